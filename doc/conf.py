@@ -72,6 +72,7 @@ html_theme = 'sphinx_rtd_theme'
 # - Author (use [author])
 # - Manual section
 man_pages = [
+    ('man1/flux-bench', 'flux-bench', 'measure latency and throughput of Flux services', [author], 1),
     ('man1/flux-broker', 'flux-broker', 'Flux comms message broker daemon', [author], 1),
     ('man1/flux-content', 'flux-content', 'access content service', [author], 1),
     ('man1/flux-cron', 'flux-cron', 'Cron-like utility for Flux', [author], 1),
@@ -105,6 +106,12 @@ man_pages = [
     ('man3/flux_content_load', 'flux_content_load_get', 'load/store content', [author], 3),
     ('man3/flux_content_load', 'flux_content_store', 'load/store content', [author], 3),
     ('man3/flux_content_load', 'flux_content_store_get', 'load/store content', [author], 3),
+    ('man3/flux_content_load', 'flux_content_load_batch', 'load/store content', [author], 3),
+    ('man3/flux_content_load', 'flux_content_load_batch_get', 'load/store content', [author], 3),
+    ('man3/flux_content_load', 'flux_content_store_batch', 'load/store content', [author], 3),
+    ('man3/flux_content_load', 'flux_content_store_batch_get', 'load/store content', [author], 3),
+    ('man3/flux_content_load', 'flux_content_has', 'load/store content', [author], 3),
+    ('man3/flux_content_load', 'flux_content_has_get', 'load/store content', [author], 3),
     ('man3/flux_content_load', 'flux_content_load', 'load/store content', [author], 3),
     ('man3/flux_core_version', 'flux_core_version_string', 'get flux-core version', [author], 3),
     ('man3/flux_core_version', 'flux_core_version', 'get flux-core version', [author], 3),
@@ -132,6 +139,11 @@ man_pages = [
     ('man3/flux_future_and_then', 'flux_future_continue', 'functions for sequential composition of futures', [author], 3),
     ('man3/flux_future_and_then', 'flux_future_continue_error', 'functions for sequential composition of futures', [author], 3),
     ('man3/flux_future_and_then', 'flux_future_and_then', 'functions for sequential composition of futures', [author], 3),
+    ('man3/flux_coro_create', 'flux_coro_push', 'coroutines on futures', [author], 3),
+    ('man3/flux_coro_create', 'flux_coro_get', 'coroutines on futures', [author], 3),
+    ('man3/flux_coro_create', 'flux_coro_count', 'coroutines on futures', [author], 3),
+    ('man3/flux_coro_create', 'flux_coro_set_result', 'coroutines on futures', [author], 3),
+    ('man3/flux_coro_create', 'flux_coro_create', 'coroutines on futures', [author], 3),
     ('man3/flux_future_create', 'flux_future_fulfill', 'support methods for classes that return futures', [author], 3),
     ('man3/flux_future_create', 'flux_future_fulfill_error', 'support methods for classes that return futures', [author], 3),
     ('man3/flux_future_create', 'flux_future_fulfill_with', 'support methods for classes that return futures', [author], 3),
@@ -150,6 +162,10 @@ man_pages = [
     ('man3/flux_future_wait_all_create', 'flux_future_first_child', 'functions for future composition', [author], 3),
     ('man3/flux_future_wait_all_create', 'flux_future_next_child', 'functions for future composition', [author], 3),
     ('man3/flux_future_wait_all_create', 'flux_future_get_child', 'functions for future composition', [author], 3),
+    ('man3/flux_future_wait_all_create', 'flux_future_push_index', 'functions for future composition', [author], 3),
+    ('man3/flux_future_wait_all_create', 'flux_future_get_child_index', 'functions for future composition', [author], 3),
+    ('man3/flux_future_wait_all_create', 'flux_future_child_count', 'functions for future composition', [author], 3),
+    ('man3/flux_future_wait_all_create', 'flux_future_ready_child', 'functions for future composition', [author], 3),
     ('man3/flux_future_wait_all_create', 'flux_future_wait_all_create', 'functions for future composition', [author], 3),
     ('man3/flux_get_rank', 'flux_get_size', 'query Flux broker comms info', [author], 3),
     ('man3/flux_get_rank', 'flux_get_rank', 'query Flux broker comms info', [author], 3),
@@ -166,6 +182,7 @@ man_pages = [
     ('man3/flux_kvs_commit', 'flux_kvs_commit', 'commit a KVS transaction', [author], 3),
     ('man3/flux_kvs_copy', 'flux_kvs_move', 'copy/move a KVS key', [author], 3),
     ('man3/flux_kvs_copy', 'flux_kvs_copy', 'copy/move a KVS key', [author], 3),
+    ('man3/flux_kvs_copy', 'flux_kvs_copy_batch', 'copy/move a KVS key', [author], 3),
     ('man3/flux_kvs_getroot', 'flux_kvs_getroot_get_treeobj', 'look up KVS root hash', [author], 3),
     ('man3/flux_kvs_getroot', 'flux_kvs_getroot_get_blobref', 'look up KVS root hash', [author], 3),
     ('man3/flux_kvs_getroot', 'flux_kvs_getroot_get_sequence', 'look up KVS root hash', [author], 3),
@@ -173,6 +190,7 @@ man_pages = [
     ('man3/flux_kvs_getroot', 'flux_kvs_getroot_cancel', 'look up KVS root hash', [author], 3),
     ('man3/flux_kvs_getroot', 'flux_kvs_getroot', 'look up KVS root hash', [author], 3),
     ('man3/flux_kvs_lookup', 'flux_kvs_lookupat', 'look up KVS key', [author], 3),
+    ('man3/flux_kvs_lookup', 'flux_kvs_lookup_stream', 'look up KVS key', [author], 3),
     ('man3/flux_kvs_lookup', 'flux_kvs_lookup_get', 'look up KVS key', [author], 3),
     ('man3/flux_kvs_lookup', 'flux_kvs_lookup_get_unpack', 'look up KVS key', [author], 3),
     ('man3/flux_kvs_lookup', 'flux_kvs_lookup_get_raw', 'look up KVS key', [author], 3),
@@ -182,6 +200,8 @@ man_pages = [
     ('man3/flux_kvs_lookup', 'flux_kvs_lookup', 'look up KVS key', [author], 3),
     ('man3/flux_kvs_namespace_create', 'flux_kvs_namespace_create', 'create/remove a KVS namespace', [author], 3),
     ('man3/flux_kvs_namespace_create', 'flux_kvs_namespace_remove', 'create/remove a KVS namespace', [author], 3),
+    ('man3/flux_kvs_namespace_create', 'flux_kvs_namespace_create_rank', 'create/remove a KVS namespace', [author], 3),
+    ('man3/flux_kvs_namespace_create', 'flux_kvs_namespace_clone', 'create/remove a KVS namespace', [author], 3),
     ('man3/flux_kvs_txn_create', 'flux_kvs_txn_destroy', 'operate on a KVS transaction object', [author], 3),
     ('man3/flux_kvs_txn_create', 'flux_kvs_txn_put', 'operate on a KVS transaction object', [author], 3),
     ('man3/flux_kvs_txn_create', 'flux_kvs_txn_pack', 'operate on a KVS transaction object', [author], 3),
@@ -285,6 +305,7 @@ man_pages = [
     ('man3/flux_stat_watcher_create', 'flux_stat_watcher_create', 'create stat watcher', [author], 3),
     ('man3/flux_timer_watcher_create', 'flux_timer_watcher_reset', 'set/reset a timer', [author], 3),
     ('man3/flux_timer_watcher_create', 'flux_timer_watcher_create', 'set/reset a timer', [author], 3),
+    ('man3/flux_timer_watcher_create', 'flux_coarse_timer_watcher_create', 'set/reset a timer', [author], 3),
     ('man3/flux_watcher_start', 'flux_watcher_stop', 'start/stop/destroy/query reactor watcher', [author], 3),
     ('man3/flux_watcher_start', 'flux_watcher_destroy', 'start/stop/destroy/query reactor watcher', [author], 3),
     ('man3/flux_watcher_start', 'flux_watcher_next_wakeup', 'start/stop/destroy/query reactor watcher', [author], 3),
@@ -299,9 +320,17 @@ man_pages = [
     ('man3/idset_create', 'idset_next', 'Manipulate numerically sorted sets of non-negative integers', [author], 3),
     ('man3/idset_create', 'idset_count', 'Manipulate numerically sorted sets of non-negative integers', [author], 3),
     ('man3/idset_create', 'idset_equal', 'Manipulate numerically sorted sets of non-negative integers', [author], 3),
+    ('man3/idset_create', 'idset_add', 'Manipulate numerically sorted sets of non-negative integers', [author], 3),
+    ('man3/idset_create', 'idset_subtract', 'Manipulate numerically sorted sets of non-negative integers', [author], 3),
+    ('man3/idset_create', 'idset_union', 'Manipulate numerically sorted sets of non-negative integers', [author], 3),
+    ('man3/idset_create', 'idset_difference', 'Manipulate numerically sorted sets of non-negative integers', [author], 3),
+    ('man3/idset_create', 'idset_intersect', 'Manipulate numerically sorted sets of non-negative integers', [author], 3),
+    ('man3/idset_create', 'idset_has_intersection', 'Manipulate numerically sorted sets of non-negative integers', [author], 3),
     ('man3/idset_encode','idset_encode', 'Convert idset to string and string to idset', [author], 3),
     ('man3/idset_encode','idset_decode', 'Convert idset to string and string to idset', [author], 3),
     ('man3/idset_encode','idset_ndecode', 'Convert idset to string and string to idset', [author], 3),
+    ('man3/idset_encode','idset_encode_binary', 'Convert idset to string and string to idset', [author], 3),
+    ('man3/idset_encode','idset_decode_binary', 'Convert idset to string and string to idset', [author], 3),
     ('man3/idset_encode','idset_format_map', 'Convert idset to string and string to idset', [author], 3),
     ('man5/flux-config-bootstrap', 'flux-config-bootstrap', 'configure Flux instance bootstrap', [author], 5),
     ('man7/flux-broker-attributes', 'flux-broker-attributes', 'overview Flux broker attributes', [author], 7),
@@ -80,6 +80,21 @@ subtest ('Test zmsg response', function ()
 
 end)
 
+subtest ('Test zmsg payload and get', function ()
+	local data = { a = { b = { c = "deep" } }, list = { 1, 2, 3 } }
+	local msg = z.req ("test.get", data)
+
+	type_ok (msg.payload, 'string',        'msg.payload is a string')
+	like (msg.payload, '"deep"',           'msg.payload is raw JSON')
+	is (msg:get ("a", "b", "c"), "deep",   'msg:get returns nested value')
+	is (msg:get ("list", 2), 2,            'msg:get indexes arrays')
+	is (msg:get ("a", "nope"), nil,        'msg:get of missing key is nil')
+	is (msg:get ("a", "b", "c", "d"), nil, 'msg:get past a scalar is nil')
+	ok (equals (data, msg:get ()),         'msg:get () returns all data')
+	ok (msg.data == msg.data,              'msg.data is converted once')
+	ok (equals (data, msg.data),           'msg.data is preserved')
+end)
+
 subtest ('Test zmsg errnum', function ()
 	local resp = z.resp_err ("test.resp_err", 255)
 
@@ -87,6 +102,8 @@ subtest ('Test zmsg errnum', function ()
 	is (resp.tag,     "test.resp_err",        'msg.tag is correct')
 	is (resp.type,    "response",             'msg.type is response')
 	is (resp.data,    nil,                    'msg.data is nil')
+	is (resp.payload, nil,                    'msg.payload is nil')
+	is (resp:get ("x"), nil,                  'msg:get is nil')
 	is (resp.errnum,  255,                    'msg.errnum is non-nil')
 end)
 
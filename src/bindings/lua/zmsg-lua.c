@@ -29,8 +29,10 @@ struct zmsg_info {
     int     typemask;  /* Type of message */
     flux_msg_t *msg;   /* Stored copy of original message */
     char *tag;         /* Topic tag for message */
-    json_t *o;         /* Decode JSON payload, NULL if no payload */
- 
+    const char *json_str; /* Raw JSON payload, NULL if no payload */
+    json_t *o;         /* Decoded payload, NULL until first accessed */
+    int data_ref;      /* Registry ref of cached msg.data table */
+
     zi_resp_f resp;    /* Respond handler (for msg:respond() method) */
     void *arg;         /* data passed to respond handler */
 };
@@ -48,23 +50,22 @@ static void zmsg_info_destroy (struct zmsg_info *zi)
 struct zmsg_info * zmsg_info_create (flux_msg_t **msg, int typemask)
 {
     const char *topic;
-    const char *json_str = NULL;
     struct zmsg_info *zi = calloc (1, sizeof (*zi));
     if (zi == NULL)
         return (NULL);
 
+    /* The JSON payload is not decoded here. It is decoded on first
+     * access of msg.data or msg:get(), so handlers that only look at
+     * msg.tag or msg.payload never pay for decoding.
+     */
     if ((flux_msg_get_topic (*msg, &topic) < 0)
         || !(zi->tag = strdup (topic))
         || !(zi->msg = flux_msg_copy (*msg, true))
-        || (flux_msg_get_string (zi->msg, &json_str) < 0)) {
-        zmsg_info_destroy (zi);
-        return (NULL);
-    }
-    /* If there was a payload, cache decoded JSON into zi->o */
-    if (json_str && !(zi->o = json_loads (json_str, JSON_DECODE_ANY, NULL))) {
+        || (flux_msg_get_string (zi->msg, &zi->json_str) < 0)) {
         zmsg_info_destroy (zi);
         return (NULL);
     }
+    zi->data_ref = LUA_NOREF;
     zi->typemask = typemask;
     zi->resp = NULL;
     zi->arg = NULL;
@@ -84,6 +85,16 @@ int zmsg_info_register_resp_cb (struct zmsg_info *zi, zi_resp_f f, void *arg)
     return (0);
 }
 
+/* Return the decoded JSON payload, decoding it on first use.
+ * Returns NULL if there is no payload or it could not be decoded.
+ */
+static json_t *zmsg_info_json (struct zmsg_info *zi)
+{
+    if (!zi->o && zi->json_str)
+        zi->o = json_loads (zi->json_str, JSON_DECODE_ANY, NULL);
+    return (zi->o);
+}
+
 static struct zmsg_info * l_get_zmsg_info (lua_State *L, int index)
 {
     struct zmsg_info **zip = luaL_checkudata (L, index, "CMB.zmsgi");
@@ -93,10 +104,33 @@ static struct zmsg_info * l_get_zmsg_info (lua_State *L, int index)
 static int l_zmsg_info_destroy (lua_State *L)
 {
     struct zmsg_info *zi = l_get_zmsg_info (L, 1);
+    luaL_unref (L, LUA_REGISTRYINDEX, zi->data_ref);
     zmsg_info_destroy (zi);
     return (0);
 }
 
+/* Push msg.data, converting the payload to a Lua table only once
+ * per message and caching the result in the registry.
+ */
+static int l_zmsg_info_push_data (lua_State *L, struct zmsg_info *zi)
+{
+    json_t *o;
+
+    if (zi->data_ref != LUA_NOREF) {
+        lua_rawgeti (L, LUA_REGISTRYINDEX, zi->data_ref);
+        return (1);
+    }
+    if (!(o = zmsg_info_json (zi))
+        || json_is_null (o)
+        || json_object_to_lua (L, o) < 0) {
+        lua_pushnil (L);
+        return (1);
+    }
+    lua_pushvalue (L, -1);
+    zi->data_ref = luaL_ref (L, LUA_REGISTRYINDEX);
+    return (1);
+}
+
 static const char * zmsg_type_string (int type)
 {
     switch (type) {
@@ -132,8 +166,12 @@ static int l_zmsg_info_index (lua_State *L)
             lua_pushnil (L);
         return (1);
     }
-    if (strcmp (key, "data") == 0) {
-        if (!zi->o || json_object_to_lua (L, zi->o) < 0)
+    if (strcmp (key, "data") == 0)
+        return l_zmsg_info_push_data (L, zi);
+    if (strcmp (key, "payload") == 0) {
+        if (zi->json_str)
+            lua_pushstring (L, zi->json_str);
+        else
             lua_pushnil (L);
         return (1);
     }
@@ -161,6 +199,30 @@ static int l_zmsg_info_index (lua_State *L)
     return (1);
 }
 
+/*  msg:get (key, ...) returns the payload value at the path of object
+ *   keys (or 1-based array indices) given as arguments, converting only
+ *   that value to Lua. Returns nil if there is no payload or any key is
+ *   missing.
+ */
+static int l_zmsg_info_get (lua_State *L)
+{
+    struct zmsg_info *zi = l_get_zmsg_info (L, 1);
+    json_t *o = zmsg_info_json (zi);
+    int i;
+
+    for (i = 2; o && i <= lua_gettop (L); i++) {
+        if (json_is_array (o) && lua_type (L, i) == LUA_TNUMBER)
+            o = json_array_get (o, lua_tointeger (L, i) - 1);
+        else if (json_is_object (o))
+            o = json_object_get (o, luaL_checkstring (L, i));
+        else
+            o = NULL;
+    }
+    if (!o || json_is_null (o) || json_object_to_lua (L, o) < 0)
+        lua_pushnil (L);
+    return (1);
+}
+
 static int l_zmsg_info_respond (lua_State *L)
 {
     struct zmsg_info *zi = l_get_zmsg_info (L, 1);
@@ -189,6 +251,7 @@ static const struct luaL_Reg zmsg_methods [] = {
     { "__gc",            l_zmsg_info_destroy  },
     { "__index",         l_zmsg_info_index    },
     { "respond",         l_zmsg_info_respond  },
+    { "get",             l_zmsg_info_get      },
     { NULL,              NULL                 }
 };
 
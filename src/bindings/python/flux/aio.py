@@ -0,0 +1,117 @@
+###############################################################
+# Copyright 2021 Lawrence Livermore National Security, LLC
+# (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+#
+# This file is part of the Flux resource manager framework.
+# For details, see https://github.com/flux-framework.
+#
+# SPDX-License-Identifier: LGPL-3.0
+###############################################################
+
+"""
+asyncio integration for Flux handles.
+
+A handle is attached to an asyncio event loop by registering a reader on
+flux_pollfd(), which becomes readable when there are messages to process.
+The reader runs the Flux reactor without blocking until the handle has no
+more pending messages, so message handlers and future continuations run
+in the asyncio thread and no helper thread is needed.
+
+Futures are awaitable (see Future.__await__ in flux.future), and awaiting
+one attaches its handle to the running loop automatically:
+
+    async def main(h):
+        resp = await h.rpc("cmb.ping", {"seq": 1})
+
+Only message driven watchers are serviced this way.  Flux reactor timers,
+including the timeout argument of Future.then(), do not wake the loop,
+so use asyncio.wait_for() for timeouts instead.
+"""
+
+import asyncio
+
+from flux.core.inner import ffi, lib
+
+# Maximum number of reactor iterations per reader callback, after which
+# the rest is deferred with call_soon() so other asyncio tasks may run
+_MAX_ITERATIONS = 1000
+
+# Attached handles keyed by their flux_t address: (loop, handle, fd)
+_ATTACHED = {}
+
+
+def _key(handle):
+    return int(ffi.cast("uintptr_t", handle.handle))
+
+
+def _service(handle):
+    """Run the Flux reactor until the handle has no pending messages.
+
+    flux_pollfd() is edge triggered, and is re-armed by flux_pollevents(),
+    so keep going while FLUX_POLLIN is raised.
+    """
+    entry = _ATTACHED.get(_key(handle))
+    if entry is None:
+        return
+    loop = entry[0]
+    reactor = handle.get_reactor()
+    for _ in range(_MAX_ITERATIONS):
+        handle.flux_reactor_run(reactor, lib.FLUX_REACTOR_NOWAIT)
+        if not handle.pollevents() & lib.FLUX_POLLIN:
+            return
+    loop.call_soon(_service, handle)
+
+
+def attach(handle, loop=None):
+    """Service the Flux handle 'handle' from asyncio event loop 'loop'.
+
+    If loop is None, the current event loop is used.  Attaching a handle
+    that is attached to another loop moves it to 'loop'.
+    """
+    if loop is None:
+        loop = asyncio.get_event_loop()
+    entry = _ATTACHED.get(_key(handle))
+    if entry is not None:
+        if entry[0] is loop:
+            return
+        detach(handle)
+    fd = handle.pollfd()
+    _ATTACHED[_key(handle)] = (loop, handle, fd)
+    loop.add_reader(fd, _service, handle)
+    # Messages may already be queued, which would not raise a new edge
+    loop.call_soon(_service, handle)
+
+
+def detach(handle):
+    """Stop servicing 'handle' from the event loop it is attached to."""
+    entry = _ATTACHED.pop(_key(handle), None)
+    if entry is not None:
+        loop, _, fd = entry
+        if not loop.is_closed():
+            loop.remove_reader(fd)
+
+
+def _then_cb(future, arg):
+    waiter = future.aio_waiter
+    if waiter is not None and not waiter.done():
+        waiter.set_result(None)
+
+
+async def wait(future):
+    """Wait for 'future' to be fulfilled, then return future.get().
+
+    A streaming future may be awaited again after future.reset().
+    """
+    if not future.is_ready():
+        loop = asyncio.get_event_loop()
+        attach(future.get_flux(), loop)
+        future.aio_waiter = loop.create_future()
+        if future.then_cb is None:
+            future.then(_then_cb)
+        elif future.then_cb is not _then_cb:
+            raise ValueError("cannot await a future with a then() callback")
+        try:
+            await future.aio_waiter
+        finally:
+            future.aio_waiter = None
+    return future.get()
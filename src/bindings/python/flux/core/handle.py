@@ -123,6 +123,28 @@ class Flux(Wrapper):
         """ Create a new RPC object """
         return RPC(self, topic, payload, nodeid, flags)
 
+    def rpc_batch(self, requests, nodeid=raw.FLUX_NODEID_ANY, flags=0):
+        """ Send a batch of RPCs before waiting for any response.
+
+        :param requests: an iterable of topic strings, or of tuples
+            (topic, payload) or (topic, payload, nodeid)
+        :param nodeid: default nodeid for tuples that do not specify one
+        :param flags: RPC flags applied to every request
+        :returns: list of RPC objects, in the order of requests
+
+        All requests are in flight at once, so the cost of a round trip
+        is paid once for the batch rather than once per request.
+        """
+        rpcs = []
+        for req in requests:
+            if isinstance(req, (six.text_type, six.binary_type)):
+                req = (req,)
+            topic = req[0]
+            payload = req[1] if len(req) > 1 else None
+            rank = req[2] if len(req) > 2 else nodeid
+            rpcs.append(RPC(self, topic, payload, rank, flags))
+        return rpcs
+
     def event_create(self, topic, payload=None):
         """ Create a new event message.
 
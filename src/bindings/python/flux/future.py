@@ -78,6 +78,7 @@ class Future(WrapperPimpl):
         self.then_cb = None
         self.then_arg = None
         self.cb_handle = None
+        self.aio_waiter = None
 
     def error_string(self):
         try:
@@ -137,6 +138,16 @@ class Future(WrapperPimpl):
         self.pimpl.wait_for(timeout)
         return self
 
+    def __await__(self):
+        """
+        Await fulfillment of this future from an asyncio coroutine, and
+        return the result of get().  See flux.aio.
+        """
+        # pylint: disable=import-outside-toplevel,cyclic-import
+        import flux.aio
+
+        return flux.aio.wait(self).__await__()
+
     def get(self):
         """
         Base Future.get() method. Does not return a result, just blocks
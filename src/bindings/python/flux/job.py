@@ -11,6 +11,7 @@ import os
 import math
 import json
 import errno
+import fnmatch
 import datetime
 import collections
 import collections.abc as abc
@@ -353,6 +354,51 @@ def wait(flux_handle, jobid=lib.FLUX_JOBID_ANY):
     return future.get_status()
 
 
+class JobWaitBatchRPC(RPC):
+    def get_status(self):
+        """Return a list of JobWaitResult, one per job reaped"""
+        return [
+            JobWaitResult(
+                int(entry["id"]), bool(entry["success"]), entry["errstr"].encode()
+            )
+            for entry in self.get()["jobs"]
+        ]
+
+
+def wait_batch_async(flux_handle, max_jobs):
+    """Wait for up to max_jobs jobs to complete, asynchronously
+
+    Submit a request to reap all waitable jobs that have already
+    completed, up to max_jobs, or if there are none, the next waitable
+    job to complete.
+
+    :param flux_handle: handle for Flux broker from flux.Flux()
+    :type flux_handle: Flux
+    :param max_jobs: the maximum number of jobs to return
+    :returns: an RPC object for obtaining the job results
+    :rtype: JobWaitBatchRPC
+    """
+    if int(max_jobs) < 1:
+        raise EnvironmentError(errno.EINVAL, "max_jobs must be at least 1")
+    payload = {"id": lib.FLUX_JOBID_ANY, "max": int(max_jobs)}
+    return JobWaitBatchRPC(flux_handle, "job-manager.wait", payload)
+
+
+def wait_batch(flux_handle, max_jobs):
+    """Wait for up to max_jobs jobs to complete
+
+    Like wait(flux_handle), but return the results of all waitable jobs
+    that have already completed, up to max_jobs, in one request.
+
+    :param flux_handle: handle for Flux broker from flux.Flux()
+    :type flux_handle: Flux
+    :param max_jobs: the maximum number of jobs to return
+    :returns: a list of job status tuples as returned by wait()
+    :rtype: list
+    """
+    return wait_batch_async(flux_handle, max_jobs).get_status()
+
+
 def kill_async(flux_handle, jobid, signum=None):
     """Send a signal to a running job asynchronously
 
@@ -486,7 +532,7 @@ class JobEventWatchFuture(Future):
         self.needs_cancel = False
 
 
-def event_watch_async(flux_handle, jobid, eventlog="eventlog"):
+def event_watch_async(flux_handle, jobid, eventlog="eventlog", start=0):
     """Asynchronously get eventlog updates for a job
 
     Asynchronously watch the events of a job eventlog, optionally only
@@ -500,15 +546,18 @@ def event_watch_async(flux_handle, jobid, eventlog="eventlog"):
     :param jobid: the job ID on which to watch events
     :param name: The event name or glob pattern for which to wait (default: *)
     :param eventlog: eventlog path in job kvs directory (default: eventlog)
+    :param start: skip this many events, e.g. those already received
+        by a previous watch, or if negative, begin with this many of the
+        most recent events (default: 0)
     :returns: a JobEventWatchFuture object
     :rtype: JobEventWatchFuture
     """
 
-    future = RAW.event_watch(flux_handle, int(jobid), eventlog, 0)
+    future = RAW.event_watch_from(flux_handle, int(jobid), eventlog, 0, int(start))
     return JobEventWatchFuture(future)
 
 
-def event_watch(flux_handle, jobid, eventlog="eventlog"):
+def event_watch(flux_handle, jobid, eventlog="eventlog", start=0):
     """Python generator to watch all events for a job
 
     Synchronously watch events a job eventlog via a simple generator.
@@ -521,8 +570,9 @@ def event_watch(flux_handle, jobid, eventlog="eventlog"):
     :param jobid: the job ID on which to watch events
     :param name: The event name or glob pattern for which to wait (default: *)
     :param eventlog: eventlog path in job kvs directory (default: eventlog)
+    :param start: see event_watch_async() (default: 0)
     """
-    watcher = event_watch_async(flux_handle, jobid, eventlog)
+    watcher = event_watch_async(flux_handle, jobid, eventlog, start)
     event = watcher.get_event()
     while event is not None:
         yield event
@@ -575,6 +625,10 @@ class JobListRPC(RPC):
     def get_jobs(self):
         return self.get()["jobs"]
 
+    def get_cursor(self):
+        """Return cursor to pass to job_list() for the next page, or None"""
+        return self.get().get("cursor")
+
 
 # Due to subtleties in the python bindings and this call, this binding
 # is more of a reimplementation of flux_job_list() instead of calling
@@ -585,8 +639,22 @@ class JobListRPC(RPC):
 #
 # pylint: disable=dangerous-default-value
 def job_list(
-    flux_handle, max_entries=1000, attrs=[], userid=os.getuid(), states=0, results=0
+    flux_handle,
+    max_entries=1000,
+    attrs=[],
+    userid=os.getuid(),
+    states=0,
+    results=0,
+    cursor=None,
+    name=None,
+    since=0.0,
 ):
+    """List jobs matching userid, states and results
+
+    If name is set, only jobs with a name matching the fnmatch(3) pattern
+    are listed.  If since is set, inactive jobs are only listed if they
+    became inactive after that time.  Filtering is done by job-info.
+    """
     payload = {
         "max_entries": int(max_entries),
         "attrs": attrs,
@@ -594,9 +662,98 @@ def job_list(
         "states": states,
         "results": results,
     }
+    if cursor:
+        payload["cursor"] = cursor
+    if name:
+        payload["name"] = name
+    if since:
+        payload["since"] = float(since)
     return JobListRPC(flux_handle, "job-info.list", payload)
 
 
+# pylint: disable=dangerous-default-value
+def job_list_stream(
+    flux_handle,
+    max_entries=1000,
+    attrs=[],
+    userid=os.getuid(),
+    states=0,
+    results=0,
+    chunk_size=100,
+    name=None,
+    since=0.0,
+):
+    """Python generator to list jobs as they are received
+
+    Like job_list(), but job-info streams the jobs back in responses
+    of up to chunk_size jobs, so the first jobs may be handled before
+    the last are sent.  Inactive jobs that job-info has evicted are
+    fetched from job-archive, if loaded.  Use as:
+        for job in job.job_list_stream(flux_handle, ...):
+            # do something with job...
+    """
+    payload = {
+        "max_entries": int(max_entries),
+        "attrs": attrs,
+        "userid": int(userid),
+        "states": states,
+        "results": results,
+        "chunk_size": int(chunk_size),
+    }
+    if name:
+        payload["name"] = name
+    if since:
+        payload["since"] = float(since)
+    rpc = JobListRPC(
+        flux_handle, "job-info.list", payload, flags=constants.FLUX_RPC_STREAMING
+    )
+    count = 0
+    archive_before = None
+    while True:
+        try:
+            resp = rpc.get()
+        except OSError as exc:
+            if exc.errno == errno.ENODATA:
+                break
+            raise
+        archive_before = resp.get("archive_before", archive_before)
+        count += len(resp["jobs"])
+        yield from resp["jobs"]
+        rpc.reset()
+
+    #  job-info has evicted inactive jobs older than archive_before.
+    #  Continue from job-archive, which does not record job results.
+    #  job-archive cannot filter by name, so that is done here.
+    if archive_before is None or results != 0:
+        return
+    if max_entries > 0 and count >= max_entries:
+        return
+    payload = {
+        "max_entries": 0,
+        "before": float(archive_before),
+        "userid": int(userid),
+    }
+    if max_entries > 0 and not name:
+        payload["max_entries"] = int(max_entries - count)
+    keep = set(attrs) | {"id"}
+    try:
+        jobs = JobListRPC(flux_handle, "job-archive.list", payload).get_jobs()
+    except OSError as exc:
+        if exc.errno == errno.ENOSYS:
+            return
+        raise
+    for job in jobs:
+        #  archived jobs are sorted by t_inactive, newest first
+        if since and job.get("t_inactive", 0.0) <= since:
+            return
+        if name and not fnmatch.fnmatchcase(job.get("name") or "", name):
+            continue
+        if max_entries > 0 and count >= max_entries:
+            return
+        count += 1
+        yield {key: val for key, val in job.items() if key in keep}
+
+
 def job_list_inactive(flux_handle, since=0.0, max_entries=1000, attrs=[], name=None):
     payload = {"since": float(since), "max_entries": int(max_entries), "attrs": attrs}
     if name:
@@ -73,8 +73,26 @@ class RPC(Future):
             return None
         return ffi.string(payload_str[0]).decode("utf-8")
 
+    def get_raw(self):
+        """Return the response payload as bytes, without decoding it.
+
+        A trailing NUL, as sent with string payloads, is not included.
+        """
+        data = ffi.new("void *[1]")
+        size = ffi.new("int *")
+        self.pimpl.flux_rpc_get_raw(data, size)
+        if data[0] == ffi.NULL:
+            return None
+        buf = ffi.buffer(data[0], size[0])
+        length = size[0]
+        if length > 0 and buf[length - 1] == b"\0":
+            length -= 1
+        return buf[:length]
+
     def get(self):
-        resp_str = self.get_str()
-        if resp_str is None:
+        # Decode straight from the payload buffer, avoiding the strlen()
+        # and intermediate str copy of get_str()
+        resp = self.get_raw()
+        if resp is None:
             return None
-        return json.loads(resp_str)
+        return json.loads(resp.decode("utf-8"))
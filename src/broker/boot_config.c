@@ -20,7 +20,6 @@
 #include <flux/core.h>
 
 #include "src/common/libutil/log.h"
-#include "src/common/libutil/kary.h"
 #include "src/common/libutil/errno_safe.h"
 #include "src/common/libidset/idset.h"
 
@@ -286,6 +285,71 @@ static int gethostentry (json_t *hosts,
     return 0;
 }
 
+/* Build the TBON topology for 'hosts'.  If any host entry has a "group"
+ * key (e.g. the name of its leaf switch), hosts that share a group are
+ * placed in a subtree under the group's lowest rank, so that most overlay
+ * traffic between them stays within the group.  Otherwise the tree is a
+ * plain k-ary tree in rank order.  A NULL 'hosts' is a size=1 instance.
+ */
+struct topology *boot_config_topology (json_t *hosts, int tbon_k)
+{
+    size_t size = hosts ? json_array_size (hosts) : 1;
+    const char **groups;
+    bool grouped = false;
+    struct topology *topo = NULL;
+    size_t index;
+    json_t *entry;
+
+    if (!(groups = calloc (size, sizeof (groups[0])))) {
+        log_msg ("Config file error [bootstrap]: out of memory");
+        return NULL;
+    }
+    json_array_foreach (hosts, index, entry) {
+        if (json_unpack (entry, "{s?:s}", "group", &groups[index]) < 0) {
+            log_msg ("Config file error [bootstrap]: rank %zu bad group",
+                     index);
+            log_msg ("Hint: group key, if present, is type string");
+            goto done;
+        }
+        if (groups[index])
+            grouped = true;
+    }
+    if (grouped)
+        topo = topology_create_grouped (size, tbon_k, groups);
+    else
+        topo = topology_create (size, tbon_k);
+    if (!topo)
+        log_err ("Config file error [bootstrap]: could not create topology");
+done:
+    free (groups);
+    return topo;
+}
+
+/* Look up the host entry for 'rank', and set 'trusted' to the value of its
+ * "trusted" key (default false).  A trusted host's links to its TBON
+ * children are not secured, e.g. because they run over a cluster-private
+ * network.  Return 0 on success, -1 on failure.
+ */
+int boot_config_gettrustedbyrank (json_t *hosts, uint32_t rank, bool *trusted)
+{
+    json_t *entry;
+    int val = 0;
+
+    if (!(entry = json_array_get (hosts, rank))) {
+        log_msg ("Config file error [bootstrap] rank %u not found in hosts",
+                 (unsigned int)rank);
+        return -1;
+    }
+    if (json_unpack (entry, "{s?:b}", "trusted", &val) < 0) {
+        log_msg ("Config file error [bootstrap]: rank %u bad trusted",
+                 (unsigned int)rank);
+        log_msg ("Hint: trusted key, if present, is type boolean");
+        return -1;
+    }
+    *trusted = val ? true : false;
+    return 0;
+}
+
 /* Look up the host entry for 'rank', then copy that entry's bind address
  * into 'buf'.  If the entry doesn't provide an explicit bind address,
  * use the default.  Perform any host or port substitutions while copying.
@@ -360,8 +424,9 @@ int boot_config (flux_t *h, struct overlay *overlay, attr_t *attrs, int tbon_k)
 {
     struct boot_conf conf;
     uint32_t rank;
-    uint32_t size;
     json_t *hosts = NULL;
+    struct topology *topo;
+    bool trusted;
 
     /* Throw an error if 'tbon.endpoint' attribute is already set.
      * flux-start sets this, and it's not compatible with the
@@ -379,6 +444,7 @@ int boot_config (flux_t *h, struct overlay *overlay, attr_t *attrs, int tbon_k)
 
     /* If hosts array was specified, match hostname to determine rank,
      * and size is the length of the hosts array.  O/w rank=0, size=1.
+     * N.B. overlay_init() takes ownership of 'topo'.
      */
     if (hosts != NULL) {
         const char *fakehost = getenv ("FLUX_FAKE_HOSTNAME"); // for testing;
@@ -392,16 +458,15 @@ int boot_config (flux_t *h, struct overlay *overlay, attr_t *attrs, int tbon_k)
                                       fakehost ? fakehost : hostname,
                                       &rank) < 0)
             goto error;
-        size = json_array_size (hosts);
     }
-    else {
-        size = 1;
+    else
         rank = 0;
-    }
 
-    /* Tell overlay network this broker's rank, size, and branching factor.
+    /* Tell overlay network this broker's rank and the shape of the tree.
      */
-    if (overlay_init (overlay, size, rank, tbon_k) < 0)
+    if (!(topo = boot_config_topology (hosts, tbon_k)))
+        goto error;
+    if (overlay_init (overlay, topo, rank) < 0)
         goto error;
 
     /* If broker has "downstream" peers, determine the URI to bind to
@@ -409,7 +474,7 @@ int boot_config (flux_t *h, struct overlay *overlay, attr_t *attrs, int tbon_k)
      * attribute to the URI peers will connect to.  If broker has no
      * downstream peers, set tbon.endpoint to NULL.
      */
-    if (kary_childof (tbon_k, size, rank, 0) != KARY_NONE) {
+    if (topology_has_child (topo, rank)) {
         char bind_uri[MAX_URI + 1];
         char my_uri[MAX_URI + 1];
 
@@ -425,6 +490,12 @@ int boot_config (flux_t *h, struct overlay *overlay, attr_t *attrs, int tbon_k)
             log_err ("overlay_set_child %s", bind_uri);
             goto error;
         }
+        if (boot_config_gettrustedbyrank (hosts, rank, &trusted) < 0)
+            goto error;
+        if (trusted && overlay_set_child_trusted (overlay) < 0) {
+            log_err ("overlay_set_child_trusted");
+            goto error;
+        }
         if (overlay_bind (overlay) < 0) { /* idempotent */
             log_err ("overlay_bind");
             goto error;
@@ -459,7 +530,7 @@ int boot_config (flux_t *h, struct overlay *overlay, attr_t *attrs, int tbon_k)
         char parent_uri[MAX_URI + 1];
         if (boot_config_geturibyrank (hosts,
                                       &conf,
-                                      kary_parentof (tbon_k, rank),
+                                      topology_get_parent (topo, rank),
                                       parent_uri,
                                       sizeof (parent_uri)) < 0)
             goto error;
@@ -467,6 +538,14 @@ int boot_config (flux_t *h, struct overlay *overlay, attr_t *attrs, int tbon_k)
             log_err ("overlay_set_parent %s", parent_uri);
             goto error;
         }
+        if (boot_config_gettrustedbyrank (hosts,
+                                          topology_get_parent (topo, rank),
+                                          &trusted) < 0)
+            goto error;
+        if (trusted && overlay_set_parent_trusted (overlay) < 0) {
+            log_err ("overlay_set_parent_trusted");
+            goto error;
+        }
     }
 
     /* instance-level (position in instance hierarchy) is always zero here.
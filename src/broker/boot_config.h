@@ -43,12 +43,16 @@ int boot_config_getbindbyrank (json_t *hosts,
                                uint32_t rank,
                                char *buf,
                                int bufsz);
+int boot_config_gettrustedbyrank (json_t *hosts,
+                                  uint32_t rank,
+                                  bool *trusted);
 int boot_config_getrankbyname (json_t *hosts,
                                const char *name,
                                uint32_t *rank);
 int boot_config_parse (const flux_conf_t *cf,
                        struct boot_conf *conf,
                        json_t **hosts);
+struct topology *boot_config_topology (json_t *hosts, int tbon_k);
 int boot_config_format_uri (char *buf,
                             int bufsz,
                             const char *fmt,
@@ -18,7 +18,7 @@
 #include "src/common/libutil/log.h"
 #include "src/common/libutil/cleanup.h"
 #include "src/common/libutil/ipaddr.h"
-#include "src/common/libutil/kary.h"
+#include "src/common/libutil/monotime.h"
 #include "src/common/libpmi/pmi.h"
 #include "src/common/libpmi/pmi_strerror.h"
 
@@ -31,6 +31,53 @@
 /* Generally accepted max, although some go higher (IE is 2083) */
 #define ENDPOINT_MAX 2048
 
+/* Time spent in each phase of the bootstrap, for scaling diagnostics.
+ * The barriers are expected to dominate at scale, since they wait on
+ * the slowest broker.
+ */
+enum {
+    PHASE_INIT,         // PMI init, params, instance level
+    PHASE_PUT,          // bind and publish child URI
+    PHASE_BARRIER1,     // wait for all puts
+    PHASE_GET,          // fetch parent URI
+    PHASE_BARRIER2,     // wait for all gets
+    PHASE_FINALIZE,
+    PHASE_COUNT,
+};
+
+static const char *phase_names[PHASE_COUNT] = {
+    "init", "put", "barrier", "get", "barrier2", "finalize",
+};
+
+struct boot_timing {
+    struct timespec t;
+    double elapsed[PHASE_COUNT];
+};
+
+static void phase_end (struct boot_timing *bt, int phase)
+{
+    bt->elapsed[phase] = monotime_since (bt->t) / 1000;
+    monotime (&bt->t);
+}
+
+static void phase_log (flux_t *h, struct boot_timing *bt)
+{
+    char buf[256];
+    int len = 0;
+    int i;
+
+    for (i = 0; i < PHASE_COUNT; i++) {
+        int n = snprintf (buf + len, sizeof (buf) - len, "%s%s=%.3fs",
+                          i > 0 ? " " : "",
+                          phase_names[i],
+                          bt->elapsed[i]);
+        if (n >= sizeof (buf) - len)
+            break;
+        len += n;
+    }
+    flux_log (h, LOG_INFO, "pmi: phases %s", buf);
+}
+
 /* Given a string with possible format specifiers, return string that is
  * fully expanded.
  *
@@ -177,7 +224,7 @@ static int set_instance_level_attr (struct pmi_handle *pmi,
     return 0;
 }
 
-int boot_pmi (struct overlay *overlay, attr_t *attrs, int tbon_k)
+int boot_pmi (flux_t *h, struct overlay *overlay, attr_t *attrs, int tbon_k)
 {
     int parent_rank;
     const char *child_uri;
@@ -186,8 +233,11 @@ int boot_pmi (struct overlay *overlay, attr_t *attrs, int tbon_k)
     const char *tbonendpoint = NULL;
     struct pmi_handle *pmi;
     struct pmi_params pmi_params;
+    struct topology *topo;
+    struct boot_timing bt = { 0 };
     int result;
 
+    monotime (&bt.t);
     memset (&pmi_params, 0, sizeof (pmi_params));
     if (!(pmi = broker_pmi_create ())) {
         log_err ("broker_pmi_create");
@@ -207,18 +257,21 @@ int boot_pmi (struct overlay *overlay, attr_t *attrs, int tbon_k)
         log_err ("set_instance_level_attr");
         goto error;
     }
-    if (overlay_init (overlay, pmi_params.size, pmi_params.rank, tbon_k) < 0)
+    /* PMI offers no view of the network, so the tree is plain k-ary.
+     * N.B. overlay_init() takes ownership of 'topo'.
+     */
+    if (!(topo = topology_create (pmi_params.size, tbon_k))) {
+        log_err ("topology_create");
+        goto error;
+    }
+    if (overlay_init (overlay, topo, pmi_params.rank) < 0)
         goto error;
+    phase_end (&bt, PHASE_INIT);
 
     /* If there are to be downstream peers, then bind to socket and share the
      * concretized URI with other ranks via PMI KVS key=cmbd.<rank>.uri.
-     * N.B. there are no downstream peers if the 0th child of this rank
-     * in k-ary tree does not exist.
      */
-    if (kary_childof (tbon_k,
-                      pmi_params.size,
-                      pmi_params.rank,
-                      0) != KARY_NONE) {
+    if (topology_has_child (topo, pmi_params.rank)) {
 
         if (update_endpoint_attr (attrs,
                                   "tbon.endpoint",
@@ -269,6 +322,7 @@ int boot_pmi (struct overlay *overlay, attr_t *attrs, int tbon_k)
             goto error;
         }
     }
+    phase_end (&bt, PHASE_PUT);
 
     /* The PMI barrier (which is implicitly over 'size' ranks) ensures that
      * all KVS puts are complete before any PMI gets.
@@ -278,12 +332,13 @@ int boot_pmi (struct overlay *overlay, attr_t *attrs, int tbon_k)
         log_msg ("broker_pmi_barrier: %s", pmi_strerror (result));
         goto error;
     }
+    phase_end (&bt, PHASE_BARRIER1);
 
     /* If there is to be an upstream peer, fetch its URI from PMI KVS.
      * N.B. only rank 0 has no upstream peer.
      */
     if (pmi_params.rank > 0) {
-        parent_rank = kary_parentof (tbon_k, pmi_params.rank);
+        parent_rank = topology_get_parent (topo, pmi_params.rank);
         if (snprintf (key, sizeof (key),
                       "cmbd.%d.uri", parent_rank) >= sizeof (key)) {
             log_msg ("pmi key string overflow");
@@ -300,18 +355,22 @@ int boot_pmi (struct overlay *overlay, attr_t *attrs, int tbon_k)
             goto error;
         }
     }
+    phase_end (&bt, PHASE_GET);
 
     result = broker_pmi_barrier (pmi);
     if (result != PMI_SUCCESS) {
         log_msg ("broker_pmi_barrier: %s", pmi_strerror (result));
         goto error;
     }
+    phase_end (&bt, PHASE_BARRIER2);
 
     result = broker_pmi_finalize (pmi);
     if (result != PMI_SUCCESS) {
         log_msg ("broker_pmi_finalize: %s", pmi_strerror (result));
         goto error;
     }
+    phase_end (&bt, PHASE_FINALIZE);
+    phase_log (h, &bt);
 
     broker_pmi_destroy (pmi);
     return 0;
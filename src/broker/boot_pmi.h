@@ -13,10 +13,14 @@
 
 /* boot_pmi - bootstrap broker/overlay with PMI */
 
+#include <flux/core.h>
+
 #include "attr.h"
 #include "overlay.h"
 
-int boot_pmi (struct overlay *overlay, attr_t *attrs, int tbon_k);
+/* The time spent in each bootstrap phase is logged to 'h'.
+ */
+int boot_pmi (flux_t *h, struct overlay *overlay, attr_t *attrs, int tbon_k);
 
 #endif /* BROKER_BOOT_PMI_H */
 
@@ -50,7 +50,6 @@
 #include "src/common/libutil/cleanup.h"
 #include "src/common/libidset/idset.h"
 #include "src/common/libutil/ipaddr.h"
-#include "src/common/libutil/kary.h"
 #include "src/common/libutil/monotime.h"
 #include "src/common/libutil/zsecurity.h"
 #include "src/common/libpmi/pmi.h"
@@ -70,13 +69,16 @@
 #include "content-cache.h"
 #include "runat.h"
 #include "heaptrace.h"
+#include "stackprof.h"
 #include "exec.h"
 #include "ping.h"
 #include "rusage.h"
+#include "profile.h"
 #include "boot_config.h"
 #include "boot_pmi.h"
 #include "publisher.h"
 #include "state_machine.h"
+#include "topicset.h"
 
 #include "broker.h"
 
@@ -87,8 +89,8 @@ static void broker_request_sendmsg (broker_ctx_t *ctx, const flux_msg_t *msg);
 static int broker_request_sendmsg_internal (broker_ctx_t *ctx,
                                             const flux_msg_t *msg);
 
-static void parent_cb (struct overlay *ov, void *sock, void *arg);
-static void child_cb (struct overlay *ov, void *sock, void *arg);
+static void parent_cb (struct overlay *ov, flux_msg_t *msg, void *arg);
+static void child_cb (struct overlay *ov, flux_msg_t *msg, void *arg);
 static void module_cb (module_t *p, void *arg);
 static void module_status_cb (module_t *p, int prev_state, void *arg);
 static void hello_cb (struct hello *h, void *arg);
@@ -115,12 +117,19 @@ static int create_dummyattrs (flux_t *h, uint32_t rank, uint32_t size);
 static int create_runat_phases (broker_ctx_t *ctx);
 
 static int handle_event (broker_ctx_t *ctx, const flux_msg_t *msg);
+static int update_subscriptions (broker_ctx_t *ctx, const flux_msg_t *request);
 
 static void init_attrs (attr_t *attrs, pid_t pid);
 
 static const struct flux_handle_ops broker_handle_ops;
 
 #define OPTIONS "+vs:X:k:H:g:S:c:"
+
+/* Seconds to wait for the parent to replay missed events before giving up
+ * and logging them as lost.
+ */
+#define EVENT_REPLAY_TIMEOUT 10.
+
 static const struct option longopts[] = {
     {"verbose",         no_argument,        0, 'v'},
     {"security",        required_argument,  0, 's'},
@@ -280,6 +289,8 @@ int main (int argc, char *argv[])
         oom ();
     if (!(ctx.subscriptions = zlist_new ()))
         oom ();
+    if (!(ctx.event_hold = zlist_new ()))
+        oom ();
     if (!(ctx.cache = content_cache_create ()))
         oom ();
     if (!(ctx.publisher = publisher_create ()))
@@ -414,7 +425,7 @@ int main (int argc, char *argv[])
         double elapsed_sec;
         struct timespec start_time;
         monotime (&start_time);
-        if (boot_pmi (ctx.overlay, ctx.attrs, ctx.tbon_k) < 0) {
+        if (boot_pmi (ctx.h, ctx.overlay, ctx.attrs, ctx.tbon_k) < 0) {
             log_msg ("bootstrap failed");
             goto cleanup;
         }
@@ -492,12 +503,18 @@ int main (int argc, char *argv[])
             log_err ("overlay_connect");
             goto cleanup;
         }
+        /* From here on, tell the parent about subscription changes,
+         * so it forwards only the events this subtree wants.
+         */
+        ctx.sub_update = true;
+        if (update_subscriptions (&ctx, NULL) < 0) {
+            log_err ("update_subscriptions");
+            goto cleanup;
+        }
     }
 
     if (!(ctx.shutdown = shutdown_create (ctx.h,
                                           ctx.shutdown_grace,
-                                          ctx.size,
-                                          ctx.tbon_k,
                                           ctx.overlay))) {
         log_err ("shutdown_create");
         goto cleanup;
@@ -514,6 +531,10 @@ int main (int argc, char *argv[])
         log_err ("heaptrace_initialize");
         goto cleanup;
     }
+    if (stackprof_initialize (ctx.h) < 0) {
+        log_err ("stackprof_initialize");
+        goto cleanup;
+    }
     if (exec_initialize (ctx.h, ctx.rank, ctx.attrs) < 0) {
         log_err ("exec_initialize");
         goto cleanup;
@@ -526,6 +547,10 @@ int main (int argc, char *argv[])
         log_err ("rusage_initialize");
         goto cleanup;
     }
+    if (profile_initialize (ctx.h, "cmb") < 0) {
+        log_err ("profile_initialize");
+        goto cleanup;
+    }
 
     if (!(handlers = broker_add_services (&ctx))) {
         log_err ("broker_add_services");
@@ -574,6 +599,11 @@ int main (int argc, char *argv[])
         log_err ("hello_create");
         goto cleanup;
     }
+    if (hello_set_topology (ctx.hello,
+                            overlay_get_topology (ctx.overlay)) < 0) {
+        log_err ("hello_set_topology");
+        goto cleanup;
+    }
     if (hello_start (ctx.hello) < 0) {
         log_err ("hello_start");
         goto cleanup;
@@ -620,6 +650,8 @@ cleanup:
     if (sigaction (SIGTERM, &old_sigact_term, NULL) < 0)
         log_err ("sigaction");
 
+    ctx.sub_update = false;
+
     /* remove heartbeat timer, if any
      */
     heartbeat_stop (ctx.heartbeat);
@@ -644,6 +676,13 @@ cleanup:
     flux_close (ctx.h);
     flux_reactor_destroy (ctx.reactor);
     zlist_destroy (&ctx.subscriptions);
+    if (ctx.event_hold) {
+        flux_msg_t *msg;
+        while ((msg = zlist_pop (ctx.event_hold)))
+            flux_msg_decref (msg);
+        zlist_destroy (&ctx.event_hold);
+    }
+    flux_future_destroy (ctx.event_replay_f);
     free (ctx.init_shell_cmd);
 
     return ctx.exit_rc;
@@ -1028,8 +1067,36 @@ static void module_dlerror (const char *errmsg, void *arg)
 }
 
 
+/* Look up the CPU and NUMA placement of module 'name' in the
+ * [modules.<name>] table of the broker config.  Keys that are not
+ * configured are left unchanged.
+ */
+static int config_get_placement (broker_ctx_t *ctx,
+                                 const char *name,
+                                 const char **cpus,
+                                 const char **numa)
+{
+    flux_conf_error_t error;
+
+    if (flux_conf_unpack (flux_get_conf (ctx->h),
+                          &error,
+                          "{s?{s?{s?s s?s}}}",
+                          "modules",
+                            name,
+                              "cpus", cpus,
+                              "numa", numa) < 0) {
+        log_msg ("Config file error [modules.%s]: %s", name, error.errbuf);
+        errno = EINVAL;
+        return -1;
+    }
+    return 0;
+}
+
+/* Placement given in a load request overrides the broker config.
+ */
 static int load_module_bypath (broker_ctx_t *ctx, const char *path,
                                const char *argz, size_t argz_len,
+                               const char *cpus, const char *numa,
                                const flux_msg_t *request)
 {
     module_t *p = NULL;
@@ -1039,8 +1106,18 @@ static int load_module_bypath (broker_ctx_t *ctx, const char *path,
         errno = ENOENT;
         goto error;
     }
+    if (!cpus && !numa
+        && config_get_placement (ctx, name, &cpus, &numa) < 0)
+        goto error;
     if (!(p = module_add (ctx->modhash, path)))
         goto error;
+    if (module_set_placement (p, cpus, numa) < 0) {
+        log_err ("%s: error setting placement cpus=%s numa=%s",
+                 name,
+                 cpus ? cpus : "-",
+                 numa ? numa : "-");
+        goto module_remove;
+    }
     if (service_add (ctx->services, module_get_name (p),
                                     module_get_uuid (p), mod_svc_cb, p) < 0)
         goto module_remove;
@@ -1082,7 +1159,13 @@ static int load_module_byname (broker_ctx_t *ctx, const char *name,
         log_msg ("%s: not found in module search path", name);
         return -1;
     }
-    if (load_module_bypath (ctx, path, argz, argz_len, request) < 0) {
+    if (load_module_bypath (ctx,
+                            path,
+                            argz,
+                            argz_len,
+                            NULL,
+                            NULL,
+                            request) < 0) {
         free (path);
         return -1;
     }
@@ -1171,14 +1254,19 @@ static void cmb_insmod_cb (flux_t *h, flux_msg_handler_t *mh,
     broker_ctx_t *ctx = arg;
     const char *path;
     json_t *args;
+    const char *cpus = NULL;
+    const char *numa = NULL;
     size_t index;
     json_t *value;
     char *argz = NULL;
     size_t argz_len = 0;
     error_t e;
 
-    if (flux_request_unpack (msg, NULL, "{s:s s:o}", "path", &path,
-                                                     "args", &args) < 0)
+    if (flux_request_unpack (msg, NULL, "{s:s s:o s?s s?s}",
+                             "path", &path,
+                             "args", &args,
+                             "cpus", &cpus,
+                             "numa", &numa) < 0)
         goto error;
     if (!json_is_array (args))
         goto proto;
@@ -1190,7 +1278,7 @@ static void cmb_insmod_cb (flux_t *h, flux_msg_handler_t *mh,
             goto error;
         }
     }
-    if (load_module_bypath (ctx, path, argz, argz_len, msg) < 0)
+    if (load_module_bypath (ctx, path, argz, argz_len, cpus, numa, msg) < 0)
         goto error;
     free (argz);
     return;
@@ -1224,6 +1312,107 @@ error:
         flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
 }
 
+/* Report message counters: requests routed by topic, traffic per
+ * overlay peer, and queue depths.  The counters are cleared afterwards
+ * if the optional "clear" flag is true.
+ */
+static void broker_stats_cb (flux_t *h, flux_msg_handler_t *mh,
+                             const flux_msg_t *msg, void *arg)
+{
+    broker_ctx_t *ctx = arg;
+    int clear = 0;
+    json_t *services = NULL;
+    json_t *overlay = NULL;
+
+    if (flux_request_unpack (msg, NULL, "{s?b}", "clear", &clear) < 0)
+        goto error;
+    if (!(services = service_stats (ctx->services))
+        || !(overlay = overlay_get_stats (ctx->overlay)))
+        goto error;
+    if (flux_respond_pack (h, msg, "{s:O s:O s:{s:i} s:{s:I}}",
+                           "services", services,
+                           "overlay", overlay,
+                           "queues",
+                             "event-hold", (int)zlist_size (ctx->event_hold),
+                           "routing",
+                             "upstream-nosvc", (json_int_t)ctx->upstream_nosvc)
+                           < 0)
+        flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
+    if (clear) {
+        service_stats_clear (ctx->services);
+        ctx->upstream_nosvc = 0;
+        overlay_clear_stats (ctx->overlay);
+    }
+    json_decref (services);
+    json_decref (overlay);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+    json_decref (services);
+    json_decref (overlay);
+}
+
+struct trace_query {
+    json_t *events;
+    bool nomem;
+};
+
+static void trace_append (const struct flux_trace_event *event, void *arg)
+{
+    struct trace_query *q = arg;
+    json_t *o;
+
+    if (!(o = json_pack ("{s:I s:I s:f s:s s:s s:s}",
+                         "trace", (json_int_t)event->trace,
+                         "span", (json_int_t)event->span,
+                         "timestamp", event->timestamp,
+                         "where", event->where,
+                         "type", flux_msg_typestr (event->type),
+                         "topic", event->topic))
+        || json_array_append_new (q->events, o) < 0)
+        q->nomem = true;
+}
+
+/* Return events from the trace ring of this broker and its modules,
+ * optionally only those of one trace, in the order they were recorded.
+ */
+static void broker_trace_cb (flux_t *h, flux_msg_handler_t *mh,
+                             const flux_msg_t *msg, void *arg)
+{
+    broker_ctx_t *ctx = arg;
+    struct trace_query q = { .events = NULL, .nomem = false };
+    json_int_t trace = 0;
+    int clear = 0;
+
+    if (flux_request_unpack (msg, NULL, "{s?I s?b}",
+                             "trace", &trace,
+                             "clear", &clear) < 0)
+        goto error;
+    if (!(q.events = json_array ())) {
+        errno = ENOMEM;
+        goto error;
+    }
+    if (flux_trace_foreach (trace, trace_append, &q) < 0)
+        goto error;
+    if (q.nomem) {
+        errno = ENOMEM;
+        goto error;
+    }
+    if (flux_respond_pack (h, msg, "{s:i s:O}",
+                           "rank", (int)ctx->rank,
+                           "events", q.events) < 0)
+        flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
+    if (clear)
+        flux_trace_clear ();
+    json_decref (q.events);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+    json_decref (q.events);
+}
+
 #if CODE_COVERAGE_ENABLED
 void __gcov_flush (void);
 #endif
@@ -1277,7 +1466,12 @@ static void cmb_sub_cb (flux_t *h, flux_msg_handler_t *mh,
     }
     if (module_subscribe (ctx->modhash, uuid, topic) < 0)
         goto error;
-    if (flux_respond (h, msg, NULL) < 0)
+    if (ctx->sub_update) {
+        /* respond once the subscription is in effect upstream */
+        if (update_subscriptions (ctx, msg) < 0)
+            goto error;
+    }
+    else if (flux_respond (h, msg, NULL) < 0)
         flux_log_error (h, "%s: flux_respond", __FUNCTION__);
     free (uuid);
     return;
@@ -1306,6 +1500,8 @@ static void cmb_unsub_cb (flux_t *h, flux_msg_handler_t *mh,
         goto error;
     if (flux_respond (h, msg, NULL) < 0)
         flux_log_error (h, "%s: flux_respond", __FUNCTION__);
+    if (ctx->sub_update && update_subscriptions (ctx, NULL) < 0)
+        flux_log_error (h, "%s: update_subscriptions", __FUNCTION__);
     free (uuid);
     return;
 error:
@@ -1453,6 +1649,18 @@ static const struct flux_msg_handler_spec htab[] = {
         cmb_unsub_cb,
         0
     },
+    {
+        FLUX_MSGTYPE_REQUEST,
+        "broker.stats",
+        broker_stats_cb,
+        0
+    },
+    {
+        FLUX_MSGTYPE_REQUEST,
+        "broker.trace",
+        broker_trace_cb,
+        0
+    },
     {
         FLUX_MSGTYPE_REQUEST,
         "service.add",
@@ -1480,11 +1688,13 @@ static struct internal_service services[] = {
     { "hello",              NULL },
     { "attr",               NULL },
     { "heaptrace",          NULL },
+    { "stackprof",          NULL },
     { "event",              "[0]" },
     { "service",            NULL },
     { "overlay",            NULL },
     { "config",             NULL },
     { "runat",              NULL },
+    { "broker",             NULL },
     { NULL, NULL, },
 };
 
@@ -1527,15 +1737,12 @@ static void broker_remove_services (flux_msg_handler_t *handlers[])
 
 /* Handle requests from overlay peers.
  */
-static void child_cb (struct overlay *ov, void *sock, void *arg)
+static void child_cb (struct overlay *ov, flux_msg_t *msg, void *arg)
 {
     broker_ctx_t *ctx = arg;
     int type;
     char *uuid = NULL;
-    flux_msg_t *msg = flux_msg_recvzsock (sock);
 
-    if (!msg)
-        goto done;
     if (flux_msg_get_type (msg, &type) < 0)
         goto done;
     if (flux_msg_get_route_last (msg, &uuid) < 0)
@@ -1570,35 +1777,18 @@ static void child_cb (struct overlay *ov, void *sock, void *arg)
 done:
     if (uuid)
         free (uuid);
-    flux_msg_destroy (msg);
 }
 
-/* Handle events received by parent_cb.
- * On rank 0, publisher is wired to send events here also.
+/* Deliver an event in sequence.
  */
-static int handle_event (broker_ctx_t *ctx, const flux_msg_t *msg)
+static int deliver_event (broker_ctx_t *ctx, const flux_msg_t *msg)
 {
-    uint32_t seq;
     const char *topic, *s;
 
-    if (flux_msg_get_seq (msg, &seq) < 0
-            || flux_msg_get_topic (msg, &topic) < 0) {
+    if (flux_msg_get_topic (msg, &topic) < 0) {
         flux_log (ctx->h, LOG_ERR, "dropping malformed event");
         return -1;
     }
-    if (seq <= ctx->event_recv_seq) {
-        //flux_log (ctx->h, LOG_DEBUG, "dropping duplicate event %d", seq);
-        return -1;
-    }
-    if (ctx->event_recv_seq > 0) { /* don't log initial missed events */
-        int first = ctx->event_recv_seq + 1;
-        int count = seq - first;
-        if (count > 1)
-            flux_log (ctx->h, LOG_ERR, "lost events %d-%d", first, seq - 1);
-        else if (count == 1)
-            flux_log (ctx->h, LOG_ERR, "lost event %d", first);
-    }
-    ctx->event_recv_seq = seq;
 
     /* Forward to this rank's children.
      */
@@ -1621,18 +1811,176 @@ static int handle_event (broker_ctx_t *ctx, const flux_msg_t *msg)
     return module_event_mcast (ctx->modhash, msg);
 }
 
+static void log_lost_events (broker_ctx_t *ctx, int first, int last)
+{
+    if (last > first)
+        flux_log (ctx->h, LOG_ERR, "lost events %d-%d", first, last);
+    else
+        flux_log (ctx->h, LOG_ERR, "lost event %d", first);
+}
+
+/* Events [first, last] were not received.  If the parent's history of
+ * them is complete, they were not forwarded because nothing below this
+ * broker subscribed to them.
+ */
+static void event_gap (broker_ctx_t *ctx, int first, int last, bool complete)
+{
+    if (complete)
+        overlay_mcast_skip (ctx->overlay, first, last);
+    else {
+        log_lost_events (ctx, first, last);
+        overlay_event_lost (ctx->overlay, first, last);
+    }
+}
+
+static int event_hold (broker_ctx_t *ctx, const flux_msg_t *msg, bool head)
+{
+    int rc;
+
+    if (head)
+        rc = zlist_push (ctx->event_hold, (flux_msg_t *)msg);
+    else
+        rc = zlist_append (ctx->event_hold, (flux_msg_t *)msg);
+    if (rc < 0) {
+        errno = ENOMEM;
+        return -1;
+    }
+    (void)flux_msg_incref (msg);
+    return 0;
+}
+
+struct replay_state {
+    broker_ctx_t *ctx;
+    int next;
+    bool complete;
+};
+
+static void event_replay_one (const flux_msg_t *msg, void *arg)
+{
+    struct replay_state *rs = arg;
+    broker_ctx_t *ctx = rs->ctx;
+    uint32_t seq;
+
+    if (flux_msg_get_seq (msg, &seq) < 0
+        || seq < rs->next
+        || seq > ctx->event_replay_last)
+        return;
+    if (seq > rs->next)
+        event_gap (ctx, rs->next, seq - 1, rs->complete);
+    ctx->event_recv_seq = seq;
+    (void)deliver_event (ctx, msg);
+    rs->next = seq + 1;
+}
+
+static int handle_event_seq (broker_ctx_t *ctx, const flux_msg_t *msg);
+
+/* Deliver replayed events, account for the rest of the gap, then
+ * process events that arrived in the meantime.
+ */
+static void event_replay_continuation (flux_future_t *f, void *arg)
+{
+    broker_ctx_t *ctx = arg;
+    struct replay_state rs = {
+        .ctx = ctx,
+        .next = ctx->event_replay_first,
+        .complete = false,
+    };
+    flux_msg_t *msg;
+
+    if (overlay_event_replay_get (f, &rs.complete, event_replay_one, &rs) < 0) {
+        flux_log_error (ctx->h,
+                        "event replay %d-%d",
+                        ctx->event_replay_first,
+                        ctx->event_replay_last);
+        rs.complete = false;
+    }
+    if (rs.next <= ctx->event_replay_last)
+        event_gap (ctx, rs.next, ctx->event_replay_last, rs.complete);
+    if (ctx->event_recv_seq < ctx->event_replay_last)
+        ctx->event_recv_seq = ctx->event_replay_last;
+    flux_future_destroy (f);
+    ctx->event_replay_f = NULL;
+
+    while (!ctx->event_replay_f && (msg = zlist_pop (ctx->event_hold))) {
+        (void)handle_event_seq (ctx, msg);
+        flux_msg_decref (msg);
+    }
+}
+
+static int event_replay_start (broker_ctx_t *ctx, int first, int last)
+{
+    flux_future_t *f;
+
+    if (!(f = overlay_event_replay (ctx->overlay, first, last))
+        || flux_future_then (f,
+                             EVENT_REPLAY_TIMEOUT,
+                             event_replay_continuation,
+                             ctx) < 0) {
+        flux_future_destroy (f);
+        return -1;
+    }
+    ctx->event_replay_f = f;
+    ctx->event_replay_first = first;
+    ctx->event_replay_last = last;
+    return 0;
+}
+
+/* Account for an event or a skip notice from the parent, in sequence.
+ * A gap in the sequence is repaired by asking the parent to replay the
+ * missing events: 'msg' and anything that follows are held until then.
+ */
+static int handle_event_seq (broker_ctx_t *ctx, const flux_msg_t *msg)
+{
+    uint32_t first, last;
+    int next = ctx->event_recv_seq + 1;
+    bool skip = false;
+
+    if (overlay_event_skip_decode (msg, &first, &last) == 0)
+        skip = true;
+    else if (flux_msg_get_seq (msg, &first) == 0)
+        last = first;
+    else {
+        flux_log (ctx->h, LOG_ERR, "dropping malformed event");
+        return -1;
+    }
+    if (last <= ctx->event_recv_seq) {
+        //flux_log (ctx->h, LOG_DEBUG, "dropping duplicate event %d", first);
+        return -1;
+    }
+    if (ctx->event_recv_seq > 0 && first > next) { /* don't check initial */
+        if (ctx->rank > 0 && event_replay_start (ctx, next, first - 1) == 0)
+            return event_hold (ctx, msg, true);
+        log_lost_events (ctx, next, first - 1);
+        overlay_event_lost (ctx->overlay, next, first - 1);
+    }
+    if (skip) {
+        overlay_mcast_skip (ctx->overlay, first > next ? first : next, last);
+        ctx->event_recv_seq = last;
+        return 0;
+    }
+    ctx->event_recv_seq = first;
+    return deliver_event (ctx, msg);
+}
+
+/* Handle events and skip notices received by parent_cb.
+ * On rank 0, publisher is wired to send events here also.
+ */
+static int handle_event (broker_ctx_t *ctx, const flux_msg_t *msg)
+{
+    if (ctx->event_replay_f)
+        return event_hold (ctx, msg, false);
+    return handle_event_seq (ctx, msg);
+}
+
 /* Handle messages from one or more parents.
  */
-static void parent_cb (struct overlay *ov, void *sock, void *arg)
+static void parent_cb (struct overlay *ov, flux_msg_t *msg, void *arg)
 {
     broker_ctx_t *ctx = arg;
-    flux_msg_t *msg = flux_msg_recvzsock (sock);
     int type;
 
-    if (!msg)
-        goto done;
     if (flux_msg_get_type (msg, &type) < 0)
-        goto done;
+        return;
     switch (type) {
         case FLUX_MSGTYPE_RESPONSE:
             if (broker_response_sendmsg (ctx, msg) < 0)
@@ -1649,13 +1997,21 @@ static void parent_cb (struct overlay *ov, void *sock, void *arg)
         case FLUX_MSGTYPE_REQUEST:
             broker_request_sendmsg (ctx, msg);
             break;
+        case FLUX_MSGTYPE_KEEPALIVE: {
+            uint32_t first, last;
+            if (overlay_event_skip_decode (msg, &first, &last) == 0) {
+                (void)handle_event (ctx, msg);
+                break;
+            }
+        }
+        // fall through
         default:
             flux_log (ctx->h, LOG_ERR, "%s: unexpected %s", __FUNCTION__,
                       flux_msg_typestr (type));
             break;
     }
 done:
-    flux_msg_destroy (msg);
+    return;
 }
 
 /* Callback to send disconnect messages on behalf of unloading module.
@@ -1779,6 +2135,8 @@ static void module_status_cb (module_t *p, int prev_status, void *arg)
     if (prev_status == FLUX_MODSTATE_INIT &&
         (status == FLUX_MODSTATE_RUNNING ||
          status == FLUX_MODSTATE_SLEEPING)) {
+        flux_log (ctx->h, LOG_DEBUG, "module %s started in %.3fs",
+                  name, module_get_init_time (p));
         if (module_insmod_respond (ctx->h, p) < 0)
             flux_log_error (ctx->h, "flux_respond to insmod %s", name);
     }
@@ -1875,6 +2233,7 @@ static int broker_request_sendmsg_internal (broker_ctx_t *ctx,
         if (service_send (ctx->services, msg) < 0) {
             if (errno != ENOSYS)
                 return -1;
+            ctx->upstream_nosvc++;
             if (overlay_sendmsg_parent (ctx->overlay, msg) < 0) {
                 if (errno == EHOSTUNREACH)
                     errno = ENOSYS;
@@ -1891,9 +2250,10 @@ static int broker_request_sendmsg_internal (broker_ctx_t *ctx,
     /* Send the request up or down TBON as addressed.
      */
     else {
-        uint32_t down_rank;
-        down_rank = kary_child_route (ctx->tbon_k, ctx->size, ctx->rank, nodeid);
-        if (down_rank == KARY_NONE) { // up
+        struct topology *topo = overlay_get_topology (ctx->overlay);
+        int down_rank;
+        down_rank = topology_get_child_route (topo, ctx->rank, nodeid);
+        if (down_rank < 0) { // up
             if (overlay_sendmsg_parent (ctx->overlay, msg) < 0)
                 return -1;
         }
@@ -1956,7 +2316,9 @@ static bool uuid_to_rank (const char *s, uint32_t size, uint32_t *rank)
  */
 static bool is_my_parent (broker_ctx_t *ctx, uint32_t rank)
 {
-    if (kary_parentof (ctx->tbon_k, ctx->rank) == rank)
+    struct topology *topo = overlay_get_topology (ctx->overlay);
+
+    if (topology_get_parent (topo, ctx->rank) == rank)
         return true;
     return false;
 }
@@ -2078,6 +2440,31 @@ done:
     return rc;
 }
 
+/* Tell the overlay about the subscriptions of internal services and
+ * modules.  If 'request' is non-NULL, it is responded to once they are
+ * in effect upstream.
+ */
+static int update_subscriptions (broker_ctx_t *ctx, const flux_msg_t *request)
+{
+    struct topicset *ts;
+    const char *s;
+
+    if (!(ts = topicset_create ()))
+        return -1;
+    s = zlist_first (ctx->subscriptions);
+    while (s) {
+        if (topicset_add (ts, s) < 0)
+            goto error;
+        s = zlist_next (ctx->subscriptions);
+    }
+    if (modhash_add_subscriptions (ctx->modhash, ts) < 0)
+        goto error;
+    return overlay_set_subscriptions (ctx->overlay, ts, request);
+error:
+    topicset_destroy (ts);
+    return -1;
+}
+
 static int broker_subscribe (void *impl, const char *topic)
 {
     broker_ctx_t *ctx = impl;
@@ -2088,6 +2475,8 @@ static int broker_subscribe (void *impl, const char *topic)
     if (zlist_append (ctx->subscriptions, cpy) < 0)
         goto nomem;
     zlist_freefn (ctx->subscriptions, cpy, free, true);
+    if (ctx->sub_update && update_subscriptions (ctx, NULL) < 0)
+        flux_log_error (ctx->h, "%s: update_subscriptions", __FUNCTION__);
     return 0;
 nomem:
     free (cpy);
@@ -27,8 +27,14 @@ struct broker {
 
     bool verbose;
     int event_recv_seq;
+    zlist_t *event_hold;        /* events held while a gap is repaired */
+    flux_future_t *event_replay_f;
+    int event_replay_first;
+    int event_replay_last;
+    bool sub_update;            /* send subscription changes upstream */
     zlist_t *sigwatchers;
     struct service_switch *services;
+    uint64_t upstream_nosvc;    /* requests routed up for lack of a service */
     struct heartbeat *heartbeat;
     struct brokercfg *config;
     const char *config_path;
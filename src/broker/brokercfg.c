@@ -19,6 +19,7 @@
 #include <assert.h>
 
 #include "src/common/libutil/log.h"
+#include "src/common/libutil/errno_safe.h"
 
 #include "attr.h"
 #include "module.h"
@@ -130,6 +131,12 @@ error:
 }
 
 /* Send a '<name>.config-reload' request to all loaded modules.
+ * The config object is encoded once and the same payload is sent to each
+ * module, rather than re-encoding it per module.  Each module decodes its
+ * own copy, since jansson objects must not be shared between threads
+ * (see interthread.c).  The whole config is sent, even if unchanged:
+ * modules do not declare which tables they read, and a module that failed
+ * an earlier reload still needs the config the broker now holds.
  * On success, return a composite future that is fulfilled once all modules
  * have responded.  On failure, return NULL with errno set.
  */
@@ -138,11 +145,18 @@ static flux_future_t *reload_module_configs (flux_t *h, struct brokercfg *cfg)
     flux_future_t *cf;
     module_t *module;
     json_t *conf;
+    char *s;
 
     if (flux_conf_unpack (flux_get_conf (h), NULL, "o", &conf) < 0)
         return NULL;
-    if (!(cf = flux_future_wait_all_create ()))
+    if (!(s = json_dumps (conf, JSON_COMPACT))) {
+        errno = ENOMEM;
         return NULL;
+    }
+    if (!(cf = flux_future_wait_all_create ())) {
+        free (s);
+        return NULL;
+    }
     flux_future_set_flux (cf, h);
     module = module_first (cfg->modhash);
     while (module) {
@@ -156,7 +170,7 @@ static flux_future_t *reload_module_configs (flux_t *h, struct brokercfg *cfg)
             errno = EOVERFLOW;
             goto error;
         }
-        if (!(f = flux_rpc_pack (h, topic, FLUX_NODEID_ANY, 0, "O", conf)))
+        if (!(f = flux_rpc (h, topic, s, FLUX_NODEID_ANY, 0)))
             goto error;
         if (flux_future_push (cf, module_get_name (module), f) < 0) {
             flux_future_destroy (f);
@@ -164,8 +178,10 @@ static flux_future_t *reload_module_configs (flux_t *h, struct brokercfg *cfg)
         }
         module = module_next (cfg->modhash);
     }
+    free (s);
     return cf;
 error:
+    ERRNO_SAFE_WRAP (free, s);
     flux_future_destroy (cf);
     return NULL;
 }
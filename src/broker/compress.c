@@ -0,0 +1,278 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* compress.c - lz4/zstd wrappers for the overlay
+ *
+ * zstd is used at a low compression level: the overlay compresses
+ * messages on the broker's reactor thread, so speed matters more
+ * than ratio.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <jansson.h>
+#include <lz4.h>
+#if HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "compress.h"
+
+#define ZSTD_LEVEL 1
+
+struct compress {
+    void *buf;
+    size_t bufsize;
+#if HAVE_ZSTD
+    ZSTD_CCtx *cctx;
+    ZSTD_DCtx *dctx;
+#endif
+};
+
+static const struct {
+    const char *name;
+    int codec;
+} codec_names[] = {
+    { "lz4", COMPRESS_LZ4 },
+    { "zstd", COMPRESS_ZSTD },
+};
+
+void compress_destroy (struct compress *c)
+{
+    if (c) {
+        int saved_errno = errno;
+#if HAVE_ZSTD
+        ZSTD_freeCCtx (c->cctx);
+        ZSTD_freeDCtx (c->dctx);
+#endif
+        free (c->buf);
+        free (c);
+        errno = saved_errno;
+    }
+}
+
+struct compress *compress_create (void)
+{
+    struct compress *c;
+
+    if (!(c = calloc (1, sizeof (*c))))
+        return NULL;
+#if HAVE_ZSTD
+    if (!(c->cctx = ZSTD_createCCtx ()) || !(c->dctx = ZSTD_createDCtx ())) {
+        compress_destroy (c);
+        errno = ENOMEM;
+        return NULL;
+    }
+#endif
+    return c;
+}
+
+int compress_codecs (void)
+{
+    int mask = COMPRESS_LZ4;
+#if HAVE_ZSTD
+    mask |= COMPRESS_ZSTD;
+#endif
+    return mask;
+}
+
+int compress_codec_parse (const char *name)
+{
+    int i;
+
+    if (name) {
+        for (i = 0; i < sizeof (codec_names) / sizeof (codec_names[0]); i++) {
+            if (!strcmp (name, codec_names[i].name)
+                && (codec_names[i].codec & compress_codecs ()))
+                return codec_names[i].codec;
+        }
+    }
+    errno = EINVAL;
+    return -1;
+}
+
+const char *compress_codec_name (int codec)
+{
+    int i;
+
+    for (i = 0; i < sizeof (codec_names) / sizeof (codec_names[0]); i++) {
+        if (codec_names[i].codec == codec)
+            return codec_names[i].name;
+    }
+    return "unknown";
+}
+
+json_t *compress_codecs_encode (int mask)
+{
+    json_t *a;
+    int i;
+
+    if (!(a = json_array ()))
+        goto nomem;
+    for (i = 0; i < sizeof (codec_names) / sizeof (codec_names[0]); i++) {
+        if ((mask & codec_names[i].codec)) {
+            json_t *o;
+            if (!(o = json_string (codec_names[i].name))
+                || json_array_append_new (a, o) < 0) {
+                json_decref (o);
+                goto nomem;
+            }
+        }
+    }
+    return a;
+nomem:
+    json_decref (a);
+    errno = ENOMEM;
+    return NULL;
+}
+
+int compress_codecs_decode (json_t *o, int *maskp)
+{
+    size_t index;
+    json_t *value;
+    int mask = 0;
+
+    if (!json_is_array (o) || !maskp) {
+        errno = EPROTO;
+        return -1;
+    }
+    json_array_foreach (o, index, value) {
+        const char *name = json_string_value (value);
+        int i;
+        if (!name) {
+            errno = EPROTO;
+            return -1;
+        }
+        for (i = 0; i < sizeof (codec_names) / sizeof (codec_names[0]); i++) {
+            if (!strcmp (name, codec_names[i].name))
+                mask |= codec_names[i].codec;
+        }
+    }
+    *maskp = mask;
+    return 0;
+}
+
+static int grow_buf (struct compress *c, size_t size)
+{
+    void *p;
+
+    if (c->bufsize >= size)
+        return 0;
+    if (!(p = realloc (c->buf, size)))
+        return -1;
+    c->buf = p;
+    c->bufsize = size;
+    return 0;
+}
+
+int compress_encode (struct compress *c,
+                     int codec,
+                     const void *data,
+                     size_t len,
+                     const void **outp,
+                     size_t *outlenp)
+{
+    size_t n;
+
+    if (!c || !data || !outp || !outlenp) {
+        errno = EINVAL;
+        return -1;
+    }
+    switch (codec) {
+        case COMPRESS_LZ4: {
+            int r;
+            if (len > LZ4_MAX_INPUT_SIZE) {
+                errno = EMSGSIZE;
+                return -1;
+            }
+            if (grow_buf (c, LZ4_compressBound (len)) < 0)
+                return -1;
+            if ((r = LZ4_compress_default (data,
+                                           c->buf,
+                                           len,
+                                           c->bufsize > INT_MAX ?
+                                           INT_MAX : c->bufsize)) <= 0) {
+                errno = EINVAL;
+                return -1;
+            }
+            n = r;
+            break;
+        }
+#if HAVE_ZSTD
+        case COMPRESS_ZSTD:
+            if (grow_buf (c, ZSTD_compressBound (len)) < 0)
+                return -1;
+            n = ZSTD_compressCCtx (c->cctx,
+                                   c->buf,
+                                   c->bufsize,
+                                   data,
+                                   len,
+                                   ZSTD_LEVEL);
+            if (ZSTD_isError (n)) {
+                errno = EINVAL;
+                return -1;
+            }
+            break;
+#endif
+        default:
+            errno = EINVAL;
+            return -1;
+    }
+    *outp = c->buf;
+    *outlenp = n;
+    return 0;
+}
+
+int compress_decode (struct compress *c,
+                     int codec,
+                     const void *data,
+                     size_t len,
+                     void *out,
+                     size_t outlen)
+{
+    if (!c || !data || !out) {
+        errno = EINVAL;
+        return -1;
+    }
+    switch (codec) {
+        case COMPRESS_LZ4: {
+            int r;
+            if (len > INT_MAX || outlen > INT_MAX)
+                goto eproto;
+            r = LZ4_decompress_safe (data, out, len, outlen);
+            if (r < 0 || r != (int)outlen)
+                goto eproto;
+            break;
+        }
+#if HAVE_ZSTD
+        case COMPRESS_ZSTD: {
+            size_t n = ZSTD_decompressDCtx (c->dctx, out, outlen, data, len);
+            if (ZSTD_isError (n) || n != outlen)
+                goto eproto;
+            break;
+        }
+#endif
+        default:
+            goto eproto;
+    }
+    return 0;
+eproto:
+    errno = EPROTO;
+    return -1;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
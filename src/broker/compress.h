@@ -0,0 +1,77 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _BROKER_COMPRESS_H
+#define _BROKER_COMPRESS_H
+
+#include <stddef.h>
+#include <jansson.h>
+
+/* compress - codecs for compressing overlay messages
+ *
+ * Codecs are identified by a bit, so the set a peer can decode may be
+ * exchanged as a mask.  lz4 is always available; zstd only if flux-core
+ * was built with it.
+ */
+
+enum {
+    COMPRESS_LZ4 = 1,
+    COMPRESS_ZSTD = 2,
+};
+
+struct compress;
+
+struct compress *compress_create (void);
+void compress_destroy (struct compress *c);
+
+/* Return the mask of codecs supported by this broker.
+ */
+int compress_codecs (void);
+
+/* Convert between codec bit and name, e.g. "lz4".
+ * compress_codec_parse() fails with EINVAL if the codec is unknown or
+ * unsupported.
+ */
+int compress_codec_parse (const char *name);
+const char *compress_codec_name (int codec);
+
+/* Convert between a codec mask and a JSON array of names.
+ * Unknown names are ignored when decoding.
+ */
+json_t *compress_codecs_encode (int mask);
+int compress_codecs_decode (json_t *o, int *mask);
+
+/* Compress 'len' bytes of 'data' with 'codec'.  On success, '*outp' is
+ * set to a buffer owned by 'c' that is valid until the next call, and
+ * '*outlenp' to its length.
+ */
+int compress_encode (struct compress *c,
+                     int codec,
+                     const void *data,
+                     size_t len,
+                     const void **outp,
+                     size_t *outlenp);
+
+/* Decompress 'len' bytes of 'data' with 'codec' into 'out', which must
+ * be exactly the uncompressed size 'outlen'.  Fails with EPROTO if the
+ * data is corrupt or decompresses to a different size.
+ */
+int compress_decode (struct compress *c,
+                     int codec,
+                     const void *data,
+                     size_t len,
+                     void *out,
+                     size_t outlen);
+
+#endif /* !_BROKER_COMPRESS_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
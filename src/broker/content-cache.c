@@ -15,11 +15,16 @@
 #endif
 #include <inttypes.h>
 #include <czmq.h>
+#include <jansson.h>
 #include <flux/core.h>
 #include "src/common/libutil/errno_safe.h"
 #include "src/common/libutil/blobref.h"
+#include "src/common/libutil/blobbatch.h"
+#include "src/common/libutil/blobsnap.h"
+#include "src/common/libutil/bloom.h"
 #include "src/common/libutil/iterators.h"
 #include "src/common/libutil/log.h"
+#include "src/common/libkvs/treeobj.h"
 
 #include "attr.h"
 #include "content-cache.h"
@@ -39,7 +44,61 @@ static const uint32_t default_blob_size_limit = 1048576*1024;
 
 static const uint32_t default_flush_batch_limit = 256;
 
+/* Maximum number of readahead loads in flight (see cache_readahead()).
+ */
+static const uint32_t default_prefetch_limit = 256;
+
+/* Write-back on ranks > 0 (see writeback_send()):  the window in
+ * milliseconds that stores are held for coalescing (0 = write-through),
+ * and the number of store-batch requests that may be in flight upstream.
+ */
+static const uint32_t default_writeback_window = 0;
+static const uint32_t default_writeback_credits = 4;
+
+/* Limits on the blobs sent upstream or to the backing store in one
+ * content.load-batch or content.store-batch request.
+ */
+static const int batch_max_count = 256;
+static const int batch_max_size = 1048576*4;
+
+/* Size of the rank 0 filter of blobrefs known to be in the backing store:
+ * 10 bits per key and 7 hashes give about 1% false positives when full.
+ * The filter is cleared when it fills.
+ */
+static const size_t stored_filter_keys = 1048576;
+
+/* Cache entries that may be evicted, that is, valid entries that are not
+ * dirty, are kept on one of two LRU lists following the Adaptive
+ * Replacement Cache (ARC) of Megiddo and Modha:  'recent' (T1) holds
+ * entries referenced once since they were admitted, and 'frequent' (T2)
+ * holds entries referenced again.  The blobrefs of entries evicted from
+ * each list are remembered on a 'ghost' list (B1 or B2).  An entry that
+ * is admitted while it has a ghost goes straight to T2, and moves the
+ * target size of T1 toward the list that would have kept it.  Sizes are
+ * in bytes, so that large blobs weigh accordingly.  Dirty entries, and
+ * invalid entries with a load in flight, are on no list.
+ */
+struct lru_node {
+    struct lru_node *prev;
+    struct lru_node *next;
+};
+
+struct lru_list {
+    struct lru_node head;           /* head.next is most recently used */
+    uint64_t size;
+    int count;
+};
+
+struct ghost {
+    struct lru_node lru;            /* must be first */
+    struct lru_list *list;
+    int len;
+    char blobref[];
+};
+
 struct cache_entry {
+    struct lru_node lru;            /* must be first */
+    struct lru_list *arc_list;      /* T1, T2, or NULL if not evictable */
     flux_t *h;
     void *data;
     int len;
@@ -49,8 +108,15 @@ struct cache_entry {
                                     /*   or to backing store (rank 0) */
     uint8_t load_pending:1;
     uint8_t store_pending:1;
+    uint8_t queued:1;               /* on a list for cache_*_batch() */
+    uint8_t probed:1;               /* backing store lacks it (rank 0) */
+    uint8_t prefetched:1;           /* loaded by readahead, not yet used */
+    uint8_t prefetch_load:1;        /* load in flight is a readahead */
+    uint8_t mapped:1;               /* data points into the snapshot */
     zlist_t *load_requests;
     zlist_t *store_requests;
+    zlist_t *load_batches;          /* batch items waiting for load */
+    zlist_t *store_batches;         /* batch items waiting for store */
     int lastused;
 };
 
@@ -60,6 +126,10 @@ struct content_cache {
     uint32_t rank;
     zhash_t *entries;
     uint8_t backing:1;              /* 'content.backing' service available */
+    uint8_t backing_has:1;          /* backing store handles 'has' requests */
+    struct bloom *stored;           /* blobrefs in backing store (rank 0) */
+    struct blobsnap *snapshot;      /* content.snapshot (rank 0) */
+    char *snapshot_path;
     char *backing_name;
     char hash_name[BLOBREF_MAX_STRING_SIZE];
     zlist_t *flush_requests;
@@ -69,18 +139,219 @@ struct content_cache {
     uint32_t flush_batch_limit;
     uint32_t flush_batch_count;
 
+    uint32_t prefetch_limit;        /* max readahead loads in flight */
+    uint32_t prefetch_inflight;
+
+    zlist_t *writeback;             /* dirty entries held for write-back */
+    int writeback_size;             /* bytes of entries on 'writeback' */
+    flux_watcher_t *writeback_timer;
+    uint8_t writeback_armed:1;      /* writeback_timer is running */
+    uint32_t writeback_window;      /* milliseconds, 0 = write-through */
+    uint32_t writeback_credits;     /* max writeback batches in flight */
+    uint32_t writeback_inflight;
+
     uint32_t purge_target_entries;
     uint32_t purge_target_size;
     uint32_t purge_old_entry;
     uint32_t purge_large_entry;
+    uint32_t purge_period;          /* milliseconds, 0 = purge on heartbeat */
+    flux_watcher_t *purge_timer;
+    uint8_t purge_armed:1;          /* purge_timer is running */
+    double purge_t0;
 
     uint32_t acct_size;             /* total size of all cache entries */
     uint32_t acct_valid;            /* count of valid cache entries */
     uint32_t acct_dirty;            /* count of dirty cache entries */
+
+    struct lru_list t1;             /* ARC recent list */
+    struct lru_list t2;             /* ARC frequent list */
+    struct lru_list b1;             /* ARC ghosts evicted from t1 */
+    struct lru_list b2;             /* ARC ghosts evicted from t2 */
+    zhash_t *ghosts;                /* ghosts, by blobref */
+    uint64_t arc_p;                 /* target size of t1 */
+
+    uint64_t hits;                  /* loads of valid entries */
+    uint64_t misses;                /* loads of invalid or absent entries */
+    uint64_t ghost_hits;            /* admissions of ghosted entries */
+    uint64_t dedup_hits;            /* stores skipped, already in backing */
+    uint64_t prefetch_issued;       /* readahead loads sent */
+    uint64_t prefetch_hits;         /* readahead entries later loaded */
+    uint64_t prefetch_wasted;       /* readahead entries removed unused */
+    uint64_t writeback_batches;     /* writeback store-batch requests sent */
+    uint64_t writeback_stalls;      /* writeback sends waiting for credit */
+    uint64_t snapshot_hits;         /* entries served from the snapshot */
+};
+
+/* A content.load-batch or content.store-batch request.  The result for
+ * each item is copied as it becomes available, and the response is sent
+ * once all items are done.
+ */
+struct batch_item {
+    void *data;                     /* blob (load) or blobref (store) */
+    int len;
+    int errnum;
+};
+
+struct batch {
+    flux_t *h;
+    const flux_msg_t *msg;
+    const char *type;
+    int count;
+    int pending;                    /* items not done, +1 for the handler */
+    struct batch_item *items;
+};
+
+/* One item of a batch, waiting on a cache entry.
+ */
+struct batch_waiter {
+    struct batch *batch;
+    int index;
 };
 
 static void flush_respond (content_cache_t *cache);
 static int cache_flush (content_cache_t *cache);
+static void cache_readahead (content_cache_t *cache, struct cache_entry *e);
+static void writeback_send (content_cache_t *cache);
+static int cache_epoch (content_cache_t *cache);
+static void purge_kick (content_cache_t *cache);
+
+static void batch_destroy (struct batch *b)
+{
+    if (b) {
+        int saved_errno = errno;
+        int i;
+        for (i = 0; i < b->count; i++)
+            free (b->items[i].data);
+        free (b->items);
+        flux_msg_decref (b->msg);
+        free (b);
+        errno = saved_errno;
+    }
+}
+
+static struct batch *batch_create (flux_t *h,
+                                   const flux_msg_t *msg,
+                                   int count,
+                                   const char *type)
+{
+    struct batch *b;
+
+    if (!(b = calloc (1, sizeof (*b))))
+        return NULL;
+    if (count > 0 && !(b->items = calloc (count, sizeof (b->items[0])))) {
+        free (b);
+        return NULL;
+    }
+    b->h = h;
+    b->msg = flux_msg_incref (msg);
+    b->type = type;
+    b->count = count;
+    b->pending = count + 1;
+    return b;
+}
+
+static void batch_respond (struct batch *b)
+{
+    struct blobbatch *bb;
+    const void *buf;
+    int len;
+    int rc = 0;
+    int i;
+
+    if (!(bb = blobbatch_create ()))
+        goto error;
+    for (i = 0; i < b->count; i++) {
+        if (b->items[i].errnum)
+            rc = blobbatch_append_error (bb, b->items[i].errnum);
+        else
+            rc = blobbatch_append (bb, b->items[i].data, b->items[i].len);
+        if (rc < 0)
+            goto error;
+    }
+    blobbatch_encode (bb, &buf, &len);
+    if (flux_respond_raw (b->h, b->msg, buf, len) < 0)
+        flux_log_error (b->h, "content %s: flux_respond_raw", b->type);
+    blobbatch_destroy (bb);
+    return;
+error:
+    if (flux_respond_error (b->h, b->msg, errno, NULL) < 0)
+        flux_log_error (b->h, "content %s: flux_respond_error", b->type);
+    blobbatch_destroy (bb);
+}
+
+/* Drop one pending count, responding and destroying 'b' on the last.
+ */
+static void batch_decref (struct batch *b)
+{
+    if (--b->pending == 0) {
+        batch_respond (b);
+        batch_destroy (b);
+    }
+}
+
+/* Record the result of item 'index', either 'len' bytes of 'data',
+ * or if 'errnum' is nonzero, an error.
+ */
+static void batch_item_done (struct batch *b,
+                             int index,
+                             const void *data,
+                             int len,
+                             int errnum)
+{
+    struct batch_item *item = &b->items[index];
+
+    if (!errnum && len > 0) {
+        if (!(item->data = malloc (len)))
+            errnum = ENOMEM;
+        else {
+            memcpy (item->data, data, len);
+            item->len = len;
+        }
+    }
+    item->errnum = errnum;
+    batch_decref (b);
+}
+
+/* Add item 'index' of batch 'b' to a list of waiters, creating the list
+ * as needed.  Returns 0 on success, -1 on failure with errno set.
+ */
+static int batch_list_add (zlist_t **l, struct batch *b, int index)
+{
+    struct batch_waiter *w;
+
+    if (!*l && !(*l = zlist_new ()))
+        goto nomem;
+    if (!(w = calloc (1, sizeof (*w))))
+        goto nomem;
+    w->batch = b;
+    w->index = index;
+    if (zlist_append (*l, w) < 0) {
+        free (w);
+        goto nomem;
+    }
+    return 0;
+nomem:
+    errno = ENOMEM;
+    return -1;
+}
+
+/* Record the same result for a list of waiting batch items.
+ * The list is always run to completion, then destroyed.
+ */
+static void batch_list_respond (zlist_t **l,
+                                const void *data,
+                                int len,
+                                int errnum)
+{
+    if (*l) {
+        struct batch_waiter *w;
+        while ((w = zlist_pop (*l))) {
+            batch_item_done (w->batch, w->index, data, len, errnum);
+            free (w);
+        }
+        zlist_destroy (l);
+    }
+}
 
 static void request_list_destroy (zlist_t **l)
 {
@@ -157,7 +428,7 @@ static void cache_entry_destroy (void *arg)
 {
     struct cache_entry *e = arg;
     if (e) {
-        if (e->data)
+        if (e->data && !e->mapped)
             free (e->data);
         if (e->blobref)
             free (e->blobref);
@@ -169,6 +440,8 @@ static void cache_entry_destroy (void *arg)
                       __FUNCTION__);
         request_list_destroy (&e->load_requests);
         request_list_destroy (&e->store_requests);
+        batch_list_respond (&e->load_batches, NULL, 0, ECANCELED);
+        batch_list_respond (&e->store_batches, NULL, 0, ECANCELED);
         free (e);
     }
 }
@@ -216,6 +489,150 @@ done:
     return rc;
 }
 
+/* LRU lists
+ */
+
+static void lru_init (struct lru_list *l)
+{
+    l->head.prev = l->head.next = &l->head;
+    l->size = 0;
+    l->count = 0;
+}
+
+static void lru_push (struct lru_list *l, struct lru_node *n, int len)
+{
+    n->next = l->head.next;
+    n->prev = &l->head;
+    l->head.next->prev = n;
+    l->head.next = n;
+    l->size += len;
+    l->count++;
+}
+
+static void lru_unlink (struct lru_list *l, struct lru_node *n, int len)
+{
+    n->prev->next = n->next;
+    n->next->prev = n->prev;
+    n->prev = n->next = NULL;
+    l->size -= len;
+    l->count--;
+}
+
+static struct lru_node *lru_tail (struct lru_list *l)
+{
+    return l->count > 0 ? l->head.prev : NULL;
+}
+
+/* ARC replacement
+ */
+
+static void ghost_destroy (void *arg)
+{
+    free (arg);
+}
+
+static void ghost_remove (content_cache_t *cache, struct ghost *g)
+{
+    lru_unlink (g->list, &g->lru, g->len);
+    zhash_delete (cache->ghosts, g->blobref);
+}
+
+static void ghost_add (content_cache_t *cache,
+                       struct lru_list *l,
+                       struct cache_entry *e)
+{
+    struct ghost *g;
+
+    if (!(g = calloc (1, sizeof (*g) + strlen (e->blobref) + 1)))
+        return; /* the ghost is only a hint */
+    strcpy (g->blobref, e->blobref);
+    g->len = e->len;
+    g->list = l;
+    if (zhash_insert (cache->ghosts, g->blobref, g) < 0) {
+        ghost_destroy (g);
+        return;
+    }
+    zhash_freefn (cache->ghosts, g->blobref, ghost_destroy);
+    lru_push (l, &g->lru, g->len);
+}
+
+/* Keep the recent list and its ghosts within the cache size target,
+ * and all lists within twice the target, as in ARC.  Ghosts are also
+ * kept within the entry count target.
+ */
+static void ghost_trim (content_cache_t *cache)
+{
+    uint64_t c = cache->purge_target_size;
+
+    while (cache->b1.count > 0 && cache->t1.size + cache->b1.size > c)
+        ghost_remove (cache, (struct ghost *)lru_tail (&cache->b1));
+    while (cache->b2.count > 0 && cache->t1.size + cache->t2.size
+                                  + cache->b1.size + cache->b2.size > 2 * c)
+        ghost_remove (cache, (struct ghost *)lru_tail (&cache->b2));
+    while (cache->b1.count + cache->b2.count > cache->purge_target_entries) {
+        if (cache->b1.count >= cache->b2.count)
+            ghost_remove (cache, (struct ghost *)lru_tail (&cache->b1));
+        else
+            ghost_remove (cache, (struct ghost *)lru_tail (&cache->b2));
+    }
+}
+
+/* Put 'e' on an ARC list if it has just become evictable.
+ */
+static void arc_admit (content_cache_t *cache, struct cache_entry *e)
+{
+    struct ghost *g;
+
+    if (!e->valid || e->dirty || e->arc_list)
+        return;
+    if ((g = zhash_lookup (cache->ghosts, e->blobref))) {
+        uint64_t delta = g->len > 0 ? g->len : 1;
+
+        if (g->list == &cache->b1) {
+            if (cache->b2.size > cache->b1.size && cache->b1.size > 0)
+                delta *= cache->b2.size / cache->b1.size;
+            cache->arc_p += delta;
+            if (cache->arc_p > cache->purge_target_size)
+                cache->arc_p = cache->purge_target_size;
+        }
+        else {
+            if (cache->b1.size > cache->b2.size && cache->b2.size > 0)
+                delta *= cache->b1.size / cache->b2.size;
+            cache->arc_p = cache->arc_p > delta ? cache->arc_p - delta : 0;
+        }
+        ghost_remove (cache, g);
+        cache->ghost_hits++;
+        e->arc_list = &cache->t2;
+    }
+    else
+        e->arc_list = &cache->t1;
+    lru_push (e->arc_list, &e->lru, e->len);
+    purge_kick (cache);
+}
+
+/* Take 'e' off its ARC list, e.g. because it is dirty again.
+ */
+static void arc_unlink (content_cache_t *cache, struct cache_entry *e)
+{
+    if (e->arc_list) {
+        lru_unlink (e->arc_list, &e->lru, e->len);
+        e->arc_list = NULL;
+    }
+}
+
+/* Note a reference to 'e'.  An evictable entry moves to the head of
+ * the frequent list.
+ */
+static void arc_touch (content_cache_t *cache, struct cache_entry *e)
+{
+    e->lastused = cache_epoch (cache);
+    if (e->arc_list) {
+        lru_unlink (e->arc_list, &e->lru, e->len);
+        e->arc_list = &cache->t2;
+        lru_push (e->arc_list, &e->lru, e->len);
+    }
+}
+
 /* Insert a cache entry, by blobref.
  * Returns 0 on success, -1 on failure with errno set.
  * Side effect: destroys entry on failure.
@@ -253,15 +670,45 @@ static void remove_entry (content_cache_t *cache, struct cache_entry *e)
 {
     assert (!e->load_requests || zlist_size (e->load_requests) == 0);
     assert (!e->store_requests || zlist_size (e->store_requests) == 0);
+    assert (!e->load_batches || zlist_size (e->load_batches) == 0);
+    assert (!e->store_batches || zlist_size (e->store_batches) == 0);
+    arc_unlink (cache, e);
     if (e->valid) {
         cache->acct_size -= e->len;
         cache->acct_valid--;
     }
     if (e->dirty)
         cache->acct_dirty--;
+    if (e->prefetched)
+        cache->prefetch_wasted++;
     zhash_delete (cache->entries, e->blobref);
 }
 
+/* On rank 0, blobrefs known to be in the backing store are added to a
+ * bloom filter, which outlives their cache entries.  Before a dirty entry
+ * whose blobref is in the filter is stored, the backing store is asked
+ * whether it already has the blob, with a content-backing.has request that
+ * carries only blobrefs.  If it does, the entry is made clean without
+ * sending its data.  A false positive costs only the extra request.
+ */
+static void stored_add (content_cache_t *cache, const char *blobref)
+{
+    if (!cache->stored)
+        return;
+    if (bloom_count (cache->stored) >= stored_filter_keys)
+        bloom_clear (cache->stored);
+    bloom_add (cache->stored, blobref, strlen (blobref));
+}
+
+static bool probe_wanted (content_cache_t *cache, struct cache_entry *e)
+{
+    return cache->rank == 0
+        && cache->backing
+        && cache->backing_has
+        && !e->probed
+        && bloom_check (cache->stored, e->blobref, strlen (e->blobref));
+}
+
 /* Load operation
  *
  * If a cache entry is already present and valid, response is immediate.
@@ -271,17 +718,48 @@ static void remove_entry (content_cache_t *cache, struct cache_entry *e)
  * Once the response is received, identical responses are sent to all
  * parked requests, and cache entry is made valid or removed if there was
  * an error such as ENOENT.
+ *
+ * A content.load-batch request is handled the same way for each of its
+ * blobrefs, except that the entries that must be loaded are requested
+ * together in content.load-batch requests of their own.
  */
 
-static void cache_load_continuation (flux_future_t *f, void *arg)
+static void entry_respond_load (content_cache_t *cache, struct cache_entry *e)
 {
-    content_cache_t *cache = arg;
-    struct cache_entry *e = flux_future_aux_get (f, "entry");
-    const void *data = NULL;
-    int len = 0;
+    request_list_respond_raw (&e->load_requests,
+                              cache->h,
+                              e->data,
+                              e->len,
+                              "load");
+    batch_list_respond (&e->load_batches, e->data, e->len, 0);
+}
+
+static void entry_respond_load_error (content_cache_t *cache,
+                                      struct cache_entry *e,
+                                      int errnum)
+{
+    request_list_respond_error (&e->load_requests,
+                                cache->h,
+                                errnum,
+                                NULL,
+                                "load");
+    batch_list_respond (&e->load_batches, NULL, 0, errnum);
+}
 
+/* Finish a load of 'e' that returned 'rc' (with errno set on failure).
+ */
+static void cache_load_finish (content_cache_t *cache,
+                               struct cache_entry *e,
+                               int rc,
+                               const void *data,
+                               int len)
+{
     e->load_pending = 0;
-    if (flux_content_load_get (f, &data, &len) < 0) {
+    if (e->prefetch_load) {
+        e->prefetch_load = 0;
+        cache->prefetch_inflight--;
+    }
+    if (rc < 0) {
         if (errno == ENOSYS && cache->rank == 0)
             errno = ENOENT;
         if (errno != ENOENT)
@@ -297,21 +775,29 @@ static void cache_load_continuation (flux_future_t *f, void *arg)
         cache->acct_valid++;
         cache->acct_size += len;
     }
-    e->lastused = cache->epoch;
-    request_list_respond_raw (&e->load_requests,
-                              cache->h,
-                              e->data,
-                              e->len,
-                              "load");
-    flux_future_destroy (f);
+    if (cache->rank == 0)
+        stored_add (cache, e->blobref);
+    e->lastused = cache_epoch (cache);
+    arc_admit (cache, e);
+    entry_respond_load (cache, e);
+    if (!e->prefetched)
+        cache_readahead (cache, e);
     return;
 error:
-    request_list_respond_error (&e->load_requests,
-                                cache->h,
-                                errno,
-                                NULL,
-                                "load");
+    entry_respond_load_error (cache, e, errno);
     remove_entry (cache, e);
+}
+
+static void cache_load_continuation (flux_future_t *f, void *arg)
+{
+    content_cache_t *cache = arg;
+    struct cache_entry *e = flux_future_aux_get (f, "entry");
+    const void *data = NULL;
+    int len = 0;
+    int rc;
+
+    rc = flux_content_load_get (f, &data, &len);
+    cache_load_finish (cache, e, rc, data, len);
     flux_future_destroy (f);
 }
 
@@ -352,6 +838,257 @@ done:
     return rc;
 }
 
+static void entry_list_destroy (void *arg)
+{
+    zlist_t *l = arg;
+    zlist_destroy (&l);
+}
+
+static void cache_load_batch_continuation (flux_future_t *f, void *arg)
+{
+    content_cache_t *cache = arg;
+    zlist_t *l = flux_future_aux_get (f, "entries");
+    struct cache_entry *e;
+    const void *data;
+    int len;
+    int index = 0;
+    int rc;
+
+    e = zlist_first (l);
+    while (e) {
+        data = NULL;
+        len = 0;
+        rc = flux_content_load_batch_get (f, index++, &data, &len);
+        cache_load_finish (cache, e, rc, data, len);
+        e = zlist_next (l);
+    }
+    flux_future_destroy (f);
+}
+
+/* Send one content.load-batch request for the entries in 'l',
+ * taking ownership of 'l' on success.
+ */
+static int cache_load_send (content_cache_t *cache, zlist_t *l)
+{
+    const char *blobrefs[batch_max_count];
+    struct cache_entry *e;
+    flux_future_t *f;
+    int flags = CONTENT_FLAG_UPSTREAM;
+    int count = 0;
+
+    if (cache->rank == 0)
+        flags = CONTENT_FLAG_CACHE_BYPASS;
+    e = zlist_first (l);
+    while (e) {
+        blobrefs[count++] = e->blobref;
+        e = zlist_next (l);
+    }
+    if (!(f = flux_content_load_batch (cache->h, blobrefs, count, flags)))
+        return -1;
+    if (flux_future_aux_set (f, "entries", l, entry_list_destroy) < 0
+        || flux_future_then (f, -1., cache_load_batch_continuation, cache) < 0) {
+        flux_future_destroy (f);
+        return -1;
+    }
+    e = zlist_first (l);
+    while (e) {
+        e->load_pending = 1;
+        e = zlist_next (l);
+    }
+    return 0;
+}
+
+/* Load the entries queued on 'l', at most batch_max_count per request.
+ * Entries that cannot be requested fail as if their load had failed.
+ * On return, 'l' is empty.
+ */
+static void cache_load_batch (content_cache_t *cache, zlist_t *l)
+{
+    struct cache_entry *e;
+
+    while (zlist_size (l) > 0) {
+        zlist_t *batch;
+
+        if (zlist_size (l) == 1) {
+            e = zlist_pop (l);
+            e->queued = 0;
+            if (cache_load (cache, e) < 0)
+                cache_load_finish (cache, e, -1, NULL, 0);
+            continue;
+        }
+        if (!(batch = zlist_new ()))
+            goto nomem;
+        while (zlist_size (batch) < batch_max_count
+               && (e = zlist_first (l))) {
+            if (zlist_append (batch, e) < 0) {
+                zlist_destroy (&batch);
+                goto nomem;
+            }
+            (void)zlist_pop (l);
+            e->queued = 0;
+        }
+        if (cache_load_send (cache, batch) < 0) {
+            int saved_errno = errno;
+            flux_log_error (cache->h, "content load-batch");
+            while ((e = zlist_pop (batch))) {
+                errno = saved_errno;
+                cache_load_finish (cache, e, -1, NULL, 0);
+            }
+            zlist_destroy (&batch);
+        }
+    }
+    return;
+nomem:
+    while ((e = zlist_pop (l))) {
+        e->queued = 0;
+        errno = ENOMEM;
+        cache_load_finish (cache, e, -1, NULL, 0);
+    }
+}
+
+/* Snapshot
+ *
+ * On rank 0, content.snapshot may name a file written by
+ * 'flux content snapshot', holding the blobs reachable from a KVS root.
+ * A blob that is not cached is served from the snapshot, if it has it,
+ * before the backing store is asked.  The entry's data points into the
+ * snapshot's mapping rather than being copied.  The entry is clean,
+ * since the snapshot must have been taken from the backing store the
+ * instance is restarted with.
+ */
+static struct cache_entry *snapshot_entry (content_cache_t *cache,
+                                           const char *blobref)
+{
+    struct cache_entry *e;
+    const void *data;
+    int len;
+
+    if (!cache->snapshot
+        || blobsnap_get (cache->snapshot, blobref, &data, &len) < 0)
+        return NULL;
+    if (!(e = cache_entry_create (cache->h, blobref))
+        || insert_entry (cache, e) < 0)
+        return NULL; /* insert destroys 'e' on failure */
+    e->data = (void *)data;
+    e->len = len;
+    e->mapped = 1;
+    e->valid = 1;
+    cache->acct_valid++;
+    cache->acct_size += len;
+    e->lastused = cache_epoch (cache);
+    arc_admit (cache, e);
+    cache->snapshot_hits++;
+    return e;
+}
+
+/* Readahead
+ *
+ * The KVS loads a directory, then typically many of its entries.  So once
+ * a loaded blob that is a treeobj dir or dirshard is used, the blobs it
+ * refers to are loaded too, in the background, at most prefetch_limit
+ * at a time.  Entries created this way are marked prefetched until a
+ * load request uses them, which counts as a prefetch hit, and then their
+ * own children are read ahead in turn.  A prefetched entry removed before
+ * it is used counts as wasted.
+ */
+
+/* Start a readahead load of 'blobref' unless it is cached or the budget
+ * is spent.  Returns -1 once the budget is spent, else 0.
+ */
+static int readahead_blobref (content_cache_t *cache,
+                              const char *blobref,
+                              zlist_t *l)
+{
+    struct cache_entry *e;
+
+    if (cache->prefetch_inflight >= cache->prefetch_limit)
+        return -1;
+    if (lookup_entry (cache, blobref) || snapshot_entry (cache, blobref))
+        return 0;
+    if (!(e = cache_entry_create (cache->h, blobref))
+        || insert_entry (cache, e) < 0)
+        return 0; /* insert destroys 'e' on failure */
+    if (zlist_append (l, e) < 0) {
+        remove_entry (cache, e);
+        return 0;
+    }
+    e->queued = 1;
+    e->prefetched = 1;
+    e->prefetch_load = 1;
+    cache->prefetch_inflight++;
+    cache->prefetch_issued++;
+    return 0;
+}
+
+/* Read ahead the blobs referenced by the entries of dir or dirshard 'obj',
+ * including those of dirs and dirshards embedded in it.
+ */
+static int readahead_treeobj (content_cache_t *cache,
+                              const json_t *obj,
+                              zlist_t *l)
+{
+    json_t *data = treeobj_get_data ((json_t *)obj);
+    const char *key;
+    json_t *o;
+
+    if (treeobj_is_dirshard (obj))
+        data = json_object_get (data, "shards");
+    json_object_foreach (data, key, o) {
+        if (treeobj_is_valref (o) || treeobj_is_dirref (o)) {
+            int count = treeobj_get_count (o);
+            for (int i = 0; i < count; i++) {
+                const char *blobref = treeobj_get_blobref (o, i);
+                if (blobref && readahead_blobref (cache, blobref, l) < 0)
+                    return -1;
+            }
+        }
+        else if (treeobj_is_dir (o) || treeobj_is_dirshard (o)) {
+            if (readahead_treeobj (cache, o, l) < 0)
+                return -1;
+        }
+    }
+    return 0;
+}
+
+/* Only blobs that look like a JSON object or a binary treeobj are
+ * decoded, so most value blobs are skipped cheaply.
+ */
+static void cache_readahead (content_cache_t *cache, struct cache_entry *e)
+{
+    const char *data = e->data;
+    json_t *obj;
+    zlist_t *l;
+
+    if (cache->prefetch_limit == 0
+        || cache->prefetch_inflight >= cache->prefetch_limit
+        || (cache->rank == 0 && !cache->backing)
+        || e->len < 4
+        || (data[0] != '{' && memcmp (data, "\0TO\1", 4) != 0))
+        return;
+    if (!(obj = treeobj_decodeb (data, e->len)))
+        return;
+    if ((treeobj_is_dir (obj) || treeobj_is_dirshard (obj))
+        && (l = zlist_new ())) {
+        (void)readahead_treeobj (cache, obj, l);
+        cache_load_batch (cache, l);
+        zlist_destroy (&l);
+    }
+    json_decref (obj);
+}
+
+/* Note a load request's use of 'e', counting a prefetch hit if it was
+ * read ahead.
+ */
+static void readahead_used (content_cache_t *cache, struct cache_entry *e)
+{
+    if (e->prefetched) {
+        e->prefetched = 0;
+        cache->prefetch_hits++;
+        if (e->valid)
+            cache_readahead (cache, e);
+    }
+}
+
 void content_load_request (flux_t *h, flux_msg_handler_t *mh,
                            const flux_msg_t *msg, void *arg)
 {
@@ -369,7 +1106,8 @@ void content_load_request (flux_t *h, flux_msg_handler_t *mh,
         errno = EPROTO;
         goto error;
     }
-    if (!(e = lookup_entry (cache, blobref))) {
+    if (!(e = lookup_entry (cache, blobref))
+        && !(e = snapshot_entry (cache, blobref))) {
         if (cache->rank == 0 && !cache->backing) {
             errno = ENOENT;
             goto error;
@@ -381,15 +1119,19 @@ void content_load_request (flux_t *h, flux_msg_handler_t *mh,
         }
     }
     if (!e->valid) {
+        cache->misses++;
         if (cache_load (cache, e) < 0)
             goto error;
         if (request_list_add (&e->load_requests, msg) < 0) {
             flux_log_error (h, "content load");
             goto error;
         }
+        readahead_used (cache, e);
         return; /* RPC continuation will respond to msg */
     }
-    e->lastused = cache->epoch;
+    cache->hits++;
+    arc_touch (cache, e);
+    readahead_used (cache, e);
     data = e->data;
     len = e->len;
     if (flux_respond_raw (h, msg, data, len) < 0)
@@ -400,6 +1142,80 @@ error:
         flux_log_error (h, "content load: flux_respond_error");
 }
 
+static void content_load_batch_request (flux_t *h, flux_msg_handler_t *mh,
+                                        const flux_msg_t *msg, void *arg)
+{
+    content_cache_t *cache = arg;
+    const void *buf;
+    int len;
+    struct blobbatch *req = NULL;
+    struct batch *b = NULL;
+    zlist_t *l = NULL;
+    int count;
+    int i;
+
+    if (flux_request_decode_raw (msg, NULL, &buf, &len) < 0
+        || !(req = blobbatch_decode (buf, len)))
+        goto error;
+    count = blobbatch_count (req);
+    if (!(b = batch_create (h, msg, count, "load-batch"))
+        || !(l = zlist_new ())) {
+        errno = ENOMEM;
+        goto error;
+    }
+    for (i = 0; i < count; i++) {
+        const char *blobref;
+        struct cache_entry *e;
+
+        if (!(blobref = blobbatch_get_string (req, i)))
+            goto item_error;
+        if (!(e = lookup_entry (cache, blobref))
+            && !(e = snapshot_entry (cache, blobref))) {
+            if (cache->rank == 0 && !cache->backing) {
+                errno = ENOENT;
+                goto item_error;
+            }
+            if (!(e = cache_entry_create (h, blobref))
+                                            || insert_entry (cache, e) < 0) {
+                flux_log_error (h, "content load-batch");
+                goto item_error;
+            }
+        }
+        if (!e->valid) {
+            cache->misses++;
+            if (batch_list_add (&e->load_batches, b, i) < 0)
+                goto item_error;
+            if (!e->load_pending && !e->queued) {
+                if (zlist_append (l, e) < 0) {
+                    errno = ENOMEM;
+                    goto item_error;
+                }
+                e->queued = 1;
+            }
+            readahead_used (cache, e);
+            continue; /* item is done when the entry is loaded */
+        }
+        cache->hits++;
+        arc_touch (cache, e);
+        readahead_used (cache, e);
+        batch_item_done (b, i, e->data, e->len, 0);
+        continue;
+item_error:
+        batch_item_done (b, i, NULL, 0, errno);
+    }
+    cache_load_batch (cache, l);
+    zlist_destroy (&l);
+    blobbatch_destroy (req);
+    batch_decref (b);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "content load-batch: flux_respond_error");
+    zlist_destroy (&l);
+    batch_destroy (b);
+    blobbatch_destroy (req);
+}
+
 /* Store operation
  *
  * If a cache entry is already valid and not dirty, response is immediate.
@@ -417,8 +1233,37 @@ error:
  * while holding the invariant that after a store RPC returns, the entry may
  * be loaded from any rank.  The optional content.backing service can
  * offload rank 0 hash entries at a slower pace.
+ *
+ * A content.store-batch request is handled the same way for each of its
+ * blobs.  Dirty entries are sent upstream, or to the backing store, in
+ * content.store-batch requests of their own, as is done by cache_flush().
  */
 
+static void entry_respond_store (content_cache_t *cache, struct cache_entry *e)
+{
+    request_list_respond_raw (&e->store_requests,
+                              cache->h,
+                              e->blobref,
+                              strlen (e->blobref) + 1,
+                              "store");
+    batch_list_respond (&e->store_batches,
+                        e->blobref,
+                        strlen (e->blobref) + 1,
+                        0);
+}
+
+static void entry_respond_store_error (content_cache_t *cache,
+                                       struct cache_entry *e,
+                                       int errnum)
+{
+    request_list_respond_error (&e->store_requests,
+                                cache->h,
+                                errnum,
+                                NULL,
+                                "store");
+    batch_list_respond (&e->store_batches, NULL, 0, errnum);
+}
+
 /* If cache has been flushed, respond to flush requests, if any.
  * If there are still dirty entries and the number of outstanding
  * store requests would not exceed the limit, flush more entries.
@@ -426,162 +1271,575 @@ error:
  * only do it when the number of outstanding store requests falls to
  * a low water mark, here hardwired to be half of the limit.
  */
-static void cache_resume_flush (content_cache_t *cache)
+static void cache_resume_flush (content_cache_t *cache)
+{
+    if (cache->acct_dirty == 0 || (cache->rank == 0 && !cache->backing))
+        flush_respond (cache);
+    else if (cache->acct_dirty - cache->flush_batch_count > 0
+            && cache->flush_batch_count <= cache->flush_batch_limit / 2)
+        (void)cache_flush (cache); /* resume flushing */
+}
+
+/* Finish a store of 'e' that returned 'rc' (with errno set on failure).
+ */
+static void cache_store_finish (content_cache_t *cache,
+                                struct cache_entry *e,
+                                int rc,
+                                const char *blobref)
+{
+    e->store_pending = 0;
+    e->probed = 0;
+    assert (cache->flush_batch_count > 0);
+    cache->flush_batch_count--;
+    if (rc < 0) {
+        if (cache->rank == 0 && errno == ENOSYS)
+            flux_log (cache->h, LOG_DEBUG, "content store: %s",
+                      "backing store service unavailable");
+        else
+            flux_log_error (cache->h, "content store");
+        goto error;
+    }
+    if (strcmp (blobref, e->blobref)) {
+        flux_log (cache->h, LOG_ERR, "content store: wrong blobref");
+        errno = EIO;
+        goto error;
+    }
+    if (e->dirty) {
+        cache->acct_dirty--;
+        e->dirty = 0;
+    }
+    if (cache->rank == 0)
+        stored_add (cache, e->blobref);
+    arc_admit (cache, e);
+    entry_respond_store (cache, e);
+    return;
+error:
+    entry_respond_store_error (cache, e, errno);
+}
+
+static void cache_store_continuation (flux_future_t *f, void *arg)
+{
+    content_cache_t *cache = arg;
+    struct cache_entry *e = flux_future_aux_get (f, "entry");
+    const char *blobref = NULL;
+    int rc;
+
+    rc = flux_content_store_get (f, &blobref);
+    cache_store_finish (cache, e, rc, blobref);
+    flux_future_destroy (f);
+    cache_resume_flush (cache);
+}
+
+static int cache_probe_send (content_cache_t *cache, zlist_t *l);
+static int cache_store_batch (content_cache_t *cache, zlist_t *l);
+
+/* Ask the backing store whether it has 'e'.  Returns 0 if the request
+ * was sent, or -1 if 'e' should be stored now.
+ */
+static int cache_probe (content_cache_t *cache, struct cache_entry *e)
+{
+    zlist_t *l;
+
+    if (!(l = zlist_new ()))
+        return -1;
+    if (zlist_append (l, e) < 0 || cache_probe_send (cache, l) < 0) {
+        zlist_destroy (&l);
+        return -1;
+    }
+    return 0;
+}
+
+static int cache_store (content_cache_t *cache, struct cache_entry *e)
+{
+    flux_future_t *f;
+    int saved_errno = 0;
+    int flags = CONTENT_FLAG_UPSTREAM;
+    int rc = -1;
+
+    assert (e->valid);
+
+    if (e->store_pending)
+        return 0;
+    if (cache->rank == 0) {
+        if (cache->flush_batch_count >= cache->flush_batch_limit)
+            return 0;
+        if (probe_wanted (cache, e) && cache_probe (cache, e) == 0)
+            return 0;
+        flags = CONTENT_FLAG_CACHE_BYPASS;
+    }
+    if (!(f = flux_content_store (cache->h, e->data, e->len, flags))) {
+        saved_errno = errno;
+        flux_log_error (cache->h, "content store");
+        goto done;
+    }
+    if (flux_future_aux_set (f, "entry", e, NULL) < 0) {
+        flux_log_error (cache->h, "content store: flux_future_aux_set");
+        goto done;
+    }
+    if (flux_future_then (f, -1., cache_store_continuation, cache) < 0) {
+        saved_errno = errno;
+        flux_log_error (cache->h, "content store");
+        flux_future_destroy (f);
+        goto done;
+    }
+    e->store_pending = 1;
+    cache->flush_batch_count++;
+    rc = 0;
+done:
+    if (rc < 0)
+        errno = saved_errno;
+    return rc;
+}
+
+static void cache_store_batch_continuation (flux_future_t *f, void *arg)
+{
+    content_cache_t *cache = arg;
+    zlist_t *l = flux_future_aux_get (f, "entries");
+    struct cache_entry *e;
+    const char *blobref;
+    int index = 0;
+    int rc;
+
+    e = zlist_first (l);
+    while (e) {
+        blobref = NULL;
+        rc = flux_content_store_batch_get (f, index++, &blobref);
+        cache_store_finish (cache, e, rc, blobref);
+        e = zlist_next (l);
+    }
+    if (flux_future_aux_get (f, "writeback")) {
+        cache->writeback_inflight--;
+        writeback_send (cache); // spend the returned credit
+    }
+    flux_future_destroy (f);
+    cache_resume_flush (cache);
+}
+
+/* Send one content.store-batch request for the entries in 'l',
+ * taking ownership of 'l' on success.  If 'writeback' is true, the
+ * request holds a writeback credit until its response is received.
+ */
+static int cache_store_send (content_cache_t *cache,
+                             zlist_t *l,
+                             bool writeback)
+{
+    const void *bufs[batch_max_count];
+    int lens[batch_max_count];
+    struct cache_entry *e;
+    flux_future_t *f;
+    int flags = CONTENT_FLAG_UPSTREAM;
+    int count = 0;
+
+    if (cache->rank == 0)
+        flags = CONTENT_FLAG_CACHE_BYPASS;
+    e = zlist_first (l);
+    while (e) {
+        bufs[count] = e->data;
+        lens[count++] = e->len;
+        e = zlist_next (l);
+    }
+    if (!(f = flux_content_store_batch (cache->h, bufs, lens, count, flags)))
+        return -1;
+    if (flux_future_aux_set (f, "entries", l, entry_list_destroy) < 0
+        || (writeback
+            && flux_future_aux_set (f, "writeback", cache, NULL) < 0)
+        || flux_future_then (f,
+                             -1.,
+                             cache_store_batch_continuation,
+                             cache) < 0) {
+        flux_future_destroy (f);
+        return -1;
+    }
+    if (writeback) {
+        cache->writeback_inflight++;
+        cache->writeback_batches++;
+    }
+    e = zlist_first (l);
+    while (e) {
+        e->store_pending = 1;
+        cache->flush_batch_count++;
+        e = zlist_next (l);
+    }
+    return 0;
+}
+
+/* Entries the backing store has are finished as if stored.  The rest
+ * are stored now.
+ */
+static void cache_probe_continuation (flux_future_t *f, void *arg)
+{
+    content_cache_t *cache = arg;
+    zlist_t *l = flux_future_aux_get (f, "entries");
+    zlist_t *store = zlist_new ();
+    struct cache_entry *e;
+    int index = 0;
+
+    e = zlist_first (l);
+    while (e) {
+        if (flux_content_has_get (f, index++) == 0) {
+            cache->dedup_hits++;
+            cache_store_finish (cache, e, 0, e->blobref);
+        }
+        else {
+            if (errno == ENOSYS)
+                cache->backing_has = 0;
+            e->store_pending = 0;
+            e->probed = 1;
+            cache->flush_batch_count--;
+            /* If the entry can't be queued here, it is still dirty,
+             * and the next cache_flush() picks it up.
+             */
+            if (store && zlist_append (store, e) == 0)
+                e->queued = 1;
+        }
+        e = zlist_next (l);
+    }
+    flux_future_destroy (f);
+    if (store) {
+        (void)cache_store_batch (cache, store);
+        zlist_destroy (&store);
+    }
+    cache_resume_flush (cache);
+}
+
+/* Send one content-backing.has request for the entries in 'l',
+ * taking ownership of 'l' on success.  The entries are store_pending
+ * until the response is received.
+ */
+static int cache_probe_send (content_cache_t *cache, zlist_t *l)
+{
+    const char *blobrefs[batch_max_count];
+    struct cache_entry *e;
+    flux_future_t *f;
+    int count = 0;
+
+    e = zlist_first (l);
+    while (e) {
+        blobrefs[count++] = e->blobref;
+        e = zlist_next (l);
+    }
+    if (!(f = flux_content_has (cache->h, blobrefs, count)))
+        return -1;
+    if (flux_future_aux_set (f, "entries", l, entry_list_destroy) < 0
+        || flux_future_then (f, -1., cache_probe_continuation, cache) < 0) {
+        flux_future_destroy (f);
+        return -1;
+    }
+    e = zlist_first (l);
+    while (e) {
+        e->store_pending = 1;
+        cache->flush_batch_count++;
+        e = zlist_next (l);
+    }
+    return 0;
+}
+
+/* Move the entries of 'l' that the backing store may already have to
+ * content-backing.has requests, within the flush batch limit.  Entries
+ * whose request cannot be sent are left on 'l' to be stored.
+ */
+static void cache_probe_batch (content_cache_t *cache, zlist_t *l)
+{
+    zlist_t *probe = NULL;
+    struct cache_entry *e;
+
+    e = zlist_first (l);
+    while (e) {
+        if (probe_wanted (cache, e)) {
+            if (!probe && !(probe = zlist_new ()))
+                break;
+            if (zlist_append (probe, e) < 0)
+                break;
+            if (zlist_size (probe) == batch_max_count
+                || cache->flush_batch_count + zlist_size (probe)
+                    >= cache->flush_batch_limit)
+                break;
+        }
+        e = zlist_next (l);
+    }
+    if (probe && zlist_size (probe) > 0) {
+        e = zlist_first (probe);
+        while (e) {
+            zlist_remove (l, e);
+            e->queued = 0;
+            e = zlist_next (probe);
+        }
+        if (cache_probe_send (cache, probe) < 0) {
+            while ((e = zlist_pop (probe))) {
+                if (zlist_append (l, e) == 0)
+                    e->queued = 1;
+            }
+            zlist_destroy (&probe);
+        }
+        else if (zlist_size (l) > 0
+                 && cache->flush_batch_count < cache->flush_batch_limit)
+            cache_probe_batch (cache, l); // next batch_max_count entries
+        return;
+    }
+    zlist_destroy (&probe);
+}
+
+/* Store the dirty entries queued on 'l', at most batch_max_count entries
+ * or batch_max_size bytes per request.  On rank 0, entries beyond the
+ * flush batch limit are left dirty for cache_resume_flush() to pick up.
+ * If a request cannot be sent, its entries' store waiters fail.
+ * On return, 'l' is empty.
+ */
+static int cache_store_batch (content_cache_t *cache, zlist_t *l)
+{
+    struct cache_entry *e;
+    int saved_errno = 0;
+    int rc = 0;
+
+    if (cache->rank == 0 && cache->backing && cache->backing_has)
+        cache_probe_batch (cache, l);
+    while (zlist_size (l) > 0) {
+        zlist_t *batch;
+        int size = 0;
+
+        if (!(batch = zlist_new ()))
+            goto nomem;
+        while ((e = zlist_first (l))) {
+            if (zlist_size (batch) > 0
+                && (zlist_size (batch) == batch_max_count
+                    || size + e->len > batch_max_size))
+                break;
+            if (cache->rank == 0
+                && cache->flush_batch_count + zlist_size (batch)
+                    >= cache->flush_batch_limit)
+                break;
+            if (zlist_append (batch, e) < 0) {
+                zlist_destroy (&batch);
+                goto nomem;
+            }
+            (void)zlist_pop (l);
+            e->queued = 0;
+            size += e->len;
+        }
+        if (zlist_size (batch) == 0) { // rank 0 flush limit reached
+            zlist_destroy (&batch);
+            break;
+        }
+        if (zlist_size (batch) == 1) {
+            e = zlist_pop (batch);
+            zlist_destroy (&batch);
+            if (cache_store (cache, e) < 0) {
+                saved_errno = errno;
+                entry_respond_store_error (cache, e, errno);
+                rc = -1;
+            }
+            continue;
+        }
+        if (cache_store_send (cache, batch, false) < 0) {
+            saved_errno = errno;
+            flux_log_error (cache->h, "content store-batch");
+            while ((e = zlist_pop (batch)))
+                entry_respond_store_error (cache, e, saved_errno);
+            zlist_destroy (&batch);
+            rc = -1;
+        }
+    }
+    while ((e = zlist_pop (l)))
+        e->queued = 0;
+    if (rc < 0)
+        errno = saved_errno;
+    return rc;
+nomem:
+    while ((e = zlist_pop (l))) {
+        e->queued = 0;
+        entry_respond_store_error (cache, e, ENOMEM);
+    }
+    errno = ENOMEM;
+    return -1;
+}
+
+/* Write-back:  on ranks > 0 with a nonzero content.writeback-window,
+ * dirty entries are held on cache->writeback for up to that many
+ * milliseconds, so that stores from this rank and from its children are
+ * coalesced into content.store-batch requests to the TBON parent.  A blob
+ * stored by several children is queued, and sent upstream, only once.
+ * At most content.writeback-credits batches (0 = unlimited) are in flight;
+ * a credit is returned when the parent responds.  Store requests are still
+ * answered only after the parent has the blob.
+ */
+static bool writeback_enabled (content_cache_t *cache)
 {
-    if (cache->acct_dirty == 0 || (cache->rank == 0 && !cache->backing))
-        flush_respond (cache);
-    else if (cache->acct_dirty - cache->flush_batch_count > 0
-            && cache->flush_batch_count <= cache->flush_batch_limit / 2)
-        (void)cache_flush (cache); /* resume flushing */
+    return cache->rank > 0 && cache->writeback_window > 0;
 }
 
-static void cache_store_continuation (flux_future_t *f, void *arg)
+static int writeback_queue (content_cache_t *cache, struct cache_entry *e)
 {
-    content_cache_t *cache = arg;
-    struct cache_entry *e = flux_future_aux_get (f, "entry");
-    const char *blobref;
-
-    e->store_pending = 0;
-    assert (cache->flush_batch_count > 0);
-    cache->flush_batch_count--;
-    if (flux_content_store_get (f, &blobref) < 0) {
-        if (cache->rank == 0 && errno == ENOSYS)
-            flux_log (cache->h, LOG_DEBUG, "content store: %s",
-                      "backing store service unavailable");
-        else
-            flux_log_error (cache->h, "content store");
-        goto error;
-    }
-    if (strcmp (blobref, e->blobref)) {
-        flux_log (cache->h, LOG_ERR, "content store: wrong blobref");
-        errno = EIO;
-        goto error;
-    }
-    if (e->dirty) {
-        cache->acct_dirty--;
-        e->dirty = 0;
+    if (zlist_append (cache->writeback, e) < 0) {
+        errno = ENOMEM;
+        return -1;
     }
-    request_list_respond_raw (&e->store_requests,
-                              cache->h,
-                              e->blobref,
-                              strlen (e->blobref) + 1,
-                              "store");
-    flux_future_destroy (f);
-    cache_resume_flush (cache);
-    return;
-error:
-    request_list_respond_error (&e->store_requests,
-                                cache->h,
-                                errno,
-                                NULL,
-                                "store");
-    flux_future_destroy (f);
-    cache_resume_flush (cache);
+    e->queued = 1;
+    cache->writeback_size += e->len;
+    return 0;
 }
 
-static int cache_store (content_cache_t *cache, struct cache_entry *e)
+/* Send held entries upstream as far as credits allow.  Entries left on
+ * cache->writeback are sent when a credit is returned.
+ */
+static void writeback_send (content_cache_t *cache)
 {
-    flux_future_t *f;
-    int saved_errno = 0;
-    int flags = CONTENT_FLAG_UPSTREAM;
-    int rc = -1;
+    struct cache_entry *e;
 
-    assert (e->valid);
+    while (zlist_size (cache->writeback) > 0) {
+        zlist_t *batch;
+        int size = 0;
 
-    if (e->store_pending)
-        return 0;
-    if (cache->rank == 0) {
-        if (cache->flush_batch_count >= cache->flush_batch_limit)
-            return 0;
-        flags = CONTENT_FLAG_CACHE_BYPASS;
-    }
-    if (!(f = flux_content_store (cache->h, e->data, e->len, flags))) {
-        saved_errno = errno;
-        flux_log_error (cache->h, "content store");
-        goto done;
+        if (cache->writeback_credits > 0
+            && cache->writeback_inflight >= cache->writeback_credits) {
+            cache->writeback_stalls++;
+            return;
+        }
+        if (!(batch = zlist_new ()))
+            goto nomem;
+        while ((e = zlist_first (cache->writeback))) {
+            if (zlist_size (batch) > 0
+                && (zlist_size (batch) == batch_max_count
+                    || size + e->len > batch_max_size))
+                break;
+            if (zlist_append (batch, e) < 0) {
+                zlist_destroy (&batch);
+                goto nomem;
+            }
+            (void)zlist_pop (cache->writeback);
+            e->queued = 0;
+            cache->writeback_size -= e->len;
+            size += e->len;
+        }
+        if (cache_store_send (cache, batch, true) < 0) {
+            int saved_errno = errno;
+            flux_log_error (cache->h, "content writeback");
+            while ((e = zlist_pop (batch)))
+                entry_respond_store_error (cache, e, saved_errno);
+            zlist_destroy (&batch);
+        }
     }
-    if (flux_future_aux_set (f, "entry", e, NULL) < 0) {
-        flux_log_error (cache->h, "content store: flux_future_aux_set");
-        goto done;
+    return;
+nomem:
+    while ((e = zlist_pop (cache->writeback))) {
+        e->queued = 0;
+        entry_respond_store_error (cache, e, ENOMEM);
     }
-    if (flux_future_then (f, -1., cache_store_continuation, cache) < 0) {
-        saved_errno = errno;
-        flux_log_error (cache->h, "content store");
-        flux_future_destroy (f);
-        goto done;
+    cache->writeback_size = 0;
+}
+
+/* Send a full batch now, otherwise start the window, if not running.
+ */
+static void writeback_kick (content_cache_t *cache)
+{
+    if (zlist_size (cache->writeback) == 0)
+        return;
+    if (zlist_size (cache->writeback) >= batch_max_count
+        || cache->writeback_size >= batch_max_size)
+        writeback_send (cache);
+    else if (!cache->writeback_armed) {
+        flux_timer_watcher_reset (cache->writeback_timer,
+                                  cache->writeback_window * 1E-3,
+                                  0.);
+        flux_watcher_start (cache->writeback_timer);
+        cache->writeback_armed = 1;
     }
-    e->store_pending = 1;
-    cache->flush_batch_count++;
-    rc = 0;
-done:
-    if (rc < 0)
-        errno = saved_errno;
-    return rc;
 }
 
-static void content_store_request (flux_t *h, flux_msg_handler_t *mh,
-                                   const flux_msg_t *msg, void *arg)
+static void writeback_timer_cb (flux_reactor_t *r,
+                                flux_watcher_t *w,
+                                int revents,
+                                void *arg)
 {
     content_cache_t *cache = arg;
-    const void *data;
-    int len;
-    struct cache_entry *e = NULL;
-    char blobref[BLOBREF_MAX_STRING_SIZE];
 
-    if (flux_request_decode_raw (msg, NULL, &data, &len) < 0)
-        goto error;
+    cache->writeback_armed = 0;
+    writeback_send (cache);
+}
+
+/* Add 'len' bytes of 'data' to the cache, computing its blobref.
+ * The entry is made valid if needed, responding to any queued loads,
+ * and is dirty if it has not yet been stored upstream or to the backing
+ * store.  Returns the entry, or NULL on failure with errno set.
+ */
+static struct cache_entry *cache_store_entry (content_cache_t *cache,
+                                              const void *data,
+                                              int len,
+                                              char *blobref,
+                                              int blobref_size)
+{
+    struct cache_entry *e;
+
     if (len > cache->blob_size_limit) {
         errno = EFBIG;
-        goto error;
+        return NULL;
     }
     if (blobref_hash (cache->hash_name, (uint8_t *)data, len, blobref,
-                      sizeof (blobref)) < 0)
-        goto error;
+                      blobref_size) < 0)
+        return NULL;
 
     if (!(e = lookup_entry (cache, blobref))) {
-        if (!(e = cache_entry_create (h, blobref)))
-            goto error;
+        if (!(e = cache_entry_create (cache->h, blobref)))
+            return NULL;
         if (insert_entry (cache, e) < 0)
-            goto error; /* insert destroys 'e' on failure */
+            return NULL; /* insert destroys 'e' on failure */
     }
     if (!e->valid) {
         if (cache_entry_fill (e, data, len) < 0)
-            goto error;
+            return NULL;
         if (!e->valid) {
             e->valid = 1;
             cache->acct_valid++;
             cache->acct_size += len;
         }
-        request_list_respond_raw (&e->load_requests,
-                                  cache->h,
-                                  e->data,
-                                  e->len,
-                                  "load");
+        entry_respond_load (cache, e);
         if (!e->dirty) {
             e->dirty = 1;
             cache->acct_dirty++;
         }
     }
-    e->lastused = cache->epoch;
+    /* When a backing store module is unloaded, it will clear
+     * cache->backing then attempt to store all its blobs.  Any of
+     * those still in cache need to be marked dirty.
+     */
+    else if (!e->dirty && cache->rank == 0 && !cache->backing) {
+        e->dirty = 1;
+        cache->acct_dirty++;
+        arc_unlink (cache, e);
+    }
+    arc_touch (cache, e);
+    return e;
+}
+
+static void content_store_request (flux_t *h, flux_msg_handler_t *mh,
+                                   const flux_msg_t *msg, void *arg)
+{
+    content_cache_t *cache = arg;
+    const void *data;
+    int len;
+    struct cache_entry *e = NULL;
+    char blobref[BLOBREF_MAX_STRING_SIZE];
+
+    if (flux_request_decode_raw (msg, NULL, &data, &len) < 0)
+        goto error;
+    if (!(e = cache_store_entry (cache, data, len, blobref, sizeof (blobref))))
+        goto error;
     if (e->dirty) {
         if (cache->rank > 0 || cache->backing) {
-            if (cache_store (cache, e) < 0)
+            if (writeback_enabled (cache)) {
+                if (!e->store_pending && !e->queued) {
+                    if (writeback_queue (cache, e) < 0)
+                        goto error;
+                    writeback_kick (cache);
+                }
+            }
+            else if (cache_store (cache, e) < 0)
                 goto error;
-            if (cache->rank > 0) {  /* write-through */
+            if (cache->rank > 0) {  /* write-through or write-back */
                 if (request_list_add (&e->store_requests, msg) < 0)
                     goto error;
                 return;
             }
         }
-    } else {
-        /* When a backing store module is unloaded, it will clear
-         * cache->backing then attempt to store all its blobs.  Any of
-         * those still in cache need to be marked dirty.
-         */
-        if (cache->rank == 0 && !cache->backing) {
-            e->dirty = 1;
-            cache->acct_dirty++;
-        }
     }
     if (flux_respond_raw (h, msg, blobref, strlen (blobref) + 1) < 0)
         flux_log_error (h, "content store: flux_respond_raw");
@@ -591,6 +1849,79 @@ error:
         flux_log_error (h, "content store: flux_respond_error");
 }
 
+static void content_store_batch_request (flux_t *h, flux_msg_handler_t *mh,
+                                         const flux_msg_t *msg, void *arg)
+{
+    content_cache_t *cache = arg;
+    const void *buf;
+    int len;
+    struct blobbatch *req = NULL;
+    struct batch *b = NULL;
+    zlist_t *l = NULL;
+    int count;
+    int i;
+
+    if (flux_request_decode_raw (msg, NULL, &buf, &len) < 0
+        || !(req = blobbatch_decode (buf, len)))
+        goto error;
+    count = blobbatch_count (req);
+    if (!(b = batch_create (h, msg, count, "store-batch"))
+        || !(l = zlist_new ())) {
+        errno = ENOMEM;
+        goto error;
+    }
+    for (i = 0; i < count; i++) {
+        char blobref[BLOBREF_MAX_STRING_SIZE];
+        const void *data;
+        int size;
+        struct cache_entry *e;
+
+        if (blobbatch_get (req, i, &data, &size) < 0
+            || !(e = cache_store_entry (cache,
+                                        data,
+                                        size,
+                                        blobref,
+                                        sizeof (blobref))))
+            goto item_error;
+        if (e->dirty && (cache->rank > 0 || cache->backing)) {
+            if (!e->store_pending && !e->queued) {
+                if (writeback_enabled (cache)) {
+                    if (writeback_queue (cache, e) < 0)
+                        goto item_error;
+                }
+                else {
+                    if (zlist_append (l, e) < 0) {
+                        errno = ENOMEM;
+                        goto item_error;
+                    }
+                    e->queued = 1;
+                }
+            }
+            if (cache->rank > 0) {  /* write-through or write-back */
+                if (batch_list_add (&e->store_batches, b, i) < 0)
+                    goto item_error;
+                continue; /* item is done when the entry is stored */
+            }
+        }
+        batch_item_done (b, i, blobref, strlen (blobref) + 1, 0);
+        continue;
+item_error:
+        batch_item_done (b, i, NULL, 0, errno);
+    }
+    (void)cache_store_batch (cache, l); /* failures are sent to waiters */
+    writeback_kick (cache);
+    zlist_destroy (&l);
+    blobbatch_destroy (req);
+    batch_decref (b);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "content store-batch: flux_respond_error");
+    zlist_destroy (&l);
+    batch_destroy (b);
+    blobbatch_destroy (req);
+}
+
 /* Backing store is enabled/disabled by modules that provide the
  * 'content.backing' service.  At module load time, the backing module
  * informs the content service of its availability, and entries are
@@ -602,30 +1933,33 @@ static int cache_flush (content_cache_t *cache)
 {
     struct cache_entry *e;
     const char *key;
-    int saved_errno = 0;
+    zlist_t *l;
     int count = 0;
-    int rc = 0;
+    int rc;
 
     if (cache->acct_dirty - cache->flush_batch_count == 0
             || cache->flush_batch_count >= cache->flush_batch_limit)
         return 0;
 
+    if (!(l = zlist_new ())) {
+        errno = ENOMEM;
+        return -1;
+    }
     flux_log (cache->h, LOG_DEBUG, "content flush begin");
     FOREACH_ZHASH (cache->entries, key, e) {
-        if (!e->dirty || e->store_pending)
+        if (!e->dirty || e->store_pending || e->queued)
             continue;
-        if (cache_store (cache, e) < 0) {
-            saved_errno = errno;
-            rc = -1;
-        }
+        if (zlist_append (l, e) < 0)
+            break;
+        e->queued = 1;
         count++;
-        if (cache->flush_batch_count >= cache->flush_batch_limit)
+        if (cache->flush_batch_count + count >= cache->flush_batch_limit)
             break;
     }
+    rc = cache_store_batch (cache, l);
+    zlist_destroy (&l);
     flux_log (cache->h, LOG_DEBUG, "content flush +%d (dirty=%d pending=%d)",
               count, cache->acct_dirty, cache->flush_batch_count);
-    if (rc < 0)
-        errno = saved_errno;
     return rc;
 }
 
@@ -664,7 +1998,11 @@ static void content_register_backing_request (flux_t *h,
         errstr = "content backing store cannot be changed on the fly";
         goto error;
     }
+    if (!cache->stored
+        && !(cache->stored = bloom_create (stored_filter_keys * 10, 7)))
+        goto error;
     cache->backing = 1;
+    cache->backing_has = 1;
     flux_log (h, LOG_DEBUG, "content backing store: enabled %s", name);
     if (flux_respond (h, msg, NULL) < 0)
         flux_log_error (h, "error responding to register-backing request");
@@ -691,6 +2029,7 @@ static void content_unregister_backing_request (flux_t *h,
         goto error;
     }
     cache->backing = 0;
+    bloom_clear (cache->stored);
     flux_log (h, LOG_DEBUG, "content backing store: disabled");
     if (flux_respond (h, msg, NULL) < 0)
         flux_log_error (h, "error responding to unregister-backing request");
@@ -703,62 +2042,114 @@ error:
 }
 
 /* Forcibly drop all entries from the cache that can be dropped
- * without data loss.
- * N.B. this walks the entire cache in one go.
+ * without data loss, that is, all entries on the ARC lists.
  */
 
 static void content_dropcache_request (flux_t *h, flux_msg_handler_t *mh,
                                        const flux_msg_t *msg, void *arg)
 {
     content_cache_t *cache = arg;
-    zlist_t *keys = NULL;
-    char *key;
-    struct cache_entry *e;
+    struct lru_node *n;
     int orig_size;
 
     if (flux_request_decode (msg, NULL, NULL) < 0)
         goto error;
     orig_size = zhash_size (cache->entries);
-    if (!(keys = zhash_keys (cache->entries))) {
-        errno = ENOMEM;
-        goto error;
-    }
-    while ((key = zlist_pop (keys))) {
-        e = zhash_lookup (cache->entries, key);
-        assert (e != NULL);
-        if (e->valid && !e->dirty)
-            remove_entry (cache, e);
-        free (key);
-    }
+    while ((n = lru_tail (&cache->t1)) || (n = lru_tail (&cache->t2)))
+        remove_entry (cache, (struct cache_entry *)n);
     flux_log (h, LOG_DEBUG, "content dropcache %d/%d",
               orig_size - (int)zhash_size (cache->entries), orig_size);
     if (flux_respond (h, msg, NULL) < 0)
         flux_log_error (h, "content dropcache");
-    zlist_destroy (&keys);
     return;
 error:
     flux_log (h, LOG_DEBUG, "content dropcache: %s", flux_strerror (errno));
     if (flux_respond_error (h, msg, errno, NULL) < 0)
         flux_log_error (h, "content dropcache");
-    zlist_destroy (&keys);
 }
 
 /* Return stats about the cache.
  */
 
+static void stats_respond (content_cache_t *cache,
+                           const flux_msg_t *msg,
+                           json_t *backing)
+{
+    json_t *o;
+
+    if (!(o = json_pack ("{s:i s:i s:i s:i s:I s:I s:I s:I s:I s:I s:I s:I s:I s:I}",
+                         "count", zhash_size (cache->entries),
+                         "valid", cache->acct_valid,
+                         "dirty", cache->acct_dirty,
+                         "size", cache->acct_size,
+                         "hits", (json_int_t)cache->hits,
+                         "misses", (json_int_t)cache->misses,
+                         "ghost-hits", (json_int_t)cache->ghost_hits,
+                         "dedup-hits", (json_int_t)cache->dedup_hits,
+                         "prefetch-issued", (json_int_t)cache->prefetch_issued,
+                         "prefetch-hits", (json_int_t)cache->prefetch_hits,
+                         "prefetch-wasted",
+                         (json_int_t)cache->prefetch_wasted,
+                         "writeback-batches",
+                         (json_int_t)cache->writeback_batches,
+                         "writeback-stalls",
+                         (json_int_t)cache->writeback_stalls,
+                         "snapshot-hits",
+                         (json_int_t)cache->snapshot_hits))
+        || (backing && json_object_set (o, "backing", backing) < 0)) {
+        errno = ENOMEM;
+        goto error;
+    }
+    if (flux_respond_pack (cache->h, msg, "O", o) < 0)
+        flux_log_error (cache->h, "content stats");
+    json_decref (o);
+    return;
+error:
+    if (flux_respond_error (cache->h, msg, errno, NULL) < 0)
+        flux_log_error (cache->h, "content stats");
+    json_decref (o);
+}
+
+/* Include the backing store's stats, if it provides them.
+ */
+static void stats_backing_continuation (flux_future_t *f, void *arg)
+{
+    content_cache_t *cache = arg;
+    const flux_msg_t *msg = flux_future_aux_get (f, "msg");
+    json_t *backing = NULL;
+
+    if (flux_rpc_get_unpack (f, "o", &backing) < 0)
+        backing = NULL;
+    stats_respond (cache, msg, backing);
+    flux_future_destroy (f);
+}
+
 static void content_stats_request (flux_t *h, flux_msg_handler_t *mh,
                                    const flux_msg_t *msg, void *arg)
 {
     content_cache_t *cache = arg;
+    flux_future_t *f;
 
     if (flux_request_decode (msg, NULL, NULL) < 0)
         goto error;
-    if (flux_respond_pack (h, msg, "{ s:i s:i s:i s:i}",
-                           "count", zhash_size (cache->entries),
-                           "valid", cache->acct_valid,
-                           "dirty", cache->acct_dirty,
-                           "size", cache->acct_size) < 0)
-        flux_log_error (h, "content stats");
+    if (cache->rank == 0 && cache->backing) {
+        if (!(f = flux_rpc (h, "content-backing.stats.get", NULL, 0, 0)))
+            goto error;
+        if (flux_future_aux_set (f,
+                                 "msg",
+                                 (void *)flux_msg_incref (msg),
+                                 (flux_free_f)flux_msg_decref) < 0) {
+            flux_msg_decref (msg);
+            flux_future_destroy (f);
+            goto error;
+        }
+        if (flux_future_then (f, -1., stats_backing_continuation, cache) < 0) {
+            flux_future_destroy (f);
+            goto error;
+        }
+        return;
+    }
+    stats_respond (cache, msg, NULL);
     return;
 error:
     if (flux_respond_error (h, msg, errno, NULL) < 0)
@@ -803,6 +2194,7 @@ static void content_flush_request (flux_t *h, flux_msg_handler_t *mh,
     if (flux_request_decode (msg, NULL, NULL) < 0)
         goto error;
     if (cache->acct_dirty != 0) {
+        writeback_send (cache); // don't wait out the window
         if (cache_flush (cache) < 0)
             goto error;
         if (cache->acct_dirty > 0) {
@@ -825,50 +2217,67 @@ error:
         flux_log_error (h, "content flush");
 }
 
-/* Heartbeat drives periodic cache purge
+/* Heartbeat drives periodic cache purge, unless content.purge-period
+ * is set.  Then a purge runs one period after the cache grows past its
+ * targets, and again each period while it has entries that may be evicted
+ * once old enough, so an idle cache within its targets is never woken.
+ * Entry ages are counted in periods instead of heartbeats.
  */
 
-static int cache_purge (content_cache_t *cache)
+static int cache_epoch (content_cache_t *cache)
 {
-    int after_entries = zhash_size (cache->entries);
-    int after_size = cache->acct_size;
-    struct cache_entry *e;
-    zlist_t *purge = NULL;
-    int rc = -1;
-    const char *key;
+    if (cache->purge_period > 0 && cache->h) {
+        double t = flux_reactor_now (flux_get_reactor (cache->h));
+        return (t - cache->purge_t0) * 1E3 / cache->purge_period;
+    }
+    return cache->epoch;
+}
 
-    if (cache->acct_dirty == zhash_size (cache->entries))
-        return 0;
+static bool purge_needed (content_cache_t *cache)
+{
+    return zhash_size (cache->entries) > cache->purge_target_entries
+        || cache->acct_size > cache->purge_target_size;
+}
 
-    FOREACH_ZHASH (cache->entries, key, e) {
-        if (after_size <= cache->purge_target_size
-                        && after_entries <= cache->purge_target_entries)
+/* Choose an entry to evict, as in ARC's REPLACE:  take the least recently
+ * used entry of the recent list if that list exceeds its target size,
+ * otherwise of the frequent list.  Entries referenced within the last
+ * purge-old-entry heartbeats are not evicted.  The tail of a list is its
+ * least recently used entry, so if it is too young, the whole list is.
+ */
+static struct cache_entry *arc_victim (content_cache_t *cache)
+{
+    struct cache_entry *t1 = (struct cache_entry *)lru_tail (&cache->t1);
+    struct cache_entry *t2 = (struct cache_entry *)lru_tail (&cache->t2);
+
+    int epoch = cache_epoch (cache);
+
+    if (t1 && epoch - t1->lastused < cache->purge_old_entry)
+        t1 = NULL;
+    if (t2 && epoch - t2->lastused < cache->purge_old_entry)
+        t2 = NULL;
+    if (t1 && (cache->t1.size > cache->arc_p || !t2))
+        return t1;
+    return t2;
+}
+
+static void cache_purge (content_cache_t *cache)
+{
+    struct cache_entry *e;
+    int count = 0;
+
+    while (purge_needed (cache)) {
+        if (!(e = arc_victim (cache)))
             break;
-        if (!e->valid || e->dirty)
-            continue;
-        if (cache->epoch - e->lastused < cache->purge_old_entry)
-            continue;
-        if (after_entries <= cache->purge_target_entries
-                    && e->len < cache->purge_large_entry)
-            continue;
-        if ((!purge && !(purge = zlist_new ()))
-                    || zlist_append (purge, e) < 0) {
-            errno = ENOMEM;
-            goto done;
-        }
-        after_size -= e->len;
-        after_entries--;
-    }
-    if (purge) {
-        flux_log (cache->h, LOG_DEBUG, "content purge: %d entries",
-                  (int)zlist_size (purge));
-        while ((e = zlist_pop (purge)))
-            remove_entry (cache, e);
+        ghost_add (cache,
+                   e->arc_list == &cache->t1 ? &cache->b1 : &cache->b2,
+                   e);
+        remove_entry (cache, e);
+        count++;
     }
-    rc = 0;
-done:
-    zlist_destroy (&purge);
-    return rc;
+    ghost_trim (cache);
+    if (count > 0)
+        flux_log (cache->h, LOG_DEBUG, "content purge: %d entries", count);
 }
 
 static void heartbeat_event (flux_t *h, flux_msg_handler_t *mh,
@@ -878,7 +2287,40 @@ static void heartbeat_event (flux_t *h, flux_msg_handler_t *mh,
 
     if (flux_heartbeat_decode (msg, &cache->epoch) < 0)
         return; /* ignore mangled heartbeat */
+    if (cache->purge_period == 0)
+        cache_purge (cache);
+}
+
+/* Start the purge timer if the cache is past its targets.
+ */
+static void purge_kick (content_cache_t *cache)
+{
+    if (cache->purge_period == 0
+        || cache->purge_armed
+        || !cache->purge_timer
+        || !purge_needed (cache))
+        return;
+    flux_timer_watcher_reset (cache->purge_timer,
+                              cache->purge_period * 1E-3,
+                              0.);
+    flux_watcher_start (cache->purge_timer);
+    cache->purge_armed = 1;
+}
+
+static void purge_timer_cb (flux_reactor_t *r,
+                            flux_watcher_t *w,
+                            int revents,
+                            void *arg)
+{
+    content_cache_t *cache = arg;
+
+    cache->purge_armed = 0;
     cache_purge (cache);
+    /* Entries that were too young are retried next period.  If no entry
+     * is evictable at all, arc_admit() restarts the timer when one is.
+     */
+    if (lru_tail (&cache->t1) || lru_tail (&cache->t2))
+        purge_kick (cache);
 }
 
 /* Initialization
@@ -897,6 +2339,18 @@ static const struct flux_msg_handler_spec htab[] = {
         content_store_request,
         FLUX_ROLE_USER
     },
+    {
+        FLUX_MSGTYPE_REQUEST,
+        "content.load-batch",
+        content_load_batch_request,
+        FLUX_ROLE_USER
+    },
+    {
+        FLUX_MSGTYPE_REQUEST,
+        "content.store-batch",
+        content_store_batch_request,
+        FLUX_ROLE_USER
+    },
     {
         FLUX_MSGTYPE_REQUEST,
         "content.unregister-backing",
@@ -946,6 +2400,21 @@ int content_cache_set_flux (content_cache_t *cache, flux_t *h)
         return -1;
     if (flux_event_subscribe (h, "hb") < 0)
         return -1;
+    if (!(cache->writeback_timer = flux_timer_watcher_create (
+                                            flux_get_reactor (h),
+                                            0.,
+                                            0.,
+                                            writeback_timer_cb,
+                                            cache)))
+        return -1;
+    if (!(cache->purge_timer = flux_timer_watcher_create (
+                                            flux_get_reactor (h),
+                                            0.,
+                                            0.,
+                                            purge_timer_cb,
+                                            cache)))
+        return -1;
+    cache->purge_t0 = flux_reactor_now (flux_get_reactor (h));
     return 0;
 }
 
@@ -974,6 +2443,8 @@ static int content_cache_getattr (const char *name, const char **val, void *arg)
         *val = cache->hash_name;
     else if (!strcmp (name, "content.backing-module"))
         *val = cache->backing_name;
+    else if (!strcmp (name, "content.snapshot"))
+        *val = cache->snapshot_path;
     else if (!strcmp (name, "content.acct-entries")) {
         snprintf (s, sizeof (s), "%zd", zhash_size (cache->entries));
         *val = s;
@@ -995,6 +2466,22 @@ int content_cache_register_attrs (content_cache_t *cache, attr_t *attr)
         if (attr_delete (attr, "content.backing-module", 1) < 0)
             return -1;
     }
+    /* Likewise, open the snapshot named by content.snapshot, if set.
+     */
+    if (attr_get (attr, "content.snapshot", &s, NULL) == 0) {
+        if (!(cache->snapshot_path = strdup (s)))
+            return -1;
+        if (attr_delete (attr, "content.snapshot", 1) < 0)
+            return -1;
+        if (cache->rank == 0) {
+            if (!(cache->snapshot = blobsnap_open (s))) {
+                flux_log_error (cache->h, "content snapshot %s", s);
+                return -1;
+            }
+            flux_log (cache->h, LOG_INFO, "content snapshot %s: %d blobs",
+                      s, blobsnap_count (cache->snapshot));
+        }
+    }
 
     /* Purge tunables
      */
@@ -1010,6 +2497,9 @@ int content_cache_register_attrs (content_cache_t *cache, attr_t *attr)
     if (attr_add_active_uint32 (attr, "content.purge-large-entry",
                 &cache->purge_large_entry, 0) < 0)
         return -1;
+    if (attr_add_active_uint32 (attr, "content.purge-period",
+                &cache->purge_period, FLUX_ATTRFLAG_IMMUTABLE) < 0)
+        return -1;
     /* Accounting numbers
      */
     if (attr_add_active_uint32 (attr, "content.acct-size",
@@ -1035,9 +2525,21 @@ int content_cache_register_attrs (content_cache_t *cache, attr_t *attr)
     if (attr_add_active (attr, "content.backing-module",FLUX_ATTRFLAG_READONLY,
                  content_cache_getattr, NULL, cache) < 0)
         return -1;
+    if (attr_add_active (attr, "content.snapshot", FLUX_ATTRFLAG_READONLY,
+                 content_cache_getattr, NULL, cache) < 0)
+        return -1;
     if (attr_add_active_uint32 (attr, "content.flush-batch-count",
                 &cache->flush_batch_count, 0) < 0)
         return -1;
+    if (attr_add_active_uint32 (attr, "content.prefetch-limit",
+                &cache->prefetch_limit, 0) < 0)
+        return -1;
+    if (attr_add_active_uint32 (attr, "content.writeback-window",
+                &cache->writeback_window, 0) < 0)
+        return -1;
+    if (attr_add_active_uint32 (attr, "content.writeback-credits",
+                &cache->writeback_credits, 0) < 0)
+        return -1;
     /* content-hash can be set on the command line
      */
     if (attr_add_active (attr, "content.hash", FLUX_ATTRFLAG_IMMUTABLE,
@@ -1057,7 +2559,14 @@ void content_cache_destroy (content_cache_t *cache)
         }
         if (cache->backing_name)
             free (cache->backing_name);
+        flux_watcher_destroy (cache->writeback_timer);
+        flux_watcher_destroy (cache->purge_timer);
+        zlist_destroy (&cache->writeback);
         zhash_destroy (&cache->entries);
+        zhash_destroy (&cache->ghosts);
+        blobsnap_close (cache->snapshot); // after entries that map it
+        free (cache->snapshot_path);
+        bloom_destroy (cache->stored);
         request_list_destroy (&cache->flush_requests);
         free (cache);
     }
@@ -1070,14 +2579,23 @@ content_cache_t *content_cache_create (void)
         errno = ENOMEM;
         return NULL;
     }
-    if (!(cache->entries = zhash_new ())) {
+    if (!(cache->entries = zhash_new ())
+        || !(cache->ghosts = zhash_new ())
+        || !(cache->writeback = zlist_new ())) {
         content_cache_destroy (cache);
         errno = ENOMEM;
         return NULL;
     }
+    lru_init (&cache->t1);
+    lru_init (&cache->t2);
+    lru_init (&cache->b1);
+    lru_init (&cache->b2);
     cache->rank = FLUX_NODEID_ANY;
     cache->blob_size_limit = default_blob_size_limit;
     cache->flush_batch_limit = default_flush_batch_limit;
+    cache->prefetch_limit = default_prefetch_limit;
+    cache->writeback_window = default_writeback_window;
+    cache->writeback_credits = default_writeback_credits;
     cache->purge_target_entries = default_cache_purge_target_entries;
     cache->purge_target_size = default_cache_purge_target_size;
     cache->purge_old_entry = default_cache_purge_old_entry;
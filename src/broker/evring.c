@@ -0,0 +1,154 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* evring.c - circular buffer of recent events
+ *
+ * 'first' is the lowest sequence number the history is complete from;
+ * it advances as events are evicted or declared lost.  'last' is the
+ * highest sequence number accounted for.  Zero means none yet.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <errno.h>
+#include <flux/core.h>
+
+#include "evring.h"
+
+struct evring {
+    const flux_msg_t **msgs;
+    uint32_t *seqs;
+    int size;
+    int head;           // index of oldest event
+    int count;
+    uint32_t first;
+    uint32_t last;
+};
+
+void evring_destroy (struct evring *ring)
+{
+    if (ring) {
+        int saved_errno = errno;
+        int i;
+        for (i = 0; i < ring->count; i++)
+            flux_msg_decref (ring->msgs[(ring->head + i) % ring->size]);
+        free (ring->msgs);
+        free (ring->seqs);
+        free (ring);
+        errno = saved_errno;
+    }
+}
+
+struct evring *evring_create (int size)
+{
+    struct evring *ring;
+
+    if (size < 1) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(ring = calloc (1, sizeof (*ring))))
+        return NULL;
+    ring->size = size;
+    if (!(ring->msgs = calloc (size, sizeof (ring->msgs[0])))
+        || !(ring->seqs = calloc (size, sizeof (ring->seqs[0])))) {
+        evring_destroy (ring);
+        errno = ENOMEM;
+        return NULL;
+    }
+    return ring;
+}
+
+/* Update accounting for [first, last].  If the range does not follow on
+ * from what was accounted before, history before it is incomplete.
+ */
+static void account (struct evring *ring, uint32_t first, uint32_t last)
+{
+    if (ring->first == 0 || (ring->last > 0 && first != ring->last + 1))
+        ring->first = first;
+    if (last > ring->last)
+        ring->last = last;
+}
+
+int evring_append (struct evring *ring, const flux_msg_t *msg)
+{
+    uint32_t seq;
+    int tail;
+
+    if (!ring || !msg) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (flux_msg_get_seq (msg, &seq) < 0)
+        return -1;
+    if (seq <= ring->last) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (ring->count == ring->size) {
+        if (ring->first <= ring->seqs[ring->head])
+            ring->first = ring->seqs[ring->head] + 1;
+        flux_msg_decref (ring->msgs[ring->head]);
+        ring->head = (ring->head + 1) % ring->size;
+        ring->count--;
+    }
+    account (ring, seq, seq);
+    tail = (ring->head + ring->count) % ring->size;
+    ring->msgs[tail] = flux_msg_incref (msg);
+    ring->seqs[tail] = seq;
+    ring->count++;
+    return 0;
+}
+
+void evring_skip (struct evring *ring, uint32_t first, uint32_t last)
+{
+    if (ring && first <= last && last > ring->last)
+        account (ring, first, last);
+}
+
+void evring_lost (struct evring *ring, uint32_t first, uint32_t last)
+{
+    if (ring && first <= last && last > ring->last) {
+        ring->first = last + 1;
+        ring->last = last;
+    }
+}
+
+bool evring_replay (struct evring *ring,
+                    uint32_t first,
+                    uint32_t last,
+                    evring_f cb,
+                    void *arg)
+{
+    int i;
+
+    if (!ring)
+        return false;
+    for (i = 0; i < ring->count; i++) {
+        int index = (ring->head + i) % ring->size;
+        uint32_t seq = ring->seqs[index];
+        if (seq > last)
+            break;
+        if (seq >= first && cb)
+            cb (ring->msgs[index], arg);
+    }
+    return (ring->first > 0 && ring->first <= first && last <= ring->last);
+}
+
+int evring_count (struct evring *ring)
+{
+    return ring ? ring->count : 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
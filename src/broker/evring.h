@@ -0,0 +1,55 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _BROKER_EVRING_H
+#define _BROKER_EVRING_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <flux/core.h>
+
+/* evring - bounded history of recent events, for gap repair
+ *
+ * Each broker accounts for every event sequence number in order, either
+ * by receiving the event (evring_append), by being told that it was not
+ * forwarded because nobody in its subtree subscribed (evring_skip), or by
+ * giving up on it (evring_lost).  The ring holds the last 'size' events
+ * received, and can say whether its history of a range is complete, i.e.
+ * every sequence number in the range not held was skipped.
+ */
+
+typedef void (*evring_f)(const flux_msg_t *msg, void *arg);
+
+struct evring *evring_create (int size);
+void evring_destroy (struct evring *ring);
+
+/* Account for event 'msg'.  Sequence numbers must increase.
+ */
+int evring_append (struct evring *ring, const flux_msg_t *msg);
+
+void evring_skip (struct evring *ring, uint32_t first, uint32_t last);
+void evring_lost (struct evring *ring, uint32_t first, uint32_t last);
+
+/* Call 'cb' for each held event with sequence number in [first, last],
+ * in order.  Returns true if the ring's history of the range is complete.
+ */
+bool evring_replay (struct evring *ring,
+                    uint32_t first,
+                    uint32_t last,
+                    evring_f cb,
+                    void *arg);
+
+int evring_count (struct evring *ring);
+
+#endif /* !_BROKER_EVRING_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -21,6 +21,7 @@
 
 #include "hello.h"
 #include "reduce.h"
+#include "topology.h"
 
 /* After this many seconds, ignore topo-based hwm.
  * Override by setting hello.timeout broker attribute.
@@ -37,7 +38,7 @@ struct hello {
     uint32_t rank;
     uint32_t size;
     struct idset *idset;
-    zlist_t *idset_requests;
+    struct flux_msglist *idset_requests;
 
     double start;
 
@@ -45,6 +46,20 @@ struct hello {
     void *cb_arg;
 
     flux_reduce_t *reduce;
+
+    /* In "children" mode, flush once every direct child has checked in,
+     * since each child only forwards once its own subtree is complete or
+     * timed out.  Stragglers then cost one timeout, not one per level.
+     */
+    bool children_mode;
+    struct topology *topo;
+    struct idset *children;     // direct children that have checked in
+    int child_count;
+
+    /* rank 0: ranks expected and checked in, per TBON level */
+    int *level_size;
+    int *level_count;
+    int maxlevel;
 };
 
 static int idset_respond (struct hello *hello, const flux_msg_t *msg)
@@ -69,48 +84,6 @@ done:
     return rc;
 }
 
-static bool match_msg_matchtag (const flux_msg_t *msg, uint32_t match_matchtag)
-{
-    uint32_t matchtag;
-
-    if (match_matchtag == FLUX_MATCHTAG_NONE)
-        return true;
-    if (flux_msg_get_matchtag (msg, &matchtag) < 0)
-        return false;
-    return (matchtag == match_matchtag ? true : false);
-}
-
-static bool match_msg_sender (const flux_msg_t *msg, const char *match_sender)
-{
-    char *sender;
-    int cmp;
-
-    if (flux_msg_get_route_first (msg, &sender) < 0 || sender == NULL)
-        return false;
-    cmp = strcmp (sender, match_sender);
-    free (sender);
-    return (cmp == 0 ? true : false);
-}
-
-/* Search hello->idset_requests for a request matching sender and matchtag.
- * matchtag=FLUX_MATCTHAG_NONE acts as a wildcard.
- */
-static const flux_msg_t *idset_request_find (struct hello *hello,
-                                             const char *sender,
-                                             uint32_t matchtag)
-{
-    const flux_msg_t *msg;
-
-    msg = zlist_first (hello->idset_requests);
-    while (msg) {
-        if (match_msg_matchtag (msg, matchtag)
-                || match_msg_sender (msg, sender))
-            break;
-        msg = zlist_next (hello->idset_requests);
-    }
-    return msg;
-}
-
 double hello_get_time (struct hello *hello)
 {
     if (hello->start == 0. || hello->h == NULL)
@@ -176,10 +149,10 @@ static void idset_request (flux_t *h,
      * responses until cancel/disconnect.
      */
     if (flux_msg_is_streaming (msg)) {
-        if (zlist_append (hello->idset_requests,
-                          (flux_msg_t *)flux_msg_incref (msg)) < 0) {
+        if (flux_msglist_append (hello->idset_requests,
+                                 msg,
+                                 (flux_msg_t *)flux_msg_incref (msg)) < 0) {
             flux_msg_decref (msg);
-            errno = ENOMEM;
             goto error;
         }
     }
@@ -196,15 +169,11 @@ static void disconnect_request (flux_t *h,
 {
     struct hello *hello = arg;
     const flux_msg_t *req;
-    char *sender;
 
-    if (flux_msg_get_route_first (msg, &sender) < 0 || sender == NULL)
-        return;
-    while ((req = idset_request_find (hello, sender, FLUX_MATCHTAG_NONE))) {
-        zlist_remove (hello->idset_requests, (flux_msg_t *)req);
+    while ((req = flux_msglist_pop_sender (hello->idset_requests,
+                                           msg,
+                                           FLUX_MATCHTAG_NONE)))
         flux_msg_decref (req);
-    }
-    free (sender);
 }
 
 /* User specifies matchtag of request to cancel (use flux_rpc_get_matchtag()).
@@ -218,19 +187,54 @@ static void cancel_request (flux_t *h,
 {
     struct hello *hello = arg;
     const flux_msg_t *req;
-    char *sender;
     uint32_t matchtag;
 
     if (flux_request_unpack (msg, NULL, "{s:i}", &matchtag) < 0)
         return;
-    if (flux_msg_get_route_first (msg, &sender) < 0 || sender == NULL)
-        return;
-    if ((req = idset_request_find (hello, sender, matchtag))) {
+    if ((req = flux_msglist_pop_sender (hello->idset_requests,
+                                        msg,
+                                        matchtag))) {
         (void)flux_respond_error (h, req, ECANCELED, "Request was canceled");
-        zlist_remove (hello->idset_requests, (flux_msg_t *)req);
         flux_msg_decref (req);
     }
-    free (sender);
+}
+
+/* Note which direct child 'item' came through.
+ */
+static void child_checkin (struct hello *hello, const struct idset *item)
+{
+    int child;
+
+    if (!hello->children)
+        return;
+    child = topology_get_child_route (hello->topo,
+                                      hello->rank,
+                                      idset_first (item));
+    if (child >= 0)
+        (void)idset_set (hello->children, child);
+}
+
+int hello_set_topology (struct hello *hello, struct topology *topo)
+{
+    int i;
+
+    hello->topo = topo;
+    hello->child_count = topology_get_child_count (topo, hello->rank);
+    if (!(hello->children = idset_create (hello->size, 0)))
+        return -1;
+    if (hello->rank == 0) {
+        hello->maxlevel = topology_get_maxlevel (topo);
+        if (!(hello->level_size = calloc (hello->maxlevel + 1, sizeof (int)))
+            || !(hello->level_count = calloc (hello->maxlevel + 1,
+                                              sizeof (int))))
+            return -1;
+        for (i = 0; i < hello->size; i++) {
+            int level = topology_get_level (topo, i);
+            if (level >= 0 && level <= hello->maxlevel)
+                hello->level_size[level]++;
+        }
+    }
+    return 0;
 }
 
 /* handle a message sent from downstream via downstream's r_forward op.
@@ -264,12 +268,17 @@ static void join_request (flux_t *h,
         errmsg = "join failed to decode idset";
         goto error;
     }
+    child_checkin (hello, item);
     if (flux_reduce_append (hello->reduce, item, batch) < 0) {
         idset_destroy (item);
         errno = ENOMEM;
         errmsg = "join could not append to reduction handle";
         goto error;
     }
+    if (hello->children_mode
+        && hello->child_count > 0
+        && idset_count (hello->children) == hello->child_count)
+        flux_reduce_flush (hello->reduce);
     if (flux_respond (h, msg, NULL) < 0)
         log_err ("hello: join respond error");
     return;
@@ -325,6 +334,29 @@ static void r_reduce (flux_reduce_t *r, int batch, void *arg)
  * This may be called once the total hwm is reached on rank 0,
  * or after the timeout, as new messages arrive (after r_reduce).
  */
+static void level_update (struct hello *hello, const struct idset *item)
+{
+    unsigned int rank;
+    int level;
+
+    if (!hello->level_count)
+        return;
+    rank = idset_first (item);
+    while (rank != IDSET_INVALID_ID) {
+        if (!hello->idset || !idset_test (hello->idset, rank)) {
+            level = topology_get_level (hello->topo, rank);
+            if (level >= 0 && level <= hello->maxlevel
+                && ++hello->level_count[level] == hello->level_size[level])
+                flux_log (hello->h,
+                          LOG_INFO,
+                          "wireup: level %d complete %.3fs",
+                          level,
+                          hello_get_time (hello));
+        }
+        rank = idset_next (item, rank);
+    }
+}
+
 static void r_sink (flux_reduce_t *r, int batch, void *arg)
 {
     struct hello *hello = arg;
@@ -334,6 +366,8 @@ static void r_sink (flux_reduce_t *r, int batch, void *arg)
     assert (batch == 0);
     assert (item != NULL);
 
+    level_update (hello, item);
+
     if (!hello->idset)
         hello->idset = item;
     else {
@@ -348,10 +382,10 @@ static void r_sink (flux_reduce_t *r, int batch, void *arg)
     if (hello->cb)
         hello->cb (hello, hello->cb_arg);
     if (hello->idset_requests) {
-        const flux_msg_t *msg = zlist_first (hello->idset_requests);
+        const flux_msg_t *msg = flux_msglist_first (hello->idset_requests);
         while (msg) {
             (void)idset_respond (hello, msg);
-            msg = zlist_next (hello->idset_requests);
+            msg = flux_msglist_next (hello->idset_requests);
         }
     }
 }
@@ -372,6 +406,11 @@ static void r_forward (flux_reduce_t *r, int batch, void *arg)
 
     if (!(s = idset_encode (item, IDSET_FLAG_RANGE)))
         log_err_exit ("hello: idset_encode");
+    flux_log (hello->h,
+              LOG_DEBUG,
+              "hello: forwarded %zu ranks %.3fs",
+              idset_count (item),
+              hello_get_time (hello));
     if (!(f = flux_rpc_pack (hello->h,
                              "hello.join",
                              FLUX_NODEID_UPSTREAM,
@@ -429,10 +468,8 @@ struct hello *hello_create (flux_t *h, attr_t *attrs, hello_cb_f cb, void *arg)
     hello->cb = cb;
     hello->cb_arg = arg;
 
-    if (!(hello->idset_requests = zlist_new ())) {
-        errno = ENOMEM;
+    if (!(hello->idset_requests = flux_msglist_create ()))
         goto error;
-    }
 
     if (flux_msg_handler_addvec (hello->h, htab, hello, &hello->handlers) < 0)
         goto error;
@@ -478,6 +515,34 @@ struct hello *hello_create (flux_t *h, attr_t *attrs, hello_cb_f cb, void *arg)
             if (attr_add (attrs, "hello.timeout", num, FLUX_ATTRFLAG_IMMUTABLE) < 0)
                 goto error;
         }
+
+        /* hello.mode (tunable)
+         * "children" flushes once all direct children have checked in.
+         * "subtree" waits for hwm or timeout.
+         */
+        if (attr_get (attrs, "hello.mode", &s, NULL) == 0) {
+            if (!strcmp (s, "subtree"))
+                hello->children_mode = false;
+            else if (!strcmp (s, "children"))
+                hello->children_mode = true;
+            else {
+                log_msg ("hello: invalid hello.mode: %s", s);
+                errno = EINVAL;
+                goto error;
+            }
+            if (attr_set_flags (attrs,
+                                "hello.mode",
+                                FLUX_ATTRFLAG_IMMUTABLE) < 0)
+                goto error;
+        }
+        else {
+            hello->children_mode = true;
+            if (attr_add (attrs,
+                          "hello.mode",
+                          "children",
+                          FLUX_ATTRFLAG_IMMUTABLE) < 0)
+                goto error;
+        }
     }
 
     /* Create the reduction handle for this broker.
@@ -512,11 +577,14 @@ void hello_destroy (struct hello *hello)
         flux_reduce_destroy (hello->reduce);
         flux_msg_handler_delvec (hello->handlers);
         idset_destroy (hello->idset);
+        idset_destroy (hello->children);
+        free (hello->level_size);
+        free (hello->level_count);
         if (hello->idset_requests) {
             const flux_msg_t *msg;
-            while ((msg = zlist_pop (hello->idset_requests)))
+            while ((msg = flux_msglist_pop (hello->idset_requests)))
                 flux_msg_decref (msg);
-            zlist_destroy (&hello->idset_requests);
+            flux_msglist_destroy (hello->idset_requests);
         }
         free (hello);
         errno = saved_errno;
@@ -13,6 +13,7 @@
 
 #include <stdbool.h>
 #include "attr.h"
+#include "topology.h"
 
 struct hello;
 
@@ -37,6 +38,12 @@ bool hello_complete (struct hello *hello);
  */
 const struct idset *hello_get_idset (struct hello *hello);
 
+/* Provide the TBON topology (call before hello_start).
+ * This enables the "children" hello.mode and per-level wireup logging
+ * on rank 0.  Without it, only hwm and timeout are used.
+ */
+int hello_set_topology (struct hello *hello, struct topology *topo);
+
 /* Start the hello protocol (call on all ranks).
  */
 int hello_start (struct hello *hello);
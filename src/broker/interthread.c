@@ -0,0 +1,287 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* interthread.c - connected pair of flux_t handles for two threads
+ *
+ * Each direction is a threadq, which has a single producer and a single
+ * consumer.  That matches a flux_t, which is used by one thread at a
+ * time, so no locks are needed.
+ *
+ * The threadq eventfd serves as the handle pollfd.  op_pollevents()
+ * leaves it signaled while messages are queued, and clears it only when
+ * the queue is found empty, so the reactor is woken by the next push.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <poll.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <flux/core.h>
+
+#include "src/common/librouter/threadq.h"
+
+#include "interthread.h"
+
+#define INTERTHREAD_MAGIC 0xfeefbe03
+
+struct channel {
+    struct threadq *q[2];
+    int refcount;
+};
+
+struct endpoint {
+    int magic;
+    struct channel *chan;
+    struct threadq *rx;
+    struct threadq *tx;
+    flux_t *h;
+};
+
+static const struct flux_handle_ops h1_ops;
+static const struct flux_handle_ops h2_ops;
+
+static void channel_decref (struct channel *chan)
+{
+    if (chan
+        && __atomic_sub_fetch (&chan->refcount, 1, __ATOMIC_ACQ_REL) == 0) {
+        flux_msg_t *msg;
+        int i;
+
+        for (i = 0; i < 2; i++) {
+            while ((msg = threadq_pop (chan->q[i])))
+                flux_msg_destroy (msg);
+            threadq_destroy (chan->q[i]);
+        }
+        free (chan);
+    }
+}
+
+static struct channel *channel_create (void)
+{
+    struct channel *chan;
+
+    if (!(chan = calloc (1, sizeof (*chan))))
+        return NULL;
+    chan->refcount = 1;
+    if (!(chan->q[0] = threadq_create ())
+        || !(chan->q[1] = threadq_create ())) {
+        channel_decref (chan);
+        return NULL;
+    }
+    return chan;
+}
+
+static int op_pollfd (void *impl)
+{
+    struct endpoint *ep = impl;
+    assert (ep->magic == INTERTHREAD_MAGIC);
+
+    return threadq_pollfd (ep->rx);
+}
+
+static int op_pollevents (void *impl)
+{
+    struct endpoint *ep = impl;
+    assert (ep->magic == INTERTHREAD_MAGIC);
+    int revents = FLUX_POLLOUT;
+
+    if (!threadq_peek (ep->rx))
+        threadq_clear (ep->rx);
+    if (threadq_peek (ep->rx))
+        revents |= FLUX_POLLIN;
+    return revents;
+}
+
+/* Copy 'msg' with a payload of its own.  flux_msg_copy() would share the
+ * payload, along with the json_t decoded from it, and jansson objects are
+ * not safe to use from two threads at once.
+ */
+static flux_msg_t *msg_copy_private (const flux_msg_t *msg)
+{
+    flux_msg_t *cpy;
+    const void *buf;
+    int size;
+
+    if (!(cpy = flux_msg_copy (msg, false)))
+        return NULL;
+    if (flux_msg_has_payload (msg)) {
+        if (flux_msg_get_payload (msg, &buf, &size) < 0
+            || flux_msg_set_payload (cpy, buf, size) < 0) {
+            flux_msg_destroy (cpy);
+            return NULL;
+        }
+    }
+    return cpy;
+}
+
+static int op_send (void *impl, const flux_msg_t *msg, int flags)
+{
+    struct endpoint *ep = impl;
+    assert (ep->magic == INTERTHREAD_MAGIC);
+    flux_msg_t *cpy;
+
+    if (!(cpy = msg_copy_private (msg)))
+        return -1;
+    if (threadq_push (ep->tx, cpy) < 0) {
+        flux_msg_destroy (cpy);
+        return -1;
+    }
+    return 0;
+}
+
+static flux_msg_t *op_recv (void *impl, int flags)
+{
+    struct endpoint *ep = impl;
+    assert (ep->magic == INTERTHREAD_MAGIC);
+    flux_msg_t *msg;
+
+    for (;;) {
+        struct pollfd pfd = {
+            .fd = threadq_pollfd (ep->rx),
+            .events = POLLIN,
+        };
+        if ((msg = threadq_pop (ep->rx)))
+            break;
+        threadq_clear (ep->rx);
+        if ((msg = threadq_pop (ep->rx)))
+            break;
+        if ((flags & FLUX_O_NONBLOCK)) {
+            errno = EWOULDBLOCK;
+            break;
+        }
+        if (poll (&pfd, 1, -1) < 0 && errno != EINTR)
+            break;
+    }
+    return msg;
+}
+
+static int op_event_subscribe (void *impl, const char *topic)
+{
+    struct endpoint *ep = impl;
+    assert (ep->magic == INTERTHREAD_MAGIC);
+    flux_future_t *f;
+    int rc = -1;
+
+    if (!(f = flux_rpc_pack (ep->h, "cmb.sub", FLUX_NODEID_ANY, 0,
+                             "{ s:s }", "topic", topic)))
+        goto done;
+    if (flux_future_get (f, NULL) < 0)
+        goto done;
+    rc = 0;
+done:
+    flux_future_destroy (f);
+    return rc;
+}
+
+static int op_event_unsubscribe (void *impl, const char *topic)
+{
+    struct endpoint *ep = impl;
+    assert (ep->magic == INTERTHREAD_MAGIC);
+    flux_future_t *f;
+    int rc = -1;
+
+    if (!(f = flux_rpc_pack (ep->h, "cmb.unsub", FLUX_NODEID_ANY, 0,
+                             "{ s:s }", "topic", topic)))
+        goto done;
+    if (flux_future_get (f, NULL) < 0)
+        goto done;
+    rc = 0;
+done:
+    flux_future_destroy (f);
+    return rc;
+}
+
+static void op_fini (void *impl)
+{
+    struct endpoint *ep = impl;
+    assert (ep->magic == INTERTHREAD_MAGIC);
+
+    channel_decref (ep->chan);
+    ep->magic = ~INTERTHREAD_MAGIC;
+    free (ep);
+}
+
+static flux_t *endpoint_create (struct channel *chan,
+                                int rx,
+                                const struct flux_handle_ops *ops)
+{
+    struct endpoint *ep;
+
+    if (!(ep = calloc (1, sizeof (*ep))))
+        return NULL;
+    ep->magic = INTERTHREAD_MAGIC;
+    ep->rx = chan->q[rx];
+    ep->tx = chan->q[!rx];
+    __atomic_add_fetch (&chan->refcount, 1, __ATOMIC_RELAXED);
+    ep->chan = chan;
+    /* N.B. on failure, flux_handle_create() calls op_fini() on 'ep'.
+     */
+    if (!(ep->h = flux_handle_create (ep, ops, 0)))
+        return NULL;
+    return ep->h;
+}
+
+int interthread_create (flux_t **h1, flux_t **h2)
+{
+    struct channel *chan;
+    flux_t *a = NULL;
+    flux_t *b = NULL;
+
+    if (!h1 || !h2) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!(chan = channel_create ()))
+        return -1;
+    if (!(a = endpoint_create (chan, 0, &h1_ops))
+        || !(b = endpoint_create (chan, 1, &h2_ops))) {
+        int saved_errno = errno;
+        flux_close (a);
+        channel_decref (chan);
+        errno = saved_errno;
+        return -1;
+    }
+    channel_decref (chan); // each endpoint holds a reference
+    *h1 = a;
+    *h2 = b;
+    return 0;
+}
+
+static const struct flux_handle_ops h1_ops = {
+    .pollfd = op_pollfd,
+    .pollevents = op_pollevents,
+    .send = op_send,
+    .recv = op_recv,
+    .getopt = NULL,
+    .setopt = NULL,
+    .event_subscribe = NULL,
+    .event_unsubscribe = NULL,
+    .impl_destroy = op_fini,
+};
+
+static const struct flux_handle_ops h2_ops = {
+    .pollfd = op_pollfd,
+    .pollevents = op_pollevents,
+    .send = op_send,
+    .recv = op_recv,
+    .getopt = NULL,
+    .setopt = NULL,
+    .event_subscribe = op_event_subscribe,
+    .event_unsubscribe = op_event_unsubscribe,
+    .impl_destroy = op_fini,
+};
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
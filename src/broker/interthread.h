@@ -0,0 +1,43 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _BROKER_INTERTHREAD_H
+#define _BROKER_INTERTHREAD_H
+
+#include <flux/core.h>
+
+/* interthread - a pair of connected flux_t handles for two threads
+ * of one process, used between the broker and a module thread.
+ *
+ * A message sent on one handle is received on the other.  Messages are
+ * passed by pointer on a pair of lock-free queues, each with an eventfd
+ * wakeup, so nothing is encoded or decoded.  The receiver gets a copy of
+ * the sender's message with its own payload, so no decoded JSON crosses
+ * threads, and either thread may modify its own message afterwards.
+ *
+ * Each handle may be used by only one thread at a time, like any flux_t.
+ * The handles may be destroyed in either order, from either thread.
+ * Messages not yet received when both are destroyed are freed.
+ *
+ * event_subscribe/unsubscribe on 'h2' are sent as cmb.sub/cmb.unsub
+ * requests to 'h1', as with a broker connection.  They are no-ops
+ * on 'h1'.
+ */
+
+/* Create the pair.  Set handle flags with flux_flags_set().
+ * Returns 0 on success, -1 with errno set.
+ */
+int interthread_create (flux_t **h1, flux_t **h2);
+
+#endif /* !_BROKER_INTERTHREAD_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
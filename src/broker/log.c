@@ -12,12 +12,26 @@
 #include "config.h"
 #endif
 #include <czmq.h>
+#include <jansson.h>
+#include <ctype.h>
+#include <inttypes.h>
 
 #include "src/common/libutil/log.h"
 #include "src/common/libutil/wallclock.h"
 #include "src/common/libutil/stdlog.h"
 
 #include "log.h"
+#include "logagg.h"
+
+/* The ring buffer is a preallocated array of slots holding contiguous
+ * sequence numbers, so dmesg lookups are O(1).  The common case, a
+ * well formed RFC 5424 message from this rank, is stored compactly: the
+ * header is reduced to integers plus small ids for the interned appname,
+ * procid, and msgid strings, and only the structured data and message are
+ * copied into the slot's reusable text buffer.  The message is re-encoded
+ * when it is read by dmesg.  Anything that would not round trip exactly is
+ * stored verbatim.
+ */
 
 /* See descriptions in flux-broker-attributes(7) */
 static const int default_ring_size = 1024;
@@ -25,6 +39,8 @@ static const int default_forward_level = LOG_DEBUG;
 static const int default_critical_level = LOG_CRIT;
 static const int default_stderr_level = LOG_ERR;
 static const int default_level = LOG_DEBUG;
+static const double default_forward_window = 1.;
+static const double default_forward_rate = 1000.;
 
 #define LOGBUF_MAGIC 0xe1e2e3e4
 typedef struct {
@@ -38,16 +54,41 @@ typedef struct {
     int critical_level;
     int stderr_level;
     int level;
-    zlist_t *buf;
+    struct logbuf_entry *ring;
     int ring_size;
+    int head;               // slot of oldest entry
+    int count;              // number of entries in the ring
     int seq;
-    zlist_t *sleepers;
+    struct flux_msglist *sleepers;
+    struct flux_msglist *followers; // streaming dmesg requests
+    zhash_t *atom_ids;      // string => id + 1
+    char **atoms;           // id => string
+    int atom_count;
+    char *fmt;              // re-encoded message
+    int fmt_size;
+    struct logagg *agg;     // folds messages forwarded from downstream
+    flux_watcher_t *agg_timer;
+    bool agg_armed;
+    double forward_window;
+    double forward_rate;
 } logbuf_t;
 
+#define ATOMS_MAX 4096
+#define DMESG_CHUNK 64
+
 struct logbuf_entry {
-    char *buf;
-    int len;
     int seq;
+    bool raw;               // text holds the entire message
+    int pri;
+    uint32_t hostname;
+    time_t sec;
+    unsigned long usec;
+    uint16_t appname;       // atom ids
+    uint16_t procid;
+    uint16_t msgid;
+    char *text;             // structured data and message
+    int len;
+    int size;               // allocated size of text
 };
 
 #define SLEEPER_MAGIC 0xe4e3e2e1
@@ -91,70 +132,221 @@ static struct sleeper *sleeper_create (flux_msg_handler_f fun,
     return s;
 }
 
-static void logbuf_entry_destroy (struct logbuf_entry *e)
+static struct logbuf_entry *entry_at (logbuf_t *logbuf, int i)
+{
+    return &logbuf->ring[(logbuf->head + i) % logbuf->ring_size];
+}
+
+static void logbuf_trim (logbuf_t *logbuf, int size)
 {
-    if (e) {
-        if (e->buf)
-            free (e->buf);
-        free (e);
+    assert (logbuf->magic == LOGBUF_MAGIC);
+    if (logbuf->count > size) {
+        int n = logbuf->count - size;
+        logbuf->head = (logbuf->head + n) % logbuf->ring_size;
+        logbuf->count = size;
     }
 }
 
-static struct logbuf_entry *logbuf_entry_create (const char *buf, int len)
+static void logbuf_clear (logbuf_t *logbuf, int seq_index)
 {
-    struct logbuf_entry *e = calloc (1, sizeof (*e));
-    if (!e)
-        return NULL;
-    if (!(e->buf = calloc (1, len))) {
-        free (e);
-        return NULL;
+    if (seq_index == -1)
+        logbuf_trim (logbuf, 0);
+    else if (logbuf->count > 0) {
+        int first = entry_at (logbuf, 0)->seq;
+        if (seq_index >= first) {
+            int n = seq_index - first + 1;
+            logbuf_trim (logbuf, n < logbuf->count ? logbuf->count - n : 0);
+        }
     }
-    memcpy (e->buf, buf, len);
-    e->len = len;
-    return e;
 }
 
-static void logbuf_trim (logbuf_t *logbuf, int size)
+/* Return the id of interned string 's', adding it if necessary,
+ * or -1 if the atom table is full.
+ */
+static int atom_get (logbuf_t *logbuf, const char *s)
 {
-    assert (logbuf->magic == LOGBUF_MAGIC);
-    struct logbuf_entry *e;
-    while (zlist_size (logbuf->buf) > size) {
-        e = zlist_pop (logbuf->buf);
-        logbuf_entry_destroy (e);
+    char **atoms;
+    void *item;
+
+    if ((item = zhash_lookup (logbuf->atom_ids, s)))
+        return (uintptr_t)item - 1;
+    if (logbuf->atom_count == ATOMS_MAX)
+        return -1;
+    if (!(atoms = realloc (logbuf->atoms,
+                           sizeof (atoms[0]) * (logbuf->atom_count + 1))))
+        return -1;
+    logbuf->atoms = atoms;
+    if (!(atoms[logbuf->atom_count] = strdup (s)))
+        return -1;
+    item = (void *)(uintptr_t)(logbuf->atom_count + 1);
+    if (zhash_insert (logbuf->atom_ids, s, item) < 0) {
+        free (atoms[logbuf->atom_count]);
+        return -1;
     }
+    return logbuf->atom_count++;
 }
 
-static void logbuf_clear (logbuf_t *logbuf, int seq_index)
+/* Parse a canonical decimal rank, i.e. one that %u reproduces.
+ */
+static int parse_rank (const char *s, uint32_t *rank)
 {
-    struct logbuf_entry *e;
+    unsigned long i;
+    char *endptr;
 
-    if (seq_index == -1)
-        logbuf_trim (logbuf, 0);
-    else {
-        while ((e = zlist_first (logbuf->buf)) && e->seq <= seq_index) {
-            e = zlist_pop (logbuf->buf);
-            logbuf_entry_destroy (e);
+    if (!isdigit (*s) || (*s == '0' && s[1] != '\0') || strlen (s) > 10)
+        return -1;
+    errno = 0;
+    i = strtoul (s, &endptr, 10);
+    if (errno != 0 || *endptr != '\0' || i > UINT32_MAX)
+        return -1;
+    *rank = i;
+    return 0;
+}
+
+static int count_digits (int i)
+{
+    int n = 1;
+    while ((i /= 10) > 0)
+        n++;
+    return n;
+}
+
+/* Try to store the header of 'buf' in compact form.
+ * Return the offset of the structured data, or -1 if the header
+ * wouldn't be reproduced exactly by entry_format().
+ */
+static int entry_set_header (logbuf_t *logbuf,
+                             struct logbuf_entry *e,
+                             const char *buf,
+                             const struct stdlog_header *hdr,
+                             const char *sd)
+{
+    int appname, procid, msgid;
+    int off;
+
+    if (!hdr || hdr->version != 1 || hdr->pri < 0 || hdr->pri > 191)
+        return -1;
+    /* Header fields are copied verbatim by stdlog_decode(), but integers
+     * might not be canonical.  Check that re-encoding gives the same length.
+     */
+    off = 1 + count_digits (hdr->pri) + 1 + 1 + 1
+        + strlen (hdr->timestamp) + 1
+        + strlen (hdr->hostname) + 1
+        + strlen (hdr->appname) + 1
+        + strlen (hdr->procid) + 1
+        + strlen (hdr->msgid) + 1;
+    if (sd - buf != off)
+        return -1;
+    if (parse_rank (hdr->hostname, &e->hostname) < 0
+        || wallclock_parse_zulu (hdr->timestamp, &e->sec, &e->usec) < 0
+        || (appname = atom_get (logbuf, hdr->appname)) < 0
+        || (procid = atom_get (logbuf, hdr->procid)) < 0
+        || (msgid = atom_get (logbuf, hdr->msgid)) < 0)
+        return -1;
+    e->pri = hdr->pri;
+    e->appname = appname;
+    e->procid = procid;
+    e->msgid = msgid;
+    return off;
+}
+
+static int entry_set (logbuf_t *logbuf,
+                      struct logbuf_entry *e,
+                      const char *buf,
+                      int len,
+                      const struct stdlog_header *hdr,
+                      const char *sd)
+{
+    int off;
+
+    if ((off = entry_set_header (logbuf, e, buf, hdr, sd)) < 0)
+        off = 0;
+    if (e->size < len - off) {
+        char *text;
+        if (!(text = realloc (e->text, len - off))) {
+            errno = ENOMEM;
+            return -1;
+        }
+        e->text = text;
+        e->size = len - off;
+    }
+    memcpy (e->text, buf + off, len - off);
+    e->len = len - off;
+    e->raw = (off == 0);
+    return 0;
+}
+
+/* Re-encode entry 'e' into logbuf->fmt, unless it was stored verbatim.
+ */
+static int entry_format (logbuf_t *logbuf, struct logbuf_entry *e,
+                         const char **buf, int *len)
+{
+    char timestamp[WALLCLOCK_MAXLEN];
+    int n;
+
+    if (e->raw) {
+        *buf = e->text;
+        *len = e->len;
+        return 0;
+    }
+    if (logbuf->fmt_size < STDLOG_MAX_HEADER + e->len + 1) {
+        int size = STDLOG_MAX_HEADER + e->len + 1;
+        char *fmt;
+        if (!(fmt = realloc (logbuf->fmt, size))) {
+            errno = ENOMEM;
+            return -1;
         }
+        logbuf->fmt = fmt;
+        logbuf->fmt_size = size;
     }
+    if (wallclock_format_zulu (e->sec, e->usec,
+                               timestamp, sizeof (timestamp)) < 0)
+        return -1;
+    n = snprintf (logbuf->fmt, STDLOG_MAX_HEADER + 1,
+                  "<%d>1 %s %" PRIu32 " %s %s %s ",
+                  e->pri,
+                  timestamp,
+                  e->hostname,
+                  logbuf->atoms[e->appname],
+                  logbuf->atoms[e->procid],
+                  logbuf->atoms[e->msgid]);
+    assert (n <= STDLOG_MAX_HEADER);
+    memcpy (logbuf->fmt + n, e->text, e->len);
+    *buf = logbuf->fmt;
+    *len = n + e->len;
+    return 0;
+}
+
+/* Find the first entry with sequence number greater than 'seq_index'.
+ */
+static struct logbuf_entry *logbuf_next (logbuf_t *logbuf, int seq_index)
+{
+    int first, i;
+
+    if (logbuf->count == 0) {
+        errno = ENOENT;
+        return NULL;
+    }
+    first = entry_at (logbuf, 0)->seq;
+    i = seq_index < first ? 0 : seq_index - first + 1;
+    if (i >= logbuf->count) {
+        errno = ENOENT;
+        return NULL;
+    }
+    return entry_at (logbuf, i);
 }
 
 static int logbuf_get (logbuf_t *logbuf, int seq_index, int *seq,
                        const char **buf, int *len)
 {
-    struct logbuf_entry *e = zlist_first (logbuf->buf);
+    struct logbuf_entry *e;
 
-    while (e && e->seq <= seq_index)
-        e = zlist_next (logbuf->buf);
-    if (!e) {
-        errno = ENOENT;
+    if (!(e = logbuf_next (logbuf, seq_index)))
+        return -1;
+    if (entry_format (logbuf, e, buf, len) < 0)
         return -1;
-    }
     if (seq)
         *seq = e->seq;
-    if (buf)
-        *buf = e->buf;
-    if (len)
-        *len = e->len;
     return 0;
 }
 
@@ -166,15 +358,20 @@ static int logbuf_sleepon (logbuf_t *logbuf, flux_msg_handler_f fun, flux_t *h,
     struct sleeper *s = sleeper_create (fun, h, mh, msg, arg);
     if (!s)
         return -1;
-    if (zlist_append (logbuf->sleepers, s) < 0) {
+    if (flux_msglist_append (logbuf->sleepers, s->msg, s) < 0) {
         sleeper_destroy (s);
-        errno = ENOMEM;
         return -1;
     }
     return 0;
 }
 
-static int append_new_entry (logbuf_t *logbuf, const char *buf, int len)
+static void notify_followers (logbuf_t *logbuf, struct logbuf_entry *e);
+
+static int append_new_entry (logbuf_t *logbuf,
+                             const char *buf,
+                             int len,
+                             const struct stdlog_header *hdr,
+                             const char *sd)
 {
     assert (logbuf->magic == LOGBUF_MAGIC);
     struct logbuf_entry *e;
@@ -182,17 +379,13 @@ static int append_new_entry (logbuf_t *logbuf, const char *buf, int len)
 
     if (logbuf->ring_size > 0) {
         logbuf_trim (logbuf, logbuf->ring_size - 1);
-        if (!(e = logbuf_entry_create (buf, len))) {
-            errno = ENOMEM;
+        e = entry_at (logbuf, logbuf->count);
+        if (entry_set (logbuf, e, buf, len, hdr, sd) < 0)
             return -1;
-        }
         e->seq = logbuf->seq++;
-        if (zlist_append (logbuf->buf, e) < 0) {
-            logbuf_entry_destroy (e);
-            errno = ENOMEM;
-            return -1;
-        }
-        while ((s = zlist_pop (logbuf->sleepers))) {
+        logbuf->count++;
+        notify_followers (logbuf, e);
+        while ((s = flux_msglist_pop (logbuf->sleepers))) {
             s->fun (s->h, s->mh, s->msg, s->arg);
             sleeper_destroy (s);
         }
@@ -213,11 +406,13 @@ static logbuf_t *logbuf_create (void)
     logbuf->stderr_level = default_stderr_level;
     logbuf->level = default_level;
     logbuf->ring_size = default_ring_size;
-    if (!(logbuf->buf = zlist_new ())) {
-        errno = ENOMEM;
+    logbuf->forward_window = default_forward_window;
+    logbuf->forward_rate = default_forward_rate;
+    if (!(logbuf->ring = calloc (logbuf->ring_size, sizeof (logbuf->ring[0]))))
         goto cleanup;
-    }
-    if (!(logbuf->sleepers = zlist_new ())) {
+    if (!(logbuf->sleepers = flux_msglist_create ())
+        || !(logbuf->followers = flux_msglist_create ())
+        || !(logbuf->atom_ids = zhash_new ())) {
         errno = ENOMEM;
         goto cleanup;
     }
@@ -231,16 +426,34 @@ void logbuf_destroy (logbuf_t *logbuf)
 {
     if (logbuf) {
         assert (logbuf->magic == LOGBUF_MAGIC);
-        if (logbuf->buf) {
-            logbuf_trim (logbuf, 0);
-            zlist_destroy (&logbuf->buf);
+        if (logbuf->ring) {
+            int i;
+            for (i = 0; i < logbuf->ring_size; i++)
+                free (logbuf->ring[i].text);
+            free (logbuf->ring);
         }
         if (logbuf->sleepers) {
             struct sleeper *s;
-            while ((s = zlist_pop (logbuf->sleepers)))
+            while ((s = flux_msglist_pop (logbuf->sleepers)))
                 sleeper_destroy (s);
-            zlist_destroy (&logbuf->sleepers);
+            flux_msglist_destroy (logbuf->sleepers);
+        }
+        if (logbuf->followers) {
+            flux_msg_t *msg;
+            while ((msg = flux_msglist_pop (logbuf->followers)))
+                flux_msg_destroy (msg);
+            flux_msglist_destroy (logbuf->followers);
+        }
+        zhash_destroy (&logbuf->atom_ids);
+        if (logbuf->atoms) {
+            int i;
+            for (i = 0; i < logbuf->atom_count; i++)
+                free (logbuf->atoms[i]);
+            free (logbuf->atoms);
         }
+        free (logbuf->fmt);
+        flux_watcher_destroy (logbuf->agg_timer);
+        logagg_destroy (logbuf->agg);
         if (logbuf->f)
             (void)fclose (logbuf->f);
         if (logbuf->filename)
@@ -291,14 +504,58 @@ static int logbuf_set_level (logbuf_t *logbuf, int level)
 }
 
 
+/* Reallocate the ring, keeping the newest entries.
+ */
 static int logbuf_set_ring_size (logbuf_t *logbuf, int size)
 {
+    struct logbuf_entry *ring = NULL;
+    int i;
+
     if (size < 0) {
         errno = EINVAL;
         return -1;
     }
+    if (size == logbuf->ring_size)
+        return 0;
+    if (size > 0 && !(ring = calloc (size, sizeof (ring[0]))))
+        return -1;
     logbuf_trim (logbuf, size);
+    for (i = 0; i < logbuf->count; i++) {
+        struct logbuf_entry *e = entry_at (logbuf, i);
+        ring[i] = *e;
+        e->text = NULL;
+    }
+    for (i = 0; i < logbuf->ring_size; i++)
+        free (logbuf->ring[i].text);
+    free (logbuf->ring);
+    logbuf->ring = ring;
     logbuf->ring_size = size;
+    logbuf->head = 0;
+    return 0;
+}
+
+/* Flush folded messages before changing the window,
+ * so that a window of 0 (no folding) takes effect immediately.
+ */
+static int logbuf_set_forward_window (logbuf_t *logbuf, double window)
+{
+    if (window < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    (void)logagg_flush (logbuf->agg);
+    logbuf->forward_window = window;
+    return 0;
+}
+
+static int logbuf_set_forward_rate (logbuf_t *logbuf, double rate)
+{
+    if (rate < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    logagg_set_rate (logbuf->agg, rate);
+    logbuf->forward_rate = rate;
     return 0;
 }
 
@@ -350,13 +607,21 @@ static int attr_get_log (const char *name, const char **val, void *arg)
         assert (n < sizeof (s));
         *val = s;
     } else if (!strcmp (name, "log-ring-used")) {
-        n = snprintf (s, sizeof (s), "%zd", zlist_size (logbuf->buf));
+        n = snprintf (s, sizeof (s), "%d", logbuf->count);
         assert (n < sizeof (s));
         *val = s;
     } else if (!strcmp (name, "log-count")) {
         n = snprintf (s, sizeof (s), "%d", logbuf->seq);
         assert (n < sizeof (s));
         *val = s;
+    } else if (!strcmp (name, "log-forward-window")) {
+        n = snprintf (s, sizeof (s), "%g", logbuf->forward_window);
+        assert (n < sizeof (s));
+        *val = s;
+    } else if (!strcmp (name, "log-forward-rate")) {
+        n = snprintf (s, sizeof (s), "%g", logbuf->forward_rate);
+        assert (n < sizeof (s));
+        *val = s;
     } else if (!strcmp (name, "log-filename")) {
         *val = logbuf->filename;
     } else if (!strcmp (name, "log-level")) {
@@ -393,6 +658,12 @@ static int attr_set_log (const char *name, const char *val, void *arg)
         int size = strtol (val, NULL, 10);
         if (logbuf_set_ring_size (logbuf, size) < 0)
             goto done;
+    } else if (!strcmp (name, "log-forward-window")) {
+        if (logbuf_set_forward_window (logbuf, strtod (val, NULL)) < 0)
+            goto done;
+    } else if (!strcmp (name, "log-forward-rate")) {
+        if (logbuf_set_forward_rate (logbuf, strtod (val, NULL)) < 0)
+            goto done;
     } else if (!strcmp (name, "log-filename")) {
         if (logbuf_set_filename (logbuf, val) < 0)
             goto done;
@@ -441,6 +712,12 @@ static int logbuf_register_attrs (logbuf_t *logbuf, attr_t *attrs)
     if (attr_add_active (attrs, "log-critical-level", 0,
                          attr_get_log, attr_set_log, logbuf) < 0)
         goto done;
+    if (attr_add_active (attrs, "log-forward-window", 0,
+                         attr_get_log, attr_set_log, logbuf) < 0)
+        goto done;
+    if (attr_add_active (attrs, "log-forward-rate", 0,
+                         attr_get_log, attr_set_log, logbuf) < 0)
+        goto done;
     if (attr_add_active (attrs, "log-ring-size", 0,
                          attr_get_log, attr_set_log, logbuf) < 0)
         goto done;
@@ -467,6 +744,59 @@ static int logbuf_forward (logbuf_t *logbuf, const char *buf, int len)
     return 0;
 }
 
+/* Send a message on toward the log file on rank 0.
+ */
+static int logbuf_output (logbuf_t *logbuf, const char *buf, int len)
+{
+    if (logbuf->rank == 0) {
+        flux_log_fprint (buf, len, logbuf->f);
+        return 0;
+    }
+    return logbuf_forward (logbuf, buf, len);
+}
+
+static void logagg_output_cb (const char *buf, int len, void *arg)
+{
+    logbuf_t *logbuf = arg;
+    (void)logbuf_output (logbuf, buf, len);
+}
+
+static void agg_timer_cb (flux_reactor_t *r,
+                          flux_watcher_t *w,
+                          int revents,
+                          void *arg)
+{
+    logbuf_t *logbuf = arg;
+
+    logbuf->agg_armed = false;
+    (void)logagg_flush (logbuf->agg);
+}
+
+/* Messages from downstream are folded and rate limited by logagg.
+ * This broker's own messages are passed through.
+ */
+static int logbuf_forward_agg (logbuf_t *logbuf,
+                               const char *buf,
+                               int len,
+                               uint32_t rank)
+{
+    flux_reactor_t *r;
+
+    if (rank == logbuf->rank || !logbuf->agg || logbuf->forward_window == 0)
+        return logbuf_output (logbuf, buf, len);
+    r = flux_get_reactor (logbuf->h);
+    if (logagg_append (logbuf->agg, buf, len, flux_reactor_now (r)) < 0)
+        return -1;
+    if (!logbuf->agg_armed && logagg_pending (logbuf->agg)) {
+        flux_timer_watcher_reset (logbuf->agg_timer,
+                                  logbuf->forward_window,
+                                  0.);
+        flux_watcher_start (logbuf->agg_timer);
+        logbuf->agg_armed = true;
+    }
+    return 0;
+}
+
 static int logbuf_append (logbuf_t *logbuf, const char *buf, int len)
 {
     assert (logbuf->magic == LOGBUF_MAGIC);
@@ -475,16 +805,23 @@ static int logbuf_append (logbuf_t *logbuf, const char *buf, int len)
     uint32_t rank = FLUX_NODEID_ANY;
     int severity = LOG_INFO;
     struct stdlog_header hdr;
+    bool decoded = false;
+    const char *sd = NULL;
 
     stdlog_init (&hdr);
-    if (stdlog_decode (buf, len, &hdr, NULL, NULL, NULL, NULL) == 0) {
+    if (stdlog_decode (buf, len, &hdr, &sd, NULL, NULL, NULL) == 0) {
         rank = strtoul (hdr.hostname, NULL, 10);
         severity = STDLOG_SEVERITY (hdr.pri);
+        decoded = true;
     }
 
     if (rank == logbuf->rank) {
         if (severity <= logbuf->level) {
-            if (append_new_entry (logbuf, buf, len) < 0)
+            if (append_new_entry (logbuf,
+                                  buf,
+                                  len,
+                                  decoded ? &hdr : NULL,
+                                  sd) < 0)
                 rc = -1;
         }
         if (severity <= logbuf->critical_level) {
@@ -493,12 +830,8 @@ static int logbuf_append (logbuf_t *logbuf, const char *buf, int len)
         }
     }
     if (severity <= logbuf->forward_level) {
-        if (logbuf->rank == 0) {
-            flux_log_fprint (buf, len, logbuf->f);
-        } else {
-            if (logbuf_forward (logbuf, buf, len) < 0)
-                rc = -1;
-        }
+        if (logbuf_forward_agg (logbuf, buf, len, rank) < 0)
+            rc = -1;
     }
     if (!logged_stderr && severity <= logbuf->stderr_level && logbuf->rank == 0)
         flux_log_fprint (buf, len, stderr);
@@ -560,6 +893,108 @@ error:
     flux_respond_error (h, msg, errno, NULL);
 }
 
+/* Append entry 'e' to JSON array 'bufs'.
+ * Entries that are not valid UTF-8 cannot be encoded and are skipped.
+ */
+static int append_buf (logbuf_t *logbuf, struct logbuf_entry *e, json_t *bufs)
+{
+    const char *buf;
+    int len;
+    json_t *o;
+
+    if (entry_format (logbuf, e, &buf, &len) < 0)
+        return -1;
+    if (!(o = json_pack ("s#", buf, len)))
+        return 0;
+    if (json_array_append_new (bufs, o) < 0) {
+        json_decref (o);
+        errno = ENOMEM;
+        return -1;
+    }
+    return 0;
+}
+
+static int respond_bufs (flux_t *h, const flux_msg_t *msg,
+                         int seq, json_t *bufs)
+{
+    return flux_respond_pack (h, msg, "{s:i s:O}", "seq", seq, "bufs", bufs);
+}
+
+static void notify_followers (logbuf_t *logbuf, struct logbuf_entry *e)
+{
+    flux_msg_t *msg;
+    json_t *bufs;
+
+    if (flux_msglist_count (logbuf->followers) == 0)
+        return;
+    if (!(bufs = json_array ()) || append_buf (logbuf, e, bufs) < 0) {
+        json_decref (bufs);
+        return;
+    }
+    if (json_array_size (bufs) > 0) {
+        msg = flux_msglist_first (logbuf->followers);
+        while (msg) {
+            /* N.B. logging here would recurse */
+            (void)respond_bufs (logbuf->h, msg, e->seq, bufs);
+            msg = flux_msglist_next (logbuf->followers);
+        }
+    }
+    json_decref (bufs);
+}
+
+/* Streaming dmesg: send entries after 'seq' in chunks of {seq, bufs},
+ * where seq is that of the last entry in the chunk.  Then terminate the
+ * stream with ENODATA, or if following, keep the request and send new
+ * entries as they are appended.
+ */
+static void dmesg_stream (logbuf_t *logbuf, const flux_msg_t *msg,
+                          int seq, int follow)
+{
+    flux_t *h = logbuf->h;
+    struct logbuf_entry *e;
+    json_t *bufs = NULL;
+    flux_msg_t *cpy;
+
+    if (!flux_msg_is_streaming (msg)) {
+        errno = EPROTO;
+        goto error;
+    }
+    if (!(bufs = json_array ()))
+        goto nomem;
+    while ((e = logbuf_next (logbuf, seq))) {
+        if (append_buf (logbuf, e, bufs) < 0)
+            goto error;
+        seq = e->seq;
+        if (json_array_size (bufs) == DMESG_CHUNK) {
+            if (respond_bufs (h, msg, seq, bufs) < 0)
+                goto error;
+            json_array_clear (bufs);
+        }
+    }
+    if (json_array_size (bufs) > 0) {
+        if (respond_bufs (h, msg, seq, bufs) < 0)
+            goto error;
+    }
+    json_decref (bufs);
+    if (follow) {
+        if (!(cpy = flux_msg_copy (msg, false)))
+            goto error;
+        if (flux_msglist_append (logbuf->followers, cpy, cpy) < 0) {
+            flux_msg_destroy (cpy);
+            goto error;
+        }
+        return;
+    }
+    errno = ENODATA;
+    goto error;
+nomem:
+    errno = ENOMEM;
+error:
+    json_decref (bufs);
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        log_err ("%s: flux_respond_error", __FUNCTION__);
+}
+
 static void dmesg_request_cb (flux_t *h, flux_msg_handler_t *mh,
                               const flux_msg_t *msg, void *arg)
 {
@@ -567,11 +1002,17 @@ static void dmesg_request_cb (flux_t *h, flux_msg_handler_t *mh,
     const char *buf;
     int len;
     int seq, follow;
+    int stream = 0;
 
-    if (flux_request_unpack (msg, NULL, "{ s:i s:b }",
+    if (flux_request_unpack (msg, NULL, "{ s:i s:b s?b }",
                              "seq", &seq,
-                             "follow", &follow) < 0)
+                             "follow", &follow,
+                             "stream", &stream) < 0)
         goto error;
+    if (stream) {
+        dmesg_stream (logbuf, msg, seq, follow);
+        return;
+    }
     if (logbuf_get (logbuf, seq, &seq, &buf, &len) < 0) {
         if (follow && errno == ENOENT) {
             if (logbuf_sleepon (logbuf, dmesg_request_cb, h, mh, msg, arg) < 0)
@@ -589,52 +1030,26 @@ error:
     flux_respond_error (h, msg, errno, NULL);
 }
 
-static int cmp_sender (flux_msg_t *msg, const char *uuid)
-{
-    char *sender = NULL;
-    int rc = 0;
-
-    if (flux_msg_get_route_first (msg, &sender) < 0)
-        goto done;
-    if (!sender || strcmp (sender, uuid) != 0)
-        goto done;
-    rc = 1;
-done:
-    free (sender);
-    return rc;
-}
-
+/* Drop sleeping and streaming dmesg requests from a disconnecting client.
+ */
 static void disconnect_request_cb (flux_t *h, flux_msg_handler_t *mh,
                                    const flux_msg_t *msg, void *arg)
 {
     logbuf_t *logbuf = arg;
-    char *sender = NULL;
     struct sleeper *s;
-    zlist_t *tmp = NULL;
+    flux_msg_t *req;
 
     assert (logbuf->magic == LOGBUF_MAGIC);
-    if (flux_msg_get_route_first (msg, &sender) < 0 || !sender)
-        goto done;
-    s = zlist_first (logbuf->sleepers);
-    while (s) {
+    while ((s = flux_msglist_pop_sender (logbuf->sleepers,
+                                         msg,
+                                         FLUX_MATCHTAG_NONE))) {
         assert (s->magic == SLEEPER_MAGIC);
-        if (cmp_sender (s->msg, sender)) {
-            if (!tmp && !(tmp = zlist_new ()))
-                goto done;
-            if (zlist_append (tmp, s) < 0)
-                goto done;
-        }
-        s = zlist_next (logbuf->sleepers);
-    }
-    if (tmp) {
-        while ((s = zlist_pop (tmp))) {
-            zlist_remove (logbuf->sleepers, s);
-            sleeper_destroy (s);
-        }
+        sleeper_destroy (s);
     }
-done:
-    free (sender);
-    zlist_destroy (&tmp);
+    while ((req = flux_msglist_pop_sender (logbuf->followers,
+                                           msg,
+                                           FLUX_MATCHTAG_NONE)))
+        flux_msg_destroy (req);
     /* no response */
 }
 
@@ -661,6 +1076,15 @@ int logbuf_initialize (flux_t *h, uint32_t rank, attr_t *attrs)
         goto error;
     logbuf->h = h;
     logbuf->rank = rank;
+    if (!(logbuf->agg = logagg_create (logagg_output_cb, logbuf)))
+        goto error;
+    logagg_set_rate (logbuf->agg, logbuf->forward_rate);
+    if (!(logbuf->agg_timer = flux_timer_watcher_create (flux_get_reactor (h),
+                                                         0.,
+                                                         0.,
+                                                         agg_timer_cb,
+                                                         logbuf)))
+        goto error;
     if (logbuf_register_attrs (logbuf, attrs) < 0)
         goto error;
     if (flux_msg_handler_addvec (h, htab, logbuf, &logbuf->handlers) < 0)
@@ -0,0 +1,405 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* logagg.c - collapse identical forwarded log messages
+ *
+ * Folds are hashed by "severity appname message" (appname cannot contain
+ * a space).  A fold is created with zero count when the first occurrence
+ * is output, so that later occurrences in the window are counted, not
+ * output.  The number of folds per window is capped; past the cap,
+ * messages are only subject to rate limiting.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <syslog.h>
+#include <czmq.h>
+
+#include "src/common/libutil/stdlog.h"
+#include "src/common/libutil/wallclock.h"
+#include "src/common/libidset/idset.h"
+
+#include "logagg.h"
+
+#define LOGAGG_MAX_FOLDS 4096
+
+struct fold {
+    char *buf;              // first folded occurrence, for its header
+    int len;
+    char *msg;
+    int count;
+    struct idset *ranks;
+};
+
+struct bucket {
+    double tokens;
+    double last;
+};
+
+struct logagg {
+    logagg_output_f cb;
+    void *arg;
+    double rate;
+    zhashx_t *folds;
+    zhashx_t *buckets;      // hostname => struct bucket
+    int dropped;
+    struct idset *dropped_ranks;
+};
+
+static void fold_destroy (struct fold *f)
+{
+    if (f) {
+        int saved_errno = errno;
+        free (f->buf);
+        free (f->msg);
+        idset_destroy (f->ranks);
+        free (f);
+        errno = saved_errno;
+    }
+}
+
+static void fold_destructor (void **item)
+{
+    if (item) {
+        fold_destroy (*item);
+        *item = NULL;
+    }
+}
+
+static struct fold *fold_create (const char *msg, int msglen)
+{
+    struct fold *f;
+
+    if (!(f = calloc (1, sizeof (*f))))
+        return NULL;
+    if (!(f->msg = strndup (msg, msglen))
+        || !(f->ranks = idset_create (0, IDSET_FLAG_AUTOGROW))) {
+        fold_destroy (f);
+        return NULL;
+    }
+    return f;
+}
+
+static int fold_add (struct fold *f,
+                     const char *buf,
+                     int len,
+                     int count,
+                     const struct idset *ranks)
+{
+    if (!f->buf) {
+        if (!(f->buf = malloc (len)))
+            return -1;
+        memcpy (f->buf, buf, len);
+        f->len = len;
+    }
+    if (idset_add (f->ranks, ranks) < 0)
+        return -1;
+    f->count += count;
+    return 0;
+}
+
+static zhashx_t *folds_create (void)
+{
+    zhashx_t *folds;
+
+    if (!(folds = zhashx_new ())) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    zhashx_set_destructor (folds, fold_destructor);
+    return folds;
+}
+
+/* A message either has nil structured data and stands for itself,
+ * or carries a repeat count and ranks from a downstream logagg.
+ */
+static int parse_ranks (const char *hostname,
+                        const char *sd,
+                        int sdlen,
+                        int *count,
+                        struct idset **ranksp)
+{
+    struct idset *ranks;
+    const char *s;
+    int slen;
+
+    if (sdlen == 1 && sd[0] == '-') {
+        unsigned long rank;
+        char *endptr;
+
+        errno = 0;
+        rank = strtoul (hostname, &endptr, 10);
+        if (errno != 0 || endptr == hostname || *endptr != '\0')
+            return -1;
+        if (!(ranks = idset_create (0, IDSET_FLAG_AUTOGROW)))
+            return -1;
+        if (idset_set (ranks, rank) < 0) {
+            idset_destroy (ranks);
+            return -1;
+        }
+        *count = 1;
+    }
+    else {
+        if (stdlog_repeat_decode (sd, sdlen, count, &s, &slen) < 0)
+            return -1;
+        if (!(ranks = idset_ndecode (s, slen)))
+            return -1;
+    }
+    *ranksp = ranks;
+    return 0;
+}
+
+static bool rate_ok (struct logagg *agg, const char *hostname, double now)
+{
+    double capacity = agg->rate > 1. ? agg->rate : 1.;
+    struct bucket *b;
+
+    if (agg->rate == 0)
+        return true;
+    if (!(b = zhashx_lookup (agg->buckets, hostname))) {
+        if (!(b = calloc (1, sizeof (*b))))
+            return true;
+        b->tokens = capacity;
+        b->last = now;
+        if (zhashx_insert (agg->buckets, hostname, b) < 0) {
+            free (b);
+            return true;
+        }
+    }
+    b->tokens += (now - b->last) * agg->rate;
+    if (b->tokens > capacity)
+        b->tokens = capacity;
+    b->last = now;
+    if (b->tokens < 1.)
+        return false;
+    b->tokens -= 1.;
+    return true;
+}
+
+/* Encode and output a message standing for 'count' messages by 'ranks',
+ * with the header of 'hdr' except for hostname, which becomes the first
+ * of 'ranks'.
+ */
+static int output_repeat (struct logagg *agg,
+                          struct stdlog_header *hdr,
+                          int count,
+                          const struct idset *ranks,
+                          const char *msg)
+{
+    char hostname[16];
+    char *s = NULL;
+    char *sd = NULL;
+    char *buf = NULL;
+    int sdlen, len, n;
+    int rc = -1;
+
+    snprintf (hostname, sizeof (hostname), "%u", idset_first (ranks));
+    hdr->hostname = hostname;
+    if (!(s = idset_encode (ranks, IDSET_FLAG_RANGE)))
+        goto done;
+    if ((sdlen = stdlog_repeat_encode (NULL, 0, count, s)) < 0)
+        goto done;
+    if (!(sd = malloc (sdlen + 1)))
+        goto done;
+    (void)stdlog_repeat_encode (sd, sdlen + 1, count, s);
+    len = STDLOG_MAX_HEADER + sdlen + strlen (msg) + 2;
+    if (!(buf = malloc (len)))
+        goto done;
+    if ((n = stdlog_encode (buf, len, hdr, sd, msg)) >= len)
+        n = len - 1;
+    agg->cb (buf, n, agg->arg);
+    rc = 0;
+done:
+    free (buf);
+    free (sd);
+    free (s);
+    return rc;
+}
+
+static int output_fold (struct logagg *agg, struct fold *f)
+{
+    struct stdlog_header hdr;
+
+    stdlog_init (&hdr);
+    if (stdlog_decode (f->buf, f->len, &hdr, NULL, NULL, NULL, NULL) < 0)
+        return -1;
+    return output_repeat (agg, &hdr, f->count, f->ranks, f->msg);
+}
+
+static int output_dropped (struct logagg *agg)
+{
+    char timestamp[WALLCLOCK_MAXLEN];
+    struct stdlog_header hdr;
+
+    stdlog_init (&hdr);
+    hdr.pri = STDLOG_PRI (LOG_WARNING, LOG_USER);
+    if (wallclock_get_zulu (timestamp, sizeof (timestamp)) >= 0)
+        hdr.timestamp = timestamp;
+    hdr.appname = "broker";
+    return output_repeat (agg,
+                          &hdr,
+                          agg->dropped,
+                          agg->dropped_ranks,
+                          "log messages dropped by rate limit");
+}
+
+int logagg_flush (struct logagg *agg)
+{
+    zhashx_t *folds;
+    struct fold *f;
+    int count = 0;
+
+    if (!agg)
+        return 0;
+    /* Swap in a new window first, in case output is re-entrant.
+     */
+    folds = agg->folds;
+    if (!(agg->folds = folds_create ())) {
+        agg->folds = folds;
+        return -1;
+    }
+
+    f = zhashx_first (folds);
+    while (f) {
+        if (f->count > 0 && output_fold (agg, f) == 0)
+            count++;
+        f = zhashx_next (folds);
+    }
+    zhashx_destroy (&folds);
+
+    if (agg->dropped > 0) {
+        if (output_dropped (agg) == 0)
+            count++;
+        agg->dropped = 0;
+        idset_range_clear (agg->dropped_ranks,
+                           0,
+                           idset_last (agg->dropped_ranks));
+    }
+    return count;
+}
+
+bool logagg_pending (struct logagg *agg)
+{
+    if (!agg)
+        return false;
+    return zhashx_size (agg->folds) > 0 || agg->dropped > 0;
+}
+
+int logagg_append (struct logagg *agg, const char *buf, int len, double now)
+{
+    struct stdlog_header hdr;
+    const char *sd, *msg;
+    int sdlen, msglen;
+    struct idset *ranks = NULL;
+    char *key = NULL;
+    struct fold *f;
+    int count;
+
+    stdlog_init (&hdr);
+    if (stdlog_decode (buf, len, &hdr, &sd, &sdlen, &msg, &msglen) < 0
+        || parse_ranks (hdr.hostname, sd, sdlen, &count, &ranks) < 0) {
+        agg->cb (buf, len, agg->arg);
+        return 0;
+    }
+    if (asprintf (&key, "%d %s %.*s",
+                  STDLOG_SEVERITY (hdr.pri),
+                  hdr.appname,
+                  msglen,
+                  msg) < 0)
+        goto error;
+    if ((f = zhashx_lookup (agg->folds, key))) {
+        if (fold_add (f, buf, len, count, ranks) < 0)
+            goto error;
+    }
+    else if (!rate_ok (agg, hdr.hostname, now)) {
+        if (idset_add (agg->dropped_ranks, ranks) < 0)
+            goto error;
+        agg->dropped += count;
+    }
+    else {
+        agg->cb (buf, len, agg->arg);
+        if (zhashx_size (agg->folds) < LOGAGG_MAX_FOLDS) {
+            if (!(f = fold_create (msg, msglen)))
+                goto error;
+            if (zhashx_insert (agg->folds, key, f) < 0) {
+                fold_destroy (f);
+                errno = EEXIST;
+                goto error;
+            }
+        }
+    }
+    free (key);
+    idset_destroy (ranks);
+    return 0;
+error:
+    free (key);
+    idset_destroy (ranks);
+    return -1;
+}
+
+void logagg_set_rate (struct logagg *agg, double rate)
+{
+    if (agg) {
+        agg->rate = rate > 0 ? rate : 0;
+        zhashx_purge (agg->buckets);
+    }
+}
+
+void logagg_destroy (struct logagg *agg)
+{
+    if (agg) {
+        int saved_errno = errno;
+        zhashx_destroy (&agg->folds);
+        zhashx_destroy (&agg->buckets);
+        idset_destroy (agg->dropped_ranks);
+        free (agg);
+        errno = saved_errno;
+    }
+}
+
+static void bucket_destructor (void **item)
+{
+    if (item) {
+        free (*item);
+        *item = NULL;
+    }
+}
+
+struct logagg *logagg_create (logagg_output_f cb, void *arg)
+{
+    struct logagg *agg;
+
+    if (!(agg = calloc (1, sizeof (*agg))))
+        return NULL;
+    agg->cb = cb;
+    agg->arg = arg;
+    if (!(agg->folds = folds_create ()))
+        goto error;
+    if (!(agg->buckets = zhashx_new ()))
+        goto nomem;
+    zhashx_set_destructor (agg->buckets, bucket_destructor);
+    if (!(agg->dropped_ranks = idset_create (0, IDSET_FLAG_AUTOGROW)))
+        goto error;
+    return agg;
+nomem:
+    errno = ENOMEM;
+error:
+    logagg_destroy (agg);
+    return NULL;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,57 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _BROKER_LOGAGG_H
+#define _BROKER_LOGAGG_H
+
+#include <stdbool.h>
+
+/* logagg - collapse identical log messages forwarded from downstream
+ *
+ * The first occurrence of a message (by appname, severity, and text) in a
+ * window is output immediately.  Later occurrences are folded into one
+ * message that is output by logagg_flush(), carrying the number of
+ * occurrences and the ranks that logged them (see stdlog_repeat_encode()).
+ * Folded messages received from downstream are merged, so the collapse
+ * compounds at each level of the TBON.
+ *
+ * Messages that are not folded consume a token from a per-rank bucket
+ * refilled at 'rate' messages per second.  Messages arriving at an empty
+ * bucket are dropped and summarized by logagg_flush().
+ */
+
+typedef void (*logagg_output_f)(const char *buf, int len, void *arg);
+
+struct logagg *logagg_create (logagg_output_f cb, void *arg);
+void logagg_destroy (struct logagg *agg);
+
+/* Set per-rank rate limit in messages per second (0 = unlimited).
+ */
+void logagg_set_rate (struct logagg *agg, double rate);
+
+/* Accept RFC 5424 message 'buf'.  'now' is the current time in seconds.
+ * Messages that cannot be decoded are output unchanged.
+ */
+int logagg_append (struct logagg *agg, const char *buf, int len, double now);
+
+/* Output folded messages and the summary of dropped ones, and start
+ * a new window.  Returns the number of messages output.
+ */
+int logagg_flush (struct logagg *agg);
+
+/* Return true if the current window is non-empty, i.e. a flush is needed.
+ */
+bool logagg_pending (struct logagg *agg);
+
+#endif /* !_BROKER_LOGAGG_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -29,11 +29,13 @@
 #include <flux/core.h>
 
 #include "src/common/libutil/log.h"
+#include "src/common/libflux/module_private.h"
 
 #include "module.h"
 #include "modservice.h"
 #include "ping.h"
 #include "rusage.h"
+#include "profile.h"
 
 typedef struct {
     flux_t *h;
@@ -83,9 +85,10 @@ static void stats_get_cb (flux_t *h, flux_msg_handler_t *mh,
 
     flux_get_msgcounters (h, &mcs);
 
-    if (flux_respond_pack (h, msg, "{ s:i s:i s:i s:i s:i s:i s:i s:i }",
+    if (flux_respond_pack (h, msg, "{ s:i s:i s:i s:i s:i s:i s:i s:i s:i }",
                            "#request (tx)", mcs.request_tx,
                            "#request (rx)", mcs.request_rx,
+                           "#request (expired)", flux_dispatch_get_expired (h),
                            "#response (tx)", mcs.response_tx,
                            "#response (rx)", mcs.response_rx,
                            "#event (tx)", mcs.event_tx,
@@ -99,12 +102,16 @@ static void stats_clear_event_cb (flux_t *h, flux_msg_handler_t *mh,
                                   const flux_msg_t *msg, void *arg)
 {
     flux_clr_msgcounters (h);
+    flux_dispatch_clear_expired (h);
+    profile_clear (h);
 }
 
 static void stats_clear_request_cb (flux_t *h, flux_msg_handler_t *mh,
                                     const flux_msg_t *msg, void *arg)
 {
     flux_clr_msgcounters (h);
+    flux_dispatch_clear_expired (h);
+    profile_clear (h);
     if (flux_respond (h, msg, NULL) < 0)
         FLUX_LOG_ERROR (h);
 }
@@ -152,13 +159,72 @@ error:
         flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
 }
 
+/* Get memory account, optionally setting a new soft limit.
+ */
+static void memory_cb (flux_t *h, flux_msg_handler_t *mh,
+                       const flux_msg_t *msg, void *arg)
+{
+    module_t *p = arg;
+    struct flux_module_memory *mm = module_get_memory (p);
+    json_int_t limit = -1;
+
+    if (flux_request_unpack (msg, NULL, "{s?I}", "limit", &limit) < 0)
+        goto error;
+    if (limit != -1) {
+        if (limit < 0) {
+            errno = EINVAL;
+            goto error;
+        }
+        __atomic_store_n (&mm->limit, (size_t) limit, __ATOMIC_RELAXED);
+        mm->shed_usage = 0;
+    }
+    if (flux_respond_pack (h, msg, "{s:I s:I s:I s:I}",
+                           "usage", (json_int_t) mm->usage,
+                           "peak", (json_int_t) mm->peak,
+                           "limit", (json_int_t) mm->limit,
+                           "sheds", (json_int_t) mm->sheds) < 0)
+        flux_log_error (h, "%s: flux_respond", __FUNCTION__);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+}
+
+/* If memory usage is over the soft limit, ask the module to shed.
+ * Call again only if usage has grown since, or after the module
+ * got back under the limit.
+ */
+static void memory_check (modservice_ctx_t *ctx)
+{
+    struct flux_module_memory *mm = module_get_memory (ctx->p);
+
+    if (mm->limit == 0 || mm->usage <= mm->limit) {
+        mm->shed_usage = 0;
+        return;
+    }
+    if (mm->shed_usage > 0 && mm->usage <= mm->shed_usage)
+        return;
+    if (mm->shed_usage == 0)
+        flux_log (ctx->h, LOG_WARNING,
+                  "memory usage %zu exceeds soft limit %zu%s",
+                  mm->usage, mm->limit, mm->shed ? "" : " (cannot shed)");
+    mm->shed_usage = mm->usage;
+    if (mm->shed) {
+        __atomic_add_fetch (&mm->sheds, 1, __ATOMIC_RELAXED);
+        mm->shed (ctx->h, mm->usage, mm->limit, mm->shed_arg);
+    }
+}
+
 /* Reactor loop is about to block.
  */
 static void prepare_cb (flux_reactor_t *r, flux_watcher_t *w,
                         int revents, void *arg)
 {
     modservice_ctx_t *ctx = arg;
-    flux_msg_t *msg = flux_keepalive_encode (0, FLUX_MODSTATE_SLEEPING);
+    flux_msg_t *msg;
+
+    memory_check (ctx);
+    msg = flux_keepalive_encode (0, FLUX_MODSTATE_SLEEPING);
     if (!msg || flux_send (ctx->h, msg, 0) < 0)
         flux_log_error (ctx->h, "error sending keepalive");
     flux_msg_destroy (msg);
@@ -262,6 +328,15 @@ int modservice_register (flux_t *h, module_t *p)
         return -1;
     if (register_request (ctx, "debug", debug_cb, FLUX_ROLE_OWNER) < 0)
         return -1;
+    if (register_request (ctx, "memory", memory_cb, FLUX_ROLE_OWNER) < 0)
+        return -1;
+    if (flux_aux_set (h, FLUX_MODULE_MEMORY_AUX,
+                      module_get_memory (ctx->p), NULL) < 0
+        || flux_aux_set (h, FLUX_MODULE_HANDOFF_AUX,
+                         module_get_handoff (ctx->p), NULL) < 0) {
+        log_err ("flux_aux_set");
+        return -1;
+    }
 
     if (ping_initialize (h,
                          module_get_name (ctx->p),
@@ -273,6 +348,10 @@ int modservice_register (flux_t *h, module_t *p)
         log_err ("rusage_initialize");
         return -1;
     }
+    if (profile_initialize (h, module_get_name (ctx->p)) < 0) {
+        log_err ("profile_initialize");
+        return -1;
+    }
 
     if (register_event (ctx, "stats.clear", stats_clear_event_cb) < 0)
         return -1;
@@ -22,6 +22,7 @@
 #include <stdbool.h>
 #include <sys/socket.h>
 #include <sys/time.h>
+#include <sys/prctl.h>
 #include <stdarg.h>
 #include <dlfcn.h>
 #include <inttypes.h>
@@ -37,10 +38,16 @@
 
 #include "src/common/libutil/log.h"
 #include "src/common/libutil/iterators.h"
+#include "src/common/libutil/monotime.h"
+#include "src/common/librouter/subtrie.h"
+#include "src/common/libflux/module_private.h"
 
 #include "heartbeat.h"
+#include "interthread.h"
 #include "module.h"
 #include "modservice.h"
+#include "placement.h"
+#include "topicset.h"
 
 #ifndef UUID_STR_LEN
 #define UUID_STR_LEN 37     // defined in later libuuid headers
@@ -58,7 +65,7 @@ struct broker_module {
     int lastseen;
     heartbeat_t *heartbeat;
 
-    zsock_t *sock;          /* broker end of PAIR socket */
+    flux_t *pair_h;         /* broker end of interthread pair */
     struct flux_msg_cred cred; /* cred of connection */
 
     uuid_t uuid;            /* uuid for unique request sender identity */
@@ -74,6 +81,13 @@ struct broker_module {
     int status;
     int errnum;
     bool muted;             /* module is under directive 42, no new messages */
+    struct timespec t_start;
+    double init_time;       /* seconds from start to RUNNING, or -1 */
+    struct flux_module_memory memory; /* reported by module thread */
+    struct flux_module_handoff handoff;
+    zhash_t *handoffs;
+    struct placement placement;
+    struct numa_map *numa;
 
     modpoller_cb_f poller_cb;
     void *poller_arg;
@@ -92,9 +106,12 @@ struct broker_module {
 
 struct modhash {
     zhash_t *zh_byuuid;
+    struct subtrie *subtrie;    /* subscription prefix => module_t */
     uint32_t rank;
     flux_t *broker_h;
     heartbeat_t *heartbeat;
+    struct numa_map *numa;
+    zhash_t *handoffs;          /* module name => state for next load */
 };
 
 static int setup_module_profiling (module_t *p)
@@ -143,13 +160,23 @@ done:
     return rc;
 }
 
+/* Set the calling thread's name, truncated to the kernel limit of
+ * 15 characters.
+ */
+static void module_set_thread_name (const char *name)
+{
+    char buf[16];
+
+    snprintf (buf, sizeof (buf), "%s", name);
+    (void)prctl (PR_SET_NAME, buf, 0, 0, 0);
+}
+
 static void *module_thread (void *arg)
 {
     module_t *p = arg;
     assert (p->magic == MODULE_MAGIC);
     sigset_t signal_set;
     int errnum;
-    char *uri = NULL;
     char **av = NULL;
     char *rankstr = NULL;
     int ac;
@@ -159,16 +186,15 @@ static void *module_thread (void *arg)
 
     setup_module_profiling (p);
 
-    /* Connect to broker socket, enable logging, register built-in services
+    /* The handle connected to the broker was created by module_add().
+     * Enable logging, register built-in services.
      */
-    if (asprintf (&uri, "shmem://%s", p->uuid_str) < 0) {
-        log_err ("asprintf");
-        goto done;
-    }
-    if (!(p->h = flux_open (uri, 0))) {
-        log_err ("flux_open %s", uri);
-        goto done;
-    }
+    if (getenv ("FLUX_HANDLE_TRACE"))
+        flux_flags_set (p->h, FLUX_O_TRACE);
+    if (getenv ("FLUX_HANDLE_MATCHDEBUG"))
+        flux_flags_set (p->h, FLUX_O_MATCHDEBUG);
+    if (getenv ("FLUX_HANDLE_RPCTRACE"))
+        flux_flags_set (p->h, FLUX_O_RPCTRACE);
     if (asprintf (&rankstr, "%"PRIu32, p->rank) < 0) {
         log_err ("asprintf");
         goto done;
@@ -192,12 +218,21 @@ static void *module_thread (void *arg)
         goto done;
     }
 
-    /* Block all signals
+    /* The thread already runs on its CPUs, set in module_start().
+     * Memory policy can only be set by the thread itself.
+     */
+    if (placement_set_mempolicy (&p->placement) < 0)
+        log_err ("%s: error setting NUMA memory policy", p->name);
+
+    /* Block all signals except SIGPROF, so the thread can be sampled
+     * by stackprof.  Name the thread after the module for the same reason.
      */
     if (sigfillset (&signal_set) < 0) {
         log_err ("%s: sigfillset", p->name);
         goto done;
     }
+    (void)sigdelset (&signal_set, SIGPROF);
+    module_set_thread_name (p->name);
     if ((errnum = pthread_sigmask (SIG_BLOCK, &signal_set, NULL)) != 0) {
         log_errn (errnum, "pthread_sigmask");
         goto done;
@@ -245,7 +280,6 @@ static void *module_thread (void *arg)
         flux_log_error (p->h, "flux_send");
     flux_msg_destroy (msg);
 done:
-    free (uri);
     free (rankstr);
     if (av)
         free (av);
@@ -278,7 +312,7 @@ flux_msg_t *module_recvmsg (module_t *p)
 
     assert (p->magic == MODULE_MAGIC);
 
-    if (!(msg = flux_msg_recvzsock (p->sock)))
+    if (!(msg = flux_recv (p->pair_h, FLUX_MATCH_ANY, FLUX_O_NONBLOCK)))
         goto error;
     if (flux_msg_get_type (msg, &type) < 0)
         goto error;
@@ -295,7 +329,7 @@ flux_msg_t *module_recvmsg (module_t *p)
         default:
             break;
     }
-    /* All shmem:// connections to the broker have FLUX_ROLE_OWNER
+    /* All interthread connections to the broker have FLUX_ROLE_OWNER
      * and are "authenticated" as the instance owner.
      * Allow modules so endowed to change the userid/rolemask on messages when
      * sending on behalf of other users.  This is necessary for connectors
@@ -341,7 +375,7 @@ int module_sendmsg (module_t *p, const flux_msg_t *msg)
                 goto done;
             if (flux_msg_push_route (cpy, uuid) < 0)
                 goto done;
-            if (flux_msg_sendzsock (p->sock, cpy) < 0)
+            if (flux_send (p->pair_h, cpy, 0) < 0)
                 goto done;
             break;
         }
@@ -350,12 +384,12 @@ int module_sendmsg (module_t *p, const flux_msg_t *msg)
                 goto done;
             if (flux_msg_pop_route (cpy, NULL) < 0)
                 goto done;
-            if (flux_msg_sendzsock (p->sock, cpy) < 0)
+            if (flux_send (p->pair_h, cpy, 0) < 0)
                 goto done;
             break;
         }
         default:
-            if (flux_msg_sendzsock (p->sock, msg) < 0)
+            if (flux_send (p->pair_h, msg, 0) < 0)
                 goto done;
             break;
     }
@@ -425,7 +459,15 @@ static void module_destroy (module_t *p)
 
     flux_watcher_stop (p->broker_w);
     flux_watcher_destroy (p->broker_w);
-    zsock_destroy (&p->sock);
+    flux_close (p->h); // module thread never started
+    flux_close (p->pair_h);
+
+    /* Keep state exported by the module for the next one of this name.
+     */
+    if (p->handoff.next && p->handoffs)
+        zhash_update (p->handoffs, p->name, p->handoff.next);
+    free (p->handoff.prev);
+    free (p->handoff.next);
 
 #ifndef __SANITIZE_ADDRESS__
     dlclose (p->dso);
@@ -489,16 +531,30 @@ static void module_cb (flux_reactor_t *r, flux_watcher_t *w,
 int module_start (module_t *p)
 {
     assert (p->magic == MODULE_MAGIC);
+    pthread_attr_t attr;
     int errnum;
     int rc = -1;
 
+    if ((errnum = pthread_attr_init (&attr))) {
+        errno = errnum;
+        return -1;
+    }
+    if (p->placement.bind
+        && (errnum = pthread_attr_setaffinity_np (&attr,
+                                                  sizeof (p->placement.cpus),
+                                                  &p->placement.cpus))) {
+        errno = errnum;
+        goto done;
+    }
     flux_watcher_start (p->broker_w);
-    if ((errnum = pthread_create (&p->t, NULL, module_thread, p))) {
+    monotime (&p->t_start);
+    if ((errnum = pthread_create (&p->t, &attr, module_thread, p))) {
         errno = errnum;
         goto done;
     }
     rc = 0;
 done:
+    pthread_attr_destroy (&attr);
     return rc;
 }
 
@@ -524,6 +580,12 @@ void module_add_arg (module_t *p, const char *arg)
         log_errn_exit (e, "argz_add");
 }
 
+int module_set_placement (module_t *p, const char *cpus, const char *numa)
+{
+    assert (p->magic == MODULE_MAGIC);
+    return placement_init (&p->placement, p->numa, cpus, numa);
+}
+
 void module_set_poller_cb (module_t *p, modpoller_cb_f cb, void *arg)
 {
     assert (p->magic == MODULE_MAGIC);
@@ -546,6 +608,10 @@ void module_set_status (module_t *p, int new_status)
     assert (p->status != FLUX_MODSTATE_EXITED); /* illegal state transition */
     int prev_status = p->status;
     p->status = new_status;
+    if (prev_status == FLUX_MODSTATE_INIT
+        && (new_status == FLUX_MODSTATE_RUNNING
+            || new_status == FLUX_MODSTATE_SLEEPING))
+        p->init_time = monotime_since (p->t_start) * 1E-3;
     if (p->status_cb)
         p->status_cb (p, prev_status, p->status_arg);
 }
@@ -556,6 +622,12 @@ int module_get_status (module_t *p)
     return p->status;
 }
 
+double module_get_init_time (module_t *p)
+{
+    assert (p->magic == MODULE_MAGIC);
+    return p->init_time;
+}
+
 void module_set_errnum (module_t *p, int errnum)
 {
     assert (p->magic == MODULE_MAGIC);
@@ -568,6 +640,18 @@ int module_get_errnum (module_t *p)
     return p->errnum;
 }
 
+struct flux_module_memory *module_get_memory (module_t *p)
+{
+    assert (p->magic == MODULE_MAGIC);
+    return &p->memory;
+}
+
+struct flux_module_handoff *module_get_handoff (module_t *p)
+{
+    assert (p->magic == MODULE_MAGIC);
+    return &p->handoff;
+}
+
 int module_push_rmmod (module_t *p, const flux_msg_t *msg)
 {
     flux_msg_t *cpy = flux_msg_copy (msg, false);
@@ -614,6 +698,7 @@ module_t *module_add (modhash_t *mh, const char *path)
     const char **mod_namep;
     mod_main_f *mod_main;
     zfile_t *zf;
+    const char *state;
     int rc;
 
     dlerror ();
@@ -635,6 +720,8 @@ module_t *module_add (modhash_t *mh, const char *path)
         return NULL;
     }
     p->magic = MODULE_MAGIC;
+    p->init_time = -1;
+    p->placement.node = -1;
     p->main = mod_main;
     p->dso = dso;
     if (!(p->name = strdup (*mod_namep))) {
@@ -662,21 +749,33 @@ module_t *module_add (modhash_t *mh, const char *path)
     p->rank = mh->rank;
     p->broker_h = mh->broker_h;
     p->heartbeat = mh->heartbeat;
+    p->numa = mh->numa;
+    p->handoffs = mh->handoffs;
 
-    /* Broker end of PAIR socket is opened here.
+    /* Take over state left by the last module of this name, if any.
      */
-    if (!(p->sock = zsock_new_pair (NULL))) {
-        log_err ("zsock_new_pair");
-        goto cleanup;
+    if ((state = zhash_lookup (mh->handoffs, p->name))) {
+        if (!(p->handoff.prev = strdup (state))) {
+            errno = ENOMEM;
+            goto cleanup;
+        }
+        zhash_delete (mh->handoffs, p->name);
     }
-    if (zsock_bind (p->sock, "inproc://%s", module_get_uuid (p)) < 0) {
-        log_err ("zsock_bind inproc://%s", module_get_uuid (p));
+
+    /* Both ends of the connection are created here.  The module end is
+     * handed to the module thread, which closes it when it exits.
+     */
+    if (interthread_create (&p->pair_h, &p->h) < 0) {
+        log_err ("interthread_create");
         goto cleanup;
     }
-    if (!(p->broker_w = flux_zmq_watcher_create (flux_get_reactor (p->broker_h),
-                                                 p->sock, FLUX_POLLIN,
-                                                 module_cb, p))) {
-        log_err ("flux_zmq_watcher_create");
+    p->broker_w = flux_handle_watcher_create (flux_get_reactor (p->broker_h),
+                                              p->pair_h,
+                                              FLUX_POLLIN,
+                                              module_cb,
+                                              p);
+    if (!p->broker_w) {
+        log_err ("flux_handle_watcher_create");
         goto cleanup;
     }
     /* Set creds for connection.
@@ -702,6 +801,7 @@ cleanup:
 void module_remove (modhash_t *mh, module_t *p)
 {
     assert (p->magic == MODULE_MAGIC);
+    subtrie_remove_subscriber (mh->subtrie, p);
     zhash_delete (mh->zh_byuuid, module_get_uuid (p));
 }
 
@@ -712,11 +812,18 @@ modhash_t *modhash_create (void)
         errno = ENOMEM;
         return NULL;
     }
-    if (!(mh->zh_byuuid = zhash_new ())) {
+    if (!(mh->zh_byuuid = zhash_new ())
+        || !(mh->subtrie = subtrie_create ())
+        || !(mh->handoffs = zhash_new ())) {
         modhash_destroy (mh);
         errno = ENOMEM;
         return NULL;
     }
+    zhash_autofree (mh->handoffs);
+    /* Without a NUMA map, placement by node fails but modules still load.
+     */
+    if (!(mh->numa = numa_map_create (NULL)))
+        log_err ("error reading NUMA topology");
     return mh;
 }
 
@@ -736,6 +843,9 @@ void modhash_destroy (modhash_t *mh)
             }
             zhash_destroy (&mh->zh_byuuid);
         }
+        zhash_destroy (&mh->handoffs);
+        subtrie_destroy (mh->subtrie);
+        numa_map_destroy (mh->numa);
         free (mh);
     }
 }
@@ -755,6 +865,24 @@ void modhash_set_heartbeat (modhash_t *mh, heartbeat_t *hb)
     mh->heartbeat = hb;
 }
 
+/* Get the CPUs the module thread is actually running on, which may
+ * differ from its placement if the module changed its own affinity.
+ */
+static int module_get_cpus (module_t *p, cpu_set_t *cpus)
+{
+    int e;
+
+    if (!p->t || p->status == FLUX_MODSTATE_EXITED) {
+        errno = ESRCH;
+        return -1;
+    }
+    if ((e = pthread_getaffinity_np (p->t, sizeof (*cpus), cpus))) {
+        errno = e;
+        return -1;
+    }
+    return 0;
+}
+
 json_t *module_get_modlist (modhash_t *mh, struct service_switch *sw)
 {
     json_t *mods = NULL;
@@ -771,16 +899,33 @@ json_t *module_get_modlist (modhash_t *mh, struct service_switch *sw)
         if ((p = zhash_lookup (mh->zh_byuuid, uuid))) {
             json_t *svcs;
             json_t *entry;
+            cpu_set_t set;
+            char *cpus = NULL;
+            char *numa = NULL;
 
             if (!(svcs  = service_list_byuuid (sw, uuid)))
                 goto nomem;
-            if (!(entry = json_pack ("{s:s s:i s:s s:i s:i s:o}",
-                                     "name", module_get_name (p),
-                                     "size", p->size,
-                                     "digest", p->digest,
-                                      "idle", module_get_idle (p),
-                                      "status", p->status,
-                                      "services", svcs))) {
+            size_t memory = __atomic_load_n (&p->memory.usage,
+                                             __ATOMIC_RELAXED);
+            if (module_get_cpus (p, &set) == 0) {
+                cpus = placement_encode_cpus (&set);
+                if (mh->numa)
+                    numa = numa_map_nodes (mh->numa, &set);
+            }
+            entry = json_pack ("{s:s s:i s:s s:i s:i s:f s:I s:s s:s s:o}",
+                               "name", module_get_name (p),
+                               "size", p->size,
+                               "digest", p->digest,
+                               "idle", module_get_idle (p),
+                               "status", p->status,
+                               "init", p->init_time,
+                               "memory", (json_int_t) memory,
+                               "cpus", cpus ? cpus : "",
+                               "numa", numa ? numa : "",
+                               "services", svcs);
+            free (cpus);
+            free (numa);
+            if (!entry) {
                 json_decref (svcs);
                 goto nomem;
             }
@@ -844,7 +989,12 @@ int module_subscribe (modhash_t *mh, const char *uuid, const char *topic)
         errno = ENOMEM;
         goto done;
     }
+    if (subtrie_add (mh->subtrie, topic, p) < 0) {
+        free (cpy);
+        goto done;
+    }
     if (zlist_push (p->subs, cpy) < 0) {
+        (void)subtrie_remove (mh->subtrie, topic, p);
         free (cpy);
         errno = ENOMEM;
         goto done;
@@ -867,6 +1017,7 @@ int module_unsubscribe (modhash_t *mh, const char *uuid, const char *topic)
     s = zlist_first (p->subs);
     while (s) {
         if (!strcmp (topic, s)) {
+            (void)subtrie_remove (mh->subtrie, topic, p);
             zlist_remove (p->subs, s);
             free (s);
             break;
@@ -878,37 +1029,55 @@ done:
     return rc;
 }
 
-static bool match_sub (module_t *p, const char *topic)
+int modhash_add_subscriptions (modhash_t *mh, struct topicset *ts)
 {
-    char *s = zlist_first (p->subs);
+    const char *uuid;
+    module_t *p;
+    char *s;
 
-    while (s) {
-        if (!strncmp (topic, s, strlen (s)))
-            return true;
-        s = zlist_next (p->subs);
+    FOREACH_ZHASH (mh->zh_byuuid, uuid, p) {
+        s = zlist_first (p->subs);
+        while (s) {
+            if (topicset_add (ts, s) < 0)
+                return -1;
+            s = zlist_next (p->subs);
+        }
     }
-    return false;
+    return 0;
 }
 
+struct mcast_ctx {
+    const flux_msg_t *msg;
+    int rc;
+    int errnum;
+};
+
+// subtrie_match_f footprint
+static void mcast_send (void *subscriber, void *arg)
+{
+    module_t *p = subscriber;
+    struct mcast_ctx *mc = arg;
+
+    if (module_sendmsg (p, mc->msg) < 0 && mc->rc == 0) {
+        mc->rc = -1;
+        mc->errnum = errno;
+    }
+}
+
+/* Send event to every module with a matching subscription.  A failure to
+ * send to one module does not prevent delivery to the others.
+ */
 int module_event_mcast (modhash_t *mh, const flux_msg_t *msg)
 {
+    struct mcast_ctx mc = { .msg = msg, .rc = 0, .errnum = 0 };
     const char *topic;
-    module_t *p;
-    int rc = -1;
 
     if (flux_msg_get_topic (msg, &topic) < 0)
-        goto done;
-    p = zhash_first (mh->zh_byuuid);
-    while (p) {
-        if (match_sub (p, topic)) {
-            if (module_sendmsg (p, msg) < 0)
-                goto done;
-        }
-        p = zhash_next (mh->zh_byuuid);
-    }
-    rc = 0;
-done:
-    return rc;
+        return -1;
+    subtrie_match (mh->subtrie, topic, mcast_send, &mc);
+    if (mc.rc < 0)
+        errno = mc.errnum;
+    return mc.rc;
 }
 
 module_t *module_first (modhash_t *mh)
@@ -20,6 +20,8 @@
 
 typedef struct broker_module module_t;
 typedef struct modhash modhash_t;
+
+struct topicset;
 typedef void (*modpoller_cb_f)(module_t *p, void *arg);
 typedef void (*module_status_cb_f)(module_t *p, int prev_status, void *arg);
 
@@ -42,6 +44,12 @@ void module_remove (modhash_t *mh, module_t *p);
 void module_set_args (module_t *p, int argc, char * const argv[]);
 void module_add_arg (module_t *p, const char *arg);
 
+/* Restrict the module thread to the CPUs in idset 'cpus', the CPUs of the
+ * NUMA nodes in idset 'numa', or both; either may be NULL.  Call before
+ * module_start().  Returns 0 on success, -1 with errno set (EINVAL, ENOENT).
+ */
+int module_set_placement (module_t *p, const char *cpus, const char *numa);
+
 /* Get module name.
  */
 const char *module_get_name (module_t *p);
@@ -78,6 +86,10 @@ int module_event_mcast (modhash_t *mh, const flux_msg_t *msg);
 int module_subscribe (modhash_t *mh, const char *uuid, const char *topic);
 int module_unsubscribe (modhash_t *mh, const char *uuid, const char *topic);
 
+/* Add the subscriptions of all modules to 'ts'.
+ */
+int modhash_add_subscriptions (modhash_t *mh, struct topicset *ts);
+
 int module_push_rmmod (module_t *p, const flux_msg_t *msg);
 flux_msg_t *module_pop_rmmod (module_t *p);
 int module_push_insmod (module_t *p, const flux_msg_t *msg);
@@ -89,9 +101,25 @@ void module_set_status (module_t *p, int status);
 int module_get_status (module_t *p);
 void module_set_status_cb (module_t *p, module_status_cb_f cb, void *arg);
 
+/* Get seconds from module_start() until the module left INIT,
+ * or -1 if it has not yet done so.
+ */
+double module_get_init_time (module_t *p);
+
 int module_get_errnum (module_t *p);
 void module_set_errnum (module_t *p, int errnum);
 
+/* Get the memory account shared with the module thread.
+ */
+struct flux_module_memory *module_get_memory (module_t *p);
+
+/* Get the state handed over from the module's predecessor and to its
+ * successor.  State exported by the module is kept by the modhash
+ * when the module is destroyed, and given to the next module of the
+ * same name added to it.
+ */
+struct flux_module_handoff *module_get_handoff (module_t *p);
+
 /* Send a response message to the module whose uuid matches the
  * next hop in the routing stack.
  */
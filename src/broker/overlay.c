@@ -12,27 +12,155 @@
 #include "config.h"
 #endif
 #include <stdarg.h>
+#include <limits.h>
 #include <czmq.h>
 #include <zmq.h>
 #include <flux/core.h>
 #include <inttypes.h>
+#include <arpa/inet.h>
 #include <jansson.h>
 
 #include "src/common/libutil/xzmalloc.h"
 #include "src/common/libutil/log.h"
 #include "src/common/libutil/iterators.h"
-#include "src/common/libutil/kary.h"
 #include "src/common/libutil/cleanup.h"
 #include "src/common/libutil/zsecurity.h"
+#include "src/common/libutil/monotime.h"
 
 #include "heartbeat.h"
 #include "overlay.h"
 #include "attr.h"
+#include "topicset.h"
+#include "evring.h"
+#include "compress.h"
+
+/* Opt-in message batching (tbon.batch-count > 1).
+ * Messages bound for the parent, or for a given child, are queued and sent
+ * as one zeromq message at the end of the reactor loop iteration, or
+ * sooner if batch-count messages or BATCH_MAX_SIZE bytes are queued.
+ * The envelope is a keepalive message with topic "overlay.batch" whose
+ * raw payload is a sequence of [4 byte length][flux_msg_encode() output].
+ * A receiver always accepts batches, so batching may be enabled on
+ * some brokers and not others.
+ */
+#define BATCH_TOPIC     "overlay.batch"
+
+/* Event forwarding.
+ * A child that has reported its subtree's subscriptions is only sent
+ * matching events.  A run of events it was not sent is described by a
+ * keepalive with topic "overlay.event-skip" ahead of the next event it is
+ * sent, so it can tell events nobody below it wanted from lost ones.
+ * Lost events are requested from the parent's ring of recent events.
+ */
+#define SKIP_TOPIC      "overlay.event-skip"
+#define SUBSCRIBE_TOPIC "overlay.event-subscribe"
+#define REPLAY_TOPIC    "overlay.event-replay"
+#define EVENT_REPLAY_SIZE_DEFAULT 256
+#define BATCH_MAX_SIZE  (256*1024)
+
+/* Opt-in compression (tbon.compress-threshold > 0).
+ * A message (or batch envelope) whose encoded size is at least the
+ * threshold is sent as a keepalive with topic "overlay.compressed" whose
+ * raw payload is [1 byte codec][4 byte length][compressed
+ * flux_msg_encode() output], if that is smaller.  On connect, a child
+ * and its parent exchange the codecs they can decode (overlay.codecs),
+ * and a message is only compressed with a codec the receiver accepts.
+ */
+#define COMPRESS_TOPIC  "overlay.compressed"
+#define CODECS_TOPIC    "overlay.codecs"
+
+struct zstats {
+    uint64_t count;             /* messages compressed */
+    uint64_t in;                /* bytes before compression */
+    uint64_t out;               /* bytes after compression */
+    double time;                /* seconds spent compressing, incl. attempts */
+};
+
+/* Per-peer traffic, counted in messages before batching/compression.
+ */
+struct msgstats {
+    uint64_t tx_count;
+    uint64_t tx_bytes;
+    uint64_t rx_count;
+    uint64_t rx_bytes;
+};
+
+struct batch {
+    const flux_msg_t **msgs;
+    int count;
+    int alloc;
+    size_t size;
+};
+
+/* A message buffer is a sequence of [4 byte length][flux_msg_encode()].
+ */
+typedef int (*msgbuf_f)(flux_msg_t *msg, void *arg);
+
+static int msgbuf_append (uint8_t **buf,
+                          size_t *len,
+                          size_t *alloc,
+                          const flux_msg_t *msg)
+{
+    size_t n = flux_msg_encode_size (msg);
+    uint32_t nlen = htonl (n);
+
+    if (*len + sizeof (nlen) + n > *alloc) {
+        size_t newalloc = *alloc ? *alloc : 4096;
+        uint8_t *p;
+        while (*len + sizeof (nlen) + n > newalloc)
+            newalloc *= 2;
+        if (!(p = realloc (*buf, newalloc)))
+            return -1;
+        *buf = p;
+        *alloc = newalloc;
+    }
+    memcpy (*buf + *len, &nlen, sizeof (nlen));
+    if (flux_msg_encode (msg, *buf + *len + sizeof (nlen), n) < 0)
+        return -1;
+    *len += sizeof (nlen) + n;
+    return 0;
+}
+
+/* Decode each message in 'buf' and pass it to 'cb', then destroy it.
+ */
+static int msgbuf_decode (const uint8_t *buf,
+                          size_t size,
+                          msgbuf_f cb,
+                          void *arg)
+{
+    size_t offset = 0;
+
+    while (offset < size) {
+        uint32_t len;
+        flux_msg_t *msg;
+
+        if (size - offset < sizeof (len))
+            goto eproto;
+        memcpy (&len, buf + offset, sizeof (len));
+        len = ntohl (len);
+        offset += sizeof (len);
+        if (len > size - offset)
+            goto eproto;
+        if (!(msg = flux_msg_decode (buf + offset, len)))
+            return -1;
+        offset += len;
+        if (cb (msg, arg) < 0) {
+            flux_msg_destroy (msg);
+            return -1;
+        }
+        flux_msg_destroy (msg);
+    }
+    return 0;
+eproto:
+    errno = EPROTO;
+    return -1;
+}
 
 struct endpoint {
     zsock_t *zs;
     char *uri;
     flux_watcher_t *w;
+    bool trusted;               /* skip zeromq security on this link */
 };
 
 struct overlay {
@@ -45,18 +173,16 @@ struct overlay {
 
     uint32_t size;
     uint32_t rank;
-    int tbon_k;
-    int tbon_level;
-    int tbon_maxlevel;
-    int tbon_descendants;
+    struct topology *topo;
 
     struct endpoint *parent;    /* DEALER - requests to parent */
-    overlay_sock_cb_f parent_cb;
+    overlay_recv_f parent_cb;
     void *parent_arg;
     int parent_lastsent;
+    struct batch *parent_batch;
 
     struct endpoint *child;     /* ROUTER - requests from children */
-    overlay_sock_cb_f child_cb;
+    overlay_recv_f child_cb;
     void *child_arg;
 
     zsock_t *child_monitor_sock;
@@ -69,12 +195,455 @@ struct overlay {
     void *init_arg;
 
     int idle_warning;
+
+    uint32_t batch_count;
+    flux_watcher_t *batch_prep;
+
+    struct topicset *local_topics;  /* this broker's subscriptions */
+    struct topicset *adv_topics;    /* subtree subscriptions sent to parent */
+    zlist_t *pending;               /* outstanding subscription updates */
+    struct evring *ring;
+    uint32_t event_replay_size;
+
+    uint32_t compress_threshold;
+    int codec;                      /* preferred codec */
+    struct compress *compress;
+    int parent_codecs;              /* codecs the parent accepts */
+    struct zstats parent_zstats;
+    flux_future_t *codecs_f;
+
+    struct msgstats parent_mstats;
 };
 
+/* Each heartbeat, a broker child is sent a cmb.ping request (if the last
+ * one has been answered) to measure the round trip time across the hop.
+ */
 typedef struct {
     int lastseen;
+    double rtt;                 /* seconds, or -1 if not yet measured */
+    flux_future_t *ping_f;
+    struct timespec ping_t0;
+    struct batch *batch;
+    struct topicset *topics;    /* subtree subscriptions, NULL=unknown */
+    uint32_t skip_first;        /* events not forwarded since last one was */
+    uint32_t skip_last;
+    int codecs;                 /* codecs the child accepts */
+    struct zstats zstats;
+    struct msgstats mstats;
 } child_t;
 
+static void batch_clear (struct batch *b)
+{
+    int i;
+
+    for (i = 0; i < b->count; i++)
+        flux_msg_decref (b->msgs[i]);
+    b->count = 0;
+    b->size = 0;
+}
+
+static void batch_destroy (struct batch *b)
+{
+    if (b) {
+        int saved_errno = errno;
+        batch_clear (b);
+        free (b->msgs);
+        free (b);
+        errno = saved_errno;
+    }
+}
+
+static void child_destroy (child_t *child)
+{
+    if (child) {
+        int saved_errno = errno;
+        flux_future_destroy (child->ping_f);
+        batch_destroy (child->batch);
+        topicset_destroy (child->topics);
+        free (child);
+        errno = saved_errno;
+    }
+}
+
+/* Return the traffic counters for the parent (uuid=NULL) or child 'uuid',
+ * or NULL if the child is unknown.
+ */
+static struct msgstats *peer_msgstats (struct overlay *ov, const char *uuid)
+{
+    child_t *child;
+
+    if (!uuid)
+        return &ov->parent_mstats;
+    if (!(child = zhash_lookup (ov->children, uuid)))
+        return NULL;
+    return &child->mstats;
+}
+
+static void account_rx (struct overlay *ov, const char *uuid, size_t size)
+{
+    struct msgstats *ms;
+
+    if ((ms = peer_msgstats (ov, uuid))) {
+        ms->rx_count++;
+        ms->rx_bytes += size;
+    }
+}
+
+static void account_tx (struct msgstats *ms, const flux_msg_t *msg)
+{
+    ms->tx_count++;
+    ms->tx_bytes += flux_msg_encode_size (msg);
+}
+
+/* Pick the codec for a peer that accepts 'codecs': the preferred one if
+ * possible, else lz4, which every broker accepts.  Returns 0 if none.
+ */
+static int peer_codec (struct overlay *ov, int codecs)
+{
+    if ((codecs & ov->codec))
+        return ov->codec;
+    return codecs & COMPRESS_LZ4;
+}
+
+/* Compress 'msg' into a new envelope, returned in '*envp'.  '*envp' is
+ * set to NULL if compression would not save space.
+ */
+static int compress_msg (struct overlay *ov,
+                         const flux_msg_t *msg,
+                         size_t size,
+                         int codec,
+                         const char *uuid,
+                         struct zstats *zs,
+                         flux_msg_t **envp)
+{
+    struct timespec t0;
+    uint8_t *ebuf = NULL;
+    const void *zbuf;
+    size_t zlen;
+    size_t len;
+    uint8_t *buf = NULL;
+    uint32_t nsize = htonl (size);
+    flux_msg_t *env = NULL;
+
+    if (size > UINT32_MAX) {
+        *envp = NULL;
+        return 0;
+    }
+    monotime (&t0);
+    if (!(ebuf = malloc (size)))
+        return -1;
+    if (flux_msg_encode (msg, ebuf, size) < 0
+        || compress_encode (ov->compress, codec, ebuf, size, &zbuf, &zlen) < 0)
+        goto error;
+    zs->time += monotime_since (t0) / 1000.;
+    len = 1 + sizeof (nsize) + zlen;
+    if (len >= size || len > INT_MAX) {
+        free (ebuf);
+        *envp = NULL;
+        return 0;
+    }
+    if (!(buf = malloc (len)))
+        goto error;
+    buf[0] = codec;
+    memcpy (buf + 1, &nsize, sizeof (nsize));
+    memcpy (buf + 1 + sizeof (nsize), zbuf, zlen);
+    if (!(env = flux_msg_create (FLUX_MSGTYPE_KEEPALIVE))
+        || flux_msg_set_topic (env, COMPRESS_TOPIC) < 0
+        || flux_msg_set_payload (env, buf, len) < 0
+        || flux_msg_enable_route (env) < 0)
+        goto error;
+    if (uuid && flux_msg_push_route (env, uuid) < 0)
+        goto error;
+    zs->count++;
+    zs->in += size;
+    zs->out += len;
+    free (ebuf);
+    free (buf);
+    *envp = env;
+    return 0;
+error:
+    flux_msg_destroy (env);
+    free (ebuf);
+    free (buf);
+    return -1;
+}
+
+/* Send 'msg' to the parent (uuid=NULL) or to child 'uuid', compressing
+ * it if it is large enough and the peer accepts a codec.
+ */
+static int sendzsock (struct overlay *ov,
+                      void *zsock,
+                      const flux_msg_t *msg,
+                      const char *uuid)
+{
+    struct zstats *zs;
+    flux_msg_t *env;
+    child_t *child;
+    size_t size;
+    int codec;
+    int rc;
+
+    if (ov->compress_threshold == 0
+        || (size = flux_msg_encode_size (msg)) < ov->compress_threshold)
+        return flux_msg_sendzsock (zsock, msg);
+    if (uuid) {
+        if (!(child = zhash_lookup (ov->children, uuid)))
+            return flux_msg_sendzsock (zsock, msg);
+        codec = peer_codec (ov, child->codecs);
+        zs = &child->zstats;
+    }
+    else {
+        codec = peer_codec (ov, ov->parent_codecs);
+        zs = &ov->parent_zstats;
+    }
+    if (codec == 0)
+        return flux_msg_sendzsock (zsock, msg);
+    if (compress_msg (ov, msg, size, codec, uuid, zs, &env) < 0)
+        return -1;
+    if (!env)
+        return flux_msg_sendzsock (zsock, msg);
+    rc = flux_msg_sendzsock (zsock, env);
+    flux_msg_destroy (env);
+    return rc;
+}
+
+/* Send queued messages.  A batch of one is sent as is.  If 'uuid' is
+ * non-NULL, the envelope is addressed to that peer of a ROUTER socket.
+ * The queue is emptied even if sending fails.
+ */
+static int batch_flush (struct overlay *ov,
+                        struct batch *b,
+                        void *zsock,
+                        const char *uuid)
+{
+    flux_msg_t *env = NULL;
+    uint8_t *buf = NULL;
+    size_t len = 0;
+    size_t alloc = 0;
+    int rc = -1;
+    int i;
+
+    if (!b || b->count == 0)
+        return 0;
+    if (b->count == 1) {
+        rc = sendzsock (ov, zsock, b->msgs[0], uuid);
+        goto done;
+    }
+    for (i = 0; i < b->count; i++) {
+        if (msgbuf_append (&buf, &len, &alloc, b->msgs[i]) < 0)
+            goto done;
+    }
+    if (len > INT_MAX) {
+        errno = EMSGSIZE;
+        goto done;
+    }
+    if (!(env = flux_msg_create (FLUX_MSGTYPE_KEEPALIVE))
+        || flux_msg_set_topic (env, BATCH_TOPIC) < 0
+        || flux_msg_set_payload (env, buf, len) < 0
+        || flux_msg_enable_route (env) < 0)
+        goto done;
+    if (uuid && flux_msg_push_route (env, uuid) < 0)
+        goto done;
+    rc = sendzsock (ov, zsock, env, uuid);
+done:
+    flux_msg_destroy (env);
+    free (buf);
+    batch_clear (b);
+    return rc;
+}
+
+/* Queue 'msg' on the batch pointed to by 'bp', creating it if necessary.
+ * Returns 1 if the batch is now full and should be flushed, 0 if not,
+ * or -1 on error.
+ */
+static int batch_append (struct overlay *ov,
+                         struct batch **bp,
+                         const flux_msg_t *msg)
+{
+    struct batch *b = *bp;
+
+    if (!b) {
+        if (!(b = calloc (1, sizeof (*b))))
+            return -1;
+        *bp = b;
+    }
+    if (b->count == b->alloc) {
+        int alloc = b->alloc ? b->alloc * 2 : 16;
+        const flux_msg_t **msgs;
+        if (!(msgs = realloc (b->msgs, alloc * sizeof (msgs[0]))))
+            return -1;
+        b->msgs = msgs;
+        b->alloc = alloc;
+    }
+    b->msgs[b->count++] = flux_msg_incref (msg);
+    b->size += sizeof (uint32_t) + flux_msg_encode_size (msg);
+    if (b->count >= ov->batch_count || b->size >= BATCH_MAX_SIZE)
+        return 1;
+    flux_watcher_start (ov->batch_prep);
+    return 0;
+}
+
+static void log_flush_error (struct overlay *ov, const char *peer)
+{
+    if (errno != EHOSTUNREACH) // a child has disconnected - not an error
+        flux_log_error (ov->h, "overlay: error sending batch to %s", peer);
+}
+
+/* Flush all batches before the reactor blocks.
+ */
+static void batch_prep_cb (flux_reactor_t *r,
+                           flux_watcher_t *w,
+                           int revents,
+                           void *arg)
+{
+    struct overlay *ov = arg;
+    const char *uuid;
+    child_t *child;
+
+    if (ov->parent && ov->parent->zs) {
+        if (batch_flush (ov, ov->parent_batch, ov->parent->zs, NULL) < 0)
+            log_flush_error (ov, "parent");
+    }
+    if (ov->child && ov->child->zs) {
+        FOREACH_ZHASH (ov->children, uuid, child) {
+            if (batch_flush (ov, child->batch, ov->child->zs, uuid) < 0)
+                log_flush_error (ov, uuid);
+        }
+    }
+    flux_watcher_stop (w);
+}
+
+static bool is_batch (const flux_msg_t *msg)
+{
+    int type;
+    const char *topic;
+
+    if (flux_msg_get_type (msg, &type) < 0
+        || type != FLUX_MSGTYPE_KEEPALIVE
+        || flux_msg_get_topic (msg, &topic) < 0
+        || strcmp (topic, BATCH_TOPIC) != 0)
+        return false;
+    return true;
+}
+
+static bool is_compressed (const flux_msg_t *msg)
+{
+    int type;
+    const char *topic;
+
+    if (flux_msg_get_type (msg, &type) < 0
+        || type != FLUX_MSGTYPE_KEEPALIVE
+        || flux_msg_get_topic (msg, &topic) < 0
+        || strcmp (topic, COMPRESS_TOPIC) != 0)
+        return false;
+    return true;
+}
+
+struct unpack_ctx {
+    struct overlay *ov;
+    const char *uuid;
+    overlay_recv_f cb;
+    void *arg;
+};
+
+static int batch_unpack_one (flux_msg_t *msg, void *arg)
+{
+    struct unpack_ctx *ctx = arg;
+    size_t size = flux_msg_encode_size (msg);
+
+    if (ctx->uuid) {
+        if (flux_msg_enable_route (msg) < 0
+            || flux_msg_push_route (msg, ctx->uuid) < 0)
+            return -1;
+    }
+    else
+        (void)flux_msg_pop_route (msg, NULL);
+    flux_trace_record (msg, "overlay.rx");
+    if (ctx->cb)
+        ctx->cb (ctx->ov, msg, ctx->arg);
+    account_rx (ctx->ov, ctx->uuid, size);
+    return 0;
+}
+
+/* Unpack batch envelope 'env' and pass each message to 'cb', fixing up
+ * its route stack as though it had arrived on its own.  If 'uuid' is
+ * non-NULL, the batch came from that peer of a ROUTER socket, which
+ * would have pushed it.  Otherwise, it came from the parent ROUTER, which
+ * would have popped the destination identity.
+ */
+static void batch_unpack (struct overlay *ov,
+                          const flux_msg_t *env,
+                          const char *uuid,
+                          overlay_recv_f cb,
+                          void *arg)
+{
+    struct unpack_ctx ctx = { .ov = ov, .uuid = uuid, .cb = cb, .arg = arg };
+    const void *buf;
+    int size;
+
+    if (flux_msg_get_payload (env, &buf, &size) < 0
+        || msgbuf_decode (buf, size, batch_unpack_one, &ctx) < 0)
+        flux_log (ov->h, LOG_ERR, "overlay: dropping malformed batch from %s",
+                  uuid ? uuid : "parent");
+}
+
+static flux_msg_t *decompress_msg (struct overlay *ov, const flux_msg_t *env)
+{
+    const uint8_t *buf;
+    int size;
+    uint32_t len;
+    uint8_t *ebuf;
+    flux_msg_t *msg;
+
+    if (flux_msg_get_payload (env, (const void **)&buf, &size) < 0)
+        return NULL;
+    if (size < (int)(1 + sizeof (len))) {
+        errno = EPROTO;
+        return NULL;
+    }
+    memcpy (&len, buf + 1, sizeof (len));
+    len = ntohl (len);
+    if (!(ebuf = malloc (len)))
+        return NULL;
+    if (compress_decode (ov->compress,
+                         buf[0],
+                         buf + 1 + sizeof (len),
+                         size - 1 - sizeof (len),
+                         ebuf,
+                         len) < 0) {
+        free (ebuf);
+        return NULL;
+    }
+    msg = flux_msg_decode (ebuf, len);
+    free (ebuf);
+    return msg;
+}
+
+/* Decompress envelope 'env' and pass the message to 'cb', or unpack it
+ * if it is a batch.  Routes are fixed up as in batch_unpack().
+ */
+static void compressed_unpack (struct overlay *ov,
+                               const flux_msg_t *env,
+                               const char *uuid,
+                               overlay_recv_f cb,
+                               void *arg)
+{
+    struct unpack_ctx ctx = { .ov = ov, .uuid = uuid, .cb = cb, .arg = arg };
+    flux_msg_t *msg;
+
+    if (!(msg = decompress_msg (ov, env))) {
+        flux_log_error (ov->h, "overlay: dropping malformed message from %s",
+                        uuid ? uuid : "parent");
+        return;
+    }
+    if (is_batch (msg))
+        batch_unpack (ov, msg, uuid, cb, arg);
+    else if (batch_unpack_one (msg, &ctx) < 0)
+        flux_log_error (ov->h, "overlay: dropping message from %s",
+                        uuid ? uuid : "parent");
+    flux_msg_destroy (msg);
+}
+
 static void endpoint_destroy (struct endpoint *ep)
 {
     if (ep) {
@@ -105,16 +674,18 @@ void overlay_set_init_callback (struct overlay *ov,
 }
 
 int overlay_init (struct overlay *overlay,
-                  uint32_t size,
-                  uint32_t rank,
-                  int tbon_k)
+                  struct topology *topo,
+                  uint32_t rank)
 {
-    overlay->size = size;
+    if (!topo || rank >= topology_get_size (topo)) {
+        topology_destroy (topo);
+        errno = EINVAL;
+        return -1;
+    }
+    topology_destroy (overlay->topo);
+    overlay->topo = topo;
+    overlay->size = topology_get_size (topo);
     overlay->rank = rank;
-    overlay->tbon_k = tbon_k;
-    overlay->tbon_level = kary_levelof (tbon_k, rank);
-    overlay->tbon_maxlevel = kary_levelof (tbon_k, size - 1);
-    overlay->tbon_descendants = kary_sum_descendants (tbon_k, size, rank);
     if (overlay->init_cb)
         return (*overlay->init_cb) (overlay, overlay->init_arg);
     return 0;
@@ -130,6 +701,11 @@ uint32_t overlay_get_size (struct overlay *ov)
     return ov->size;
 }
 
+struct topology *overlay_get_topology (struct overlay *ov)
+{
+    return ov->topo;
+}
+
 int overlay_get_child_peer_count (struct overlay *ov)
 {
     return ov->child_peer_count;
@@ -161,12 +737,63 @@ void overlay_checkin_child (struct overlay *ov, const char *uuid)
     child_t *child  = zhash_lookup (ov->children, uuid);
     if (!child) {
         child = xzmalloc (sizeof (*child));
+        child->rtt = -1;
         zhash_update (ov->children, uuid, child);
-        zhash_freefn (ov->children, uuid, (zhash_free_fn *)free);
+        zhash_freefn (ov->children, uuid, (zhash_free_fn *)child_destroy);
     }
     child->lastseen = ov->epoch;
 }
 
+static void child_ping_continuation (flux_future_t *f, void *arg)
+{
+    struct overlay *ov = arg;
+    const char *uuid = flux_future_aux_get (f, "overlay::uuid");
+    child_t *child;
+
+    if (!uuid || !(child = zhash_lookup (ov->children, uuid))
+              || child->ping_f != f) {
+        flux_future_destroy (f);
+        return;
+    }
+    if (flux_rpc_get (f, NULL) == 0)
+        child->rtt = monotime_since (child->ping_t0) / 1000.;
+    flux_future_destroy (f);
+    child->ping_f = NULL;
+}
+
+/* Children that are brokers use their rank as uuid.
+ */
+static void overlay_ping_children (struct overlay *ov)
+{
+    const char *uuid;
+    child_t *child;
+
+    FOREACH_ZHASH (ov->children, uuid, child) {
+        char *endptr;
+        char *cpy;
+        unsigned long rank;
+        flux_future_t *f;
+
+        if (child->ping_f)
+            continue;
+        errno = 0;
+        rank = strtoul (uuid, &endptr, 10);
+        if (errno != 0 || *endptr != '\0' || rank >= ov->size)
+            continue;
+        if (!(f = flux_rpc (ov->h, "cmb.ping", "{}", rank, 0)))
+            continue;
+        if (!(cpy = strdup (uuid))
+            || flux_future_aux_set (f, "overlay::uuid", cpy, free) < 0
+            || flux_future_then (f, -1., child_ping_continuation, ov) < 0) {
+            free (cpy);
+            flux_future_destroy (f);
+            continue;
+        }
+        monotime (&child->ping_t0);
+        child->ping_f = f;
+    }
+}
+
 int overlay_set_parent (struct overlay *ov, const char *fmt, ...)
 {
     int rc = -1;
@@ -180,6 +807,16 @@ int overlay_set_parent (struct overlay *ov, const char *fmt, ...)
     return rc;
 }
 
+int overlay_set_parent_trusted (struct overlay *ov)
+{
+    if (!ov->parent || ov->parent->zs) {
+        errno = EINVAL;
+        return -1;
+    }
+    ov->parent->trusted = true;
+    return 0;
+}
+
 const char *overlay_get_parent (struct overlay *ov)
 {
     if (!ov->parent)
@@ -195,9 +832,17 @@ int overlay_sendmsg_parent (struct overlay *ov, const flux_msg_t *msg)
         errno = EHOSTUNREACH;
         goto done;
     }
-    rc = flux_msg_sendzsock (ov->parent->zs, msg);
-    if (rc == 0)
+    flux_trace_record (msg, "overlay.tx");
+    if (ov->batch_count > 1) {
+        if ((rc = batch_append (ov, &ov->parent_batch, msg)) > 0)
+            rc = batch_flush (ov, ov->parent_batch, ov->parent->zs, NULL);
+    }
+    else
+        rc = sendzsock (ov, ov->parent->zs, msg, NULL);
+    if (rc == 0) {
         ov->parent_lastsent = ov->epoch;
+        account_tx (&ov->parent_mstats, msg);
+    }
 done:
     return rc;
 }
@@ -231,9 +876,10 @@ static void heartbeat_cb (flux_t *h,
         return;
     overlay_keepalive_parent (ov);
     overlay_log_idle_children (ov);
+    overlay_ping_children (ov);
 }
 
-void overlay_set_parent_cb (struct overlay *ov, overlay_sock_cb_f cb, void *arg)
+void overlay_set_parent_cb (struct overlay *ov, overlay_recv_f cb, void *arg)
 {
     ov->parent_cb = cb;
     ov->parent_arg = arg;
@@ -252,6 +898,16 @@ int overlay_set_child (struct overlay *ov, const char *fmt, ...)
     return rc;
 }
 
+int overlay_set_child_trusted (struct overlay *ov)
+{
+    if (!ov->child || ov->child->zs) {
+        errno = EINVAL;
+        return -1;
+    }
+    ov->child->trusted = true;
+    return 0;
+}
+
 const char *overlay_get_child (struct overlay *ov)
 {
     if (!ov->child)
@@ -259,26 +915,55 @@ const char *overlay_get_child (struct overlay *ov)
     return ov->child->uri;
 }
 
-void overlay_set_child_cb (struct overlay *ov, overlay_sock_cb_f cb, void *arg)
+void overlay_set_child_cb (struct overlay *ov, overlay_recv_f cb, void *arg)
 {
     ov->child_cb = cb;
     ov->child_arg = arg;
 }
 
+/* Send 'msg', whose last route is the identity of child 'uuid'.
+ * Messages to a child that has not checked in are not batched, so that
+ * EHOSTUNREACH is reported to the caller immediately.
+ */
+static int sendmsg_child (struct overlay *ov,
+                          const flux_msg_t *msg,
+                          const char *uuid)
+{
+    child_t *child = zhash_lookup (ov->children, uuid);
+    int rc;
+
+    flux_trace_record (msg, "overlay.tx");
+    if (ov->batch_count > 1 && child) {
+        if ((rc = batch_append (ov, &child->batch, msg)) > 0)
+            rc = batch_flush (ov, child->batch, ov->child->zs, uuid);
+    }
+    else
+        rc = sendzsock (ov, ov->child->zs, msg, uuid);
+    if (rc == 0 && child)
+        account_tx (&child->mstats, msg);
+    return rc;
+}
+
 int overlay_sendmsg_child (struct overlay *ov, const flux_msg_t *msg)
 {
+    char *uuid = NULL;
     int rc = -1;
 
     if (!ov->child || !ov->child->zs) {
         errno = EINVAL;
         goto done;
     }
-    rc = flux_msg_sendzsock (ov->child->zs, msg);
+    if (flux_msg_get_route_last (msg, &uuid) < 0 || !uuid) {
+        errno = EPROTO;
+        goto done;
+    }
+    rc = sendmsg_child (ov, msg, uuid);
 done:
+    free (uuid);
     return rc;
 }
 
-static int overlay_mcast_child_one (void *zsock,
+static int overlay_mcast_child_one (struct overlay *ov,
                                     const flux_msg_t *msg,
                                     const char *uuid)
 {
@@ -291,7 +976,7 @@ static int overlay_mcast_child_one (void *zsock,
         goto done;
     if (flux_msg_push_route (cpy, uuid) < 0)
         goto done;
-    if (flux_msg_sendzsock (zsock, cpy) < 0) {
+    if (sendmsg_child (ov, cpy, uuid) < 0) {
         if (errno != EHOSTUNREACH) // a child has disconnected - not an error
             goto done;
     }
@@ -301,17 +986,71 @@ done:
     return rc;
 }
 
+/* Tell a child about events it was not sent, ahead of the next one it is.
+ */
+static void child_skip_flush (struct overlay *ov,
+                              child_t *child,
+                              const char *uuid)
+{
+    flux_msg_t *msg;
+
+    if (child->skip_last == 0)
+        return;
+    if (!(msg = flux_msg_create (FLUX_MSGTYPE_KEEPALIVE))
+        || flux_msg_set_topic (msg, SKIP_TOPIC) < 0
+        || flux_msg_pack (msg,
+                          "{s:i s:i}",
+                          "first", (int)child->skip_first,
+                          "last", (int)child->skip_last) < 0
+        || flux_msg_enable_route (msg) < 0
+        || flux_msg_push_route (msg, uuid) < 0
+        || sendmsg_child (ov, msg, uuid) < 0) {
+        if (errno != EHOSTUNREACH)
+            flux_log_error (ov->h, "overlay: error sending skip to %s", uuid);
+    }
+    flux_msg_destroy (msg);
+    child->skip_first = child->skip_last = 0;
+}
+
+static void child_skip_add (struct overlay *ov,
+                            child_t *child,
+                            const char *uuid,
+                            uint32_t first,
+                            uint32_t last)
+{
+    if (child->skip_last > 0 && first != child->skip_last + 1)
+        child_skip_flush (ov, child, uuid);
+    if (child->skip_last == 0)
+        child->skip_first = first;
+    child->skip_last = last;
+}
+
 int overlay_mcast_child (struct overlay *ov, const flux_msg_t *msg)
 {
     const char *uuid;
     child_t *child;
     int first_errno;
     int failures = 0;
+    uint32_t seq;
+    const char *topic;
 
     if (!ov->child || !ov->child->zs || !ov->children)
         return 0;
+    if (flux_msg_get_seq (msg, &seq) < 0
+        || flux_msg_get_topic (msg, &topic) < 0)
+        return -1;
+    if (!ov->ring && ov->event_replay_size > 0)
+        ov->ring = evring_create (ov->event_replay_size);
+    if (ov->ring && evring_append (ov->ring, msg) < 0)
+        flux_log_error (ov->h, "overlay: error saving event %ju",
+                        (uintmax_t)seq);
     FOREACH_ZHASH (ov->children, uuid, child) {
-        if (overlay_mcast_child_one (ov->child->zs, msg, uuid) < 0) {
+        if (child->topics && !topicset_match (child->topics, topic)) {
+            child_skip_add (ov, child, uuid, seq, seq);
+            continue;
+        }
+        child_skip_flush (ov, child, uuid);
+        if (overlay_mcast_child_one (ov, msg, uuid) < 0) {
             if (failures == 0)
                 first_errno = errno;
             failures++;
@@ -324,6 +1063,331 @@ int overlay_mcast_child (struct overlay *ov, const flux_msg_t *msg)
     return 0;
 }
 
+void overlay_mcast_skip (struct overlay *ov, uint32_t first, uint32_t last)
+{
+    const char *uuid;
+    child_t *child;
+
+    if (!ov->child || !ov->child->zs || first == 0 || first > last)
+        return;
+    evring_skip (ov->ring, first, last);
+    FOREACH_ZHASH (ov->children, uuid, child)
+        child_skip_add (ov, child, uuid, first, last);
+}
+
+void overlay_event_lost (struct overlay *ov, uint32_t first, uint32_t last)
+{
+    evring_lost (ov->ring, first, last);
+}
+
+int overlay_event_skip_decode (const flux_msg_t *msg,
+                               uint32_t *first,
+                               uint32_t *last)
+{
+    int type;
+    const char *topic;
+    int a, b;
+
+    if (flux_msg_get_type (msg, &type) < 0
+        || type != FLUX_MSGTYPE_KEEPALIVE
+        || flux_msg_get_topic (msg, &topic) < 0
+        || strcmp (topic, SKIP_TOPIC) != 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (flux_msg_unpack (msg, "{s:i s:i}", "first", &a, "last", &b) < 0)
+        return -1;
+    if (a < 1 || b < a) {
+        errno = EPROTO;
+        return -1;
+    }
+    *first = a;
+    *last = b;
+    return 0;
+}
+
+/* Compute the subscriptions of this broker's subtree.  A child that has
+ * not reported its subtree's subscriptions might want anything.
+ */
+static struct topicset *subtree_topics (struct overlay *ov)
+{
+    struct topicset *ts;
+    const char *uuid;
+    child_t *child;
+    int known = 0;
+
+    if (!(ts = topicset_create ()))
+        return NULL;
+    if (topicset_add_set (ts, ov->local_topics) < 0)
+        goto error;
+    FOREACH_ZHASH (ov->children, uuid, child) {
+        if (child->topics) {
+            if (topicset_add_set (ts, child->topics) < 0)
+                goto error;
+            known++;
+        }
+    }
+    if (known < topology_get_child_count (ov->topo, ov->rank)) {
+        if (topicset_add (ts, "") < 0)
+            goto error;
+    }
+    return ts;
+error:
+    topicset_destroy (ts);
+    return NULL;
+}
+
+static void advertise_continuation (flux_future_t *f, void *arg)
+{
+    struct overlay *ov = arg;
+    const flux_msg_t *request = flux_future_aux_get (f, "overlay::request");
+
+    if (flux_future_get (f, NULL) < 0) {
+        flux_log_error (ov->h, "overlay: error updating parent subscriptions");
+        topicset_destroy (ov->adv_topics); // resend on next update
+        ov->adv_topics = NULL;
+    }
+    if (request && flux_respond (ov->h, request, NULL) < 0)
+        flux_log_error (ov->h, "overlay: error responding to subscribe");
+    zlist_remove (ov->pending, f);
+    flux_future_destroy (f);
+}
+
+/* Send the subtree's subscriptions to the parent if they have changed.
+ * If 'request' is non-NULL, respond to it once the parent has any new
+ * subscriptions, so that matching events published after that are sure
+ * to be forwarded here.  On failure, the caller must respond to 'request'.
+ */
+static int advertise (struct overlay *ov, const flux_msg_t *request)
+{
+    struct topicset *ts = NULL;
+    json_t *topics = NULL;
+    flux_future_t *f = NULL;
+    int parent = topology_get_parent (ov->topo, ov->rank);
+    bool grew;
+
+    if (parent < 0 || !ov->parent || !ov->parent->zs || !ov->local_topics)
+        goto respond;
+    if (!(ts = subtree_topics (ov)))
+        return -1;
+    if (ov->adv_topics
+        && topicset_covers (ts, ov->adv_topics)
+        && topicset_covers (ov->adv_topics, ts)) {
+        topicset_destroy (ts);
+        goto respond;
+    }
+    grew = !ov->adv_topics || !topicset_covers (ov->adv_topics, ts);
+    if (!(topics = topicset_encode (ts)))
+        goto error;
+    if (!(f = flux_rpc_pack (ov->h,
+                             SUBSCRIBE_TOPIC,
+                             parent,
+                             0,
+                             "{s:i s:O}",
+                             "rank", (int)ov->rank,
+                             "topics", topics)))
+        goto error;
+    if (grew && request) {
+        if (flux_future_aux_set (f,
+                                 "overlay::request",
+                                 (void *)flux_msg_incref (request),
+                                 (flux_free_f)flux_msg_decref) < 0) {
+            flux_msg_decref (request);
+            goto error;
+        }
+        request = NULL;
+    }
+    if (flux_future_then (f, -1., advertise_continuation, ov) < 0
+        || zlist_append (ov->pending, f) < 0)
+        goto error;
+    topicset_destroy (ov->adv_topics);
+    ov->adv_topics = ts;
+    json_decref (topics);
+respond:
+    if (request && flux_respond (ov->h, request, NULL) < 0)
+        flux_log_error (ov->h, "overlay: error responding to subscribe");
+    return 0;
+error:
+    flux_future_destroy (f);
+    topicset_destroy (ts);
+    json_decref (topics);
+    return -1;
+}
+
+int overlay_set_subscriptions (struct overlay *ov,
+                               struct topicset *local,
+                               const flux_msg_t *request)
+{
+    if (!local) {
+        errno = EINVAL;
+        return -1;
+    }
+    topicset_destroy (ov->local_topics);
+    ov->local_topics = local;
+    return advertise (ov, request);
+}
+
+static void subscribe_cb (flux_t *h,
+                          flux_msg_handler_t *mh,
+                          const flux_msg_t *msg,
+                          void *arg)
+{
+    struct overlay *ov = arg;
+    int rank;
+    json_t *topics;
+    struct topicset *ts;
+    char uuid[16];
+    child_t *child;
+
+    if (flux_request_unpack (msg,
+                             NULL,
+                             "{s:i s:o}",
+                             "rank", &rank,
+                             "topics", &topics) < 0)
+        goto error;
+    snprintf (uuid, sizeof (uuid), "%d", rank);
+    if (!(child = zhash_lookup (ov->children, uuid))) {
+        errno = ENOENT;
+        goto error;
+    }
+    if (!(ts = topicset_decode (topics)))
+        goto error;
+    topicset_destroy (child->topics);
+    child->topics = ts;
+    if (advertise (ov, msg) < 0)
+        goto error;
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "error responding to overlay.event-subscribe");
+}
+
+struct replay_buf {
+    uint8_t *buf;
+    size_t len;
+    size_t alloc;
+    const struct topicset *topics;
+    int errnum;
+};
+
+static void replay_append (const flux_msg_t *msg, void *arg)
+{
+    struct replay_buf *rb = arg;
+    const char *topic;
+
+    if (rb->errnum != 0)
+        return;
+    if (rb->topics) {
+        if (flux_msg_get_topic (msg, &topic) < 0
+            || !topicset_match (rb->topics, topic))
+            return;
+    }
+    if (msgbuf_append (&rb->buf, &rb->len, &rb->alloc, msg) < 0)
+        rb->errnum = errno;
+}
+
+/* Respond with a one byte "history is complete" flag followed by the
+ * requested events that match the child's subscriptions, in order.
+ */
+static void replay_cb (flux_t *h,
+                       flux_msg_handler_t *mh,
+                       const flux_msg_t *msg,
+                       void *arg)
+{
+    struct overlay *ov = arg;
+    int rank, first, last;
+    char uuid[16];
+    child_t *child;
+    struct replay_buf rb = { 0 };
+    bool complete;
+
+    if (flux_request_unpack (msg,
+                             NULL,
+                             "{s:i s:i s:i}",
+                             "rank", &rank,
+                             "first", &first,
+                             "last", &last) < 0)
+        goto error;
+    if (first < 1 || last < first) {
+        errno = EPROTO;
+        goto error;
+    }
+    snprintf (uuid, sizeof (uuid), "%d", rank);
+    if ((child = zhash_lookup (ov->children, uuid)))
+        rb.topics = child->topics;
+    if (!(rb.buf = malloc (1)))
+        goto error;
+    rb.len = rb.alloc = 1;
+    complete = evring_replay (ov->ring, first, last, replay_append, &rb);
+    if (rb.errnum != 0) {
+        errno = rb.errnum;
+        goto error;
+    }
+    rb.buf[0] = complete ? 1 : 0;
+    if (flux_respond_raw (h, msg, rb.buf, rb.len) < 0)
+        flux_log_error (h, "error responding to overlay.event-replay");
+    free (rb.buf);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "error responding to overlay.event-replay");
+    free (rb.buf);
+}
+
+flux_future_t *overlay_event_replay (struct overlay *ov,
+                                     uint32_t first,
+                                     uint32_t last)
+{
+    int parent = topology_get_parent (ov->topo, ov->rank);
+
+    if (parent < 0 || first == 0 || last < first) {
+        errno = EINVAL;
+        return NULL;
+    }
+    return flux_rpc_pack (ov->h,
+                          REPLAY_TOPIC,
+                          parent,
+                          0,
+                          "{s:i s:i s:i}",
+                          "rank", (int)ov->rank,
+                          "first", (int)first,
+                          "last", (int)last);
+}
+
+struct replay_get_ctx {
+    overlay_replay_f cb;
+    void *arg;
+};
+
+static int replay_get_one (flux_msg_t *msg, void *arg)
+{
+    struct replay_get_ctx *ctx = arg;
+
+    ctx->cb (msg, ctx->arg);
+    return 0;
+}
+
+int overlay_event_replay_get (flux_future_t *f,
+                              bool *complete,
+                              overlay_replay_f cb,
+                              void *arg)
+{
+    struct replay_get_ctx ctx = { .cb = cb, .arg = arg };
+    const uint8_t *buf;
+    int size;
+
+    if (flux_rpc_get_raw (f, (const void **)&buf, &size) < 0)
+        return -1;
+    if (size < 1) {
+        errno = EPROTO;
+        return -1;
+    }
+    *complete = buf[0] ? true : false;
+    if (!cb)
+        return 0;
+    return msgbuf_decode (buf + 1, size - 1, replay_get_one, &ctx);
+}
+
 /* Handle notification of peer connect/disconnect on child monitor socket.
  * Maintain ov->child_peer_count, accessed via overlay_get_child_peer_count().
  * Call a callback, if any, when the count changes.
@@ -393,8 +1457,27 @@ static void child_cb (flux_reactor_t *r, flux_watcher_t *w,
 {
     void *zsock = flux_zmq_watcher_get_zsock (w);
     struct overlay *ov = arg;
-    if (ov->child_cb)
-        ov->child_cb (ov, zsock, ov->child_arg);
+    flux_msg_t *msg;
+    char *uuid = NULL;
+
+    if (!(msg = flux_msg_recvzsock (zsock)))
+        return;
+    if (flux_msg_get_route_last (msg, &uuid) < 0 || !uuid)
+        goto done;
+    if (is_batch (msg))
+        batch_unpack (ov, msg, uuid, ov->child_cb, ov->child_arg);
+    else if (is_compressed (msg))
+        compressed_unpack (ov, msg, uuid, ov->child_cb, ov->child_arg);
+    else {
+        size_t size = flux_msg_encode_size (msg);
+        flux_trace_record (msg, "overlay.rx");
+        if (ov->child_cb)
+            ov->child_cb (ov, msg, ov->child_arg);
+        account_rx (ov, uuid, size);
+    }
+done:
+    free (uuid);
+    flux_msg_destroy (msg);
 }
 
 /* Cleanup not done in this function, responsibiility of caller to
@@ -408,7 +1491,7 @@ static int bind_child (struct overlay *ov, struct endpoint *ep)
     if (child_monitor_init (ov, ep) < 0)
         return -1;
     zsock_set_router_mandatory (ep->zs, 1);
-    if (zsecurity_ssockinit (ov->sec, ep->zs) < 0) {
+    if (!ep->trusted && zsecurity_ssockinit (ov->sec, ep->zs) < 0) {
         log_msg ("zsecurity_ssockinit: %s", zsecurity_errstr (ov->sec));
         return -1;
     }
@@ -439,8 +1522,22 @@ static void parent_cb (flux_reactor_t *r, flux_watcher_t *w,
 {
     void *zsock = flux_zmq_watcher_get_zsock (w);
     struct overlay *ov = arg;
-    if (ov->parent_cb)
-        ov->parent_cb (ov, zsock, ov->parent_arg);
+    flux_msg_t *msg;
+
+    if (!(msg = flux_msg_recvzsock (zsock)))
+        return;
+    if (is_batch (msg))
+        batch_unpack (ov, msg, NULL, ov->parent_cb, ov->parent_arg);
+    else if (is_compressed (msg))
+        compressed_unpack (ov, msg, NULL, ov->parent_cb, ov->parent_arg);
+    else {
+        size_t size = flux_msg_encode_size (msg);
+        flux_trace_record (msg, "overlay.rx");
+        if (ov->parent_cb)
+            ov->parent_cb (ov, msg, ov->parent_arg);
+        account_rx (ov, NULL, size);
+    }
+    flux_msg_destroy (msg);
 }
 
 static int connect_parent (struct overlay *ov, struct endpoint *ep)
@@ -450,7 +1547,7 @@ static int connect_parent (struct overlay *ov, struct endpoint *ep)
 
     if (!(ep->zs = zsock_new_dealer (NULL)))
         goto error;
-    if (zsecurity_csockinit (ov->sec, ep->zs) < 0) {
+    if (!ep->trusted && zsecurity_csockinit (ov->sec, ep->zs) < 0) {
         savederr = errno;
         log_msg ("zsecurity_csockinit: %s", zsecurity_errstr (ov->sec));
         errno = savederr;
@@ -486,6 +1583,84 @@ static int overlay_sec_init (struct overlay *ov)
     return 0;
 }
 
+static void codecs_continuation (flux_future_t *f, void *arg)
+{
+    struct overlay *ov = arg;
+    json_t *codecs;
+
+    if (flux_rpc_get_unpack (f, "{s:o}", "codecs", &codecs) < 0
+        || compress_codecs_decode (codecs, &ov->parent_codecs) < 0)
+        flux_log_error (ov->h, "overlay: error exchanging codecs with parent");
+}
+
+/* Tell the parent which codecs this broker accepts, and learn which
+ * ones it accepts.
+ */
+static int codecs_hello (struct overlay *ov)
+{
+    int parent = topology_get_parent (ov->topo, ov->rank);
+    json_t *codecs;
+    flux_future_t *f;
+
+    if (parent < 0)
+        return 0;
+    if (!(codecs = compress_codecs_encode (compress_codecs ())))
+        return -1;
+    if (!(f = flux_rpc_pack (ov->h,
+                             CODECS_TOPIC,
+                             parent,
+                             0,
+                             "{s:i s:O}",
+                             "rank", (int)ov->rank,
+                             "codecs", codecs))
+        || flux_future_then (f, -1., codecs_continuation, ov) < 0) {
+        flux_future_destroy (f);
+        json_decref (codecs);
+        return -1;
+    }
+    json_decref (codecs);
+    flux_future_destroy (ov->codecs_f);
+    ov->codecs_f = f;
+    return 0;
+}
+
+static void codecs_cb (flux_t *h,
+                       flux_msg_handler_t *mh,
+                       const flux_msg_t *msg,
+                       void *arg)
+{
+    struct overlay *ov = arg;
+    int rank;
+    json_t *codecs;
+    json_t *mine = NULL;
+    char uuid[16];
+    child_t *child;
+
+    if (flux_request_unpack (msg,
+                             NULL,
+                             "{s:i s:o}",
+                             "rank", &rank,
+                             "codecs", &codecs) < 0)
+        goto error;
+    snprintf (uuid, sizeof (uuid), "%d", rank);
+    if (!(child = zhash_lookup (ov->children, uuid))) {
+        errno = ENOENT;
+        goto error;
+    }
+    if (compress_codecs_decode (codecs, &child->codecs) < 0)
+        goto error;
+    if (!(mine = compress_codecs_encode (compress_codecs ())))
+        goto error;
+    if (flux_respond_pack (h, msg, "{s:O}", "codecs", mine) < 0)
+        flux_log_error (h, "error responding to overlay.codecs");
+    json_decref (mine);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "error responding to overlay.codecs");
+    json_decref (mine);
+}
+
 int overlay_connect (struct overlay *ov)
 {
     int rc = -1;
@@ -501,6 +1676,10 @@ int overlay_connect (struct overlay *ov)
             log_err ("%s", ov->parent->uri);
             goto done;
         }
+        if (codecs_hello (ov) < 0) {
+            log_err ("overlay.codecs");
+            goto done;
+        }
     }
     rc = 0;
 done:
@@ -538,6 +1717,8 @@ static int overlay_attr_get_cb (const char *name, const char **val, void *arg)
 
     if (!strcmp (name, "tbon.parent-endpoint"))
         *val = overlay_get_parent (overlay);
+    else if (!strcmp (name, "tbon.compress-codec"))
+        *val = compress_codec_name (overlay->codec);
     else {
         errno = ENOENT;
         goto done;
@@ -547,6 +1728,21 @@ done:
     return rc;
 }
 
+static int overlay_attr_set_cb (const char *name, const char *val, void *arg)
+{
+    struct overlay *overlay = arg;
+    int codec;
+
+    if (!strcmp (name, "tbon.compress-codec")) {
+        if ((codec = compress_codec_parse (val)) < 0)
+            return -1;
+        overlay->codec = codec;
+        return 0;
+    }
+    errno = ENOENT;
+    return -1;
+}
+
 int overlay_register_attrs (struct overlay *overlay, attr_t *attrs)
 {
     if (attr_add_active (attrs, "tbon.parent-endpoint",
@@ -559,18 +1755,36 @@ int overlay_register_attrs (struct overlay *overlay, attr_t *attrs)
     if (attr_add_uint32 (attrs, "size", overlay->size,
                          FLUX_ATTRFLAG_IMMUTABLE) < 0)
         return -1;
-    if (attr_add_int (attrs, "tbon.arity", overlay->tbon_k,
+    if (attr_add_int (attrs, "tbon.arity",
+                      topology_get_arity (overlay->topo),
                       FLUX_ATTRFLAG_IMMUTABLE) < 0)
         return -1;
-    if (attr_add_int (attrs, "tbon.level", overlay->tbon_level,
+    if (attr_add_int (attrs, "tbon.level",
+                      topology_get_level (overlay->topo, overlay->rank),
                       FLUX_ATTRFLAG_IMMUTABLE) < 0)
         return -1;
-    if (attr_add_int (attrs, "tbon.maxlevel", overlay->tbon_maxlevel,
+    if (attr_add_int (attrs, "tbon.maxlevel",
+                      topology_get_maxlevel (overlay->topo),
                       FLUX_ATTRFLAG_IMMUTABLE) < 0)
         return -1;
-    if (attr_add_int (attrs, "tbon.descendants", overlay->tbon_descendants,
+    if (attr_add_int (attrs, "tbon.descendants",
+                      topology_get_descendants (overlay->topo, overlay->rank),
                       FLUX_ATTRFLAG_IMMUTABLE) < 0)
         return -1;
+    if (attr_add_active_uint32 (attrs, "tbon.batch-count",
+                                &overlay->batch_count, 0) < 0)
+        return -1;
+    if (attr_add_active_uint32 (attrs, "tbon.event-replay-size",
+                                &overlay->event_replay_size,
+                                FLUX_ATTRFLAG_IMMUTABLE) < 0)
+        return -1;
+    if (attr_add_active_uint32 (attrs, "tbon.compress-threshold",
+                                &overlay->compress_threshold, 0) < 0)
+        return -1;
+    if (attr_add_active (attrs, "tbon.compress-codec", 0,
+                         overlay_attr_get_cb, overlay_attr_set_cb,
+                         overlay) < 0)
+        return -1;
 
     return 0;
 }
@@ -597,6 +1811,14 @@ static json_t *lspeer_object_create (struct overlay *ov)
                                    "idle",
                                    ov->epoch - child->lastseen)))
             goto nomem;
+        if (child->rtt >= 0) {
+            json_t *rtt = json_real (child->rtt);
+            if (!rtt || json_object_set_new (child_o, "rtt", rtt) < 0) {
+                json_decref (rtt);
+                json_decref (child_o);
+                goto nomem;
+            }
+        }
         if (json_object_set_new (o, uuid, child_o) < 0) {
             json_decref (child_o);
             goto nomem;
@@ -631,10 +1853,131 @@ error:
         flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
 }
 
+static json_t *zstats_encode (struct zstats *zs)
+{
+    return json_pack ("{s:I s:I s:I s:f}",
+                      "count", (json_int_t)zs->count,
+                      "in", (json_int_t)zs->in,
+                      "out", (json_int_t)zs->out,
+                      "time", zs->time);
+}
+
+static json_t *peer_stats_encode (struct msgstats *ms,
+                                  struct batch *b,
+                                  struct zstats *zs)
+{
+    json_t *o;
+    json_t *compress;
+
+    if (!(compress = zstats_encode (zs)))
+        return NULL;
+    o = json_pack ("{s:{s:I s:I} s:{s:I s:I} s:i s:o}",
+                   "tx",
+                     "count", (json_int_t)ms->tx_count,
+                     "bytes", (json_int_t)ms->tx_bytes,
+                   "rx",
+                     "count", (json_int_t)ms->rx_count,
+                     "bytes", (json_int_t)ms->rx_bytes,
+                   "queued", b ? b->count : 0,
+                   "compress", compress);
+    return o;
+}
+
+json_t *overlay_get_stats (struct overlay *ov)
+{
+    json_t *o = NULL;
+    json_t *children;
+    json_t *peer;
+    const char *uuid;
+    child_t *child;
+
+    if (!(o = json_pack ("{s:s s:i s:{}}",
+                         "codec", compress_codec_name (ov->codec),
+                         "threshold", (int)ov->compress_threshold,
+                         "children")))
+        goto nomem;
+    if (ov->parent) {
+        if (!(peer = peer_stats_encode (&ov->parent_mstats,
+                                        ov->parent_batch,
+                                        &ov->parent_zstats))
+            || json_object_set_new (o, "parent", peer) < 0) {
+            json_decref (peer);
+            goto nomem;
+        }
+    }
+    children = json_object_get (o, "children");
+    FOREACH_ZHASH (ov->children, uuid, child) {
+        if (!(peer = peer_stats_encode (&child->mstats,
+                                        child->batch,
+                                        &child->zstats))
+            || json_object_set_new (children, uuid, peer) < 0) {
+            json_decref (peer);
+            goto nomem;
+        }
+    }
+    return o;
+nomem:
+    json_decref (o);
+    errno = ENOMEM;
+    return NULL;
+}
+
+void overlay_clear_stats (struct overlay *ov)
+{
+    const char *uuid;
+    child_t *child;
+
+    memset (&ov->parent_mstats, 0, sizeof (ov->parent_mstats));
+    memset (&ov->parent_zstats, 0, sizeof (ov->parent_zstats));
+    FOREACH_ZHASH (ov->children, uuid, child) {
+        memset (&child->mstats, 0, sizeof (child->mstats));
+        memset (&child->zstats, 0, sizeof (child->zstats));
+    }
+}
+
+/* Report traffic and compression statistics for each link, from this
+ * broker's end.
+ */
+static void stats_cb (flux_t *h,
+                      flux_msg_handler_t *mh,
+                      const flux_msg_t *msg,
+                      void *arg)
+{
+    struct overlay *ov = arg;
+    json_t *o;
+
+    if (flux_request_decode (msg, NULL, NULL) < 0)
+        goto error;
+    if (!(o = overlay_get_stats (ov)))
+        goto error;
+    if (flux_respond_pack (h, msg, "O", o) < 0)
+        flux_log_error (h, "%s: flux_respond", __FUNCTION__);
+    json_decref (o);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+}
+
 void overlay_destroy (struct overlay *ov)
 {
     if (ov) {
         int saved_errno = errno;
+        if (ov->batch_prep)
+            batch_prep_cb (NULL, ov->batch_prep, 0, ov); // flush
+        flux_watcher_destroy (ov->batch_prep);
+        batch_destroy (ov->parent_batch);
+        if (ov->pending) {
+            flux_future_t *f;
+            while ((f = zlist_pop (ov->pending)))
+                flux_future_destroy (f);
+            zlist_destroy (&ov->pending);
+        }
+        evring_destroy (ov->ring);
+        flux_future_destroy (ov->codecs_f);
+        compress_destroy (ov->compress);
+        topicset_destroy (ov->local_topics);
+        topicset_destroy (ov->adv_topics);
         if (ov->sec)
             zsecurity_destroy (ov->sec);
         if (ov->h)
@@ -647,6 +1990,7 @@ void overlay_destroy (struct overlay *ov)
         endpoint_destroy (ov->parent);
         endpoint_destroy (ov->child);
         zhash_destroy (&ov->children);
+        topology_destroy (ov->topo);
         free (ov);
         errno = saved_errno;
     }
@@ -655,6 +1999,10 @@ void overlay_destroy (struct overlay *ov)
 static const struct flux_msg_handler_spec htab[] = {
     { FLUX_MSGTYPE_EVENT,  "heartbeat", heartbeat_cb, 0 },
     { FLUX_MSGTYPE_REQUEST,  "overlay.lspeer", lspeer_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST,  SUBSCRIBE_TOPIC, subscribe_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST,  REPLAY_TOPIC, replay_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST,  CODECS_TOPIC, codecs_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST,  "overlay.stats", stats_cb, 0 },
     FLUX_MSGHANDLER_TABLE_END,
 };
 
@@ -667,10 +2015,14 @@ struct overlay *overlay_create (flux_t *h, int sec_typemask, const char *keydir)
     ov->rank = FLUX_NODEID_ANY;
     ov->parent_lastsent = -1;
     ov->h = h;
-    if (!(ov->children = zhash_new ())) {
+    ov->event_replay_size = EVENT_REPLAY_SIZE_DEFAULT;
+    ov->codec = COMPRESS_LZ4;
+    if (!(ov->children = zhash_new ()) || !(ov->pending = zlist_new ())) {
         errno = ENOMEM;
         goto error;
     }
+    if (!(ov->compress = compress_create ()))
+        goto error;
     if (!(ov->sec = zsecurity_create (sec_typemask, keydir)))
         goto error;
 
@@ -678,6 +2030,10 @@ struct overlay *overlay_create (flux_t *h, int sec_typemask, const char *keydir)
         goto error;
     if (flux_event_subscribe (ov->h, "hb") < 0)
         goto error;
+    if (!(ov->batch_prep = flux_prepare_watcher_create (flux_get_reactor (h),
+                                                        batch_prep_cb,
+                                                        ov)))
+        goto error;
 
     return ov;
 error:
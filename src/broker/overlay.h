@@ -11,12 +11,19 @@
 #ifndef _BROKER_OVERLAY_H
 #define _BROKER_OVERLAY_H
 
+#include <jansson.h>
+
 #include "attr.h"
 #include "src/common/libutil/zsecurity.h"
+#include "topology.h"
+#include "topicset.h"
 
 struct overlay;
 
-typedef void (*overlay_sock_cb_f)(struct overlay *ov, void *sock, void *arg);
+/* Receive callback.  The overlay retains ownership of 'msg', but the
+ * callback may modify it.
+ */
+typedef void (*overlay_recv_f)(struct overlay *ov, flux_msg_t *msg, void *arg);
 typedef int (*overlay_init_cb_f)(struct overlay *ov, void *arg);
 typedef void (*overlay_monitor_cb_f)(struct overlay *ov, void *arg);
 
@@ -32,25 +39,34 @@ void overlay_set_init_callback (struct overlay *ov,
                                 void *arg);
 
 /* These need to be called before connect/bind.
+ * overlay_init() takes ownership of 'topo', even on failure.
  */
 int overlay_init (struct overlay *ov,
-                  uint32_t size,
-                  uint32_t rank,
-                  int tbon_k);
+                  struct topology *topo,
+                  uint32_t rank);
 void overlay_set_idle_warning (struct overlay *ov, int heartbeats);
 
 /* Accessors
  */
 uint32_t overlay_get_rank (struct overlay *ov);
 uint32_t overlay_get_size (struct overlay *ov);
+struct topology *overlay_get_topology (struct overlay *ov);
 int overlay_get_child_peer_count (struct overlay *ov);
 
 /* All ranks but rank 0 connect to a parent to form the main TBON.
  */
 int overlay_set_parent (struct overlay *ov, const char *fmt, ...);
 const char *overlay_get_parent (struct overlay *ov);
+
+/* Skip zeromq security on the parent or child link, e.g. when it runs
+ * over a trusted network.  Call after overlay_set_parent() or
+ * overlay_set_child(), before the link is connected or bound.  Both ends
+ * of a link must agree, else the peers cannot communicate.
+ */
+int overlay_set_parent_trusted (struct overlay *ov);
+int overlay_set_child_trusted (struct overlay *ov);
 void overlay_set_parent_cb (struct overlay *ov,
-                            overlay_sock_cb_f cb,
+                            overlay_recv_f cb,
                             void *arg);
 int overlay_sendmsg_parent (struct overlay *ov, const flux_msg_t *msg);
 
@@ -59,13 +75,64 @@ int overlay_sendmsg_parent (struct overlay *ov, const flux_msg_t *msg);
  */
 int overlay_set_child (struct overlay *ov, const char *fmt, ...);
 const char *overlay_get_child (struct overlay *ov);
-void overlay_set_child_cb (struct overlay *ov, overlay_sock_cb_f cb, void *arg);
+void overlay_set_child_cb (struct overlay *ov, overlay_recv_f cb, void *arg);
 int overlay_sendmsg_child (struct overlay *ov, const flux_msg_t *msg);
 /* We can "multicast" events to all child peers using mcast_child().
  * It walks the 'children' hash, finding peers and routeing them a copy of msg.
+ * Children whose subtree has no matching subscription are not sent the
+ * event, but are told about it by a skip notice ahead of the next event.
+ * The event is also saved for replay to children that detect a gap.
  */
 int overlay_mcast_child (struct overlay *ov, const flux_msg_t *msg);
 
+/* Events [first, last] were not received by this broker because nothing
+ * in its subtree subscribed (skip), or could not be recovered (lost).
+ * Skips are passed on to children.
+ */
+void overlay_mcast_skip (struct overlay *ov, uint32_t first, uint32_t last);
+void overlay_event_lost (struct overlay *ov, uint32_t first, uint32_t last);
+
+/* Decode a skip notice received from the parent.
+ * Returns -1 if 'msg' is not a skip notice.
+ */
+int overlay_event_skip_decode (const flux_msg_t *msg,
+                               uint32_t *first,
+                               uint32_t *last);
+
+/* Set this broker's own event subscriptions (overlay takes ownership of
+ * 'local').  The union of these and the children's subscriptions is sent
+ * to the parent when it changes.  If 'request' is non-NULL, it is
+ * responded to once any new subscriptions are in effect upstream.
+ * On failure, the caller must respond to 'request'.
+ */
+int overlay_set_subscriptions (struct overlay *ov,
+                               struct topicset *local,
+                               const flux_msg_t *request);
+
+/* Ask the parent to replay events [first, last].  The response holds a
+ * flag that is true if the parent's history of the range is complete,
+ * i.e. any event not replayed was not wanted by this subtree, and the
+ * replayed events, which are passed in order to 'cb'.
+ */
+typedef void (*overlay_replay_f)(const flux_msg_t *msg, void *arg);
+flux_future_t *overlay_event_replay (struct overlay *ov,
+                                     uint32_t first,
+                                     uint32_t last);
+int overlay_event_replay_get (flux_future_t *f,
+                              bool *complete,
+                              overlay_replay_f cb,
+                              void *arg);
+
+/* Return per-peer traffic statistics: message counts and bytes sent and
+ * received, messages queued for batching, and compression:
+ *   {"codec":s, "threshold":i, "parent"?:{}, "children":{uuid:{}, ...}}
+ * where each peer is
+ *   {"tx":{"count":I, "bytes":I}, "rx":{...}, "queued":i,
+ *    "compress":{"count":I, "in":I, "out":I, "time":f}}
+ */
+json_t *overlay_get_stats (struct overlay *ov);
+void overlay_clear_stats (struct overlay *ov);
+
 /* Call when message is received from child 'uuid'.
  */
 void overlay_checkin_child (struct overlay *ov, const char *uuid);
@@ -94,6 +161,8 @@ int overlay_connect (struct overlay *ov);
  *   tbon.level
  *   tbon.maxlevel
  *   tbon.descendants
+ *   tbon.batch-count
+ *   tbon.event-replay-size
  * Returns 0 on success, -1 on error.
  */
 int overlay_register_attrs (struct overlay *overlay, attr_t *attrs);
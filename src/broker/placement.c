@@ -0,0 +1,319 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* placement.c - CPU and NUMA placement of module threads
+ *
+ * Node CPUs come from sysfs rather than hwloc, so the broker doesn't pay
+ * for a topology load on startup.  The memory policy is set with the raw
+ * set_mempolicy(2) system call to avoid a libnuma dependency.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+
+#include "src/common/libidset/idset.h"
+#include "src/common/libutil/read_all.h"
+#include "src/common/libutil/errno_safe.h"
+
+#include "placement.h"
+
+#define NODE_MASK_BITS 1024
+
+struct numa_node {
+    unsigned int id;
+    cpu_set_t cpus;
+};
+
+struct numa_map {
+    struct numa_node *nodes;
+    int count;
+};
+
+/* Read a sysfs file containing an idset, e.g. "0-3,8-11\n".
+ */
+static struct idset *read_idset (const char *path)
+{
+    int fd;
+    char *buf = NULL;
+    ssize_t len;
+    struct idset *ids;
+
+    if ((fd = open (path, O_RDONLY)) < 0)
+        return NULL;
+    len = read_all (fd, (void **)&buf);
+    ERRNO_SAFE_WRAP (close, fd);
+    if (len < 0)
+        return NULL;
+    while (len > 0 && (buf[len - 1] == '\n' || buf[len - 1] == ' '))
+        len--;
+    if (len == 0)
+        ids = idset_create (0, IDSET_FLAG_AUTOGROW);
+    else
+        ids = idset_ndecode (buf, len);
+    ERRNO_SAFE_WRAP (free, buf);
+    return ids;
+}
+
+static int idset_to_cpus (const struct idset *ids, cpu_set_t *cpus)
+{
+    unsigned int id;
+
+    CPU_ZERO (cpus);
+    id = idset_first (ids);
+    while (id != IDSET_INVALID_ID) {
+        if (id >= CPU_SETSIZE) {
+            errno = EINVAL;
+            return -1;
+        }
+        CPU_SET (id, cpus);
+        id = idset_next (ids, id);
+    }
+    return 0;
+}
+
+void numa_map_destroy (struct numa_map *map)
+{
+    if (map) {
+        int saved_errno = errno;
+        free (map->nodes);
+        free (map);
+        errno = saved_errno;
+    }
+}
+
+struct numa_map *numa_map_create (const char *path)
+{
+    struct numa_map *map;
+    struct idset *online;
+    char fpath[PATH_MAX];
+    unsigned int id;
+
+    if (!path)
+        path = "/sys/devices/system/node";
+    if (!(map = calloc (1, sizeof (*map))))
+        return NULL;
+    snprintf (fpath, sizeof (fpath), "%s/online", path);
+    if (!(online = read_idset (fpath))) {
+        if (errno == ENOENT)
+            return map;
+        goto error;
+    }
+    if (!(map->nodes = calloc (idset_count (online) + 1,
+                               sizeof (map->nodes[0]))))
+        goto error;
+    id = idset_first (online);
+    while (id != IDSET_INVALID_ID) {
+        struct numa_node *node = &map->nodes[map->count];
+        struct idset *cpus;
+        int rc;
+
+        snprintf (fpath, sizeof (fpath), "%s/node%u/cpulist", path, id);
+        if (!(cpus = read_idset (fpath)))
+            goto error;
+        rc = idset_to_cpus (cpus, &node->cpus);
+        idset_destroy (cpus);
+        if (rc < 0)
+            goto error;
+        node->id = id;
+        map->count++;
+        id = idset_next (online, id);
+    }
+    idset_destroy (online);
+    return map;
+error:
+    idset_destroy (online);
+    numa_map_destroy (map);
+    return NULL;
+}
+
+int numa_map_count (struct numa_map *map)
+{
+    return map ? map->count : 0;
+}
+
+static struct numa_node *numa_map_lookup (struct numa_map *map,
+                                          unsigned int id)
+{
+    int i;
+
+    for (i = 0; i < map->count; i++) {
+        if (map->nodes[i].id == id)
+            return &map->nodes[i];
+    }
+    return NULL;
+}
+
+char *numa_map_nodes (struct numa_map *map, const cpu_set_t *cpus)
+{
+    struct idset *ids;
+    char *s;
+    int i;
+
+    if (!map || !cpus) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(ids = idset_create (0, IDSET_FLAG_AUTOGROW)))
+        return NULL;
+    for (i = 0; i < map->count; i++) {
+        cpu_set_t both;
+
+        CPU_AND (&both, &map->nodes[i].cpus, cpus);
+        if (CPU_COUNT (&both) > 0 && idset_set (ids, map->nodes[i].id) < 0)
+            goto error;
+    }
+    s = idset_encode (ids, IDSET_FLAG_RANGE);
+    idset_destroy (ids);
+    return s;
+error:
+    ERRNO_SAFE_WRAP (idset_destroy, ids);
+    return NULL;
+}
+
+static int parse_numa (struct numa_map *map,
+                       const char *s,
+                       cpu_set_t *cpus,
+                       int *nodep)
+{
+    struct idset *ids;
+    unsigned int id;
+
+    if (!(ids = idset_decode (s)) || idset_count (ids) == 0) {
+        idset_destroy (ids);
+        errno = EINVAL;
+        return -1;
+    }
+    CPU_ZERO (cpus);
+    id = idset_first (ids);
+    while (id != IDSET_INVALID_ID) {
+        struct numa_node *node;
+
+        if (!map || !(node = numa_map_lookup (map, id))) {
+            idset_destroy (ids);
+            errno = ENOENT;
+            return -1;
+        }
+        CPU_OR (cpus, cpus, &node->cpus);
+        id = idset_next (ids, id);
+    }
+    *nodep = idset_count (ids) == 1 ? idset_first (ids) : -1;
+    idset_destroy (ids);
+    return 0;
+}
+
+static int parse_cpus (const char *s, cpu_set_t *cpus)
+{
+    struct idset *ids;
+    int rc;
+
+    if (!(ids = idset_decode (s)) || idset_count (ids) == 0) {
+        idset_destroy (ids);
+        errno = EINVAL;
+        return -1;
+    }
+    rc = idset_to_cpus (ids, cpus);
+    idset_destroy (ids);
+    return rc;
+}
+
+int placement_init (struct placement *pl,
+                    struct numa_map *map,
+                    const char *cpus,
+                    const char *numa)
+{
+    cpu_set_t set;
+
+    if (!pl) {
+        errno = EINVAL;
+        return -1;
+    }
+    CPU_ZERO (&pl->cpus);
+    pl->bind = false;
+    pl->node = -1;
+    if (cpus) {
+        if (parse_cpus (cpus, &pl->cpus) < 0)
+            return -1;
+        pl->bind = true;
+    }
+    if (numa) {
+        if (parse_numa (map, numa, &set, &pl->node) < 0)
+            return -1;
+        if (pl->bind)
+            CPU_AND (&pl->cpus, &pl->cpus, &set);
+        else
+            pl->cpus = set;
+        pl->bind = true;
+    }
+    if (pl->bind && CPU_COUNT (&pl->cpus) == 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    return 0;
+}
+
+int placement_set_mempolicy (const struct placement *pl)
+{
+    unsigned long mask[NODE_MASK_BITS / (8 * sizeof (unsigned long))];
+    int bits = 8 * sizeof (mask[0]);
+
+    if (!pl || pl->node >= NODE_MASK_BITS) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (pl->node < 0)
+        return 0;
+    memset (mask, 0, sizeof (mask));
+    mask[pl->node / bits] |= 1UL << (pl->node % bits);
+    /* N.B. the kernel reads 'maxnode - 1' bits of 'mask'.
+     */
+    if (syscall (SYS_set_mempolicy,
+                 MPOL_PREFERRED,
+                 mask,
+                 NODE_MASK_BITS + 1) < 0)
+        return -1;
+    return 0;
+}
+
+char *placement_encode_cpus (const cpu_set_t *cpus)
+{
+    struct idset *ids;
+    char *s;
+    int cpu;
+
+    if (!cpus) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(ids = idset_create (0, IDSET_FLAG_AUTOGROW)))
+        return NULL;
+    for (cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET (cpu, cpus) && idset_set (ids, cpu) < 0) {
+            ERRNO_SAFE_WRAP (idset_destroy, ids);
+            return NULL;
+        }
+    }
+    s = idset_encode (ids, IDSET_FLAG_RANGE);
+    ERRNO_SAFE_WRAP (idset_destroy, ids);
+    return s;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
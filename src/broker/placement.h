@@ -0,0 +1,75 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _BROKER_PLACEMENT_H
+#define _BROKER_PLACEMENT_H
+
+#include <sched.h>
+#include <stdbool.h>
+
+/* placement - CPU and NUMA placement of module threads
+ *
+ * A module thread may be restricted to a set of CPUs, to the CPUs of a
+ * set of NUMA nodes, or to the intersection of both.  When the thread is
+ * placed on a single NUMA node, its memory policy also prefers that node,
+ * so its heap stays local even if it is briefly run elsewhere.
+ */
+
+struct numa_map;
+
+struct placement {
+    cpu_set_t cpus;     // CPUs the thread may run on
+    bool bind;          // false = inherit the broker's affinity
+    int node;           // preferred NUMA node for allocations, or -1
+};
+
+/* Read the CPUs of each online NUMA node from 'path', normally
+ * /sys/devices/system/node (used if 'path' is NULL).  A system without
+ * that directory results in a map with no nodes, not an error.
+ */
+struct numa_map *numa_map_create (const char *path);
+void numa_map_destroy (struct numa_map *map);
+
+/* Return the number of nodes in 'map'.
+ */
+int numa_map_count (struct numa_map *map);
+
+/* Encode the set of nodes having at least one CPU in 'cpus',
+ * e.g. "0-1".  The caller must free the result.
+ */
+char *numa_map_nodes (struct numa_map *map, const cpu_set_t *cpus);
+
+/* Initialize 'pl' from idset strings 'cpus' and 'numa', either of
+ * which may be NULL.  If both are NULL, the placement is the default.
+ * Returns 0 on success, -1 with errno set:
+ * EINVAL - an idset could not be parsed, a CPU is out of range, or the
+ *          CPUs and nodes don't intersect
+ * ENOENT - a NUMA node is not in 'map'
+ */
+int placement_init (struct placement *pl,
+                    struct numa_map *map,
+                    const char *cpus,
+                    const char *numa);
+
+/* Apply the memory policy of 'pl' to the calling thread.
+ * This is a no-op if pl->node is -1.
+ */
+int placement_set_mempolicy (const struct placement *pl);
+
+/* Encode 'cpus' as an idset string, e.g. "0-3,8".
+ * The caller must free the result.
+ */
+char *placement_encode_cpus (const cpu_set_t *cpus);
+
+#endif /* !_BROKER_PLACEMENT_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
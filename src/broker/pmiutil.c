@@ -357,6 +357,8 @@ struct pmi_handle *broker_pmi_create (void)
                                                  getenv ("PMI_SIZE"),
                                                  NULL))) {
         pmi->mode = PMI_MODE_WIRE1;
+        (void)pmi_simple_client_set_kvsseg (pmi->cli,
+                                            getenv ("FLUX_PMI_KVSSEG"));
     }
     /* N.B. SLURM boldly installs its libpmi.so into the system libdir,
      * so it will be found here, even if not running in a SLURM job.
@@ -0,0 +1,178 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* profile.c - report reactor and message handler callback durations
+ *
+ * Request payload (optional):
+ *   {"enable"?:b, "clear"?:b}
+ *
+ * Response payload:
+ *   {"enabled":b,
+ *    "watchers":{name:stats, ...},
+ *    "request":{topic:stats, ...},
+ *    "response":{topic:stats, ...},
+ *    "event":{topic:stats, ...}}
+ *
+ * where stats is
+ *   {"count":i, "total":f, "max":f, "hist":[i, ...]}
+ * with durations in seconds and a log2 histogram of durations in
+ * microseconds, as described for flux_cbstats_t in reactor.h.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <errno.h>
+#include <jansson.h>
+#include <flux/core.h>
+
+#include "profile.h"
+
+struct profile_context {
+    flux_msg_handler_t *mh;
+};
+
+static void add_stats (const char *name,
+                       const flux_cbstats_t *stats,
+                       void *arg)
+{
+    json_t *obj = arg;
+    json_t *hist;
+    json_t *o;
+    int n;
+
+    /* Trim trailing empty buckets.
+     */
+    for (n = FLUX_CBSTATS_BUCKETS; n > 0; n--) {
+        if (stats->hist[n - 1] > 0)
+            break;
+    }
+    if (!(hist = json_array ()))
+        return;
+    for (int i = 0; i < n; i++) {
+        json_t *count = json_integer (stats->hist[i]);
+        if (!count || json_array_append_new (hist, count) < 0) {
+            json_decref (count);
+            json_decref (hist);
+            return;
+        }
+    }
+    if (!(o = json_pack ("{s:i s:f s:f s:o}",
+                         "count", stats->count,
+                         "total", stats->total,
+                         "max", stats->max,
+                         "hist", hist)))
+        return;
+    if (json_object_set_new (obj, name, o) < 0)
+        json_decref (o);
+}
+
+static json_t *msg_handler_stats (flux_t *h, int type)
+{
+    json_t *obj;
+
+    if (!(obj = json_object ()))
+        return NULL;
+    flux_msg_handler_profile_foreach (h, type, add_stats, obj);
+    return obj;
+}
+
+static void profile_request_cb (flux_t *h, flux_msg_handler_t *mh,
+                                const flux_msg_t *msg, void *arg)
+{
+    flux_reactor_t *r = flux_get_reactor (h);
+    int enable = -1;
+    int clear = 0;
+    json_t *watchers = NULL;
+    json_t *requests = NULL;
+    json_t *responses = NULL;
+    json_t *events = NULL;
+
+    if (flux_request_unpack (msg, NULL, "{s?b s?b}",
+                             "enable", &enable,
+                             "clear", &clear) < 0)
+        goto error;
+    if (clear)
+        profile_clear (h);
+    if (enable != -1)
+        flux_reactor_profile_enable (r, enable);
+    if (!(watchers = json_object ())
+        || !(requests = msg_handler_stats (h, FLUX_MSGTYPE_REQUEST))
+        || !(responses = msg_handler_stats (h, FLUX_MSGTYPE_RESPONSE))
+        || !(events = msg_handler_stats (h, FLUX_MSGTYPE_EVENT))) {
+        errno = ENOMEM;
+        goto error;
+    }
+    flux_reactor_profile_foreach (r, add_stats, watchers);
+    if (flux_respond_pack (h, msg, "{s:b s:O s:O s:O s:O}",
+                           "enabled", flux_reactor_profile_enabled (r),
+                           "watchers", watchers,
+                           "request", requests,
+                           "response", responses,
+                           "event", events) < 0)
+        flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
+    json_decref (watchers);
+    json_decref (requests);
+    json_decref (responses);
+    json_decref (events);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+    json_decref (watchers);
+    json_decref (requests);
+    json_decref (responses);
+    json_decref (events);
+}
+
+void profile_clear (flux_t *h)
+{
+    flux_reactor_profile_clear (flux_get_reactor (h));
+    flux_msg_handler_profile_clear (h);
+}
+
+static void profile_finalize (void *arg)
+{
+    struct profile_context *p = arg;
+    flux_msg_handler_stop (p->mh);
+    flux_msg_handler_destroy (p->mh);
+    free (p);
+}
+
+int profile_initialize (flux_t *h, const char *service)
+{
+    struct flux_match match = FLUX_MATCH_ANY;
+    struct profile_context *p = calloc (1, sizeof (*p));
+    if (!p) {
+        errno = ENOMEM;
+        goto error;
+    }
+    match.typemask = FLUX_MSGTYPE_REQUEST;
+    if (flux_match_asprintf (&match, "%s.profile", service) < 0) {
+        errno = ENOMEM;
+        goto error;
+    }
+    if (!(p->mh = flux_msg_handler_create (h, match, profile_request_cb, p)))
+        goto error;
+    flux_msg_handler_start (p->mh);
+    flux_aux_set (h, "flux::profile", p, profile_finalize);
+    flux_match_free (match);
+    flux_reactor_profile_enable (flux_get_reactor (h), true);
+    return 0;
+error:
+    if (p)
+        profile_finalize (p);
+    flux_match_free (match);
+    return -1;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
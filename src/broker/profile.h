@@ -0,0 +1,29 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef BROKER_PROFILE_H
+#define BROKER_PROFILE_H
+
+#include <flux/core.h>
+
+/* Enable reactor callback profiling on 'h' and register a
+ * <service>.profile method to query and control it.
+ */
+int profile_initialize (flux_t *h, const char *service);
+
+/* Reset profile data collected on 'h'.
+ */
+void profile_clear (flux_t *h);
+
+#endif /* BROKER_PROFILE_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -234,6 +234,12 @@ int flux_reduce_push (flux_reduce_t *r, void *item)
     return zlist_push (r->items, item);
 }
 
+void flux_reduce_flush (flux_reduce_t *r)
+{
+    if (r && !r->flushed)
+        flush_current (r);
+}
+
 int flux_reduce_opt_get (flux_reduce_t *r, int option, void *val, size_t size)
 {
     switch (option) {
@@ -50,6 +50,11 @@ void *flux_reduce_pop (flux_reduce_t *r);
 
 int flux_reduce_push (flux_reduce_t *r, void *item);
 
+/* Flush the current batch now, as if the hwm had been reached.
+ * Later items in the batch are flushed as they arrive.
+ */
+void flux_reduce_flush (flux_reduce_t *r);
+
 int flux_reduce_opt_get (flux_reduce_t *r, int option, void *val, size_t size);
 
 int flux_reduce_opt_set (flux_reduce_t *r, int option, void *val, size_t size);
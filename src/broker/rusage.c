@@ -13,6 +13,7 @@
 #endif
 #include <time.h>
 #include <sys/resource.h>
+#include <jansson.h>
 #include <flux/core.h>
 #include "rusage.h"
 
@@ -24,6 +25,8 @@ static void rusage_request_cb (flux_t *h, flux_msg_handler_t *mh,
                                const flux_msg_t *msg, void *arg)
 {
     struct rusage ru;
+    flux_msg_cachestats_t mcs;
+    flux_reactor_stats_t rs;
 
     if (flux_request_decode (msg, NULL, NULL) < 0) {
         flux_log_error (h, "%s: flux_request_decode", __FUNCTION__);
@@ -31,8 +34,12 @@ static void rusage_request_cb (flux_t *h, flux_msg_handler_t *mh,
     }
     if (getrusage (RUSAGE_THREAD, &ru) < 0)
         goto error;
+    flux_msg_get_cachestats (&mcs);
+    flux_reactor_get_stats (flux_get_reactor (h), &rs);
     if (flux_respond_pack (h, msg,
-            "{s:f s:f s:i s:i s:i s:i s:i s:i s:i s:i s:i s:i s:i s:i s:i s:i}",
+            "{s:f s:f s:i s:i s:i s:i s:i s:i s:i s:i s:i s:i s:i s:i s:i s:i"
+            " s:{s:I s:I s:i s:I s:I s:i}"
+            " s:{s:i s:i s:I}}",
             "utime", (double)ru.ru_utime.tv_sec + 1E-6 * ru.ru_utime.tv_usec,
             "stime", (double)ru.ru_stime.tv_sec + 1E-6 * ru.ru_stime.tv_usec,
             "maxrss", ru.ru_maxrss,
@@ -48,7 +55,18 @@ static void rusage_request_cb (flux_t *h, flux_msg_handler_t *mh,
             "msgrcv", ru.ru_msgrcv,
             "nsignals", ru.ru_nsignals,
             "nvcsw", ru.ru_nvcsw,
-            "nivcsw", ru.ru_nivcsw) < 0)
+            "nivcsw", ru.ru_nivcsw,
+            "msgcache",
+              "msg-alloc", (json_int_t)mcs.msg_alloc,
+              "msg-reuse", (json_int_t)mcs.msg_reuse,
+              "msg-cached", mcs.msg_cached,
+              "payload-alloc", (json_int_t)mcs.payload_alloc,
+              "payload-reuse", (json_int_t)mcs.payload_reuse,
+              "payload-cached", mcs.payload_cached,
+            "reactor",
+              "timers", rs.timers,
+              "coarse-timers", rs.coarse_timers,
+              "coarse-wakeups", (json_int_t)rs.coarse_wakeups) < 0)
         flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
     return;
 error:
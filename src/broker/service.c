@@ -15,17 +15,40 @@
 #include <flux/core.h>
 
 #include "src/common/libutil/log.h"
+#include "src/common/libflux/topic_private.h"
 
 #include "service.h"
 
+/* Requests are routed and counted by topic, up to this many distinct
+ * topics.  After that, requests for new topics are resolved by service
+ * name on each send, and counted as "<service>.*".
+ */
+#define ROUTES_MAX_TOPICS 1024
+
 struct service {
     service_send_f cb;
     void *cb_arg;
     char *uuid;
 };
 
+/* A route caches the service that a topic resolved to, so the common
+ * case of service_send() is one hash lookup, by interned topic if the
+ * message has one.  The service is valid only
+ * if 'generation' matches the switch's, which changes whenever a service
+ * is added or removed.  A NULL service caches a miss.
+ */
+struct route {
+    struct service *svc;
+    unsigned int generation;
+    uint64_t count;
+    uint64_t bytes;
+};
+
 struct service_switch {
     zhash_t *services;
+    zhash_t *routes;    /* struct route - by topic */
+    zhashx_t *routes_interned; /* struct route - by interned topic */
+    unsigned int generation;
 };
 
 struct service_switch *service_switch_create (void)
@@ -33,10 +56,18 @@ struct service_switch *service_switch_create (void)
     struct service_switch *sw = calloc (1, sizeof *sw);
     if (!sw)
         goto error;
-    if (!(sw->services = zhash_new ())) {
+    if (!(sw->services = zhash_new ())
+        || !(sw->routes = zhash_new ())
+        || !(sw->routes_interned = zhashx_new ())) {
         errno = ENOMEM;
         goto error;
     }
+    /* N.B. routes belong to sw->routes and keys to the topic intern table.
+     */
+    zhashx_set_key_destructor (sw->routes_interned, NULL);
+    zhashx_set_key_duplicator (sw->routes_interned, NULL);
+    zhashx_set_key_hasher (sw->routes_interned, flux_topic_hasher);
+    zhashx_set_key_comparator (sw->routes_interned, flux_topic_comparator);
     return sw;
 error:
     service_switch_destroy (sw);
@@ -47,6 +78,8 @@ void service_switch_destroy (struct service_switch *sw)
 {
     if (sw) {
         zhash_destroy (&sw->services);
+        zhashx_destroy (&sw->routes_interned);
+        zhash_destroy (&sw->routes);
         free (sw);
     }
 }
@@ -78,6 +111,7 @@ error:
 void service_remove (struct service_switch *sw, const char *name)
 {
     zhash_delete (sw->services, name);
+    sw->generation++;
 }
 
 const char *service_get_uuid (struct service_switch *sw, const char *name)
@@ -138,6 +172,7 @@ void service_remove_byuuid (struct service_switch *sw, const char *uuid)
         while ((key = zlist_pop (trash)))
             zhash_delete (sw->services, key);
         zlist_destroy (&trash);
+        sw->generation++;
     }
 }
 
@@ -162,6 +197,7 @@ int service_add (struct service_switch *sh, const char *name,
         goto error;
     }
     zhash_freefn (sh->services, name, (zhash_free_fn *)service_destroy);
+    sh->generation++;
     return 0;
 error:
     service_destroy (svc);
@@ -198,26 +234,156 @@ done:
     return svc;
 }
 
+static struct route *route_create (struct service_switch *sw,
+                                   const char *topic,
+                                   const struct flux_topic *interned)
+{
+    struct route *r;
+
+    if (!(r = calloc (1, sizeof (*r))))
+        return NULL;
+    r->generation = sw->generation - 1; // stale
+    if (zhash_insert (sw->routes, topic, r) < 0) {
+        free (r);
+        return NULL;
+    }
+    zhash_freefn (sw->routes, topic, free);
+    if (interned)
+        (void)zhashx_insert (sw->routes_interned, (void *)interned, r);
+    return r;
+}
+
+/* Find the existing route for 'topic', by interned topic if available.
+ */
+static struct route *route_find (struct service_switch *sw,
+                                 const char *topic,
+                                 const struct flux_topic *interned)
+{
+    struct route *r;
+
+    if (interned && (r = zhashx_lookup (sw->routes_interned, interned)))
+        return r;
+    if ((r = zhash_lookup (sw->routes, topic)) && interned)
+        (void)zhashx_insert (sw->routes_interned, (void *)interned, r);
+    return r;
+}
+
+/* Find the route for 'topic', resolving its service if the cached one
+ * is stale.  Returns NULL with errno = ENOSYS if no service matches.
+ * If the route table is full, the route returned is the overflow counter
+ * for the service, shared by all its topics past the limit.
+ */
+static struct route *route_lookup (struct service_switch *sw,
+                                   const char *topic,
+                                   const struct flux_topic *interned)
+{
+    struct route *r;
+    struct service *svc;
+    const char *p;
+    int length;
+    char key[128];
+
+    if ((r = route_find (sw, topic, interned))
+        && r->generation == sw->generation) {
+        if (!r->svc) {
+            errno = ENOSYS;
+            return NULL;
+        }
+        return r;
+    }
+    if ((p = strchr (topic, '.')))
+        length = p - topic;
+    else
+        length = strlen (topic);
+    if (!(svc = service_lookup_subtopic (sw, topic, length))
+        && errno != ENOSYS)
+        return NULL;
+    if (!r) {
+        if (zhash_size (sw->routes) >= ROUTES_MAX_TOPICS) {
+            if (!svc)
+                return NULL;
+            snprintf (key, sizeof (key), "%.*s.*", length, topic);
+            if (!(r = zhash_lookup (sw->routes, key)))
+                r = route_create (sw, key, NULL);
+        }
+        else
+            r = route_create (sw, topic, interned);
+        if (!r) {
+            errno = ENOMEM;
+            return NULL;
+        }
+    }
+    r->svc = svc;
+    r->generation = sw->generation;
+    if (!svc) {
+        errno = ENOSYS;
+        return NULL;
+    }
+    return r;
+}
+
+json_t *service_stats (struct service_switch *sw)
+{
+    json_t *o;
+    struct route *r;
+
+    if (!(o = json_object ()))
+        goto nomem;
+    r = zhash_first (sw->routes);
+    while (r) {
+        json_t *entry;
+        if (r->count > 0) {
+            if (!(entry = json_pack ("{s:I s:I}",
+                                     "count", (json_int_t)r->count,
+                                     "bytes", (json_int_t)r->bytes))
+                || json_object_set_new (o,
+                                        zhash_cursor (sw->routes),
+                                        entry) < 0) {
+                json_decref (entry);
+                goto nomem;
+            }
+        }
+        r = zhash_next (sw->routes);
+    }
+    return o;
+nomem:
+    json_decref (o);
+    errno = ENOMEM;
+    return NULL;
+}
+
+/* Zero the counters but keep the routes.
+ */
+void service_stats_clear (struct service_switch *sw)
+{
+    struct route *r;
+
+    r = zhash_first (sw->routes);
+    while (r) {
+        r->count = 0;
+        r->bytes = 0;
+        r = zhash_next (sw->routes);
+    }
+}
+
 /* Look up a service by first "word" of topic string.
  * If found, call the service's callback and return its return value.
  * If not found, return -1 with errno set (usually ENOSYS).
  */
 int service_send (struct service_switch *sw, const flux_msg_t *msg)
 {
-    const char *topic, *p;
-    int length;
-    struct service *svc;
+    const char *topic;
+    struct route *r;
 
     if (flux_msg_get_topic (msg, &topic) < 0)
         return -1;
-    if ((p = strchr (topic, '.')))
-        length = p - topic;
-    else
-        length = strlen (topic);
-    if (!(svc = service_lookup_subtopic (sw, topic, length)))
+    if (!(r = route_lookup (sw, topic, flux_msg_get_topic_interned (msg))))
         return -1;
+    r->count++;
+    r->bytes += flux_msg_encode_size (msg);
+    flux_trace_record (msg, "service");
 
-    return svc->cb (msg, svc->cb_arg);
+    return r->svc->cb (msg, r->svc->cb_arg);
 }
 
 /*
@@ -32,6 +32,12 @@ const char *service_get_uuid (struct service_switch *sw, const char *name);
 
 json_t *service_list_byuuid (struct service_switch *sw, const char *uuid);
 
+/* Return an object mapping request topics to the number of requests
+ * routed to a service and their total size, {"count":n, "bytes":n}.
+ */
+json_t *service_stats (struct service_switch *sw);
+void service_stats_clear (struct service_switch *sw);
+
 #endif /* !_BROKER_SERVICE_H */
 
 /*
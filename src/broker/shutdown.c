@@ -26,6 +26,11 @@
  * - when shutdown begins: !shutdown_is_complete() and !shutdown_is_expired()
  * - when shutdown completes: shutdown_is_compete() and !shutdown_is_expired()
  * - when shutdown expires: shutdown_is_expired()
+ *
+ * The time spent waiting for descendants is logged when shutdown completes,
+ * at LOG_INFO on rank 0 and LOG_DEBUG elsewhere.  Since every broker handles
+ * the event as soon as it arrives, leaves disconnect in parallel and the
+ * time at rank 0 is roughly one hop per TBON level.
  */
 
 #if HAVE_CONFIG_H
@@ -35,7 +40,6 @@
 #include <assert.h>
 #include <flux/core.h>
 
-#include "src/common/libutil/kary.h"
 
 #include "overlay.h"
 #include "shutdown.h"
@@ -47,6 +51,8 @@ struct shutdown {
     flux_msg_handler_t **handlers;
     flux_watcher_t *timer;
     double grace;
+    double t_begin;
+    int children;           // child peers at shutdown begin
     bool expired;
     bool complete;
 
@@ -58,12 +64,21 @@ static void shutdown_begin (struct shutdown *s)
 {
     assert (s->complete == false);
     assert (s->expired == false);
+    s->t_begin = flux_reactor_now (flux_get_reactor (s->h));
+    s->children = overlay_get_child_peer_count (s->overlay);
     if (s->cb)
         s->cb (s, s->arg);
 }
 
 static void shutdown_complete (struct shutdown *s)
 {
+    double t = flux_reactor_now (flux_get_reactor (s->h)) - s->t_begin;
+
+    flux_log (s->h,
+              overlay_get_rank (s->overlay) == 0 ? LOG_INFO : LOG_DEBUG,
+              "shutdown: %d children disconnected after %.3fs",
+              s->children,
+              t);
     s->complete = true;
     flux_watcher_stop (s->timer);
     overlay_set_monitor_cb (s->overlay, NULL, NULL);
@@ -178,8 +193,6 @@ static const struct flux_msg_handler_spec htab[] = {
 
 struct shutdown *shutdown_create (flux_t *h,
                                   double grace,
-                                  uint32_t size,
-                                  int tbon_k,
                                   struct overlay *overlay)
 {
     struct shutdown *s;
@@ -195,7 +208,8 @@ struct shutdown *shutdown_create (flux_t *h,
      * N.B. a size=1 instance has 1 level.
      */
     if (grace == 0) {
-        int levels = kary_levelof (tbon_k, size - 1) + 1;
+        struct topology *topo = overlay_get_topology (overlay);
+        int levels = topology_get_maxlevel (topo) + 1;
         s->grace = levels * 2; // e.g. 2s for size=1, 4s for size=3 k=2
     }
     else
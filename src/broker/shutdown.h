@@ -17,8 +17,6 @@ typedef void (*shutdown_cb_f) (struct shutdown *s, void *arg);
 
 struct shutdown *shutdown_create (flux_t *h,
                                   double grace,
-                                  uint32_t size,
-                                  int tbon_k,
                                   struct overlay *overlay);
 void shutdown_destroy (struct shutdown *s);
 
@@ -0,0 +1,342 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* stackprof.c - sampling profiler for broker threads
+ *
+ * While running, an ITIMER_PROF interval timer delivers SIGPROF at the
+ * requested frequency of CPU time consumed by the process.  The signal
+ * is taken by the thread that was running, and the handler records that
+ * thread's name and call stack in a preallocated sample buffer.  Module
+ * threads leave SIGPROF unblocked for this purpose, and are named after
+ * their module.  An idle broker consumes no CPU time, so it takes no
+ * samples.
+ *
+ * stackprof.get folds the samples into "thread;outer;...;inner" stacks
+ * with a count each, the input format of flame graph tools.  Frames are
+ * symbolized with dladdr(3), so functions not in a dynamic symbol table
+ * appear as "object+0xoffset", for offline symbolization.
+ *
+ * The handler is left installed after stop, so that a SIGPROF still
+ * pending does not terminate the broker.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <dlfcn.h>
+#include <libgen.h>
+#include <sys/time.h>
+#include <sys/prctl.h>
+#if HAVE_EXECINFO_H
+#include <execinfo.h>
+#endif
+#include <jansson.h>
+#include <flux/core.h>
+
+#include "stackprof.h"
+
+#define STACKPROF_MAX_DEPTH     32
+#define STACKPROF_SKIP_FRAMES   2   /* handler and signal trampoline */
+
+static const int default_frequency = 99;
+static const int max_frequency = 1000;
+static const int default_max_samples = 10000;
+
+struct sample {
+    volatile int ready;
+    char comm[16];
+    int depth;
+    void *pc[STACKPROF_MAX_DEPTH];
+};
+
+static struct {
+    struct sample *samples;
+    int max_samples;
+    volatile int count;         /* slots claimed, may exceed max_samples */
+    volatile sig_atomic_t running;
+    bool installed;
+    int frequency;
+} prof;
+
+static flux_msg_handler_t **handlers = NULL;
+
+#if HAVE_EXECINFO_H
+static void sigprof_handler (int signum)
+{
+    int saved_errno = errno;
+    struct sample *s;
+    int i;
+
+    if (!prof.running)
+        goto done;
+    if ((i = __sync_fetch_and_add (&prof.count, 1)) >= prof.max_samples)
+        goto done;
+    s = &prof.samples[i];
+    if (prctl (PR_GET_NAME, s->comm, 0, 0, 0) < 0)
+        s->comm[0] = '\0';
+    s->depth = backtrace (s->pc, STACKPROF_MAX_DEPTH);
+    __sync_synchronize ();
+    s->ready = 1;
+done:
+    errno = saved_errno;
+}
+
+static int timer_set (int frequency)
+{
+    struct itimerval it;
+
+    memset (&it, 0, sizeof (it));
+    /* setitimer() rejects tv_usec >= 1s, so frequency=1 uses tv_sec.
+     */
+    if (frequency == 1)
+        it.it_interval.tv_sec = 1;
+    else if (frequency > 1)
+        it.it_interval.tv_usec = 1000000 / frequency;
+    it.it_value = it.it_interval;
+    return setitimer (ITIMER_PROF, &it, NULL);
+}
+
+static int stackprof_start (int frequency, int max_samples)
+{
+    struct sample *samples;
+    void *pc[1];
+
+    if (!prof.installed) {
+        struct sigaction sa;
+
+        /* backtrace() may load libgcc on first use, which is not
+         * safe in a signal handler, so call it once here.
+         */
+        (void)backtrace (pc, 1);
+        memset (&sa, 0, sizeof (sa));
+        sa.sa_handler = sigprof_handler;
+        sa.sa_flags = SA_RESTART;
+        sigemptyset (&sa.sa_mask);
+        if (sigaction (SIGPROF, &sa, NULL) < 0)
+            return -1;
+        prof.installed = true;
+    }
+    if (!(samples = calloc (max_samples, sizeof (samples[0]))))
+        return -1;
+    free (prof.samples);
+    prof.samples = samples;
+    prof.max_samples = max_samples;
+    prof.count = 0;
+    prof.frequency = frequency;
+    prof.running = 1;
+    if (timer_set (frequency) < 0) {
+        prof.running = 0;
+        return -1;
+    }
+    return 0;
+}
+
+static int stackprof_stop (void)
+{
+    if (timer_set (0) < 0)
+        return -1;
+    prof.running = 0;
+    return 0;
+}
+#endif /* HAVE_EXECINFO_H */
+
+/* Append the name of the frame at 'pc' to 's', freeing 's'.
+ */
+static char *frame_append (char *s, void *pc)
+{
+    Dl_info info;
+    char *ns;
+    int rc;
+
+    if (!dladdr (pc, &info))
+        rc = asprintf (&ns, "%s;%p", s, pc);
+    else if (info.dli_sname)
+        rc = asprintf (&ns, "%s;%s", s, info.dli_sname);
+    else {
+        char *fname = strdup (info.dli_fname);
+        rc = asprintf (&ns, "%s;%s+0x%lx",
+                       s,
+                       fname ? basename (fname) : "?",
+                       (unsigned long)((char *)pc - (char *)info.dli_fbase));
+        free (fname);
+    }
+    free (s);
+    return rc < 0 ? NULL : ns;
+}
+
+static int stack_add (json_t *stacks, struct sample *s)
+{
+    char *key;
+    json_t *o;
+    int i;
+
+    if (!(key = strdup (s->comm[0] ? s->comm : "?")))
+        return -1;
+    for (i = s->depth - 1; i >= STACKPROF_SKIP_FRAMES; i--) {
+        if (!(key = frame_append (key, s->pc[i])))
+            return -1;
+    }
+    if ((o = json_object_get (stacks, key)))
+        json_integer_set (o, json_integer_value (o) + 1);
+    else if (json_object_set_new (stacks, key, json_integer (1)) < 0) {
+        free (key);
+        return -1;
+    }
+    free (key);
+    return 0;
+}
+
+static json_t *stackprof_fold (int *samples, int *dropped)
+{
+    json_t *stacks;
+    int count = prof.count;
+    int i;
+
+    if (!(stacks = json_object ()))
+        return NULL;
+    *samples = 0;
+    *dropped = 0;
+    if (count > prof.max_samples) {
+        *dropped = count - prof.max_samples;
+        count = prof.max_samples;
+    }
+    for (i = 0; i < count; i++) {
+        struct sample *s = &prof.samples[i];
+        if (!s->ready)
+            continue;
+        __sync_synchronize ();
+        if (stack_add (stacks, s) < 0) {
+            json_decref (stacks);
+            return NULL;
+        }
+        (*samples)++;
+    }
+    return stacks;
+}
+
+static void start_cb (flux_t *h, flux_msg_handler_t *mh,
+                      const flux_msg_t *msg, void *arg)
+{
+    int frequency = default_frequency;
+    int max_samples = default_max_samples;
+
+    if (flux_request_unpack (msg, NULL, "{s?i s?i}",
+                             "frequency", &frequency,
+                             "max-samples", &max_samples) < 0)
+        goto error;
+    if (frequency < 1 || frequency > max_frequency || max_samples < 1) {
+        errno = EINVAL;
+        goto error;
+    }
+#if HAVE_EXECINFO_H
+    if (prof.running) {
+        errno = EEXIST;
+        goto error;
+    }
+    if (stackprof_start (frequency, max_samples) < 0)
+        goto error;
+#else
+    errno = ENOSYS;
+    goto error;
+#endif
+    if (flux_respond (h, msg, NULL) < 0)
+        FLUX_LOG_ERROR (h);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        FLUX_LOG_ERROR (h);
+}
+
+static void stop_cb (flux_t *h, flux_msg_handler_t *mh,
+                     const flux_msg_t *msg, void *arg)
+{
+    if (flux_request_decode (msg, NULL, NULL) < 0)
+        goto error;
+#if HAVE_EXECINFO_H
+    if (!prof.running) {
+        errno = EINVAL;
+        goto error;
+    }
+    if (stackprof_stop () < 0)
+        goto error;
+#else
+    errno = ENOSYS;
+    goto error;
+#endif
+    if (flux_respond (h, msg, NULL) < 0)
+        FLUX_LOG_ERROR (h);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        FLUX_LOG_ERROR (h);
+}
+
+static void get_cb (flux_t *h, flux_msg_handler_t *mh,
+                    const flux_msg_t *msg, void *arg)
+{
+    json_t *stacks;
+    int samples, dropped;
+
+    if (flux_request_decode (msg, NULL, NULL) < 0)
+        goto error;
+    if (!prof.samples) {
+        errno = ENOENT;
+        goto error;
+    }
+    if (!(stacks = stackprof_fold (&samples, &dropped))) {
+        errno = ENOMEM;
+        goto error;
+    }
+    if (flux_respond_pack (h, msg, "{s:b s:i s:i s:i s:o}",
+                           "running", prof.running ? 1 : 0,
+                           "frequency", prof.frequency,
+                           "samples", samples,
+                           "dropped", dropped,
+                           "stacks", stacks) < 0)
+        FLUX_LOG_ERROR (h);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        FLUX_LOG_ERROR (h);
+}
+
+static const struct flux_msg_handler_spec htab[] = {
+    { FLUX_MSGTYPE_REQUEST, "stackprof.start",  start_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST, "stackprof.stop",   stop_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST, "stackprof.get",    get_cb, 0 },
+    FLUX_MSGHANDLER_TABLE_END,
+};
+
+static void stackprof_finalize (void *arg)
+{
+#if HAVE_EXECINFO_H
+    if (prof.running)
+        (void)stackprof_stop ();
+#endif
+    flux_msg_handler_delvec (handlers);
+    handlers = NULL;
+}
+
+int stackprof_initialize (flux_t *h)
+{
+    char *dummy = "hello";
+    if (flux_msg_handler_addvec (h, htab, NULL, &handlers) < 0)
+        return -1;
+    flux_aux_set (h, "flux::stackprof", dummy, stackprof_finalize);
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
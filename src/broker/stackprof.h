@@ -0,0 +1,25 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef BROKER_STACKPROF_H
+#define BROKER_STACKPROF_H
+
+#include <flux/core.h>
+
+/* Register the stackprof.start, stackprof.stop, and stackprof.get
+ * services, a SIGPROF based sampling profiler of all broker threads.
+ */
+int stackprof_initialize (flux_t *h);
+
+#endif /* BROKER_STACKPROF_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -26,6 +26,7 @@
 struct state_machine {
     struct broker *ctx;
     broker_state_t state;
+    double t_state;         // time the current state was entered
 
     zlist_t *events;
     flux_watcher_t *prep;
@@ -163,12 +164,19 @@ static void process_event (struct state_machine *s, const char *event)
     next_state = state_next (s->state, event);
 
     if (next_state != s->state) {
+        double now = flux_reactor_now (flux_get_reactor (s->ctx->h));
+
+        /* Log time spent in the state being left, so a slow startup or
+         * shutdown can be attributed to rc1, rc2, cleanup, or rc3.
+         */
         flux_log (s->ctx->h,
-                  LOG_INFO, "%s: %s->%s",
+                  LOG_INFO, "%s: %s->%s %.3fs",
                   event,
                   statestr (s->state),
-                  statestr (next_state));
+                  statestr (next_state),
+                  now - s->t_state);
         s->state = next_state;
+        s->t_state = now;
         state_action (s, s->state);
     }
     else {
@@ -299,6 +307,7 @@ struct state_machine *state_machine_create (struct broker *ctx)
         return NULL;
     s->ctx = ctx;
     s->state = STATE_NONE;
+    s->t_state = flux_reactor_now (r);
     if (!(s->events = zlist_new ()))
         goto nomem;
     zlist_autofree (s->events);
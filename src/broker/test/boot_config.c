@@ -383,6 +383,124 @@ void test_empty_hosts (const char *dir)
     flux_conf_decref (cf);
 }
 
+void test_topology (const char *dir)
+{
+    char path[PATH_MAX + 1];
+    flux_conf_t *cf;
+    struct boot_conf conf;
+    json_t *hosts;
+    struct topology *topo;
+    const char *input = \
+"[bootstrap]\n" \
+"hosts = [\n" \
+"  { host=\"foo0\" },\n" \
+"  { host=\"foo[1-2]\", group=\"a\" },\n" \
+"  { host=\"foo[3-5]\", group=\"b\" },\n" \
+"]\n";
+
+    create_test_file (dir, "boot", path, sizeof (path), input);
+    if (!(cf = flux_conf_parse (dir, NULL)))
+        BAIL_OUT ("flux_conf_parse failed");
+    if (boot_config_parse (cf, &conf, &hosts) < 0)
+        BAIL_OUT ("boot_config_parse unexpectedly failed");
+
+    topo = boot_config_topology (hosts, 2);
+    ok (topo != NULL && topology_get_size (topo) == 6,
+        "boot_config_topology works with grouped hosts");
+    ok (topology_get_parent (topo, 1) == 0
+        && topology_get_parent (topo, 2) == 1
+        && topology_get_parent (topo, 3) == 0
+        && topology_get_parent (topo, 4) == 3
+        && topology_get_parent (topo, 5) == 3,
+        "hosts are placed in subtrees by group");
+    topology_destroy (topo);
+
+    topo = boot_config_topology (NULL, 2);
+    ok (topo != NULL && topology_get_size (topo) == 1,
+        "boot_config_topology hosts=NULL is a size=1 topology");
+    topology_destroy (topo);
+
+    json_decref (hosts);
+    if (unlink (path) < 0)
+        BAIL_OUT ("could not cleanup test file %s", path);
+    flux_conf_decref (cf);
+}
+
+void test_bad_host_group (const char *dir)
+{
+    char path[PATH_MAX + 1];
+    flux_conf_t *cf;
+    struct boot_conf conf;
+    json_t *hosts;
+    const char *input = \
+"[bootstrap]\n" \
+"hosts = [\n" \
+"  { host=\"foo\", group=42 },\n" \
+"]\n";
+
+    create_test_file (dir, "boot", path, sizeof (path), input);
+    if (!(cf = flux_conf_parse (dir, NULL)))
+        BAIL_OUT ("flux_conf_parse failed");
+    if (boot_config_parse (cf, &conf, &hosts) < 0)
+        BAIL_OUT ("boot_config_parse unexpectedly failed");
+    ok (boot_config_topology (hosts, 2) == NULL,
+        "boot_config_topology failed on host entry with wrong group type");
+
+    json_decref (hosts);
+    if (unlink (path) < 0)
+        BAIL_OUT ("could not cleanup test file %s", path);
+    flux_conf_decref (cf);
+}
+
+void test_trusted (const char *dir)
+{
+    char path[PATH_MAX + 1];
+    flux_conf_t *cf;
+    struct boot_conf conf;
+    json_t *hosts;
+    bool trusted;
+    const char *input = \
+"[bootstrap]\n" \
+"hosts = [\n" \
+"  { host=\"foo0\" },\n" \
+"  { host=\"foo[1-2]\", trusted=true },\n" \
+"  { host=\"foo3\", trusted=false },\n" \
+"  { host=\"foo4\", trusted=\"yes\" },\n" \
+"]\n";
+
+    create_test_file (dir, "boot", path, sizeof (path), input);
+    if (!(cf = flux_conf_parse (dir, NULL)))
+        BAIL_OUT ("flux_conf_parse failed");
+    if (boot_config_parse (cf, &conf, &hosts) < 0)
+        BAIL_OUT ("boot_config_parse unexpectedly failed");
+
+    trusted = true;
+    ok (boot_config_gettrustedbyrank (hosts, 0, &trusted) == 0
+        && trusted == false,
+        "boot_config_gettrustedbyrank defaults to false");
+    trusted = false;
+    ok (boot_config_gettrustedbyrank (hosts, 1, &trusted) == 0
+        && trusted == true,
+        "boot_config_gettrustedbyrank rank 1 is trusted");
+    trusted = false;
+    ok (boot_config_gettrustedbyrank (hosts, 2, &trusted) == 0
+        && trusted == true,
+        "boot_config_gettrustedbyrank rank 2 is trusted (expanded)");
+    trusted = true;
+    ok (boot_config_gettrustedbyrank (hosts, 3, &trusted) == 0
+        && trusted == false,
+        "boot_config_gettrustedbyrank rank 3 trusted=false works");
+    ok (boot_config_gettrustedbyrank (hosts, 4, &trusted) < 0,
+        "boot_config_gettrustedbyrank fails on wrong trusted type");
+    ok (boot_config_gettrustedbyrank (hosts, 5, &trusted) < 0,
+        "boot_config_gettrustedbyrank fails on unknown rank");
+
+    json_decref (hosts);
+    if (unlink (path) < 0)
+        BAIL_OUT ("could not cleanup test file %s", path);
+    flux_conf_decref (cf);
+}
+
 void test_format (void)
 {
     char buf[MAX_URI + 1];
@@ -451,6 +569,9 @@ int main (int argc, char **argv)
     test_empty_hosts (dir);
     test_missing_info (dir);
     test_toml_mixed_array (dir);
+    test_topology (dir);
+    test_bad_host_group (dir);
+    test_trusted (dir);
 
     if (rmdir (dir) < 0)
         BAIL_OUT ("could not cleanup test dir %s", dir);
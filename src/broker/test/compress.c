@@ -0,0 +1,122 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <jansson.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/broker/compress.h"
+
+static char data[65536];
+
+void test_roundtrip (struct compress *c, int codec)
+{
+    const char *name = compress_codec_name (codec);
+    static char out[sizeof (data)];
+    const void *zbuf;
+    size_t zlen;
+    char *cpy;
+
+    ok (compress_encode (c, codec, data, sizeof (data), &zbuf, &zlen) == 0,
+        "%s: compress_encode works", name);
+    ok (zlen < sizeof (data),
+        "%s: compressed %zu bytes to %zu", name, sizeof (data), zlen);
+    if (!(cpy = malloc (zlen)))
+        BAIL_OUT ("malloc failed");
+    memcpy (cpy, zbuf, zlen);
+    memset (out, 0, sizeof (out));
+    ok (compress_decode (c, codec, cpy, zlen, out, sizeof (out)) == 0
+        && !memcmp (out, data, sizeof (data)),
+        "%s: compress_decode restores the data", name);
+    errno = 0;
+    ok (compress_decode (c, codec, cpy, zlen, out, sizeof (out) - 1) < 0
+        && errno == EPROTO,
+        "%s: compress_decode with wrong size fails with EPROTO", name);
+    memset (cpy, 0xff, zlen);
+    errno = 0;
+    ok (compress_decode (c, codec, cpy, zlen, out, sizeof (out)) < 0
+        && errno == EPROTO,
+        "%s: compress_decode of corrupt data fails with EPROTO", name);
+    free (cpy);
+}
+
+void test_codecs (void)
+{
+    json_t *o;
+    int mask;
+
+    ok ((compress_codecs () & COMPRESS_LZ4),
+        "lz4 is always supported");
+    ok (compress_codec_parse ("lz4") == COMPRESS_LZ4,
+        "compress_codec_parse lz4 works");
+    errno = 0;
+    ok (compress_codec_parse ("gzip") < 0 && errno == EINVAL,
+        "compress_codec_parse of unknown codec fails with EINVAL");
+    errno = 0;
+    ok (compress_codec_parse (NULL) < 0 && errno == EINVAL,
+        "compress_codec_parse NULL fails with EINVAL");
+    ok (!strcmp (compress_codec_name (COMPRESS_ZSTD), "zstd")
+        && !strcmp (compress_codec_name (0), "unknown"),
+        "compress_codec_name works");
+
+    ok ((o = compress_codecs_encode (COMPRESS_LZ4 | COMPRESS_ZSTD)) != NULL
+        && json_array_size (o) == 2,
+        "compress_codecs_encode works");
+    ok (compress_codecs_decode (o, &mask) == 0
+        && mask == (COMPRESS_LZ4 | COMPRESS_ZSTD),
+        "compress_codecs_decode works");
+    json_decref (o);
+
+    o = json_pack ("[ss]", "lz4", "gzip");
+    ok (compress_codecs_decode (o, &mask) == 0 && mask == COMPRESS_LZ4,
+        "compress_codecs_decode ignores unknown codecs");
+    json_decref (o);
+    o = json_pack ("[i]", 1);
+    errno = 0;
+    ok (compress_codecs_decode (o, &mask) < 0 && errno == EPROTO,
+        "compress_codecs_decode with non-string fails with EPROTO");
+    json_decref (o);
+}
+
+int main (int argc, char *argv[])
+{
+    struct compress *c;
+    int i;
+
+    plan (NO_PLAN);
+
+    for (i = 0; i < sizeof (data); i++)
+        data[i] = "flux"[i % 4] + (i / 256) % 3;
+
+    ok ((c = compress_create ()) != NULL,
+        "compress_create works");
+    test_codecs ();
+    test_roundtrip (c, COMPRESS_LZ4);
+    if ((compress_codecs () & COMPRESS_ZSTD))
+        test_roundtrip (c, COMPRESS_ZSTD);
+    errno = 0;
+    ok (compress_encode (c, 0, data, 1, NULL, NULL) < 0 && errno == EINVAL,
+        "compress_encode with bad args fails with EINVAL");
+    lives_ok ({compress_destroy (NULL);},
+        "compress_destroy NULL doesnt crash");
+    compress_destroy (c);
+
+    done_testing ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
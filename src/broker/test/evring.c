@@ -0,0 +1,133 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <errno.h>
+#include <flux/core.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/broker/evring.h"
+
+static flux_msg_t *event (uint32_t seq)
+{
+    flux_msg_t *msg;
+
+    if (!(msg = flux_event_encode ("test", NULL))
+        || flux_msg_set_seq (msg, seq) < 0)
+        BAIL_OUT ("failed to create event");
+    return msg;
+}
+
+static void append (struct evring *ring, uint32_t seq)
+{
+    flux_msg_t *msg = event (seq);
+
+    if (evring_append (ring, msg) < 0)
+        BAIL_OUT ("evring_append %u failed", seq);
+    flux_msg_decref (msg);
+}
+
+static void count_cb (const flux_msg_t *msg, void *arg)
+{
+    uint32_t seq;
+    uint32_t *p = arg;
+
+    if (flux_msg_get_seq (msg, &seq) < 0)
+        BAIL_OUT ("flux_msg_get_seq failed");
+    if (seq > p[1])
+        p[1] = seq;
+    p[0]++;
+}
+
+void test_basic (void)
+{
+    struct evring *ring;
+    uint32_t n[2];
+    flux_msg_t *msg;
+
+    ok ((ring = evring_create (4)) != NULL,
+        "evring_create size=4 works");
+    ok (!evring_replay (ring, 1, 1, NULL, NULL),
+        "empty ring history is incomplete");
+
+    append (ring, 1);
+    append (ring, 2);
+    evring_skip (ring, 3, 5);
+    append (ring, 6);
+    ok (evring_count (ring) == 3,
+        "ring holds 3 events");
+    n[0] = n[1] = 0;
+    ok (evring_replay (ring, 2, 6, count_cb, n) == true,
+        "evring_replay 2-6 is complete");
+    ok (n[0] == 2 && n[1] == 6,
+        "replayed events 2 and 6");
+
+    msg = event (6);
+    errno = 0;
+    ok (evring_append (ring, msg) < 0 && errno == EINVAL,
+        "evring_append of old sequence number fails with EINVAL");
+    flux_msg_decref (msg);
+
+    append (ring, 7);
+    append (ring, 8);
+    ok (evring_count (ring) == 4,
+        "ring is full");
+    ok (!evring_replay (ring, 1, 8, NULL, NULL),
+        "evicted event makes history of 1-8 incomplete");
+    ok (evring_replay (ring, 2, 8, NULL, NULL),
+        "history of 2-8 is still complete");
+
+    evring_lost (ring, 9, 10);
+    append (ring, 11);
+    ok (!evring_replay (ring, 8, 11, NULL, NULL),
+        "lost events make history incomplete");
+    n[0] = n[1] = 0;
+    ok (evring_replay (ring, 11, 11, count_cb, n) && n[0] == 1,
+        "history after lost events is complete");
+
+    append (ring, 13);
+    ok (!evring_replay (ring, 12, 13, NULL, NULL),
+        "unaccounted gap makes history incomplete");
+
+    evring_destroy (ring);
+}
+
+void test_badargs (void)
+{
+    errno = 0;
+    ok (evring_create (0) == NULL && errno == EINVAL,
+        "evring_create size=0 fails with EINVAL");
+    errno = 0;
+    ok (evring_append (NULL, NULL) < 0 && errno == EINVAL,
+        "evring_append ring=NULL fails with EINVAL");
+    ok (!evring_replay (NULL, 1, 1, NULL, NULL) && evring_count (NULL) == 0,
+        "NULL ring has no history");
+    lives_ok ({evring_skip (NULL, 1, 1);
+               evring_lost (NULL, 1, 1);
+               evring_destroy (NULL);},
+        "evring_skip/lost/destroy ring=NULL doesnt crash");
+}
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    test_basic ();
+    test_badargs ();
+
+    done_testing ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,278 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <errno.h>
+#include <string.h>
+#include <pthread.h>
+#include <flux/core.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/broker/interthread.h"
+
+#define NPINGS 10000
+#define NEVENTS 10000
+
+void test_basic (void)
+{
+    flux_t *h1, *h2;
+    flux_msg_t *msg;
+    flux_msg_t *rmsg;
+    const char *topic;
+    const void *buf, *rbuf;
+    int size, rsize;
+
+    ok (interthread_create (&h1, &h2) == 0,
+        "interthread_create works");
+    ok (flux_pollfd (h1) >= 0 && flux_pollfd (h2) >= 0,
+        "both handles have a pollfd");
+    ok (flux_pollevents (h1) == FLUX_POLLOUT,
+        "h1 pollevents is FLUX_POLLOUT");
+
+    if (!(msg = flux_request_encode ("foo.bar", NULL)))
+        BAIL_OUT ("flux_request_encode failed");
+    ok (flux_send (h2, msg, 0) == 0,
+        "flux_send on h2 works");
+    ok (flux_msg_set_topic (msg, "foo.baz") == 0,
+        "sender modified its message after sending");
+    flux_msg_destroy (msg);
+    ok ((flux_pollevents (h1) & FLUX_POLLIN),
+        "h1 pollevents is FLUX_POLLIN");
+    rmsg = flux_recv (h1, FLUX_MATCH_ANY, FLUX_O_NONBLOCK);
+    ok (rmsg != NULL
+        && flux_msg_get_topic (rmsg, &topic) == 0
+        && !strcmp (topic, "foo.bar"),
+        "flux_recv on h1 got the original message");
+    flux_msg_destroy (rmsg);
+    ok (flux_pollevents (h1) == FLUX_POLLOUT,
+        "h1 pollevents is FLUX_POLLOUT again");
+    errno = 0;
+    ok (flux_recv (h1, FLUX_MATCH_ANY, FLUX_O_NONBLOCK) == NULL
+        && errno == EWOULDBLOCK,
+        "flux_recv FLUX_O_NONBLOCK on empty h1 fails with EWOULDBLOCK");
+
+    if (!(msg = flux_event_encode ("foo.payload", "{}")))
+        BAIL_OUT ("flux_event_encode failed");
+    if (flux_send (h1, msg, 0) < 0)
+        BAIL_OUT ("flux_send failed");
+    rmsg = flux_recv (h2, FLUX_MATCH_EVENT, 0);
+    ok (rmsg != NULL
+        && flux_msg_get_payload (msg, &buf, &size) == 0
+        && flux_msg_get_payload (rmsg, &rbuf, &rsize) == 0
+        && size == rsize
+        && !memcmp (buf, rbuf, size)
+        && buf != rbuf,
+        "flux_recv on h2 got a copy of the payload, not a shared one");
+    flux_msg_destroy (rmsg);
+    flux_msg_destroy (msg);
+
+    if (!(msg = flux_event_encode ("foo.event", NULL)))
+        BAIL_OUT ("flux_event_encode failed");
+    ok (flux_send (h1, msg, 0) == 0 && flux_send (h1, msg, 0) == 0,
+        "flux_send on h1 works twice");
+    flux_msg_destroy (msg);
+    ok ((flux_pollevents (h2) & FLUX_POLLIN),
+        "h2 pollevents is FLUX_POLLIN");
+    rmsg = flux_recv (h2, FLUX_MATCH_EVENT, 0);
+    ok (rmsg != NULL
+        && flux_msg_get_topic (rmsg, &topic) == 0
+        && !strcmp (topic, "foo.event"),
+        "flux_recv on h2 got the first event");
+    flux_msg_destroy (rmsg);
+    ok ((flux_pollevents (h2) & FLUX_POLLIN),
+        "h2 pollevents is still FLUX_POLLIN");
+
+    ok (flux_event_subscribe (h1, "foo") == 0,
+        "flux_event_subscribe on h1 is a no-op");
+
+    /* Leave the second event queued on h2 and a request on h1.
+     */
+    if (!(msg = flux_request_encode ("foo.unread", NULL)))
+        BAIL_OUT ("flux_request_encode failed");
+    if (flux_send (h2, msg, 0) < 0)
+        BAIL_OUT ("flux_send failed");
+    flux_msg_destroy (msg);
+    flux_close (h2);
+    flux_close (h1);
+    diag ("destroyed handles with unread messages");
+
+    errno = 0;
+    ok (interthread_create (NULL, &h2) < 0 && errno == EINVAL,
+        "interthread_create h1=NULL fails with EINVAL");
+    errno = 0;
+    ok (interthread_create (&h1, NULL) < 0 && errno == EINVAL,
+        "interthread_create h2=NULL fails with EINVAL");
+}
+
+/* Echo each request back as a response until "ping.stop" is received,
+ * using blocking receive.  Subscribe first, so the main thread can test
+ * the cmb.sub request.
+ */
+static void *echo_thread (void *arg)
+{
+    flux_t *h = arg;
+    flux_msg_t *msg;
+    const char *topic;
+
+    if (flux_event_subscribe (h, "foo") < 0)
+        diag ("flux_event_subscribe: %s", strerror (errno));
+    while ((msg = flux_recv (h, FLUX_MATCH_REQUEST, 0))) {
+        if (flux_msg_get_topic (msg, &topic) < 0
+            || flux_respond (h, msg, NULL) < 0) {
+            flux_msg_destroy (msg);
+            break;
+        }
+        if (!strcmp (topic, "ping.stop")) {
+            flux_msg_destroy (msg);
+            break;
+        }
+        flux_msg_destroy (msg);
+    }
+    return NULL;
+}
+
+void test_threads (void)
+{
+    flux_t *h1, *h2;
+    pthread_t t;
+    flux_msg_t *msg;
+    const char *topic;
+    const char *s;
+    int i;
+    int count = 0;
+
+    if (interthread_create (&h1, &h2) < 0)
+        BAIL_OUT ("interthread_create failed");
+    if (pthread_create (&t, NULL, echo_thread, h2) != 0)
+        BAIL_OUT ("pthread_create failed");
+
+    msg = flux_recv (h1, FLUX_MATCH_REQUEST, 0);
+    ok (msg != NULL
+        && flux_request_unpack (msg, &topic, "{s:s}", "topic", &s) == 0
+        && !strcmp (topic, "cmb.sub")
+        && !strcmp (s, "foo"),
+        "flux_event_subscribe on h2 sent cmb.sub request to h1");
+    ok (flux_respond (h1, msg, NULL) == 0,
+        "responded to cmb.sub");
+    flux_msg_destroy (msg);
+
+    for (i = 0; i < NPINGS; i++) {
+        if (!(msg = flux_request_encode (i < NPINGS - 1 ? "ping.ping"
+                                                        : "ping.stop",
+                                         NULL)))
+            BAIL_OUT ("flux_request_encode failed");
+        if (flux_send (h1, msg, 0) < 0)
+            BAIL_OUT ("flux_send failed");
+        flux_msg_destroy (msg);
+    }
+    while (count < NPINGS
+           && (msg = flux_recv (h1, FLUX_MATCH_RESPONSE, 0))) {
+        count++;
+        flux_msg_destroy (msg);
+    }
+    ok (count == NPINGS,
+        "received %d responses from thread", NPINGS);
+    pthread_join (t, NULL);
+
+    flux_close (h1);
+    flux_close (h2);
+}
+
+struct unpack_ctx {
+    flux_t *h;
+    int count;
+};
+
+/* Unpack each event until "ev.stop" is received, counting events whose
+ * payload decoded to the expected value.
+ */
+static void *unpack_thread (void *arg)
+{
+    struct unpack_ctx *ctx = arg;
+    flux_msg_t *msg;
+    const char *topic;
+    int seq;
+
+    while ((msg = flux_recv (ctx->h, FLUX_MATCH_EVENT, 0))) {
+        if (flux_event_unpack (msg, &topic, "{s:i}", "seq", &seq) < 0) {
+            flux_msg_destroy (msg);
+            break;
+        }
+        if (seq == ctx->count)
+            ctx->count++;
+        if (!strcmp (topic, "ev.stop")) {
+            flux_msg_destroy (msg);
+            break;
+        }
+        flux_msg_destroy (msg);
+    }
+    return NULL;
+}
+
+/* Send each event to two threads, as the broker does when it multicasts
+ * an event to modules, while the sender also decodes it.  Each thread
+ * must get its own payload, or they would race on the cached JSON.
+ */
+void test_shared_event (void)
+{
+    flux_t *h1[2], *h2[2];
+    pthread_t t[2];
+    struct unpack_ctx ctx[2];
+    flux_msg_t *msg;
+    int i, j;
+
+    for (j = 0; j < 2; j++) {
+        if (interthread_create (&h1[j], &h2[j]) < 0)
+            BAIL_OUT ("interthread_create failed");
+        ctx[j].h = h2[j];
+        ctx[j].count = 0;
+        if (pthread_create (&t[j], NULL, unpack_thread, &ctx[j]) != 0)
+            BAIL_OUT ("pthread_create failed");
+    }
+    for (i = 0; i < NEVENTS; i++) {
+        int seq;
+        if (!(msg = flux_event_pack (i < NEVENTS - 1 ? "ev.ev" : "ev.stop",
+                                     "{s:i}",
+                                     "seq", i)))
+            BAIL_OUT ("flux_event_pack failed");
+        for (j = 0; j < 2; j++) {
+            if (flux_send (h1[j], msg, 0) < 0)
+                BAIL_OUT ("flux_send failed");
+        }
+        if (flux_event_unpack (msg, NULL, "{s:i}", "seq", &seq) < 0)
+            BAIL_OUT ("flux_event_unpack failed");
+        flux_msg_destroy (msg);
+    }
+    for (j = 0; j < 2; j++) {
+        pthread_join (t[j], NULL);
+        ok (ctx[j].count == NEVENTS,
+            "thread %d unpacked %d shared events", j, NEVENTS);
+        flux_close (h1[j]);
+        flux_close (h2[j]);
+    }
+}
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    test_basic ();
+    test_threads ();
+    test_shared_event ();
+
+    done_testing ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
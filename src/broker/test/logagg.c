@@ -0,0 +1,190 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <errno.h>
+#include <string.h>
+#include <syslog.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/common/libutil/stdlog.h"
+#include "src/broker/logagg.h"
+
+#define MAX_OUTPUT 16
+
+static char output[MAX_OUTPUT][1024];
+static int output_count;
+
+static void output_cb (const char *buf, int len, void *arg)
+{
+    if (output_count < MAX_OUTPUT)
+        snprintf (output[output_count], sizeof (output[0]), "%.*s", len, buf);
+    output_count++;
+}
+
+static void append (struct logagg *agg,
+                    const char *rank,
+                    const char *sd,
+                    const char *msg,
+                    double now)
+{
+    struct stdlog_header hdr;
+    char buf[1024];
+    int len;
+
+    stdlog_init (&hdr);
+    hdr.hostname = (char *)rank;
+    hdr.appname = "test";
+    len = stdlog_encode (buf, sizeof (buf), &hdr, sd, msg);
+    if (logagg_append (agg, buf, len, now) < 0)
+        BAIL_OUT ("logagg_append failed");
+}
+
+/* Check that output[i] is a repeated message with 'count' and 'ranks'.
+ */
+static bool check_repeat (int i,
+                          const char *appname,
+                          const char *msg,
+                          int count,
+                          const char *ranks)
+{
+    struct stdlog_header hdr;
+    const char *sd, *m, *r;
+    int sdlen, mlen, rlen, n;
+
+    if (i >= output_count)
+        return false;
+    stdlog_init (&hdr);
+    if (stdlog_decode (output[i], strlen (output[i]),
+                       &hdr, &sd, &sdlen, &m, &mlen) < 0
+        || stdlog_repeat_decode (sd, sdlen, &n, &r, &rlen) < 0)
+        return false;
+    diag ("%s", output[i]);
+    return !strcmp (hdr.appname, appname)
+        && mlen == strlen (msg) && !strncmp (m, msg, mlen)
+        && n == count
+        && rlen == strlen (ranks) && !strncmp (r, ranks, rlen);
+}
+
+void test_fold (void)
+{
+    struct logagg *agg;
+
+    if (!(agg = logagg_create (output_cb, NULL)))
+        BAIL_OUT ("logagg_create failed");
+    output_count = 0;
+    ok (logagg_pending (agg) == false,
+        "new logagg has nothing pending");
+
+    append (agg, "1", STDLOG_NILVALUE, "hello", 0.);
+    ok (output_count == 1 && strstr (output[0], "hello") != NULL,
+        "first occurrence is output immediately");
+    ok (logagg_pending (agg) == true,
+        "logagg_pending is true");
+    append (agg, "2", STDLOG_NILVALUE, "hello", 0.);
+    append (agg, "3", STDLOG_NILVALUE, "hello", 0.);
+    append (agg, "4", "[flux@0 count=\"5\" ranks=\"4-8\"]", "hello", 0.);
+    append (agg, "1", STDLOG_NILVALUE, "world", 0.);
+    ok (output_count == 2 && strstr (output[1], "world") != NULL,
+        "repeated occurrences were folded, new message was output");
+
+    ok (logagg_flush (agg) == 1,
+        "logagg_flush output one message");
+    ok (check_repeat (2, "test", "hello", 7, "2-8"),
+        "folded message has merged count and ranks");
+    ok (logagg_pending (agg) == false,
+        "logagg_pending is false after flush");
+
+    append (agg, "2", STDLOG_NILVALUE, "hello", 0.);
+    ok (output_count == 4,
+        "first occurrence in a new window is output immediately");
+
+    output_count = 0;
+    append (agg, "x", STDLOG_NILVALUE, "hello", 0.);
+    append (agg, "x", STDLOG_NILVALUE, "hello", 0.);
+    ok (output_count == 2,
+        "message with non-numeric hostname is passed through");
+    ok (logagg_append (agg, "foo", 3, 0.) == 0 && output_count == 3,
+        "undecodable message is passed through");
+    append (agg, "1", "[foo@0 x=\"1\"]", "hello", 0.);
+    append (agg, "1", "[foo@0 x=\"1\"]", "hello", 0.);
+    ok (output_count == 5,
+        "message with foreign structured data is passed through");
+
+    logagg_destroy (agg);
+}
+
+void test_rate (void)
+{
+    struct logagg *agg;
+
+    if (!(agg = logagg_create (output_cb, NULL)))
+        BAIL_OUT ("logagg_create failed");
+    logagg_set_rate (agg, 2);
+    output_count = 0;
+
+    append (agg, "1", STDLOG_NILVALUE, "a", 0.);
+    append (agg, "1", STDLOG_NILVALUE, "b", 0.);
+    append (agg, "1", STDLOG_NILVALUE, "c", 0.);
+    append (agg, "2", STDLOG_NILVALUE, "d", 0.);
+    ok (output_count == 3,
+        "message exceeding the rate limit of its rank was dropped");
+    append (agg, "1", STDLOG_NILVALUE, "a", 0.);
+    ok (output_count == 3,
+        "repeated message is folded, not rate limited");
+
+    ok (logagg_flush (agg) == 2,
+        "logagg_flush output two messages");
+    ok (check_repeat (3, "test", "a", 1, "1")
+        || check_repeat (4, "test", "a", 1, "1"),
+        "folded message was output");
+    ok (check_repeat (4, "broker", "log messages dropped by rate limit", 1, "1")
+        || check_repeat (3, "broker", "log messages dropped by rate limit",
+                         1, "1"),
+        "summary of dropped messages was output");
+
+    output_count = 0;
+    append (agg, "1", STDLOG_NILVALUE, "e", 0.5);
+    append (agg, "1", STDLOG_NILVALUE, "f", 0.5);
+    ok (output_count == 1,
+        "bucket refills at the configured rate");
+
+    logagg_set_rate (agg, 0);
+    output_count = 0;
+    append (agg, "1", STDLOG_NILVALUE, "g", 0.5);
+    append (agg, "1", STDLOG_NILVALUE, "h", 0.5);
+    append (agg, "1", STDLOG_NILVALUE, "i", 0.5);
+    ok (output_count == 3,
+        "rate of 0 disables rate limiting");
+
+    logagg_destroy (agg);
+}
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    test_fold ();
+    test_rate ();
+
+    lives_ok ({logagg_destroy (NULL);},
+        "logagg_destroy NULL doesn't crash");
+    ok (logagg_flush (NULL) == 0 && logagg_pending (NULL) == false,
+        "logagg_flush/pending NULL are no-ops");
+
+    done_testing ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,222 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <sys/param.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/broker/placement.h"
+
+/* Fake sysfs with two nodes: node0 has CPUs 0-3, node1 has CPUs 4-7.
+ */
+static char dir[PATH_MAX + 1];
+
+static void write_file (const char *name, const char *contents)
+{
+    char path[PATH_MAX + 1];
+    FILE *f;
+
+    if (snprintf (path, sizeof (path), "%s/%s", dir, name) >= sizeof (path))
+        BAIL_OUT ("snprintf overflow");
+    if (!(f = fopen (path, "w")))
+        BAIL_OUT ("fopen %s: %s", path, strerror (errno));
+    fputs (contents, f);
+    if (fclose (f) != 0)
+        BAIL_OUT ("fclose %s: %s", path, strerror (errno));
+}
+
+static void remove_file (const char *name)
+{
+    char path[PATH_MAX + 1];
+
+    if (snprintf (path, sizeof (path), "%s/%s", dir, name) >= sizeof (path))
+        BAIL_OUT ("snprintf overflow");
+    if (unlink (path) < 0 && rmdir (path) < 0)
+        BAIL_OUT ("remove %s: %s", path, strerror (errno));
+}
+
+static void create_sysfs (void)
+{
+    const char *tmpdir = getenv ("TMPDIR");
+    char path[PATH_MAX + 1];
+    int i;
+
+    if (snprintf (dir,
+                  sizeof (dir),
+                  "%s/node.XXXXXX",
+                  tmpdir ? tmpdir : "/tmp") >= sizeof (dir))
+        BAIL_OUT ("snprintf overflow");
+    if (!mkdtemp (dir))
+        BAIL_OUT ("mkdtemp %s: %s", dir, strerror (errno));
+    for (i = 0; i < 2; i++) {
+        if (snprintf (path, sizeof (path), "%s/node%d", dir, i)
+            >= sizeof (path))
+            BAIL_OUT ("snprintf overflow");
+        if (mkdir (path, 0700) < 0)
+            BAIL_OUT ("mkdir %s: %s", path, strerror (errno));
+    }
+    write_file ("online", "0-1\n");
+    write_file ("node0/cpulist", "0-3\n");
+    write_file ("node1/cpulist", "4-7\n");
+}
+
+static void destroy_sysfs (void)
+{
+    remove_file ("node1/cpulist");
+    remove_file ("node0/cpulist");
+    remove_file ("node1");
+    remove_file ("node0");
+    remove_file ("online");
+    if (rmdir (dir) < 0)
+        BAIL_OUT ("rmdir %s: %s", dir, strerror (errno));
+}
+
+static bool cpus_equal (const cpu_set_t *cpus, const char *s)
+{
+    char *encoded = placement_encode_cpus (cpus);
+    bool result = encoded && !strcmp (encoded, s);
+
+    if (encoded)
+        diag ("cpus=%s", encoded);
+    free (encoded);
+    return result;
+}
+
+void test_numa_map (void)
+{
+    struct numa_map *map;
+    cpu_set_t cpus;
+    char *s;
+
+    map = numa_map_create (dir);
+    ok (map != NULL,
+        "numa_map_create works");
+    ok (numa_map_count (map) == 2,
+        "map has two nodes");
+
+    CPU_ZERO (&cpus);
+    CPU_SET (2, &cpus);
+    s = numa_map_nodes (map, &cpus);
+    ok (s && !strcmp (s, "0"),
+        "numa_map_nodes cpus=2 returns 0");
+    free (s);
+    CPU_SET (5, &cpus);
+    s = numa_map_nodes (map, &cpus);
+    ok (s && !strcmp (s, "0-1"),
+        "numa_map_nodes cpus=2,5 returns 0-1");
+    free (s);
+
+    errno = 0;
+    ok (numa_map_nodes (NULL, &cpus) == NULL && errno == EINVAL,
+        "numa_map_nodes map=NULL fails with EINVAL");
+    ok (numa_map_count (NULL) == 0,
+        "numa_map_count map=NULL returns 0");
+    numa_map_destroy (map);
+
+    map = numa_map_create ("/noexist");
+    ok (map != NULL && numa_map_count (map) == 0,
+        "numa_map_create on missing directory returns empty map");
+    numa_map_destroy (map);
+    lives_ok ({numa_map_destroy (NULL);},
+        "numa_map_destroy map=NULL doesn't crash");
+}
+
+void test_placement (void)
+{
+    struct numa_map *map;
+    struct placement pl;
+
+    if (!(map = numa_map_create (dir)))
+        BAIL_OUT ("numa_map_create failed");
+
+    ok (placement_init (&pl, map, NULL, NULL) == 0
+        && pl.bind == false
+        && pl.node == -1,
+        "placement_init with no cpus or numa is the default");
+    ok (placement_set_mempolicy (&pl) == 0,
+        "placement_set_mempolicy with no node is a no-op");
+
+    ok (placement_init (&pl, map, "1,3", NULL) == 0
+        && pl.bind == true
+        && pl.node == -1
+        && cpus_equal (&pl.cpus, "1,3"),
+        "placement_init cpus=1,3 works");
+
+    ok (placement_init (&pl, map, NULL, "1") == 0
+        && pl.bind == true
+        && pl.node == 1
+        && cpus_equal (&pl.cpus, "4-7"),
+        "placement_init numa=1 binds to node 1 CPUs and prefers node 1");
+    ok (placement_init (&pl, map, NULL, "0-1") == 0
+        && pl.bind == true
+        && pl.node == -1
+        && cpus_equal (&pl.cpus, "0-7"),
+        "placement_init numa=0-1 binds to all CPUs with no preferred node");
+    ok (placement_init (&pl, map, "2-5", "1") == 0
+        && pl.node == 1
+        && cpus_equal (&pl.cpus, "4-5"),
+        "placement_init cpus=2-5 numa=1 binds to the intersection");
+
+    errno = 0;
+    ok (placement_init (&pl, map, "0-1", "1") < 0 && errno == EINVAL,
+        "placement_init with disjoint cpus and numa fails with EINVAL");
+    errno = 0;
+    ok (placement_init (&pl, map, "foo", NULL) < 0 && errno == EINVAL,
+        "placement_init cpus=foo fails with EINVAL");
+    errno = 0;
+    ok (placement_init (&pl, map, "", NULL) < 0 && errno == EINVAL,
+        "placement_init cpus=\"\" fails with EINVAL");
+    errno = 0;
+    ok (placement_init (&pl, map, "100000", NULL) < 0 && errno == EINVAL,
+        "placement_init with CPU beyond CPU_SETSIZE fails with EINVAL");
+    errno = 0;
+    ok (placement_init (&pl, map, NULL, "2") < 0 && errno == ENOENT,
+        "placement_init numa=2 fails with ENOENT");
+    errno = 0;
+    ok (placement_init (&pl, NULL, NULL, "0") < 0 && errno == ENOENT,
+        "placement_init numa=0 with no map fails with ENOENT");
+    errno = 0;
+    ok (placement_init (NULL, map, NULL, NULL) < 0 && errno == EINVAL,
+        "placement_init pl=NULL fails with EINVAL");
+
+    errno = 0;
+    ok (placement_set_mempolicy (NULL) < 0 && errno == EINVAL,
+        "placement_set_mempolicy pl=NULL fails with EINVAL");
+    errno = 0;
+    ok (placement_encode_cpus (NULL) == NULL && errno == EINVAL,
+        "placement_encode_cpus cpus=NULL fails with EINVAL");
+
+    numa_map_destroy (map);
+}
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    create_sysfs ();
+    test_numa_map ();
+    test_placement ();
+    destroy_sysfs ();
+
+    done_testing ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -351,6 +351,43 @@ void test_timed (flux_t *h)
     flux_reduce_destroy (r);
 }
 
+void test_flush (flux_t *h)
+{
+    flux_reduce_t *r;
+    int i, errors;
+
+    clear_counts ();
+
+    ok ((r = flux_reduce_create (h, reduce_ops, 10., NULL,
+                                 FLUX_REDUCE_TIMEDFLUSH)) != NULL,
+        "flush: flux_reduce_create works");
+    if (!r)
+        BAIL_OUT();
+    errors = 0;
+    for (i = 0; i < 10; i++) {
+        if (flux_reduce_append (r, xstrdup ("hi"), 0) < 0)
+            errors++;
+    }
+    ok (errors == 0 && sink_calls == 0,
+        "flush: flux_reduce_append added 10 items, none sinked");
+    flux_reduce_flush (r);
+    cmp_ok (sink_calls, "==", 1,
+        "flush: flux_reduce_flush sinked once");
+    cmp_ok (sink_items, "==", 10,
+        "flush: op.sink processed 10 items");
+
+    clear_counts ();
+    ok (flux_reduce_append (r, xstrdup ("hi"), 0) == 0,
+        "flush: flux_reduce_append added 1 more item");
+    cmp_ok (sink_calls, "==", 1,
+        "flush: later item was sinked immediately");
+    flux_reduce_flush (r);
+    cmp_ok (sink_calls, "==", 1,
+        "flush: flux_reduce_flush of flushed batch does nothing");
+
+    flux_reduce_destroy (r);
+}
+
 int main (int argc, char *argv[])
 {
     flux_t *h;
@@ -369,6 +406,7 @@ int main (int argc, char *argv[])
     test_nopolicy (h); // 6
     test_hwm (h); // 37
     test_timed(h); // 18
+    test_flush (h);
 
     flux_close (h);
     done_testing();
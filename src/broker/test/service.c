@@ -37,6 +37,73 @@ static int foo_cb (const flux_msg_t *msg, void *arg)
 }
 
 
+static int stats_count (json_t *o, const char *topic)
+{
+    int count;
+
+    if (json_unpack (o, "{s:{s:i}}", topic, "count", &count) < 0)
+        return -1;
+    return count;
+}
+
+void test_stats (void)
+{
+    struct service_switch *sw;
+    flux_msg_t *msg, *msg2, *msg3;
+    json_t *o;
+
+    if (!(sw = service_switch_create ()))
+        BAIL_OUT ("service_switch_create failed");
+    if (service_add (sw, "foo", NULL, foo_cb, NULL) < 0)
+        BAIL_OUT ("service_add failed");
+    if (!(msg = flux_request_encode ("foo.a", NULL))
+        || !(msg2 = flux_request_encode ("foo.b", "{}"))
+        || !(msg3 = flux_request_encode ("bar.a", NULL)))
+        BAIL_OUT ("flux_request_encode failed");
+    foo_cb_rc = 0;
+    (void)service_send (sw, msg);
+    (void)service_send (sw, msg);
+    (void)service_send (sw, msg2);
+    (void)service_send (sw, msg3);
+
+    ok ((o = service_stats (sw)) != NULL,
+        "service_stats works");
+    ok (json_object_size (o) == 2
+        && stats_count (o, "foo.a") == 2
+        && stats_count (o, "foo.b") == 1,
+        "requests are counted by topic");
+    ok (stats_count (o, "bar.a") < 0,
+        "requests to unknown services are not counted");
+    json_decref (o);
+
+    service_stats_clear (sw);
+    ok ((o = service_stats (sw)) != NULL && json_object_size (o) == 0,
+        "service_stats_clear works");
+    json_decref (o);
+
+    foo_cb_called = 0;
+    ok (service_send (sw, msg) == 0 && foo_cb_called == 1,
+        "cached route still works after service_stats_clear");
+    ok ((o = service_stats (sw)) != NULL && stats_count (o, "foo.a") == 1,
+        "and request count restarted");
+    json_decref (o);
+
+    if (service_add (sw, "bar", NULL, foo_cb, NULL) < 0)
+        BAIL_OUT ("service_add failed");
+    foo_cb_called = 0;
+    ok (service_send (sw, msg3) == 0 && foo_cb_called == 1,
+        "cached miss is invalidated by service_add");
+    service_remove (sw, "foo");
+    errno = 0;
+    ok (service_send (sw, msg) < 0 && errno == ENOSYS,
+        "cached route is invalidated by service_remove");
+
+    flux_msg_destroy (msg);
+    flux_msg_destroy (msg2);
+    flux_msg_destroy (msg3);
+    service_switch_destroy (sw);
+}
+
 int main (int argc, char **argv)
 {
     struct service_switch *sw;
@@ -138,6 +205,8 @@ int main (int argc, char **argv)
     flux_msg_destroy (msg2);
     flux_msg_destroy (msg3);
 
+    test_stats ();
+
     service_switch_destroy (sw);
 
     done_testing ();
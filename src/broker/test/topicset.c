@@ -0,0 +1,142 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <errno.h>
+#include <jansson.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/broker/topicset.h"
+
+void test_basic (void)
+{
+    struct topicset *ts;
+
+    ok ((ts = topicset_create ()) != NULL,
+        "topicset_create works");
+    ok (topicset_count (ts) == 0,
+        "new set is empty");
+    ok (!topicset_match (ts, "foo"),
+        "empty set matches nothing");
+
+    ok (topicset_add (ts, "foo.bar") == 1,
+        "topicset_add foo.bar returns 1");
+    ok (topicset_add (ts, "foo.bar.baz") == 0,
+        "topicset_add foo.bar.baz returns 0 (already matched)");
+    ok (topicset_add (ts, "hb") == 1,
+        "topicset_add hb returns 1");
+    ok (topicset_count (ts) == 2,
+        "set has 2 members");
+    ok (topicset_match (ts, "foo.bar.x") && topicset_match (ts, "hb"),
+        "set matches topics with a member prefix");
+    ok (!topicset_match (ts, "foo") && !topicset_match (ts, "h"),
+        "set does not match shorter topics");
+
+    ok (topicset_add (ts, "foo") == 1,
+        "topicset_add foo returns 1");
+    ok (topicset_count (ts) == 2,
+        "foo replaced foo.bar");
+    ok (topicset_add (ts, "") == 1 && topicset_count (ts) == 1,
+        "adding the empty prefix collapses the set");
+    ok (topicset_match (ts, "anything"),
+        "empty prefix matches everything");
+
+    topicset_destroy (ts);
+}
+
+void test_set (void)
+{
+    struct topicset *a, *b;
+
+    if (!(a = topicset_create ()) || !(b = topicset_create ()))
+        BAIL_OUT ("topicset_create failed");
+    if (topicset_add (a, "foo") < 0 || topicset_add (b, "foo.bar") < 0)
+        BAIL_OUT ("topicset_add failed");
+    ok (topicset_covers (a, b) && !topicset_covers (b, a),
+        "topicset_covers works");
+    ok (topicset_add_set (a, b) == 0,
+        "topicset_add_set of covered set returns 0");
+    if (topicset_add (b, "bar") < 0)
+        BAIL_OUT ("topicset_add failed");
+    ok (topicset_add_set (a, b) == 1
+        && topicset_count (a) == 2
+        && topicset_covers (a, b),
+        "topicset_add_set of new members returns 1");
+    topicset_destroy (a);
+    topicset_destroy (b);
+}
+
+void test_codec (void)
+{
+    struct topicset *ts, *ts2;
+    json_t *o;
+
+    if (!(ts = topicset_create ()))
+        BAIL_OUT ("topicset_create failed");
+    if (topicset_add (ts, "a") < 0 || topicset_add (ts, "b.c") < 0)
+        BAIL_OUT ("topicset_add failed");
+    ok ((o = topicset_encode (ts)) != NULL && json_array_size (o) == 2,
+        "topicset_encode works");
+    ok ((ts2 = topicset_decode (o)) != NULL
+        && topicset_covers (ts, ts2)
+        && topicset_covers (ts2, ts),
+        "topicset_decode returns an equal set");
+    json_decref (o);
+    topicset_destroy (ts2);
+
+    o = json_pack ("[si]", "a", 42);
+    errno = 0;
+    ok (topicset_decode (o) == NULL && errno == EPROTO,
+        "topicset_decode with non-string member fails with EPROTO");
+    json_decref (o);
+    o = json_object ();
+    errno = 0;
+    ok (topicset_decode (o) == NULL && errno == EPROTO,
+        "topicset_decode of non-array fails with EPROTO");
+    json_decref (o);
+
+    topicset_destroy (ts);
+}
+
+void test_badargs (void)
+{
+    errno = 0;
+    ok (topicset_add (NULL, "foo") < 0 && errno == EINVAL,
+        "topicset_add ts=NULL fails with EINVAL");
+    errno = 0;
+    ok (topicset_add_set (NULL, NULL) < 0 && errno == EINVAL,
+        "topicset_add_set ts=NULL fails with EINVAL");
+    errno = 0;
+    ok (topicset_encode (NULL) == NULL && errno == EINVAL,
+        "topicset_encode ts=NULL fails with EINVAL");
+    ok (!topicset_match (NULL, "foo") && topicset_count (NULL) == 0,
+        "NULL set is empty");
+    lives_ok ({topicset_destroy (NULL);},
+        "topicset_destroy ts=NULL doesnt crash");
+}
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    test_basic ();
+    test_set ();
+    test_codec ();
+    test_badargs ();
+
+    done_testing ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,199 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#include <errno.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "src/common/libutil/kary.h"
+#include "src/common/libtap/tap.h"
+#include "src/broker/topology.h"
+
+/* The default topology must agree with the libutil kary functions.
+ */
+void test_kary (uint32_t size, int k)
+{
+    struct topology *topo;
+    bool parent_ok = true;
+    bool child_ok = true;
+    bool level_ok = true;
+    bool desc_ok = true;
+    bool route_ok = true;
+    uint32_t i, j;
+
+    if (!(topo = topology_create (size, k)))
+        BAIL_OUT ("topology_create failed");
+    for (i = 0; i < size; i++) {
+        uint32_t p = kary_parentof (k, i);
+        if (topology_get_parent (topo, i) != (p == KARY_NONE ? -1 : (int)p))
+            parent_ok = false;
+        int nchild = 0;
+        while (nchild < k
+               && kary_childof (k, size, i, nchild) != KARY_NONE)
+            nchild++;
+        if (topology_has_child (topo, i)
+            != (kary_childof (k, size, i, 0) != KARY_NONE)
+            || topology_get_child_count (topo, i) != nchild)
+            child_ok = false;
+        if (topology_get_level (topo, i) != kary_levelof (k, i))
+            level_ok = false;
+        if (topology_get_descendants (topo, i)
+            != kary_sum_descendants (k, size, i))
+            desc_ok = false;
+        for (j = 0; j < size; j++) {
+            uint32_t r = kary_child_route (k, size, i, j);
+            if (topology_get_child_route (topo, i, j)
+                != (r == KARY_NONE ? -1 : (int)r))
+                route_ok = false;
+        }
+    }
+    ok (parent_ok, "size=%u k=%d: parents match kary", size, k);
+    ok (child_ok, "size=%u k=%d: has_child matches kary", size, k);
+    ok (level_ok, "size=%u k=%d: levels match kary", size, k);
+    ok (topology_get_maxlevel (topo) == kary_levelof (k, size - 1),
+        "size=%u k=%d: maxlevel matches kary", size, k);
+    ok (desc_ok, "size=%u k=%d: descendants match kary", size, k);
+    ok (route_ok, "size=%u k=%d: child routes match kary", size, k);
+    topology_destroy (topo);
+}
+
+void test_grouped (void)
+{
+    /* rack a: 0,1,2,3  rack b: 4,5,6,7  rack c: 8,9  rank 10: no group
+     */
+    const char *groups[] = { "a", "a", "a", "a",
+                             "b", "b", "b", "b",
+                             "c", "c",
+                             NULL };
+    struct topology *topo;
+    bool local_ok = true;
+    int i;
+
+    ok ((topo = topology_create_grouped (11, 2, groups)) != NULL,
+        "topology_create_grouped works");
+    ok (topology_get_parent (topo, 0) == -1,
+        "rank 0 is the root");
+    /* leaders 0,4,8,10 form a binary tree
+     */
+    ok (topology_get_parent (topo, 4) == 0
+        && topology_get_parent (topo, 8) == 0
+        && topology_get_parent (topo, 10) == 4,
+        "group leaders form a k-ary tree under rank 0");
+    for (i = 1; i < 10; i++) {
+        int p = topology_get_parent (topo, i);
+        if (i == 4 || i == 8)
+            continue;
+        if (p < 0 || groups[p] == NULL || strcmp (groups[p], groups[i]) != 0)
+            local_ok = false;
+    }
+    ok (local_ok, "group members have a parent in their group");
+    ok (topology_get_parent (topo, 5) == 4
+        && topology_get_parent (topo, 6) == 4
+        && topology_get_parent (topo, 7) == 5,
+        "group members form a k-ary tree under their leader");
+    ok (topology_get_parent (topo, 1) == 0
+        && topology_get_parent (topo, 2) == 0
+        && topology_get_parent (topo, 3) == 1,
+        "members of rank 0's group form a tree under rank 0");
+    ok (topology_get_descendants (topo, 0) == 10
+        && topology_get_descendants (topo, 4) == 4
+        && topology_get_descendants (topo, 8) == 1,
+        "descendants are counted across groups");
+    ok (topology_get_level (topo, 7) == 3
+        && topology_get_maxlevel (topo) == 3,
+        "levels are computed");
+    ok (topology_get_child_route (topo, 0, 7) == 4
+        && topology_get_child_route (topo, 4, 7) == 5
+        && topology_get_child_route (topo, 5, 7) == 7
+        && topology_get_child_route (topo, 8, 7) == -1
+        && topology_get_child_route (topo, 7, 7) == -1,
+        "child routes follow the grouped tree");
+    ok (topology_has_child (topo, 4)
+        && !topology_has_child (topo, 10),
+        "topology_has_child works");
+    topology_destroy (topo);
+}
+
+void test_grouped_one (void)
+{
+    const char *groups[] = { "a", "a", "a", "a", "a" };
+    struct topology *topo;
+    struct topology *kary;
+    bool same = true;
+    int i;
+
+    topo = topology_create_grouped (5, 2, groups);
+    kary = topology_create (5, 2);
+    if (!topo || !kary)
+        BAIL_OUT ("topology create failed");
+    for (i = 0; i < 5; i++) {
+        if (topology_get_parent (topo, i) != topology_get_parent (kary, i))
+            same = false;
+    }
+    ok (same, "a single group is the same as the k-ary tree");
+    topology_destroy (topo);
+    topology_destroy (kary);
+}
+
+void test_badargs (void)
+{
+    struct topology *topo;
+
+    errno = 0;
+    ok (topology_create (0, 2) == NULL && errno == EINVAL,
+        "topology_create size=0 fails with EINVAL");
+    errno = 0;
+    ok (topology_create (4, 0) == NULL && errno == EINVAL,
+        "topology_create k=0 fails with EINVAL");
+    errno = 0;
+    ok (topology_create_grouped (4, 2, NULL) == NULL && errno == EINVAL,
+        "topology_create_grouped groups=NULL fails with EINVAL");
+
+    if (!(topo = topology_create (4, 2)))
+        BAIL_OUT ("topology_create failed");
+    ok (topology_get_parent (topo, 4) == -1
+        && topology_get_level (topo, 4) == -1
+        && topology_get_descendants (topo, 4) == 0
+        && !topology_has_child (topo, 4)
+        && topology_get_child_route (topo, 0, 4) == -1,
+        "out of range ranks are handled");
+    ok (topology_get_size (topo) == 4 && topology_get_arity (topo) == 2,
+        "topology_get_size/arity work");
+    topology_destroy (topo);
+
+    ok (topology_get_parent (NULL, 0) == -1
+        && topology_get_size (NULL) == 0
+        && topology_get_maxlevel (NULL) == 0,
+        "NULL topology is handled");
+    lives_ok ({topology_destroy (NULL);},
+        "topology_destroy NULL doesnt crash");
+}
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    test_kary (1, 2);
+    test_kary (2, 2);
+    test_kary (16, 2);
+    test_kary (100, 3);
+    test_kary (64, 1);
+    test_kary (33, 32);
+    test_grouped ();
+    test_grouped_one ();
+    test_badargs ();
+
+    done_testing ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
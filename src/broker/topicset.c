@@ -0,0 +1,203 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* topicset.c - minimal set of subscription prefixes
+ *
+ * Members are kept in an unsorted array.  Sets are small (one entry per
+ * distinct subscription in a subtree), and are matched against each
+ * forwarded event, so a linear scan is adequate.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <jansson.h>
+
+#include "topicset.h"
+
+struct topicset {
+    char **prefix;
+    int count;
+    int alloc;
+};
+
+void topicset_destroy (struct topicset *ts)
+{
+    if (ts) {
+        int saved_errno = errno;
+        int i;
+        for (i = 0; i < ts->count; i++)
+            free (ts->prefix[i]);
+        free (ts->prefix);
+        free (ts);
+        errno = saved_errno;
+    }
+}
+
+struct topicset *topicset_create (void)
+{
+    struct topicset *ts;
+
+    if (!(ts = calloc (1, sizeof (*ts))))
+        return NULL;
+    return ts;
+}
+
+static bool is_prefix (const char *prefix, const char *topic)
+{
+    return !strncmp (topic, prefix, strlen (prefix));
+}
+
+bool topicset_match (const struct topicset *ts, const char *topic)
+{
+    int i;
+
+    if (ts && topic) {
+        for (i = 0; i < ts->count; i++) {
+            if (is_prefix (ts->prefix[i], topic))
+                return true;
+        }
+    }
+    return false;
+}
+
+int topicset_add (struct topicset *ts, const char *prefix)
+{
+    char *cpy;
+    int i;
+
+    if (!ts || !prefix) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (topicset_match (ts, prefix))
+        return 0;
+    if (ts->count == ts->alloc) {
+        int alloc = ts->alloc ? ts->alloc * 2 : 8;
+        char **p;
+        if (!(p = realloc (ts->prefix, alloc * sizeof (p[0]))))
+            return -1;
+        ts->prefix = p;
+        ts->alloc = alloc;
+    }
+    if (!(cpy = strdup (prefix)))
+        return -1;
+    /* Drop members that the new prefix matches.
+     */
+    i = 0;
+    while (i < ts->count) {
+        if (is_prefix (prefix, ts->prefix[i])) {
+            free (ts->prefix[i]);
+            ts->prefix[i] = ts->prefix[--ts->count];
+        }
+        else
+            i++;
+    }
+    ts->prefix[ts->count++] = cpy;
+    return 1;
+}
+
+int topicset_add_set (struct topicset *ts, const struct topicset *other)
+{
+    int grew = 0;
+    int i;
+
+    if (!ts || !other) {
+        errno = EINVAL;
+        return -1;
+    }
+    for (i = 0; i < other->count; i++) {
+        int rc;
+        if ((rc = topicset_add (ts, other->prefix[i])) < 0)
+            return -1;
+        if (rc > 0)
+            grew = 1;
+    }
+    return grew;
+}
+
+bool topicset_covers (const struct topicset *ts,
+                      const struct topicset *other)
+{
+    int i;
+
+    if (!ts || !other)
+        return false;
+    for (i = 0; i < other->count; i++) {
+        if (!topicset_match (ts, other->prefix[i]))
+            return false;
+    }
+    return true;
+}
+
+int topicset_count (const struct topicset *ts)
+{
+    return ts ? ts->count : 0;
+}
+
+json_t *topicset_encode (const struct topicset *ts)
+{
+    json_t *a;
+    int i;
+
+    if (!ts) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(a = json_array ()))
+        goto nomem;
+    for (i = 0; i < ts->count; i++) {
+        json_t *o;
+        if (!(o = json_string (ts->prefix[i]))
+            || json_array_append_new (a, o) < 0) {
+            json_decref (o);
+            goto nomem;
+        }
+    }
+    return a;
+nomem:
+    json_decref (a);
+    errno = ENOMEM;
+    return NULL;
+}
+
+struct topicset *topicset_decode (json_t *o)
+{
+    struct topicset *ts;
+    size_t index;
+    json_t *value;
+
+    if (!o || !json_is_array (o)) {
+        errno = EPROTO;
+        return NULL;
+    }
+    if (!(ts = topicset_create ()))
+        return NULL;
+    json_array_foreach (o, index, value) {
+        const char *s = json_string_value (value);
+        if (!s) {
+            errno = EPROTO;
+            goto error;
+        }
+        if (topicset_add (ts, s) < 0)
+            goto error;
+    }
+    return ts;
+error:
+    topicset_destroy (ts);
+    return NULL;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
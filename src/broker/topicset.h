@@ -0,0 +1,59 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _BROKER_TOPICSET_H
+#define _BROKER_TOPICSET_H
+
+#include <stdbool.h>
+#include <jansson.h>
+
+/* topicset - a set of event subscription prefixes
+ *
+ * An event topic matches the set if any member is a prefix of it, so
+ * the empty string matches everything.  The set is kept minimal: a
+ * prefix that is already matched is not added, and adding a prefix
+ * removes any members it matches.
+ */
+
+struct topicset;
+
+struct topicset *topicset_create (void);
+void topicset_destroy (struct topicset *ts);
+
+/* Add 'prefix' to the set.
+ * Returns 1 if the set now matches more topics, 0 if 'prefix' was already
+ * matched, or -1 on error with errno set.
+ */
+int topicset_add (struct topicset *ts, const char *prefix);
+
+/* Add all members of 'other' to 'ts'.
+ * Returns 1 if 'ts' now matches more topics, 0 if not, or -1 on error.
+ */
+int topicset_add_set (struct topicset *ts, const struct topicset *other);
+
+bool topicset_match (const struct topicset *ts, const char *topic);
+
+/* Return true if every topic matched by 'other' is matched by 'ts'.
+ */
+bool topicset_covers (const struct topicset *ts,
+                      const struct topicset *other);
+
+int topicset_count (const struct topicset *ts);
+
+/* Convert to/from a JSON array of strings.
+ */
+json_t *topicset_encode (const struct topicset *ts);
+struct topicset *topicset_decode (json_t *o);
+
+#endif /* !_BROKER_TOPICSET_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
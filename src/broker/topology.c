@@ -0,0 +1,267 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* topology.c - tree based overlay network shape
+ *
+ * The tree is stored as an array of parents indexed by rank.  Since
+ * parents always have lower ranks than their children, levels are found
+ * in one pass up the array and descendant counts in one pass back down.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <czmq.h>
+
+#include "src/common/libutil/kary.h"
+
+#include "topology.h"
+
+struct topology {
+    uint32_t size;
+    int k;
+    int *parent;
+    int *level;
+    int *descendants;
+    int *nchildren;
+    int maxlevel;
+};
+
+void topology_destroy (struct topology *topo)
+{
+    if (topo) {
+        int saved_errno = errno;
+        free (topo->parent);
+        free (topo->level);
+        free (topo->descendants);
+        free (topo->nchildren);
+        free (topo);
+        errno = saved_errno;
+    }
+}
+
+static struct topology *topology_alloc (uint32_t size, int k)
+{
+    struct topology *topo;
+
+    if (size == 0 || k < 1) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(topo = calloc (1, sizeof (*topo))))
+        return NULL;
+    topo->size = size;
+    topo->k = k;
+    if (!(topo->parent = calloc (size, sizeof (topo->parent[0])))
+        || !(topo->level = calloc (size, sizeof (topo->level[0])))
+        || !(topo->descendants = calloc (size, sizeof (topo->descendants[0])))
+        || !(topo->nchildren = calloc (size, sizeof (topo->nchildren[0])))) {
+        topology_destroy (topo);
+        return NULL;
+    }
+    topo->parent[0] = -1;
+    return topo;
+}
+
+static void topology_finalize (struct topology *topo)
+{
+    int i;
+
+    for (i = 1; i < topo->size; i++) {
+        topo->level[i] = topo->level[topo->parent[i]] + 1;
+        topo->nchildren[topo->parent[i]]++;
+        if (topo->level[i] > topo->maxlevel)
+            topo->maxlevel = topo->level[i];
+    }
+    for (i = topo->size - 1; i > 0; i--)
+        topo->descendants[topo->parent[i]] += topo->descendants[i] + 1;
+}
+
+struct topology *topology_create (uint32_t size, int k)
+{
+    struct topology *topo;
+    int i;
+
+    if (!(topo = topology_alloc (size, k)))
+        return NULL;
+    for (i = 1; i < size; i++)
+        topo->parent[i] = kary_parentof (k, i);
+    topology_finalize (topo);
+    return topo;
+}
+
+/* Arrange 'ranks' (ascending, ranks[0] is the subtree root) as a k-ary tree.
+ */
+static void link_kary (struct topology *topo, const int *ranks, int count)
+{
+    int i;
+
+    for (i = 1; i < count; i++)
+        topo->parent[ranks[i]] = ranks[kary_parentof (topo->k, i)];
+}
+
+struct topology *topology_create_grouped (uint32_t size,
+                                          int k,
+                                          const char *groups[])
+{
+    struct topology *topo;
+    zhashx_t *leaders = NULL;   // group name => leader rank + 1
+    int *members = NULL;        // ranks of one group, or group leaders
+    int *leader = NULL;         // leader of each rank
+    int count;
+    int i, j;
+
+    if (!groups) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(topo = topology_alloc (size, k)))
+        return NULL;
+    if (!(members = calloc (size, sizeof (members[0])))
+        || !(leader = calloc (size, sizeof (leader[0])))
+        || !(leaders = zhashx_new ()))
+        goto nomem;
+
+    /* Find each rank's leader.  Rank 0 leads its own group, so that
+     * the group with rank 0 in it is led by the root.
+     */
+    for (i = 0; i < size; i++) {
+        void *val;
+
+        if (!groups[i] || i == 0) {
+            leader[i] = i;
+            continue;
+        }
+        if ((val = zhashx_lookup (leaders, groups[i])))
+            leader[i] = (uintptr_t)val - 1;
+        else if (groups[0] && !strcmp (groups[i], groups[0]))
+            leader[i] = 0;
+        else {
+            if (zhashx_insert (leaders,
+                               groups[i],
+                               (void *)(uintptr_t)(i + 1)) < 0)
+                goto nomem;
+            leader[i] = i;
+        }
+    }
+
+    /* Leaders form a k-ary tree under rank 0.
+     */
+    for (i = 0, count = 0; i < size; i++) {
+        if (leader[i] == i)
+            members[count++] = i;
+    }
+    link_kary (topo, members, count);
+
+    /* Members of each group form a k-ary tree under their leader.
+     * N.B. this is quadratic in the number of groups, which is small.
+     */
+    for (i = 0; i < size; i++) {
+        if (leader[i] != i)
+            continue;
+        members[0] = i;
+        count = 1;
+        for (j = i + 1; j < size; j++) {
+            if (leader[j] == i)
+                members[count++] = j;
+        }
+        if (count > 1) {
+            int root_parent = topo->parent[i];
+            link_kary (topo, members, count);
+            topo->parent[i] = root_parent;
+        }
+    }
+    topology_finalize (topo);
+    zhashx_destroy (&leaders);
+    free (leader);
+    free (members);
+    return topo;
+nomem:
+    zhashx_destroy (&leaders);
+    free (leader);
+    free (members);
+    topology_destroy (topo);
+    errno = ENOMEM;
+    return NULL;
+}
+
+uint32_t topology_get_size (struct topology *topo)
+{
+    return topo ? topo->size : 0;
+}
+
+int topology_get_arity (struct topology *topo)
+{
+    return topo ? topo->k : 0;
+}
+
+int topology_get_parent (struct topology *topo, uint32_t rank)
+{
+    if (!topo || rank >= topo->size)
+        return -1;
+    return topo->parent[rank];
+}
+
+bool topology_has_child (struct topology *topo, uint32_t rank)
+{
+    if (!topo || rank >= topo->size)
+        return false;
+    return topo->nchildren[rank] > 0;
+}
+
+int topology_get_child_count (struct topology *topo, uint32_t rank)
+{
+    if (!topo || rank >= topo->size)
+        return 0;
+    return topo->nchildren[rank];
+}
+
+int topology_get_level (struct topology *topo, uint32_t rank)
+{
+    if (!topo || rank >= topo->size)
+        return -1;
+    return topo->level[rank];
+}
+
+int topology_get_maxlevel (struct topology *topo)
+{
+    return topo ? topo->maxlevel : 0;
+}
+
+int topology_get_descendants (struct topology *topo, uint32_t rank)
+{
+    if (!topo || rank >= topo->size)
+        return 0;
+    return topo->descendants[rank];
+}
+
+int topology_get_child_route (struct topology *topo,
+                              uint32_t rank,
+                              uint32_t dst)
+{
+    int r;
+
+    if (!topo || rank >= topo->size || dst >= topo->size || rank == dst)
+        return -1;
+    r = dst;
+    while (r > rank) {  // parents have lower ranks
+        if (topo->parent[r] == rank)
+            return r;
+        r = topo->parent[r];
+    }
+    return -1;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,77 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _BROKER_TOPOLOGY_H
+#define _BROKER_TOPOLOGY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* topology - shape of the tree based overlay network
+ *
+ * By default, ranks form a k-ary tree rooted at rank 0.
+ *
+ * A grouped topology keeps each group of ranks (e.g. the nodes on one
+ * switch or rack) in its own subtree.  The lowest rank in each group is
+ * the group's leader.  Group leaders form a k-ary tree under rank 0 in
+ * rank order, and the other members of each group form a k-ary tree under
+ * their leader, so that, apart from leaders, every broker's parent is in
+ * its own group.  Rank 0 always leads its own group.
+ *
+ * In both cases, a rank's parent has a lower rank.
+ */
+
+struct topology;
+
+struct topology *topology_create (uint32_t size, int k);
+
+/* Create a grouped topology.  'groups' is an array of 'size' group names
+ * indexed by rank.  A NULL name places the rank in a group of its own.
+ */
+struct topology *topology_create_grouped (uint32_t size,
+                                          int k,
+                                          const char *groups[]);
+
+void topology_destroy (struct topology *topo);
+
+uint32_t topology_get_size (struct topology *topo);
+int topology_get_arity (struct topology *topo);
+
+/* Return the parent of 'rank', or -1 if 'rank' is the root or invalid.
+ */
+int topology_get_parent (struct topology *topo, uint32_t rank);
+
+/* Return true if 'rank' has at least one child, or the number of children.
+ */
+bool topology_has_child (struct topology *topo, uint32_t rank);
+int topology_get_child_count (struct topology *topo, uint32_t rank);
+
+/* Return the distance of 'rank' from rank 0 (level 0), or the
+ * maximum level of any rank.
+ */
+int topology_get_level (struct topology *topo, uint32_t rank);
+int topology_get_maxlevel (struct topology *topo);
+
+/* Return the number of ranks in the subtree below 'rank'.
+ */
+int topology_get_descendants (struct topology *topo, uint32_t rank);
+
+/* Return the child of 'rank' through which 'dst' is reached, or -1 if
+ * 'dst' is not a descendant of 'rank'.
+ */
+int topology_get_child_route (struct topology *topo,
+                              uint32_t rank,
+                              uint32_t dst);
+
+#endif /* !_BROKER_TOPOLOGY_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
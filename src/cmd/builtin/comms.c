@@ -13,6 +13,7 @@
 #include <inttypes.h>
 #include <argz.h>
 #include <assert.h>
+#include <jansson.h>
 
 #include "src/common/libidset/idset.h"
 
@@ -89,6 +90,219 @@ static int internal_comms_lspeer (optparse_t *p, int ac, char *av[])
     return 0;
 }
 
+static int internal_comms_stats (optparse_t *p, int ac, char *av[])
+{
+    flux_t *h;
+    flux_future_t *f;
+    const char *stats;
+
+    if (optparse_option_index (p) != ac) {
+        optparse_print_usage (p);
+        exit (1);
+    }
+    if (!(h = builtin_get_flux_handle (p)))
+        log_err_exit ("flux_open");
+    if (!(f = flux_rpc (h, "overlay.stats", NULL, FLUX_NODEID_ANY, 0)))
+        log_err_exit ("flux_rpc");
+    if (flux_rpc_get (f, &stats) < 0)
+        log_msg_exit ("overlay.stats: %s", flux_future_error_string (f));
+    printf ("%s\n", stats);
+    flux_future_destroy (f);
+
+    flux_close (h);
+    return 0;
+}
+
+struct topic_count {
+    const char *topic;
+    json_int_t count;
+    json_int_t bytes;
+};
+
+static int topic_count_cmp (const void *a, const void *b)
+{
+    const struct topic_count *t1 = a;
+    const struct topic_count *t2 = b;
+
+    if (t1->count != t2->count)
+        return t1->count < t2->count ? 1 : -1;
+    return strcmp (t1->topic, t2->topic);
+}
+
+/* List request topics, busiest first.
+ */
+static void traffic_print_services (json_t *services)
+{
+    struct topic_count *tc;
+    const char *topic;
+    json_t *entry;
+    int n = 0;
+    int i;
+
+    if (!(tc = calloc (json_object_size (services) + 1, sizeof (*tc))))
+        log_msg_exit ("out of memory");
+    json_object_foreach (services, topic, entry) {
+        if (json_unpack (entry, "{s:I s:I}",
+                         "count", &tc[n].count,
+                         "bytes", &tc[n].bytes) < 0)
+            log_msg_exit ("error decoding service stats");
+        tc[n++].topic = topic;
+    }
+    qsort (tc, n, sizeof (*tc), topic_count_cmp);
+    printf ("%-32s %12s %14s\n", "TOPIC", "COUNT", "BYTES");
+    for (i = 0; i < n; i++)
+        printf ("%-32s %12"JSON_INTEGER_FORMAT" %14"JSON_INTEGER_FORMAT"\n",
+                tc[i].topic, tc[i].count, tc[i].bytes);
+    free (tc);
+}
+
+static void traffic_print_peer (const char *name, json_t *peer)
+{
+    json_int_t tx_count, tx_bytes, rx_count, rx_bytes;
+    int queued;
+
+    if (json_unpack (peer, "{s:{s:I s:I} s:{s:I s:I} s:i}",
+                     "tx",
+                       "count", &tx_count,
+                       "bytes", &tx_bytes,
+                     "rx",
+                       "count", &rx_count,
+                       "bytes", &rx_bytes,
+                     "queued", &queued) < 0)
+        log_msg_exit ("error decoding peer stats");
+    printf ("%-8s %12"JSON_INTEGER_FORMAT" %14"JSON_INTEGER_FORMAT
+            " %12"JSON_INTEGER_FORMAT" %14"JSON_INTEGER_FORMAT" %6d\n",
+            name, tx_count, tx_bytes, rx_count, rx_bytes, queued);
+}
+
+static int internal_comms_traffic (optparse_t *p, int ac, char *av[])
+{
+    flux_t *h;
+    flux_future_t *f;
+    uint32_t rank = optparse_get_int (p, "rank", FLUX_NODEID_ANY);
+    const char *s;
+    json_t *services;
+    json_t *parent = NULL;
+    json_t *children;
+    json_t *peer;
+    const char *uuid;
+    int event_hold;
+    json_int_t upstream_nosvc = 0;
+
+    if (optparse_option_index (p) != ac) {
+        optparse_print_usage (p);
+        exit (1);
+    }
+    if (!(h = builtin_get_flux_handle (p)))
+        log_err_exit ("flux_open");
+    if (!(f = flux_rpc_pack (h, "broker.stats", rank, 0, "{s:b}",
+                             "clear", optparse_hasopt (p, "clear"))))
+        log_err_exit ("flux_rpc");
+    if (optparse_hasopt (p, "json")) {
+        if (flux_rpc_get (f, &s) < 0)
+            log_msg_exit ("broker.stats: %s", future_strerror (f, errno));
+        printf ("%s\n", s);
+    }
+    else {
+        if (flux_rpc_get_unpack (f, "{s:o s:{s?o s:o} s:{s:i} s?{s?I}}",
+                                 "services", &services,
+                                 "overlay",
+                                   "parent", &parent,
+                                   "children", &children,
+                                 "queues",
+                                   "event-hold", &event_hold,
+                                 "routing",
+                                   "upstream-nosvc", &upstream_nosvc) < 0)
+            log_msg_exit ("broker.stats: %s", future_strerror (f, errno));
+        traffic_print_services (services);
+        printf ("\n%-8s %12s %14s %12s %14s %6s\n",
+                "PEER", "TX-COUNT", "TX-BYTES", "RX-COUNT", "RX-BYTES",
+                "QUEUED");
+        if (parent)
+            traffic_print_peer ("parent", parent);
+        json_object_foreach (children, uuid, peer)
+            traffic_print_peer (uuid, peer);
+        printf ("\nevents held for replay: %d\n", event_hold);
+        printf ("requests routed upstream for lack of a local service: %lld\n",
+                (long long)upstream_nosvc);
+    }
+    flux_future_destroy (f);
+
+    flux_close (h);
+    return 0;
+}
+
+/* Print traced message events recorded by a broker and its modules,
+ * with the time of each relative to the first.
+ */
+static int internal_comms_trace (optparse_t *p, int ac, char *av[])
+{
+    flux_t *h;
+    flux_future_t *f;
+    uint32_t rank = optparse_get_int (p, "rank", FLUX_NODEID_ANY);
+    int n = optparse_option_index (p);
+    json_int_t trace = 0;
+    json_t *events;
+    json_t *entry;
+    size_t index;
+    double t0 = 0.;
+    const char *s;
+
+    if (n < ac - 1) {
+        optparse_print_usage (p);
+        exit (1);
+    }
+    if (n < ac) {
+        char *endptr;
+        errno = 0;
+        trace = strtoll (av[n], &endptr, 16);
+        if (errno != 0 || *endptr != '\0' || trace <= 0)
+            log_msg_exit ("invalid trace id: %s", av[n]);
+    }
+    if (!(h = builtin_get_flux_handle (p)))
+        log_err_exit ("flux_open");
+    if (!(f = flux_rpc_pack (h, "broker.trace", rank, 0, "{s:I s:b}",
+                             "trace", trace,
+                             "clear", optparse_hasopt (p, "clear"))))
+        log_err_exit ("flux_rpc");
+    if (optparse_hasopt (p, "json")) {
+        if (flux_rpc_get (f, &s) < 0)
+            log_msg_exit ("broker.trace: %s", future_strerror (f, errno));
+        printf ("%s\n", s);
+    }
+    else {
+        if (flux_rpc_get_unpack (f, "{s:o}", "events", &events) < 0)
+            log_msg_exit ("broker.trace: %s", future_strerror (f, errno));
+        json_array_foreach (events, index, entry) {
+            json_int_t id, span;
+            double t;
+            const char *where, *type, *topic;
+
+            if (json_unpack (entry, "{s:I s:I s:f s:s s:s s:s}",
+                             "trace", &id,
+                             "span", &span,
+                             "timestamp", &t,
+                             "where", &where,
+                             "type", &type,
+                             "topic", &topic) < 0)
+                log_msg_exit ("broker.trace: malformed event");
+            if (index == 0)
+                t0 = t;
+            printf ("%12.6f %016llx %016llx %-10s %-8s %s\n",
+                    t - t0,
+                    (unsigned long long)id,
+                    (unsigned long long)span,
+                    where,
+                    type,
+                    topic);
+        }
+    }
+    flux_future_destroy (f);
+
+    flux_close (h);
+    return 0;
+}
+
 /* Return true if all members of 'idset1' are in 'idset2'.
  */
 static bool is_subset_of (struct idset *idset1, struct idset *idset2)
@@ -204,6 +418,46 @@ static struct optparse_option up_opts[] = {
     OPTPARSE_TABLE_END
 };
 
+static struct optparse_option traffic_opts[] = {
+    { .name = "rank",
+      .key = 'r',
+      .has_arg = 1,
+      .arginfo = "RANK",
+      .usage = "Show counters of broker RANK (default: local broker)",
+    },
+    { .name = "json",
+      .key = 'j',
+      .has_arg = 0,
+      .usage = "Print raw JSON response",
+    },
+    { .name = "clear",
+      .key = 'c',
+      .has_arg = 0,
+      .usage = "Clear counters after reading them",
+    },
+    OPTPARSE_TABLE_END
+};
+
+static struct optparse_option trace_opts[] = {
+    { .name = "rank",
+      .key = 'r',
+      .has_arg = 1,
+      .arginfo = "RANK",
+      .usage = "Show events of broker RANK (default: local broker)",
+    },
+    { .name = "json",
+      .key = 'j',
+      .has_arg = 0,
+      .usage = "Print raw JSON response",
+    },
+    { .name = "clear",
+      .key = 'c',
+      .has_arg = 0,
+      .usage = "Discard events after reading them",
+    },
+    OPTPARSE_TABLE_END
+};
+
 static struct optparse_subcommand comms_subcmds[] = {
     { "lspeer",
       "",
@@ -212,6 +466,27 @@ static struct optparse_subcommand comms_subcmds[] = {
       0,
       NULL,
     },
+    { "stats",
+      "",
+      "Show overlay compression statistics",
+      internal_comms_stats,
+      0,
+      NULL,
+    },
+    { "traffic",
+      "[OPTIONS]",
+      "Show message counters by request topic and overlay peer",
+      internal_comms_traffic,
+      0,
+      traffic_opts,
+    },
+    { "trace",
+      "[OPTIONS] [TRACE-ID]",
+      "Show traced message events, optionally of one trace",
+      internal_comms_trace,
+      0,
+      trace_opts,
+    },
     { "info",
       "",
       "List rank, size, TBON branching factor",
@@ -11,9 +11,13 @@
 #include "builtin.h"
 
 #include <unistd.h>
+#include <czmq.h>
+#include <jansson.h>
 
 #include "src/common/libutil/blobref.h"
+#include "src/common/libutil/blobsnap.h"
 #include "src/common/libutil/read_all.h"
+#include "src/common/libkvs/treeobj.h"
 
 static int internal_content_load (optparse_t *p, int ac, char *av[])
 {
@@ -116,6 +120,36 @@ static int internal_content_dropcache (optparse_t *p, int ac, char *av[])
     return (0);
 }
 
+static int internal_content_gc (optparse_t *p, int ac, char *av[])
+{
+    flux_t *h;
+    flux_future_t *f = NULL;
+    json_int_t scanned, deleted, bytes;
+
+    if (optparse_option_index (p) != ac) {
+        optparse_print_usage (p);
+        exit (1);
+    }
+    if (!(h = builtin_get_flux_handle (p)))
+        log_err_exit ("flux_open");
+    if (!(f = flux_rpc (h, "content-backing.gc", NULL, 0, 0))
+        || flux_rpc_get_unpack (f,
+                                "{s:I s:I s:I}",
+                                "scanned", &scanned,
+                                "deleted", &deleted,
+                                "deleted_bytes", &bytes) < 0)
+        log_msg_exit ("content-backing.gc: %s", future_strerror (f, errno));
+    if (optparse_hasopt (p, "verbose"))
+        fprintf (stderr,
+                 "deleted %jd of %jd blobs (%jd bytes)\n",
+                 (intmax_t)deleted,
+                 (intmax_t)scanned,
+                 (intmax_t)bytes);
+    flux_future_destroy (f);
+    flux_close (h);
+    return (0);
+}
+
 static int spam_max_inflight;
 static int spam_cur_inflight;
 
@@ -171,6 +205,214 @@ static int internal_content_spam (optparse_t *p, int ac, char *av[])
     return (0);
 }
 
+/* Snapshot:  walk the KVS from a root, loading each reachable blob from
+ * the backing store and appending it to a blob snapshot, with up to
+ * SNAPSHOT_MAX_INFLIGHT loads in flight.  Dir blobs are visited for the
+ * blobrefs they contain.
+ */
+#define SNAPSHOT_MAX_INFLIGHT 256
+
+struct snapshot {
+    flux_t *h;
+    struct blobsnap_writer *w;
+    zhash_t *seen;
+    zlist_t *dirs;          // blobrefs of treeobjs to visit
+    zlist_t *vals;          // blobrefs of opaque blobs
+    int inflight;
+    int count;
+    int errnum;
+    char *errblob;
+};
+
+static int snapshot_queue (struct snapshot *snap,
+                           const char *blobref,
+                           bool visit)
+{
+    char *cpy;
+
+    if (zhash_lookup (snap->seen, blobref))
+        return 0;
+    if (zhash_insert (snap->seen, blobref, (void *)1) < 0
+        || !(cpy = strdup (blobref)))
+        goto nomem;
+    if (zlist_append (visit ? snap->dirs : snap->vals, cpy) < 0) {
+        free (cpy);
+        goto nomem;
+    }
+    return 0;
+nomem:
+    errno = ENOMEM;
+    return -1;
+}
+
+/* Queue the blobs that treeobj 'obj' refers to.
+ */
+static int snapshot_treeobj (struct snapshot *snap, const json_t *obj)
+{
+    json_t *data = treeobj_get_data ((json_t *)obj);
+    const char *key;
+    json_t *o;
+
+    if (treeobj_is_valref (obj) || treeobj_is_dirref (obj)) {
+        bool visit = treeobj_is_dirref (obj);
+        int count = treeobj_get_count (obj);
+
+        for (int i = 0; i < count; i++) {
+            const char *blobref = treeobj_get_blobref (obj, i);
+            if (!blobref || snapshot_queue (snap, blobref, visit) < 0)
+                return -1;
+        }
+        return 0;
+    }
+    if (treeobj_is_dirshard (obj))
+        data = json_object_get (data, "shards");
+    else if (!treeobj_is_dir (obj))
+        return 0;
+    json_object_foreach (data, key, o) {
+        if (snapshot_treeobj (snap, o) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+static void snapshot_send (struct snapshot *snap);
+
+static void snapshot_continuation (flux_future_t *f, void *arg)
+{
+    struct snapshot *snap = arg;
+    const char *blobref = flux_future_aux_get (f, "blobref");
+    bool visit = flux_future_aux_get (f, "visit") != NULL;
+    const void *data;
+    int size;
+    json_t *obj;
+
+    snap->inflight--;
+    if (snap->errnum)
+        goto done;
+    if (flux_content_load_get (f, &data, &size) < 0
+        || blobsnap_writer_append (snap->w, blobref, data, size) < 0)
+        goto error;
+    snap->count++;
+    if (visit) {
+        if (!(obj = treeobj_decodeb (data, size))) {
+            errno = EPROTO;
+            goto error;
+        }
+        if (snapshot_treeobj (snap, obj) < 0) {
+            json_decref (obj);
+            goto error;
+        }
+        json_decref (obj);
+    }
+    snapshot_send (snap);
+done:
+    if (snap->inflight == 0)
+        flux_reactor_stop (flux_get_reactor (snap->h));
+    flux_future_destroy (f);
+    return;
+error:
+    snap->errnum = errno;
+    snap->errblob = strdup (blobref);
+    goto done;
+}
+
+/* Visit dirs first, so that the queue of unvisited dirs stays short.
+ */
+static void snapshot_send (struct snapshot *snap)
+{
+    while (snap->inflight < SNAPSHOT_MAX_INFLIGHT && !snap->errnum) {
+        flux_future_t *f;
+        bool visit = true;
+        char *blobref;
+
+        if (!(blobref = zlist_pop (snap->dirs))) {
+            if (!(blobref = zlist_pop (snap->vals)))
+                break;
+            visit = false;
+        }
+        if (!(f = flux_content_load (snap->h,
+                                     blobref,
+                                     CONTENT_FLAG_CACHE_BYPASS))
+            || flux_future_aux_set (f, "blobref", blobref, free) < 0
+            || (visit && flux_future_aux_set (f, "visit", snap, NULL) < 0)
+            || flux_future_then (f, -1., snapshot_continuation, snap) < 0)
+            log_err_exit ("flux_content_load %s", blobref);
+        snap->inflight++;
+    }
+}
+
+static char *snapshot_checkpoint_root (flux_t *h)
+{
+    flux_future_t *f;
+    const char *value;
+    char *root;
+
+    if (!(f = flux_rpc_pack (h,
+                             "kvs-checkpoint.get",
+                             0,
+                             0,
+                             "{s:s}",
+                             "key",
+                             "kvs-primary"))
+        || flux_rpc_get_unpack (f, "{s:s}", "value", &value) < 0)
+        log_msg_exit ("kvs-checkpoint.get: %s", future_strerror (f, errno));
+    if (!(root = strdup (value)))
+        log_msg_exit ("out of memory");
+    flux_future_destroy (f);
+    return root;
+}
+
+static int internal_content_snapshot (optparse_t *p, int ac, char *av[])
+{
+    int n = optparse_option_index (p);
+    struct snapshot snap = { 0 };
+    const char *path;
+    char *root;
+
+    if (n != ac - 1) {
+        optparse_print_usage (p);
+        exit (1);
+    }
+    path = av[n];
+    if (!(snap.h = builtin_get_flux_handle (p)))
+        log_err_exit ("flux_open");
+    if (optparse_hasopt (p, "root")) {
+        if (!(root = strdup (optparse_get_str (p, "root", NULL))))
+            log_msg_exit ("out of memory");
+    }
+    else
+        root = snapshot_checkpoint_root (snap.h);
+    if (blobref_validate (root) < 0)
+        log_msg_exit ("%s: invalid blobref", root);
+    if (!(snap.seen = zhash_new ())
+        || !(snap.dirs = zlist_new ())
+        || !(snap.vals = zlist_new ())
+        || snapshot_queue (&snap, root, true) < 0)
+        log_msg_exit ("out of memory");
+    if (!(snap.w = blobsnap_writer_create (path, root)))
+        log_err_exit ("%s", path);
+
+    snapshot_send (&snap);
+    if (flux_reactor_run (flux_get_reactor (snap.h), 0) < 0)
+        log_err_exit ("flux_reactor_run");
+    if (snap.errnum) {
+        blobsnap_writer_destroy (snap.w);
+        log_errn_exit (snap.errnum, "%s", snap.errblob ? snap.errblob : root);
+    }
+    if (blobsnap_writer_commit (snap.w) < 0)
+        log_err_exit ("%s", path);
+    if (optparse_hasopt (p, "verbose"))
+        fprintf (stderr, "%s: %d blobs from %s\n", path, snap.count, root);
+
+    blobsnap_writer_destroy (snap.w);
+    zlist_destroy (&snap.vals);
+    zlist_destroy (&snap.dirs);
+    zhash_destroy (&snap.seen);
+    free (root);
+    flux_close (snap.h);
+    return (0);
+}
+
 int cmd_content (optparse_t *p, int ac, char *av[])
 {
     log_init ("flux-content");
@@ -192,6 +434,20 @@ static struct optparse_option store_opts[] = {
       OPTPARSE_TABLE_END,
 };
 
+static struct optparse_option snapshot_opts[] = {
+    { .name = "root",  .key = 'r',  .has_arg = 1, .arginfo = "BLOBREF",
+      .usage = "Snapshot the KVS root BLOBREF instead of the checkpoint", },
+    { .name = "verbose",  .key = 'v',  .has_arg = 0,
+      .usage = "Print the number of blobs written", },
+    OPTPARSE_TABLE_END,
+};
+
+static struct optparse_option gc_opts[] = {
+    { .name = "verbose",  .key = 'v',  .has_arg = 0,
+      .usage = "Print the number of blobs deleted", },
+    OPTPARSE_TABLE_END,
+};
+
 static struct optparse_subcommand content_subcmds[] = {
     { "load",
       "[OPTIONS] BLOBREF",
@@ -221,6 +477,20 @@ static struct optparse_subcommand content_subcmds[] = {
       0,
       NULL,
     },
+    { "snapshot",
+      "[OPTIONS] FILE",
+      "Write the blobs reachable from the KVS checkpoint to FILE",
+      internal_content_snapshot,
+      0,
+      snapshot_opts,
+    },
+    { "gc",
+      "[OPTIONS]",
+      "Delete blobs that are not reachable from the KVS",
+      internal_content_gc,
+      0,
+      gc_opts,
+    },
     { "spam",
       "N [M]",
       "Store N random entries, keeping M requests in flight (default 1)",
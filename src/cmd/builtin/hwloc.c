@@ -18,12 +18,14 @@
 #include <assert.h>
 #include <argz.h>
 #include <inttypes.h>
+#include <czmq.h>
 #include <jansson.h>
 
 #include <hwloc.h>
 
 #include "src/common/libidset/idset.h"
 #include "src/common/libaggregate/aggregate.h"
+#include "src/common/libkvs/treeobj.h"
 #include "src/common/libutil/monotime.h"
 
 #define XML_BASEDIR "resource.hwloc.xml"
@@ -73,6 +75,21 @@ static struct idset *ranks_to_idset (flux_t *h, const char *ranks)
 /*  Topology kvs helpers:
  */
 
+/*  Decode a JSON string encoded hwloc xml value, as stored by
+ *   kvs_txn_put_xml(), returning a copy of the xml.
+ */
+static char *xml_decode (const void *data, int len)
+{
+    json_t *o;
+    char *xml = NULL;
+
+    if ((o = json_loadb (data, len, JSON_DECODE_ANY, NULL))
+        && json_is_string (o))
+        xml = strdup (json_string_value (o));
+    json_decref (o);
+    return (xml);
+}
+
 static void lookup_continuation (flux_future_t *f, void *arg)
 {
     char **valp = arg;
@@ -86,9 +103,75 @@ static void lookup_continuation (flux_future_t *f, void *arg)
     flux_future_destroy (f);
 }
 
+static void load_continuation (flux_future_t *f, void *arg)
+{
+    char **valp = arg;
+    const void *data;
+    int len;
+
+    if (flux_content_load_get (f, &data, &len) < 0
+        || !(*valp = xml_decode (data, len)))
+        log_err_exit ("unable to load rank xml");
+
+    flux_future_destroy (f);
+}
+
+static void lookup_treeobj_continuation (flux_future_t *f, void *arg)
+{
+    json_t **valp = arg;
+    const char *s;
+
+    if (flux_kvs_lookup_get_treeobj (f, &s) < 0
+        || !(*valp = treeobj_decode (s)))
+        log_err_exit ("unable to look up rank xml");
+
+    flux_future_destroy (f);
+}
+
+/*  Fetch the xml referred to by treeobj 'o' into xmls[i].  Ranks with the
+ *   same topology refer to the same blob (see kvs_txn_put_xml()), so each
+ *   unique blob is loaded only once, and its index + 1 is recorded in
+ *   'first' so that duplicates can be copied from it once all loads complete.
+ *   Anything else falls back to a regular lookup of 'key'.
+ */
+static int fetch_topo_xml (flux_t *h, zhashx_t *first, char **xmls, int i,
+                           json_t *o, const char *key)
+{
+    flux_future_t *f;
+    const char *blobref;
+    void *data;
+    int len;
+
+    if (treeobj_is_val (o)) {
+        if (treeobj_decode_val (o, &data, &len) < 0
+            || !(xmls[i] = xml_decode (data, len)))
+            return (-1);
+        free (data);
+        return (0);
+    }
+    if (treeobj_is_valref (o) && treeobj_get_count (o) == 1) {
+        if (!(blobref = treeobj_get_blobref (o, 0)))
+            return (-1);
+        if (zhashx_lookup (first, blobref))
+            return (0);
+        if (zhashx_insert (first, blobref, (void *)(intptr_t)(i + 1)) < 0)
+            return (-1);
+        if (!(f = flux_content_load (h, blobref, 0))
+            || flux_future_then (f, -1., load_continuation, &xmls[i]) < 0)
+            return (-1);
+        return (0);
+    }
+    if (!(f = flux_kvs_lookup (h, NULL, 0, key))
+        || flux_future_then (f, -1., lookup_continuation, &xmls[i]) < 0)
+        return (-1);
+    return (0);
+}
+
 /*  Send lookup request for topology XML for all ranks in idset, returning
  *   copies of each XML in xmls array (The array must have space for
  *   idset_count (idset) members).
+ *  Only the tree objects are looked up at first, then the xml of each
+ *   distinct topology is fetched once from the content store.
  *  There should be no other watchers registered on the main handle reactor
  *   here, so it is safe to drop into the handle reactor and return when
  *   all lookup handlers have completed.
@@ -97,19 +180,57 @@ static int lookup_all_topo_xml (flux_t *h, char **xmls, struct idset *idset)
 {
     flux_future_t *f = NULL;
     char key [1024];
-    int rank = idset_first (idset);
-    int i = 0;
+    int count = idset_count (idset);
+    json_t **treeobjs;
+    zhashx_t *first;
+    int rank;
+    int i;
+
+    if (!(treeobjs = calloc (count, sizeof (treeobjs[0])))
+        || !(first = zhashx_new ()))
+        log_msg_exit ("out of memory");
 
+    rank = idset_first (idset);
+    i = 0;
     while (rank != IDSET_INVALID_ID) {
         snprintf (key, sizeof (key), "%s.%d", XML_BASEDIR, rank);
-        if (!(f = flux_kvs_lookup (h, NULL, 0, key))
-            || (flux_future_then (f, -1., lookup_continuation, &xmls[i]) < 0))
+        if (!(f = flux_kvs_lookup (h, NULL, FLUX_KVS_TREEOBJ, key))
+            || (flux_future_then (f,
+                                  -1.,
+                                  lookup_treeobj_continuation,
+                                  &treeobjs[i]) < 0))
             log_err_exit ("kvs lookup");
 
         rank = idset_next (idset, rank);
         i++;
     }
-    return (flux_reactor_run (flux_get_reactor (h), 0));
+    if (flux_reactor_run (flux_get_reactor (h), 0) < 0)
+        return (-1);
+
+    rank = idset_first (idset);
+    i = 0;
+    while (rank != IDSET_INVALID_ID) {
+        snprintf (key, sizeof (key), "%s.%d", XML_BASEDIR, rank);
+        if (fetch_topo_xml (h, first, xmls, i, treeobjs[i], key) < 0)
+            log_err_exit ("%s", key);
+        rank = idset_next (idset, rank);
+        i++;
+    }
+    if (flux_reactor_run (flux_get_reactor (h), 0) < 0)
+        return (-1);
+
+    for (i = 0; i < count; i++) {
+        if (!xmls[i]) {
+            const char *blobref = treeobj_get_blobref (treeobjs[i], 0);
+            intptr_t j = (intptr_t)zhashx_lookup (first, blobref) - 1;
+            if (!(xmls[i] = strdup (xmls[j])))
+                log_msg_exit ("out of memory");
+        }
+        json_decref (treeobjs[i]);
+    }
+    free (treeobjs);
+    zhashx_destroy (&first);
+    return (0);
 }
 
 /*  Lookup topo XML for a single rank using degenerate case of
@@ -349,14 +470,45 @@ static int cmd_info (optparse_t *p, int ac, char *av[])
 /*  flux-hwloc reload:
  */
 
-/*  Add hwloc xml string `xml` to kvs for rank `rank` to a kvs txn
+/*  Add hwloc xml string `xml` to kvs for rank `rank` to a kvs txn.
+ *   The value is first stored in the content store, and the txn
+ *   carries only a reference to it.  Since blobs are named by their
+ *   hash, ranks with identical topology share one blob, which the
+ *   content cache at each level of the TBON forwards upstream only
+ *   once.  The value is the same JSON string that flux_kvs_txn_pack()
+ *   would store, so readers of resource.hwloc.xml.<rank> are unaffected.
  */
-static int kvs_txn_put_xml (flux_kvs_txn_t *txn, uint32_t rank,
-                             const char *xml)
+static int kvs_txn_put_xml (flux_t *h, flux_kvs_txn_t *txn, uint32_t rank,
+                            const char *xml)
 {
     char key [1024];
+    flux_future_t *f = NULL;
+    const char *blobref;
+    json_t *o;
+    char *s = NULL;
+    char *treeobj = NULL;
+    int rc = -1;
+
     snprintf (key, sizeof (key), "%s.%ju", XML_BASEDIR, (uintmax_t) rank);
-    return (flux_kvs_txn_pack (txn, 0, key, "s", xml));
+    if (!(o = json_string (xml)))
+        goto done;
+    s = json_dumps (o, JSON_ENCODE_ANY);
+    json_decref (o);
+    if (!s
+        || !(f = flux_content_store (h, s, strlen (s), 0))
+        || flux_content_store_get (f, &blobref) < 0
+        || !(o = treeobj_create_valref (blobref)))
+        goto done;
+    treeobj = treeobj_encode (o);
+    json_decref (o);
+    if (!treeobj)
+        goto done;
+    rc = flux_kvs_txn_put_treeobj (txn, 0, key, treeobj);
+done:
+    free (treeobj);
+    free (s);
+    flux_future_destroy (f);
+    return (rc);
 }
 
 /*  Add hwloc xml from file at path <basedir>/<rank>.xml to kvs for
@@ -364,7 +516,9 @@ static int kvs_txn_put_xml (flux_kvs_txn_t *txn, uint32_t rank,
  *   so that the common Flux hwloc flags may be applied,  and to check
  *   that the XML is valid before putting it in the kvs.
  */
-static flux_future_t *kvs_txn_put_xml_file (flux_kvs_txn_t *txn, int rank,
+static flux_future_t *kvs_txn_put_xml_file (flux_t *h,
+                                            flux_kvs_txn_t *txn,
+                                            int rank,
                                             const char *basedir)
 {
     char path [8192];
@@ -393,7 +547,7 @@ static flux_future_t *kvs_txn_put_xml_file (flux_kvs_txn_t *txn, int rank,
         log_err_exit ("hwloc_topology_export_xmlbuffer");
     }
 
-    if (kvs_txn_put_xml (txn, rank, xml) < 0)
+    if (kvs_txn_put_xml (h, txn, rank, xml) < 0)
         log_err_exit ("kvs_txn_put_xml");
 
     hwloc_free_xmlbuffer (topo, xml);
@@ -416,7 +570,7 @@ flux_future_t * kvs_load_xml_idset (flux_t *h, const char *basedir,
         log_err_exit ("flux_kvs_txn_create");
 
     while (rank != IDSET_INVALID_ID) {
-        kvs_txn_put_xml_file (txn, rank, basedir);
+        kvs_txn_put_xml_file (h, txn, rank, basedir);
         rank = idset_next (idset, rank);
     }
     if (!(f = flux_kvs_commit (h, NULL, 0, txn)))
@@ -725,7 +879,7 @@ static int kvs_put_xml_fence (flux_t *h, int rank,
     flux_kvs_txn_t *txn = NULL;
 
     if (!(txn = flux_kvs_txn_create ())
-        || (kvs_txn_put_xml (txn, rank, xml) < 0))
+        || (kvs_txn_put_xml (h, txn, rank, xml) < 0))
         log_err_exit ("kvs put xml (rank=%d)", rank);
     if (!(f = flux_kvs_fence (h, NULL, 0, name, nprocs, txn))
         || flux_future_get (f, NULL) < 0)
@@ -30,6 +30,7 @@
 #include <inttypes.h>
 
 #include "src/common/libutil/cleanup.h"
+#include "src/common/libutil/fsd.h"
 #include "src/common/librouter/usock.h"
 #include "src/common/librouter/router.h"
 
@@ -41,6 +42,9 @@ struct proxy_command {
     flux_subprocess_t *p;
     int exit_code;
     uid_t proxy_user;
+    int clients;
+    double idle_timeout;
+    flux_watcher_t *idle_w;     // with --listen and no command
 };
 
 static const char *route_auxkey = "flux::route";
@@ -184,6 +188,26 @@ static int uconn_send (const flux_msg_t *msg, void *arg)
     return usock_conn_send (uconn, msg);
 }
 
+/* No clients have been connected for the idle timeout.
+ */
+static void idle_cb (flux_reactor_t *r,
+                     flux_watcher_t *w,
+                     int revents,
+                     void *arg)
+{
+    flux_reactor_stop (r);
+}
+
+static void uconn_close (struct usock_conn *uconn, void *arg)
+{
+    struct proxy_command *ctx = arg;
+
+    if (--ctx->clients == 0 && ctx->idle_w) {
+        flux_timer_watcher_reset (ctx->idle_w, ctx->idle_timeout, 0.);
+        flux_watcher_start (ctx->idle_w);
+    }
+}
+
 /* Accept a connection from new client.
  * This function must call usock_conn_accept() or usock_conn_reject().
  */
@@ -215,6 +239,9 @@ static void acceptor_cb (struct usock_conn *uconn, void *arg)
     }
     usock_conn_set_error_cb (uconn, uconn_error, ctx);
     usock_conn_set_recv_cb (uconn, uconn_recv, ctx);
+    usock_conn_set_close_cb (uconn, uconn_close, ctx);
+    ctx->clients++;
+    flux_watcher_stop (ctx->idle_w);
     usock_conn_accept (uconn, cred);
     return;
 error:
@@ -230,6 +257,8 @@ static int cmd_proxy (optparse_t *p, int ac, char *av[])
     char workpath[PATH_MAX + 1];
     char sockpath[PATH_MAX + 1];
     const char *uri;
+    const char *listen;
+    const char *timeout;
     int optindex;
     flux_reactor_t *r;
 
@@ -241,6 +270,17 @@ static int cmd_proxy (optparse_t *p, int ac, char *av[])
     uri = av[optindex++];
 
     memset (&ctx, 0, sizeof (ctx));
+    listen = optparse_get_str (p, "listen", NULL);
+    if ((timeout = optparse_get_str (p, "idle-timeout", NULL))) {
+        if (!listen || optindex < ac)
+            log_msg_exit ("--idle-timeout requires --listen and no COMMAND");
+        if (fsd_parse_duration (timeout, &ctx.idle_timeout) < 0)
+            log_msg_exit ("invalid --idle-timeout value");
+    }
+    /* A persistent proxy connects directly, not through another proxy.
+     */
+    if (listen)
+        (void)unsetenv ("FLUX_SSH_PERSIST");
     if (!(ctx.h = flux_open (uri, 0)))
         log_err_exit ("%s", uri);
     flux_log_set_appname (ctx.h, "proxy");
@@ -255,17 +295,24 @@ static int cmd_proxy (optparse_t *p, int ac, char *av[])
     if (!(ctx.router = router_create (ctx.h)))
         log_err_exit ("router_create");
 
-    /* Create socket directory.
+    /* Create socket directory, unless a socket path was given.
      */
-    n = snprintf (workpath, sizeof (workpath), "%s/flux-proxy-XXXXXX",
-                             tmpdir ? tmpdir : "/tmp");
-    assert (n < sizeof (workpath));
-    if (!mkdtemp (workpath))
-        log_err_exit ("error creating proxy socket directory");
-    cleanup_push_string(cleanup_directory, workpath);
-
-    n = snprintf (sockpath, sizeof (sockpath), "%s/local", workpath);
-    assert (n < sizeof (sockpath));
+    if (listen) {
+        if (snprintf (sockpath, sizeof (sockpath), "%s", listen)
+            >= sizeof (sockpath))
+            log_msg_exit ("--listen path is too long");
+    }
+    else {
+        n = snprintf (workpath, sizeof (workpath), "%s/flux-proxy-XXXXXX",
+                                 tmpdir ? tmpdir : "/tmp");
+        assert (n < sizeof (workpath));
+        if (!mkdtemp (workpath))
+            log_err_exit ("error creating proxy socket directory");
+        cleanup_push_string(cleanup_directory, workpath);
+
+        n = snprintf (sockpath, sizeof (sockpath), "%s/local", workpath);
+        assert (n < sizeof (sockpath));
+    }
 
     /* Create listen socket and watcher to handle new connections
      */
@@ -274,9 +321,21 @@ static int cmd_proxy (optparse_t *p, int ac, char *av[])
     cleanup_push_string (cleanup_file, sockpath);
     usock_server_set_acceptor (ctx.server, acceptor_cb, &ctx);
 
-    /* Create child
+    /* Create child, or with --listen and no command, serve clients
+     * until the idle timeout (if any) expires with no clients connected.
      */
-    if (child_create (&ctx, ac - optindex, av + optindex, sockpath) < 0)
+    if (listen && optindex == ac) {
+        if (ctx.idle_timeout > 0.) {
+            if (!(ctx.idle_w = flux_timer_watcher_create (r,
+                                                          ctx.idle_timeout,
+                                                          0.,
+                                                          idle_cb,
+                                                          &ctx)))
+                log_err_exit ("flux_timer_watcher_create");
+            flux_watcher_start (ctx.idle_w);
+        }
+    }
+    else if (child_create (&ctx, ac - optindex, av + optindex, sockpath) < 0)
         log_err_exit ("child_create");
 
     /* Start reactor
@@ -288,6 +347,7 @@ static int cmd_proxy (optparse_t *p, int ac, char *av[])
 done:
     usock_server_destroy (ctx.server); // destroy before router
     router_destroy (ctx.router);
+    flux_watcher_destroy (ctx.idle_w);
 
     if (ctx.exit_code)
         exit (ctx.exit_code);
@@ -296,6 +356,18 @@ done:
     return (0);
 }
 
+static struct optparse_option proxy_opts[] = {
+    { .name = "listen", .has_arg = 1, .arginfo = "PATH",
+      .usage = "Serve clients on socket PATH.  With no COMMAND, keep running"
+               " until interrupted or idle",
+    },
+    { .name = "idle-timeout", .has_arg = 1, .arginfo = "FSD",
+      .usage = "With --listen and no COMMAND, exit once no clients have been"
+               " connected for FSD",
+    },
+    OPTPARSE_TABLE_END
+};
+
 int subcommand_proxy_register (optparse_t *p)
 {
     optparse_err_t e;
@@ -304,7 +376,7 @@ int subcommand_proxy_register (optparse_t *p)
         "[OPTIONS] URI [COMMAND...]",
         "Route messages to/from Flux instance",
         0,
-        NULL);
+        proxy_opts);
     if (e != OPTPARSE_SUCCESS)
         return (-1);
 
@@ -0,0 +1,150 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#include "builtin.h"
+#include <jansson.h>
+
+static int internal_stackprof_start (optparse_t *p, int ac, char *av[])
+{
+    flux_t *h;
+    flux_future_t *f;
+    int frequency = optparse_get_int (p, "frequency", 99);
+    int max_samples = optparse_get_int (p, "max-samples", 10000);
+
+    if (optparse_option_index (p) != ac) {
+        optparse_print_usage (p);
+        exit (1);
+    }
+    if (!(h = builtin_get_flux_handle (p)))
+        log_err_exit ("flux_open");
+    if (!(f = flux_rpc_pack (h, "stackprof.start", FLUX_NODEID_ANY, 0,
+                             "{ s:i s:i }",
+                             "frequency", frequency,
+                             "max-samples", max_samples))
+            || flux_future_get (f, NULL) < 0)
+        log_err_exit ("stackprof.start");
+    flux_future_destroy (f);
+    flux_close (h);
+    return (0);
+}
+
+static int internal_stackprof_stop (optparse_t *p, int ac, char *av[])
+{
+    flux_t *h;
+    flux_future_t *f;
+
+    if (optparse_option_index (p) != ac) {
+        optparse_print_usage (p);
+        exit (1);
+    }
+    if (!(h = builtin_get_flux_handle (p)))
+        log_err_exit ("flux_open");
+    if (!(f = flux_rpc (h, "stackprof.stop", NULL, FLUX_NODEID_ANY, 0))
+            || flux_rpc_get (f, NULL) < 0)
+        log_err_exit ("stackprof.stop");
+    flux_future_destroy (f);
+    flux_close (h);
+    return (0);
+}
+
+/* Print folded stacks, one "frame;...;frame count" per line, which is
+ * the input format of flamegraph.pl.
+ */
+static int internal_stackprof_dump (optparse_t *p, int ac, char *av[])
+{
+    flux_t *h;
+    flux_future_t *f;
+    json_t *stacks;
+    const char *key;
+    json_t *value;
+    int samples, dropped;
+
+    if (optparse_option_index (p) != ac) {
+        optparse_print_usage (p);
+        exit (1);
+    }
+    if (!(h = builtin_get_flux_handle (p)))
+        log_err_exit ("flux_open");
+    if (!(f = flux_rpc (h, "stackprof.get", NULL, FLUX_NODEID_ANY, 0))
+            || flux_rpc_get_unpack (f, "{s:i s:i s:o}",
+                                    "samples", &samples,
+                                    "dropped", &dropped,
+                                    "stacks", &stacks) < 0)
+        log_err_exit ("stackprof.get");
+    json_object_foreach (stacks, key, value) {
+        printf ("%s %lld\n", key, (long long)json_integer_value (value));
+    }
+    if (dropped > 0)
+        log_msg ("%d of %d samples dropped (buffer full)",
+                 dropped, samples + dropped);
+    flux_future_destroy (f);
+    flux_close (h);
+    return (0);
+}
+
+int cmd_stackprof (optparse_t *p, int ac, char *av[])
+{
+    if (optparse_run_subcommand (p, ac, av) != OPTPARSE_SUCCESS)
+        exit (1);
+    return (0);
+}
+
+static struct optparse_option start_opts[] = {
+    { .name = "frequency", .key = 'F', .has_arg = 1, .arginfo = "HZ",
+      .usage = "Sample at HZ per second of CPU time (default 99)",
+    },
+    { .name = "max-samples", .key = 'n', .has_arg = 1, .arginfo = "N",
+      .usage = "Keep at most N samples (default 10000)",
+    },
+    OPTPARSE_TABLE_END
+};
+
+static struct optparse_subcommand stackprof_subcmds[] = {
+    { "start",
+      "[OPTIONS]",
+      "start sampling broker thread stacks",
+      internal_stackprof_start,
+      0,
+      start_opts,
+    },
+    { "stop",
+      NULL,
+      "stop sampling",
+      internal_stackprof_stop,
+      0,
+      NULL,
+    },
+    { "dump",
+      NULL,
+      "print sampled stacks in folded format",
+      internal_stackprof_dump,
+      0,
+      NULL,
+    },
+    OPTPARSE_SUBCMD_END
+};
+
+int subcommand_stackprof_register (optparse_t *p)
+{
+    optparse_err_t e;
+
+    e = optparse_reg_subcommand (p, "stackprof", cmd_stackprof, NULL,
+            "Sample call stacks of flux-broker threads", 0, NULL);
+    if (e != OPTPARSE_SUCCESS)
+        return (-1);
+
+    e = optparse_reg_subcommands (optparse_get_subcommand (p, "stackprof"),
+                                  stackprof_subcmds);
+    return (e == OPTPARSE_SUCCESS ? 0 : -1);
+}
+
+/*
+ * vi: ts=4 sw=4 expandtab
+ */
@@ -29,6 +29,7 @@ struct aggregate_args {
     json_t *o;
     double timeout;
     int fwd_count;
+    const char *reduce;
     bool verbose;
     struct timespec t0;
 };
@@ -45,6 +46,8 @@ static struct optparse_option opts[] = {
       .usage = "Set reduction timeout to T seconds." },
     { .name = "fwd-count", .key = 'c', .arginfo = "N", .has_arg = 1,
       .usage = "Forward aggregate upstream after N" },
+    { .name = "reduce", .key = 'r', .arginfo = "OP", .has_arg = 1,
+      .usage = "Combine values with OP (sum, min, max, or idset)" },
     { .name = "verbose", .key = 'v', .has_arg = 0,
       .usage = "Verbose operation" },
     OPTPARSE_TABLE_END
@@ -190,10 +193,11 @@ static void barrier_continue (flux_future_t *f, void *arg)
     struct aggregate_args *args = arg;
     flux_future_t *f2 = NULL;
     verbose (args, "barrier complete, calling aggregate.push");
-    if (!(f2 = aggregator_push_json (args->h, args->fwd_count, args->timeout,
-                                     args->key, args->o))
+    if (!(f2 = aggregator_push_reduce (args->h, args->fwd_count,
+                                       args->timeout, args->key,
+                                       args->reduce, args->o))
         || (flux_future_then (f2, -1., aggregate_push_continue, arg) < 0))
-        log_err_exit ("aggregator_push_json");
+        log_err_exit ("aggregator_push_reduce");
     flux_future_destroy (f);
 }
 
@@ -227,6 +231,7 @@ int main (int argc, char *argv[])
     args.verbose = optparse_hasopt (p, "verbose");
     args.fwd_count = optparse_get_int (p, "fwd-count", 0);
     args.timeout = optparse_get_duration (p, "timeout", -1.);
+    args.reduce = optparse_get_str (p, "reduce", NULL);
 
     if (!(args.h = flux_open (NULL, 0)))
         log_err_exit ("flux_open");
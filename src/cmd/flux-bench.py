@@ -0,0 +1,336 @@
+##############################################################
+# Copyright 2021 Lawrence Livermore National Security, LLC
+# (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+#
+# This file is part of the Flux resource manager framework.
+# For details, see https://github.com/flux-framework.
+#
+# SPDX-License-Identifier: LGPL-3.0
+##############################################################
+
+import sys
+import json
+import time
+import errno
+import logging
+import argparse
+
+import flux
+import flux.job
+import flux.kvs
+import flux.util
+from flux.constants import FLUX_RPC_STREAMING, FLUX_KVS_APPEND
+from flux.constants import FLUX_KVS_WATCH, FLUX_KVS_WAITCREATE
+from flux.core.inner import ffi
+from flux.job import JobspecV1
+from flux.rpc import RPC
+
+LOGGER = logging.getLogger("flux-bench")
+
+# Number of blobs in the value looked up by the "stream" scenario
+STREAM_BLOBS = 8
+
+
+def percentile(samples, pct):
+    """Return the 'pct' percentile of sorted 'samples' (nearest rank)"""
+    rank = int(round(pct / 100.0 * len(samples) + 0.5))
+    return samples[min(max(rank, 1), len(samples)) - 1]
+
+
+def summarize(samples, elapsed):
+    """Summarize latency 'samples' (seconds), taken over 'elapsed' seconds,
+    as a dict of rate in operations per second and latency in microseconds
+    """
+    samples = sorted(samples)
+    usec = 1e6
+    return {
+        "count": len(samples),
+        "elapsed": elapsed,
+        "rate": len(samples) / elapsed if elapsed > 0 else 0.0,
+        "latency": {
+            "min": samples[0] * usec,
+            "mean": sum(samples) / len(samples) * usec,
+            "p50": percentile(samples, 50) * usec,
+            "p90": percentile(samples, 90) * usec,
+            "p99": percentile(samples, 99) * usec,
+            "max": samples[-1] * usec,
+        },
+    }
+
+
+def timeit(count, func):
+    """Call func(i) 'count' times and return a summary of its latency"""
+    samples = []
+    t0 = time.perf_counter()
+    for i in range(count):
+        start = time.perf_counter()
+        func(i)
+        samples.append(time.perf_counter() - start)
+    return summarize(samples, time.perf_counter() - t0)
+
+
+def padding(args, i):
+    """Return a payload string of args.size bytes, unique for 'i' so the
+    content store does not deduplicate it
+    """
+    prefix = "{}:{}:".format(time.time(), i)
+    return prefix + "x" * max(args.size - len(prefix), 0)
+
+
+def bench_rpc(h, args):
+    """Round trip of a cmb.ping request to the local broker"""
+    payload = {"seq": 0, "pad": "x" * args.size}
+
+    def ping(i):
+        payload["seq"] = i
+        h.rpc("cmb.ping", payload).get()
+
+    return timeit(args.count, ping)
+
+
+def bench_stream(h, args):
+    """Streaming kvs.lookup-stream RPC of a value stored in several blobs"""
+    key = "bench.stream"
+    txn = flux.kvs.RAW.flux_kvs_txn_create()
+    try:
+        flux.kvs.RAW.flux_kvs_txn_unlink(txn, 0, key)
+        for i in range(STREAM_BLOBS):
+            value = json.dumps(padding(args, i))
+            flux.kvs.RAW.flux_kvs_txn_put(txn, FLUX_KVS_APPEND, key, value)
+        future = flux.kvs.RAW.flux_kvs_commit(h, None, 0, txn)
+        flux.kvs.RAW.flux_future_get(future, ffi.NULL)
+        flux.kvs.RAW.flux_future_destroy(future)
+    finally:
+        flux.kvs.RAW.flux_kvs_txn_destroy(txn)
+
+    payload = {"key": key, "namespace": "primary", "flags": 0}
+
+    def stream(i):
+        future = RPC(h, "kvs.lookup-stream", payload, flags=FLUX_RPC_STREAMING)
+        while True:
+            try:
+                future.get()
+            except OSError as exc:
+                if exc.errno == errno.ENODATA:
+                    break
+                raise
+            future.reset()
+
+    return timeit(args.count, stream)
+
+
+def bench_event(h, args):
+    """Publish an event and receive it back on the same handle"""
+    topic = "bench.event"
+    h.event_subscribe(topic)
+    payload = {"seq": 0, "pad": "x" * args.size}
+
+    def pubsub(i):
+        payload["seq"] = i
+        h.event_send(topic, payload)
+        h.event_recv(topic)
+
+    try:
+        return timeit(args.count, pubsub)
+    finally:
+        h.flux_event_unsubscribe(topic.encode("utf-8"))
+
+
+def bench_kvs_commit(h, args):
+    """Put one key and commit it"""
+    def commit(i):
+        flux.kvs.put(h, "bench.commit", padding(args, i))
+        flux.kvs.commit(h)
+
+    return timeit(args.count, commit)
+
+
+def bench_kvs_lookup(h, args):
+    """Look up one key"""
+    key = "bench.lookup"
+    flux.kvs.put(h, key, padding(args, 0))
+    flux.kvs.commit(h)
+    return timeit(args.count, lambda i: flux.kvs.get(h, key))
+
+
+def bench_kvs_watch(h, args):
+    """Time from the start of a commit until a watcher sees its value"""
+    key = "bench.watch"
+    flux.kvs.put(h, key, padding(args, 0))
+    flux.kvs.commit(h)
+    flags = FLUX_KVS_WATCH | FLUX_KVS_WAITCREATE
+    future = flux.kvs.RAW.flux_kvs_lookup(h, None, flags, key)
+    valp = ffi.new("char *[1]")
+    try:
+        # the first response is the current value
+        flux.kvs.RAW.flux_kvs_lookup_get(future, valp)
+        flux.kvs.RAW.flux_future_reset(future)
+
+        def watch(i):
+            flux.kvs.put(h, key, padding(args, i + 1))
+            flux.kvs.commit(h)
+            flux.kvs.RAW.flux_kvs_lookup_get(future, valp)
+            flux.kvs.RAW.flux_future_reset(future)
+
+        return timeit(args.count, watch)
+    finally:
+        flux.kvs.RAW.flux_future_destroy(future)
+
+
+def bench_content(h, args):
+    """Time a content.store followed by a content.load of the same blob"""
+
+    def store_load(i):
+        blobref = h.rpc("content.store", padding(args, i)).get_raw()
+        h.rpc("content.load", blobref).get_raw()
+
+    return timeit(args.count, store_load)
+
+
+def jobspec():
+    spec = JobspecV1.from_command(["true"])
+    spec.cwd = "/"
+    spec.environment = {}
+    return spec.dumps()
+
+
+def bench_job_latency(h, args):
+    """Time from submission until a job has started, one job at a time"""
+    spec = jobspec()
+    samples = []
+    t0 = time.perf_counter()
+    for i in range(args.count):
+        start = time.perf_counter()
+        jobid = flux.job.submit(h, spec, waitable=True)
+        flux.job.event_wait(h, jobid, "start")
+        samples.append(time.perf_counter() - start)
+        flux.job.wait(h, jobid)
+    return summarize(samples, time.perf_counter() - t0)
+
+
+def bench_job_throughput(h, args):
+    """Submit all jobs up front, then time each until it is complete"""
+    spec = jobspec()
+    t0 = time.perf_counter()
+    futures = [
+        flux.job.submit_async(h, spec, waitable=True) for i in range(args.count)
+    ]
+    for future in futures:
+        future.get_id()
+    samples = []
+    for i in range(args.count):
+        result = flux.job.wait(h)
+        if not result.success:
+            raise OSError(errno.EIO, result.errstr.decode("utf-8", "replace"))
+        samples.append(time.perf_counter() - t0)
+    return summarize(samples, time.perf_counter() - t0)
+
+
+SCENARIOS = {
+    "rpc": bench_rpc,
+    "stream": bench_stream,
+    "event": bench_event,
+    "kvs-commit": bench_kvs_commit,
+    "kvs-lookup": bench_kvs_lookup,
+    "kvs-watch": bench_kvs_watch,
+    "content": bench_content,
+    "job-latency": bench_job_latency,
+    "job-throughput": bench_job_throughput,
+}
+
+
+def list_scenarios(args):
+    for name, func in SCENARIOS.items():
+        print("{:<16} {}".format(name, func.__doc__.splitlines()[0]))
+
+
+def run(args):
+    unknown = [name for name in args.scenario if name not in SCENARIOS]
+    if unknown:
+        LOGGER.error("unknown scenario: %s", ", ".join(unknown))
+        sys.exit(1)
+    names = args.scenario or [
+        name for name in SCENARIOS if not name.startswith("job-")
+    ]
+    h = flux.Flux()
+    results = {}
+    for name in names:
+        if args.warmup > 0:
+            warmup = argparse.Namespace(**vars(args))
+            warmup.count = args.warmup
+            SCENARIOS[name](h, warmup)
+        results[name] = SCENARIOS[name](h, args)
+    output = {
+        "version": h.attr_get("version"),
+        "size": int(h.attr_get("size")),
+        "count": args.count,
+        "warmup": args.warmup,
+        "payload-size": args.size,
+        "scenarios": results,
+    }
+    json.dump(output, sys.stdout, indent=args.indent)
+    sys.stdout.write("\n")
+
+
+@flux.util.CLIMain(LOGGER)
+def main():
+    parser = argparse.ArgumentParser(
+        prog="flux-bench", formatter_class=flux.util.help_formatter()
+    )
+    parser.add_argument(
+        "-n",
+        "--count",
+        type=int,
+        metavar="N",
+        default=1000,
+        help="Number of operations per scenario (default: %(default)s)",
+    )
+    parser.add_argument(
+        "-s",
+        "--size",
+        type=int,
+        metavar="BYTES",
+        default=0,
+        help="Payload size in bytes (default: %(default)s)",
+    )
+    parser.add_argument(
+        "-w",
+        "--warmup",
+        type=int,
+        metavar="N",
+        default=10,
+        help="Untimed operations before each scenario (default: %(default)s)",
+    )
+    parser.add_argument(
+        "-i",
+        "--indent",
+        type=int,
+        metavar="N",
+        default=None,
+        help="Indent JSON output by N spaces",
+    )
+    parser.add_argument(
+        "-l", "--list", action="store_true", help="List scenarios and exit",
+    )
+    parser.add_argument(
+        "scenario",
+        nargs="*",
+        help="Scenarios to run (default: all except job-*)",
+    )
+    args = parser.parse_args()
+    if args.count < 1:
+        LOGGER.error("--count must be at least 1")
+        sys.exit(1)
+    if args.size < 0:
+        LOGGER.error("--size must not be negative")
+        sys.exit(1)
+    if args.list:
+        list_scenarios(args)
+    else:
+        run(args)
+
+
+if __name__ == "__main__":
+    main()
+
+# vi: ts=4 sw=4 expandtab
@@ -24,6 +24,8 @@
 #include "src/common/libutil/monotime.h"
 #include "src/common/libidset/idset.h"
 #include "src/common/libutil/log.h"
+#include "src/common/libioencode/ioencode.h"
+#include "src/common/libsubprocess/command.h"
 
 static struct optparse_option cmdopts[] = {
     { .name = "rank", .key = 'r', .has_arg = 1, .arginfo = "IDSET",
@@ -38,6 +40,10 @@ static struct optparse_option cmdopts[] = {
       .usage = "Redirect stdin from /dev/null" },
     { .name = "verbose", .key = 'v', .has_arg = 0,
       .usage = "Run with more verbosity." },
+    { .name = "tree", .key = 't', .has_arg = 0,
+      .usage = "Distribute the command over the TBON, and merge identical "
+               "output lines, labeled with the RANKS that output them "
+               "(implies --noinput)" },
     OPTPARSE_TABLE_END
 };
 
@@ -58,6 +64,8 @@ optparse_t *opts = NULL;
 int stdin_flags;
 flux_watcher_t *stdin_w;
 
+flux_future_t *fanout_f;
+
 /* time to wait in between SIGINTs */
 #define INTERRUPT_MILLISECS 1000.0
 
@@ -84,6 +92,29 @@ void idset_destroy_wrapper (void *data)
     idset_destroy (idset);
 }
 
+/* Add 'ranks' to the idset for exit status 'key'.
+ */
+void exitsets_add (const char *key, const struct idset *ranks)
+{
+    struct idset *idset;
+    unsigned int id;
+
+    if (!(idset = zhashx_lookup (exitsets, key))) {
+        if (!(idset = idset_create (rank_range, 0)))
+            log_err_exit ("idset_create");
+        if (zhashx_insert (exitsets, key, idset) < 0)
+            log_err_exit ("zhashx_insert");
+        if (!zhashx_freefn (exitsets, key, idset_destroy_wrapper))
+            log_err_exit ("zhashx_freefn");
+    }
+    id = idset_first (ranks);
+    while (id != IDSET_INVALID_ID) {
+        if (idset_set (idset, id) < 0)
+            log_err_exit ("idset_set");
+        id = idset_next (ranks, id);
+    }
+}
+
 void completion_cb (flux_subprocess_t *p)
 {
     int rank = flux_subprocess_rank (p);
@@ -107,17 +138,12 @@ void completion_cb (flux_subprocess_t *p)
             sprintf (buf, "Exit %d", ec);
 
         /* use exit code as key for hash */
-        if (!(idset = zhashx_lookup (exitsets, buf))) {
-            if (!(idset = idset_create (rank_range, 0)))
-                log_err_exit ("idset_create");
-            if (zhashx_insert (exitsets, buf, idset) < 0)
-                log_err_exit ("zhashx_insert");
-            if (!zhashx_freefn (exitsets, buf, idset_destroy_wrapper))
-                log_err_exit ("zhashx_freefn");
-        }
-
+        if (!(idset = idset_create (0, IDSET_FLAG_AUTOGROW)))
+            log_err_exit ("idset_create");
         if (idset_set (idset, rank) < 0)
             log_err_exit ("idset_set");
+        exitsets_add (buf, idset);
+        idset_destroy (idset);
     }
 
     if (idset_clear (hanging, rank) < 0)
@@ -230,6 +256,119 @@ static void stdin_cb (flux_reactor_t *r, flux_watcher_t *w,
     }
 }
 
+/* --tree: print merged output lines, and record merged exit status.
+ */
+static void fanout_output (json_t *lines)
+{
+    size_t index;
+    json_t *o;
+
+    json_array_foreach (lines, index, o) {
+        const char *stream, *ranks;
+        char *data;
+        int len;
+        bool eof;
+
+        if (iodecode (o, &stream, &ranks, &data, &len, &eof) < 0)
+            log_msg_exit ("error decoding output");
+        if (len > 0) {
+            FILE *fstream = !strcmp (stream, "stderr") ? stderr : stdout;
+            fprintf (fstream, "%s: ", ranks);
+            fwrite (data, len, 1, fstream);
+        }
+        free (data);
+    }
+}
+
+static void fanout_status (json_t *status)
+{
+    size_t index;
+    json_t *o;
+
+    json_array_foreach (status, index, o) {
+        const char *ranks, *msg;
+        struct idset *idset;
+        int code;
+
+        if (json_unpack (o, "{s:s s:i s:s}",
+                         "ranks", &ranks,
+                         "code", &code,
+                         "msg", &msg) < 0
+            || !(idset = idset_decode (ranks)))
+            log_msg_exit ("error decoding status");
+        exitsets_add (msg, idset);
+        if (code > exit_code)
+            exit_code = code;
+        idset_destroy (idset);
+    }
+}
+
+static void fanout_cb (flux_future_t *f, void *arg)
+{
+    const char *type;
+    json_t *o;
+
+    if (flux_rpc_get_unpack (f, "{s:s}", "type", &type) < 0) {
+        if (errno != ENODATA)
+            log_msg_exit ("%s", future_strerror (f, errno));
+        flux_future_destroy (f);
+        fanout_f = NULL;
+        exited = rank_count;
+        return;
+    }
+    if (!strcmp (type, "output")) {
+        if (flux_rpc_get_unpack (f, "{s:o}", "lines", &o) < 0)
+            log_err_exit ("error decoding output response");
+        fanout_output (o);
+    }
+    else if (!strcmp (type, "status")) {
+        if (flux_rpc_get_unpack (f, "{s:o}", "status", &o) < 0)
+            log_err_exit ("error decoding status response");
+        fanout_status (o);
+    }
+    flux_future_reset (f);
+}
+
+static void fanout_start (flux_t *h, flux_cmd_t *cmd, struct idset *ns)
+{
+    char *cmd_str;
+    char *ranks;
+
+    if (!(cmd_str = flux_cmd_tojson (cmd)))
+        log_err_exit ("flux_cmd_tojson");
+    if (!(ranks = idset_encode (ns, IDSET_FLAG_RANGE)))
+        log_err_exit ("idset_encode");
+    if (!(fanout_f = flux_rpc_pack (h,
+                                    "cmb.rexec.fanout",
+                                    0,
+                                    FLUX_RPC_STREAMING,
+                                    "{s:s s:s}",
+                                    "cmd", cmd_str,
+                                    "ranks", ranks))
+        || flux_future_then (fanout_f, -1., fanout_cb, NULL) < 0)
+        log_err_exit ("error sending fanout request");
+    free (ranks);
+    free (cmd_str);
+}
+
+static void fanout_signal (int signum)
+{
+    flux_t *h = flux_future_get_flux (fanout_f);
+    flux_future_t *f;
+
+    if (!(f = flux_rpc_pack (h,
+                             "cmb.rexec.fanout-signal",
+                             0,
+                             FLUX_RPC_NORESPONSE,
+                             "{s:i s:i}",
+                             "signum", signum,
+                             "matchtag", (int)flux_rpc_get_matchtag (fanout_f)))) {
+        if (optparse_getopt (opts, "verbose", NULL) > 0)
+            fprintf (stderr, "failed to send signal: %s\n", strerror (errno));
+    }
+    flux_future_destroy (f);
+}
+
 static void signal_cb (int signum)
 {
     flux_subprocess_t *p = zlist_first (subprocesses);
@@ -237,6 +376,10 @@ static void signal_cb (int signum)
     if (signum == SIGINT) {
         if (sigint_count >= 2) {
             double since_last = monotime_since (last);
+            if (since_last < INTERRUPT_MILLISECS && fanout_f) {
+                fprintf (stderr, "command may still be running at exit\n");
+                exit (1);
+            }
             if (since_last < INTERRUPT_MILLISECS) {
                 int flags = IDSET_FLAG_BRACKETS | IDSET_FLAG_RANGE;
                 char *idset_str;
@@ -252,7 +395,13 @@ static void signal_cb (int signum)
         }
     }
 
-    if (optparse_getopt (opts, "verbose", NULL) > 0)
+    if (fanout_f) {
+        if (optparse_getopt (opts, "verbose", NULL) > 0)
+            fprintf (stderr, "sending signal %d to all ranks\n", signum);
+        fanout_signal (signum);
+        p = NULL;
+    }
+    else if (optparse_getopt (opts, "verbose", NULL) > 0)
         fprintf (stderr, "sending signal %d to %d running processes\n",
                  signum, started - exited);
 
@@ -399,7 +548,12 @@ int main (int argc, char *argv[])
     if (!(exitsets = zhashx_new ()))
         log_err_exit ("zhashx_new()");
 
-    rank = idset_first (ns);
+    if (optparse_hasopt (opts, "tree")) {
+        fanout_start (h, cmd, ns);
+        rank = IDSET_INVALID_ID;
+    }
+    else
+        rank = idset_first (ns);
     while (rank != IDSET_INVALID_ID) {
         flux_subprocess_t *p;
         if (!(p = flux_rexec (h, rank, 0, cmd, &ops)))
@@ -416,7 +570,7 @@ int main (int argc, char *argv[])
 
     /* -n,--noinput: close subprocess stdin
      */
-    if (optparse_getopt (opts, "noinput", NULL) > 0) {
+    if (optparse_getopt (opts, "noinput", NULL) > 0 || fanout_f) {
         flux_subprocess_t *p;
         p = zlist_first (subprocesses);
         while (p) {
@@ -289,6 +289,17 @@ static struct optparse_option wait_event_opts[] =  {
       .usage = "Specify alternate eventlog path suffix "
                "(e.g. \"guest.exec.eventlog\")",
     },
+    { .name = "start", .key = 's', .has_arg = 1, .arginfo = "N",
+      .usage = "Skip the first N events, or if N < 0, start with the "
+               "last -N events",
+    },
+    OPTPARSE_TABLE_END
+};
+
+static struct optparse_option stats_opts[] =  {
+    { .name = "latency", .key = 'l', .has_arg = 0,
+      .usage = "Show job submit-to-start latency by pipeline stage",
+    },
     OPTPARSE_TABLE_END
 };
 
@@ -325,7 +336,7 @@ static struct optparse_subcommand subcommands[] = {
       NULL,
     },
     { "priority",
-      "[OPTIONS] id priority",
+      "[OPTIONS] id [id...] priority",
       "Set job priority",
       cmd_priority,
       0,
@@ -360,8 +371,8 @@ static struct optparse_subcommand subcommands[] = {
       raiseall_opts,
     },
     { "kill",
-      "[OPTIONS] id",
-      "Send signal to running job",
+      "[OPTIONS] id [id...]",
+      "Send signal to running job(s)",
       cmd_kill,
       0,
       kill_opts,
@@ -424,11 +435,11 @@ static struct optparse_subcommand subcommands[] = {
       NULL
     },
     { "stats",
-      NULL,
+      "[--latency]",
       "Get current job stats",
       cmd_stats,
       0,
-      NULL
+      stats_opts
     },
     { "namespace",
       "[id ...]",
@@ -611,6 +622,48 @@ uint32_t parse_arg_userid (optparse_t *p, const char *optname)
     return userid;
 }
 
+/* Parse 'argc' jobids from 'argv' into a JSON array.
+ */
+static json_t *parse_jobid_array (int argc, char **argv)
+{
+    json_t *ids;
+    int i;
+
+    if (!(ids = json_array ()))
+        log_msg_exit ("out of memory");
+    for (i = 0; i < argc; i++) {
+        json_t *o = json_integer (parse_jobid (argv[i]));
+        if (!o || json_array_append_new (ids, o) < 0)
+            log_msg_exit ("out of memory");
+    }
+    return ids;
+}
+
+/* Handle the {"count":i, "errors":i} response of a bulk request 'f'
+ * for 'nids' jobs.  Return 0 if all jobs were acted upon, else -1.
+ */
+static int bulk_response (flux_future_t *f, const char *name, int nids)
+{
+    int count;
+    int errors;
+
+    if (flux_rpc_get_unpack (f,
+                             "{s:i s:i}",
+                             "count",
+                             &count,
+                             "errors",
+                             &errors) < 0)
+        log_msg_exit ("%s: %s", name, future_strerror (f, errno));
+    if (count < nids)
+        log_msg ("%s: %d of %d jobs not found or not eligible",
+                 name,
+                 nids - count,
+                 nids);
+    if (errors > 0)
+        log_msg ("%s: %d errors", name, errors);
+    return (count < nids || errors > 0) ? -1 : 0;
+}
+
 int cmd_priority (optparse_t *p, int argc, char **argv)
 {
     int optindex = optparse_option_index (p);
@@ -619,17 +672,45 @@ int cmd_priority (optparse_t *p, int argc, char **argv)
     int priority;
     flux_jobid_t id;
     const char *jobid = NULL;
+    int rc = 0;
 
-    if (optindex != argc - 2) {
+    if (argc - optindex < 2) {
         optparse_print_usage (p);
         exit (1);
     }
     if (!(h = flux_open (NULL, 0)))
         log_err_exit ("flux_open");
 
+    priority = parse_arg_unsigned (argv[argc - 1], "priority");
+    if (argc - optindex > 2) {
+        json_t *ids = parse_jobid_array (argc - optindex - 1,
+                                         argv + optindex);
+        int nids = json_array_size (ids);
+
+        if (!(f = flux_rpc_pack (h,
+                                 "job-manager.priorityall",
+                                 FLUX_NODEID_ANY,
+                                 0,
+                                 "{s:b s:i s:i s:i s:o}",
+                                 "dry_run",
+                                 0,
+                                 "userid",
+                                 FLUX_USERID_UNKNOWN,
+                                 "states",
+                                 FLUX_JOB_ACTIVE,
+                                 "priority",
+                                 priority,
+                                 "ids",
+                                 ids)))
+            log_err_exit ("error sending priorityall request");
+        if (bulk_response (f, "priority", nids) < 0)
+            rc = 1;
+        flux_future_destroy (f);
+        flux_close (h);
+        return rc;
+    }
     jobid = argv[optindex++];
     id = parse_jobid (jobid);
-    priority = parse_arg_unsigned (argv[optindex++], "priority");
 
     if (!(f = flux_job_set_priority (h, id, priority)))
         log_err_exit ("flux_job_set_priority");
@@ -864,15 +945,40 @@ int cmd_kill (optparse_t *p, int argc, char **argv)
         exit (1);
     }
 
-    jobid = argv[optindex++];
-    id = parse_jobid (jobid);
-
     s = optparse_get_str (p, "signal", "SIGTERM");
     if ((signum = str2signum (s))< 0)
         log_msg_exit ("kill: Invalid signal %s", s);
 
     if (!(h = flux_open (NULL, 0)))
         log_err_exit ("flux_open");
+    if (argc - optindex > 1) {
+        json_t *ids = parse_jobid_array (argc - optindex, argv + optindex);
+        int nids = json_array_size (ids);
+        int rc = 0;
+
+        if (!(f = flux_rpc_pack (h,
+                                 "job-manager.killall",
+                                 FLUX_NODEID_ANY,
+                                 0,
+                                 "{s:b s:i s:i s:o}",
+                                 "dry_run",
+                                 0,
+                                 "userid",
+                                 FLUX_USERID_UNKNOWN,
+                                 "signum",
+                                 signum,
+                                 "ids",
+                                 ids)))
+            log_err_exit ("error sending killall request");
+        if (bulk_response (f, "kill", nids) < 0)
+            rc = 1;
+        flux_future_destroy (f);
+        flux_close (h);
+        return rc;
+    }
+    jobid = argv[optindex++];
+    id = parse_jobid (jobid);
+
     if (!(f = flux_job_kill (h, id, signum)))
         log_err_exit ("flux_job_kill");
     if (flux_rpc_get (f, NULL) < 0)
@@ -1354,9 +1460,21 @@ static void handle_output_data (struct attach_ctx *ctx, json_t *context)
     else
         fp = stderr;
     if (len > 0) {
-        if (optparse_hasopt (ctx->p, "label-io"))
-            fprintf (fp, "%s: ", rank);
-        fwrite (data, len, 1, fp);
+        struct idset *ranks;
+        unsigned int id;
+        /* The shell may merge identical output from several tasks into
+         * one entry with an idset "rank".  Write it once per task.
+         */
+        if (!(ranks = idset_decode (rank)))
+            log_msg_exit ("malformed event context rank");
+        id = idset_first (ranks);
+        while (id != IDSET_INVALID_ID) {
+            if (optparse_hasopt (ctx->p, "label-io"))
+                fprintf (fp, "%u: ", id);
+            fwrite (data, len, 1, fp);
+            id = idset_next (ranks, id);
+        }
+        idset_destroy (ranks);
     }
     free (data);
 }
@@ -2690,8 +2808,12 @@ int cmd_wait_event (optparse_t *p, int argc, char **argv)
         *ctx.context_value++ = '\0';
     }
 
-    if (!(f = flux_job_event_watch (h, ctx.id, ctx.path, 0)))
-        log_err_exit ("flux_job_event_watch");
+    if (!(f = flux_job_event_watch_from (h,
+                                         ctx.id,
+                                         ctx.path,
+                                         0,
+                                         optparse_get_int (p, "start", 0))))
+        log_err_exit ("flux_job_event_watch_from");
     if (flux_future_then (f, ctx.timeout, wait_event_continuation, &ctx) < 0)
         log_err_exit ("flux_future_then");
     if (flux_reactor_run (flux_get_reactor (h), 0) < 0)
@@ -2784,6 +2906,97 @@ int cmd_info (optparse_t *p, int argc, char **argv)
     return (0);
 }
 
+/* Estimate percentile 'pct' of a log2 histogram of microsecond
+ * durations (see loghist.h) as the upper bound of the bucket that holds
+ * it, but no more than 'max' seconds.
+ */
+static double hist_percentile (json_t *hist, int count, double max, double pct)
+{
+    size_t index;
+    json_t *value;
+    json_int_t seen = 0;
+
+    json_array_foreach (hist, index, value) {
+        seen += json_integer_value (value);
+        if (seen > 0 && seen >= pct / 100. * count) {
+            double t = 1E-6 * (1ULL << index);
+            return t < max ? t : max;
+        }
+    }
+    return max;
+}
+
+static void print_latency (const char *stage, json_t *stats)
+{
+    int count;
+    double total, max;
+    json_t *hist;
+
+    if (!stats)
+        return;
+    if (json_unpack (stats, "{s:i s:F s:F s:o}",
+                            "count", &count,
+                            "total", &total,
+                            "max", &max,
+                            "hist", &hist) < 0)
+        log_msg_exit ("error decoding %s latency", stage);
+    if (count == 0) {
+        printf ("%-12s %8d %10s %10s %10s %10s %10s\n",
+                stage, count, "-", "-", "-", "-", "-");
+        return;
+    }
+    printf ("%-12s %8d %10.3f %10.3f %10.3f %10.3f %10.3f\n",
+            stage,
+            count,
+            1E3 * total / count,
+            1E3 * hist_percentile (hist, count, max, 50),
+            1E3 * hist_percentile (hist, count, max, 90),
+            1E3 * hist_percentile (hist, count, max, 99),
+            1E3 * max);
+}
+
+/* Show the latency of each stage of the submit-to-start pipeline, in
+ * order, from job-manager and job-exec stats.  Percentiles are bucket
+ * upper bounds, so they overestimate by up to a factor of two.
+ */
+static void stats_latency (flux_t *h)
+{
+    const char *stages[] = {
+        "validate", "ingest", "depend", "queue", "sched", "exec", NULL,
+    };
+    flux_future_t *f;
+    flux_future_t *f_exec;
+    json_t *latency;
+    json_t *exec_latency = NULL;
+
+    if (!(f = flux_rpc (h, "job-manager.stats.get", NULL, FLUX_NODEID_ANY, 0))
+        || !(f_exec = flux_rpc (h, "job-exec.stats.get", NULL,
+                                FLUX_NODEID_ANY, 0)))
+        log_err_exit ("flux_rpc");
+    if (flux_rpc_get_unpack (f, "{s:o}", "latency", &latency) < 0)
+        log_msg_exit ("job-manager.stats.get: %s", future_strerror (f, errno));
+    /* job-exec is optional, e.g. with an alternate exec service */
+    if (flux_rpc_get_unpack (f_exec, "{s:o}", "latency", &exec_latency) < 0
+        && errno != ENOSYS)
+        log_msg_exit ("job-exec.stats.get: %s",
+                      future_strerror (f_exec, errno));
+
+    printf ("%-12s %8s %10s %10s %10s %10s %10s\n",
+            "STAGE", "COUNT", "MEAN(ms)", "P50(ms)", "P90(ms)", "P99(ms)",
+            "MAX(ms)");
+    for (int i = 0; stages[i] != NULL; i++)
+        print_latency (stages[i], json_object_get (latency, stages[i]));
+    if (exec_latency) {
+        print_latency ("exec.init", json_object_get (exec_latency, "init"));
+        print_latency ("exec.launch",
+                       json_object_get (exec_latency, "launch"));
+    }
+    print_latency ("total", json_object_get (latency, "total"));
+
+    flux_future_destroy (f_exec);
+    flux_future_destroy (f);
+}
+
 int cmd_stats (optparse_t *p, int argc, char **argv)
 {
     flux_t *h;
@@ -2794,6 +3007,12 @@ int cmd_stats (optparse_t *p, int argc, char **argv)
     if (!(h = flux_open (NULL, 0)))
         log_err_exit ("flux_open");
 
+    if (optparse_hasopt (p, "latency")) {
+        stats_latency (h);
+        flux_close (h);
+        return (0);
+    }
+
     if (!(f = flux_rpc (h, topic, NULL, FLUX_NODEID_ANY, 0)))
         log_err_exit ("flux_rpc");
     if (flux_rpc_get (f, &s) < 0)
@@ -2812,6 +3031,10 @@ static char *to_f58 (flux_jobid_t id, char *buf, int len)
     return buf;
 }
 
+/* Maximum number of jobs reaped per wait request with --all.
+ */
+static const int wait_batch_max = 1024;
+
 int cmd_wait (optparse_t *p, int argc, char **argv)
 {
     flux_t *h;
@@ -2837,30 +3060,42 @@ int cmd_wait (optparse_t *p, int argc, char **argv)
         log_err_exit ("flux_open");
     if (optparse_hasopt (p, "all")) {
         for (;;) {
-            if (!(f = flux_job_wait (h, FLUX_JOBID_ANY)))
-                log_err_exit ("flux_job_wait");
-            if (flux_job_wait_get_status (f, &success, &errstr) < 0) {
+            json_t *jobs;
+            size_t index;
+            json_t *entry;
+
+            if (!(f = flux_job_wait_batch (h, wait_batch_max)))
+                log_err_exit ("flux_job_wait_batch");
+            if (flux_rpc_get_unpack (f, "{s:o}", "jobs", &jobs) < 0) {
                 if (errno == ECHILD) { // no more waitable jobs
                     flux_future_destroy (f);
                     break;
                 }
-                log_msg_exit ("flux_job_wait_get_status: %s",
+                log_msg_exit ("flux_job_wait_batch: %s",
                               future_strerror (f, errno));
             }
-            if (flux_job_wait_get_id (f, &id) < 0)
-                log_msg_exit ("flux_job_wait_get_id: %s",
-                              future_strerror (f, errno));
-            if (!success) {
-                fprintf (stderr, "%s: %s\n",
-                         to_f58 (id, buf, sizeof (buf)),
-                         errstr);
-                rc = 1;
-            }
-            else {
-                if (optparse_hasopt (p, "verbose"))
-                    fprintf (stderr,
-                             "%s: job completed successfully\n",
-                             to_f58 (id, buf, sizeof (buf)));
+            json_array_foreach (jobs, index, entry) {
+                json_int_t jobid;
+                int ok;
+
+                if (json_unpack (entry, "{s:I s:b s:s}",
+                                 "id", &jobid,
+                                 "success", &ok,
+                                 "errstr", &errstr) < 0)
+                    log_msg_exit ("flux_job_wait_batch: malformed response");
+                id = jobid;
+                if (!ok) {
+                    fprintf (stderr, "%s: %s\n",
+                             to_f58 (id, buf, sizeof (buf)),
+                             errstr);
+                    rc = 1;
+                }
+                else {
+                    if (optparse_hasopt (p, "verbose"))
+                        fprintf (stderr,
+                                 "%s: job completed successfully\n",
+                                 to_f58 (id, buf, sizeof (buf)));
+                }
             }
             flux_future_destroy (f);
         }
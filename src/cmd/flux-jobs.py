@@ -307,16 +307,23 @@ def fetch_jobs_ids(flux_handle, args, attrs):
     return cbargs["jobs"]
 
 
-def fetch_jobs_all(flux_handle, args, attrs, userid, states, results):
-    rpc_handle = flux.job.job_list(
-        flux_handle, args.count, list(attrs), userid, states, results
-    )
+def fetch_jobs_all(flux_handle, args, attrs, userid, states, results, since):
+    #  Jobs are streamed, so rows may be displayed as they arrive.
+    #  Filtering by name and time is done by job-info, like the rest.
     try:
-        jobs = rpc_handle.get_jobs()
+        yield from flux.job.job_list_stream(
+            flux_handle,
+            args.count,
+            list(attrs),
+            userid,
+            states,
+            results,
+            name=args.name,
+            since=since,
+        )
     except EnvironmentError as err:
         print("{}: {}".format("rpc", err.strerror), file=sys.stderr)
         sys.exit(1)
-    return jobs
 
 
 def calc_filters(args):
@@ -412,6 +419,17 @@ def fetch_jobs_flux(args, fields):
     if args.a or args.A:
         args.filter = "pending,running,inactive"
 
+    since = 0.0
+    if args.since:
+        try:
+            since = time.time() - flux.util.parse_fsd(args.since)
+        except ValueError:
+            print("invalid --since duration: " + args.since, file=sys.stderr)
+            sys.exit(1)
+        #  --since is about inactive jobs, so list them unless filtered out
+        if args.filter == "pending,running":
+            args.filter = "pending,running,inactive"
+
     if args.user == "all":
         userid = flux.constants.FLUX_USERID_UNKNOWN
     else:
@@ -426,20 +444,20 @@ def fetch_jobs_flux(args, fields):
 
     (states, results) = calc_filters(args)
 
-    jobs = fetch_jobs_all(flux_handle, args, attrs, userid, states, results)
+    jobs = fetch_jobs_all(flux_handle, args, attrs, userid, states, results, since)
     return jobs
 
 
 def fetch_jobs(args, fields):
     """
     Fetch jobs from flux or optionally stdin.
-    Returns a list of JobInfo objects
+    Returns an iterator of JobInfo objects
     """
     if args.from_stdin:
         lst = fetch_jobs_stdin()
     else:
         lst = fetch_jobs_flux(args, fields)
-    return [JobInfo(job) for job in lst]
+    return (JobInfo(job) for job in lst)
 
 
 class FilterAction(argparse.Action):
@@ -504,6 +522,24 @@ def parse_args():
         default="pending,running",
         help="List jobs with specific job state or result",
     )
+    parser.add_argument(
+        "--name",
+        action=FilterAction,
+        type=str,
+        metavar="GLOB",
+        default=None,
+        help="Limit output to jobs with a name matching GLOB",
+    )
+    parser.add_argument(
+        "--since",
+        action=FilterAction,
+        type=str,
+        metavar="FSD",
+        default=None,
+        help="Limit output of inactive jobs to those that became inactive "
+        "within the last FSD (e.g. 1h). Implies inactive jobs are listed "
+        "if --filter is not given",
+    )
     parser.add_argument(
         "-n",
         "--suppress-header",
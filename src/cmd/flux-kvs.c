@@ -43,8 +43,6 @@ int cmd_getroot (optparse_t *p, int argc, char **argv);
 int cmd_eventlog (optparse_t *p, int argc, char **argv);
 
 static int get_window_width (optparse_t *p, int fd);
-static void dump_kvs_dir (const flux_kvsdir_t *dir, int maxcol,
-                          const char *ns, bool Ropt, bool dopt);
 
 #define min(a,b) ((a)<(b)?(a):(b))
 
@@ -98,6 +96,9 @@ static struct optparse_option get_opts[] =  {
     { .name = "count", .key = 'c', .has_arg = 1, .arginfo = "COUNT",
       .usage = "Display at most COUNT changes",
     },
+    { .name = "stream", .key = 'S', .has_arg = 0,
+      .usage = "Stream raw value one part at a time",
+    },
     OPTPARSE_TABLE_END
 };
 
@@ -318,7 +319,7 @@ static struct optparse_subcommand subcommands[] = {
       mkdir_opts
     },
     { "copy",
-      "[-S src-ns] [-D dst-ns] source destination",
+      "[-S src-ns] [-D dst-ns] source destination [source destination...]",
       "Copy source key to destination key",
       cmd_copy,
       0,
@@ -440,7 +441,10 @@ int cmd_namespace_create (optparse_t *p, int argc, char **argv)
     flux_future_t *f;
     int optindex, i;
     uint32_t owner = FLUX_USERID_UNKNOWN;
+    uint32_t rank = 0;
+    int flags = 0;
     const char *str;
+    const char *clone;
 
     optindex = optparse_option_index (p);
     if ((optindex - argc) == 0) {
@@ -448,6 +452,9 @@ int cmd_namespace_create (optparse_t *p, int argc, char **argv)
         exit (1);
     }
 
+    if (optparse_hasopt (p, "ephemeral"))
+        flags |= FLUX_KVS_NAMESPACE_EPHEMERAL;
+
     if ((str = optparse_get_str (p, "owner", NULL))) {
         char *endptr;
         owner = strtoul (str, &endptr, 10);
@@ -455,11 +462,24 @@ int cmd_namespace_create (optparse_t *p, int argc, char **argv)
             log_msg_exit ("--owner requires an unsigned integer argument");
     }
 
+    if ((str = optparse_get_str (p, "rank", NULL))) {
+        char *endptr;
+        rank = strtoul (str, &endptr, 10);
+        if (*endptr != '\0')
+            log_msg_exit ("--rank requires an unsigned integer argument");
+    }
+
+    if ((clone = optparse_get_str (p, "clone", NULL))
+        && (flags != 0 || rank != 0))
+        log_msg_exit ("--clone cannot be used with --ephemeral or --rank");
+
     for (i = optindex; i < argc; i++) {
         const char *name = argv[i];
-        int flags = 0;
-        if (!(f = flux_kvs_namespace_create (h, name, owner, flags))
-            || flux_future_get (f, NULL) < 0)
+        if (clone)
+            f = flux_kvs_namespace_clone (h, clone, name, owner);
+        else
+            f = flux_kvs_namespace_create_rank (h, name, owner, rank, flags);
+        if (!f || flux_future_get (f, NULL) < 0)
             log_err_exit ("%s", name);
         flux_future_destroy (f);
     }
@@ -536,6 +556,15 @@ static struct optparse_option namespace_create_opts[] =  {
     { .name = "owner", .key = 'o', .has_arg = 1,
       .usage = "Specify alternate namespace owner via userid",
     },
+    { .name = "rank", .key = 'r', .has_arg = 1,
+      .usage = "Apply transactions to namespace on broker rank",
+    },
+    { .name = "ephemeral", .key = 'e', .has_arg = 0,
+      .usage = "Keep namespace in memory instead of the content store",
+    },
+    { .name = "clone", .key = 'c', .has_arg = 1, .arginfo = "NAMESPACE",
+      .usage = "Start namespace with the current content of NAMESPACE",
+    },
     OPTPARSE_TABLE_END
 };
 
@@ -693,11 +722,40 @@ void lookup_continuation (flux_future_t *f, void *arg)
         flux_future_destroy (f);
 }
 
+void lookup_stream_continuation (flux_future_t *f, void *arg)
+{
+    const char *key = flux_kvs_lookup_get_key (f);
+    const void *data;
+    int len;
+
+    if (flux_rpc_get (f, NULL) < 0) {
+        if (errno != ENODATA)
+            log_err_exit ("%s", key);
+        flux_future_destroy (f);
+        return; // EOF
+    }
+    if (flux_kvs_lookup_get_raw (f, &data, &len) < 0)
+        log_err_exit ("%s", key);
+    if (write_all (STDOUT_FILENO, data, len) < 0)
+        log_err_exit ("%s", key);
+    flux_future_reset (f);
+}
+
 void cmd_get_one (flux_t *h, const char *key, struct lookup_ctx *ctx)
 {
     flux_future_t *f;
     int flags = 0;
 
+    if (optparse_hasopt (ctx->p, "stream")) {
+        if (!(f = flux_kvs_lookup_stream (h, ctx->ns, 0, key)))
+            log_err_exit ("%s", key);
+        if (flux_future_then (f, -1., lookup_stream_continuation, NULL) < 0)
+            log_err_exit ("flux_future_then");
+        if (flux_reactor_run (flux_get_reactor (h), 0) < 0)
+            log_err_exit ("flux_reactor_run");
+        return;
+    }
+
     if (optparse_hasopt (ctx->p, "treeobj"))
         flags |= FLUX_KVS_TREEOBJ;
     if (optparse_hasopt (ctx->p, "watch")) {
@@ -744,6 +802,13 @@ int cmd_get (optparse_t *p, int argc, char **argv)
     ctx.maxcount = optparse_get_int (p, "count", 0);
     ctx.ns = optparse_get_str (p, "namespace", NULL);
 
+    if (optparse_hasopt (p, "stream")
+        && (optparse_hasopt (p, "treeobj")
+            || optparse_hasopt (p, "watch")
+            || optparse_hasopt (p, "waitcreate")
+            || optparse_hasopt (p, "at")))
+        log_msg_exit ("get: --stream cannot be used with -t, -w, -W, or -a");
+
     for (i = optindex; i < argc; i++)
         cmd_get_one (h, argv[i], &ctx);
     /* Unless --watch is specified, cmd_get_one() starts the reactor and
@@ -1147,86 +1212,255 @@ static void dump_kvs_val (const char *key, int maxcol, const char *value)
         kv_printf (key, maxcol, "%s", value);
 }
 
-static void dump_kvs_dir (const flux_kvsdir_t *dir, int maxcol,
-                          const char *ns, bool Ropt, bool dopt)
+/* Directory walks are pipelined: lookups are issued for up to
+ * KVS_WALK_MAX_OUTSTANDING entries at a time, taken from the first
+ * KVS_WALK_WINDOW entries of the queue, and results are handed to the
+ * walk callback strictly in queue order.  Entries added by the callback
+ * are placed at the front of the queue, so output is depth first, exactly
+ * as if each lookup were performed synchronously.
+ */
+#define KVS_WALK_MAX_OUTSTANDING 64
+#define KVS_WALK_WINDOW (4 * KVS_WALK_MAX_OUTSTANDING)
+
+struct kvs_walk;
+
+typedef void (*kvs_walk_f)(struct kvs_walk *w,
+                           const char *key,
+                           const char *rootref,
+                           int flags,
+                           flux_future_t *f,
+                           void *arg);
+
+struct kvs_walk_entry {
+    char *key;
+    char *rootref;
+    int flags;
+    bool lookup;            // false if no lookup is required
+    bool done;
+    flux_future_t *f;
+    struct kvs_walk *w;
+};
+
+struct kvs_walk {
+    flux_t *h;
+    const char *ns;
+    zlistx_t *queue;        // entries in output order
+    zlistx_t *added;        // entries added since the last splice
+    int outstanding;
+    kvs_walk_f cb;
+    void *arg;
+};
+
+static void kvs_walk_pump (struct kvs_walk *w);
+
+static void kvs_walk_entry_destroy (struct kvs_walk_entry *e)
+{
+    if (e) {
+        int saved_errno = errno;
+        flux_future_destroy (e->f);
+        free (e->key);
+        free (e->rootref);
+        free (e);
+        errno = saved_errno;
+    }
+}
+
+static void kvs_walk_entry_destructor (void **item)
+{
+    if (item) {
+        kvs_walk_entry_destroy (*item);
+        *item = NULL;
+    }
+}
+
+static void kvs_walk_destroy (struct kvs_walk *w)
+{
+    if (w) {
+        int saved_errno = errno;
+        zlistx_destroy (&w->queue);
+        zlistx_destroy (&w->added);
+        free (w);
+        errno = saved_errno;
+    }
+}
+
+static struct kvs_walk *kvs_walk_create (flux_t *h, const char *ns,
+                                         kvs_walk_f cb, void *arg)
+{
+    struct kvs_walk *w;
+
+    if (!(w = calloc (1, sizeof (*w)))
+        || !(w->queue = zlistx_new ())
+        || !(w->added = zlistx_new ()))
+        log_err_exit ("kvs_walk_create");
+    zlistx_set_destructor (w->queue, kvs_walk_entry_destructor);
+    zlistx_set_destructor (w->added, kvs_walk_entry_destructor);
+    w->h = h;
+    w->ns = ns;
+    w->cb = cb;
+    w->arg = arg;
+    return w;
+}
+
+/* Queue 'key' for the walk callback.  If 'lookup' is true, it is first
+ * looked up with 'flags', relative to 'rootref' if non-NULL.
+ */
+static void kvs_walk_add (struct kvs_walk *w, const char *key,
+                          const char *rootref, int flags, bool lookup)
+{
+    struct kvs_walk_entry *e;
+
+    if (!(e = calloc (1, sizeof (*e)))
+        || !(e->key = strdup (key))
+        || (rootref && !(e->rootref = strdup (rootref))))
+        log_err_exit ("malloc");
+    e->flags = flags;
+    e->lookup = lookup;
+    e->done = !lookup;
+    e->w = w;
+    if (!zlistx_add_end (w->added, e))
+        log_err_exit ("zlistx_add_end");
+}
+
+/* Move newly added entries to the front of the queue, preserving order.
+ */
+static void kvs_walk_splice (struct kvs_walk *w)
+{
+    struct kvs_walk_entry *e;
+
+    while ((e = zlistx_last (w->added))) {
+        zlistx_detach_cur (w->added);
+        if (!zlistx_add_start (w->queue, e))
+            log_err_exit ("zlistx_add_start");
+    }
+}
+
+static void kvs_walk_continuation (flux_future_t *f, void *arg)
+{
+    struct kvs_walk_entry *e = arg;
+
+    e->done = true;
+    e->w->outstanding--;
+    kvs_walk_pump (e->w);
+}
+
+static void kvs_walk_pump (struct kvs_walk *w)
+{
+    struct kvs_walk_entry *e;
+    int n = 0;
+
+    while ((e = zlistx_first (w->queue)) && e->done) {
+        zlistx_detach_cur (w->queue);
+        w->cb (w, e->key, e->rootref, e->flags, e->f, w->arg);
+        kvs_walk_entry_destroy (e);
+        kvs_walk_splice (w);
+    }
+    e = zlistx_first (w->queue);
+    while (e && n++ < KVS_WALK_WINDOW
+             && w->outstanding < KVS_WALK_MAX_OUTSTANDING) {
+        if (e->lookup && !e->f) {
+            if (e->rootref)
+                e->f = flux_kvs_lookupat (w->h, e->flags, e->key, e->rootref);
+            else
+                e->f = flux_kvs_lookup (w->h, w->ns, e->flags, e->key);
+            if (!e->f
+                || flux_future_then (e->f,
+                                     -1.,
+                                     kvs_walk_continuation,
+                                     e) < 0)
+                log_err_exit ("%s", e->key);
+            w->outstanding++;
+        }
+        e = zlistx_next (w->queue);
+    }
+    if (zlistx_size (w->queue) == 0)
+        flux_reactor_stop (flux_get_reactor (w->h));
+}
+
+static void kvs_walk_run (struct kvs_walk *w)
+{
+    kvs_walk_splice (w);
+    kvs_walk_pump (w);
+    if (zlistx_size (w->queue) > 0
+        && flux_reactor_run (flux_get_reactor (w->h), 0) < 0)
+        log_err_exit ("flux_reactor_run");
+}
+
+struct dump_ctx {
+    int maxcol;
+    bool Ropt;
+    bool dopt;
+};
+
+static void dump_kvs_dir (struct kvs_walk *w, const flux_kvsdir_t *dir,
+                          struct dump_ctx *ctx)
 {
     const char *rootref = flux_kvsdir_rootref (dir);
-    flux_t *h = flux_kvsdir_handle (dir);
-    flux_future_t *f;
     flux_kvsitr_t *itr;
     const char *name;
     char *key;
 
-    itr = flux_kvsitr_create (dir);
+    if (!(itr = flux_kvsitr_create (dir)))
+        log_err_exit ("flux_kvsitr_create");
     while ((name = flux_kvsitr_next (itr))) {
-        key = flux_kvsdir_key_at (dir, name);
-        if (flux_kvsdir_issymlink (dir, name)) {
-            const char *ns = NULL;
-            const char *target = NULL;
-            if (rootref) {
-                if (!(f = flux_kvs_lookupat (h, FLUX_KVS_READLINK, key,
-                                             rootref)))
-                    log_err_exit ("%s", key);
-            }
-            else {
-                if (!(f = flux_kvs_lookup (h, ns, FLUX_KVS_READLINK, key)))
-                    log_err_exit ("%s", key);
-            }
-            if (flux_kvs_lookup_get_symlink (f, &ns, &target) < 0)
+        if (!(key = flux_kvsdir_key_at (dir, name)))
+            log_err_exit ("%s: flux_kvsdir_key_at failed", name);
+        if (flux_kvsdir_issymlink (dir, name))
+            kvs_walk_add (w, key, rootref, FLUX_KVS_READLINK, true);
+        else if (flux_kvsdir_isdir (dir, name))
+            kvs_walk_add (w, key, rootref, FLUX_KVS_READDIR, ctx->Ropt);
+        else
+            kvs_walk_add (w, key, rootref, 0, !ctx->dopt);
+        free (key);
+    }
+    flux_kvsitr_destroy (itr);
+}
+
+static void dump_kvs_cb (struct kvs_walk *w,
+                         const char *key,
+                         const char *rootref,
+                         int flags,
+                         flux_future_t *f,
+                         void *arg)
+{
+    struct dump_ctx *ctx = arg;
+
+    if ((flags & FLUX_KVS_READLINK)) {
+        const char *ns = NULL;
+        const char *target = NULL;
+        if (flux_kvs_lookup_get_symlink (f, &ns, &target) < 0)
+            log_err_exit ("%s", key);
+        if (ns)
+            printf ("%s -> %s::%s\n", key, ns, target);
+        else
+            printf ("%s -> %s\n", key, target);
+    }
+    else if ((flags & FLUX_KVS_READDIR)) {
+        const flux_kvsdir_t *dir;
+        if (!f)
+            printf ("%s.\n", key);
+        else {
+            if (flux_kvs_lookup_get_dir (f, &dir) < 0)
                 log_err_exit ("%s", key);
-            if (ns)
-                printf ("%s -> %s::%s\n", key, ns, target);
-            else
-                printf ("%s -> %s\n", key, target);
-            flux_future_destroy (f);
-        } else if (flux_kvsdir_isdir (dir, name)) {
-            if (Ropt) {
-                const flux_kvsdir_t *ndir;
-                if (rootref) {
-                    if (!(f = flux_kvs_lookupat (h, FLUX_KVS_READDIR, key,
-                                                 rootref)))
-                        log_err_exit ("%s", key);
-                }
-                else {
-                    if (!(f = flux_kvs_lookup (h, ns, FLUX_KVS_READDIR, key)))
-                        log_err_exit ("%s", key);
-                }
-                if (flux_kvs_lookup_get_dir (f, &ndir) < 0)
-                    log_err_exit ("%s", key);
-                if (flux_kvsdir_get_size (ndir) == 0)
-                    printf ("%s.\n", key);
-                else
-                    dump_kvs_dir (ndir, maxcol, ns, Ropt, dopt);
-                flux_future_destroy (f);
-            } else
+            if (flux_kvsdir_get_size (dir) == 0)
                 printf ("%s.\n", key);
-        } else {
-            if (!dopt) {
-                const char *value;
-                const void *buf;
-                int len;
-                if (rootref) {
-                    if (!(f = flux_kvs_lookupat (h, 0, key, rootref)))
-                        log_err_exit ("%s", key);
-                }
-                else {
-                    if (!(f = flux_kvs_lookup (h, ns, 0, key)))
-                        log_err_exit ("%s", key);
-                }
-                if (flux_kvs_lookup_get (f, &value) == 0) // null terminated
-                    dump_kvs_val (key, maxcol, value);
-                else if (flux_kvs_lookup_get_raw  (f, &buf, &len) == 0)
-                    kv_printf (key, maxcol, "%.*s", len, (char *)buf);
-                else
-                    log_err_exit ("%s", key);
-                flux_future_destroy (f);
-            }
             else
-                printf ("%s\n", key);
+                dump_kvs_dir (w, dir, ctx);
         }
-        free (key);
     }
-    flux_kvsitr_destroy (itr);
+    else {
+        const char *value;
+        const void *buf;
+        int len;
+        if (!f)
+            printf ("%s\n", key);
+        else if (flux_kvs_lookup_get (f, &value) == 0) // null terminated
+            dump_kvs_val (key, ctx->maxcol, value);
+        else if (flux_kvs_lookup_get_raw  (f, &buf, &len) == 0)
+            kv_printf (key, ctx->maxcol, "%.*s", len, (char *)buf);
+        else
+            log_err_exit ("%s", key);
+    }
 }
 
 int cmd_dir (optparse_t *p, int argc, char **argv)
@@ -1234,8 +1468,8 @@ int cmd_dir (optparse_t *p, int argc, char **argv)
     flux_t *h = (flux_t *)optparse_get_data (p, "flux_handle");
     int maxcol = get_window_width (p, STDOUT_FILENO);
     const char *ns = NULL;
-    bool Ropt;
-    bool dopt;
+    struct dump_ctx ctx;
+    struct kvs_walk *w;
     char *key;
     flux_future_t *f;
     const flux_kvsdir_t *dir;
@@ -1243,8 +1477,9 @@ int cmd_dir (optparse_t *p, int argc, char **argv)
 
     optindex = optparse_option_index (p);
     ns = optparse_get_str (p, "namespace", NULL);
-    Ropt = optparse_hasopt (p, "recursive");
-    dopt = optparse_hasopt (p, "directory");
+    ctx.maxcol = maxcol;
+    ctx.Ropt = optparse_hasopt (p, "recursive");
+    ctx.dopt = optparse_hasopt (p, "directory");
     if (optindex == argc)
         key = ".";
     else if (optindex == (argc - 1))
@@ -1263,8 +1498,11 @@ int cmd_dir (optparse_t *p, int argc, char **argv)
     }
     if (flux_kvs_lookup_get_dir (f, &dir) < 0)
         log_err_exit ("%s", key);
-    dump_kvs_dir (dir, maxcol, ns, Ropt, dopt);
+    w = kvs_walk_create (h, ns, dump_kvs_cb, &ctx);
+    dump_kvs_dir (w, dir, &ctx);
     flux_future_destroy (f);
+    kvs_walk_run (w);
+    kvs_walk_destroy (w);
     return (0);
 }
 
@@ -1374,28 +1612,33 @@ static void list_kvs_dir_single (const flux_kvsdir_t *dir, int win_width,
     free (namebuf);
 }
 
-/* List contents of directory pointed to by 'key', descending into subdirs
- * if -R was specified.  First the directory is listed, then its subdirs.
- */
-static void list_kvs_dir (flux_t *h, const char *ns, const char *key,
-                          optparse_t *p, int win_width, bool print_label,
-                          bool print_vspace)
+struct list_ctx {
+    optparse_t *p;
+    int win_width;
+    bool print_label;
+    bool print_vspace;
+};
+
+static void list_kvs_dir_cb (struct kvs_walk *w,
+                             const char *key,
+                             const char *rootref,
+                             int flags,
+                             flux_future_t *f,
+                             void *arg)
 {
-    flux_future_t *f;
+    struct list_ctx *ctx = arg;
     const flux_kvsdir_t *dir;
     flux_kvsitr_t *itr;
     const char *name;
 
-    if (!(f = flux_kvs_lookup (h, ns, FLUX_KVS_READDIR, key))
-                || flux_kvs_lookup_get_dir (f, &dir) < 0) {
+    if (flux_kvs_lookup_get_dir (f, &dir) < 0)
         log_err_exit ("%s", key);
-        goto done;
-    }
-    if (print_label)
-        printf ("%s%s:\n", print_vspace ? "\n" : "", key);
-    list_kvs_dir_single (dir, win_width, p);
+    if (ctx->print_label)
+        printf ("%s%s:\n", ctx->print_vspace ? "\n" : "", key);
+    list_kvs_dir_single (dir, ctx->win_width, ctx->p);
+    ctx->print_vspace = true;
 
-    if (optparse_hasopt (p, "recursive")) {
+    if (optparse_hasopt (ctx->p, "recursive")) {
         if (!(itr = flux_kvsitr_create (dir)))
             log_err_exit ("flux_kvsitr_create");
         while ((name = flux_kvsitr_next (itr))) {
@@ -1405,14 +1648,33 @@ static void list_kvs_dir (flux_t *h, const char *ns, const char *key,
                     log_err ("%s: flux_kvsdir_key_at failed", name);
                     continue;
                 }
-                list_kvs_dir (h, ns, nkey, p, win_width, print_label, true);
+                kvs_walk_add (w, nkey, NULL, FLUX_KVS_READDIR, true);
                 free (nkey);
             }
         }
         flux_kvsitr_destroy (itr);
     }
-done:
-    flux_future_destroy (f);
+}
+
+/* List contents of directory pointed to by 'key', descending into subdirs
+ * if -R was specified.  First the directory is listed, then its subdirs.
+ */
+static void list_kvs_dir (flux_t *h, const char *ns, const char *key,
+                          optparse_t *p, int win_width, bool print_label,
+                          bool print_vspace)
+{
+    struct list_ctx ctx = {
+        .p = p,
+        .win_width = win_width,
+        .print_label = print_label,
+        .print_vspace = print_vspace,
+    };
+    struct kvs_walk *w;
+
+    w = kvs_walk_create (h, ns, list_kvs_dir_cb, &ctx);
+    kvs_walk_add (w, key, NULL, FLUX_KVS_READDIR, true);
+    kvs_walk_run (w);
+    kvs_walk_destroy (w);
 }
 
 /* List keys, arranging in columns so that they fit within 'win_width',
@@ -1628,12 +1890,42 @@ int cmd_copy (optparse_t *p, int argc, char **argv)
     const char *srcns, *dstns;
 
     optindex = optparse_option_index (p);
-    if (optindex != (argc - 2))
+    if (argc - optindex < 2 || (argc - optindex) % 2 != 0)
         log_msg_exit ("copy: specify srckey dstkey");
 
     srcns = optparse_get_str (p, "src-namespace", NULL);
     dstns = optparse_get_str (p, "dst-namespace", NULL);
 
+    /* Multiple pairs are copied in a single transaction.
+     */
+    if (argc - optindex > 2) {
+        int count = (argc - optindex) / 2;
+        const char **srckeys;
+        const char **dstkeys;
+        int i;
+
+        if (!(srckeys = calloc (count, sizeof (srckeys[0])))
+            || !(dstkeys = calloc (count, sizeof (dstkeys[0]))))
+            log_err_exit ("calloc");
+        for (i = 0; i < count; i++) {
+            srckeys[i] = argv[optindex + 2 * i];
+            dstkeys[i] = argv[optindex + 2 * i + 1];
+        }
+        if (!(f = flux_kvs_copy_batch (h,
+                                       srcns,
+                                       srckeys,
+                                       dstns,
+                                       dstkeys,
+                                       count,
+                                       0))
+            || flux_future_get (f, NULL) < 0)
+            log_err_exit ("flux_kvs_copy_batch");
+        flux_future_destroy (f);
+        free (srckeys);
+        free (dstkeys);
+        return (0);
+    }
+
     srckey = argv[optindex];
     dstkey = argv[optindex + 1];
 
@@ -11,9 +11,11 @@
 # pylint: disable=duplicate-code
 import os
 import sys
+import time
 import logging
 import argparse
 import json
+import collections
 from itertools import chain
 
 import flux
@@ -128,10 +130,10 @@ class MiniCmd:
         raise NotImplementedError()
 
     # pylint: disable=too-many-branches,too-many-statements
-    def submit(self, args):
+    def jobspec_create(self, args):
         """
-        Submit job, constructing jobspec from args.
-        Returns jobid.
+        Create jobspec from args, including options common to all
+        subcommands.
         """
         jobspec = self.init_jobspec(args)
         jobspec.cwd = os.getcwd()
@@ -183,18 +185,29 @@ class MiniCmd:
                 except (json.JSONDecodeError, TypeError):
                     val = tmp[1]
                 jobspec.setattr(key, val)
+        return jobspec
 
-        arg_debug = False
-        arg_waitable = False
+    @staticmethod
+    def submit_flags(args):
+        """
+        Return submit flags from --flags as keyword arguments for job.submit()
+        """
+        flags = {"waitable": False, "debug": False}
         if args.flags is not None:
             for tmp in args.flags:
                 for flag in tmp.split(","):
-                    if flag == "debug":
-                        arg_debug = True
-                    elif flag == "waitable":
-                        arg_waitable = True
-                    else:
+                    if flag not in flags:
                         raise ValueError("--flags: Unknown flag " + flag)
+                    flags[flag] = True
+        return flags
+
+    def submit(self, args):
+        """
+        Submit job, constructing jobspec from args.
+        Returns jobid.
+        """
+        jobspec = self.jobspec_create(args)
+        flags = self.submit_flags(args)
 
         if args.dry_run:
             print(jobspec.dumps(), file=sys.stdout)
@@ -202,11 +215,7 @@ class MiniCmd:
 
         flux_handle = flux.Flux()
         jobid = job.submit(
-            flux_handle,
-            jobspec.dumps(),
-            priority=args.priority,
-            waitable=arg_waitable,
-            debug=arg_debug,
+            flux_handle, jobspec.dumps(), priority=args.priority, **flags
         )
         return JobID(jobid)
 
@@ -214,11 +223,30 @@ class MiniCmd:
         return self.parser
 
 
-class SubmitCmd(MiniCmd):
+def idset_expand(idset):
     """
-    SubmitCmd submits a job, displays the jobid on stdout, and returns.
-
-    Usage: flux mini submit [OPTIONS] cmd ...
+    Return the sorted list of ids in an RFC 22 idset string, e.g. "0-3,7"
+    """
+    ids = set()
+    string = idset.strip()
+    if string.startswith("[") and string.endswith("]"):
+        string = string[1:-1]
+    try:
+        for item in string.split(","):
+            low, _, high = item.partition("-")
+            low = int(low)
+            high = int(high) if high else low
+            if low < 0 or high < low:
+                raise ValueError()
+            ids.update(range(low, high + 1))
+    except ValueError:
+        raise ValueError("invalid idset: " + idset) from None
+    return sorted(ids)
+
+
+class SubmitBaseCmd(MiniCmd):
+    """
+    SubmitBaseCmd adds the job size options of flux mini submit and run.
     """
 
     def __init__(self):
@@ -265,16 +293,139 @@ class SubmitCmd(MiniCmd):
             num_nodes=args.nodes,
         )
 
+
+class SubmitCmd(SubmitBaseCmd):
+    """
+    SubmitCmd submits a job, displays the jobid on stdout, and returns.
+    With --cc or --bcc, it submits a copy of the job for each id in an idset.
+
+    Usage: flux mini submit [OPTIONS] cmd ...
+    """
+
+    # Maximum number of submit requests in flight for --cc and --bcc
+    BULK_WINDOW = 256
+
+    def __init__(self):
+        super().__init__()
+        self.parser.add_argument(
+            "--cc",
+            metavar="IDSET",
+            help="Submit a copy of the job for each id in IDSET, replacing "
+            + "{cc} in the command, --job-name, and I/O file names with the id",
+        )
+        self.parser.add_argument(
+            "--bcc",
+            metavar="IDSET",
+            help="Like --cc, but submit identical copies of the job",
+        )
+        self.parser.add_argument(
+            "-v",
+            "--verbose",
+            action="count",
+            default=0,
+            help="With --cc or --bcc, report submission rate on stderr",
+        )
+
+    @staticmethod
+    def cc_substitute(jobspec, template, ccid):
+        """
+        Set the members of jobspec saved in template, with {cc} replaced
+        by ccid, and set FLUX_JOB_CC in the job environment.
+        """
+        ccstr = str(ccid)
+        command, name, paths = template
+        jobspec.tasks[0]["command"] = [x.replace("{cc}", ccstr) for x in command]
+        if name is not None:
+            jobspec.setattr("system.job.name", name.replace("{cc}", ccstr))
+        for attr, path in paths.items():
+            setattr(jobspec, attr, path.replace("{cc}", ccstr))
+        jobspec.environment["FLUX_JOB_CC"] = ccstr
+
+    def submit_bulk(self, args):
+        """
+        Build the jobspec once and submit a copy of it per id of --cc or
+        --bcc, keeping up to BULK_WINDOW submit requests in flight.  Print
+        jobids as they are acknowledged, in submission order.
+        Return the number of failed submissions.
+        """
+        if args.cc is not None and args.bcc is not None:
+            raise ValueError("--cc and --bcc are mutually exclusive")
+        ids = idset_expand(args.cc if args.cc is not None else args.bcc)
+        jobspec = self.jobspec_create(args)
+        flags = self.submit_flags(args)
+
+        template = None
+        payload = jobspec.dumps()
+        if args.cc is not None:
+            paths = {}
+            for attr in ["stdin", "stdout", "stderr"]:
+                path = getattr(jobspec, attr)
+                if path is not None:
+                    paths[attr] = path
+            template = (list(jobspec.tasks[0]["command"]), args.job_name, paths)
+
+        if args.dry_run:
+            for ccid in ids:
+                if template:
+                    self.cc_substitute(jobspec, template, ccid)
+                    payload = jobspec.dumps()
+                print(payload, file=sys.stdout)
+            sys.exit(0)
+
+        flux_handle = flux.Flux()
+        pending = collections.deque()
+        errors = 0
+
+        def acknowledge():
+            nonlocal errors
+            ccid, future = pending.popleft()
+            try:
+                print(JobID(future.get_id()), file=sys.stdout)
+            except OSError as exc:
+                LOGGER.error("cc=%d: %s", ccid, exc.strerror)
+                errors += 1
+
+        t_start = time.time()
+        for ccid in ids:
+            if template:
+                self.cc_substitute(jobspec, template, ccid)
+                payload = jobspec.dumps()
+            future = job.submit_async(
+                flux_handle, payload, priority=args.priority, **flags
+            )
+            pending.append((ccid, future))
+            if len(pending) >= self.BULK_WINDOW:
+                acknowledge()
+        while pending:
+            acknowledge()
+        elapsed = time.time() - t_start
+
+        if args.verbose > 0:
+            sys.stdout.flush()
+            count = len(ids) - errors
+            rate = count / elapsed if elapsed > 0 else 0.0
+            print(
+                "flux-mini: submitted {} jobs in {:.3f}s ({:.1f} job/s)".format(
+                    count, elapsed, rate
+                ),
+                file=sys.stderr,
+            )
+        return errors
+
     def main(self, args):
+        if args.cc is not None or args.bcc is not None:
+            if self.submit_bulk(args) > 0:
+                sys.exit(1)
+            return
         jobid = self.submit(args)
         print(jobid, file=sys.stdout)
 
 
-class RunCmd(SubmitCmd):
+class RunCmd(SubmitBaseCmd):
     """
-    RunCmd is identical to SubmitCmd, except it attaches the the job
-    after submission.  Some additional options are added to modify the
-    attach behavior.
+    RunCmd is identical to SubmitCmd without --cc and --bcc, except it
+    attaches the the job after submission.  Some additional options are
+    added to modify the attach behavior.
 
     Usage: flux mini run [OPTIONS] cmd ...
     """
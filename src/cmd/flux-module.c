@@ -12,6 +12,7 @@
 #include "config.h"
 #endif
 #include <stdio.h>
+#include <stdbool.h>
 #include <getopt.h>
 #include <dlfcn.h>
 #include <flux/core.h>
@@ -26,6 +27,7 @@
 #include "src/common/libutil/oom.h"
 #include "src/common/libutil/read_all.h"
 #include "src/common/libutil/iterators.h"
+#include "src/common/libidset/idset.h"
 
 const int max_idle = 99;
 
@@ -36,21 +38,54 @@ int cmd_reload (optparse_t *p, int argc, char **argv);
 int cmd_info (optparse_t *p, int argc, char **argv);
 int cmd_stats (optparse_t *p, int argc, char **argv);
 int cmd_debug (optparse_t *p, int argc, char **argv);
+int cmd_memory (optparse_t *p, int argc, char **argv);
 
-static struct optparse_option legacy_opts[] =  {
+static struct optparse_option load_opts[] =  {
     { .name = "rank", .key = 'r', .has_arg = 1, .arginfo = "RANK",
       .usage = "Send RPC to specified rank",
     },
+    { .name = "cpus", .key = 'c', .has_arg = 1, .arginfo = "IDSET",
+      .usage = "Run module thread on CPUs in IDSET",
+    },
+    { .name = "numa", .key = 'n', .has_arg = 1, .arginfo = "IDSET",
+      .usage = "Run module thread on NUMA nodes in IDSET",
+    },
     OPTPARSE_TABLE_END,
 };
 
-static struct optparse_option remove_opts[] =  {
+static struct optparse_option reload_opts[] =  {
     { .name = "rank", .key = 'r', .has_arg = 1, .arginfo = "RANK",
       .usage = "Send RPC to specified rank",
     },
     { .name = "force", .key = 'f',
       .usage = "Ignore nonexistent modules",
     },
+    { .name = "cpus", .key = 'c', .has_arg = 1, .arginfo = "IDSET",
+      .usage = "Run module thread on CPUs in IDSET",
+    },
+    { .name = "numa", .key = 'n', .has_arg = 1, .arginfo = "IDSET",
+      .usage = "Run module thread on NUMA nodes in IDSET",
+    },
+    OPTPARSE_TABLE_END,
+};
+
+static struct optparse_option list_opts[] =  {
+    { .name = "placement", .key = 'p', .has_arg = 0,
+      .usage = "Show CPU and NUMA placement of modules",
+    },
+    OPTPARSE_TABLE_END,
+};
+
+static struct optparse_option remove_opts[] =  {
+    { .name = "rank", .key = 'r', .has_arg = 1, .arginfo = "IDSET",
+      .usage = "Send RPC to specified ranks, or \"all\"",
+    },
+    { .name = "exclude", .key = 'x', .has_arg = 1, .arginfo = "IDSET",
+      .usage = "Exclude ranks from --rank",
+    },
+    { .name = "force", .key = 'f',
+      .usage = "Ignore nonexistent modules",
+    },
     OPTPARSE_TABLE_END,
 };
 
@@ -67,6 +102,9 @@ static struct optparse_option stats_opts[] =  {
     { .name = "rusage", .key = 'R', .has_arg = 0,
       .usage = "Request rusage data instead of stats",
     },
+    { .name = "profile", .key = 'P', .has_arg = 0,
+      .usage = "Request callback profile data instead of stats",
+    },
     { .name = "clear", .key = 'c', .has_arg = 0,
       .usage = "Clear stats on target rank",
     },
@@ -87,13 +125,19 @@ static struct optparse_option debug_opts[] = {
     OPTPARSE_TABLE_END,
 };
 
+static struct optparse_option memory_opts[] = {
+    { .name = "limit",  .key = 'l',  .has_arg = 1, .arginfo = "SIZE",
+      .usage = "Set soft memory limit (0 for none)", },
+    OPTPARSE_TABLE_END,
+};
+
 static struct optparse_subcommand subcommands[] = {
     { "list",
       "[OPTIONS] [module]",
       "List loaded modules",
       cmd_list,
       0,
-      NULL,
+      list_opts,
     },
     { "remove",
       "[OPTIONS] module",
@@ -114,14 +158,14 @@ static struct optparse_subcommand subcommands[] = {
       "Load module",
       cmd_load,
       0,
-      legacy_opts,
+      load_opts,
     },
     { "reload",
       "[OPTIONS] module",
       "Reload module",
       cmd_reload,
       0,
-      remove_opts,
+      reload_opts,
     },
     { "info",
       "[OPTIONS] module",
@@ -144,6 +188,13 @@ static struct optparse_subcommand subcommands[] = {
       0,
       debug_opts,
     },
+    { "memory",
+      "[OPTIONS] module",
+      "Get module memory usage, set soft limit",
+      cmd_memory,
+      0,
+      memory_opts,
+    },
     OPTPARSE_SUBCMD_END
 };
 
@@ -285,7 +336,10 @@ static void module_load (flux_t *h, optparse_t *p, int argc, char **argv)
 {
     char *modname;
     char *modpath;
+    const char *cpus;
+    const char *numa;
     int n;
+    json_t *payload;
     flux_future_t *f;
 
     if ((n = optparse_option_index (p)) == argc) {
@@ -306,15 +360,24 @@ static void module_load (flux_t *h, optparse_t *p, int argc, char **argv)
         n++;
     }
 
+    if (!(payload = json_pack ("{s:s s:O}", "path", modpath, "args", args)))
+        log_msg_exit ("json_pack() failed");
+    /* Only add placement keys if requested, since services other than
+     * the broker may implement insmod.
+     */
+    if ((cpus = optparse_get_str (p, "cpus", NULL))
+        && json_object_set_new (payload, "cpus", json_string (cpus)) < 0)
+        log_msg_exit ("json_object_set_new() failed");
+    if ((numa = optparse_get_str (p, "numa", NULL))
+        && json_object_set_new (payload, "numa", json_string (numa)) < 0)
+        log_msg_exit ("json_object_set_new() failed");
+
     if (!(f = flux_rpc_pack (h,
                              topic,
                              optparse_get_int (p, "rank", FLUX_NODEID_ANY),
                              0,
-                             "{s:s s:O}",
-                             "path",
-                             modpath,
-                             "args",
-                             args)))
+                             "O",
+                             payload)))
         log_err_exit ("%s", topic);
     if (flux_rpc_get (f, NULL) < 0) {
         if (errno == EEXIST)
@@ -324,6 +387,7 @@ static void module_load (flux_t *h, optparse_t *p, int argc, char **argv)
     flux_future_destroy (f);
     free (topic);
     free (service);
+    json_decref (payload);
     json_decref (args);
     free (modpath);
     free (modname);
@@ -339,25 +403,95 @@ int cmd_load (optparse_t *p, int argc, char **argv)
     return 0;
 }
 
+/* Return the set of ranks selected by --rank and --exclude, or NULL if
+ * --rank was not specified.  --rank may be a single rank, an idset,
+ * or "all".
+ */
+static struct idset *get_ranks (flux_t *h, optparse_t *p)
+{
+    const char *arg;
+    struct idset *ranks;
+    uint32_t size;
+
+    if (optparse_getopt (p, "rank", &arg) <= 0)
+        return NULL;
+    if (!strcmp (arg, "all")) {
+        if (flux_get_size (h, &size) < 0)
+            log_err_exit ("flux_get_size");
+        if (!(ranks = idset_create (size, 0))
+            || idset_range_set (ranks, 0, size - 1) < 0)
+            log_err_exit ("error creating rank idset");
+    }
+    else if (!(ranks = idset_decode (arg)))
+        log_msg_exit ("error decoding --rank idset '%s'", arg);
+    /* N.B. "exclude" is not valid for every subcommand that removes
+     * modules, so check it with optparse_getopt(), which doesn't fail.
+     */
+    if (optparse_getopt (p, "exclude", &arg) > 0) {
+        struct idset *xset;
+        unsigned int id;
+
+        if (!(xset = idset_decode (arg)))
+            log_msg_exit ("error decoding --exclude idset '%s'", arg);
+        id = idset_first (xset);
+        while (id != IDSET_INVALID_ID) {
+            (void)idset_clear (ranks, id);
+            id = idset_next (xset, id);
+        }
+        idset_destroy (xset);
+    }
+    return ranks;
+}
+
+/* Remove the module from each rank in --rank, or from the local broker.
+ * The rmmod requests for all ranks are sent before any response is
+ * awaited, so modules are removed across the instance in parallel,
+ * without a process per rank as with flux exec.
+ */
 static void module_remove (flux_t *h, const char *modname, optparse_t *p)
 {
-    flux_future_t *f;
     char *service = getservice (modname);
     char *topic = xasprintf ("%s.rmmod", service);
-
-    if (!(f = flux_rpc_pack (h,
-                             topic,
-                             optparse_get_int (p, "rank", FLUX_NODEID_ANY),
-                             0,
-                             "{s:s}",
-                             "name",
-                             modname)))
-        log_err_exit ("%s %s", topic, modname);
-    if (flux_rpc_get (f, NULL) < 0) {
-        if (!(optparse_hasopt (p, "force") && errno == ENOENT))
+    struct idset *ranks = get_ranks (h, p);
+    flux_future_t **fv;
+    unsigned int count = ranks ? idset_count (ranks) : 1;
+    unsigned int id;
+    unsigned int i;
+    int errors = 0;
+
+    fv = xzmalloc (sizeof (fv[0]) * (count > 0 ? count : 1));
+    id = ranks ? idset_first (ranks) : FLUX_NODEID_ANY;
+    for (i = 0; i < count; i++) {
+        if (!(fv[i] = flux_rpc_pack (h,
+                                     topic,
+                                     id,
+                                     0,
+                                     "{s:s}",
+                                     "name",
+                                     modname)))
             log_err_exit ("%s %s", topic, modname);
+        if (ranks)
+            id = idset_next (ranks, id);
     }
-    flux_future_destroy (f);
+    id = ranks ? idset_first (ranks) : FLUX_NODEID_ANY;
+    for (i = 0; i < count; i++) {
+        if (flux_rpc_get (fv[i], NULL) < 0) {
+            if (!(optparse_hasopt (p, "force") && errno == ENOENT)) {
+                if (ranks)
+                    log_err ("rank %u: %s %s", id, topic, modname);
+                else
+                    log_err ("%s %s", topic, modname);
+                errors++;
+            }
+        }
+        flux_future_destroy (fv[i]);
+        if (ranks)
+            id = idset_next (ranks, id);
+    }
+    if (errors > 0)
+        exit (1);
+    free (fv);
+    idset_destroy (ranks);
     free (topic);
     free (service);
 }
@@ -455,36 +589,98 @@ char lsmod_state_char (int state)
     }
 }
 
-void lsmod_print_header (FILE *f)
+/* Format a byte count with a binary unit suffix, or "-" if zero.
+ */
+char *lsmod_memory_string (json_int_t bytes, char *buf, int bufsz)
 {
-    fprintf (f, "%-20s %8s %-7s %4s  %c %s\n",
-            "Module", "Size", "Digest", "Idle", 'S', "Service");
+    const char *suffix[] = { "", "K", "M", "G", "T" };
+    double value = bytes;
+    int i = 0;
+
+    if (bytes <= 0) {
+        snprintf (buf, bufsz, "-");
+        return buf;
+    }
+    while (value >= 1024 && i < 4) {
+        value /= 1024;
+        i++;
+    }
+    if (i == 0)
+        snprintf (buf, bufsz, "%d", (int)bytes);
+    else
+        snprintf (buf, bufsz, "%.1f%s", value, suffix[i]);
+    return buf;
+}
+
+char *lsmod_init_string (double init, char *buf, int bufsz)
+{
+    if (init >= 0)
+        snprintf (buf, bufsz, "%.3f", init);
+    else
+        snprintf (buf, bufsz, "-");
+    return buf;
+}
+
+void lsmod_print_header (FILE *f, bool placement)
+{
+    if (placement)
+        fprintf (f, "%-20s %-16s %-6s  %c %s\n",
+                "Module", "Cpus", "Numa", 'S', "Service");
+    else
+        fprintf (f, "%-20s %8s %-7s %6s %4s %6s  %c %s\n",
+                "Module", "Size", "Digest", "Memory", "Idle", "Init", 'S',
+                "Service");
+}
+
+void lsmod_print_placement (FILE *f,
+                            const char *name,
+                            const char *cpus,
+                            const char *numa,
+                            int status,
+                            json_t *services)
+{
+    char *serv_s = lsmod_services_string (services, name);
+
+    fprintf (f, "%-20.20s %-16s %-6s  %c %s\n",
+             name,
+             strlen (cpus) > 0 ? cpus : "-",
+             strlen (numa) > 0 ? numa : "-",
+             lsmod_state_char (status),
+             serv_s ? serv_s : "");
+
+    free (serv_s);
 }
 
 void lsmod_print_entry (FILE *f,
                        const char *name,
                        int size,
                        const char *digest,
+                       json_int_t memory,
                        int idle,
+                       double init,
                        int status,
                        json_t *services)
 {
     int digest_len = strlen (digest);
     char *serv_s = lsmod_services_string (services, name);
+    char memory_s[16];
     char idle_s[16];
+    char init_s[16];
 
-    fprintf (f, "%-20.20s %8d %7s %4s  %c %s\n",
+    fprintf (f, "%-20.20s %8d %7s %6s %4s %6s  %c %s\n",
              name,
              size,
              digest_len > 7 ? digest + digest_len - 7 : digest,
+             lsmod_memory_string (memory, memory_s, sizeof (memory_s)),
              lsmod_idle_string (idle, idle_s, sizeof (idle_s)),
+             lsmod_init_string (init, init_s, sizeof (init_s)),
              lsmod_state_char (status),
              serv_s ? serv_s : "");
 
     free (serv_s);
 }
 
-void lsmod_print_list (FILE *f, json_t *o)
+void lsmod_print_list (FILE *f, json_t *o, bool placement)
 {
     size_t index;
     json_t *value;
@@ -496,21 +692,35 @@ void lsmod_print_list (FILE *f, json_t *o)
     json_t *services;
 
     json_array_foreach (o, index, value) {
-        if (json_unpack (value, "{s:s s:i s:s s:i s:i s:o}",
+        double init = -1;
+        json_int_t memory = 0;
+        const char *cpus = "";
+        const char *numa = "";
+        if (json_unpack (value, "{s:s s:i s:s s:i s:i s:o s?F s?I s?s s?s}",
                          "name", &name,
                          "size", &size,
                          "digest", &digest,
                          "idle", &idle,
                          "status", &status,
-                         "services", &services) < 0)
+                         "services", &services,
+                         "init", &init,
+                         "memory", &memory,
+                         "cpus", &cpus,
+                         "numa", &numa) < 0)
             log_msg_exit ("Erorr parsing lsmod response");
         if (!json_is_array (services))
             log_msg_exit ("Erorr parsing lsmod services array");
+        if (placement) {
+            lsmod_print_placement (f, name, cpus, numa, status, services);
+            continue;
+        }
         lsmod_print_entry (f,
                            name,
                            size,
                            digest,
+                           memory,
                            idle,
+                           init,
                            status,
                            services);
     }
@@ -546,8 +756,8 @@ int cmd_list (optparse_t *p, int argc, char **argv)
         log_err_exit ("%s", topic);
     if (!json_is_array (o))
         log_msg_exit ("%s: module list is not an array", topic);
-    lsmod_print_header (stdout);
-    lsmod_print_list (stdout, o);
+    lsmod_print_header (stdout, optparse_hasopt (p, "placement"));
+    lsmod_print_list (stdout, o, optparse_hasopt (p, "placement"));
     flux_future_destroy (f);
     free (topic);
     flux_close (h);
@@ -633,6 +843,15 @@ int cmd_stats (optparse_t *p, int argc, char **argv)
         if (flux_send (h, msg, 0) < 0)
             log_err_exit ("sending event");
         flux_msg_destroy (msg);
+    } else if (optparse_hasopt (p, "profile")) {
+        topic = xasprintf ("%s.profile", service);
+        if (!(f = flux_rpc (h, topic, NULL, nodeid, 0)))
+            log_err_exit ("%s", topic);
+        if (flux_rpc_get (f, &json_str) < 0)
+            log_err_exit ("%s", topic);
+        if (!json_str)
+            log_errn_exit (EPROTO, "%s", topic);
+        parse_json (p, json_str);
     } else if (optparse_hasopt (p, "rusage")) {
         topic = xasprintf ("%s.rusage", service);
         if (!(f = flux_rpc (h, topic, NULL, nodeid, 0)))
@@ -700,6 +919,80 @@ int cmd_debug (optparse_t *p, int argc, char **argv)
     return (0);
 }
 
+/* Parse a byte count with optional k, M, G or T suffix (powers of 1024).
+ */
+static json_int_t parse_size (const char *s)
+{
+    char *endptr;
+    double value;
+    double scale = 1;
+
+    errno = 0;
+    value = strtod (s, &endptr);
+    if (errno != 0 || endptr == s || value < 0)
+        log_msg_exit ("invalid size: %s", s);
+    switch (*endptr) {
+        case 'T':
+        case 't':
+            scale *= 1024;
+            /* fall through */
+        case 'G':
+        case 'g':
+            scale *= 1024;
+            /* fall through */
+        case 'M':
+        case 'm':
+            scale *= 1024;
+            /* fall through */
+        case 'K':
+        case 'k':
+            scale *= 1024;
+            endptr++;
+            break;
+    }
+    if (*endptr != '\0')
+        log_msg_exit ("invalid size: %s", s);
+    return value * scale;
+}
+
+int cmd_memory (optparse_t *p, int argc, char **argv)
+{
+    int n;
+    flux_t *h;
+    char *topic = NULL;
+    const char *limit_s;
+    json_int_t usage, peak, limit, sheds;
+    flux_future_t *f = NULL;
+
+    if ((n = optparse_option_index (p)) != argc - 1)
+        log_msg_exit ("flux-memory requires module argument");
+    topic = xasprintf ("%s.memory", argv[n]);
+
+    if (!(h = flux_open (NULL, 0)))
+        log_err_exit ("flux_open");
+    if ((limit_s = optparse_get_str (p, "limit", NULL)))
+        f = flux_rpc_pack (h, topic, FLUX_NODEID_ANY, 0, "{s:I}",
+                           "limit", parse_size (limit_s));
+    else
+        f = flux_rpc (h, topic, "{}", FLUX_NODEID_ANY, 0);
+    if (!f)
+        log_err_exit ("%s", topic);
+    if (flux_rpc_get_unpack (f, "{s:I s:I s:I s:I}",
+                             "usage", &usage,
+                             "peak", &peak,
+                             "limit", &limit,
+                             "sheds", &sheds) < 0)
+        log_err_exit ("%s", topic);
+    printf ("usage: %jd\n", (intmax_t) usage);
+    printf ("peak:  %jd\n", (intmax_t) peak);
+    printf ("limit: %jd\n", (intmax_t) limit);
+    printf ("sheds: %jd\n", (intmax_t) sheds);
+    flux_future_destroy (f);
+    flux_close (h);
+    free (topic);
+    return (0);
+}
+
 /*
  * vi: ts=4 sw=4 expandtab
  */
@@ -9,6 +9,7 @@
 ##############################################################
 
 import sys
+import errno
 import logging
 import argparse
 import re
@@ -17,6 +18,7 @@ import json
 
 import flux
 from flux.rpc import RPC
+from flux.constants import FLUX_RPC_STREAMING
 from flux.memoized_property import memoized_property
 
 
@@ -267,6 +269,66 @@ class SchedResourceList:
         return res
 
 
+class ResourceSummaryEntry:
+    """
+    One state of a sched.resource-summary response: node and core counts
+    and a ranged idset of ranks, precomputed by the scheduler in place of
+    the per-rank sets of sched.resource-status.
+    """
+
+    def __init__(self, state, entry):
+        self.state = state
+        self.nnodes = entry["nnodes"]
+        self.ncores = entry["ncores"]
+        self.ngpus = entry["ngpus"]
+        self.ranks = entry["ranks"]
+
+
+class ResourceSummary:
+    """
+    Encapsulate response from sched.resource-summary query, which
+    provides all states, so "up" and "free" need not be computed here.
+    """
+
+    def __init__(self, resp):
+        self.entries = {}
+        for state in ["all", "up", "down", "allocated", "free"]:
+            self.entries[state] = ResourceSummaryEntry(state, resp[state])
+
+    def __getitem__(self, item):
+        return self.entries[item]
+
+
+def resource_summary_watch(handle):
+    """
+    Yield a ResourceSummary, then another each time resources change
+    """
+    future = RPC(handle, "sched.resource-summary", flags=FLUX_RPC_STREAMING)
+    while True:
+        try:
+            resp = future.get()
+        except OSError as exc:
+            if exc.errno == errno.ENODATA:
+                break
+            raise
+        yield ResourceSummary(resp)
+        future.reset()
+
+
+def resource_query(handle, summary):
+    """
+    Query resources from the scheduler, using the summary if 'summary' is
+    True, unless the scheduler does not provide it.
+    """
+    if summary:
+        try:
+            return ResourceSummary(RPC(handle, "sched.resource-summary").get())
+        except OSError as exc:
+            if exc.errno != errno.ENOSYS:
+                raise
+    return SchedResourceList(RPC(handle, "sched.resource-status").get())
+
+
 def list_handler(args):
     valid_states = ["up", "down", "allocated", "free", "all"]
     headings = {
@@ -292,16 +354,29 @@ def list_handler(args):
 
     formatter = flux.util.OutputFormat(headings, fmt, prepend="0.")
 
+    #  The summary has everything but the resource lists
+    summary = "rlist" not in formatter.fields
+
+    def print_resources(resources):
+        if not args.no_header:
+            print(formatter.header())
+        for state in states:
+            print(formatter.format(resources[state]))
+        sys.stdout.flush()
+
+    if args.watch:
+        if args.from_stdin or not summary:
+            LOGGER.error("--watch cannot be used with --from-stdin or {rlist}")
+            sys.exit(1)
+        for resources in resource_summary_watch(flux.Flux()):
+            print_resources(resources)
+        return
+
     if args.from_stdin:
-        resp = json.load(sys.stdin)
+        resources = SchedResourceList(json.load(sys.stdin))
     else:
-        resp = RPC(flux.Flux(), "sched.resource-status").get()
-    resources = SchedResourceList(resp)
-
-    if not args.no_header:
-        print(formatter.header())
-    for state in states:
-        print(formatter.format(resources[state]))
+        resources = resource_query(flux.Flux(), summary)
+    print_resources(resources)
 
 
 LOGGER = logging.getLogger("flux-resource")
@@ -353,6 +428,12 @@ def main():
     list_parser.add_argument(
         "-n", "--no-header", action="store_true", help="Suppress header output"
     )
+    list_parser.add_argument(
+        "-w",
+        "--watch",
+        action="store_true",
+        help="Print resources again each time they change",
+    )
     list_parser.add_argument(
         "--from-stdin", action="store_true", help=argparse.SUPPRESS
     )
@@ -28,6 +28,7 @@
 #include "src/common/libutil/oom.h"
 #include "src/common/libutil/cleanup.h"
 #include "src/common/libutil/setenvf.h"
+#include "src/common/libutil/monotime.h"
 #include "src/common/libpmi/simple_server.h"
 #include "src/common/libpmi/dgetline.h"
 
@@ -43,9 +44,11 @@ static struct {
     int size;
     int count;
     int exit_rc;
+    struct timespec launch_time;
     struct {
         zhash_t *kvs;
         struct pmi_simple_server *srv;
+        int barrier_count;
     } pmi;
 } ctx;
 
@@ -94,6 +97,8 @@ static struct optparse_option opts[] = {
       .usage = "Trace pmi simple server protocol exchange", },
     { .name = "scratchdir", .key = 'D', .has_arg = 1, .arginfo = "DIR",
       .usage = "Use DIR as scratch directory", },
+    { .name = "lightweight", .has_arg = 0,
+      .usage = "Load only essential modules on brokers with rank > 0", },
 
 /* Option group 1, these options will be listed after those above */
     { .group = 1,
@@ -441,6 +446,10 @@ int exec_broker (const char *cmd_argz, size_t cmd_argz_len,
     if (argz_add (&argz, &argz_len, broker_path) != 0)
         goto nomem;
 
+    if (optparse_hasopt (ctx.opts, "lightweight")) {
+        if (argz_add (&argz, &argz_len, "--setattr=init.lightweight=1") != 0)
+            goto nomem;
+    }
     add_args_list (&argz, &argz_len, ctx.opts, "broker-opts");
     if (cmd_argz) {
         if (argz_append (&argz, &argz_len, cmd_argz, cmd_argz_len) != 0)
@@ -483,6 +492,8 @@ struct client *client_create (const char *broker_path, const char *scratch_dir,
     argz_add (&argz, &argz_len, dir_arg);
     argz_add (&argz, &argz_len, "--setattr=tbon.endpoint=ipc://%B/req");
     free (dir_arg);
+    if (optparse_hasopt (ctx.opts, "lightweight"))
+        argz_add (&argz, &argz_len, "--setattr=init.lightweight=1");
     add_args_list (&argz, &argz_len, ctx.opts, "broker-opts");
     if (rank == 0 && cmd_argz)
         argz_append (&argz, &argz_len, cmd_argz, cmd_argz_len); /* must be last arg */
@@ -536,12 +547,30 @@ void client_dumpargs (struct client *cli)
     free (az);
 }
 
+/* All brokers have entered a PMI barrier.  The server is internal to
+ * flux-start, so there is nothing further to synchronize with; just
+ * complete the barrier.  Since all brokers are launched at once, the time
+ * from launch to each barrier is a good measure of instance bring-up cost.
+ */
+static int pmi_barrier_enter (void *arg)
+{
+    ctx.pmi.barrier_count++;
+    if (optparse_hasopt (ctx.opts, "verbose"))
+        log_msg ("PMI barrier %d: %d brokers after %.3fs",
+                 ctx.pmi.barrier_count,
+                 ctx.size,
+                 monotime_since (ctx.launch_time) / 1000);
+    if (pmi_simple_server_barrier_complete (ctx.pmi.srv, 0) < 0)
+        log_err_exit ("pmi_simple_server_barrier_complete");
+    return 0;
+}
+
 void pmi_server_initialize (int flags)
 {
     struct pmi_simple_ops ops = {
         .kvs_put = pmi_kvs_put,
         .kvs_get = pmi_kvs_get,
-        .barrier_enter = NULL,
+        .barrier_enter = pmi_barrier_enter,
         .response_send = pmi_response_send,
         .debug_trace = pmi_debug_trace,
     };
@@ -631,6 +660,10 @@ int start_session (const char *cmd_argz, size_t cmd_argz_len,
 
     pmi_server_initialize (flags);
 
+    /* Launch all brokers before entering the reactor, so they bootstrap
+     * concurrently and the PMI barriers wait only on the slowest one.
+     */
+    monotime (&ctx.launch_time);
     for (rank = 0; rank < ctx.size; rank++) {
         if (!(cli = client_create (broker_path, scratch_dir, rank,
                                    cmd_argz, cmd_argz_len)))
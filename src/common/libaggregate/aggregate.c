@@ -162,35 +162,46 @@ int aggregate_unpack_to_kvs (flux_future_t *f, const char *path)
     return (rc);
 }
 
-flux_future_t *aggregator_push_json (flux_t *h, int fwd_count, double timeout,
-                                     const char *key, json_t *o)
+flux_future_t *aggregator_push_reduce (flux_t *h, int fwd_count,
+                                       double timeout, const char *key,
+                                       const char *op, json_t *o)
 {
     uint32_t size;
     uint32_t rank;
     int n;
     char rankstr [16]; /* aggregator expects ranks as string */
+    json_t *payload;
 
     if ((flux_get_size (h, &size) < 0)
         || (flux_get_rank (h, &rank) < 0)
         || ((n = snprintf (rankstr, sizeof (rankstr), "%d", rank)) < 0)
-        || (n >= sizeof (rankstr)))
+        || (n >= sizeof (rankstr))) {
+        json_decref (o);
         return NULL;
+    }
+    if (!(payload = json_pack ("{s:s,s:i,s:i,s:{s:o}}",
+                               "key", key,
+                               "total", size,
+                               "fwd_count", fwd_count,
+                               "entries", rankstr, o)))
+        goto nomem;
+    if (timeout >= 0.
+        && json_object_set_new (payload, "timeout", json_real (timeout)) < 0)
+        goto nomem;
+    if (op && json_object_set_new (payload, "reduce", json_string (op)) < 0)
+        goto nomem;
+    return flux_rpc_pack (h, "aggregator.push", FLUX_NODEID_ANY, 0,
+                          "o", payload);
+nomem:
+    json_decref (payload);
+    errno = ENOMEM;
+    return NULL;
+}
 
-    if (timeout >= 0.)
-        return flux_rpc_pack (h, "aggregator.push", FLUX_NODEID_ANY, 0,
-                             "{s:s,s:i,s:i,s:f,s:{s:o}}",
-                             "key", key,
-                             "total", size,
-                             "fwd_count", fwd_count,
-                             "timeout" , timeout,
-                             "entries", rankstr, o);
-    else
-        return flux_rpc_pack (h, "aggregator.push", FLUX_NODEID_ANY, 0,
-                             "{s:s,s:i,s:i,s:{s:o}}",
-                             "key", key,
-                             "total", size,
-                             "fwd_count", fwd_count,
-                             "entries", rankstr, o);
+flux_future_t *aggregator_push_json (flux_t *h, int fwd_count, double timeout,
+                                     const char *key, json_t *o)
+{
+    return aggregator_push_reduce (h, fwd_count, timeout, key, NULL, o);
 }
 
 /* vi: ts=4 sw=4 expandtab
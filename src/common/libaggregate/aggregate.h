@@ -20,6 +20,16 @@
 flux_future_t *aggregator_push_json (flux_t *h, int fwd_count, double t,
 		                     const char *key, json_t *o);
 
+/*
+ *  As above, but combine values at each level of the TBON with reduction
+ *   operator `op`, one of "sum", "min", "max" (numeric values), or
+ *   "idset" (union of idset strings).  The final aggregate then has a
+ *   single entry.  If op is NULL this is equivalent to aggregator_push_json().
+ */
+flux_future_t *aggregator_push_reduce (flux_t *h, int fwd_count, double t,
+                                       const char *key, const char *op,
+                                       json_t *o);
+
 /*  Fulfill future when aggregate at `key` is "complete", i.e.
  *   count == total. Use aggreate_wait_get_unpack () to unpack final
  *   aggregate kvs value after successful fulfillment.
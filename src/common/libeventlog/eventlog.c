@@ -11,6 +11,7 @@
 #if HAVE_CONFIG_H
 #include "config.h"
 #endif
+#include <ctype.h>
 #include <flux/core.h>
 #include <jansson.h>
 #include <czmq.h>
@@ -367,6 +368,226 @@ char *eventlog_encode (json_t *array)
     return buf;
 }
 
+struct eventlog_iter {
+    const char *s;          // eventlog (not copied)
+    const char *end;        // end of last newline terminated entry
+    const char *cur;        // start of current entry, NULL if unpositioned
+    const char *cur_end;    // newline terminating current entry
+    double timestamp;
+    char *name;
+    size_t namesz;
+    json_t *entry;          // current entry, decoded on demand
+};
+
+struct eventlog_iter *eventlog_iter_create (const char *s)
+{
+    struct eventlog_iter *iter;
+    const char *p;
+
+    if (!s) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(iter = calloc (1, sizeof (*iter))))
+        return NULL;
+    iter->s = s;
+    /* As with eventlog_decode(), text after the last newline is ignored.
+     */
+    iter->end = s;
+    if ((p = strrchr (s, '\n')))
+        iter->end = p + 1;
+    return iter;
+}
+
+void eventlog_iter_destroy (struct eventlog_iter *iter)
+{
+    if (iter) {
+        int saved_errno = errno;
+        json_decref (iter->entry);
+        free (iter->name);
+        free (iter);
+        errno = saved_errno;
+    }
+}
+
+static const char *skip_ws (const char *p, const char *end)
+{
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+        p++;
+    return p;
+}
+
+static const char *skip_token (const char *p, const char *end, const char *tok)
+{
+    size_t len = strlen (tok);
+
+    p = skip_ws (p, end);
+    if (end - p < len || strncmp (p, tok, len) != 0)
+        return NULL;
+    return p + len;
+}
+
+static int iter_set_name (struct eventlog_iter *iter, const char *s, size_t len)
+{
+    if (len + 1 > iter->namesz) {
+        char *p;
+        if (!(p = realloc (iter->name, len + 1)))
+            return -1;
+        iter->name = p;
+        iter->namesz = len + 1;
+    }
+    memcpy (iter->name, s, len);
+    iter->name[len] = '\0';
+    return 0;
+}
+
+/* Extract timestamp and name from an entry in [p, end) without decoding
+ * the whole entry, if it begins {"timestamp":N,"name":"S" with S free of
+ * escapes, as produced by eventlog_entry_encode().
+ * Returns 0 on success, -1 on failure with errno set, or 1 if the entry
+ * is not in that form and must be fully decoded.
+ */
+static int iter_parse_fast (struct eventlog_iter *iter,
+                            const char *p,
+                            const char *end)
+{
+    const char *q;
+    char *endptr;
+
+    if (!(p = skip_token (p, end, "{"))
+        || !(p = skip_token (p, end, "\"timestamp\""))
+        || !(p = skip_token (p, end, ":")))
+        return 1;
+    p = skip_ws (p, end);
+    for (q = p; q < end && (isdigit (*q) || strchr ("+-.eE", *q)); q++)
+        ;
+    if (q == p || !(*p == '-' || isdigit (*p)))
+        return 1;
+    iter->timestamp = strtod (p, &endptr);
+    if (endptr != q)
+        return 1;
+    if (!(p = skip_token (q, end, ","))
+        || !(p = skip_token (p, end, "\"name\""))
+        || !(p = skip_token (p, end, ":"))
+        || !(p = skip_token (p, end, "\"")))
+        return 1;
+    for (q = p; q < end && *q != '"'; q++) {
+        if (*q == '\\' || (unsigned char)*q < 0x20)
+            return 1;
+    }
+    if (q == p || q == end)
+        return 1;
+    if (!(skip_token (q + 1, end, ",") || skip_token (q + 1, end, "}")))
+        return 1;
+    return iter_set_name (iter, p, q - p);
+}
+
+static int iter_parse (struct eventlog_iter *iter)
+{
+    const char *name;
+    int rc;
+
+    json_decref (iter->entry);
+    iter->entry = NULL;
+    if ((rc = iter_parse_fast (iter, iter->cur, iter->cur_end)) <= 0)
+        return rc;
+    if (!(iter->entry = json_loadb (iter->cur,
+                                    iter->cur_end - iter->cur,
+                                    0,
+                                    NULL))
+        || !eventlog_entry_validate (iter->entry)
+        || eventlog_entry_parse (iter->entry,
+                                 &iter->timestamp,
+                                 &name,
+                                 NULL) < 0) {
+        json_decref (iter->entry);
+        iter->entry = NULL;
+        errno = EINVAL;
+        return -1;
+    }
+    return iter_set_name (iter, name, strlen (name));
+}
+
+static int iter_get (struct eventlog_iter *iter,
+                     double *timestamp,
+                     const char **name)
+{
+    if (iter->cur_end == iter->cur) { // empty entry
+        errno = EINVAL;
+        return -1;
+    }
+    if (iter_parse (iter) < 0)
+        return -1;
+    if (timestamp)
+        *timestamp = iter->timestamp;
+    if (name)
+        *name = iter->name;
+    return 1;
+}
+
+int eventlog_iter_next (struct eventlog_iter *iter,
+                        double *timestamp,
+                        const char **name)
+{
+    const char *p;
+
+    if (!iter) {
+        errno = EINVAL;
+        return -1;
+    }
+    p = iter->cur ? iter->cur_end + 1 : iter->s;
+    if (p >= iter->end) {
+        iter->cur = NULL;
+        return 0;
+    }
+    iter->cur = p;
+    iter->cur_end = strchr (p, '\n');
+    return iter_get (iter, timestamp, name);
+}
+
+int eventlog_iter_prev (struct eventlog_iter *iter,
+                        double *timestamp,
+                        const char **name)
+{
+    const char *p;
+
+    if (!iter) {
+        errno = EINVAL;
+        return -1;
+    }
+    p = iter->cur ? iter->cur : iter->end;
+    if (p == iter->s) {
+        iter->cur = NULL;
+        return 0;
+    }
+    iter->cur_end = p - 1;
+    p = iter->cur_end;
+    while (p > iter->s && p[-1] != '\n')
+        p--;
+    iter->cur = p;
+    return iter_get (iter, timestamp, name);
+}
+
+json_t *eventlog_iter_entry (struct eventlog_iter *iter)
+{
+    if (!iter || !iter->cur) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!iter->entry) {
+        json_t *o;
+
+        if (!(o = json_loadb (iter->cur, iter->cur_end - iter->cur, 0, NULL))
+            || !eventlog_entry_validate (o)) {
+            json_decref (o);
+            errno = EINVAL;
+            return NULL;
+        }
+        iter->entry = o;
+    }
+    return iter->entry;
+}
+
 /*
  * vi:tabstop=4 shiftwidth=4 expandtab
  */
@@ -48,6 +48,32 @@ json_t *eventlog_entry_vpack (double timestamp,
 
 char *eventlog_entry_encode (json_t *entry);
 
+/* iterate over the entries of eventlog 's' one at a time, without
+ * decoding the whole eventlog.  's' is not copied and must remain valid
+ * for the life of the iterator.  An unpositioned iterator (new, or after
+ * reaching either end) moves to the first entry with eventlog_iter_next()
+ * or to the last with eventlog_iter_prev().  Each returns 1 with the
+ * timestamp and name of the entry, 0 if there are no more entries,
+ * or -1 with errno set on failure.  'name' is valid until the iterator
+ * moves.  Timestamp and name are extracted without decoding the entry
+ * context, so other errors in an entry may not be detected until
+ * eventlog_iter_entry() decodes it.
+ */
+struct eventlog_iter *eventlog_iter_create (const char *s);
+void eventlog_iter_destroy (struct eventlog_iter *iter);
+int eventlog_iter_next (struct eventlog_iter *iter,
+                        double *timestamp,
+                        const char **name);
+int eventlog_iter_prev (struct eventlog_iter *iter,
+                        double *timestamp,
+                        const char **name);
+
+/* decode the current entry of 'iter' into a json object, e.g. to get its
+ * context with eventlog_entry_parse().  The object is owned by the
+ * iterator and is valid until it moves.
+ */
+json_t *eventlog_iter_entry (struct eventlog_iter *iter);
+
 #endif /* !_EVENTLOG_H */
 
 /*
@@ -479,6 +479,104 @@ void eventlog_entry_encoding_errors (void)
         "eventlog_entry_vpack context=\"[\"foo\"]\" fails with EINVAL");
 }
 
+void eventlog_iterating (void)
+{
+    const char *log = "{\"timestamp\":1.0,\"name\":\"submit\","
+                      "\"context\":{\"userid\":42}}\n"
+                      "{ \"timestamp\" : 2, \"name\" : \"depend\" }\n"
+                      "{\"name\":\"start\",\"timestamp\":3.5}\n"
+                      "{\"timestamp\":4.0,\"name\":\"f\\u006fo\"}\n"
+                      "trailing garbage";
+    struct eventlog_iter *iter;
+    double timestamp;
+    const char *name;
+    json_t *entry;
+    json_t *context;
+    int userid;
+
+    errno = 0;
+    ok (eventlog_iter_create (NULL) == NULL && errno == EINVAL,
+        "eventlog_iter_create s=NULL fails with EINVAL");
+    errno = 0;
+    ok (eventlog_iter_next (NULL, NULL, NULL) < 0 && errno == EINVAL,
+        "eventlog_iter_next iter=NULL fails with EINVAL");
+
+    if (!(iter = eventlog_iter_create (log)))
+        BAIL_OUT ("eventlog_iter_create failed");
+    errno = 0;
+    ok (eventlog_iter_entry (iter) == NULL && errno == EINVAL,
+        "eventlog_iter_entry fails with EINVAL on unpositioned iterator");
+
+    ok (eventlog_iter_next (iter, &timestamp, &name) == 1
+        && timestamp == 1. && !strcmp (name, "submit"),
+        "eventlog_iter_next returns first entry");
+    ok ((entry = eventlog_iter_entry (iter)) != NULL
+        && eventlog_entry_parse (entry, NULL, NULL, &context) == 0
+        && json_unpack (context, "{s:i}", "userid", &userid) == 0
+        && userid == 42,
+        "eventlog_iter_entry returns entry with context");
+    ok (eventlog_iter_next (iter, &timestamp, &name) == 1
+        && timestamp == 2. && !strcmp (name, "depend"),
+        "eventlog_iter_next handles white space");
+    ok (eventlog_iter_next (iter, &timestamp, &name) == 1
+        && timestamp == 3.5 && !strcmp (name, "start"),
+        "eventlog_iter_next handles keys in any order");
+    ok (eventlog_iter_next (iter, &timestamp, &name) == 1
+        && timestamp == 4. && !strcmp (name, "foo"),
+        "eventlog_iter_next handles escapes in name");
+    ok (eventlog_iter_next (iter, &timestamp, &name) == 0,
+        "eventlog_iter_next returns 0 at end, ignoring trailing text");
+
+    ok (eventlog_iter_prev (iter, &timestamp, &name) == 1
+        && timestamp == 4. && !strcmp (name, "foo"),
+        "eventlog_iter_prev returns last entry");
+    ok (eventlog_iter_prev (iter, &timestamp, &name) == 1
+        && timestamp == 3.5 && !strcmp (name, "start"),
+        "eventlog_iter_prev returns previous entry");
+    ok (eventlog_iter_next (iter, &timestamp, &name) == 1
+        && timestamp == 4. && !strcmp (name, "foo"),
+        "eventlog_iter_next after eventlog_iter_prev works");
+    ok (eventlog_iter_prev (iter, NULL, NULL) == 1
+        && eventlog_iter_prev (iter, NULL, NULL) == 1
+        && eventlog_iter_prev (iter, NULL, &name) == 1
+        && !strcmp (name, "submit"),
+        "eventlog_iter_prev returns first entry");
+    ok (eventlog_iter_prev (iter, NULL, NULL) == 0,
+        "eventlog_iter_prev returns 0 at beginning");
+    eventlog_iter_destroy (iter);
+
+    if (!(iter = eventlog_iter_create ("")))
+        BAIL_OUT ("eventlog_iter_create failed");
+    ok (eventlog_iter_next (iter, NULL, NULL) == 0
+        && eventlog_iter_prev (iter, NULL, NULL) == 0,
+        "eventlog_iter_next/prev return 0 on empty eventlog");
+    eventlog_iter_destroy (iter);
+
+    if (!(iter = eventlog_iter_create ("{\"timestamp\":1,\"name\":\"a\"}\n"
+                                       "\n"
+                                       "{\"timestamp\":1}\n"
+                                       "{\"timestamp\":1.0,\"name\":\"b\","
+                                       "\"context\":[]}\n")))
+        BAIL_OUT ("eventlog_iter_create failed");
+    ok (eventlog_iter_next (iter, NULL, &name) == 1 && !strcmp (name, "a"),
+        "eventlog_iter_next works");
+    errno = 0;
+    ok (eventlog_iter_next (iter, NULL, NULL) < 0 && errno == EINVAL,
+        "eventlog_iter_next fails with EINVAL on empty entry");
+    errno = 0;
+    ok (eventlog_iter_next (iter, NULL, NULL) < 0 && errno == EINVAL,
+        "eventlog_iter_next fails with EINVAL on entry without name");
+    ok (eventlog_iter_next (iter, NULL, &name) == 1 && !strcmp (name, "b"),
+        "eventlog_iter_next does not check context");
+    errno = 0;
+    ok (eventlog_iter_entry (iter) == NULL && errno == EINVAL,
+        "eventlog_iter_entry fails with EINVAL on invalid context");
+    eventlog_iter_destroy (iter);
+
+    lives_ok ({eventlog_iter_destroy (NULL);},
+        "eventlog_iter_destroy NULL doesn't crash");
+}
+
 int main (int argc, char *argv[])
 {
     plan (NO_PLAN);
@@ -489,6 +587,7 @@ int main (int argc, char *argv[])
     eventlog_entry_decoding ();
     eventlog_entry_decoding_errors ();
     eventlog_entry_encoding ();
+    eventlog_iterating ();
     /* eventlog_entry_encoding_errors (); */
 
     done_testing ();
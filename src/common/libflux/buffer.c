@@ -17,6 +17,8 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <stdarg.h>
+#include <unistd.h>
+#include <sys/uio.h>
 
 #include "buffer.h"
 #include "buffer_private.h"
@@ -387,6 +389,54 @@ int flux_buffer_write (flux_buffer_t *fb, const void *data, int len)
     return ret;
 }
 
+int flux_buffer_peek_iov (flux_buffer_t *fb, int len, struct iovec *iov)
+{
+    if (!fb || fb->magic != FLUX_BUFFER_MAGIC || !iov) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    return cbuf_peek_iov (fb->cbuf, iov, len);
+}
+
+int flux_buffer_reserve (flux_buffer_t *fb, int len, struct iovec *iov)
+{
+    if (!fb || fb->magic != FLUX_BUFFER_MAGIC || !iov) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (fb->readonly) {
+        errno = EROFS;
+        return -1;
+    }
+
+    return cbuf_reserve (fb->cbuf, iov, len);
+}
+
+int flux_buffer_commit (flux_buffer_t *fb, int len)
+{
+    int ret;
+
+    if (!fb || fb->magic != FLUX_BUFFER_MAGIC) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (fb->readonly) {
+        errno = EROFS;
+        return -1;
+    }
+
+    if ((ret = cbuf_commit (fb->cbuf, len)) < 0)
+        return -1;
+
+    if (ret > 0)
+        check_read_cb (fb);
+
+    return ret;
+}
+
 int flux_buffer_lines (flux_buffer_t *fb)
 {
     if (!fb || fb->magic != FLUX_BUFFER_MAGIC) {
@@ -530,6 +580,27 @@ int flux_buffer_write_line (flux_buffer_t *fb, const char *data)
     return ret;
 }
 
+/* Write data in the buffer to [fd] with one writev(2), even if it
+ * wraps around the end of the ring buffer.
+ */
+static int peek_to_fd (flux_buffer_t *fb, int fd, int len)
+{
+    struct iovec iov[2];
+    int iovcnt;
+    ssize_t n;
+
+    if (fd < 0 || len < -1) {
+        errno = EINVAL;
+        return -1;
+    }
+    if ((iovcnt = cbuf_peek_iov (fb->cbuf, iov, len)) <= 0)
+        return iovcnt;
+    do {
+        n = writev (fd, iov, iovcnt);
+    } while (n < 0 && errno == EINTR);
+    return n;
+}
+
 int flux_buffer_peek_to_fd (flux_buffer_t *fb, int fd, int len)
 {
     if (!fb || fb->magic != FLUX_BUFFER_MAGIC) {
@@ -537,7 +608,7 @@ int flux_buffer_peek_to_fd (flux_buffer_t *fb, int fd, int len)
         return -1;
     }
 
-    return cbuf_peek_to_fd (fb->cbuf, fd, len);
+    return peek_to_fd (fb, fd, len);
 }
 
 int flux_buffer_read_to_fd (flux_buffer_t *fb, int fd, int len)
@@ -549,16 +620,23 @@ int flux_buffer_read_to_fd (flux_buffer_t *fb, int fd, int len)
         return -1;
     }
 
-    if ((ret = cbuf_read_to_fd (fb->cbuf, fd, len)) < 0)
+    if ((ret = peek_to_fd (fb, fd, len)) < 0)
         return -1;
 
-    check_write_cb (fb);
+    if (ret > 0) {
+        if (cbuf_drop (fb->cbuf, ret) < 0)
+            return -1;
+        check_write_cb (fb);
+    }
 
     return ret;
 }
 
 int flux_buffer_write_from_fd (flux_buffer_t *fb, int fd, int len)
 {
+    struct iovec iov[2];
+    int iovcnt;
+    ssize_t n;
     int ret;
 
     if (!fb || fb->magic != FLUX_BUFFER_MAGIC) {
@@ -571,7 +649,24 @@ int flux_buffer_write_from_fd (flux_buffer_t *fb, int fd, int len)
         return -1;
     }
 
-    if ((ret = cbuf_write_from_fd (fb->cbuf, fd, len, NULL)) < 0)
+    if (fd < 0 || len < -1) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (len == 0)
+        return 0;
+
+    /* Read directly into the ring buffer, with one readv(2) even if
+     * the free space wraps around its end.
+     */
+    if ((iovcnt = cbuf_reserve (fb->cbuf, iov, len)) < 0)
+        return -1;
+    do {
+        n = readv (fd, iov, iovcnt);
+    } while (n < 0 && errno == EINTR);
+    if (n <= 0)
+        return n;
+    if ((ret = cbuf_commit (fb->cbuf, n)) < 0)
         return -1;
 
     check_read_cb (fb);
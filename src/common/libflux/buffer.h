@@ -12,6 +12,7 @@
 #define FLUX_BUFFER_H
 
 #include <stdbool.h>
+#include <sys/uio.h>
 
 typedef struct flux_buffer flux_buffer_t;
 
@@ -71,6 +72,31 @@ const void *flux_buffer_read (flux_buffer_t *fb, int len, int *lenp);
  */
 int flux_buffer_write (flux_buffer_t *fb, const void *data, int len);
 
+/* Access up to [len] bytes of data in the buffer without copying or
+ * consuming it.  [iov] must have room for two entries, and is filled
+ * with the data in order, which spans two entries if it wraps around
+ * the end of the internal ring buffer.  The data is not NUL terminated,
+ * and remains valid until the buffer is next modified.  Consume with
+ * flux_buffer_drop().  Set [len] to -1 to access all data.  Returns the
+ * number of entries filled (0 if no data is available) or -1 on error.
+ */
+int flux_buffer_peek_iov (flux_buffer_t *fb, int len, struct iovec *iov);
+
+/* Reserve space for writing up to [len] bytes into the buffer without
+ * an intermediate copy.  [iov] must have room for two entries, and is
+ * filled with the space available, which may be less than [len].  Data
+ * stored there is added to the buffer by flux_buffer_commit(), and the
+ * buffer shall not be otherwise modified in between.  Set [len] to -1
+ * to reserve an appropriate chunk size.  Returns the number of entries
+ * filled or -1 on error, with errno set to ENOSPC if the buffer is full.
+ */
+int flux_buffer_reserve (flux_buffer_t *fb, int len, struct iovec *iov);
+
+/* Add [len] bytes of data stored in space from flux_buffer_reserve() to
+ * the buffer.  Returns number of bytes written on success.
+ */
+int flux_buffer_commit (flux_buffer_t *fb, int len);
+
 /* Determines lines available for peeking/reading.  Returns -1
  * on error, >= 0 for lines available */
 int flux_buffer_lines (flux_buffer_t *fb);
@@ -0,0 +1,59 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdint.h>
+#include <time.h>
+
+#include "cbstats.h"
+
+/* CLOCK_MONOTONIC is read through the vDSO on Linux, which costs tens
+ * of nanoseconds and needs no calibration, unlike the TSC.
+ */
+void cbstats_start (struct timespec *t0)
+{
+    clock_gettime (CLOCK_MONOTONIC, t0);
+}
+
+void cbstats_record (flux_cbstats_t *stats, struct timespec *t0)
+{
+    struct timespec t1;
+    int64_t nsec;
+    uint64_t usec;
+    double t;
+    int bucket;
+
+    clock_gettime (CLOCK_MONOTONIC, &t1);
+    nsec = (t1.tv_sec - t0->tv_sec) * 1000000000LL
+                      + (t1.tv_nsec - t0->tv_nsec);
+    if (nsec < 0)
+        nsec = 0;
+    t = 1E-9 * nsec;
+
+    /* hist[0] counts durations under 1us, hist[i] counts [2^(i-1),2^i) us,
+     * and the last bucket also counts anything longer.
+     */
+    usec = nsec / 1000;
+    bucket = usec == 0 ? 0 : 64 - __builtin_clzll (usec);
+    if (bucket >= FLUX_CBSTATS_BUCKETS)
+        bucket = FLUX_CBSTATS_BUCKETS - 1;
+
+    stats->count++;
+    stats->total += t;
+    if (stats->max < t)
+        stats->max = t;
+    stats->hist[bucket]++;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
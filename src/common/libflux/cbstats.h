@@ -0,0 +1,28 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _FLUX_CORE_CBSTATS_H
+#define _FLUX_CORE_CBSTATS_H
+
+#include <time.h>
+
+#include "reactor.h"
+
+/* Callback timing for reactor and message handler profiling.
+ * Call cbstats_start() before a callback and cbstats_record() after.
+ */
+void cbstats_start (struct timespec *t0);
+void cbstats_record (flux_cbstats_t *stats, struct timespec *t0);
+
+#endif /* !_FLUX_CORE_CBSTATS_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
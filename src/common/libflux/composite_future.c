@@ -16,18 +16,38 @@
 #include "future.h"
 
 /*  Type-specific data for a composite future:
+ *
+ *  Children are kept in an array in push order, which owns them, and
+ *   named children are also in a hash by name.  Each child's index is
+ *   set in its aux hash, so that a child continuation updates the count
+ *   of ready children and the queue of ready children in O(1), rather
+ *   than rechecking all children.
  */
 struct composite_future {
     int seq;             /* sequence for anonymous children          */
     unsigned int any:1;  /* true if this future is a "wait any" type */
     zhash_t *children;   /* hash of child futures by name            */
+
+    flux_future_t **vec; /* child futures by index                   */
+    int *ready;          /* child indices in order handled           */
+    bool *counted;       /* true if child index is in ready[]        */
+    int count;           /* number of children                       */
+    int size;            /* allocated size of vec, ready, counted    */
+    int nready;          /* number of children fulfilled             */
+    int errnum;          /* errnum of first child handled w/ error   */
 };
 
 static void composite_future_destroy (struct composite_future *f)
 {
     if (f) {
+        int i;
         if (f->children)
             zhash_destroy (&f->children);
+        for (i = 0; i < f->count; i++)
+            flux_future_destroy (f->vec[i]);
+        free (f->vec);
+        free (f->ready);
+        free (f->counted);
         free (f);
     }
 }
@@ -44,6 +64,26 @@ static struct composite_future * composite_future_create (void)
     return (cf);
 }
 
+static int composite_future_grow (struct composite_future *cf)
+{
+    int size = cf->size ? cf->size * 2 : 8;
+    flux_future_t **vec;
+    int *ready;
+    bool *counted;
+
+    if (!(vec = realloc (cf->vec, size * sizeof (vec[0]))))
+        return -1;
+    cf->vec = vec;
+    if (!(ready = realloc (cf->ready, size * sizeof (ready[0]))))
+        return -1;
+    cf->ready = ready;
+    if (!(counted = realloc (cf->counted, size * sizeof (counted[0]))))
+        return -1;
+    cf->counted = counted;
+    cf->size = size;
+    return 0;
+}
+
 /*  Return the embedded composite_future data from future `f`
  */
 static struct composite_future * composite_get (flux_future_t *f)
@@ -51,57 +91,51 @@ static struct composite_future * composite_get (flux_future_t *f)
     return flux_future_aux_get (f, "flux::composite");
 }
 
-/*
- *  Return true if all futures in this composite are ready
- */
-static bool wait_all_is_ready (struct composite_future *cf, int *errnum)
-{
-    int err = 0;
-    flux_future_t *f = zhash_first (cf->children);
-    while (f) {
-        if (!flux_future_is_ready (f))
-            return (false);
-        if (flux_future_get (f, NULL) < 0)
-            err = errno;
-        f = zhash_next (cf->children);
-    }
-    *errnum = err;
-    return (true);
-}
-
-/*
- *  Return true if cf->any or if all futures are fulfilled.
- *  Sets *errp to returned errno if any future failed for wait_all
- *   case, or if 'f', the current future, has error set for
- *   wait_any case.
+/*  Return the index of child future `f` in its parent, or -1
  */
-static bool composite_is_ready (struct composite_future *cf,
-                                flux_future_t *f,
-                                int *errp)
+static int child_index (flux_future_t *f)
 {
-    if (cf->any) {
-        *errp = flux_future_get (f, NULL) < 0 ? errno : 0;
-        return true;
-    }
-    return wait_all_is_ready (cf, errp);
+    int *index = flux_future_aux_get (f, "flux::child_index");
+    return index ? *index : -1;
 }
 
-/*  Continuation for children of a composition future -- simply check
- *   to see if the parent composite is "ready" and fulfill it if so.
+/*  Continuation for children of a composition future -- count the
+ *   child as ready the first time it is fulfilled, then fulfill the
+ *   parent if the composite is "ready": for wait_any, as soon as one
+ *   child is fulfilled, for wait_all, once the count of ready children
+ *   reaches the number of children.
+ *
+ *  For wait_any, the parent carries the error of the fulfilled child.
+ *   For wait_all, it carries the error of the first child handled here
+ *   with an error, if any.  Continuations of children fulfilled in the
+ *   same reactor loop iteration run in unspecified order, so ready[]
+ *   records the order children were handled, not fulfilled.
  */
 static void child_cb (flux_future_t *f, void *arg)
 {
-    int errnum;
     flux_future_t *parent = arg;
     struct composite_future *cf = composite_get (parent);
-    if (!arg || !cf)
+    int index = child_index (f);
+    int errnum;
+
+    if (!arg || !cf || index < 0 || index >= cf->count)
         return;
-    if (composite_is_ready (cf, f, &errnum)) {
-        if (errnum)
-            flux_future_fulfill_error (parent, errnum, NULL);
-        else
-            flux_future_fulfill (parent, NULL, NULL);
+    errnum = flux_future_get (f, NULL) < 0 ? errno : 0;
+    if (!cf->counted[index]) {
+        cf->counted[index] = true;
+        cf->ready[cf->nready++] = index;
+        if (errnum && !cf->errnum)
+            cf->errnum = errnum;
     }
+    if (!cf->any) {
+        if (cf->nready < cf->count)
+            return;
+        errnum = cf->errnum;
+    }
+    if (errnum)
+        flux_future_fulfill_error (parent, errnum, NULL);
+    else
+        flux_future_fulfill (parent, NULL, NULL);
 }
 
 /*  Propagate the current reactor *and* flux_t handle context from
@@ -125,9 +159,8 @@ static void future_propagate_context (flux_future_t *f, flux_future_t *next)
  */
 void composite_future_init (flux_future_t *f, void *arg)
 {
-    flux_future_t *child;
     struct composite_future *cf = arg;
-    bool empty = true;
+    int i;
     if (cf == NULL) {
         errno = EINVAL;
         goto error;
@@ -137,19 +170,15 @@ void composite_future_init (flux_future_t *f, void *arg)
      *   so that the composite future's 'then' *or* 'now' context becomes
      *   a 'then' context for all children.
      */
-    child = zhash_first (cf->children);
-    while (child) {
-        if (empty)
-            empty = false;
-        future_propagate_context (f, child);
-        if (flux_future_then (child, -1., child_cb, (void *) f) < 0)
+    for (i = 0; i < cf->count; i++) {
+        future_propagate_context (f, cf->vec[i]);
+        if (flux_future_then (cf->vec[i], -1., child_cb, (void *) f) < 0)
             goto error;
-        child = zhash_next (cf->children);
     }
     /*  An empty wait_all future is fulfilled immediately since
      *   logically "all" child futures are fulfilled
      */
-    if (empty && !cf->any)
+    if (cf->count == 0 && !cf->any)
         flux_future_fulfill (f, NULL, NULL);
     return;
 error:
@@ -188,6 +217,46 @@ flux_future_t *flux_future_wait_any_create (void)
     return future_create_composite (1);
 }
 
+/*  Append child to the array of children of composite future 'f'.
+ *  Return the index of the child on success.
+ */
+static int composite_append (flux_future_t *f,
+                             struct composite_future *cf,
+                             flux_future_t *child)
+{
+    int *index;
+
+    if (flux_future_aux_get (child, "flux::parent")) {
+        errno = EEXIST;
+        return -1;
+    }
+    if (cf->count == cf->size && composite_future_grow (cf) < 0)
+        return -1;
+    if (!(index = malloc (sizeof (*index))))
+        return -1;
+    *index = cf->count;
+    if (flux_future_aux_set (child, "flux::child_index", index, free) < 0) {
+        free (index);
+        return -1;
+    }
+    if (flux_future_aux_set (child, "flux::parent", f, NULL) < 0) {
+        (void) flux_future_aux_set (child, "flux::child_index", NULL, NULL);
+        return -1;
+    }
+    cf->vec[cf->count] = child;
+    cf->counted[cf->count] = false;
+    return cf->count++;
+}
+
+/*  Remove the last appended child from the array of children.
+ */
+static void composite_pop (struct composite_future *cf)
+{
+    flux_future_t *child = cf->vec[--cf->count];
+    (void) flux_future_aux_set (child, "flux::child_index", NULL, NULL);
+    (void) flux_future_aux_set (child, "flux::parent", NULL, NULL);
+}
+
 int flux_future_push (flux_future_t *f, const char *name, flux_future_t *child)
 {
     struct composite_future *cf = NULL;
@@ -203,11 +272,15 @@ int flux_future_push (flux_future_t *f, const char *name, flux_future_t *child)
             return -1;
         name = anon;
     }
-    if (zhash_insert (cf->children, name, child) < 0)
+    if (zhash_lookup (cf->children, name)) {
+        errno = EEXIST;
         goto done;
-    zhash_freefn (cf->children, name, (flux_free_f) flux_future_destroy);
-    if (flux_future_aux_set (child, "flux::parent", f, NULL) < 0) {
-        zhash_delete (cf->children, name);
+    }
+    if (composite_append (f, cf, child) < 0)
+        goto done;
+    if (zhash_insert (cf->children, name, child) < 0) {
+        composite_pop (cf);
+        errno = ENOMEM;
         goto done;
     }
     rc = 0;
@@ -216,6 +289,17 @@ done:
     return rc;
 }
 
+int flux_future_push_index (flux_future_t *f, flux_future_t *child)
+{
+    struct composite_future *cf = NULL;
+
+    if (!f || !child || !(cf = composite_get (f))) {
+        errno = EINVAL;
+        return -1;
+    }
+    return composite_append (f, cf, child);
+}
+
 flux_future_t *flux_future_get_child (flux_future_t *f, const char *name)
 {
     struct composite_future *cf = NULL;
@@ -226,6 +310,44 @@ flux_future_t *flux_future_get_child (flux_future_t *f, const char *name)
     return zhash_lookup (cf->children, name);
 }
 
+flux_future_t *flux_future_get_child_index (flux_future_t *f, int index)
+{
+    struct composite_future *cf = NULL;
+    if (!f || !(cf = composite_get (f))) {
+        errno = EINVAL;
+        return (NULL);
+    }
+    if (index < 0 || index >= cf->count) {
+        errno = ENOENT;
+        return (NULL);
+    }
+    return cf->vec[index];
+}
+
+int flux_future_child_count (flux_future_t *f)
+{
+    struct composite_future *cf = NULL;
+    if (!f || !(cf = composite_get (f))) {
+        errno = EINVAL;
+        return -1;
+    }
+    return cf->count;
+}
+
+int flux_future_ready_child (flux_future_t *f, int n)
+{
+    struct composite_future *cf = NULL;
+    if (!f || !(cf = composite_get (f)) || n < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (n >= cf->nready) {
+        errno = ENOENT;
+        return -1;
+    }
+    return cf->ready[n];
+}
+
 const char *flux_future_first_child (flux_future_t *f)
 {
     struct composite_future *cf = NULL;
@@ -19,6 +19,7 @@
 #include "content.h"
 
 #include "src/common/libutil/blobref.h"
+#include "src/common/libutil/blobbatch.h"
 
 flux_future_t *flux_content_load (flux_t *h, const char *blobref, int flags)
 {
@@ -73,6 +74,189 @@ int flux_content_store_get (flux_future_t *f, const char **blobref)
     return 0;
 }
 
+static flux_future_t *batch_rpc (flux_t *h,
+                                  const char *topic,
+                                  const char *backing_topic,
+                                  struct blobbatch *bb,
+                                  int flags)
+{
+    const void *buf;
+    int len;
+    uint32_t rank = FLUX_NODEID_ANY;
+
+    if ((flags & CONTENT_FLAG_UPSTREAM))
+        rank = FLUX_NODEID_UPSTREAM;
+    if ((flags & CONTENT_FLAG_CACHE_BYPASS)) {
+        topic = backing_topic;
+        rank = 0;
+    }
+    blobbatch_encode (bb, &buf, &len);
+    return flux_rpc_raw (h, topic, buf, len, rank, 0);
+}
+
+flux_future_t *flux_content_load_batch (flux_t *h,
+                                        const char **blobrefs,
+                                        int count,
+                                        int flags)
+{
+    struct blobbatch *bb;
+    flux_future_t *f = NULL;
+    int i;
+
+    if (!h || count < 1 || !blobrefs) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(bb = blobbatch_create ()))
+        return NULL;
+    for (i = 0; i < count; i++) {
+        if (!blobrefs[i] || blobref_validate (blobrefs[i]) < 0) {
+            errno = EINVAL;
+            goto done;
+        }
+        if (blobbatch_append (bb, blobrefs[i], strlen (blobrefs[i]) + 1) < 0)
+            goto done;
+    }
+    f = batch_rpc (h,
+                   "content.load-batch",
+                   "content-backing.load-batch",
+                   bb,
+                   flags);
+done:
+    blobbatch_destroy (bb);
+    return f;
+}
+
+static void blobbatch_destroy_wrapper (void *arg)
+{
+    blobbatch_destroy (arg);
+}
+
+/* Decode the batch response once, and cache the result in the future.
+ */
+static struct blobbatch *batch_get (flux_future_t *f)
+{
+    struct blobbatch *bb;
+    const void *buf;
+    int len;
+
+    if ((bb = flux_future_aux_get (f, "flux::blobbatch")))
+        return bb;
+    if (flux_rpc_get_raw (f, &buf, &len) < 0)
+        return NULL;
+    if (!(bb = blobbatch_decode (buf, len)))
+        return NULL;
+    if (flux_future_aux_set (f,
+                             "flux::blobbatch",
+                             bb,
+                             blobbatch_destroy_wrapper) < 0) {
+        blobbatch_destroy (bb);
+        return NULL;
+    }
+    return bb;
+}
+
+int flux_content_load_batch_get (flux_future_t *f,
+                                 int index,
+                                 const void **buf,
+                                 int *len)
+{
+    struct blobbatch *bb;
+
+    if (!(bb = batch_get (f)))
+        return -1;
+    return blobbatch_get (bb, index, buf, len);
+}
+
+flux_future_t *flux_content_store_batch (flux_t *h,
+                                         const void **bufs,
+                                         const int *lens,
+                                         int count,
+                                         int flags)
+{
+    struct blobbatch *bb;
+    flux_future_t *f = NULL;
+    int i;
+
+    if (!h || count < 1 || !bufs || !lens) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(bb = blobbatch_create ()))
+        return NULL;
+    for (i = 0; i < count; i++) {
+        if (blobbatch_append (bb, bufs[i], lens[i]) < 0)
+            goto done;
+    }
+    f = batch_rpc (h,
+                   "content.store-batch",
+                   "content-backing.store-batch",
+                   bb,
+                   flags);
+done:
+    blobbatch_destroy (bb);
+    return f;
+}
+
+int flux_content_store_batch_get (flux_future_t *f,
+                                  int index,
+                                  const char **blobref)
+{
+    struct blobbatch *bb;
+    const char *ref;
+
+    if (!(bb = batch_get (f)))
+        return -1;
+    if (!(ref = blobbatch_get_string (bb, index)))
+        return -1;
+    if (blobref_validate (ref) < 0) {
+        errno = EPROTO;
+        return -1;
+    }
+    if (blobref)
+        *blobref = ref;
+    return 0;
+}
+
+flux_future_t *flux_content_has (flux_t *h, const char **blobrefs, int count)
+{
+    struct blobbatch *bb;
+    flux_future_t *f = NULL;
+    int i;
+
+    if (!h || count < 1 || !blobrefs) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(bb = blobbatch_create ()))
+        return NULL;
+    for (i = 0; i < count; i++) {
+        if (!blobrefs[i] || blobref_validate (blobrefs[i]) < 0) {
+            errno = EINVAL;
+            goto done;
+        }
+        if (blobbatch_append (bb, blobrefs[i], strlen (blobrefs[i]) + 1) < 0)
+            goto done;
+    }
+    f = batch_rpc (h,
+                   NULL,
+                   "content-backing.has",
+                   bb,
+                   CONTENT_FLAG_CACHE_BYPASS);
+done:
+    blobbatch_destroy (bb);
+    return f;
+}
+
+int flux_content_has_get (flux_future_t *f, int index)
+{
+    struct blobbatch *bb;
+
+    if (!(bb = batch_get (f)))
+        return -1;
+    return blobbatch_get (bb, index, NULL, NULL);
+}
+
 /*
  * vi:tabstop=4 shiftwidth=4 expandtab
  */
@@ -46,6 +46,50 @@ flux_future_t *flux_content_store (flux_t *h,
  */
 int flux_content_store_get (flux_future_t *f, const char **blobref);
 
+/* Send one request to load 'count' blobs by blobref.
+ */
+flux_future_t *flux_content_load_batch (flux_t *h,
+                                        const char **blobrefs,
+                                        int count,
+                                        int flags);
+
+/* Get result of load batch request for blob 'index' (in request order).
+ * Storage for 'buf' belongs to 'f' and is valid until 'f' is destroyed.
+ * Returns 0 on success, -1 on failure with errno set, e.g. to ENOENT if
+ * that blob could not be loaded.
+ */
+int flux_content_load_batch_get (flux_future_t *f,
+                                 int index,
+                                 const void **buf,
+                                 int *len);
+
+/* Send one request to store 'count' blobs.
+ */
+flux_future_t *flux_content_store_batch (flux_t *h,
+                                         const void **bufs,
+                                         const int *lens,
+                                         int count,
+                                         int flags);
+
+/* Get result of store batch request for blob 'index' (in request order).
+ * Storage for 'blobref' belongs to 'f' and is valid until 'f' is destroyed.
+ * Returns 0 on success, -1 on failure with errno set.
+ */
+int flux_content_store_batch_get (flux_future_t *f,
+                                  int index,
+                                  const char **blobref);
+
+/* Send one request to the backing store, asking whether it holds each
+ * of 'count' blobs.  The request bypasses the cache.
+ */
+flux_future_t *flux_content_has (flux_t *h, const char **blobrefs, int count);
+
+/* Get result of has request for blob 'index' (in request order).
+ * Returns 0 if the backing store holds that blob, -1 on failure with
+ * errno set, e.g. to ENOENT if it does not.
+ */
+int flux_content_has_get (flux_future_t *f, int index);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,307 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* coro.c - stackless coroutines on futures
+ *
+ * The coroutine function is a switch on its resume point (see the
+ *  FLUX_CORO_* macros in future.h), so each step is a plain call of the
+ *  function.  A step ends by returning FLUX_CORO_YIELD with the futures
+ *  it pushed, which become the awaited set.  A continuation on each
+ *  awaited future counts it ready, and the next step is called when the
+ *  count reaches the size of the set.
+ *
+ * Awaited futures are kept in an array of slots that is reused by each
+ *  step, so steps do not allocate, apart from the futures themselves.
+ *  The array only grows while the function runs, which is never while
+ *  continuations of a slot are outstanding, so a slot may be passed as
+ *  the continuation argument.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "future.h"
+
+struct coro_slot {
+    flux_coro_t *co;
+    flux_future_t *f;
+    bool ready;
+};
+
+struct flux_coro {
+    flux_future_t *f;           /* the coroutine future */
+    flux_coro_f fn;
+    void *arg;
+    int state;                  /* resume point, 0 = not started */
+    bool started;
+    bool exited;
+    int errnum;                 /* first flux_coro_push() failure */
+
+    struct coro_slot *slots;    /* awaited [0,nwait), pushed [nwait,count) */
+    int count;
+    int size;
+    int nwait;
+    int pending;                /* awaited futures not yet ready */
+
+    void *result;
+    flux_free_f result_free;
+};
+
+static void coro_destroy (flux_coro_t *co)
+{
+    if (co) {
+        int saved_errno = errno;
+        int i;
+        for (i = 0; i < co->count; i++)
+            flux_future_destroy (co->slots[i].f);
+        free (co->slots);
+        if (co->result && co->result_free)
+            co->result_free (co->result);
+        free (co);
+        errno = saved_errno;
+    }
+}
+
+/*  Propagate the current reactor and flux_t handle of the coroutine
+ *   future to 'f', so that its continuation runs in the same context.
+ */
+static void coro_propagate_context (flux_coro_t *co, flux_future_t *f)
+{
+    flux_reactor_t *r = flux_future_get_reactor (co->f);
+    flux_t *h = flux_future_get_flux (co->f);
+
+    if (r)
+        flux_future_set_reactor (f, r);
+    if (h)
+        flux_future_set_flux (f, h);
+}
+
+static void coro_exit (flux_coro_t *co, int rc)
+{
+    int errnum = rc < 0 ? errno : 0;
+    int i;
+
+    co->exited = true;
+    for (i = 0; i < co->count; i++)
+        flux_future_destroy (co->slots[i].f);
+    co->count = co->nwait = co->pending = 0;
+    if (errnum)
+        flux_future_fulfill_error (co->f, errnum, NULL);
+    else {
+        flux_future_fulfill (co->f, co->result, co->result_free);
+        co->result = NULL;
+        co->result_free = NULL;
+    }
+}
+
+static void coro_child_cb (flux_future_t *f, void *arg);
+
+/*  Register continuations on awaited futures that are not yet ready.
+ */
+static int coro_await (flux_coro_t *co)
+{
+    int i;
+    for (i = 0; i < co->nwait; i++) {
+        struct coro_slot *slot = &co->slots[i];
+        if (slot->ready)
+            continue;
+        coro_propagate_context (co, slot->f);
+        if (flux_future_then (slot->f, -1., coro_child_cb, slot) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+/*  Run the next step of the coroutine.  On yield, the futures awaited
+ *   by the previous step are destroyed and the futures pushed by this
+ *   step take their place.
+ */
+static void coro_step (flux_coro_t *co)
+{
+    int rc = co->fn (co, co->arg);
+    int i;
+
+    if (rc != FLUX_CORO_YIELD) {
+        coro_exit (co, rc < 0 ? -1 : 0);
+        return;
+    }
+    for (i = 0; i < co->nwait; i++)
+        flux_future_destroy (co->slots[i].f);
+    co->count -= co->nwait;
+    if (co->nwait > 0 && co->count > 0)
+        memmove (co->slots,
+                 co->slots + co->nwait,
+                 co->count * sizeof (co->slots[0]));
+    co->nwait = co->pending = co->count;
+    if (co->errnum) {
+        errno = co->errnum;
+        goto error;
+    }
+    if (co->nwait == 0) {
+        errno = EINVAL;
+        goto error;
+    }
+    for (i = 0; i < co->nwait; i++)
+        co->slots[i].ready = false;
+    if (coro_await (co) < 0)
+        goto error;
+    return;
+error:
+    coro_exit (co, -1);
+}
+
+static void coro_child_cb (flux_future_t *f, void *arg)
+{
+    struct coro_slot *slot = arg;
+    flux_coro_t *co = slot->co;
+
+    if (slot->ready || co->exited)
+        return;
+    slot->ready = true;
+    if (--co->pending == 0)
+        coro_step (co);
+}
+
+/*  Initialization callback for the coroutine future, called once for
+ *   each context it is waited on in.  The first call runs the first step.
+ *   Later calls move outstanding continuations to the new context.
+ */
+static void coro_init (flux_future_t *f, void *arg)
+{
+    flux_coro_t *co = arg;
+
+    if (!co) {
+        errno = EINVAL;
+        goto error;
+    }
+    if (co->exited)
+        return;
+    if (!co->started) {
+        co->started = true;
+        coro_step (co);
+    }
+    else if (coro_await (co) < 0)
+        goto error;
+    return;
+error:
+    flux_future_fulfill_error (f, errno, NULL);
+}
+
+flux_future_t *flux_coro_create (flux_coro_f fn, void *arg)
+{
+    flux_coro_t *co;
+    flux_future_t *f;
+
+    if (!fn) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(co = calloc (1, sizeof (*co))))
+        return NULL;
+    co->fn = fn;
+    co->arg = arg;
+    if (!(f = flux_future_create (coro_init, co))
+        || flux_future_aux_set (f, "flux::coro",
+                                co,
+                                (flux_free_f) coro_destroy) < 0) {
+        coro_destroy (co);
+        flux_future_destroy (f);
+        return NULL;
+    }
+    co->f = f;
+    return f;
+}
+
+/*  A failed push also fails the coroutine at its next await, so that
+ *   a coroutine may push the result of a call that can fail, e.g.
+ *   flux_rpc(), without checking it.
+ */
+int flux_coro_push (flux_coro_t *co, flux_future_t *f)
+{
+    if (!co) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!f) {
+        if (errno == 0)
+            errno = EINVAL;
+        goto error;
+    }
+    if (flux_future_aux_get (f, "flux::coro_parent")) {
+        errno = EEXIST;
+        goto error;
+    }
+    if (co->count == co->size) {
+        int size = co->size ? co->size * 2 : 8;
+        struct coro_slot *slots;
+        if (!(slots = realloc (co->slots, size * sizeof (slots[0]))))
+            goto error;
+        co->slots = slots;
+        co->size = size;
+    }
+    if (flux_future_aux_set (f, "flux::coro_parent", co, NULL) < 0)
+        goto error;
+    co->slots[co->count].co = co;
+    co->slots[co->count].f = f;
+    co->slots[co->count].ready = false;
+    co->count++;
+    return 0;
+error:
+    if (!co->errnum)
+        co->errnum = errno;
+    return -1;
+}
+
+flux_future_t *flux_coro_get (flux_coro_t *co, int i)
+{
+    if (!co || i < 0 || i >= co->nwait) {
+        errno = EINVAL;
+        return NULL;
+    }
+    return co->slots[i].f;
+}
+
+int flux_coro_count (flux_coro_t *co)
+{
+    if (!co) {
+        errno = EINVAL;
+        return -1;
+    }
+    return co->nwait;
+}
+
+void flux_coro_set_result (flux_coro_t *co, void *result, flux_free_f free_fn)
+{
+    if (co) {
+        if (co->result && co->result_free)
+            co->result_free (co->result);
+        co->result = result;
+        co->result_free = free_fn;
+    }
+}
+
+int flux_coro_get_state (flux_coro_t *co)
+{
+    return co ? co->state : -1;
+}
+
+void flux_coro_set_state (flux_coro_t *co, int state)
+{
+    if (co)
+        co->state = state;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -33,6 +33,26 @@ static int get_pollevents (flux_t *h)
     return events;
 }
 
+/* The io watcher on the handle's pollfd stays started for the lifetime
+ * of the ev_flux watcher, so the loop wakes when the pollfd is signaled
+ * without re-registering the fd on every iteration.  The pollfd is edge
+ * triggered, so readiness is still tested with flux_pollevents():
+ * - prepare: if the handle is ready, start the no-op idle watcher so
+ *   the loop does not block
+ * - check: if the handle was not ready in prepare and the pollfd has not
+ *   been signaled since, nothing changed and flux_pollevents() is skipped
+ */
+static void io_cb (struct ev_loop *loop, ev_io *w, int revents)
+{
+    struct ev_flux *fw = (struct ev_flux *)((char *)w
+                            - offsetof (struct ev_flux, io_w));
+
+    /* Normally check_cb consumes io_w's pending event first.  If not,
+     * make sure the next check_cb tests the handle.
+     */
+    ev_idle_start (loop, &fw->idle_w);
+}
+
 static void prepare_cb (struct ev_loop *loop, ev_prepare *w, int revents)
 {
     struct ev_flux *fw = (struct ev_flux *)((char *)w
@@ -41,25 +61,24 @@ static void prepare_cb (struct ev_loop *loop, ev_prepare *w, int revents)
 
     if ((events & fw->events) || (events & EV_ERROR))
         ev_idle_start (loop, &fw->idle_w);
-    else
-        ev_io_start (loop, &fw->io_w);
 }
 
 static void check_cb (struct ev_loop *loop, ev_check *w, int revents)
 {
     struct ev_flux *fw = (struct ev_flux *)((char *)w
                             - offsetof (struct ev_flux, check_w));
+    int io_revents = ev_clear_pending (loop, &fw->io_w);
+    int events;
 
-    if (ev_is_pending (&fw->io_w)
-            && ev_clear_pending (loop, &fw->io_w) & EV_ERROR) {
-        fw->cb (loop, fw, EV_ERROR);
+    if (!ev_is_active (&fw->idle_w) && io_revents == 0)
         return;
-    }
-    int events = get_pollevents (fw->h);
-
-    ev_io_stop (loop, &fw->io_w);
     ev_idle_stop (loop, &fw->idle_w);
 
+    if ((io_revents & EV_ERROR)) {
+        fw->cb (loop, fw, EV_ERROR);
+        return;
+    }
+    events = get_pollevents (fw->h);
     if ((events & fw->events) || (events & EV_ERROR))
         fw->cb (loop, fw, events);
 }
@@ -75,7 +94,7 @@ int ev_flux_init (struct ev_flux *w, ev_flux_f cb, flux_t *h, int events)
     ev_prepare_init (&w->prepare_w, prepare_cb);
     ev_check_init (&w->check_w, check_cb);
     ev_idle_init (&w->idle_w, NULL);
-    ev_io_init (&w->io_w, NULL, w->pollfd, EV_READ);
+    ev_io_init (&w->io_w, io_cb, w->pollfd, EV_READ);
 
     return 0;
 }
@@ -84,6 +103,7 @@ void ev_flux_start (struct ev_loop *loop, struct ev_flux *w)
 {
     ev_prepare_start (loop, &w->prepare_w);
     ev_check_start (loop, &w->check_w);
+    ev_io_start (loop, &w->io_w);
 }
 
 void ev_flux_stop (struct ev_loop *loop, struct ev_flux *w)
@@ -21,6 +21,7 @@
 #include <assert.h>
 #include <inttypes.h>
 #include <zmq.h>
+#include <jansson.h>
 
 #include "flog.h"
 #include "attr.h"
@@ -232,48 +233,52 @@ done:
     return rc;
 }
 
+/* Entries are streamed in chunks, terminated by ENODATA unless following.
+ */
 static flux_future_t *dmesg_rpc (flux_t *h, int seq, bool follow)
 {
-    return flux_rpc_pack (h, "log.dmesg", FLUX_NODEID_ANY, 0,
-                          "{s:i s:b}", "seq", seq, "follow", follow);
+    return flux_rpc_pack (h, "log.dmesg", FLUX_NODEID_ANY, FLUX_RPC_STREAMING,
+                          "{s:i s:b s:b}",
+                          "seq", seq,
+                          "follow", follow,
+                          "stream", true);
 }
 
 static int dmesg_rpc_get (flux_future_t *f, int *seq, flux_log_f fun, void *arg)
 {
-    const char *buf;
-    int rc = -1;
+    json_t *bufs;
+    size_t index;
+    json_t *value;
 
-    if (flux_rpc_get_unpack (f, "{s:i s:s}", "seq", seq, "buf", &buf) < 0)
-        goto done;
-    fun (buf, strlen (buf), arg);
-    rc = 0;
-done:
-    return rc;
+    if (flux_rpc_get_unpack (f, "{s:i s:o}", "seq", seq, "bufs", &bufs) < 0)
+        return -1;
+    json_array_foreach (bufs, index, value) {
+        const char *buf = json_string_value (value);
+        if (buf)
+            fun (buf, json_string_length (value), arg);
+    }
+    return 0;
 }
 
 int flux_dmesg (flux_t *h, int flags, flux_log_f fun, void *arg)
 {
     int rc = -1;
     int seq = -1;
-    bool eof = false;
     bool follow = false;
 
     if (flags & FLUX_DMESG_FOLLOW)
         follow = true;
     if (fun) {
-        while (!eof) {
-            flux_future_t *f;
-            if (!(f = dmesg_rpc (h, seq, follow)))
-                goto done;
-            if (dmesg_rpc_get (f, &seq, fun, arg) < 0) {
-                if (errno != ENOENT) {
-                    flux_future_destroy (f);
-                    goto done;
-                }
-                eof = true;
-            }
+        flux_future_t *f;
+        if (!(f = dmesg_rpc (h, seq, follow)))
+            goto done;
+        while (dmesg_rpc_get (f, &seq, fun, arg) == 0)
+            flux_future_reset (f);
+        if (errno != ENODATA) {
             flux_future_destroy (f);
+            goto done;
         }
+        flux_future_destroy (f);
     }
     if ((flags & FLUX_DMESG_CLEAR)) {
         if (dmesg_clear (h, seq) < 0)
@@ -288,13 +293,24 @@ void flux_log_fprint (const char *buf, int len, void *arg)
 {
     FILE *f = arg;
     struct stdlog_header hdr;
-    const char *msg;
-    int msglen, severity;
+    const char *sd, *msg, *ranks;
+    int sdlen, msglen, rankslen, severity, count;
     uint32_t nodeid;
 
     if (f) {
-        if (stdlog_decode (buf, len, &hdr, NULL, NULL, &msg, &msglen) < 0)
+        if (stdlog_decode (buf, len, &hdr, &sd, &sdlen, &msg, &msglen) < 0)
             fprintf (f, "%.*s\n", len, buf);
+        else if (stdlog_repeat_decode (sd, sdlen,
+                                       &count, &ranks, &rankslen) == 0) {
+            severity = STDLOG_SEVERITY (hdr.pri);
+            fprintf (f, "%s %s.%s[%.*s]: %.*s (%d occurrences)\n",
+                     hdr.timestamp,
+                     hdr.appname,
+                     stdlog_severity_to_string (severity),
+                     rankslen, ranks,
+                     msglen, msg,
+                     count);
+        }
         else {
             nodeid = strtoul (hdr.hostname, NULL, 10);
             severity = STDLOG_SEVERITY (hdr.pri);
@@ -35,6 +35,8 @@
 #include "service.h"
 #include "version.h"
 #include "plugin.h"
+#include "msglist.h"
+#include "trace.h"
 
 #endif /* !_FLUX_CORE_FLUX_H */
 
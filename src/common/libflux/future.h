@@ -91,6 +91,21 @@ const char * flux_future_next_child (flux_future_t *cf);
 
 flux_future_t *flux_future_get_child (flux_future_t *cf, const char *name);
 
+/* Push an unnamed child, returning its index.  All children, named or
+ *  not, are indexed from 0 in push order.
+ */
+int flux_future_push_index (flux_future_t *cf, flux_future_t *f);
+
+flux_future_t *flux_future_get_child_index (flux_future_t *cf, int index);
+
+int flux_future_child_count (flux_future_t *cf);
+
+/* Return the index of the nth child whose fulfillment the composite has
+ * handled.  Children fulfilled in the same reactor loop iteration are
+ * handled in unspecified order, so this is not always fulfillment order.
+ */
+int flux_future_ready_child (flux_future_t *cf, int n);
+
 /* Future chaining
  */
 
@@ -125,6 +140,77 @@ int flux_future_continue (flux_future_t *prev, flux_future_t *f);
 void flux_future_continue_error (flux_future_t *prev, int errnum,
                                  const char *errstr);
 
+/* Coroutines
+ *
+ * A coroutine is a function run as a sequence of steps in a future.
+ *  Each step pushes one or more futures with flux_coro_push(), then
+ *  calls FLUX_CORO_AWAIT(), and the next step runs once all of them are
+ *  fulfilled.  Coroutines are stackless: local variables are not
+ *  preserved across FLUX_CORO_AWAIT() and must be kept in 'arg'.
+ *
+ *  static int lookup (flux_coro_t *co, void *arg)
+ *  {
+ *      struct ctx *ctx = arg;
+ *      FLUX_CORO_BEGIN (co);
+ *      flux_coro_push (co, flux_rpc (ctx->h, "a", NULL, 0, 0));
+ *      flux_coro_push (co, flux_rpc (ctx->h, "b", NULL, 0, 0));
+ *      FLUX_CORO_AWAIT (co);
+ *      if (flux_rpc_get (flux_coro_get (co, 0), NULL) < 0)
+ *          return -1;
+ *      ...
+ *      FLUX_CORO_END (co);
+ *  }
+ *
+ * The future returned by flux_coro_create() starts the coroutine when
+ *  it is first waited on, and is fulfilled when the function returns 0,
+ *  or fulfilled with errno if it returns -1.
+ */
+
+typedef struct flux_coro flux_coro_t;
+
+typedef int (*flux_coro_f)(flux_coro_t *co, void *arg);
+
+#define FLUX_CORO_YIELD 1
+
+#define FLUX_CORO_BEGIN(co) \
+    switch (flux_coro_get_state (co)) { case 0:
+
+/* Only one FLUX_CORO_AWAIT() may appear on a line.
+ */
+#define FLUX_CORO_AWAIT(co) \
+    do { \
+        flux_coro_set_state ((co), __LINE__); \
+        return FLUX_CORO_YIELD; \
+        case __LINE__:; \
+    } while (0)
+
+#define FLUX_CORO_END(co) \
+    } \
+    return 0
+
+flux_future_t *flux_coro_create (flux_coro_f fn, void *arg);
+
+/* Await future 'f' at the next FLUX_CORO_AWAIT().  The coroutine takes
+ *  ownership of 'f', which is destroyed at the following await, or when
+ *  the coroutine exits.
+ */
+int flux_coro_push (flux_coro_t *co, flux_future_t *f);
+
+/* Get the ith future, in push order, awaited by the last
+ *  FLUX_CORO_AWAIT(), or the number of such futures.
+ */
+flux_future_t *flux_coro_get (flux_coro_t *co, int i);
+int flux_coro_count (flux_coro_t *co);
+
+/* Set the result the coroutine future is fulfilled with on success.
+ */
+void flux_coro_set_result (flux_coro_t *co, void *result, flux_free_f free_fn);
+
+/* Resume point, used by FLUX_CORO_BEGIN() and FLUX_CORO_AWAIT().
+ */
+int flux_coro_get_state (flux_coro_t *co);
+void flux_coro_set_state (flux_coro_t *co, int state);
+
 #ifdef __cplusplus
 }
 #endif
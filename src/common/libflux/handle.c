@@ -32,6 +32,7 @@
 #include "msg_handler.h" // for flux_sleep_on ()
 #include "flog.h"
 #include "conf.h"
+#include "trace.h"
 
 #include "src/common/libutil/log.h"
 #include "src/common/libutil/msglist.h"
@@ -280,6 +281,8 @@ flux_t *flux_open (const char *uri, int flags)
         flags |= FLUX_O_TRACE;
     if (getenv ("FLUX_HANDLE_MATCHDEBUG"))
         flags |= FLUX_O_MATCHDEBUG;
+    if (getenv ("FLUX_HANDLE_RPCTRACE"))
+        flags |= FLUX_O_RPCTRACE;
     if (!(h = connector_init (path, flags))) {
         ERRNO_SAFE_WRAP (dlclose, dso);
         goto error;
@@ -602,6 +605,7 @@ int flux_send (flux_t *h, const flux_msg_t *msg, int flags)
     update_tx_stats (h, msg);
     if (flags & FLUX_O_TRACE)
         flux_msg_fprint (stderr, msg);
+    flux_trace_record (msg, "send");
     if (h->ops->send (h->impl, msg, flags) < 0)
         goto fatal;
 #if HAVE_CALIPER
@@ -44,6 +44,7 @@ enum {
     FLUX_O_CLONE = 2,   /* handle was created with flux_clone() */
     FLUX_O_NONBLOCK = 4,/* handle should not block on send/recv */
     FLUX_O_MATCHDEBUG = 8,/* enable matchtag debugging */
+    FLUX_O_RPCTRACE = 16,/* start a trace for each RPC (see trace.h) */
 };
 
 /* Flags for flux_requeue().
@@ -8,7 +8,7 @@
  * SPDX-License-Identifier: LGPL-3.0
 \************************************************************/
 
-/* A flux messages consist of a list of zeromq frames:
+/* A flux messages consist of a list of zeromq frames on the wire:
  *
  * [route]
  * [route]
@@ -21,6 +21,16 @@
  * PROTO frame
  *
  * See also: RFC 3
+ *
+ * In memory, the message is not kept as a list of frames.  The PROTO
+ * block is stored decoded in 'struct proto', the route stack is an array
+ * of strings ordered from first (sender) to last (most recent hop) so that
+ * push/pop operate in place at the end of the array, the topic is interned
+ * (see topic.c) or else kept in a buffer that is reused when the topic is
+ * replaced, and the payload is a
+ * refcounted, immutable buffer that is shared (not copied) by flux_msg_copy().
+ * Frames are only materialized when the message is sent on a zeromq socket
+ * or encoded, and then directly from these fields.
  */
 
 #if HAVE_CONFIG_H
@@ -33,6 +43,8 @@
 #include <assert.h>
 #include <fnmatch.h>
 #include <inttypes.h>
+#include <pthread.h>
+#include <time.h>
 #include <czmq.h>
 #include <jansson.h>
 
@@ -40,14 +52,7 @@
 #include "src/common/libutil/errno_safe.h"
 
 #include "message.h"
-
-struct flux_msg {
-    zmsg_t *zmsg;
-    json_t *json;
-    char *lasterr;
-    struct aux_item *aux;
-    int refcount;
-};
+#include "topic_private.h"
 
 /* Begin manual codec
  * PROTO consists of 4 byte prelude followed by a fixed length
@@ -70,160 +75,397 @@ struct flux_msg {
 #define PROTO_U32_COUNT     4
 #define PROTO_SIZE          4 + (PROTO_U32_COUNT * 4)
 
-/* Helpful aliases */
-#define PROTO_IND_NODEID    PROTO_IND_AUX1 // request
-#define PROTO_IND_MATCHTAG  PROTO_IND_AUX2 // request, response
-#define PROTO_IND_SEQUENCE  PROTO_IND_AUX1 // event
-#define PROTO_IND_ERRNUM    PROTO_IND_AUX1 // response, keepalive
-#define PROTO_IND_STATUS    PROTO_IND_AUX2 // keepalive
+/* A request with a deadline has one more u32 after the array, holding the
+ * milliseconds remaining when the message was encoded.  The time left is
+ * sent rather than the deadline itself, so clocks need not agree between
+ * nodes, and decoders that predate it ignore the longer PROTO frame.
+ * A message with a trace context follows that with the 64-bit trace and
+ * span ids, each as two u32's (high word first), and sets the timeout to
+ * PROTO_TIMEOUT_NONE if it has no deadline.
+ */
+#define PROTO_OFF_TIMEOUT   PROTO_SIZE
+#define PROTO_OFF_TRACE     (PROTO_SIZE + 4)
+#define PROTO_SIZE_TIMEOUT  (PROTO_SIZE + 4)
+#define PROTO_SIZE_MAX      (PROTO_SIZE + 20)
+
+#define PROTO_TIMEOUT_NONE  UINT32_MAX
+
+/* Usage of aux1 and aux2 depends on message type:
+ *   aux1: nodeid (request), sequence (event), errnum (response, keepalive)
+ *   aux2: matchtag (request, response), status (keepalive)
+ * 'deadline' is CLOCK_MONOTONIC seconds, or 0 for none (request only).
+ * 'trace' and 'span' are the trace context, or 0 for none (any type).
+ */
+struct proto {
+    uint8_t type;
+    uint8_t flags;
+    uint32_t userid;
+    uint32_t rolemask;
+    uint32_t aux1;
+    uint32_t aux2;
+    double deadline;
+    uint64_t trace;
+    uint64_t span;
+};
+
+static double monotonic_now (void)
+{
+    struct timespec ts;
 
-static int proto_set_u32 (uint8_t *data, int len, int index, uint32_t val);
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1E-9;
+}
 
-static int proto_set_type (uint8_t *data, int len, int type)
+/* Encode 'proto' into 'data' (PROTO_SIZE_MAX bytes) and return the size.
+ */
+static size_t proto_encode (const struct proto *proto, uint8_t *data)
 {
+    uint32_t u32[PROTO_U32_COUNT] = {
+        htonl (proto->userid),
+        htonl (proto->rolemask),
+        htonl (proto->aux1),
+        htonl (proto->aux2),
+    };
+    uint32_t ms = PROTO_TIMEOUT_NONE;
+    uint32_t ids[4];
+
+    data[PROTO_OFF_MAGIC] = PROTO_MAGIC;
+    data[PROTO_OFF_VERSION] = PROTO_VERSION;
+    data[PROTO_OFF_TYPE] = proto->type;
+    data[PROTO_OFF_FLAGS] = proto->flags;
+    memcpy (&data[PROTO_OFF_U32_ARRAY], u32, sizeof (u32));
+    if (proto->deadline == 0 && proto->trace == 0)
+        return PROTO_SIZE;
+    if (proto->deadline > 0) {
+        double remaining = (proto->deadline - monotonic_now ()) * 1E3;
+
+        if (remaining <= 0)
+            ms = 0;
+        else if (remaining >= PROTO_TIMEOUT_NONE)
+            ms = PROTO_TIMEOUT_NONE - 1;
+        else
+            ms = (uint32_t)remaining;
+    }
+    ms = htonl (ms);
+    memcpy (&data[PROTO_OFF_TIMEOUT], &ms, sizeof (ms));
+    if (proto->trace == 0)
+        return PROTO_SIZE_TIMEOUT;
+    ids[0] = htonl (proto->trace >> 32);
+    ids[1] = htonl (proto->trace & 0xffffffff);
+    ids[2] = htonl (proto->span >> 32);
+    ids[3] = htonl (proto->span & 0xffffffff);
+    memcpy (&data[PROTO_OFF_TRACE], ids, sizeof (ids));
+    return PROTO_SIZE_MAX;
+}
+
+static int proto_decode (struct proto *proto, const uint8_t *data, size_t len)
+{
+    uint32_t u32[PROTO_U32_COUNT];
+
     if (len < PROTO_SIZE || data[PROTO_OFF_MAGIC] != PROTO_MAGIC
                          || data[PROTO_OFF_VERSION] != PROTO_VERSION)
         return -1;
+    proto->type = data[PROTO_OFF_TYPE];
+    proto->flags = data[PROTO_OFF_FLAGS];
+    memcpy (u32, &data[PROTO_OFF_U32_ARRAY], sizeof (u32));
+    proto->userid = ntohl (u32[PROTO_IND_USERID]);
+    proto->rolemask = ntohl (u32[PROTO_IND_ROLEMASK]);
+    proto->aux1 = ntohl (u32[PROTO_IND_AUX1]);
+    proto->aux2 = ntohl (u32[PROTO_IND_AUX2]);
+    proto->deadline = 0;
+    proto->trace = 0;
+    proto->span = 0;
+    if (len >= PROTO_SIZE_TIMEOUT && proto->type == FLUX_MSGTYPE_REQUEST) {
+        uint32_t ms;
+        memcpy (&ms, &data[PROTO_OFF_TIMEOUT], sizeof (ms));
+        ms = ntohl (ms);
+        if (ms != PROTO_TIMEOUT_NONE)
+            proto->deadline = monotonic_now () + ms * 1E-3;
+    }
+    if (len >= PROTO_SIZE_MAX) {
+        uint32_t ids[4];
+        memcpy (ids, &data[PROTO_OFF_TRACE], sizeof (ids));
+        proto->trace = (uint64_t)ntohl (ids[0]) << 32 | ntohl (ids[1]);
+        proto->span = (uint64_t)ntohl (ids[2]) << 32 | ntohl (ids[3]);
+    }
+    return 0;
+}
+
+static int proto_set_type (struct proto *proto, int type)
+{
     switch (type) {
         case FLUX_MSGTYPE_REQUEST:
-            if (proto_set_u32 (data, len, PROTO_IND_NODEID,
-                               FLUX_NODEID_ANY) < 0)
-                return -1;
-            if (proto_set_u32 (data, len, PROTO_IND_MATCHTAG,
-                               FLUX_MATCHTAG_NONE) < 0)
-                return -1;
+            proto->aux1 = FLUX_NODEID_ANY;      // nodeid
+            proto->aux2 = FLUX_MATCHTAG_NONE;   // matchtag
             break;
         case FLUX_MSGTYPE_RESPONSE:
             /* N.B. don't clobber matchtag from request on set_type */
-            if (proto_set_u32 (data, len, PROTO_IND_ERRNUM, 0) < 0)
-                return -1;
+            proto->aux1 = 0;                    // errnum
             break;
         case FLUX_MSGTYPE_EVENT:
-            if (proto_set_u32 (data, len, PROTO_IND_SEQUENCE, 0) < 0)
-                return -1;
-            if (proto_set_u32 (data, len, PROTO_IND_AUX2, 0) < 0)
-                return -1;
+            proto->aux1 = 0;                    // sequence
+            proto->aux2 = 0;
             break;
         case FLUX_MSGTYPE_KEEPALIVE:
-            if (proto_set_u32 (data, len, PROTO_IND_STATUS, 0) < 0)
-                return -1;
-            if (proto_set_u32 (data, len, PROTO_IND_ERRNUM, 0) < 0)
-                return -1;
+            proto->aux2 = 0;                    // status
+            proto->aux1 = 0;                    // errnum
             break;
         default:
             return -1;
     }
-    data[PROTO_OFF_TYPE] = type;
+    if (type != FLUX_MSGTYPE_REQUEST)
+        proto->deadline = 0;
+    proto->type = type;
     return 0;
 }
-static int proto_get_type (uint8_t *data, int len, int *type)
+
+static void proto_init (struct proto *proto, uint8_t flags)
 {
-    if (len < PROTO_SIZE || data[PROTO_OFF_MAGIC] != PROTO_MAGIC
-                         || data[PROTO_OFF_VERSION] != PROTO_VERSION)
-        return -1;
-    *type = data[PROTO_OFF_TYPE];
-    return 0;
+    memset (proto, 0, sizeof (*proto));
+    proto->flags = flags;
+    proto->userid = FLUX_USERID_UNKNOWN;
+    proto->rolemask = FLUX_ROLE_NONE;
 }
-static int proto_set_flags (uint8_t *data, int len, uint8_t flags)
+/* End manual codec
+ */
+
+/* Immutable payload buffer, shared among message copies.
+ * The decoded JSON object is cached here rather than in the message,
+ * so copies of a message parse the payload at most once between them.
+ */
+struct payload {
+    int refcount;
+    int size;
+    json_t *json;
+    char data[];
+};
+
+struct flux_msg {
+    struct proto proto;
+    char **routes;          /* routes[0] = first hop, routes[n-1] = last */
+    int route_count;
+    int route_alloc;
+    const char *topic;      /* topic_intern->s or topic_buf */
+    size_t topic_len;
+    const struct flux_topic *topic_intern;
+    char *topic_buf;        /* used for topics that can't be interned */
+    size_t topic_alloc;
+    struct payload *payload;
+    char *lasterr;
+    struct aux_item *aux;
+    int refcount;
+};
+
+/* Per-thread cache of released message structures and small payload
+ * buffers.  Each broker module runs its own handle in its own thread,
+ * so a thread cache is effectively a per-handle cache.  Cached messages
+ * keep their route array and topic buffer allocations for reuse.
+ * A message or payload released in a thread other than the one that
+ * allocated it simply lands in the releasing thread's cache.
+ */
+#define MSGCACHE_MAX_MSGS       256
+#define MSGCACHE_MAX_PAYLOADS   256
+#define MSGCACHE_PAYLOAD_SIZE   256 /* payloads <= this size are cached */
+
+struct msgcache {
+    flux_msg_t *msgs[MSGCACHE_MAX_MSGS];
+    int msg_count;
+    struct payload *payloads[MSGCACHE_MAX_PAYLOADS];
+    int payload_count;
+    flux_msg_cachestats_t stats;
+};
+
+static pthread_key_t msgcache_key;
+static pthread_once_t msgcache_once = PTHREAD_ONCE_INIT;
+static bool msgcache_key_valid;
+
+static void msg_free (flux_msg_t *msg);
+
+static void msgcache_destroy (void *arg)
 {
-    if (len < PROTO_SIZE || data[PROTO_OFF_MAGIC] != PROTO_MAGIC
-                         || data[PROTO_OFF_VERSION] != PROTO_VERSION)
-        return -1;
-    data[PROTO_OFF_FLAGS] = flags;
-    return 0;
+    struct msgcache *cache = arg;
+
+    if (cache) {
+        int saved_errno = errno;
+        while (cache->msg_count > 0)
+            msg_free (cache->msgs[--cache->msg_count]);
+        while (cache->payload_count > 0)
+            free (cache->payloads[--cache->payload_count]);
+        free (cache);
+        errno = saved_errno;
+    }
 }
-static int proto_get_flags (uint8_t *data, int len, uint8_t *val)
+
+static void msgcache_key_create (void)
 {
-    if (len < PROTO_SIZE || data[PROTO_OFF_MAGIC] != PROTO_MAGIC
-                         || data[PROTO_OFF_VERSION] != PROTO_VERSION)
-        return -1;
-    *val = data[PROTO_OFF_FLAGS];
-    return 0;
+    if (pthread_key_create (&msgcache_key, msgcache_destroy) == 0)
+        msgcache_key_valid = true;
 }
-static int proto_set_u32 (uint8_t *data, int len, int index, uint32_t val)
+
+/* Return the calling thread's cache, creating it if necessary.
+ * Returns NULL if the cache cannot be created; callers fall back to
+ * the heap in that case.
+ */
+static struct msgcache *msgcache_get (void)
 {
-    uint32_t x = htonl (val);
-    int offset = PROTO_OFF_U32_ARRAY + index * 4;
+    struct msgcache *cache;
 
-    if (len < PROTO_SIZE || data[PROTO_OFF_MAGIC] != PROTO_MAGIC
-                         || data[PROTO_OFF_VERSION] != PROTO_VERSION
-                         || index < 0 || index >= PROTO_U32_COUNT)
-        return -1;
-    memcpy (&data[offset], &x, sizeof (x));
-    return 0;
+    pthread_once (&msgcache_once, msgcache_key_create);
+    if (!msgcache_key_valid)
+        return NULL;
+    if (!(cache = pthread_getspecific (msgcache_key))) {
+        if (!(cache = calloc (1, sizeof (*cache))))
+            return NULL;
+        if (pthread_setspecific (msgcache_key, cache) != 0) {
+            free (cache);
+            return NULL;
+        }
+    }
+    return cache;
 }
-static int proto_get_u32 (uint8_t *data, int len, int index, uint32_t *val)
+
+void flux_msg_get_cachestats (flux_msg_cachestats_t *stats)
 {
-    uint32_t x;
-    int offset = PROTO_OFF_U32_ARRAY + index * 4;
+    struct msgcache *cache;
 
-    if (len < PROTO_SIZE || data[PROTO_OFF_MAGIC] != PROTO_MAGIC
-                         || data[PROTO_OFF_VERSION] != PROTO_VERSION
-                         || index < 0 || index >= PROTO_U32_COUNT)
-        return -1;
-    memcpy (&x, &data[offset], sizeof (x));
-    *val = ntohl (x);
-    return 0;
+    if (!stats)
+        return;
+    if ((cache = msgcache_get ())) {
+        *stats = cache->stats;
+        stats->msg_cached = cache->msg_count;
+        stats->payload_cached = cache->payload_count;
+    }
+    else
+        memset (stats, 0, sizeof (*stats));
 }
-static void proto_init (uint8_t *data, int len, uint8_t flags)
+
+static struct payload *payload_create (const void *buf, int size)
 {
-    int n;
-    assert (len >= PROTO_SIZE);
-    memset (data, 0, len);
-    data[PROTO_OFF_MAGIC] = PROTO_MAGIC;
-    data[PROTO_OFF_VERSION] = PROTO_VERSION;
-    data[PROTO_OFF_FLAGS] = flags;
-    n = proto_set_u32 (data, len, PROTO_IND_USERID, FLUX_USERID_UNKNOWN);
-    assert (n == 0);
-    n = proto_set_u32 (data, len, PROTO_IND_ROLEMASK, FLUX_ROLE_NONE);
-    assert (n == 0);
+    struct msgcache *cache = msgcache_get ();
+    struct payload *p;
+
+    if (size <= MSGCACHE_PAYLOAD_SIZE) {
+        if (cache && cache->payload_count > 0) {
+            p = cache->payloads[--cache->payload_count];
+            cache->stats.payload_reuse++;
+        }
+        else {
+            if (!(p = malloc (sizeof (*p) + MSGCACHE_PAYLOAD_SIZE)))
+                return NULL;
+            if (cache)
+                cache->stats.payload_alloc++;
+        }
+    }
+    else {
+        if (!(p = malloc (sizeof (*p) + size)))
+            return NULL;
+        if (cache)
+            cache->stats.payload_alloc++;
+    }
+    p->refcount = 1;
+    p->size = size;
+    p->json = NULL;
+    memcpy (p->data, buf, size);
+    return p;
+}
+
+static struct payload *payload_incref (struct payload *p)
+{
+    if (p)
+        (void)__atomic_add_fetch (&p->refcount, 1, __ATOMIC_RELAXED);
+    return p;
+}
+
+static void payload_decref (struct payload *p)
+{
+    if (p && __atomic_sub_fetch (&p->refcount, 1, __ATOMIC_ACQ_REL) == 0) {
+        struct msgcache *cache;
+
+        json_decref (p->json);
+        if (p->size <= MSGCACHE_PAYLOAD_SIZE
+            && (cache = msgcache_get ())
+            && cache->payload_count < MSGCACHE_MAX_PAYLOADS)
+            cache->payloads[cache->payload_count++] = p;
+        else
+            free (p);
+    }
 }
-/* End manual codec
- */
 
 static flux_msg_t *flux_msg_create_common (void)
 {
+    struct msgcache *cache = msgcache_get ();
     flux_msg_t *msg;
 
-    if (!(msg = calloc (1, sizeof (*msg))))
-        return NULL;
+    if (cache && cache->msg_count > 0) {
+        msg = cache->msgs[--cache->msg_count];
+        cache->stats.msg_reuse++;
+    }
+    else {
+        if (!(msg = calloc (1, sizeof (*msg))))
+            return NULL;
+        if (cache)
+            cache->stats.msg_alloc++;
+    }
     msg->refcount = 1;
     return msg;
 }
 
 flux_msg_t *flux_msg_create (int type)
 {
-    uint8_t proto[PROTO_SIZE];
     flux_msg_t *msg;
 
     if (!(msg = flux_msg_create_common ()))
         return NULL;
-    proto_init (proto, PROTO_SIZE, 0);
-    if (proto_set_type (proto, PROTO_SIZE, type) < 0) {
+    proto_init (&msg->proto, 0);
+    if (proto_set_type (&msg->proto, type) < 0) {
         errno = EINVAL;
         goto error;
     }
-    if (!(msg->zmsg = zmsg_new ())) {
-        errno = ENOMEM;
-        goto error;
-    }
-    if (zmsg_addmem (msg->zmsg, proto, PROTO_SIZE) < 0)
-        goto error;
     return msg;
 error:
     flux_msg_destroy (msg);
     return NULL;
 }
 
+static void msg_routes_free (flux_msg_t *msg)
+{
+    int i;
+
+    for (i = 0; i < msg->route_count; i++)
+        free (msg->routes[i]);
+    msg->route_count = 0;
+}
+
+static void msg_free (flux_msg_t *msg)
+{
+    msg_routes_free (msg);
+    free (msg->routes);
+    free (msg->topic_buf);
+    free (msg);
+}
+
 void flux_msg_destroy (flux_msg_t *msg)
 {
-    if (msg && --msg->refcount == 0) {
+    if (msg && __atomic_sub_fetch (&msg->refcount, 1, __ATOMIC_ACQ_REL) == 0) {
         int saved_errno = errno;
-        json_decref (msg->json);
-        zmsg_destroy (&msg->zmsg);
+        struct msgcache *cache;
+
+        msg_routes_free (msg);
+        payload_decref (msg->payload);
         aux_destroy (&msg->aux);
         free (msg->lasterr);
-        free (msg);
+        if ((cache = msgcache_get ())
+            && cache->msg_count < MSGCACHE_MAX_MSGS) {
+            /* Retain route array and topic buffer, reset the rest.
+             */
+            memset (&msg->proto, 0, sizeof (msg->proto));
+            msg->payload = NULL;
+            msg->lasterr = NULL;
+            msg->aux = NULL;
+            cache->msgs[cache->msg_count++] = msg;
+        }
+        else
+            msg_free (msg);
         errno = saved_errno;
     }
 }
@@ -232,6 +474,10 @@ void flux_msg_destroy (flux_msg_t *msg)
  * incref/decref to allow msg destruction to be juggled to whoever last
  * decrements the reference count.  Other than its eventual destruction,
  * the message content shall not change.
+ * Reference counts are atomic, but unpacking writes the message (last
+ * error) and its payload (decoded JSON cache), and jansson objects are not
+ * thread safe, so a message or a copy sharing its payload must not be used
+ * from two threads.  Hand another thread a copy with its own payload.
  */
 void flux_msg_decref (const flux_msg_t *const_msg)
 {
@@ -247,7 +493,7 @@ const flux_msg_t *flux_msg_incref (const flux_msg_t *const_msg)
         errno = EINVAL;
         return NULL;
     }
-    msg->refcount++;
+    (void)__atomic_add_fetch (&msg->refcount, 1, __ATOMIC_RELAXED);
     return msg;
 }
 
@@ -275,96 +521,288 @@ void *flux_msg_aux_get (const flux_msg_t *msg, const char *name)
     return aux_get (msg->aux, name);
 }
 
+/* Iterate over the wire representation of 'msg', calling 'fn' once per
+ * frame in the order frames appear on the wire.  The PROTO frame is
+ * encoded into 'proto' (caller-supplied PROTO_SIZE_MAX buffer).
+ * Stops early and returns -1 if 'fn' returns -1.
+ */
+typedef int (*frame_f)(const void *data, size_t size, bool more, void *arg);
+
+static int msg_foreach_frame (const flux_msg_t *msg,
+                              uint8_t *proto,
+                              frame_f fn,
+                              void *arg)
+{
+    int i;
+
+    if ((msg->proto.flags & FLUX_MSGFLAG_ROUTE)) {
+        for (i = msg->route_count - 1; i >= 0; i--) {
+            if (fn (msg->routes[i], strlen (msg->routes[i]), true, arg) < 0)
+                return -1;
+        }
+        if (fn (NULL, 0, true, arg) < 0)
+            return -1;
+    }
+    if ((msg->proto.flags & FLUX_MSGFLAG_TOPIC)) {
+        if (fn (msg->topic, msg->topic_len + 1, true, arg) < 0)
+            return -1;
+    }
+    if ((msg->proto.flags & FLUX_MSGFLAG_PAYLOAD)) {
+        if (fn (msg->payload->data, msg->payload->size, true, arg) < 0)
+            return -1;
+    }
+    if (fn (proto, proto_encode (&msg->proto, proto), false, arg) < 0)
+        return -1;
+    return 0;
+}
+
+static int frame_encode_size (const void *data, size_t n, bool more, void *arg)
+{
+    size_t *size = arg;
+
+    if (n < 0xff)
+        *size += 1;
+    else
+        *size += 1 + 4;
+    *size += n;
+    return 0;
+}
+
 size_t flux_msg_encode_size (const flux_msg_t *msg)
 {
-    zframe_t *zf;
+    uint8_t proto[PROTO_SIZE_MAX];
     size_t size = 0;
 
-    zf = zmsg_first (msg->zmsg);
-    while (zf) {
-        size_t n = zframe_size (zf);
-        if (n < 255)
-            size += 1;
-        else
-            size += 1 + 4;
-        size += n;
-        zf = zmsg_next (msg->zmsg);
-    }
+    (void)msg_foreach_frame (msg, proto, frame_encode_size, &size);
     return size;
 }
 
+struct encode_cursor {
+    uint8_t *p;
+    size_t left;
+};
+
+static int frame_encode (const void *data, size_t n, bool more, void *arg)
+{
+    struct encode_cursor *cur = arg;
+
+    if (n < 0xff) {
+        if (cur->left < n + 1)
+            return -1;
+        *cur->p++ = (uint8_t)n;
+        cur->left -= 1;
+    } else {
+        uint32_t x = htonl (n);
+        if (cur->left < n + 1 + 4)
+            return -1;
+        *cur->p++ = 0xff;
+        memcpy (cur->p, &x, sizeof (x));
+        cur->p += 4;
+        cur->left -= 1 + 4;
+    }
+    if (n > 0)
+        memcpy (cur->p, data, n);
+    cur->p += n;
+    cur->left -= n;
+    return 0;
+}
 
 int flux_msg_encode (const flux_msg_t *msg, void *buf, size_t size)
 {
-    uint8_t *p = buf;
-    zframe_t *zf;
+    uint8_t proto[PROTO_SIZE_MAX];
+    struct encode_cursor cur = { .p = buf, .left = size };
 
-    zf = zmsg_first (msg->zmsg);
-    while (zf) {
-        size_t n = zframe_size (zf);
-        if (n < 0xff) {
-            if (size - (p - (uint8_t *)buf) < n + 1)
-                goto nospace;
-            *p++ = (uint8_t)n;
-        } else {
-            if (size - (p - (uint8_t *)buf) < n + 1 + 4)
-                goto nospace;
-            *p++ = 0xff;
-            *(uint32_t *)p = htonl (n);
-            p += 4;
+    if (msg_foreach_frame (msg, proto, frame_encode, &cur) < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    return 0;
+}
+
+int flux_msg_frames (const flux_msg_t *msg)
+{
+    int count = 1; // PROTO
+
+    if ((msg->proto.flags & FLUX_MSGFLAG_ROUTE))
+        count += msg->route_count + 1;
+    if ((msg->proto.flags & FLUX_MSGFLAG_TOPIC))
+        count++;
+    if ((msg->proto.flags & FLUX_MSGFLAG_PAYLOAD))
+        count++;
+    return count;
+}
+
+struct frame {
+    const void *data;
+    size_t size;
+};
+
+static int msg_append_route (flux_msg_t *msg, const char *id, size_t len)
+{
+    char *s;
+
+    if (msg->route_count == msg->route_alloc) {
+        int new_alloc = msg->route_alloc > 0 ? msg->route_alloc * 2 : 4;
+        char **new_routes;
+        if (!(new_routes = realloc (msg->routes,
+                                    new_alloc * sizeof (msg->routes[0]))))
+            return -1;
+        msg->routes = new_routes;
+        msg->route_alloc = new_alloc;
+    }
+    if (!(s = strndup (id, len)))
+        return -1;
+    msg->routes[msg->route_count++] = s;
+    return 0;
+}
+
+static int msg_set_topic_buf (flux_msg_t *msg, const char *topic, size_t len)
+{
+    len = strnlen (topic, len);
+    if ((msg->topic_intern = flux_topic_intern (topic, len))) {
+        msg->topic = msg->topic_intern->s;
+        msg->topic_len = len;
+        return 0;
+    }
+    if (len + 1 > msg->topic_alloc) {
+        char *new_topic;
+        if (!(new_topic = realloc (msg->topic_buf, len + 1)))
+            return -1;
+        msg->topic_buf = new_topic;
+        msg->topic_alloc = len + 1;
+    }
+    memcpy (msg->topic_buf, topic, len);
+    msg->topic_buf[len] = '\0';
+    msg->topic = msg->topic_buf;
+    msg->topic_len = len;
+    return 0;
+}
+
+/* Build a message from an array of wire frames.
+ * The last frame is the PROTO frame, whose flags determine how the
+ * frames that precede it are interpreted.
+ */
+static flux_msg_t *msg_from_frames (struct frame *frames, int count)
+{
+    flux_msg_t *msg;
+    int i = 0;
+    int last = count - 1;
+
+    if (count < 1) {
+        errno = EPROTO;
+        return NULL;
+    }
+    if (!(msg = flux_msg_create_common ()))
+        return NULL;
+    if (proto_decode (&msg->proto, frames[last].data, frames[last].size) < 0)
+        goto eproto;
+    if ((msg->proto.flags & FLUX_MSGFLAG_ROUTE)) {
+        int delim;
+        for (delim = 0; delim < last; delim++) {
+            if (frames[delim].size == 0)
+                break;
         }
-        memcpy (p, zframe_data (zf), n);
-        p += n;
-        zf = zmsg_next (msg->zmsg);
+        if (delim == last)
+            goto eproto;
+        for (i = delim - 1; i >= 0; i--) {
+            if (msg_append_route (msg, frames[i].data, frames[i].size) < 0)
+                goto nomem;
+        }
+        i = delim + 1;
+    }
+    if ((msg->proto.flags & FLUX_MSGFLAG_TOPIC)) {
+        const char *s = frames[i].data;
+        if (i >= last || frames[i].size == 0
+                      || s[frames[i].size - 1] != '\0')
+            goto eproto;
+        if (msg_set_topic_buf (msg, s, frames[i].size - 1) < 0)
+            goto nomem;
+        i++;
+    }
+    if ((msg->proto.flags & FLUX_MSGFLAG_PAYLOAD)) {
+        if (i >= last)
+            goto eproto;
+        if (!(msg->payload = payload_create (frames[i].data, frames[i].size)))
+            goto nomem;
+        i++;
     }
+    if (i != last)
+        goto eproto;
+    return msg;
+eproto:
+    errno = EPROTO;
+    flux_msg_destroy (msg);
+    return NULL;
+nomem:
+    errno = ENOMEM;
+    flux_msg_destroy (msg);
+    return NULL;
+}
+
+static int frames_append (struct frame **frames,
+                          int *count,
+                          int *alloc,
+                          const void *data,
+                          size_t size)
+{
+    if (*count == *alloc) {
+        int new_alloc = *alloc * 2;
+        struct frame *new_frames;
+        if (!(new_frames = realloc (*frames,
+                                    new_alloc * sizeof (**frames))))
+            return -1;
+        *frames = new_frames;
+        *alloc = new_alloc;
+    }
+    (*frames)[*count].data = data;
+    (*frames)[*count].size = size;
+    (*count)++;
     return 0;
-nospace:
-    errno = EINVAL;
-    return -1;
 }
 
 flux_msg_t *flux_msg_decode (const void *buf, size_t size)
 {
-    flux_msg_t *msg;
+    flux_msg_t *msg = NULL;
     uint8_t const *p = buf;
-    zframe_t *zf;
+    struct frame *frames;
+    int count = 0;
+    int alloc = 8;
 
-    if (!(msg = flux_msg_create_common ()))
+    if (!(frames = malloc (alloc * sizeof (*frames)))) {
+        errno = ENOMEM;
         return NULL;
-    if (!(msg->zmsg = zmsg_new ()))
-        goto nomem;
+    }
     while (p - (uint8_t *)buf < size) {
         size_t n = *p++;
         if (n == 0xff) {
+            uint32_t x;
             if (size - (p - (uint8_t *)buf) < 4) {
                 errno = EINVAL;
-                goto error;
+                goto done;
             }
-            n = ntohl (*(uint32_t *)p);
+            memcpy (&x, p, sizeof (x));
+            n = ntohl (x);
             p += 4;
         }
         if (size - (p - (uint8_t *)buf) < n) {
             errno = EINVAL;
-            goto error;
+            goto done;
+        }
+        if (frames_append (&frames, &count, &alloc, p, n) < 0) {
+            errno = ENOMEM;
+            goto done;
         }
-        if (!(zf = zframe_new (p, n)))
-            goto nomem;
-        if (zmsg_append (msg->zmsg, &zf) < 0)
-            goto nomem;
         p += n;
     }
+    msg = msg_from_frames (frames, count);
+done:
+    ERRNO_SAFE_WRAP (free, frames);
     return msg;
-nomem:
-    errno = ENOMEM;
-error:
-    flux_msg_destroy (msg);
-    return NULL;
 }
 
 int flux_msg_set_type (flux_msg_t *msg, int type)
 {
-    zframe_t *zf = zmsg_last (msg->zmsg);
-    if (!zf || proto_set_type (zframe_data (zf), zframe_size (zf), type) < 0) {
+    if (!msg || proto_set_type (&msg->proto, type) < 0) {
         errno = EINVAL;
         return -1;
     }
@@ -373,11 +811,11 @@ int flux_msg_set_type (flux_msg_t *msg, int type)
 
 int flux_msg_get_type (const flux_msg_t *msg, int *type)
 {
-    zframe_t *zf = zmsg_last (msg->zmsg);
-    if (!zf || proto_get_type (zframe_data (zf), zframe_size (zf), type) < 0) {
-        errno = EPROTO;
+    if (!msg || !type) {
+        errno = EINVAL;
         return -1;
     }
+    *type = msg->proto.type;
     return 0;
 }
 
@@ -393,11 +831,18 @@ int flux_msg_set_flags (flux_msg_t *msg, uint8_t fl)
         errno = EINVAL;
         return -1;
     }
-    zframe_t *zf = zmsg_last (msg->zmsg);
-    if (!zf || proto_set_flags (zframe_data (zf), zframe_size (zf), fl) < 0) {
+    /* Topic and payload flags may be cleared but not set directly.
+     */
+    if (((fl & FLUX_MSGFLAG_TOPIC)
+                && !(msg->proto.flags & FLUX_MSGFLAG_TOPIC))
+        || ((fl & FLUX_MSGFLAG_PAYLOAD)
+                && !(msg->proto.flags & FLUX_MSGFLAG_PAYLOAD))) {
         errno = EINVAL;
         return -1;
     }
+    if (!(fl & FLUX_MSGFLAG_ROUTE))
+        msg_routes_free (msg);
+    msg->proto.flags = fl;
     return 0;
 }
 
@@ -407,11 +852,7 @@ int flux_msg_get_flags (const flux_msg_t *msg, uint8_t *fl)
         errno = EINVAL;
         return -1;
     }
-    zframe_t *zf = zmsg_last (msg->zmsg);
-    if (!zf || proto_get_flags (zframe_data (zf), zframe_size (zf), fl) < 0) {
-        errno = EPROTO;
-        return -1;
-    }
+    *fl = msg->proto.flags;
     return 0;
 }
 
@@ -473,77 +914,41 @@ bool flux_msg_is_noresponse (const flux_msg_t *msg)
 
 int flux_msg_set_userid (flux_msg_t *msg, uint32_t userid)
 {
-    zframe_t *zf;
-
     if (!msg) {
         errno = EINVAL;
         return -1;
     }
-    zf = zmsg_last (msg->zmsg);
-    if (!zf || proto_set_u32 (zframe_data (zf),
-                              zframe_size (zf),
-                              PROTO_IND_USERID,
-                              userid) < 0) {
-        errno = EINVAL;
-        return -1;
-    }
+    msg->proto.userid = userid;
     return 0;
 }
 
 int flux_msg_get_userid (const flux_msg_t *msg, uint32_t *userid)
 {
-    zframe_t *zf;
-
     if (!msg || !userid) {
         errno = EINVAL;
         return -1;
     }
-    zf = zmsg_last (msg->zmsg);
-    if (!zf || proto_get_u32 (zframe_data (zf),
-                              zframe_size (zf),
-                              PROTO_IND_USERID,
-                              userid) < 0) {
-        errno = EPROTO;
-        return -1;
-    }
+    *userid = msg->proto.userid;
     return 0;
 }
 
 int flux_msg_set_rolemask (flux_msg_t *msg, uint32_t rolemask)
 {
-    zframe_t *zf;
-
     if (!msg) {
         errno = EINVAL;
         return -1;
     }
-    zf = zmsg_last (msg->zmsg);
-    if (!zf || proto_set_u32 (zframe_data (zf),
-                              zframe_size (zf),
-                              PROTO_IND_ROLEMASK,
-                              rolemask) < 0) {
-        errno = EINVAL;
-        return -1;
-    }
+    msg->proto.rolemask = rolemask;
     return 0;
 }
 
 int flux_msg_get_rolemask (const flux_msg_t *msg, uint32_t *rolemask)
 {
-    zframe_t *zf;
-
     if (!msg || !rolemask) {
         errno = EINVAL;
         return -1;
     }
-    zf = zmsg_last (msg->zmsg);
-    if (!zf || proto_get_u32 (zframe_data (zf),
-                              zframe_size (zf),
-                              PROTO_IND_ROLEMASK,
-                              rolemask) < 0) {
-        errno = EPROTO;
-        return -1;
-    }
+    *rolemask = msg->proto.rolemask;
     return 0;
 }
 
@@ -597,22 +1002,13 @@ int flux_msg_authorize (const flux_msg_t *msg, uint32_t userid)
 
 int flux_msg_set_nodeid (flux_msg_t *msg, uint32_t nodeid)
 {
-    zframe_t *zf;
-    int type;
-
     if (!msg)
         goto error;
     if (nodeid == FLUX_NODEID_UPSTREAM) /* should have been resolved earlier */
         goto error;
-    if (!(zf = zmsg_last (msg->zmsg)))
-        goto error;
-    if (proto_get_type (zframe_data (zf), zframe_size (zf), &type) < 0)
-        goto error;
-    if (type != FLUX_MSGTYPE_REQUEST)
-        goto error;
-    if (proto_set_u32 (zframe_data (zf), zframe_size (zf),
-                       PROTO_IND_NODEID, nodeid) < 0)
+    if (msg->proto.type != FLUX_MSGTYPE_REQUEST)
         goto error;
+    msg->proto.aux1 = nodeid;
     return 0;
 error:
     errno = EINVAL;
@@ -621,151 +1017,165 @@ error:
 
 int flux_msg_get_nodeid (const flux_msg_t *msg, uint32_t *nodeidp)
 {
-    zframe_t *zf;
-    int type;
-    uint32_t nodeid;
-
     if (!msg || !nodeidp) {
         errno = EINVAL;
         return -1;
     }
-    if (!(zf = zmsg_last (msg->zmsg)))
-        goto error;
-    if (proto_get_type (zframe_data (zf), zframe_size (zf), &type) < 0)
-        goto error;
-    if (type != FLUX_MSGTYPE_REQUEST)
-        goto error;
-    if (proto_get_u32 (zframe_data (zf), zframe_size (zf),
-                       PROTO_IND_NODEID, &nodeid) < 0)
-        goto error;
-    *nodeidp = nodeid;
+    if (msg->proto.type != FLUX_MSGTYPE_REQUEST) {
+        errno = EPROTO;
+        return -1;
+    }
+    *nodeidp = msg->proto.aux1;
     return 0;
-error:
-    return EPROTO;
-    return -1;
 }
 
 int flux_msg_set_errnum (flux_msg_t *msg, int e)
 {
-    zframe_t *zf = zmsg_last (msg->zmsg);
-    int type;
-
-    if (!zf || proto_get_type (zframe_data (zf), zframe_size (zf), &type) < 0
-            || (type != FLUX_MSGTYPE_RESPONSE && type != FLUX_MSGTYPE_KEEPALIVE)
-            || proto_set_u32 (zframe_data (zf), zframe_size (zf),
-                              PROTO_IND_ERRNUM, e) < 0) {
+    if (!msg || (msg->proto.type != FLUX_MSGTYPE_RESPONSE
+              && msg->proto.type != FLUX_MSGTYPE_KEEPALIVE)) {
         errno = EINVAL;
         return -1;
     }
+    msg->proto.aux1 = e;
     return 0;
 }
 
 int flux_msg_get_errnum (const flux_msg_t *msg, int *e)
 {
-    zframe_t *zf = zmsg_last (msg->zmsg);
-    int type;
-    uint32_t xe;
-
-    if (!zf || proto_get_type (zframe_data (zf), zframe_size (zf), &type) < 0
-            || (type != FLUX_MSGTYPE_RESPONSE && type != FLUX_MSGTYPE_KEEPALIVE)
-            || proto_get_u32 (zframe_data (zf), zframe_size (zf),
-                              PROTO_IND_ERRNUM, &xe) < 0) {
+    if (!msg || (msg->proto.type != FLUX_MSGTYPE_RESPONSE
+              && msg->proto.type != FLUX_MSGTYPE_KEEPALIVE)) {
         errno = EPROTO;
         return -1;
     }
-    *e = xe;
+    *e = msg->proto.aux1;
     return 0;
 }
 
 int flux_msg_set_seq (flux_msg_t *msg, uint32_t seq)
 {
-    zframe_t *zf = zmsg_last (msg->zmsg);
-    int type;
-
-    if (!zf || proto_get_type (zframe_data (zf), zframe_size (zf), &type) < 0
-            || type != FLUX_MSGTYPE_EVENT
-            || proto_set_u32 (zframe_data (zf), zframe_size (zf),
-                              PROTO_IND_SEQUENCE, seq) < 0) {
+    if (!msg || msg->proto.type != FLUX_MSGTYPE_EVENT) {
         errno = EINVAL;
         return -1;
     }
+    msg->proto.aux1 = seq;
     return 0;
 }
 
 int flux_msg_get_seq (const flux_msg_t *msg, uint32_t *seq)
 {
-    zframe_t *zf = zmsg_last (msg->zmsg);
-    int type;
-
-    if (!zf || proto_get_type (zframe_data (zf), zframe_size (zf), &type) < 0
-            || type != FLUX_MSGTYPE_EVENT
-            || proto_get_u32 (zframe_data (zf), zframe_size (zf),
-                              PROTO_IND_SEQUENCE, seq) < 0) {
+    if (!msg || msg->proto.type != FLUX_MSGTYPE_EVENT) {
         errno = EPROTO;
         return -1;
     }
+    *seq = msg->proto.aux1;
     return 0;
 }
 
 int flux_msg_set_matchtag (flux_msg_t *msg, uint32_t t)
 {
-    zframe_t *zf = zmsg_last (msg->zmsg);
-    int type;
-
-    if (!zf || proto_get_type (zframe_data (zf), zframe_size (zf), &type) < 0
-            || (type != FLUX_MSGTYPE_REQUEST && type != FLUX_MSGTYPE_RESPONSE)
-            || proto_set_u32 (zframe_data (zf), zframe_size (zf),
-                              PROTO_IND_MATCHTAG, t) < 0) {
+    if (!msg || (msg->proto.type != FLUX_MSGTYPE_REQUEST
+              && msg->proto.type != FLUX_MSGTYPE_RESPONSE)) {
         errno = EINVAL;
         return -1;
     }
+    msg->proto.aux2 = t;
     return 0;
 }
 
 int flux_msg_get_matchtag (const flux_msg_t *msg, uint32_t *t)
 {
-    zframe_t *zf = zmsg_last (msg->zmsg);
-    int type;
+    if (!msg || (msg->proto.type != FLUX_MSGTYPE_REQUEST
+              && msg->proto.type != FLUX_MSGTYPE_RESPONSE)) {
+        errno = EPROTO;
+        return -1;
+    }
+    *t = msg->proto.aux2;
+    return 0;
+}
 
-    if (!zf || proto_get_type (zframe_data (zf), zframe_size (zf), &type) < 0
-            || (type != FLUX_MSGTYPE_REQUEST && type != FLUX_MSGTYPE_RESPONSE)
-            || proto_get_u32 (zframe_data (zf), zframe_size (zf),
-                              PROTO_IND_MATCHTAG, t) < 0) {
+int flux_msg_set_deadline (flux_msg_t *msg, double timeout)
+{
+    if (!msg || msg->proto.type != FLUX_MSGTYPE_REQUEST) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (timeout < 0)
+        msg->proto.deadline = 0;
+    else
+        msg->proto.deadline = monotonic_now () + timeout;
+    return 0;
+}
+
+int flux_msg_get_deadline (const flux_msg_t *msg, double *timeout)
+{
+    if (!msg || msg->proto.type != FLUX_MSGTYPE_REQUEST) {
         errno = EPROTO;
         return -1;
     }
+    if (msg->proto.deadline == 0) {
+        errno = ENOENT;
+        return -1;
+    }
+    if (timeout)
+        *timeout = msg->proto.deadline - monotonic_now ();
     return 0;
 }
 
-int flux_msg_set_status (flux_msg_t *msg, int s)
+bool flux_msg_is_expired (const flux_msg_t *msg)
 {
-    zframe_t *zf = zmsg_last (msg->zmsg);
-    int type;
+    return (msg
+            && msg->proto.type == FLUX_MSGTYPE_REQUEST
+            && msg->proto.deadline > 0
+            && monotonic_now () >= msg->proto.deadline);
+}
 
-    if (!zf || proto_get_type (zframe_data (zf), zframe_size (zf), &type) < 0
-            || type != FLUX_MSGTYPE_KEEPALIVE
-            || proto_set_u32 (zframe_data (zf), zframe_size (zf),
-                              PROTO_IND_STATUS, s) < 0) {
+int flux_msg_set_trace (flux_msg_t *msg, uint64_t trace, uint64_t span)
+{
+    if (!msg) {
         errno = EINVAL;
         return -1;
     }
+    msg->proto.trace = trace;
+    msg->proto.span = trace ? span : 0;
     return 0;
 }
 
-int flux_msg_get_status (const flux_msg_t *msg, int *s)
+int flux_msg_get_trace (const flux_msg_t *msg,
+                        uint64_t *trace,
+                        uint64_t *span)
 {
-    zframe_t *zf = zmsg_last (msg->zmsg);
-    int type;
-    uint32_t u;
+    if (!msg) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (msg->proto.trace == 0) {
+        errno = ENOENT;
+        return -1;
+    }
+    if (trace)
+        *trace = msg->proto.trace;
+    if (span)
+        *span = msg->proto.span;
+    return 0;
+}
+
+int flux_msg_set_status (flux_msg_t *msg, int s)
+{
+    if (!msg || msg->proto.type != FLUX_MSGTYPE_KEEPALIVE) {
+        errno = EINVAL;
+        return -1;
+    }
+    msg->proto.aux2 = s;
+    return 0;
+}
 
-    if (!zf || proto_get_type (zframe_data (zf), zframe_size (zf), &type) < 0
-            || type != FLUX_MSGTYPE_KEEPALIVE
-            || proto_get_u32 (zframe_data (zf), zframe_size (zf),
-                              PROTO_IND_STATUS, &u) < 0) {
+int flux_msg_get_status (const flux_msg_t *msg, int *s)
+{
+    if (!msg || msg->proto.type != FLUX_MSGTYPE_KEEPALIVE) {
         errno = EPROTO;
         return -1;
     }
-    *s = u;
+    *s = msg->proto.aux2;
     return 0;
 }
 
@@ -828,51 +1238,36 @@ bool flux_msg_cmp (const flux_msg_t *msg, struct flux_match match)
 
 int flux_msg_enable_route (flux_msg_t *msg)
 {
-    uint8_t flags;
-
-    if (flux_msg_get_flags (msg, &flags) < 0)
-        return -1;
-    if ((flags & FLUX_MSGFLAG_ROUTE))
-        return 0;
-    if (zmsg_pushmem (msg->zmsg, NULL, 0) < 0) {
-        errno = ENOMEM;
+    if (!msg) {
+        errno = EINVAL;
         return -1;
     }
-    flags |= FLUX_MSGFLAG_ROUTE;
-    return flux_msg_set_flags (msg, flags);
+    msg->proto.flags |= FLUX_MSGFLAG_ROUTE;
+    return 0;
 }
 
 int flux_msg_clear_route (flux_msg_t *msg)
 {
-    uint8_t flags;
-    zframe_t *zf;
-    int size;
-
-    if (flux_msg_get_flags (msg, &flags) < 0)
+    if (!msg) {
+        errno = EINVAL;
         return -1;
-    if (!(flags & FLUX_MSGFLAG_ROUTE))
-        return 0;
-    while ((zf = zmsg_pop (msg->zmsg))) {
-        size = zframe_size (zf);
-        zframe_destroy (&zf);
-        if (size == 0)
-            break;
     }
-    flags &= ~(uint8_t)FLUX_MSGFLAG_ROUTE;
-    return flux_msg_set_flags (msg, flags);
+    msg_routes_free (msg);
+    msg->proto.flags &= ~(uint8_t)FLUX_MSGFLAG_ROUTE;
+    return 0;
 }
 
 int flux_msg_push_route (flux_msg_t *msg, const char *id)
 {
-    uint8_t flags;
-
-    if (flux_msg_get_flags (msg, &flags) < 0)
+    if (!msg || !id) {
+        errno = EINVAL;
         return -1;
-    if (!(flags & FLUX_MSGFLAG_ROUTE)) {
+    }
+    if (!(msg->proto.flags & FLUX_MSGFLAG_ROUTE)) {
         errno = EPROTO;
         return -1;
     }
-    if (zmsg_pushstr (msg->zmsg, id) < 0) {
+    if (msg_append_route (msg, id, strlen (id)) < 0) {
         errno = ENOMEM;
         return -1;
     }
@@ -881,26 +1276,20 @@ int flux_msg_push_route (flux_msg_t *msg, const char *id)
 
 int flux_msg_pop_route (flux_msg_t *msg, char **id)
 {
-    uint8_t flags;
-    zframe_t *zf;
-
-    if (flux_msg_get_flags (msg, &flags) < 0)
+    if (!msg) {
+        errno = EINVAL;
         return -1;
-    if (!(flags & FLUX_MSGFLAG_ROUTE) || !(zf = zmsg_first (msg->zmsg))) {
+    }
+    if (!(msg->proto.flags & FLUX_MSGFLAG_ROUTE)) {
         errno = EPROTO;
         return -1;
     }
-    if (zframe_size (zf) > 0 && (zf = zmsg_pop (msg->zmsg))) {
-        if (id) {
-            char *s = zframe_strdup (zf);
-            if (!s) {
-                zframe_destroy (&zf);
-                errno = ENOMEM;
-                return -1;
-            }
+    if (msg->route_count > 0) {
+        char *s = msg->routes[--msg->route_count];
+        if (id)
             *id = s;
-        }
-        zframe_destroy (&zf);
+        else
+            free (s);
     } else {
         if (id)
             *id = NULL;
@@ -908,20 +1297,18 @@ int flux_msg_pop_route (flux_msg_t *msg, char **id)
     return 0;
 }
 
-/* replaces flux_msg_nexthop */
-int flux_msg_get_route_last (const flux_msg_t *msg, char **id)
+/* Get route at position 'n' from the top of the stack (last = 0).
+ */
+static const char *msg_route_nth (const flux_msg_t *msg, int n)
+{
+    return msg->routes[msg->route_count - 1 - n];
+}
+
+static int msg_route_dup (const char *route, char **id)
 {
-    uint8_t flags;
-    zframe_t *zf;
     char *s = NULL;
 
-    if (flux_msg_get_flags (msg, &flags) < 0)
-        return -1;
-    if (!(flags & FLUX_MSGFLAG_ROUTE) || !(zf = zmsg_first (msg->zmsg))) {
-        errno = EPROTO;
-        return -1;
-    }
-    if (zframe_size (zf) > 0 && !(s = zframe_strdup (zf))) {
+    if (route && !(s = strdup (route))) {
         errno = ENOMEM;
         return -1;
     }
@@ -929,108 +1316,68 @@ int flux_msg_get_route_last (const flux_msg_t *msg, char **id)
     return 0;
 }
 
-/* replaces flux_msg_sender */
-int flux_msg_get_route_first (const flux_msg_t *msg, char **id)
+/* replaces flux_msg_nexthop */
+int flux_msg_get_route_last (const flux_msg_t *msg, char **id)
 {
-    uint8_t flags;
-    zframe_t *zf, *zf_next;
-    char *s = NULL;
-
-    if (flux_msg_get_flags (msg, &flags) < 0)
+    if (!msg || !id) {
+        errno = EINVAL;
         return -1;
-    if (!(flags & FLUX_MSGFLAG_ROUTE)) {
+    }
+    if (!(msg->proto.flags & FLUX_MSGFLAG_ROUTE)) {
         errno = EPROTO;
         return -1;
     }
-    zf = zmsg_first (msg->zmsg);
-    while (zf && zframe_size (zf) > 0) {
-        zf_next = zmsg_next (msg->zmsg);
-        if (zf_next && zframe_size (zf_next) == 0)
-            break;
-        zf = zf_next;
-    }
-    if (!zf) {
-        errno = EPROTO;
+    return msg_route_dup (msg->route_count > 0 ? msg_route_nth (msg, 0)
+                                               : NULL, id);
+}
+
+/* replaces flux_msg_sender */
+int flux_msg_get_route_first (const flux_msg_t *msg, char **id)
+{
+    if (!msg || !id) {
+        errno = EINVAL;
         return -1;
     }
-    if (zframe_size (zf) > 0 && !(s = zframe_strdup (zf))) {
-        errno = ENOMEM;
+    if (!(msg->proto.flags & FLUX_MSGFLAG_ROUTE)) {
+        errno = EPROTO;
         return -1;
     }
-    *id = s;
-    return 0;
+    return msg_route_dup (msg->route_count > 0 ? msg->routes[0] : NULL, id);
 }
 
 int flux_msg_get_route_count (const flux_msg_t *msg)
 {
-    uint8_t flags;
-    zframe_t *zf;
-    int count = 0;
-
-    if (flux_msg_get_flags (msg, &flags) < 0)
+    if (!msg) {
+        errno = EINVAL;
         return -1;
-    if (!(flags & FLUX_MSGFLAG_ROUTE)) {
+    }
+    if (!(msg->proto.flags & FLUX_MSGFLAG_ROUTE)) {
         errno = EPROTO;
         return -1;
     }
-    zf = zmsg_first (msg->zmsg);
-    while (zf && zframe_size (zf) > 0) {
-        zf = zmsg_next (msg->zmsg);
-        count++;
-    }
-    return count;
+    return msg->route_count;
 }
 
 /* Get sum of size in bytes of route frames
  */
 static int flux_msg_get_route_size (const flux_msg_t *msg)
 {
-    uint8_t flags;
-    zframe_t *zf;
     int size = 0;
+    int i;
 
-    if (flux_msg_get_flags (msg, &flags) < 0)
-        return -1;
-    if (!(flags & FLUX_MSGFLAG_ROUTE)) {
+    if (!(msg->proto.flags & FLUX_MSGFLAG_ROUTE)) {
         errno = EPROTO;
         return -1;
     }
-    zf = zmsg_first (msg->zmsg);
-    while (zf && zframe_size (zf) > 0) {
-        size += zframe_size (zf);
-        zf = zmsg_next (msg->zmsg);
-    }
+    for (i = 0; i < msg->route_count; i++)
+        size += strlen (msg->routes[i]);
     return size;
 }
 
-static zframe_t *flux_msg_get_route_nth (const flux_msg_t *msg, int n)
-{
-    uint8_t flags;
-    zframe_t *zf;
-    int count = 0;
-
-    if (flux_msg_get_flags (msg, &flags) < 0)
-        return NULL;
-    if (!(flags & FLUX_MSGFLAG_ROUTE)) {
-        errno = EPROTO;
-        return NULL;
-    }
-    zf = zmsg_first (msg->zmsg);
-    while (zf && zframe_size (zf) > 0) {
-        if (count == n)
-            return zf;
-        zf = zmsg_next (msg->zmsg);
-        count++;
-    }
-    errno = ENOENT;
-    return NULL;
-}
-
 char *flux_msg_get_route_string (const flux_msg_t *msg)
 {
     int hops, len;
     int n;
-    zframe_t *zf;
     char *buf, *cp;
 
     if (msg == NULL) {
@@ -1044,94 +1391,63 @@ char *flux_msg_get_route_string (const flux_msg_t *msg)
     if (!(cp = buf = malloc (len + hops + 1)))
         return NULL;
     for (n = hops - 1; n >= 0; n--) {
+        const char *route = msg_route_nth (msg, n);
         if (cp > buf)
             *cp++ = '!';
-        if (!(zf = flux_msg_get_route_nth (msg, n))) {
-            ERRNO_SAFE_WRAP (free, buf);
-            return NULL;
-        }
-        int cpylen = zframe_size (zf);
+        int cpylen = strlen (route);
         if (cpylen == 36) /* abbreviate long UUID */
             cpylen = 8;
         assert (cp - buf + cpylen < len + hops);
-        memcpy (cp, zframe_data (zf), cpylen);
+        memcpy (cp, route, cpylen);
         cp += cpylen;
     }
     *cp = '\0';
     return buf;
 }
 
-static bool payload_overlap (const void *b, zframe_t *zf)
+static bool payload_overlap (const void *b, struct payload *p)
 {
-    return ((char *)b >= (char *)zframe_data (zf)
-         && (char *)b <  (char *)zframe_data (zf) + zframe_size (zf));
+    return ((char *)b >= p->data && (char *)b < p->data + p->size);
 }
 
 int flux_msg_set_payload (flux_msg_t *msg, const void *buf, int size)
 {
-    zframe_t *zf;
-    uint8_t flags;
-    int rc = -1;
+    struct payload *p;
 
     if (!msg) {
         errno = EINVAL;
-        goto done;
-    }
-    json_decref (msg->json);            /* invalidate cached json object */
-    msg->json = NULL;
-    if (flux_msg_get_flags (msg, &flags) < 0)
-        goto done;
-    if (!(flags & FLUX_MSGFLAG_PAYLOAD) && (buf == NULL || size == 0)) {
-        rc = 0;
-        goto done;
-    }
-    zf = zmsg_first (msg->zmsg);
-    if ((flags & FLUX_MSGFLAG_ROUTE)) {
-        while (zf && zframe_size (zf) > 0)
-            zf = zmsg_next (msg->zmsg);      /* skip route frame */
-        if (zf)
-            zf = zmsg_next (msg->zmsg);      /* skip route delim */
-    }
-    if ((flags & FLUX_MSGFLAG_TOPIC)) {
-        if (zf)
-            zf = zmsg_next (msg->zmsg);      /* skip topic frame */
-    }
-    if (!zf) {                          /* must at least have proto frame */
-        errno = EPROTO;
-        goto done;
+        return -1;
     }
-    /* Case #1: replace existing payload.
-     */
-    if ((flags & FLUX_MSGFLAG_PAYLOAD) && (buf != NULL && size > 0)) {
-        if (zframe_data (zf) != buf || zframe_size (zf) != size) {
-            if (payload_overlap (buf, zf)) {
-                errno = EINVAL;
-                goto done;
-            }
-            zframe_reset (zf, buf, size);
-        }
-    /* Case #2: add payload.
+    /* Case #1: remove payload (if any).
      */
-    } else if (!(flags & FLUX_MSGFLAG_PAYLOAD) && (buf != NULL && size > 0)) {
-        zmsg_remove (msg->zmsg, zf);
-        if (zmsg_addmem (msg->zmsg, buf, size) < 0
-                                        || zmsg_append (msg->zmsg, &zf) < 0) {
-            errno = ENOMEM;
-            goto done;
+    if (buf == NULL || size == 0) {
+        payload_decref (msg->payload);
+        msg->payload = NULL;
+        msg->proto.flags &= ~(uint8_t)(FLUX_MSGFLAG_PAYLOAD);
+        return 0;
+    }
+    if (msg->payload) {
+        /* Case #2: payload echo - no change.
+         */
+        if (msg->payload->data == buf && msg->payload->size == size)
+            return 0;
+        if (payload_overlap (buf, msg->payload)) {
+            errno = EINVAL;
+            return -1;
         }
-        flags |= FLUX_MSGFLAG_PAYLOAD;
-    /* Case #3: remove payload.
+    }
+    /* Case #3: add or replace payload.
+     * The old payload may be shared with copies of this message,
+     * so it is never modified in place.
      */
-    } else if ((flags & FLUX_MSGFLAG_PAYLOAD) && (buf == NULL || size == 0)) {
-        zmsg_remove (msg->zmsg, zf);
-        zframe_destroy (&zf);
-        flags &= ~(uint8_t)(FLUX_MSGFLAG_PAYLOAD);
+    if (!(p = payload_create (buf, size))) {
+        errno = ENOMEM;
+        return -1;
     }
-    if (flux_msg_set_flags (msg, flags) < 0)
-        goto done;
-    rc = 0;
-done:
-    return rc;
+    payload_decref (msg->payload);
+    msg->payload = p;
+    msg->proto.flags |= FLUX_MSGFLAG_PAYLOAD;
+    return 0;
 }
 
 static inline void msg_lasterr_reset (flux_msg_t *msg)
@@ -1208,34 +1524,18 @@ int flux_msg_pack (flux_msg_t *msg, const char *fmt, ...)
 
 int flux_msg_get_payload (const flux_msg_t *msg, const void **buf, int *size)
 {
-    zframe_t *zf;
-    uint8_t flags;
-
-    if (flux_msg_get_flags (msg, &flags) < 0)
-        return -1;
-    if (!(flags & FLUX_MSGFLAG_PAYLOAD)) {
-        errno = EPROTO;
+    if (!msg) {
+        errno = EINVAL;
         return -1;
     }
-    zf = zmsg_first (msg->zmsg);
-    if ((flags & FLUX_MSGFLAG_ROUTE)) {
-        while (zf && zframe_size (zf) > 0)
-            zf = zmsg_next (msg->zmsg);
-        if (zf)
-            zf = zmsg_next (msg->zmsg);
-    }
-    if ((flags & FLUX_MSGFLAG_TOPIC)) {
-        if (zf)
-            zf = zmsg_next (msg->zmsg);
-    }
-    if (!zf) {
+    if (!(msg->proto.flags & FLUX_MSGFLAG_PAYLOAD)) {
         errno = EPROTO;
         return -1;
     }
     if (buf)
-        *buf = zframe_data (zf);
+        *buf = msg->payload->data;
     if (size)
-        *size = zframe_size (zf);
+        *size = msg->payload->size;
     return 0;
 }
 
@@ -1283,6 +1583,41 @@ done:
     return rc;
 }
 
+/* Decode the payload as a JSON object, caching the result in the
+ * (shared) payload.
+ */
+static json_t *msg_payload_json (flux_msg_t *msg)
+{
+    const char *json_str;
+    json_error_t err;
+    json_t *json;
+
+    if (msg->payload && msg->payload->json)
+        return msg->payload->json;
+    if (flux_msg_get_string (msg, &json_str) < 0) {
+        msg_lasterr_set (msg, "flux_msg_get_string: %s", strerror (errno));
+        return NULL;
+    }
+    if (!json_str) {
+        msg_lasterr_set (msg, "message does not have a string payload");
+        errno = EPROTO;
+        return NULL;
+    }
+    if (!(json = json_loads (json_str, JSON_ALLOW_NUL, &err))) {
+        msg_lasterr_set (msg, "%s", err.text);
+        errno = EPROTO;
+        return NULL;
+    }
+    if (!json_is_object (json)) {
+        msg_lasterr_set (msg, "payload is not a JSON object");
+        json_decref (json);
+        errno = EPROTO;
+        return NULL;
+    }
+    msg->payload->json = json;
+    return json;
+}
+
 /* N.B. const attribute of msg argument is defeated internally to
  * allow msg to be "annotated" with parsed json object for convenience.
  * The message content is otherwise unchanged.
@@ -1290,7 +1625,7 @@ done:
 int flux_msg_vunpack (const flux_msg_t *cmsg, const char *fmt, va_list ap)
 {
     int rc = -1;
-    const char *json_str;
+    json_t *json;
     json_error_t err;
     flux_msg_t *msg = (flux_msg_t *)cmsg;
 
@@ -1300,28 +1635,9 @@ int flux_msg_vunpack (const flux_msg_t *cmsg, const char *fmt, va_list ap)
         errno = EINVAL;
         goto done;
     }
-    if (!msg->json) {
-        if (flux_msg_get_string (msg, &json_str) < 0) {
-            msg_lasterr_set (msg, "flux_msg_get_string: %s", strerror (errno));
-            goto done;
-        }
-        if (!json_str) {
-            msg_lasterr_set (msg, "message does not have a string payload");
-            errno = EPROTO;
-            goto done;
-        }
-        if (!(msg->json = json_loads (json_str, JSON_ALLOW_NUL, &err))) {
-            msg_lasterr_set (msg, "%s", err.text);
-            errno = EPROTO;
-            goto done;
-        }
-        if (!json_is_object (msg->json)) {
-            msg_lasterr_set (msg, "payload is not a JSON object");
-            errno = EPROTO;
-            goto done;
-        }
-    }
-    if (json_vunpack_ex (msg->json, &err, 0, fmt, ap) < 0) {
+    if (!(json = msg_payload_json (msg)))
+        goto done;
+    if (json_vunpack_ex (json, &err, 0, fmt, ap) < 0) {
         msg_lasterr_set (msg, "%s", err.text);
         errno = EPROTO;
         goto done;
@@ -1353,141 +1669,78 @@ const char *flux_msg_last_error (const flux_msg_t *msg)
 
 int flux_msg_set_topic (flux_msg_t *msg, const char *topic)
 {
-    zframe_t *zf, *zf2 = NULL;
-    uint8_t flags;
-    int rc = -1;
-
-    if (flux_msg_get_flags (msg, &flags) < 0)
-        goto done;
-    zf = zmsg_first (msg->zmsg);
-    if ((flags & FLUX_MSGFLAG_ROUTE)) {   /* skip over routing frames, if any */
-        while (zf && zframe_size (zf) > 0)
-            zf = zmsg_next (msg->zmsg);
-        if (zf)
-            zf = zmsg_next (msg->zmsg);
-    }
-    if (!zf) {                          /* must at least have proto frame */
-        errno = EPROTO;
-        goto done;
+    if (!msg) {
+        errno = EINVAL;
+        return -1;
     }
-    if ((flags & FLUX_MSGFLAG_TOPIC) && topic) {        /* case 1: repl topic */
-        zframe_reset (zf, topic, strlen (topic) + 1);
-    } else if (!(flags & FLUX_MSGFLAG_TOPIC) && topic) {/* case 2: add topic */
-        zmsg_remove (msg->zmsg, zf);
-        if ((flags & FLUX_MSGFLAG_PAYLOAD) && (zf2 = zmsg_next (msg->zmsg)))
-            zmsg_remove (msg->zmsg, zf2);
-        if (zmsg_addmem (msg->zmsg, topic, strlen (topic) + 1) < 0
-                                    || zmsg_append (msg->zmsg, &zf) < 0
-                                    || (zf2 && zmsg_append (msg->zmsg, &zf2) < 0)) {
+    if (topic) {                        /* case 1: add or replace topic */
+        if (msg_set_topic_buf (msg, topic, strlen (topic)) < 0) {
             errno = ENOMEM;
-            goto done;
+            return -1;
         }
-        flags |= FLUX_MSGFLAG_TOPIC;
-        if (flux_msg_set_flags (msg, flags) < 0)
-            goto done;
-    } else if ((flags & FLUX_MSGFLAG_TOPIC) && !topic) { /* case 3: del topic */
-        zmsg_remove (msg->zmsg, zf);
-        zframe_destroy (&zf);
-        flags &= ~(uint8_t)FLUX_MSGFLAG_TOPIC;
-        if (flux_msg_set_flags (msg, flags) < 0)
-            goto done;
+        msg->proto.flags |= FLUX_MSGFLAG_TOPIC;
+    } else {                            /* case 2: delete topic */
+        msg->proto.flags &= ~(uint8_t)FLUX_MSGFLAG_TOPIC;
     }
-    rc = 0;
-done:
-    return rc;
+    return 0;
 }
 
-static int zf_topic (const flux_msg_t *msg, zframe_t **zfp)
+int flux_msg_get_topic (const flux_msg_t *msg, const char **topic)
 {
-    uint8_t flags;
-    zframe_t *zf = NULL;
-    int rc = -1;
-
-    if (flux_msg_get_flags (msg, &flags) < 0)
-        goto done;
-    if (!(flags & FLUX_MSGFLAG_TOPIC)) {
-        errno = EPROTO;
-        goto done;
-    }
-    zf = zmsg_first (msg->zmsg);
-    if ((flags & FLUX_MSGFLAG_ROUTE)) {
-        while (zf && zframe_size (zf) > 0)
-            zf = zmsg_next (msg->zmsg);
-        if (zf)
-            zf = zmsg_next (msg->zmsg);
+    if (!msg || !topic) {
+        errno = EINVAL;
+        return -1;
     }
-    if (!zf) {
+    if (!(msg->proto.flags & FLUX_MSGFLAG_TOPIC)) {
         errno = EPROTO;
-        goto done;
+        return -1;
     }
-    *zfp = zf;
-    rc = 0;
-done:
-    return rc;
+    *topic = msg->topic;
+    return 0;
 }
 
-int flux_msg_get_topic (const flux_msg_t *msg, const char **topic)
+const struct flux_topic *flux_msg_get_topic_interned (const flux_msg_t *msg)
 {
-    zframe_t *zf;
-    const char *s;
-    int rc = -1;
-
-    if (zf_topic (msg, &zf) < 0)
-        goto done;
-    s = (const char *)zframe_data (zf);
-    if (s[zframe_size (zf) - 1] != '\0') {
-        errno = EPROTO;
-        goto done;
-    }
-    *topic = s;
-    rc = 0;
-done:
-    return rc;
+    if (!msg || !(msg->proto.flags & FLUX_MSGFLAG_TOPIC))
+        return NULL;
+    return msg->topic_intern;
 }
 
 flux_msg_t *flux_msg_copy (const flux_msg_t *msg, bool payload)
 {
     flux_msg_t *cpy = NULL;
-    zframe_t *zf;
-    int count;
-    uint8_t flags;
-    bool skip_payload = false;
+    int i;
 
-    /* Set skip_payload = true if caller set 'payload' flag false
-     * AND message contains a payload frame.
-     */
-    if (flux_msg_get_flags (msg, &flags) < 0)
+    if (!msg) {
+        errno = EINVAL;
         return NULL;
-    if (!payload && (flags & FLUX_MSGFLAG_PAYLOAD)) {
-        flags &= ~(FLUX_MSGFLAG_PAYLOAD);
-        skip_payload = true;
     }
     if (!(cpy = flux_msg_create_common ()))
         return NULL;
-    if (!(cpy->zmsg = zmsg_new ()))
-        goto nomem;
-
-    /* Copy frames from 'msg' to 'cpy'.
-     * 'count' indexes frames from 0 to zmsg_size (msg) - 1.
-     * The payload frame (if it exists) will be in the second to last position.
-     */
-    count = 0;
-    zf = zmsg_first (msg->zmsg);
-    while (zf) {
-        if (!skip_payload || count != zmsg_size (msg->zmsg) - 2) {
-            if (zmsg_addmem (cpy->zmsg, zframe_data (zf), zframe_size (zf)) < 0)
-                goto nomem;
+    cpy->proto = msg->proto;
+    for (i = 0; i < msg->route_count; i++) {
+        if (msg_append_route (cpy, msg->routes[i], strlen (msg->routes[i])) < 0)
+            goto nomem;
+    }
+    if ((msg->proto.flags & FLUX_MSGFLAG_TOPIC)) {
+        if (msg->topic_intern) {
+            cpy->topic_intern = msg->topic_intern;
+            cpy->topic = msg->topic;
+            cpy->topic_len = msg->topic_len;
         }
-        zf = zmsg_next (msg->zmsg);
-        count++;
+        else if (msg_set_topic_buf (cpy, msg->topic, msg->topic_len) < 0)
+            goto nomem;
     }
-    if (flux_msg_set_flags (cpy, flags) < 0)
-        goto error;
+    /* The payload is immutable, so it is shared rather than copied.
+     */
+    if (payload)
+        cpy->payload = payload_incref (msg->payload);
+    else
+        cpy->proto.flags &= ~(uint8_t)(FLUX_MSGFLAG_PAYLOAD);
     return cpy;
 nomem:
-    errno = ENOMEM;
-error:
     flux_msg_destroy (cpy);
+    errno = ENOMEM;
     return NULL;
 }
 
@@ -1525,11 +1778,24 @@ static const char *msgtype_shortstr (int type)
     return "?";
 }
 
+static void proto_fprint (FILE *f,
+                          const char *prefix,
+                          const uint8_t *data,
+                          size_t size)
+{
+    int i;
+
+    fprintf (f, "%s[%03zu] ", prefix, size);
+    for (i = 0; i < size; i++)
+        fprintf (f, "%02X", data[i]);
+    fprintf (f, "\n");
+}
+
 void flux_msg_fprint (FILE *f, const flux_msg_t *msg)
 {
     int hops;
     int type = 0;
-    zframe_t *proto;
+    uint8_t proto[PROTO_SIZE_MAX];
     const char *prefix, *topic = NULL;
 
     fprintf (f, "--------------------------------------\n");
@@ -1537,8 +1803,7 @@ void flux_msg_fprint (FILE *f, const flux_msg_t *msg)
         fprintf (f, "NULL");
         return;
     }
-    if (flux_msg_get_type (msg, &type) < 0
-            || (!(proto = zmsg_last (msg->zmsg)))) {
+    if (flux_msg_get_type (msg, &type) < 0) {
         fprintf (f, "malformed message");
         return;
     }
@@ -1573,54 +1838,83 @@ void flux_msg_fprint (FILE *f, const flux_msg_t *msg)
     }
     /* Proto block
      */
-    zframe_fprint (proto, prefix, f);
+    proto_fprint (f, prefix, proto, proto_encode (&msg->proto, proto));
+}
+
+/* Each frame is handed to zmq directly from message storage.
+ */
+static int frame_send (const void *data, size_t size, bool more, void *arg)
+{
+    if (zmq_send (arg, data, size, more ? ZMQ_SNDMORE : 0) < 0)
+        return -1;
+    return 0;
 }
 
 int flux_msg_sendzsock (void *sock, const flux_msg_t *msg)
 {
-    int rc = -1;
+    uint8_t proto[PROTO_SIZE_MAX];
+    void *handle;
 
-    if (!sock || !msg || !zmsg_is (msg->zmsg)) {
+    if (!sock || !msg || !(handle = zsock_resolve (sock))) {
         errno = EINVAL;
-        goto done;
-    }
-
-    void *handle = zsock_resolve (sock);
-    int flags = ZFRAME_REUSE | ZFRAME_MORE;
-    zframe_t *zf = zmsg_first (msg->zmsg);
-    size_t count = 0;
-
-    while (zf) {
-        if (++count == zmsg_size (msg->zmsg))
-            flags &= ~ZFRAME_MORE;
-        if (zframe_send (&zf, handle, flags) < 0)
-            goto done;
-        zf = zmsg_next (msg->zmsg);
+        return -1;
     }
-    rc = 0;
-done:
-    return rc;
+    return msg_foreach_frame (msg, proto, frame_send, handle);
 }
 
 flux_msg_t *flux_msg_recvzsock (void *sock)
 {
-    zmsg_t *zmsg;
-    flux_msg_t *msg;
+    void *handle;
+    zmq_msg_t *zframes;
+    struct frame *frames = NULL;
+    int alloc = 8;
+    int count = 0;
+    flux_msg_t *msg = NULL;
+    int i;
 
-    if (!(zmsg = zmsg_recv (sock)))
+    if (!sock || !(handle = zsock_resolve (sock))) {
+        errno = EINVAL;
         return NULL;
-    if (!(msg = flux_msg_create_common ())) {
-        zmsg_destroy (&zmsg);
+    }
+    if (!(zframes = malloc (alloc * sizeof (*zframes)))) {
         errno = ENOMEM;
         return NULL;
     }
-    msg->zmsg = zmsg;
-    return msg;
-}
+    do {
+        if (count == alloc) {
+            zmq_msg_t *new_zframes;
+            if (!(new_zframes = realloc (zframes,
+                                         alloc * 2 * sizeof (*zframes)))) {
+                errno = ENOMEM;
+                goto done;
+            }
+            zframes = new_zframes;
+            alloc *= 2;
+        }
+        if (zmq_msg_init (&zframes[count]) < 0)
+            goto done;
+        if (zmq_msg_recv (&zframes[count], handle, 0) < 0) {
+            ERRNO_SAFE_WRAP (zmq_msg_close, &zframes[count]);
+            goto done;
+        }
+        count++;
+    } while (zmq_msg_more (&zframes[count - 1]));
 
-int flux_msg_frames (const flux_msg_t *msg)
-{
-    return zmsg_size (msg->zmsg);
+    if (!(frames = malloc (count * sizeof (*frames)))) {
+        errno = ENOMEM;
+        goto done;
+    }
+    for (i = 0; i < count; i++) {
+        frames[i].data = zmq_msg_data (&zframes[i]);
+        frames[i].size = zmq_msg_size (&zframes[i]);
+    }
+    msg = msg_from_frames (frames, count);
+done:
+    for (i = 0; i < count; i++)
+        ERRNO_SAFE_WRAP (zmq_msg_close, &zframes[i]);
+    ERRNO_SAFE_WRAP (free, zframes);
+    ERRNO_SAFE_WRAP (free, frames);
+    return msg;
 }
 
 struct flux_match flux_match_init (int typemask,
@@ -1651,4 +1945,3 @@ int flux_match_asprintf (struct flux_match *m, const char *topic_glob_fmt, ...)
 /*
  * vi:tabstop=4 shiftwidth=4 expandtab
  */
-
@@ -120,6 +120,21 @@ int flux_msg_encode (const flux_msg_t *msg, void *buf, size_t size);
  */
 int flux_msg_frames (const flux_msg_t *msg);
 
+/* Get statistics for the calling thread's message allocation cache.
+ * Released messages and small payloads are cached per thread and
+ * reused by subsequent allocations in that thread.
+ */
+typedef struct {
+    uint64_t msg_alloc;     /* messages allocated from the heap */
+    uint64_t msg_reuse;     /* messages recycled from the cache */
+    int msg_cached;         /* messages currently held in the cache */
+    uint64_t payload_alloc; /* payload buffers allocated from the heap */
+    uint64_t payload_reuse; /* payload buffers recycled from the cache */
+    int payload_cached;     /* payload buffers currently held in the cache */
+} flux_msg_cachestats_t;
+
+void flux_msg_get_cachestats (flux_msg_cachestats_t *stats);
+
 /* Decode a flux_msg_t from buffer.
  * Returns message on success, NULL on failure with errno set.
  * Caller must destroy message with flux_msg_destroy().
@@ -198,6 +213,10 @@ int flux_msg_get_string (const flux_msg_t *msg, const char **s);
 /* Get/set JSON payload (encoded as string)
  * pack/unpack functions use jansson pack/unpack style arguments for
  * encoding/decoding the JSON object payload directly from/to its members.
+ * The decoded object is cached with the payload and shared by copies of
+ * the message made with flux_msg_copy(), so JSON objects obtained with
+ * unpack must be treated as read-only.  Since the cached object is not
+ * thread safe, such copies must not be used from different threads.
  */
 int flux_msg_pack (flux_msg_t *msg, const char *fmt, ...);
 int flux_msg_vpack (flux_msg_t *msg, const char *fmt, va_list ap);
@@ -284,6 +303,32 @@ int flux_msg_set_matchtag (flux_msg_t *msg, uint32_t matchtag);
 int flux_msg_get_matchtag (const flux_msg_t *msg, uint32_t *matchtag);
 bool flux_msg_cmp_matchtag (const flux_msg_t *msg, uint32_t matchtag);
 
+/* Get/set request deadline (request only).
+ * A deadline is set 'timeout' seconds from now, and a negative 'timeout'
+ * clears it.  It is carried with the request to other nodes, where it is
+ * measured again from the time of arrival, so clocks need not agree.
+ * The dispatcher drops a request whose deadline has passed and responds
+ * with ETIMEDOUT (see flux_dispatch_get_expired()).  A service that
+ * forwards a request on behalf of a client can copy the deadline into
+ * the new request.
+ * get returns the seconds remaining, which may be negative, or fails
+ * with ENOENT if the request has no deadline.
+ */
+int flux_msg_set_deadline (flux_msg_t *msg, double timeout);
+int flux_msg_get_deadline (const flux_msg_t *msg, double *timeout);
+bool flux_msg_is_expired (const flux_msg_t *msg);
+
+/* Get/set trace context (any type).
+ * 'trace' identifies an end-to-end operation and 'span' one request in it.
+ * Responses derived from a request keep its context.  Setting 'trace'
+ * to 0 clears the context.  get fails with ENOENT if there is none.
+ * See also: flux_trace_record().
+ */
+int flux_msg_set_trace (flux_msg_t *msg, uint64_t trace, uint64_t span);
+int flux_msg_get_trace (const flux_msg_t *msg,
+                        uint64_t *trace,
+                        uint64_t *span);
+
 /* Match a message.
  */
 bool flux_msg_cmp (const flux_msg_t *msg, struct flux_match match);
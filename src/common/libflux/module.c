@@ -18,6 +18,7 @@
 #include <jansson.h>
 
 #include "module.h"
+#include "module_private.h"
 #include "message.h"
 #include "keepalive.h"
 #include "rpc.h"
@@ -145,6 +146,90 @@ done:
     return rc;
 }
 
+void flux_module_memory_set (flux_t *h, size_t bytes)
+{
+    struct flux_module_memory *mm;
+
+    if (h && (mm = flux_aux_get (h, FLUX_MODULE_MEMORY_AUX))) {
+        __atomic_store_n (&mm->usage, bytes, __ATOMIC_RELAXED);
+        if (bytes > __atomic_load_n (&mm->peak, __ATOMIC_RELAXED))
+            __atomic_store_n (&mm->peak, bytes, __ATOMIC_RELAXED);
+    }
+}
+
+void flux_module_memory_add (flux_t *h, ssize_t delta)
+{
+    struct flux_module_memory *mm;
+
+    if (h && (mm = flux_aux_get (h, FLUX_MODULE_MEMORY_AUX))) {
+        size_t usage = __atomic_load_n (&mm->usage, __ATOMIC_RELAXED);
+
+        if (delta < 0 && (size_t)-delta > usage)
+            usage = 0;
+        else
+            usage += delta;
+        flux_module_memory_set (h, usage);
+    }
+}
+
+size_t flux_module_memory_get (flux_t *h)
+{
+    struct flux_module_memory *mm;
+
+    if (!h || !(mm = flux_aux_get (h, FLUX_MODULE_MEMORY_AUX)))
+        return 0;
+    return __atomic_load_n (&mm->usage, __ATOMIC_RELAXED);
+}
+
+int flux_module_set_shed (flux_t *h, flux_module_shed_f cb, void *arg)
+{
+    struct flux_module_memory *mm;
+
+    if (!h) {
+        errno = EINVAL;
+        return -1;
+    }
+    if ((mm = flux_aux_get (h, FLUX_MODULE_MEMORY_AUX))) {
+        mm->shed = cb;
+        mm->shed_arg = arg;
+        mm->shed_usage = 0;
+    }
+    return 0;
+}
+
+int flux_module_handoff_export (flux_t *h, const char *state)
+{
+    struct flux_module_handoff *ho;
+    char *cpy = NULL;
+
+    if (!h) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!(ho = flux_aux_get (h, FLUX_MODULE_HANDOFF_AUX)))
+        return 0;
+    if (state && !(cpy = strdup (state)))
+        return -1;
+    free (ho->next);
+    ho->next = cpy;
+    return 0;
+}
+
+const char *flux_module_handoff_import (flux_t *h)
+{
+    struct flux_module_handoff *ho;
+
+    if (!h) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(ho = flux_aux_get (h, FLUX_MODULE_HANDOFF_AUX)) || !ho->prev) {
+        errno = ENOENT;
+        return NULL;
+    }
+    return ho->prev;
+}
+
 /*
  * vi:tabstop=4 shiftwidth=4 expandtab
  */
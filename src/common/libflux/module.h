@@ -17,6 +17,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <sys/types.h>
 
 #include "handle.h"
 
@@ -69,6 +70,82 @@ bool flux_module_debug_test (flux_t *h, int flag, bool clear);
  */
 int flux_module_set_running (flux_t *h);
 
+/* Memory accounting.  A module reports the bytes held by its caches and
+ * lists with flux_module_memory_set() or flux_module_memory_add(), and
+ * flux-module(1) list displays the total.  If a soft limit is set with
+ * flux-module(1) memory --limit and usage exceeds it, the shed callback
+ * is called before the module's reactor blocks, so the module can
+ * release memory (e.g. expire cache entries) and report its new usage.
+ * It is called again only if usage grows past its value at the last
+ * call, or after usage has dropped to the limit or below.
+ * These functions have no effect outside of a broker module.
+ */
+typedef void (*flux_module_shed_f)(flux_t *h,
+                                   size_t usage,
+                                   size_t limit,
+                                   void *arg);
+
+void flux_module_memory_set (flux_t *h, size_t bytes);
+void flux_module_memory_add (flux_t *h, ssize_t delta);
+
+/* Return the current usage, or 0 outside of a broker module.
+ */
+size_t flux_module_memory_get (flux_t *h);
+
+int flux_module_set_shed (flux_t *h, flux_module_shed_f cb, void *arg);
+
+/* State handoff across module reload.  Before it exits, a module may
+ * export an opaque 'state' string, which the broker keeps until the next
+ * module of the same name is loaded on this broker.  That module may then
+ * import it to restore caches instead of starting cold.  The successor
+ * may be a different version of the module, so the state should carry
+ * its own version and be validated on import.  Exporting again replaces
+ * the state, and exporting NULL discards it.
+ * Export has no effect outside of a broker module.
+ * Returns 0 on success, -1 on error with errno set.
+ */
+int flux_module_handoff_export (flux_t *h, const char *state);
+
+/* Return the state exported by the module's predecessor, or NULL with
+ * errno set to ENOENT if there is none.  The string remains valid for
+ * the life of the module.
+ */
+const char *flux_module_handoff_import (flux_t *h);
+
+/* Key function for flux_module_set_workers().  Return a string naming the
+ * state that request 'msg' operates on, such as a KVS namespace or jobid.
+ * Requests with the same key are always handled by the same worker.
+ * Return NULL if any worker may handle the request.
+ */
+typedef const char *(*flux_module_key_f)(const flux_msg_t *msg, void *arg);
+
+/* Worker function for flux_module_set_workers().  It is called in a new
+ * thread with a handle 'h' that has its own reactor, and plays the role of
+ * mod_main() for the worker:  it should register message handlers and run
+ * the reactor.  The reactor is stopped when the module exits.
+ * A handle and the objects created from it may only be used by the thread
+ * that owns it, so workers should not share state without locking.
+ */
+typedef int (*flux_module_worker_f)(flux_t *h, int index, void *arg);
+
+/* Start 'count' worker threads, each calling fn(h, index, arg), and forward
+ * requests matching 'topic_glob' from the module handle to them.  If 'key'
+ * is non-NULL, it is called for each request in the module thread to choose
+ * a worker; otherwise requests are distributed round robin.
+ * Messages sent by workers, including requests and their responses, are
+ * routed through the module handle, so the module must run its reactor.
+ * Workers are stopped and joined when the module handle is closed.  RPCs
+ * from workers that are still pending then fail with ECONNRESET, so that
+ * a worker blocked in flux_future_get() can return to its reactor.
+ * Returns 0 on success, -1 on error with errno set.
+ */
+int flux_module_set_workers (flux_t *h,
+                             int count,
+                             const char *topic_glob,
+                             flux_module_key_f key,
+                             flux_module_worker_f fn,
+                             void *arg);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,60 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _FLUX_CORE_MODULE_PRIVATE_H
+#define _FLUX_CORE_MODULE_PRIVATE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "module.h"
+
+/* Memory account shared by the broker and a module thread.
+ *
+ * The broker allocates one per module and attaches it to the module's
+ * handle under FLUX_MODULE_MEMORY_AUX before mod_main() runs, so the
+ * flux_module_memory_*() functions are no-ops outside the broker.
+ * 'usage', 'peak', 'limit' and 'sheds' are written by the module thread
+ * and read by the broker thread for lsmod, so access them with
+ * __atomic builtins.  The remaining fields belong to the module thread.
+ */
+#define FLUX_MODULE_MEMORY_AUX "flux::module_memory"
+
+struct flux_module_memory {
+    size_t usage;               // bytes reported by the module
+    size_t peak;                // largest 'usage' seen
+    size_t limit;               // soft limit, 0 = none
+    uint64_t sheds;             // number of shed callbacks made
+
+    flux_module_shed_f shed;
+    void *shed_arg;
+    size_t shed_usage;          // usage at last shed, 0 if under limit
+};
+
+/* State handed from a module to its successor on reload.
+ *
+ * The broker attaches one per module to the module's handle under
+ * FLUX_MODULE_HANDOFF_AUX before mod_main() runs.  'prev' is set by the
+ * broker before the module thread starts, and 'next' is read by the broker
+ * after the thread is joined, so no locking is needed.  Both are owned by
+ * the broker's module object.
+ */
+#define FLUX_MODULE_HANDOFF_AUX "flux::module_handoff"
+
+struct flux_module_handoff {
+    char *prev;                 // state exported by the predecessor
+    char *next;                 // state exported for the successor
+};
+
+#endif /* !_FLUX_CORE_MODULE_PRIVATE_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,473 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* module_workers.c - run module request handlers on a pool of threads
+ *
+ * Each worker thread has its own handle and reactor, connected to the
+ * module's main thread over a shmem:// PAIR socket.  The main thread
+ * forwards requests matching the worker topic glob to a worker, chosen
+ * by hashing the key returned by the module's key function, or round
+ * robin if there is no key.
+ *
+ * Messages sent by a worker are forwarded to the broker on the module
+ * handle.  Requests sent by a worker have a route frame naming the worker
+ * pushed onto them, so their responses can be routed back to it.
+ *
+ * At module exit (when the module handle is closed), each worker is sent
+ * a keepalive message that stops its reactor, and the thread is joined.
+ * The main thread no longer routes messages then, so a worker blocked in
+ * a synchronous RPC would never get its response.  Requests sent by each
+ * worker are tracked until their final response, and those outstanding
+ * are failed with ECONNRESET, as are any the worker sends while it is
+ * being joined.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "module.h"
+#include "handle.h"
+#include "reactor.h"
+#include "message.h"
+#include "msg_handler.h"
+#include "msglist.h"
+#include "keepalive.h"
+#include "attr.h"
+#include "conf.h"
+#include "flog.h"
+
+#include "src/common/libutil/log.h"
+
+#define WORKER_ROUTE_PREFIX "flux::worker-"
+
+struct module_workers;
+
+struct worker {
+    struct module_workers *mw;
+    int index;
+    char route[32];         // route frame pushed on worker's requests
+    char name[64];          // shmem:// socket name
+    flux_t *h;              // main thread's end of worker connection
+    flux_msg_handler_t **handlers;
+    char *rank;             // copied from module handle for worker handle
+    flux_conf_t *conf;      // copied from module handle for worker handle
+    struct flux_msglist *pending; // worker requests awaiting a response
+    pthread_t t;
+    bool started;
+};
+
+struct module_workers {
+    flux_t *h;              // module handle
+    int count;
+    struct worker *workers;
+    flux_msg_handler_t *request_mh;
+    flux_msg_handler_t *response_mh;
+    flux_module_key_f key;
+    flux_module_worker_f fn;
+    void *arg;
+    unsigned int next;      // round robin index for unkeyed requests
+};
+
+/* FNV-1a, for choosing a worker by key.
+ */
+static unsigned int hash_key (const char *s)
+{
+    unsigned int hash = 2166136261U;
+
+    while (*s) {
+        hash ^= (unsigned char)*s++;
+        hash *= 16777619U;
+    }
+    return hash;
+}
+
+static struct worker *worker_select (struct module_workers *mw,
+                                     const flux_msg_t *msg)
+{
+    const char *key = NULL;
+
+    if (mw->key)
+        key = mw->key (msg, mw->arg);
+    if (key)
+        return &mw->workers[hash_key (key) % mw->count];
+    return &mw->workers[mw->next++ % mw->count];
+}
+
+/* Main thread: a request for the workers arrived from the broker.
+ */
+static void request_cb (flux_t *h,
+                        flux_msg_handler_t *mh,
+                        const flux_msg_t *msg,
+                        void *arg)
+{
+    struct module_workers *mw = arg;
+    struct worker *w = worker_select (mw, msg);
+
+    if (flux_send (w->h, msg, 0) < 0) {
+        flux_log_error (h, "error forwarding request to worker %d", w->index);
+        if (flux_respond_error (h, msg, errno, NULL) < 0)
+            flux_log_error (h, "error responding to request");
+    }
+}
+
+/* Main thread: a response arrived from the broker.  If it is for a request
+ * sent by a worker, pop the worker's route frame and forward it.
+ */
+static void response_cb (flux_t *h,
+                         flux_msg_handler_t *mh,
+                         const flux_msg_t *msg,
+                         void *arg)
+{
+    struct module_workers *mw = arg;
+    struct worker *w;
+    flux_msg_t *cpy;
+    char *route = NULL;
+    int index;
+    char *endptr;
+    uint32_t matchtag;
+    int errnum = 0;
+    flux_msg_t *req;
+
+    if (!(cpy = flux_msg_copy (msg, true)))
+        return;
+    if (flux_msg_pop_route (cpy, &route) < 0 || !route)
+        goto done;
+    if (strncmp (route,
+                 WORKER_ROUTE_PREFIX,
+                 strlen (WORKER_ROUTE_PREFIX)) != 0)
+        goto done;
+    errno = 0;
+    index = strtol (route + strlen (WORKER_ROUTE_PREFIX), &endptr, 10);
+    if (errno != 0 || *endptr != '\0' || index < 0 || index >= mw->count)
+        goto done;
+    w = &mw->workers[index];
+    /* A streaming request is finished by an error response.
+     */
+    if ((!flux_msg_is_streaming (cpy)
+         || (flux_msg_get_errnum (cpy, &errnum) == 0 && errnum != 0))
+        && flux_msg_get_matchtag (cpy, &matchtag) == 0
+        && (req = flux_msglist_pop_sender (w->pending, cpy, matchtag)))
+        flux_msg_decref (req);
+    if (flux_send (w->h, cpy, 0) < 0)
+        flux_log_error (h, "error forwarding response to worker %d", index);
+done:
+    free (route);
+    flux_msg_destroy (cpy);
+}
+
+/* Main thread: a message arrived from a worker.  Forward it to the broker.
+ */
+static void worker_msg_cb (flux_t *h,
+                           flux_msg_handler_t *mh,
+                           const flux_msg_t *msg,
+                           void *arg)
+{
+    struct worker *w = arg;
+    flux_msg_t *cpy = NULL;
+    uint32_t matchtag;
+    int type;
+
+    if (flux_msg_get_type (msg, &type) < 0)
+        return;
+    if (type == FLUX_MSGTYPE_REQUEST) {
+        if (!(cpy = flux_msg_copy (msg, true))
+            || flux_msg_enable_route (cpy) < 0
+            || flux_msg_push_route (cpy, w->route) < 0)
+            goto error;
+        if (flux_send (w->mw->h, cpy, 0) < 0)
+            goto error;
+        if (!flux_msg_is_noresponse (msg)
+            && flux_msg_get_matchtag (msg, &matchtag) == 0
+            && matchtag != FLUX_MATCHTAG_NONE) {
+            const flux_msg_t *req = flux_msg_incref (msg);
+            if (flux_msglist_append (w->pending, req, (void *)req) < 0) {
+                flux_msg_decref (req);
+                flux_log_error (w->mw->h,
+                                "error tracking request from worker %d",
+                                w->index);
+            }
+        }
+        flux_msg_destroy (cpy);
+        return;
+    }
+    if (flux_send (w->mw->h, msg, 0) < 0)
+        goto error;
+    return;
+error:
+    flux_log_error (w->mw->h,
+                    "error forwarding %s from worker %d",
+                    flux_msg_typestr (type),
+                    w->index);
+    flux_msg_destroy (cpy);
+}
+
+static const struct flux_msg_handler_spec worker_htab[] = {
+    { FLUX_MSGTYPE_REQUEST,     NULL,   worker_msg_cb,  FLUX_ROLE_ALL },
+    { FLUX_MSGTYPE_RESPONSE,    NULL,   worker_msg_cb,  FLUX_ROLE_ALL },
+    { FLUX_MSGTYPE_EVENT,       NULL,   worker_msg_cb,  FLUX_ROLE_ALL },
+    FLUX_MSGHANDLER_TABLE_END,
+};
+
+/* Worker thread: the module is exiting.
+ */
+static void stop_cb (flux_t *h,
+                     flux_msg_handler_t *mh,
+                     const flux_msg_t *msg,
+                     void *arg)
+{
+    flux_reactor_stop (flux_get_reactor (h));
+}
+
+/* Make the worker handle look like the module handle to the worker
+ * function:  same rank attribute and config object.  These were copied
+ * in the main thread since the module handle may not be used here.
+ */
+static int worker_setup (struct worker *w, flux_t *h)
+{
+    if (w->rank && flux_attr_set_cacheonly (h, "rank", w->rank) < 0)
+        return -1;
+    if (w->conf) {
+        if (flux_set_conf (h, w->conf) < 0)
+            return -1;
+        w->conf = NULL; // handle owns it now
+    }
+    return 0;
+}
+
+static void *worker_thread (void *arg)
+{
+    struct worker *w = arg;
+    struct flux_match match = FLUX_MATCH_ANY;
+    flux_msg_handler_t *mh = NULL;
+    char uri[128];
+    flux_t *h;
+
+    (void)snprintf (uri, sizeof (uri), "shmem://%s&connect", w->name);
+    if (!(h = flux_open (uri, 0))) {
+        log_err ("worker %d: flux_open %s", w->index, uri);
+        return NULL;
+    }
+    if (worker_setup (w, h) < 0) {
+        flux_log_error (h, "worker %d: setup failed", w->index);
+        goto done;
+    }
+    match.typemask = FLUX_MSGTYPE_KEEPALIVE;
+    if (!(mh = flux_msg_handler_create (h, match, stop_cb, NULL))) {
+        flux_log_error (h, "worker %d: flux_msg_handler_create", w->index);
+        goto done;
+    }
+    flux_msg_handler_start (mh);
+    if (w->mw->fn (h, w->index, w->mw->arg) < 0)
+        flux_log_error (h, "worker %d: fatal error", w->index);
+done:
+    flux_msg_handler_destroy (mh);
+    flux_close (h);
+    return NULL;
+}
+
+/* Main thread: fail a request from worker 'w', which is being stopped.
+ */
+static void worker_fail_request (struct worker *w, const flux_msg_t *msg)
+{
+    if (flux_msg_is_noresponse (msg))
+        return;
+    if (flux_respond_error (w->h, msg, ECONNRESET, "module is unloading") < 0)
+        flux_log_error (w->mw->h,
+                        "error failing request from worker %d",
+                        w->index);
+}
+
+/* Main thread: wait up to 100ms for worker 'w' to exit.
+ * Returns 0 on success, or an errno value such as ETIMEDOUT.
+ */
+static int worker_join (struct worker *w)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_REALTIME, &ts);
+    ts.tv_nsec += 100000000;
+    if (ts.tv_nsec >= 1000000000) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000;
+    }
+    return pthread_timedjoin_np (w->t, NULL, &ts);
+}
+
+static void worker_stop (struct worker *w)
+{
+    flux_msg_t *msg;
+
+    if (w->started) {
+        int e;
+
+        if (!(msg = flux_keepalive_encode (0, FLUX_MODSTATE_EXITED))
+            || flux_send (w->h, msg, 0) < 0)
+            flux_log_error (w->mw->h, "error stopping worker %d", w->index);
+        flux_msg_destroy (msg);
+        while ((msg = flux_msglist_pop (w->pending))) {
+            worker_fail_request (w, msg);
+            flux_msg_decref (msg);
+        }
+        /* Anything the worker sends now would not be routed, so fail its
+         * requests and drop the rest.
+         */
+        while ((e = worker_join (w)) == ETIMEDOUT) {
+            while ((msg = flux_recv (w->h, FLUX_MATCH_ANY, FLUX_O_NONBLOCK))) {
+                int type;
+                if (flux_msg_get_type (msg, &type) == 0
+                    && type == FLUX_MSGTYPE_REQUEST)
+                    worker_fail_request (w, msg);
+                flux_msg_destroy (msg);
+            }
+        }
+        if (e != 0) {
+            errno = e;
+            flux_log_error (w->mw->h, "error joining worker %d", w->index);
+        }
+        w->started = false;
+    }
+    while ((msg = flux_msglist_pop (w->pending)))
+        flux_msg_decref (msg);
+    flux_msglist_destroy (w->pending);
+    w->pending = NULL;
+    flux_msg_handler_delvec (w->handlers);
+    w->handlers = NULL;
+    flux_close (w->h);
+    w->h = NULL;
+    flux_conf_decref (w->conf);
+    w->conf = NULL;
+    free (w->rank);
+    w->rank = NULL;
+}
+
+static void module_workers_destroy (struct module_workers *mw)
+{
+    if (mw) {
+        int saved_errno = errno;
+        flux_msg_handler_destroy (mw->request_mh);
+        flux_msg_handler_destroy (mw->response_mh);
+        for (int i = 0; i < mw->count; i++)
+            worker_stop (&mw->workers[i]);
+        free (mw->workers);
+        free (mw);
+        errno = saved_errno;
+    }
+}
+
+static int worker_start (struct module_workers *mw, int index)
+{
+    struct worker *w = &mw->workers[index];
+    const char *rank;
+    char uri[128];
+    sigset_t set, oset;
+    int e;
+
+    w->mw = mw;
+    w->index = index;
+    (void)snprintf (w->route, sizeof (w->route),
+                    WORKER_ROUTE_PREFIX "%d", index);
+    (void)snprintf (w->name, sizeof (w->name),
+                    "flux-module-worker-%p-%d", (void *)mw, index);
+    (void)snprintf (uri, sizeof (uri), "shmem://%s&bind", w->name);
+    if (!(w->h = flux_open (uri, 0)))
+        return -1;
+    if (flux_set_reactor (w->h, flux_get_reactor (mw->h)) < 0)
+        return -1;
+    if (flux_msg_handler_addvec (w->h, worker_htab, w, &w->handlers) < 0)
+        return -1;
+    if ((rank = flux_attr_get (mw->h, "rank")) && !(w->rank = strdup (rank)))
+        return -1;
+    if (!(w->conf = flux_conf_copy (flux_get_conf (mw->h))))
+        return -1;
+    if (!(w->pending = flux_msglist_create ()))
+        return -1;
+
+    /* Workers inherit the blocked signal mask of the module thread,
+     * but block all signals in case this is called from elsewhere.
+     */
+    sigfillset (&set);
+    pthread_sigmask (SIG_BLOCK, &set, &oset);
+    e = pthread_create (&w->t, NULL, worker_thread, w);
+    pthread_sigmask (SIG_SETMASK, &oset, NULL);
+    if (e != 0) {
+        errno = e;
+        return -1;
+    }
+    w->started = true;
+    return 0;
+}
+
+int flux_module_set_workers (flux_t *h,
+                             int count,
+                             const char *topic_glob,
+                             flux_module_key_f key,
+                             flux_module_worker_f fn,
+                             void *arg)
+{
+    struct module_workers *mw;
+    struct flux_match match = FLUX_MATCH_REQUEST;
+
+    if (!h || count < 1 || !topic_glob || !fn) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (flux_aux_get (h, "flux::module_workers")) {
+        errno = EEXIST;
+        return -1;
+    }
+    if (!(mw = calloc (1, sizeof (*mw))))
+        return -1;
+    mw->h = h;
+    mw->key = key;
+    mw->fn = fn;
+    mw->arg = arg;
+    if (!(mw->workers = calloc (count, sizeof (mw->workers[0]))))
+        goto error;
+    for (mw->count = 0; mw->count < count; mw->count++) {
+        if (worker_start (mw, mw->count) < 0) {
+            mw->count++; // clean up partially started worker
+            goto error;
+        }
+    }
+    match.topic_glob = (char *)topic_glob;
+    if (!(mw->request_mh = flux_msg_handler_create (h, match, request_cb, mw)))
+        goto error;
+    match = FLUX_MATCH_RESPONSE;
+    if (!(mw->response_mh = flux_msg_handler_create (h,
+                                                     match,
+                                                     response_cb,
+                                                     mw)))
+        goto error;
+    flux_msg_handler_allow_rolemask (mw->request_mh, FLUX_ROLE_ALL);
+    flux_msg_handler_allow_rolemask (mw->response_mh, FLUX_ROLE_ALL);
+    if (flux_aux_set (h,
+                      "flux::module_workers",
+                      mw,
+                      (flux_free_f)module_workers_destroy) < 0)
+        goto error;
+    flux_msg_handler_start (mw->request_mh);
+    flux_msg_handler_start (mw->response_mh);
+    return 0;
+error:
+    module_workers_destroy (mw);
+    return -1;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -20,22 +20,62 @@
 #include "message.h"
 #include "reactor.h"
 #include "msg_handler.h"
+#include "msg_handler_private.h"
+#include "topic_private.h"
 #include "response.h"
 #include "flog.h"
+#include "cbstats.h"
+#include "trace.h"
 
 #include "src/common/libutil/log.h"
-#include "src/common/libutil/iterators.h"
+
+/* Limit the number of distinct topics profiled per message type, in case
+ * a handler glob matches an unbounded set.  Excess topics are lumped
+ * together under CBSTATS_OTHER_TOPIC.
+ */
+#define CBSTATS_MAX_TOPICS 1024
+#define CBSTATS_OTHER_TOPIC "(other)"
+
+/* Response handlers are found by indexing a table with the matchtag.
+ * The table grows in powers of two up to the size of the matchtag pool.
+ * Matchtags outside of that range, which the handle's tag pool never
+ * allocates, fall back to a hash.
+ */
+#define RPC_TABLE_MIN (1U<<10)
+#define RPC_TABLE_MAX (1U<<20)
+
+/* Handlers that are not in the hashes below are indexed by the literal
+ * prefix of their topic glob (up to the first glob metacharacter) in a
+ * character trie.  Only handlers on nodes along a message's topic path
+ * can match it.  Each handler has a sequence number that increases with
+ * registration order, and each node lists its handlers newest first.
+ */
+struct topic_node {
+    struct topic_node *parent;
+    struct topic_node *child;       // first child
+    struct topic_node *sibling;     // next sibling
+    flux_msg_handler_t *handlers;   // newest first
+    char c;
+};
 
 struct dispatch {
     flux_t *h;
-    zlist_t *handlers;
+    flux_reactor_t *r;
+    struct topic_node *handlers;    // trie root
+    uint64_t handlers_seq;
     zlist_t *handlers_new;
-    zhashx_t *handlers_rpc; // matchtag => response handler
-    zhashx_t *handlers_method; // topic => request handler (non-glob only)
+    flux_msg_handler_t **handlers_rpc; // matchtag => response handler
+    uint32_t handlers_rpc_size;
+    zhashx_t *handlers_rpc_sparse; // matchtag >= RPC_TABLE_MAX => handler
+    zhashx_t *handlers_interned; // interned topic => request handler
+    zhashx_t *handlers_method; // topic => request handler (not interned)
     flux_watcher_t *w;
     int running_count;
     int usecount;
     zlist_t *unmatched;
+    int expired;            // requests dropped past their deadline
+    uint64_t trace;         // trace id of message being dispatched, or 0
+    zhashx_t *cbstats[3]; // topic => flux_cbstats_t, by message type
 #if HAVE_CALIPER
     cali_id_t prof_msg_type;
     cali_id_t prof_msg_topic;
@@ -52,6 +92,12 @@ struct flux_msg_handler {
     flux_msg_handler_f fn;
     void *arg;
     uint8_t running:1;
+    int refcount;
+    struct topic_node *node;        // set if indexed in d->handlers
+    const struct flux_topic *topic; // set if in d->handlers_interned
+    flux_msg_handler_t *next;
+    flux_msg_handler_t *prev;
+    uint64_t seq;
 };
 
 static void handle_cb (flux_reactor_t *r, flux_watcher_t *w,
@@ -94,16 +140,21 @@ static void dispatch_usecount_decr (struct dispatch *d)
             zlist_destroy (&d->unmatched);
         }
         if (d->handlers) {
-            assert (zlist_size (d->handlers) == 0);
-            zlist_destroy (&d->handlers);
+            assert (d->handlers->handlers == NULL
+                    && d->handlers->child == NULL);
+            free (d->handlers);
         }
         if (d->handlers_new) {
             assert (zlist_size (d->handlers_new) == 0);
             zlist_destroy (&d->handlers_new);
         }
         flux_watcher_destroy (d->w);
-        zhashx_destroy (&d->handlers_rpc);
+        free (d->handlers_rpc);
+        zhashx_destroy (&d->handlers_rpc_sparse);
+        zhashx_destroy (&d->handlers_interned);
         zhashx_destroy (&d->handlers_method);
+        for (int i = 0; i < 3; i++)
+            zhashx_destroy (&d->cbstats[i]);
         free (d);
         errno = saved_errno;
     }
@@ -130,23 +181,26 @@ static struct dispatch *dispatch_get (flux_t *h)
             return NULL;
         memset (d, 0, sizeof (*d));
         d->usecount = 1;
-        if (!(d->handlers = zlist_new ()))
+        if (!(d->handlers = calloc (1, sizeof (*d->handlers))))
             goto nomem;
         if (!(d->handlers_new = zlist_new ()))
             goto nomem;
         d->h = h;
+        d->r = r;
         d->w = flux_handle_watcher_create (r, h, FLUX_POLLIN, handle_cb, d);
         if (!d->w)
             goto error;
-        if (!(d->handlers_rpc = zhashx_new ()))
-            goto nomem;
-        zhashx_set_key_hasher (d->handlers_rpc, matchtag_hasher);
-        zhashx_set_key_comparator (d->handlers_rpc, matchtag_cmp);
-        zhashx_set_key_destructor (d->handlers_rpc, NULL);
-        zhashx_set_key_duplicator (d->handlers_rpc, NULL);
         /* N.B. d->handlers_method key points to mh->match.topic_glob in entry,
          * so disable the key duplicator and destructor to avoid extra malloc.
+         * d->handlers_interned keys belong to the topic intern table.
          */
+        if (!(d->handlers_interned = zhashx_new ()))
+            goto nomem;
+        zhashx_set_key_destructor (d->handlers_interned, NULL);
+        zhashx_set_key_duplicator (d->handlers_interned, NULL);
+        zhashx_set_key_hasher (d->handlers_interned, flux_topic_hasher);
+        zhashx_set_key_comparator (d->handlers_interned,
+                                   flux_topic_comparator);
         if (!(d->handlers_method = zhashx_new ()))
             goto nomem;
         zhashx_set_key_destructor (d->handlers_method, NULL);
@@ -173,7 +227,7 @@ error:
     return NULL;
 }
 
-/* zhahsx_comparator_fn to compare matchtags
+/* zhashx_comparator_fn to compare matchtags
  */
 static int matchtag_cmp (const void *key1, const void *key2)
 {
@@ -196,6 +250,82 @@ static size_t matchtag_hasher (const void *key)
     return matchtag;
 }
 
+static flux_msg_handler_t *rpc_lookup (struct dispatch *d, uint32_t matchtag)
+{
+    if (matchtag < d->handlers_rpc_size)
+        return d->handlers_rpc[matchtag];
+    if (matchtag >= RPC_TABLE_MAX && d->handlers_rpc_sparse)
+        return zhashx_lookup (d->handlers_rpc_sparse, &matchtag);
+    return NULL;
+}
+
+static int rpc_table_grow (struct dispatch *d, uint32_t matchtag)
+{
+    uint32_t size = d->handlers_rpc_size ? d->handlers_rpc_size
+                                         : RPC_TABLE_MIN;
+    flux_msg_handler_t **table;
+
+    while (size <= matchtag)
+        size <<= 1;
+    if (!(table = realloc (d->handlers_rpc, size * sizeof (table[0])))) {
+        errno = ENOMEM;
+        return -1;
+    }
+    memset (&table[d->handlers_rpc_size],
+            0,
+            (size - d->handlers_rpc_size) * sizeof (table[0]));
+    d->handlers_rpc = table;
+    d->handlers_rpc_size = size;
+    return 0;
+}
+
+static int rpc_insert (struct dispatch *d, flux_msg_handler_t *mh)
+{
+    uint32_t matchtag = mh->match.matchtag;
+
+    if (matchtag >= RPC_TABLE_MAX) {
+        if (!d->handlers_rpc_sparse) {
+            if (!(d->handlers_rpc_sparse = zhashx_new ())) {
+                errno = ENOMEM;
+                return -1;
+            }
+            zhashx_set_key_hasher (d->handlers_rpc_sparse, matchtag_hasher);
+            zhashx_set_key_comparator (d->handlers_rpc_sparse, matchtag_cmp);
+            zhashx_set_key_destructor (d->handlers_rpc_sparse, NULL);
+            zhashx_set_key_duplicator (d->handlers_rpc_sparse, NULL);
+        }
+        if (zhashx_insert (d->handlers_rpc_sparse,
+                           &mh->match.matchtag,
+                           mh) < 0) {
+            errno = EEXIST;
+            return -1;
+        }
+        return 0;
+    }
+    if (matchtag >= d->handlers_rpc_size && rpc_table_grow (d, matchtag) < 0)
+        return -1;
+    if (d->handlers_rpc[matchtag]) {
+        errno = EEXIST;
+        return -1;
+    }
+    d->handlers_rpc[matchtag] = mh;
+    return 0;
+}
+
+static void rpc_delete (struct dispatch *d, flux_msg_handler_t *mh)
+{
+    uint32_t matchtag = mh->match.matchtag;
+
+    if (matchtag < d->handlers_rpc_size) {
+        if (d->handlers_rpc[matchtag] == mh)
+            d->handlers_rpc[matchtag] = NULL;
+    }
+    else if (matchtag >= RPC_TABLE_MAX && d->handlers_rpc_sparse) {
+        if (zhashx_lookup (d->handlers_rpc_sparse, &matchtag) == mh)
+            zhashx_delete (d->handlers_rpc_sparse, &matchtag);
+    }
+}
+
 static int copy_match (struct flux_match *dst,
                        const struct flux_match src)
 {
@@ -209,6 +339,210 @@ static int copy_match (struct flux_match *dst,
     return 0;
 }
 
+/* Return true if 'c' is special in an fnmatch(3) pattern.
+ */
+static bool isa_globchar (char c)
+{
+    return (c == '*' || c == '?' || c == '[' || c == '\\');
+}
+
+static struct topic_node *topic_node_child (struct topic_node *node,
+                                            char c,
+                                            bool create)
+{
+    struct topic_node *child;
+
+    for (child = node->child; child != NULL; child = child->sibling) {
+        if (child->c == c)
+            return child;
+    }
+    if (!create)
+        return NULL;
+    if (!(child = calloc (1, sizeof (*child))))
+        return NULL;
+    child->c = c;
+    child->parent = node;
+    child->sibling = node->child;
+    node->child = child;
+    return child;
+}
+
+/* Remove empty nodes from the leaf 'node' up toward the root.
+ */
+static void topic_node_prune (struct topic_node *node)
+{
+    while (node->parent && !node->handlers && !node->child) {
+        struct topic_node *parent = node->parent;
+        struct topic_node **npp = &parent->child;
+        while (*npp != node)
+            npp = &(*npp)->sibling;
+        *npp = node->sibling;
+        free (node);
+        node = parent;
+    }
+}
+
+static int handler_index_insert (struct dispatch *d, flux_msg_handler_t *mh)
+{
+    struct topic_node *node = d->handlers;
+    const char *cp = mh->match.topic_glob;
+
+    while (cp && *cp && !isa_globchar (*cp)) {
+        struct topic_node *child;
+        if (!(child = topic_node_child (node, *cp++, true))) {
+            topic_node_prune (node);
+            errno = ENOMEM;
+            return -1;
+        }
+        node = child;
+    }
+    mh->seq = ++d->handlers_seq;
+    mh->node = node;
+    mh->prev = NULL;
+    mh->next = node->handlers;
+    if (mh->next)
+        mh->next->prev = mh;
+    node->handlers = mh;
+    return 0;
+}
+
+static void handler_index_remove (flux_msg_handler_t *mh)
+{
+    struct topic_node *node = mh->node;
+
+    if (!node)
+        return;
+    if (mh->prev)
+        mh->prev->next = mh->next;
+    else
+        node->handlers = mh->next;
+    if (mh->next)
+        mh->next->prev = mh->prev;
+    mh->next = mh->prev = NULL;
+    mh->node = NULL;
+    topic_node_prune (node);
+}
+
+static int cbstats_index (int type)
+{
+    switch (type) {
+        case FLUX_MSGTYPE_REQUEST:
+            return 0;
+        case FLUX_MSGTYPE_RESPONSE:
+            return 1;
+        case FLUX_MSGTYPE_EVENT:
+            return 2;
+    }
+    return -1;
+}
+
+static void cbstats_destructor (void **item)
+{
+    if (item) {
+        free (*item);
+        *item = NULL;
+    }
+}
+
+static flux_cbstats_t *cbstats_lookup (struct dispatch *d,
+                                       const flux_msg_t *msg)
+{
+    int type;
+    int index;
+    const char *topic;
+    flux_cbstats_t *stats;
+    zhashx_t *hash;
+
+    if (flux_msg_get_type (msg, &type) < 0
+        || (index = cbstats_index (type)) < 0
+        || flux_msg_get_topic (msg, &topic) < 0)
+        return NULL;
+    if (!(hash = d->cbstats[index])) {
+        if (!(hash = zhashx_new ()))
+            return NULL;
+        zhashx_set_destructor (hash, cbstats_destructor);
+        d->cbstats[index] = hash;
+    }
+    if (!(stats = zhashx_lookup (hash, topic))) {
+        if (zhashx_size (hash) >= CBSTATS_MAX_TOPICS) {
+            topic = CBSTATS_OTHER_TOPIC;
+            if ((stats = zhashx_lookup (hash, topic)))
+                return stats;
+        }
+        if (!(stats = calloc (1, sizeof (*stats))))
+            return NULL;
+        if (zhashx_insert (hash, topic, stats) < 0) {
+            free (stats);
+            return NULL;
+        }
+    }
+    return stats;
+}
+
+/* Call a message handler, timing it by message type and topic.
+ * Hold a dispatch reference so that the stats entry remains valid even if
+ * the callback destroys the last message handler.
+ */
+static void call_handler_profile (flux_msg_handler_t *mh,
+                                  const flux_msg_t *msg)
+{
+    struct dispatch *d = mh->d;
+    flux_cbstats_t *stats;
+    struct timespec t0;
+
+    if (!(stats = cbstats_lookup (d, msg))) {
+        mh->fn (d->h, mh, msg, mh->arg);
+        return;
+    }
+    dispatch_usecount_incr (d);
+    cbstats_start (&t0);
+    mh->fn (d->h, mh, msg, mh->arg);
+    cbstats_record (stats, &t0);
+    dispatch_usecount_decr (d);
+}
+
+void flux_msg_handler_profile_foreach (flux_t *h,
+                                       int type,
+                                       flux_cbstats_f fn,
+                                       void *arg)
+{
+    struct dispatch *d;
+    flux_cbstats_t *stats;
+    int index;
+
+    if (!h || !fn || (index = cbstats_index (type)) < 0)
+        return;
+    if (!(d = flux_aux_get (h, "flux::dispatch")) || !d->cbstats[index])
+        return;
+    stats = zhashx_first (d->cbstats[index]);
+    while (stats) {
+        if (stats->count > 0)
+            fn (zhashx_cursor (d->cbstats[index]), stats, arg);
+        stats = zhashx_next (d->cbstats[index]);
+    }
+}
+
+void flux_msg_handler_profile_clear (flux_t *h)
+{
+    struct dispatch *d;
+
+    if (!h || !(d = flux_aux_get (h, "flux::dispatch")))
+        return;
+    /* Zero entries rather than deleting them, since a message handler
+     * that is currently being profiled may hold a pointer to one.
+     */
+    for (int i = 0; i < 3; i++) {
+        flux_cbstats_t *stats;
+        if (!d->cbstats[i])
+            continue;
+        stats = zhashx_first (d->cbstats[i]);
+        while (stats) {
+            memset (stats, 0, sizeof (*stats));
+            stats = zhashx_next (d->cbstats[i]);
+        }
+    }
+}
+
 static void call_handler (flux_msg_handler_t *mh, const flux_msg_t *msg)
 {
     uint32_t rolemask, matchtag;
@@ -228,22 +562,123 @@ static void call_handler (flux_msg_handler_t *mh, const flux_msg_t *msg)
         }
         return;
     }
-    mh->fn (mh->d->h, mh, msg, mh->arg);
+    if (flux_reactor_profile_enabled (mh->d->r))
+        call_handler_profile (mh, msg);
+    else
+        mh->fn (mh->d->h, mh, msg, mh->arg);
+}
+
+/* Return the most recently registered running handler in the index that
+ * matches 'msg', or NULL if there is none.
+ */
+static flux_msg_handler_t *handler_index_first (struct dispatch *d,
+                                                const flux_msg_t *msg,
+                                                const char *topic)
+{
+    struct topic_node *node = d->handlers;
+    flux_msg_handler_t *best = NULL;
+
+    while (node) {
+        flux_msg_handler_t *mh;
+        for (mh = node->handlers; mh != NULL; mh = mh->next) {
+            if (best && mh->seq < best->seq)
+                break;
+            if (mh->running && flux_msg_cmp (msg, mh->match)) {
+                best = mh;
+                break;
+            }
+        }
+        if (!topic || *topic == '\0')
+            break;
+        node = topic_node_child (node, *topic++, false);
+    }
+    return best;
+}
+
+static int handler_seq_cmp (const void *a, const void *b)
+{
+    const flux_msg_handler_t *mh1 = *(const flux_msg_handler_t **)a;
+    const flux_msg_handler_t *mh2 = *(const flux_msg_handler_t **)b;
+
+    if (mh1->seq > mh2->seq)
+        return -1;
+    if (mh1->seq < mh2->seq)
+        return 1;
+    return 0;
+}
+
+
+/* Call every running handler in the index that matches 'msg', most
+ * recently registered first.  Candidates are collected up front and
+ * referenced so that callbacks may safely destroy any handler.
+ */
+static bool handler_index_all (struct dispatch *d,
+                               const flux_msg_t *msg,
+                               const char *topic)
+{
+    flux_msg_handler_t *buf[32];
+    flux_msg_handler_t **v = buf;
+    int size = sizeof (buf) / sizeof (buf[0]);
+    int count = 0;
+    struct topic_node *node = d->handlers;
+    bool match = false;
+
+    while (node) {
+        flux_msg_handler_t *mh;
+        for (mh = node->handlers; mh != NULL; mh = mh->next) {
+            if (!mh->running || !flux_msg_cmp (msg, mh->match))
+                continue;
+            if (count == size) {
+                flux_msg_handler_t **nv;
+                if (!(nv = malloc (sizeof (*nv) * size * 2)))
+                    goto done;
+                memcpy (nv, v, sizeof (*v) * count);
+                if (v != buf)
+                    free (v);
+                v = nv;
+                size *= 2;
+            }
+            mh->refcount++;
+            v[count++] = mh;
+        }
+        if (!topic || *topic == '\0')
+            break;
+        node = topic_node_child (node, *topic++, false);
+    }
+done:
+    if (count > 1)
+        qsort (v, count, sizeof (v[0]), handler_seq_cmp);
+    for (int i = 0; i < count; i++) {
+        if (v[i]->running) {
+            call_handler (v[i], msg);
+            match = true;
+        }
+    }
+    for (int i = 0; i < count; i++)
+        free_msg_handler (v[i]);
+    if (v != buf)
+        free (v);
+    return match;
 }
 
 /* Messages are matched in the following order:
- * 1) RPC responses - lookup in handlers_rpc hash by matchtag.
- * 2) RPC requests - lookup in handlers_method hash by topic string
+ * 1) RPC responses - lookup in handlers_rpc table by matchtag.
+ * 2) RPC requests - lookup in handlers_interned hash by interned topic,
+ *    which compares pointers, then in handlers_method hash by topic string
+ *    if any handlers have topics that could not be interned
  * 3) Requests and responses not matched above - sent to first match in
- *    list of handlers, where most recently registered handlers match first.
- * 4) Events - sent to all matches in list of handlers
+ *    the handler index, where most recently registered handlers match first.
+ * 4) Events - sent to all matches in the handler index, most recently
+ *    registered first.
  */
 static bool dispatch_message (struct dispatch *d,
                               const flux_msg_t *msg,
                               int type)
 {
     flux_msg_handler_t *mh;
-    bool match = false;
+    const char *topic = NULL;
+
+    (void)flux_msg_get_topic (msg, &topic);
 
     /* rpc response w/matchtag */
     if (type == FLUX_MSGTYPE_RESPONSE) {
@@ -251,38 +686,35 @@ static bool dispatch_message (struct dispatch *d,
         if (flux_msg_get_route_count (msg) == 0
                 && flux_msg_get_matchtag (msg, &matchtag) == 0
                 && matchtag != FLUX_MATCHTAG_NONE
-                && (mh = zhashx_lookup (d->handlers_rpc, &matchtag))
+                && (mh = rpc_lookup (d, matchtag))
                 && mh->running
                 && flux_msg_cmp (msg, mh->match)) {
             call_handler (mh, msg);
-            match = true;
+            return true;
         }
     }
     /* rpc request */
     else if (type == FLUX_MSGTYPE_REQUEST) {
-        const char *topic;
-        if (flux_msg_get_topic (msg, &topic) == 0
-                && (mh = zhashx_lookup (d->handlers_method, topic))
-                && mh->running) {
+        const struct flux_topic *interned;
+
+        mh = NULL;
+        if ((interned = flux_msg_get_topic_interned (msg)))
+            mh = zhashx_lookup (d->handlers_interned, interned);
+        if (!mh && topic && zhashx_size (d->handlers_method) > 0)
+            mh = zhashx_lookup (d->handlers_method, topic);
+        if (mh && mh->running) {
             call_handler (mh, msg);
-            match = true;
+            return true;
         }
     }
     /* other */
-    if (!match) {
-        FOREACH_ZLIST (d->handlers, mh) {
-            if (!mh->running)
-                continue;
-            if (flux_msg_cmp (msg, mh->match)) {
-                call_handler (mh, msg);
-                if (type != FLUX_MSGTYPE_EVENT) {
-                    match = true;
-                    break;
-                }
-            }
-        }
+    if (type == FLUX_MSGTYPE_EVENT)
+        return handler_index_all (d, msg, topic);
+    if ((mh = handler_index_first (d, msg, topic))) {
+        call_handler (mh, msg);
+        return true;
     }
-    return match;
+    return false;
 }
 
 /* A matchtag may have been leaked if an RPC future is destroyed with
@@ -309,20 +741,16 @@ static void handle_late_response (struct dispatch *d, const flux_msg_t *msg)
         fprintf (stderr, "MATCHDEBUG: reclaimed matchtag=%d\n", matchtag);
 }
 
-static int transfer_items_zlist (zlist_t *from, zlist_t *to)
+static int transfer_new_handlers (struct dispatch *d)
 {
-    void *item;
-    int rc = -1;
+    flux_msg_handler_t *mh;
 
-    while ((item = zlist_pop (from))) {
-        if (zlist_push (to, item) < 0) {
-            errno = ENOMEM;
-            goto done;
-        }
+    while ((mh = zlist_first (d->handlers_new))) {
+        if (handler_index_insert (d, mh) < 0)
+            return -1;
+        zlist_remove (d->handlers_new, mh);
     }
-    rc = 0;
-done:
-    return rc;
+    return 0;
 }
 
 static void handle_cb (flux_reactor_t *r,
@@ -335,6 +763,7 @@ static void handle_cb (flux_reactor_t *r,
     int rc = -1;
     int type;
     bool match;
+    uint64_t saved_trace;
 
     if (revents & FLUX_POLLERR)
         goto done;
@@ -347,13 +776,26 @@ static void handle_cb (flux_reactor_t *r,
         rc = 0; /* ignore mangled message */
         goto done;
     }
+    flux_trace_record (msg, "dispatch");
+    /* Drop a request whose deadline has passed, since the sender has
+     * given up waiting for it.
+     */
+    if (type == FLUX_MSGTYPE_REQUEST && flux_msg_is_expired (msg)) {
+        d->expired++;
+        (void)flux_respond_error (d->h,
+                                  msg,
+                                  ETIMEDOUT,
+                                  "Request deadline expired");
+        rc = 0;
+        goto done;
+    }
 
     const char *topic;
     flux_msg_get_topic (msg, &topic);
     /* Add any new handlers here, making handler creation
      * safe to call during handlers list traversal below.
      */
-    if (transfer_items_zlist (d->handlers_new, d->handlers) < 0)
+    if (transfer_new_handlers (d) < 0)
         goto done;
 
 #if defined(HAVE_CALIPER)
@@ -364,7 +806,14 @@ static void handle_cb (flux_reactor_t *r,
     cali_end (d->prof_msg_type);
 #endif
 
+    /* Requests sent by the handler join the dispatched message's trace.
+     * Save and restore, since a handler may run the reactor recursively.
+     */
+    saved_trace = d->trace;
+    if (flux_msg_get_trace (msg, &d->trace, NULL) < 0)
+        d->trace = 0;
     match = dispatch_message (d, msg, type);
+    d->trace = saved_trace;
 
 #if defined(HAVE_CALIPER)
     cali_begin_string (d->prof_msg_type, flux_msg_typestr (type));
@@ -468,9 +917,11 @@ void flux_msg_handler_deny_rolemask (flux_msg_handler_t *mh, uint32_t rolemask)
     }
 }
 
+/* Drop a reference on 'mh', freeing it when the last one is gone.
+ */
 static void free_msg_handler (flux_msg_handler_t *mh)
 {
-    if (mh) {
+    if (mh && --mh->refcount <= 0) {
         int saved_errno = errno;
         assert (mh->magic == HANDLER_MAGIC);
         flux_match_free (mh->match);
@@ -487,15 +938,18 @@ void flux_msg_handler_destroy (flux_msg_handler_t *mh)
         assert (mh->magic == HANDLER_MAGIC);
         if (mh->match.typemask == FLUX_MSGTYPE_RESPONSE
                             && mh->match.matchtag != FLUX_MATCHTAG_NONE) {
-            zhashx_delete (mh->d->handlers_rpc, &mh->match.matchtag);
+            rpc_delete (mh->d, mh);
         }
         else if (mh->match.typemask == FLUX_MSGTYPE_REQUEST
                             && !isa_multmatch (mh->match.topic_glob)) {
-            zhashx_delete (mh->d->handlers_method, mh->match.topic_glob);
+            if (mh->topic)
+                zhashx_delete (mh->d->handlers_interned, mh->topic);
+            else
+                zhashx_delete (mh->d->handlers_method, mh->match.topic_glob);
         }
         else {
             zlist_remove (mh->d->handlers_new, mh);
-            zlist_remove (mh->d->handlers, mh);
+            handler_index_remove (mh);
         }
         flux_msg_handler_stop (mh);
         dispatch_usecount_decr (mh->d);
@@ -520,6 +974,7 @@ flux_msg_handler_t *flux_msg_handler_create (flux_t *h,
     if (!(mh = calloc (1, sizeof (*mh))))
         return NULL;
     mh->magic = HANDLER_MAGIC;
+    mh->refcount = 1;
     if (copy_match (&mh->match, match) < 0)
         goto error;
     mh->rolemask = FLUX_ROLE_OWNER;
@@ -527,23 +982,27 @@ flux_msg_handler_t *flux_msg_handler_create (flux_t *h,
     mh->arg = arg;
     mh->d = d;
     /* Response (valid matchtag):
-     * Fail if entry in the handlers_rpc hash exists, since that probably
+     * Fail if entry in the handlers_rpc table exists, since that probably
      * indicates a matchtag reuse problem!
      */
     if (mh->match.typemask == FLUX_MSGTYPE_RESPONSE
                             && mh->match.matchtag != FLUX_MATCHTAG_NONE) {
-        if (zhashx_insert (d->handlers_rpc, &mh->match.matchtag, mh) < 0) {
-            errno = EEXIST;
+        if (rpc_insert (d, mh) < 0)
             goto error;
-        }
     }
     /* Request (non-glob):
-     * Replace existing entry in the handlers_method hash, if any.
+     * Replace existing entry in the handlers_interned or
+     * handlers_method hash, if any.
      * This allows builtin module methods to be overridden.
      */
     else if (mh->match.typemask == FLUX_MSGTYPE_REQUEST
                             && !isa_multmatch (mh->match.topic_glob)) {
-        zhashx_update (d->handlers_method, mh->match.topic_glob, mh);
+        const char *topic = mh->match.topic_glob;
+
+        if ((mh->topic = flux_topic_intern (topic, strlen (topic))))
+            zhashx_update (d->handlers_interned, (void *)mh->topic, mh);
+        else
+            zhashx_update (d->handlers_method, mh->match.topic_glob, mh);
     }
     /* Request (glob), response (FLUX_MATCHTAG_NONE), events:
      * Message handler is pushed to the front of the handlers list,
@@ -552,8 +1011,8 @@ flux_msg_handler_t *flux_msg_handler_create (flux_t *h,
      * Event messages are broadcast to all matching handlers.
      */
     else {
-        /* N.B. append(handlers_new); later, pop(handlers_new), push(handlers).
-         * Net effect: push(handlers).
+        /* N.B. append(handlers_new); later, pop(handlers_new) and add
+         * to the index, in registration order.
          */
         if (zlist_append (d->handlers_new, mh) < 0) {
             errno = ENOMEM;
@@ -640,6 +1099,34 @@ int flux_dispatch_requeue (flux_t *h)
     return 0;
 }
 
+int flux_dispatch_get_expired (flux_t *h)
+{
+    struct dispatch *d;
+
+    if (!h) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!(d = flux_aux_get (h, "flux::dispatch")))
+        return 0;
+    return d->expired;
+}
+
+void flux_dispatch_clear_expired (flux_t *h)
+{
+    struct dispatch *d;
+
+    if (h && (d = flux_aux_get (h, "flux::dispatch")))
+        d->expired = 0;
+}
+
+uint64_t dispatch_get_trace (flux_t *h)
+{
+    struct dispatch *d = flux_aux_get (h, "flux::dispatch");
+
+    return d ? d->trace : 0;
+}
+
 /*
  * vi:tabstop=4 shiftwidth=4 expandtab
  */
@@ -13,6 +13,7 @@
 
 #include "message.h"
 #include "handle.h"
+#include "reactor.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -55,10 +56,27 @@ int flux_msg_handler_addvec (flux_t *h,
                              flux_msg_handler_t **msg_handlers[]);
 void flux_msg_handler_delvec (flux_msg_handler_t *msg_handlers[]);
 
+/* Call 'fn' for each topic of message 'type' (FLUX_MSGTYPE_REQUEST,
+ * _RESPONSE, or _EVENT) that was dispatched to a message handler while
+ * profiling was enabled on the handle's reactor.
+ * See flux_reactor_profile_enable().
+ */
+void flux_msg_handler_profile_foreach (flux_t *h,
+                                       int type,
+                                       flux_cbstats_f fn,
+                                       void *arg);
+void flux_msg_handler_profile_clear (flux_t *h);
+
 /* Requeue any unmatched messages, if handle was cloned.
  */
 int flux_dispatch_requeue (flux_t *h);
 
+/* Get/clear the number of requests the dispatcher dropped because their
+ * deadline had passed (see flux_msg_set_deadline()).
+ */
+int flux_dispatch_get_expired (flux_t *h);
+void flux_dispatch_clear_expired (flux_t *h);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,27 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _FLUX_CORE_MSG_HANDLER_PRIVATE_H
+#define _FLUX_CORE_MSG_HANDLER_PRIVATE_H
+
+#include <stdint.h>
+
+#include "handle.h"
+
+/* Return the trace id of the message being dispatched on 'h',
+ * or 0 if none, or if no message handler is running.
+ */
+uint64_t dispatch_get_trace (flux_t *h);
+
+#endif /* !_FLUX_CORE_MSG_HANDLER_PRIVATE_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
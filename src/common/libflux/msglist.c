@@ -0,0 +1,287 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* msglist.c - pending requests indexed by sender
+ *
+ * Each entry is linked into the list of all entries (arrival order) and
+ * into a per-sender list, and is found by item in a hash.  Removal is
+ * O(1) given the item, and a sender's entries are found without looking
+ * at anyone else's.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdint.h>
+#include <czmq.h>
+
+#include "message.h"
+#include "msglist.h"
+
+struct msglist_entry {
+    void *item;
+    const flux_msg_t *msg;
+    char *sender;               // "" if request has no route
+    uint32_t matchtag;
+    void *handle;               // in ml->items
+    void *sender_handle;        // in sender's list
+};
+
+struct flux_msglist {
+    zlistx_t *items;            // entries in order of arrival
+    zhashx_t *byitem;           // item => entry
+    zhashx_t *bysender;         // sender => zlistx_t of entries
+};
+
+static void entry_destroy (struct msglist_entry *entry)
+{
+    if (entry) {
+        int saved_errno = errno;
+        flux_msg_decref (entry->msg);
+        free (entry->sender);
+        free (entry);
+        errno = saved_errno;
+    }
+}
+
+/* Sender of request 'msg' (caller must free), or "" if it has no route.
+ */
+static char *get_sender (const flux_msg_t *msg)
+{
+    char *sender = NULL;
+
+    if (flux_msg_get_route_first (msg, &sender) < 0 && errno != EPROTO)
+        return NULL;
+    if (!sender && !(sender = strdup ("")))
+        errno = ENOMEM;
+    return sender;
+}
+
+/* Unlink 'entry' from the arrival order and sender lists.
+ * Safe to call on a partially linked entry.
+ */
+static void entry_unlink (struct flux_msglist *ml, struct msglist_entry *entry)
+{
+    if (entry->sender_handle) {
+        zlistx_t *l = zhashx_lookup (ml->bysender, entry->sender);
+        if (l) {
+            zlistx_delete (l, entry->sender_handle);
+            if (zlistx_size (l) == 0)
+                zhashx_delete (ml->bysender, entry->sender);
+        }
+        entry->sender_handle = NULL;
+    }
+    if (entry->handle) {
+        zlistx_delete (ml->items, entry->handle);
+        entry->handle = NULL;
+    }
+}
+
+int flux_msglist_append (struct flux_msglist *ml,
+                         const flux_msg_t *msg,
+                         void *item)
+{
+    struct msglist_entry *entry;
+    zlistx_t *l;
+
+    if (!ml || !msg || !item) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (zhashx_lookup (ml->byitem, item)) {
+        errno = EEXIST;
+        return -1;
+    }
+    if (!(entry = calloc (1, sizeof (*entry))))
+        return -1;
+    entry->item = item;
+    if (flux_msg_get_matchtag (msg, &entry->matchtag) < 0
+        || !(entry->sender = get_sender (msg)))
+        goto error;
+    if (!(l = zhashx_lookup (ml->bysender, entry->sender))) {
+        if (!(l = zlistx_new ()))
+            goto nomem;
+        if (zhashx_insert (ml->bysender, entry->sender, l) < 0) {
+            zlistx_destroy (&l);
+            goto nomem;
+        }
+    }
+    if (!(entry->sender_handle = zlistx_add_end (l, entry))
+        || !(entry->handle = zlistx_add_end (ml->items, entry))
+        || zhashx_insert (ml->byitem, item, entry) < 0)
+        goto nomem;
+    entry->msg = flux_msg_incref (msg);
+    return 0;
+nomem:
+    errno = ENOMEM;
+error:
+    entry_unlink (ml, entry);
+    entry_destroy (entry);
+    return -1;
+}
+
+int flux_msglist_remove (struct flux_msglist *ml, void *item)
+{
+    struct msglist_entry *entry;
+
+    if (!ml || !item) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!(entry = zhashx_lookup (ml->byitem, item))) {
+        errno = ENOENT;
+        return -1;
+    }
+    zhashx_delete (ml->byitem, item);
+    entry_unlink (ml, entry);
+    entry_destroy (entry);
+    return 0;
+}
+
+void *flux_msglist_pop_sender (struct flux_msglist *ml,
+                               const flux_msg_t *msg,
+                               uint32_t matchtag)
+{
+    struct msglist_entry *entry = NULL;
+    char *sender;
+    zlistx_t *l;
+    void *item = NULL;
+
+    if (!ml || !msg || !(sender = get_sender (msg)))
+        return NULL;
+    if ((l = zhashx_lookup (ml->bysender, sender))) {
+        entry = zlistx_first (l);
+        while (entry) {
+            if (matchtag == FLUX_MATCHTAG_NONE || entry->matchtag == matchtag)
+                break;
+            entry = zlistx_next (l);
+        }
+    }
+    if (entry) {
+        item = entry->item;
+        (void)flux_msglist_remove (ml, item);
+    }
+    free (sender);
+    return item;
+}
+
+void *flux_msglist_pop (struct flux_msglist *ml)
+{
+    struct msglist_entry *entry;
+    void *item;
+
+    if (!ml || !(entry = zlistx_first (ml->items)))
+        return NULL;
+    item = entry->item;
+    (void)flux_msglist_remove (ml, item);
+    return item;
+}
+
+void *flux_msglist_first (struct flux_msglist *ml)
+{
+    struct msglist_entry *entry;
+
+    if (!ml || !(entry = zlistx_first (ml->items)))
+        return NULL;
+    return entry->item;
+}
+
+void *flux_msglist_next (struct flux_msglist *ml)
+{
+    struct msglist_entry *entry;
+
+    if (!ml || !(entry = zlistx_next (ml->items)))
+        return NULL;
+    return entry->item;
+}
+
+void *flux_msglist_last (struct flux_msglist *ml)
+{
+    struct msglist_entry *entry;
+
+    if (!ml || !(entry = zlistx_last (ml->items)))
+        return NULL;
+    return entry->item;
+}
+
+int flux_msglist_count (struct flux_msglist *ml)
+{
+    if (!ml) {
+        errno = EINVAL;
+        return -1;
+    }
+    return zlistx_size (ml->items);
+}
+
+// zhashx_hash_fn footprint - item pointer is the key
+static size_t item_hasher (const void *key)
+{
+    return (uintptr_t)key;
+}
+
+// zhashx_comparator_fn footprint
+static int item_cmp (const void *key1, const void *key2)
+{
+    if (key1 == key2)
+        return 0;
+    return key1 < key2 ? -1 : 1;
+}
+
+// zhashx_destructor_fn footprint
+static void sender_list_destructor (void **item)
+{
+    if (item) {
+        zlistx_t *l = *item;
+        zlistx_destroy (&l);
+        *item = NULL;
+    }
+}
+
+void flux_msglist_destroy (struct flux_msglist *ml)
+{
+    if (ml) {
+        int saved_errno = errno;
+        if (ml->items && ml->byitem) {
+            while (flux_msglist_pop (ml))
+                ;
+        }
+        zhashx_destroy (&ml->byitem);
+        zhashx_destroy (&ml->bysender);
+        zlistx_destroy (&ml->items);
+        free (ml);
+        errno = saved_errno;
+    }
+}
+
+struct flux_msglist *flux_msglist_create (void)
+{
+    struct flux_msglist *ml;
+
+    if (!(ml = calloc (1, sizeof (*ml))))
+        return NULL;
+    if (!(ml->items = zlistx_new ())
+        || !(ml->byitem = zhashx_new ())
+        || !(ml->bysender = zhashx_new ()))
+        goto nomem;
+    zhashx_set_key_hasher (ml->byitem, item_hasher);
+    zhashx_set_key_comparator (ml->byitem, item_cmp);
+    zhashx_set_key_duplicator (ml->byitem, NULL);
+    zhashx_set_key_destructor (ml->byitem, NULL);
+    zhashx_set_destructor (ml->bysender, sender_list_destructor);
+    return ml;
+nomem:
+    flux_msglist_destroy (ml);
+    errno = ENOMEM;
+    return NULL;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
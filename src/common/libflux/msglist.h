@@ -0,0 +1,82 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _FLUX_CORE_MSGLIST_H
+#define _FLUX_CORE_MSGLIST_H
+
+#include "message.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* flux_msglist - pending requests indexed by sender
+ *
+ * A service that holds requests (e.g. streaming or sleeping requests)
+ * appends an item for each to a flux_msglist, along with the request
+ * message.  The item is typically the service's own watcher structure,
+ * or the message itself.  Items are kept in order of arrival, and are also
+ * indexed by the sender and matchtag of their request, so that cancel and
+ * disconnect requests find the affected items in O(k) for k items from
+ * that sender, rather than by scanning all pending requests.
+ *
+ * The list takes a reference on each message but does not own the items.
+ */
+
+struct flux_msglist;
+
+struct flux_msglist *flux_msglist_create (void);
+void flux_msglist_destroy (struct flux_msglist *ml);
+
+/* Append 'item', indexed by the sender and matchtag of request 'msg'.
+ * An item may be in the list only once (EEXIST).
+ */
+int flux_msglist_append (struct flux_msglist *ml,
+                         const flux_msg_t *msg,
+                         void *item);
+
+/* Remove 'item' from the list.  Fails with ENOENT if it is not present.
+ * It is safe to remove the current item while iterating.
+ */
+int flux_msglist_remove (struct flux_msglist *ml, void *item);
+
+/* Remove and return the oldest item whose request came from the same sender
+ * as 'msg', e.g. a cancel or disconnect request.  If 'matchtag' is not
+ * FLUX_MATCHTAG_NONE, the item's request must also have that matchtag.
+ * Returns NULL if there is no such item.
+ */
+void *flux_msglist_pop_sender (struct flux_msglist *ml,
+                               const flux_msg_t *msg,
+                               uint32_t matchtag);
+
+/* Remove and return the oldest item, or NULL if the list is empty.
+ */
+void *flux_msglist_pop (struct flux_msglist *ml);
+
+/* Iterate over items in order of arrival.
+ */
+void *flux_msglist_first (struct flux_msglist *ml);
+void *flux_msglist_next (struct flux_msglist *ml);
+
+/* Return the most recently appended item, or NULL if the list is empty.
+ */
+void *flux_msglist_last (struct flux_msglist *ml);
+
+int flux_msglist_count (struct flux_msglist *ml);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* !_FLUX_CORE_MSGLIST_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -32,6 +32,7 @@ struct flux_plugin {
     struct aux_item *aux;
     void *dso;
     zlistx_t *handlers;
+    int handler_gen;
     char last_error [128];
 };
 
@@ -253,6 +254,7 @@ int flux_plugin_remove_handler (flux_plugin_t *p,
     if (find_handler (p, topic)) {
         if (zlistx_delete (p->handlers, zlistx_cursor (p->handlers)) < 0)
             return plugin_seterror (p, errno, NULL);
+        p->handler_gen++;
     }
     return 0;
 }
@@ -303,10 +305,18 @@ int flux_plugin_add_handler (flux_plugin_t *p,
         flux_plugin_handler_destroy (h);
         return plugin_seterror (p, errno, NULL);
     }
+    p->handler_gen++;
 
     return 0;
 }
 
+int flux_plugin_get_handler_generation (flux_plugin_t *p)
+{
+    if (!p)
+        return plugin_seterror (p, EINVAL, NULL);
+    return p->handler_gen;
+}
+
 int flux_plugin_register (flux_plugin_t *p,
                           const char *name,
                           const struct flux_plugin_handler t[])
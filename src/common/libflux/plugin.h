@@ -72,6 +72,12 @@ flux_plugin_f flux_plugin_get_handler (flux_plugin_t *p, const char *topic);
  */
 flux_plugin_f flux_plugin_match_handler (flux_plugin_t *p, const char *topic);
 
+/*  Return a counter which is incremented each time a handler is added
+ *   to or removed from plugin 'p'. Callers which cache the results of
+ *   handler lookups may use this to detect that the cache is stale.
+ */
+int flux_plugin_get_handler_generation (flux_plugin_t *p);
+
 /*  Convenience function to register a table of handlers along with
  *   a plugin name for the plugin 'p'.
  */
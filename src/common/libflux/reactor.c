@@ -15,6 +15,7 @@
 #include <string.h>
 #include <errno.h>
 #include <stdbool.h>
+#include <time.h>
 #include <czmq.h>
 
 #include "handle.h"
@@ -24,16 +25,68 @@
 #include "ev_buffer_write.h"
 #include "buffer.h"
 #include "buffer_private.h"
+#include "cbstats.h"
 
 #include "src/common/libev/ev.h"
 #include "src/common/libutil/ev_zmq.h"
 #include "src/common/libutil/log.h"
 #include "src/common/libutil/fdutils.h"
+#include "src/common/libutil/timerwheel.h"
+
+/* Coarse timers are serviced by a timer wheel with this resolution,
+ * driven by a single libev timer.
+ */
+#define COARSE_TICK 0.01
+
+/* Watcher types for callback profiling.
+ */
+enum {
+    WATCHER_HANDLE = 0,
+    WATCHER_FD,
+    WATCHER_BUFFER_READ,
+    WATCHER_BUFFER_WRITE,
+    WATCHER_ZMQ,
+    WATCHER_TIMER,
+    WATCHER_COARSE_TIMER,
+    WATCHER_PERIODIC,
+    WATCHER_PREPARE,
+    WATCHER_CHECK,
+    WATCHER_IDLE,
+    WATCHER_CHILD,
+    WATCHER_SIGNAL,
+    WATCHER_STAT,
+    WATCHER_TYPE_COUNT,
+};
+
+static const char *watcher_type_names[] = {
+    "handle",
+    "fd",
+    "buffer_read",
+    "buffer_write",
+    "zmq",
+    "timer",
+    "coarse_timer",
+    "periodic",
+    "prepare",
+    "check",
+    "idle",
+    "child",
+    "signal",
+    "stat",
+};
 
 struct flux_reactor {
     struct ev_loop *loop;
     int usecount;
     unsigned int errflag:1;
+
+    struct timerwheel *wheel;   // created with first coarse timer
+    ev_timer wheel_w;
+    uint64_t wheel_armed;       // tick wheel_w is set to expire at
+    flux_reactor_stats_t stats;
+
+    bool profile;
+    flux_cbstats_t cbstats[WATCHER_TYPE_COUNT];
 };
 
 struct flux_watcher {
@@ -49,11 +102,14 @@ static void reactor_usecount_decr (flux_reactor_t *r)
     if (r && --r->usecount == 0) {
         int saved_errno = errno;
         if (r->loop) {
+            if (r->wheel)
+                ev_timer_stop (r->loop, &r->wheel_w);
             if (ev_is_default_loop (r->loop))
                 ev_default_destroy ();
             else
                 ev_loop_destroy (r->loop);
         }
+        timerwheel_destroy (r->wheel);
         free (r);
         errno = saved_errno;
     }
@@ -154,6 +210,43 @@ void flux_reactor_stop_error (flux_reactor_t *r)
     ev_break (r->loop, EVBREAK_ALL);
 }
 
+void flux_reactor_get_stats (flux_reactor_t *r, flux_reactor_stats_t *stats)
+{
+    if (r && stats) {
+        *stats = r->stats;
+        stats->coarse_timers = timerwheel_count (r->wheel);
+    }
+}
+
+void flux_reactor_profile_enable (flux_reactor_t *r, bool enable)
+{
+    if (r)
+        r->profile = enable;
+}
+
+bool flux_reactor_profile_enabled (flux_reactor_t *r)
+{
+    return r ? r->profile : false;
+}
+
+void flux_reactor_profile_foreach (flux_reactor_t *r,
+                                   flux_cbstats_f fn,
+                                   void *arg)
+{
+    if (r && fn) {
+        for (int i = 0; i < WATCHER_TYPE_COUNT; i++) {
+            if (r->cbstats[i].count > 0)
+                fn (watcher_type_names[i], &r->cbstats[i], arg);
+        }
+    }
+}
+
+void flux_reactor_profile_clear (flux_reactor_t *r)
+{
+    if (r)
+        memset (r->cbstats, 0, sizeof (r->cbstats));
+}
+
 void flux_reactor_active_incref (flux_reactor_t *r)
 {
     if (r)
@@ -194,6 +287,25 @@ static int libev_to_events (int events)
  ** Watchers
  **/
 
+/* Call the watcher's callback, timing it if profiling is enabled.
+ * The callback may destroy the watcher.
+ */
+static void watcher_call (flux_watcher_t *w, int revents, int type)
+{
+    flux_reactor_t *r = w->r;
+
+    if (!w->fn)
+        return;
+    if (r->profile) {
+        struct timespec t0;
+        cbstats_start (&t0);
+        w->fn (r, w, revents, w->arg);
+        cbstats_record (&r->cbstats[type], &t0);
+    }
+    else
+        w->fn (r, w, revents, w->arg);
+}
+
 flux_watcher_t *flux_watcher_create (flux_reactor_t *r,
                                      size_t data_size,
                                      struct flux_watcher_ops *ops,
@@ -295,8 +407,7 @@ static void handle_stop (flux_watcher_t *w)
 static void handle_cb (struct ev_loop *loop, struct ev_flux *fw, int revents)
 {
     struct flux_watcher *w = fw->data;
-    if (w->fn)
-        w->fn (ev_userdata (loop), w, libev_to_events (revents), w->arg);
+    watcher_call (w, libev_to_events (revents), WATCHER_HANDLE);
 }
 
 static struct flux_watcher_ops handle_watcher = {
@@ -343,8 +454,7 @@ static void fd_stop (flux_watcher_t *w)
 static void fd_cb (struct ev_loop *loop, ev_io *iow, int revents)
 {
     struct flux_watcher *w = iow->data;
-    if (w->fn)
-        w->fn (ev_userdata (loop), w, libev_to_events (revents), w->arg);
+    watcher_call (w, libev_to_events (revents), WATCHER_FD);
 }
 
 static struct flux_watcher_ops fd_watcher = {
@@ -401,8 +511,7 @@ static void buffer_read_cb (struct ev_loop *loop,
                             int revents)
 {
     struct flux_watcher *w = ebr->data;
-    if (w->fn)
-        w->fn (ev_userdata (loop), w, libev_to_events (revents), w->arg);
+    watcher_call (w, libev_to_events (revents), WATCHER_BUFFER_READ);
 }
 
 static struct flux_watcher_ops buffer_read_watcher = {
@@ -488,8 +597,7 @@ static void buffer_write_cb (struct ev_loop *loop,
                              int revents)
 {
     struct flux_watcher *w = ebw->data;
-    if (w->fn)
-        w->fn (ev_userdata (loop), w, libev_to_events (revents), w->arg);
+    watcher_call (w, libev_to_events (revents), WATCHER_BUFFER_WRITE);
 }
 
 static struct flux_watcher_ops buffer_write_watcher = {
@@ -599,8 +707,7 @@ static void zmq_stop (flux_watcher_t *w)
 static void zmq_cb (struct ev_loop *loop, ev_zmq *pw, int revents)
 {
     struct flux_watcher *w = pw->data;
-    if (w->fn)
-        w->fn (ev_userdata (loop), w, libev_to_events (revents), w->arg);
+    watcher_call (w, libev_to_events (revents), WATCHER_ZMQ);
 }
 
 static struct flux_watcher_ops zmq_watcher  = {
@@ -637,22 +744,40 @@ void *flux_zmq_watcher_get_zsock (flux_watcher_t *w)
 
 /* Timer
  */
+struct f_timer {
+    ev_timer evt;           // must be first, w->data is used as ev_timer
+    bool counted;           // included in reactor stats.timers
+};
+
+static void timer_count (flux_watcher_t *w, bool active)
+{
+    struct f_timer *ft = w->data;
+    if (ft->counted != active) {
+        ft->counted = active;
+        w->r->stats.timers += active ? 1 : -1;
+    }
+}
 
 static void timer_start (flux_watcher_t *w)
 {
     ev_timer_start (w->r->loop, (ev_timer *)w->data);
+    timer_count (w, true);
 }
 
 static void timer_stop (flux_watcher_t *w)
 {
     ev_timer_stop (w->r->loop, (ev_timer *)w->data);
+    timer_count (w, false);
 }
 
 static void timer_cb (struct ev_loop *loop, ev_timer *tw, int revents)
 {
     struct flux_watcher *w = tw->data;
-    if (w->fn)
-        w->fn (ev_userdata (loop), w, libev_to_events (revents), w->arg);
+    /* libev stops a oneshot timer before its callback is invoked.
+     */
+    if (!ev_is_active (tw))
+        timer_count (w, false);
+    watcher_call (w, libev_to_events (revents), WATCHER_TIMER);
 }
 
 static struct flux_watcher_ops timer_watcher = {
@@ -665,23 +790,158 @@ flux_watcher_t *flux_timer_watcher_create (flux_reactor_t *r,
                                            double after, double repeat,
                                            flux_watcher_f cb, void *arg)
 {
-    ev_timer *tw;
+    struct f_timer *ft;
+    flux_watcher_t *w;
+    if (after < 0 || repeat < 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(w = flux_watcher_create (r, sizeof (*ft), &timer_watcher, cb, arg)))
+        return NULL;
+    ft = flux_watcher_get_data (w);
+    ev_timer_init (&ft->evt, timer_cb, after, repeat);
+    ft->evt.data = w;
+
+    return w;
+}
+
+/* Coarse timer
+ */
+struct f_coarse {
+    struct timerwheel_entry e;  // must be first
+    flux_watcher_t *w;
+    double after;
+    double repeat;
+    double at;                  // CLOCK_MONOTONIC expiration time
+};
+
+static double coarse_now (void)
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + 1E-9 * ts.tv_nsec;
+}
+
+/* Round up so that a coarse timer never fires early.
+ */
+static uint64_t coarse_tick (double t)
+{
+    double ticks = t / COARSE_TICK;
+    uint64_t n = (uint64_t)ticks;
+    return n < ticks ? n + 1 : n;
+}
+
+/* (Re-)arm the wheel's libev timer for the next tick the wheel has work
+ * to do, or stop it if the wheel is empty.  It is not rearmed when an
+ * entry is removed, so it may fire with nothing to do.
+ */
+static void wheel_arm (flux_reactor_t *r)
+{
+    uint64_t next;
+    double delay;
+
+    if (timerwheel_next (r->wheel, &next) < 0) {
+        ev_timer_stop (r->loop, &r->wheel_w);
+        return;
+    }
+    if (ev_is_active (&r->wheel_w) && r->wheel_armed == next)
+        return;
+    delay = next * COARSE_TICK - coarse_now ();
+    ev_timer_stop (r->loop, &r->wheel_w);
+    ev_timer_set (&r->wheel_w, delay > 0 ? delay : 0, 0);
+    ev_timer_start (r->loop, &r->wheel_w);
+    r->wheel_armed = next;
+}
+
+static void coarse_expire (struct timerwheel_entry *e, void *arg)
+{
+    flux_reactor_t *r = arg;
+    struct f_coarse *fc = (struct f_coarse *)e;
+    flux_watcher_t *w = fc->w;
+
+    if (fc->repeat > 0) {
+        double now = coarse_now ();
+        fc->at += fc->repeat;
+        if (fc->at < now)
+            fc->at = now;
+        timerwheel_add (r->wheel, &fc->e, coarse_tick (fc->at));
+    }
+    watcher_call (w, 0, WATCHER_COARSE_TIMER);
+}
+
+static void wheel_cb (struct ev_loop *loop, ev_timer *tw, int revents)
+{
+    flux_reactor_t *r = ev_userdata (loop);
+
+    r->stats.coarse_wakeups++;
+    timerwheel_run (r->wheel,
+                    (uint64_t)(coarse_now () / COARSE_TICK),
+                    coarse_expire,
+                    r);
+    wheel_arm (r);
+}
+
+static void coarse_start (flux_watcher_t *w)
+{
+    struct f_coarse *fc = w->data;
+
+    if (timerwheel_entry_active (&fc->e))
+        return;
+    fc->at = coarse_now () + fc->after;
+    timerwheel_add (w->r->wheel, &fc->e, coarse_tick (fc->at));
+    wheel_arm (w->r);
+}
+
+static void coarse_stop (flux_watcher_t *w)
+{
+    struct f_coarse *fc = w->data;
+
+    timerwheel_remove (w->r->wheel, &fc->e);
+    if (timerwheel_count (w->r->wheel) == 0)
+        ev_timer_stop (w->r->loop, &w->r->wheel_w);
+}
+
+static struct flux_watcher_ops coarse_watcher = {
+    .start = coarse_start,
+    .stop = coarse_stop,
+    .destroy = NULL,
+};
+
+flux_watcher_t *flux_coarse_timer_watcher_create (flux_reactor_t *r,
+                                                  double after, double repeat,
+                                                  flux_watcher_f cb, void *arg)
+{
+    struct f_coarse *fc;
     flux_watcher_t *w;
     if (after < 0 || repeat < 0) {
         errno = EINVAL;
         return NULL;
     }
-    if (!(w = flux_watcher_create (r, sizeof (*tw), &timer_watcher, cb, arg)))
+    if (!r->wheel) {
+        if (!(r->wheel = timerwheel_create (coarse_tick (coarse_now ())))) {
+            errno = ENOMEM;
+            return NULL;
+        }
+        ev_timer_init (&r->wheel_w, wheel_cb, 0, 0);
+    }
+    if (!(w = flux_watcher_create (r, sizeof (*fc), &coarse_watcher, cb, arg)))
         return NULL;
-    tw = flux_watcher_get_data (w);
-    ev_timer_init (tw, timer_cb, after, repeat);
-    tw->data = w;
+    fc = flux_watcher_get_data (w);
+    fc->w = w;
+    fc->after = after;
+    fc->repeat = repeat;
 
     return w;
 }
 
 void flux_timer_watcher_reset (flux_watcher_t *w, double after, double repeat)
 {
+    if (flux_watcher_get_ops (w) == &coarse_watcher) {
+        struct f_coarse *fc = w->data;
+        fc->after = after;
+        fc->repeat = repeat;
+        return;
+    }
     assert (flux_watcher_get_ops (w) == &timer_watcher);
     ev_timer *tw = w->data;
     ev_timer_set (tw, after, repeat);
@@ -711,8 +971,7 @@ static void periodic_cb (struct ev_loop *loop, ev_periodic *pw, int revents)
 {
     struct f_periodic *fp = pw->data;
     struct flux_watcher *w = fp->w;
-    if (w->fn)
-        fp->w->fn (ev_userdata (loop), w, libev_to_events (revents), w->arg);
+    watcher_call (w, libev_to_events (revents), WATCHER_PERIODIC);
 }
 
 static ev_tstamp periodic_reschedule_cb (ev_periodic *pw, ev_tstamp now)
@@ -789,6 +1048,13 @@ double flux_watcher_next_wakeup (flux_watcher_t *w)
         struct ev_loop *loop = w->r->loop;
         return ((double) (ev_now (loop) +  ev_timer_remaining (loop, tw)));
     }
+    else if (flux_watcher_get_ops (w) == &coarse_watcher) {
+        struct f_coarse *fc = w->data;
+        struct ev_loop *loop = w->r->loop;
+        if (timerwheel_entry_active (&fc->e))
+            return ev_now (loop) + (fc->at - coarse_now ());
+        return ev_now (loop) + fc->after;
+    }
     errno = EINVAL;
     return  (-1.);
 }
@@ -808,8 +1074,7 @@ static void prepare_stop (flux_watcher_t *w)
 static void prepare_cb (struct ev_loop *loop, ev_prepare *pw, int revents)
 {
     struct flux_watcher *w = pw->data;
-    if (w->fn)
-        w->fn (ev_userdata (loop), w, libev_to_events (revents), w->arg);
+    watcher_call (w, libev_to_events (revents), WATCHER_PREPARE);
 }
 
 static struct flux_watcher_ops prepare_watcher = {
@@ -849,8 +1114,7 @@ static void check_stop (flux_watcher_t *w)
 static void check_cb (struct ev_loop *loop, ev_check *cw, int revents)
 {
     struct flux_watcher *w = cw->data;
-    if (w->fn)
-        w->fn (ev_userdata (loop), w, libev_to_events (revents), w->arg);
+    watcher_call (w, libev_to_events (revents), WATCHER_CHECK);
 }
 
 static struct flux_watcher_ops check_watcher = {
@@ -890,8 +1154,7 @@ static void idle_stop (flux_watcher_t *w)
 static void idle_cb (struct ev_loop *loop, ev_idle *iw, int revents)
 {
     struct flux_watcher *w = iw->data;
-    if (w->fn)
-        w->fn (ev_userdata (loop), w, libev_to_events (revents), w->arg);
+    watcher_call (w, libev_to_events (revents), WATCHER_IDLE);
 }
 
 static struct flux_watcher_ops idle_watcher = {
@@ -931,8 +1194,7 @@ static void child_stop (flux_watcher_t *w)
 static void child_cb (struct ev_loop *loop, ev_child *cw, int revents)
 {
     struct flux_watcher *w = cw->data;
-    if (w->fn)
-        w->fn (ev_userdata (loop), w, libev_to_events (revents), w->arg);
+    watcher_call (w, libev_to_events (revents), WATCHER_CHILD);
 }
 
 static struct flux_watcher_ops child_watcher = {
@@ -998,8 +1260,7 @@ static void signal_stop (flux_watcher_t *w)
 static void signal_cb (struct ev_loop *loop, ev_signal *sw, int revents)
 {
     struct flux_watcher *w = sw->data;
-    if (w->fn)
-        w->fn (ev_userdata (loop), w, libev_to_events (revents), w->arg);
+    watcher_call (w, libev_to_events (revents), WATCHER_SIGNAL);
 }
 
 static struct flux_watcher_ops signal_watcher = {
@@ -1049,8 +1310,7 @@ static void stat_stop (flux_watcher_t *w)
 static void stat_cb (struct ev_loop *loop, ev_stat *sw, int revents)
 {
     struct flux_watcher *w = sw->data;
-    if (w->fn)
-        w->fn (ev_userdata (loop), w, libev_to_events (revents), w->arg);
+    watcher_call (w, libev_to_events (revents), WATCHER_STAT);
 }
 
 static struct flux_watcher_ops stat_watcher = {
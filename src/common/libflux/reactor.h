@@ -14,6 +14,7 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 #include "handle.h"
 #include "buffer.h"
@@ -69,6 +70,46 @@ double flux_reactor_time (void);
 void flux_reactor_active_incref (flux_reactor_t *r);
 void flux_reactor_active_decref (flux_reactor_t *r);
 
+/* Get reactor statistics.
+ */
+typedef struct {
+    int timers;                 /* active timer watchers */
+    int coarse_timers;          /* active coarse timer watchers */
+    uint64_t coarse_wakeups;    /* times the coarse timer wheel was serviced */
+} flux_reactor_stats_t;
+
+void flux_reactor_get_stats (flux_reactor_t *r, flux_reactor_stats_t *stats);
+
+/* Callback profiling.
+ * When enabled, the duration of each watcher callback is recorded by
+ * watcher type.  Message handler callbacks are recorded separately by
+ * message type and topic (see flux_msg_handler_profile_foreach()).
+ * Watcher durations include any message handler callbacks they run.
+ */
+#define FLUX_CBSTATS_BUCKETS 24
+
+typedef struct {
+    int count;                      /* number of calls */
+    double total;                   /* cumulative duration (seconds) */
+    double max;                     /* longest duration (seconds) */
+    int hist[FLUX_CBSTATS_BUCKETS]; /* log2 histogram: hist[0] < 1us, */
+                                    /* hist[i] < 2^i us, last is unbounded */
+} flux_cbstats_t;
+
+typedef void (*flux_cbstats_f)(const char *name,
+                               const flux_cbstats_t *stats,
+                               void *arg);
+
+void flux_reactor_profile_enable (flux_reactor_t *r, bool enable);
+bool flux_reactor_profile_enabled (flux_reactor_t *r);
+
+/* Call 'fn' for each watcher type that has been called since profiling
+ * was enabled or last cleared.
+ */
+void flux_reactor_profile_foreach (flux_reactor_t *r,
+                                   flux_cbstats_f fn,
+                                   void *arg);
+void flux_reactor_profile_clear (flux_reactor_t *r);
 
 /* Watchers
  */
@@ -147,6 +188,18 @@ flux_watcher_t *flux_timer_watcher_create (flux_reactor_t *r,
 
 void flux_timer_watcher_reset (flux_watcher_t *w, double after, double repeat);
 
+/* coarse timer
+ * Like a timer, but kept in a timer wheel with 10ms resolution, so start
+ * and stop are O(1) regardless of the number of active timers.  It never
+ * fires early, but may fire up to one tick late.  Intended for timeouts
+ * that are usually stopped before they expire.  'after' is relative to
+ * the time the watcher is started.  flux_timer_watcher_reset() and
+ * flux_watcher_next_wakeup() may be used with coarse timer watchers.
+ */
+flux_watcher_t *flux_coarse_timer_watcher_create (flux_reactor_t *r,
+                                                  double after, double repeat,
+                                                  flux_watcher_f cb, void *arg);
+
 /* periodic
  */
 
@@ -30,7 +30,9 @@
 #include "rpc.h"
 #include "reactor.h"
 #include "msg_handler.h"
+#include "msg_handler_private.h"
 #include "flog.h"
+#include "trace.h"
 
 struct flux_rpc {
     uint32_t matchtag;
@@ -238,6 +240,8 @@ static flux_future_t *flux_rpc_message_nocopy (flux_t *h,
     struct flux_rpc *rpc = NULL;
     flux_future_t *f;
     uint8_t msgflags;
+    double *timeout;
+    uint64_t trace;
 
     if (!(f = flux_future_create (initialize_cb, NULL)))
         goto error;
@@ -265,6 +269,22 @@ static flux_future_t *flux_rpc_message_nocopy (flux_t *h,
         goto error;
     if (flux_msg_set_nodeid (msg, nodeid) < 0)
         goto error;
+    if ((timeout = flux_aux_get (h, "flux::rpc_timeout"))
+        && flux_msg_get_deadline (msg, NULL) < 0
+        && flux_msg_set_deadline (msg, *timeout) < 0)
+        goto error;
+    /* Unless the caller set a trace context, join the trace of the request
+     * being handled, or start one if requested with FLUX_O_RPCTRACE.
+     */
+    if (flux_msg_get_trace (msg, NULL, NULL) < 0) {
+        if (!(trace = dispatch_get_trace (h))
+            && (flux_flags_get (h) & FLUX_O_RPCTRACE))
+            trace = flux_trace_id_create ();
+        if (trace && flux_msg_set_trace (msg,
+                                         trace,
+                                         flux_trace_id_create ()) < 0)
+            goto error;
+    }
 #if HAVE_CALIPER
     cali_begin_string_byname ("flux.message.rpc", "single");
     cali_begin_int_byname ("flux.message.rpc.nodeid", nodeid);
@@ -290,6 +310,28 @@ error:
     return NULL;
 }
 
+int flux_rpc_set_timeout (flux_t *h, double timeout)
+{
+    double *p;
+
+    if (!h) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (timeout < 0) {
+        flux_aux_set (h, "flux::rpc_timeout", NULL, NULL);
+        return 0;
+    }
+    if (!(p = malloc (sizeof (*p))))
+        return -1;
+    *p = timeout;
+    if (flux_aux_set (h, "flux::rpc_timeout", p, free) < 0) {
+        free (p);
+        return -1;
+    }
+    return 0;
+}
+
 static int validate_flags (int flags, int allowed)
 {
     if ((flags & allowed) != flags) {
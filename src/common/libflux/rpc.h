@@ -48,6 +48,15 @@ int flux_rpc_get_unpack (flux_future_t *f, const char *fmt, ...);
 
 int flux_rpc_get_raw (flux_future_t *f, const void **data, int *len);
 
+/* Give each request sent with flux_rpc*() on 'h' a deadline 'timeout'
+ * seconds after it is sent, unless it already has one (see
+ * flux_msg_set_deadline()).  Pair this with the timeout passed to
+ * flux_future_then() or flux_future_wait_for(), so that services drop
+ * requests the caller has stopped waiting for.  A negative 'timeout'
+ * restores the default of no deadline.
+ */
+int flux_rpc_set_timeout (flux_t *h, double timeout);
+
 /* Accessor for RPC matchtag (see RFC 6).
  */
 uint32_t flux_rpc_get_matchtag (flux_future_t *f);
@@ -13,6 +13,12 @@
 /* Matchtags are used to match requests and responses in RPC's.
  *
  * Requests that receive no response use FLUX_MATCHTAG_NONE (0).
+ *
+ * Free tags are tracked in a bitmap (1 = free) with a summary bitmap
+ * on top (1 = word has a free tag), so allocation finds the lowest free
+ * tag with two count-trailing-zeros operations.  'hint' caches the first
+ * summary word that may have a free tag, so a run of allocations does not
+ * rescan the full words below it.
  */
 
 #if HAVE_CONFIG_H
@@ -27,31 +33,76 @@
 #include "tagpool.h"
 #include "message.h"
 
-#include "src/common/libutil/veb.h"
 #include "src/common/libutil/log.h"
 
 #define TAGPOOL_COUNT (1UL<<20)
 #define TAGPOOL_START (1UL<<10)
 
+#define BITS_PER_WORD   64
+#define WORDS(n)        (((n) + BITS_PER_WORD - 1) / BITS_PER_WORD)
+
 #define TAGPOOL_MAGIC   0x34447ff2
 struct tagpool {
     int             magic;
-    Veb             veb;
+    uint64_t        *bits;      // 1 bit per tag, set if free
+    uint64_t        *summary;   // 1 bit per bits[] word, set if nonzero
+    uint32_t        size;       // number of tags in bits[]
+    uint32_t        hint;       // summary[] words below this are zero
     int             avail;
     tagpool_grow_f  grow_cb;
     void            *grow_arg;
     int             grow_depth;
 };
 
-static void pool_set (Veb veb, uint32_t from, uint32_t to, uint8_t value)
+static void pool_set_free (struct tagpool *t, uint32_t tag)
 {
-    while (from < to) {
-        if (value)
-            vebput (veb, from);
-        else
-            vebdel (veb, from);
-        from++;
-    }
+    uint32_t w = tag / BITS_PER_WORD;
+
+    t->bits[w] |= 1ULL << (tag % BITS_PER_WORD);
+    t->summary[w / BITS_PER_WORD] |= 1ULL << (w % BITS_PER_WORD);
+}
+
+static void pool_clr_free (struct tagpool *t, uint32_t tag)
+{
+    uint32_t w = tag / BITS_PER_WORD;
+
+    t->bits[w] &= ~(1ULL << (tag % BITS_PER_WORD));
+    if (t->bits[w] == 0)
+        t->summary[w / BITS_PER_WORD] &= ~(1ULL << (w % BITS_PER_WORD));
+}
+
+static bool pool_is_free (struct tagpool *t, uint32_t tag)
+{
+    return t->bits[tag / BITS_PER_WORD] & (1ULL << (tag % BITS_PER_WORD));
+}
+
+/* Resize the pool to 'newsize' tags, marking the new tags free.
+ * 'newsize' is a multiple of BITS_PER_WORD.
+ */
+static int pool_resize (struct tagpool *t, uint32_t newsize)
+{
+    uint32_t oldwords = WORDS (t->size);
+    uint32_t newwords = WORDS (newsize);
+    uint64_t *bits;
+    uint64_t *summary;
+
+    if (!(bits = realloc (t->bits, newwords * sizeof (bits[0]))))
+        return -1;
+    t->bits = bits;
+    if (!(summary = realloc (t->summary,
+                             WORDS (newwords) * sizeof (summary[0]))))
+        return -1;
+    t->summary = summary;
+    memset (&t->bits[oldwords], 0xff,
+            (newwords - oldwords) * sizeof (bits[0]));
+    memset (&t->summary[WORDS (oldwords)], 0,
+            (WORDS (newwords) - WORDS (oldwords)) * sizeof (summary[0]));
+    for (uint32_t w = oldwords; w < newwords; w++)
+        t->summary[w / BITS_PER_WORD] |= 1ULL << (w % BITS_PER_WORD);
+    if (t->hint > oldwords / BITS_PER_WORD)
+        t->hint = oldwords / BITS_PER_WORD;
+    t->size = newsize;
+    return 0;
 }
 
 struct tagpool *tagpool_create (void)
@@ -60,10 +111,9 @@ struct tagpool *tagpool_create (void)
     if (!t)
         goto nomem;
     t->magic = TAGPOOL_MAGIC;
-    t->veb = vebnew (TAGPOOL_START, 1);
-    if (!t->veb.D)
+    if (pool_resize (t, TAGPOOL_START) < 0)
         goto nomem;
-    vebdel (t->veb, FLUX_MATCHTAG_NONE); /* allocate reserved value */
+    pool_clr_free (t, FLUX_MATCHTAG_NONE); /* allocate reserved value */
     t->avail = TAGPOOL_COUNT - 1;
     return t;
 nomem:
@@ -76,7 +126,8 @@ void tagpool_destroy (struct tagpool *t)
 {
     if (t) {
         assert (t->magic == TAGPOOL_MAGIC);
-        free (t->veb.D);
+        free (t->bits);
+        free (t->summary);
         t->magic = ~TAGPOOL_MAGIC;
         free (t);
     }
@@ -88,33 +139,23 @@ void tagpool_set_grow_cb (struct tagpool *t, tagpool_grow_f cb, void *arg)
     t->grow_arg = arg;
 }
 
-static uint32_t alloc_with_resize (struct tagpool *t)
+/* Find and claim the lowest free tag, or return FLUX_MATCHTAG_NONE.
+ */
+static uint32_t pool_take (struct tagpool *t)
 {
-    uint32_t max = TAGPOOL_COUNT;
-    uint32_t oldsize, newsize, tag;
-
-    oldsize = t->veb.M;
-    newsize = oldsize << 1;
-    tag = vebsucc (t->veb, 0);
-
-    if (tag == t->veb.M && newsize <= max) {
-        if (t->grow_cb && t->grow_depth == 0) {
-            t->grow_depth++;
-            t->grow_cb (t->grow_arg, oldsize, newsize);
-            t->grow_depth--;
-        }
-        Veb new = vebnew (newsize, 0);
-        if (new.D) {
-            pool_set (new, oldsize, newsize, 1);
-            free (t->veb.D);
-            t->veb = new;
-            tag = vebsucc (t->veb, oldsize);
-            assert (tag == oldsize);
+    uint32_t nsummary = WORDS (WORDS (t->size));
+
+    while (t->hint < nsummary) {
+        uint64_t s = t->summary[t->hint];
+        if (s) {
+            uint32_t w = t->hint * BITS_PER_WORD + __builtin_ctzll (s);
+            uint32_t tag = w * BITS_PER_WORD + __builtin_ctzll (t->bits[w]);
+            pool_clr_free (t, tag);
+            return tag;
         }
+        t->hint++;
     }
-    if (tag < t->veb.M)
-        vebdel (t->veb, tag);
-    return tag;
+    return FLUX_MATCHTAG_NONE;
 }
 
 uint32_t tagpool_alloc (struct tagpool *t)
@@ -122,20 +163,33 @@ uint32_t tagpool_alloc (struct tagpool *t)
     assert (t->magic == TAGPOOL_MAGIC);
     uint32_t tag;
 
-    tag = alloc_with_resize (t);
-    if (tag < t->veb.M) {
-        t->avail--;
-        return tag;
+    tag = pool_take (t);
+    if (tag == FLUX_MATCHTAG_NONE && t->size < TAGPOOL_COUNT) {
+        uint32_t oldsize = t->size;
+        uint32_t newsize = oldsize << 1;
+
+        if (t->grow_cb && t->grow_depth == 0) {
+            t->grow_depth++;
+            t->grow_cb (t->grow_arg, oldsize, newsize);
+            t->grow_depth--;
+        }
+        if (pool_resize (t, newsize) == 0)
+            tag = pool_take (t);
     }
-    return FLUX_MATCHTAG_NONE;
+    if (tag != FLUX_MATCHTAG_NONE)
+        t->avail--;
+    return tag;
 }
 
 void tagpool_free (struct tagpool *t, uint32_t tag)
 {
     assert (t->magic == TAGPOOL_MAGIC);
     if (tag != FLUX_MATCHTAG_NONE) {
-        if (tag < t->veb.M) {
-            vebput (t->veb, tag);
+        if (tag < t->size && !pool_is_free (t, tag)) {
+            uint32_t s = tag / BITS_PER_WORD / BITS_PER_WORD;
+            pool_set_free (t, tag);
+            if (s < t->hint)
+                t->hint = s;
             t->avail++;
         }
     }
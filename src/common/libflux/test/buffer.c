@@ -1209,6 +1209,107 @@ void large_data (void)
     flux_buffer_destroy (fb);
 }
 
+static int iov_cmp (struct iovec *iov, int iovcnt, const char *s)
+{
+    int i;
+
+    for (i = 0; i < iovcnt; i++) {
+        if (strlen (s) < iov[i].iov_len
+            || memcmp (iov[i].iov_base, s, iov[i].iov_len) != 0)
+            return -1;
+        s += iov[i].iov_len;
+    }
+    return *s == '\0' ? 0 : -1;
+}
+
+/* Use a 8 byte buffer and fill it so data wraps around the end of
+ * the ring buffer.
+ */
+void iov_buffer (void)
+{
+    flux_buffer_t *fb;
+    struct iovec iov[2];
+    int pipefds[2];
+    char buf[16];
+    int iovcnt;
+
+    ok ((fb = flux_buffer_create (8)) != NULL,
+        "flux_buffer_create works");
+
+    ok (flux_buffer_peek_iov (fb, -1, iov) == 0,
+        "flux_buffer_peek_iov returns 0 entries on empty buffer");
+    ok (flux_buffer_peek_iov (NULL, -1, iov) < 0 && errno == EINVAL,
+        "flux_buffer_peek_iov fails with EINVAL on NULL buffer");
+    ok (flux_buffer_peek_iov (fb, -1, NULL) < 0 && errno == EINVAL,
+        "flux_buffer_peek_iov fails with EINVAL on NULL iov");
+
+    ok ((iovcnt = flux_buffer_reserve (fb, 6, iov)) == 1
+        && iov[0].iov_len == 6,
+        "flux_buffer_reserve returns contiguous space");
+    memcpy (iov[0].iov_base, "abcdef", 6);
+    ok (flux_buffer_bytes (fb) == 0,
+        "reserved space is not data before commit");
+    ok (flux_buffer_commit (fb, 6) == 6,
+        "flux_buffer_commit works");
+    ok (flux_buffer_bytes (fb) == 6,
+        "flux_buffer_bytes includes committed data");
+
+    ok ((iovcnt = flux_buffer_peek_iov (fb, 4, iov)) == 1
+        && iov_cmp (iov, iovcnt, "abcd") == 0,
+        "flux_buffer_peek_iov returns requested length");
+    ok (flux_buffer_bytes (fb) == 6,
+        "flux_buffer_peek_iov does not consume data");
+    ok (flux_buffer_drop (fb, 4) == 4,
+        "flux_buffer_drop consumes peeked data");
+
+    ok ((iovcnt = flux_buffer_reserve (fb, -1, iov)) == 2
+        && iov[0].iov_len + iov[1].iov_len == 6,
+        "flux_buffer_reserve returns free space spanning the wrap");
+    memcpy (iov[0].iov_base, "ghijkl", iov[0].iov_len);
+    memcpy (iov[1].iov_base, "ghijkl" + iov[0].iov_len, iov[1].iov_len);
+    ok (flux_buffer_commit (fb, 6) == 6,
+        "flux_buffer_commit works across the wrap");
+    ok (flux_buffer_space (fb) == 0,
+        "buffer is full");
+    ok (flux_buffer_reserve (fb, 1, iov) < 0 && errno == ENOSPC,
+        "flux_buffer_reserve fails with ENOSPC on full buffer");
+    ok (flux_buffer_commit (fb, 1) < 0 && errno == EINVAL,
+        "flux_buffer_commit fails with EINVAL beyond free space");
+
+    ok ((iovcnt = flux_buffer_peek_iov (fb, -1, iov)) == 2
+        && iov_cmp (iov, iovcnt, "efghijkl") == 0,
+        "flux_buffer_peek_iov returns data spanning the wrap in order");
+
+    ok (pipe (pipefds) == 0,
+        "pipe succeeded");
+    ok (flux_buffer_read_to_fd (fb, pipefds[1], -1) == 8,
+        "flux_buffer_read_to_fd writes wrapped data at once");
+    ok (read (pipefds[0], buf, sizeof (buf)) == 8
+        && memcmp (buf, "efghijkl", 8) == 0,
+        "data read from pipe is correct");
+
+    ok (flux_buffer_write (fb, "mnop", 4) == 4
+        && flux_buffer_drop (fb, 4) == 4,
+        "move ring buffer position");
+    ok (write (pipefds[1], "qrstuvwx", 8) == 8,
+        "write to pipe works");
+    ok (flux_buffer_write_from_fd (fb, pipefds[0], -1) == 8,
+        "flux_buffer_write_from_fd reads into wrapped free space at once");
+    ok ((iovcnt = flux_buffer_peek_iov (fb, -1, iov)) == 2
+        && iov_cmp (iov, iovcnt, "qrstuvwx") == 0,
+        "data written from fd is correct");
+
+    ok (flux_buffer_readonly (fb) == 0
+        && flux_buffer_drop (fb, -1) == 8,
+        "set buffer readonly and empty it");
+    ok (flux_buffer_reserve (fb, 1, iov) < 0 && errno == EROFS,
+        "flux_buffer_reserve fails with EROFS on readonly buffer");
+
+    flux_buffer_destroy (fb);
+    close (pipefds[0]);
+    close (pipefds[1]);
+}
+
 int main (int argc, char *argv[])
 {
     plan (NO_PLAN);
@@ -1221,6 +1322,7 @@ int main (int argc, char *argv[])
     full_buffer ();
     readonly_buffer ();
     large_data ();
+    iov_buffer ();
 
     done_testing();
 
@@ -712,6 +712,84 @@ static void test_composite_anon_child (flux_reactor_t *r, bool with_error)
     flux_future_destroy (all);
 }
 
+static void test_composite_index (flux_reactor_t *r)
+{
+    flux_future_t *all = flux_future_wait_all_create ();
+    flux_future_t *any = flux_future_wait_any_create ();
+    flux_future_t *f[3];
+    bool with_error = false;
+    int i;
+
+    if (!all || !any)
+        BAIL_OUT ("Error creating composite futures");
+    flux_future_set_reactor (all, r);
+    flux_future_set_reactor (any, r);
+
+    ok (flux_future_push_index (NULL, NULL) < 0 && errno == EINVAL,
+        "flux_future_push_index (NULL, NULL) returns EINVAL");
+    ok (flux_future_child_count (NULL) < 0 && errno == EINVAL,
+        "flux_future_child_count (NULL) returns EINVAL");
+    ok (flux_future_child_count (all) == 0,
+        "flux_future_child_count (all) == 0");
+
+    for (i = 0; i < 3; i++) {
+        if (!(f[i] = flux_future_create (init_no_fulfill, NULL)))
+            BAIL_OUT ("flux_future_create failed");
+    }
+    ok (flux_future_push (all, "f0", f[0]) == 0,
+        "flux_future_push (all, 'f0', f0) works");
+    ok (flux_future_push_index (all, f[1]) == 1
+        && flux_future_push_index (all, f[2]) == 2,
+        "flux_future_push_index returns child index in push order");
+    ok (flux_future_push_index (all, f[1]) < 0 && errno == EEXIST,
+        "flux_future_push_index of a child already pushed fails with EEXIST");
+    ok (flux_future_child_count (all) == 3,
+        "flux_future_child_count (all) == 3");
+    ok (flux_future_get_child_index (all, 0) == f[0]
+        && flux_future_get_child_index (all, 2) == f[2],
+        "flux_future_get_child_index returns children by index");
+    ok (flux_future_get_child_index (all, 3) == NULL && errno == ENOENT,
+        "flux_future_get_child_index out of range fails with ENOENT");
+    ok (flux_future_ready_child (all, 0) < 0 && errno == ENOENT,
+        "flux_future_ready_child fails with ENOENT before any are ready");
+
+    ok (flux_future_wait_for (all, 0.1) < 0 && errno == ETIMEDOUT,
+        "flux_future_wait_for (all) returns ETIMEDOUT");
+
+    flux_future_fulfill (f[2], NULL, NULL);
+    flux_future_fulfill_error (f[0], EPERM, NULL);
+    ok (flux_future_wait_for (all, 0.1) < 0 && errno == ETIMEDOUT,
+        "wait_all not ready with one child remaining");
+    flux_future_fulfill (f[1], NULL, NULL);
+    ok (flux_future_get (all, NULL) < 0 && errno == EPERM,
+        "wait_all is fulfilled with the error of the failed child");
+    /* f2 and f0 were fulfilled in the same reactor loop iteration, so
+     * they may be handled in either order, but before f1.
+     */
+    ok (flux_future_ready_child (all, 0) + flux_future_ready_child (all, 1) == 2
+        && flux_future_ready_child (all, 0) != flux_future_ready_child (all, 1)
+        && flux_future_ready_child (all, 2) == 1,
+        "flux_future_ready_child returns children in order handled");
+    ok (flux_future_ready_child (all, 3) < 0 && errno == ENOENT,
+        "flux_future_ready_child (all, 3) fails with ENOENT");
+
+    for (i = 0; i < 3; i++) {
+        if (!(f[i] = flux_future_create (i == 1 ? init_and_fulfill
+                                                : init_no_fulfill,
+                                         &with_error)))
+            BAIL_OUT ("flux_future_create failed");
+        if (flux_future_push_index (any, f[i]) != i)
+            BAIL_OUT ("flux_future_push_index failed");
+    }
+    ok (flux_future_get (any, NULL) == 0,
+        "wait_any future is fulfilled");
+    ok (flux_future_ready_child (any, 0) == 1,
+        "flux_future_ready_child (any, 0) is the fulfilled child");
+
+    flux_future_destroy (all);
+    flux_future_destroy (any);
+}
+
 void test_empty_composite (flux_reactor_t *r)
 {
     flux_future_t *all = flux_future_wait_all_create ();
@@ -749,6 +827,7 @@ int main (int argc, char *argv[])
     test_chained_multiple_fulfill ();
 
     test_composite_anon_child (reactor, false);
+    test_composite_index (reactor);
     test_empty_composite (reactor);
 
     flux_reactor_destroy (reactor);
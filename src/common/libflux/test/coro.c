@@ -0,0 +1,241 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <errno.h>
+#include <string.h>
+
+#include "src/common/libflux/reactor.h"
+#include "src/common/libflux/future.h"
+#include "src/common/libtap/tap.h"
+
+struct ctx {
+    int n;
+    int i;
+    int sum;
+    int steps;
+};
+
+/* A future fulfilled with 'value' when it is first waited on, or with
+ * an error if 'value' is negative.
+ */
+static void value_init (flux_future_t *f, void *arg)
+{
+    int *value = arg;
+    if (*value < 0)
+        flux_future_fulfill_error (f, -*value, NULL);
+    else
+        flux_future_fulfill (f, value, NULL);
+}
+
+static flux_future_t *value_future (int v)
+{
+    flux_future_t *f;
+    int *value;
+
+    if (!(value = malloc (sizeof (*value))))
+        return NULL;
+    *value = v;
+    if (!(f = flux_future_create (value_init, value))
+        || flux_future_aux_set (f, "value", value, free) < 0) {
+        flux_future_destroy (f);
+        free (value);
+        return NULL;
+    }
+    return f;
+}
+
+static int value_get (flux_future_t *f)
+{
+    const int *value;
+    if (flux_future_get (f, (const void **)&value) < 0)
+        return -1;
+    return *value;
+}
+
+static int sum_coro (flux_coro_t *co, void *arg)
+{
+    struct ctx *ctx = arg;
+    int i;
+
+    FLUX_CORO_BEGIN (co);
+
+    /* Await a batch of futures at once */
+    for (i = 0; i < ctx->n; i++)
+        flux_coro_push (co, value_future (i + 1));
+    FLUX_CORO_AWAIT (co);
+    ctx->steps++;
+    for (i = 0; i < flux_coro_count (co); i++) {
+        int v = value_get (flux_coro_get (co, i));
+        if (v < 0)
+            return -1;
+        ctx->sum += v;
+    }
+
+    /* Await futures one at a time in a loop */
+    for (ctx->i = 0; ctx->i < 3; ctx->i++) {
+        flux_coro_push (co, value_future (100));
+        FLUX_CORO_AWAIT (co);
+        ctx->steps++;
+        if (flux_coro_count (co) != 1)
+            return -1;
+        ctx->sum += value_get (flux_coro_get (co, 0));
+    }
+    flux_coro_set_result (co, &ctx->sum, NULL);
+
+    FLUX_CORO_END (co);
+}
+
+static int error_coro (flux_coro_t *co, void *arg)
+{
+    struct ctx *ctx = arg;
+
+    FLUX_CORO_BEGIN (co);
+    flux_coro_push (co, value_future (1));
+    flux_coro_push (co, value_future (-EPERM));
+    FLUX_CORO_AWAIT (co);
+    ctx->steps++;
+    if (value_get (flux_coro_get (co, 1)) < 0)
+        return -1;
+    FLUX_CORO_END (co);
+}
+
+static int empty_coro (flux_coro_t *co, void *arg)
+{
+    FLUX_CORO_BEGIN (co);
+    FLUX_CORO_AWAIT (co);
+    FLUX_CORO_END (co);
+}
+
+static int push_null_coro (flux_coro_t *co, void *arg)
+{
+    FLUX_CORO_BEGIN (co);
+    errno = ENOMEM;
+    flux_coro_push (co, NULL);
+    flux_coro_push (co, value_future (1));
+    FLUX_CORO_AWAIT (co);
+    FLUX_CORO_END (co);
+}
+
+static int done_rc = -1;
+static int done_result = -1;
+
+static void done_cb (flux_future_t *f, void *arg)
+{
+    flux_reactor_t *r = arg;
+    const int *result;
+
+    done_rc = flux_future_get (f, (const void **)&result);
+    if (done_rc == 0)
+        done_result = *result;
+    flux_reactor_stop (r);
+}
+
+static void test_then (flux_reactor_t *r)
+{
+    struct ctx ctx = { .n = 100 };
+    flux_future_t *f;
+
+    ok ((f = flux_coro_create (sum_coro, &ctx)) != NULL,
+        "flux_coro_create works");
+    flux_future_set_reactor (f, r);
+    ok (ctx.steps == 0,
+        "coroutine is not started by flux_coro_create");
+    ok (flux_future_then (f, -1., done_cb, r) == 0,
+        "flux_future_then works");
+    ok (flux_reactor_run (r, 0) >= 0,
+        "reactor ran");
+    ok (done_rc == 0 && done_result == 5050 + 300,
+        "coroutine future was fulfilled with result %d", done_result);
+    ok (ctx.steps == 4,
+        "coroutine ran %d steps", ctx.steps);
+    flux_future_destroy (f);
+}
+
+static void test_now (flux_reactor_t *r)
+{
+    struct ctx ctx = { .n = 5 };
+    const int *result;
+    flux_future_t *f;
+
+    if (!(f = flux_coro_create (sum_coro, &ctx)))
+        BAIL_OUT ("flux_coro_create failed");
+    flux_future_set_reactor (f, r);
+    ok (flux_future_get (f, (const void **)&result) == 0
+        && *result == 15 + 300,
+        "flux_future_get runs coroutine to completion");
+    ok (ctx.steps == 4,
+        "coroutine ran %d steps", ctx.steps);
+    flux_future_destroy (f);
+}
+
+static void test_errors (flux_reactor_t *r)
+{
+    struct ctx ctx = { 0 };
+    flux_future_t *f;
+
+    ok (flux_coro_create (NULL, NULL) == NULL && errno == EINVAL,
+        "flux_coro_create fn=NULL fails with EINVAL");
+    ok (flux_coro_push (NULL, NULL) < 0 && errno == EINVAL,
+        "flux_coro_push co=NULL fails with EINVAL");
+    ok (flux_coro_get (NULL, 0) == NULL && errno == EINVAL,
+        "flux_coro_get co=NULL fails with EINVAL");
+    ok (flux_coro_count (NULL) < 0 && errno == EINVAL,
+        "flux_coro_count co=NULL fails with EINVAL");
+    lives_ok ({flux_coro_set_result (NULL, NULL, NULL);},
+        "flux_coro_set_result co=NULL doesn't crash");
+
+    if (!(f = flux_coro_create (error_coro, &ctx)))
+        BAIL_OUT ("flux_coro_create failed");
+    flux_future_set_reactor (f, r);
+    ok (flux_future_get (f, NULL) < 0 && errno == EPERM,
+        "coroutine returning -1 fulfills its future with errno");
+    ok (ctx.steps == 1,
+        "coroutine step ran after all futures were fulfilled");
+    flux_future_destroy (f);
+
+    if (!(f = flux_coro_create (empty_coro, NULL)))
+        BAIL_OUT ("flux_coro_create failed");
+    flux_future_set_reactor (f, r);
+    ok (flux_future_get (f, NULL) < 0 && errno == EINVAL,
+        "await with no futures pushed fails with EINVAL");
+    flux_future_destroy (f);
+
+    if (!(f = flux_coro_create (push_null_coro, NULL)))
+        BAIL_OUT ("flux_coro_create failed");
+    flux_future_set_reactor (f, r);
+    ok (flux_future_get (f, NULL) < 0 && errno == ENOMEM,
+        "failed push fails coroutine with errno at await");
+    flux_future_destroy (f);
+}
+
+int main (int argc, char *argv[])
+{
+    flux_reactor_t *r;
+
+    plan (NO_PLAN);
+
+    if (!(r = flux_reactor_create (0)))
+        BAIL_OUT ("flux_reactor_create failed");
+
+    test_then (r);
+    test_now (r);
+    test_errors (r);
+
+    flux_reactor_destroy (r);
+    done_testing ();
+    return (0);
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
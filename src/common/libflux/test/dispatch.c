@@ -222,6 +222,246 @@ void test_request_catchall (flux_t *h)
     flux_msg_handler_destroy (mh);
 }
 
+/* Verify that a request whose deadline has passed is not dispatched,
+ * and that the sender gets an ETIMEDOUT response.
+ */
+void test_request_expired (flux_t *h)
+{
+    flux_future_t *f;
+    struct flux_match match = FLUX_MATCH_REQUEST;
+    flux_msg_handler_t *mh;
+    int rc;
+
+    match.topic_glob = "foo.expired";
+    if (!(mh = flux_msg_handler_create (h, match, cb, NULL)))
+        BAIL_OUT ("flux_msg_handler_create failed");
+    flux_msg_handler_start (mh);
+    flux_dispatch_clear_expired (h);
+    ok (flux_dispatch_get_expired (h) == 0,
+        "flux_dispatch_get_expired returns 0");
+
+    ok (flux_rpc_set_timeout (h, 0.) == 0,
+        "flux_rpc_set_timeout 0 works");
+    cb_called = 0;
+    f = flux_rpc (h, "foo.expired", NULL, FLUX_NODEID_ANY, 0);
+    ok (f != NULL,
+        "sent foo.expired RPC");
+    rc = flux_reactor_run (flux_get_reactor (h), FLUX_REACTOR_NOWAIT);
+    ok (rc >= 0,
+        "flux_reactor_run NOWAIT ran");
+    ok (cb_called == 0,
+        "handler was not called for expired request");
+    errno = 0;
+    ok (flux_future_get (f, NULL) < 0 && errno == ETIMEDOUT,
+        "RPC failed with ETIMEDOUT");
+    ok (flux_dispatch_get_expired (h) == 1,
+        "flux_dispatch_get_expired returns 1");
+    flux_future_destroy (f);
+
+    ok (flux_rpc_set_timeout (h, -1.) == 0,
+        "flux_rpc_set_timeout -1 works");
+    f = flux_rpc (h, "foo.expired", NULL, FLUX_NODEID_ANY, 0);
+    ok (f != NULL,
+        "sent foo.expired RPC without deadline");
+    rc = flux_reactor_run (flux_get_reactor (h), FLUX_REACTOR_NOWAIT);
+    ok (rc >= 0 && cb_called == 1,
+        "handler was called for request without deadline");
+    flux_future_destroy (f);
+
+    flux_dispatch_clear_expired (h);
+    ok (flux_dispatch_get_expired (h) == 0,
+        "flux_dispatch_clear_expired works");
+    errno = 0;
+    ok (flux_dispatch_get_expired (NULL) < 0 && errno == EINVAL,
+        "flux_dispatch_get_expired h=NULL fails with EINVAL");
+    errno = 0;
+    ok (flux_rpc_set_timeout (NULL, 1.) < 0 && errno == EINVAL,
+        "flux_rpc_set_timeout h=NULL fails with EINVAL");
+
+    flux_msg_handler_destroy (mh);
+}
+
+uint64_t outer_trace, outer_span;
+uint64_t nested_trace, nested_span;
+void trace_outer_cb (flux_t *h,
+                     flux_msg_handler_t *mh,
+                     const flux_msg_t *msg,
+                     void *arg)
+{
+    flux_future_t *f;
+
+    if (flux_msg_get_trace (msg, &outer_trace, &outer_span) < 0)
+        outer_trace = outer_span = 0;
+    f = flux_rpc (h, "foo.nested", NULL, FLUX_NODEID_ANY, FLUX_RPC_NORESPONSE);
+    flux_future_destroy (f);
+    (void)flux_respond (h, msg, NULL);
+}
+
+void trace_nested_cb (flux_t *h,
+                      flux_msg_handler_t *mh,
+                      const flux_msg_t *msg,
+                      void *arg)
+{
+    if (flux_msg_get_trace (msg, &nested_trace, &nested_span) < 0)
+        nested_trace = nested_span = 0;
+}
+
+/* Verify that FLUX_O_RPCTRACE starts a trace for an RPC, that the
+ * response keeps it, and that an RPC sent by the handler joins it.
+ */
+void test_rpc_trace (flux_t *h)
+{
+    struct flux_match match = FLUX_MATCH_REQUEST;
+    flux_msg_handler_t *mh, *mh2;
+    flux_future_t *f;
+    const flux_msg_t *rmsg;
+    uint64_t trace;
+    int i;
+
+    match.topic_glob = "foo.outer";
+    if (!(mh = flux_msg_handler_create (h, match, trace_outer_cb, NULL)))
+        BAIL_OUT ("flux_msg_handler_create failed");
+    match.topic_glob = "foo.nested";
+    if (!(mh2 = flux_msg_handler_create (h, match, trace_nested_cb, NULL)))
+        BAIL_OUT ("flux_msg_handler_create failed");
+    flux_msg_handler_start (mh);
+    flux_msg_handler_start (mh2);
+
+    f = flux_rpc (h, "foo.outer", NULL, FLUX_NODEID_ANY, 0);
+    ok (f != NULL && flux_future_get (f, NULL) == 0,
+        "untraced RPC works");
+    ok (outer_trace == 0,
+        "request has no trace context");
+    flux_future_destroy (f);
+    for (i = 0; i < 10; i++)
+        (void)flux_reactor_run (flux_get_reactor (h), FLUX_REACTOR_NOWAIT);
+
+    flux_flags_set (h, FLUX_O_RPCTRACE);
+    f = flux_rpc (h, "foo.outer", NULL, FLUX_NODEID_ANY, 0);
+    ok (f != NULL && flux_future_get (f, (const void **)&rmsg) == 0,
+        "traced RPC works");
+    ok (outer_trace != 0 && outer_span != 0,
+        "FLUX_O_RPCTRACE gave the request a trace context");
+    ok (flux_msg_get_trace (rmsg, &trace, NULL) == 0 && trace == outer_trace,
+        "response has the request trace context");
+    for (i = 0; i < 10 && nested_trace != outer_trace; i++)
+        (void)flux_reactor_run (flux_get_reactor (h), FLUX_REACTOR_NOWAIT);
+    ok (nested_trace == outer_trace && nested_span != outer_span,
+        "RPC sent by the handler joined the trace with a new span");
+    flux_future_destroy (f);
+    flux_flags_unset (h, FLUX_O_RPCTRACE);
+
+    flux_msg_handler_destroy (mh2);
+    flux_msg_handler_destroy (mh);
+}
+
+/* Verify that overlapping glob request handlers are matched newest first,
+ * regardless of how specific their topic prefixes are.
+ */
+void test_request_glob_precedence (flux_t *h)
+{
+    flux_future_t *f;
+    struct flux_match match = FLUX_MATCH_REQUEST;
+    flux_msg_handler_t *mh, *mh2;
+    int rc;
+
+    match.topic_glob = "foo.*";
+    mh = flux_msg_handler_create (h, match, cb, NULL);
+    flux_msg_handler_start (mh);
+    match.topic_glob = "*";
+    mh2 = flux_msg_handler_create (h, match, cb2, NULL);
+    flux_msg_handler_start (mh2);
+    ok (mh != NULL && mh2 != NULL,
+        "foo.* then * request handlers created and started");
+
+    cb_called = 0;
+    cb2_called = 0;
+    f = flux_rpc (h, "foo.baz", NULL, FLUX_NODEID_ANY, 0);
+    ok (f != NULL,
+        "sent foo.baz RPC");
+    rc = flux_reactor_run (flux_get_reactor (h), FLUX_REACTOR_NOWAIT);
+    ok (rc >= 0,
+        "flux_reactor_run NOWAIT ran");
+    ok (cb_called == 0 && cb2_called == 1,
+        "newer * handler was called");
+    flux_future_destroy (f);
+
+    flux_msg_handler_stop (mh2);
+    f = flux_rpc (h, "foo.baz", NULL, FLUX_NODEID_ANY, 0);
+    ok (f != NULL,
+        "sent foo.baz RPC");
+    rc = flux_reactor_run (flux_get_reactor (h), FLUX_REACTOR_NOWAIT);
+    ok (rc >= 0,
+        "flux_reactor_run NOWAIT ran");
+    ok (cb_called == 1 && cb2_called == 1,
+        "with * handler stopped, foo.* handler was called");
+    flux_future_destroy (f);
+
+    flux_msg_handler_destroy (mh2);
+    flux_msg_handler_destroy (mh);
+}
+
+int ev_order[4];
+int ev_count;
+flux_msg_handler_t *ev_victim;
+void ev_cb (flux_t *h, flux_msg_handler_t *mh, const flux_msg_t *msg,
+            void *arg)
+{
+    if (ev_count < 4)
+        ev_order[ev_count++] = *(int *)arg;
+    if (ev_victim && ev_victim != mh) {
+        flux_msg_handler_destroy (ev_victim);
+        ev_victim = NULL;
+    }
+}
+
+/* Verify that an event is delivered to all matching handlers, newest first,
+ * and that a handler destroyed by an earlier callback is not called.
+ */
+void test_event_fanout (flux_t *h)
+{
+    struct flux_match match = FLUX_MATCH_EVENT;
+    const char *globs[] = { "ev.*", NULL, "ev.a", "nomatch.*" };
+    int ids[] = { 0, 1, 2, 3 };
+    flux_msg_handler_t *mh[4];
+    flux_msg_t *msg;
+    int rc;
+
+    for (int i = 0; i < 4; i++) {
+        match.topic_glob = (char *)globs[i];
+        if (!(mh[i] = flux_msg_handler_create (h, match, ev_cb, &ids[i])))
+            BAIL_OUT ("flux_msg_handler_create failed");
+        flux_msg_handler_start (mh[i]);
+    }
+    if (!(msg = flux_event_encode ("ev.a", NULL)))
+        BAIL_OUT ("flux_event_encode failed");
+
+    ev_count = 0;
+    ok (flux_send (h, msg, 0) == 0,
+        "sent ev.a event");
+    rc = flux_reactor_run (flux_get_reactor (h), FLUX_REACTOR_NOWAIT);
+    ok (rc >= 0,
+        "flux_reactor_run NOWAIT ran");
+    ok (ev_count == 3
+        && ev_order[0] == 2 && ev_order[1] == 1 && ev_order[2] == 0,
+        "matching event handlers were called newest first");
+
+    ev_count = 0;
+    ev_victim = mh[0];
+    ok (flux_send (h, msg, 0) == 0,
+        "sent ev.a event");
+    rc = flux_reactor_run (flux_get_reactor (h), FLUX_REACTOR_NOWAIT);
+    ok (rc >= 0,
+        "flux_reactor_run NOWAIT ran");
+    ok (ev_count == 2 && ev_order[0] == 2 && ev_order[1] == 1,
+        "handler destroyed by an earlier callback was not called");
+    mh[0] = NULL;
+
+    flux_msg_destroy (msg);
+    for (int i = 0; i < 4; i++)
+        flux_msg_handler_destroy (mh[i]);
+}
+
 /* Verify that an RPC response is matched before one for a glob.
  * A "router" should be able to register a catch-all response handler
  * that doesn't override its own service methods.
@@ -479,6 +719,10 @@ int main (int argc, char *argv[])
     test_cloned_dispatch (h);
     test_method_override (h);
     test_request_catchall (h);
+    test_request_expired (h);
+    test_rpc_trace (h);
+    test_request_glob_precedence (h);
+    test_event_fanout (h);
     test_response_catchall (h);
     test_response_with_routes (h);
 
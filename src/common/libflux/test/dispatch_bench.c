@@ -0,0 +1,138 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* dispatch_bench.c - measure message dispatch rate vs handler count
+ *
+ * Register N glob request handlers and N event handlers with distinct
+ * topic prefixes, then send messages that match one handler in the middle
+ * and report the dispatch rate.  Iteration counts are kept small so this
+ * runs quickly under "make check"; the rates are printed as diagnostics.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <errno.h>
+#include <stdio.h>
+#include <flux/core.h>
+
+#include "src/common/libutil/monotime.h"
+#include "src/common/libtap/tap.h"
+#include "src/common/libtestutil/util.h"
+
+static const int handler_counts[] = { 10, 100, 1000 };
+static const int iterations = 2000;
+
+struct bench {
+    int target;
+    int hits;
+    int misses;
+};
+
+struct handler_arg {
+    struct bench *bench;
+    int id;
+};
+
+static void bench_cb (flux_t *h,
+                      flux_msg_handler_t *mh,
+                      const flux_msg_t *msg,
+                      void *arg)
+{
+    struct handler_arg *ha = arg;
+
+    if (ha->id == ha->bench->target)
+        ha->bench->hits++;
+    else
+        ha->bench->misses++;
+}
+
+static flux_msg_t *encode (int type, const char *topic)
+{
+    if (type == FLUX_MSGTYPE_EVENT)
+        return flux_event_encode (topic, NULL);
+    return flux_request_encode (topic, NULL);
+}
+
+static void run_bench (flux_t *h, int type, int count)
+{
+    const char *name = type == FLUX_MSGTYPE_EVENT ? "event" : "request";
+    flux_reactor_t *r = flux_get_reactor (h);
+    flux_msg_handler_t **mh;
+    struct handler_arg *ha;
+    struct bench bench = { .target = count / 2 };
+    struct flux_match match = FLUX_MATCH_ANY;
+    char topic[64];
+    flux_msg_t *msg;
+    struct timespec t0;
+    double elapsed;
+    int i;
+
+    if (!(mh = calloc (count, sizeof (mh[0])))
+        || !(ha = calloc (count, sizeof (ha[0]))))
+        BAIL_OUT ("out of memory");
+    match.typemask = type;
+    for (i = 0; i < count; i++) {
+        snprintf (topic, sizeof (topic), "svc%d.*", i);
+        match.topic_glob = topic;
+        ha[i].bench = &bench;
+        ha[i].id = i;
+        if (!(mh[i] = flux_msg_handler_create (h, match, bench_cb, &ha[i])))
+            BAIL_OUT ("flux_msg_handler_create failed");
+        flux_msg_handler_start (mh[i]);
+    }
+    snprintf (topic, sizeof (topic), "svc%d.method", bench.target);
+    if (!(msg = encode (type, topic)))
+        BAIL_OUT ("could not encode %s", name);
+
+    monotime (&t0);
+    for (i = 0; i < iterations; i++) {
+        if (flux_send (h, msg, 0) < 0
+            || flux_reactor_run (r, FLUX_REACTOR_NOWAIT) < 0)
+            break;
+    }
+    elapsed = monotime_since (t0) / 1000;
+
+    ok (bench.hits == iterations && bench.misses == 0,
+        "%s: %d handlers: %d messages went to the matching handler",
+        name, count, iterations);
+    diag ("%s: %d handlers: %.0f msg/s",
+          name, count, elapsed > 0 ? iterations / elapsed : 0);
+
+    flux_msg_destroy (msg);
+    for (i = 0; i < count; i++)
+        flux_msg_handler_destroy (mh[i]);
+    free (ha);
+    free (mh);
+}
+
+int main (int argc, char *argv[])
+{
+    flux_t *h;
+    int n = sizeof (handler_counts) / sizeof (handler_counts[0]);
+
+    plan (NO_PLAN);
+
+    if (!(h = loopback_create (0)))
+        BAIL_OUT ("can't continue without loopback handle");
+
+    for (int i = 0; i < n; i++)
+        run_bench (h, FLUX_MSGTYPE_REQUEST, handler_counts[i]);
+    for (int i = 0; i < n; i++)
+        run_bench (h, FLUX_MSGTYPE_EVENT, handler_counts[i]);
+
+    flux_close (h);
+    done_testing();
+    return (0);
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
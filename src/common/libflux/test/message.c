@@ -19,6 +19,9 @@
 #include "src/common/libflux/message.h"
 #include "src/common/libtap/tap.h"
 
+/* size of the encoded PROTO frame, per RFC 3 */
+#define PROTO_TEST_SIZE 20
+
 /* flux_msg_get_route_first, flux_msg_get_route_last, _get_route_count
  *   on message with variable number of routing frames
  */
@@ -678,6 +681,282 @@ void check_encode (void)
     flux_msg_destroy (msg2);
 }
 
+/* Request deadline is set, cleared, expires, and survives an
+ * encode/decode round trip in an extended PROTO frame.
+ */
+void check_deadline (void)
+{
+    flux_msg_t *msg, *msg2;
+    void *buf;
+    size_t size, size2;
+    double t;
+
+    if (!(msg = flux_msg_create (FLUX_MSGTYPE_REQUEST))
+        || flux_msg_set_topic (msg, "foo.bar") < 0)
+        BAIL_OUT ("failed to create request");
+    size = flux_msg_encode_size (msg);
+    errno = 0;
+    ok (flux_msg_get_deadline (msg, &t) < 0 && errno == ENOENT,
+        "flux_msg_get_deadline on new request fails with ENOENT");
+    ok (flux_msg_is_expired (msg) == false,
+        "flux_msg_is_expired on request without deadline returns false");
+    ok (flux_msg_set_deadline (msg, 60.) == 0,
+        "flux_msg_set_deadline 60 works");
+    ok (flux_msg_get_deadline (msg, &t) == 0 && t > 0. && t <= 60.,
+        "flux_msg_get_deadline returns time remaining");
+    ok (flux_msg_is_expired (msg) == false,
+        "flux_msg_is_expired returns false");
+
+    size2 = flux_msg_encode_size (msg);
+    ok (size2 == size + 4,
+        "deadline adds 4 bytes to encoded message");
+    buf = malloc (size2);
+    assert (buf != NULL);
+    ok (flux_msg_encode (msg, buf, size2) == 0,
+        "flux_msg_encode works");
+    ok ((msg2 = flux_msg_decode (buf, size2)) != NULL,
+        "flux_msg_decode works");
+    free (buf);
+    ok (flux_msg_get_deadline (msg2, &t) == 0 && t > 59. && t <= 60.,
+        "decoded request has the deadline");
+    flux_msg_destroy (msg2);
+
+    ok (flux_msg_set_deadline (msg, -1.) == 0,
+        "flux_msg_set_deadline -1 works");
+    errno = 0;
+    ok (flux_msg_get_deadline (msg, NULL) < 0 && errno == ENOENT,
+        "deadline was cleared");
+    ok (flux_msg_encode_size (msg) == size,
+        "encoded size is restored");
+
+    ok (flux_msg_set_deadline (msg, 0.) == 0,
+        "flux_msg_set_deadline 0 works");
+    ok (flux_msg_is_expired (msg) == true,
+        "flux_msg_is_expired returns true");
+    ok (flux_msg_get_deadline (msg, &t) == 0 && t <= 0.,
+        "flux_msg_get_deadline returns time remaining <= 0");
+
+    ok (flux_msg_set_type (msg, FLUX_MSGTYPE_RESPONSE) == 0,
+        "changed message type to response");
+    errno = 0;
+    ok (flux_msg_get_deadline (msg, &t) < 0 && errno == EPROTO,
+        "flux_msg_get_deadline on response fails with EPROTO");
+    ok (flux_msg_is_expired (msg) == false,
+        "flux_msg_is_expired on response returns false");
+    ok (flux_msg_set_type (msg, FLUX_MSGTYPE_REQUEST) == 0
+        && flux_msg_get_deadline (msg, &t) < 0 && errno == ENOENT,
+        "changing message type cleared deadline");
+    errno = 0;
+    ok (flux_msg_set_type (msg, FLUX_MSGTYPE_EVENT) == 0
+        && flux_msg_set_deadline (msg, 1.) < 0 && errno == EINVAL,
+        "flux_msg_set_deadline on event fails with EINVAL");
+    errno = 0;
+    ok (flux_msg_set_deadline (NULL, 1.) < 0 && errno == EINVAL,
+        "flux_msg_set_deadline msg=NULL fails with EINVAL");
+    ok (flux_msg_is_expired (NULL) == false,
+        "flux_msg_is_expired msg=NULL returns false");
+
+    flux_msg_destroy (msg);
+}
+
+/* Trace context is set on any message type, survives an encode/decode
+ * round trip with or without a deadline, and is kept by a response.
+ */
+void check_trace (void)
+{
+    flux_msg_t *msg, *msg2;
+    void *buf;
+    size_t size, size2;
+    uint64_t trace, span;
+    double t;
+
+    if (!(msg = flux_msg_create (FLUX_MSGTYPE_REQUEST))
+        || flux_msg_set_topic (msg, "foo.bar") < 0)
+        BAIL_OUT ("failed to create request");
+    size = flux_msg_encode_size (msg);
+    errno = 0;
+    ok (flux_msg_get_trace (msg, &trace, &span) < 0 && errno == ENOENT,
+        "flux_msg_get_trace on new message fails with ENOENT");
+    ok (flux_msg_set_trace (msg, 0x123456789abcdefULL, 42) == 0,
+        "flux_msg_set_trace works");
+    ok (flux_msg_get_trace (msg, &trace, &span) == 0
+        && trace == 0x123456789abcdefULL && span == 42,
+        "flux_msg_get_trace returns trace context");
+    size2 = flux_msg_encode_size (msg);
+    ok (size2 == size + 20,
+        "trace context adds 20 bytes to encoded message");
+
+    buf = malloc (size2);
+    assert (buf != NULL);
+    ok (flux_msg_encode (msg, buf, size2) == 0
+        && (msg2 = flux_msg_decode (buf, size2)) != NULL,
+        "encoded and decoded message");
+    free (buf);
+    trace = span = 0;
+    ok (flux_msg_get_trace (msg2, &trace, &span) == 0
+        && trace == 0x123456789abcdefULL && span == 42,
+        "decoded message has trace context");
+    errno = 0;
+    ok (flux_msg_get_deadline (msg2, NULL) < 0 && errno == ENOENT,
+        "decoded message has no deadline");
+    flux_msg_destroy (msg2);
+
+    ok (flux_msg_set_deadline (msg, 60.) == 0,
+        "set deadline");
+    ok (flux_msg_encode_size (msg) == size2,
+        "deadline adds nothing to traced message");
+    buf = malloc (size2);
+    assert (buf != NULL);
+    ok (flux_msg_encode (msg, buf, size2) == 0
+        && (msg2 = flux_msg_decode (buf, size2)) != NULL,
+        "encoded and decoded message");
+    free (buf);
+    ok (flux_msg_get_trace (msg2, &trace, &span) == 0
+        && trace == 0x123456789abcdefULL && span == 42
+        && flux_msg_get_deadline (msg2, &t) == 0 && t > 59.,
+        "decoded message has trace context and deadline");
+    flux_msg_destroy (msg2);
+
+    ok (flux_msg_set_type (msg, FLUX_MSGTYPE_RESPONSE) == 0
+        && flux_msg_get_trace (msg, &trace, NULL) == 0
+        && trace == 0x123456789abcdefULL,
+        "changing message type to response keeps trace context");
+    ok (flux_msg_set_trace (msg, 0, 42) == 0
+        && flux_msg_get_trace (msg, NULL, NULL) < 0 && errno == ENOENT,
+        "flux_msg_set_trace trace=0 clears trace context");
+    ok (flux_msg_encode_size (msg) == size,
+        "encoded size is restored");
+    errno = 0;
+    ok (flux_msg_set_trace (NULL, 1, 1) < 0 && errno == EINVAL,
+        "flux_msg_set_trace msg=NULL fails with EINVAL");
+    errno = 0;
+    ok (flux_msg_get_trace (NULL, NULL, NULL) < 0 && errno == EINVAL,
+        "flux_msg_get_trace msg=NULL fails with EINVAL");
+
+    flux_msg_destroy (msg);
+}
+
+/* Route stack, topic, and payload survive an encode/decode round trip
+ * in the expected order, and malformed input is rejected.
+ */
+void check_encode_routes (void)
+{
+    flux_msg_t *msg, *msg2;
+    void *buf;
+    size_t size;
+    const char *topic;
+    const void *payload;
+    int payload_size;
+    char pay[512];
+    char *s;
+
+    memset (pay, 'x', sizeof (pay));
+    if (!(msg = flux_msg_create (FLUX_MSGTYPE_RESPONSE))
+        || flux_msg_set_topic (msg, "foo.bar") < 0
+        || flux_msg_set_payload (msg, pay, sizeof (pay)) < 0
+        || flux_msg_set_matchtag (msg, 42) < 0
+        || flux_msg_enable_route (msg) < 0
+        || flux_msg_push_route (msg, "first") < 0
+        || flux_msg_push_route (msg, "middle") < 0
+        || flux_msg_push_route (msg, "last") < 0)
+        BAIL_OUT ("failed to create test message");
+    ok (flux_msg_frames (msg) == 7,
+        "message with 3 routes, topic, and payload has 7 frames");
+    size = flux_msg_encode_size (msg);
+    if (!(buf = malloc (size)))
+        BAIL_OUT ("out of memory");
+    ok (flux_msg_encode (msg, buf, size) == 0,
+        "flux_msg_encode works");
+    errno = 0;
+    ok (flux_msg_encode (msg, buf, size - 1) < 0 && errno == EINVAL,
+        "flux_msg_encode fails with EINVAL on short buffer");
+    ok ((msg2 = flux_msg_decode (buf, size)) != NULL,
+        "flux_msg_decode works");
+    ok (flux_msg_get_route_count (msg2) == 3,
+        "decoded message has 3 routes");
+    ok (flux_msg_get_route_first (msg2, &s) == 0 && s && !strcmp (s, "first"),
+        "decoded message has expected first route");
+    free (s);
+    ok (flux_msg_get_route_last (msg2, &s) == 0 && s && !strcmp (s, "last"),
+        "decoded message has expected last route");
+    free (s);
+    ok (flux_msg_get_topic (msg2, &topic) == 0 && !strcmp (topic, "foo.bar"),
+        "decoded message has expected topic");
+    ok (flux_msg_get_payload (msg2, &payload, &payload_size) == 0
+        && payload_size == sizeof (pay)
+        && memcmp (payload, pay, payload_size) == 0,
+        "decoded message has expected payload");
+    flux_msg_destroy (msg2);
+
+    errno = 0;
+    ok (flux_msg_decode (buf, size - PROTO_TEST_SIZE - 1) == NULL
+        && errno == EPROTO,
+        "flux_msg_decode fails with EPROTO when PROTO frame is missing");
+
+    free (buf);
+    flux_msg_destroy (msg);
+}
+
+/* Copies share the decoded JSON payload.
+ */
+void check_copy_json (void)
+{
+    flux_msg_t *msg, *cpy;
+    json_t *o1, *o2;
+    int i;
+
+    if (!(msg = flux_msg_create (FLUX_MSGTYPE_EVENT))
+        || flux_msg_pack (msg, "{s:{s:i}}", "obj", "foo", 42) < 0)
+        BAIL_OUT ("failed to create test message");
+    ok ((cpy = flux_msg_copy (msg, true)) != NULL,
+        "flux_msg_copy works");
+    ok (flux_msg_unpack (msg, "{s:o}", "obj", &o1) == 0,
+        "flux_msg_unpack original works");
+    ok (flux_msg_unpack (cpy, "{s:o}", "obj", &o2) == 0,
+        "flux_msg_unpack copy works");
+    ok (o1 == o2,
+        "copy shares decoded JSON with original");
+    flux_msg_destroy (msg);
+    i = 0;
+    ok (flux_msg_unpack (cpy, "{s:{s:i}}", "obj", "foo", &i) == 0 && i == 42,
+        "decoded JSON remains valid in copy after original is destroyed");
+    ok (flux_msg_pack (cpy, "{s:i}", "bar", 43) == 0
+        && flux_msg_unpack (cpy, "{s:i}", "bar", &i) == 0 && i == 43,
+        "new payload invalidates shared decoded JSON");
+    flux_msg_destroy (cpy);
+}
+
+/* Copies share the payload, but changing the payload of one message
+ * does not affect the other.
+ */
+void check_copy_payload (void)
+{
+    flux_msg_t *msg, *cpy;
+    const void *buf1, *buf2;
+    int len1, len2;
+    const char *s;
+
+    if (!(msg = flux_msg_create (FLUX_MSGTYPE_EVENT))
+        || flux_msg_set_string (msg, "hello") < 0)
+        BAIL_OUT ("failed to create test message");
+    ok ((cpy = flux_msg_copy (msg, true)) != NULL,
+        "flux_msg_copy works");
+    ok (flux_msg_get_payload (msg, &buf1, &len1) == 0
+        && flux_msg_get_payload (cpy, &buf2, &len2) == 0
+        && buf1 == buf2 && len1 == len2,
+        "copy shares payload buffer with original");
+    ok (flux_msg_set_string (cpy, "world") == 0,
+        "flux_msg_set_string on copy works");
+    ok (flux_msg_get_string (msg, &s) == 0 && !strcmp (s, "hello"),
+        "original payload is unchanged");
+    ok (flux_msg_get_string (cpy, &s) == 0 && !strcmp (s, "world"),
+        "copy has new payload");
+    flux_msg_destroy (msg);
+    ok (flux_msg_get_string (cpy, &s) == 0 && !strcmp (s, "world"),
+        "copy payload is valid after original is destroyed");
+    flux_msg_destroy (cpy);
+}
+
 void check_sendzsock (void)
 {
     zsock_t *zsock[2] = { NULL, NULL };
@@ -1013,6 +1292,41 @@ void check_refcount (void)
         "flux_msg_destroy msg=NULL doesnt crash crash");
 }
 
+void check_cachestats (void)
+{
+    flux_msg_cachestats_t before, after;
+    flux_msg_t *msg;
+
+    lives_ok ({flux_msg_get_cachestats (NULL);},
+        "flux_msg_get_cachestats stats=NULL doesnt crash");
+    if (!(msg = flux_msg_create (FLUX_MSGTYPE_REQUEST)))
+        BAIL_OUT ("failed to create test message");
+    if (flux_msg_set_string (msg, "small payload") < 0)
+        BAIL_OUT ("failed to set payload");
+    flux_msg_destroy (msg);
+
+    flux_msg_get_cachestats (&before);
+    ok (before.msg_cached > 0 && before.payload_cached > 0,
+        "destroyed message and payload were cached");
+    if (!(msg = flux_msg_create (FLUX_MSGTYPE_EVENT)))
+        BAIL_OUT ("failed to create test message");
+    if (flux_msg_set_string (msg, "another") < 0)
+        BAIL_OUT ("failed to set payload");
+    flux_msg_get_cachestats (&after);
+    ok (after.msg_reuse == before.msg_reuse + 1
+        && after.msg_alloc == before.msg_alloc,
+        "message was recycled from the cache");
+    ok (after.payload_reuse == before.payload_reuse + 1
+        && after.payload_alloc == before.payload_alloc,
+        "payload was recycled from the cache");
+    ok (flux_msg_get_route_count (msg) < 0
+        && !flux_msg_cmp (msg, flux_match_init (FLUX_MSGTYPE_ANY,
+                                                FLUX_MATCHTAG_NONE,
+                                                "foo")),
+        "recycled message has no routes or topic");
+    flux_msg_destroy (msg);
+}
+
 int main (int argc, char *argv[])
 {
     plan (NO_PLAN);
@@ -1027,16 +1341,22 @@ int main (int argc, char *argv[])
     check_security ();
     check_aux ();
     check_copy ();
+    check_copy_payload ();
+    check_copy_json ();
     check_flags ();
 
     check_cmp ();
 
     check_encode ();
+    check_encode_routes ();
+    check_deadline ();
+    check_trace ();
     check_sendzsock ();
 
     check_params ();
 
     check_refcount();
+    check_cachestats ();
 
     //check_print ();
 
@@ -19,6 +19,7 @@
 
 #include <flux/core.h>
 
+#include "src/common/libflux/module_private.h"
 #include "src/common/libtap/tap.h"
 #include "src/common/libtestutil/util.h"
 
@@ -183,6 +184,111 @@ void test_debug (void)
     flux_handle_destroy (h);
 }
 
+static void shed (flux_t *h, size_t usage, size_t limit, void *arg)
+{
+}
+
+void test_memory (void)
+{
+    flux_t *h;
+    struct flux_handle_ops ops;
+    struct flux_module_memory mm;
+    int arg;
+
+    memset (&ops, 0, sizeof (ops));
+    if (!(h = flux_handle_create (NULL, &ops, 0)))
+        BAIL_OUT ("flux_handle_create failed");
+
+    lives_ok ({flux_module_memory_set (h, 100);},
+        "flux_module_memory_set with unpopulated aux doesn't crash");
+    lives_ok ({flux_module_memory_add (h, 100);},
+        "flux_module_memory_add with unpopulated aux doesn't crash");
+    ok (flux_module_memory_get (h) == 0,
+        "flux_module_memory_get returns 0 with unpopulated aux");
+    ok (flux_module_set_shed (h, shed, NULL) == 0,
+        "flux_module_set_shed with unpopulated aux works");
+
+    memset (&mm, 0, sizeof (mm));
+    if (flux_aux_set (h, FLUX_MODULE_MEMORY_AUX, &mm, NULL) < 0)
+        BAIL_OUT ("flux_aux_set failed");
+
+    flux_module_memory_set (h, 1000);
+    ok (flux_module_memory_get (h) == 1000 && mm.peak == 1000,
+        "flux_module_memory_set sets usage and peak");
+    flux_module_memory_add (h, 24);
+    ok (flux_module_memory_get (h) == 1024 && mm.peak == 1024,
+        "flux_module_memory_add adds to usage and peak");
+    flux_module_memory_add (h, -512);
+    ok (flux_module_memory_get (h) == 512 && mm.peak == 1024,
+        "flux_module_memory_add subtracts from usage but not peak");
+    flux_module_memory_add (h, -1000);
+    ok (flux_module_memory_get (h) == 0,
+        "flux_module_memory_add clamps usage at 0");
+
+    mm.shed_usage = 42;
+    ok (flux_module_set_shed (h, shed, &arg) == 0
+        && mm.shed == shed && mm.shed_arg == &arg && mm.shed_usage == 0,
+        "flux_module_set_shed sets callback and resets shed state");
+
+    errno = 0;
+    ok (flux_module_set_shed (NULL, shed, NULL) < 0 && errno == EINVAL,
+        "flux_module_set_shed h=NULL fails with EINVAL");
+    ok (flux_module_memory_get (NULL) == 0,
+        "flux_module_memory_get h=NULL returns 0");
+
+    flux_handle_destroy (h);
+}
+
+void test_handoff (void)
+{
+    flux_t *h;
+    struct flux_handle_ops ops;
+    struct flux_module_handoff ho;
+    const char *s;
+
+    memset (&ops, 0, sizeof (ops));
+    if (!(h = flux_handle_create (NULL, &ops, 0)))
+        BAIL_OUT ("flux_handle_create failed");
+
+    ok (flux_module_handoff_export (h, "foo") == 0,
+        "flux_module_handoff_export with unpopulated aux works");
+    errno = 0;
+    ok (flux_module_handoff_import (h) == NULL && errno == ENOENT,
+        "flux_module_handoff_import with unpopulated aux fails with ENOENT");
+
+    memset (&ho, 0, sizeof (ho));
+    if (flux_aux_set (h, FLUX_MODULE_HANDOFF_AUX, &ho, NULL) < 0)
+        BAIL_OUT ("flux_aux_set failed");
+
+    errno = 0;
+    ok (flux_module_handoff_import (h) == NULL && errno == ENOENT,
+        "flux_module_handoff_import with no predecessor fails with ENOENT");
+    ho.prev = "bar";
+    s = flux_module_handoff_import (h);
+    ok (s != NULL && !strcmp (s, "bar"),
+        "flux_module_handoff_import returns predecessor's state");
+
+    ok (flux_module_handoff_export (h, "foo") == 0
+        && ho.next != NULL
+        && !strcmp (ho.next, "foo"),
+        "flux_module_handoff_export sets state for successor");
+    ok (flux_module_handoff_export (h, "baz") == 0
+        && ho.next != NULL
+        && !strcmp (ho.next, "baz"),
+        "flux_module_handoff_export replaces state");
+    ok (flux_module_handoff_export (h, NULL) == 0 && ho.next == NULL,
+        "flux_module_handoff_export state=NULL discards state");
+
+    errno = 0;
+    ok (flux_module_handoff_export (NULL, "foo") < 0 && errno == EINVAL,
+        "flux_module_handoff_export h=NULL fails with EINVAL");
+    errno = 0;
+    ok (flux_module_handoff_import (NULL) == NULL && errno == EINVAL,
+        "flux_module_handoff_import h=NULL fails with EINVAL");
+
+    flux_handle_destroy (h);
+}
+
 void test_set_running (void)
 {
     flux_t *h;
@@ -207,6 +313,8 @@ int main (int argc, char *argv[])
     test_modname ();
     test_modfind ();
     test_debug ();
+    test_memory ();
+    test_handoff ();
     test_set_running ();
 
     done_testing();
@@ -0,0 +1,224 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#include <errno.h>
+#include <string.h>
+
+#include "message.h"
+#include "request.h"
+#include "msglist.h"
+
+#include "src/common/libtap/tap.h"
+
+/* Create a request from 'sender' with 'matchtag'.
+ * sender=NULL creates a request without a route stack.
+ */
+flux_msg_t *create_request (const char *sender, uint32_t matchtag)
+{
+    flux_msg_t *msg;
+
+    if (!(msg = flux_request_encode ("foo.bar", NULL)))
+        BAIL_OUT ("flux_request_encode failed");
+    if (flux_msg_set_matchtag (msg, matchtag) < 0)
+        BAIL_OUT ("flux_msg_set_matchtag failed");
+    if (sender) {
+        if (flux_msg_enable_route (msg) < 0
+            || flux_msg_push_route (msg, sender) < 0)
+            BAIL_OUT ("failed to set request sender");
+    }
+    return msg;
+}
+
+void test_basic (void)
+{
+    struct flux_msglist *ml;
+    flux_msg_t *msg[3];
+    int item[3];
+    int i;
+
+    ml = flux_msglist_create ();
+    ok (ml != NULL,
+        "flux_msglist_create works");
+    ok (flux_msglist_count (ml) == 0,
+        "flux_msglist_count returns 0");
+    ok (flux_msglist_first (ml) == NULL,
+        "flux_msglist_first returns NULL");
+    ok (flux_msglist_last (ml) == NULL,
+        "flux_msglist_last returns NULL");
+
+    for (i = 0; i < 3; i++) {
+        msg[i] = create_request ("A", i + 1);
+        ok (flux_msglist_append (ml, msg[i], &item[i]) == 0,
+            "flux_msglist_append item %d works", i);
+    }
+    errno = 0;
+    ok (flux_msglist_append (ml, msg[0], &item[0]) < 0 && errno == EEXIST,
+        "flux_msglist_append of a duplicate item fails with EEXIST");
+    ok (flux_msglist_count (ml) == 3,
+        "flux_msglist_count returns 3");
+
+    ok (flux_msglist_first (ml) == &item[0]
+        && flux_msglist_next (ml) == &item[1]
+        && flux_msglist_next (ml) == &item[2]
+        && flux_msglist_next (ml) == NULL,
+        "items are iterated in order of arrival");
+    ok (flux_msglist_last (ml) == &item[2],
+        "flux_msglist_last returns the last item");
+
+    ok (flux_msglist_first (ml) == &item[0]
+        && flux_msglist_next (ml) == &item[1]
+        && flux_msglist_remove (ml, &item[1]) == 0
+        && flux_msglist_next (ml) == &item[2],
+        "current item can be removed while iterating");
+    errno = 0;
+    ok (flux_msglist_remove (ml, &item[1]) < 0 && errno == ENOENT,
+        "flux_msglist_remove of a removed item fails with ENOENT");
+
+    ok (flux_msglist_pop (ml) == &item[0]
+        && flux_msglist_pop (ml) == &item[2]
+        && flux_msglist_pop (ml) == NULL,
+        "flux_msglist_pop returns items in order, then NULL");
+    ok (flux_msglist_count (ml) == 0,
+        "flux_msglist_count returns 0");
+
+    /* The list holds a reference on each message until the item is removed.
+     */
+    ok (flux_msglist_append (ml, msg[0], &item[0]) == 0,
+        "flux_msglist_append item 0 again");
+    flux_msg_decref (msg[0]);
+    ok (flux_msglist_pop_sender (ml, msg[1], 1) == &item[0],
+        "item can be found after caller drops its message reference");
+
+    for (i = 1; i < 3; i++)
+        flux_msg_decref (msg[i]);
+    flux_msglist_destroy (ml);
+}
+
+void test_sender (void)
+{
+    struct flux_msglist *ml;
+    flux_msg_t *msg[4];
+    flux_msg_t *dis_a, *dis_b, *dis_c;
+    int item[4];
+    int i;
+
+    if (!(ml = flux_msglist_create ()))
+        BAIL_OUT ("flux_msglist_create failed");
+
+    msg[0] = create_request ("A", 1);
+    msg[1] = create_request ("B", 1);
+    msg[2] = create_request ("A", 2);
+    msg[3] = create_request ("B", 2);
+    for (i = 0; i < 4; i++) {
+        if (flux_msglist_append (ml, msg[i], &item[i]) < 0)
+            BAIL_OUT ("flux_msglist_append failed");
+    }
+    dis_a = create_request ("A", FLUX_MATCHTAG_NONE);
+    dis_b = create_request ("B", FLUX_MATCHTAG_NONE);
+    dis_c = create_request ("C", FLUX_MATCHTAG_NONE);
+
+    ok (flux_msglist_pop_sender (ml, dis_c, FLUX_MATCHTAG_NONE) == NULL,
+        "flux_msglist_pop_sender of unknown sender returns NULL");
+    ok (flux_msglist_pop_sender (ml, dis_b, 3) == NULL,
+        "flux_msglist_pop_sender of unknown matchtag returns NULL");
+    ok (flux_msglist_pop_sender (ml, dis_b, 2) == &item[3],
+        "flux_msglist_pop_sender B matchtag=2 returns correct item");
+    ok (flux_msglist_pop_sender (ml, dis_a, FLUX_MATCHTAG_NONE) == &item[0]
+        && flux_msglist_pop_sender (ml, dis_a, FLUX_MATCHTAG_NONE) == &item[2]
+        && flux_msglist_pop_sender (ml, dis_a, FLUX_MATCHTAG_NONE) == NULL,
+        "flux_msglist_pop_sender A returns A's items in order, then NULL");
+    ok (flux_msglist_count (ml) == 1
+        && flux_msglist_first (ml) == &item[1],
+        "B's other item remains");
+    ok (flux_msglist_remove (ml, &item[1]) == 0
+        && flux_msglist_pop_sender (ml, dis_b, FLUX_MATCHTAG_NONE) == NULL,
+        "removed item is no longer found by sender");
+
+    /* Messages without a route stack are indexed under the empty sender.
+     */
+    flux_msg_t *noroute = create_request (NULL, 5);
+    ok (flux_msglist_append (ml, noroute, &item[0]) == 0,
+        "flux_msglist_append works on a request without route stack");
+    ok (flux_msglist_pop_sender (ml, noroute, 5) == &item[0],
+        "flux_msglist_pop_sender finds it by the same message");
+    flux_msg_decref (noroute);
+
+    /* destroy drops remaining items and their message references
+     */
+    ok (flux_msglist_append (ml, msg[0], &item[0]) == 0,
+        "flux_msglist_append item 0");
+
+    for (i = 0; i < 4; i++)
+        flux_msg_decref (msg[i]);
+    flux_msg_decref (dis_a);
+    flux_msg_decref (dis_b);
+    flux_msg_decref (dis_c);
+    flux_msglist_destroy (ml);
+}
+
+void test_errors (void)
+{
+    struct flux_msglist *ml;
+    flux_msg_t *msg;
+    int item;
+
+    if (!(ml = flux_msglist_create ()))
+        BAIL_OUT ("flux_msglist_create failed");
+    msg = create_request ("A", 1);
+
+    errno = 0;
+    ok (flux_msglist_append (NULL, msg, &item) < 0 && errno == EINVAL,
+        "flux_msglist_append ml=NULL fails with EINVAL");
+    errno = 0;
+    ok (flux_msglist_append (ml, NULL, &item) < 0 && errno == EINVAL,
+        "flux_msglist_append msg=NULL fails with EINVAL");
+    errno = 0;
+    ok (flux_msglist_append (ml, msg, NULL) < 0 && errno == EINVAL,
+        "flux_msglist_append item=NULL fails with EINVAL");
+    errno = 0;
+    ok (flux_msglist_remove (NULL, &item) < 0 && errno == EINVAL,
+        "flux_msglist_remove ml=NULL fails with EINVAL");
+    errno = 0;
+    ok (flux_msglist_remove (ml, &item) < 0 && errno == ENOENT,
+        "flux_msglist_remove unknown item fails with ENOENT");
+    errno = 0;
+    ok (flux_msglist_count (NULL) < 0 && errno == EINVAL,
+        "flux_msglist_count ml=NULL fails with EINVAL");
+    ok (flux_msglist_pop_sender (NULL, msg, 1) == NULL,
+        "flux_msglist_pop_sender ml=NULL returns NULL");
+    ok (flux_msglist_pop_sender (ml, NULL, 1) == NULL,
+        "flux_msglist_pop_sender msg=NULL returns NULL");
+    ok (flux_msglist_pop (NULL) == NULL
+        && flux_msglist_first (NULL) == NULL
+        && flux_msglist_next (NULL) == NULL
+        && flux_msglist_last (NULL) == NULL,
+        "flux_msglist_pop/first/next/last ml=NULL return NULL");
+    lives_ok ({flux_msglist_destroy (NULL);},
+        "flux_msglist_destroy ml=NULL doesn't crash");
+
+    flux_msg_decref (msg);
+    flux_msglist_destroy (ml);
+}
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    test_basic ();
+    test_sender ();
+    test_errors ();
+
+    done_testing ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
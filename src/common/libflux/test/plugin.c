@@ -128,6 +128,8 @@ void test_invalid_args ()
         "flux_plugin_match_handler (p, NULL) returns EINVAL");
     ok (flux_plugin_match_handler (NULL, "foo") == NULL && errno == EINVAL,
         "flux_plugin_match_handler (NULL, 'foo') returns EINVAL");
+    ok (flux_plugin_get_handler_generation (NULL) < 0 && errno == EINVAL,
+        "flux_plugin_get_handler_generation (NULL) returns EINVAL");
 
     ok (flux_plugin_load_dso (NULL, NULL) < 0 && errno == EINVAL,
         "flux_plugin_load_dso (NULL, NULL) returns EINVAL");
@@ -275,12 +277,15 @@ int op1 (flux_plugin_t *p, const char *topic,
 
 void test_basic ()
 {
-    int a, b;
+    int a, b, gen;
     flux_plugin_t *p = flux_plugin_create ();
     flux_plugin_arg_t *args = flux_plugin_arg_create ();
     if (!p || !args)
         BAIL_OUT ("flux_plugin_{args_}create failed");
 
+    ok (flux_plugin_get_handler_generation (p) == 0,
+        "flux_plugin_get_handler_generation is initially 0");
+
     ok (flux_plugin_set_name (p, "op") == 0,
         "flux_plugin_set_name works");
     is (flux_plugin_get_name (p), "op",
@@ -290,11 +295,15 @@ void test_basic ()
         "flux_plugin_add_handler (p, 'foo.*', NULL) works");
     ok (flux_plugin_get_handler (p, "foo.*") == NULL,
         "flux_plugin_get_handler (p, 'foo.*') returns NULL");
+    ok (flux_plugin_get_handler_generation (p) == 0,
+        "flux_plugin_get_handler_generation unchanged by no-op remove");
 
     ok (flux_plugin_add_handler (p, "op.*", op1, NULL) == 0,
         "flux_plugin_add_handler() works");
     ok (flux_plugin_get_handler (p, "op.*") == op1,
         "flux_plugin_get_handler (p, 'op.*') returns op1");
+    ok ((gen = flux_plugin_get_handler_generation (p)) > 0,
+        "flux_plugin_get_handler_generation increased after add_handler");
     ok (flux_plugin_match_handler (p, "op.add") == op1,
         "flux_plugin_match_handler (p, 'op.add') returns op1");
 
@@ -328,6 +337,11 @@ void test_basic ()
     ok (flux_plugin_call (p, "foo", args) == 0,
         "callback with no match returns success and does nothing");
 
+    ok (flux_plugin_remove_handler (p, "op.*") == 0,
+        "flux_plugin_remove_handler (p, 'op.*') works");
+    ok (flux_plugin_get_handler_generation (p) > gen,
+        "flux_plugin_get_handler_generation increased after remove");
+
     flux_plugin_arg_destroy (args);
     flux_plugin_destroy (p);
 }
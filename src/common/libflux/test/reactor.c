@@ -1029,6 +1029,202 @@ static void test_timer (flux_reactor_t *reactor)
     flux_watcher_destroy (w);
 }
 
+static int coarse_count = 0;
+static void coarse_stop_other (flux_reactor_t *r, flux_watcher_t *w,
+                               int revents, void *arg)
+{
+    flux_watcher_t *other = arg;
+    coarse_count++;
+    flux_watcher_stop (other);
+}
+
+static void test_coarse_timer (flux_reactor_t *reactor)
+{
+    flux_watcher_t *w, *w2;
+    flux_watcher_t *many[1000];
+    flux_reactor_stats_t stats;
+    double elapsed, t0, t[] = { 0.001, 0.010, 0.050, 0.100 };
+    int i, rc;
+
+    flux_reactor_now_update (reactor);
+
+    errno = 0;
+    ok (!flux_coarse_timer_watcher_create (reactor, -1, 0, oneshot, NULL)
+        && errno == EINVAL,
+        "coarse: creating negative timeout fails with EINVAL");
+    errno = 0;
+    ok (!flux_coarse_timer_watcher_create (reactor, 0, -1, oneshot, NULL)
+        && errno == EINVAL,
+        "coarse: creating negative repeat fails with EINVAL");
+
+    lives_ok ({flux_reactor_get_stats (reactor, NULL);},
+        "flux_reactor_get_stats stats=NULL doesnt crash");
+    flux_reactor_get_stats (reactor, &stats);
+    ok (stats.timers == 0 && stats.coarse_timers == 0,
+        "flux_reactor_get_stats shows no active timers");
+
+    oneshot_errno = 0;
+    ok ((w = flux_coarse_timer_watcher_create (reactor, 0, 0, oneshot, NULL))
+        != NULL,
+        "coarse: creating zero timeout oneshot works");
+    flux_watcher_start (w);
+    flux_reactor_get_stats (reactor, &stats);
+    ok (stats.coarse_timers == 1 && stats.timers == 0,
+        "flux_reactor_get_stats shows one active coarse timer");
+    oneshot_runs = 0;
+    ok (flux_reactor_run (reactor, 0) == 0 && oneshot_runs == 1,
+        "coarse: oneshot was executed once");
+    flux_reactor_get_stats (reactor, &stats);
+    ok (stats.coarse_timers == 0 && stats.coarse_wakeups > 0,
+        "flux_reactor_get_stats shows expired coarse timer is inactive");
+    oneshot_runs = 0;
+    ok (flux_reactor_run (reactor, 0) == 0 && oneshot_runs == 0,
+        "coarse: expired oneshot didn't run");
+
+    for (i = 0; i < sizeof (t) / sizeof (t[0]); i++) {
+        flux_timer_watcher_reset (w, t[i], 0);
+        flux_watcher_start (w);
+        t0 = flux_reactor_now (reactor);
+        oneshot_runs = 0;
+        rc = flux_reactor_run (reactor, 0);
+        elapsed = flux_reactor_now (reactor) - t0;
+        ok (rc == 0 && oneshot_runs == 1 && elapsed >= t[i],
+            "coarse: reactor ran %.3fs oneshot at >= time (%.3fs)",
+            t[i], elapsed);
+    }
+    flux_timer_watcher_reset (w, 10, 0);
+    flux_watcher_start (w);
+    ok (flux_watcher_next_wakeup (w) >= flux_reactor_now (reactor) + 9.9,
+        "coarse: flux_watcher_next_wakeup works");
+    flux_watcher_stop (w);
+    flux_watcher_destroy (w);
+
+    ok ((w = flux_coarse_timer_watcher_create (reactor, 0.01, 0.01,
+                                               repeat, NULL)) != NULL,
+        "coarse: creating 10ms timeout with 10ms repeat works");
+    flux_watcher_start (w);
+    repeat_countdown = 10;
+    t0 = flux_reactor_now (reactor);
+    ok (flux_reactor_run (reactor, 0) == 0 && repeat_countdown == 0,
+        "coarse: repeat timer ran 10x and stopped itself");
+    elapsed = flux_reactor_now (reactor) - t0;
+    ok (elapsed >= 0.01*10,
+        "coarse: elapsed time is >= 10*10ms (%.3fs)", elapsed);
+    flux_watcher_destroy (w);
+
+    /* A population of long timeouts that are stopped without firing,
+     * alongside one short one that stops the rest.
+     */
+    for (i = 0; i < 1000; i++) {
+        if (!(many[i] = flux_coarse_timer_watcher_create (reactor,
+                                                          60. + i,
+                                                          0,
+                                                          oneshot,
+                                                          NULL)))
+            BAIL_OUT ("flux_coarse_timer_watcher_create failed");
+        flux_watcher_start (many[i]);
+    }
+    flux_reactor_get_stats (reactor, &stats);
+    ok (stats.coarse_timers == 1000,
+        "flux_reactor_get_stats shows 1000 active coarse timers");
+    for (i = 0; i < 999; i++)
+        flux_watcher_stop (many[i]);
+    if (!(w2 = flux_timer_watcher_create (reactor, 0.001, 0, NULL, NULL)))
+        BAIL_OUT ("flux_timer_watcher_create failed");
+    flux_watcher_start (w2);
+    ok ((w = flux_coarse_timer_watcher_create (reactor, 0.01, 0,
+                                               coarse_stop_other,
+                                               many[999])) != NULL,
+        "coarse: created timer that stops another");
+    flux_watcher_start (w);
+    flux_reactor_get_stats (reactor, &stats);
+    ok (stats.coarse_timers == 2 && stats.timers == 1,
+        "flux_reactor_get_stats shows 2 coarse timers and 1 timer");
+    oneshot_runs = 0;
+    coarse_count = 0;
+    ok (flux_reactor_run (reactor, 0) == 0
+        && coarse_count == 1 && oneshot_runs == 0,
+        "coarse: reactor exited when last coarse timer was stopped");
+    flux_reactor_get_stats (reactor, &stats);
+    ok (stats.coarse_timers == 0 && stats.timers == 0,
+        "flux_reactor_get_stats shows no active timers");
+    flux_watcher_destroy (w);
+    flux_watcher_destroy (w2);
+    for (i = 0; i < 1000; i++)
+        flux_watcher_destroy (many[i]);
+}
+
+struct profile_result {
+    const char *name;
+    flux_cbstats_t stats;
+    int found;
+};
+
+static void profile_cb (const char *name,
+                        const flux_cbstats_t *stats,
+                        void *arg)
+{
+    struct profile_result *res = arg;
+    if (!strcmp (name, res->name)) {
+        res->stats = *stats;
+        res->found++;
+    }
+}
+
+static void sleep_cb (flux_reactor_t *r, flux_watcher_t *w,
+                      int revents, void *arg)
+{
+    usleep (2000);
+}
+
+static void test_profile (flux_reactor_t *reactor)
+{
+    flux_watcher_t *w;
+    struct profile_result res = { .name = "timer" };
+    int sum = 0;
+
+    ok (flux_reactor_profile_enabled (reactor) == false,
+        "profile: profiling is disabled by default");
+    if (!(w = flux_timer_watcher_create (reactor, 0, 0, sleep_cb, NULL)))
+        BAIL_OUT ("flux_timer_watcher_create failed");
+    flux_watcher_start (w);
+    ok (flux_reactor_run (reactor, 0) == 0,
+        "profile: ran timer with profiling disabled");
+    flux_reactor_profile_foreach (reactor, profile_cb, &res);
+    ok (res.found == 0,
+        "profile: no stats were recorded");
+
+    flux_reactor_profile_enable (reactor, true);
+    ok (flux_reactor_profile_enabled (reactor) == true,
+        "profile: flux_reactor_profile_enable works");
+    for (int i = 0; i < 3; i++) {
+        flux_timer_watcher_reset (w, 0, 0);
+        flux_watcher_start (w);
+        if (flux_reactor_run (reactor, 0) < 0)
+            BAIL_OUT ("flux_reactor_run failed");
+    }
+    flux_reactor_profile_foreach (reactor, profile_cb, &res);
+    ok (res.found == 1 && res.stats.count == 3,
+        "profile: timer callback was counted 3 times");
+    ok (res.stats.max >= 0.002 && res.stats.total >= 3 * 0.002,
+        "profile: max=%.3fs total=%.3fs", res.stats.max, res.stats.total);
+    for (int i = 0; i < FLUX_CBSTATS_BUCKETS; i++)
+        sum += res.stats.hist[i];
+    ok (sum == 3 && res.stats.hist[0] == 0,
+        "profile: histogram counts 3 calls over 1us");
+
+    flux_reactor_profile_clear (reactor);
+    res.found = 0;
+    flux_reactor_profile_foreach (reactor, profile_cb, &res);
+    ok (res.found == 0,
+        "profile: flux_reactor_profile_clear works");
+    flux_reactor_profile_enable (reactor, false);
+    flux_watcher_destroy (w);
+
+    lives_ok ({flux_reactor_profile_foreach (NULL, profile_cb, NULL);},
+        "flux_reactor_profile_foreach r=NULL doesnt crash");
+}
+
 
 /* A reactor callback that immediately stops reactor without error */
 static bool do_stop_callback_ran = false;
@@ -1457,6 +1653,8 @@ int main (int argc, char *argv[])
         "reactor ran to completion (no watchers)");
 
     test_timer (reactor);
+    test_coarse_timer (reactor);
+    test_profile (reactor);
     test_periodic (reactor);
     test_fd (reactor);
     test_buffer (reactor);
@@ -12,6 +12,68 @@
 #include "src/common/libflux/tagpool.h"
 #include "src/common/libtap/tap.h"
 
+static int grow_calls;
+static uint32_t grow_oldsize;
+static uint32_t grow_newsize;
+
+static void grow_cb (void *arg, uint32_t oldsize, uint32_t newsize)
+{
+    grow_calls++;
+    grow_oldsize = oldsize;
+    grow_newsize = newsize;
+}
+
+/* Allocate past the initial pool size, then verify that freed tags
+ * are reused lowest first, and that freeing twice is harmless.
+ */
+void test_grow_reuse (void)
+{
+    struct tagpool *t;
+    uint32_t size;
+    uint32_t avail;
+    uint32_t tag;
+    int i, errors;
+
+    if (!(t = tagpool_create ()))
+        BAIL_OUT ("tagpool_create failed");
+    tagpool_set_grow_cb (t, grow_cb, NULL);
+    size = tagpool_getattr (t, TAGPOOL_ATTR_SIZE);
+
+    errors = 0;
+    for (i = 1; i <= 5000; i++) {
+        if (tagpool_alloc (t) != i)
+            errors++;
+    }
+    ok (errors == 0,
+        "grow: allocated tags 1-5000 in order");
+    ok (grow_calls == 3 && grow_oldsize == 4096 && grow_newsize == 8192,
+        "grow: grow callback was called for each expansion");
+
+    tagpool_free (t, 4000);
+    tagpool_free (t, 100);
+    tagpool_free (t, 3000);
+    ok (tagpool_alloc (t) == 100
+        && tagpool_alloc (t) == 3000
+        && tagpool_alloc (t) == 4000
+        && tagpool_alloc (t) == 5001,
+        "grow: freed tags are reused lowest first");
+
+    tagpool_free (t, 42);
+    avail = tagpool_getattr (t, TAGPOOL_ATTR_AVAIL);
+    tagpool_free (t, 42);
+    ok (tagpool_getattr (t, TAGPOOL_ATTR_AVAIL) == avail,
+        "grow: freeing a free tag does not change avail");
+    tagpool_free (t, FLUX_MATCHTAG_NONE);
+    tagpool_free (t, size + 1);
+    ok (tagpool_getattr (t, TAGPOOL_ATTR_AVAIL) == avail,
+        "grow: freeing FLUX_MATCHTAG_NONE or out of range tag is ignored");
+    tag = tagpool_alloc (t);
+    ok (tag == 42 && tagpool_alloc (t) == 5002,
+        "grow: tag freed twice is allocated only once");
+
+    tagpool_destroy (t);
+}
+
 int main (int argc, char *argv[])
 {
     struct tagpool *t;
@@ -89,6 +151,8 @@ int main (int argc, char *argv[])
 
     tagpool_destroy (t);
 
+    test_grow_reuse ();
+
     done_testing ();
     return (0);
 }
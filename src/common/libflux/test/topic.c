@@ -0,0 +1,163 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#include <errno.h>
+#include <string.h>
+#include <stdio.h>
+#include <pthread.h>
+
+#include "message.h"
+#include "request.h"
+#include "topic_private.h"
+
+#include "src/common/libtap/tap.h"
+
+#define NTHREADS 8
+#define NTOPICS 256
+
+void test_intern (void)
+{
+    const struct flux_topic *t1, *t2, *t3;
+    char buf[256];
+    int count = flux_topic_count ();
+
+    t1 = flux_topic_intern ("foo.bar", 7);
+    ok (t1 != NULL && t1->len == 7 && !strcmp (t1->s, "foo.bar"),
+        "flux_topic_intern works");
+    ok (t1 != NULL && t1->hash == flux_topic_hash ("foo.bar", 7),
+        "interned topic has its hash");
+    ok (flux_topic_count () == count + 1,
+        "topic count increased by one");
+    t2 = flux_topic_intern ("foo.bar.baz", 7);
+    ok (t2 == t1,
+        "interning an equal string returns the same pointer");
+    ok (flux_topic_count () == count + 1,
+        "topic count did not change");
+    t3 = flux_topic_intern ("foo.baz", 7);
+    ok (t3 != NULL && t3 != t1,
+        "interning a different string returns a different pointer");
+    ok (flux_topic_hasher (t1) == t1->hash
+        && flux_topic_comparator (t1, t2) == 0
+        && flux_topic_comparator (t1, t3) != 0,
+        "flux_topic_hasher and flux_topic_comparator work");
+    ok (flux_topic_intern ("", 0) != NULL,
+        "the empty topic can be interned");
+
+    memset (buf, 'x', sizeof (buf));
+    errno = 0;
+    ok (flux_topic_intern (buf, sizeof (buf)) == NULL && errno == EINVAL,
+        "flux_topic_intern of a long topic fails with EINVAL");
+    errno = 0;
+    ok (flux_topic_intern (NULL, 0) == NULL && errno == EINVAL,
+        "flux_topic_intern s=NULL fails with EINVAL");
+}
+
+void test_message (void)
+{
+    flux_msg_t *msg1, *msg2, *cpy;
+    const struct flux_topic *t;
+    const char *topic;
+    char buf[256];
+
+    if (!(msg1 = flux_request_encode ("topic.test", NULL))
+        || !(msg2 = flux_request_encode ("topic.test", NULL)))
+        BAIL_OUT ("flux_request_encode failed");
+    t = flux_msg_get_topic_interned (msg1);
+    ok (t != NULL && !strcmp (t->s, "topic.test"),
+        "request has an interned topic");
+    ok (flux_msg_get_topic_interned (msg2) == t,
+        "requests with the same topic share the interned topic");
+    ok ((cpy = flux_msg_copy (msg1, true)) != NULL
+        && flux_msg_get_topic_interned (cpy) == t,
+        "copy shares the interned topic");
+    flux_msg_destroy (cpy);
+
+    memset (buf, 'x', sizeof (buf) - 1);
+    buf[sizeof (buf) - 1] = '\0';
+    ok (flux_msg_set_topic (msg2, buf) == 0
+        && flux_msg_get_topic_interned (msg2) == NULL
+        && flux_msg_get_topic (msg2, &topic) == 0
+        && !strcmp (topic, buf),
+        "long topic is not interned but still works");
+    ok ((cpy = flux_msg_copy (msg2, true)) != NULL
+        && flux_msg_get_topic (cpy, &topic) == 0
+        && !strcmp (topic, buf),
+        "copy of message with long topic works");
+    flux_msg_destroy (cpy);
+    ok (flux_msg_set_topic (msg2, "topic.test") == 0
+        && flux_msg_get_topic_interned (msg2) == t,
+        "setting the topic back interns it again");
+    ok (flux_msg_set_topic (msg2, NULL) == 0
+        && flux_msg_get_topic_interned (msg2) == NULL,
+        "message without topic has no interned topic");
+
+    flux_msg_destroy (msg1);
+    flux_msg_destroy (msg2);
+}
+
+struct race {
+    pthread_t t;
+    const struct flux_topic *topics[NTOPICS];
+};
+
+static void *race_thread (void *arg)
+{
+    struct race *race = arg;
+    char topic[32];
+    int i;
+
+    for (i = 0; i < NTOPICS; i++) {
+        snprintf (topic, sizeof (topic), "race.%d", i);
+        race->topics[i] = flux_topic_intern (topic, strlen (topic));
+    }
+    return NULL;
+}
+
+void test_threads (void)
+{
+    struct race race[NTHREADS];
+    int count = flux_topic_count ();
+    int errors = 0;
+    int i, j;
+
+    for (i = 0; i < NTHREADS; i++) {
+        if (pthread_create (&race[i].t, NULL, race_thread, &race[i]) != 0)
+            BAIL_OUT ("pthread_create failed");
+    }
+    for (i = 0; i < NTHREADS; i++)
+        pthread_join (race[i].t, NULL);
+    for (i = 0; i < NTHREADS; i++) {
+        for (j = 0; j < NTOPICS; j++) {
+            if (!race[i].topics[j] || race[i].topics[j] != race[0].topics[j])
+                errors++;
+        }
+    }
+    ok (errors == 0,
+        "%d threads interning the same topics got the same pointers",
+        NTHREADS);
+    ok (flux_topic_count () == count + NTOPICS,
+        "each topic was interned once");
+}
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    test_intern ();
+    test_message ();
+    test_threads ();
+
+    done_testing ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
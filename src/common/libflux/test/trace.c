@@ -0,0 +1,123 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#include <errno.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "message.h"
+#include "request.h"
+#include "trace.h"
+
+#include "src/common/libtap/tap.h"
+
+struct collect {
+    int count;
+    uint64_t last_span;
+    const char *last_where;
+    char last_topic[64];
+    int last_type;
+    double last_timestamp;
+};
+
+void collect_cb (const struct flux_trace_event *event, void *arg)
+{
+    struct collect *c = arg;
+
+    c->count++;
+    c->last_span = event->span;
+    c->last_where = event->where;
+    c->last_type = event->type;
+    c->last_timestamp = event->timestamp;
+    snprintf (c->last_topic, sizeof (c->last_topic), "%s", event->topic);
+}
+
+int count_events (uint64_t trace)
+{
+    struct collect c = { 0 };
+
+    if (flux_trace_foreach (trace, collect_cb, &c) < 0)
+        BAIL_OUT ("flux_trace_foreach failed");
+    return c.count;
+}
+
+void test_record (void)
+{
+    flux_msg_t *msg;
+    struct collect c = { 0 };
+    uint64_t t1 = flux_trace_id_create ();
+    uint64_t t2 = flux_trace_id_create ();
+    int i;
+
+    ok (t1 != 0 && t2 != 0 && t1 != t2,
+        "flux_trace_id_create returns distinct nonzero ids");
+    ok (t1 <= INT64_MAX && t2 <= INT64_MAX,
+        "flux_trace_id_create ids are less than 2^63");
+
+    if (!(msg = flux_request_encode ("foo.bar", NULL)))
+        BAIL_OUT ("flux_request_encode failed");
+    flux_trace_record (msg, "test");
+    ok (count_events (0) == 0,
+        "message without trace context is not recorded");
+
+    if (flux_msg_set_trace (msg, t1, 1) < 0)
+        BAIL_OUT ("flux_msg_set_trace failed");
+    flux_trace_record (msg, "test1");
+    if (flux_msg_set_trace (msg, t2, 2) < 0)
+        BAIL_OUT ("flux_msg_set_trace failed");
+    flux_trace_record (msg, "test2");
+    if (flux_msg_set_trace (msg, t1, 3) < 0)
+        BAIL_OUT ("flux_msg_set_trace failed");
+    flux_trace_record (msg, "test3");
+
+    ok (count_events (0) == 3,
+        "flux_trace_foreach trace=0 visits all events");
+    ok (flux_trace_foreach (t1, collect_cb, &c) == 0 && c.count == 2,
+        "flux_trace_foreach visits events of one trace");
+    ok (c.last_span == 3
+        && !strcmp (c.last_where, "test3")
+        && !strcmp (c.last_topic, "foo.bar")
+        && c.last_type == FLUX_MSGTYPE_REQUEST
+        && c.last_timestamp > 0,
+        "last event has expected content");
+
+    flux_trace_clear ();
+    ok (count_events (0) == 0,
+        "flux_trace_clear discards events");
+
+    for (i = 0; i < 5000; i++)
+        flux_trace_record (msg, "wrap");
+    ok (count_events (0) == 4096,
+        "ring keeps the most recent 4096 events");
+    flux_trace_clear ();
+
+    errno = 0;
+    ok (flux_trace_foreach (0, NULL, NULL) < 0 && errno == EINVAL,
+        "flux_trace_foreach fn=NULL fails with EINVAL");
+    lives_ok ({flux_trace_record (NULL, "test");},
+        "flux_trace_record msg=NULL doesn't crash");
+
+    flux_msg_destroy (msg);
+}
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    test_record ();
+
+    done_testing ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
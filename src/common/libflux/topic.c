@@ -0,0 +1,147 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* topic.c - process-wide intern table for message topics
+ *
+ * The table is an open addressing hash of pointers with linear probing.
+ * Entries are only ever added, each with one compare-and-swap on an empty
+ * slot, so readers need no lock.  Two threads adding the same topic race
+ * for the same first empty slot on its probe path, and the loser adopts
+ * the winner's entry.  The entry count is capped at half the slots, which
+ * keeps probes short and guarantees an empty slot ends every probe.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+
+#include "topic_private.h"
+
+#define TOPIC_SLOTS     8192            // power of 2
+#define TOPIC_MAX       (TOPIC_SLOTS / 2)
+#define TOPIC_MAXLEN    128             // longer topics are not interned
+
+static struct flux_topic *topic_slots[TOPIC_SLOTS];
+static int topic_count;
+
+/* FNV-1a
+ */
+uint32_t flux_topic_hash (const char *s, size_t len)
+{
+    uint32_t hash = 2166136261U;
+    size_t i;
+
+    for (i = 0; i < len; i++) {
+        hash ^= (unsigned char)s[i];
+        hash *= 16777619U;
+    }
+    return hash;
+}
+
+static bool topic_equal (const struct flux_topic *t,
+                         uint32_t hash,
+                         const char *s,
+                         size_t len)
+{
+    return t->hash == hash && t->len == len && !memcmp (t->s, s, len);
+}
+
+/* Reserve a place in the table and create an entry for 's'.
+ */
+static struct flux_topic *topic_create (uint32_t hash,
+                                        const char *s,
+                                        size_t len)
+{
+    struct flux_topic *t;
+
+    if (__atomic_add_fetch (&topic_count, 1, __ATOMIC_RELAXED) > TOPIC_MAX)
+        goto full;
+    if (!(t = malloc (sizeof (*t) + len + 1)))
+        goto full;
+    t->hash = hash;
+    t->len = len;
+    memcpy (t->s, s, len);
+    t->s[len] = '\0';
+    return t;
+full:
+    __atomic_sub_fetch (&topic_count, 1, __ATOMIC_RELAXED);
+    return NULL;
+}
+
+static void topic_destroy (struct flux_topic *t)
+{
+    free (t);
+    __atomic_sub_fetch (&topic_count, 1, __ATOMIC_RELAXED);
+}
+
+const struct flux_topic *flux_topic_intern (const char *s, size_t len)
+{
+    struct flux_topic *new = NULL;
+    uint32_t hash;
+    size_t i;
+
+    if (!s || len > TOPIC_MAXLEN) {
+        errno = EINVAL;
+        return NULL;
+    }
+    hash = flux_topic_hash (s, len);
+    i = hash & (TOPIC_SLOTS - 1);
+    for (;;) {
+        struct flux_topic *t;
+
+        t = __atomic_load_n (&topic_slots[i], __ATOMIC_ACQUIRE);
+        if (!t) {
+            if (!new && !(new = topic_create (hash, s, len))) {
+                errno = ENOSPC;
+                return NULL;
+            }
+            if (__atomic_compare_exchange_n (&topic_slots[i],
+                                             &t,
+                                             new,
+                                             false,
+                                             __ATOMIC_RELEASE,
+                                             __ATOMIC_ACQUIRE))
+                return new;
+            // lost the race, 't' is the winner
+        }
+        if (topic_equal (t, hash, s, len)) {
+            if (new)
+                topic_destroy (new);
+            return t;
+        }
+        i = (i + 1) & (TOPIC_SLOTS - 1);
+    }
+}
+
+int flux_topic_count (void)
+{
+    return __atomic_load_n (&topic_count, __ATOMIC_RELAXED);
+}
+
+size_t flux_topic_hasher (const void *key)
+{
+    return ((const struct flux_topic *)key)->hash;
+}
+
+int flux_topic_comparator (const void *key1, const void *key2)
+{
+    uintptr_t a = (uintptr_t)key1;
+    uintptr_t b = (uintptr_t)key2;
+
+    return a < b ? -1 : a > b ? 1 : 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
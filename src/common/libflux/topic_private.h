@@ -0,0 +1,67 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _FLUX_CORE_TOPIC_PRIVATE_H
+#define _FLUX_CORE_TOPIC_PRIVATE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "message.h"
+
+/* Process-wide table of interned topic strings.
+ *
+ * Each distinct topic is stored once, with its hash, and is never freed,
+ * so two interned topics are equal if and only if their pointers are.
+ * Messages intern their topic when it is set, so routing tables can be
+ * keyed by interned topic and probed without hashing or comparing
+ * strings.  The table is bounded, so topics that are long or arrive
+ * after it fills are not interned, and a table keyed by interned topic
+ * needs a string-keyed fallback for them.
+ *
+ * Lookups and inserts are lock-free, so any thread may intern.
+ */
+struct flux_topic {
+    uint32_t hash;
+    uint32_t len;
+    char s[];
+};
+
+/* Return the interned copy of the 'len' byte topic 's', adding it to the
+ * table if necessary, or NULL if it can't be interned.
+ */
+const struct flux_topic *flux_topic_intern (const char *s, size_t len);
+
+/* Return the hash of the 'len' byte string 's', as used for interned
+ * topics.
+ */
+uint32_t flux_topic_hash (const char *s, size_t len);
+
+/* Return the number of interned topics.
+ */
+int flux_topic_count (void);
+
+/* zhashx key hasher and comparator for struct flux_topic keys.
+ * Keys belong to the intern table, so set the key duplicator and
+ * destructor to NULL.
+ */
+size_t flux_topic_hasher (const void *key);
+int flux_topic_comparator (const void *key1, const void *key2);
+
+/* Return the interned topic of 'msg', or NULL if it has none or it
+ * isn't interned.
+ */
+const struct flux_topic *flux_msg_get_topic_interned (const flux_msg_t *msg);
+
+#endif /* !_FLUX_CORE_TOPIC_PRIVATE_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
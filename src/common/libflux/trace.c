@@ -0,0 +1,134 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* trace.c - process-wide ring buffer of traced message events
+ *
+ * The ring is allocated on the first traced message, so a process that
+ * never sees one pays only for the trace context check on each message.
+ * Entries copy the topic into a fixed buffer (truncated if necessary),
+ * so recording never allocates.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "message.h"
+#include "trace.h"
+
+#define TRACE_RING_SIZE     4096
+#define TRACE_TOPIC_SIZE    64
+
+struct trace_entry {
+    struct flux_trace_event event;
+    char topic[TRACE_TOPIC_SIZE];
+};
+
+static pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct trace_entry *trace_ring;
+static unsigned int trace_count; // total recorded, ring index is modulo
+
+static uint64_t id_seed;
+static uint64_t id_counter;
+
+void flux_trace_record (const flux_msg_t *msg, const char *where)
+{
+    uint64_t trace, span;
+    struct trace_entry *entry;
+    struct timespec ts;
+    const char *topic = NULL;
+    int type = 0;
+
+    if (flux_msg_get_trace (msg, &trace, &span) < 0)
+        return;
+    (void)flux_msg_get_type (msg, &type);
+    (void)flux_msg_get_topic (msg, &topic);
+    clock_gettime (CLOCK_REALTIME, &ts);
+
+    pthread_mutex_lock (&trace_lock);
+    if (!trace_ring) {
+        if (!(trace_ring = calloc (TRACE_RING_SIZE, sizeof (*trace_ring))))
+            goto done;
+    }
+    entry = &trace_ring[trace_count++ % TRACE_RING_SIZE];
+    entry->event.trace = trace;
+    entry->event.span = span;
+    entry->event.timestamp = ts.tv_sec + ts.tv_nsec * 1E-9;
+    entry->event.where = where;
+    entry->event.type = type;
+    entry->event.topic = entry->topic;
+    strncpy (entry->topic, topic ? topic : "", TRACE_TOPIC_SIZE - 1);
+    entry->topic[TRACE_TOPIC_SIZE - 1] = '\0';
+done:
+    pthread_mutex_unlock (&trace_lock);
+}
+
+int flux_trace_foreach (uint64_t trace, flux_trace_f fn, void *arg)
+{
+    unsigned int i;
+    unsigned int first;
+
+    if (!fn) {
+        errno = EINVAL;
+        return -1;
+    }
+    pthread_mutex_lock (&trace_lock);
+    if (trace_ring) {
+        first = trace_count > TRACE_RING_SIZE ? trace_count - TRACE_RING_SIZE
+                                              : 0;
+        for (i = first; i != trace_count; i++) {
+            struct trace_entry *entry = &trace_ring[i % TRACE_RING_SIZE];
+            if (trace == 0 || entry->event.trace == trace)
+                fn (&entry->event, arg);
+        }
+    }
+    pthread_mutex_unlock (&trace_lock);
+    return 0;
+}
+
+void flux_trace_clear (void)
+{
+    pthread_mutex_lock (&trace_lock);
+    trace_count = 0;
+    pthread_mutex_unlock (&trace_lock);
+}
+
+/* splitmix64 over a counter, seeded once per process.
+ */
+uint64_t flux_trace_id_create (void)
+{
+    uint64_t z;
+
+    do {
+        pthread_mutex_lock (&trace_lock);
+        if (id_seed == 0) {
+            struct timespec ts;
+            clock_gettime (CLOCK_REALTIME, &ts);
+            id_seed = (((uint64_t)ts.tv_sec << 32) ^ ts.tv_nsec
+                       ^ ((uint64_t)getpid () << 16)) | 1;
+        }
+        z = id_seed + ++id_counter * 0x9e3779b97f4a7c15ULL;
+        pthread_mutex_unlock (&trace_lock);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        z = (z ^ (z >> 31)) & INT64_MAX;
+    } while (z == 0);
+    return z;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
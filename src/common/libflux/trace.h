@@ -0,0 +1,79 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _FLUX_CORE_TRACE_H
+#define _FLUX_CORE_TRACE_H
+
+#include <stdint.h>
+
+#include "message.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* flux_trace - timestamps of traced messages
+ *
+ * A message with a trace context (see flux_msg_set_trace()) is recorded
+ * each time it passes a trace point: when it is sent on a handle, when it
+ * is dispatched to a message handler, and at each broker routing hop.
+ * Events are kept in a ring buffer shared by all threads of the process,
+ * so the broker's events and those of its module threads are together,
+ * and the oldest are overwritten when it is full.  Messages without a
+ * trace context are not recorded.
+ *
+ * flux_rpc() gives a request a new span of the current trace context,
+ * which is that of the message being dispatched (request or response),
+ * if it has one.  Otherwise a new trace is started if the handle has the
+ * FLUX_O_RPCTRACE flag.  Future continuations run after dispatch, so
+ * requests sent from them are not traced unless the service copies the
+ * context.
+ */
+
+struct flux_trace_event {
+    uint64_t trace;
+    uint64_t span;
+    double timestamp;       // wall clock time
+    const char *where;      // trace point
+    int type;               // message type
+    const char *topic;
+};
+
+typedef void (*flux_trace_f)(const struct flux_trace_event *event,
+                             void *arg);
+
+/* Record 'msg' at trace point 'where', which must be a string constant.
+ * This is a no-op if 'msg' has no trace context.
+ */
+void flux_trace_record (const flux_msg_t *msg, const char *where);
+
+/* Call 'fn' for each recorded event of 'trace', or all events if 'trace'
+ * is 0, oldest first.  'fn' must not call flux_trace_record().
+ */
+int flux_trace_foreach (uint64_t trace, flux_trace_f fn, void *arg);
+
+/* Discard all recorded events.
+ */
+void flux_trace_clear (void);
+
+/* Return a new random trace or span id.
+ * Ids are never 0, and are less than 2^63 so they fit in a JSON integer.
+ */
+uint64_t flux_trace_id_create (void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* !_FLUX_CORE_TRACE_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
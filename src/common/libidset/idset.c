@@ -288,6 +288,177 @@ bool idset_equal (const struct idset *idset1,
     return true;
 }
 
+/* Visit ids of 'a' that are (or with 'in_b' false, are not) in 'b'.
+ * Iterate over the smaller set when looking for common ids, so the cost
+ * is proportional to the size of the smaller set.
+ * Returns the number of ids visited, or -1 if visit () fails.
+ */
+typedef int (*visit_f)(struct idset *dst, unsigned int id);
+
+static int idset_visit (const struct idset *a,
+                        const struct idset *b,
+                        bool in_b,
+                        struct idset *dst,
+                        visit_f visit)
+{
+    const struct idset *iter = a;
+    const struct idset *other = b;
+    unsigned int id;
+    int count = 0;
+
+    if (in_b && idset_count (b) < idset_count (a)) {
+        iter = b;
+        other = a;
+    }
+    id = vebsucc (iter->T, 0);
+    while (id < iter->T.M) {
+        /* N.B. visit () may remove 'id' from 'iter' */
+        unsigned int next = vebsucc (iter->T, id + 1);
+        if (idset_test (other, id) == in_b) {
+            if (visit && visit (dst, id) < 0)
+                return -1;
+            count++;
+        }
+        id = next;
+    }
+    return count;
+}
+
+static int visit_put (struct idset *dst, unsigned int id)
+{
+    idset_put (dst, id);
+    return 0;
+}
+
+static int visit_del (struct idset *dst, unsigned int id)
+{
+    idset_del (dst, id);
+    return 0;
+}
+
+int idset_add (struct idset *a, const struct idset *b)
+{
+    unsigned int id;
+
+    if (!a) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!b || idset_count (b) == 0)
+        return 0;
+    if (idset_grow (a, idset_last (b) + 1) < 0)
+        return -1;
+    id = vebsucc (b->T, 0);
+    while (id < b->T.M) {
+        idset_put (a, id);
+        id = vebsucc (b->T, id + 1);
+    }
+    return 0;
+}
+
+int idset_subtract (struct idset *a, const struct idset *b)
+{
+    if (!a) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!b || idset_count (b) == 0)
+        return 0;
+    (void)idset_visit (a, b, true, a, visit_del);
+    return 0;
+}
+
+/* Create an empty set with the flags of 'a' that can hold ids up to 'last'.
+ */
+static struct idset *idset_create_like (const struct idset *a,
+                                        unsigned int last)
+{
+    size_t size = a->T.M;
+    if (last != IDSET_INVALID_ID && last >= size)
+        size = last + 1;
+    return idset_create (size, a->flags);
+}
+
+struct idset *idset_union (const struct idset *a, const struct idset *b)
+{
+    struct idset *result;
+
+    if (!a) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(result = idset_create_like (a, b ? idset_last (b) : 0))
+        || idset_add (result, a) < 0
+        || idset_add (result, b) < 0) {
+        idset_destroy (result);
+        return NULL;
+    }
+    return result;
+}
+
+struct idset *idset_difference (const struct idset *a, const struct idset *b)
+{
+    struct idset *result;
+
+    if (!a) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!b || idset_count (b) == 0)
+        return idset_copy (a);
+    /* Copying 'a' is a memcpy, so if 'b' is the smaller set, copy 'a'
+     * and remove ids of 'b' rather than visit all of 'a'.
+     */
+    if (idset_count (b) < idset_count (a)) {
+        if (!(result = idset_copy (a))
+            || idset_subtract (result, b) < 0) {
+            idset_destroy (result);
+            return NULL;
+        }
+        return result;
+    }
+    if (!(result = idset_create_like (a, 0)))
+        return NULL;
+    (void)idset_visit (a, b, false, result, visit_put);
+    return result;
+}
+
+struct idset *idset_intersect (const struct idset *a, const struct idset *b)
+{
+    struct idset *result;
+
+    if (!a) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(result = idset_create_like (a, 0)))
+        return NULL;
+    if (b)
+        (void)idset_visit (a, b, true, result, visit_put);
+    return result;
+}
+
+bool idset_has_intersection (const struct idset *a, const struct idset *b)
+{
+    const struct idset *iter = a;
+    const struct idset *other = b;
+    unsigned int id;
+
+    if (!a || !b)
+        return false;
+    if (idset_count (b) < idset_count (a)) {
+        iter = b;
+        other = a;
+    }
+    id = vebsucc (iter->T, 0);
+    while (id < iter->T.M) {
+        if (idset_test (other, id))
+            return true;
+        id = vebsucc (iter->T, id + 1);
+    }
+    return false;
+}
+
 /*
  * vi:tabstop=4 shiftwidth=4 expandtab
  */
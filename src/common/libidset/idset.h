@@ -57,6 +57,18 @@ struct idset *idset_decode (const char *s);
  */
 struct idset *idset_ndecode (const char *s, size_t len);
 
+/* Encode idset in a compact binary form of 'size' bytes, a sequence of
+ * ranges, each a pair of LEB128 varints: the gap since the previous
+ * range, and the range length minus one.  The caller must free the result.
+ * Returns buffer on success, or NULL on failure with errno set.
+ */
+void *idset_encode_binary (const struct idset *idset, size_t *size);
+
+/* Decode 'size' bytes of binary encoded idset 'buf'.
+ * Returns idset on success, or NULL on failure with errno set.
+ */
+struct idset *idset_decode_binary (const void *buf, size_t size);
+
 /* Add id (or range [lo-hi]) to idset.
  * Return 0 on success, -1 on failure with errno set.
  */
@@ -100,6 +112,27 @@ size_t idset_count (const struct idset *idset);
  */
 bool idset_equal (const struct idset *set1, const struct idset *set2);
 
+/* Add (or remove) the ids of 'b' to (from) 'a'.  'b' may be NULL.
+ * If 'a' was not created with IDSET_FLAG_AUTOGROW, it must be large
+ * enough to hold the ids added to it.
+ * Return 0 on success, -1 on failure with errno set.
+ */
+int idset_add (struct idset *a, const struct idset *b);
+int idset_subtract (struct idset *a, const struct idset *b);
+
+/* Return a new set that is the union (a + b), difference (a - b), or
+ * intersection of 'a' and 'b', with the flags of 'a'.  'b' may be NULL.
+ * The caller must destroy the returned set.
+ * Returns idset on success, or NULL on failure with errno set.
+ */
+struct idset *idset_union (const struct idset *a, const struct idset *b);
+struct idset *idset_difference (const struct idset *a, const struct idset *b);
+struct idset *idset_intersect (const struct idset *a, const struct idset *b);
+
+/* Return true if 'a' and 'b' have at least one id in common.
+ */
+bool idset_has_intersection (const struct idset *a, const struct idset *b);
+
 /* Expand bracketed idset string(s) in 's', calling 'fun()' for each
  * expanded string.  'fun()' should return 0 on success, or -1 on failure
  * with errno set.  A fun() failure causes idset_format_map () to immediately
@@ -19,6 +19,8 @@
 #include <stdarg.h>
 #include <stdbool.h>
 
+#include "src/common/libutil/errno_safe.h"
+
 #include "idset.h"
 #include "idset_private.h"
 
@@ -61,17 +63,114 @@ static char *trim_brackets (char *s)
     return p;
 }
 
+/* Parse a decimal id from [*p, end) and advance *p past it.
+ * Returns 0 on success, -1 if there are no digits or the value is too large.
+ */
+static int parse_id (const char **p, const char *end, unsigned int *id)
+{
+    const char *s = *p;
+    unsigned long long n = 0;
+
+    while (s < end && *s >= '0' && *s <= '9') {
+        n = n * 10 + (*s++ - '0');
+        if (n >= UINT_MAX)
+            return -1;
+    }
+    if (s == *p)
+        return -1;
+    *p = s;
+    *id = n;
+    return 0;
+}
+
+/* Scan (and if 'idset' is non-NULL, decode) the common case of comma
+ * separated ids and ranges in [s, end).  Set *maxp to the largest id.
+ * Returns 0 on success, -1 on failure with errno set, or 1 if the string
+ * is not in that form.
+ */
+static int scan_ranges (const char *s,
+                        const char *end,
+                        struct idset *idset,
+                        unsigned int *maxp)
+{
+    unsigned int max = 0;
+
+    while (s < end) {
+        unsigned int lo, hi;
+
+        if (*s == ',') {
+            s++;
+            continue;
+        }
+        if (parse_id (&s, end, &lo) < 0)
+            return 1;
+        hi = lo;
+        if (s < end && *s == '-') {
+            s++;
+            if (parse_id (&s, end, &hi) < 0)
+                return 1;
+        }
+        if (s < end && *s != ',')
+            return 1;
+        if (idset && idset_range_set (idset, lo, hi) < 0)
+            return -1;
+        if (lo > max)
+            max = lo;
+        if (hi > max)
+            max = hi;
+    }
+    *maxp = max;
+    return 0;
+}
+
+/* Decode the common case of comma separated ids and ranges with optional
+ * enclosing brackets without copying the string.  The first pass finds
+ * the largest id so the idset is created at its final size, rather than
+ * grown (by reinserting every id) as ids are added.
+ * Returns 0 on success with *idsetp set, -1 on failure with errno set,
+ * or 1 if the string should be decoded by the general purpose parser,
+ * which handles (or rejects) anything else strtoul(3) accepts.
+ */
+static int decode_fast (const char *s, size_t size, struct idset **idsetp)
+{
+    const char *end = memchr (s, '\0', size);
+    struct idset *idset;
+    unsigned int max;
+    int rc;
+
+    if (!end)
+        end = s + size;
+    if (s < end && *s == '[')
+        s++;
+    if (s < end && end[-1] == ']')
+        end--;
+    if ((rc = scan_ranges (s, end, NULL, &max)) != 0)
+        return rc;
+    if (!(idset = idset_create (max < IDSET_DEFAULT_SIZE ? 0 : max + 1,
+                                IDSET_FLAG_AUTOGROW)))
+        return -1;
+    if (scan_ranges (s, end, idset, &max) < 0) {
+        ERRNO_SAFE_WRAP (idset_destroy, idset);
+        return -1;
+    }
+    *idsetp = idset;
+    return 0;
+}
+
 struct idset *idset_ndecode (const char *str, size_t size)
 {
     struct idset *idset;
     char *cpy = NULL;
     char *tok, *saveptr, *a1;
     int saved_errno;
+    int rc;
 
     if (!str) {
         errno = EINVAL;
         return NULL;
     }
+    if ((rc = decode_fast (str, size, &idset)) <= 0)
+        return rc == 0 ? idset : NULL;
     if (!(idset = idset_create (0, IDSET_FLAG_AUTOGROW)))
         return NULL;
     if (!(cpy = strndup (str, size)))
@@ -109,6 +208,87 @@ struct idset *idset_decode (const char *str)
     return idset_ndecode (str, str ? strlen (str) : 0);
 }
 
+/* Parse an unsigned LEB128 varint from [*p, end) and advance *p past it.
+ * Returns 0 on success, -1 if it is truncated or does not fit in 32 bits.
+ */
+static int get_varint (const unsigned char **p,
+                       const unsigned char *end,
+                       unsigned int *np)
+{
+    const unsigned char *s = *p;
+    unsigned long long n = 0;
+    int shift = 0;
+
+    do {
+        if (s == end || shift > 28)
+            return -1;
+        n |= (unsigned long long)(*s & 0x7f) << shift;
+        shift += 7;
+    } while (*s++ & 0x80);
+    if (n > UINT_MAX)
+        return -1;
+    *p = s;
+    *np = n;
+    return 0;
+}
+
+/* Scan (and if 'idset' is non-NULL, decode) binary encoded ranges.
+ * Set *maxp to the largest id.
+ * Returns 0 on success, -1 on failure with errno set.
+ */
+static int scan_binary (const unsigned char *p,
+                        const unsigned char *end,
+                        struct idset *idset,
+                        unsigned int *maxp)
+{
+    unsigned long long next_lo = 0;
+
+    while (p < end) {
+        unsigned int gap, n;
+        unsigned long long lo, hi;
+
+        if (get_varint (&p, end, &gap) < 0
+            || get_varint (&p, end, &n) < 0)
+            goto inval;
+        lo = next_lo + gap;
+        hi = lo + n;
+        if (hi >= UINT_MAX)
+            goto inval;
+        if (idset && idset_range_set (idset, lo, hi) < 0)
+            return -1;
+        next_lo = hi + 1;
+    }
+    *maxp = next_lo > 0 ? next_lo - 1 : 0;
+    return 0;
+inval:
+    errno = EINVAL;
+    return -1;
+}
+
+struct idset *idset_decode_binary (const void *buf, size_t size)
+{
+    const unsigned char *p = buf;
+    struct idset *idset;
+    unsigned int max;
+
+    if (!buf && size > 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!p)
+        p = (const unsigned char *)"";
+    if (scan_binary (p, p + size, NULL, &max) < 0)
+        return NULL;
+    if (!(idset = idset_create (max < IDSET_DEFAULT_SIZE ? 0 : max + 1,
+                                IDSET_FLAG_AUTOGROW)))
+        return NULL;
+    if (scan_binary (p, p + size, idset, &max) < 0) {
+        ERRNO_SAFE_WRAP (idset_destroy, idset);
+        return NULL;
+    }
+    return idset;
+}
+
 /*
  * vi:tabstop=4 shiftwidth=4 expandtab
  */
@@ -16,62 +16,68 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
-#include <stdarg.h>
 #include <stdbool.h>
 
 #include "idset.h"
 #include "idset_private.h"
 
-/* Format a string like printf, then append it to *s.
+/* Append 'n' characters of 'str' to *s.
  * The allocated size of '*s' is '*sz'.
  * The current string length of '*s' is '*len'.
- * Grow *s by IDSET_ENCODE_CHUNK to allow new string to be appended.
+ * Grow *s geometrically, starting at IDSET_ENCODE_CHUNK, so that encoding
+ * a large set makes O(log n) allocations.
  * Returns 0 on success, -1 on failure with errno = ENOMEM.
  */
-static int __attribute__ ((format (printf, 4, 5)))
-catprintf (char **s, size_t *sz, size_t *len, const char *fmt, ...)
+static int catn (char **s, size_t *sz, size_t *len, const char *str, size_t n)
 {
-    va_list ap;
-    char *ns;
-    size_t nlen;
-    int rc;
-
-    va_start (ap, fmt);
-    rc = vasprintf (&ns, fmt, ap);
-    va_end (ap);
-    if (rc < 0)
-        return -1;
-    nlen = strlen (ns);
-
-    while (*len + nlen + 1 > *sz) {
-        size_t nsz = *sz + IDSET_ENCODE_CHUNK;
+    if (*len + n + 1 > *sz) {
+        size_t nsz = *sz ? *sz : IDSET_ENCODE_CHUNK;
         char *p;
-        if (!(p = realloc (*s, nsz)))
-            goto error;
-        if (*s == NULL)
-            *p = '\0';
+
+        while (*len + n + 1 > nsz)
+            nsz *= 2;
+        if (!(p = realloc (*s, nsz))) {
+            errno = ENOMEM;
+            return -1;
+        }
         *s = p;
         *sz = nsz;
     }
-    strcat (*s, ns);
-    *len += nlen;
-    free (ns);
+    memcpy (*s + *len, str, n);
+    *len += n;
+    (*s)[*len] = '\0';
     return 0;
-error:
-    free (ns);
-    errno = ENOMEM;
-    return -1;
+}
+
+/* Format 'n' in decimal, ending just before 'end'.
+ * Returns a pointer to the first digit.
+ */
+static char *fmt_uint (char *end, unsigned int n)
+{
+    char *p = end;
+    do {
+        *--p = '0' + n % 10;
+        n /= 10;
+    } while (n > 0);
+    return p;
 }
 
 static int catrange (char **s, size_t *sz, size_t *len,
                      unsigned int lo, unsigned int hi, const char *sep)
 {
-    int rc;
-    if (lo == hi)
-        rc = catprintf (s, sz, len, "%u%s", lo, sep);
-    else
-        rc = catprintf (s, sz, len, "%u-%u%s", lo, hi, sep);
-    return rc;
+    char buf[32];
+    char *end = buf + sizeof (buf);
+    char *p;
+    size_t seplen = strlen (sep);
+
+    end -= seplen;
+    memcpy (end, sep, seplen);
+    p = fmt_uint (end, hi);
+    if (lo != hi) {
+        *--p = '-';
+        p = fmt_uint (p, lo);
+    }
+    return catn (s, sz, len, p, buf + sizeof (buf) - p);
 }
 
 /* Return value: count of id's in set, or -1 on failure.
@@ -88,7 +94,7 @@ static int encode_ranged (const struct idset *idset,
 
     lo = hi = id = vebsucc (idset->T, 0);
     while (id < idset->T.M) {
-        unsigned int next = vebsucc (idset->T, id + 1);;
+        unsigned int next = vebsucc (idset->T, id + 1);
         bool last = (next == idset->T.M);
 
         if (first)                  // first iteration
@@ -122,9 +128,9 @@ static int encode_simple (const struct idset *idset,
 
     id = vebsucc (idset->T, 0);
     while (id != idset->T.M) {
-        int next = vebsucc (idset->T, id + 1);
+        unsigned int next = vebsucc (idset->T, id + 1);
         char *sep = next == idset->T.M ? "" : ",";
-        if (catprintf (s, sz, len, "%d%s", id, sep) < 0)
+        if (catrange (s, sz, len, id, id, sep) < 0)
             return -1;
         if (count < INT_MAX)
             count++;
@@ -148,7 +154,7 @@ char *idset_encode (const struct idset *idset, int flags)
         return NULL;
     }
     if ((flags & IDSET_FLAG_BRACKETS)) {    // add open brace, if requested
-        if (catprintf (&str, &strsz, &strlength, "[") < 0)
+        if (catn (&str, &strsz, &strlength, "[", 1) < 0)
             goto error;
     }
     if ((flags & IDSET_FLAG_RANGE))
@@ -158,7 +164,7 @@ char *idset_encode (const struct idset *idset, int flags)
     if (count < 0)
         goto error;
     if ((flags & IDSET_FLAG_BRACKETS) && count > 1) { // add close brace
-        if (catprintf (&str, &strsz, &strlength, "]") < 0)
+        if (catn (&str, &strsz, &strlength, "]", 1) < 0)
             goto error;
     }
     if (!str) {
@@ -174,6 +180,65 @@ error:
     return NULL;
 }
 
+/* Append 'n' as an unsigned LEB128 varint to 'buf', which has room.
+ */
+static size_t put_varint (unsigned char *buf, unsigned int n)
+{
+    size_t i = 0;
+    while (n >= 0x80) {
+        buf[i++] = (n & 0x7f) | 0x80;
+        n >>= 7;
+    }
+    buf[i++] = n;
+    return i;
+}
+
+/* Binary encoding: a sequence of ranges, each encoded as two varints,
+ * the gap since the end of the previous range (or 0) and the range
+ * length minus one.  A range takes at most 10 bytes.
+ */
+void *idset_encode_binary (const struct idset *idset, size_t *sizep)
+{
+    unsigned char *buf = NULL;
+    size_t sz = 0;
+    size_t len = 0;
+    unsigned int next_lo = 0;
+    unsigned int id;
+
+    if (!idset || !sizep) {
+        errno = EINVAL;
+        return NULL;
+    }
+    id = vebsucc (idset->T, 0);
+    while (id < idset->T.M) {
+        unsigned int lo = id;
+        unsigned int hi = id;
+
+        while ((id = vebsucc (idset->T, hi + 1)) == hi + 1
+               && id < idset->T.M)
+            hi++;
+        if (len + 10 > sz) {
+            size_t nsz = sz ? sz * 2 : 64;
+            unsigned char *p;
+            if (!(p = realloc (buf, nsz)))
+                goto nomem;
+            buf = p;
+            sz = nsz;
+        }
+        len += put_varint (buf + len, lo - next_lo);
+        len += put_varint (buf + len, hi - lo);
+        next_lo = hi + 1;
+    }
+    if (!buf && !(buf = malloc (1)))
+        goto nomem;
+    *sizep = len;
+    return buf;
+nomem:
+    free (buf);
+    errno = ENOMEM;
+    return NULL;
+}
+
 /*
  * vi:tabstop=4 shiftwidth=4 expandtab
  */
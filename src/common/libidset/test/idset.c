@@ -17,6 +17,7 @@
 #include <czmq.h>
 
 #include "src/common/libtap/tap.h"
+#include "src/common/libutil/monotime.h"
 #include "src/common/libidset/idset.h"
 #include "src/common/libidset/idset_private.h"
 
@@ -133,6 +134,159 @@ void test_codec_large (void)
     idset_destroy (idset);
 }
 
+/* Encode and decode a large set of mostly ranges, as seen in R objects
+ * of big instances, and report the time taken.
+ */
+void test_codec_perf (void)
+{
+    struct idset *idset;
+    struct idset *idset2;
+    struct timespec t0;
+    unsigned int id;
+    char *s;
+    void *buf;
+    size_t size;
+    int i;
+
+    if (!(idset = idset_create (0, IDSET_FLAG_AUTOGROW)))
+        BAIL_OUT ("idset_create failed");
+    for (id = 0; id < 1000000; id += 10) {
+        if (idset_range_set (idset, id, id + (id % 7)) < 0)
+            BAIL_OUT ("idset_range_set failed");
+    }
+
+    monotime (&t0);
+    for (i = 0; i < 10; i++) {
+        if (!(s = idset_encode (idset, IDSET_FLAG_RANGE)))
+            break;
+        if (i < 9)
+            free (s);
+    }
+    ok (i == 10,
+        "idset_encode of %zu ids works", idset_count (idset));
+    diag ("encode: %.3fms each, %zu bytes",
+          monotime_since (t0) / 10, strlen (s));
+
+    monotime (&t0);
+    for (i = 0; i < 10; i++) {
+        if (!(idset2 = idset_decode (s)))
+            break;
+        if (i < 9)
+            idset_destroy (idset2);
+    }
+    ok (i == 10 && idset_equal (idset, idset2),
+        "idset_decode of large set works");
+    diag ("decode: %.3fms each", monotime_since (t0) / 10);
+    idset_destroy (idset2);
+    free (s);
+
+    monotime (&t0);
+    buf = idset_encode_binary (idset, &size);
+    ok (buf != NULL,
+        "idset_encode_binary of large set works");
+    diag ("binary encode: %.3fms, %zu bytes", monotime_since (t0), size);
+    monotime (&t0);
+    idset2 = idset_decode_binary (buf, size);
+    ok (idset2 != NULL && idset_equal (idset, idset2),
+        "idset_decode_binary of large set works");
+    diag ("binary decode: %.3fms", monotime_since (t0));
+    idset_destroy (idset2);
+    free (buf);
+
+    idset_destroy (idset);
+}
+
+struct inout fallback_inputs[] = {
+    { " 1,2",           IDSET_FLAG_RANGE, "1-2" },
+    { "+3",             IDSET_FLAG_RANGE, "3" },
+    { "1--0",           IDSET_FLAG_RANGE, "0-1" },
+    { "1,,2,",          IDSET_FLAG_RANGE, "1-2" },
+    { "[5-3]",          IDSET_FLAG_RANGE, "3-5" },
+    { NULL, 0, NULL },
+};
+
+const char *bad_inputs[] = {
+    "1-", "-", "1-2-3", "a", "1x", "[[1]", "4294967295", "99999999999", NULL,
+};
+
+void test_codec_fallback (void)
+{
+    struct inout *ip;
+    int i;
+
+    for (ip = &fallback_inputs[0]; ip->in != NULL; ip++) {
+        struct idset *idset;
+        char *s = NULL;
+
+        idset = idset_decode (ip->in);
+        if (idset)
+            s = idset_encode (idset, ip->flags);
+        ok (s && !strcmp (s, ip->out),
+            "idset_decode '%s' works", ip->in);
+        free (s);
+        idset_destroy (idset);
+    }
+    for (i = 0; bad_inputs[i] != NULL; i++) {
+        errno = 0;
+        ok (idset_decode (bad_inputs[i]) == NULL && errno == EINVAL,
+            "idset_decode '%s' fails with EINVAL", bad_inputs[i]);
+    }
+    struct idset *idset = idset_ndecode ("1-3,5", 3);
+    ok (idset != NULL && idset_count (idset) == 3,
+        "idset_ndecode stops at size");
+    idset_destroy (idset);
+}
+
+void test_binary (void)
+{
+    struct inout *ip;
+    struct idset *idset;
+    unsigned char trunc[] = { 0x80 };
+    unsigned char big[] = { 0xff, 0xff, 0xff, 0xff, 0x0f, 0x00 };
+    void *buf;
+    size_t size;
+
+    for (ip = &test_inputs[0]; ip->in != NULL; ip++) {
+        struct idset *idset2 = NULL;
+
+        if (!(idset = idset_decode (ip->in)))
+            BAIL_OUT ("idset_decode '%s' failed", ip->in);
+        if ((buf = idset_encode_binary (idset, &size)))
+            idset2 = idset_decode_binary (buf, size);
+        ok (idset2 != NULL && idset_equal (idset, idset2),
+            "idset_encode/decode_binary '%s' works", ip->in);
+        free (buf);
+        idset_destroy (idset2);
+        idset_destroy (idset);
+    }
+
+    if (!(idset = idset_decode ("0-127,1000")))
+        BAIL_OUT ("idset_decode failed");
+    buf = idset_encode_binary (idset, &size);
+    ok (buf != NULL && size == 5,
+        "idset_encode_binary encodes 0-127,1000 in 5 bytes");
+    free (buf);
+    idset_destroy (idset);
+
+    errno = 0;
+    ok (idset_encode_binary (NULL, &size) == NULL && errno == EINVAL,
+        "idset_encode_binary idset=NULL fails with EINVAL");
+    errno = 0;
+    ok (idset_decode_binary (NULL, 1) == NULL && errno == EINVAL,
+        "idset_decode_binary buf=NULL size=1 fails with EINVAL");
+    idset = idset_decode_binary (NULL, 0);
+    ok (idset != NULL && idset_count (idset) == 0,
+        "idset_decode_binary size=0 returns empty set");
+    idset_destroy (idset);
+    errno = 0;
+    ok (idset_decode_binary (trunc, sizeof (trunc)) == NULL
+        && errno == EINVAL,
+        "idset_decode_binary fails on truncated input");
+    errno = 0;
+    ok (idset_decode_binary (big, sizeof (big)) == NULL && errno == EINVAL,
+        "idset_decode_binary fails on out of range id");
+}
+
 void test_badparam (void)
 {
     struct idset *idset;
@@ -704,6 +858,107 @@ void test_format_map (void)
     zlist_destroy (&list);
 }
 
+static bool check_set (const struct idset *idset, const char *expected)
+{
+    char *s;
+    bool result;
+
+    if (!idset || !(s = idset_encode (idset, IDSET_FLAG_RANGE)))
+        return false;
+    result = !strcmp (s, expected);
+    if (!result)
+        diag ("got '%s' expected '%s'", s, expected);
+    free (s);
+    return result;
+}
+
+void test_setops (void)
+{
+    struct idset *a = NULL;
+    struct idset *b = NULL;
+    struct idset *c;
+    struct idset *small = NULL;
+
+    if (!(a = idset_decode ("0-7,100"))
+        || !(b = idset_decode ("4-11"))
+        || !(small = idset_create (8, 0)))
+        BAIL_OUT ("could not create test sets");
+
+    c = idset_union (a, b);
+    ok (check_set (c, "0-11,100") && idset_count (c) == 13,
+        "idset_union works");
+    idset_destroy (c);
+    c = idset_union (b, NULL);
+    ok (check_set (c, "4-11"),
+        "idset_union b=NULL copies a");
+    idset_destroy (c);
+
+    c = idset_difference (a, b);
+    ok (check_set (c, "0-3,100") && idset_count (c) == 5,
+        "idset_difference works");
+    idset_destroy (c);
+    c = idset_difference (b, a);
+    ok (check_set (c, "8-11") && idset_count (c) == 4,
+        "idset_difference works with smaller first set");
+    idset_destroy (c);
+    c = idset_difference (a, NULL);
+    ok (check_set (c, "0-7,100"),
+        "idset_difference b=NULL copies a");
+    idset_destroy (c);
+
+    c = idset_intersect (a, b);
+    ok (check_set (c, "4-7") && idset_count (c) == 4,
+        "idset_intersect works");
+    idset_destroy (c);
+    c = idset_intersect (a, small);
+    ok (check_set (c, "") && idset_count (c) == 0,
+        "idset_intersect with empty set is empty");
+    idset_destroy (c);
+
+    ok (idset_has_intersection (a, b) == true,
+        "idset_has_intersection returns true for overlapping sets");
+    ok (idset_has_intersection (a, small) == false
+        && idset_has_intersection (a, NULL) == false,
+        "idset_has_intersection returns false for disjoint sets");
+
+    if (!(c = idset_copy (a)))
+        BAIL_OUT ("idset_copy failed");
+    ok (idset_add (c, b) == 0 && check_set (c, "0-11,100")
+        && idset_count (c) == 13,
+        "idset_add works");
+    ok (idset_subtract (c, b) == 0 && check_set (c, "0-3,100")
+        && idset_count (c) == 5,
+        "idset_subtract works");
+    ok (idset_subtract (c, NULL) == 0 && idset_add (c, NULL) == 0
+        && check_set (c, "0-3,100"),
+        "idset_add/subtract b=NULL is a no-op");
+    idset_destroy (c);
+
+    errno = 0;
+    ok (idset_add (small, a) < 0 && errno == EINVAL,
+        "idset_add fails with EINVAL if set cannot grow");
+
+    errno = 0;
+    ok (idset_add (NULL, a) < 0 && errno == EINVAL,
+        "idset_add a=NULL fails with EINVAL");
+    errno = 0;
+    ok (idset_subtract (NULL, a) < 0 && errno == EINVAL,
+        "idset_subtract a=NULL fails with EINVAL");
+    errno = 0;
+    ok (idset_union (NULL, a) == NULL && errno == EINVAL,
+        "idset_union a=NULL fails with EINVAL");
+    errno = 0;
+    ok (idset_difference (NULL, a) == NULL && errno == EINVAL,
+        "idset_difference a=NULL fails with EINVAL");
+    errno = 0;
+    ok (idset_intersect (NULL, a) == NULL && errno == EINVAL,
+        "idset_intersect a=NULL fails with EINVAL");
+
+    idset_destroy (a);
+    idset_destroy (b);
+    idset_destroy (small);
+}
+
 void issue_1974(void)
 {
     struct idset *idset;
@@ -752,6 +1007,9 @@ int main (int argc, char *argv[])
     test_badparam ();
     test_codec ();
     test_codec_large ();
+    test_codec_perf ();
+    test_codec_fallback ();
+    test_binary ();
     test_iter ();
     test_set ();
     test_range_set ();
@@ -762,6 +1020,7 @@ int main (int argc, char *argv[])
     test_autogrow ();
     test_format_first ();
     test_format_map ();
+    test_setops ();
     issue_1974 ();
     issue_2336 ();
 
@@ -14,6 +14,7 @@
 #include <unistd.h>
 #include <sys/types.h>
 #include <ctype.h>
+#include <string.h>
 #include <flux/core.h>
 #if HAVE_FLUX_SECURITY
 #include <flux/security/sign.h>
@@ -128,6 +129,112 @@ int flux_job_submit_get_id (flux_future_t *f, flux_jobid_t *jobid)
     return 0;
 }
 
+flux_future_t *flux_job_submit_bulk (flux_t *h,
+                                     int count,
+                                     const char **jobspecs,
+                                     int priority,
+                                     int flags)
+{
+    flux_future_t *f = NULL;
+    json_t *jobs;
+    int i;
+    int saved_errno;
+#if HAVE_FLUX_SECURITY
+    flux_security_t *sec = NULL;
+#endif
+
+    if (!h || count < 1 || !jobspecs) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(jobs = json_array ()))
+        goto nomem;
+#if HAVE_FLUX_SECURITY
+    if (!(flags & FLUX_JOB_PRE_SIGNED)) {
+        if (!(sec = get_security_ctx (h, &f))) {
+            json_decref (jobs);
+            return f;
+        }
+    }
+#endif
+    for (i = 0; i < count; i++) {
+        json_t *o = NULL;
+
+        if (!jobspecs[i]) {
+            errno = EINVAL;
+            goto error;
+        }
+        if ((flags & FLUX_JOB_PRE_SIGNED))
+            o = json_string (jobspecs[i]);
+        else {
+#if HAVE_FLUX_SECURITY
+            const char *J;
+            if (!(J = flux_sign_wrap (sec, jobspecs[i], strlen (jobspecs[i]),
+                                      NULL, 0))) {
+                json_decref (jobs);
+                return get_security_error (sec);
+            }
+            o = json_string (J);
+#else
+            char *J;
+            if (!(J = sign_none_wrap (jobspecs[i], strlen (jobspecs[i]),
+                                      getuid ())))
+                goto error;
+            o = json_string (J);
+            free (J);
+#endif
+        }
+        if (!o || json_array_append_new (jobs, o) < 0) {
+            json_decref (o);
+            goto nomem;
+        }
+    }
+    flags &= ~FLUX_JOB_PRE_SIGNED; // client only flag
+    if (!(f = flux_rpc_pack (h, "job-ingest.submit-bulk", FLUX_NODEID_ANY, 0,
+                             "{s:O s:i s:i}",
+                             "jobs", jobs,
+                             "priority", priority,
+                             "flags", flags)))
+        goto error;
+    json_decref (jobs);
+    return f;
+nomem:
+    errno = ENOMEM;
+error:
+    saved_errno = errno;
+    json_decref (jobs);
+    errno = saved_errno;
+    return NULL;
+}
+
+int flux_job_submit_bulk_get_ids (flux_future_t *f,
+                                  int count,
+                                  flux_jobid_t *ids)
+{
+    json_t *a;
+    json_t *o;
+    size_t index;
+
+    if (!f || count < 1 || !ids) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (flux_rpc_get_unpack (f, "{s:o}", "ids", &a) < 0)
+        return -1;
+    if (!json_is_array (a) || json_array_size (a) != count) {
+        errno = EPROTO;
+        return -1;
+    }
+    json_array_foreach (a, index, o) {
+        if (!json_is_integer (o)) {
+            errno = EPROTO;
+            return -1;
+        }
+        ids[index] = json_integer_value (o);
+    }
+    return 0;
+}
+
 flux_future_t *flux_job_wait (flux_t *h, flux_jobid_t id)
 {
     if (!h) {
@@ -143,6 +250,23 @@ flux_future_t *flux_job_wait (flux_t *h, flux_jobid_t id)
                           id);
 }
 
+flux_future_t *flux_job_wait_batch (flux_t *h, int max)
+{
+    if (!h || max < 1) {
+        errno = EINVAL;
+        return NULL;
+    }
+    return flux_rpc_pack (h,
+                          "job-manager.wait",
+                          FLUX_NODEID_ANY,
+                          0,
+                          "{s:I s:i}",
+                          "id",
+                          FLUX_JOBID_ANY,
+                          "max",
+                          max);
+}
+
 int flux_job_wait_get_status (flux_future_t *f,
                               bool *successp,
                               const char **errstrp)
@@ -412,8 +536,9 @@ int flux_job_kvs_namespace (char *buf, int bufsz, flux_jobid_t id)
     return len;
 }
 
-flux_future_t *flux_job_event_watch (flux_t *h, flux_jobid_t id,
-                                     const char *path, int flags)
+flux_future_t *flux_job_event_watch_from (flux_t *h, flux_jobid_t id,
+                                          const char *path, int flags,
+                                          int start)
 {
     flux_future_t *f;
     const char *topic = "job-info.eventlog-watch";
@@ -431,10 +556,11 @@ flux_future_t *flux_job_event_watch (flux_t *h, flux_jobid_t id,
         guest = true;
     }
     if (!(f = flux_rpc_pack (h, topic, FLUX_NODEID_ANY, rpc_flags,
-                             "{s:I s:s s:i}",
+                             "{s:I s:s s:i s:i}",
                              "id", id,
                              "path", path,
-                             "flags", flags)))
+                             "flags", flags,
+                             "start", start)))
         return NULL;
     if (guest) {
         /* value not relevant, set to anything */
@@ -446,6 +572,12 @@ flux_future_t *flux_job_event_watch (flux_t *h, flux_jobid_t id,
     return f;
 }
 
+flux_future_t *flux_job_event_watch (flux_t *h, flux_jobid_t id,
+                                     const char *path, int flags)
+{
+    return flux_job_event_watch_from (h, id, path, flags, 0);
+}
+
 int flux_job_event_watch_get (flux_future_t *f, const char **event)
 {
     const char *s;
@@ -523,6 +655,72 @@ inval:
     return -1;
 }
 
+static void put_u64 (uint8_t *p, uint64_t val)
+{
+    int i;
+
+    for (i = 7; i >= 0; i--) {
+        p[i] = val & 0xff;
+        val >>= 8;
+    }
+}
+
+static uint64_t get_u64 (const uint8_t *p)
+{
+    uint64_t val = 0;
+    int i;
+
+    for (i = 0; i < 8; i++)
+        val = (val << 8) | p[i];
+    return val;
+}
+
+int flux_job_transition_encode (void *buf, int bufsz,
+                                flux_jobid_t id,
+                                flux_job_state_t state,
+                                double timestamp)
+{
+    uint8_t *p = buf;
+    uint64_t t;
+
+    if (!buf || bufsz < FLUX_JOB_TRANSITION_SIZE) {
+        errno = EINVAL;
+        return -1;
+    }
+    memcpy (&t, &timestamp, sizeof (t));
+    put_u64 (p, id);
+    p[8] = (state >> 24) & 0xff;
+    p[9] = (state >> 16) & 0xff;
+    p[10] = (state >> 8) & 0xff;
+    p[11] = state & 0xff;
+    put_u64 (p + 12, t);
+    return 0;
+}
+
+int flux_job_transition_decode (const void *buf, int bufsz,
+                                flux_jobid_t *id,
+                                flux_job_state_t *state,
+                                double *timestamp)
+{
+    const uint8_t *p = buf;
+    uint64_t t;
+
+    if (!buf || bufsz < FLUX_JOB_TRANSITION_SIZE) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (id)
+        *id = get_u64 (p);
+    if (state)
+        *state = ((uint32_t)p[8] << 24) | ((uint32_t)p[9] << 16)
+                 | ((uint32_t)p[10] << 8) | p[11];
+    if (timestamp) {
+        t = get_u64 (p + 12);
+        memcpy (timestamp, &t, sizeof (t));
+    }
+    return 0;
+}
+
 const char *flux_job_resulttostr (flux_job_result_t result, bool abbrev)
 {
     switch (result) {
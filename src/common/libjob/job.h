@@ -87,6 +87,23 @@ const char *flux_job_resulttostr (flux_job_result_t result, bool abbrev);
 
 int flux_job_strtoresult (const char *s, flux_job_result_t *result);
 
+/* Compact job state transition records, as published by the job manager
+ * in "job-transitions" events when enabled.  The event payload is an array
+ * of FLUX_JOB_TRANSITION_SIZE byte records, each holding a jobid, the new
+ * state, and the transition timestamp in network byte order.
+ * Return 0 on success, -1 on failure with errno set.
+ */
+#define FLUX_JOB_TRANSITION_SIZE 20
+
+int flux_job_transition_encode (void *buf, int bufsz,
+                                flux_jobid_t id,
+                                flux_job_state_t state,
+                                double timestamp);
+int flux_job_transition_decode (const void *buf, int bufsz,
+                                flux_jobid_t *id,
+                                flux_job_state_t *state,
+                                double *timestamp);
+
 /* Submit a job to the system.
  * 'jobspec' should be RFC 14 jobspec.
  * 'priority' should be a value from 0 to 31 (16 if not instance owner).
@@ -102,6 +119,25 @@ flux_future_t *flux_job_submit (flux_t *h, const char *jobspec,
  */
 int flux_job_submit_get_id (flux_future_t *f, flux_jobid_t *id);
 
+/* Submit 'count' jobs in one request, with common 'priority' and 'flags'.
+ * Jobs are validated and committed together: either all are accepted,
+ * or the request fails and none are.  If validation fails, the extended
+ * error message identifies the first failing job by its index.
+ */
+flux_future_t *flux_job_submit_bulk (flux_t *h,
+                                     int count,
+                                     const char **jobspecs,
+                                     int priority,
+                                     int flags);
+
+/* Parse jobids from response to flux_job_submit_bulk() request.
+ * 'ids' must have room for the 'count' jobids, which are returned in
+ * the order the jobspecs were submitted.
+ */
+int flux_job_submit_bulk_get_ids (flux_future_t *f,
+                                  int count,
+                                  flux_jobid_t *ids);
+
 /* Wait for jobid to enter INACTIVE state.
  * If jobid=FLUX_JOBID_ANY, wait for the next waitable job.
  * Fails with ECHILD if there is nothing to wait for.
@@ -112,6 +148,14 @@ int flux_job_wait_get_status (flux_future_t *f,
                               const char **errstr);
 int flux_job_wait_get_id (flux_future_t *f, flux_jobid_t *id);
 
+/* Wait for up to 'max' waitable jobs at once.  All jobs that are
+ * already INACTIVE are returned, up to 'max', or if there are none, the
+ * next waitable job to enter INACTIVE state.  Fails with ECHILD if
+ * there is nothing to wait for.
+ * The response is {"jobs":[{"id":I, "success":b, "errstr":s}, ...]}.
+ */
+flux_future_t *flux_job_wait_batch (flux_t *h, int max);
+
 /* Request a list of jobs.
  * If 'max_entries' > 0, fetch at most that many jobs.
  * 'json_str' is an encoded JSON array of attribute strings, e.g.
@@ -194,9 +238,16 @@ int flux_job_kvs_namespace (char *buf,
 
 /* Job eventlog watch functions
  * - path specifies optional alternate eventlog path
+ * - flux_job_event_watch_from() skips the first 'start' entries, e.g. to
+ *   resume a watch after the entries already received.  If 'start' is
+ *   negative, the watch begins with the last -start entries present
+ *   (not supported for guest eventlogs).
  */
 flux_future_t *flux_job_event_watch (flux_t *h, flux_jobid_t id,
                                      const char *path, int flags);
+flux_future_t *flux_job_event_watch_from (flux_t *h, flux_jobid_t id,
+                                          const char *path, int flags,
+                                          int start);
 int flux_job_event_watch_get (flux_future_t *f, const char **event);
 int flux_job_event_watch_cancel (flux_future_t *f);
 
@@ -0,0 +1,171 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <jansson.h>
+
+#include "jobspec_summary.h"
+
+struct res_level {
+    const char *type;
+    int count;
+    json_t *with;
+};
+
+static int __attribute__ ((format (printf, 2, 3)))
+set_error (json_error_t *error, const char *fmt, ...)
+{
+    va_list ap;
+
+    if (error) {
+        va_start (ap, fmt);
+        vsnprintf (error->text, sizeof (error->text), fmt, ap);
+        va_end (ap);
+    }
+    errno = EINVAL;
+    return -1;
+}
+
+static int parse_res_level (json_t *o,
+                            int level,
+                            struct res_level *resp,
+                            json_error_t *error)
+{
+    json_error_t loc_error;
+    struct res_level res;
+
+    if (o == NULL)
+        return set_error (error, "level %d: missing", level);
+    res.with = NULL;
+    /* For jobspec version 1, expect exactly one array element per level.
+     */
+    if (json_unpack_ex (o, &loc_error, 0,
+                        "[{s:s s:i s?o}]",
+                        "type", &res.type,
+                        "count", &res.count,
+                        "with", &res.with) < 0)
+        return set_error (error, "level %d: %s", level, loc_error.text);
+    *resp = res;
+    return 0;
+}
+
+static int parse_resources (json_t *resources,
+                            struct jobspec_summary *js,
+                            json_error_t *error)
+{
+    struct res_level res[3];
+
+    /* For jobspec version 1, expect either:
+     * - node->slot->core->NIL
+     * - slot->core->NIL
+     */
+    memset (res, 0, sizeof (res));
+    if (parse_res_level (resources, 0, &res[0], error) < 0)
+        return -1;
+    if (res[0].with && parse_res_level (res[0].with, 1, &res[1], error) < 0)
+        return -1;
+    if (res[1].with && parse_res_level (res[1].with, 2, &res[2], error) < 0)
+        return -1;
+    if (res[0].type != NULL && !strcmp (res[0].type, "slot")
+            && res[1].type != NULL && !strcmp (res[1].type, "core")
+            && res[1].with == NULL) {
+        js->slot_count = res[0].count;
+        js->cores_per_slot = res[1].count;
+        js->slots_per_node = -1; // unspecified
+    }
+    else if (res[0].type != NULL && !strcmp (res[0].type, "node")
+            && res[1].type != NULL && !strcmp (res[1].type, "slot")
+            && res[2].type != NULL && !strcmp (res[2].type, "core")
+            && res[2].with == NULL) {
+        js->node_count = res[0].count;
+        js->slot_count = res[0].count * res[1].count;
+        js->cores_per_slot = res[2].count;
+        js->slots_per_node = res[1].count;
+    }
+    else {
+        return set_error (error,
+                          "Unexpected resource hierarchy: %s->%s->%s%s",
+                          res[0].type ? res[0].type : "NULL",
+                          res[1].type ? res[1].type : "NULL",
+                          res[2].type ? res[2].type : "NULL",
+                          res[2].with ? "->..." : "");
+    }
+    return 0;
+}
+
+static int parse_tasks (json_t *tasks,
+                        struct jobspec_summary *js,
+                        json_error_t *error)
+{
+    if (json_unpack_ex (tasks, NULL, 0,
+                        "[{s:{s:i}}]",
+                        "count", "total", &js->task_count) < 0) {
+        int per_slot;
+        if (json_unpack_ex (tasks, NULL, 0,
+                            "[{s:{s:i}}]",
+                            "count", "per_slot", &per_slot) < 0)
+            return set_error (error, "Unable to parse task count");
+        if (per_slot != 1)
+            return set_error (error,
+                              "per_slot count: expected 1 got %d",
+                              per_slot);
+        js->task_count = js->slot_count;
+    }
+    if (json_unpack_ex (tasks, NULL, 0,
+                        "[{s:o}]",
+                        "command", &js->command) < 0)
+        return set_error (error, "Unable to parse command");
+    if (!json_is_array (js->command))
+        return set_error (error, "Malformed command entry");
+    return 0;
+}
+
+int jobspec_summary_parse (json_t *jobspec,
+                           struct jobspec_summary *js,
+                           json_error_t *error)
+{
+    int version;
+    json_t *tasks;
+    json_t *resources;
+    json_error_t loc_error;
+
+    if (!jobspec || !js)
+        return set_error (error, "invalid argument");
+    memset (js, 0, sizeof (*js));
+    if (json_unpack_ex (jobspec, &loc_error, 0,
+                        "{s:i s:o s:o s:{s:{s?F s?s s?{s?s}}}}",
+                        "version", &version,
+                        "resources", &resources,
+                        "tasks", &tasks,
+                        "attributes",
+                            "system",
+                                "duration", &js->duration,
+                                "cwd", &js->cwd,
+                                "job",
+                                    "name", &js->name) < 0)
+        return set_error (error, "%s", loc_error.text);
+    if (version != 1)
+        return set_error (error,
+                          "Invalid jobspec version: expected 1 got %d",
+                          version);
+    if (parse_resources (resources, js, error) < 0
+        || parse_tasks (tasks, js, error) < 0)
+        return -1;
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
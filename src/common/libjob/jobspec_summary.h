@@ -0,0 +1,44 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _JOBSPEC_SUMMARY_H
+#define _JOBSPEC_SUMMARY_H
+
+#include <jansson.h>
+
+/* Counts and commonly used members of a V1 jobspec (RFC 25).
+ * json_t and string members are borrowed from the decoded jobspec.
+ */
+struct jobspec_summary {
+    int task_count;             // number of tasks in job
+    int slot_count;             // number of task slots
+    int cores_per_slot;         // number of cores per task slot
+    int slots_per_node;         // number of slots per node (-1=unspecified)
+    int node_count;             // number of nodes (0=unspecified)
+    double duration;            // attributes.system.duration (0=unset)
+    json_t *command;            // tasks[0].command array
+    const char *cwd;            // attributes.system.cwd, if any
+    const char *name;           // attributes.system.job.name, if any
+};
+
+/* Summarize decoded V1 'jobspec' in 'js'.  The resources of a V1 jobspec
+ * are either node->slot->core or slot->core, with one entry per level.
+ * Returns 0 on success, or -1 with errno set to EINVAL and a reason
+ * copied to 'error->text'.
+ */
+int jobspec_summary_parse (json_t *jobspec,
+                           struct jobspec_summary *js,
+                           json_error_t *error);
+
+#endif /* !_JOBSPEC_SUMMARY_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
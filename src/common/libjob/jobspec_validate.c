@@ -0,0 +1,273 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* jobspec_validate - check jobspec without a Python validator
+ *
+ * This mirrors the Jobspec and JobspecV1 constructors of the flux.job
+ * Python module, so that a jobspec is accepted or rejected the same way,
+ * with the same message, whichever validator job-ingest runs.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <jansson.h>
+
+#include "jobspec_validate.h"
+
+static int set_error (json_error_t *error, const char *fmt, ...)
+{
+    va_list ap;
+
+    if (error) {
+        va_start (ap, fmt);
+        vsnprintf (error->text, sizeof (error->text), fmt, ap);
+        va_end (ap);
+    }
+    errno = EINVAL;
+    return -1;
+}
+
+/* Fail if any of the NULL-terminated 'keys' is missing from object 'o'
+ * (unless 'optional'), or if 'o' has any other key (unless 'additional').
+ */
+static int validate_keys (json_t *o,
+                          const char **keys,
+                          bool optional,
+                          bool additional,
+                          json_error_t *error)
+{
+    const char *key;
+    json_t *value;
+    int i;
+
+    if (!optional) {
+        for (i = 0; keys[i] != NULL; i++) {
+            if (!json_object_get (o, keys[i]))
+                return set_error (error, "Missing key (%s)", keys[i]);
+        }
+    }
+    if (!additional) {
+        json_object_foreach (o, key, value) {
+            for (i = 0; keys[i] != NULL; i++) {
+                if (!strcmp (key, keys[i]))
+                    break;
+            }
+            if (keys[i] == NULL)
+                return set_error (error, "Extraneous key (%s)", key);
+        }
+    }
+    return 0;
+}
+
+/* Python treats true and false as the integers 1 and 0.
+ */
+static bool is_boolean (json_t *o)
+{
+    return json_is_boolean (o)
+        || (json_is_number (o)
+            && (json_number_value (o) == 0 || json_number_value (o) == 1));
+}
+
+static int validate_complex_range (json_t *range, json_error_t *error)
+{
+    const char *keys[] = { "min", "max", "operator", "operand", NULL };
+    const char *intkeys[] = { "min", "max", "operand", NULL };
+    json_t *op;
+    int i;
+
+    if (!json_object_get (range, "min"))
+        return set_error (error, "min must be in range");
+    if (json_object_size (range) > 1
+        && validate_keys (range, keys, false, false, error) < 0)
+        return -1;
+    for (i = 0; intkeys[i] != NULL; i++) {
+        json_t *o = json_object_get (range, intkeys[i]);
+        if (!o)
+            continue;
+        if (!json_is_integer (o))
+            return set_error (error, "%s must be an int", intkeys[i]);
+        if (json_integer_value (o) < 1)
+            return set_error (error, "%s must be > 0", intkeys[i]);
+    }
+    if ((op = json_object_get (range, "operator"))
+        && (!json_is_string (op)
+            || strlen (json_string_value (op)) != 1
+            || !strchr ("+*^", json_string_value (op)[0])))
+        return set_error (error, "operator must be one of ['+', '*', '^']");
+    return 0;
+}
+
+static int validate_resource (json_t *res, json_error_t *error)
+{
+    const char *strkeys[] = { "id", "unit", "label", NULL };
+    json_t *type;
+    json_t *count;
+    json_t *o;
+    int i;
+
+    if (!json_is_object (res))
+        return set_error (error, "resource must be a mapping");
+    if (!(type = json_object_get (res, "type")))
+        return set_error (error, "type is a required key for resources");
+    if (!json_is_string (type))
+        return set_error (error, "type must be a string");
+    if (!(count = json_object_get (res, "count")))
+        return set_error (error, "count is a required key for resources");
+    if (json_is_object (count)) {
+        if (validate_complex_range (count, error) < 0)
+            return -1;
+    }
+    else if (!json_is_integer (count))
+        return set_error (error, "count must be an int or mapping");
+    else if (json_integer_value (count) < 1)
+        return set_error (error, "count must be > 0");
+    for (i = 0; strkeys[i] != NULL; i++) {
+        if ((o = json_object_get (res, strkeys[i])) && !json_is_string (o))
+            return set_error (error, "%s must be a string", strkeys[i]);
+    }
+    if ((o = json_object_get (res, "exclusive")) && !is_boolean (o))
+        return set_error (error, "exclusive must be a boolean");
+    if (!strcmp (json_string_value (type), "slot")
+        && !json_object_get (res, "label"))
+        return set_error (error, "slots must have labels");
+    return 0;
+}
+
+/* Validate each resource in 'resources', then its children, depth first.
+ */
+static int validate_resources (json_t *resources, json_error_t *error)
+{
+    size_t index;
+    json_t *res;
+
+    json_array_foreach (resources, index, res) {
+        json_t *with;
+
+        if (validate_resource (res, error) < 0)
+            return -1;
+        if ((with = json_object_get (res, "with"))) {
+            if (!json_is_array (with))
+                return set_error (error, "with must be a sequence");
+            if (validate_resources (with, error) < 0)
+                return -1;
+        }
+    }
+    return 0;
+}
+
+static int validate_task (json_t *task, json_error_t *error)
+{
+    const char *keys[] = { "command", "slot", "count", NULL };
+    json_t *command;
+    json_t *o;
+    size_t index;
+
+    if (!json_is_object (task))
+        return set_error (error, "task must be a mapping");
+    if (validate_keys (task, keys, false, true, error) < 0)
+        return -1;
+    if (!json_is_object (json_object_get (task, "count")))
+        return set_error (error, "count must be a mapping");
+    if (!json_is_string (json_object_get (task, "slot")))
+        return set_error (error, "slot must be a string");
+    if ((o = json_object_get (task, "attributes")) && !json_is_object (o))
+        return set_error (error, "attributes must be a mapping");
+    command = json_object_get (task, "command");
+    if ((json_is_array (command) && json_array_size (command) == 0)
+        || (json_is_string (command) && json_string_length (command) == 0))
+        return set_error (error, "command array cannot have length of zero");
+    if (!json_is_array (command))
+        return set_error (error, "command must be a list of strings");
+    json_array_foreach (command, index, o) {
+        if (!json_is_string (o))
+            return set_error (error, "command must be a list of strings");
+    }
+    return 0;
+}
+
+static int validate_v1 (json_t *attributes, json_error_t *error)
+{
+    json_t *system;
+    json_t *duration;
+
+    if (!(system = json_object_get (attributes, "system")))
+        return set_error (error, "attributes.system is a required key");
+    if (!json_is_object (system))
+        return set_error (error, "attributes.system must be a mapping");
+    if (!(duration = json_object_get (system, "duration")))
+        return set_error (error,
+                          "attributes.system.duration is a required key");
+    if (!json_is_number (duration) && !json_is_boolean (duration))
+        return set_error (error,
+                          "attributes.system.duration must be a number");
+    return 0;
+}
+
+int jobspec_validate (json_t *jobspec,
+                      int require_version,
+                      json_error_t *error)
+{
+    const char *top_level_keys[] = {
+        "resources", "tasks", "version", "attributes", NULL
+    };
+    const char *attributes_keys[] = { "system", "user", NULL };
+    json_t *resources;
+    json_t *tasks;
+    json_t *version;
+    json_t *attributes;
+    bool v1;
+    size_t index;
+    json_t *task;
+
+    if (!json_is_object (jobspec))
+        return set_error (error, "jobspec must be a mapping");
+    if (validate_keys (jobspec, top_level_keys, false, false, error) < 0)
+        return -1;
+    resources = json_object_get (jobspec, "resources");
+    tasks = json_object_get (jobspec, "tasks");
+    version = json_object_get (jobspec, "version");
+    attributes = json_object_get (jobspec, "attributes");
+
+    v1 = (require_version == 1
+          || (json_is_number (version) && json_number_value (version) == 1));
+    if (v1 && !(json_is_number (version) && json_number_value (version) == 1))
+        return set_error (error, "version must be 1");
+    if (!json_is_array (resources))
+        return set_error (error, "resources must be a sequence");
+    if (!json_is_array (tasks))
+        return set_error (error, "tasks must be a sequence");
+    if (!json_is_integer (version))
+        return set_error (error, "version must be an integer");
+    if (!json_is_object (attributes))
+        return set_error (error, "attributes must be a mapping");
+    if (json_integer_value (version) < 1)
+        return set_error (error, "version must be >= 1");
+    if (validate_resources (resources, error) < 0)
+        return -1;
+    json_array_foreach (tasks, index, task) {
+        if (validate_task (task, error) < 0)
+            return -1;
+    }
+    if (validate_keys (attributes, attributes_keys, true, false, error) < 0)
+        return -1;
+    if (v1 && validate_v1 (attributes, error) < 0)
+        return -1;
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,32 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _JOBSPEC_VALIDATE_H
+#define _JOBSPEC_VALIDATE_H
+
+#include <jansson.h>
+
+/* Validate decoded 'jobspec' against RFC 14 canonical jobspec, and
+ * if its version is 1, or 'require_version' is 1, against the
+ * additional requirements of RFC 25 jobspec V1.  Pass 0 for
+ * 'require_version' to accept any version.  The checks and messages
+ * follow validate_jobspec() in the flux.job Python module.
+ * Returns 0 if valid, or -1 with errno set to EINVAL and a reason
+ * suitable for the submitting user copied to 'error->text'.
+ */
+int jobspec_validate (json_t *jobspec,
+                      int require_version,
+                      json_error_t *error);
+
+#endif /* !_JOBSPEC_VALIDATE_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
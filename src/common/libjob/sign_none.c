@@ -23,10 +23,16 @@
 
 #include "sign_none.h"
 
+/* The encoded header is short and identical for all jobs of a user,
+ * so decode it on the stack unless it is unexpectedly large.
+ */
+#define HEADER_BUFSIZE 128
+
 int header_decode (const char *src, int srclen, uint32_t *useridp)
 {
     size_t dstlen = BASE64_DECODE_SIZE (srclen);
-    char *dst;
+    char buf[HEADER_BUFSIZE];
+    char *dst = buf;
     char *entry = NULL;
     char *key;
     char *val;
@@ -36,13 +42,13 @@ int header_decode (const char *src, int srclen, uint32_t *useridp)
     uint32_t userid;
     char *endptr;
 
-    if (!(dst = calloc (1, dstlen)))
+    if (dstlen > sizeof (buf) && !(dst = malloc (dstlen)))
         return -1;
     if (sodium_base642bin ((unsigned char *)dst, dstlen, src, srclen,
                            NULL, &dstlen, NULL,
                            sodium_base64_VARIANT_ORIGINAL) < 0)
         goto error_inval;
-    if (dst[dstlen - 1] != '\0')
+    if (dstlen == 0 || dst[dstlen - 1] != '\0')
         goto error_inval;
     while ((key = entry = argz_next (dst, dstlen, entry))) {
         if (!(val = entry = argz_next (dst, dstlen, entry)))
@@ -67,11 +73,13 @@ int header_decode (const char *src, int srclen, uint32_t *useridp)
     userid = strtoul (val_userid + 1, &endptr, 10);
     if (errno != 0 || *endptr != '\0' || endptr == val_userid)
         goto error_inval;
-    free (dst);
+    if (dst != buf)
+        free (dst);
     *useridp = userid;
     return 0;
 error_inval:
-    free (dst);
+    if (dst != buf)
+        free (dst);
     errno = EINVAL;
     return -1;
 }
@@ -117,7 +125,10 @@ static int payload_decode (const void *src, int srclen,
     size_t dstlen = BASE64_DECODE_SIZE (srclen);
     void *dst;
 
-    if (!(dst = calloc (1, dstlen)))
+    /* N.B. the decoded payload overwrites the buffer, so skip zeroing it.
+     * Allocate at least one byte so an empty payload is not NULL.
+     */
+    if (!(dst = malloc (dstlen > 0 ? dstlen : 1)))
         return -1;
     if (sodium_base642bin ((unsigned char *)dst, dstlen, src, srclen,
                            NULL, &dstlen, NULL,
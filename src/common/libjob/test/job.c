@@ -103,6 +103,8 @@ void check_jobkey (void)
 void check_corner_case (void)
 {
     flux_t *h = (flux_t *)(uintptr_t)42; // fake but non-NULL
+    const char *jobspec = "{}";
+    flux_jobid_t id;
 
     /* flux_job_submit */
 
@@ -114,6 +116,26 @@ void check_corner_case (void)
     ok (flux_job_submit_get_id (NULL, NULL) < 0 && errno == EINVAL,
         "flux_job_submit_get_id with NULL args fails with EINVAL");
 
+    /* flux_job_submit_bulk */
+
+    errno = 0;
+    ok (flux_job_submit_bulk (NULL, 1, &jobspec, 0, 0) == NULL
+        && errno == EINVAL,
+        "flux_job_submit_bulk h=NULL fails with EINVAL");
+
+    errno = 0;
+    ok (flux_job_submit_bulk (h, 0, &jobspec, 0, 0) == NULL
+        && errno == EINVAL,
+        "flux_job_submit_bulk count=0 fails with EINVAL");
+
+    errno = 0;
+    ok (flux_job_submit_bulk (h, 1, NULL, 0, 0) == NULL && errno == EINVAL,
+        "flux_job_submit_bulk jobspecs=NULL fails with EINVAL");
+
+    errno = 0;
+    ok (flux_job_submit_bulk_get_ids (NULL, 1, &id) < 0 && errno == EINVAL,
+        "flux_job_submit_bulk_get_ids f=NULL fails with EINVAL");
+
     /* flux_job_list */
 
     errno = 0;
@@ -200,6 +222,11 @@ void check_corner_case (void)
         && errno == EINVAL,
         "flux_job_event_watch fails with EINVAL on bad input");
 
+    errno = 0;
+    ok (!flux_job_event_watch_from (NULL, 0, NULL, 0, 1)
+        && errno == EINVAL,
+        "flux_job_event_watch_from fails with EINVAL on bad input");
+
     errno = 0;
     ok (flux_job_event_watch_get (NULL, NULL) < 0
         && errno == EINVAL,
@@ -222,6 +249,14 @@ void check_corner_case (void)
     errno = 0;
     ok (flux_job_wait_get_id (NULL, NULL) < 0 && errno == EINVAL,
         "flux_job_wait_get_id f=NULL fails with EINVAL");
+
+    errno = 0;
+    ok (flux_job_wait_batch (NULL, 1) == NULL && errno == EINVAL,
+        "flux_job_wait_batch h=NULL fails with EINVAL");
+
+    errno = 0;
+    ok (flux_job_wait_batch (h, 0) == NULL && errno == EINVAL,
+        "flux_job_wait_batch max=0 fails with EINVAL");
 }
 
 struct ss {
@@ -400,6 +435,42 @@ void check_jobid_parse_encode (void)
         "flux_job_id_encode with unknown encode type returns EPROTO");
 }
 
+void check_transition (void)
+{
+    uint8_t buf[FLUX_JOB_TRANSITION_SIZE];
+    flux_jobid_t id;
+    flux_job_state_t state;
+    double t;
+
+    ok (flux_job_transition_encode (buf, sizeof (buf),
+                                    6787342413402046,
+                                    FLUX_JOB_CLEANUP,
+                                    1612345678.123456) == 0,
+        "flux_job_transition_encode works");
+    ok (buf[0] == 0x00 && buf[1] == 0x18 && buf[7] == 0xbe
+        && buf[11] == FLUX_JOB_CLEANUP,
+        "flux_job_transition_encode uses network byte order");
+    ok (flux_job_transition_decode (buf, sizeof (buf), &id, &state, &t) == 0,
+        "flux_job_transition_decode works");
+    ok (id == 6787342413402046 && state == FLUX_JOB_CLEANUP
+        && t == 1612345678.123456,
+        "flux_job_transition_decode returned encoded values");
+    ok (flux_job_transition_decode (buf, sizeof (buf), NULL, NULL, NULL) == 0,
+        "flux_job_transition_decode works with NULL outputs");
+
+    errno = 0;
+    ok (flux_job_transition_encode (buf, sizeof (buf) - 1, 1, 1, 0.) < 0
+        && errno == EINVAL,
+        "flux_job_transition_encode short buffer fails with EINVAL");
+    errno = 0;
+    ok (flux_job_transition_encode (NULL, sizeof (buf), 1, 1, 0.) < 0
+        && errno == EINVAL,
+        "flux_job_transition_encode buf=NULL fails with EINVAL");
+    errno = 0;
+    ok (flux_job_transition_decode (buf, sizeof (buf) - 1, &id, &state, &t) < 0
+        && errno == EINVAL,
+        "flux_job_transition_decode short buffer fails with EINVAL");
+}
 
 int main (int argc, char *argv[])
 {
@@ -420,6 +491,8 @@ int main (int argc, char *argv[])
 
     check_jobid_parse_encode ();
 
+    check_transition ();
+
     done_testing ();
     return 0;
 }
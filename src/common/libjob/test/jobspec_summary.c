@@ -0,0 +1,134 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <string.h>
+#include <errno.h>
+#include <jansson.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/common/libjob/jobspec_summary.h"
+
+#define SLOT(count, with) \
+    "{\"type\":\"slot\",\"count\":" count ",\"label\":\"task\"," \
+    "\"with\":[" with "]}"
+#define CORE(count) "{\"type\":\"core\",\"count\":" count "}"
+#define NODE(count, with) \
+    "{\"type\":\"node\",\"count\":" count ",\"with\":[" with "]}"
+#define TASKS(count) \
+    "[{\"command\":[\"hostname\"],\"slot\":\"task\",\"count\":" count "}]"
+#define PER_SLOT "{\"per_slot\":1}"
+#define ATTRS "{\"system\":{\"duration\":30.5,\"cwd\":\"/tmp\"," \
+              "\"job\":{\"name\":\"foo\"}}}"
+
+#define JOBSPEC(version, res, tasks, attrs) \
+    "{\"version\":" version ",\"resources\":[" res \
+    "],\"tasks\":" tasks ",\"attributes\":" attrs "}"
+
+struct test {
+    const char *jobspec;
+    struct jobspec_summary expected;
+    const char *errstr;     // NULL if valid
+};
+
+static struct test tests[] = {
+    { JOBSPEC ("1", SLOT ("2", CORE ("3")), TASKS (PER_SLOT), ATTRS),
+      { .task_count = 2, .slot_count = 2, .cores_per_slot = 3,
+        .slots_per_node = -1, .node_count = 0, .duration = 30.5 },
+      NULL },
+    { JOBSPEC ("1", NODE ("4", SLOT ("2", CORE ("1"))),
+               TASKS ("{\"total\":5}"), "{\"system\":{}}"),
+      { .task_count = 5, .slot_count = 8, .cores_per_slot = 1,
+        .slots_per_node = 2, .node_count = 4 },
+      NULL },
+    { JOBSPEC ("2", SLOT ("1", CORE ("1")), TASKS (PER_SLOT), ATTRS),
+      { 0 }, "Invalid jobspec version: expected 1 got 2" },
+    { JOBSPEC ("1", CORE ("1"), TASKS (PER_SLOT), ATTRS),
+      { 0 }, "Unexpected resource hierarchy: core->NULL->NULL" },
+    { JOBSPEC ("1", SLOT ("1", CORE ("1")),
+               TASKS ("{\"per_slot\":2}"), ATTRS),
+      { 0 }, "per_slot count: expected 1 got 2" },
+    { JOBSPEC ("1", SLOT ("1", CORE ("1")), TASKS ("{}"), ATTRS),
+      { 0 }, "Unable to parse task count" },
+    { JOBSPEC ("1", SLOT ("1", CORE ("1")), TASKS (PER_SLOT), "{}"),
+      { 0 }, NULL /* any error */ },
+    { NULL },
+};
+
+static void check_summary (struct test *t)
+{
+    json_t *jobspec;
+    json_error_t error;
+    struct jobspec_summary js;
+    int rc;
+
+    if (!(jobspec = json_loads (t->jobspec, 0, &error)))
+        BAIL_OUT ("json_loads: %s", error.text);
+    error.text[0] = '\0';
+    rc = jobspec_summary_parse (jobspec, &js, &error);
+    if (t->expected.slot_count > 0) {
+        ok (rc == 0
+            && js.task_count == t->expected.task_count
+            && js.slot_count == t->expected.slot_count
+            && js.cores_per_slot == t->expected.cores_per_slot
+            && js.slots_per_node == t->expected.slots_per_node
+            && js.node_count == t->expected.node_count
+            && js.duration == t->expected.duration
+            && json_is_array (js.command),
+            "jobspec_summary_parse works: %d tasks %d slots",
+            js.task_count, js.slot_count);
+        if (rc < 0)
+            diag ("%s", error.text);
+    }
+    else {
+        ok (rc < 0 && errno == EINVAL
+            && (!t->errstr || !strcmp (error.text, t->errstr)),
+            "jobspec_summary_parse fails: %s", error.text);
+    }
+    json_decref (jobspec);
+}
+
+static void test_members (void)
+{
+    json_t *jobspec;
+    struct jobspec_summary js;
+
+    if (!(jobspec = json_loads (tests[0].jobspec, 0, NULL)))
+        BAIL_OUT ("json_loads failed");
+    ok (jobspec_summary_parse (jobspec, &js, NULL) == 0
+        && js.cwd && !strcmp (js.cwd, "/tmp")
+        && js.name && !strcmp (js.name, "foo"),
+        "jobspec_summary_parse sets cwd and name");
+    json_decref (jobspec);
+
+    errno = 0;
+    ok (jobspec_summary_parse (NULL, &js, NULL) < 0 && errno == EINVAL,
+        "jobspec_summary_parse jobspec=NULL fails with EINVAL");
+}
+
+int main (int argc, char *argv[])
+{
+    int i;
+
+    plan (NO_PLAN);
+
+    for (i = 0; tests[i].jobspec != NULL; i++)
+        check_summary (&tests[i]);
+    test_members ();
+
+    done_testing ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,159 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <string.h>
+#include <errno.h>
+#include <jansson.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/common/libjob/jobspec_validate.h"
+
+#define RES "[{\"type\":\"slot\",\"count\":1,\"label\":\"task\"," \
+            "\"with\":[{\"type\":\"core\",\"count\":1}]}]"
+#define TASKS "[{\"command\":[\"hostname\"],\"slot\":\"task\"," \
+              "\"count\":{\"per_slot\":1}}]"
+#define ATTRS "{\"system\":{\"duration\":0}}"
+
+#define JOBSPEC(version, res, tasks, attrs) \
+    "{\"version\":" version ",\"resources\":" res \
+    ",\"tasks\":" tasks ",\"attributes\":" attrs "}"
+
+struct test {
+    const char *jobspec;
+    int require_version;
+    const char *errstr;     // NULL if valid
+};
+
+static struct test tests[] = {
+    { JOBSPEC ("1", RES, TASKS, ATTRS), 0, NULL },
+    { JOBSPEC ("1", RES, TASKS, ATTRS), 1, NULL },
+    { JOBSPEC ("2", RES, TASKS, "{}"), 0, NULL },
+    { JOBSPEC ("1", RES, TASKS, "{\"system\":{\"duration\":1.5},"
+                                "\"user\":{\"x\":1}}"), 0, NULL },
+    { JOBSPEC ("1", "[{\"type\":\"node\",\"count\":{\"min\":1,\"max\":4,"
+                    "\"operator\":\"+\",\"operand\":1},\"exclusive\":true,"
+                    "\"with\":" RES "}]", TASKS, ATTRS), 0, NULL },
+
+    { "[]", 0, "jobspec must be a mapping" },
+    { "{\"version\":1,\"resources\":" RES ",\"tasks\":" TASKS "}",
+      0, "Missing key (attributes)" },
+    { "{\"version\":1,\"resources\":" RES ",\"tasks\":" TASKS
+      ",\"attributes\":" ATTRS ",\"foo\":1}", 0, "Extraneous key (foo)" },
+    { JOBSPEC ("2", RES, TASKS, ATTRS), 1, "version must be 1" },
+    { JOBSPEC ("\"1\"", RES, TASKS, ATTRS), 0, "version must be an integer" },
+    { JOBSPEC ("0", RES, TASKS, ATTRS), 0, "version must be >= 1" },
+    { JOBSPEC ("1", "{}", TASKS, ATTRS), 0, "resources must be a sequence" },
+    { JOBSPEC ("1", RES, "{}", ATTRS), 0, "tasks must be a sequence" },
+    { JOBSPEC ("1", RES, TASKS, "null"), 0, "attributes must be a mapping" },
+    { JOBSPEC ("1", RES, TASKS, "{\"foo\":{}}"), 0, "Extraneous key (foo)" },
+    { JOBSPEC ("1", RES, TASKS, "{}"),
+      0, "attributes.system is a required key" },
+    { JOBSPEC ("1", RES, TASKS, "{\"system\":1}"),
+      0, "attributes.system must be a mapping" },
+    { JOBSPEC ("1", RES, TASKS, "{\"system\":{}}"),
+      0, "attributes.system.duration is a required key" },
+    { JOBSPEC ("1", RES, TASKS, "{\"system\":{\"duration\":\"1m\"}}"),
+      0, "attributes.system.duration must be a number" },
+
+    { JOBSPEC ("2", "[1]", TASKS, "{}"), 0, "resource must be a mapping" },
+    { JOBSPEC ("2", "[{\"count\":1}]", TASKS, "{}"),
+      0, "type is a required key for resources" },
+    { JOBSPEC ("2", "[{\"type\":1,\"count\":1}]", TASKS, "{}"),
+      0, "type must be a string" },
+    { JOBSPEC ("2", "[{\"type\":\"node\"}]", TASKS, "{}"),
+      0, "count is a required key for resources" },
+    { JOBSPEC ("2", "[{\"type\":\"node\",\"count\":\"1\"}]", TASKS, "{}"),
+      0, "count must be an int or mapping" },
+    { JOBSPEC ("2", "[{\"type\":\"node\",\"count\":0}]", TASKS, "{}"),
+      0, "count must be > 0" },
+    { JOBSPEC ("2", "[{\"type\":\"node\",\"count\":{}}]", TASKS, "{}"),
+      0, "min must be in range" },
+    { JOBSPEC ("2", "[{\"type\":\"node\",\"count\":{\"min\":1,\"max\":2}}]",
+               TASKS, "{}"),
+      0, "Missing key (operator)" },
+    { JOBSPEC ("2", "[{\"type\":\"node\",\"count\":{\"min\":0}}]",
+               TASKS, "{}"),
+      0, "min must be > 0" },
+    { JOBSPEC ("2", "[{\"type\":\"node\",\"count\":{\"min\":1,\"max\":2,"
+                    "\"operator\":\"-\",\"operand\":1}}]", TASKS, "{}"),
+      0, "operator must be one of ['+', '*', '^']" },
+    { JOBSPEC ("2", "[{\"type\":\"node\",\"count\":1,\"unit\":1}]",
+               TASKS, "{}"),
+      0, "unit must be a string" },
+    { JOBSPEC ("2", "[{\"type\":\"node\",\"count\":1,\"exclusive\":\"yes\"}]",
+               TASKS, "{}"),
+      0, "exclusive must be a boolean" },
+    { JOBSPEC ("2", "[{\"type\":\"slot\",\"count\":1}]", TASKS, "{}"),
+      0, "slots must have labels" },
+    { JOBSPEC ("2", "[{\"type\":\"node\",\"count\":1,"
+                    "\"with\":[{\"type\":\"core\"}]}]", TASKS, "{}"),
+      0, "count is a required key for resources" },
+
+    { JOBSPEC ("2", RES, "[1]", "{}"), 0, "task must be a mapping" },
+    { JOBSPEC ("2", RES, "[{\"slot\":\"task\",\"count\":{}}]", "{}"),
+      0, "Missing key (command)" },
+    { JOBSPEC ("2", RES, "[{\"command\":[\"a\"],\"slot\":\"task\","
+                         "\"count\":1}]", "{}"),
+      0, "count must be a mapping" },
+    { JOBSPEC ("2", RES, "[{\"command\":[\"a\"],\"slot\":1,"
+                         "\"count\":{}}]", "{}"),
+      0, "slot must be a string" },
+    { JOBSPEC ("2", RES, "[{\"command\":[],\"slot\":\"task\","
+                         "\"count\":{}}]", "{}"),
+      0, "command array cannot have length of zero" },
+    { JOBSPEC ("2", RES, "[{\"command\":\"a\",\"slot\":\"task\","
+                         "\"count\":{}}]", "{}"),
+      0, "command must be a list of strings" },
+    { JOBSPEC ("2", RES, "[{\"command\":[\"a\",1],\"slot\":\"task\","
+                         "\"count\":{}}]", "{}"),
+      0, "command must be a list of strings" },
+    { NULL, 0, NULL },
+};
+
+int main (int argc, char *argv[])
+{
+    int i;
+
+    plan (NO_PLAN);
+
+    for (i = 0; tests[i].jobspec != NULL; i++) {
+        json_t *o;
+        json_error_t error;
+        int rc;
+
+        if (!(o = json_loads (tests[i].jobspec, 0, &error)))
+            BAIL_OUT ("test %d: %s", i, error.text);
+        memset (&error, 0, sizeof (error));
+        errno = 0;
+        rc = jobspec_validate (o, tests[i].require_version, &error);
+        if (tests[i].errstr)
+            ok (rc < 0 && errno == EINVAL
+                && !strcmp (error.text, tests[i].errstr),
+                "jobspec_validate fails: %s", tests[i].errstr);
+        else
+            ok (rc == 0,
+                "jobspec_validate accepts valid jobspec %d", i);
+        if (rc < 0 && (!tests[i].errstr || strcmp (error.text, tests[i].errstr)))
+            diag ("%s", error.text);
+        json_decref (o);
+    }
+    ok (jobspec_validate (NULL, 0, NULL) < 0 && errno == EINVAL,
+        "jobspec_validate jobspec=NULL error=NULL fails with EINVAL");
+
+    done_testing ();
+    return (0);
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
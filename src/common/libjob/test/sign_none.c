@@ -149,6 +149,11 @@ void decode_bad_header (void)
     /* extra separator */
     const char bad11_header[] = "\0version\0i1\0userid\0i1000\0mech\0snone";
     char *bad11 = wrap (bad11_header, sizeof (bad11_header), NULL, 0);
+    /* oversized header (decoded on the heap) with extra foo field */
+    char bad12_header[256] = "version\0i1\0userid\0i1000\0mech\0snone\0foo";
+    memset (bad12_header + 39, 'x', sizeof (bad12_header) - 40);
+    bad12_header[sizeof (bad12_header) - 1] = '\0';
+    char *bad12 = wrap (bad12_header, sizeof (bad12_header), NULL, 0);
 
     uint32_t userid;
     void *payload;
@@ -210,6 +215,11 @@ void decode_bad_header (void)
     ok (rc < 0 && errno == EINVAL,
         "sign_none_unwrap extra seprator fails with EINVAL");
 
+    errno = 0;
+    rc = sign_none_unwrap (bad12, &payload, &payloadsz, &userid);
+    ok (rc < 0 && errno == EINVAL,
+        "sign_none_unwrap oversized header fails with EINVAL");
+
     free (bad1);
     free (bad2);
     free (bad3);
@@ -221,6 +231,7 @@ void decode_bad_header (void)
     free (bad9);
     free (bad10);
     free (bad11);
+    free (bad12);
 }
 
 void decode_bad_other (void)
@@ -21,17 +21,117 @@
 flux_future_t *flux_kvs_namespace_create (flux_t *h, const char *ns,
                                           uint32_t owner, int flags)
 {
-    if (!ns || flags) {
+    return flux_kvs_namespace_create_rank (h, ns, owner, 0, flags);
+}
+
+flux_future_t *flux_kvs_namespace_create_rank (flux_t *h, const char *ns,
+                                               uint32_t owner, uint32_t rank,
+                                               int flags)
+{
+    if (!ns || (flags & ~FLUX_KVS_NAMESPACE_EPHEMERAL)
+            || rank == FLUX_NODEID_ANY
+            || rank == FLUX_NODEID_UPSTREAM) {
         errno = EINVAL;
         return NULL;
     }
 
-    /* N.B. owner cast to int */
+    /* N.B. owner and rank cast to int */
     return flux_rpc_pack (h, "kvs.namespace-create", 0, 0,
-                          "{ s:s s:i s:i }",
+                          "{ s:s s:i s:i s:i }",
                           "namespace", ns,
                           "owner", owner,
-                          "flags", flags);
+                          "flags", flags,
+                          "rank", rank);
+}
+
+struct clone_context {
+    char *ns;
+    uint32_t owner;
+};
+
+static void clone_context_destroy (struct clone_context *ctx)
+{
+    if (ctx) {
+        int saved_errno = errno;
+        free (ctx->ns);
+        free (ctx);
+        errno = saved_errno;
+    }
+}
+
+/* Clone: create the namespace at the source root once getroot finishes.
+ * The new namespace refers to the same content, so nothing is copied.
+ */
+static void getroot_continuation (flux_future_t *f, void *arg)
+{
+    struct clone_context *ctx = arg;
+    flux_t *h = flux_future_get_flux (f);
+    const char *rootref;
+    int flags;
+    flux_future_t *f2;
+
+    if (flux_rpc_get_unpack (f, "{ s:s s:i }",
+                             "rootref", &rootref,
+                             "flags", &flags) < 0)
+        goto error;
+    /* The data of an ephemeral namespace is not in the content store.
+     */
+    if ((flags & FLUX_KVS_NAMESPACE_EPHEMERAL)) {
+        errno = EINVAL;
+        goto error;
+    }
+    /* N.B. owner cast to int */
+    if (!(f2 = flux_rpc_pack (h, "kvs.namespace-create", 0, 0,
+                              "{ s:s s:i s:i s:i s:s }",
+                              "namespace", ctx->ns,
+                              "owner", ctx->owner,
+                              "flags", 0,
+                              "rank", 0,
+                              "rootref", rootref)))
+        goto error;
+    if (flux_future_continue (f, f2) < 0) {
+        flux_future_destroy (f2);
+        goto error;
+    }
+    goto done;
+error:
+    flux_future_continue_error (f, errno, NULL);
+done:
+    flux_future_destroy (f);
+}
+
+flux_future_t *flux_kvs_namespace_clone (flux_t *h, const char *srcns,
+                                         const char *ns, uint32_t owner)
+{
+    struct clone_context *ctx;
+    flux_future_t *f1;
+    flux_future_t *f2;
+
+    if (!h || !ns) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(f1 = flux_kvs_getroot (h, srcns, 0)))
+        return NULL;
+    if (!(ctx = calloc (1, sizeof (*ctx)))
+        || !(ctx->ns = strdup (ns))) {
+        clone_context_destroy (ctx);
+        goto error;
+    }
+    ctx->owner = owner;
+    if (flux_future_aux_set (f1,
+                             NULL,
+                             ctx,
+                             (flux_free_f)clone_context_destroy) < 0) {
+        clone_context_destroy (ctx);
+        goto error;
+    }
+    if (!(f2 = flux_future_and_then (f1, getroot_continuation, ctx)))
+        goto error;
+    return f2;
+error:
+    flux_future_destroy (f1);
+    return NULL;
 }
 
 flux_future_t *flux_kvs_namespace_remove (flux_t *h, const char *ns)
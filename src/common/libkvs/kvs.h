@@ -38,10 +38,25 @@ enum kvs_op {
     FLUX_KVS_WATCH_APPEND = 256
 };
 
+enum kvs_namespace_flags {
+    FLUX_KVS_NAMESPACE_EPHEMERAL = 1,
+};
+
 /* Namespace
  * - namespace create only creates the namespace on rank 0.  Other
  *   ranks initialize against that namespace the first time they use
  *   it.
+ * - by default rank 0 applies all transactions to a namespace.
+ *   flux_kvs_namespace_create_rank() places that work on another rank,
+ *   e.g. the first rank of a job for the job's guest namespace.
+ * - FLUX_KVS_NAMESPACE_EPHEMERAL creates a namespace whose data is kept
+ *   in memory by the KVS of its rank instead of in the content store.
+ *   It is lost when that KVS module is unloaded.  Lookups on other ranks
+ *   load it from there.
+ * - namespace clone creates a namespace whose root is the current root
+ *   of another namespace.  The two share all content by reference, so
+ *   the cost does not depend on the size of the source namespace.  The
+ *   clone is owned by rank 0.  An ephemeral namespace cannot be cloned.
  * - namespace remove marks the namespace for removal on all ranks.
  *   Garbage collection will happen in the background and the
  *   namespace will official be removed.  The removal is "eventually
@@ -49,6 +64,11 @@ enum kvs_op {
  */
 flux_future_t *flux_kvs_namespace_create (flux_t *h, const char *ns,
                                           uint32_t owner, int flags);
+flux_future_t *flux_kvs_namespace_create_rank (flux_t *h, const char *ns,
+                                               uint32_t owner, uint32_t rank,
+                                               int flags);
+flux_future_t *flux_kvs_namespace_clone (flux_t *h, const char *srcns,
+                                         const char *ns, uint32_t owner);
 flux_future_t *flux_kvs_namespace_remove (flux_t *h, const char *ns);
 
 /* Synchronization:
@@ -0,0 +1,387 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* kvs_cache.c - client side cache of KVS lookups
+ *
+ * Lookup results are cached per namespace, keyed by flags and key, and
+ * tagged with the root sequence number of the lookup.  The cache
+ * subscribes to the kvs.namespace-<NS>-setroot and -removed events of
+ * each namespace it holds, and drops a namespace's entries that are
+ * older than its new root when the root changes.  A cached value is therefore as current as one
+ * looked up on a broker other than rank 0, whose KVS is updated by
+ * the same event.
+ *
+ * Handles that never run a reactor would not see those events, so
+ * pending ones are also received directly before each cache lookup.
+ * The cache consumes them either way.
+ *
+ * setroot events are private to the instance owner, so the cache may
+ * only be enabled by the instance owner.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <jansson.h>
+#include <czmq.h>
+#include <flux/core.h>
+
+#include "kvs_cache_private.h"
+
+/* All entries are dropped when the cache fills, which is simple and
+ * is expected to be rare for the small sets of keys that are read
+ * repeatedly.
+ */
+static const int kvs_cache_max_entries = 1024;
+
+static const char *auxkey = "flux::kvs_cache";
+
+struct cache_entry {
+    int rootseq;
+    json_t *treeobj;
+};
+
+struct cache_ns {
+    char *name;
+    char *setroot_topic;
+    char *removed_topic;
+    int rootseq;            /* from the last setroot event */
+    int commits;            /* commits in progress on this handle */
+    zhashx_t *entries;      /* "flags:key" => struct cache_entry */
+    flux_msg_handler_t *mh[2];
+};
+
+struct kvs_cache {
+    flux_t *h;
+    zhashx_t *namespaces;   /* name => struct cache_ns */
+    int count;
+};
+
+static void cache_entry_destroy (void **item)
+{
+    if (item && *item) {
+        struct cache_entry *e = *item;
+        json_decref (e->treeobj);
+        free (e);
+        *item = NULL;
+    }
+}
+
+static void cache_ns_purge (struct kvs_cache *cache, struct cache_ns *nsc)
+{
+    cache->count -= zhashx_size (nsc->entries);
+    zhashx_purge (nsc->entries);
+}
+
+/* Drop entries of 'nsc' from before root sequence 'rootseq'.
+ */
+static void cache_ns_expire (struct kvs_cache *cache,
+                             struct cache_ns *nsc,
+                             int rootseq)
+{
+    zlistx_t *keys;
+    const char *key;
+
+    if (!(keys = zhashx_keys (nsc->entries))) {
+        cache_ns_purge (cache, nsc);
+        return;
+    }
+    for (key = zlistx_first (keys); key; key = zlistx_next (keys)) {
+        struct cache_entry *e = zhashx_lookup (nsc->entries, key);
+        if (e->rootseq < rootseq) {
+            zhashx_delete (nsc->entries, key);
+            cache->count--;
+        }
+    }
+    zlistx_destroy (&keys);
+}
+
+static void cache_ns_event (struct kvs_cache *cache,
+                            struct cache_ns *nsc,
+                            const flux_msg_t *msg)
+{
+    const char *topic;
+    int rootseq;
+
+    if (flux_msg_get_topic (msg, &topic) < 0)
+        return;
+    if (!strcmp (topic, nsc->removed_topic)) {
+        cache_ns_purge (cache, nsc);
+        nsc->rootseq = 0;
+    }
+    else if (!strcmp (topic, nsc->setroot_topic)
+             && flux_event_unpack (msg, NULL, "{s:i}",
+                                   "rootseq", &rootseq) == 0
+             && rootseq > nsc->rootseq) {
+        cache_ns_expire (cache, nsc, rootseq);
+        nsc->rootseq = rootseq;
+    }
+}
+
+static void cache_ns_event_cb (flux_t *h,
+                               flux_msg_handler_t *mh,
+                               const flux_msg_t *msg,
+                               void *arg)
+{
+    struct kvs_cache *cache = flux_aux_get (h, auxkey);
+
+    if (cache)
+        cache_ns_event (cache, arg, msg);
+}
+
+/* Receive events for 'nsc' that are queued on the handle but have not
+ * been dispatched yet.
+ */
+static void cache_ns_recv_events (struct kvs_cache *cache,
+                                  struct cache_ns *nsc)
+{
+    struct flux_match match = FLUX_MATCH_EVENT;
+    flux_msg_t *msg;
+    int i;
+
+    for (i = 0; i < 2; i++) {
+        match.topic_glob = i == 0 ? nsc->setroot_topic : nsc->removed_topic;
+        while ((msg = flux_recv (cache->h, match, FLUX_O_NONBLOCK))) {
+            cache_ns_event (cache, nsc, msg);
+            flux_msg_destroy (msg);
+        }
+    }
+}
+
+static void cache_ns_destroy (void **item)
+{
+    if (item && *item) {
+        struct cache_ns *nsc = *item;
+        int saved_errno = errno;
+        flux_msg_handler_destroy (nsc->mh[0]);
+        flux_msg_handler_destroy (nsc->mh[1]);
+        zhashx_destroy (&nsc->entries);
+        free (nsc->setroot_topic);
+        free (nsc->removed_topic);
+        free (nsc->name);
+        free (nsc);
+        errno = saved_errno;
+        *item = NULL;
+    }
+}
+
+static struct cache_ns *cache_ns_create (flux_t *h, const char *ns)
+{
+    struct cache_ns *nsc;
+    struct flux_match match = FLUX_MATCH_EVENT;
+    int i;
+
+    if (!(nsc = calloc (1, sizeof (*nsc))))
+        return NULL;
+    if (!(nsc->name = strdup (ns))
+        || asprintf (&nsc->setroot_topic,
+                     "kvs.namespace-%s-setroot", ns) < 0
+        || asprintf (&nsc->removed_topic,
+                     "kvs.namespace-%s-removed", ns) < 0
+        || !(nsc->entries = zhashx_new ()))
+        goto nomem;
+    zhashx_set_destructor (nsc->entries, cache_entry_destroy);
+    for (i = 0; i < 2; i++) {
+        match.topic_glob = i == 0 ? nsc->setroot_topic : nsc->removed_topic;
+        if (!(nsc->mh[i] = flux_msg_handler_create (h,
+                                                    match,
+                                                    cache_ns_event_cb,
+                                                    nsc)))
+            goto error;
+        flux_msg_handler_start (nsc->mh[i]);
+    }
+    /* The subscription is in place when this returns, so a root change
+     * after any lookup that is sent from here on is seen.
+     */
+    if (flux_event_subscribe (h, nsc->setroot_topic) < 0
+        || flux_event_subscribe (h, nsc->removed_topic) < 0)
+        goto error;
+    return nsc;
+nomem:
+    errno = ENOMEM;
+error:
+    cache_ns_destroy ((void **)&nsc);
+    return NULL;
+}
+
+/* Get the cache for namespace 'ns', creating it if needed.
+ */
+static struct cache_ns *cache_ns_get (struct kvs_cache *cache, const char *ns)
+{
+    struct cache_ns *nsc;
+
+    if (!(nsc = zhashx_lookup (cache->namespaces, ns))) {
+        if (!(nsc = cache_ns_create (cache->h, ns)))
+            return NULL;
+        (void)zhashx_insert (cache->namespaces, ns, nsc);
+    }
+    return nsc;
+}
+
+static char *entry_key (int flags, const char *key)
+{
+    char *s;
+
+    if (asprintf (&s, "%d:%s", flags, key) < 0)
+        return NULL;
+    return s;
+}
+
+static int cacheable (int flags)
+{
+    return !(flags & (FLUX_KVS_WATCH | FLUX_KVS_WAITCREATE));
+}
+
+bool kvs_cache_enabled (flux_t *h)
+{
+    return flux_aux_get (h, auxkey) ? true : false;
+}
+
+json_t *kvs_cache_lookup (flux_t *h, const char *ns, int flags,
+                          const char *key)
+{
+    struct kvs_cache *cache;
+    struct cache_ns *nsc;
+    struct cache_entry *e;
+    char *ekey;
+
+    if (!(cache = flux_aux_get (h, auxkey)) || !cacheable (flags))
+        return NULL;
+    if (!(nsc = cache_ns_get (cache, ns)))
+        return NULL;
+    cache_ns_recv_events (cache, nsc);
+    if (nsc->commits > 0 || !(ekey = entry_key (flags, key)))
+        return NULL;
+    e = zhashx_lookup (nsc->entries, ekey);
+    free (ekey);
+    if (!e || e->rootseq < nsc->rootseq)
+        return NULL;
+    return e->treeobj;
+}
+
+void kvs_cache_insert (flux_t *h, const char *ns, int flags, const char *key,
+                       int rootseq, json_t *treeobj)
+{
+    struct kvs_cache *cache;
+    struct cache_ns *nsc;
+    struct cache_entry *e;
+    char *ekey;
+
+    if (!(cache = flux_aux_get (h, auxkey))
+        || !cacheable (flags)
+        || !(nsc = zhashx_lookup (cache->namespaces, ns))
+        || nsc->commits > 0
+        || rootseq < nsc->rootseq)
+        return;
+    if (cache->count >= kvs_cache_max_entries) {
+        zhashx_t *namespaces = cache->namespaces;
+        struct cache_ns *n;
+        for (n = zhashx_first (namespaces); n; n = zhashx_next (namespaces))
+            cache_ns_purge (cache, n);
+    }
+    if (!(ekey = entry_key (flags, key)))
+        return;
+    if (!(e = calloc (1, sizeof (*e)))) {
+        free (ekey);
+        return;
+    }
+    e->rootseq = rootseq;
+    e->treeobj = json_incref (treeobj);
+    if (zhashx_lookup (nsc->entries, ekey))
+        cache->count--;
+    zhashx_update (nsc->entries, ekey, e);
+    cache->count++;
+    free (ekey);
+}
+
+void kvs_cache_commit_begin (flux_t *h, const char *ns)
+{
+    struct kvs_cache *cache;
+    struct cache_ns *nsc;
+
+    if ((cache = flux_aux_get (h, auxkey))
+        && (nsc = zhashx_lookup (cache->namespaces, ns))) {
+        cache_ns_purge (cache, nsc);
+        nsc->commits++;
+    }
+}
+
+void kvs_cache_commit_end (flux_t *h, const char *ns)
+{
+    struct kvs_cache *cache;
+    struct cache_ns *nsc;
+
+    if ((cache = flux_aux_get (h, auxkey))
+        && (nsc = zhashx_lookup (cache->namespaces, ns))
+        && nsc->commits > 0) {
+        cache_ns_purge (cache, nsc);
+        nsc->commits--;
+    }
+}
+
+static void kvs_cache_destroy (struct kvs_cache *cache)
+{
+    if (cache) {
+        int saved_errno = errno;
+        zhashx_destroy (&cache->namespaces);
+        free (cache);
+        errno = saved_errno;
+    }
+}
+
+int flux_kvs_lookup_cache_enable (flux_t *h)
+{
+    struct kvs_cache *cache;
+    const char *s;
+    char *endptr;
+    unsigned long owner;
+
+    if (!h) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (flux_aux_get (h, auxkey))
+        return 0;
+    if (!(s = flux_attr_get (h, "security.owner")))
+        return -1;
+    errno = 0;
+    owner = strtoul (s, &endptr, 10);
+    if (errno != 0 || *endptr != '\0') {
+        errno = EPROTO;
+        return -1;
+    }
+    if (owner != getuid ()) {
+        errno = EPERM;
+        return -1;
+    }
+    if (!(cache = calloc (1, sizeof (*cache))))
+        return -1;
+    cache->h = h;
+    if (!(cache->namespaces = zhashx_new ())) {
+        kvs_cache_destroy (cache);
+        errno = ENOMEM;
+        return -1;
+    }
+    zhashx_set_destructor (cache->namespaces, cache_ns_destroy);
+    if (flux_aux_set (h, auxkey, cache, (flux_free_f)kvs_cache_destroy) < 0) {
+        kvs_cache_destroy (cache);
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
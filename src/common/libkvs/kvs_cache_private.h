@@ -0,0 +1,47 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _FLUX_KVS_CACHE_PRIVATE_H
+#define _FLUX_KVS_CACHE_PRIVATE_H
+
+#include <stdbool.h>
+#include <jansson.h>
+#include <flux/core.h>
+
+/* Client side lookup cache, enabled with flux_kvs_lookup_cache_enable().
+ * The functions below do nothing, or find nothing, if it is not enabled
+ * on 'h'.
+ */
+
+bool kvs_cache_enabled (flux_t *h);
+
+/* Return the cached tree object for (ns, flags, key), or NULL.
+ */
+json_t *kvs_cache_lookup (flux_t *h, const char *ns, int flags,
+                          const char *key);
+
+/* Cache 'treeobj', the result of a lookup of (ns, flags, key) at root
+ * sequence 'rootseq'.
+ */
+void kvs_cache_insert (flux_t *h, const char *ns, int flags, const char *key,
+                       int rootseq, json_t *treeobj);
+
+/* Bracket a commit or fence to namespace 'ns' sent on 'h', so that its
+ * result is not hidden by cached values.  The cache is not used for
+ * 'ns' in between.
+ */
+void kvs_cache_commit_begin (flux_t *h, const char *ns);
+void kvs_cache_commit_end (flux_t *h, const char *ns);
+
+#endif  /* !_FLUX_KVS_CACHE_PRIVATE_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -16,31 +16,48 @@
 #include <flux/core.h>
 
 #include "treeobj.h"
+#include "kvs_cache_private.h"
 #include "kvs_txn_private.h"
 #include "kvs_util_private.h"
 #include "src/common/libutil/blobref.h"
+#include "src/common/libutil/errno_safe.h"
 
 static const char *auxkey = "flux::commit_ctx";
 
 struct commit_ctx {
     char *treeobj;      /* cached treeobj */
+    flux_t *h;
+    char *ns;
 };
 
 static void free_ctx (struct commit_ctx *ctx)
 {
     if (ctx) {
         int saved_errno = errno;
+        if (ctx->ns) {
+            kvs_cache_commit_end (ctx->h, ctx->ns);
+            free (ctx->ns);
+        }
         free (ctx->treeobj);
         free (ctx);
         errno = saved_errno;
     }
 }
 
-static struct commit_ctx *alloc_ctx (void)
+/* The lookup cache for 'ns' is bypassed until the commit future is
+ * destroyed, by which time its result is known.
+ */
+static struct commit_ctx *alloc_ctx (flux_t *h, const char *ns)
 {
     struct commit_ctx *ctx;
     if (!(ctx = calloc (1, sizeof (*ctx))))
         return NULL;
+    if (!(ctx->ns = strdup (ns))) {
+        free (ctx);
+        return NULL;
+    }
+    ctx->h = h;
+    kvs_cache_commit_begin (h, ns);
     return ctx;
 }
 
@@ -50,7 +67,8 @@ flux_future_t *flux_kvs_fence (flux_t *h, const char *ns, int flags,
 {
     flux_future_t *f;
     struct commit_ctx *ctx = NULL;
-    json_t *ops;
+    json_t *hdr;
+    char *payload;
 
     if (!name || nprocs <= 0 || !txn) {
         errno = EINVAL;
@@ -68,21 +86,27 @@ flux_future_t *flux_kvs_fence (flux_t *h, const char *ns, int flags,
         flags &= ~FLUX_KVS_TXN_COMPACT;
     }
 
-    if (!(ops = txn_get_ops (txn))) {
-        errno = EINVAL;
+    if (!(hdr = json_pack ("{s:s s:i s:s s:i}",
+                           "name", name,
+                           "nprocs", nprocs,
+                           "namespace", ns,
+                           "flags", flags))) {
+        errno = ENOMEM;
         return NULL;
     }
+    payload = txn_encode_request (txn, hdr);
+    json_decref (hdr);
+    if (!payload)
+        return NULL;
 
-    if (!(ctx = alloc_ctx ()))
+    if (!(ctx = alloc_ctx (h, ns))) {
+        ERRNO_SAFE_WRAP (free, payload);
         return NULL;
+    }
 
-    if (!(f = flux_rpc_pack (h, "kvs.fence", FLUX_NODEID_ANY, 0,
-                             "{s:s s:i s:s s:i s:O}",
-                             "name", name,
-                             "nprocs", nprocs,
-                             "namespace", ns,
-                             "flags", flags,
-                             "ops", ops)))
+    f = flux_rpc (h, "kvs.fence", payload, FLUX_NODEID_ANY, 0);
+    ERRNO_SAFE_WRAP (free, payload);
+    if (!f)
         goto error;
 
     if (flux_future_aux_set (f, auxkey, ctx, (flux_free_f)free_ctx) < 0)
@@ -102,7 +126,8 @@ flux_future_t *flux_kvs_commit (flux_t *h, const char *ns, int flags,
 {
     flux_future_t *f;
     struct commit_ctx *ctx = NULL;
-    json_t *ops;
+    json_t *hdr;
+    char *payload;
 
     if (!txn) {
         errno = EINVAL;
@@ -120,19 +145,25 @@ flux_future_t *flux_kvs_commit (flux_t *h, const char *ns, int flags,
         flags &= ~FLUX_KVS_TXN_COMPACT;
     }
 
-    if (!(ops = txn_get_ops (txn))) {
-        errno = EINVAL;
+    if (!(hdr = json_pack ("{s:s s:i}",
+                           "namespace", ns,
+                           "flags", flags))) {
+        errno = ENOMEM;
         return NULL;
     }
+    payload = txn_encode_request (txn, hdr);
+    json_decref (hdr);
+    if (!payload)
+        return NULL;
 
-    if (!(ctx = alloc_ctx ()))
+    if (!(ctx = alloc_ctx (h, ns))) {
+        ERRNO_SAFE_WRAP (free, payload);
         return NULL;
+    }
 
-    if (!(f = flux_rpc_pack (h, "kvs.commit", FLUX_NODEID_ANY, 0,
-                             "{s:s s:i s:O}",
-                             "namespace", ns,
-                             "flags", flags,
-                             "ops", ops)))
+    f = flux_rpc (h, "kvs.commit", payload, FLUX_NODEID_ANY, 0);
+    ERRNO_SAFE_WRAP (free, payload);
+    if (!f)
         goto error;
 
     if (flux_future_aux_set (f, auxkey, ctx, (flux_free_f)free_ctx) < 0)
@@ -13,11 +13,15 @@
  * Copy is implemented as a sequential lookup + put.
  *
  * Move is implemented as a sequential copy + unlink.
+ *
+ * Batch copy is implemented as parallel lookups + a single put
+ * transaction.
  */
 
 #if HAVE_CONFIG_H
 #include "config.h"
 #endif
+#include <stdio.h>
 #include <flux/core.h>
 
 #include "kvs_copy.h"
@@ -221,6 +225,152 @@ error:
     return NULL;
 }
 
+struct copy_batch_context {
+    int commit_flags;
+    char *dstns;
+    int count;
+    char **dstkeys;
+};
+
+static void copy_batch_context_destroy (struct copy_batch_context *ctx)
+{
+    if (ctx) {
+        int saved_errno = errno;
+        int i;
+        free (ctx->dstns);
+        if (ctx->dstkeys) {
+            for (i = 0; i < ctx->count; i++)
+                free (ctx->dstkeys[i]);
+            free (ctx->dstkeys);
+        }
+        free (ctx);
+        errno = saved_errno;
+    }
+}
+
+static struct copy_batch_context *copy_batch_context_create (
+                                                    const char *dstns,
+                                                    const char **dstkeys,
+                                                    int count,
+                                                    int commit_flags)
+{
+    struct copy_batch_context *ctx;
+    int i;
+
+    if (!(ctx = calloc (1, sizeof (*ctx))))
+        return NULL;
+    if ((dstns && !(ctx->dstns = strdup (dstns)))
+        || !(ctx->dstkeys = calloc (count, sizeof (ctx->dstkeys[0]))))
+        goto error;
+    ctx->count = count;
+    for (i = 0; i < count; i++) {
+        if (!(ctx->dstkeys[i] = strdup (dstkeys[i])))
+            goto error;
+    }
+    ctx->commit_flags = commit_flags;
+    return ctx;
+error:
+    copy_batch_context_destroy (ctx);
+    return NULL;
+}
+
+/* Batch copy: put all 'dstkeys' in one transaction once every lookup
+ * in the composite 'f' has finished.  Lookup futures are named by
+ * their index into the key arrays.
+ */
+static void batch_lookup_continuation (flux_future_t *f, void *arg)
+{
+    struct copy_batch_context *ctx = arg;
+    flux_t *h = flux_future_get_flux (f);
+    flux_kvs_txn_t *txn = NULL;
+    flux_future_t *f2;
+    char name[16];
+    int i;
+
+    if (!(txn = flux_kvs_txn_create ()))
+        goto error;
+    for (i = 0; i < ctx->count; i++) {
+        flux_future_t *lf;
+        const char *val;
+
+        snprintf (name, sizeof (name), "%d", i);
+        if (!(lf = flux_future_get_child (f, name))
+            || flux_kvs_lookup_get_treeobj (lf, &val) < 0
+            || flux_kvs_txn_put_treeobj (txn, 0, ctx->dstkeys[i], val) < 0)
+            goto error;
+    }
+    if (!(f2 = flux_kvs_commit (h, ctx->dstns, ctx->commit_flags, txn)))
+        goto error;
+    if (flux_future_continue (f, f2) < 0) {
+        flux_future_destroy (f2);
+        goto error;
+    }
+    goto done;
+error:
+    flux_future_continue_error (f, errno, NULL);
+done:
+    flux_future_destroy (f);
+    flux_kvs_txn_destroy (txn);
+}
+
+flux_future_t *flux_kvs_copy_batch (flux_t *h,
+                                    const char *srcns,
+                                    const char **srckeys,
+                                    const char *dstns,
+                                    const char **dstkeys,
+                                    int count,
+                                    int commit_flags)
+{
+    struct copy_batch_context *ctx;
+    flux_future_t *f1;
+    flux_future_t *f2;
+    char name[16];
+    int i;
+
+    if (!h || !srckeys || !dstkeys || count <= 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+    for (i = 0; i < count; i++) {
+        if (!srckeys[i] || !dstkeys[i]) {
+            errno = EINVAL;
+            return NULL;
+        }
+    }
+    if (!(f1 = flux_future_wait_all_create ()))
+        return NULL;
+    flux_future_set_flux (f1, h);
+    for (i = 0; i < count; i++) {
+        flux_future_t *lf;
+
+        snprintf (name, sizeof (name), "%d", i);
+        if (!(lf = flux_kvs_lookup (h, srcns, FLUX_KVS_TREEOBJ, srckeys[i])))
+            goto error;
+        if (flux_future_push (f1, name, lf) < 0) {
+            flux_future_destroy (lf);
+            goto error;
+        }
+    }
+    if (!(ctx = copy_batch_context_create (dstns,
+                                           dstkeys,
+                                           count,
+                                           commit_flags)))
+        goto error;
+    if (flux_future_aux_set (f1,
+                             NULL,
+                             ctx,
+                             (flux_free_f)copy_batch_context_destroy) < 0) {
+        copy_batch_context_destroy (ctx);
+        goto error;
+    }
+    if (!(f2 = flux_future_and_then (f1, batch_lookup_continuation, ctx)))
+        goto error;
+    return f2;
+error:
+    flux_future_destroy (f1);
+    return NULL;
+}
+
 /*
  * vi:tabstop=4 shiftwidth=4 expandtab
  */
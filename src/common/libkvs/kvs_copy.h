@@ -51,6 +51,21 @@ flux_future_t *flux_kvs_move (flux_t *h,
                               const char *dstkey,
                               int commit_flags);
 
+/* Copy each of the 'count' keys in 'srckeys' to the key at the same
+ * index in 'dstkeys'.  The source keys are looked up in parallel, then
+ * all destination keys are written by reference in a single transaction,
+ * so the batch costs one commit regardless of 'count'.
+ *
+ * Returns future on success, NULL on failure with errno set.
+ */
+flux_future_t *flux_kvs_copy_batch (flux_t *h,
+                                    const char *srcns,
+                                    const char **srckeys,
+                                    const char *dstns,
+                                    const char **dstkeys,
+                                    int count,
+                                    int commit_flags);
+
 #ifdef __cplusplus
 }
 #endif
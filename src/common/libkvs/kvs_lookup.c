@@ -18,6 +18,7 @@
 #include <czmq.h>
 #include <flux/core.h>
 
+#include "kvs_cache_private.h"
 #include "kvs_dir_private.h"
 #include "kvs_lookup.h"
 #include "kvs_util_private.h"
@@ -28,6 +29,8 @@ struct lookup_ctx {
     char *key;
     char *atref;
     int flags;
+    char *ns;          // namespace if result is to be cached, else NULL
+    bool cached;       // treeobj came from the cache, not a response
 
     json_t *treeobj;
     char *treeobj_str; // json_dumps of tree object returned from lookup
@@ -49,6 +52,7 @@ static void free_ctx (struct lookup_ctx *ctx)
     if (ctx) {
         free (ctx->key);
         free (ctx->atref);
+        free (ctx->ns);
         json_decref (ctx->treeobj);
         free (ctx->treeobj_str);
         free (ctx->val_data);
@@ -106,6 +110,29 @@ static int validate_lookup_flags (int flags, bool watch_ok)
     }
 }
 
+/* Return a future that is already fulfilled with a cached 'treeobj'.
+ */
+static flux_future_t *lookup_cached (flux_t *h,
+                                     struct lookup_ctx *ctx,
+                                     json_t *treeobj)
+{
+    flux_future_t *f;
+
+    if (!(f = flux_future_create (NULL, NULL)))
+        goto error;
+    flux_future_set_flux (f, h);
+    ctx->treeobj = json_incref (treeobj);
+    ctx->cached = true;
+    if (flux_future_aux_set (f, auxkey, ctx, (flux_free_f)free_ctx) < 0)
+        goto error;
+    flux_future_fulfill (f, NULL, NULL);
+    return f;
+error:
+    free_ctx (ctx);
+    flux_future_destroy (f);
+    return NULL;
+}
+
 flux_future_t *flux_kvs_lookup (flux_t *h,
                                 const char *ns,
                                 int flags,
@@ -115,6 +142,7 @@ flux_future_t *flux_kvs_lookup (flux_t *h,
     flux_future_t *f;
     const char *topic = "kvs.lookup";
     int rpc_flags = 0;
+    json_t *treeobj;
 
     if (!h || !key || strlen (key) == 0
         || validate_lookup_flags (flags, true) < 0) {
@@ -127,6 +155,15 @@ flux_future_t *flux_kvs_lookup (flux_t *h,
     }
     if (!(ctx = alloc_ctx (h, flags, key)))
         return NULL;
+    if (kvs_cache_enabled (h)) {
+        if ((treeobj = kvs_cache_lookup (h, ns, flags, key)))
+            return lookup_cached (h, ctx, treeobj);
+        if (!(ctx->ns = strdup (ns))) {
+            free_ctx (ctx);
+            errno = ENOMEM;
+            return NULL;
+        }
+    }
     if ((flags & FLUX_KVS_WATCH)
         || (flags & FLUX_KVS_WAITCREATE))
         topic = "kvs-watch.lookup"; // redirect to kvs-watch module
@@ -189,17 +226,56 @@ flux_future_t *flux_kvs_lookupat (flux_t *h, int flags, const char *key,
     return f;
 }
 
-static int decode_treeobj (flux_future_t *f, json_t **treeobj)
+flux_future_t *flux_kvs_lookup_stream (flux_t *h,
+                                       const char *ns,
+                                       int flags,
+                                       const char *key)
+{
+    struct lookup_ctx *ctx;
+    flux_future_t *f;
+
+    if (!h || !key || strlen (key) == 0 || flags != 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!ns) {
+        if (!(ns = kvs_get_namespace ()))
+            return NULL;
+    }
+    if (!(ctx = alloc_ctx (h, flags, key)))
+        return NULL;
+    if (!(f = flux_rpc_pack (h, "kvs.lookup-stream", FLUX_NODEID_ANY,
+                             FLUX_RPC_STREAMING,
+                             "{s:s s:s s:i}",
+                             "key", key,
+                             "namespace", ns,
+                             "flags", flags))) {
+        free_ctx (ctx);
+        return NULL;
+    }
+    if (flux_future_aux_set (f, auxkey, ctx, (flux_free_f)free_ctx) < 0) {
+        free_ctx (ctx);
+        flux_future_destroy (f);
+        return NULL;
+    }
+    return f;
+}
+
+static int decode_treeobj (flux_future_t *f, json_t **treeobj, int *rootseq)
 {
     json_t *obj;
+    int seq = -1;
 
-    if (flux_rpc_get_unpack (f, "{s:o}", "val", &obj) < 0)
+    if (flux_rpc_get_unpack (f, "{s:o s?i}",
+                             "val", &obj,
+                             "rootseq", &seq) < 0)
         return -1;
     if (treeobj_validate (obj) < 0) {
         errno = EPROTO;
         return -1;
     }
     *treeobj = obj;
+    *rootseq = seq;
     return 0;
 }
 
@@ -217,14 +293,24 @@ static struct lookup_ctx *get_lookup_ctx (flux_future_t *f)
 /* Parse the lookup response message, extracting the 'val' treeobj.
  * If decoded results were previously cached and the response has
  * changed (e.g. future has been reset and another response has arrived),
- * invalidate the cached results.
+ * invalidate the cached results.  A response with the root sequence
+ * is offered to the lookup cache, if enabled.
  */
 static int parse_response (flux_future_t *f, struct lookup_ctx *ctx)
 {
     json_t *treeobj2;
+    int rootseq;
 
-    if (decode_treeobj (f, &treeobj2) < 0)
+    if (ctx->cached)
+        return 0;
+    if (decode_treeobj (f, &treeobj2, &rootseq) < 0)
         return -1;
+    if (ctx->ns && rootseq >= 0) {
+        kvs_cache_insert (ctx->h, ctx->ns, ctx->flags, ctx->key,
+                          rootseq, treeobj2);
+        free (ctx->ns);
+        ctx->ns = NULL;
+    }
     if (!ctx->treeobj || !json_equal (ctx->treeobj, treeobj2)) {
         json_decref (ctx->treeobj);
         ctx->treeobj = json_incref (treeobj2);
@@ -20,6 +20,14 @@ flux_future_t *flux_kvs_lookup (flux_t *h, const char *ns, int flags,
 flux_future_t *flux_kvs_lookupat (flux_t *h, int flags, const char *key,
                                   const char *treeobj);
 
+/* Look up the value of 'key' as a stream of responses, one for each blob
+ * the value is stored in, in order.  Get each part of the value with
+ * flux_kvs_lookup_get_raw(), then flux_future_reset() the future to wait
+ * for the next.  The stream ends with an ENODATA error.  'flags' must be 0.
+ */
+flux_future_t *flux_kvs_lookup_stream (flux_t *h, const char *ns, int flags,
+                                       const char *key);
+
 int flux_kvs_lookup_get (flux_future_t *f, const char **value);
 int flux_kvs_lookup_get_unpack (flux_future_t *f, const char *fmt, ...);
 int flux_kvs_lookup_get_raw (flux_future_t *f, const void **data, int *len);
@@ -38,6 +46,16 @@ const char *flux_kvs_lookup_get_key (flux_future_t *f);
  */
 int flux_kvs_lookup_cancel (flux_future_t *f);
 
+/* Enable a cache of lookup results on 'h', so that repeated lookups of a
+ * key are answered locally until the namespace root changes.  Lookups of
+ * a namespace are cached after the first, which subscribes to its root
+ * change events.  A future answered from the cache is not an RPC future.
+ * A value committed via another handle is seen once the root change
+ * event arrives.  Only the instance owner may enable the cache.
+ * Returns 0 on success, -1 on failure with errno set.
+ */
+int flux_kvs_lookup_cache_enable (flux_t *h);
+
 #ifdef __cplusplus
 }
 #endif
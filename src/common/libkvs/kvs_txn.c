@@ -15,6 +15,10 @@
 #include <flux/core.h>
 #include <czmq.h>
 #include <string.h>
+#include <stdio.h>
+#include <sodium.h>
+
+#include "src/common/libutil/errno_safe.h"
 
 #include "kvs_txn_private.h"
 #include "treeobj.h"
@@ -35,6 +39,13 @@
  * A zero-length value may be stored in the KVS via
  * flux_kvs_txn_put (value=NULL) or flux_kvs_txn_put_raw (data=NULL,len=0).
  * A NULL format string passed to flux_kvs_txn_pack() is invalid.
+ *
+ * Encoding:
+ * Operations are appended to txn->buf as JSON text, "[op,op,...", so a
+ * commit request can be sent without building a json_t per operation.
+ * Values are written straight into the buffer as base64.  The ops array
+ * is decoded from the buffer only on demand, e.g. for compaction, and is
+ * kept in sync with the buffer from then on.
  */
 
 void flux_kvs_txn_destroy (flux_kvs_txn_t *txn)
@@ -42,11 +53,38 @@ void flux_kvs_txn_destroy (flux_kvs_txn_t *txn)
     if (txn) {
         int saved_errno = errno;
         json_decref (txn->ops);
+        free (txn->buf);
         free (txn);
         errno = saved_errno;
     }
 }
 
+static int txn_buf_reserve (flux_kvs_txn_t *txn, size_t n)
+{
+    if (txn->len + n > txn->size) {
+        size_t size = txn->size ? txn->size : 256;
+        char *buf;
+        while (size < txn->len + n)
+            size *= 2;
+        if (!(buf = realloc (txn->buf, size))) {
+            errno = ENOMEM;
+            return -1;
+        }
+        txn->buf = buf;
+        txn->size = size;
+    }
+    return 0;
+}
+
+static int txn_buf_put (flux_kvs_txn_t *txn, const char *data, size_t len)
+{
+    if (txn_buf_reserve (txn, len) < 0)
+        return -1;
+    memcpy (txn->buf + txn->len, data, len);
+    txn->len += len;
+    return 0;
+}
+
 flux_kvs_txn_t *flux_kvs_txn_create (void)
 {
     flux_kvs_txn_t *txn = calloc (1, sizeof (*txn));
@@ -54,16 +92,130 @@ flux_kvs_txn_t *flux_kvs_txn_create (void)
         errno = ENOMEM;
         goto error;
     }
-    if (!(txn->ops = json_array ())) {
-        errno = ENOMEM;
+    if (txn_buf_put (txn, "[", 1) < 0)
         goto error;
-    }
     return txn;
 error:
     flux_kvs_txn_destroy (txn);
     return NULL;
 }
 
+/* Return the length of the UTF-8 sequence at 's', or -1 if invalid.
+ * Overlong forms, surrogates, and code points above U+10FFFF are invalid,
+ * as they are to jansson.
+ */
+static int utf8_seqlen (const unsigned char *s)
+{
+    unsigned int c;
+    int i, n;
+
+    if (s[0] < 0x80)
+        return 1;
+    if (s[0] >= 0xc2 && s[0] <= 0xdf)
+        n = 2, c = s[0] & 0x1f;
+    else if (s[0] >= 0xe0 && s[0] <= 0xef)
+        n = 3, c = s[0] & 0x0f;
+    else if (s[0] >= 0xf0 && s[0] <= 0xf4)
+        n = 4, c = s[0] & 0x07;
+    else
+        return -1;
+    for (i = 1; i < n; i++) {
+        if ((s[i] & 0xc0) != 0x80)
+            return -1;
+        c = (c << 6) | (s[i] & 0x3f);
+    }
+    if ((n == 3 && c < 0x800)
+        || (n == 4 && (c < 0x10000 || c > 0x10ffff))
+        || (c >= 0xd800 && c <= 0xdfff))
+        return -1;
+    return n;
+}
+
+/* Append 's' as a quoted JSON string.
+ */
+static int txn_buf_put_str (flux_kvs_txn_t *txn, const char *s)
+{
+    const unsigned char *p = (const unsigned char *)s;
+    const unsigned char *span = p;
+    char esc[8];
+    int n;
+
+    if (txn_buf_put (txn, "\"", 1) < 0)
+        return -1;
+    while (*p) {
+        if (*p >= 0x20 && *p != '"' && *p != '\\') {
+            if ((n = utf8_seqlen (p)) < 0) {
+                errno = EINVAL;
+                return -1;
+            }
+            p += n;
+            continue;
+        }
+        if (txn_buf_put (txn, (const char *)span, p - span) < 0)
+            return -1;
+        switch (*p) {
+            case '"':
+                strcpy (esc, "\\\"");
+                break;
+            case '\\':
+                strcpy (esc, "\\\\");
+                break;
+            case '\n':
+                strcpy (esc, "\\n");
+                break;
+            case '\t':
+                strcpy (esc, "\\t");
+                break;
+            default:
+                snprintf (esc, sizeof (esc), "\\u%04x", *p);
+                break;
+        }
+        if (txn_buf_put (txn, esc, strlen (esc)) < 0)
+            return -1;
+        span = ++p;
+    }
+    if (txn_buf_put (txn, (const char *)span, p - span) < 0
+        || txn_buf_put (txn, "\"", 1) < 0)
+        return -1;
+    return 0;
+}
+
+/* Append 'data' base64 encoded per RFC 11.
+ */
+static int txn_buf_put_base64 (flux_kvs_txn_t *txn, const void *data, int len)
+{
+    size_t xlen;
+
+    xlen = sodium_base64_encoded_len (len, sodium_base64_VARIANT_ORIGINAL);
+    if (txn_buf_reserve (txn, xlen) < 0)
+        return -1;
+    sodium_bin2base64 (txn->buf + txn->len, xlen,
+                       (const unsigned char *)data, len,
+                       sodium_base64_VARIANT_ORIGINAL);
+    txn->len += xlen - 1; // drop NUL
+    return 0;
+}
+
+/* Decode the op that begins at txn->buf + 'start' and add it to
+ * txn->ops, if the ops array has been decoded.
+ */
+static int txn_sync_ops (flux_kvs_txn_t *txn, size_t start)
+{
+    json_t *op;
+
+    if (!txn->ops)
+        return 0;
+    if (!(op = json_loadb (txn->buf + start, txn->len - start, 0, NULL))) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (json_array_append_new (txn->ops, op) < 0) {
+        errno = ENOMEM;
+        return -1;
+    }
+    return 0;
+}
+
 static int validate_flags (int flags, int allowed)
 {
     if ((flags & allowed) != flags) {
@@ -73,6 +225,28 @@ static int validate_flags (int flags, int allowed)
     return 0;
 }
 
+/* Append the encoding of an operation.
+ */
+static int append_op_to_buf (flux_kvs_txn_t *txn, json_t *op)
+{
+    size_t start = txn->len;
+    char *s;
+
+    if (!(s = json_dumps (op, JSON_COMPACT))) {
+        errno = ENOMEM;
+        return -1;
+    }
+    if ((txn->count > 0 && txn_buf_put (txn, ",", 1) < 0)
+        || txn_buf_put (txn, s, strlen (s)) < 0) {
+        free (s);
+        txn->len = start;
+        return -1;
+    }
+    free (s);
+    txn->count++;
+    return 0;
+}
+
 /* Add an operation on dirent to the transaction.
  * Takes a reference on dirent so caller retains ownership.
  */
@@ -84,10 +258,16 @@ static int append_op_to_txn (flux_kvs_txn_t *txn, int flags,
 
     if (txn_encode_op (key, flags, dirent, &op) < 0)
         goto error;
-    if (json_array_append_new (txn->ops, op) < 0) {
-        errno = ENOMEM;
+    if (append_op_to_buf (txn, op) < 0)
         goto error;
+    if (txn->ops) {
+        if (json_array_append_new (txn->ops, op) < 0) {
+            errno = ENOMEM;
+            goto error;
+        }
+        op = NULL;
     }
+    json_decref (op);
     return 0;
 error:
     saved_errno = errno;
@@ -96,32 +276,52 @@ error:
     return -1;
 }
 
-int flux_kvs_txn_put_raw (flux_kvs_txn_t *txn, int flags,
-                          const char *key, const void *data, int len)
+/* Add an operation assigning a 'val' to 'key', encoding it directly
+ * into the buffer.  This is the common case, so no json_t is built for it.
+ */
+static int append_val_to_txn (flux_kvs_txn_t *txn, int flags,
+                              const char *key, const void *data, int len)
 {
-    json_t *dirent = NULL;
-    int saved_errno;
+    size_t start = txn->len;
+    size_t opstart;
+    char hdr[64];
 
-    if (!txn || !key) {
+    if (strlen (key) == 0 || len < 0) {
         errno = EINVAL;
-        goto error;
+        return -1;
     }
-    if (validate_flags (flags, FLUX_KVS_APPEND) < 0)
-        goto error;
-    if (!(dirent = treeobj_create_val (data, len)))
-        goto error;
-    if (append_op_to_txn (txn, flags, key, dirent) < 0)
-        goto error;
-    json_decref (dirent);
+    if (txn->count > 0 && txn_buf_put (txn, ",", 1) < 0)
+        goto error;
+    opstart = txn->len;
+    snprintf (hdr, sizeof (hdr),
+              ",\"flags\":%d,\"dirent\":{\"ver\":1,\"type\":\"val\","
+              "\"data\":\"", flags);
+    if (txn_buf_put (txn, "{\"key\":", 7) < 0
+        || txn_buf_put_str (txn, key) < 0
+        || txn_buf_put (txn, hdr, strlen (hdr)) < 0
+        || txn_buf_put_base64 (txn, data, len) < 0
+        || txn_buf_put (txn, "\"}}", 3) < 0
+        || txn_sync_ops (txn, opstart) < 0)
+        goto error;
+    txn->count++;
     return 0;
-
 error:
-    saved_errno = errno;
-    json_decref (dirent);
-    errno = saved_errno;
+    txn->len = start;
     return -1;
 }
 
+int flux_kvs_txn_put_raw (flux_kvs_txn_t *txn, int flags,
+                          const char *key, const void *data, int len)
+{
+    if (!txn || !key) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (validate_flags (flags, FLUX_KVS_APPEND) < 0)
+        return -1;
+    return append_val_to_txn (txn, flags, key, data, len);
+}
+
 int flux_kvs_txn_put_treeobj (flux_kvs_txn_t *txn, int flags,
                               const char *key, const char *treeobj)
 {
@@ -151,68 +351,46 @@ error:
 int flux_kvs_txn_put (flux_kvs_txn_t *txn, int flags,
                       const char *key, const char *value)
 {
-    json_t *dirent = NULL;
-    int saved_errno;
-
     if (!txn || !key) {
         errno = EINVAL;
-        goto error;
+        return -1;
     }
     if (validate_flags (flags, FLUX_KVS_APPEND) < 0)
-        goto error;
-    if (!(dirent = treeobj_create_val (value, value ? strlen (value) : 0)))
-        goto error;
-    if (append_op_to_txn (txn, flags, key, dirent) < 0)
-        goto error;
-    json_decref (dirent);
-    return 0;
-
-error:
-    saved_errno = errno;
-    json_decref (dirent);
-    errno = saved_errno;
-    return -1;
+        return -1;
+    return append_val_to_txn (txn,
+                              flags,
+                              key,
+                              value,
+                              value ? strlen (value) : 0);
 }
 
 int flux_kvs_txn_vpack (flux_kvs_txn_t *txn, int flags,
                         const char *key, const char *fmt, va_list ap)
 {
-    json_t *val, *dirent = NULL;
-    int saved_errno;
+    json_t *val;
     char *s;
+    int rc;
 
     if (!txn || !key || !fmt) {
         errno = EINVAL;
-        goto error;
+        return -1;
     }
     if (validate_flags (flags, FLUX_KVS_APPEND) < 0)
-        goto error;
+        return -1;
     val = json_vpack_ex (NULL, 0, fmt, ap);
     if (!val) {
         errno = EINVAL;
-        goto error;
+        return -1;
     }
     if (!(s = json_dumps (val, JSON_ENCODE_ANY))) {
         errno = ENOMEM;
         json_decref (val);
-        goto error;
+        return -1;
     }
     json_decref (val);
-    if (!(dirent = treeobj_create_val (s, strlen (s)))) {
-        free (s);
-        goto error;
-    }
-    free (s);
-    if (append_op_to_txn (txn, flags, key, dirent) < 0)
-        goto error;
-    json_decref (dirent);
-    return 0;
-
-error:
-    saved_errno = errno;
-    json_decref (dirent);
-    errno = saved_errno;
-    return -1;
+    rc = append_val_to_txn (txn, flags, key, s, strlen (s));
+    ERRNO_SAFE_WRAP (free, s);
+    return rc;
 }
 
 int flux_kvs_txn_pack (flux_kvs_txn_t *txn, int flags,
@@ -312,17 +490,83 @@ error:
 
 int txn_get_op_count (flux_kvs_txn_t *txn)
 {
-    return json_array_size (txn->ops);
+    return txn->count;
 }
 
+/* Decode the ops array from the buffer on first use.  The buffer has
+ * room for the closing bracket, which is not counted in txn->len.
+ */
 json_t *txn_get_ops (flux_kvs_txn_t *txn)
 {
+    if (!txn->ops) {
+        if (txn_buf_reserve (txn, 1) < 0)
+            return NULL;
+        txn->buf[txn->len] = ']';
+        if (!(txn->ops = json_loadb (txn->buf, txn->len + 1, 0, NULL))) {
+            errno = EINVAL;
+            return NULL;
+        }
+    }
     return txn->ops;
 }
 
+int txn_set_ops (flux_kvs_txn_t *txn, json_t *ops)
+{
+    size_t len = txn->len;
+    int count = txn->count;
+    json_t *op;
+    size_t index;
+
+    txn->len = 1; // keep "["
+    txn->count = 0;
+    json_array_foreach (ops, index, op) {
+        if (append_op_to_buf (txn, op) < 0) {
+            txn->len = len;
+            txn->count = count;
+            return -1;
+        }
+    }
+    json_incref (ops);
+    json_decref (txn->ops);
+    txn->ops = ops;
+    return 0;
+}
+
+char *txn_encode_request (flux_kvs_txn_t *txn, json_t *hdr)
+{
+    char *s;
+    char *payload;
+    size_t len;
+
+    if (!(s = json_dumps (hdr, JSON_COMPACT)))
+        goto nomem;
+    len = strlen (s);
+    if (len < 2 || s[len - 1] != '}') {
+        free (s);
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(payload = malloc (len + txn->len + 10))) {
+        free (s);
+        goto nomem;
+    }
+    /* {hdr,"ops":[op,op,...]}
+     */
+    memcpy (payload, s, len - 1);
+    sprintf (payload + len - 1, "%s\"ops\":", len > 2 ? "," : "");
+    len = strlen (payload);
+    memcpy (payload + len, txn->buf, txn->len);
+    strcpy (payload + len + txn->len, "]}");
+    free (s);
+    return payload;
+nomem:
+    errno = ENOMEM;
+    return NULL;
+}
+
 int txn_get_op (flux_kvs_txn_t *txn, int index, json_t **op)
 {
-    json_t *entry = json_array_get (txn->ops, index);
+    json_t *entry = json_array_get (txn_get_ops (txn), index);
     if (!entry) {
         errno = EINVAL;
         return -1;
@@ -199,7 +199,8 @@ int txn_compact (flux_kvs_txn_t *txn)
 {
     struct compact_key *ck;
     zhash_t *append_keys = NULL;
-    json_t *ops_new;
+    json_t *ops;
+    json_t *ops_new = NULL;
     size_t len;
     int saved_errno, i;
 
@@ -208,7 +209,9 @@ int txn_compact (flux_kvs_txn_t *txn)
         return -1;
     }
 
-    len = json_array_size (txn->ops);
+    if (!(ops = txn_get_ops (txn)))
+        return -1;
+    len = json_array_size (ops);
     if (!len)
         return 0;
 
@@ -228,7 +231,7 @@ int txn_compact (flux_kvs_txn_t *txn)
         int flags;
         json_t *dirent;
 
-        if (!(entry = json_array_get (txn->ops, i))) {
+        if (!(entry = json_array_get (ops, i))) {
             errno = EINVAL;
             goto error;
         }
@@ -298,8 +301,9 @@ int txn_compact (flux_kvs_txn_t *txn)
         ck = zhash_next (append_keys);
     }
 
-    json_decref (txn->ops);
-    txn->ops = ops_new;
+    if (txn_set_ops (txn, ops_new) < 0)
+        goto error;
+    json_decref (ops_new);
     zhash_destroy (&append_keys);
     return 0;
 
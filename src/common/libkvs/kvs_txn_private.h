@@ -12,13 +12,31 @@
 #define _KVS_TXN_PRIVATE_H
 
 struct flux_kvs_txn {
-    json_t *ops;
+    char *buf;          /* "[op,op,..." as JSON text, see kvs_txn.c */
+    size_t len;
+    size_t size;
+    int count;
+    json_t *ops;        /* decoded from buf on demand, or NULL */
 };
 
 int txn_get_op_count (flux_kvs_txn_t *txn);
 
+/* Get the ops array, decoding it first if necessary.
+ * The array belongs to the transaction and must not be modified.
+ */
 json_t *txn_get_ops (flux_kvs_txn_t *txn);
 
+/* Replace the transaction's operations with 'ops'.
+ * Takes a reference on 'ops'.
+ */
+int txn_set_ops (flux_kvs_txn_t *txn, json_t *ops);
+
+/* Encode a request payload containing the members of object 'hdr' plus
+ * an "ops" array with the transaction's operations.  The operations are
+ * copied from the buffer without being decoded.  Caller must free.
+ */
+char *txn_encode_request (flux_kvs_txn_t *txn, json_t *hdr);
+
 int txn_get_op (flux_kvs_txn_t *txn, int index, json_t **op);
 
 int txn_decode_op (json_t *op, const char **key, int *flags, json_t **dirent);
@@ -27,6 +27,20 @@ void errors (void)
     ok (flux_kvs_namespace_create (NULL, NULL, 0, 5) == NULL && errno == EINVAL,
         "flux_kvs_namespace_create fails on bad input");
 
+    errno = 0;
+    ok (flux_kvs_namespace_create_rank (NULL, "ns", 0, FLUX_NODEID_ANY, 0) == NULL
+        && errno == EINVAL,
+        "flux_kvs_namespace_create_rank fails on bad rank");
+
+    errno = 0;
+    ok (flux_kvs_namespace_create (NULL, "ns", 0, 2) == NULL && errno == EINVAL,
+        "flux_kvs_namespace_create fails on unknown flags");
+
+    errno = 0;
+    ok (flux_kvs_namespace_clone (NULL, "src", "ns", 0) == NULL
+        && errno == EINVAL,
+        "flux_kvs_namespace_clone fails on bad input");
+
     errno = 0;
     ok (flux_kvs_namespace_remove (NULL, NULL) == NULL && errno == EINVAL,
         "flux_kvs_namespace_remove fails on bad input");
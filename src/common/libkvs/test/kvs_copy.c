@@ -21,6 +21,7 @@
 int main (int argc, char *argv[])
 {
     flux_t *h = (flux_t *)(uintptr_t)42;
+    const char *keys[] = { "a", NULL };
 
     plan (NO_PLAN);
 
@@ -50,6 +51,23 @@ int main (int argc, char *argv[])
         && errno == EINVAL,
         "flux_kvs_move srckey=NULL fails with EINVAL");
 
+    errno = 0;
+    ok (flux_kvs_copy_batch (NULL, NULL, keys, NULL, keys, 1, 0) == NULL
+        && errno == EINVAL,
+        "flux_kvs_copy_batch h=NULL fails with EINVAL");
+    errno = 0;
+    ok (flux_kvs_copy_batch (h, NULL, NULL, NULL, keys, 1, 0) == NULL
+        && errno == EINVAL,
+        "flux_kvs_copy_batch srckeys=NULL fails with EINVAL");
+    errno = 0;
+    ok (flux_kvs_copy_batch (h, NULL, keys, NULL, keys, 0, 0) == NULL
+        && errno == EINVAL,
+        "flux_kvs_copy_batch count=0 fails with EINVAL");
+    errno = 0;
+    ok (flux_kvs_copy_batch (h, NULL, keys, NULL, keys, 2, 0) == NULL
+        && errno == EINVAL,
+        "flux_kvs_copy_batch with NULL key fails with EINVAL");
+
     done_testing();
     return (0);
 }
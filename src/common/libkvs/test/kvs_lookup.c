@@ -33,6 +33,10 @@ void errors (void)
     ok (flux_kvs_lookupat (NULL, 0, NULL, NULL) == NULL && errno == EINVAL,
         "flux_kvs_lookupat fails on bad input");
 
+    errno = 0;
+    ok (flux_kvs_lookup_stream (NULL, NULL, 0, NULL) == NULL && errno == EINVAL,
+        "flux_kvs_lookup_stream fails on bad input");
+
     errno = 0;
     ok (flux_kvs_lookup_get (NULL, NULL) < 0 && errno == EINVAL,
         "flux_kvs_lookup_get fails on bad input");
@@ -53,6 +57,10 @@ void errors (void)
     ok (flux_kvs_lookup_cancel (NULL) == -1 && errno == EINVAL,
         "flux_kvs_lookup_cancel future=NULL fails with EINVAL");
 
+    errno = 0;
+    ok (flux_kvs_lookup_cache_enable (NULL) < 0 && errno == EINVAL,
+        "flux_kvs_lookup_cache_enable h=NULL fails with EINVAL");
+
     if (!(f = flux_future_create (NULL, NULL)))
         BAIL_OUT ("flux_future_create failed");
 
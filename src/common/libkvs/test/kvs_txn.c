@@ -380,6 +380,88 @@ void test_corner_cases (void)
     json_decref (val);
 }
 
+void test_encoding (void)
+{
+    flux_kvs_txn_t *txn;
+    json_t *hdr, *o, *ops, *entry, *dirent;
+    const char *ns, *key;
+    char *payload;
+    int flags;
+
+    if (!(txn = flux_kvs_txn_create ()))
+        BAIL_OUT ("flux_kvs_txn_create failed");
+
+    if (!(hdr = json_object ()))
+        BAIL_OUT ("json_object failed");
+    ok ((payload = txn_encode_request (txn, hdr)) != NULL
+        && !strcmp (payload, "{\"ops\":[]}"),
+        "txn_encode_request works on empty txn and header");
+    free (payload);
+    json_decref (hdr);
+
+    ok (flux_kvs_txn_put (txn, 0, "a.\"b\"\\c\n", "42") == 0,
+        "flux_kvs_txn_put works with key that needs escaping");
+    ok (flux_kvs_txn_put (txn, 0, "caf\xc3\xa9", "x") == 0,
+        "flux_kvs_txn_put works with UTF-8 key");
+    errno = 0;
+    ok (flux_kvs_txn_put (txn, 0, "bad\xc3", "x") < 0 && errno == EINVAL,
+        "flux_kvs_txn_put fails with EINVAL on invalid UTF-8 key");
+    errno = 0;
+    ok (flux_kvs_txn_put_raw (txn, 0, "", "x", 1) < 0 && errno == EINVAL,
+        "flux_kvs_txn_put_raw fails with EINVAL on empty key");
+    ok (txn_get_op_count (txn) == 2,
+        "failed puts did not add ops");
+
+    if (!(hdr = json_pack ("{s:s s:i}", "namespace", "primary", "flags", 0)))
+        BAIL_OUT ("json_pack failed");
+    payload = txn_encode_request (txn, hdr);
+    ok (payload != NULL,
+        "txn_encode_request works");
+    o = payload ? json_loads (payload, 0, NULL) : NULL;
+    ok (o != NULL
+        && json_unpack (o, "{s:s s:o}", "namespace", &ns, "ops", &ops) == 0
+        && !strcmp (ns, "primary")
+        && json_array_size (ops) == 2,
+        "request contains header and ops");
+    ok (o != NULL
+        && txn_decode_op (json_array_get (ops, 0), &key, &flags, &dirent) == 0
+        && !strcmp (key, "a.\"b\"\\c\n")
+        && check_int_value (dirent, 42) == 0,
+        "escaped key and value are decoded intact");
+    ok (o != NULL
+        && txn_decode_op (json_array_get (ops, 1), &key, NULL, NULL) == 0
+        && !strcmp (key, "caf\xc3\xa9"),
+        "UTF-8 key is decoded intact");
+    json_decref (o);
+    free (payload);
+
+    ok ((ops = txn_get_ops (txn)) != NULL && json_array_size (ops) == 2,
+        "txn_get_ops works");
+    ok (flux_kvs_txn_unlink (txn, 0, "b") == 0
+        && flux_kvs_txn_put (txn, 0, "c", "43") == 0,
+        "ops can be added after txn_get_ops");
+    ok ((ops = txn_get_ops (txn)) != NULL
+        && json_array_size (ops) == 3
+        && txn_get_op_count (txn) == 3
+        && txn_get_op (txn, 2, &entry) == 0
+        && txn_decode_op (entry, &key, NULL, &dirent) == 0
+        && !strcmp (key, "c")
+        && check_int_value (dirent, 43) == 0,
+        "decoded ops are kept in sync with the buffer");
+
+    payload = txn_encode_request (txn, hdr);
+    o = payload ? json_loads (payload, 0, NULL) : NULL;
+    ok (o != NULL
+        && json_unpack (o, "{s:o}", "ops", &ops) == 0
+        && json_equal (ops, txn_get_ops (txn)),
+        "request ops match decoded ops");
+    json_decref (o);
+    free (payload);
+
+    json_decref (hdr);
+    flux_kvs_txn_destroy (txn);
+}
+
 int main (int argc, char *argv[])
 {
 
@@ -388,6 +470,7 @@ int main (int argc, char *argv[])
     basic ();
     test_raw_values ();
     test_corner_cases ();
+    test_encoding ();
 
     done_testing();
     return (0);
@@ -383,6 +383,116 @@ void test_dir (void)
     json_decref (dir);
 }
 
+void test_dirshard (void)
+{
+    json_t *dirshard, *dirref, *dir, *val, *cpy;
+    int count[TREEOBJ_DIRSHARD_WIDTH] = { 0 };
+    int used = 0;
+    char *b;
+    size_t len;
+    int index;
+    int i;
+
+    errno = 0;
+    ok (treeobj_create_dirshard (-1) == NULL && errno == EINVAL,
+        "treeobj_create_dirshard level=-1 fails with EINVAL");
+    errno = 0;
+    ok (treeobj_create_dirshard (TREEOBJ_DIRSHARD_LEVELS) == NULL
+        && errno == EINVAL,
+        "treeobj_create_dirshard level=TREEOBJ_DIRSHARD_LEVELS fails");
+    ok ((dirshard = treeobj_create_dirshard (1)) != NULL,
+        "treeobj_create_dirshard works");
+    ok (treeobj_is_dirshard (dirshard) && !treeobj_is_dir (dirshard),
+        "treeobj_is_dirshard returns true");
+    ok (treeobj_validate (dirshard) == 0,
+        "treeobj_validate likes empty dirshard");
+    ok (treeobj_get_dirshard_level (dirshard) == 1,
+        "treeobj_get_dirshard_level returns 1");
+    ok (treeobj_get_count (dirshard) == 0,
+        "treeobj_get_count returns 0");
+
+    index = treeobj_dirshard_index (1, "foo");
+    ok (index >= 0 && index < TREEOBJ_DIRSHARD_WIDTH,
+        "treeobj_dirshard_index returns index in range");
+    ok (treeobj_dirshard_index (1, "foo") == index,
+        "treeobj_dirshard_index is consistent");
+    errno = 0;
+    ok (treeobj_dirshard_index (TREEOBJ_DIRSHARD_LEVELS, "foo") < 0
+        && errno == EINVAL,
+        "treeobj_dirshard_index fails with EINVAL on bad level");
+
+    errno = 0;
+    ok (treeobj_get_shard (dirshard, index) == NULL && errno == ENOENT,
+        "treeobj_get_shard fails with ENOENT on missing shard");
+    errno = 0;
+    ok (treeobj_peek_shard (dirshard, TREEOBJ_DIRSHARD_WIDTH) == NULL
+        && errno == EINVAL,
+        "treeobj_peek_shard fails with EINVAL on bad index");
+
+    if (!(dirref = treeobj_create_dirref (blobrefs[0]))
+        || !(dir = treeobj_create_dir ())
+        || !(val = treeobj_create_val ("foo", 3)))
+        BAIL_OUT ("could not create treeobjs");
+    errno = 0;
+    ok (treeobj_insert_shard (dirshard, 0, val) < 0 && errno == EINVAL,
+        "treeobj_insert_shard rejects val shard");
+    ok (treeobj_insert_entry (dir, "foo", val) == 0
+        && treeobj_insert_shard (dirshard, index, dir) == 0,
+        "treeobj_insert_shard works with dir shard");
+    ok (treeobj_insert_shard (dirshard, (index + 1) % 16, dirref) == 0,
+        "treeobj_insert_shard works with dirref shard");
+    ok (treeobj_get_count (dirshard) == 2,
+        "treeobj_get_count returns 2");
+    ok (treeobj_validate (dirshard) == 0,
+        "treeobj_validate likes dirshard");
+    ok (treeobj_peek_shard (dirshard, index) != NULL
+        && treeobj_is_dir (treeobj_peek_shard (dirshard, index)),
+        "treeobj_peek_shard returns dir shard");
+
+    ok ((cpy = treeobj_copy (dirshard)) != NULL
+        && json_equal (cpy, dirshard) == 1,
+        "treeobj_copy works on dirshard");
+    ok (treeobj_delete_shard (cpy, index) == 0
+        && treeobj_get_count (cpy) == 1
+        && treeobj_get_count (dirshard) == 2,
+        "treeobj_delete_shard on copy does not affect original");
+    errno = 0;
+    ok (treeobj_delete_shard (cpy, index) < 0 && errno == ENOENT,
+        "treeobj_delete_shard fails with ENOENT on missing shard");
+    json_decref (cpy);
+
+    ok ((b = treeobj_encode_binary (dirshard, &len)) != NULL,
+        "treeobj_encode_binary works on dirshard");
+    cpy = b ? treeobj_decodeb (b, len) : NULL;
+    ok (cpy != NULL && json_equal (cpy, dirshard) == 1,
+        "and round trips");
+    json_decref (cpy);
+    free (b);
+
+    /* All the names that hash to a shard at level 0 are spread over
+     * more than one shard at level 1.
+     */
+    for (i = 0; i < 1000; i++) {
+        char name[16];
+        snprintf (name, sizeof (name), "job%d", i);
+        if (treeobj_dirshard_index (0, name) == 0)
+            count[treeobj_dirshard_index (1, name)]++;
+    }
+    for (i = 0; i < TREEOBJ_DIRSHARD_WIDTH; i++) {
+        if (count[i] > 0)
+            used++;
+    }
+    ok (used > 1,
+        "names in one level 0 shard are split across %d level 1 shards",
+        used);
+
+    diag_json (dirshard);
+    json_decref (val);
+    json_decref (dir);
+    json_decref (dirref);
+    json_decref (dirshard);
+}
+
 void test_dir_peek (void)
 {
     json_t *dir;
@@ -801,6 +911,141 @@ void test_corner_cases (void)
     json_decref (symlink);
 }
 
+/* Build a dir containing one of each treeobj type, inserting entries
+ * in forward or reverse order.
+ */
+json_t *create_mixed_dir (int reverse)
+{
+    const char *names[] = { "val", "valref", "dirref", "link", "nslink", "sub" };
+    int n = sizeof (names) / sizeof (names[0]);
+    json_t *dir, *sub, *ent;
+    int i, j;
+
+    if (!(dir = treeobj_create_dir ()) || !(sub = treeobj_create_dir ()))
+        return NULL;
+    if (!(ent = treeobj_create_val ("hello", 5))
+        || treeobj_insert_entry (sub, "greeting", ent) < 0)
+        return NULL;
+    json_decref (ent);
+
+    for (j = 0; j < n; j++) {
+        i = reverse ? n - 1 - j : j;
+        switch (i) {
+            case 0:
+                ent = treeobj_create_val ("\0\1\2", 3);
+                break;
+            case 1:
+                ent = treeobj_create_valref (blobrefs[0]);
+                if (ent && treeobj_append_blobref (ent, blobrefs[1]) < 0)
+                    return NULL;
+                break;
+            case 2:
+                ent = treeobj_create_dirref (blobrefs[1]);
+                break;
+            case 3:
+                ent = treeobj_create_symlink (NULL, "a.b.c");
+                break;
+            case 4:
+                ent = treeobj_create_symlink ("ns", "x.y");
+                break;
+            default:
+                ent = json_incref (sub);
+                break;
+        }
+        if (!ent || treeobj_insert_entry (dir, names[i], ent) < 0)
+            return NULL;
+        json_decref (ent);
+    }
+    json_decref (sub);
+    return dir;
+}
+
+void test_codec_binary (void)
+{
+    json_t *dir1, *dir2, *large, *cpy;
+    char *b1, *b2, *s;
+    size_t len1, len2;
+    size_t i;
+
+    if (!(dir1 = create_mixed_dir (0))
+        || !(dir2 = create_mixed_dir (1))
+        || !(large = create_large_dir ()))
+        BAIL_OUT ("could not create test directories");
+
+    errno = 0;
+    ok (treeobj_encode_binary (NULL, &len1) == NULL && errno == EINVAL,
+        "treeobj_encode_binary obj=NULL fails with EINVAL");
+
+    b1 = treeobj_encode_binary (dir1, &len1);
+    b2 = treeobj_encode_binary (dir2, &len2);
+    ok (b1 != NULL && b2 != NULL,
+        "treeobj_encode_binary works on dir with all treeobj types");
+    if (!b1 || !b2)
+        BAIL_OUT ("could not continue");
+    ok (len1 == len2 && memcmp (b1, b2, len1) == 0,
+        "encoding does not depend on insertion order");
+
+    cpy = treeobj_decodeb (b1, len1);
+    ok (cpy != NULL && json_equal (cpy, dir1) == 1,
+        "treeobj_decodeb auto-detects binary encoding and round trips");
+    if (!cpy)
+        diag ("%m");
+    json_decref (cpy);
+
+    errno = 0;
+    ok (treeobj_decodeb (b1, len1 - 1) == NULL && errno == EPROTO,
+        "treeobj_decodeb fails with EPROTO on truncated input");
+    if (!(b2 = realloc (b2, len2 + 1)))
+        BAIL_OUT ("realloc failed");
+    b2[len2] = '\0';
+    errno = 0;
+    ok (treeobj_decodeb (b2, len2 + 1) == NULL && errno == EPROTO,
+        "treeobj_decodeb fails with EPROTO on trailing data");
+    b1[4] = 99;
+    errno = 0;
+    ok (treeobj_decodeb (b1, len1) == NULL && errno == EPROTO,
+        "treeobj_decodeb fails with EPROTO on unknown object type");
+    free (b1);
+    free (b2);
+
+    /* Rename "a" to "c" in the encoding of { "a", "b" } so the entries
+     * are no longer sorted.
+     */
+    json_decref (dir2);
+    if (!(dir2 = treeobj_create_dir ())
+        || !(cpy = treeobj_create_symlink (NULL, "t"))
+        || treeobj_insert_entry (dir2, "a", cpy) < 0
+        || treeobj_insert_entry (dir2, "b", cpy) < 0)
+        BAIL_OUT ("could not create two entry dir");
+    json_decref (cpy);
+    if (!(b2 = treeobj_encode_binary (dir2, &len2)))
+        BAIL_OUT ("treeobj_encode_binary failed");
+    for (i = 1; i + 1 < len2; i++) {
+        if (b2[i] == 'a' && b2[i - 1] == 1 && b2[i + 1] == '\0')
+            b2[i] = 'c';
+    }
+    errno = 0;
+    ok (treeobj_decodeb (b2, len2) == NULL && errno == EPROTO,
+        "treeobj_decodeb fails with EPROTO on unsorted dir entries");
+    free (b2);
+
+    b1 = treeobj_encode_binary (large, &len1);
+    s = treeobj_encode (large);
+    ok (b1 != NULL && s != NULL && len1 < strlen (s),
+        "binary encoding of %d-entry dir is smaller than JSON",
+        large_dir_entries);
+    cpy = b1 ? treeobj_decodeb (b1, len1) : NULL;
+    ok (cpy != NULL && json_equal (cpy, large) == 1,
+        "and round trips");
+    json_decref (cpy);
+    free (b1);
+    free (s);
+
+    json_decref (large);
+    json_decref (dir1);
+    json_decref (dir2);
+}
+
 int main(int argc, char** argv)
 {
     plan (NO_PLAN);
@@ -810,12 +1055,14 @@ int main(int argc, char** argv)
     test_dirref ();
     test_dir ();
     test_dir_peek ();
+    test_dirshard ();
     test_copy ();
     test_deep_copy ();
     test_symlink ();
     test_corner_cases ();
 
     test_codec ();
+    test_codec_binary ();
 
     done_testing();
 }
@@ -14,6 +14,8 @@
 #include "config.h"
 #endif
 #include <errno.h>
+#include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
 #include <assert.h>
 #include <sodium.h>
@@ -21,6 +23,7 @@
 #include "treeobj.h"
 #include "src/common/libutil/macros.h"
 #include "src/common/libutil/blobref.h"
+#include "src/common/libutil/errno_safe.h"
 
 static const int treeobj_version = 1;
 
@@ -69,6 +72,22 @@ static int treeobj_peek (const json_t *obj, const char **typep,
     return 0;
 }
 
+/* Shards are keyed by a single lower case hex digit.
+ */
+static const char *shard_keys[TREEOBJ_DIRSHARD_WIDTH] = {
+    "0", "1", "2", "3", "4", "5", "6", "7",
+    "8", "9", "a", "b", "c", "d", "e", "f",
+};
+
+static int shard_key_index (const char *key)
+{
+    if (key[0] >= '0' && key[0] <= '9' && key[1] == '\0')
+        return key[0] - '0';
+    if (key[0] >= 'a' && key[0] <= 'f' && key[1] == '\0')
+        return key[0] - 'a' + 10;
+    return -1;
+}
+
 int treeobj_validate (const json_t *obj)
 {
     const json_t *o;
@@ -120,6 +139,25 @@ int treeobj_validate (const json_t *obj)
         if (!json_is_string (data))
             goto inval;
     }
+    else if (!strcmp (type, "dirshard")) {
+        const json_t *shards;
+        const char *key;
+        int level;
+        if (json_unpack ((json_t *)data, "{s:i s:o !}",
+                                         "level", &level,
+                                         "shards", &shards) < 0
+            || level < 0 || level >= TREEOBJ_DIRSHARD_LEVELS
+            || !json_is_object (shards))
+            goto inval;
+        json_object_foreach ((json_t *)shards, key, o) {
+            if (shard_key_index (key) < 0
+                || (!treeobj_is_dirref (o)
+                    && !treeobj_is_dir (o)
+                    && !treeobj_is_dirshard (o))
+                || treeobj_validate (o) < 0)
+                goto inval;
+        }
+    }
     else
         goto inval;
     return 0;
@@ -166,6 +204,12 @@ bool treeobj_is_dirref (const json_t *obj)
     return type && !strcmp (type, "dirref");
 }
 
+bool treeobj_is_dirshard (const json_t *obj)
+{
+    const char *type = treeobj_get_type (obj);
+    return type && !strcmp (type, "dirshard");
+}
+
 json_t *treeobj_get_data (json_t *obj)
 {
     json_t *data;
@@ -264,6 +308,9 @@ int treeobj_get_count (const json_t *obj)
     else if (!strcmp (type, "dir")) {
         count = json_object_size (data);
     }
+    else if (!strcmp (type, "dirshard")) {
+        count = json_object_size (json_object_get (data, "shards"));
+    }
     else if (!strcmp (type, "symlink") || !strcmp (type, "val")) {
         count = 1;
     } else {
@@ -365,14 +412,14 @@ const json_t *treeobj_peek_entry (const json_t *obj, const char *name)
     return obj2;
 }
 
-json_t *treeobj_copy (json_t *obj)
+json_t *treeobj_copy (const json_t *obj)
 {
-    json_t *data;
+    const json_t *data;
     json_t *cpy;
     json_t *datacpy;
     int save_errno;
 
-    if (treeobj_unpack (obj, NULL, &data) < 0) {
+    if (treeobj_peek (obj, NULL, &data) < 0) {
         errno = EINVAL;
         return NULL;
     }
@@ -383,7 +430,7 @@ json_t *treeobj_copy (json_t *obj)
         if (!(cpy = treeobj_create_dir ()))
             return NULL;
 
-        if (!(datacpy = json_copy (data))) {
+        if (!(datacpy = json_copy ((json_t *)data))) {
             save_errno = errno;
             json_decref (cpy);
             errno = save_errno;
@@ -397,6 +444,28 @@ json_t *treeobj_copy (json_t *obj)
             return NULL;
         }
     }
+    else if (treeobj_is_dirshard (obj)) {
+        const json_t *shards = json_object_get (data, "shards");
+
+        if (!(cpy = treeobj_create_dirshard (json_integer_value (
+                                json_object_get (data, "level")))))
+            return NULL;
+        if (!(datacpy = json_copy ((json_t *)shards))) {
+            save_errno = errno;
+            json_decref (cpy);
+            errno = save_errno;
+            return NULL;
+        }
+        if (json_object_set_new (treeobj_get_data (cpy),
+                                 "shards",
+                                 datacpy) < 0) {
+            save_errno = errno;
+            json_decref (datacpy);
+            json_decref (cpy);
+            errno = save_errno;
+            return NULL;
+        }
+    }
     else {
         if (!(cpy = json_deep_copy (obj)))
             return NULL;
@@ -470,6 +539,133 @@ json_t *treeobj_create_dir (void)
     return obj;
 }
 
+json_t *treeobj_create_dirshard (int level)
+{
+    json_t *obj;
+
+    if (level < 0 || level >= TREEOBJ_DIRSHARD_LEVELS) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(obj = json_pack ("{s:i s:s s:{s:i s:{}}}", "ver", treeobj_version,
+                                                   "type", "dirshard",
+                                                   "data",
+                                                     "level", level,
+                                                     "shards"))) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    return obj;
+}
+
+static json_t *dirshard_shards (const json_t *obj, int *levelp)
+{
+    const char *type;
+    const json_t *data;
+    json_t *shards;
+    int level;
+
+    if (treeobj_peek (obj, &type, &data) < 0
+        || strcmp (type, "dirshard") != 0
+        || json_unpack ((json_t *)data, "{s:i s:o}",
+                                        "level", &level,
+                                        "shards", &shards) < 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (levelp)
+        *levelp = level;
+    return shards;
+}
+
+int treeobj_get_dirshard_level (const json_t *obj)
+{
+    int level;
+
+    if (!dirshard_shards (obj, &level))
+        return -1;
+    return level;
+}
+
+/* 32-bit FNV-1a.  This is part of the dirshard format and must not change.
+ */
+static uint32_t shard_hash (const char *name)
+{
+    uint32_t hash = 2166136261U;
+
+    while (*name) {
+        hash ^= (uint8_t)*name++;
+        hash *= 16777619U;
+    }
+    return hash;
+}
+
+int treeobj_dirshard_index (int level, const char *name)
+{
+    if (!name || level < 0 || level >= TREEOBJ_DIRSHARD_LEVELS) {
+        errno = EINVAL;
+        return -1;
+    }
+    return (shard_hash (name) >> (level * 4)) & (TREEOBJ_DIRSHARD_WIDTH - 1);
+}
+
+json_t *treeobj_get_shard (json_t *obj, int index)
+{
+    json_t *shards;
+    json_t *obj2;
+
+    if (!(shards = dirshard_shards (obj, NULL))
+        || index < 0 || index >= TREEOBJ_DIRSHARD_WIDTH) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(obj2 = json_object_get (shards, shard_keys[index]))) {
+        errno = ENOENT;
+        return NULL;
+    }
+    return obj2;
+}
+
+const json_t *treeobj_peek_shard (const json_t *obj, int index)
+{
+    return treeobj_get_shard ((json_t *)obj, index);
+}
+
+int treeobj_insert_shard (json_t *obj, int index, json_t *shard)
+{
+    json_t *shards;
+
+    if (!(shards = dirshard_shards (obj, NULL))
+        || index < 0 || index >= TREEOBJ_DIRSHARD_WIDTH
+        || (!treeobj_is_dirref (shard)
+            && !treeobj_is_dir (shard)
+            && !treeobj_is_dirshard (shard))) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (json_object_set (shards, shard_keys[index], shard) < 0) {
+        errno = ENOMEM;
+        return -1;
+    }
+    return 0;
+}
+
+int treeobj_delete_shard (json_t *obj, int index)
+{
+    json_t *shards;
+
+    if (!(shards = dirshard_shards (obj, NULL))
+        || index < 0 || index >= TREEOBJ_DIRSHARD_WIDTH) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (json_object_del (shards, shard_keys[index]) < 0) {
+        errno = ENOENT;
+        return -1;
+    }
+    return 0;
+}
+
 json_t *treeobj_create_symlink (const char *ns, const char *target)
 {
     json_t *data, *obj;
@@ -606,9 +802,419 @@ json_t *treeobj_decode (const char *buf)
     return treeobj_decodeb (buf, strlen (buf));
 }
 
+/* Binary treeobj encoding (see treeobj.h).
+ */
+static const char treeobj_binary_magic[] = { '\0', 'T', 'O', 1 };
+#define TREEOBJ_BINARY_MAGIC_SIZE sizeof (treeobj_binary_magic)
+
+enum {
+    TB_VAL = 1,
+    TB_VALREF = 2,
+    TB_DIR = 3,
+    TB_DIRREF = 4,
+    TB_SYMLINK = 5,
+    TB_DIRSHARD = 6,
+};
+
+struct tbuf {
+    char *data;
+    size_t len;
+    size_t size;
+};
+
+static int tbuf_reserve (struct tbuf *b, size_t n)
+{
+    if (b->len + n > b->size) {
+        size_t size = b->size ? b->size : 256;
+        char *data;
+        while (size < b->len + n)
+            size *= 2;
+        if (!(data = realloc (b->data, size))) {
+            errno = ENOMEM;
+            return -1;
+        }
+        b->data = data;
+        b->size = size;
+    }
+    return 0;
+}
+
+static int tbuf_put (struct tbuf *b, const void *data, size_t len)
+{
+    if (tbuf_reserve (b, len) < 0)
+        return -1;
+    memcpy (b->data + b->len, data, len);
+    b->len += len;
+    return 0;
+}
+
+static int tbuf_put_u8 (struct tbuf *b, uint8_t val)
+{
+    return tbuf_put (b, &val, 1);
+}
+
+static int tbuf_put_u32 (struct tbuf *b, uint32_t val)
+{
+    uint8_t v[4] = { val >> 24, val >> 16, val >> 8, val };
+    return tbuf_put (b, v, sizeof (v));
+}
+
+/* Strings are stored as a 32-bit length, the bytes, and a terminating NUL,
+ * so the decoder can use them in place.
+ */
+static int tbuf_put_str (struct tbuf *b, const char *s)
+{
+    size_t len = strlen (s);
+    if (len > UINT32_MAX) {
+        errno = EOVERFLOW;
+        return -1;
+    }
+    if (tbuf_put_u32 (b, len) < 0 || tbuf_put (b, s, len + 1) < 0)
+        return -1;
+    return 0;
+}
+
+/* Store a blobref as its hash name and raw digest, not as a hex string.
+ */
+static int tbuf_put_blobref (struct tbuf *b, const char *blobref)
+{
+    uint8_t hash[BLOBREF_MAX_DIGEST_SIZE];
+    const char *dash;
+    int hash_len;
+
+    if (!blobref
+        || !(dash = strchr (blobref, '-'))
+        || dash - blobref > UINT8_MAX
+        || (hash_len = blobref_strtohash (blobref, hash, sizeof (hash))) < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (tbuf_put_u8 (b, dash - blobref) < 0
+        || tbuf_put (b, blobref, dash - blobref) < 0
+        || tbuf_put_u8 (b, hash_len) < 0
+        || tbuf_put (b, hash, hash_len) < 0)
+        return -1;
+    return 0;
+}
+
+static int key_cmp (const void *a, const void *b)
+{
+    return strcmp (*(const char **)a, *(const char **)b);
+}
+
+static int tbuf_put_treeobj (struct tbuf *b, const json_t *obj)
+{
+    const char *type;
+    const json_t *data;
+
+    if (treeobj_peek (obj, &type, &data) < 0)
+        return -1;
+    if (!strcmp (type, "val")) {
+        if (!json_is_string (data)
+            || tbuf_put_u8 (b, TB_VAL) < 0
+            || tbuf_put_str (b, json_string_value (data)) < 0)
+            goto inval;
+    }
+    else if (!strcmp (type, "valref") || !strcmp (type, "dirref")) {
+        size_t index;
+        const json_t *o;
+        if (!json_is_array (data)
+            || json_array_size (data) == 0
+            || tbuf_put_u8 (b, !strcmp (type, "valref") ? TB_VALREF
+                                                       : TB_DIRREF) < 0
+            || tbuf_put_u32 (b, json_array_size (data)) < 0)
+            goto inval;
+        json_array_foreach (data, index, o) {
+            if (tbuf_put_blobref (b, json_string_value (o)) < 0)
+                goto inval;
+        }
+    }
+    else if (!strcmp (type, "dir")) {
+        const char **keys;
+        const char *key;
+        const json_t *o;
+        size_t count;
+        size_t i = 0;
+
+        if (!json_is_object (data))
+            goto inval;
+        count = json_object_size (data);
+        if (!(keys = malloc (sizeof (keys[0]) * (count ? count : 1)))) {
+            errno = ENOMEM;
+            return -1;
+        }
+        json_object_foreach ((json_t *)data, key, o)
+            keys[i++] = key;
+        qsort (keys, count, sizeof (keys[0]), key_cmp);
+        if (tbuf_put_u8 (b, TB_DIR) < 0 || tbuf_put_u32 (b, count) < 0)
+            goto dir_error;
+        for (i = 0; i < count; i++) {
+            if (tbuf_put_str (b, keys[i]) < 0
+                || tbuf_put_treeobj (b, json_object_get (data, keys[i])) < 0)
+                goto dir_error;
+        }
+        free (keys);
+        return 0;
+dir_error:
+        ERRNO_SAFE_WRAP (free, keys);
+        return -1;
+    }
+    else if (!strcmp (type, "dirshard")) {
+        const json_t *shard;
+        int level;
+        int i;
+
+        if ((level = treeobj_get_dirshard_level (obj)) < 0
+            || tbuf_put_u8 (b, TB_DIRSHARD) < 0
+            || tbuf_put_u8 (b, level) < 0
+            || tbuf_put_u32 (b, treeobj_get_count (obj)) < 0)
+            goto inval;
+        for (i = 0; i < TREEOBJ_DIRSHARD_WIDTH; i++) {
+            if (!(shard = treeobj_peek_shard (obj, i)))
+                continue;
+            if (tbuf_put_u8 (b, i) < 0 || tbuf_put_treeobj (b, shard) < 0)
+                goto inval;
+        }
+    }
+    else if (!strcmp (type, "symlink")) {
+        const char *ns = NULL;
+        const char *target;
+        if (treeobj_get_symlink (obj, &ns, &target) < 0
+            || tbuf_put_u8 (b, TB_SYMLINK) < 0
+            || tbuf_put_u8 (b, ns ? 1 : 0) < 0
+            || (ns && tbuf_put_str (b, ns) < 0)
+            || tbuf_put_str (b, target) < 0)
+            goto inval;
+    }
+    else
+        goto inval;
+    return 0;
+inval:
+    if (errno != ENOMEM && errno != EOVERFLOW)
+        errno = EINVAL;
+    return -1;
+}
+
+char *treeobj_encode_binary (const json_t *obj, size_t *lenp)
+{
+    struct tbuf b = { 0 };
+
+    if (!lenp) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (tbuf_put (&b, treeobj_binary_magic, TREEOBJ_BINARY_MAGIC_SIZE) < 0
+        || tbuf_put_treeobj (&b, obj) < 0) {
+        ERRNO_SAFE_WRAP (free, b.data);
+        return NULL;
+    }
+    *lenp = b.len;
+    return b.data;
+}
+
+struct tcursor {
+    const char *p;
+    size_t left;
+};
+
+static int tcursor_get (struct tcursor *c, const void **data, size_t len)
+{
+    if (c->left < len)
+        return -1;
+    *data = c->p;
+    c->p += len;
+    c->left -= len;
+    return 0;
+}
+
+static int tcursor_get_u8 (struct tcursor *c, uint8_t *val)
+{
+    const void *p;
+    if (tcursor_get (c, &p, 1) < 0)
+        return -1;
+    *val = *(const uint8_t *)p;
+    return 0;
+}
+
+static int tcursor_get_u32 (struct tcursor *c, uint32_t *val)
+{
+    const uint8_t *v;
+    if (tcursor_get (c, (const void **)&v, 4) < 0)
+        return -1;
+    *val = ((uint32_t)v[0] << 24) | ((uint32_t)v[1] << 16)
+         | ((uint32_t)v[2] << 8) | v[3];
+    return 0;
+}
+
+static int tcursor_get_str (struct tcursor *c, const char **s)
+{
+    uint32_t len;
+    const char *p;
+
+    if (tcursor_get_u32 (c, &len) < 0
+        || len == UINT32_MAX
+        || tcursor_get (c, (const void **)&p, (size_t)len + 1) < 0
+        || p[len] != '\0'
+        || memchr (p, '\0', len) != NULL)
+        return -1;
+    *s = p;
+    return 0;
+}
+
+static json_t *tcursor_get_refs (struct tcursor *c, const char *type)
+{
+    json_t *array;
+    json_t *obj;
+    uint32_t count;
+
+    if (tcursor_get_u32 (c, &count) < 0 || count == 0)
+        return NULL;
+    if (!(array = json_array ()))
+        return NULL;
+    while (count-- > 0) {
+        char name[UINT8_MAX + 1];
+        char blobref[BLOBREF_MAX_STRING_SIZE];
+        const void *p;
+        uint8_t len;
+        json_t *o;
+
+        if (tcursor_get_u8 (c, &len) < 0 || tcursor_get (c, &p, len) < 0)
+            goto error;
+        memcpy (name, p, len);
+        name[len] = '\0';
+        if (tcursor_get_u8 (c, &len) < 0
+            || tcursor_get (c, &p, len) < 0
+            || blobref_hashtostr (name, p, len, blobref, sizeof (blobref)) < 0
+            || !(o = json_string (blobref))
+            || json_array_append_new (array, o) < 0)
+            goto error;
+    }
+    if (!(obj = json_pack ("{s:i s:s s:o}", "ver", treeobj_version,
+                                            "type", type,
+                                            "data", array)))
+        goto error;
+    return obj;
+error:
+    json_decref (array);
+    return NULL;
+}
+
+static json_t *tcursor_get_treeobj (struct tcursor *c, int depth)
+{
+    uint8_t type;
+    const char *s;
+    json_t *obj = NULL;
+
+    if (depth > 64 || tcursor_get_u8 (c, &type) < 0)
+        return NULL;
+    switch (type) {
+        case TB_VAL:
+            if (tcursor_get_str (c, &s) < 0)
+                return NULL;
+            obj = json_pack ("{s:i s:s s:s}", "ver", treeobj_version,
+                                              "type", "val",
+                                              "data", s);
+            break;
+        case TB_VALREF:
+            obj = tcursor_get_refs (c, "valref");
+            break;
+        case TB_DIRREF:
+            obj = tcursor_get_refs (c, "dirref");
+            break;
+        case TB_DIR: {
+            json_t *data;
+            const char *prev = NULL;
+            uint32_t count;
+
+            if (tcursor_get_u32 (c, &count) < 0
+                || !(obj = treeobj_create_dir ()))
+                return NULL;
+            data = treeobj_get_data (obj);
+            while (count-- > 0) {
+                json_t *o;
+                /* Entries are sorted, which also rules out duplicates.
+                 */
+                if (tcursor_get_str (c, &s) < 0
+                    || (prev && strcmp (prev, s) >= 0)
+                    || !(o = tcursor_get_treeobj (c, depth + 1)))
+                    goto error;
+                if (json_object_set_new (data, s, o) < 0)
+                    goto error;
+                prev = s;
+            }
+            break;
+        }
+        case TB_DIRSHARD: {
+            uint8_t level;
+            uint8_t index;
+            int prev = -1;
+            uint32_t count;
+
+            if (tcursor_get_u8 (c, &level) < 0
+                || tcursor_get_u32 (c, &count) < 0
+                || count > TREEOBJ_DIRSHARD_WIDTH
+                || !(obj = treeobj_create_dirshard (level)))
+                return NULL;
+            while (count-- > 0) {
+                json_t *o;
+                if (tcursor_get_u8 (c, &index) < 0
+                    || index <= prev
+                    || !(o = tcursor_get_treeobj (c, depth + 1)))
+                    goto error;
+                if (treeobj_insert_shard (obj, index, o) < 0) {
+                    json_decref (o);
+                    goto error;
+                }
+                json_decref (o);
+                prev = index;
+            }
+            break;
+        }
+        case TB_SYMLINK: {
+            const char *ns = NULL;
+            uint8_t has_ns;
+            if (tcursor_get_u8 (c, &has_ns) < 0
+                || has_ns > 1
+                || (has_ns && tcursor_get_str (c, &ns) < 0)
+                || tcursor_get_str (c, &s) < 0)
+                return NULL;
+            obj = treeobj_create_symlink (ns, s);
+            break;
+        }
+    }
+    return obj;
+error:
+    json_decref (obj);
+    return NULL;
+}
+
+static bool treeobj_is_binary (const char *buf, size_t buflen)
+{
+    return (buflen >= TREEOBJ_BINARY_MAGIC_SIZE
+            && !memcmp (buf, treeobj_binary_magic, TREEOBJ_BINARY_MAGIC_SIZE));
+}
+
+static json_t *treeobj_decode_binary (const char *buf, size_t buflen)
+{
+    struct tcursor c = {
+        .p = buf + TREEOBJ_BINARY_MAGIC_SIZE,
+        .left = buflen - TREEOBJ_BINARY_MAGIC_SIZE,
+    };
+    json_t *obj;
+
+    if (!(obj = tcursor_get_treeobj (&c, 0)) || c.left != 0) {
+        json_decref (obj);
+        errno = EPROTO;
+        return NULL;
+    }
+    return obj;
+}
+
 json_t *treeobj_decodeb (const char *buf, size_t buflen)
 {
     json_t *obj = NULL;
+    if (buf && treeobj_is_binary (buf, buflen))
+        return treeobj_decode_binary (buf, buflen);
     if (!(obj = json_loadb (buf, buflen, 0, NULL))
             || treeobj_validate (obj) < 0) {
         errno = EPROTO;
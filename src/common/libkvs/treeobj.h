@@ -28,6 +28,7 @@ json_t *treeobj_create_val (const void *data, int len);
 json_t *treeobj_create_valref (const char *blobref);
 json_t *treeobj_create_dir (void);
 json_t *treeobj_create_dirref (const char *blobref);
+json_t *treeobj_create_dirshard (int level);
 
 /* Validate treeobj, recursively.
  * Return 0 if valid, -1 with errno = EINVAL if invalid.
@@ -45,6 +46,7 @@ bool treeobj_is_val (const json_t *obj);
 bool treeobj_is_valref (const json_t *obj);
 bool treeobj_is_dir (const json_t *obj);
 bool treeobj_is_dirref (const json_t *obj);
+bool treeobj_is_dirshard (const json_t *obj);
 
 /* get type-specific value.
  * For dirref/valref, this is an array of blobrefs.
@@ -72,6 +74,7 @@ int treeobj_decode_val (const json_t *obj, void **data, int *len);
 /* get type-specific count.
  * For dirref/valref, this is the number of blobrefs.
  * For directory, this is number of entries
+ * For dirshard, this is the number of shards.
  * For symlink or val, this is 1.
  * Return count on success, -1 on error with errno = EINVAL.
  */
@@ -101,12 +104,34 @@ int treeobj_insert_entry_novalidate (json_t *obj,
  */
 const json_t *treeobj_peek_entry (const json_t *obj, const char *name);
 
+/* A dirshard splits one large directory across up to 16 shards, so
+ * that changing one entry rewrites only the shards on the path to it
+ * rather than the whole directory.  Its data is an object with "level"
+ * and "shards", where "shards" maps a single hex digit to a dirref,
+ * dir, or dirshard.  The entry 'name' belongs to the shard at index
+ * treeobj_dirshard_index (level, name), a 4-bit slice of a 32-bit hash
+ * of 'name' selected by 'level'.  A dir shard holds entries directly;
+ * a dirshard shard splits its entries again at level + 1.  A dirref to
+ * a dirshard otherwise behaves like a dirref to the equivalent dir.
+ * get/peek fail with ENOENT if the shard is not present.
+ */
+#define TREEOBJ_DIRSHARD_WIDTH  16
+#define TREEOBJ_DIRSHARD_LEVELS 8
+
+int treeobj_get_dirshard_level (const json_t *obj);
+int treeobj_dirshard_index (int level, const char *name);
+json_t *treeobj_get_shard (json_t *obj, int index);
+const json_t *treeobj_peek_shard (const json_t *obj, int index);
+int treeobj_insert_shard (json_t *obj, int index, json_t *shard);
+int treeobj_delete_shard (json_t *obj, int index);
+
 /* Shallow copy a treeobj
  * Note that this is not a shallow copy on the json object, but is a
  * shallow copy on the data within a tree object.  For example, for a
  * dir object, the first level of directory entries will be copied.
+ * The copied entries are shared with 'obj', not duplicated.
  */
-json_t *treeobj_copy (json_t *obj);
+json_t *treeobj_copy (const json_t *obj);
 
 /* Deep copy a treeobj */
 json_t *treeobj_deep_copy (const json_t *obj);
@@ -131,11 +156,32 @@ json_t *treeobj_create_valref_buf (const char *hashtype, int maxblob,
 /* Convert a treeobj to/from string.
  * The return value of treeobj_decode must be destroyed with json_decref().
  * The return value of treeobj_encode must be destroyed with free().
+ * treeobj_decodeb() accepts either the JSON or the binary encoding below.
  */
 json_t *treeobj_decode (const char *buf);
 json_t *treeobj_decodeb (const char *buf, size_t buflen);
 char *treeobj_encode (const json_t *obj);
 
+/* Convert a treeobj to a compact binary encoding for the content store,
+ * which is faster to produce and parse than JSON for large directories.
+ * The buffer begins with the 4 bytes "\0TO\1", which cannot begin JSON.
+ * Objects are a type byte followed by:
+ *   val:            string (the base64 data)
+ *   valref, dirref: u32 count, then count blobrefs, each a u8 length
+ *                   and hash name, then a u8 length and raw digest
+ *   dir:            u32 count, then count (string name, object) pairs,
+ *                   sorted by name with strcmp()
+ *   symlink:        u8 1 if namespace follows, [string namespace],
+ *                   string target
+ *   dirshard:       u8 level, u32 count, then count (u8 index, object)
+ *                   pairs sorted by index
+ * Integers are big endian.  A string is a u32 length, that many bytes,
+ * and a NUL.  The encoding of a given treeobj is unique, so it hashes
+ * consistently.  Returns a buffer of *lenp bytes that must be freed with
+ * free(), or NULL on error with errno set.
+ */
+char *treeobj_encode_binary (const json_t *obj, size_t *lenp);
+
 #endif /* !_FLUX_KVS_TREEOBJ_H */
 
 /*
@@ -29,6 +29,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <sys/uio.h>
 #include "cbuf.h"
 
 
@@ -999,6 +1000,120 @@ cbuf_write_from_fd (cbuf_t dst, int srcfd, int len, int *ndropped)
 }
 
 
+int
+cbuf_peek_iov (cbuf_t src, struct iovec *iov, int len)
+{
+    int i_src, n;
+    int iovcnt = 0;
+
+    assert (src != NULL);
+
+    if ((iov == NULL) || (len < -1)) {
+        errno = EINVAL;
+        return (-1);
+    }
+    cbuf_mutex_lock (src);
+    assert (cbuf_is_valid (src));
+    if (len == -1) {
+        len = src->used;
+    }
+    else {
+        len = MIN (len, src->used);
+    }
+    i_src = src->i_out;
+    while (len > 0) {
+        n = MIN (len, (src->size + 1) - i_src);
+        iov[iovcnt].iov_base = &src->data[i_src];
+        iov[iovcnt].iov_len = n;
+        iovcnt++;
+        i_src = (i_src + n) % (src->size + 1);
+        len -= n;
+    }
+    assert (iovcnt <= 2);
+    cbuf_mutex_unlock (src);
+    return (iovcnt);
+}
+
+
+int
+cbuf_reserve (cbuf_t dst, struct iovec *iov, int len)
+{
+    int nfree, i_dst, n;
+    int iovcnt = 0;
+
+    assert (dst != NULL);
+
+    if ((iov == NULL) || (len < -1) || (len == 0)) {
+        errno = EINVAL;
+        return (-1);
+    }
+    cbuf_mutex_lock (dst);
+    assert (cbuf_is_valid (dst));
+    nfree = dst->size - dst->used;
+    if (len == -1) {
+        len = (nfree > 0) ? nfree : CBUF_CHUNK;
+    }
+    if ((len > nfree) && (dst->size < dst->maxsize)) {
+        nfree += cbuf_grow (dst, len - nfree);
+    }
+    len = MIN (len, nfree);
+    if (len == 0) {
+        cbuf_mutex_unlock (dst);
+        errno = ENOSPC;
+        return (-1);
+    }
+    i_dst = dst->i_in;
+    while (len > 0) {
+        n = MIN (len, (dst->size + 1) - i_dst);
+        iov[iovcnt].iov_base = &dst->data[i_dst];
+        iov[iovcnt].iov_len = n;
+        iovcnt++;
+        i_dst = (i_dst + n) % (dst->size + 1);
+        len -= n;
+    }
+    assert (iovcnt <= 2);
+    assert (cbuf_is_valid (dst));
+    cbuf_mutex_unlock (dst);
+    return (iovcnt);
+}
+
+
+int
+cbuf_commit (cbuf_t dst, int len)
+{
+    int nfree, nrepl;
+
+    assert (dst != NULL);
+
+    if (len < 0) {
+        errno = EINVAL;
+        return (-1);
+    }
+    cbuf_mutex_lock (dst);
+    assert (cbuf_is_valid (dst));
+    nfree = dst->size - dst->used;
+    if (len > nfree) {
+        cbuf_mutex_unlock (dst);
+        errno = EINVAL;
+        return (-1);
+    }
+    /*  As in cbuf_writer(), except unread data is never overwritten.
+     */
+    if (len > 0) {
+        nrepl = (dst->i_out - dst->i_rep + (dst->size + 1)) % (dst->size + 1);
+        dst->used += len;
+        dst->i_in = (dst->i_in + len) % (dst->size + 1);
+        if (len > nfree - nrepl) {
+            dst->got_wrap = 1;
+            dst->i_rep = (dst->i_in + 1) % (dst->size + 1);
+        }
+    }
+    assert (cbuf_is_valid (dst));
+    cbuf_mutex_unlock (dst);
+    return (len);
+}
+
+
 int
 cbuf_copy (cbuf_t src, cbuf_t dst, int len, int *ndropped)
 {
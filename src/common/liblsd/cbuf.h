@@ -19,6 +19,8 @@
 #ifndef LSD_CBUF_H
 #define LSD_CBUF_H
 
+struct iovec;
+
 
 /*****************************************************************************
  *  Notes
@@ -290,6 +292,38 @@ int cbuf_write_from_fd (cbuf_t dst, int srcfd, int len, int *ndropped);
  *    Sets [ndropped] (if not NULL) to the number of bytes overwritten.
  */
 
+int cbuf_peek_iov (cbuf_t src, struct iovec *iov, int len);
+/*
+ *  Fills [iov], which must have room for two entries, with pointers to
+ *    up to [len] bytes of unread data in the [src] cbuf, without copying
+ *    or consuming it.  If [len] is -1, it will be set to the number of
+ *    [src] bytes available for reading.  The data spans two entries if it
+ *    wraps around the end of the buffer.  The pointers are valid until
+ *    the cbuf is next modified.  The data can be consumed via cbuf_drop().
+ *  Returns the number of [iov] entries filled (0 if the cbuf is empty),
+ *    or -1 on error (with errno set).
+ */
+
+int cbuf_reserve (cbuf_t dst, struct iovec *iov, int len);
+/*
+ *  Fills [iov], which must have room for two entries, with pointers to
+ *    free space in the [dst] cbuf for up to [len] bytes, growing the cbuf
+ *    if needed.  If [len] is -1, it will be set to an appropriate chunk
+ *    size.  Unread data is never overwritten, regardless of dst's
+ *    CBUF_OPT_OVERWRITE behavior, so less than [len] bytes may be reserved.
+ *    Data stored in the reserved space is added to the cbuf by
+ *    cbuf_commit().  The cbuf must not be otherwise modified in between.
+ *  Returns the number of [iov] entries filled, or -1 on error (with errno
+ *    set to ENOSPC if the cbuf is full).
+ */
+
+int cbuf_commit (cbuf_t dst, int len);
+/*
+ *  Adds [len] bytes of data stored in space returned by cbuf_reserve()
+ *    to the [dst] cbuf.
+ *  Returns the number of bytes added, or -1 on error (with errno set).
+ */
+
 int cbuf_copy (cbuf_t src, cbuf_t dst, int len, int *ndropped);
 /*
  *  Copies up to [len] bytes of data from the [src] cbuf into the [dst] cbuf
@@ -0,0 +1,282 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* kvsseg.c - job-local PMI KVS segment
+ *
+ * Layout (native byte order, the segment never leaves the node):
+ *
+ *   struct kvsseg_header
+ *   uint32_t index[count]      offsets of records, sorted by key
+ *   records                    "key\0value\0" ...
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#include "kvsseg.h"
+
+#define KVSSEG_MAGIC "FLUXKVS1"
+
+struct kvsseg_header {
+    char magic[8];
+    uint32_t generation;
+    uint32_t count;
+    uint32_t size;
+};
+
+struct pmi_kvsseg {
+    void *base;
+    size_t size;
+    const struct kvsseg_header *hdr;
+    const uint32_t *index;
+};
+
+struct kv {
+    const char *key;
+    const char *val;
+};
+
+static int kv_cmp (const void *a, const void *b)
+{
+    const struct kv *kv1 = a;
+    const struct kv *kv2 = b;
+    return strcmp (kv1->key, kv2->key);
+}
+
+static int write_all (int fd, const void *buf, size_t len)
+{
+    size_t count = 0;
+    ssize_t n;
+
+    while (count < len) {
+        if ((n = write (fd, (const char *)buf + count, len - count)) < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        count += n;
+    }
+    return 0;
+}
+
+int pmi_kvsseg_write (const char *path,
+                      unsigned int generation,
+                      int count,
+                      const char *keys[],
+                      const char *vals[])
+{
+    struct kvsseg_header hdr;
+    struct kv *kvs = NULL;
+    uint32_t *index = NULL;
+    char *tmp = NULL;
+    size_t size;
+    int fd = -1;
+    int saved_errno;
+    int i;
+
+    if (!path || count < 0 || (count > 0 && (!keys || !vals))) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!(kvs = calloc (count + 1, sizeof (*kvs)))
+        || !(index = calloc (count + 1, sizeof (*index))))
+        goto error;
+    size = sizeof (hdr) + count * sizeof (*index);
+    for (i = 0; i < count; i++) {
+        kvs[i].key = keys[i];
+        kvs[i].val = vals[i];
+    }
+    qsort (kvs, count, sizeof (*kvs), kv_cmp);
+    for (i = 0; i < count; i++) {
+        index[i] = size;
+        size += strlen (kvs[i].key) + strlen (kvs[i].val) + 2;
+        if (size > UINT32_MAX) {
+            errno = EOVERFLOW;
+            goto error;
+        }
+    }
+    memset (&hdr, 0, sizeof (hdr));
+    memcpy (hdr.magic, KVSSEG_MAGIC, sizeof (hdr.magic));
+    hdr.generation = generation;
+    hdr.count = count;
+    hdr.size = size;
+
+    if (asprintf (&tmp, "%s.XXXXXX", path) < 0) {
+        tmp = NULL;
+        goto error;
+    }
+    if ((fd = mkstemp (tmp)) < 0)
+        goto error;
+    if (write_all (fd, &hdr, sizeof (hdr)) < 0
+        || write_all (fd, index, count * sizeof (*index)) < 0)
+        goto error;
+    for (i = 0; i < count; i++) {
+        if (write_all (fd, kvs[i].key, strlen (kvs[i].key) + 1) < 0
+            || write_all (fd, kvs[i].val, strlen (kvs[i].val) + 1) < 0)
+            goto error;
+    }
+    if (close (fd) < 0) {
+        fd = -1;
+        goto error;
+    }
+    fd = -1;
+    if (rename (tmp, path) < 0)
+        goto error;
+    free (tmp);
+    free (index);
+    free (kvs);
+    return 0;
+error:
+    saved_errno = errno;
+    if (fd >= 0)
+        close (fd);
+    if (tmp)
+        (void)unlink (tmp);
+    free (tmp);
+    free (index);
+    free (kvs);
+    errno = saved_errno;
+    return -1;
+}
+
+static const char *record_key (struct pmi_kvsseg *seg, uint32_t i)
+{
+    return (const char *)seg->base + seg->index[i];
+}
+
+static const char *record_val (const char *key)
+{
+    return key + strlen (key) + 1;
+}
+
+/* Check that every record holds two NUL-terminated strings within the
+ * segment, and that the index is sorted, so lookups can't run off the end.
+ */
+static int kvsseg_validate (struct pmi_kvsseg *seg)
+{
+    size_t recs = sizeof (*seg->hdr) + seg->hdr->count * sizeof (uint32_t);
+    uint32_t i;
+
+    if (memcmp (seg->hdr->magic, KVSSEG_MAGIC, sizeof (seg->hdr->magic)) != 0
+        || seg->hdr->size != seg->size
+        || recs > seg->size)
+        return -1;
+    for (i = 0; i < seg->hdr->count; i++) {
+        uint32_t off = seg->index[i];
+        const char *p;
+        const char *end = (const char *)seg->base + seg->size;
+        int nuls = 0;
+
+        if (off < recs || off >= seg->size)
+            return -1;
+        for (p = (const char *)seg->base + off; p < end && nuls < 2; p++) {
+            if (*p == '\0')
+                nuls++;
+        }
+        if (nuls < 2)
+            return -1;
+        if (i > 0 && strcmp (record_key (seg, i - 1), record_key (seg, i)) >= 0)
+            return -1;
+    }
+    return 0;
+}
+
+void pmi_kvsseg_close (struct pmi_kvsseg *seg)
+{
+    if (seg) {
+        int saved_errno = errno;
+        if (seg->base)
+            (void)munmap (seg->base, seg->size);
+        free (seg);
+        errno = saved_errno;
+    }
+}
+
+struct pmi_kvsseg *pmi_kvsseg_open (const char *path)
+{
+    struct pmi_kvsseg *seg;
+    struct stat sb;
+    int fd;
+
+    if (!path) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if ((fd = open (path, O_RDONLY)) < 0)
+        return NULL;
+    if (!(seg = calloc (1, sizeof (*seg))))
+        goto error;
+    if (fstat (fd, &sb) < 0)
+        goto error;
+    if (sb.st_size < sizeof (struct kvsseg_header)) {
+        errno = EPROTO;
+        goto error;
+    }
+    seg->size = sb.st_size;
+    seg->base = mmap (NULL, seg->size, PROT_READ, MAP_SHARED, fd, 0);
+    if (seg->base == MAP_FAILED) {
+        seg->base = NULL;
+        goto error;
+    }
+    seg->hdr = seg->base;
+    seg->index = (const uint32_t *)(seg->hdr + 1);
+    if (kvsseg_validate (seg) < 0) {
+        errno = EPROTO;
+        goto error;
+    }
+    close (fd);
+    return seg;
+error:
+    pmi_kvsseg_close (seg);
+    close (fd);
+    return NULL;
+}
+
+unsigned int pmi_kvsseg_generation (struct pmi_kvsseg *seg)
+{
+    return seg ? seg->hdr->generation : 0;
+}
+
+const char *pmi_kvsseg_lookup (struct pmi_kvsseg *seg, const char *key)
+{
+    uint32_t lo = 0;
+    uint32_t hi;
+
+    if (!seg || !key)
+        return NULL;
+    hi = seg->hdr->count;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        const char *k = record_key (seg, mid);
+        int rc = strcmp (key, k);
+        if (rc == 0)
+            return record_val (k);
+        if (rc < 0)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+    return NULL;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,52 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _FLUX_PMI_KVSSEG_H
+#define _FLUX_PMI_KVSSEG_H
+
+/* Job-local PMI KVS segment.
+ *
+ * After a barrier, the PMI server may write all key-value pairs it holds
+ * to a file that local clients map read-only and search directly, instead
+ * of sending a get request per key.  The file is replaced atomically by
+ * each write, and carries a generation number (the count of completed
+ * barriers) so that a client can tell whether it is current.
+ */
+
+struct pmi_kvsseg;
+
+/* Write 'count' key-value pairs to 'path', tagged with 'generation'.
+ * The file is written under a temporary name and renamed into place.
+ * Returns 0 on success, -1 on failure with errno set.
+ */
+int pmi_kvsseg_write (const char *path,
+                      unsigned int generation,
+                      int count,
+                      const char *keys[],
+                      const char *vals[]);
+
+/* Map the segment at 'path' and validate it.
+ * Returns NULL on failure with errno set.
+ */
+struct pmi_kvsseg *pmi_kvsseg_open (const char *path);
+void pmi_kvsseg_close (struct pmi_kvsseg *seg);
+
+unsigned int pmi_kvsseg_generation (struct pmi_kvsseg *seg);
+
+/* Return the value of 'key', or NULL if not found.
+ * The value remains valid until the segment is closed.
+ */
+const char *pmi_kvsseg_lookup (struct pmi_kvsseg *seg, const char *key);
+
+#endif /* !_FLUX_PMI_KVSSEG_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
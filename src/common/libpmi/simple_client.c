@@ -19,6 +19,7 @@
 #include <string.h>
 #include <sys/param.h>
 #include <assert.h>
+#include <stdbool.h>
 
 #include "src/common/libutil/aux.h"
 
@@ -27,6 +28,7 @@
 #include "clique.h"
 #include "dgetline.h"
 #include "keyval.h"
+#include "kvsseg.h"
 #include "pmi.h"
 
 int pmi_simple_client_init (struct pmi_simple_client *pmi)
@@ -172,6 +174,7 @@ int pmi_simple_client_barrier (struct pmi_simple_client *pmi)
         result = rc;
         goto done;
     }
+    pmi->barriers++;
     result = PMI_SUCCESS;
 done:
     return result;
@@ -233,6 +236,35 @@ done:
     return result;
 }
 
+/* Look up 'key' in the KVS segment, (re)mapping it if it is older than
+ * the last barrier.  Return true if the value was copied to 'value'.
+ * Any failure just means the caller must ask the server.
+ */
+static bool kvsseg_get (struct pmi_simple_client *pmi,
+                        const char *key,
+                        char *value,
+                        int len)
+{
+    const char *val;
+
+    if (!pmi->kvsseg_path || pmi->barriers == 0)
+        return false;
+    if (pmi->seg && pmi_kvsseg_generation (pmi->seg) != pmi->barriers) {
+        pmi_kvsseg_close (pmi->seg);
+        pmi->seg = NULL;
+    }
+    if (!pmi->seg) {
+        if (!(pmi->seg = pmi_kvsseg_open (pmi->kvsseg_path)))
+            return false;
+        if (pmi_kvsseg_generation (pmi->seg) != pmi->barriers)
+            return false;
+    }
+    if (!(val = pmi_kvsseg_lookup (pmi->seg, key)) || strlen (val) >= len)
+        return false;
+    strcpy (value, val);
+    return true;
+}
+
 int pmi_simple_client_kvs_get (struct pmi_simple_client *pmi,
                                const char *kvsname,
                                const char *key,
@@ -246,6 +278,8 @@ int pmi_simple_client_kvs_get (struct pmi_simple_client *pmi,
         return PMI_ERR_INIT;
     if (!kvsname || !key || !value || len <= 0)
         return PMI_ERR_INVALID_ARG;
+    if (kvsseg_get (pmi, key, value, len))
+        return PMI_SUCCESS;
     if (dprintf (pmi->fd, "cmd=get kvsname=%s key=%s\n", kvsname, key) < 0)
         goto done;
     if (dgetline (pmi->fd, pmi->buf, pmi->buflen) < 0)
@@ -407,6 +441,8 @@ void pmi_simple_client_destroy (struct pmi_simple_client *pmi)
         aux_destroy (&pmi->aux);
         if (pmi->fd != -1)
             (void)close (pmi->fd);
+        pmi_kvsseg_close (pmi->seg);
+        free (pmi->kvsseg_path);
         free (pmi->buf);
         free (pmi);
         errno = saved_errno;
@@ -444,6 +480,24 @@ error:
     return NULL;
 }
 
+int pmi_simple_client_set_kvsseg (struct pmi_simple_client *pmi,
+                                  const char *path)
+{
+    char *cpy = NULL;
+
+    if (!pmi) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (path && !(cpy = strdup (path)))
+        return -1;
+    pmi_kvsseg_close (pmi->seg);
+    pmi->seg = NULL;
+    free (pmi->kvsseg_path);
+    pmi->kvsseg_path = cpy;
+    return 0;
+}
+
 /*
  * vi:tabstop=4 shiftwidth=4 expandtab
  */
@@ -31,6 +31,9 @@ struct pmi_simple_client {
     int buflen;
     int fd;
     struct aux_item *aux;
+    char *kvsseg_path;
+    struct pmi_kvsseg *seg;
+    unsigned int barriers;
 };
 
 /* Create/destroy
@@ -44,6 +47,13 @@ struct pmi_simple_client *pmi_simple_client_create_fd (const char *pmi_fd,
                                                        const char *pmi_size,
                                                        const char *pmi_spawned);
 
+/* Look up keys in the server's KVS segment at 'path' (see kvsseg.h)
+ * before asking the server.  The segment is only used if it was written
+ * after the client's most recent barrier.  'path' may be NULL.
+ */
+int pmi_simple_client_set_kvsseg (struct pmi_simple_client *pmi,
+                                  const char *path);
+
 /* Core operations
  */
 int pmi_simple_client_init (struct pmi_simple_client *pmi);
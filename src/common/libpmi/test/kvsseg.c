@@ -0,0 +1,141 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/common/libpmi/kvsseg.h"
+
+static char path[1024];
+
+void test_basic (void)
+{
+    const char *keys[] = { "zeta", "alpha", "PMI_process_mapping", "mid" };
+    const char *vals[] = { "z", "a", "(vector,(0,1,4))", "" };
+    struct pmi_kvsseg *seg;
+    const char *val;
+    int i;
+
+    ok (pmi_kvsseg_write (path, 1, 4, keys, vals) == 0,
+        "pmi_kvsseg_write works");
+    ok ((seg = pmi_kvsseg_open (path)) != NULL,
+        "pmi_kvsseg_open works");
+    ok (pmi_kvsseg_generation (seg) == 1,
+        "pmi_kvsseg_generation returns generation");
+    for (i = 0; i < 4; i++) {
+        val = pmi_kvsseg_lookup (seg, keys[i]);
+        ok (val != NULL && !strcmp (val, vals[i]),
+            "pmi_kvsseg_lookup %s works", keys[i]);
+    }
+    ok (pmi_kvsseg_lookup (seg, "nokey") == NULL
+        && pmi_kvsseg_lookup (seg, "al") == NULL
+        && pmi_kvsseg_lookup (seg, "zzz") == NULL,
+        "pmi_kvsseg_lookup of missing key returns NULL");
+
+    ok (pmi_kvsseg_write (path, 2, 1, keys, vals) == 0,
+        "pmi_kvsseg_write can replace segment");
+    val = pmi_kvsseg_lookup (seg, "alpha");
+    ok (val != NULL && !strcmp (val, "a"),
+        "previously opened segment is unchanged by replacement");
+    pmi_kvsseg_close (seg);
+
+    ok ((seg = pmi_kvsseg_open (path)) != NULL
+        && pmi_kvsseg_generation (seg) == 2,
+        "reopened segment has the new generation");
+    ok (pmi_kvsseg_lookup (seg, "alpha") == NULL
+        && pmi_kvsseg_lookup (seg, "zeta") != NULL,
+        "reopened segment has the new content");
+    pmi_kvsseg_close (seg);
+
+    ok (pmi_kvsseg_write (path, 3, 0, NULL, NULL) == 0,
+        "pmi_kvsseg_write works with no keys");
+    ok ((seg = pmi_kvsseg_open (path)) != NULL
+        && pmi_kvsseg_lookup (seg, "zeta") == NULL,
+        "empty segment has no keys");
+    pmi_kvsseg_close (seg);
+}
+
+void test_corrupt (void)
+{
+    int fd;
+
+    if ((fd = open (path, O_WRONLY | O_TRUNC)) < 0)
+        BAIL_OUT ("could not truncate %s", path);
+    if (write (fd, "FLUXKVS1", 8) != 8)
+        BAIL_OUT ("write failed");
+    close (fd);
+    errno = 0;
+    ok (pmi_kvsseg_open (path) == NULL && errno == EPROTO,
+        "pmi_kvsseg_open of short segment fails with EPROTO");
+
+    if ((fd = open (path, O_WRONLY | O_TRUNC)) < 0)
+        BAIL_OUT ("could not truncate %s", path);
+    if (write (fd, "notakvssegment-notakvssegment", 29) != 29)
+        BAIL_OUT ("write failed");
+    close (fd);
+    errno = 0;
+    ok (pmi_kvsseg_open (path) == NULL && errno == EPROTO,
+        "pmi_kvsseg_open of bad magic fails with EPROTO");
+}
+
+void test_badargs (void)
+{
+    errno = 0;
+    ok (pmi_kvsseg_write (NULL, 0, 0, NULL, NULL) < 0 && errno == EINVAL,
+        "pmi_kvsseg_write path=NULL fails with EINVAL");
+    errno = 0;
+    ok (pmi_kvsseg_write (path, 0, 1, NULL, NULL) < 0 && errno == EINVAL,
+        "pmi_kvsseg_write keys=NULL fails with EINVAL");
+    errno = 0;
+    ok (pmi_kvsseg_open (NULL) == NULL && errno == EINVAL,
+        "pmi_kvsseg_open path=NULL fails with EINVAL");
+    errno = 0;
+    ok (pmi_kvsseg_open ("/noexist") == NULL && errno == ENOENT,
+        "pmi_kvsseg_open of missing file fails with ENOENT");
+    ok (pmi_kvsseg_lookup (NULL, "foo") == NULL
+        && pmi_kvsseg_generation (NULL) == 0,
+        "pmi_kvsseg_lookup/generation seg=NULL are harmless");
+    lives_ok ({pmi_kvsseg_close (NULL);},
+        "pmi_kvsseg_close seg=NULL doesnt crash");
+}
+
+int main (int argc, char *argv[])
+{
+    const char *tmpdir = getenv ("TMPDIR");
+    int fd;
+
+    plan (NO_PLAN);
+
+    snprintf (path, sizeof (path), "%s/kvsseg.XXXXXX", tmpdir ? tmpdir : "/tmp");
+    if ((fd = mkstemp (path)) < 0)
+        BAIL_OUT ("mkstemp failed");
+    close (fd);
+
+    test_basic ();
+    test_corrupt ();
+    test_badargs ();
+
+    (void)unlink (path);
+
+    done_testing ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -19,6 +19,7 @@
 
 #include "router.h"
 #include "subhash.h"
+#include "subtrie.h"
 #include "servhash.h"
 #include "disconnect.h"
 
@@ -36,6 +37,7 @@ struct router {
     zhashx_t *routes;               // uuid => 'struct router_entry'
     void *arg;
     struct subhash *subscriptions;  // router's subscriber hash
+    struct subtrie *subtrie;        // topic prefix => router entries
     struct servhash *services;
     flux_msg_handler_t **handlers;
     bool mute;
@@ -234,24 +236,36 @@ static int broker_unsubscribe (const char *topic, void *arg)
     return 0;
 }
 
-/* A client asks the router to subscribe.
+/* A client subscribes to a topic for the first time.
  * This might generate a broker_subscribe() or just usecount++.
+ * The client is added to the subtrie for event distribution.
  */
 static int router_subscribe (const char *topic, void *arg)
 {
-    struct router *rtr = arg;
+    struct router_entry *entry = arg;
+    struct router *rtr = entry->rtr;
 
-    return subhash_subscribe (rtr->subscriptions, topic);
+    if (subtrie_add (rtr->subtrie, topic, entry) < 0)
+        return -1;
+    if (subhash_subscribe (rtr->subscriptions, topic) < 0) {
+        ERRNO_SAFE_WRAP (subtrie_remove, rtr->subtrie, topic, entry);
+        return -1;
+    }
+    return 0;
 }
 
-/* A client asks the router to unsubscribe.
+/* A client drops its last subscription to a topic.
  * This might generate a broker_unsubscribe() or just usecount--.
  */
 static int router_unsubscribe (const char *topic, void *arg)
 {
-    struct router *rtr = arg;
+    struct router_entry *entry = arg;
+    struct router *rtr = entry->rtr;
 
-    return subhash_unsubscribe (rtr->subscriptions, topic);
+    if (subhash_unsubscribe (rtr->subscriptions, topic) < 0)
+        return -1;
+    (void)subtrie_remove (rtr->subtrie, topic, entry);
+    return 0;
 }
 
 static void disconnect_cb (const flux_msg_t *msg, void *arg)
@@ -276,6 +290,8 @@ static void router_entry_destroy (struct router_entry *entry)
         disconnect_destroy (entry->dcon);
         servhash_disconnect (rtr->services, entry->uuid);
         subhash_destroy (entry->subscriptions);
+        if (rtr)
+            subtrie_remove_subscriber (rtr->subtrie, entry);
         ERRNO_SAFE_WRAP (free, entry->uuid);
         ERRNO_SAFE_WRAP (free, entry);
     }
@@ -327,8 +343,8 @@ struct router_entry *router_entry_add (struct router *rtr,
     if (!(entry = router_entry_create (uuid, cb, arg)))
         return NULL;
 
-    subhash_set_subscribe (entry->subscriptions, router_subscribe, rtr);
-    subhash_set_unsubscribe (entry->subscriptions, router_unsubscribe, rtr);
+    subhash_set_subscribe (entry->subscriptions, router_subscribe, entry);
+    subhash_set_unsubscribe (entry->subscriptions, router_unsubscribe, entry);
 
     if (zhashx_insert (rtr->routes, uuid, entry) < 0) {
         router_entry_destroy (entry);
@@ -409,6 +425,18 @@ error:
     flux_msg_destroy (cpy);
 }
 
+// subtrie_match_f footprint
+static void event_send (void *subscriber, void *arg)
+{
+    struct router_entry *entry = subscriber;
+    const flux_msg_t *msg = arg;
+
+    if (entry->send (msg, entry->arg) < 0)
+        flux_log_error (entry->rtr->h,
+                        "router: event > client=%.5s",
+                        entry->uuid);
+}
+
 /* Receive event from broker.
  * Distribute to all router entries with matching subscriptions.
  */
@@ -418,22 +446,13 @@ static void event_cb (flux_t *h,
                       void *arg)
 {
     struct router *rtr = arg;
-    struct router_entry *entry;
     const char *topic;
 
     if (flux_msg_get_topic (msg, &topic) < 0) {
         flux_log_error (h, "router: event > client");
         return;
     }
-
-    entry = zhashx_first (rtr->routes);
-    while ((entry)) {
-        if (subhash_topic_match (entry->subscriptions, topic)) {
-            if (entry->send (msg, entry->arg) < 0)
-                flux_log_error (h, "router: event > client=%.5s", entry->uuid);
-        }
-        entry = zhashx_next (rtr->routes);
-    }
+    subtrie_match (rtr->subtrie, topic, event_send, (void *)msg);
 }
 
 static const struct flux_msg_handler_spec htab[] = {
@@ -464,6 +483,9 @@ struct router *router_create (flux_t *h)
     subhash_set_subscribe (rtr->subscriptions, broker_subscribe, rtr);
     subhash_set_unsubscribe (rtr->subscriptions, broker_unsubscribe, rtr);
 
+    if (!(rtr->subtrie = subtrie_create ()))
+        goto error;
+
     if (!(rtr->services = servhash_create (h)))
         goto error;
     servhash_set_respond (rtr->services, router_entry_respond_byuuid, rtr);
@@ -480,9 +502,13 @@ void router_destroy (struct router *rtr)
 {
     if (rtr) {
         flux_msg_handler_delvec (rtr->handlers);
+        /* Entries unsubscribe and disconnect services as they are
+         * destroyed, so destroy them first.
+         */
+        ERRNO_SAFE_WRAP (zhashx_destroy, &rtr->routes);
         subhash_destroy (rtr->subscriptions);
+        subtrie_destroy (rtr->subtrie);
         servhash_destroy (rtr->services);
-        ERRNO_SAFE_WRAP (zhashx_destroy, &rtr->routes);
         ERRNO_SAFE_WRAP (free, rtr);
     }
 }
@@ -39,6 +39,10 @@
  *   is assembled, then it is freed.  The static buffer is sized somewhat
  *   arbitrarily at 4K.
  *
+ * - iobuf_send() and iobuf_recv() perform the same framing over an
+ *   arbitrary read/write function with non-blocking fd semantics, so that
+ *   other byte transports (e.g. a shared memory ring) can carry messages.
+ *
  * - sendfd/recvfd do not encrypt messages, therefore this transport
  *   is only appropriate for use on AF_LOCAL sockets or on file descriptors
  *   tunneled through a secure channel.
@@ -67,32 +71,66 @@ void iobuf_clean (struct iobuf *iobuf)
     memset (iobuf, 0, sizeof (*iobuf));
 }
 
-int sendfd (int fd, const flux_msg_t *msg, struct iobuf *iobuf)
+size_t sendfd_frame_size (const flux_msg_t *msg)
+{
+    return flux_msg_encode_size (msg) + 8;
+}
+
+int sendfd_frame (const flux_msg_t *msg, void *buf, size_t size)
+{
+    uint8_t *p = buf;
+    uint32_t hdr[2];
+
+    if (!msg || !buf || size < 8) {
+        errno = EINVAL;
+        return -1;
+    }
+    /* N.B. buf may be at any offset in a coalesced output buffer,
+     * so avoid unaligned 32-bit stores.
+     */
+    hdr[0] = IOBUF_MAGIC;
+    hdr[1] = htonl (size - 8);
+    memcpy (p, hdr, sizeof (hdr));
+    return flux_msg_encode (msg, &p[8], size - 8);
+}
+
+static ssize_t fd_write (void *arg, const void *buf, size_t len)
+{
+    return write (*(int *)arg, buf, len);
+}
+
+static ssize_t fd_read (void *arg, void *buf, size_t len)
+{
+    return read (*(int *)arg, buf, len);
+}
+
+int iobuf_send (iobuf_write_f fn,
+                void *arg,
+                const flux_msg_t *msg,
+                struct iobuf *iobuf)
 {
     struct iobuf local;
     struct iobuf *io = iobuf ? iobuf : &local;
     int rc = -1;
 
-    if (fd < 0 || !msg) {
+    if (!fn || !msg) {
         errno = EINVAL;
         return -1;
     }
     if (!iobuf)
         iobuf_init (&local);
     if (!io->buf) {
-        io->size = flux_msg_encode_size (msg) + 8;
+        io->size = sendfd_frame_size (msg);
         if (io->size <= sizeof (io->buf_fixed))
             io->buf = io->buf_fixed;
         else if (!(io->buf = malloc (io->size)))
             goto done;
-        *(uint32_t *)&io->buf[0] = IOBUF_MAGIC;
-        *(uint32_t *)&io->buf[4] = htonl (io->size - 8);
-        if (flux_msg_encode (msg, &io->buf[8], io->size - 8) < 0)
+        if (sendfd_frame (msg, io->buf, io->size) < 0)
             goto done;
         io->done = 0;
     }
     do {
-        rc = write (fd, io->buf + io->done, io->size - io->done);
+        rc = fn (arg, io->buf + io->done, io->size - io->done);
         if (rc < 0)
             goto done;
         io->done += rc;
@@ -110,14 +148,23 @@ done:
     return rc;
 }
 
-flux_msg_t *recvfd (int fd, struct iobuf *iobuf)
+int sendfd (int fd, const flux_msg_t *msg, struct iobuf *iobuf)
+{
+    if (fd < 0 || !msg) {
+        errno = EINVAL;
+        return -1;
+    }
+    return iobuf_send (fd_write, &fd, msg, iobuf);
+}
+
+flux_msg_t *iobuf_recv (iobuf_read_f fn, void *arg, struct iobuf *iobuf)
 {
     struct iobuf local;
     struct iobuf *io = iobuf ? iobuf : &local;
     flux_msg_t *msg = NULL;
     int rc = -1;
 
-    if (fd < 0) {
+    if (!fn) {
         errno = EINVAL;
         return NULL;
     }
@@ -129,7 +176,7 @@ flux_msg_t *recvfd (int fd, struct iobuf *iobuf)
     }
     do {
         if (io->done < 8) {
-            rc = read (fd, io->buf + io->done, 8 - io->done);
+            rc = fn (arg, io->buf + io->done, 8 - io->done);
             if (rc < 0)
                 goto done;
             if (rc == 0) {
@@ -151,7 +198,7 @@ flux_msg_t *recvfd (int fd, struct iobuf *iobuf)
             }
         }
         if (io->done >= 8 && io->done < io->size) {
-            rc = read (fd, io->buf + io->done, io->size - io->done);
+            rc = fn (arg, io->buf + io->done, io->size - io->done);
             if (rc < 0)
                 goto done;
             if (rc == 0) {
@@ -175,6 +222,15 @@ done:
     return msg;
 }
 
+flux_msg_t *recvfd (int fd, struct iobuf *iobuf)
+{
+    if (fd < 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+    return iobuf_recv (fd_read, &fd, iobuf);
+}
+
 /*
  * vi:tabstop=4 shiftwidth=4 expandtab
  */
@@ -32,6 +32,32 @@ int sendfd (int fd, const flux_msg_t *msg, struct iobuf *iobuf);
  */
 flux_msg_t *recvfd (int fd, struct iobuf *iobuf);
 
+/* Read/write functions for iobuf_send() and iobuf_recv(), with the
+ * semantics of read(2) and write(2) on a non-blocking file descriptor.
+ */
+typedef ssize_t (*iobuf_write_f)(void *arg, const void *buf, size_t len);
+typedef ssize_t (*iobuf_read_f)(void *arg, void *buf, size_t len);
+
+/* Like sendfd() and recvfd(), but use 'fn' to perform I/O.
+ */
+int iobuf_send (iobuf_write_f fn,
+                void *arg,
+                const flux_msg_t *msg,
+                struct iobuf *iobuf);
+flux_msg_t *iobuf_recv (iobuf_read_f fn, void *arg, struct iobuf *iobuf);
+
+/* Return the number of bytes required to frame 'msg' as sendfd() would
+ * write it.
+ */
+size_t sendfd_frame_size (const flux_msg_t *msg);
+
+/* Frame 'msg' into 'buf' as sendfd() would write it.  'size' should be
+ * the value returned by sendfd_frame_size().  This allows callers to
+ * coalesce several messages into one buffer and write them together.
+ * Returns 0 on success, -1 on failure with errno set.
+ */
+int sendfd_frame (const flux_msg_t *msg, void *buf, size_t size);
+
 /* Initialize iobuf members.
  */
 void iobuf_init (struct iobuf *iobuf);
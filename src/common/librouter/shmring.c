@@ -0,0 +1,480 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* shmring.c - shared memory byte rings between two processes
+ *
+ * The client creates a sealed memfd containing a header and two data
+ * areas, one per direction, plus one eventfd per side.  The fds are
+ * passed to the server (e.g. with SCM_RIGHTS), which maps the same memfd.
+ *
+ * Each direction is a single-producer, single-consumer ring indexed by
+ * free running 64-bit byte counters: the producer advances 'head', the
+ * consumer advances 'tail'.  Each side keeps its own copy of the counter
+ * it owns and only reads the peer's counter from shared memory, which is
+ * validated before use since the peer can write the segment arbitrarily.
+ *
+ * Wakeups: before a consumer waits for data (or a producer waits for
+ * space) it sets a "waiting" flag, then re-checks the ring.  After the
+ * peer makes progress it atomically clears the flag and, if it was set,
+ * writes to the waiter's eventfd.  Thus a busy ring costs no syscalls.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/eventfd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "src/common/libutil/errno_safe.h"
+
+#include "shmring.h"
+
+#define SHMRING_MAGIC       0x72696e67  // "ring"
+#define SHMRING_VERSION     1
+#define SHMRING_MIN_SIZE    4096
+#define SHMRING_MAX_SIZE    (1UL << 30)
+#define SHMRING_DATA_OFFSET 4096        // data areas start after header page
+
+#define CACHELINE 64
+
+struct ring_ctl {
+    uint64_t head __attribute__ ((aligned (CACHELINE)));
+    uint64_t tail __attribute__ ((aligned (CACHELINE)));
+    uint32_t reader_waiting __attribute__ ((aligned (CACHELINE)));
+    uint32_t writer_waiting;
+};
+
+enum {
+    RING_C2S = 0,   // client to server
+    RING_S2C = 1,   // server to client
+};
+
+struct shmring_header {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t size;              // size of each data area (power of 2)
+    struct ring_ctl ctl[2];
+};
+
+struct shmring {
+    int fds[SHMRING_FD_COUNT];
+    void *base;
+    size_t maplen;
+    uint64_t size;              // validated copy of hdr->size
+
+    struct ring_ctl *tx;
+    uint8_t *tx_data;
+    uint64_t tx_head;           // our copy of tx->head
+
+    struct ring_ctl *rx;
+    uint8_t *rx_data;
+    uint64_t rx_tail;           // our copy of rx->tail
+
+    int wake_fd;                // our eventfd
+    int peer_fd;                // peer's eventfd
+    bool armed;                 // we set a waiting flag
+};
+
+/* N.B. EAGAIN from an eventfd write means the counter is saturated,
+ * i.e. the peer already has a wakeup pending.
+ */
+static int signal_peer (struct shmring *ring)
+{
+    uint64_t val = 1;
+    if (write (ring->peer_fd, &val, sizeof (val)) < 0 && errno != EAGAIN)
+        return -1;
+    return 0;
+}
+
+static int wake_clear (struct shmring *ring)
+{
+    uint64_t val;
+    if (read (ring->wake_fd, &val, sizeof (val)) < 0 && errno != EAGAIN)
+        return -1;
+    return 0;
+}
+
+/* Return number of bytes in rx ring, or -1 with errno == EPROTO if the
+ * peer's head counter is out of range.
+ */
+static int64_t rx_avail (struct shmring *ring, int memorder)
+{
+    uint64_t head = __atomic_load_n (&ring->rx->head, memorder);
+    uint64_t avail = head - ring->rx_tail;
+
+    if (avail > ring->size) {
+        errno = EPROTO;
+        return -1;
+    }
+    return avail;
+}
+
+/* Return number of free bytes in tx ring, or -1 with errno == EPROTO if
+ * the peer's tail counter is out of range.
+ */
+static int64_t tx_space (struct shmring *ring, int memorder)
+{
+    uint64_t tail = __atomic_load_n (&ring->tx->tail, memorder);
+    uint64_t used = ring->tx_head - tail;
+
+    if (used > ring->size) {
+        errno = EPROTO;
+        return -1;
+    }
+    return ring->size - used;
+}
+
+ssize_t shmring_write (struct shmring *ring, const void *buf, size_t len)
+{
+    int64_t space;
+    size_t n, off, first;
+
+    if (!ring || (!buf && len > 0)) {
+        errno = EINVAL;
+        return -1;
+    }
+    if ((space = tx_space (ring, __ATOMIC_ACQUIRE)) < 0)
+        return -1;
+    if (space == 0) {
+        __atomic_store_n (&ring->tx->writer_waiting, 1, __ATOMIC_SEQ_CST);
+        ring->armed = true;
+        if ((space = tx_space (ring, __ATOMIC_SEQ_CST)) < 0)
+            return -1;
+        if (space == 0) {
+            errno = EWOULDBLOCK;
+            return -1;
+        }
+    }
+    n = len < space ? len : space;
+    off = ring->tx_head & (ring->size - 1);
+    first = n < ring->size - off ? n : ring->size - off;
+    memcpy (ring->tx_data + off, buf, first);
+    memcpy (ring->tx_data, (const uint8_t *)buf + first, n - first);
+    ring->tx_head += n;
+    __atomic_store_n (&ring->tx->head, ring->tx_head, __ATOMIC_SEQ_CST);
+    if (__atomic_exchange_n (&ring->tx->reader_waiting, 0, __ATOMIC_SEQ_CST))
+        (void)signal_peer (ring);
+    return n;
+}
+
+ssize_t shmring_read (struct shmring *ring, void *buf, size_t len)
+{
+    int64_t avail;
+    size_t n, off, first;
+
+    if (!ring || (!buf && len > 0)) {
+        errno = EINVAL;
+        return -1;
+    }
+    if ((avail = rx_avail (ring, __ATOMIC_ACQUIRE)) < 0)
+        return -1;
+    if (avail == 0) {
+        __atomic_store_n (&ring->rx->reader_waiting, 1, __ATOMIC_SEQ_CST);
+        ring->armed = true;
+        if ((avail = rx_avail (ring, __ATOMIC_SEQ_CST)) < 0)
+            return -1;
+        if (avail == 0) {
+            errno = EWOULDBLOCK;
+            return -1;
+        }
+    }
+    n = len < avail ? len : avail;
+    off = ring->rx_tail & (ring->size - 1);
+    first = n < ring->size - off ? n : ring->size - off;
+    memcpy (buf, ring->rx_data + off, first);
+    memcpy ((uint8_t *)buf + first, ring->rx_data, n - first);
+    ring->rx_tail += n;
+    __atomic_store_n (&ring->rx->tail, ring->rx_tail, __ATOMIC_SEQ_CST);
+    if (__atomic_exchange_n (&ring->rx->writer_waiting, 0, __ATOMIC_SEQ_CST))
+        (void)signal_peer (ring);
+    return n;
+}
+
+int shmring_pollevents (struct shmring *ring)
+{
+    int64_t avail, space;
+    int events = 0;
+
+    if (!ring)
+        return POLLERR;
+    /* A waiting flag was set, so the eventfd may have been signaled.
+     * Reset it (the ring itself is checked below).
+     */
+    if (ring->armed) {
+        if (wake_clear (ring) < 0)
+            return POLLERR;
+        ring->armed = false;
+    }
+    if ((avail = rx_avail (ring, __ATOMIC_ACQUIRE)) < 0)
+        return POLLERR;
+    if (avail == 0) {
+        __atomic_store_n (&ring->rx->reader_waiting, 1, __ATOMIC_SEQ_CST);
+        ring->armed = true;
+        if ((avail = rx_avail (ring, __ATOMIC_SEQ_CST)) < 0)
+            return POLLERR;
+    }
+    if (avail > 0)
+        events |= POLLIN;
+    if ((space = tx_space (ring, __ATOMIC_ACQUIRE)) < 0)
+        return POLLERR;
+    if (space == 0) {
+        __atomic_store_n (&ring->tx->writer_waiting, 1, __ATOMIC_SEQ_CST);
+        ring->armed = true;
+        if ((space = tx_space (ring, __ATOMIC_SEQ_CST)) < 0)
+            return POLLERR;
+    }
+    if (space > 0)
+        events |= POLLOUT;
+    return events;
+}
+
+void shmring_clear (struct shmring *ring)
+{
+    if (ring) {
+        (void)wake_clear (ring);
+        ring->armed = false;
+    }
+}
+
+int shmring_pollfd (struct shmring *ring)
+{
+    if (!ring) {
+        errno = EINVAL;
+        return -1;
+    }
+    return ring->wake_fd;
+}
+
+void shmring_get_fds (struct shmring *ring, int fds[SHMRING_FD_COUNT])
+{
+    if (ring) {
+        for (int i = 0; i < SHMRING_FD_COUNT; i++)
+            fds[i] = ring->fds[i];
+    }
+}
+
+void shmring_destroy (struct shmring *ring)
+{
+    if (ring) {
+        int saved_errno = errno;
+        if (ring->base)
+            (void)munmap (ring->base, ring->maplen);
+        for (int i = 0; i < SHMRING_FD_COUNT; i++) {
+            if (ring->fds[i] >= 0)
+                (void)close (ring->fds[i]);
+        }
+        free (ring);
+        errno = saved_errno;
+    }
+}
+
+static struct shmring *shmring_alloc (void)
+{
+    struct shmring *ring;
+
+    if (!(ring = calloc (1, sizeof (*ring))))
+        return NULL;
+    for (int i = 0; i < SHMRING_FD_COUNT; i++)
+        ring->fds[i] = -1;
+    return ring;
+}
+
+/* Set up tx/rx pointers for the given side, after ring->base and
+ * ring->size are valid.
+ */
+static void shmring_bind (struct shmring *ring, bool server)
+{
+    struct shmring_header *hdr = ring->base;
+    uint8_t *data = (uint8_t *)ring->base + SHMRING_DATA_OFFSET;
+    int tx = server ? RING_S2C : RING_C2S;
+    int rx = server ? RING_C2S : RING_S2C;
+
+    ring->tx = &hdr->ctl[tx];
+    ring->tx_data = data + tx * ring->size;
+    ring->tx_head = __atomic_load_n (&ring->tx->head, __ATOMIC_ACQUIRE);
+
+    ring->rx = &hdr->ctl[rx];
+    ring->rx_data = data + rx * ring->size;
+    ring->rx_tail = __atomic_load_n (&ring->rx->tail, __ATOMIC_ACQUIRE);
+
+    ring->wake_fd = ring->fds[server ? SHMRING_FD_SERVER : SHMRING_FD_CLIENT];
+    ring->peer_fd = ring->fds[server ? SHMRING_FD_CLIENT : SHMRING_FD_SERVER];
+}
+
+static size_t roundup_pow2 (size_t size)
+{
+    size_t n = SHMRING_MIN_SIZE;
+    while (n < size)
+        n <<= 1;
+    return n;
+}
+
+#if HAVE_MEMFD_CREATE
+struct shmring *shmring_create (size_t size)
+{
+    struct shmring *ring;
+    struct shmring_header *hdr;
+    int seals = F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL;
+
+    if (size > SHMRING_MAX_SIZE) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(ring = shmring_alloc ()))
+        return NULL;
+    ring->size = roundup_pow2 (size);
+    ring->maplen = SHMRING_DATA_OFFSET + 2 * ring->size;
+    if ((ring->fds[SHMRING_FD_MEM] = memfd_create ("flux-shmring",
+                                                   MFD_CLOEXEC
+                                                   | MFD_ALLOW_SEALING)) < 0)
+        goto error;
+    if (ftruncate (ring->fds[SHMRING_FD_MEM], ring->maplen) < 0)
+        goto error;
+    if (fcntl (ring->fds[SHMRING_FD_MEM], F_ADD_SEALS, seals) < 0)
+        goto error;
+    if ((ring->base = mmap (NULL,
+                            ring->maplen,
+                            PROT_READ | PROT_WRITE,
+                            MAP_SHARED,
+                            ring->fds[SHMRING_FD_MEM],
+                            0)) == MAP_FAILED) {
+        ring->base = NULL;
+        goto error;
+    }
+    hdr = ring->base;
+    hdr->magic = SHMRING_MAGIC;
+    hdr->version = SHMRING_VERSION;
+    hdr->size = ring->size;
+    if ((ring->fds[SHMRING_FD_CLIENT] = eventfd (0, EFD_CLOEXEC
+                                                    | EFD_NONBLOCK)) < 0
+        || (ring->fds[SHMRING_FD_SERVER] = eventfd (0, EFD_CLOEXEC
+                                                       | EFD_NONBLOCK)) < 0)
+        goto error;
+    shmring_bind (ring, false);
+    return ring;
+error:
+    shmring_destroy (ring);
+    return NULL;
+}
+#else
+struct shmring *shmring_create (size_t size)
+{
+    errno = ENOSYS;
+    return NULL;
+}
+#endif
+
+/* The eventfds are supplied by an untrusted peer.  Insist that they are
+ * eventfds and make them non-blocking, so that a pipe or socket passed in
+ * their place cannot block this thread in signal_peer() or wake_clear().
+ */
+static int eventfd_validate (int fd)
+{
+    struct stat sb;
+    char path[64];
+    char target[64];
+    ssize_t n;
+    int flags;
+
+    if (fstat (fd, &sb) < 0)
+        return -1;
+    if (S_ISFIFO (sb.st_mode)
+        || S_ISSOCK (sb.st_mode)
+        || S_ISCHR (sb.st_mode)
+        || S_ISBLK (sb.st_mode)
+        || S_ISDIR (sb.st_mode))
+        goto inval;
+    (void)snprintf (path, sizeof (path), "/proc/self/fd/%d", fd);
+    if ((n = readlink (path, target, sizeof (target) - 1)) < 0)
+        goto inval;
+    target[n] = '\0';
+    if (strcmp (target, "anon_inode:[eventfd]") != 0)
+        goto inval;
+    if ((flags = fcntl (fd, F_GETFL)) < 0)
+        return -1;
+    if (!(flags & O_NONBLOCK) && fcntl (fd, F_SETFL, flags | O_NONBLOCK) < 0)
+        return -1;
+    return 0;
+inval:
+    errno = EINVAL;
+    return -1;
+}
+
+struct shmring *shmring_attach (int fds[SHMRING_FD_COUNT])
+{
+    struct shmring *ring;
+    struct shmring_header hdr;
+    struct stat sb;
+    int seals;
+    int required_seals = F_SEAL_SHRINK | F_SEAL_SEAL;
+
+    if (!fds || fds[SHMRING_FD_MEM] < 0
+             || fds[SHMRING_FD_CLIENT] < 0
+             || fds[SHMRING_FD_SERVER] < 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (eventfd_validate (fds[SHMRING_FD_CLIENT]) < 0
+        || eventfd_validate (fds[SHMRING_FD_SERVER]) < 0)
+        return NULL;
+    /* The segment must not be shrinkable, or the peer could truncate it
+     * and cause SIGBUS when we access it.
+     */
+    if ((seals = fcntl (fds[SHMRING_FD_MEM], F_GET_SEALS)) < 0)
+        return NULL;
+    if ((seals & required_seals) != required_seals) {
+        errno = EPERM;
+        return NULL;
+    }
+    if (fstat (fds[SHMRING_FD_MEM], &sb) < 0)
+        return NULL;
+    if (pread (fds[SHMRING_FD_MEM], &hdr, sizeof (hdr), 0) != sizeof (hdr)
+        || hdr.magic != SHMRING_MAGIC
+        || hdr.version != SHMRING_VERSION
+        || hdr.size < SHMRING_MIN_SIZE
+        || hdr.size > SHMRING_MAX_SIZE
+        || (hdr.size & (hdr.size - 1)) != 0
+        || sb.st_size != SHMRING_DATA_OFFSET + 2 * hdr.size) {
+        errno = EPROTO;
+        return NULL;
+    }
+    if (!(ring = shmring_alloc ()))
+        return NULL;
+    ring->size = hdr.size;
+    ring->maplen = sb.st_size;
+    if ((ring->base = mmap (NULL,
+                            ring->maplen,
+                            PROT_READ | PROT_WRITE,
+                            MAP_SHARED,
+                            fds[SHMRING_FD_MEM],
+                            0)) == MAP_FAILED) {
+        ERRNO_SAFE_WRAP (free, ring);
+        return NULL;
+    }
+    for (int i = 0; i < SHMRING_FD_COUNT; i++)
+        ring->fds[i] = fds[i];
+    shmring_bind (ring, true);
+    return ring;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
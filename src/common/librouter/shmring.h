@@ -0,0 +1,81 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _ROUTER_SHMRING_H
+#define _ROUTER_SHMRING_H
+
+#include <sys/types.h>
+
+/* A pair of single-producer, single-consumer byte rings in a shared
+ * memory segment, one for each direction between a client and a server
+ * process on the same node, with eventfd wakeups.
+ */
+struct shmring;
+
+enum {
+    SHMRING_FD_MEM = 0,     // sealed memfd holding the rings
+    SHMRING_FD_CLIENT = 1,  // eventfd the client side waits on
+    SHMRING_FD_SERVER = 2,  // eventfd the server side waits on
+    SHMRING_FD_COUNT = 3,
+};
+
+/* Client: create a new segment with rings of 'size' bytes in each
+ * direction ('size' is rounded up to a power of two).
+ */
+struct shmring *shmring_create (size_t size);
+
+/* Server: map a segment created by a peer with shmring_create(), given
+ * the file descriptors from shmring_get_fds().  The segment is validated
+ * before use, and the wakeup fds must be eventfds (EINVAL otherwise),
+ * which are set non-blocking.  On success, the ring takes ownership of
+ * the fds.
+ */
+struct shmring *shmring_attach (int fds[SHMRING_FD_COUNT]);
+
+void shmring_destroy (struct shmring *ring);
+
+/* Get the file descriptors that must be passed to the peer.
+ */
+void shmring_get_fds (struct shmring *ring, int fds[SHMRING_FD_COUNT]);
+
+/* Get this side's wakeup eventfd.  It becomes readable when the peer
+ * has written data for us, or has freed space that we were waiting for.
+ */
+int shmring_pollfd (struct shmring *ring);
+
+/* Check for pending events (non-blocking).  Returns a mask of POLLIN
+ * (data can be read) and POLLOUT (space can be written), or POLLERR if the
+ * segment is corrupt.  If either is absent, a wakeup is armed for it.
+ * This also resets a wakeup that has fired, if any.
+ */
+int shmring_pollevents (struct shmring *ring);
+
+/* Reset this side's wakeup eventfd unconditionally.  Call this from a
+ * level-triggered watcher on shmring_pollfd() before checking the ring.
+ */
+void shmring_clear (struct shmring *ring);
+
+/* Write up to 'len' bytes to the peer, with the semantics of write(2)
+ * on a non-blocking fd.  Returns -1 with errno == EWOULDBLOCK if the ring
+ * is full.
+ */
+ssize_t shmring_write (struct shmring *ring, const void *buf, size_t len);
+
+/* Read up to 'len' bytes from the peer, with the semantics of read(2)
+ * on a non-blocking fd.  Returns -1 with errno == EWOULDBLOCK if the ring
+ * is empty.
+ */
+ssize_t shmring_read (struct shmring *ring, void *buf, size_t len);
+
+#endif /* !_ROUTER_SHMRING_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
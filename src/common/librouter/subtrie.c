@@ -0,0 +1,368 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* subtrie.c - event subscription prefix trie
+ *
+ * Each node of the trie corresponds to one character of a subscription
+ * prefix, and holds a list of references to the subscribers whose prefix
+ * ends there.  Matching an event topic walks the single path from the root
+ * spelled by the topic, visiting every node whose prefix matches, so the
+ * cost is proportional to the topic length plus the number of matching
+ * subscribers, rather than to the total number of subscriptions.
+ *
+ * Each subscriber also has a list of its own references, so that one
+ * (prefix, subscriber) pair can be found without scanning a node that may
+ * be shared by thousands of subscribers, and so that all of a subscriber's
+ * prefixes can be dropped at once when it goes away.
+ *
+ * A subscriber holding overlapping prefixes (e.g. "kvs" and "kvs.setroot")
+ * is reported only once per match.  A per-match generation number is
+ * stored in the subscriber to detect duplicates.
+ *
+ * Nodes are pruned as soon as they have no references and no children.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <stdint.h>
+#include <czmq.h>
+
+#include "subtrie.h"
+
+struct subtrie_node {
+    struct subtrie_node *parent;
+    struct subtrie_node *child;     // first child
+    struct subtrie_node *next;      // next sibling
+    struct subtrie_ref *refs;       // subscribers whose prefix ends here
+    unsigned char c;
+};
+
+struct subtrie_ref {
+    struct subtrie_sub *sub;
+    struct subtrie_node *node;
+    int refcount;
+    struct subtrie_ref *prev;       // node->refs list
+    struct subtrie_ref *next;
+    struct subtrie_ref *sub_next;   // sub->refs list
+};
+
+struct subtrie_sub {
+    void *subscriber;
+    struct subtrie_ref *refs;
+    unsigned int mark;
+};
+
+struct subtrie {
+    struct subtrie_node root;
+    zhashx_t *subs;                 // subscriber => struct subtrie_sub
+    unsigned int mark;
+};
+
+/* N.B. only called once a subscriber's references have been unlinked
+ * from their nodes, or when the whole trie is being destroyed.
+ */
+static void subtrie_sub_destroy (struct subtrie_sub *sub)
+{
+    if (sub) {
+        int saved_errno = errno;
+        struct subtrie_ref *ref;
+        while ((ref = sub->refs)) {
+            sub->refs = ref->sub_next;
+            free (ref);
+        }
+        free (sub);
+        errno = saved_errno;
+    }
+}
+
+// zhashx_destructor_fn footprint (wrapper)
+static void subtrie_sub_destructor (void **item)
+{
+    if (item) {
+        subtrie_sub_destroy (*item);
+        *item = NULL;
+    }
+}
+
+// zhashx_hash_fn footprint - subscriber pointer is the key
+static size_t subscriber_hasher (const void *key)
+{
+    return (uintptr_t)key;
+}
+
+// zhashx_comparator_fn footprint
+static int subscriber_cmp (const void *key1, const void *key2)
+{
+    if (key1 == key2)
+        return 0;
+    return key1 < key2 ? -1 : 1;
+}
+
+static struct subtrie_node *node_find_child (struct subtrie_node *node,
+                                             unsigned char c)
+{
+    struct subtrie_node *child;
+
+    for (child = node->child; child != NULL; child = child->next) {
+        if (child->c == c)
+            return child;
+    }
+    return NULL;
+}
+
+static struct subtrie_node *node_get_child (struct subtrie_node *node,
+                                            unsigned char c)
+{
+    struct subtrie_node *child;
+
+    if (!(child = node_find_child (node, c))) {
+        if (!(child = calloc (1, sizeof (*child))))
+            return NULL;
+        child->c = c;
+        child->parent = node;
+        child->next = node->child;
+        node->child = child;
+    }
+    return child;
+}
+
+static struct subtrie_node *node_lookup (struct subtrie *st,
+                                         const char *prefix)
+{
+    struct subtrie_node *node = &st->root;
+    const char *cp;
+
+    for (cp = prefix; *cp != '\0' && node != NULL; cp++)
+        node = node_find_child (node, *cp);
+    return node;
+}
+
+/* Free 'node' and any ancestors that are no longer needed.
+ */
+static void node_prune (struct subtrie *st, struct subtrie_node *node)
+{
+    while (node != &st->root && !node->refs && !node->child) {
+        struct subtrie_node *parent = node->parent;
+        struct subtrie_node **np = &parent->child;
+
+        while (*np != node)
+            np = &(*np)->next;
+        *np = node->next;
+        free (node);
+        node = parent;
+    }
+}
+
+static void node_destroy_children (struct subtrie_node *node)
+{
+    struct subtrie_node *child;
+
+    while ((child = node->child)) {
+        node->child = child->next;
+        node_destroy_children (child);
+        free (child);
+    }
+}
+
+/* Unlink 'ref' from its node and free it.
+ * The caller must have already unlinked it from ref->sub->refs.
+ */
+static void ref_destroy (struct subtrie *st, struct subtrie_ref *ref)
+{
+    struct subtrie_node *node = ref->node;
+
+    if (ref->prev)
+        ref->prev->next = ref->next;
+    else
+        node->refs = ref->next;
+    if (ref->next)
+        ref->next->prev = ref->prev;
+    free (ref);
+    node_prune (st, node);
+}
+
+int subtrie_add (struct subtrie *st, const char *prefix, void *subscriber)
+{
+    struct subtrie_sub *sub;
+    struct subtrie_node *node;
+    struct subtrie_node *last;
+    struct subtrie_ref *ref;
+    bool new_sub = false;
+    const char *cp;
+
+    if (!st || !prefix || !subscriber) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!(sub = zhashx_lookup (st->subs, subscriber))) {
+        if (!(sub = calloc (1, sizeof (*sub))))
+            return -1;
+        sub->subscriber = subscriber;
+        if (zhashx_insert (st->subs, subscriber, sub) < 0) {
+            subtrie_sub_destroy (sub);
+            errno = EEXIST;
+            return -1;
+        }
+        new_sub = true;
+    }
+    last = node = &st->root;
+    for (cp = prefix; *cp != '\0'; cp++) {
+        if (!(node = node_get_child (last, *cp)))
+            goto error;
+        last = node;
+    }
+    for (ref = sub->refs; ref != NULL; ref = ref->sub_next) {
+        if (ref->node == node) {
+            ref->refcount++;
+            return 0;
+        }
+    }
+    if (!(ref = calloc (1, sizeof (*ref))))
+        goto error;
+    ref->sub = sub;
+    ref->node = node;
+    ref->refcount = 1;
+    ref->next = node->refs;
+    if (node->refs)
+        node->refs->prev = ref;
+    node->refs = ref;
+    ref->sub_next = sub->refs;
+    sub->refs = ref;
+    return 0;
+error:
+    node_prune (st, last);
+    if (new_sub)
+        zhashx_delete (st->subs, subscriber);
+    errno = ENOMEM;
+    return -1;
+}
+
+int subtrie_remove (struct subtrie *st, const char *prefix, void *subscriber)
+{
+    struct subtrie_sub *sub;
+    struct subtrie_node *node;
+    struct subtrie_ref **refp;
+    struct subtrie_ref *ref;
+
+    if (!st || !prefix || !subscriber) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!(sub = zhashx_lookup (st->subs, subscriber))
+        || !(node = node_lookup (st, prefix)))
+        goto noent;
+    for (refp = &sub->refs; *refp != NULL; refp = &(*refp)->sub_next) {
+        if ((*refp)->node == node)
+            break;
+    }
+    if (!(ref = *refp))
+        goto noent;
+    if (--ref->refcount > 0)
+        return 0;
+    *refp = ref->sub_next;
+    ref_destroy (st, ref);
+    if (!sub->refs)
+        zhashx_delete (st->subs, subscriber);
+    return 0;
+noent:
+    errno = ENOENT;
+    return -1;
+}
+
+void subtrie_remove_subscriber (struct subtrie *st, void *subscriber)
+{
+    struct subtrie_sub *sub;
+    struct subtrie_ref *ref;
+
+    if (st && subscriber && (sub = zhashx_lookup (st->subs, subscriber))) {
+        while ((ref = sub->refs)) {
+            sub->refs = ref->sub_next;
+            ref_destroy (st, ref);
+        }
+        zhashx_delete (st->subs, subscriber);
+    }
+}
+
+int subtrie_match (struct subtrie *st,
+                   const char *topic,
+                   subtrie_match_f cb,
+                   void *arg)
+{
+    struct subtrie_node *node;
+    struct subtrie_ref *ref;
+    const char *cp = topic;
+    int count = 0;
+
+    if (!st || !topic)
+        return 0;
+
+    /* Start a new generation.  On wraparound, clear all subscriber marks
+     * so a stale mark cannot be mistaken for the current one.
+     */
+    if (++st->mark == 0) {
+        struct subtrie_sub *sub = zhashx_first (st->subs);
+        while (sub) {
+            sub->mark = 0;
+            sub = zhashx_next (st->subs);
+        }
+        st->mark = 1;
+    }
+    node = &st->root;
+    while (node) {
+        for (ref = node->refs; ref != NULL; ref = ref->next) {
+            if (ref->sub->mark != st->mark) {
+                ref->sub->mark = st->mark;
+                if (cb)
+                    cb (ref->sub->subscriber, arg);
+                count++;
+            }
+        }
+        if (*cp == '\0')
+            break;
+        node = node_find_child (node, *cp++);
+    }
+    return count;
+}
+
+void subtrie_destroy (struct subtrie *st)
+{
+    if (st) {
+        int saved_errno = errno;
+        node_destroy_children (&st->root);
+        zhashx_destroy (&st->subs);
+        free (st);
+        errno = saved_errno;
+    }
+}
+
+struct subtrie *subtrie_create (void)
+{
+    struct subtrie *st;
+
+    if (!(st = calloc (1, sizeof (*st))))
+        return NULL;
+    if (!(st->subs = zhashx_new ()))
+        goto error;
+    zhashx_set_key_hasher (st->subs, subscriber_hasher);
+    zhashx_set_key_comparator (st->subs, subscriber_cmp);
+    zhashx_set_key_duplicator (st->subs, NULL);
+    zhashx_set_key_destructor (st->subs, NULL);
+    zhashx_set_destructor (st->subs, subtrie_sub_destructor);
+    return st;
+error:
+    subtrie_destroy (st);
+    return NULL;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,50 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _ROUTER_SUBTRIE_H
+#define _ROUTER_SUBTRIE_H
+
+/* subtrie - map event subscription prefixes to subscribers
+ *
+ * A subscriber is an opaque pointer, e.g. a router entry or broker module.
+ * An event topic matches a subscriber if any of its prefixes is a prefix
+ * of the topic, so the empty string matches everything.
+ */
+
+typedef void (*subtrie_match_f)(void *subscriber, void *arg);
+
+struct subtrie *subtrie_create (void);
+void subtrie_destroy (struct subtrie *st);
+
+/* Add/remove a (prefix, subscriber) pair.  Pairs are reference counted:
+ * a prefix added N times by the same subscriber must be removed N times.
+ * subtrie_remove() fails with ENOENT if the pair is not present.
+ */
+int subtrie_add (struct subtrie *st, const char *prefix, void *subscriber);
+int subtrie_remove (struct subtrie *st, const char *prefix, void *subscriber);
+
+/* Remove all prefixes held by 'subscriber'.
+ */
+void subtrie_remove_subscriber (struct subtrie *st, void *subscriber);
+
+/* Call 'cb' once for each subscriber with a prefix matching 'topic',
+ * even if it holds several.  'cb' must not modify the subtrie.
+ * Returns the number of subscribers matched.
+ */
+int subtrie_match (struct subtrie *st,
+                   const char *topic,
+                   subtrie_match_f cb,
+                   void *arg);
+
+#endif /* !_ROUTER_SUBTRIE_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
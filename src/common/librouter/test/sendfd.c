@@ -292,6 +292,58 @@ next:
     free (buf);
 }
 
+/* Frame two messages into one buffer, write it with one call, and
+ * ensure recvfd() sees two messages.
+ */
+void test_frame (void)
+{
+    int pfd[2];
+    flux_msg_t *msg1, *msg2, *msg;
+    size_t size1, size2;
+    uint8_t *buf;
+    const char *topic;
+
+    if (pipe2 (pfd, O_CLOEXEC) < 0)
+        BAIL_OUT ("pipe2 failed");
+    if (!(msg1 = flux_request_encode ("foo.one", NULL))
+        || !(msg2 = flux_request_encode ("foo.two", "{}")))
+        BAIL_OUT ("flux_request_encode failed");
+    size1 = sendfd_frame_size (msg1);
+    size2 = sendfd_frame_size (msg2);
+    ok (size1 == flux_msg_encode_size (msg1) + 8,
+        "sendfd_frame_size includes 8 byte header");
+    if (!(buf = malloc (size1 + size2)))
+        BAIL_OUT ("malloc failed");
+    ok (sendfd_frame (msg1, buf, size1) == 0
+        && sendfd_frame (msg2, buf + size1, size2) == 0,
+        "sendfd_frame works for two messages in one buffer");
+    ok (write (pfd[1], buf, size1 + size2) == size1 + size2,
+        "coalesced buffer was written in one call");
+    ok ((msg = recvfd (pfd[0], NULL)) != NULL
+        && flux_msg_get_topic (msg, &topic) == 0
+        && !strcmp (topic, "foo.one"),
+        "recvfd received first message");
+    flux_msg_destroy (msg);
+    ok ((msg = recvfd (pfd[0], NULL)) != NULL
+        && flux_msg_get_topic (msg, &topic) == 0
+        && !strcmp (topic, "foo.two"),
+        "recvfd received second message");
+    flux_msg_destroy (msg);
+
+    errno = 0;
+    ok (sendfd_frame (msg1, buf, 4) < 0 && errno == EINVAL,
+        "sendfd_frame size=4 fails with EINVAL");
+    errno = 0;
+    ok (sendfd_frame (NULL, buf, size1) < 0 && errno == EINVAL,
+        "sendfd_frame msg=NULL fails with EINVAL");
+
+    free (buf);
+    flux_msg_destroy (msg1);
+    flux_msg_destroy (msg2);
+    close (pfd[1]);
+    close (pfd[0]);
+}
+
 void test_inval (void)
 {
     flux_msg_t *msg;
@@ -324,6 +376,7 @@ int main (int argc, char *argv[])
     test_nonblock (4096, 256);
     test_nonblock (16384, 64);
     test_nonblock (1048586, 1);
+    test_frame ();
     test_inval ();
 
     done_testing();
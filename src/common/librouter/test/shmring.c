@@ -0,0 +1,279 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <sys/mman.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/common/librouter/shmring.h"
+
+static bool fd_readable (int fd)
+{
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+
+    return poll (&pfd, 1, 0) == 1 && (pfd.revents & POLLIN);
+}
+
+/* Attach a "server" ring to a "client" ring in the same process,
+ * using dups of the client's fds as if they were passed with SCM_RIGHTS.
+ */
+static struct shmring *server_attach (struct shmring *client)
+{
+    int fds[SHMRING_FD_COUNT];
+    struct shmring *server;
+
+    shmring_get_fds (client, fds);
+    for (int i = 0; i < SHMRING_FD_COUNT; i++) {
+        if ((fds[i] = dup (fds[i])) < 0)
+            BAIL_OUT ("dup failed");
+    }
+    if (!(server = shmring_attach (fds))) {
+        for (int i = 0; i < SHMRING_FD_COUNT; i++)
+            (void)close (fds[i]);
+    }
+    return server;
+}
+
+void test_basic (void)
+{
+    struct shmring *client;
+    struct shmring *server;
+    char buf[64];
+
+    ok ((client = shmring_create (0)) != NULL,
+        "shmring_create works");
+    ok ((server = server_attach (client)) != NULL,
+        "shmring_attach works");
+
+    ok (shmring_pollevents (client) == POLLOUT,
+        "client: pollevents is POLLOUT on empty ring");
+    ok (shmring_pollevents (server) == POLLOUT,
+        "server: pollevents is POLLOUT on empty ring");
+
+    errno = 0;
+    ok (shmring_read (server, buf, sizeof (buf)) < 0 && errno == EWOULDBLOCK,
+        "server: shmring_read on empty ring fails with EWOULDBLOCK");
+    ok (!fd_readable (shmring_pollfd (server)),
+        "server: wakeup fd is not readable");
+
+    ok (shmring_write (client, "hello", 6) == 6,
+        "client: shmring_write works");
+    ok (fd_readable (shmring_pollfd (server)),
+        "server: wakeup fd is readable after write to waiting reader");
+    ok (shmring_pollevents (server) == (POLLIN | POLLOUT),
+        "server: pollevents is POLLIN|POLLOUT");
+    ok (!fd_readable (shmring_pollfd (server)),
+        "server: pollevents reset the wakeup fd");
+    ok (shmring_read (server, buf, sizeof (buf)) == 6
+        && !strcmp (buf, "hello"),
+        "server: shmring_read got the data");
+
+    ok (shmring_write (server, "world", 6) == 6,
+        "server: shmring_write works");
+    ok (shmring_read (client, buf, sizeof (buf)) == 6
+        && !strcmp (buf, "world"),
+        "client: shmring_read got the data");
+
+    shmring_destroy (server);
+    shmring_destroy (client);
+}
+
+/* Fill the ring, ensure the writer gets EWOULDBLOCK, and a wakeup
+ * once the reader makes space.  Verify data integrity across wraparound.
+ */
+void test_full (void)
+{
+    struct shmring *client;
+    struct shmring *server;
+    size_t size = 4096;
+    char *buf;
+    char *rbuf;
+    ssize_t n;
+    size_t total;
+    int errors = 0;
+
+    if (!(buf = malloc (size * 3)) || !(rbuf = malloc (size * 3)))
+        BAIL_OUT ("malloc failed");
+    for (int i = 0; i < size * 3; i++)
+        buf[i] = i % 251;
+    if (!(client = shmring_create (size)))
+        BAIL_OUT ("shmring_create failed");
+    if (!(server = server_attach (client)))
+        BAIL_OUT ("shmring_attach failed");
+
+    ok (shmring_write (client, buf, 1000) == 1000,
+        "client: wrote 1000 bytes");
+    ok (shmring_read (server, rbuf, 1000) == 1000
+        && !memcmp (buf, rbuf, 1000),
+        "server: read 1000 bytes");
+
+    n = shmring_write (client, buf, size * 3);
+    ok (n == size,
+        "client: short write fills the ring");
+    errno = 0;
+    ok (shmring_write (client, buf + n, 1) < 0 && errno == EWOULDBLOCK,
+        "client: shmring_write on full ring fails with EWOULDBLOCK");
+    ok (shmring_pollevents (client) == 0,
+        "client: pollevents is 0 on full ring");
+    ok (!fd_readable (shmring_pollfd (client)),
+        "client: wakeup fd is not readable");
+
+    total = 0;
+    while ((n = shmring_read (server, rbuf + total, 100)) > 0)
+        total += n;
+    ok (total == size && !memcmp (buf, rbuf, size),
+        "server: read back full ring intact across wraparound");
+    ok (fd_readable (shmring_pollfd (client)),
+        "client: wakeup fd became readable when space was made");
+    ok (shmring_pollevents (client) == POLLOUT,
+        "client: pollevents is POLLOUT");
+
+    for (int i = 0; i < 100; i++) {
+        if (shmring_write (client, buf + i, 37) != 37
+            || shmring_read (server, rbuf, 37) != 37
+            || memcmp (buf + i, rbuf, 37) != 0)
+            errors++;
+    }
+    ok (errors == 0,
+        "100 odd-sized transfers through the ring are intact");
+
+    shmring_destroy (server);
+    shmring_destroy (client);
+    free (rbuf);
+    free (buf);
+}
+
+void test_attach_bad (void)
+{
+    struct shmring *client;
+    int fds[SHMRING_FD_COUNT];
+    int bad[SHMRING_FD_COUNT];
+
+    if (!(client = shmring_create (0)))
+        BAIL_OUT ("shmring_create failed");
+    shmring_get_fds (client, fds);
+
+    /* unsealed memfd */
+    memcpy (bad, fds, sizeof (bad));
+    if ((bad[SHMRING_FD_MEM] = memfd_create ("test", MFD_CLOEXEC)) < 0)
+        BAIL_OUT ("memfd_create failed");
+    errno = 0;
+    ok (shmring_attach (bad) == NULL && errno == EPERM,
+        "shmring_attach with unsealed memfd fails with EPERM");
+    close (bad[SHMRING_FD_MEM]);
+
+    /* sealed but garbage content */
+    if ((bad[SHMRING_FD_MEM] = memfd_create ("test", MFD_CLOEXEC
+                                                     | MFD_ALLOW_SEALING)) < 0
+        || ftruncate (bad[SHMRING_FD_MEM], 65536) < 0
+        || fcntl (bad[SHMRING_FD_MEM],
+                  F_ADD_SEALS,
+                  F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) < 0)
+        BAIL_OUT ("could not create sealed memfd");
+    errno = 0;
+    ok (shmring_attach (bad) == NULL && errno == EPROTO,
+        "shmring_attach with bad header fails with EPROTO");
+    close (bad[SHMRING_FD_MEM]);
+
+    /* pipe in place of an eventfd */
+    int pfd[2];
+    bad[SHMRING_FD_MEM] = fds[SHMRING_FD_MEM];
+    if (pipe (pfd) < 0)
+        BAIL_OUT ("pipe failed");
+    bad[SHMRING_FD_CLIENT] = pfd[0];
+    errno = 0;
+    ok (shmring_attach (bad) == NULL && errno == EINVAL,
+        "shmring_attach with a pipe for the client fd fails with EINVAL");
+    bad[SHMRING_FD_CLIENT] = fds[SHMRING_FD_CLIENT];
+    bad[SHMRING_FD_SERVER] = pfd[1];
+    errno = 0;
+    ok (shmring_attach (bad) == NULL && errno == EINVAL,
+        "shmring_attach with a pipe for the server fd fails with EINVAL");
+    bad[SHMRING_FD_SERVER] = fds[SHMRING_FD_SERVER];
+    close (pfd[0]);
+    close (pfd[1]);
+
+    /* memfd in place of an eventfd */
+    bad[SHMRING_FD_CLIENT] = fds[SHMRING_FD_MEM];
+    errno = 0;
+    ok (shmring_attach (bad) == NULL && errno == EINVAL,
+        "shmring_attach with a memfd for the client fd fails with EINVAL");
+
+    errno = 0;
+    bad[SHMRING_FD_CLIENT] = -1;
+    ok (shmring_attach (bad) == NULL && errno == EINVAL,
+        "shmring_attach with fd=-1 fails with EINVAL");
+    errno = 0;
+    ok (shmring_create (1UL << 40) == NULL && errno == EINVAL,
+        "shmring_create with huge size fails with EINVAL");
+    errno = 0;
+    ok (shmring_write (NULL, "x", 1) < 0 && errno == EINVAL,
+        "shmring_write ring=NULL fails with EINVAL");
+    errno = 0;
+    ok (shmring_read (NULL, fds, 1) < 0 && errno == EINVAL,
+        "shmring_read ring=NULL fails with EINVAL");
+
+    shmring_destroy (client);
+}
+
+/* The peer may pass blocking eventfds.  The server must not block on them.
+ */
+void test_attach_blocking (void)
+{
+    struct shmring *client;
+    struct shmring *server;
+    int fds[SHMRING_FD_COUNT];
+    int flags;
+
+    if (!(client = shmring_create (0)))
+        BAIL_OUT ("shmring_create failed");
+    shmring_get_fds (client, fds);
+    if ((fds[SHMRING_FD_MEM] = dup (fds[SHMRING_FD_MEM])) < 0
+        || (fds[SHMRING_FD_CLIENT] = eventfd (0, EFD_CLOEXEC)) < 0
+        || (fds[SHMRING_FD_SERVER] = eventfd (0, EFD_CLOEXEC)) < 0)
+        BAIL_OUT ("could not create fds");
+    server = shmring_attach (fds);
+    ok (server != NULL,
+        "shmring_attach with blocking eventfds works");
+    ok ((flags = fcntl (fds[SHMRING_FD_CLIENT], F_GETFL)) >= 0
+        && (flags & O_NONBLOCK)
+        && (flags = fcntl (fds[SHMRING_FD_SERVER], F_GETFL)) >= 0
+        && (flags & O_NONBLOCK),
+        "shmring_attach made the eventfds non-blocking");
+    shmring_destroy (server);
+    shmring_destroy (client);
+}
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    test_basic ();
+    test_full ();
+    test_attach_bad ();
+    test_attach_blocking ();
+
+    done_testing();
+    return (0);
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,256 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <errno.h>
+#include <string.h>
+#include <flux/core.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/common/librouter/subtrie.h"
+
+#define NSUBS 4
+
+struct result {
+    int count[NSUBS];
+};
+
+static int subs[NSUBS];
+
+void count_cb (void *subscriber, void *arg)
+{
+    struct result *res = arg;
+    int i = (int *)subscriber - subs;
+
+    if (i >= 0 && i < NSUBS)
+        res->count[i]++;
+}
+
+/* Match 'topic', returning the number of subscribers matched, and fill
+ * 'res' with the number of times each subscriber was reported.
+ */
+int match (struct subtrie *st, const char *topic, struct result *res)
+{
+    memset (res, 0, sizeof (*res));
+    return subtrie_match (st, topic, count_cb, res);
+}
+
+void test_match (void)
+{
+    struct subtrie *st;
+    struct result res;
+
+    st = subtrie_create ();
+    ok (st != NULL,
+        "subtrie_create works");
+
+    ok (match (st, "foo", &res) == 0,
+        "empty subtrie matches nothing");
+
+    ok (subtrie_add (st, "foo", &subs[0]) == 0,
+        "subtrie_add foo sub0");
+    ok (subtrie_add (st, "foo.bar", &subs[1]) == 0,
+        "subtrie_add foo.bar sub1");
+    ok (subtrie_add (st, "", &subs[2]) == 0,
+        "subtrie_add \"\" sub2");
+    ok (subtrie_add (st, "bar", &subs[3]) == 0,
+        "subtrie_add bar sub3");
+
+    ok (match (st, "foo", &res) == 2
+        && res.count[0] == 1 && res.count[2] == 1,
+        "foo matches sub0 and sub2");
+    ok (match (st, "foobar", &res) == 2
+        && res.count[0] == 1 && res.count[2] == 1,
+        "foobar matches sub0 and sub2");
+    ok (match (st, "foo.bar.baz", &res) == 3
+        && res.count[0] == 1 && res.count[1] == 1 && res.count[2] == 1,
+        "foo.bar.baz matches sub0, sub1, and sub2");
+    ok (match (st, "fo", &res) == 1 && res.count[2] == 1,
+        "fo matches sub2 only");
+    ok (match (st, "", &res) == 1 && res.count[2] == 1,
+        "empty topic matches sub2 only");
+    ok (match (st, "bar", &res) == 2
+        && res.count[3] == 1 && res.count[2] == 1,
+        "bar matches sub2 and sub3");
+
+    ok (subtrie_match (st, "foo.bar", NULL, NULL) == 3,
+        "subtrie_match works with cb=NULL");
+
+    subtrie_destroy (st);
+}
+
+void test_overlap (void)
+{
+    struct subtrie *st;
+    struct result res;
+
+    if (!(st = subtrie_create ()))
+        BAIL_OUT ("subtrie_create failed");
+
+    ok (subtrie_add (st, "kvs", &subs[0]) == 0
+        && subtrie_add (st, "kvs.setroot", &subs[0]) == 0
+        && subtrie_add (st, "", &subs[0]) == 0,
+        "sub0 adds overlapping prefixes");
+    ok (match (st, "kvs.setroot-primary", &res) == 1 && res.count[0] == 1,
+        "sub0 is reported once when several prefixes match");
+    ok (match (st, "kvs.setroot-primary", &res) == 1 && res.count[0] == 1,
+        "and again on the next match");
+
+    subtrie_destroy (st);
+}
+
+void test_refcount (void)
+{
+    struct subtrie *st;
+    struct result res;
+
+    if (!(st = subtrie_create ()))
+        BAIL_OUT ("subtrie_create failed");
+
+    ok (subtrie_add (st, "foo", &subs[0]) == 0
+        && subtrie_add (st, "foo", &subs[0]) == 0,
+        "subtrie_add foo sub0 twice");
+    ok (subtrie_add (st, "foo", &subs[1]) == 0,
+        "subtrie_add foo sub1");
+
+    ok (subtrie_remove (st, "foo", &subs[0]) == 0,
+        "subtrie_remove foo sub0");
+    ok (match (st, "foo", &res) == 2 && res.count[0] == 1,
+        "sub0 still matches after one remove");
+    ok (subtrie_remove (st, "foo", &subs[0]) == 0,
+        "subtrie_remove foo sub0 (again)");
+    ok (match (st, "foo", &res) == 1 && res.count[1] == 1,
+        "sub0 no longer matches, sub1 still does");
+
+    errno = 0;
+    ok (subtrie_remove (st, "foo", &subs[0]) < 0 && errno == ENOENT,
+        "subtrie_remove foo sub0 (third time) fails with ENOENT");
+
+    ok (subtrie_remove (st, "foo", &subs[1]) == 0,
+        "subtrie_remove foo sub1");
+    ok (match (st, "foo", &res) == 0,
+        "foo matches nothing");
+
+    /* Removing a longer prefix must not disturb a shorter one on the
+     * same path, and vice versa.
+     */
+    ok (subtrie_add (st, "job", &subs[0]) == 0
+        && subtrie_add (st, "job-state", &subs[1]) == 0,
+        "subtrie_add job sub0, job-state sub1");
+    ok (subtrie_remove (st, "job-state", &subs[1]) == 0,
+        "subtrie_remove job-state sub1");
+    ok (match (st, "job-state", &res) == 1 && res.count[0] == 1,
+        "job-state matches sub0 only");
+    ok (subtrie_add (st, "job-state", &subs[1]) == 0
+        && subtrie_remove (st, "job", &subs[0]) == 0,
+        "re-add job-state sub1, remove job sub0");
+    ok (match (st, "job-state", &res) == 1 && res.count[1] == 1,
+        "job-state matches sub1 only");
+
+    subtrie_destroy (st);
+}
+
+void test_remove_subscriber (void)
+{
+    struct subtrie *st;
+    struct result res;
+
+    if (!(st = subtrie_create ()))
+        BAIL_OUT ("subtrie_create failed");
+
+    ok (subtrie_add (st, "a", &subs[0]) == 0
+        && subtrie_add (st, "a.b", &subs[0]) == 0
+        && subtrie_add (st, "a.b", &subs[0]) == 0
+        && subtrie_add (st, "c", &subs[0]) == 0
+        && subtrie_add (st, "a.b", &subs[1]) == 0,
+        "sub0 adds several prefixes, sub1 shares one");
+
+    subtrie_remove_subscriber (st, &subs[0]);
+    ok (match (st, "a.b", &res) == 1 && res.count[1] == 1,
+        "after subtrie_remove_subscriber sub0, a.b matches sub1 only");
+    ok (match (st, "c", &res) == 0,
+        "c matches nothing");
+    errno = 0;
+    ok (subtrie_remove (st, "a", &subs[0]) < 0 && errno == ENOENT,
+        "subtrie_remove a sub0 fails with ENOENT");
+
+    lives_ok ({subtrie_remove_subscriber (st, &subs[2]);},
+        "subtrie_remove_subscriber of unknown subscriber doesn't crash");
+
+    ok (subtrie_add (st, "a", &subs[0]) == 0,
+        "sub0 can subscribe again");
+    ok (match (st, "a.b", &res) == 2 && res.count[0] == 1,
+        "a.b matches sub0 again");
+
+    subtrie_destroy (st);
+}
+
+void test_errors (void)
+{
+    struct subtrie *st;
+
+    if (!(st = subtrie_create ()))
+        BAIL_OUT ("subtrie_create failed");
+
+    errno = 0;
+    ok (subtrie_add (NULL, "foo", &subs[0]) < 0 && errno == EINVAL,
+        "subtrie_add st=NULL fails with EINVAL");
+    errno = 0;
+    ok (subtrie_add (st, NULL, &subs[0]) < 0 && errno == EINVAL,
+        "subtrie_add prefix=NULL fails with EINVAL");
+    errno = 0;
+    ok (subtrie_add (st, "foo", NULL) < 0 && errno == EINVAL,
+        "subtrie_add subscriber=NULL fails with EINVAL");
+    errno = 0;
+    ok (subtrie_remove (NULL, "foo", &subs[0]) < 0 && errno == EINVAL,
+        "subtrie_remove st=NULL fails with EINVAL");
+    errno = 0;
+    ok (subtrie_remove (st, "foo", &subs[0]) < 0 && errno == ENOENT,
+        "subtrie_remove unknown subscriber fails with ENOENT");
+    ok (subtrie_add (st, "foo", &subs[0]) == 0,
+        "subtrie_add foo sub0");
+    errno = 0;
+    ok (subtrie_remove (st, "fo", &subs[0]) < 0 && errno == ENOENT,
+        "subtrie_remove fo sub0 (interior node) fails with ENOENT");
+    errno = 0;
+    ok (subtrie_remove (st, "foobar", &subs[0]) < 0 && errno == ENOENT,
+        "subtrie_remove foobar sub0 (no node) fails with ENOENT");
+
+    ok (subtrie_match (NULL, "foo", NULL, NULL) == 0,
+        "subtrie_match st=NULL returns 0");
+    ok (subtrie_match (st, NULL, NULL, NULL) == 0,
+        "subtrie_match topic=NULL returns 0");
+
+    lives_ok ({subtrie_destroy (NULL);},
+        "subtrie_destroy st=NULL doesn't crash");
+
+    subtrie_destroy (st);
+}
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    test_match ();
+    test_overlap ();
+    test_refcount ();
+    test_remove_subscriber ();
+    test_errors ();
+
+    done_testing ();
+
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,158 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <errno.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/common/librouter/threadq.h"
+
+#define NITEMS 100000
+
+static bool pollfd_ready (struct threadq *q, int timeout)
+{
+    struct pollfd pfd = { .fd = threadq_pollfd (q), .events = POLLIN };
+
+    return poll (&pfd, 1, timeout) == 1 && (pfd.revents & POLLIN);
+}
+
+void test_basic (void)
+{
+    struct threadq *q;
+    int item[3];
+
+    q = threadq_create ();
+    ok (q != NULL,
+        "threadq_create works");
+    ok (threadq_pollfd (q) >= 0,
+        "threadq_pollfd returns a valid fd");
+    ok (threadq_pop (q) == NULL,
+        "threadq_pop on empty queue returns NULL");
+    ok (threadq_peek (q) == NULL,
+        "threadq_peek on empty queue returns NULL");
+    ok (!pollfd_ready (q, 0),
+        "pollfd is not ready");
+
+    ok (threadq_push (q, &item[0]) == 0
+        && threadq_push (q, &item[1]) == 0
+        && threadq_push (q, &item[2]) == 0,
+        "threadq_push works three times");
+    ok (pollfd_ready (q, 0),
+        "pollfd is ready");
+    ok (threadq_peek (q) == &item[0] && threadq_peek (q) == &item[0],
+        "threadq_peek returns the oldest item without removing it");
+    threadq_clear (q);
+    ok (!pollfd_ready (q, 0),
+        "threadq_clear resets pollfd");
+    ok (threadq_pop (q) == &item[0]
+        && threadq_pop (q) == &item[1]
+        && threadq_pop (q) == &item[2]
+        && threadq_pop (q) == NULL,
+        "threadq_pop returns items in order");
+
+    ok (threadq_push (q, &item[0]) == 0 && pollfd_ready (q, 0),
+        "pollfd is ready after another push");
+    threadq_clear (q);
+    ok (threadq_pop (q) == &item[0],
+        "threadq_pop returns the item");
+
+    errno = 0;
+    ok (threadq_push (q, NULL) < 0 && errno == EINVAL,
+        "threadq_push item=NULL fails with EINVAL");
+    errno = 0;
+    ok (threadq_push (NULL, &item[0]) < 0 && errno == EINVAL,
+        "threadq_push q=NULL fails with EINVAL");
+    ok (threadq_pop (NULL) == NULL,
+        "threadq_pop q=NULL returns NULL");
+    ok (threadq_peek (NULL) == NULL,
+        "threadq_peek q=NULL returns NULL");
+    errno = 0;
+    ok (threadq_pollfd (NULL) < 0 && errno == EINVAL,
+        "threadq_pollfd q=NULL fails with EINVAL");
+    lives_ok ({threadq_clear (NULL);},
+        "threadq_clear q=NULL doesn't crash");
+
+    ok (threadq_push (q, &item[1]) == 0,
+        "pushed an item that won't be popped");
+    threadq_destroy (q);
+    lives_ok ({threadq_destroy (NULL);},
+        "threadq_destroy q=NULL doesn't crash");
+}
+
+static void *producer (void *arg)
+{
+    struct threadq *q = arg;
+    uintptr_t i;
+
+    for (i = 1; i <= NITEMS; i++) {
+        if (threadq_push (q, (void *)i) < 0)
+            BAIL_OUT ("threadq_push failed");
+    }
+    return NULL;
+}
+
+/* Consume from another thread the way a reactor callback would:
+ * wait for the pollfd, clear, then drain.
+ */
+void test_threads (void)
+{
+    struct threadq *q;
+    pthread_t t;
+    uintptr_t expect = 1;
+    uintptr_t i;
+    int wakeups = 0;
+    bool inorder = true;
+
+    if (!(q = threadq_create ()))
+        BAIL_OUT ("threadq_create failed");
+    if (pthread_create (&t, NULL, producer, q) != 0)
+        BAIL_OUT ("pthread_create failed");
+    while (expect <= NITEMS) {
+        if (!pollfd_ready (q, 5000))
+            break;
+        wakeups++;
+        threadq_clear (q);
+        while ((i = (uintptr_t)threadq_pop (q))) {
+            if (i != expect)
+                inorder = false;
+            expect++;
+        }
+    }
+    pthread_join (t, NULL);
+    ok (expect == NITEMS + 1 && inorder,
+        "consumer received %d items in order from producer thread",
+        NITEMS);
+    diag ("%d wakeups", wakeups);
+    ok (threadq_pop (q) == NULL,
+        "queue is empty");
+    threadq_destroy (q);
+}
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    test_basic ();
+    test_threads ();
+
+    done_testing ();
+
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
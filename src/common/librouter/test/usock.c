@@ -22,6 +22,7 @@
 #include "src/common/libtap/tap.h"
 #include "src/common/libutil/unlink_recursive.h"
 #include "src/common/librouter/usock.h"
+#include "src/common/librouter/sendfd.h"
 
 void tmpdir_destroy (const char *path)
 {
@@ -152,6 +153,19 @@ void conn_invalid (void)
     ok (usock_conn_create (r, 0, -1) == NULL && errno == EINVAL,
         "usock_conn_create outfd=-1 fails with EINVAL");
 
+    errno = 0;
+    ok (usock_conn_release (NULL) < 0 && errno == EINVAL,
+        "usock_conn_release conn=NULL fails with EINVAL");
+    errno = 0;
+    ok (usock_conn_release (conn) < 0 && errno == EINVAL,
+        "usock_conn_release fails with EINVAL on conn that doesn't own fds");
+    errno = 0;
+    ok (usock_conn_adopt (NULL, fd[0]) == NULL && errno == EINVAL,
+        "usock_conn_adopt r=NULL fails with EINVAL");
+    errno = 0;
+    ok (usock_conn_adopt (r, -1) == NULL && errno == EINVAL,
+        "usock_conn_adopt fd=-1 fails with EINVAL");
+
     usock_conn_destroy (conn);
     (void)close (fd[0]);
     (void)close (fd[1]);
@@ -225,6 +239,146 @@ void client_connect (void)
         "usock_client_connect path=/noexist (retry=capped) fails with ENOENT");
 }
 
+/* Queue a burst of messages to a connection, let the reactor flush them
+ * in coalesced writes, then ensure they arrive intact and in order.
+ */
+/* A released socket stays open when its conn is destroyed, and is
+ * closed when the adopting conn is destroyed.
+ */
+void conn_release (void)
+{
+    struct usock_conn *conn;
+    flux_reactor_t *r;
+    int fd[2];
+    int cfd;
+
+    if (!(r = flux_reactor_create (0)))
+        BAIL_OUT ("flux_reactor_create failed");
+    if (socketpair (PF_LOCAL, SOCK_STREAM, 0, fd) < 0)
+        BAIL_OUT ("socketpair failed");
+    if (!(conn = usock_conn_adopt (r, fd[0])))
+        BAIL_OUT ("usock_conn_adopt failed");
+    cfd = usock_conn_release (conn);
+    ok (cfd == fd[0],
+        "usock_conn_release returns the socket");
+    usock_conn_destroy (conn);
+    ok (fcntl (fd[0], F_GETFD) >= 0,
+        "socket is still open after destroying released conn");
+
+    if (!(conn = usock_conn_adopt (r, cfd)))
+        BAIL_OUT ("usock_conn_adopt failed");
+    usock_conn_destroy (conn);
+    errno = 0;
+    ok (fcntl (fd[0], F_GETFD) < 0 && errno == EBADF,
+        "socket is closed after destroying adopting conn");
+
+    (void)close (fd[1]);
+    flux_reactor_destroy (r);
+}
+
+void conn_batch (void)
+{
+    flux_reactor_t *r;
+    struct usock_conn *conn;
+    flux_msg_t *msg;
+    int fd[2];
+    int count = 100;
+    int errors = 0;
+    int i;
+
+    if (!(r = flux_reactor_create (0)))
+        BAIL_OUT ("flux_reactor_create failed");
+    if (socketpair (PF_LOCAL, SOCK_STREAM, 0, fd) < 0)
+        BAIL_OUT ("socketpair failed");
+    if (!(conn = usock_conn_create (r, fd[0], fd[0])))
+        BAIL_OUT ("usock_conn_create failed");
+    for (i = 0; i < count; i++) {
+        char topic[32];
+        snprintf (topic, sizeof (topic), "foo.%d", i);
+        if (!(msg = flux_request_encode (topic, NULL)))
+            BAIL_OUT ("flux_request_encode failed");
+        if (usock_conn_send (conn, msg) < 0)
+            errors++;
+        flux_msg_destroy (msg);
+    }
+    ok (errors == 0,
+        "usock_conn_send queued %d messages", count);
+    ok (flux_reactor_run (r, 0) >= 0,
+        "reactor ran until output queue was flushed");
+
+    errors = 0;
+    for (i = 0; i < count; i++) {
+        char topic[32];
+        const char *s;
+        snprintf (topic, sizeof (topic), "foo.%d", i);
+        if (!(msg = recvfd (fd[1], NULL))
+            || flux_msg_get_topic (msg, &s) < 0
+            || strcmp (s, topic) != 0)
+            errors++;
+        flux_msg_destroy (msg);
+    }
+    ok (errors == 0,
+        "%d messages were received in order", count);
+
+    usock_conn_destroy (conn);
+    (void)close (fd[0]);
+    (void)close (fd[1]);
+    flux_reactor_destroy (r);
+}
+
+static void hwm_error_cb (struct usock_conn *conn, int errnum, void *arg)
+{
+    int *errp = arg;
+
+    *errp = errnum;
+    usock_conn_destroy (conn);
+}
+
+void conn_hwm (void)
+{
+    flux_reactor_t *r;
+    struct usock_conn *conn;
+    flux_msg_t *msg;
+    int fd[2];
+    int errnum = 0;
+
+    if (!(r = flux_reactor_create (0)))
+        BAIL_OUT ("flux_reactor_create failed");
+    if (socketpair (PF_LOCAL, SOCK_STREAM, 0, fd) < 0)
+        BAIL_OUT ("socketpair failed");
+    if (!(conn = usock_conn_create (r, fd[0], fd[0])))
+        BAIL_OUT ("usock_conn_create failed");
+    if (!(msg = flux_request_encode ("foo.bar", NULL)))
+        BAIL_OUT ("flux_request_encode failed");
+
+    usock_conn_set_hwm (conn, 0);
+    ok (usock_conn_send (conn, msg) == 0
+        && usock_conn_send (conn, msg) == 0
+        && usock_conn_send (conn, msg) == 0,
+        "usock_conn_send works with hwm=0 (unlimited)");
+    ok (flux_reactor_run (r, 0) >= 0,
+        "reactor ran until output queue was flushed");
+
+    usock_conn_set_error_cb (conn, hwm_error_cb, &errnum);
+    usock_conn_set_hwm (conn, 2);
+    ok (usock_conn_send (conn, msg) == 0
+        && usock_conn_send (conn, msg) == 0,
+        "usock_conn_send works up to hwm");
+    errno = 0;
+    ok (usock_conn_send (conn, msg) < 0 && errno == ENOBUFS,
+        "usock_conn_send fails with ENOBUFS at hwm");
+    errno = 0;
+    ok (usock_conn_send (conn, msg) < 0 && errno == ENOBUFS,
+        "usock_conn_send continues to fail after overflow");
+    ok (flux_reactor_run (r, 0) >= 0 && errnum == ENOBUFS,
+        "connection failed with ENOBUFS from the reactor");
+
+    flux_msg_destroy (msg);
+    (void)close (fd[0]);
+    (void)close (fd[1]);
+    flux_reactor_destroy (r);
+}
+
 int main (int argc, char *argv[])
 {
     char tmpdir[PATH_MAX + 1];
@@ -236,7 +390,10 @@ int main (int argc, char *argv[])
 
     server_invalid ();
     conn_invalid ();
+    conn_release ();
     client_invalid ();
+    conn_batch ();
+    conn_hwm ();
 
     client_connect();
 
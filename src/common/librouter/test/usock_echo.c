@@ -51,8 +51,31 @@ static void tmpdir_create (void)
     diag ("mkdir %s", tmpdir);
 }
 
+/* Handle "shmem.attach" request by switching connection to shared memory.
+ * The response goes through the rings on success, the socket on failure.
+ */
+static void server_shmem_attach (struct usock_conn *conn, flux_msg_t *msg)
+{
+    flux_msg_t *rmsg;
+    int errnum = 0;
+
+    if (usock_conn_attach_shmring (conn) < 0)
+        errnum = errno;
+    if (!(rmsg = flux_response_derive (msg, errnum))
+        || usock_conn_send (conn, rmsg) < 0)
+        diag ("shmem.attach response failed: %s", flux_strerror (errno));
+    flux_msg_destroy (rmsg);
+}
+
 static void server_recv_cb (struct usock_conn *conn, flux_msg_t *msg, void *arg)
 {
+    const char *topic;
+
+    if (flux_msg_get_topic (msg, &topic) == 0
+        && !strcmp (topic, "shmem.attach")) {
+        server_shmem_attach (conn, msg);
+        return;
+    }
     if (usock_conn_send (conn, msg) < 0)
         diag ("usock_conn_send failed: %s", flux_strerror (errno));
 }
@@ -208,6 +231,99 @@ static void test_one_echo (flux_t *h)
     flux_msg_destroy (msg);
 }
 
+/* Attach shared memory rings, then echo messages larger and smaller
+ * than the ring size through them.
+ */
+static void test_shmem_echo (flux_t *h)
+{
+    char sockpath[PATH_MAX + 1];
+    flux_msg_t *req;
+    struct shmring *ring;
+    int fd;
+    struct usock_client *client;
+    int sizes[] = { 0, 1024, 4096, 65536, 1048576 };
+
+    if (snprintf (sockpath,
+                  sizeof (sockpath),
+                  "%s/server",
+                  tmpdir) >= sizeof (sockpath))
+        BAIL_OUT ("buffer overflow");
+    fd = usock_client_connect (sockpath, USOCK_RETRY_DEFAULT);
+    if (fd < 0)
+        BAIL_OUT ("usock_client_connect failed");
+    if (!(client = usock_client_create (fd)))
+        BAIL_OUT ("usock_client_create failed");
+    if (!(req = flux_request_encode ("shmem.attach", NULL)))
+        BAIL_OUT ("flux_request_encode failed");
+    ok ((ring = shmring_create (16384)) != NULL,
+        "shmring_create works");
+    ok (usock_client_attach_shmring (client, ring, req) == 0,
+        "usock_client_attach_shmring works");
+    ok (usock_client_pollfd (client) != fd,
+        "usock_client_pollfd no longer returns socket fd");
+
+    for (int i = 0; i < sizeof (sizes) / sizeof (sizes[0]); i++) {
+        flux_msg_t *msg;
+        flux_msg_t *rmsg;
+        char *buf;
+
+        if (!(buf = calloc (1, sizes[i] + 1)))
+            BAIL_OUT ("calloc failed");
+        memset (buf, 0xf0, sizes[i]);
+        if (!(msg = flux_request_encode_raw ("a", buf, sizes[i])))
+            BAIL_OUT ("flux_request_encode_raw failed");
+        ok (usock_client_send (client, msg, 0) == 0
+            && (rmsg = usock_client_recv (client, 0)) != NULL
+            && equal_message (msg, rmsg),
+            "echoed size=%d message over shmem", sizes[i]);
+        flux_msg_destroy (rmsg);
+        flux_msg_destroy (msg);
+        free (buf);
+    }
+
+    usock_client_destroy (client); // destroys ring
+    (void)close (fd);
+    flux_msg_destroy (req);
+}
+
+/* Attach fails if the request carries no fds.  Client continues on socket.
+ */
+static void test_shmem_attach_fail (flux_t *h)
+{
+    char sockpath[PATH_MAX + 1];
+    flux_msg_t *req;
+    flux_msg_t *rmsg;
+    int fd;
+    struct usock_client *client;
+
+    if (snprintf (sockpath,
+                  sizeof (sockpath),
+                  "%s/server",
+                  tmpdir) >= sizeof (sockpath))
+        BAIL_OUT ("buffer overflow");
+    fd = usock_client_connect (sockpath, USOCK_RETRY_DEFAULT);
+    if (fd < 0)
+        BAIL_OUT ("usock_client_connect failed");
+    if (!(client = usock_client_create (fd)))
+        BAIL_OUT ("usock_client_create failed");
+    if (!(req = flux_request_encode ("shmem.attach", NULL)))
+        BAIL_OUT ("flux_request_encode failed");
+
+    ok (usock_client_send (client, req, 0) == 0
+        && (rmsg = usock_client_recv (client, 0)) != NULL,
+        "shmem.attach request without fds got a response on socket");
+    errno = 0;
+    ok (flux_response_decode (rmsg, NULL, NULL) < 0 && errno == EPROTO,
+        "and it is an EPROTO error");
+    flux_msg_destroy (rmsg);
+    ok (usock_client_pollfd (client) == fd,
+        "usock_client_pollfd still returns socket fd");
+
+    usock_client_destroy (client);
+    (void)close (fd);
+    flux_msg_destroy (req);
+}
+
 struct async_ctx {
     flux_reactor_t *r;
     flux_msg_t *msg;
@@ -304,6 +420,8 @@ int main (int argc, char *argv[])
     test_async_stream (h, 4096, 256);
     test_async_stream (h, 16384, 64);
     test_async_stream (h, 1048576, 1);
+    test_shmem_echo (h);
+    test_shmem_attach_fail (h);
 
     diag ("stopping test server");
     if (test_server_stop (h) < 0)
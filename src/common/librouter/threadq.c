@@ -0,0 +1,158 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* threadq.c - single-producer, single-consumer queue between threads
+ *
+ * The queue is a singly linked list that always holds at least one node.
+ * The first node is a "stub" whose item has already been consumed.  The
+ * producer only touches 'tail' and the consumer only touches 'head', so
+ * the one shared field is the 'next' pointer of the last node, which is
+ * published with a release store and read with an acquire load.
+ *
+ * Wakeups: 'signaled' is set by the producer when it writes the eventfd,
+ * and cleared by the consumer before it drains the queue.  The producer
+ * writes the eventfd only if it finds 'signaled' clear, so once the
+ * consumer has been woken, further pushes are free until it catches up.
+ * Both sides use an atomic exchange on 'signaled', so an item pushed
+ * before the consumer's exchange is visible to its drain, and an item
+ * pushed after it triggers a new wakeup.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <errno.h>
+
+#include "threadq.h"
+
+struct threadq_node {
+    struct threadq_node *next;
+    void *item;
+};
+
+struct threadq {
+    struct threadq_node *head;  // consumer: stub node
+    struct threadq_node *tail;  // producer: last node
+    int signaled;
+    int fd;
+};
+
+int threadq_push (struct threadq *q, void *item)
+{
+    struct threadq_node *node;
+
+    if (!q || !item) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!(node = malloc (sizeof (*node))))
+        return -1;
+    node->next = NULL;
+    node->item = item;
+    __atomic_store_n (&q->tail->next, node, __ATOMIC_RELEASE);
+    q->tail = node;
+    if (!__atomic_exchange_n (&q->signaled, 1, __ATOMIC_SEQ_CST)) {
+        uint64_t val = 1;
+        (void)write (q->fd, &val, sizeof (val));
+    }
+    return 0;
+}
+
+void *threadq_pop (struct threadq *q)
+{
+    struct threadq_node *next;
+    void *item;
+
+    if (!q)
+        return NULL;
+    if (!(next = __atomic_load_n (&q->head->next, __ATOMIC_ACQUIRE)))
+        return NULL;
+    item = next->item;
+    next->item = NULL;
+    free (q->head);
+    q->head = next;
+    return item;
+}
+
+void *threadq_peek (struct threadq *q)
+{
+    struct threadq_node *next;
+
+    if (!q)
+        return NULL;
+    if (!(next = __atomic_load_n (&q->head->next, __ATOMIC_ACQUIRE)))
+        return NULL;
+    return next->item;
+}
+
+int threadq_pollfd (struct threadq *q)
+{
+    if (!q) {
+        errno = EINVAL;
+        return -1;
+    }
+    return q->fd;
+}
+
+void threadq_clear (struct threadq *q)
+{
+    if (q) {
+        uint64_t val;
+
+        /* N.B. read even if 'signaled' was clear: the producer may have
+         * set it but not yet written the eventfd on the last clear.
+         */
+        (void)__atomic_exchange_n (&q->signaled, 0, __ATOMIC_SEQ_CST);
+        (void)read (q->fd, &val, sizeof (val));
+    }
+}
+
+void threadq_destroy (struct threadq *q)
+{
+    if (q) {
+        int saved_errno = errno;
+        struct threadq_node *node;
+
+        while ((node = q->head)) {
+            q->head = node->next;
+            free (node);
+        }
+        if (q->fd >= 0)
+            (void)close (q->fd);
+        free (q);
+        errno = saved_errno;
+    }
+}
+
+struct threadq *threadq_create (void)
+{
+    struct threadq *q;
+
+    if (!(q = calloc (1, sizeof (*q))))
+        return NULL;
+    q->fd = -1;
+    if (!(q->head = calloc (1, sizeof (*q->head))))
+        goto error;
+    q->tail = q->head;
+    if ((q->fd = eventfd (0, EFD_NONBLOCK | EFD_CLOEXEC)) < 0)
+        goto error;
+    return q;
+error:
+    threadq_destroy (q);
+    return NULL;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,61 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _ROUTER_THREADQ_H
+#define _ROUTER_THREADQ_H
+
+/* threadq - unbounded single-producer, single-consumer queue of pointers
+ * between two threads, with an eventfd wakeup for the consumer's reactor.
+ *
+ * Push and pop are lock-free.  The producer writes the eventfd only when
+ * the consumer may be waiting, so a busy queue costs no syscalls.
+ *
+ * Consumer usage: watch threadq_pollfd() for FLUX_POLLIN, and in the
+ * callback, call threadq_clear() and then threadq_pop() until it
+ * returns NULL.
+ */
+
+struct threadq;
+
+struct threadq *threadq_create (void);
+
+/* Free the queue.  Any items still queued are not freed: the caller
+ * should pop them first.
+ */
+void threadq_destroy (struct threadq *q);
+
+/* Producer: append 'item' (non-NULL) to the queue.
+ * Returns 0 on success, -1 with errno set (EINVAL, ENOMEM).
+ */
+int threadq_push (struct threadq *q, void *item);
+
+/* Consumer: remove and return the oldest item, or NULL if empty.
+ */
+void *threadq_pop (struct threadq *q);
+
+/* Consumer: return the oldest item without removing it, or NULL if empty.
+ */
+void *threadq_peek (struct threadq *q);
+
+/* Consumer: get the wakeup eventfd.  It becomes readable once an item
+ * has been pushed since the last threadq_clear().
+ */
+int threadq_pollfd (struct threadq *q);
+
+/* Consumer: reset the wakeup.  Call before draining the queue, so that
+ * an item pushed during the drain causes another wakeup.
+ */
+void threadq_clear (struct threadq *q);
+
+#endif /* !_ROUTER_THREADQ_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -29,6 +29,17 @@
  *
  * Sending/receiving messages from client:
  * - usock_conn_send() adds a message to a queue, starts fd (write) watcher.
+ * - When the fd becomes writable, queued messages are framed into a single
+ *   output buffer (up to USOCK_BATCH_SIZE bytes) and written with one
+ *   write(2), so a burst of messages to one client costs few syscalls.
+ * - usock_conn_attach_shmring() switches a connection to shared memory
+ *   rings, using file descriptors the client passed with its last message
+ *   (SCM_RIGHTS).  After that, all messages in both directions go through
+ *   the rings.  The socket is retained only to detect disconnect.
+ * - usock_conn_set_hwm() limits the number of queued messages.  Once the
+ *   limit is reached, usock_conn_send() fails with ENOBUFS, input from the
+ *   client stops, and the connection fails with ENOBUFS from the reactor,
+ *   so the client sees a disconnect rather than silently lost messages.
  * - Register a receive callback to receive complete messages from client.
  * - Register an error callback to be notified when I/O errors occur.
  */
@@ -39,6 +50,7 @@
 #include <sys/un.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
+#include <sys/epoll.h>
 #include <poll.h>
 #include <unistd.h>
 #include <errno.h>
@@ -57,6 +69,15 @@
 
 #define LISTEN_BACKLOG 5
 
+/* Output is coalesced into a buffer of about this size.  A single message
+ * larger than this is allowed, but the buffer is released after it is sent.
+ */
+#define USOCK_BATCH_SIZE (64*1024)
+
+/* Max file descriptors accepted from a client via SCM_RIGHTS.
+ */
+#define USOCK_MAX_RXFDS SHMRING_FD_COUNT
+
 #ifndef UUID_STR_LEN
 #define UUID_STR_LEN 37     // defined in later libuuid headers
 #endif
@@ -74,7 +95,14 @@ struct usock_server {
 struct usock_io {
     int fd;
     flux_watcher_t *w;
-    struct iobuf iobuf;
+    struct iobuf iobuf; // unused for output - see struct usock_outbuf
+};
+
+struct usock_outbuf {
+    uint8_t *buf;
+    size_t size;        // allocated size
+    size_t len;         // bytes of framed messages in buf
+    size_t done;        // bytes of buf already written
 };
 
 struct usock_conn {
@@ -82,6 +110,17 @@ struct usock_conn {
     struct usock_io in;
     struct usock_io out;
     zlist_t *outqueue;
+    struct usock_outbuf outbuf;
+    int hwm;
+    flux_watcher_t *overflow_w;
+
+    int rxfds[USOCK_MAX_RXFDS];
+    int rxfd_count;
+
+    flux_reactor_t *r;
+    struct shmring *ring;
+    flux_watcher_t *ring_w;
+    struct iobuf ring_iobuf;
 
     usock_conn_close_f close_cb;
     void *close_arg;
@@ -106,6 +145,8 @@ struct usock_client {
     int fd;
     struct iobuf in_iobuf;
     struct iobuf out_iobuf;
+    struct shmring *ring;
+    int epfd;               // socket + ring wakeup, when ring is attached
 };
 
 const struct flux_msg_cred *usock_conn_get_cred (struct usock_conn *conn)
@@ -180,21 +221,115 @@ static void conn_io_error (struct usock_conn *conn, int errnum)
     }
 }
 
+static int conn_ring_flush (struct usock_conn *conn);
+
+void usock_conn_set_hwm (struct usock_conn *conn, int hwm)
+{
+    if (conn)
+        conn->hwm = hwm > 0 ? hwm : 0;
+}
+
+/* The output queue overflowed.  The connection fails from this callback
+ * rather than from usock_conn_send(), which is called from contexts where
+ * the connection may not be destroyed.
+ */
+static void conn_overflow_cb (flux_reactor_t *r,
+                              flux_watcher_t *w,
+                              int revents,
+                              void *arg)
+{
+    struct usock_conn *conn = arg;
+
+    conn_io_error (conn, ENOBUFS);
+}
+
+static int conn_overflow (struct usock_conn *conn)
+{
+    if (!conn->overflow_w) {
+        if (!(conn->overflow_w = flux_timer_watcher_create (conn->r,
+                                                            0.,
+                                                            0.,
+                                                            conn_overflow_cb,
+                                                            conn)))
+            return -1;
+        flux_watcher_stop (conn->in.w);
+        flux_watcher_stop (conn->ring_w);
+        flux_watcher_start (conn->overflow_w);
+    }
+    errno = ENOBUFS;
+    return -1;
+}
+
 int usock_conn_send (struct usock_conn *conn, const flux_msg_t *msg)
 {
     if (!conn || !msg) {
         errno = EINVAL;
         return -1;
     }
+    if (conn->overflow_w
+        || (conn->hwm > 0 && zlist_size (conn->outqueue) >= conn->hwm))
+        return conn_overflow (conn);
     if (zlist_append (conn->outqueue, (void *)flux_msg_incref (msg)) < 0) {
         flux_msg_decref (msg);
         errno = ENOMEM;
         return -1;
     }
+    if (conn->ring)
+        return conn_ring_flush (conn);
     flux_watcher_start (conn->out.w);
     return 0;
 }
 
+static void conn_rxfds_close (struct usock_conn *conn)
+{
+    while (conn->rxfd_count > 0)
+        (void)close (conn->rxfds[--conn->rxfd_count]);
+}
+
+/* iobuf_read_f for the connection socket.  Use recvmsg() so that file
+ * descriptors passed by the client are captured.  Any fds that arrive
+ * replace those that were received earlier.  Fall back to read() if
+ * the input fd is not a socket (e.g. a pre-wired pipe).
+ */
+static ssize_t conn_read (void *arg, void *buf, size_t len)
+{
+    struct usock_conn *conn = arg;
+    struct iovec iov = { .iov_base = buf, .iov_len = len };
+    union {
+        struct cmsghdr hdr;
+        char buf[CMSG_SPACE (sizeof (int) * USOCK_MAX_RXFDS)];
+    } control;
+    struct msghdr mh = {
+        .msg_iov = &iov,
+        .msg_iovlen = 1,
+        .msg_control = &control,
+        .msg_controllen = sizeof (control),
+    };
+    struct cmsghdr *cmsg;
+    ssize_t n;
+
+    if ((n = recvmsg (conn->in.fd, &mh, MSG_CMSG_CLOEXEC)) < 0) {
+        if (errno == ENOTSOCK)
+            return read (conn->in.fd, buf, len);
+        return -1;
+    }
+    for (cmsg = CMSG_FIRSTHDR (&mh); cmsg; cmsg = CMSG_NXTHDR (&mh, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+            int *fds = (int *)CMSG_DATA (cmsg);
+            int count = (cmsg->cmsg_len - CMSG_LEN (0)) / sizeof (int);
+
+            conn_rxfds_close (conn);
+            for (int i = 0; i < count; i++) {
+                if (conn->rxfd_count < USOCK_MAX_RXFDS)
+                    conn->rxfds[conn->rxfd_count++] = fds[i];
+                else
+                    (void)close (fds[i]);
+            }
+        }
+    }
+    return n;
+}
+
 static void conn_read_cb (flux_reactor_t *r,
                           flux_watcher_t *w,
                           int revents,
@@ -209,7 +344,7 @@ static void conn_read_cb (flux_reactor_t *r,
     if ((revents & FLUX_POLLIN)) {
         flux_msg_t *msg;
 
-        if (!(msg = recvfd (conn->in.fd, &conn->in.iobuf))) {
+        if (!(msg = iobuf_recv (conn_read, conn, &conn->in.iobuf))) {
             if (errno != EWOULDBLOCK && errno != EAGAIN)
                 goto error;
         }
@@ -238,12 +373,54 @@ static int conn_outqueue_drop (struct usock_conn *conn)
     return 1;
 }
 
+static void conn_outbuf_clean (struct usock_conn *conn)
+{
+    free (conn->outbuf.buf);
+    memset (&conn->outbuf, 0, sizeof (conn->outbuf));
+}
+
+/* Move messages from the output queue into the (empty) output buffer,
+ * framed as sendfd() would write them, until the queue is empty or
+ * the buffer reaches USOCK_BATCH_SIZE.  At least one message is moved,
+ * if available, regardless of its size.
+ */
+static int conn_outbuf_fill (struct usock_conn *conn)
+{
+    struct usock_outbuf *ob = &conn->outbuf;
+    const flux_msg_t *msg;
+
+    ob->len = ob->done = 0;
+    while ((msg = zlist_head (conn->outqueue))) {
+        size_t size = sendfd_frame_size (msg);
+
+        if (ob->len > 0 && ob->len + size > USOCK_BATCH_SIZE)
+            break;
+        if (ob->len + size > ob->size) {
+            size_t newsize = ob->len + size;
+            uint8_t *newbuf;
+
+            if (newsize < USOCK_BATCH_SIZE)
+                newsize = USOCK_BATCH_SIZE;
+            if (!(newbuf = realloc (ob->buf, newsize)))
+                return -1;
+            ob->buf = newbuf;
+            ob->size = newsize;
+        }
+        if (sendfd_frame (msg, ob->buf + ob->len, size) < 0)
+            return -1;
+        ob->len += size;
+        (void) conn_outqueue_drop (conn);
+    }
+    return 0;
+}
+
 static void conn_write_cb (flux_reactor_t *r,
                            flux_watcher_t *w,
                            int revents,
                            void *arg)
 {
     struct usock_conn *conn = arg;
+    struct usock_outbuf *ob = &conn->outbuf;
 
     if ((revents & FLUX_POLLERR)) {
         errno = EIO;
@@ -251,9 +428,16 @@ static void conn_write_cb (flux_reactor_t *r,
     }
 
     if ((revents & FLUX_POLLOUT)) {
-        const flux_msg_t *msg = zlist_head (conn->outqueue);
-        if (msg) {
-            if (sendfd (conn->out.fd, msg, &conn->out.iobuf) < 0) {
+        ssize_t n;
+
+        if (ob->done == ob->len) {
+            if (conn_outbuf_fill (conn) < 0)
+                goto error;
+        }
+        if (ob->done < ob->len) {
+            if ((n = write (conn->out.fd,
+                            ob->buf + ob->done,
+                            ob->len - ob->done)) < 0) {
                 if (errno == EPIPE) {
                     /* Remote peer has closed connection.
                      * However, there may still be pending messages sent
@@ -264,16 +448,20 @@ static void conn_write_cb (flux_reactor_t *r,
                      */
                     while (conn_outqueue_drop (conn))
                         ;
+                    conn_outbuf_clean (conn);
                     flux_watcher_stop (conn->out.w);
                 }
                 else if (errno != EWOULDBLOCK && errno != EAGAIN)
                     goto error;
+                return;
             }
-            else {
-                (void) conn_outqueue_drop (conn);
-                if (zlist_size (conn->outqueue) == 0)
-                    flux_watcher_stop (conn->out.w);
-            }
+            ob->done += n;
+        }
+        if (ob->done == ob->len) {
+            if (ob->size > USOCK_BATCH_SIZE)
+                conn_outbuf_clean (conn);
+            if (zlist_size (conn->outqueue) == 0)
+                flux_watcher_stop (conn->out.w);
         }
     }
     return;
@@ -281,6 +469,131 @@ error:
     conn_io_error (conn, errno);
 }
 
+static ssize_t ring_write (void *arg, const void *buf, size_t len)
+{
+    return shmring_write (arg, buf, len);
+}
+
+static ssize_t ring_read (void *arg, void *buf, size_t len)
+{
+    return shmring_read (arg, buf, len);
+}
+
+/* Copy queued output into the shared memory ring until the queue is empty
+ * or the ring is full.  In the latter case, the ring wakes us when
+ * the client has made space.
+ */
+static int conn_ring_flush (struct usock_conn *conn)
+{
+    struct usock_outbuf *ob = &conn->outbuf;
+    ssize_t n;
+
+    for (;;) {
+        if (ob->done == ob->len) {
+            if (ob->size > USOCK_BATCH_SIZE)
+                conn_outbuf_clean (conn);
+            if (zlist_size (conn->outqueue) == 0)
+                break;
+            if (conn_outbuf_fill (conn) < 0)
+                return -1;
+        }
+        if ((n = shmring_write (conn->ring,
+                                ob->buf + ob->done,
+                                ob->len - ob->done)) < 0) {
+            if (errno == EWOULDBLOCK || errno == EAGAIN)
+                break;
+            return -1;
+        }
+        ob->done += n;
+    }
+    return 0;
+}
+
+/* The client signaled that it wrote messages to the ring, or that it
+ * made space in the ring for queued output.
+ * N.B. recv_cb must not destroy the connection.
+ */
+static void conn_ring_cb (flux_reactor_t *r,
+                          flux_watcher_t *w,
+                          int revents,
+                          void *arg)
+{
+    struct usock_conn *conn = arg;
+    flux_msg_t *msg;
+
+    shmring_clear (conn->ring);
+    if ((shmring_pollevents (conn->ring) & POLLERR)) {
+        errno = EPROTO;
+        goto error;
+    }
+    if (conn_ring_flush (conn) < 0)
+        goto error;
+    while ((msg = iobuf_recv (ring_read, conn->ring, &conn->ring_iobuf))) {
+        if (auth_init_message (msg, &conn->cred) < 0) {
+            flux_msg_destroy (msg);
+            goto error;
+        }
+        if (conn->recv_cb)
+            conn->recv_cb (conn, msg, conn->recv_arg);
+        flux_msg_destroy (msg);
+    }
+    if (errno != EWOULDBLOCK && errno != EAGAIN)
+        goto error;
+    return;
+error:
+    conn_io_error (conn, errno);
+}
+
+int usock_conn_attach_shmring (struct usock_conn *conn)
+{
+    struct shmring *ring;
+
+    if (!conn) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (conn->ring) {
+        errno = EEXIST;
+        goto error;
+    }
+    if (conn->rxfd_count != SHMRING_FD_COUNT) {
+        errno = EPROTO;
+        goto error;
+    }
+    /* Socket output must be idle so that switching to the ring cannot
+     * reorder messages.
+     */
+    if (zlist_size (conn->outqueue) > 0
+        || conn->outbuf.done < conn->outbuf.len) {
+        errno = EBUSY;
+        goto error;
+    }
+    if (!(ring = shmring_attach (conn->rxfds)))
+        goto error;
+    conn->rxfd_count = 0; // ring owns fds now
+    if (!(conn->ring_w = flux_fd_watcher_create (conn->r,
+                                                 shmring_pollfd (ring),
+                                                 FLUX_POLLIN,
+                                                 conn_ring_cb,
+                                                 conn))) {
+        shmring_destroy (ring);
+        return -1;
+    }
+    conn->ring = ring;
+    iobuf_init (&conn->ring_iobuf);
+    flux_watcher_stop (conn->out.w);
+    flux_watcher_start (conn->ring_w);
+    /* Arm the reader wakeup.  The client does not write to the ring until
+     * it has received the response to its attach request, so nothing can
+     * be pending yet.
+     */
+    (void)shmring_pollevents (conn->ring);
+    return 0;
+error:
+    ERRNO_SAFE_WRAP (conn_rxfds_close, conn);
+    return -1;
+}
+
 static int write_char (int fd, unsigned char c)
 {
     return write (fd, &c, 1);
@@ -338,7 +651,12 @@ void usock_conn_destroy (struct usock_conn *conn)
             zlist_destroy (&conn->outqueue);
         }
         flux_watcher_destroy (conn->out.w);
-        iobuf_clean (&conn->out.iobuf);
+        conn_outbuf_clean (conn);
+        flux_watcher_destroy (conn->ring_w);
+        flux_watcher_destroy (conn->overflow_w);
+        iobuf_clean (&conn->ring_iobuf);
+        shmring_destroy (conn->ring);
+        conn_rxfds_close (conn);
         if (conn->server)
             zlist_remove (conn->server->connections, conn);
         if (conn->enable_close_on_destroy) {
@@ -419,6 +737,7 @@ struct usock_conn *usock_conn_create (flux_reactor_t *r, int infd, int outfd)
 
     conn->in.fd = infd;
     conn->out.fd = outfd;
+    conn->r = r;
     conn->cred.userid = FLUX_USERID_UNKNOWN;
     conn->cred.rolemask = FLUX_ROLE_NONE;
 
@@ -436,7 +755,6 @@ struct usock_conn *usock_conn_create (flux_reactor_t *r, int infd, int outfd)
                                                 conn_write_cb,
                                                 conn)))
         goto error;
-    iobuf_init (&conn->out.iobuf);
     uuid_generate (conn->uuid);
     uuid_unparse (conn->uuid, conn->uuid_str);
 
@@ -450,6 +768,28 @@ error:
     return NULL;
 }
 
+struct usock_conn *usock_conn_adopt (flux_reactor_t *r, int fd)
+{
+    struct usock_conn *conn;
+
+    if (!(conn = usock_conn_create (r, fd, fd)))
+        return NULL;
+    conn->enable_close_on_destroy = 1;
+    return conn;
+}
+
+int usock_conn_release (struct usock_conn *conn)
+{
+    if (!conn
+        || !conn->enable_close_on_destroy
+        || conn->in.fd != conn->out.fd) {
+        errno = EINVAL;
+        return -1;
+    }
+    conn->enable_close_on_destroy = 0;
+    return conn->in.fd;
+}
+
 static struct usock_conn *server_accept (struct usock_server *server,
                                          flux_reactor_t *r)
 {
@@ -548,6 +888,57 @@ static bool is_poll_error (int revents)
     return false;
 }
 
+/* With a ring attached, the server sends nothing more on the socket,
+ * so socket readability indicates EOF or error.
+ */
+static int client_ring_pollevents (struct usock_client *client)
+{
+    struct pollfd pfd;
+    int revents;
+    int flux_revents = 0;
+
+    pfd.fd = client->fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+
+    if (poll (&pfd, 1, 0) < 0)
+        return FLUX_POLLERR;
+    if ((pfd.revents & POLLIN) || is_poll_error (pfd.revents))
+        flux_revents |= FLUX_POLLERR;
+
+    revents = shmring_pollevents (client->ring);
+    if ((revents & POLLIN))
+        flux_revents |= FLUX_POLLIN;
+    if ((revents & POLLOUT))
+        flux_revents |= FLUX_POLLOUT;
+    if ((revents & POLLERR))
+        flux_revents |= FLUX_POLLERR;
+
+    return flux_revents;
+}
+
+/* Block until the ring wakes us, or the socket indicates EOF/error.
+ */
+static int client_ring_wait (struct usock_client *client)
+{
+    struct pollfd pfd[2];
+
+    memset (pfd, 0, sizeof (pfd));
+    pfd[0].fd = client->fd;
+    pfd[0].events = POLLIN;
+    pfd[1].fd = shmring_pollfd (client->ring);
+    pfd[1].events = POLLIN;
+
+    if (poll (pfd, 2, -1) < 0)
+        return -1;
+    if ((pfd[0].revents & POLLIN) || is_poll_error (pfd[0].revents)) {
+        errno = ECONNRESET;
+        return -1;
+    }
+    shmring_clear (client->ring);
+    return 0;
+}
+
 /* Check which events are pending events on client fd (non-blocking).
  * If none are pending, return 0.  If an error occurred, return FLUX_POLLERR.
  * N.B. see op->pollevents in libflux/connector.h
@@ -557,6 +948,9 @@ int usock_client_pollevents (struct usock_client *client)
     struct pollfd pfd;
     int flux_revents = 0;
 
+    if (client->ring)
+        return client_ring_pollevents (client);
+
     pfd.fd = client->fd;
     pfd.events = POLLIN | POLLOUT;
     pfd.revents = 0;
@@ -579,6 +973,8 @@ int usock_client_pollevents (struct usock_client *client)
  */
 int usock_client_pollfd (struct usock_client *client)
 {
+    if (client->ring)
+        return client->epfd;
     return client->fd;
 }
 
@@ -610,6 +1006,20 @@ int usock_client_send (struct usock_client *client,
                        const flux_msg_t *msg,
                        int flags)
 {
+    if (client->ring) {
+        while (iobuf_send (ring_write,
+                           client->ring,
+                           msg,
+                           &client->out_iobuf) < 0) {
+            if (errno != EWOULDBLOCK && errno != EAGAIN)
+                return -1;
+            if ((flags & FLUX_O_NONBLOCK))
+                return -1;
+            if (client_ring_wait (client) < 0)
+                return -1;
+        }
+        return 0;
+    }
     while (sendfd (client->fd, msg, &client->out_iobuf) < 0) {
         if (errno != EWOULDBLOCK && errno != EAGAIN)
             return -1;
@@ -629,6 +1039,19 @@ flux_msg_t *usock_client_recv (struct usock_client *client, int flags)
 {
     flux_msg_t *msg;
 
+    if (client->ring) {
+        while (!(msg = iobuf_recv (ring_read,
+                                   client->ring,
+                                   &client->in_iobuf))) {
+            if (errno != EWOULDBLOCK && errno != EAGAIN)
+                return NULL;
+            if ((flags & FLUX_O_NONBLOCK))
+                return NULL;
+            if (client_ring_wait (client) < 0)
+                return NULL;
+        }
+        return msg;
+    }
     while (!(msg = recvfd (client->fd, &client->in_iobuf))) {
         if (errno != EWOULDBLOCK && errno != EAGAIN)
             return NULL;
@@ -716,6 +1139,7 @@ struct usock_client *usock_client_create (int fd)
         return NULL;
 
     client->fd = fd;
+    client->epfd = -1;
     iobuf_init (&client->in_iobuf);
     iobuf_init (&client->out_iobuf);
 
@@ -729,11 +1153,146 @@ error:
     return NULL;
 }
 
+/* Send 'msg' with the ring's file descriptors attached (SCM_RIGHTS).
+ * The fds ride along with the first byte of the framed message.
+ */
+static int client_send_fds (struct usock_client *client,
+                            const flux_msg_t *msg,
+                            int *fds,
+                            int count)
+{
+    size_t size = sendfd_frame_size (msg);
+    uint8_t *buf;
+    size_t done = 0;
+    union {
+        struct cmsghdr hdr;
+        char buf[CMSG_SPACE (sizeof (int) * USOCK_MAX_RXFDS)];
+    } control;
+    int rc = -1;
+
+    if (count > USOCK_MAX_RXFDS) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!(buf = malloc (size)))
+        return -1;
+    if (sendfd_frame (msg, buf, size) < 0)
+        goto done;
+    while (done < size) {
+        struct iovec iov = { .iov_base = buf + done, .iov_len = size - done };
+        struct msghdr mh = { .msg_iov = &iov, .msg_iovlen = 1 };
+        ssize_t n;
+
+        if (done == 0) {
+            struct cmsghdr *cmsg;
+
+            memset (&control, 0, sizeof (control));
+            mh.msg_control = &control;
+            mh.msg_controllen = CMSG_SPACE (sizeof (int) * count);
+            cmsg = CMSG_FIRSTHDR (&mh);
+            cmsg->cmsg_level = SOL_SOCKET;
+            cmsg->cmsg_type = SCM_RIGHTS;
+            cmsg->cmsg_len = CMSG_LEN (sizeof (int) * count);
+            memcpy (CMSG_DATA (cmsg), fds, sizeof (int) * count);
+        }
+        if ((n = sendmsg (client->fd, &mh, 0)) < 0) {
+            if (errno != EWOULDBLOCK && errno != EAGAIN)
+                goto done;
+            if (usock_client_poll (client->fd, POLLOUT) < 0)
+                goto done;
+            continue;
+        }
+        done += n;
+    }
+    rc = 0;
+done:
+    ERRNO_SAFE_WRAP (free, buf);
+    return rc;
+}
+
+int usock_client_attach_shmring (struct usock_client *client,
+                                 struct shmring *ring,
+                                 const flux_msg_t *request)
+{
+    int fds[SHMRING_FD_COUNT];
+    struct epoll_event ev = { .events = EPOLLIN };
+    flux_msg_t *msg = NULL;
+    int epfd = -1;
+
+    if (!client || !ring || !request) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (client->ring) {
+        errno = EEXIST;
+        return -1;
+    }
+    if ((epfd = epoll_create1 (EPOLL_CLOEXEC)) < 0)
+        return -1;
+    ev.data.fd = client->fd;
+    if (epoll_ctl (epfd, EPOLL_CTL_ADD, client->fd, &ev) < 0)
+        goto error;
+    ev.data.fd = shmring_pollfd (ring);
+    if (epoll_ctl (epfd, EPOLL_CTL_ADD, ev.data.fd, &ev) < 0)
+        goto error;
+
+    shmring_get_fds (ring, fds);
+    if (client_send_fds (client, request, fds, SHMRING_FD_COUNT) < 0)
+        goto error;
+
+    /* On success, the response arrives on the ring.  On failure, the
+     * server responds on the socket.  N.B. in_iobuf is idle at this point,
+     * and is kept in case bytes following the response were read.
+     */
+    (void)shmring_pollevents (ring); // arm reader wakeup
+    for (;;) {
+        struct pollfd pfd[2];
+
+        if ((msg = iobuf_recv (ring_read, ring, &client->in_iobuf)))
+            break;
+        if (errno != EWOULDBLOCK && errno != EAGAIN)
+            goto error;
+        memset (pfd, 0, sizeof (pfd));
+        pfd[0].fd = client->fd;
+        pfd[0].events = POLLIN;
+        pfd[1].fd = shmring_pollfd (ring);
+        pfd[1].events = POLLIN;
+        if (poll (pfd, 2, -1) < 0)
+            goto error;
+        if ((pfd[0].revents & POLLIN) || is_poll_error (pfd[0].revents)) {
+            iobuf_clean (&client->in_iobuf);
+            if ((msg = usock_client_recv (client, 0))) {
+                if (flux_response_decode (msg, NULL, NULL) == 0)
+                    errno = EPROTO;
+                ERRNO_SAFE_WRAP (flux_msg_destroy, msg);
+                msg = NULL;
+            }
+            goto error;
+        }
+        shmring_clear (ring);
+    }
+    if (flux_response_decode (msg, NULL, NULL) < 0)
+        goto error;
+    flux_msg_destroy (msg);
+    client->ring = ring;
+    client->epfd = epfd;
+    return 0;
+error:
+    ERRNO_SAFE_WRAP (iobuf_clean, &client->in_iobuf);
+    ERRNO_SAFE_WRAP (flux_msg_destroy, msg);
+    if (epfd >= 0)
+        ERRNO_SAFE_WRAP (close, epfd);
+    return -1;
+}
+
 void usock_client_destroy (struct usock_client *client)
 {
     if (client) {
         iobuf_clean (&client->in_iobuf);
         iobuf_clean (&client->out_iobuf);
+        shmring_destroy (client->ring);
+        if (client->epfd >= 0)
+            ERRNO_SAFE_WRAP (close, client->epfd);
         ERRNO_SAFE_WRAP (free, client);
     }
 }
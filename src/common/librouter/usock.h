@@ -15,6 +15,7 @@
 #include <flux/core.h>
 
 #include "auth.h"
+#include "shmring.h"
 
 struct usock_conn;
 struct usock_client;
@@ -64,6 +65,22 @@ void usock_server_set_acceptor (struct usock_server *server,
 
 int usock_conn_send (struct usock_conn *conn, const flux_msg_t *msg);
 
+/* Switch connection to the shared memory rings described by the file
+ * descriptors that accompanied the most recently received message.
+ * Call this before responding to the client's attach request, so that
+ * the response (and all subsequent output) goes through the rings.
+ * Fails with EBUSY if socket output is pending.
+ */
+int usock_conn_attach_shmring (struct usock_conn *conn);
+
+/* Limit the number of messages queued for output to 'hwm'.
+ * When the limit is reached, usock_conn_send() fails with ENOBUFS, the
+ * client's input is no longer read, and the error callback is called
+ * with ENOBUFS from the reactor, so the connection can be destroyed.
+ * A value of 0 (the default) means unlimited.
+ */
+void usock_conn_set_hwm (struct usock_conn *conn, int hwm);
+
 const struct flux_msg_cred *usock_conn_get_cred (struct usock_conn *conn);
 
 const char *usock_conn_get_uuid (struct usock_conn *conn);
@@ -95,6 +112,20 @@ void usock_conn_destroy (struct usock_conn *conn);
 
 struct usock_conn *usock_conn_create (flux_reactor_t *r, int infd, int outfd);
 
+/* Take the socket away from a server connection that has not yet been
+ * accepted or rejected, so that the client may be served on a different
+ * reactor, e.g. one running in another thread.  The connection no longer
+ * closes the socket when destroyed.  Returns the socket fd, or -1 with
+ * errno set (EINVAL).
+ */
+int usock_conn_release (struct usock_conn *conn);
+
+/* Create a server connection on 'r' for a socket obtained from
+ * usock_conn_release().  The connection closes the socket when destroyed.
+ * The caller completes the handshake with usock_conn_accept().
+ */
+struct usock_conn *usock_conn_adopt (flux_reactor_t *r, int fd);
+
 /* Client
  */
 
@@ -109,6 +140,16 @@ flux_msg_t *usock_client_recv (struct usock_client *client, int flags);
 int usock_client_connect (const char *sockpath,
                           struct usock_retry_params retry);
 
+/* Send 'request' to the server with the file descriptors of 'ring'
+ * attached, and wait for a response.  On success, subsequent messages
+ * in both directions go through 'ring', and the client takes ownership
+ * of it.  On failure, the client continues to use the socket, and the
+ * caller retains ownership of 'ring'.
+ */
+int usock_client_attach_shmring (struct usock_client *client,
+                                 struct shmring *ring,
+                                 const flux_msg_t *request);
+
 struct usock_client *usock_client_create (int fd);
 void usock_client_destroy (struct usock_client *client);
 
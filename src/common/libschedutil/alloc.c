@@ -11,6 +11,7 @@
 #if HAVE_CONFIG_H
 #include "config.h"
 #endif
+#include <string.h>
 #include <flux/core.h>
 #include <jansson.h>
 
@@ -31,30 +32,42 @@ int schedutil_alloc_request_decode (const flux_msg_t *msg,
                                            "t_submit", t_submit);
 }
 
-static int schedutil_alloc_respond (flux_t *h, const flux_msg_t *msg,
+/* A successful alloc response includes R, so that the job-manager
+ * can pass it on without reading it back from the KVS.
+ */
+static int schedutil_alloc_respond (schedutil_t *util, const flux_msg_t *msg,
                                     int type, const char *note,
-                                    json_t *annotations)
+                                    json_t *annotations, const char *R)
 {
     flux_jobid_t id;
+    json_t *o;
     int rc;
 
     if (flux_request_unpack (msg, NULL, "{s:I}", "id", &id) < 0)
         return -1;
     if (annotations)
-        rc = flux_respond_pack (h, msg, "{s:I s:i s:O}",
-                                        "id", id,
-                                        "type", type,
-                                        "annotations", annotations);
+        o = json_pack ("{s:I s:i s:O}",
+                       "id", id,
+                       "type", type,
+                       "annotations", annotations);
     else if (note)
-        rc = flux_respond_pack (h, msg, "{s:I s:i s:s}",
-                                        "id", id,
-                                        "type", type,
-                                        "note", note);
+        o = json_pack ("{s:I s:i s:s}",
+                       "id", id,
+                       "type", type,
+                       "note", note);
     else
-        rc = flux_respond_pack (h, msg, "{s:I s:i}",
-                                        "id", id,
-                                        "type", type);
-    return rc;
+        o = json_pack ("{s:I s:i}",
+                       "id", id,
+                       "type", type);
+    if (!o || (R && json_object_set_new (o, "R", json_string (R)) < 0)) {
+        json_decref (o);
+        errno = ENOMEM;
+        return -1;
+    }
+    if ((rc = schedutil_batch_respond (util, msg, o)) == 0)
+        rc = flux_respond_pack (util->h, msg, "O", o);
+    json_decref (o);
+    return rc < 0 ? -1 : 0;
 }
 
 int schedutil_alloc_respond_annotate_pack (schedutil_t *util,
@@ -70,8 +83,8 @@ int schedutil_alloc_respond_annotate_pack (schedutil_t *util,
         errno = EINVAL;
         goto error;
     }
-    rc = schedutil_alloc_respond (util->h, msg, FLUX_SCHED_ALLOC_ANNOTATE,
-                                  NULL, o);
+    rc = schedutil_alloc_respond (util, msg, FLUX_SCHED_ALLOC_ANNOTATE,
+                                  NULL, o, NULL);
 error:
     va_end (ap);
     json_decref (o);
@@ -81,20 +94,21 @@ error:
 int schedutil_alloc_respond_deny (schedutil_t *util, const flux_msg_t *msg,
                                   const char *note)
 {
-    return schedutil_alloc_respond (util->h, msg, FLUX_SCHED_ALLOC_DENY,
-                                    note, NULL);
+    return schedutil_alloc_respond (util, msg, FLUX_SCHED_ALLOC_DENY,
+                                    note, NULL, NULL);
 }
 
 int schedutil_alloc_respond_cancel (schedutil_t *util, const flux_msg_t *msg)
 {
-    return schedutil_alloc_respond (util->h, msg, FLUX_SCHED_ALLOC_CANCEL,
-                                    NULL, NULL);
+    return schedutil_alloc_respond (util, msg, FLUX_SCHED_ALLOC_CANCEL,
+                                    NULL, NULL, NULL);
 }
 
 struct alloc {
     json_t *annotations;
     const flux_msg_t *msg;
     flux_kvs_txn_t *txn;
+    char *R;
 };
 
 static void alloc_destroy (struct alloc *ctx)
@@ -104,6 +118,7 @@ static void alloc_destroy (struct alloc *ctx)
         flux_kvs_txn_destroy (ctx->txn);
         flux_msg_decref (ctx->msg);
         json_decref (ctx->annotations);
+        free (ctx->R);
         free (ctx);
         errno = saved_errno;
     }
@@ -133,6 +148,8 @@ static struct alloc *alloc_create (const flux_msg_t *msg, const char *R,
         goto error;
     if (flux_kvs_txn_put (ctx->txn, 0, key, R) < 0)
         goto error;
+    if (!(ctx->R = strdup (R)))
+        goto error;
     return ctx;
 error:
     alloc_destroy (ctx);
@@ -150,8 +167,8 @@ static void alloc_continuation (flux_future_t *f, void *arg)
         goto error;
     }
     schedutil_remove_outstanding_future (util, f);
-    if (schedutil_alloc_respond (h, ctx->msg, FLUX_SCHED_ALLOC_SUCCESS,
-                                 NULL, ctx->annotations) < 0) {
+    if (schedutil_alloc_respond (util, ctx->msg, FLUX_SCHED_ALLOC_SUCCESS,
+                                 NULL, ctx->annotations, ctx->R) < 0) {
         flux_log_error (h, "alloc response");
         goto error;
     }
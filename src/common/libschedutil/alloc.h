@@ -50,6 +50,7 @@ int schedutil_alloc_respond_deny (schedutil_t *util, const flux_msg_t *msg,
 
 /* Respond to alloc request message - success, allocate R.
  * R is committed to the KVS first, then the response is sent.
+ * The response also carries R, for the job-manager journal.
  * If something goes wrong after this function returns, the reactor is stopped.
  */
 int schedutil_alloc_respond_success_pack (schedutil_t *util,
@@ -0,0 +1,178 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* batch.c - split batched requests and coalesce their responses
+ *
+ * If batching is negotiated in sched-ready, the job manager sends
+ * sched.alloc-batch {"jobs":[{id, priority, userid, t_submit}, ...]}
+ * and sched.free-batch {"ids":[id, ...]} requests.  Each job is turned
+ * into an ordinary sched.alloc or sched.free request, so the scheduler
+ * callbacks are unchanged.  Responses to those requests are queued and
+ * sent at the end of the reactor loop iteration as a single response
+ * to the batch request: {"responses":[{id, type, ...}, ...]} for alloc
+ * and {"ids":[id, ...]} for free.  Responses are kept in the order the
+ * scheduler made them.
+ *
+ * sched.cancel-batch {"ids":[id, ...]} requests get no response, and
+ * are handled in ops.c by calling the cancel callback for each job.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <flux/core.h>
+#include <jansson.h>
+
+#include "schedutil_private.h"
+#include "init.h"
+
+struct batch_response {
+    const char *key;
+    const flux_msg_t *msg;  // batch request to respond to
+    json_t *entries;
+};
+
+static void batch_response_destroy (struct batch_response *br)
+{
+    if (br) {
+        int saved_errno = errno;
+        flux_msg_decref (br->msg);
+        json_decref (br->entries);
+        free (br);
+        errno = saved_errno;
+    }
+}
+
+static struct batch_response *batch_response_create (const char *key)
+{
+    struct batch_response *br;
+
+    if (!(br = calloc (1, sizeof (*br))))
+        return NULL;
+    br->key = key;
+    if (!(br->entries = json_array ())) {
+        batch_response_destroy (br);
+        errno = ENOMEM;
+        return NULL;
+    }
+    return br;
+}
+
+static void batch_response_flush (schedutil_t *util, struct batch_response *br)
+{
+    if (json_array_size (br->entries) > 0) {
+        if (flux_respond_pack (util->h, br->msg, "{s:O}",
+                               br->key, br->entries) < 0)
+            flux_log_error (util->h, "error responding to batch request");
+        json_array_clear (br->entries);
+    }
+    flux_msg_decref (br->msg);
+    br->msg = NULL;
+}
+
+static void batch_prep_cb (flux_reactor_t *r,
+                           flux_watcher_t *w,
+                           int revents,
+                           void *arg)
+{
+    schedutil_t *util = arg;
+
+    batch_response_flush (util, util->alloc_responses);
+    batch_response_flush (util, util->free_responses);
+    flux_watcher_stop (w);
+}
+
+flux_msg_t *schedutil_batch_request (const flux_msg_t *batch,
+                                     const char *topic,
+                                     json_t *payload)
+{
+    flux_msg_t *msg;
+
+    if (!(msg = flux_msg_copy (batch, false)))
+        return NULL;
+    if (flux_msg_set_topic (msg, topic) < 0
+        || flux_msg_pack (msg, "O", payload) < 0)
+        goto error;
+    if (flux_msg_aux_set (msg,
+                          "schedutil::batch",
+                          (void *)flux_msg_incref (batch),
+                          (flux_free_f)flux_msg_decref) < 0) {
+        flux_msg_decref (batch);
+        goto error;
+    }
+    return msg;
+error:
+    flux_msg_decref (msg);
+    return NULL;
+}
+
+int schedutil_batch_respond (schedutil_t *util,
+                             const flux_msg_t *msg,
+                             json_t *entry)
+{
+    const flux_msg_t *batch;
+    const char *topic;
+    struct batch_response *br;
+
+    if (!(batch = flux_msg_aux_get (msg, "schedutil::batch")))
+        return 0;
+    if (flux_msg_get_topic (batch, &topic) < 0)
+        return -1;
+    if (!strcmp (topic, "sched.alloc-batch"))
+        br = util->alloc_responses;
+    else
+        br = util->free_responses;
+    if (!br->msg)
+        br->msg = flux_msg_incref (batch);
+    if (json_array_append (br->entries, entry) < 0) {
+        errno = ENOMEM;
+        return -1;
+    }
+    if (util->batch > 0 && json_array_size (br->entries) >= util->batch)
+        batch_response_flush (util, br);
+    else
+        flux_watcher_start (util->batch_prep);
+    return 1;
+}
+
+int schedutil_batch_init (schedutil_t *util)
+{
+    flux_reactor_t *r = flux_get_reactor (util->h);
+
+    if (!(util->alloc_responses = batch_response_create ("responses"))
+        || !(util->free_responses = batch_response_create ("ids")))
+        return -1;
+    if (!(util->batch_prep = flux_prepare_watcher_create (r,
+                                                          batch_prep_cb,
+                                                          util)))
+        return -1;
+    return 0;
+}
+
+void schedutil_batch_fini (schedutil_t *util)
+{
+    if (util->alloc_responses)
+        batch_response_flush (util, util->alloc_responses);
+    if (util->free_responses)
+        batch_response_flush (util, util->free_responses);
+    batch_response_destroy (util->alloc_responses);
+    batch_response_destroy (util->free_responses);
+    flux_watcher_destroy (util->batch_prep);
+    util->alloc_responses = NULL;
+    util->free_responses = NULL;
+    util->batch_prep = NULL;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -12,6 +12,7 @@
 #include "config.h"
 #endif
 #include <flux/core.h>
+#include <jansson.h>
 
 #include "schedutil_private.h"
 #include "init.h"
@@ -26,10 +27,19 @@ int schedutil_free_request_decode (const flux_msg_t *msg, flux_jobid_t *id)
 int schedutil_free_respond (schedutil_t *util, const flux_msg_t *msg)
 {
     flux_jobid_t id;
+    json_t *o;
+    int rc;
 
     if (flux_request_unpack (msg, NULL, "{s:I}", "id", &id) < 0)
         return -1;
-    return flux_respond_pack (util->h, msg, "{s:I}", "id", id);
+    if (!(o = json_integer (id))) {
+        errno = ENOMEM;
+        return -1;
+    }
+    if ((rc = schedutil_batch_respond (util, msg, o)) == 0)
+        rc = flux_respond_pack (util->h, msg, "{s:I}", "id", id);
+    json_decref (o);
+    return rc < 0 ? -1 : 0;
 }
 
 /*
@@ -18,40 +18,52 @@
 #include "init.h"
 #include "hello.h"
 
-static int schedutil_hello_job (flux_t *h,
-                                flux_jobid_t id,
-                                int priority,
-                                uint32_t userid,
-                                double t_submit,
-                                schedutil_hello_cb_f *cb,
-                                void *arg)
-{
-    char key[64];
+/* Lookups of R are pipelined, up to this many at once, for jobs
+ * whose R was not included in the job-manager's response.
+ */
+#define HELLO_LOOKUP_WINDOW 256
+
+struct hello_job {
+    flux_jobid_t id;
+    int priority;
+    uint32_t userid;
+    double t_submit;
     flux_future_t *f;
-    const char *R;
+};
 
-    if (!h) {
-        errno = EINVAL;
-        return -1;
-    }
+static int hello_lookup_start (flux_t *h, struct hello_job *job)
+{
+    char key[64];
 
-    if (flux_job_kvs_key (key, sizeof (key), id, "R") < 0) {
+    if (flux_job_kvs_key (key, sizeof (key), job->id, "R") < 0) {
         errno = EPROTO;
         return -1;
     }
-    if (!(f = flux_kvs_lookup (h, NULL, 0, key)))
+    if (!(job->f = flux_kvs_lookup (h, NULL, 0, key)))
         return -1;
-    if (flux_kvs_lookup_get (f, &R) < 0)
-        goto error;
-    if (cb (h, id, priority, userid, t_submit, R, arg) < 0)
-        goto error;
-    flux_future_destroy (f);
     return 0;
-error:
-    flux_log_error (h, "hello: error loading R for id=%ju",
-                    (uintmax_t)id);
-    flux_future_destroy (f);
-    return -1;
+}
+
+static int hello_lookup_finish (flux_t *h,
+                                struct hello_job *job,
+                                schedutil_hello_cb_f *cb,
+                                void *arg)
+{
+    const char *R;
+    int rc = -1;
+
+    if (flux_kvs_lookup_get (job->f, &R) < 0) {
+        flux_log_error (h, "hello: error loading R for id=%ju",
+                        (uintmax_t)job->id);
+        goto done;
+    }
+    if (cb (h, job->id, job->priority, job->userid, job->t_submit, R, arg) < 0)
+        goto done;
+    rc = 0;
+done:
+    flux_future_destroy (job->f);
+    job->f = NULL;
+    return rc;
 }
 
 int schedutil_hello (schedutil_t *util, schedutil_hello_cb_f *cb, void *arg)
@@ -60,6 +72,10 @@ int schedutil_hello (schedutil_t *util, schedutil_hello_cb_f *cb, void *arg)
     json_t *jobs;
     json_t *entry;
     size_t index;
+    struct hello_job window[HELLO_LOOKUP_WINDOW];
+    int head = 0;
+    int count = 0;
+    int saved_errno;
 
     if (!util || !cb) {
         errno = EINVAL;
@@ -71,32 +87,56 @@ int schedutil_hello (schedutil_t *util, schedutil_hello_cb_f *cb, void *arg)
     if (flux_rpc_get_unpack (f, "{s:o}", "alloc", &jobs) < 0)
         goto error;
     json_array_foreach (jobs, index, entry) {
-        flux_jobid_t id;
-        int priority;
-        uint32_t userid;
-        double t_submit;
+        struct hello_job job = { 0 };
+        const char *R = NULL;
 
-        if (json_unpack (entry, "{s:I s:i s:i s:f}",
-                                "id", &id,
-                                "priority", &priority,
-                                "userid", &userid,
-                                "t_submit", &t_submit) < 0) {
+        if (json_unpack (entry, "{s:I s:i s:i s:f s?:s}",
+                                "id", &job.id,
+                                "priority", &job.priority,
+                                "userid", &job.userid,
+                                "t_submit", &job.t_submit,
+                                "R", &R) < 0) {
             errno = EPROTO;
             goto error;
         }
-        if (schedutil_hello_job (util->h,
-                                 id,
-                                 priority,
-                                 userid,
-                                 t_submit,
-                                 cb,
-                                 arg) < 0)
+        if (R) {
+            if (cb (util->h,
+                    job.id,
+                    job.priority,
+                    job.userid,
+                    job.t_submit,
+                    R,
+                    arg) < 0)
+                goto error;
+            continue;
+        }
+        if (count == HELLO_LOOKUP_WINDOW) {
+            if (hello_lookup_finish (util->h, &window[head], cb, arg) < 0)
+                goto error;
+            head = (head + 1) % HELLO_LOOKUP_WINDOW;
+            count--;
+        }
+        if (hello_lookup_start (util->h, &job) < 0)
             goto error;
+        window[(head + count) % HELLO_LOOKUP_WINDOW] = job;
+        count++;
+    }
+    while (count > 0) {
+        if (hello_lookup_finish (util->h, &window[head], cb, arg) < 0)
+            goto error;
+        head = (head + 1) % HELLO_LOOKUP_WINDOW;
+        count--;
     }
     flux_future_destroy (f);
     return 0;
 error:
+    saved_errno = errno;
+    while (count-- > 0) {
+        flux_future_destroy (window[head].f);
+        head = (head + 1) % HELLO_LOOKUP_WINDOW;
+    }
     flux_future_destroy (f);
+    errno = saved_errno;
     return -1;
 }
 
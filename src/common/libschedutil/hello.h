@@ -29,9 +29,9 @@ typedef int (schedutil_hello_cb_f)(flux_t *h,
                                    void *arg);
 
 /* Send hello announcement to job-manager.
- * The job-manager responds with a list of jobs that have resources assigned.
- * This function looks up R for each job and passes R + metadata to 'cb'
- * with 'arg'.
+ * The job-manager responds with a list of jobs that have resources assigned,
+ * including R for jobs whose R it holds.  This function looks up R for the
+ * other jobs and passes R + metadata for each job to 'cb' with 'arg'.
  */
 int schedutil_hello (schedutil_t *util, schedutil_hello_cb_f *cb, void *arg);
 
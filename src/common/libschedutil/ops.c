@@ -108,6 +108,31 @@ static void cancel_cb (flux_t *h, flux_msg_handler_t *mh,
     util->cancel_cb (h, id, util->cb_arg);
 }
 
+/* Handle a sched.cancel-batch {"ids":[id, ...]} request, which like
+ * sched.cancel gets no response.
+ */
+static void cancel_batch_cb (flux_t *h, flux_msg_handler_t *mh,
+                             const flux_msg_t *msg, void *arg)
+{
+    schedutil_t *util = arg;
+    json_t *ids;
+    json_t *entry;
+    size_t index;
+
+    if (flux_request_unpack (msg, NULL, "{s:o}", "ids", &ids) < 0
+        || !json_is_array (ids)) {
+        flux_log (h, LOG_ERR, "sched.cancel-batch: malformed request");
+        return;
+    }
+    json_array_foreach (ids, index, entry) {
+        if (!json_is_integer (entry)) {
+            flux_log (h, LOG_ERR, "sched.cancel-batch: malformed job id");
+            return;
+        }
+        util->cancel_cb (h, json_integer_value (entry), util->cb_arg);
+    }
+}
+
 static void free_continuation (flux_future_t *f, void *arg)
 {
     schedutil_t *util = arg;
@@ -173,10 +198,69 @@ error:
         flux_log_error (h, "sched.free respond_error");
 }
 
+/* Split a sched.alloc-batch or sched.free-batch request into per-job
+ * sched.alloc or sched.free requests and handle each in turn.
+ * An error on any one job is reported by that job's handler.
+ */
+static void batch_split (flux_t *h, flux_msg_handler_t *mh,
+                         const flux_msg_t *msg, const char *key,
+                         const char *topic, flux_msg_handler_f cb,
+                         void *arg)
+{
+    json_t *a;
+    json_t *entry;
+    size_t index;
+
+    if (flux_request_unpack (msg, NULL, "{s:o}", key, &a) < 0
+        || !json_is_array (a)) {
+        flux_log (h, LOG_ERR, "%s-batch: malformed request", topic);
+        goto error;
+    }
+    json_array_foreach (a, index, entry) {
+        json_t *o = entry;
+        flux_msg_t *req;
+
+        if (json_is_integer (entry)) {
+            if (!(o = json_pack ("{s:O}", "id", entry)))
+                goto nomem;
+        }
+        else
+            json_incref (o);
+        req = schedutil_batch_request (msg, topic, o);
+        json_decref (o);
+        if (!req)
+            goto error;
+        cb (h, mh, req, arg);
+        flux_msg_decref (req);
+    }
+    return;
+nomem:
+    errno = ENOMEM;
+error:
+    flux_log_error (h, "%s-batch", topic);
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "%s-batch respond_error", topic);
+}
+
+static void alloc_batch_cb (flux_t *h, flux_msg_handler_t *mh,
+                            const flux_msg_t *msg, void *arg)
+{
+    batch_split (h, mh, msg, "jobs", "sched.alloc", alloc_cb, arg);
+}
+
+static void free_batch_cb (flux_t *h, flux_msg_handler_t *mh,
+                           const flux_msg_t *msg, void *arg)
+{
+    batch_split (h, mh, msg, "ids", "sched.free", free_cb, arg);
+}
+
 static const struct flux_msg_handler_spec htab[] = {
     { FLUX_MSGTYPE_REQUEST,  "sched.alloc", alloc_cb, 0},
+    { FLUX_MSGTYPE_REQUEST,  "sched.alloc-batch", alloc_batch_cb, 0},
     { FLUX_MSGTYPE_REQUEST,  "sched.cancel", cancel_cb, 0},
+    { FLUX_MSGTYPE_REQUEST,  "sched.cancel-batch", cancel_batch_cb, 0},
     { FLUX_MSGTYPE_REQUEST,  "sched.free", free_cb, 0},
+    { FLUX_MSGTYPE_REQUEST,  "sched.free-batch", free_batch_cb, 0},
     FLUX_MSGHANDLER_TABLE_END,
 };
 
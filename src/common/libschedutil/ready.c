@@ -18,21 +18,34 @@
 #include "init.h"
 #include "ready.h"
 
-int schedutil_ready (schedutil_t *util, const char *mode, int *queue_depth)
+int schedutil_ready_batch (schedutil_t *util,
+                           const char *mode,
+                           int batch,
+                           int *queue_depth)
 {
     flux_future_t *f;
     int count;
+    int granted = 0;
 
-    if (!util || !mode) {
+    if (!util || !mode || batch < 0) {
         errno = EINVAL;
         return -1;
     }
-    if (!(f = flux_rpc_pack (util->h, "job-manager.sched-ready",
-                             FLUX_NODEID_ANY, 0,
-                             "{s:s}", "mode", mode)))
+    if (batch > 0)
+        f = flux_rpc_pack (util->h, "job-manager.sched-ready",
+                           FLUX_NODEID_ANY, 0,
+                           "{s:s s:i}", "mode", mode, "batch", batch);
+    else
+        f = flux_rpc_pack (util->h, "job-manager.sched-ready",
+                           FLUX_NODEID_ANY, 0,
+                           "{s:s}", "mode", mode);
+    if (!f)
         return -1;
-    if (flux_rpc_get_unpack (f, "{s:i}", "count", &count) < 0)
+    if (flux_rpc_get_unpack (f, "{s:i s?:i}",
+                             "count", &count,
+                             "batch", &granted) < 0)
         goto error;
+    util->batch = granted;
     if (queue_depth)
         *queue_depth = count;
     flux_future_destroy (f);
@@ -42,6 +55,11 @@ error:
     return -1;
 }
 
+int schedutil_ready (schedutil_t *util, const char *mode, int *queue_depth)
+{
+    return schedutil_ready_batch (util, mode, 0, queue_depth);
+}
+
 
 /*
  * vi:tabstop=4 shiftwidth=4 expandtab
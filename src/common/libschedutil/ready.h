@@ -22,6 +22,18 @@
  */
 int schedutil_ready (schedutil_t *util, const char *mode, int *queue_depth);
 
+/* Like schedutil_ready(), but also offer to accept up to 'batch' jobs per
+ * alloc or free request (0 = no batching).  The job manager may grant a
+ * smaller batch size, or none.  Batching is transparent to the scheduler
+ * callbacks: batched requests are split into ordinary per-job requests,
+ * and the schedutil_alloc_respond_*() and schedutil_free_respond() replies
+ * to them are coalesced into one message per reactor loop iteration.
+ */
+int schedutil_ready_batch (schedutil_t *util,
+                           const char *mode,
+                           int batch,
+                           int *queue_depth);
+
 #endif /* !_FLUX_SCHEDUTIL_READY_H */
 
 /*
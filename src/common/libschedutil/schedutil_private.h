@@ -13,6 +13,7 @@
 
 #include <czmq.h>
 #include <flux/core.h>
+#include <jansson.h>
 
 #include "init.h"
 
@@ -26,6 +27,10 @@ struct schedutil_ctx {
     void *cb_arg;
     zlistx_t *outstanding_futures;
     zlistx_t *alloc_queue;
+    int batch;                  // max jobs per batch; 0 = not negotiated
+    flux_watcher_t *batch_prep;
+    struct batch_response *alloc_responses;
+    struct batch_response *free_responses;
 };
 
 /*
@@ -47,6 +52,30 @@ int schedutil_enqueue_alloc (schedutil_t *util, flux_future_t *f);
 flux_future_t *schedutil_peek_alloc (schedutil_t *util);
 int schedutil_dequeue_alloc (schedutil_t *util);
 
+/* Set up/tear down response batching.  Teardown sends any queued responses.
+ */
+int schedutil_batch_init (schedutil_t *util);
+void schedutil_batch_fini (schedutil_t *util);
+
+/* Create a request message for one job of a sched.alloc-batch or
+ * sched.free-batch request 'batch', with 'topic' and 'payload'.
+ * The new request retains the route of 'batch', so it may be responded
+ * to directly, but responses made with schedutil_batch_respond() are
+ * coalesced into a single response to 'batch'.
+ */
+flux_msg_t *schedutil_batch_request (const flux_msg_t *batch,
+                                     const char *topic,
+                                     json_t *payload);
+
+/* If 'msg' was created by schedutil_batch_request(), queue response
+ * 'entry' to be sent with others at the end of this reactor loop
+ * iteration and return 1.  Return 0 if 'msg' is not part of a batch,
+ * or -1 on error with errno set.
+ */
+int schedutil_batch_respond (schedutil_t *util,
+                             const flux_msg_t *msg,
+                             json_t *entry);
+
 /* (Un-)register callbacks for alloc, free, cancel.
  */
 int schedutil_ops_register (schedutil_t *util);
@@ -0,0 +1,1003 @@
+/************************************************************\
+ * Copyright 2018 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* fanout.c - tree distributed rexec
+ *
+ * Each rank handling a fanout request runs the command locally if it is
+ * a target, and forwards the request to the TBON children on the route
+ * to the other targets, with the targets in that child's subtree.  So a
+ * rank has at most tbon.arity requests outstanding, and the original
+ * requester has one.
+ *
+ * Output lines are hashed by (seq, stream, data), where seq is the line
+ * number in the output of the rank.  Lines from the local command and
+ * from children are merged for up to fanout_flush_delay seconds, then
+ * sent upstream in seq order, so each rank's output stays in order, and
+ * identical output from many ranks is passed up the tree as one line.
+ * Exit status is merged likewise, and sent when all targets in the
+ * subtree have completed.
+ */
+
+#if HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <signal.h>
+#include <czmq.h>
+#include <jansson.h>
+
+#include <flux/core.h>
+
+#include "src/common/libutil/errno_safe.h"
+#include "src/common/libutil/kary.h"
+#include "src/common/libidset/idset.h"
+#include "src/common/libioencode/ioencode.h"
+
+#include "subprocess.h"
+#include "subprocess_private.h"
+#include "command.h"
+#include "fanout.h"
+
+static const char *auxkey = "flux::fanout";
+
+/* Merged lines are sent upstream after this many seconds, or sooner
+ * if more than fanout_flush_size bytes are pending.
+ */
+static const double fanout_flush_delay = 0.1;
+static const size_t fanout_flush_size = 1048576;
+
+struct line {
+    int seq;
+    char *stream;
+    char *data;
+    int len;
+    struct idset *ranks;
+};
+
+struct status {
+    int code;
+    char *msg;
+    struct idset *ranks;
+};
+
+struct child {
+    uint32_t rank;
+    struct idset *ranks;            // targets in the subtree of rank
+    flux_future_t *f;
+    struct fanout_op *op;
+};
+
+struct fanout_op {
+    struct fanout *fo;
+    const flux_msg_t *msg;
+    char *id;                       // shared by the op on all ranks
+    char *sender;                   // original requester, on first rank
+    uint32_t matchtag;
+    void *handle;                   // in fo->ops
+    char *argv0;
+    struct idset *self;
+    flux_subprocess_t *p;
+    bool local_done;
+    int seq;
+    struct child *children;
+    int nchildren;
+    int pending;
+    zhashx_t *lines;                // struct line => struct line
+    size_t lines_size;
+    zhashx_t *status;               // msg => struct status
+    flux_watcher_t *timer_w;
+};
+
+struct fanout {
+    flux_subprocess_server_t *s;
+    char *topic;
+    char *signal_topic;
+    int k;
+    uint32_t size;
+    zlistx_t *ops;
+    flux_msg_handler_t **handlers;
+};
+
+static void line_destroy (struct line *l)
+{
+    if (l) {
+        int saved_errno = errno;
+        free (l->stream);
+        free (l->data);
+        idset_destroy (l->ranks);
+        free (l);
+        errno = saved_errno;
+    }
+}
+
+static void line_destructor (void **item)
+{
+    if (item) {
+        line_destroy (*item);
+        *item = NULL;
+    }
+}
+
+static struct line *line_create (int seq,
+                                 const char *stream,
+                                 const char *data,
+                                 int len)
+{
+    struct line *l;
+
+    if (!(l = calloc (1, sizeof (*l))))
+        return NULL;
+    l->seq = seq;
+    if (!(l->stream = strdup (stream))
+        || !(l->data = malloc (len))
+        || !(l->ranks = idset_create (0, IDSET_FLAG_AUTOGROW))) {
+        line_destroy (l);
+        return NULL;
+    }
+    memcpy (l->data, data, len);
+    l->len = len;
+    return l;
+}
+
+/* FNV-1a over the line number, stream, and data.
+ */
+static size_t line_hasher (const void *key)
+{
+    const struct line *l = key;
+    size_t hash = 2166136261u;
+    const unsigned char *cp;
+    int i;
+
+    hash = (hash ^ l->seq) * 16777619;
+    for (cp = (const unsigned char *)l->stream; *cp; cp++)
+        hash = (hash ^ *cp) * 16777619;
+    for (i = 0; i < l->len; i++)
+        hash = (hash ^ (unsigned char)l->data[i]) * 16777619;
+    return hash;
+}
+
+static int line_comparator (const void *item1, const void *item2)
+{
+    const struct line *l1 = item1;
+    const struct line *l2 = item2;
+    int rc;
+
+    if (l1->seq != l2->seq)
+        return l1->seq < l2->seq ? -1 : 1;
+    if ((rc = strcmp (l1->stream, l2->stream)))
+        return rc;
+    if (l1->len != l2->len)
+        return l1->len < l2->len ? -1 : 1;
+    return memcmp (l1->data, l2->data, l1->len);
+}
+
+/* Order lines for output by line number, then by lowest rank.
+ */
+static int line_cmp (const void *a, const void *b)
+{
+    const struct line *l1 = *(const struct line **)a;
+    const struct line *l2 = *(const struct line **)b;
+    unsigned int r1, r2;
+
+    if (l1->seq != l2->seq)
+        return l1->seq < l2->seq ? -1 : 1;
+    r1 = idset_first (l1->ranks);
+    r2 = idset_first (l2->ranks);
+    if (r1 != r2)
+        return r1 < r2 ? -1 : 1;
+    return strcmp (l1->stream, l2->stream);
+}
+
+static void status_destroy (struct status *st)
+{
+    if (st) {
+        int saved_errno = errno;
+        free (st->msg);
+        idset_destroy (st->ranks);
+        free (st);
+        errno = saved_errno;
+    }
+}
+
+static void status_destructor (void **item)
+{
+    if (item) {
+        status_destroy (*item);
+        *item = NULL;
+    }
+}
+
+static struct status *status_create (int code, const char *msg)
+{
+    struct status *st;
+
+    if (!(st = calloc (1, sizeof (*st))))
+        return NULL;
+    st->code = code;
+    if (!(st->msg = strdup (msg))
+        || !(st->ranks = idset_create (0, IDSET_FLAG_AUTOGROW))) {
+        status_destroy (st);
+        return NULL;
+    }
+    return st;
+}
+
+static void op_destroy (struct fanout_op *op)
+{
+    if (op) {
+        int saved_errno = errno;
+        int i;
+
+        if (op->children) {
+            for (i = 0; i < op->nchildren; i++) {
+                flux_future_destroy (op->children[i].f);
+                idset_destroy (op->children[i].ranks);
+            }
+            free (op->children);
+        }
+        flux_subprocess_destroy (op->p);
+        flux_watcher_destroy (op->timer_w);
+        zhashx_destroy (&op->lines);
+        zhashx_destroy (&op->status);
+        idset_destroy (op->self);
+        flux_msg_decref (op->msg);
+        free (op->argv0);
+        free (op->id);
+        free (op->sender);
+        free (op);
+        errno = saved_errno;
+    }
+}
+
+static void op_destructor (void **item)
+{
+    if (item) {
+        op_destroy (*item);
+        *item = NULL;
+    }
+}
+
+static void op_flush_cb (flux_reactor_t *r,
+                         flux_watcher_t *w,
+                         int revents,
+                         void *arg);
+
+static struct fanout_op *op_create (struct fanout *fo, const flux_msg_t *msg)
+{
+    flux_t *h = fo->s->h;
+    struct fanout_op *op;
+
+    if (!(op = calloc (1, sizeof (*op))))
+        return NULL;
+    op->fo = fo;
+    op->msg = flux_msg_incref (msg);
+    if (!(op->lines = zhashx_new ())
+        || !(op->status = zhashx_new ())) {
+        errno = ENOMEM;
+        goto error;
+    }
+    zhashx_set_key_hasher (op->lines, line_hasher);
+    zhashx_set_key_comparator (op->lines, line_comparator);
+    zhashx_set_key_duplicator (op->lines, NULL);
+    zhashx_set_key_destructor (op->lines, NULL);
+    zhashx_set_destructor (op->lines, line_destructor);
+    zhashx_set_destructor (op->status, status_destructor);
+    if (!(op->self = idset_create (0, IDSET_FLAG_AUTOGROW))
+        || idset_set (op->self, fo->s->rank) < 0)
+        goto error;
+    if (!(op->timer_w = flux_timer_watcher_create (flux_get_reactor (h),
+                                                   fanout_flush_delay,
+                                                   0.,
+                                                   op_flush_cb,
+                                                   op)))
+        goto error;
+    return op;
+error:
+    op_destroy (op);
+    return NULL;
+}
+
+/* Send merged lines upstream in order.
+ */
+static int op_flush (struct fanout_op *op)
+{
+    flux_t *h = op->fo->s->h;
+    struct line **v = NULL;
+    struct line *l;
+    json_t *lines = NULL;
+    int count = zhashx_size (op->lines);
+    int i = 0;
+    int rc = -1;
+
+    flux_watcher_stop (op->timer_w);
+    if (count == 0)
+        return 0;
+    if (!(v = calloc (count, sizeof (v[0])))
+        || !(lines = json_array ())) {
+        errno = ENOMEM;
+        goto done;
+    }
+    l = zhashx_first (op->lines);
+    while (l) {
+        v[i++] = l;
+        l = zhashx_next (op->lines);
+    }
+    qsort (v, count, sizeof (v[0]), line_cmp);
+    for (i = 0; i < count; i++) {
+        char *ranks;
+        json_t *io;
+
+        if (!(ranks = idset_encode (v[i]->ranks, IDSET_FLAG_RANGE)))
+            goto done;
+        io = ioencode (v[i]->stream, ranks, v[i]->data, v[i]->len, false);
+        ERRNO_SAFE_WRAP (free, ranks);
+        if (!io
+            || json_object_set_new (io, "seq", json_integer (v[i]->seq)) < 0
+            || json_array_append_new (lines, io) < 0) {
+            json_decref (io);
+            errno = ENOMEM;
+            goto done;
+        }
+    }
+    if (flux_respond_pack (h, op->msg, "{s:s s:O}",
+                           "type", "output",
+                           "lines", lines) < 0)
+        goto done;
+    rc = 0;
+done:
+    zhashx_purge (op->lines);
+    op->lines_size = 0;
+    ERRNO_SAFE_WRAP (json_decref, lines);
+    ERRNO_SAFE_WRAP (free, v);
+    return rc;
+}
+
+static void op_flush_cb (flux_reactor_t *r,
+                         flux_watcher_t *w,
+                         int revents,
+                         void *arg)
+{
+    struct fanout_op *op = arg;
+
+    if (op_flush (op) < 0)
+        flux_log_error (op->fo->s->h, "fanout: error sending output");
+}
+
+static int op_add_line (struct fanout_op *op,
+                        int seq,
+                        const char *stream,
+                        const char *data,
+                        int len,
+                        const struct idset *ranks)
+{
+    struct line key = {
+        .seq = seq,
+        .stream = (char *)stream,
+        .data = (char *)data,
+        .len = len,
+    };
+    struct line *l;
+
+    if (!(l = zhashx_lookup (op->lines, &key))) {
+        if (!(l = line_create (seq, stream, data, len)))
+            return -1;
+        if (zhashx_insert (op->lines, l, l) < 0) {
+            line_destroy (l);
+            errno = EEXIST;
+            return -1;
+        }
+        op->lines_size += len;
+    }
+    if (idset_add (l->ranks, ranks) < 0)
+        return -1;
+    if (op->lines_size >= fanout_flush_size)
+        return op_flush (op);
+    flux_watcher_start (op->timer_w);
+    return 0;
+}
+
+static int op_add_status (struct fanout_op *op,
+                          int code,
+                          const char *msg,
+                          const struct idset *ranks)
+{
+    struct status *st;
+
+    if (!(st = zhashx_lookup (op->status, msg))) {
+        if (!(st = status_create (code, msg)))
+            return -1;
+        if (zhashx_insert (op->status, msg, st) < 0) {
+            status_destroy (st);
+            errno = EEXIST;
+            return -1;
+        }
+    }
+    return idset_add (st->ranks, ranks);
+}
+
+/* Record failure 'errnum' for 'ranks', with exit codes as in flux-exec(1):
+ * 126 for permission denied, 127 for command not found, 68 (EX_NOHOST)
+ * for no route to host.
+ */
+static int op_add_error (struct fanout_op *op,
+                         int errnum,
+                         const char *argv0,
+                         const struct idset *ranks)
+{
+    char msg[256];
+    int code = 1;
+
+    if (errnum == EPERM || errnum == EACCES)
+        code = 126;
+    else if (errnum == ENOENT)
+        code = 127;
+    else if (errnum == EHOSTUNREACH)
+        code = 68;
+    if (argv0)
+        snprintf (msg, sizeof (msg), "Error: %s: %s", argv0, strerror (errnum));
+    else
+        snprintf (msg, sizeof (msg), "Error: %s", strerror (errnum));
+    return op_add_status (op, code, msg, ranks);
+}
+
+static int op_respond_status (struct fanout_op *op)
+{
+    flux_t *h = op->fo->s->h;
+    struct status *st;
+    json_t *status;
+    int rc = -1;
+
+    if (!(status = json_array ())) {
+        errno = ENOMEM;
+        return -1;
+    }
+    st = zhashx_first (op->status);
+    while (st) {
+        char *ranks;
+        json_t *o;
+
+        if (!(ranks = idset_encode (st->ranks, IDSET_FLAG_RANGE)))
+            goto done;
+        o = json_pack ("{s:s s:i s:s}",
+                       "ranks", ranks,
+                       "code", st->code,
+                       "msg", st->msg);
+        ERRNO_SAFE_WRAP (free, ranks);
+        if (!o || json_array_append_new (status, o) < 0) {
+            json_decref (o);
+            errno = ENOMEM;
+            goto done;
+        }
+        st = zhashx_next (op->status);
+    }
+    if (flux_respond_pack (h, op->msg, "{s:s s:O}",
+                           "type", "status",
+                           "status", status) < 0)
+        goto done;
+    rc = 0;
+done:
+    ERRNO_SAFE_WRAP (json_decref, status);
+    return rc;
+}
+
+/* If the local command and all children are done, send remaining output
+ * and status, terminate the response stream, and destroy 'op'.
+ */
+static void op_check_done (struct fanout_op *op)
+{
+    flux_t *h = op->fo->s->h;
+
+    if (!op->local_done || op->pending > 0)
+        return;
+    if (op_flush (op) < 0 || op_respond_status (op) < 0)
+        flux_log_error (h, "fanout: error sending response");
+    if (flux_respond_error (h, op->msg, ENODATA, NULL) < 0)
+        flux_log_error (h, "fanout: flux_respond_error");
+    zlistx_delete (op->fo->ops, op->handle);
+}
+
+static void op_signal (struct fanout_op *op, int signum)
+{
+    flux_t *h = op->fo->s->h;
+    int i;
+
+    if (op->p && flux_subprocess_state (op->p) == FLUX_SUBPROCESS_RUNNING) {
+        flux_future_t *f;
+        if (!(f = flux_subprocess_kill (op->p, signum)))
+            flux_log_error (h, "fanout: flux_subprocess_kill");
+        flux_future_destroy (f);
+    }
+    for (i = 0; i < op->nchildren; i++) {
+        struct child *c = &op->children[i];
+        flux_future_t *f;
+
+        if (!c->f)
+            continue;
+        if (!(f = flux_rpc_pack (h,
+                                 op->fo->signal_topic,
+                                 c->rank,
+                                 FLUX_RPC_NORESPONSE,
+                                 "{s:s s:i}",
+                                 "id", op->id,
+                                 "signum", signum)))
+            flux_log_error (h, "fanout: error forwarding signal");
+        flux_future_destroy (f);
+    }
+}
+
+static void child_cb (flux_future_t *f, void *arg)
+{
+    struct child *c = arg;
+    struct fanout_op *op = c->op;
+    flux_t *h = op->fo->s->h;
+    const char *type;
+    json_t *a;
+    json_t *o;
+    size_t index;
+
+    if (flux_rpc_get_unpack (f, "{s:s}", "type", &type) < 0) {
+        if (errno != ENODATA) {
+            if (op_add_error (op, errno, NULL, c->ranks) < 0)
+                flux_log_error (h, "fanout: error recording status");
+        }
+        flux_future_destroy (f);
+        c->f = NULL;
+        op->pending--;
+        op_check_done (op);
+        return;
+    }
+    if (!strcmp (type, "output")
+        && flux_rpc_get_unpack (f, "{s:o}", "lines", &a) == 0) {
+        json_array_foreach (a, index, o) {
+            const char *stream, *rankstr;
+            struct idset *ranks;
+            char *data = NULL;
+            int len, seq;
+            bool eof;
+
+            if (iodecode (o, &stream, &rankstr, &data, &len, &eof) < 0
+                || json_unpack (o, "{s:i}", "seq", &seq) < 0
+                || !(ranks = idset_decode (rankstr))) {
+                flux_log (h, LOG_ERR, "fanout: malformed output from %lu",
+                          (unsigned long)c->rank);
+                free (data);
+                continue;
+            }
+            if (len > 0 && op_add_line (op, seq, stream, data, len, ranks) < 0)
+                flux_log_error (h, "fanout: error merging output");
+            idset_destroy (ranks);
+            free (data);
+        }
+    }
+    else if (!strcmp (type, "status")
+        && flux_rpc_get_unpack (f, "{s:o}", "status", &a) == 0) {
+        json_array_foreach (a, index, o) {
+            const char *rankstr, *msg;
+            struct idset *ranks;
+            int code;
+
+            if (json_unpack (o, "{s:s s:i s:s}",
+                             "ranks", &rankstr,
+                             "code", &code,
+                             "msg", &msg) < 0
+                || !(ranks = idset_decode (rankstr))) {
+                flux_log (h, LOG_ERR, "fanout: malformed status from %lu",
+                          (unsigned long)c->rank);
+                continue;
+            }
+            if (op_add_status (op, code, msg, ranks) < 0)
+                flux_log_error (h, "fanout: error merging status");
+            idset_destroy (ranks);
+        }
+    }
+    flux_future_reset (f);
+}
+
+static void local_output_cb (flux_subprocess_t *p, const char *stream)
+{
+    struct fanout_op *op = flux_subprocess_aux_get (p, auxkey);
+    const char *data;
+    int len;
+
+    if (!(data = flux_subprocess_getline (p, stream, &len))) {
+        flux_log_error (op->fo->s->h, "fanout: flux_subprocess_getline");
+        return;
+    }
+    if (len > 0 && op_add_line (op, op->seq++, stream, data, len, op->self) < 0)
+        flux_log_error (op->fo->s->h, "fanout: error adding output");
+}
+
+static void local_state_cb (flux_subprocess_t *p,
+                            flux_subprocess_state_t state)
+{
+    struct fanout_op *op = flux_subprocess_aux_get (p, auxkey);
+
+    if (state == FLUX_SUBPROCESS_EXEC_FAILED
+        || state == FLUX_SUBPROCESS_FAILED) {
+        if (op_add_error (op,
+                          flux_subprocess_fail_errno (p),
+                          op->argv0,
+                          op->self) < 0)
+            flux_log_error (op->fo->s->h, "fanout: error recording status");
+        op->local_done = true;
+        op_check_done (op);
+    }
+}
+
+static void local_completion_cb (flux_subprocess_t *p)
+{
+    struct fanout_op *op = flux_subprocess_aux_get (p, auxkey);
+    char msg[64] = "";
+    int code, signum;
+
+    if (op->local_done)
+        return;
+    if ((code = flux_subprocess_exit_code (p)) < 0) {
+        if ((signum = flux_subprocess_signaled (p)) > 0) {
+            code = signum + 128;
+            snprintf (msg, sizeof (msg), "%s", strsignal (signum));
+        }
+    }
+    else
+        snprintf (msg, sizeof (msg), "Exit %d", code);
+    if (code > 0 && op_add_status (op, code, msg, op->self) < 0)
+        flux_log_error (op->fo->s->h, "fanout: error recording status");
+    op->local_done = true;
+    op_check_done (op);
+}
+
+/* Start the command on this rank.  If exec fails, the failure is
+ * recorded as status and not returned as an error.
+ */
+static int op_exec (struct fanout_op *op, const char *cmd_str)
+{
+    flux_subprocess_server_t *s = op->fo->s;
+    flux_subprocess_ops_t ops = {
+        .on_completion = local_completion_cb,
+        .on_state_change = local_state_cb,
+        .on_stdout = local_output_cb,
+        .on_stderr = local_output_cb,
+    };
+    flux_cmd_t *cmd;
+    char **env = NULL;
+    int rc = -1;
+
+    if (!(cmd = flux_cmd_fromjson (cmd_str, NULL)))
+        return -1;
+    if (!flux_cmd_argc (cmd) || !flux_cmd_getcwd (cmd)) {
+        errno = EPROTO;
+        goto done;
+    }
+    if (!(op->argv0 = strdup (flux_cmd_arg (cmd, 0))))
+        goto done;
+    if (!(env = flux_cmd_env_expand (cmd)))
+        goto done;
+    /* if no environment sent, use local server environment */
+    if (env[0] == NULL && flux_cmd_set_env (cmd, environ) < 0)
+        goto done;
+    if (flux_cmd_setenvf (cmd, 1, "FLUX_URI", "%s", s->local_uri) < 0)
+        goto done;
+    if (!(op->p = flux_exec (s->h,
+                             FLUX_SUBPROCESS_FLAGS_SETPGRP,
+                             cmd,
+                             &ops,
+                             NULL))) {
+        if (op_add_error (op, errno, op->argv0, op->self) < 0)
+            goto done;
+        op->local_done = true;
+        rc = 0;
+        goto done;
+    }
+    if (flux_subprocess_aux_set (op->p, auxkey, op, NULL) < 0)
+        goto done;
+    if (flux_subprocess_close (op->p, "stdin") < 0)
+        goto done;
+    rc = 0;
+done:
+    ERRNO_SAFE_WRAP (free, env);
+    flux_cmd_destroy (cmd);
+    return rc;
+}
+
+static int fanout_topology (struct fanout *fo)
+{
+    const char *s;
+
+    if (fo->k > 0)
+        return 0;
+    if (flux_get_size (fo->s->h, &fo->size) < 0)
+        return -1;
+    if (!(s = flux_attr_get (fo->s->h, "tbon.arity")))
+        return -1;
+    if ((fo->k = strtol (s, NULL, 10)) < 1) {
+        fo->k = 0;
+        errno = EINVAL;
+        return -1;
+    }
+    return 0;
+}
+
+/* Split 'targets' into this rank's and those in the subtree of each child.
+ * Targets not in the subtree of this rank are recorded as unreachable.
+ */
+static int op_route (struct fanout_op *op,
+                     const struct idset *targets,
+                     bool *local)
+{
+    struct fanout *fo = op->fo;
+    uint32_t rank = fo->s->rank;
+    struct idset *unreachable = NULL;
+    unsigned int id;
+    int i;
+    int rc = -1;
+
+    if (!(op->children = calloc (fo->k, sizeof (op->children[0])))
+        || !(unreachable = idset_create (0, IDSET_FLAG_AUTOGROW)))
+        goto done;
+    for (i = 0; i < fo->k; i++) {
+        uint32_t child = kary_childof (fo->k, fo->size, rank, i);
+        if (child == KARY_NONE)
+            break;
+        op->children[i].rank = child;
+        op->children[i].op = op;
+    }
+    op->nchildren = i;
+
+    *local = false;
+    id = idset_first (targets);
+    while (id != IDSET_INVALID_ID) {
+        uint32_t child = KARY_NONE;
+
+        if (id < fo->size && id != rank)
+            child = kary_child_route (fo->k, fo->size, rank, id);
+        if (id == rank)
+            *local = true;
+        else if (child == KARY_NONE) {
+            if (idset_set (unreachable, id) < 0)
+                goto done;
+        }
+        else {
+            for (i = 0; i < op->nchildren; i++) {
+                struct child *c = &op->children[i];
+                if (c->rank == child) {
+                    if (!c->ranks
+                        && !(c->ranks = idset_create (0, IDSET_FLAG_AUTOGROW)))
+                        goto done;
+                    if (idset_set (c->ranks, id) < 0)
+                        goto done;
+                    break;
+                }
+            }
+        }
+        id = idset_next (targets, id);
+    }
+    if (idset_count (unreachable) > 0
+        && op_add_error (op, EHOSTUNREACH, NULL, unreachable) < 0)
+        goto done;
+    rc = 0;
+done:
+    idset_destroy (unreachable);
+    return rc;
+}
+
+static int op_forward (struct fanout_op *op, const char *cmd_str)
+{
+    flux_t *h = op->fo->s->h;
+    int i;
+
+    for (i = 0; i < op->nchildren; i++) {
+        struct child *c = &op->children[i];
+        char *ranks;
+
+        if (!c->ranks)
+            continue;
+        if (!(ranks = idset_encode (c->ranks, IDSET_FLAG_RANGE)))
+            return -1;
+        if (!(c->f = flux_rpc_pack (h,
+                                    op->fo->topic,
+                                    c->rank,
+                                    FLUX_RPC_STREAMING,
+                                    "{s:s s:s s:s}",
+                                    "cmd", cmd_str,
+                                    "ranks", ranks,
+                                    "id", op->id))
+            || flux_future_then (c->f, -1., child_cb, c) < 0) {
+            flux_future_destroy (c->f);
+            c->f = NULL;
+            if (op_add_error (op, errno, NULL, c->ranks) < 0) {
+                ERRNO_SAFE_WRAP (free, ranks);
+                return -1;
+            }
+        }
+        else
+            op->pending++;
+        free (ranks);
+    }
+    return 0;
+}
+
+static void fanout_cb (flux_t *h, flux_msg_handler_t *mh,
+                       const flux_msg_t *msg, void *arg)
+{
+    struct fanout *fo = arg;
+    const char *cmd_str;
+    const char *ranks;
+    const char *id = NULL;
+    struct idset *targets = NULL;
+    struct fanout_op *op = NULL;
+    bool local;
+
+    if (flux_request_unpack (msg, NULL, "{s:s s:s s?s}",
+                             "cmd", &cmd_str,
+                             "ranks", &ranks,
+                             "id", &id) < 0)
+        goto error;
+    if (!flux_msg_is_streaming (msg)) {
+        errno = EPROTO;
+        goto error;
+    }
+    if (!(targets = idset_decode (ranks)) || idset_count (targets) == 0) {
+        errno = EINVAL;
+        goto error;
+    }
+    if (fanout_topology (fo) < 0)
+        goto error;
+    if (!(op = op_create (fo, msg)))
+        goto error;
+    if (id) {
+        if (!(op->id = strdup (id)))
+            goto error;
+    }
+    else {
+        if (flux_msg_get_route_first (msg, &op->sender) < 0
+            || flux_msg_get_matchtag (msg, &op->matchtag) < 0)
+            goto error;
+        if (asprintf (&op->id, "%s.%ju",
+                      op->sender,
+                      (uintmax_t)op->matchtag) < 0)
+            goto error;
+    }
+    if (op_route (op, targets, &local) < 0)
+        goto error;
+    if (!(op->handle = zlistx_add_end (fo->ops, op))) {
+        errno = ENOMEM;
+        goto error;
+    }
+    idset_destroy (targets);
+
+    /* Once listed, errors are reported as status of the ranks affected.
+     */
+    if (op_forward (op, cmd_str) < 0
+        || (local ? op_exec (op, cmd_str) : 0) < 0) {
+        if (op_add_error (op, errno, NULL, op->self) < 0)
+            flux_log_error (h, "fanout: error recording status");
+        op->local_done = true;
+    }
+    if (!local)
+        op->local_done = true;
+    op_check_done (op);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+    idset_destroy (targets);
+    op_destroy (op);
+}
+
+static void fanout_signal_cb (flux_t *h, flux_msg_handler_t *mh,
+                              const flux_msg_t *msg, void *arg)
+{
+    struct fanout *fo = arg;
+    const char *id = NULL;
+    int matchtag = -1;
+    char *sender = NULL;
+    int signum;
+    struct fanout_op *op;
+
+    if (flux_request_unpack (msg, NULL, "{s:i s?s s?i}",
+                             "signum", &signum,
+                             "id", &id,
+                             "matchtag", &matchtag) < 0)
+        goto error;
+    if (!id && flux_msg_get_route_first (msg, &sender) < 0)
+        goto error;
+    op = zlistx_first (fo->ops);
+    while (op) {
+        if (id ? !strcmp (op->id, id)
+               : (op->sender
+                  && !strcmp (op->sender, sender)
+                  && op->matchtag == matchtag))
+            op_signal (op, signum);
+        op = zlistx_next (fo->ops);
+    }
+    free (sender);
+    return;
+error:
+    flux_log_error (h, "%s", __FUNCTION__);
+    free (sender);
+}
+
+void fanout_signal_all (struct fanout *fo, int signum)
+{
+    struct fanout_op *op;
+
+    if (!fo)
+        return;
+    op = zlistx_first (fo->ops);
+    while (op) {
+        op_signal (op, signum);
+        op = zlistx_next (fo->ops);
+    }
+}
+
+void fanout_disconnect (struct fanout *fo, const char *id)
+{
+    struct fanout_op *op;
+
+    if (!fo)
+        return;
+    op = zlistx_first (fo->ops);
+    while (op) {
+        if (op->sender && !strcmp (op->sender, id))
+            op_signal (op, SIGKILL);
+        op = zlistx_next (fo->ops);
+    }
+}
+
+void fanout_destroy (struct fanout *fo)
+{
+    if (fo) {
+        int saved_errno = errno;
+        flux_msg_handler_delvec (fo->handlers);
+        fanout_signal_all (fo, SIGKILL);
+        zlistx_destroy (&fo->ops);
+        free (fo->topic);
+        free (fo->signal_topic);
+        free (fo);
+        errno = saved_errno;
+    }
+}
+
+struct fanout *fanout_create (flux_subprocess_server_t *s, const char *prefix)
+{
+    struct flux_msg_handler_spec htab[] = {
+        { FLUX_MSGTYPE_REQUEST, NULL, fanout_cb, 0 },
+        { FLUX_MSGTYPE_REQUEST, NULL, fanout_signal_cb, 0 },
+        FLUX_MSGHANDLER_TABLE_END,
+    };
+    struct fanout *fo;
+
+    if (!(fo = calloc (1, sizeof (*fo))))
+        return NULL;
+    fo->s = s;
+    if (asprintf (&fo->topic, "%s.rexec.fanout", prefix) < 0
+        || asprintf (&fo->signal_topic, "%s.rexec.fanout-signal", prefix) < 0)
+        goto error;
+    if (!(fo->ops = zlistx_new ())) {
+        errno = ENOMEM;
+        goto error;
+    }
+    zlistx_set_destructor (fo->ops, op_destructor);
+    htab[0].topic_glob = fo->topic;
+    htab[1].topic_glob = fo->signal_topic;
+    if (flux_msg_handler_addvec (s->h, htab, fo, &fo->handlers) < 0)
+        goto error;
+    return fo;
+error:
+    fanout_destroy (fo);
+    return NULL;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
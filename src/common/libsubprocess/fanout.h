@@ -0,0 +1,53 @@
+/************************************************************\
+ * Copyright 2018 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _SUBPROCESS_FANOUT_H
+#define _SUBPROCESS_FANOUT_H
+
+#include "subprocess.h"
+
+/* fanout - run a command on a set of ranks over the TBON
+ *
+ * A <prefix>.rexec.fanout request {cmd, ranks} is handled by running the
+ * command locally if this rank is in 'ranks', and forwarding the request
+ * to each TBON child with target ranks in its subtree.  Output lines are
+ * merged across ranks before they are passed upstream, so a line that is
+ * the Nth line of output of many ranks is sent once, with an idset.
+ *
+ * Responses:
+ *   {"type":"output", "lines":[{stream, rank, data, seq}, ...]}
+ *     where each line is an RFC 24 io object with an idset for "rank",
+ *     and seq is the line number within the output of those ranks.
+ *   {"type":"status", "status":[{"ranks":s, "code":i, "msg":s}, ...]}
+ *     for ranks that exited nonzero or failed, sent once before the
+ *     stream is terminated with ENODATA.
+ *
+ * A <prefix>.rexec.fanout-signal request {matchtag, signum} from the
+ * original requester signals the command on all ranks.
+ */
+
+struct fanout;
+
+struct fanout *fanout_create (flux_subprocess_server_t *s, const char *prefix);
+void fanout_destroy (struct fanout *fo);
+
+/* Signal all locally running fanout commands.
+ */
+void fanout_signal_all (struct fanout *fo, int signum);
+
+/* Kill fanout commands started by the disconnected client 'id'.
+ */
+void fanout_disconnect (struct fanout *fo, const char *id);
+
+#endif /* !_SUBPROCESS_FANOUT_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -13,9 +13,12 @@
 #endif
 
 #include <sys/types.h>
+#include <sys/stat.h>
 #include <wait.h>
 #include <unistd.h>
 #include <errno.h>
+#include <limits.h>
+#include <spawn.h>
 
 #include <czmq.h>
 
@@ -24,6 +27,7 @@
 #include "src/common/libutil/log.h"
 #include "src/common/libutil/fdwalk.h"
 #include "src/common/libutil/fdutils.h"
+#include "src/common/libutil/monotime.h"
 
 #include "subprocess.h"
 #include "subprocess_private.h"
@@ -192,6 +196,7 @@ static int channel_local_setup (flux_subprocess_t *p,
         flux_log_error (p->h, "cmd_option_bufsize");
         goto error;
     }
+    c->window = c->credits = buffer_size;
 
     if ((channel_flags & CHANNEL_WRITE) && in_cb) {
         c->buffer_write_w = flux_buffer_write_watcher_create (p->reactor,
@@ -405,6 +410,58 @@ static void closefd_child (void *arg, int fd)
     close (fd);
 }
 
+#if HAVE_CLOSE_RANGE
+#define CLOSE_KEEP_MAX 64
+
+/* Close fds >= 3 except sync_fds[1] and channel fds with close_range(2),
+ * which costs a few system calls regardless of the number of open fds.
+ * Returns -1 if it can't be used, e.g. ENOSYS on an older kernel.
+ * Runs in the child after fork, so avoid malloc.
+ */
+static int close_range_child (flux_subprocess_t *p)
+{
+    struct subprocess_channel *c;
+    int keep[CLOSE_KEEP_MAX];
+    int n = 0;
+    unsigned int lo = 3;
+    int i, j;
+
+    keep[n++] = p->sync_fds[1];
+    c = zhash_first (p->channels);
+    while (c) {
+        if (c->child_fd >= 3) {
+            if (n == CLOSE_KEEP_MAX)
+                return -1;
+            (void) fd_unset_cloexec (c->child_fd);
+            keep[n++] = c->child_fd;
+        }
+        c = zhash_next (p->channels);
+    }
+    for (i = 1; i < n; i++) { // insertion sort
+        int fd = keep[i];
+        for (j = i; j > 0 && keep[j - 1] > fd; j--)
+            keep[j] = keep[j - 1];
+        keep[j] = fd;
+    }
+    for (i = 0; i < n; i++) {
+        if (keep[i] > lo && close_range (lo, keep[i] - 1, 0) < 0)
+            return -1;
+        if (keep[i] >= lo)
+            lo = keep[i] + 1;
+    }
+    return close_range (lo, ~0U, 0);
+}
+#endif
+
+static int close_child_extra_fds (flux_subprocess_t *p)
+{
+#if HAVE_CLOSE_RANGE
+    if (close_range_child (p) == 0)
+        return 0;
+#endif
+    return fdwalk (closefd_child, (void *) p);
+}
+
 /*  Signal parent that child is ready for exec(2) and wait for parent's
  *   signal to proceed. This is done by writing 1 byte to child side of
  *   socketpair, and waiting for parent to write one byte back.
@@ -503,7 +560,7 @@ static int local_child (flux_subprocess_t *p)
         _exit (1);
 
     // Close fds
-    if (fdwalk (closefd_child, (void *) p) < 0) {
+    if (close_child_extra_fds (p) < 0) {
         fprintf (stderr, "Failed closing all fds: %s", strerror (errno));
         _exit (1);
     }
@@ -594,8 +651,159 @@ static void child_watch_cb (flux_reactor_t *r, flux_watcher_t *w,
         subprocess_check_completed (p);
 }
 
+#if HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCLOSEFROM_NP \
+    && HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCHDIR_NP
+/* posix_spawn(3) does not copy the parent's page tables, which makes it
+ * much faster than fork(2) for a large broker.  It can be used if there
+ * are no hooks to run between fork and exec and no channel fds, which
+ * would have to survive the blanket close of fds >= 3.  Otherwise, and if
+ * the path or cwd are such that errors would be reported differently than
+ * by local_child(), use fork.
+ */
+static bool local_spawn_ok (flux_subprocess_t *p)
+{
+    struct subprocess_channel *c;
+    const char *cwd;
+
+    if (p->hooks.pre_exec || p->hooks.post_fork)
+        return false;
+    c = zhash_first (p->channels);
+    while (c) {
+        if (c->flags & CHANNEL_FD)
+            return false;
+        c = zhash_next (p->channels);
+    }
+    if ((cwd = flux_cmd_getcwd (p->cmd)) && access (cwd, X_OK) < 0)
+        return false;
+    return true;
+}
+
+/* Resolve 'name' to an absolute path like execvp(3) would, using PATH
+ * from the command's environment and not the parent's.  Return false if
+ * the result would not be absolute or is not executable.
+ */
+static bool local_spawn_path (flux_subprocess_t *p,
+                              const char *name,
+                              char *buf,
+                              int size)
+{
+    const char *path;
+    const char *dir;
+    struct stat sb;
+
+    if (strchr (name, '/')) {
+        if (name[0] != '/' || snprintf (buf, size, "%s", name) >= size)
+            return false;
+        return access (buf, X_OK) == 0;
+    }
+    if (!(path = flux_cmd_getenv (p->cmd, "PATH")))
+        path = "/bin:/usr/bin";
+    dir = path;
+    while (dir) {
+        const char *end = strchr (dir, ':');
+        int len = end ? end - dir : strlen (dir);
+
+        if (len == 0 || dir[0] != '/')
+            return false;
+        if (snprintf (buf, size, "%.*s/%s", len, dir, name) < size
+            && access (buf, X_OK) == 0
+            && stat (buf, &sb) == 0
+            && S_ISREG (sb.st_mode))
+            return true;
+        dir = end ? end + 1 : NULL;
+    }
+    return false;
+}
+
+static int local_spawn (flux_subprocess_t *p, const char *path)
+{
+    struct subprocess_channel *c;
+    posix_spawn_file_actions_t fa;
+    posix_spawnattr_t attr;
+    sigset_t mask;
+    short flags = POSIX_SPAWN_SETSIGMASK;
+    const char *cwd;
+    char **argv = NULL;
+    char **env = NULL;
+    int errnum;
+
+    posix_spawn_file_actions_init (&fa);
+    posix_spawnattr_init (&attr);
+
+    if (!(p->flags & FLUX_SUBPROCESS_FLAGS_STDIO_FALLTHROUGH)) {
+        if ((c = zhash_lookup (p->channels, "stdin")))
+            posix_spawn_file_actions_adddup2 (&fa, c->child_fd, STDIN_FILENO);
+        if ((c = zhash_lookup (p->channels, "stdout")))
+            posix_spawn_file_actions_adddup2 (&fa, c->child_fd, STDOUT_FILENO);
+        else
+            posix_spawn_file_actions_addclose (&fa, STDOUT_FILENO);
+        if ((c = zhash_lookup (p->channels, "stderr")))
+            posix_spawn_file_actions_adddup2 (&fa, c->child_fd, STDERR_FILENO);
+        else
+            posix_spawn_file_actions_addclose (&fa, STDERR_FILENO);
+    }
+    posix_spawn_file_actions_addclosefrom_np (&fa, 3);
+    if ((cwd = flux_cmd_getcwd (p->cmd)))
+        posix_spawn_file_actions_addchdir_np (&fa, cwd);
+
+    sigemptyset (&mask);
+    posix_spawnattr_setsigmask (&attr, &mask);
+    if (p->flags & FLUX_SUBPROCESS_FLAGS_SETPGRP) {
+        flags |= POSIX_SPAWN_SETPGROUP;
+        posix_spawnattr_setpgroup (&attr, 0);
+    }
+    posix_spawnattr_setflags (&attr, flags);
+
+    if (!(env = flux_cmd_env_expand (p->cmd))
+        || !(argv = flux_cmd_argv_expand (p->cmd))) {
+        errnum = ENOMEM;
+        goto out;
+    }
+    errnum = posix_spawn (&p->pid, path, &fa, &attr, argv, env);
+out:
+    free (argv);
+    free (env);
+    posix_spawn_file_actions_destroy (&fa);
+    posix_spawnattr_destroy (&attr);
+    return errnum;
+}
+#endif
+
 static int local_fork (flux_subprocess_t *p)
 {
+#if HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCLOSEFROM_NP \
+    && HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCHDIR_NP
+    char path[PATH_MAX + 1];
+
+    if (local_spawn_ok (p)
+        && local_spawn_path (p, flux_cmd_arg (p->cmd, 0), path, sizeof (path))) {
+        int errnum;
+
+        /* The child has exec'd (or failed to) when posix_spawn returns,
+         * so the sync socketpair is not used.
+         */
+        if ((errnum = local_spawn (p, path)) != 0) {
+            p->exec_failed_errno = errnum;
+            errno = errnum;
+            return -1;
+        }
+        p->posix_spawned = true;
+        p->pid_set = true;
+        close_child_fds (p);
+        close (p->sync_fds[0]);
+        p->sync_fds[0] = -1;
+        if (!(p->child_w = flux_child_watcher_create (p->reactor,
+                                                      p->pid,
+                                                      true,
+                                                      child_watch_cb,
+                                                      p))) {
+            flux_log_error (p->h, "flux_child_watcher_create");
+            return -1;
+        }
+        flux_watcher_start (p->child_w);
+        return 0;
+    }
+#endif
     if ((p->pid = fork ()) < 0)
         return -1;
 
@@ -662,6 +870,10 @@ static int local_release_child (flux_subprocess_t *p)
 
 static int local_exec (flux_subprocess_t *p)
 {
+    if (p->posix_spawned) {
+        p->state = FLUX_SUBPROCESS_RUNNING;
+        return 0;
+    }
     if ((p->exec_failed_errno = local_release_child (p)) != 0) {
         /*
          *  Reap child immediately. Expectation from caller is that
@@ -708,14 +920,18 @@ static int start_local_watchers (flux_subprocess_t *p)
 
 int subprocess_local_setup (flux_subprocess_t *p)
 {
+    struct timespec t0;
+
     if (local_setup_stdio (p) < 0)
         return -1;
     if (local_setup_channels (p) < 0)
         return -1;
+    monotime (&t0);
     if (local_fork (p) < 0)
         return -1;
     if (local_exec (p) < 0)
         return -1;
+    p->spawn_time = monotime_since (t0) / 1000.;
     if (start_local_watchers (p) < 0)
         return -1;
     return 0;
@@ -16,6 +16,7 @@
 #include <wait.h>
 #include <unistd.h>
 #include <errno.h>
+#include <arpa/inet.h>
 
 #include <czmq.h>
 #include <sodium.h>
@@ -146,6 +147,14 @@ static void process_new_state (flux_subprocess_t *p,
         state_change_start (p);
 }
 
+/* Return true if there is input to send and the server has room for it.
+ */
+static bool remote_write_ready (struct subprocess_channel *c)
+{
+    return flux_buffer_bytes (c->write_buffer) > 0
+           && (!c->p->flow_control || c->credits > 0);
+}
+
 static void remote_in_prep_cb (flux_reactor_t *r,
                                flux_watcher_t *w,
                                int revents,
@@ -153,7 +162,7 @@ static void remote_in_prep_cb (flux_reactor_t *r,
 {
     struct subprocess_channel *c = arg;
 
-    if (flux_buffer_bytes (c->write_buffer) > 0
+    if (remote_write_ready (c)
         || (c->closed && !c->write_eof_sent)
         || (c->p->state == FLUX_SUBPROCESS_EXITED
             || c->p->state == FLUX_SUBPROCESS_FAILED))
@@ -169,12 +178,16 @@ static int remote_write (struct subprocess_channel *c)
     bool eof = false;
     int rv = -1;
 
-    if (!(ptr = flux_buffer_read (c->write_buffer, -1, &lenp))) {
+    if (!(ptr = flux_buffer_read (c->write_buffer,
+                                  c->p->flow_control ? c->credits : -1,
+                                  &lenp))) {
         flux_log_error (c->p->h, "flux_buffer_read");
         goto error;
     }
 
     assert (lenp);
+    if (c->p->flow_control)
+        c->credits -= lenp;
 
     /* if closed / EOF about to be sent, can attach to this RPC to
      * avoid extra RPC */
@@ -250,7 +263,7 @@ static void remote_in_check_cb (flux_reactor_t *r,
 
     flux_watcher_stop (c->in_idle_w);
 
-    if (flux_buffer_bytes (c->write_buffer) > 0) {
+    if (remote_write_ready (c)) {
         if (remote_write (c) < 0) {
             flux_log_error (c->p->h, "remote_write");
             goto error;
@@ -302,6 +315,32 @@ static void remote_out_prep_cb (flux_reactor_t *r,
         flux_watcher_start (c->out_idle_w);
 }
 
+/* Credit the server with output consumed by the caller, once it adds
+ * up to a quarter of the window, so that credit messages are few.
+ */
+static void remote_credit (struct subprocess_channel *c)
+{
+    uint64_t consumed;
+    flux_future_t *f;
+
+    if (!c->p->flow_control || c->read_eof_received)
+        return;
+    consumed = c->recv_total - flux_buffer_bytes (c->read_buffer);
+    if (consumed - c->recv_acked < c->window / 4)
+        return;
+    if (!(f = flux_rpc_pack (c->p->h, "cmb.rexec.credit", c->p->rank,
+                             FLUX_RPC_NORESPONSE,
+                             "{ s:i s:s s:i }",
+                             "pid", c->p->pid,
+                             "stream", c->name,
+                             "credit", (int)(consumed - c->recv_acked)))) {
+        flux_log_error (c->p->h, "%s: flux_rpc_pack", __FUNCTION__);
+        return;
+    }
+    c->recv_acked = consumed;
+    flux_future_destroy (f);
+}
+
 static void remote_out_check_cb (flux_reactor_t *r,
                                  flux_watcher_t *w,
                                  int revents,
@@ -317,6 +356,7 @@ static void remote_out_check_cb (flux_reactor_t *r,
                  && flux_buffer_bytes (c->read_buffer) > 0)))
         || (!c->line_buffered && flux_buffer_bytes (c->read_buffer) > 0)) {
         c->output_f (c->p, c->name);
+        remote_credit (c);
     }
 
     if (!flux_buffer_bytes (c->read_buffer)
@@ -363,6 +403,7 @@ static int remote_channel_setup (flux_subprocess_t *p,
         flux_log_error (p->h, "cmd_option_bufsize");
         goto error;
     }
+    c->window = c->credits = buffer_size;
 
     if (channel_flags & CHANNEL_WRITE) {
         if (!(c->write_buffer = flux_buffer_create (buffer_size))) {
@@ -573,32 +614,21 @@ static int remote_state (flux_subprocess_t *p, flux_future_t *f,
     return 0;
 }
 
-static int remote_output (flux_subprocess_t *p, flux_future_t *f,
-                          int rank, pid_t pid)
+static int remote_output_write (flux_subprocess_t *p,
+                                const char *stream,
+                                int rank,
+                                pid_t pid,
+                                const char *data,
+                                int len,
+                                bool eof)
 {
     struct subprocess_channel *c;
-    const char *stream = NULL;
-    char *data = NULL;
-    int len = 0;
-    bool eof = false;
-    json_t *io = NULL;
-    int rv = -1;
-
-    if (flux_rpc_get_unpack (f, "{ s:o }", "io", &io)) {
-        flux_log_error (p->h, "flux_rpc_get_unpack EPROTO io");
-        goto cleanup;
-    }
-
-    if (iodecode (io, &stream, NULL, &data, &len, &eof) < 0) {
-        flux_log_error (p->h, "iodecode");
-        goto cleanup;
-    }
 
     if (!(c = zhash_lookup (p->channels, stream))) {
         flux_log_error (p->h, "invalid channel received: rank = %d, pid = %d, stream = %s",
                  rank, pid, stream);
         errno = EPROTO;
-        goto cleanup;
+        return -1;
     }
 
     if (data && len) {
@@ -606,7 +636,7 @@ static int remote_output (flux_subprocess_t *p, flux_future_t *f,
 
         if ((tmp = flux_buffer_write (c->read_buffer, data, len)) < 0) {
             flux_log_error (p->h, "flux_buffer_write");
-            goto cleanup;
+            return -1;
         }
 
         /* add list of msgs if there is overflow? */
@@ -615,7 +645,22 @@ static int remote_output (flux_subprocess_t *p, flux_future_t *f,
             flux_log_error (p->h, "channel buffer error: rank = %d pid = %d, stream = %s, len = %d",
                             rank, pid, stream, len);
             errno = EOVERFLOW;
-            goto cleanup;
+            return -1;
+        }
+        c->recv_total += len;
+
+        /* With flow control, a line that fills the buffer cannot be
+         * consumed, and the server will send nothing more.
+         */
+        if (c->p->flow_control
+            && c->line_buffered
+            && flux_buffer_space (c->read_buffer) == 0
+            && !flux_buffer_has_line (c->read_buffer)) {
+            flux_log (p->h, LOG_ERR,
+                      "line exceeds buffer: rank = %d pid = %d, stream = %s",
+                      rank, pid, stream);
+            errno = EOVERFLOW;
+            return -1;
         }
     }
     if (eof) {
@@ -623,6 +668,31 @@ static int remote_output (flux_subprocess_t *p, flux_future_t *f,
         if (flux_buffer_readonly (c->read_buffer) < 0)
             flux_log_error (p->h, "flux_buffer_readonly");
     }
+    return 0;
+}
+
+static int remote_output (flux_subprocess_t *p, flux_future_t *f,
+                          int rank, pid_t pid)
+{
+    const char *stream = NULL;
+    char *data = NULL;
+    int len = 0;
+    bool eof = false;
+    json_t *io = NULL;
+    int rv = -1;
+
+    if (flux_rpc_get_unpack (f, "{ s:o }", "io", &io)) {
+        flux_log_error (p->h, "flux_rpc_get_unpack EPROTO io");
+        goto cleanup;
+    }
+
+    if (iodecode (io, &stream, NULL, &data, &len, &eof) < 0) {
+        flux_log_error (p->h, "iodecode");
+        goto cleanup;
+    }
+
+    if (remote_output_write (p, stream, rank, pid, data, len, eof) < 0)
+        goto cleanup;
 
     rv = 0;
 cleanup:
@@ -630,6 +700,66 @@ cleanup:
     return rv;
 }
 
+/* Return true if response payload is a binary output frame.
+ */
+static bool remote_output_is_binary (const void *buf, int len)
+{
+    uint32_t magic;
+
+    if (!buf || len < sizeof (struct rexec_output_header))
+        return false;
+    memcpy (&magic, buf, sizeof (magic));
+    return ntohl (magic) == REXEC_OUTPUT_MAGIC;
+}
+
+static int remote_output_binary (flux_subprocess_t *p,
+                                 const void *buf,
+                                 int len)
+{
+    struct rexec_output_header hdr;
+    const char *data = (const char *)buf + sizeof (hdr);
+    char stream[256];
+    int namelen;
+
+    memcpy (&hdr, buf, sizeof (hdr));
+    namelen = ntohl (hdr.namelen);
+    len -= sizeof (hdr);
+    if (namelen >= sizeof (stream) || namelen > len) {
+        flux_log (p->h, LOG_ERR, "%s: malformed output frame", __FUNCTION__);
+        errno = EPROTO;
+        return -1;
+    }
+    memcpy (stream, data, namelen);
+    stream[namelen] = '\0';
+    return remote_output_write (p,
+                                stream,
+                                ntohl (hdr.rank),
+                                ntohl (hdr.pid),
+                                data + namelen,
+                                len - namelen,
+                                ntohl (hdr.flags) & REXEC_OUTPUT_EOF);
+}
+
+static int remote_credit_received (flux_subprocess_t *p, flux_future_t *f)
+{
+    struct subprocess_channel *c;
+    const char *stream;
+    int credit;
+
+    if (flux_rpc_get_unpack (f, "{ s:s s:i }",
+                             "stream", &stream,
+                             "credit", &credit) < 0) {
+        flux_log_error (p->h, "%s: flux_rpc_get_unpack", __FUNCTION__);
+        return -1;
+    }
+    if (!(c = zhash_lookup (p->channels, stream)) || credit < 0) {
+        errno = EPROTO;
+        return -1;
+    }
+    c->credits += credit;
+    return 0;
+}
+
 static void remote_completion (flux_subprocess_t *p)
 {
     p->remote_completed = true;
@@ -645,7 +775,16 @@ static void remote_exec_cb (flux_future_t *f, void *arg)
     const char *type;
     int rank;
     pid_t pid;
+    const void *buf;
+    int len;
 
+    if (flux_rpc_get_raw (f, &buf, &len) == 0
+        && remote_output_is_binary (buf, len)) {
+        if (remote_output_binary (p, buf, len) < 0)
+            goto error;
+        flux_future_reset (f);
+        return;
+    }
     if (flux_rpc_get_unpack (f, "{ s:s s:i }",
                              "type", &type,
                              "rank", &rank) < 0) {
@@ -673,6 +812,11 @@ static void remote_exec_cb (flux_future_t *f, void *arg)
             goto error;
         flux_future_reset (f);
     }
+    else if (!strcmp (type, "credit")) {
+        if (remote_credit_received (p, f) < 0)
+            goto error;
+        flux_future_reset (f);
+    }
     else if (!strcmp (type, "complete")) {
         remote_completion (p);
         flux_future_destroy (f);
@@ -715,6 +859,13 @@ static void remote_continuation_cb (flux_future_t *f, void *arg)
     }
 
     if (!strcmp (type, "start")) {
+        int flow_control = 0;
+        if (flux_rpc_get_unpack (f, "{ s?b }",
+                                 "flow_control", &flow_control) < 0) {
+            flux_log_error (p->h, "%s: flux_rpc_get_unpack", __FUNCTION__);
+            goto error;
+        }
+        p->flow_control = flow_control;
         flux_future_reset (f);
         if (flux_future_then (f, -1., remote_exec_cb, p) < 0) {
             flux_log_error (p->h, "flux_future_then");
@@ -757,11 +908,13 @@ int remote_exec (flux_subprocess_t *p)
      * don't care if user doesn't want it.
      */
     if (!(f = flux_rpc_pack (p->h, "cmb.rexec", p->rank, 0,
-                             "{s:s s:i s:i s:i}",
+                             "{s:s s:i s:i s:i s:b s:b}",
                              "cmd", cmd_str,
                              "on_channel_out", p->ops.on_channel_out ? 1 : 0,
                              "on_stdout", p->ops.on_stdout ? 1 : 0,
-                             "on_stderr", p->ops.on_stderr ? 1 : 0))) {
+                             "on_stderr", p->ops.on_stderr ? 1 : 0,
+                             "binary_output", 1,
+                             "flow_control", 1))) {
         flux_log_error (p->h, "flux_rpc");
         goto error;
     }
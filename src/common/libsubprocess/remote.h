@@ -11,8 +11,27 @@
 #ifndef _SUBPROCESS_REMOTE_H
 #define _SUBPROCESS_REMOTE_H
 
+#include <stdint.h>
+
 #include "subprocess.h"
 
+/* If the rexec request sets "binary_output", output responses are sent
+ * as raw payloads: this header, the stream name (namelen bytes, not NUL
+ * terminated), then the data.  Header fields are in network byte order.
+ * The high order byte of the magic number is zero, so a frame cannot be
+ * mistaken for a JSON response.
+ */
+#define REXEC_OUTPUT_MAGIC  0x00726f31
+#define REXEC_OUTPUT_EOF    1
+
+struct rexec_output_header {
+    uint32_t magic;
+    uint32_t rank;
+    uint32_t pid;
+    uint32_t flags;
+    uint32_t namelen;
+};
+
 int subprocess_remote_setup (flux_subprocess_t *p);
 
 int remote_exec (flux_subprocess_t *p);
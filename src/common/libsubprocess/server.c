@@ -16,6 +16,7 @@
 #include <wait.h>
 #include <unistd.h>
 #include <errno.h>
+#include <arpa/inet.h>
 
 #include <czmq.h>
 #include <sodium.h>
@@ -33,31 +34,85 @@
 #include "command.h"
 #include "remote.h"
 #include "server.h"
+#include "fanout.h"
 #include "util.h"
 
 static const char *auxkey = "flux::rexec";
 
+/* Output is coalesced into one response of up to this many bytes while
+ * the reactor is busy.  Pending output is sent when the reactor goes idle,
+ * or after at most rexec_coalesce_delay seconds.
+ */
+static const int rexec_coalesce_size = 65536;
+static const double rexec_coalesce_delay = 0.01;
+
 struct rexec {
     const flux_msg_t *msg;          // rexec request message
     flux_subprocess_server_t *s;    // server context
+    flux_subprocess_t *p;
+    bool binary;                    // client accepts binary output frames
+    bool flow_control;              // client grants output credits
+    char *stream;                   // stream of pending output, if any
+    char *buf;                      // pending output
+    int len;
+    int size;
+    flux_watcher_t *idle_w;
+    flux_watcher_t *timer_w;
+    flux_watcher_t *input_w;        // credits client as input drains
 };
 
+static int rexec_flush (struct rexec *rex);
+static void rexec_input_cb (flux_reactor_t *r,
+                            flux_watcher_t *w,
+                            int revents,
+                            void *arg);
+static void rexec_flush_cb (flux_reactor_t *r,
+                            flux_watcher_t *w,
+                            int revents,
+                            void *arg);
+
 static void rexec_destroy (struct rexec *rex)
 {
     if (rex) {
+        int saved_errno = errno;
         flux_msg_decref (rex->msg);
-        ERRNO_SAFE_WRAP (free, rex);
+        flux_watcher_destroy (rex->idle_w);
+        flux_watcher_destroy (rex->timer_w);
+        flux_watcher_destroy (rex->input_w);
+        free (rex->stream);
+        free (rex->buf);
+        free (rex);
+        errno = saved_errno;
     }
 }
 
 static struct rexec *rexec_create (const flux_msg_t *msg,
-                                   flux_subprocess_server_t *s)
+                                   flux_subprocess_server_t *s,
+                                   flux_subprocess_t *p,
+                                   bool binary,
+                                   bool flow_control)
 {
+    flux_reactor_t *r = flux_get_reactor (s->h);
     struct rexec *rex;
 
-    if ((rex = calloc (1, sizeof (*rex)))) {
-        rex->msg = flux_msg_incref (msg);
-        rex->s = s;
+    if (!(rex = calloc (1, sizeof (*rex))))
+        return NULL;
+    rex->msg = flux_msg_incref (msg);
+    rex->s = s;
+    rex->p = p;
+    rex->binary = binary;
+    rex->flow_control = flow_control;
+    if (!(rex->idle_w = flux_idle_watcher_create (r, rexec_flush_cb, rex))
+        || !(rex->input_w = flux_prepare_watcher_create (r,
+                                                         rexec_input_cb,
+                                                         rex))
+        || !(rex->timer_w = flux_timer_watcher_create (r,
+                                                       rexec_coalesce_delay,
+                                                       0.,
+                                                       rexec_flush_cb,
+                                                       rex))) {
+        rexec_destroy (rex);
+        return NULL;
     }
     return rex;
 }
@@ -152,6 +207,8 @@ static void rexec_completion_cb (flux_subprocess_t *p)
 
     assert (rex != NULL);
 
+    if (rexec_flush (rex) < 0)
+        flux_log_error (rex->s->h, "%s: rexec_flush", __FUNCTION__);
     if (p->state != FLUX_SUBPROCESS_FAILED) {
         /* no fallback if this fails */
         if (flux_respond_pack (rex->s->h, rex->msg, "{s:s s:i}",
@@ -190,6 +247,8 @@ static void rexec_state_change_cb (flux_subprocess_t *p,
 
     assert (rex != NULL);
 
+    if (rexec_flush (rex) < 0)
+        flux_log_error (rex->s->h, "%s: rexec_flush", __FUNCTION__);
     if (state == FLUX_SUBPROCESS_RUNNING) {
         if (store_pid (rex->s, p) < 0)
             goto error;
@@ -229,6 +288,39 @@ error:
     internal_fatal (rex->s, p);
 }
 
+/* Send output as a binary frame (see remote.h).
+ */
+static int rexec_output_binary (flux_subprocess_t *p,
+                                const char *stream,
+                                flux_subprocess_server_t *s,
+                                const flux_msg_t *msg,
+                                const char *data,
+                                int len,
+                                bool eof)
+{
+    struct rexec_output_header hdr;
+    int namelen = strlen (stream);
+    char *frame;
+    int rv;
+
+    hdr.magic = htonl (REXEC_OUTPUT_MAGIC);
+    hdr.rank = htonl (s->rank);
+    hdr.pid = htonl (flux_subprocess_pid (p));
+    hdr.flags = htonl (eof ? REXEC_OUTPUT_EOF : 0);
+    hdr.namelen = htonl (namelen);
+    if (!(frame = malloc (sizeof (hdr) + namelen + len)))
+        return -1;
+    memcpy (frame, &hdr, sizeof (hdr));
+    memcpy (frame + sizeof (hdr), stream, namelen);
+    if (len > 0)
+        memcpy (frame + sizeof (hdr) + namelen, data, len);
+    if ((rv = flux_respond_raw (s->h, msg, frame, sizeof (hdr) + namelen + len))
+        < 0)
+        flux_log_error (s->h, "%s: flux_respond_raw", __FUNCTION__);
+    ERRNO_SAFE_WRAP (free, frame);
+    return rv;
+}
+
 static int rexec_output (flux_subprocess_t *p,
                          const char *stream,
                          flux_subprocess_server_t *s,
@@ -237,10 +329,14 @@ static int rexec_output (flux_subprocess_t *p,
                          int len,
                          bool eof)
 {
+    struct rexec *rex = flux_subprocess_aux_get (p, auxkey);
     json_t *io = NULL;
     char rankstr[64];
     int rv = -1;
 
+    if (rex && rex->binary)
+        return rexec_output_binary (p, stream, s, msg, data, len, eof);
+
     snprintf (rankstr, sizeof (rankstr), "%d", s->rank);
     if (!(io = ioencode (stream, rankstr, data, len, eof))) {
         flux_log_error (s->h, "%s: ioencode", __FUNCTION__);
@@ -262,24 +358,135 @@ error:
     return rv;
 }
 
+/* Send pending output, if any.
+ */
+static int rexec_flush (struct rexec *rex)
+{
+    int rc = 0;
+
+    if (rex->len > 0) {
+        rc = rexec_output (rex->p,
+                           rex->stream,
+                           rex->s,
+                           rex->msg,
+                           rex->buf,
+                           rex->len,
+                           false);
+        rex->len = 0;
+    }
+    flux_watcher_stop (rex->idle_w);
+    flux_watcher_stop (rex->timer_w);
+    return rc;
+}
+
+static void rexec_flush_cb (flux_reactor_t *r,
+                            flux_watcher_t *w,
+                            int revents,
+                            void *arg)
+{
+    struct rexec *rex = arg;
+
+    if (rexec_flush (rex) < 0)
+        internal_fatal (rex->s, rex->p);
+}
+
+/* Add output to the pending buffer, flushing first if it is for a
+ * different stream, so that output order is preserved across streams.
+ * Chunks that fill the buffer by themselves are sent directly.
+ */
+static int rexec_append (struct rexec *rex,
+                         const char *stream,
+                         const char *data,
+                         int len)
+{
+    if (rex->len > 0 && strcmp (rex->stream, stream) != 0) {
+        if (rexec_flush (rex) < 0)
+            return -1;
+    }
+    if (rex->len == 0 && len >= rexec_coalesce_size)
+        return rexec_output (rex->p, stream, rex->s, rex->msg,
+                             data, len, false);
+    if (rex->len == 0) {
+        if (!rex->stream || strcmp (rex->stream, stream) != 0) {
+            char *cpy;
+            if (!(cpy = strdup (stream)))
+                return -1;
+            free (rex->stream);
+            rex->stream = cpy;
+        }
+        flux_watcher_start (rex->idle_w);
+        flux_timer_watcher_reset (rex->timer_w, rexec_coalesce_delay, 0.);
+        flux_watcher_start (rex->timer_w);
+    }
+    if (rex->len + len > rex->size) {
+        int size = rex->len + len;
+        char *buf;
+        if (size < rexec_coalesce_size)
+            size = rexec_coalesce_size;
+        if (!(buf = realloc (rex->buf, size)))
+            return -1;
+        rex->buf = buf;
+        rex->size = size;
+    }
+    memcpy (rex->buf + rex->len, data, len);
+    rex->len += len;
+    if (rex->len >= rexec_coalesce_size)
+        return rexec_flush (rex);
+    return 0;
+}
+
+/* With flow control, read no more output than the client has credited.
+ * If there is output but no credit, stop reading the stream until credit
+ * arrives.  Output then backs up into the pipe and stalls the process.
+ */
 static void rexec_output_cb (flux_subprocess_t *p, const char *stream)
 {
     struct rexec *rex = flux_subprocess_aux_get (p, auxkey);
-    const char *ptr;
-    int lenp;
+    struct subprocess_channel *c = zhash_lookup (p->channels, stream);
+    flux_buffer_t *fb;
+    struct iovec iov[2];
+    int maxlen = -1;
+    int iovcnt;
+    int lenp = 0;
+    int i;
 
     assert (rex != NULL);
+    assert (c != NULL);
 
-    if (!(ptr = flux_subprocess_read (p, stream, -1, &lenp))) {
-        flux_log_error (rex->s->h, "%s: flux_subprocess_read", __FUNCTION__);
+    if (!(fb = flux_buffer_read_watcher_get_buffer (c->buffer_read_w)))
         goto error;
+
+    if (rex->flow_control && flux_buffer_bytes (fb) > 0) {
+        if (c->credits == 0) {
+            if (flux_subprocess_stream_stop (p, stream) < 0)
+                goto error;
+            return;
+        }
+        maxlen = c->credits;
+    }
+
+    /* Append output to the response straight from the channel buffer,
+     * then consume it.
+     */
+    if ((iovcnt = flux_buffer_peek_iov (fb, maxlen, iov)) < 0) {
+        flux_log_error (rex->s->h, "%s: flux_buffer_peek_iov", __FUNCTION__);
+        goto error;
+    }
+    for (i = 0; i < iovcnt; i++) {
+        if (rexec_append (rex, stream, iov[i].iov_base, iov[i].iov_len) < 0)
+            goto error;
+        lenp += iov[i].iov_len;
     }
 
     if (lenp) {
-        if (rexec_output (p, stream, rex->s, rex->msg, ptr, lenp, false) < 0)
+        if (rex->flow_control)
+            c->credits -= lenp;
+        if (flux_buffer_drop (fb, lenp) < 0)
             goto error;
     }
     else {
+        if (rexec_flush (rex) < 0)
+            goto error;
         if (rexec_output (p, stream, rex->s, rex->msg, NULL, 0, true) < 0)
             goto error;
     }
@@ -306,13 +513,17 @@ static void server_exec_cb (flux_t *h, flux_msg_handler_t *mh,
         .on_stderr = rexec_output_cb,
     };
     int on_channel_out, on_stdout, on_stderr;
+    int binary_output = 0;
+    int flow_control = 0;
     char **env = NULL;
 
-    if (flux_request_unpack (msg, NULL, "{s:s s:i s:i s:i}",
+    if (flux_request_unpack (msg, NULL, "{s:s s:i s:i s:i s?b s?b}",
                              "cmd", &cmd_str,
                              "on_channel_out", &on_channel_out,
                              "on_stdout", &on_stdout,
-                             "on_stderr", &on_stderr))
+                             "on_stderr", &on_stderr,
+                             "binary_output", &binary_output,
+                             "flow_control", &flow_control))
         goto error;
 
     if (!on_channel_out)
@@ -349,9 +560,10 @@ static void server_exec_cb (flux_t *h, flux_msg_handler_t *mh,
     if (flux_cmd_setenvf (cmd, 1, "FLUX_URI", "%s", s->local_uri) < 0)
         goto error;
 
-    if (flux_respond_pack (s->h, msg, "{s:s s:i}",
+    if (flux_respond_pack (s->h, msg, "{s:s s:i s:b}",
                            "type", "start",
-                           "rank", s->rank) < 0) {
+                           "rank", s->rank,
+                           "flow_control", flow_control) < 0) {
         flux_log_error (s->h, "%s: flux_respond_pack", __FUNCTION__);
         goto error;
     }
@@ -373,7 +585,14 @@ static void server_exec_cb (flux_t *h, flux_msg_handler_t *mh,
         goto cleanup;
     }
 
-    if (!(rex = rexec_create (msg, s)))
+    s->spawn_count++;
+    if (p->posix_spawned)
+        s->spawn_fast_count++;
+    s->spawn_time_total += p->spawn_time;
+    if (s->spawn_time_max < p->spawn_time)
+        s->spawn_time_max = p->spawn_time;
+
+    if (!(rex = rexec_create (msg, s, p, binary_output, flow_control)))
         goto error;
     if (flux_subprocess_aux_set (p,
                                 auxkey,
@@ -396,6 +615,49 @@ cleanup:
     flux_subprocess_unref (p);
 }
 
+/* Credit the client with input written to the subprocess, once it adds
+ * up to a quarter of the window.  Runs each reactor loop while input is
+ * buffered.
+ */
+static void rexec_input_cb (flux_reactor_t *r,
+                            flux_watcher_t *w,
+                            int revents,
+                            void *arg)
+{
+    struct rexec *rex = arg;
+    struct subprocess_channel *c;
+    bool busy = false;
+
+    c = zhash_first (rex->p->channels);
+    while (c) {
+        flux_buffer_t *fb;
+        uint64_t drained;
+
+        if (c->buffer_write_w
+            && (fb = flux_buffer_write_watcher_get_buffer (c->buffer_write_w))) {
+            drained = c->recv_total - flux_buffer_bytes (fb);
+            if (drained - c->recv_acked >= c->window / 4) {
+                if (flux_respond_pack (rex->s->h, rex->msg,
+                                       "{s:s s:i s:s s:i}",
+                                       "type", "credit",
+                                       "rank", rex->s->rank,
+                                       "stream", c->name,
+                                       "credit",
+                                       (int)(drained - c->recv_acked)) < 0)
+                    flux_log_error (rex->s->h,
+                                    "%s: flux_respond_pack",
+                                    __FUNCTION__);
+                c->recv_acked = drained;
+            }
+            if (flux_buffer_bytes (fb) > 0)
+                busy = true;
+        }
+        c = zhash_next (rex->p->channels);
+    }
+    if (!busy)
+        flux_watcher_stop (w);
+}
+
 static int write_subprocess (flux_subprocess_server_t *s, flux_subprocess_t *p,
                              const char *stream, const char *data, int len)
 {
@@ -475,8 +737,16 @@ static void server_write_cb (flux_t *h, flux_msg_handler_t *mh,
         goto out;
 
     if (data && len) {
+        struct rexec *rex = flux_subprocess_aux_get (p, auxkey);
+        struct subprocess_channel *c;
+
         if (write_subprocess (s, p, stream, data, len) < 0)
             goto error;
+        if (rex && rex->flow_control
+                && (c = zhash_lookup (p->channels, stream))) {
+            c->recv_total += len;
+            flux_watcher_start (rex->input_w);
+        }
     }
     if (eof) {
         if (close_subprocess (s, p, stream) < 0)
@@ -492,6 +762,42 @@ error:
     internal_fatal (s, p);
 }
 
+static void server_credit_cb (flux_t *h, flux_msg_handler_t *mh,
+                              const flux_msg_t *msg, void *arg)
+{
+    flux_subprocess_server_t *s = arg;
+    struct subprocess_channel *c;
+    flux_subprocess_t *p;
+    const char *stream;
+    pid_t pid;
+    int credit;
+
+    /* no response */
+    if (flux_request_unpack (msg, NULL, "{ s:i s:s s:i }",
+                             "pid", &pid,
+                             "stream", &stream,
+                             "credit", &credit) < 0) {
+        flux_log_error (s->h, "%s: flux_request_unpack", __FUNCTION__);
+        return;
+    }
+    /* The process may already be gone */
+    if (!(p = lookup_pid (s, pid)))
+        return;
+    if (!(c = zhash_lookup (p->channels, stream))
+        || !(c->flags & CHANNEL_READ)
+        || credit < 0) {
+        flux_log (s->h, LOG_ERR, "%s: invalid credit for stream %s",
+                  __FUNCTION__, stream);
+        return;
+    }
+    /* Restart the stream if it was stopped for lack of credit.
+     */
+    if (c->credits == 0 && credit > 0
+        && flux_subprocess_stream_start (p, stream) < 0)
+        flux_log_error (s->h, "%s: flux_subprocess_stream_start", __FUNCTION__);
+    c->credits += credit;
+}
+
 static void server_signal_cb (flux_t *h, flux_msg_handler_t *mh,
                               const flux_msg_t *msg, void *arg)
 {
@@ -602,6 +908,28 @@ error:
     json_decref (procs);
 }
 
+static void server_stats_cb (flux_t *h, flux_msg_handler_t *mh,
+                             const flux_msg_t *msg, void *arg)
+{
+    flux_subprocess_server_t *s = arg;
+
+    if (flux_request_decode (msg, NULL, NULL) < 0)
+        goto error;
+    if (flux_respond_pack (h, msg, "{s:i s:{s:i s:i s:f s:f}}",
+                           "rank", s->rank,
+                           "spawn",
+                             "count", s->spawn_count,
+                             "posix-spawn", s->spawn_fast_count,
+                             "time-total", s->spawn_time_total,
+                             "time-max", s->spawn_time_max) < 0)
+        flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
+    return;
+
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+}
+
 int server_start (flux_subprocess_server_t *s, const char *prefix)
 {
     /* rexec.processes is primarily for testing */
@@ -610,9 +938,11 @@ int server_start (flux_subprocess_server_t *s, const char *prefix)
         { FLUX_MSGTYPE_REQUEST, "rexec.write",  server_write_cb, 0 },
         { FLUX_MSGTYPE_REQUEST, "rexec.signal", server_signal_cb, 0 },
         { FLUX_MSGTYPE_REQUEST, "rexec.processes", server_processes_cb, 0 },
+        { FLUX_MSGTYPE_REQUEST, "rexec.credit", server_credit_cb, 0 },
+        { FLUX_MSGTYPE_REQUEST, "rexec.stats",  server_stats_cb, 0 },
         FLUX_MSGHANDLER_TABLE_END,
     };
-    char *topic_globs[4] = {NULL, NULL, NULL, NULL};
+    char *topic_globs[6] = {NULL, NULL, NULL, NULL, NULL, NULL};
     int rv = -1;
 
     assert (prefix);
@@ -625,14 +955,22 @@ int server_start (flux_subprocess_server_t *s, const char *prefix)
         goto cleanup;
     if (asprintf (&topic_globs[3], "%s.rexec.processes", prefix) < 0)
         goto cleanup;
+    if (asprintf (&topic_globs[4], "%s.rexec.credit", prefix) < 0)
+        goto cleanup;
+    if (asprintf (&topic_globs[5], "%s.rexec.stats", prefix) < 0)
+        goto cleanup;
 
     htab[0].topic_glob = (const char *)topic_globs[0];
     htab[1].topic_glob = (const char *)topic_globs[1];
     htab[2].topic_glob = (const char *)topic_globs[2];
     htab[3].topic_glob = (const char *)topic_globs[3];
+    htab[4].topic_glob = (const char *)topic_globs[4];
+    htab[5].topic_glob = (const char *)topic_globs[5];
 
     if (flux_msg_handler_addvec (s->h, htab, s, &s->handlers) < 0)
         goto cleanup;
+    if (!(s->fanout = fanout_create (s, prefix)))
+        goto cleanup;
 
     rv = 0;
 cleanup:
@@ -640,12 +978,16 @@ cleanup:
     free (topic_globs[1]);
     free (topic_globs[2]);
     free (topic_globs[3]);
+    free (topic_globs[4]);
+    free (topic_globs[5]);
     return rv;
 }
 
 void server_stop (flux_subprocess_server_t *s)
 {
     flux_msg_handler_delvec (s->handlers);
+    fanout_destroy (s->fanout);
+    s->fanout = NULL;
 }
 
 static void server_signal_subprocess (flux_subprocess_t *p, int signum)
@@ -669,6 +1011,7 @@ int server_signal_subprocesses (flux_subprocess_server_t *s, int signum)
         server_signal_subprocess (p, signum);
         p = zhash_next (s->subprocesses);
     }
+    fanout_signal_all (s->fanout, signum);
 
     return 0;
 }
@@ -702,6 +1045,7 @@ int server_terminate_by_uuid (flux_subprocess_server_t *s,
         terminate_uuid (p, id);
         p = zhash_next (s->subprocesses);
     }
+    fanout_disconnect (s->fanout, id);
 
     return 0;
 }
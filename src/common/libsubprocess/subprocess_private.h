@@ -63,6 +63,15 @@ struct subprocess_channel {
 
     /* misc */
     bool line_buffered;         /* for buffer_read_w / read_buffer */
+
+    /* remote flow control: credits are bytes the peer can accept,
+     * recv counters track bytes received into our buffer and how many
+     * of those have been consumed and credited back to the peer.
+     */
+    int window;                 /* buffer size, initial credit */
+    int credits;
+    uint64_t recv_total;
+    uint64_t recv_acked;
 };
 
 struct flux_subprocess {
@@ -109,6 +118,8 @@ struct flux_subprocess {
     bool in_hook;                   /* if presently in a hook */
     flux_watcher_t *child_w;
     flux_subprocess_hooks_t hooks;
+    double spawn_time;              /* secs from fork/spawn until exec */
+    bool posix_spawned;             /* started by posix_spawn(3) */
 
     /* remote */
 
@@ -116,6 +127,7 @@ struct flux_subprocess {
     bool remote_completed;      /* if remote has completed */
     int failed_errno;           /* Holds errno if FAILED state reached */
     int signal_pending;         /* signal sent while starting */
+    bool flow_control;          /* peer supports credit flow control */
 };
 
 struct flux_subprocess_server {
@@ -126,6 +138,13 @@ struct flux_subprocess_server {
     uint32_t rank;
     zhash_t *subprocesses;
     flux_msg_handler_t **handlers;
+    struct fanout *fanout;
+
+    /* spawn latency, for rexec.stats */
+    int spawn_count;
+    int spawn_fast_count;
+    double spawn_time_total;
+    double spawn_time_max;
 
     /* for teardown / termination */
     flux_watcher_t *terminate_timer_w;
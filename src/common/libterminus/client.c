@@ -48,6 +48,9 @@ struct flux_pty_client {
     char *service;
     bool attached;
 
+    int backlog;        /* server output backlog if flow control, else 0 */
+    int uncredited;     /* data bytes consumed, not yet credited */
+
     flux_watcher_t *fdw;  /* fd watcher for STDIN */
     flux_watcher_t *sw;   /* signal watcher       */
 
@@ -231,8 +234,13 @@ static int setup_terminal (struct flux_pty_client *c)
     return 0;
 }
 
-static void pty_client_attached (struct flux_pty_client *c)
+static void pty_client_attached (struct flux_pty_client *c,
+                                 flux_future_t *f)
 {
+    /*  Server includes its backlog if it supports flow control */
+    if (flux_rpc_get_unpack (f, "{s?i}", "backlog", &c->backlog) < 0)
+        c->backlog = 0;
+
     /*  Setup terminal, start watching stdin for data */
     if (!(c->flags & FLUX_PTY_CLIENT_NORAW))
         (void) setup_terminal (c);
@@ -247,6 +255,27 @@ static void pty_client_attached (struct flux_pty_client *c)
     c->attached = true;
 }
 
+/*  Credit the server with consumed data once a quarter of its backlog
+ *   has been consumed, so that credit messages are few.
+ */
+static void pty_client_credit (struct flux_pty_client *c, int len)
+{
+    flux_future_t *f;
+
+    c->uncredited += len;
+    if (c->uncredited < c->backlog / 4)
+        return;
+    if (!(f = flux_rpc_pack (c->h, c->service, c->rank, FLUX_RPC_NORESPONSE,
+                             "{s:s s:i}",
+                             "type", "credit",
+                             "credit", c->uncredited))) {
+        llog_error (c, "flux_rpc_pack type=credit: %s", flux_strerror (errno));
+        return;
+    }
+    flux_future_destroy (f);
+    c->uncredited = 0;
+}
+
 static void pty_client_data (struct flux_pty_client *c, flux_future_t *f)
 {
     const char *data;
@@ -260,6 +289,19 @@ static void pty_client_data (struct flux_pty_client *c, flux_future_t *f)
         llog_error (c, "data decode failed: %s", strerror (errno));
         return;
     }
+    if (c->backlog > 0)
+        pty_client_credit (c, len);
+}
+
+static void pty_client_catchup (struct flux_pty_client *c, flux_future_t *f)
+{
+    int dropped;
+
+    if (flux_rpc_get_unpack (f, "{s:i}", "dropped", &dropped) < 0) {
+        llog_error (c, "unpack: %s", future_strerror (f, errno));
+        return;
+    }
+    llog_debug (c, "output too slow: %d bytes dropped", dropped);
 }
 
 static void client_resize_cb (flux_future_t *f, void *arg)
@@ -334,9 +376,11 @@ static void pty_server_cb (flux_future_t *f, void *arg)
         return;
     }
     if (strcmp (type, "attach") == 0)
-        pty_client_attached (c);
+        pty_client_attached (c, f);
     else if (strcmp (type, "data") == 0)
         pty_client_data (c, f);
+    else if (strcmp (type, "catchup") == 0)
+        pty_client_catchup (c, f);
     else if (strcmp (type, "resize") == 0)
         pty_client_resize (c);
     else if (strcmp (type, "exit") == 0)
@@ -478,12 +522,13 @@ int flux_pty_client_attach (struct flux_pty_client *c,
     mode = c->flags & FLUX_PTY_CLIENT_STDIN_PIPE ? "wo" : "rw";
 
     if (!(f = flux_rpc_pack (h, service, rank, FLUX_RPC_STREAMING,
-                             "{s:s s:s s:{s:i s:i}}",
+                             "{s:s s:s s:{s:i s:i} s:b}",
                              "type", "attach",
                              "mode", mode,
                              "winsize",
                               "rows", ws.ws_row,
-                              "cols", ws.ws_col))) {
+                              "cols", ws.ws_col,
+                             "flow_control", 1))) {
             llog_error (c, "flux_rpc_pack: %s", flux_strerror (errno));
             return -1;
     }
@@ -16,11 +16,14 @@
  *  PROTOCOL:
  *
  *  Client attach to server:
- *  { "type":"attach", "mode":s, "winsize":{"rows":i,"colums":i}}
- *  where mode is one of "rw", "ro", or "rw"
+ *  { "type":"attach", "mode":s, "winsize":{"rows":i,"colums":i},
+ *    "flow_control"?:b }
+ *  where mode is one of "rw", "ro", or "rw", and flow_control=true
+ *  requests a bounded output backlog (see OUTPUT below)
  *
  *  Server response to attach:
- *  { "type":"attach" }
+ *  { "type":"attach", "backlog"?:i }
+ *  where backlog is included if flow control was requested
  *
  *  Resize request: (client->server or server->client)
  *  { "type":"resize", "winsize"?{"rows":i,"colums":i} }
@@ -28,6 +31,12 @@
  *  Client/server write raw data to tty (string is utf-8)
  *  { "type":"data", "data":s% }
  *
+ *  Client credit for consumed data, no response (flow control only):
+ *  { "type":"credit", "credit":i }
+ *
+ *  Server tell client that output was dropped while it was too slow:
+ *  { "type":"catchup", "dropped":i }
+ *
  *  Client detach:
  *  { "type":"detach" }
  *
@@ -36,6 +45,19 @@
  *
  *  ENODATA: End of streaming RPC
  *
+ *  OUTPUT:
+ *
+ *  Reads from the pty are coalesced for a short window, then encoded
+ *  once and the same payload is sent to every reading client.
+ *
+ *  A flow control client credits the server with the number of data
+ *  bytes it has consumed.  When its uncredited data would exceed the
+ *  backlog, the client is put in catch-up mode, where output to it is
+ *  dropped until it has consumed most of what it was sent.  It is then
+ *  sent a catchup message, and the foreground process is sent SIGWINCH
+ *  so that a full screen program redraws.  Clients without flow control
+ *  are sent all output, as before.
+ *
  */
 
 #if HAVE_CONFIG_H
@@ -58,12 +80,22 @@
 
 #include "pty.h"
 
+#define PTY_OUTBUF_SIZE 16384
+
+static const double pty_flush_window = 0.002;
+static const int pty_client_backlog = 262144;
+
 struct pty_client {
     char *uuid;
     const flux_msg_t *req;
 
     bool write_enabled;
     bool read_enabled;
+
+    bool flow_control;
+    bool catchup;
+    int uncredited;     /* data bytes sent, not yet credited */
+    int dropped;        /* data bytes dropped in catch-up mode */
 };
 
 struct flux_pty {
@@ -76,6 +108,11 @@ struct flux_pty {
     char *follower;
     flux_watcher_t *fdw;
 
+    flux_watcher_t *flush_w;
+    bool flush_armed;
+    char outbuf[PTY_OUTBUF_SIZE];
+    int outlen;
+
     int flags;
     int exit_status;
 
@@ -203,6 +240,116 @@ int flux_pty_kill (struct flux_pty *pty, int sig)
     return -1;
 }
 
+/*  Return the length of an incomplete UTF-8 sequence at the end of buf,
+ *   which is held back for the next flush, since a data string must be
+ *   valid UTF-8.
+ */
+static int utf8_partial_tail (const char *buf, int len)
+{
+    int i;
+    for (i = 1; i <= 3 && i <= len; i++) {
+        unsigned char c = buf[len - i];
+        if ((c & 0xC0) == 0x80)     /* continuation byte */
+            continue;
+        if ((c & 0xE0) == 0xC0)
+            return i < 2 ? i : 0;
+        if ((c & 0xF0) == 0xE0)
+            return i < 3 ? i : 0;
+        if ((c & 0xF8) == 0xF0)
+            return i;
+        return 0;
+    }
+    return 0;
+}
+
+static void pty_client_send_catchup (struct flux_pty *pty,
+                                     struct pty_client *c)
+{
+    llog_debug (pty, "client=%s: caught up, %d bytes dropped",
+                c->uuid, c->dropped);
+    if (flux_respond_pack (pty->h, c->req,
+                           "{s:s s:i}",
+                           "type", "catchup",
+                           "dropped", c->dropped) < 0)
+        llog_error (pty, "send catchup: %s", strerror (errno));
+    c->catchup = false;
+    c->dropped = 0;
+
+    /*  Ask a full screen program to redraw (best effort) */
+    (void) flux_pty_kill (pty, SIGWINCH);
+}
+
+static void pty_client_send_data (struct flux_pty *pty,
+                                  struct pty_client *c,
+                                  const char *payload,
+                                  int len)
+{
+    if (c->flow_control) {
+        if (!c->catchup && c->uncredited + len > pty_client_backlog) {
+            llog_debug (pty, "client=%s: backlog full, entering catch-up",
+                        c->uuid);
+            c->catchup = true;
+        }
+        if (c->catchup) {
+            c->dropped += len;
+            return;
+        }
+        c->uncredited += len;
+    }
+    if (flux_respond (pty->h, c->req, payload) < 0)
+        llog_error (pty, "send data: %s", strerror (errno));
+}
+
+/*  Send coalesced pty output to all reading clients.  The payload is
+ *   encoded once and shared by all responses.
+ */
+static void pty_flush (struct flux_pty *pty)
+{
+    struct pty_client *c;
+    json_t *o = NULL;
+    char *payload = NULL;
+    int len;
+    int tail;
+
+    if (!pty)
+        return;
+    flux_watcher_stop (pty->flush_w);
+    pty->flush_armed = false;
+    if (pty->outlen == 0)
+        return;
+    len = pty->outlen;
+    if ((tail = utf8_partial_tail (pty->outbuf, len)) == len)
+        return;
+    len -= tail;
+    if (!(o = json_pack ("{s:s s:s#}",
+                         "type", "data",
+                         "data", pty->outbuf, (size_t) len))
+        || !(payload = json_dumps (o, JSON_COMPACT))) {
+        llog_error (pty, "failed to encode %d bytes of data", len);
+        goto out;
+    }
+    c = zlist_first (pty->clients);
+    while (c) {
+        if (c->read_enabled)
+            pty_client_send_data (pty, c, payload, len);
+        c = zlist_next (pty->clients);
+    }
+out:
+    if (tail > 0)
+        memmove (pty->outbuf, pty->outbuf + len, tail);
+    pty->outlen = tail;
+    free (payload);
+    json_decref (o);
+}
+
+static void pty_flush_cb (flux_reactor_t *r,
+                          flux_watcher_t *w,
+                          int revents,
+                          void *arg)
+{
+    pty_flush (arg);
+}
+
 static void pty_clients_destroy (struct flux_pty *pty)
 {
     struct pty_client *c = zlist_first (pty->clients);
@@ -216,6 +363,8 @@ void flux_pty_close (struct flux_pty *pty, int status)
 {
     if (pty) {
         flux_watcher_destroy (pty->fdw);
+        pty_flush (pty);
+        flux_watcher_destroy (pty->flush_w);
         pty_clients_notify_exit (pty, status);
         pty_clients_destroy (pty);
         zlist_destroy (&pty->clients);
@@ -330,23 +479,6 @@ int flux_pty_attach (struct flux_pty *pty)
     return 0;
 }
 
-static void pty_client_send_data (struct flux_pty *pty, void *data, int len)
-{
-    struct pty_client *c = zlist_first (pty->clients);
-
-    while (c) {
-        if (c->read_enabled) {
-            if (flux_respond_pack (pty->h,
-                                   c->req,
-                                   "{s:s s:s#}",
-                                   "type", "data",
-                                   "data", (char *) data, len) < 0)
-                llog_error (pty, "send data: %s", strerror (errno));
-        }
-        c = zlist_next (pty->clients);
-    }
-}
-
 static void pty_read (flux_reactor_t *r,
                       flux_watcher_t *w,
                       int revents,
@@ -354,29 +486,42 @@ static void pty_read (flux_reactor_t *r,
 {
     struct flux_pty *pty = arg;
     ssize_t n;
-    char buf [4096];
 
     /* XXX: notify all clients and exit */
     if (revents & FLUX_POLLERR)
         return;
 
-    n = read (pty->leader, buf, sizeof (buf));
+    n = read (pty->leader,
+              pty->outbuf + pty->outlen,
+              sizeof (pty->outbuf) - pty->outlen);
     if (n < 0) {
         if (errno == EAGAIN || errno == EINTR)
             return;
         /*
          *  pty: EIO indicates pty follower has closed.
-         *   Stop the fd watcher and continue.
+         *   Stop the fd watcher, send any remaining output, and continue.
          */
         if (errno == EIO) {
             flux_watcher_stop (pty->fdw);
+            pty_flush (pty);
             return;
         }
         llog_error (pty, "read: %s", strerror (errno));
         return;
     }
-    else if (n > 0)
-        pty_client_send_data (pty, buf, n);
+    else if (n > 0) {
+        /*  Flush now if the buffer is full, otherwise wait for more
+         *   output until the end of a short window.
+         */
+        pty->outlen += n;
+        if (pty->outlen == sizeof (pty->outbuf))
+            pty_flush (pty);
+        else if (!pty->flush_armed) {
+            flux_timer_watcher_reset (pty->flush_w, pty_flush_window, 0.);
+            flux_watcher_start (pty->flush_w);
+            pty->flush_armed = true;
+        }
+    }
 }
 
 static int pty_resize (struct flux_pty *pty, const flux_msg_t *msg)
@@ -428,8 +573,13 @@ static int pty_client_set_mode (struct flux_pty *pty,
                                 const flux_msg_t *msg)
 {
     const char *mode;
-    if (flux_msg_unpack (msg, "{s:s}", "mode", &mode) < 0)
+    int flow_control = 0;
+    if (flux_msg_unpack (msg,
+                         "{s:s s?b}",
+                         "mode", &mode,
+                         "flow_control", &flow_control) < 0)
         return -1;
+    c->flow_control = flow_control;
     /*  Valid modes are currently only "ro", "wo", "rw" */
     if (strcmp (mode, "rw") == 0)
         c->read_enabled = c->write_enabled = true;
@@ -466,7 +616,14 @@ static int pty_attach (struct flux_pty *pty, const flux_msg_t *msg)
         && c->write_enabled
         && pty_resize (pty, msg) < 0)
         goto err;
-    if (flux_respond_pack (pty->h, msg, "{s:s}", "type", "attach") < 0)
+    if (c->flow_control) {
+        if (flux_respond_pack (pty->h, msg,
+                               "{s:s s:i}",
+                               "type", "attach",
+                               "backlog", pty_client_backlog) < 0)
+            goto err;
+    }
+    else if (flux_respond_pack (pty->h, msg, "{s:s}", "type", "attach") < 0)
         goto err;
     return 0;
 err:
@@ -478,6 +635,28 @@ err:
     return -1;
 }
 
+static int pty_credit (struct flux_pty *pty,
+                       struct pty_client *c,
+                       const flux_msg_t *msg)
+{
+    int credit;
+    if (flux_msg_unpack (msg, "{s:i}", "credit", &credit) < 0)
+        return -1;
+    if (!c->flow_control || credit < 0) {
+        errno = EPROTO;
+        return -1;
+    }
+    c->uncredited -= credit;
+    if (c->uncredited < 0)
+        c->uncredited = 0;
+    /*  The client holds back credit for less than a quarter of the
+     *   backlog, so below that it has consumed all it can.
+     */
+    if (c->catchup && c->uncredited < pty_client_backlog / 4)
+        pty_client_send_catchup (pty, c);
+    return 0;
+}
+
 static int pty_write (struct flux_pty *pty, const flux_msg_t *msg)
 {
     const char *data;
@@ -547,6 +726,14 @@ int flux_pty_sendmsg (struct flux_pty *pty, const flux_msg_t *msg)
             goto err;
         }
     }
+    else if (strcmp (type, "credit") == 0) {
+        /*  Credit requests have no response */
+        if (pty_credit (pty, c, msg) < 0)
+            llog_error (pty, "client=%s: bad credit: %s",
+                        c->uuid,
+                        strerror (errno));
+        return 0;
+    }
     else if (strcmp (type, "detach") == 0) {
         if (pty_client_detach (pty, c) < 0)
             goto err;
@@ -586,7 +773,12 @@ int flux_pty_set_flux (struct flux_pty *pty, flux_t *h)
                                        FLUX_POLLIN,
                                        pty_read,
                                        pty);
-    if (!pty->fdw)
+    pty->flush_w = flux_timer_watcher_create (flux_get_reactor (h),
+                                              pty_flush_window,
+                                              0.,
+                                              pty_flush_cb,
+                                              pty);
+    if (!pty->fdw || !pty->flush_w)
         return -1;
 
     fd_set_nonblocking (pty->leader);
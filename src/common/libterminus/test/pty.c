@@ -377,6 +377,71 @@ static void test_basic_protocol (void)
     flux_close (h);
 }
 
+static void test_flow_control (void)
+{
+    flux_t *h = test_server_create (pty_server, NULL);
+    flux_future_t *f = NULL;
+    flux_future_t *f_attach = NULL;
+    const char *type = NULL;
+    int backlog = 0;
+
+    ok ((f_attach = flux_rpc_pack (h, "pty", 0, FLUX_RPC_STREAMING,
+                                   "{s:s s:s s:{s:i s:i} s:b}",
+                                   "type", "attach",
+                                   "mode", "rw",
+                                   "winsize",
+                                      "rows", 25,
+                                      "cols", 80,
+                                   "flow_control", 1)) != NULL,
+        "request: type attach with flow_control");
+    ok (flux_rpc_get_unpack (f_attach,
+                             "{s:s s:i}",
+                             "type", &type,
+                             "backlog", &backlog) == 0,
+        "response: OK errno=%s", strerror (errno));
+    ok (type && !strcmp (type, "attach") && backlog > 0,
+        "response: type=attach backlog=%d", backlog);
+    flux_future_reset (f_attach);
+
+    ok ((f = flux_rpc_pack (h, "pty", 0, FLUX_RPC_NORESPONSE,
+                            "{s:s s:i}",
+                            "type", "credit",
+                            "credit", 1024)) != NULL,
+        "request: type credit");
+    flux_future_destroy (f);
+
+    /* credit has no response, so the next response is for resize */
+    ok ((f = flux_rpc_pack (h, "pty", 0, 0,
+                            "{s:s s:{s:i s:i}}",
+                            "type", "resize",
+                            "winsize",
+                               "rows", 25,
+                               "cols", 80)) != NULL,
+        "request: type resize after credit");
+    ok (flux_rpc_get (f, NULL) == 0,
+        "response: OK");
+    flux_future_destroy (f);
+
+    ok ((f = flux_rpc_pack (h, "pty", 0, 0,
+                            "{s:s}",
+                            "type", "detach")) != NULL,
+        "request: type detach");
+    ok (flux_rpc_get (f, NULL) == 0,
+        "response: OK");
+    flux_future_destroy (f);
+
+    ok (flux_rpc_get_unpack (f_attach, "{s:s}", "type", &type) == 0
+        && !strcmp (type, "exit"),
+        "response: type = exit");
+    flux_future_reset (f_attach);
+    ok (flux_rpc_get (f_attach, NULL) < 0 && errno == ENODATA,
+        "response: ENODATA");
+    flux_future_destroy (f_attach);
+
+    test_server_stop (h);
+    flux_close (h);
+}
+
 static void pty_exit_cb (struct flux_pty_client *c, void *arg)
 {
     flux_t *h = arg;
@@ -436,6 +501,7 @@ int main (int argc, char *argv[])
     test_invalid_args ();
     test_empty_server ();
     test_basic_protocol ();
+    test_flow_control ();
     test_client ();
 
     done_testing ();
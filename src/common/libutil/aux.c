@@ -14,16 +14,89 @@
 #include <string.h>
 #include <errno.h>
 #include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <pthread.h>
 
 #include "aux.h"
 
 struct aux_item {
-    char *key;
+    const char *key;
+    unsigned int hash;
+    bool interned;          // key belongs to the intern table, not the item
     void *val;
     aux_free_f free_fn;
     struct aux_item *next;
 };
 
+/* Interned keys live for the life of the process and are shared by all
+ * threads, so the table is protected by a mutex.  Lookups with an
+ * interned key don't consult the table: its hash is stored with it.
+ */
+#define INTERN_BUCKETS 256
+
+struct aux_key {
+    struct aux_key *next;
+    unsigned int hash;
+    char name[];
+};
+
+static pthread_mutex_t intern_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct aux_key *intern_table[INTERN_BUCKETS];
+
+/* FNV-1a
+ */
+static unsigned int key_hash (const char *key)
+{
+    unsigned int hash = 2166136261u;
+
+    while (*key) {
+        hash ^= (unsigned char)*key++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static unsigned int interned_hash (const char *key)
+{
+    const struct aux_key *ik;
+
+    ik = (const struct aux_key *)(key - offsetof (struct aux_key, name));
+    return ik->hash;
+}
+
+const char *aux_key (const char *name)
+{
+    struct aux_key *ik;
+    unsigned int hash;
+    size_t len;
+
+    if (!name) {
+        errno = EINVAL;
+        return NULL;
+    }
+    hash = key_hash (name);
+    pthread_mutex_lock (&intern_lock);
+    ik = intern_table[hash % INTERN_BUCKETS];
+    while (ik) {
+        if (ik->hash == hash && !strcmp (ik->name, name))
+            goto done;
+        ik = ik->next;
+    }
+    len = strlen (name);
+    if (!(ik = malloc (sizeof (*ik) + len + 1))) {
+        errno = ENOMEM;
+        goto done;
+    }
+    ik->hash = hash;
+    memcpy (ik->name, name, len + 1);
+    ik->next = intern_table[hash % INTERN_BUCKETS];
+    intern_table[hash % INTERN_BUCKETS] = ik;
+done:
+    pthread_mutex_unlock (&intern_lock);
+    return ik ? ik->name : NULL;
+}
+
 /* Destroy an aux item.
  * It is assumed to already be unlinked from list.
  */
@@ -33,24 +106,34 @@ static void aux_item_destroy (struct aux_item *aux)
         int saved_errno = errno;
         if (aux->free_fn && aux->val)
             aux->free_fn (aux->val);
-        free (aux->key);
+        if (!aux->interned)
+            free ((char *)aux->key);
         free (aux);
         errno = saved_errno;
     }
 }
 
-/* Create an aux item.
+/* Create an aux item.  If 'interned' is true, 'key' was returned by
+ * aux_key() and is not copied.
  * Return item on success, NULL on failure with errno set (ENOMEM).
  */
 static struct aux_item *aux_item_create (const char *key,
+                                         unsigned int hash,
+                                         bool interned,
                                          void *val, aux_free_f free_fn)
 {
     struct aux_item *aux;
 
     if (!(aux = calloc (1, sizeof (*aux))))
         return NULL;
-    if (key && !(aux->key = strdup (key)))
-        goto error;
+    if (key) {
+        if (interned)
+            aux->key = key;
+        else if (!(aux->key = strdup (key)))
+            goto error;
+        aux->hash = hash;
+        aux->interned = interned;
+    }
     aux->val = val;
     aux->free_fn = free_fn;
     return aux;
@@ -59,16 +142,36 @@ error:
     return NULL;
 }
 
+/* Return true if 'item' is stored under 'key' with 'hash'.
+ * Two interned keys match only if they are the same pointer.
+ */
+static inline bool aux_item_match (struct aux_item *item,
+                                   const char *key,
+                                   unsigned int hash,
+                                   bool interned)
+{
+    if (!item->key)
+        return false;
+    if (item->key == key)
+        return true;
+    if (item->hash != hash || (interned && item->interned))
+        return false;
+    return !strcmp (item->key, key);
+}
+
 /* Delete from 'head' an aux item that was stored under 'key', if any.
  * 'head' is an in/out parameter.
  */
-static void aux_item_delete (struct aux_item **head, const char *key)
+static void aux_item_delete (struct aux_item **head,
+                             const char *key,
+                             unsigned int hash,
+                             bool interned)
 {
     if (key && head) {
         struct aux_item *item;
 
         while ((item = *head)) {
-            if (item->key && !strcmp (item->key, key)) {
+            if (aux_item_match (item, key, hash, interned)) {
                 *head = item->next;
                 aux_item_destroy (item);
                 break;
@@ -81,14 +184,15 @@ static void aux_item_delete (struct aux_item **head, const char *key)
 /* Find in 'head' an aux item stored under 'key'.
  * Returns item on success, NULL on failure.
  */
-static struct aux_item *aux_item_find (struct aux_item *head, const char *key)
+static struct aux_item *aux_item_find (struct aux_item *head,
+                                       const char *key,
+                                       unsigned int hash,
+                                       bool interned)
 {
-    if (key) {
-        while (head) {
-            if (head->key && !strcmp (key, head->key))
-                return head;
-            head = head->next;
-        }
+    while (head) {
+        if (aux_item_match (head, key, hash, interned))
+            return head;
+        head = head->next;
     }
     return NULL;
 }
@@ -105,22 +209,57 @@ static void aux_item_insert (struct aux_item **head, struct aux_item *item)
     }
 }
 
+static void *aux_lookup (struct aux_item *head,
+                         const char *key,
+                         unsigned int hash,
+                         bool interned)
+{
+    struct aux_item *item;
+
+    if (!(item = aux_item_find (head, key, hash, interned))) {
+        errno = ENOENT;
+        return NULL;
+    }
+    return item->val;
+}
+
+static int aux_store (struct aux_item **head,
+                      const char *key,
+                      unsigned int hash,
+                      bool interned,
+                      void *val,
+                      aux_free_f free_fn)
+{
+    struct aux_item *item;
+
+    aux_item_delete (head, key, hash, interned);
+    if (val) {
+        if (!(item = aux_item_create (key, hash, interned, val, free_fn)))
+            return -1;
+        aux_item_insert (head, item);
+    }
+    return 0;
+}
+
 /* Look up 'key' in 'head'.
  * Returns value on success, NULL on failure with errno set (EINVAL, ENOENT).
  */
 void *aux_get (struct aux_item *head, const char *key)
 {
-    struct aux_item *item;
-
     if (!key) {
         errno = EINVAL;
         return NULL;
     }
-    if (!(item = aux_item_find (head, key))) {
-        errno = ENOENT;
+    return aux_lookup (head, key, key_hash (key), false);
+}
+
+void *aux_get_key (struct aux_item *head, const char *key)
+{
+    if (!key) {
+        errno = EINVAL;
         return NULL;
     }
-    return item->val;
+    return aux_lookup (head, key, interned_hash (key), true);
 }
 
 /* Insert ('key', 'value', 'free_fn') tuple in 'head'.
@@ -131,19 +270,21 @@ void *aux_get (struct aux_item *head, const char *key)
 int aux_set (struct aux_item **head,
              const char *key, void *val, aux_free_f free_fn)
 {
-    struct aux_item *item;
-
     if (!head || (!key && !val) || (!val && free_fn) || (!key && !free_fn)) {
         errno = EINVAL;
         return -1;
     }
-    aux_item_delete (head, key);
-    if (val) {
-        if (!(item = aux_item_create (key, val, free_fn)))
-            return -1;
-        aux_item_insert (head, item);
+    return aux_store (head, key, key ? key_hash (key) : 0, false, val, free_fn);
+}
+
+int aux_set_key (struct aux_item **head,
+                 const char *key, void *val, aux_free_f free_fn)
+{
+    if (!head || !key || (!val && free_fn)) {
+        errno = EINVAL;
+        return -1;
     }
-    return 0;
+    return aux_store (head, key, interned_hash (key), true, val, free_fn);
 }
 
 /* Destroy aux list 'head', calling destructors on items that have them.
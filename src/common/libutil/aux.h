@@ -40,6 +40,32 @@ void *aux_get (struct aux_item *aux, const char *key);
 
 void aux_destroy (struct aux_item **aux);
 
+/* Interned keys - for keys that are looked up often.
+ *
+ * aux_key () returns a canonical copy of 'name' that lives for the life of
+ * the process, the same pointer for every call with the same name.  It is
+ * thread safe, and is typically called once and the result cached, e.g.
+ *
+ *   static const char *key;
+ *   if (!key && !(key = aux_key ("flux::foo")))
+ *       return -1;
+ *
+ * aux_get_key ()/aux_set_key () work like aux_get ()/aux_set (), but 'key'
+ * must have been returned by aux_key (), and items stored under an interned
+ * key are found by pointer comparison.  Items are shared between the two
+ * APIs: a value stored with aux_set ("foo") is found by
+ * aux_get_key (aux_key ("foo")), and vice versa.
+ *
+ * Don't intern keys built at runtime from unbounded input, since interned
+ * keys are never freed.
+ */
+const char *aux_key (const char *name);
+
+int aux_set_key (struct aux_item **aux, const char *key,
+                 void *val, aux_free_f free_fn);
+
+void *aux_get_key (struct aux_item *aux, const char *key);
+
 #endif /* !_UTIL_AUX_H */
 
 /*
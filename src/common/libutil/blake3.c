@@ -0,0 +1,257 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* blake3.c - portable BLAKE3 hash, fixed 32 byte output
+ *
+ * The input is split into 1K chunks, each hashed independently, and the
+ * chunk chaining values are combined in a binary tree whose left subtrees
+ * hold a power of two number of chunks.  Because the subtrees are
+ * independent, the top levels of the tree are hashed in parallel threads
+ * for large inputs.  See the BLAKE3 specification,
+ * https://github.com/BLAKE3-team/BLAKE3-specs.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "blake3.h"
+
+#define CHUNK_LEN       1024
+#define BLOCK_LEN       64
+
+#define CHUNK_START     (1 << 0)
+#define CHUNK_END       (1 << 1)
+#define PARENT          (1 << 2)
+#define ROOT            (1 << 3)
+
+/* Inputs smaller than this are hashed in the calling thread, since
+ * thread startup would cost more than it saves.
+ */
+#define THREAD_MIN_LEN  (1024 * 1024)
+#define THREAD_MAX      8
+
+static const uint32_t iv[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+};
+
+static const uint8_t msg_schedule[7][16] = {
+    { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+    { 2, 6, 3, 10, 7, 0, 4, 13, 1, 11, 12, 5, 9, 14, 15, 8 },
+    { 3, 4, 10, 12, 13, 2, 7, 14, 6, 5, 9, 0, 11, 15, 8, 1 },
+    { 10, 7, 12, 9, 14, 3, 13, 15, 4, 0, 11, 2, 5, 8, 1, 6 },
+    { 12, 13, 9, 11, 15, 10, 14, 8, 7, 2, 5, 3, 0, 1, 6, 4 },
+    { 9, 14, 11, 5, 8, 12, 15, 1, 13, 3, 0, 10, 2, 6, 4, 7 },
+    { 11, 15, 5, 0, 1, 9, 8, 6, 14, 10, 2, 12, 3, 4, 7, 13 },
+};
+
+static inline uint32_t rotr32 (uint32_t x, int n)
+{
+    return (x >> n) | (x << (32 - n));
+}
+
+static inline uint32_t load32 (const uint8_t *p)
+{
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8
+         | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static inline void g (uint32_t *s, int a, int b, int c, int d,
+                      uint32_t x, uint32_t y)
+{
+    s[a] = s[a] + s[b] + x;
+    s[d] = rotr32 (s[d] ^ s[a], 16);
+    s[c] = s[c] + s[d];
+    s[b] = rotr32 (s[b] ^ s[c], 12);
+    s[a] = s[a] + s[b] + y;
+    s[d] = rotr32 (s[d] ^ s[a], 8);
+    s[c] = s[c] + s[d];
+    s[b] = rotr32 (s[b] ^ s[c], 7);
+}
+
+/* Compress one block into chaining value 'cv', in place.
+ */
+static void compress (uint32_t cv[8],
+                      const uint8_t block[BLOCK_LEN],
+                      uint32_t block_len,
+                      uint64_t counter,
+                      uint32_t flags)
+{
+    uint32_t m[16];
+    uint32_t s[16];
+
+    for (int i = 0; i < 16; i++)
+        m[i] = load32 (block + 4 * i);
+    memcpy (s, cv, 8 * sizeof (uint32_t));
+    memcpy (s + 8, iv, 4 * sizeof (uint32_t));
+    s[12] = (uint32_t)counter;
+    s[13] = (uint32_t)(counter >> 32);
+    s[14] = block_len;
+    s[15] = flags;
+    for (int r = 0; r < 7; r++) {
+        const uint8_t *x = msg_schedule[r];
+
+        g (s, 0, 4, 8, 12, m[x[0]], m[x[1]]);
+        g (s, 1, 5, 9, 13, m[x[2]], m[x[3]]);
+        g (s, 2, 6, 10, 14, m[x[4]], m[x[5]]);
+        g (s, 3, 7, 11, 15, m[x[6]], m[x[7]]);
+        g (s, 0, 5, 10, 15, m[x[8]], m[x[9]]);
+        g (s, 1, 6, 11, 12, m[x[10]], m[x[11]]);
+        g (s, 2, 7, 8, 13, m[x[12]], m[x[13]]);
+        g (s, 3, 4, 9, 14, m[x[14]], m[x[15]]);
+    }
+    for (int i = 0; i < 8; i++)
+        cv[i] = s[i] ^ s[i + 8];
+}
+
+/* Hash a chunk of at most CHUNK_LEN bytes (possibly empty).
+ */
+static void hash_chunk (const uint8_t *data,
+                        size_t len,
+                        uint64_t chunk_counter,
+                        uint32_t root,
+                        uint32_t cv[8])
+{
+    uint8_t block[BLOCK_LEN];
+    uint32_t flags = CHUNK_START;
+
+    memcpy (cv, iv, sizeof (iv));
+    while (len > BLOCK_LEN) {
+        compress (cv, data, BLOCK_LEN, chunk_counter, flags);
+        flags = 0;
+        data += BLOCK_LEN;
+        len -= BLOCK_LEN;
+    }
+    memset (block, 0, sizeof (block));
+    if (len > 0)
+        memcpy (block, data, len);
+    compress (cv, block, len, chunk_counter, flags | CHUNK_END | root);
+}
+
+static void hash_parent (const uint32_t left[8],
+                         const uint32_t right[8],
+                         uint32_t root,
+                         uint32_t cv[8])
+{
+    uint8_t block[BLOCK_LEN];
+
+    for (int i = 0; i < 8; i++) {
+        for (int j = 0; j < 4; j++) {
+            block[4 * i + j] = left[i] >> (8 * j);
+            block[32 + 4 * i + j] = right[i] >> (8 * j);
+        }
+    }
+    memcpy (cv, iv, sizeof (iv));
+    compress (cv, block, BLOCK_LEN, 0, PARENT | root);
+}
+
+struct subtree {
+    const uint8_t *data;
+    size_t len;
+    uint64_t chunk_counter;
+    uint32_t root;
+    int nthreads;
+    uint32_t cv[8];
+};
+
+static void hash_subtree (struct subtree *t);
+
+static void *subtree_thread (void *arg)
+{
+    hash_subtree (arg);
+    return NULL;
+}
+
+/* Hash a subtree.  The left subtree receives the largest power of two
+ * number of chunks that leaves at least one byte for the right.  If more
+ * than one thread is allotted, the left subtree is hashed in a new thread
+ * while this one continues with the right.
+ */
+static void hash_subtree (struct subtree *t)
+{
+    struct subtree left, right;
+    uint64_t chunks;
+    uint64_t left_chunks = 1;
+    pthread_t thread;
+    bool threaded = false;
+
+    if (t->len <= CHUNK_LEN) {
+        hash_chunk (t->data, t->len, t->chunk_counter, t->root, t->cv);
+        return;
+    }
+    chunks = (t->len + CHUNK_LEN - 1) / CHUNK_LEN;
+    while (left_chunks * 2 < chunks)
+        left_chunks *= 2;
+
+    left.data = t->data;
+    left.len = left_chunks * CHUNK_LEN;
+    left.chunk_counter = t->chunk_counter;
+    left.root = 0;
+    left.nthreads = t->nthreads / 2;
+    right.data = t->data + left.len;
+    right.len = t->len - left.len;
+    right.chunk_counter = t->chunk_counter + left_chunks;
+    right.root = 0;
+    right.nthreads = t->nthreads - left.nthreads;
+
+    if (left.nthreads > 0 && left.len >= THREAD_MIN_LEN / 2) {
+        if (pthread_create (&thread, NULL, subtree_thread, &left) == 0)
+            threaded = true;
+    }
+    if (!threaded) {
+        left.nthreads = 1;
+        hash_subtree (&left);
+    }
+    hash_subtree (&right);
+    if (threaded)
+        (void)pthread_join (thread, NULL);
+    hash_parent (left.cv, right.cv, t->root, t->cv);
+}
+
+void blake3_hash_threads (const void *data,
+                          size_t len,
+                          uint8_t *digest,
+                          int nthreads)
+{
+    struct subtree t = {
+        .data = data,
+        .len = len,
+        .chunk_counter = 0,
+        .root = ROOT,
+        .nthreads = nthreads < 1 ? 1 : nthreads,
+    };
+
+    hash_subtree (&t);
+    for (int i = 0; i < 8; i++) {
+        for (int j = 0; j < 4; j++)
+            digest[4 * i + j] = t.cv[i] >> (8 * j);
+    }
+}
+
+void blake3_hash (const void *data, size_t len, uint8_t *digest)
+{
+    int nthreads = 1;
+
+    if (len >= THREAD_MIN_LEN) {
+        /* One thread per THREAD_MIN_LEN of input, up to THREAD_MAX.
+         */
+        size_t n = len / THREAD_MIN_LEN;
+        nthreads = n > THREAD_MAX ? THREAD_MAX : n;
+    }
+    blake3_hash_threads (data, len, digest, nthreads);
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,36 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _UTIL_BLAKE3_H
+#define _UTIL_BLAKE3_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define BLAKE3_DIGEST_SIZE 32
+
+/* Compute the 32 byte BLAKE3 hash of 'data'.  Large inputs are split
+ * across threads.
+ */
+void blake3_hash (const void *data, size_t len, uint8_t *digest);
+
+/* Same as above, but use at most 'nthreads' threads (1 = calling thread
+ * only).  The result does not depend on 'nthreads'.
+ */
+void blake3_hash_threads (const void *data,
+                          size_t len,
+                          uint8_t *digest,
+                          int nthreads);
+
+#endif /* !_UTIL_BLAKE3_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
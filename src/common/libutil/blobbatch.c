@@ -0,0 +1,218 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <arpa/inet.h>
+
+#include "blobbatch.h"
+
+struct item {
+    int offset;                 // offset of data in payload
+    int len;                    // data length, or negated errnum
+};
+
+struct blobbatch {
+    char *buf;                  // encoded payload, if created
+    int size;
+    int alloc;
+    const char *ext;            // decoded payload, if decoded
+    struct item *items;
+    int count;
+    int items_alloc;
+};
+
+struct blobbatch *blobbatch_create (void)
+{
+    struct blobbatch *bb;
+
+    if (!(bb = calloc (1, sizeof (*bb))))
+        return NULL;
+    return bb;
+}
+
+void blobbatch_destroy (struct blobbatch *bb)
+{
+    if (bb) {
+        int saved_errno = errno;
+        free (bb->buf);
+        free (bb->items);
+        free (bb);
+        errno = saved_errno;
+    }
+}
+
+static int add_item (struct blobbatch *bb, int offset, int len)
+{
+    if (bb->count == bb->items_alloc) {
+        int n = bb->items_alloc ? bb->items_alloc * 2 : 16;
+        struct item *items;
+
+        if (!(items = realloc (bb->items, n * sizeof (items[0]))))
+            return -1;
+        bb->items = items;
+        bb->items_alloc = n;
+    }
+    bb->items[bb->count].offset = offset;
+    bb->items[bb->count].len = len;
+    bb->count++;
+    return 0;
+}
+
+static int append_header (struct blobbatch *bb, int32_t hdr, int len)
+{
+    uint32_t nhdr = htonl ((uint32_t)hdr);
+    int need;
+
+    if (len > INT_MAX - bb->size - (int)sizeof (nhdr)) {
+        errno = EOVERFLOW;
+        return -1;
+    }
+    need = bb->size + sizeof (nhdr) + len;
+    if (need > bb->alloc) {
+        int n = bb->alloc ? bb->alloc : 4096;
+        char *buf;
+
+        while (n < need)
+            n = n > INT_MAX / 2 ? need : n * 2;
+        if (!(buf = realloc (bb->buf, n)))
+            return -1;
+        bb->buf = buf;
+        bb->alloc = n;
+    }
+    if (add_item (bb, bb->size + sizeof (nhdr), hdr) < 0)
+        return -1;
+    memcpy (bb->buf + bb->size, &nhdr, sizeof (nhdr));
+    bb->size += sizeof (nhdr);
+    return 0;
+}
+
+int blobbatch_append (struct blobbatch *bb, const void *data, int len)
+{
+    if (!bb || bb->ext || len < 0 || (len > 0 && !data)) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (append_header (bb, len, len) < 0)
+        return -1;
+    if (len > 0)
+        memcpy (bb->buf + bb->size, data, len);
+    bb->size += len;
+    return 0;
+}
+
+int blobbatch_append_error (struct blobbatch *bb, int errnum)
+{
+    if (!bb || bb->ext || errnum <= 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    return append_header (bb, -errnum, 0);
+}
+
+void blobbatch_encode (struct blobbatch *bb, const void **buf, int *len)
+{
+    if (bb) {
+        if (buf)
+            *buf = bb->ext ? bb->ext : bb->buf;
+        if (len)
+            *len = bb->size;
+    }
+}
+
+struct blobbatch *blobbatch_decode (const void *buf, int len)
+{
+    struct blobbatch *bb;
+    const char *p = buf;
+    int pos = 0;
+
+    if (len < 0 || (len > 0 && !buf)) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(bb = blobbatch_create ()))
+        return NULL;
+    bb->ext = buf;
+    bb->size = len;
+    while (pos < len) {
+        uint32_t nhdr;
+        int32_t hdr;
+
+        if (len - pos < (int)sizeof (nhdr))
+            goto eproto;
+        memcpy (&nhdr, p + pos, sizeof (nhdr));
+        pos += sizeof (nhdr);
+        hdr = (int32_t)ntohl (nhdr);
+        if (hdr > len - pos || hdr == INT32_MIN)
+            goto eproto;
+        if (add_item (bb, pos, hdr) < 0)
+            goto error;
+        if (hdr > 0)
+            pos += hdr;
+    }
+    return bb;
+eproto:
+    errno = EPROTO;
+error:
+    blobbatch_destroy (bb);
+    return NULL;
+}
+
+int blobbatch_count (struct blobbatch *bb)
+{
+    return bb ? bb->count : 0;
+}
+
+int blobbatch_get (struct blobbatch *bb,
+                   int index,
+                   const void **data,
+                   int *len)
+{
+    struct item *item;
+
+    if (!bb || index < 0 || index >= bb->count) {
+        errno = EINVAL;
+        return -1;
+    }
+    item = &bb->items[index];
+    if (item->len < 0) {
+        errno = -item->len;
+        return -1;
+    }
+    if (data)
+        *data = (bb->ext ? bb->ext : bb->buf) + item->offset;
+    if (len)
+        *len = item->len;
+    return 0;
+}
+
+const char *blobbatch_get_string (struct blobbatch *bb, int index)
+{
+    const char *s;
+    int len;
+
+    if (blobbatch_get (bb, index, (const void **)&s, &len) < 0)
+        return NULL;
+    if (len == 0 || s[len - 1] != '\0') {
+        errno = EPROTO;
+        return NULL;
+    }
+    return s;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,66 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _UTIL_BLOBBATCH_H
+#define _UTIL_BLOBBATCH_H
+
+/* A batch of blobs encoded in one message payload, as used by the
+ * content.load-batch and content.store-batch requests and responses.
+ *
+ * The payload is a sequence of items, each a 4 byte signed length in
+ * network byte order followed by that many bytes of data.  A negative
+ * length is a negated error number with no data, recording that the
+ * operation on that item failed.
+ */
+
+struct blobbatch;
+
+struct blobbatch *blobbatch_create (void);
+void blobbatch_destroy (struct blobbatch *bb);
+
+/* Append an item containing 'len' bytes of 'data'.
+ */
+int blobbatch_append (struct blobbatch *bb, const void *data, int len);
+
+/* Append an item recording that the operation on it failed with 'errnum'.
+ */
+int blobbatch_append_error (struct blobbatch *bb, int errnum);
+
+/* Get the encoded payload.  Storage belongs to 'bb' and is valid until
+ * the next append, or until 'bb' is destroyed.
+ */
+void blobbatch_encode (struct blobbatch *bb, const void **buf, int *len);
+
+/* Decode payload 'buf' of length 'len'.  Items refer to 'buf', which must
+ * remain valid for the life of the batch.  Returns NULL with errno set
+ * to EPROTO if the payload is malformed.
+ */
+struct blobbatch *blobbatch_decode (const void *buf, int len);
+
+int blobbatch_count (struct blobbatch *bb);
+
+/* Get item 'index'.  If the item records an error, fail with errno set
+ * to its error number.
+ */
+int blobbatch_get (struct blobbatch *bb,
+                   int index,
+                   const void **data,
+                   int *len);
+
+/* Get item 'index' as a string, e.g. a blobref.  Fail with EPROTO if the
+ * item is not NUL terminated.
+ */
+const char *blobbatch_get_string (struct blobbatch *bb, int index);
+
+#endif /* !_UTIL_BLOBBATCH_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -20,6 +20,7 @@
 #include "blobref.h"
 #include "sha1.h"
 #include "sha256.h"
+#include "blake3.h"
 
 #define SHA1_PREFIX_STRING  "sha1-"
 #define SHA1_PREFIX_LENGTH  5
@@ -29,6 +30,10 @@
 #define SHA256_PREFIX_LENGTH  7
 #define SHA256_STRING_SIZE    (SHA256_BLOCK_SIZE*2 + SHA256_PREFIX_LENGTH + 1)
 
+#define BLAKE3_PREFIX_STRING  "blake3-"
+#define BLAKE3_PREFIX_LENGTH  7
+#define BLAKE3_STRING_SIZE    (BLAKE3_DIGEST_SIZE*2 + BLAKE3_PREFIX_LENGTH + 1)
+
 #if BLOBREF_MAX_STRING_SIZE < SHA1_STRING_SIZE
 #error BLOBREF_MAX_STRING_SIZE is too small
 #endif
@@ -41,9 +46,17 @@
 #if BLOBREF_MAX_DIGEST_SIZE < SHA256_BLOCK_SIZE
 #error BLOBREF_MAX_DIGEST_SIZE is too small
 #endif
+#if BLOBREF_MAX_STRING_SIZE < BLAKE3_STRING_SIZE
+#error BLOBREF_MAX_STRING_SIZE is too small
+#endif
+#if BLOBREF_MAX_DIGEST_SIZE < BLAKE3_DIGEST_SIZE
+#error BLOBREF_MAX_DIGEST_SIZE is too small
+#endif
 
 static void sha1_hash (const void *data, int data_len, void *hash, int hash_len);
 static void sha256_hash (const void *data, int data_len, void *hash, int hash_len);
+static void blake3_hash_blob (const void *data, int data_len, void *hash,
+                              int hash_len);
 
 struct blobhash {
     char *name;
@@ -60,6 +73,10 @@ static struct blobhash blobtab[] = {
       .hashlen = SHA256_BLOCK_SIZE,
       .hashfun = sha256_hash,
     },
+    { .name = "blake3",
+      .hashlen = BLAKE3_DIGEST_SIZE,
+      .hashfun = blake3_hash_blob,
+    },
     { NULL, 0, 0 },
 };
 
@@ -83,6 +100,13 @@ static void sha256_hash (const void *data, int data_len, void *hash, int hash_le
     sha256_final (&ctx, hash);
 }
 
+static void blake3_hash_blob (const void *data, int data_len, void *hash,
+                              int hash_len)
+{
+    assert (hash_len == BLAKE3_DIGEST_SIZE);
+    blake3_hash (data, data_len, hash);
+}
+
 /* true if s1 contains "s2-" prefix
  */
 static int prefixmatch (const char *s1, const char *s2)
@@ -0,0 +1,535 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* File layout, with all integers in network byte order:
+ *
+ *   header     magic "FLXSNAP1", then count, nslots, nbuckets, rootlen,
+ *              and the 64 bit offset of the index as two 32 bit halves
+ *   root       'rootlen' bytes including the terminating NULL
+ *   records    blobref (including NULL) then blob data, padded to 8 bytes
+ *   index      'nbuckets' 32 bit displacements, padded to 8 bytes, then
+ *              'nslots' slots of { offset hi, offset lo, reflen, size }
+ *
+ * A blobref hashes to a bucket, and the bucket's displacement picks the
+ * blobref's slot (hash and displace).  The writer chooses displacements,
+ * largest bucket first, so that no two blobrefs share a slot.  A slot
+ * with a zero offset is empty.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <arpa/inet.h>
+
+#include "blobsnap.h"
+
+#define SNAP_MAGIC          "FLXSNAP1"
+#define SNAP_MAGIC_LEN      8
+#define SNAP_ALIGN          8
+#define SNAP_MAX_ATTEMPTS   8
+#define SNAP_MAX_BUCKET     64  // keys per bucket, about 4 expected
+
+struct snap_header {
+    char magic[SNAP_MAGIC_LEN];
+    uint32_t count;
+    uint32_t nslots;
+    uint32_t nbuckets;
+    uint32_t rootlen;
+    uint32_t index_hi;
+    uint32_t index_lo;
+};
+
+struct snap_slot {
+    uint32_t off_hi;
+    uint32_t off_lo;
+    uint32_t reflen;
+    uint32_t size;
+};
+
+struct snap_key {
+    uint64_t hash;
+    uint64_t off;
+    uint32_t reflen;
+    uint32_t size;
+};
+
+struct blobsnap_writer {
+    char *path;
+    char *tmppath;
+    char *root;
+    FILE *f;
+    uint64_t off;
+    struct snap_key *keys;
+    uint32_t count;
+    uint32_t alloc;
+    int committed;
+};
+
+struct blobsnap {
+    const char *map;
+    size_t size;
+    const char *root;
+    uint32_t count;
+    uint32_t nslots;
+    uint32_t nbuckets;
+    const uint32_t *disp;
+    const struct snap_slot *slots;
+};
+
+static size_t pad (size_t n)
+{
+    return (n + SNAP_ALIGN - 1) & ~(size_t)(SNAP_ALIGN - 1);
+}
+
+static uint64_t hash_blobref (const char *blobref)
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+    const unsigned char *p = (const unsigned char *)blobref;
+
+    while (*p) {
+        h ^= *p++;
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+/* splitmix64 finalizer, so that each displacement gives the keys of a
+ * bucket an unrelated set of slots.
+ */
+static uint32_t slot_of (uint64_t hash, uint32_t d, uint32_t nslots)
+{
+    uint64_t z = hash + (uint64_t)(d + 1) * 0x9e3779b97f4a7c15ULL;
+
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    z ^= z >> 31;
+    return z % nslots;
+}
+
+static uint32_t bucket_of (uint64_t hash, uint32_t nbuckets)
+{
+    return (hash >> 32 ^ hash) % nbuckets;
+}
+
+void blobsnap_writer_destroy (struct blobsnap_writer *w)
+{
+    if (w) {
+        int saved_errno = errno;
+        if (w->f)
+            (void)fclose (w->f);
+        if (!w->committed && w->tmppath)
+            (void)unlink (w->tmppath);
+        free (w->keys);
+        free (w->root);
+        free (w->tmppath);
+        free (w->path);
+        free (w);
+        errno = saved_errno;
+    }
+}
+
+static int write_data (struct blobsnap_writer *w, const void *data, size_t len)
+{
+    if (len > 0 && fwrite (data, len, 1, w->f) != 1)
+        return -1;
+    w->off += len;
+    return 0;
+}
+
+/* Write 'len' bytes of 'data', then pad the file to SNAP_ALIGN.
+ */
+static int write_padded (struct blobsnap_writer *w, const void *data, size_t len)
+{
+    static const char zeros[SNAP_ALIGN];
+
+    if (write_data (w, data, len) < 0
+        || write_data (w, zeros, pad (w->off) - w->off) < 0)
+        return -1;
+    return 0;
+}
+
+struct blobsnap_writer *blobsnap_writer_create (const char *path,
+                                                const char *root)
+{
+    struct blobsnap_writer *w;
+    struct snap_header hdr;
+
+    if (!path || !root) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(w = calloc (1, sizeof (*w))))
+        return NULL;
+    if (!(w->path = strdup (path))
+        || !(w->root = strdup (root))
+        || asprintf (&w->tmppath, "%s.tmp", path) < 0)
+        goto nomem;
+    if (!(w->f = fopen (w->tmppath, "w")))
+        goto error;
+    memset (&hdr, 0, sizeof (hdr)); // rewritten by commit
+    if (write_padded (w, &hdr, sizeof (hdr)) < 0
+        || write_padded (w, w->root, strlen (w->root) + 1) < 0)
+        goto error;
+    return w;
+nomem:
+    errno = ENOMEM;
+error:
+    blobsnap_writer_destroy (w);
+    return NULL;
+}
+
+int blobsnap_writer_append (struct blobsnap_writer *w,
+                            const char *blobref,
+                            const void *data,
+                            int len)
+{
+    struct snap_key *key;
+    size_t reflen;
+
+    if (!w || w->committed || !blobref || len < 0 || (len > 0 && !data)) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (w->count == UINT32_MAX / 2) {
+        errno = EOVERFLOW;
+        return -1;
+    }
+    if (w->count == w->alloc) {
+        uint32_t n = w->alloc ? w->alloc * 2 : 1024;
+        struct snap_key *keys;
+
+        if (!(keys = realloc (w->keys, n * sizeof (keys[0]))))
+            return -1;
+        w->keys = keys;
+        w->alloc = n;
+    }
+    reflen = strlen (blobref) + 1;
+    key = &w->keys[w->count];
+    key->hash = hash_blobref (blobref);
+    key->off = w->off;
+    key->reflen = reflen;
+    key->size = len;
+    if (write_data (w, blobref, reflen) < 0
+        || write_padded (w, data, len) < 0)
+        return -1;
+    w->count++;
+    return 0;
+}
+
+struct bucket {
+    uint32_t id;
+    uint32_t start;             // first key index in the bucket's run
+    uint32_t size;
+};
+
+static int bucket_cmp (const void *a, const void *b)
+{
+    const struct bucket *b1 = a;
+    const struct bucket *b2 = b;
+
+    if (b1->size != b2->size)
+        return b1->size < b2->size ? 1 : -1;
+    return b1->id < b2->id ? -1 : b1->id > b2->id;
+}
+
+/* Try to place every key with 'nslots' slots.  Keys are grouped by bucket
+ * into 'order', and for each bucket, largest first, the smallest
+ * displacement that puts all of its keys in free slots is chosen.
+ * Returns 0 on success, -1 if some bucket could not be placed.
+ */
+static int build_index (struct blobsnap_writer *w,
+                        uint32_t nslots,
+                        uint32_t nbuckets,
+                        uint32_t *disp,
+                        uint32_t *slotkey,  // key index + 1, 0 if empty
+                        uint32_t *order,
+                        struct bucket *buckets)
+{
+    uint32_t placed[SNAP_MAX_BUCKET];
+    uint32_t i, j;
+
+    for (i = 0; i < nbuckets; i++) {
+        buckets[i].id = i;
+        buckets[i].size = 0;
+    }
+    for (i = 0; i < w->count; i++)
+        buckets[bucket_of (w->keys[i].hash, nbuckets)].size++;
+    for (i = 0, j = 0; i < nbuckets; i++) {
+        buckets[i].start = j;
+        j += buckets[i].size;
+        buckets[i].size = 0;
+    }
+    for (i = 0; i < w->count; i++) {
+        struct bucket *b = &buckets[bucket_of (w->keys[i].hash, nbuckets)];
+        order[b->start + b->size++] = i;
+    }
+    qsort (buckets, nbuckets, sizeof (buckets[0]), bucket_cmp);
+    memset (disp, 0, nbuckets * sizeof (disp[0]));
+    memset (slotkey, 0, nslots * sizeof (slotkey[0]));
+
+    for (i = 0; i < nbuckets && buckets[i].size > 0; i++) {
+        struct bucket *b = &buckets[i];
+        uint32_t d;
+
+        if (b->size > SNAP_MAX_BUCKET)
+            return -1;
+        for (d = 0; d < nslots * 4 + 64; d++) {
+            uint32_t k;
+
+            for (k = 0; k < b->size; k++) {
+                uint32_t key = order[b->start + k];
+                uint32_t slot = slot_of (w->keys[key].hash, d, nslots);
+
+                if (slotkey[slot] != 0)
+                    break;
+                slotkey[slot] = key + 1;
+                placed[k] = slot;
+            }
+            if (k == b->size)
+                break;
+            while (k > 0) // undo
+                slotkey[placed[--k]] = 0;
+        }
+        if (d == nslots * 4 + 64)
+            return -1;
+        disp[b->id] = d;
+    }
+    return 0;
+}
+
+int blobsnap_writer_commit (struct blobsnap_writer *w)
+{
+    struct snap_header hdr;
+    uint32_t nbuckets;
+    uint32_t nslots;
+    uint32_t *disp = NULL;
+    uint32_t *slotkey = NULL;
+    uint32_t *order = NULL;
+    struct bucket *buckets = NULL;
+    uint64_t index_off;
+    uint32_t i;
+    int attempt;
+    int rc = -1;
+
+    if (!w || w->committed) {
+        errno = EINVAL;
+        return -1;
+    }
+    nbuckets = w->count / 4 + 1;
+    nslots = w->count + w->count / 4 + 1;
+    if (!(disp = calloc (nbuckets, sizeof (disp[0])))
+        || !(order = calloc (w->count + 1, sizeof (order[0])))
+        || !(buckets = calloc (nbuckets, sizeof (buckets[0]))))
+        goto done;
+    for (attempt = 0; ; attempt++) {
+        free (slotkey);
+        if (!(slotkey = calloc (nslots, sizeof (slotkey[0]))))
+            goto done;
+        if (build_index (w, nslots, nbuckets, disp, slotkey, order, buckets)
+            == 0)
+            break;
+        if (attempt == SNAP_MAX_ATTEMPTS) {
+            errno = EINVAL; // e.g. a blobref appended twice
+            goto done;
+        }
+        nslots += nslots / 4 + 1;
+    }
+
+    index_off = w->off;
+    for (i = 0; i < nbuckets; i++)
+        disp[i] = htonl (disp[i]);
+    if (write_padded (w, disp, nbuckets * sizeof (disp[0])) < 0)
+        goto done;
+    for (i = 0; i < nslots; i++) {
+        struct snap_slot slot = { 0 };
+
+        if (slotkey[i] > 0) {
+            struct snap_key *key = &w->keys[slotkey[i] - 1];
+            slot.off_hi = htonl (key->off >> 32);
+            slot.off_lo = htonl (key->off & 0xffffffff);
+            slot.reflen = htonl (key->reflen);
+            slot.size = htonl (key->size);
+        }
+        if (fwrite (&slot, sizeof (slot), 1, w->f) != 1)
+            goto done;
+        w->off += sizeof (slot);
+    }
+
+    memcpy (hdr.magic, SNAP_MAGIC, SNAP_MAGIC_LEN);
+    hdr.count = htonl (w->count);
+    hdr.nslots = htonl (nslots);
+    hdr.nbuckets = htonl (nbuckets);
+    hdr.rootlen = htonl (strlen (w->root) + 1);
+    hdr.index_hi = htonl (index_off >> 32);
+    hdr.index_lo = htonl (index_off & 0xffffffff);
+    if (fseek (w->f, 0, SEEK_SET) < 0
+        || fwrite (&hdr, sizeof (hdr), 1, w->f) != 1
+        || fflush (w->f) != 0
+        || fsync (fileno (w->f)) < 0)
+        goto done;
+    if (fclose (w->f) != 0) {
+        w->f = NULL;
+        goto done;
+    }
+    w->f = NULL;
+    if (rename (w->tmppath, w->path) < 0)
+        goto done;
+    w->committed = 1;
+    rc = 0;
+done:
+    if (rc < 0 && errno == 0)
+        errno = EIO;
+    free (buckets);
+    free (order);
+    free (slotkey);
+    free (disp);
+    return rc;
+}
+
+void blobsnap_close (struct blobsnap *snap)
+{
+    if (snap) {
+        int saved_errno = errno;
+        if (snap->map)
+            (void)munmap ((void *)snap->map, snap->size);
+        free (snap);
+        errno = saved_errno;
+    }
+}
+
+struct blobsnap *blobsnap_open (const char *path)
+{
+    struct blobsnap *snap;
+    struct snap_header hdr;
+    struct stat sb;
+    uint64_t index_off;
+    uint64_t rootlen;
+    uint64_t index_size;
+    void *map;
+    int fd;
+
+    if (!path) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(snap = calloc (1, sizeof (*snap))))
+        return NULL;
+    if ((fd = open (path, O_RDONLY)) < 0)
+        goto error;
+    if (fstat (fd, &sb) < 0) {
+        close (fd);
+        goto error;
+    }
+    if (sb.st_size < (off_t)sizeof (hdr)) {
+        close (fd);
+        goto eproto;
+    }
+    map = mmap (NULL, sb.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close (fd);
+    if (map == MAP_FAILED)
+        goto error;
+    snap->map = map;
+    snap->size = sb.st_size;
+
+    memcpy (&hdr, snap->map, sizeof (hdr));
+    if (memcmp (hdr.magic, SNAP_MAGIC, SNAP_MAGIC_LEN) != 0)
+        goto eproto;
+    snap->count = ntohl (hdr.count);
+    snap->nslots = ntohl (hdr.nslots);
+    snap->nbuckets = ntohl (hdr.nbuckets);
+    rootlen = ntohl (hdr.rootlen);
+    index_off = (uint64_t)ntohl (hdr.index_hi) << 32 | ntohl (hdr.index_lo);
+    index_size = pad ((uint64_t)snap->nbuckets * sizeof (uint32_t))
+                 + (uint64_t)snap->nslots * sizeof (struct snap_slot);
+    if (snap->nbuckets == 0
+        || snap->nslots < snap->count
+        || rootlen == 0
+        || sizeof (hdr) + rootlen > index_off
+        || index_off % SNAP_ALIGN
+        || index_off > snap->size
+        || index_size > snap->size - index_off)
+        goto eproto;
+    snap->root = snap->map + pad (sizeof (hdr));
+    if (snap->root[rootlen - 1] != '\0')
+        goto eproto;
+    snap->disp = (const uint32_t *)(snap->map + index_off);
+    snap->slots = (const struct snap_slot *)(snap->map + index_off
+                      + pad (snap->nbuckets * sizeof (uint32_t)));
+    return snap;
+eproto:
+    errno = EPROTO;
+error:
+    blobsnap_close (snap);
+    return NULL;
+}
+
+const char *blobsnap_root (struct blobsnap *snap)
+{
+    return snap ? snap->root : NULL;
+}
+
+int blobsnap_count (struct blobsnap *snap)
+{
+    return snap ? snap->count : 0;
+}
+
+int blobsnap_get (struct blobsnap *snap,
+                  const char *blobref,
+                  const void **data,
+                  int *len)
+{
+    const struct snap_slot *slot;
+    uint64_t hash;
+    uint64_t off;
+    uint32_t reflen;
+    uint32_t size;
+
+    if (!snap || !blobref) {
+        errno = EINVAL;
+        return -1;
+    }
+    hash = hash_blobref (blobref);
+    slot = &snap->slots[slot_of (hash,
+                                 ntohl (snap->disp[bucket_of (hash,
+                                                    snap->nbuckets)]),
+                                 snap->nslots)];
+    off = (uint64_t)ntohl (slot->off_hi) << 32 | ntohl (slot->off_lo);
+    reflen = ntohl (slot->reflen);
+    size = ntohl (slot->size);
+    if (off == 0
+        || reflen == 0
+        || off > snap->size
+        || reflen > snap->size - off
+        || size > snap->size - off - reflen
+        || size > INT32_MAX
+        || snap->map[off + reflen - 1] != '\0'
+        || strcmp (snap->map + off, blobref) != 0) {
+        errno = ENOENT;
+        return -1;
+    }
+    if (data)
+        *data = snap->map + off + reflen;
+    if (len)
+        *len = size;
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,76 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _UTIL_BLOBSNAP_H
+#define _UTIL_BLOBSNAP_H
+
+#include <stddef.h>
+
+/* A blob snapshot is a read-only file of blobs keyed by blobref, written
+ * once and then memory mapped, so blobs can be served from it without
+ * reading or copying them.  Blobs are looked up through a perfect hash
+ * index, in which each blobref maps to exactly one slot, so a lookup
+ * reads one displacement and one slot.  The file also records the root
+ * blobref the snapshot was taken from.
+ */
+
+struct blobsnap;
+struct blobsnap_writer;
+
+/* Begin writing a snapshot of the blobs reachable from 'root', to be
+ * renamed to 'path' by blobsnap_writer_commit().
+ * Returns writer on success, NULL with errno set on failure.
+ */
+struct blobsnap_writer *blobsnap_writer_create (const char *path,
+                                                const char *root);
+
+/* Discard the writer, and the snapshot if it was not committed.
+ */
+void blobsnap_writer_destroy (struct blobsnap_writer *w);
+
+/* Add blob 'data' of 'len' bytes named 'blobref'.  Each blobref may be
+ * added only once.  Returns 0 on success, -1 with errno set on failure.
+ */
+int blobsnap_writer_append (struct blobsnap_writer *w,
+                            const char *blobref,
+                            const void *data,
+                            int len);
+
+/* Write the index, sync the file, and move it into place.
+ * Returns 0 on success, -1 with errno set on failure.
+ */
+int blobsnap_writer_commit (struct blobsnap_writer *w);
+
+/* Open and map the snapshot at 'path', checking its header.
+ * Returns snapshot on success, NULL with errno set on failure.
+ */
+struct blobsnap *blobsnap_open (const char *path);
+void blobsnap_close (struct blobsnap *snap);
+
+/* Get the root blobref and the number of blobs.
+ */
+const char *blobsnap_root (struct blobsnap *snap);
+int blobsnap_count (struct blobsnap *snap);
+
+/* Look up the blob named 'blobref'.  On success, 'data' and 'len' are
+ * assigned the blob content, which points into the mapping and remains
+ * valid until blobsnap_close().  Returns 0 on success, -1 with errno set
+ * (ENOENT if the blob is not in the snapshot).
+ */
+int blobsnap_get (struct blobsnap *snap,
+                  const char *blobref,
+                  const void **data,
+                  int *len);
+
+#endif /* !_UTIL_BLOBSNAP_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,135 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* bloom.c - bloom filter
+ *
+ * The k bit positions for a key are derived from two 64-bit hashes
+ * as h1 + i * h2 (Kirsch and Mitzenmacher), so each key is hashed once.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+
+#include "bloom.h"
+
+struct bloom {
+    uint64_t *bits;
+    uint64_t nbits;
+    int nhash;
+    size_t count;
+};
+
+/* FNV-1a, followed by a mixing step to spread the high bits.
+ */
+static uint64_t hash64 (const void *key, size_t len)
+{
+    const unsigned char *p = key;
+    uint64_t h = 0xcbf29ce484222325ULL;
+
+    for (size_t i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= 0x100000001b3ULL;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return h;
+}
+
+static uint64_t rehash64 (uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h | 1; // odd, so the positions don't repeat early
+}
+
+struct bloom *bloom_create (size_t nbits, int nhash)
+{
+    struct bloom *b;
+
+    if (nbits == 0 || nhash < 1) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(b = calloc (1, sizeof (*b))))
+        return NULL;
+    b->nbits = ((uint64_t)nbits + 63) & ~(uint64_t)63;
+    b->nhash = nhash;
+    if (!(b->bits = calloc (b->nbits / 64, sizeof (b->bits[0])))) {
+        free (b);
+        errno = ENOMEM;
+        return NULL;
+    }
+    return b;
+}
+
+void bloom_destroy (struct bloom *b)
+{
+    if (b) {
+        int saved_errno = errno;
+        free (b->bits);
+        free (b);
+        errno = saved_errno;
+    }
+}
+
+void bloom_add (struct bloom *b, const void *key, size_t len)
+{
+    uint64_t h1, h2;
+
+    if (!b)
+        return;
+    h1 = hash64 (key, len);
+    h2 = rehash64 (h1);
+    for (int i = 0; i < b->nhash; i++) {
+        uint64_t bit = (h1 + i * h2) % b->nbits;
+        b->bits[bit / 64] |= 1ULL << (bit % 64);
+    }
+    b->count++;
+}
+
+bool bloom_check (struct bloom *b, const void *key, size_t len)
+{
+    uint64_t h1, h2;
+
+    if (!b)
+        return false;
+    h1 = hash64 (key, len);
+    h2 = rehash64 (h1);
+    for (int i = 0; i < b->nhash; i++) {
+        uint64_t bit = (h1 + i * h2) % b->nbits;
+        if (!(b->bits[bit / 64] & (1ULL << (bit % 64))))
+            return false;
+    }
+    return true;
+}
+
+void bloom_clear (struct bloom *b)
+{
+    if (b) {
+        memset (b->bits, 0, b->nbits / 8);
+        b->count = 0;
+    }
+}
+
+size_t bloom_count (struct bloom *b)
+{
+    return b ? b->count : 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
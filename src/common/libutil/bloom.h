@@ -0,0 +1,51 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _UTIL_BLOOM_H
+#define _UTIL_BLOOM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Bloom filter over byte string keys.
+ *
+ * bloom_check() never returns false for a key that was added since the
+ * last bloom_clear(), but may return true for a key that was not added,
+ * with a probability that grows as keys are added.  For n keys, a filter
+ * of 'nbits' bits and 'nhash' hash functions has a false positive rate
+ * of about (1 - e^(-nhash * n / nbits))^nhash.  For example, 10 bits per
+ * key and 7 hash functions give a rate of about 1%.
+ */
+
+struct bloom;
+
+/* Create a filter of 'nbits' bits (rounded up to a multiple of 64),
+ * setting 'nhash' bits per key.
+ */
+struct bloom *bloom_create (size_t nbits, int nhash);
+void bloom_destroy (struct bloom *b);
+
+void bloom_add (struct bloom *b, const void *key, size_t len);
+bool bloom_check (struct bloom *b, const void *key, size_t len);
+
+/* Remove all keys.
+ */
+void bloom_clear (struct bloom *b);
+
+/* Get the number of keys added since the last bloom_clear(), counting
+ * a key each time it is added.
+ */
+size_t bloom_count (struct bloom *b);
+
+#endif /* !_UTIL_BLOOM_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
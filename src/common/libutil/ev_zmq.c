@@ -20,12 +20,14 @@
  * - 0MQ provides ZMQ_FD getsockopt to obtain the fd of a mailbox that
  *   becomes readable when ZMQ_EVENTS != 0 (edge triggered)
  * - libev prepare/check callbacks are used to test ZMQ_EVENTS, make user
- *   callbacks, and enable/disable no-op io and idle watchers.
+ *   callbacks, and enable/disable a no-op idle watcher.
  * - while ZMQ_EVENTS != 0, enable no-op idle watcher (no callback)
  *   so that the libev loop will continue looping, executing prepare/check
- * - when ZMQ_EVENTS == 0, enable no-op io watcher on ZMQ_FD (no callback)
- *   so that the libev loop will unblock, executing prepare/check
+ * - an io watcher on ZMQ_FD stays enabled while the ev_zmq watcher is
+ *   started, so that the libev loop will unblock, executing prepare/check
  *   on the next mailbox event
+ * - if ZMQ_EVENTS was 0 in prepare and ZMQ_FD has not become readable,
+ *   check skips testing ZMQ_EVENTS again
  */
 
 #include <czmq.h>
@@ -35,6 +37,16 @@
 #include "src/common/libev/ev.h"
 #include "src/common/libutil/ev_zmq.h"
 
+static void io_cb (struct ev_loop *loop, ev_io *w, int revents)
+{
+    ev_zmq *zw = (ev_zmq *)((char *)w - offsetof (ev_zmq, io_w));
+
+    /* Normally check_cb consumes io_w's pending event first.  If not,
+     * make sure the next check_cb tests ZMQ_EVENTS.
+     */
+    ev_idle_start (loop, &zw->idle_w);
+}
+
 static void prepare_cb (struct ev_loop *loop, ev_prepare *w, int revents)
 {
     ev_zmq *zw = (ev_zmq *)((char *)w - offsetof (ev_zmq, prepare_w));
@@ -48,8 +60,6 @@ static void prepare_cb (struct ev_loop *loop, ev_prepare *w, int revents)
         ev_idle_start (loop, &zw->idle_w);
     else if ((revents = ztoe (zevents) & zw->events))
         ev_idle_start (loop, &zw->idle_w);
-    else
-        ev_io_start (loop, &zw->io_w);
 }
 
 static void check_cb (struct ev_loop *loop, ev_check *w, int revents)
@@ -58,14 +68,15 @@ static void check_cb (struct ev_loop *loop, ev_check *w, int revents)
     uint32_t zevents = 0;
     size_t zevents_size = sizeof (zevents);
     void *handle = zsock_resolve (zw->zsock);
+    int io_revents = ev_clear_pending (loop, &zw->io_w);
 
-    ev_io_stop (loop, &zw->io_w);
+    if (!ev_is_active (&zw->idle_w) && io_revents == 0)
+        return;
     ev_idle_stop (loop, &zw->idle_w);
 
     if (handle == NULL)
         zw->cb (loop, zw, EV_ERROR);
-    else if (ev_is_pending (&zw->io_w)
-            && ev_clear_pending (loop, &zw->io_w) & EV_ERROR)
+    else if ((io_revents & EV_ERROR))
         zw->cb (loop, zw, EV_ERROR);
     else if (zmq_getsockopt (handle, ZMQ_EVENTS, &zevents, &zevents_size) < 0)
         zw->cb (loop, zw, EV_ERROR);
@@ -89,7 +100,7 @@ int ev_zmq_init (ev_zmq *w, ev_zmq_cb cb, void *zsock, int events)
     ev_prepare_init (&w->prepare_w, prepare_cb);
     ev_check_init (&w->check_w, check_cb);
     ev_idle_init (&w->idle_w, NULL);
-    ev_io_init (&w->io_w, NULL, w->fd, EV_READ);
+    ev_io_init (&w->io_w, io_cb, w->fd, EV_READ);
 
     return 0;
 }
@@ -98,6 +109,7 @@ void ev_zmq_start (struct ev_loop *loop, ev_zmq *w)
 {
     ev_prepare_start (loop, &w->prepare_w);
     ev_check_start (loop, &w->check_w);
+    ev_io_start (loop, &w->io_w);
 }
 
 void ev_zmq_stop (struct ev_loop *loop, ev_zmq *w)
@@ -26,10 +26,11 @@
 #include "fluid.h"
 #include "mnemonic.h"
 
-/* fluid: [ts:40 id:14 seq:10] */
+/* fluid: [ts:40 id:14 seq:10] by default.  The id/seq split may be
+ * changed per generator, but the timestamp always occupies the top 40 bits.
+ */
 static const int bits_per_ts = 40;
-static const int bits_per_id = 14;
-static const int bits_per_seq = 10;
+static const int bits_per_idseq = 24;
 
 /* Max base58 string length for F58 encoding */
 #define MAX_B58_STRLEN 12
@@ -88,19 +89,30 @@ static int current_ds (uint64_t *ds)
     return 0;
 }
 
-int fluid_init (struct fluid_generator *gen, uint32_t id, uint64_t timestamp)
+int fluid_init_bits (struct fluid_generator *gen,
+                     uint32_t id,
+                     int id_bits,
+                     uint64_t timestamp)
 {
+    if (id_bits < 0 || id_bits > FLUID_ID_BITS_DEFAULT)
+        return -1;
     if (current_ds (&gen->clock_zero) < 0)
         return -1;
-    if (id >= (1ULL<<bits_per_id))
+    if (id >= (1ULL<<id_bits))
         return -1;
     gen->id = id;
+    gen->id_bits = id_bits;
     gen->seq = 0;
     gen->clock_offset = timestamp;
     gen->timestamp = timestamp;
     return 0;
 }
 
+int fluid_init (struct fluid_generator *gen, uint32_t id, uint64_t timestamp)
+{
+    return fluid_init_bits (gen, id, FLUID_ID_BITS_DEFAULT, timestamp);
+}
+
 static int update_timestamp (struct fluid_generator *gen)
 {
     uint64_t clock;
@@ -128,26 +140,42 @@ int fluid_save_timestamp (struct fluid_generator *gen, uint64_t *timestamp)
 
 uint64_t fluid_get_timestamp (fluid_t fluid)
 {
-    return fluid >> (bits_per_seq + bits_per_id);
+    return fluid >> bits_per_idseq;
+}
+
+int fluid_range_max (struct fluid_generator *gen)
+{
+    return (1ULL<<(bits_per_idseq - gen->id_bits)) - 1;
 }
 
-/* If sequence bits were exhausted (already 1024 allocated in this timestamp),
+/* If the sequence bits remaining in this timestamp can't hold 'count' IDs,
  * busy-wait, calling update_timestamp() until seq is cleared.
  * The busy-wait time is bounded by the timestamp quanta (1 msec).
  */
-int fluid_generate (struct fluid_generator *gen, fluid_t *fluid)
+int fluid_generate_range (struct fluid_generator *gen,
+                          int count,
+                          fluid_t *fluid)
 {
+    int bits_per_seq = bits_per_idseq - gen->id_bits;
+
+    if (count < 1 || count > fluid_range_max (gen))
+        return -1;
     do {
         if (update_timestamp (gen) < 0)
             return -1;
-    } while (gen->seq + 1 >= (1ULL<<bits_per_seq));
-    *fluid = (gen->timestamp << (bits_per_seq + bits_per_id)
-                    | (gen->id << bits_per_seq)
+    } while (gen->seq + count >= (1ULL<<bits_per_seq));
+    *fluid = (gen->timestamp << bits_per_idseq
+                    | ((uint64_t)gen->id << bits_per_seq)
                     | gen->seq);
-    gen->seq++;
+    gen->seq += count;
     return 0;
 }
 
+int fluid_generate (struct fluid_generator *gen, fluid_t *fluid)
+{
+    return fluid_generate_range (gen, 1, fluid);
+}
+
 /*  F58 encoding.
  */
 /*  Compute base58 encoding of id in *reverse*
@@ -332,16 +360,13 @@ int fluid_encode (char *buf, int bufsz, fluid_t fluid,
 
 static int fluid_validate (fluid_t fluid)
 {
-    unsigned long long ts = fluid >> (bits_per_seq + bits_per_id);
-    unsigned int id = (fluid >> bits_per_seq) & ((1<<bits_per_id) - 1);
-    unsigned int seq = fluid & ((1<<bits_per_seq) - 1);
+    unsigned long long ts = fluid >> bits_per_idseq;
 
+    /* N.B. the id/seq split is not encoded in the FLUID, and any value
+     * of the low 24 bits is valid.
+     */
     if (ts >= (1ULL<<bits_per_ts))
         return -1;
-    if (id >= (1<<bits_per_id))
-        return -1;
-    if (seq >= (1<<bits_per_seq))
-        return -1;
     return 0;
 }
 
@@ -17,8 +17,14 @@
  * - timestamp (ms since epoch):  40 bits (35 year long runtime)
  * - generator ID:                14 bits (up to 16K generators)
  * - sequence number:             10 bits (1024 IDs per ms)
+ * The 24 bits below the timestamp may be split differently between
+ * generator ID and sequence number with fluid_init_bits(), e.g. to allow
+ * more IDs per ms when there are few generators.  All generators that
+ * share an ID space must use the same split.
  */
 
+#define FLUID_ID_BITS_DEFAULT   14
+
 typedef enum {
     FLUID_STRING_DOTHEX = 1,    // x.x.x.x
     FLUID_STRING_MNEMONIC = 2,  // mnemonicode x-x-x--x-x-x
@@ -27,7 +33,8 @@ typedef enum {
 
 struct fluid_generator {
     uint16_t id;
-    uint16_t seq;
+    uint32_t seq;
+    int id_bits;                // generator ID bits (seq gets 24 - id_bits)
     uint64_t clock_zero;        // local clock value at fluid_init()
     uint64_t clock_offset;      // clock offset due to starting timestamp
     uint64_t timestamp;
@@ -41,6 +48,14 @@ typedef uint64_t fluid_t;
  */
 int fluid_init (struct fluid_generator *gen, uint32_t id, uint64_t timestamp);
 
+/* Like fluid_init(), but allocate 'id_bits' (0 to FLUID_ID_BITS_DEFAULT)
+ * to the generator ID and the rest of the 24 bits to the sequence number.
+ */
+int fluid_init_bits (struct fluid_generator *gen,
+                     uint32_t id,
+                     int id_bits,
+                     uint64_t timestamp);
+
 /* Returns 0 on success, -1 on failure.
  * Failures include timestamp out of range, clock_gettime() error.
  * N.B. may occasionally call usleep(3) for up to 1 ms to throttle
@@ -48,6 +63,20 @@ int fluid_init (struct fluid_generator *gen, uint32_t id, uint64_t timestamp);
  */
 int fluid_generate (struct fluid_generator *gen, fluid_t *fluid);
 
+/* Reserve 'count' consecutive FLUIDs, [*fluid, *fluid + count - 1].
+ * 'count' may not exceed fluid_range_max().
+ * Returns 0 on success, -1 on failure.
+ * N.B. like fluid_generate(), may wait for up to 1 ms if the sequence
+ * numbers remaining in the current ms are fewer than 'count'.
+ */
+int fluid_generate_range (struct fluid_generator *gen,
+                          int count,
+                          fluid_t *fluid);
+
+/* Return the maximum 'count' for fluid_generate_range().
+ */
+int fluid_range_max (struct fluid_generator *gen);
+
 /* Update and retrieve the internal timestamp.
  * Returns 0 on success, -1 on failure.
  */
@@ -0,0 +1,79 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <jansson.h>
+
+#include "loghist.h"
+
+void loghist_add (struct loghist *lh, double t)
+{
+    uint64_t usec;
+    int bucket;
+
+    if (!(t > 0.))
+        t = 0.;
+    usec = t < 1E12 ? (uint64_t)(t * 1E6) : UINT64_MAX;
+    bucket = usec == 0 ? 0 : 64 - __builtin_clzll (usec);
+    if (bucket >= LOGHIST_BUCKETS)
+        bucket = LOGHIST_BUCKETS - 1;
+
+    lh->count++;
+    lh->total += t;
+    if (lh->max < t)
+        lh->max = t;
+    lh->hist[bucket]++;
+}
+
+void loghist_clear (struct loghist *lh)
+{
+    memset (lh, 0, sizeof (*lh));
+}
+
+json_t *loghist_encode (const struct loghist *lh)
+{
+    json_t *hist;
+    json_t *o;
+    int n;
+
+    for (n = LOGHIST_BUCKETS; n > 0; n--) {
+        if (lh->hist[n - 1] > 0)
+            break;
+    }
+    if (!(hist = json_array ()))
+        goto nomem;
+    for (int i = 0; i < n; i++) {
+        json_t *count = json_integer (lh->hist[i]);
+        if (!count || json_array_append_new (hist, count) < 0) {
+            json_decref (count);
+            json_decref (hist);
+            goto nomem;
+        }
+    }
+    if (!(o = json_pack ("{s:i s:f s:f s:o}",
+                         "count", lh->count,
+                         "total", lh->total,
+                         "max", lh->max,
+                         "hist", hist)))
+        goto nomem;
+    return o;
+nomem:
+    errno = ENOMEM;
+    return NULL;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,44 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _UTIL_LOGHIST_H
+#define _UTIL_LOGHIST_H
+
+#include <jansson.h>
+
+/* Log2 histogram of durations, bucketed in microseconds like
+ * flux_cbstats_t: hist[0] < 1us, hist[i] < 2^i us, and the last
+ * bucket is unbounded (2^30us is about 18 minutes).
+ */
+#define LOGHIST_BUCKETS 32
+
+struct loghist {
+    int count;
+    double total;               /* seconds */
+    double max;                 /* seconds */
+    int hist[LOGHIST_BUCKETS];
+};
+
+/* Add a duration of 't' seconds.  Negative durations count as zero.
+ */
+void loghist_add (struct loghist *lh, double t);
+
+void loghist_clear (struct loghist *lh);
+
+/* Encode as {"count":i, "total":f, "max":f, "hist":[i, ...]},
+ * with trailing empty buckets trimmed.  Returns NULL with errno set
+ * on failure.
+ */
+json_t *loghist_encode (const struct loghist *lh);
+
+#endif /* !_UTIL_LOGHIST_H */
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
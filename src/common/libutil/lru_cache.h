@@ -57,6 +57,13 @@ bool lru_cache_check (lru_cache_t *lru, const char *key);
  */
 int lru_cache_remove (lru_cache_t *lru, const char *key);
 
+/*
+ *  Remove the least recently used item from the LRU cache, e.g. to
+ *   enforce a limit other than the item count.
+ *  Returns 0 on success, -1 with errno set to ENOENT if cache is empty.
+ */
+int lru_cache_purge_last (lru_cache_t *lru);
+
 /*
  *   Run lru cache self checks on object `lru`. Used in testing.
  *    Returns < 0 if any one of several consistency checks fails.
@@ -87,6 +87,7 @@ A million repetitions of "a"
 
 //#include "os_types.h"
 #include "sha1.h"
+#include "sha_accel.h"
 
 void SHA1_Transform(uint32_t state[5], const uint8_t buffer[64]);
 
@@ -212,6 +213,10 @@ void SHA1_Update(SHA1_CTX* context, const uint8_t* data, const size_t len)
     if ((j + len) > 63) {
         memcpy(&context->buffer[j], data, (i = 64-j));
         SHA1_Transform(context->state, context->buffer);
+        if (i + 63 < len
+            && sha1_accel_blocks(context->state, data + i, (len - i) / 64)) {
+            i += (len - i) & ~(size_t)63;
+        }
         for ( ; i + 63 < len; i += 64) {
             SHA1_Transform(context->state, data + i);
         }
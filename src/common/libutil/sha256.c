@@ -16,6 +16,7 @@
 #include <stdlib.h>
 #include <memory.h>
 #include "sha256.h"
+#include "sha_accel.h"
 
 /****************************** MACROS ******************************/
 #define ROTLEFT(a,b) (((a) << (b)) | ((a) >> (32-(b))))
@@ -98,17 +99,30 @@ void sha256_init(SHA256_CTX *ctx)
 
 void sha256_update(SHA256_CTX *ctx, const BYTE data[], size_t len)
 {
-	WORD i;
+	size_t i = 0;
 
-	for (i = 0; i < len; ++i) {
-		ctx->data[ctx->datalen] = data[i];
-		ctx->datalen++;
+	// Top up a partial block, then hash whole blocks straight from 'data',
+	// with CPU instructions if available.
+	while (ctx->datalen > 0 && i < len) {
+		ctx->data[ctx->datalen++] = data[i++];
 		if (ctx->datalen == 64) {
 			sha256_transform(ctx, ctx->data);
 			ctx->bitlen += 512;
 			ctx->datalen = 0;
 		}
 	}
+	if (len - i >= 64) {
+		size_t nblocks = (len - i) / 64;
+
+		if (!sha256_accel_blocks(ctx->state, data + i, nblocks)) {
+			for (size_t n = 0; n < nblocks; n++)
+				sha256_transform(ctx, data + i + 64 * n);
+		}
+		ctx->bitlen += 512 * (unsigned long long)nblocks;
+		i += 64 * nblocks;
+	}
+	while (i < len)
+		ctx->data[ctx->datalen++] = data[i++];
 }
 
 void sha256_final(SHA256_CTX *ctx, BYTE hash[])
@@ -0,0 +1,391 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* sha_accel.c - SHA-1 and SHA-256 with CPU instructions
+ *
+ * The x86 code is compiled with function target attributes, so the rest
+ * of the tree need not be built for a CPU with the SHA extensions, and is
+ * selected at runtime with cpuid.  The ARMv8 code is only built when the
+ * compiler already targets the crypto extensions.
+ *
+ * The round structure follows the Intel and ARM reference sequences
+ * (see also Jeffrey Walton's public domain SHA-Intrinsics).
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <string.h>
+
+#include "sha_accel.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) \
+    && (defined(__GNUC__) || defined(__clang__))
+#define HAVE_SHA_X86 1
+#include <cpuid.h>
+#include <immintrin.h>
+#elif defined(__aarch64__) && (defined(__ARM_FEATURE_CRYPTO) \
+                               || defined(__ARM_FEATURE_SHA2))
+#define HAVE_SHA_ARM 1
+#include <arm_neon.h>
+#endif
+
+static const uint32_t sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+    0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+    0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+    0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+    0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+    0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+#if HAVE_SHA_X86
+#define SHA_TARGET __attribute__((target("sha,sse4.1,ssse3")))
+
+static bool cpu_has_sha (void)
+{
+    unsigned int a, b, c, d;
+
+    if (!__get_cpuid (1, &a, &b, &c, &d)
+        || !(c & bit_SSSE3)
+        || !(c & bit_SSE4_1))
+        return false;
+    if (__get_cpuid_max (0, NULL) < 7)
+        return false;
+    __cpuid_count (7, 0, a, b, c, d);
+    return (b & (1 << 29)) != 0; // SHA
+}
+
+/* Four SHA-1 rounds of function 'f' on message words 'm'.
+ */
+#define SHA1_ROUNDS4(f, m) \
+    do { \
+        e1 = _mm_sha1nexte_epu32 (e0, m); \
+        e0 = abcd; \
+        abcd = _mm_sha1rnds4_epu32 (abcd, e1, f); \
+    } while (0)
+
+/* Next four message words: w[t] = rol(w[t-3] ^ w[t-8] ^ w[t-14] ^ w[t-16]).
+ */
+#define SHA1_SCHEDULE(m0, m1, m2, m3) \
+    _mm_sha1msg2_epu32 (_mm_xor_si128 (_mm_sha1msg1_epu32 (m0, m1), m2), m3)
+
+SHA_TARGET
+static void sha1_x86 (uint32_t state[5], const uint8_t *data, size_t nblocks)
+{
+    const __m128i mask = _mm_set_epi64x (0x0001020304050607ULL,
+                                         0x08090a0b0c0d0e0fULL);
+    __m128i abcd, abcd_save, e0, e0_save, e1;
+    __m128i m[4];
+
+    abcd = _mm_shuffle_epi32 (_mm_loadu_si128 ((const __m128i *)state), 0x1b);
+    e0 = _mm_set_epi32 (state[4], 0, 0, 0);
+
+    while (nblocks-- > 0) {
+        abcd_save = abcd;
+        e0_save = e0;
+
+        for (int i = 0; i < 4; i++) {
+            m[i] = _mm_loadu_si128 ((const __m128i *)(data + 16 * i));
+            m[i] = _mm_shuffle_epi8 (m[i], mask);
+        }
+        /* Rounds 0-3 add e directly; later rounds derive it with nexte.
+         */
+        e1 = _mm_add_epi32 (e0, m[0]);
+        e0 = abcd;
+        abcd = _mm_sha1rnds4_epu32 (abcd, e1, 0);
+        SHA1_ROUNDS4 (0, m[1]);
+        SHA1_ROUNDS4 (0, m[2]);
+        SHA1_ROUNDS4 (0, m[3]);
+        for (int g = 4; g < 20; g++) {
+            m[g & 3] = SHA1_SCHEDULE (m[g & 3],
+                                      m[(g + 1) & 3],
+                                      m[(g + 2) & 3],
+                                      m[(g + 3) & 3]);
+            switch (g / 5) {
+                case 0:
+                    SHA1_ROUNDS4 (0, m[g & 3]);
+                    break;
+                case 1:
+                    SHA1_ROUNDS4 (1, m[g & 3]);
+                    break;
+                case 2:
+                    SHA1_ROUNDS4 (2, m[g & 3]);
+                    break;
+                default:
+                    SHA1_ROUNDS4 (3, m[g & 3]);
+                    break;
+            }
+        }
+        e0 = _mm_sha1nexte_epu32 (e0, e0_save);
+        abcd = _mm_add_epi32 (abcd, abcd_save);
+        data += 64;
+    }
+    abcd = _mm_shuffle_epi32 (abcd, 0x1b);
+    _mm_storeu_si128 ((__m128i *)state, abcd);
+    state[4] = _mm_extract_epi32 (e0, 3);
+}
+
+SHA_TARGET
+static void sha256_x86 (uint32_t state[8], const uint8_t *data, size_t nblocks)
+{
+    const __m128i mask = _mm_set_epi64x (0x0c0d0e0f08090a0bULL,
+                                         0x0405060700010203ULL);
+    __m128i state0, state1, abef_save, cdgh_save, msg, tmp;
+    __m128i w[4];
+
+    tmp = _mm_loadu_si128 ((const __m128i *)&state[0]);
+    state1 = _mm_loadu_si128 ((const __m128i *)&state[4]);
+    tmp = _mm_shuffle_epi32 (tmp, 0xb1);            // CDAB
+    state1 = _mm_shuffle_epi32 (state1, 0x1b);      // EFGH
+    state0 = _mm_alignr_epi8 (tmp, state1, 8);      // ABEF
+    state1 = _mm_blend_epi16 (state1, tmp, 0xf0);   // CDGH
+
+    while (nblocks-- > 0) {
+        abef_save = state0;
+        cdgh_save = state1;
+
+        for (int g = 0; g < 16; g++) {
+            __m128i *x = &w[g & 3];
+
+            if (g < 4) {
+                *x = _mm_loadu_si128 ((const __m128i *)(data + 16 * g));
+                *x = _mm_shuffle_epi8 (*x, mask);
+            }
+            else {
+                /* w[t-16] + s0(w[t-15]) + w[t-7], then add s1(w[t-2])
+                 */
+                tmp = _mm_sha256msg1_epu32 (*x, w[(g + 1) & 3]);
+                tmp = _mm_add_epi32 (tmp, _mm_alignr_epi8 (w[(g + 3) & 3],
+                                                           w[(g + 2) & 3],
+                                                           4));
+                *x = _mm_sha256msg2_epu32 (tmp, w[(g + 3) & 3]);
+            }
+            msg = _mm_add_epi32 (*x,
+                                 _mm_loadu_si128 ((const __m128i *)
+                                                  &sha256_k[4 * g]));
+            state1 = _mm_sha256rnds2_epu32 (state1, state0, msg);
+            msg = _mm_shuffle_epi32 (msg, 0x0e);
+            state0 = _mm_sha256rnds2_epu32 (state0, state1, msg);
+        }
+        state0 = _mm_add_epi32 (state0, abef_save);
+        state1 = _mm_add_epi32 (state1, cdgh_save);
+        data += 64;
+    }
+    tmp = _mm_shuffle_epi32 (state0, 0x1b);         // FEBA
+    state1 = _mm_shuffle_epi32 (state1, 0xb1);      // DCHG
+    state0 = _mm_blend_epi16 (tmp, state1, 0xf0);   // DCBA
+    state1 = _mm_alignr_epi8 (state1, tmp, 8);      // HGFE
+    _mm_storeu_si128 ((__m128i *)&state[0], state0);
+    _mm_storeu_si128 ((__m128i *)&state[4], state1);
+}
+#endif /* HAVE_SHA_X86 */
+
+#if HAVE_SHA_ARM
+static void sha1_arm (uint32_t state[5], const uint8_t *data, size_t nblocks)
+{
+    uint32x4_t abcd = vld1q_u32 (state);
+    uint32_t e0 = state[4];
+
+    while (nblocks-- > 0) {
+        uint32x4_t abcd_save = abcd;
+        uint32_t e0_save = e0;
+        uint32x4_t m[4];
+        uint32_t e1;
+
+        for (int i = 0; i < 4; i++)
+            m[i] = vreinterpretq_u32_u8 (vrev32q_u8 (vld1q_u8 (data + 16 * i)));
+        for (int g = 0; g < 20; g++) {
+            uint32x4_t wk;
+            uint32_t k = g < 5 ? 0x5a827999
+                       : g < 10 ? 0x6ed9eba1
+                       : g < 15 ? 0x8f1bbcdc
+                       : 0xca62c1d6;
+
+            if (g >= 4) {
+                m[g & 3] = vsha1su1q_u32 (vsha1su0q_u32 (m[g & 3],
+                                                         m[(g + 1) & 3],
+                                                         m[(g + 2) & 3]),
+                                          m[(g + 3) & 3]);
+            }
+            wk = vaddq_u32 (m[g & 3], vdupq_n_u32 (k));
+            e1 = vsha1h_u32 (vgetq_lane_u32 (abcd, 0));
+            if (g < 5)
+                abcd = vsha1cq_u32 (abcd, e0, wk);
+            else if (g < 10 || g >= 15)
+                abcd = vsha1pq_u32 (abcd, e0, wk);
+            else
+                abcd = vsha1mq_u32 (abcd, e0, wk);
+            e0 = e1;
+        }
+        e0 += e0_save;
+        abcd = vaddq_u32 (abcd, abcd_save);
+        data += 64;
+    }
+    vst1q_u32 (state, abcd);
+    state[4] = e0;
+}
+
+static void sha256_arm (uint32_t state[8], const uint8_t *data, size_t nblocks)
+{
+    uint32x4_t state0 = vld1q_u32 (&state[0]);
+    uint32x4_t state1 = vld1q_u32 (&state[4]);
+
+    while (nblocks-- > 0) {
+        uint32x4_t abef_save = state0;
+        uint32x4_t cdgh_save = state1;
+        uint32x4_t m[4];
+
+        for (int i = 0; i < 4; i++)
+            m[i] = vreinterpretq_u32_u8 (vrev32q_u8 (vld1q_u8 (data + 16 * i)));
+        for (int g = 0; g < 16; g++) {
+            uint32x4_t wk, tmp;
+
+            if (g >= 4) {
+                m[g & 3] = vsha256su1q_u32 (vsha256su0q_u32 (m[g & 3],
+                                                             m[(g + 1) & 3]),
+                                            m[(g + 2) & 3],
+                                            m[(g + 3) & 3]);
+            }
+            wk = vaddq_u32 (m[g & 3], vld1q_u32 (&sha256_k[4 * g]));
+            tmp = state0;
+            state0 = vsha256hq_u32 (state0, state1, wk);
+            state1 = vsha256h2q_u32 (state1, tmp, wk);
+        }
+        state0 = vaddq_u32 (state0, abef_save);
+        state1 = vaddq_u32 (state1, cdgh_save);
+        data += 64;
+    }
+    vst1q_u32 (&state[0], state0);
+    vst1q_u32 (&state[4], state1);
+}
+
+static bool cpu_has_sha (void)
+{
+    return true; // compiler targets the crypto extensions
+}
+#endif /* HAVE_SHA_ARM */
+
+/* Known answers: the state after the single padded block of "abc".
+ */
+static void abc_block (uint8_t block[64])
+{
+    memset (block, 0, 64);
+    memcpy (block, "abc", 3);
+    block[3] = 0x80;
+    block[63] = 24; // message length in bits
+}
+
+static bool sha1_selftest (void (*fn)(uint32_t *, const uint8_t *, size_t))
+{
+    uint32_t state[5] = {
+        0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0,
+    };
+    const uint32_t expect[5] = {
+        0xa9993e36, 0x4706816a, 0xba3e2571, 0x7850c26c, 0x9cd0d89d,
+    };
+    uint8_t block[64];
+
+    abc_block (block);
+    fn (state, block, 1);
+    return memcmp (state, expect, sizeof (expect)) == 0;
+}
+
+static bool sha256_selftest (void (*fn)(uint32_t *, const uint8_t *, size_t))
+{
+    uint32_t state[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+        0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+    };
+    const uint32_t expect[8] = {
+        0xba7816bf, 0x8f01cfea, 0x414140de, 0x5dae2223,
+        0xb00361a3, 0x96177a9c, 0xb410ff61, 0xf20015ad,
+    };
+    uint8_t block[64];
+
+    abc_block (block);
+    fn (state, block, 1);
+    return memcmp (state, expect, sizeof (expect)) == 0;
+}
+
+typedef void (*block_f)(uint32_t *state, const uint8_t *data, size_t nblocks);
+
+/* Resolved on first use.  A race here is harmless, since every caller
+ * resolves the same answer.
+ */
+static block_f sha1_fn;
+static block_f sha256_fn;
+static bool resolved;
+
+static void resolve (void)
+{
+#if HAVE_SHA_X86 || HAVE_SHA_ARM
+    if (cpu_has_sha ()) {
+#if HAVE_SHA_X86
+        block_f f1 = sha1_x86;
+        block_f f256 = sha256_x86;
+#else
+        block_f f1 = sha1_arm;
+        block_f f256 = sha256_arm;
+#endif
+        if (sha1_selftest (f1))
+            sha1_fn = f1;
+        if (sha256_selftest (f256))
+            sha256_fn = f256;
+    }
+#endif
+    resolved = true;
+}
+
+bool sha1_accel_available (void)
+{
+    if (!resolved)
+        resolve ();
+    return sha1_fn != NULL;
+}
+
+bool sha256_accel_available (void)
+{
+    if (!resolved)
+        resolve ();
+    return sha256_fn != NULL;
+}
+
+bool sha1_accel_blocks (uint32_t state[5], const uint8_t *data, size_t nblocks)
+{
+    if (!sha1_accel_available ())
+        return false;
+    sha1_fn (state, data, nblocks);
+    return true;
+}
+
+bool sha256_accel_blocks (uint32_t state[8],
+                          const uint8_t *data,
+                          size_t nblocks)
+{
+    if (!sha256_accel_available ())
+        return false;
+    sha256_fn (state, data, nblocks);
+    return true;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,41 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _UTIL_SHA_ACCEL_H
+#define _UTIL_SHA_ACCEL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* SHA-1 and SHA-256 block functions using CPU instructions (x86 SHA
+ * extensions, or ARMv8 crypto extensions when the compiler targets them).
+ *
+ * Each processes 'nblocks' 64-byte blocks of 'data' into 'state' and
+ * returns true, or returns false without touching 'state' if the CPU
+ * lacks the instructions, in which case the caller must use portable
+ * code.  On first use, the instructions are checked against a known
+ * answer, and are not used if they disagree.
+ */
+bool sha1_accel_blocks (uint32_t state[5], const uint8_t *data, size_t nblocks);
+bool sha256_accel_blocks (uint32_t state[8],
+                          const uint8_t *data,
+                          size_t nblocks);
+
+/* Return true if the accelerated functions are in use.
+ */
+bool sha1_accel_available (void);
+bool sha256_accel_available (void);
+
+#endif /* !_UTIL_SHA_ACCEL_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,274 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* skiplist - sorted container with O(log n) insert, delete, and reorder
+ *
+ * Each node is linked in both directions at each of its levels, so
+ * a node can be unlinked through its handle without a search, even if
+ * its sort key has already changed (as before skiplist_reorder()).
+ * Node heights are chosen with p = 1/4, from a per-list xorshift
+ * generator, so the expected height is about 1.33 links per node.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+
+#include "skiplist.h"
+
+#define MAX_LEVEL 32
+
+struct link {
+    struct node *next;
+    struct node *prev;
+};
+
+struct node {
+    void *item;
+    int height;
+    struct link link[];
+};
+
+struct skiplist {
+    skiplist_compare_f cmp;
+    skiplist_destructor_f destructor;
+    size_t size;
+    int level;              // highest level in use
+    uint64_t seed;
+    struct node *cursor;
+    struct node *head;      // sentinel with MAX_LEVEL links
+};
+
+static struct node *node_create (void *item, int height)
+{
+    struct node *n;
+
+    if (!(n = calloc (1, sizeof (*n) + height * sizeof (n->link[0])))) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    n->item = item;
+    n->height = height;
+    return n;
+}
+
+static int random_height (struct skiplist *sl)
+{
+    uint64_t x = sl->seed;
+    int height = 1;
+
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    sl->seed = x;
+    while (height < MAX_LEVEL && (x & 3) == 0) {
+        height++;
+        x >>= 2;
+    }
+    return height;
+}
+
+static void node_link (struct skiplist *sl, struct node *n)
+{
+    struct node *update[MAX_LEVEL];
+    struct node *x = sl->head;
+    int i;
+
+    if (sl->level < n->height)
+        sl->level = n->height;
+    for (i = sl->level - 1; i >= 0; i--) {
+        while (x->link[i].next && sl->cmp (x->link[i].next->item, n->item) <= 0)
+            x = x->link[i].next;
+        update[i] = x;
+    }
+    for (i = 0; i < n->height; i++) {
+        n->link[i].next = update[i]->link[i].next;
+        n->link[i].prev = update[i];
+        if (n->link[i].next)
+            n->link[i].next->link[i].prev = n;
+        update[i]->link[i].next = n;
+    }
+}
+
+static void node_unlink (struct skiplist *sl, struct node *n)
+{
+    int i;
+
+    if (sl->cursor == n)
+        sl->cursor = n->link[0].prev;
+    for (i = 0; i < n->height; i++) {
+        n->link[i].prev->link[i].next = n->link[i].next;
+        if (n->link[i].next)
+            n->link[i].next->link[i].prev = n->link[i].prev;
+    }
+    while (sl->level > 1 && !sl->head->link[sl->level - 1].next)
+        sl->level--;
+}
+
+void skiplist_destroy (struct skiplist *sl)
+{
+    if (sl) {
+        int saved_errno = errno;
+        struct node *n = sl->head->link[0].next;
+        while (n) {
+            struct node *next = n->link[0].next;
+            if (sl->destructor)
+                sl->destructor (&n->item);
+            free (n);
+            n = next;
+        }
+        free (sl->head);
+        free (sl);
+        errno = saved_errno;
+    }
+}
+
+struct skiplist *skiplist_create (skiplist_compare_f cmp)
+{
+    struct skiplist *sl;
+
+    if (!cmp) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(sl = calloc (1, sizeof (*sl)))) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    if (!(sl->head = node_create (NULL, MAX_LEVEL))) {
+        free (sl);
+        return NULL;
+    }
+    sl->cmp = cmp;
+    sl->level = 1;
+    sl->seed = (uintptr_t)sl | 1;
+    return sl;
+}
+
+void skiplist_set_destructor (struct skiplist *sl, skiplist_destructor_f fn)
+{
+    if (sl)
+        sl->destructor = fn;
+}
+
+size_t skiplist_size (struct skiplist *sl)
+{
+    return sl ? sl->size : 0;
+}
+
+void *skiplist_insert (struct skiplist *sl, void *item)
+{
+    struct node *n;
+
+    if (!sl) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(n = node_create (item, random_height (sl))))
+        return NULL;
+    node_link (sl, n);
+    sl->size++;
+    return n;
+}
+
+void skiplist_delete (struct skiplist *sl, void *handle)
+{
+    struct node *n = handle;
+
+    if (sl && n) {
+        node_unlink (sl, n);
+        sl->size--;
+        if (sl->destructor)
+            sl->destructor (&n->item);
+        free (n);
+    }
+}
+
+void skiplist_reorder (struct skiplist *sl, void *handle)
+{
+    struct node *n = handle;
+
+    if (sl && n) {
+        node_unlink (sl, n);
+        node_link (sl, n);
+    }
+}
+
+void *skiplist_handle_item (void *handle)
+{
+    struct node *n = handle;
+
+    return n ? n->item : NULL;
+}
+
+void *skiplist_first (struct skiplist *sl)
+{
+    if (!sl)
+        return NULL;
+    sl->cursor = sl->head->link[0].next;
+    return sl->cursor ? sl->cursor->item : NULL;
+}
+
+void *skiplist_next (struct skiplist *sl)
+{
+    if (!sl || !sl->cursor)
+        return NULL;
+    sl->cursor = sl->cursor->link[0].next;
+    return sl->cursor ? sl->cursor->item : NULL;
+}
+
+void *skiplist_last (struct skiplist *sl)
+{
+    struct node *x;
+    int i;
+
+    if (!sl)
+        return NULL;
+    x = sl->head;
+    for (i = sl->level - 1; i >= 0; i--) {
+        while (x->link[i].next)
+            x = x->link[i].next;
+    }
+    sl->cursor = x != sl->head ? x : NULL;
+    return sl->cursor ? sl->cursor->item : NULL;
+}
+
+void *skiplist_prev (struct skiplist *sl)
+{
+    if (!sl || !sl->cursor)
+        return NULL;
+    sl->cursor = sl->cursor->link[0].prev;
+    if (sl->cursor == sl->head)
+        sl->cursor = NULL;
+    return sl->cursor ? sl->cursor->item : NULL;
+}
+
+void *skiplist_seek (struct skiplist *sl, const void *key)
+{
+    struct node *x;
+    int i;
+
+    if (!sl)
+        return NULL;
+    x = sl->head;
+    for (i = sl->level - 1; i >= 0; i--) {
+        while (x->link[i].next && sl->cmp (x->link[i].next->item, key) <= 0)
+            x = x->link[i].next;
+    }
+    sl->cursor = x->link[0].next;
+    return sl->cursor ? sl->cursor->item : NULL;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
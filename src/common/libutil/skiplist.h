@@ -0,0 +1,83 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/*
+ *  skiplist - sorted container with O(log n) insert, delete, and reorder
+ *
+ *  Items are kept in comparator order, with items that compare equal
+ *  kept in insertion order.  Like zlistx, insert returns a handle that
+ *  may be used to delete or reposition the item without searching.
+ */
+
+#ifndef _UTIL_SKIPLIST_H
+#define _UTIL_SKIPLIST_H
+
+#include <stddef.h>
+
+struct skiplist;
+
+/* Same signatures as zlistx_comparator_fn and zlistx_destructor_fn.
+ */
+typedef int (*skiplist_compare_f)(const void *item1, const void *item2);
+typedef void (*skiplist_destructor_f)(void **item);
+
+struct skiplist *skiplist_create (skiplist_compare_f cmp);
+
+/* Destroy skiplist, calling destructor (if set) on remaining items.
+ */
+void skiplist_destroy (struct skiplist *sl);
+
+/* Set a function called on items when deleted or when skiplist is destroyed.
+ */
+void skiplist_set_destructor (struct skiplist *sl, skiplist_destructor_f fn);
+
+size_t skiplist_size (struct skiplist *sl);
+
+/* Insert 'item' in sorted position, after any items that compare equal.
+ * Returns a handle for the item, or NULL on failure with errno set.
+ */
+void *skiplist_insert (struct skiplist *sl, void *item);
+
+/* Remove the item referenced by 'handle', calling destructor if set.
+ * Handle is invalid after this call.
+ */
+void skiplist_delete (struct skiplist *sl, void *handle);
+
+/* Move the item referenced by 'handle' to its sorted position, after its
+ * sort key has changed.  Handle remains valid.
+ */
+void skiplist_reorder (struct skiplist *sl, void *handle);
+
+/* Return the item referenced by 'handle'.
+ */
+void *skiplist_handle_item (void *handle);
+
+/* Iterate items in sorted order.  Return NULL at end of list.
+ * It is safe to delete the current item while iterating.
+ */
+void *skiplist_first (struct skiplist *sl);
+void *skiplist_next (struct skiplist *sl);
+
+/* Iterate items in reverse order.  skiplist_last() is O(log n).
+ */
+void *skiplist_last (struct skiplist *sl);
+void *skiplist_prev (struct skiplist *sl);
+
+/* Position the iterator at the first item that sorts after 'key', and
+ * return it, or NULL if there is none.  'key' need not be in the list.
+ * Continue with skiplist_next().  O(log n).
+ */
+void *skiplist_seek (struct skiplist *sl, const void *key);
+
+#endif /* !_UTIL_SKIPLIST_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -17,6 +17,9 @@
 #include <stdio.h>
 #include <syslog.h>
 #include <stdarg.h>
+#include <stdbool.h>
+#include <ctype.h>
+#include <limits.h>
 
 #include "stdlog.h"
 
@@ -221,6 +224,62 @@ void stdlog_init (struct stdlog_header *hdr)
     hdr->msgid = STDLOG_NILVALUE;
 }
 
+#define REPEAT_PREFIX "[flux@0 count=\""
+#define REPEAT_RANKS "\" ranks=\""
+#define REPEAT_SUFFIX "\"]"
+
+int stdlog_repeat_encode (char *buf, int len, int count, const char *ranks)
+{
+    if (count < 1 || !ranks || strchr (ranks, '"')) {
+        errno = EINVAL;
+        return -1;
+    }
+    return snprintf (buf, len, REPEAT_PREFIX "%d" REPEAT_RANKS "%s"
+                     REPEAT_SUFFIX, count, ranks);
+}
+
+static bool skip_prefix (const char **p, const char *end, const char *prefix)
+{
+    int n = strlen (prefix);
+
+    if (end - *p < n || strncmp (*p, prefix, n) != 0)
+        return false;
+    *p += n;
+    return true;
+}
+
+int stdlog_repeat_decode (const char *sd, int sdlen, int *count,
+                          const char **ranks, int *rankslen)
+{
+    const char *p = sd;
+    const char *end = sd + sdlen;
+    const char *r;
+    int i = 0;
+
+    if (!sd || !skip_prefix (&p, end, REPEAT_PREFIX))
+        return -1;
+    if (p == end || !isdigit (*p))
+        return -1;
+    while (p < end && isdigit (*p)) {
+        if (i > (INT_MAX - 9) / 10)
+            return -1;
+        i = i * 10 + (*p++ - '0');
+    }
+    if (i < 1 || !skip_prefix (&p, end, REPEAT_RANKS))
+        return -1;
+    r = p;
+    while (p < end && *p != '"')
+        p++;
+    if (p == r || !skip_prefix (&p, end, REPEAT_SUFFIX) || p != end)
+        return -1;
+    if (count)
+        *count = i;
+    if (ranks)
+        *ranks = r;
+    if (rankslen)
+        *rankslen = p - r - strlen (REPEAT_SUFFIX);
+    return 0;
+}
 
 struct matchtab {
     char *s;
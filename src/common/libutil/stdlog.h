@@ -65,6 +65,17 @@ char *stdlog_split_message (const char *buf, int *len, const char *sep);
 
 void stdlog_init (struct stdlog_header *hdr);
 
+/* Structured data for a message that stands for 'count' identical
+ * messages logged by 'ranks' (an idset string), e.g.
+ *   [flux@0 count="42" ranks="1-7,9"]
+ * stdlog_repeat_encode() returns the encoded length as snprintf() does,
+ * or -1 on error.  stdlog_repeat_decode() sets 'ranks' to point into 'sd'
+ * and returns 0, or -1 if 'sd' is not in this form.
+ */
+int stdlog_repeat_encode (char *buf, int len, int count, const char *ranks);
+int stdlog_repeat_decode (const char *sd, int sdlen, int *count,
+                          const char **ranks, int *rankslen);
+
 
 const char *stdlog_severity_to_string (int level);
 int stdlog_string_to_severity (const char *s);
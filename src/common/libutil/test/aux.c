@@ -10,6 +10,7 @@
 
 #include <string.h>
 #include <errno.h>
+#include <stdio.h>
 
 #include "src/common/libtap/tap.h"
 #include "src/common/libutil/aux.h"
@@ -176,6 +177,69 @@ void simple_test (void)
         "aux_destroy aux=NULL doesn't crash");
 }
 
+void interned_test (void)
+{
+    struct aux_item *aux = NULL;
+    const char *foo, *bar;
+    char buf[16];
+
+    foo = aux_key ("foo");
+    ok (foo != NULL && !strcmp (foo, "foo"),
+        "aux_key foo works");
+    snprintf (buf, sizeof (buf), "%s", "foo");
+    ok (aux_key (buf) == foo,
+        "aux_key returns the same pointer for an equal string");
+    bar = aux_key ("bar");
+    ok (bar != NULL && bar != foo,
+        "aux_key bar returns a different pointer");
+
+    ok (aux_set_key (&aux, foo, "1", NULL) == 0,
+        "aux_set_key foo=1 works");
+    ok (aux_set (&aux, "bar", "2", NULL) == 0,
+        "aux_set bar=2 works");
+    ok (aux_set (&aux, "baz", "3", NULL) == 0,
+        "aux_set baz=3 works");
+
+    ok (aux_get_key (aux, foo) && !strcmp (aux_get_key (aux, foo), "1"),
+        "aux_get_key foo works");
+    ok (aux_get (aux, "foo") && !strcmp (aux_get (aux, "foo"), "1"),
+        "aux_get foo finds value set with interned key");
+    ok (aux_get_key (aux, bar) && !strcmp (aux_get_key (aux, bar), "2"),
+        "aux_get_key bar finds value set with string key");
+    errno = 0;
+    ok (aux_get_key (aux, aux_key ("nokey")) == NULL && errno == ENOENT,
+        "aux_get_key of unknown interned key fails with ENOENT");
+
+    ok (aux_set_key (&aux, bar, "4", NULL) == 0
+        && aux_get (aux, "bar") && !strcmp (aux_get (aux, "bar"), "4"),
+        "aux_set_key bar=4 replaces value set with string key");
+    ok (aux_set (&aux, "foo", "5", NULL) == 0
+        && aux_get_key (aux, foo) && !strcmp (aux_get_key (aux, foo), "5"),
+        "aux_set foo=5 replaces value set with interned key");
+    ok (aux_set_key (&aux, foo, NULL, NULL) == 0,
+        "aux_set_key foo=NULL works");
+    errno = 0;
+    ok (aux_get (aux, "foo") == NULL && errno == ENOENT,
+        "aux_get foo fails with ENOENT");
+    ok (aux_get (aux, "baz") && !strcmp (aux_get (aux, "baz"), "3"),
+        "baz is undisturbed");
+
+    errno = 0;
+    ok (aux_key (NULL) == NULL && errno == EINVAL,
+        "aux_key name=NULL fails with EINVAL");
+    errno = 0;
+    ok (aux_get_key (aux, NULL) == NULL && errno == EINVAL,
+        "aux_get_key key=NULL fails with EINVAL");
+    errno = 0;
+    ok (aux_set_key (&aux, NULL, "x", NULL) < 0 && errno == EINVAL,
+        "aux_set_key key=NULL fails with EINVAL");
+    errno = 0;
+    ok (aux_set_key (NULL, foo, "x", NULL) < 0 && errno == EINVAL,
+        "aux_set_key aux=NULL fails with EINVAL");
+
+    aux_destroy (&aux);
+}
+
 int main (int argc, char *argv[])
 {
     plan (NO_PLAN);
@@ -183,6 +247,7 @@ int main (int argc, char *argv[])
     simple_test ();
     aux_destroy_no_get_self ();
     aux_destroy_set_ok ();
+    interned_test ();
 
     done_testing ();
 
@@ -0,0 +1,125 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/common/libutil/blake3.h"
+
+/* From the official test_vectors.json, where input is the byte
+ * sequence 0, 1, ..., 250, 0, 1, ... of the given length.
+ */
+struct vector {
+    size_t len;
+    const char *hash;
+};
+
+static struct vector vectors[] = {
+    { 0, "af1349b9f5f9a1a6a0404dea36dcc9499bcb25c9adc112b7cc9a93cae41f3262" },
+    { 1, "2d3adedff11b61f14c886e35afa036736dcd87a74d27b5c1510225d0f592e213" },
+    { 1024,
+      "42214739f095a406f3fc83deb889744ac00df831c10daa55189b5d121c855af7" },
+    { 1025,
+      "d00278ae47eb27b34faecf67b4fe263f82d5412916c1ffd97c8cb7fb814b8444" },
+    { 102400,
+      "bc3e3d41a1146b069abffad3c0d44860cf664390afce4d9661f7902e7943e085" },
+};
+
+static void tohex (const uint8_t *digest, char *s)
+{
+    for (int i = 0; i < BLAKE3_DIGEST_SIZE; i++)
+        sprintf (s + 2 * i, "%02x", digest[i]);
+}
+
+static uint8_t *pattern (size_t len)
+{
+    uint8_t *buf;
+
+    if (!(buf = malloc (len ? len : 1)))
+        BAIL_OUT ("out of memory");
+    for (size_t i = 0; i < len; i++)
+        buf[i] = i % 251;
+    return buf;
+}
+
+void test_vectors (void)
+{
+    for (int i = 0; i < sizeof (vectors) / sizeof (vectors[0]); i++) {
+        uint8_t *buf = pattern (vectors[i].len);
+        uint8_t digest[BLAKE3_DIGEST_SIZE];
+        char s[BLAKE3_DIGEST_SIZE * 2 + 1];
+
+        blake3_hash (buf, vectors[i].len, digest);
+        tohex (digest, s);
+        ok (strcmp (s, vectors[i].hash) == 0,
+            "blake3 of %zu bytes is correct", vectors[i].len);
+        free (buf);
+    }
+}
+
+void test_abc (void)
+{
+    uint8_t digest[BLAKE3_DIGEST_SIZE];
+    char s[BLAKE3_DIGEST_SIZE * 2 + 1];
+
+    blake3_hash ("abc", 3, digest);
+    tohex (digest, s);
+    is (s, "6437b3ac38465133ffb63b75273a8db548c558465d79db03fd359c6cd5bd9d85",
+        "blake3 of \"abc\" is correct");
+}
+
+/* A multi-threaded hash must match the single-threaded one, including
+ * for lengths that leave an uneven tree.
+ */
+void test_threads (void)
+{
+    size_t lens[] = { 4 * 1024 * 1024, 5 * 1024 * 1024 + 12345 };
+
+    for (int i = 0; i < sizeof (lens) / sizeof (lens[0]); i++) {
+        uint8_t *buf = pattern (lens[i]);
+        uint8_t d1[BLAKE3_DIGEST_SIZE];
+        uint8_t d[BLAKE3_DIGEST_SIZE];
+        int errors = 0;
+
+        blake3_hash_threads (buf, lens[i], d1, 1);
+        for (int n = 2; n <= 8; n++) {
+            blake3_hash_threads (buf, lens[i], d, n);
+            if (memcmp (d, d1, sizeof (d)) != 0) {
+                diag ("%d threads differs", n);
+                errors++;
+            }
+        }
+        blake3_hash (buf, lens[i], d);
+        ok (errors == 0 && memcmp (d, d1, sizeof (d)) == 0,
+            "%zu bytes hash the same with 1-8 threads", lens[i]);
+        free (buf);
+    }
+}
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    test_vectors ();
+    test_abc ();
+    test_threads ();
+
+    done_testing ();
+    return (0);
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
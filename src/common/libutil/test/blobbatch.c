@@ -0,0 +1,145 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/common/libutil/blobbatch.h"
+
+void test_basic (void)
+{
+    struct blobbatch *bb;
+    struct blobbatch *bb2;
+    const void *buf;
+    int len;
+    const void *data;
+    int size;
+    const char *s;
+
+    ok ((bb = blobbatch_create ()) != NULL,
+        "blobbatch_create works");
+    ok (blobbatch_count (bb) == 0,
+        "blobbatch_count is 0");
+    blobbatch_encode (bb, &buf, &len);
+    ok (len == 0,
+        "empty batch encodes to empty payload");
+
+    ok (blobbatch_append (bb, "abc", 4) == 0,
+        "blobbatch_append works");
+    ok (blobbatch_append (bb, NULL, 0) == 0,
+        "blobbatch_append works with empty item");
+    ok (blobbatch_append_error (bb, ENOENT) == 0,
+        "blobbatch_append_error works");
+    ok (blobbatch_append (bb, "xyz", 3) == 0,
+        "blobbatch_append works");
+    ok (blobbatch_count (bb) == 4,
+        "blobbatch_count is 4");
+    ok (blobbatch_get (bb, 0, &data, &size) == 0
+        && size == 4 && !memcmp (data, "abc", 4),
+        "blobbatch_get works on created batch");
+
+    blobbatch_encode (bb, &buf, &len);
+    ok (len == 4 * 4 + 4 + 0 + 0 + 3,
+        "blobbatch_encode returns expected length");
+    ok ((bb2 = blobbatch_decode (buf, len)) != NULL,
+        "blobbatch_decode works");
+    ok (blobbatch_count (bb2) == 4,
+        "decoded batch has 4 items");
+    ok ((s = blobbatch_get_string (bb2, 0)) != NULL && !strcmp (s, "abc"),
+        "blobbatch_get_string returns item 0");
+    ok (blobbatch_get (bb2, 1, &data, &size) == 0 && size == 0,
+        "blobbatch_get returns empty item 1");
+    errno = 0;
+    ok (blobbatch_get (bb2, 2, &data, &size) < 0 && errno == ENOENT,
+        "blobbatch_get fails on error item with its errno");
+    ok (blobbatch_get (bb2, 3, &data, &size) == 0
+        && size == 3 && !memcmp (data, "xyz", 3),
+        "blobbatch_get returns item 3");
+    errno = 0;
+    ok (blobbatch_get_string (bb2, 3) == NULL && errno == EPROTO,
+        "blobbatch_get_string fails with EPROTO on unterminated item");
+    errno = 0;
+    ok (blobbatch_get (bb2, 4, NULL, NULL) < 0 && errno == EINVAL,
+        "blobbatch_get fails with EINVAL on out of range index");
+    errno = 0;
+    ok (blobbatch_append (bb2, "a", 1) < 0 && errno == EINVAL,
+        "blobbatch_append fails with EINVAL on decoded batch");
+
+    errno = 0;
+    ok (blobbatch_decode (buf, len - 1) == NULL && errno == EPROTO,
+        "blobbatch_decode fails with EPROTO on truncated item");
+    errno = 0;
+    ok (blobbatch_decode (buf, 2) == NULL && errno == EPROTO,
+        "blobbatch_decode fails with EPROTO on truncated header");
+
+    blobbatch_destroy (bb2);
+    blobbatch_destroy (bb);
+}
+
+void test_large (void)
+{
+    struct blobbatch *bb;
+    struct blobbatch *bb2;
+    const void *buf;
+    int len;
+    int errors = 0;
+    char data[100];
+
+    if (!(bb = blobbatch_create ()))
+        BAIL_OUT ("blobbatch_create failed");
+    for (int i = 0; i < 1000; i++) {
+        memset (data, i & 0xff, sizeof (data));
+        if (blobbatch_append (bb, data, i % sizeof (data)) < 0)
+            errors++;
+    }
+    ok (errors == 0,
+        "appended 1000 items");
+    blobbatch_encode (bb, &buf, &len);
+    ok ((bb2 = blobbatch_decode (buf, len)) != NULL
+        && blobbatch_count (bb2) == 1000,
+        "decoded 1000 items");
+    for (int i = 0; i < 1000; i++) {
+        const void *item;
+        int size;
+
+        memset (data, i & 0xff, sizeof (data));
+        if (blobbatch_get (bb2, i, &item, &size) < 0
+            || size != i % sizeof (data)
+            || memcmp (item, data, size) != 0)
+            errors++;
+    }
+    ok (errors == 0,
+        "all items match");
+    blobbatch_destroy (bb2);
+    blobbatch_destroy (bb);
+}
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    test_basic ();
+    test_large ();
+
+    lives_ok ({blobbatch_destroy (NULL);},
+        "blobbatch_destroy bb=NULL doesnt crash");
+
+    done_testing ();
+    return (0);
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
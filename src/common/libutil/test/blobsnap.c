@@ -0,0 +1,185 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/common/libutil/blobsnap.h"
+
+static char dir[PATH_MAX];
+
+static void make_path (char *path, size_t size, const char *name)
+{
+    if (snprintf (path, size, "%s/%s", dir, name) >= size)
+        BAIL_OUT ("snprintf failed creating path");
+}
+
+void test_empty (void)
+{
+    char path[PATH_MAX];
+    struct blobsnap_writer *w;
+    struct blobsnap *snap;
+
+    make_path (path, sizeof (path), "empty");
+    ok ((w = blobsnap_writer_create (path, "sha1-1234")) != NULL,
+        "blobsnap_writer_create works");
+    ok (blobsnap_writer_commit (w) == 0,
+        "blobsnap_writer_commit works with no blobs");
+    blobsnap_writer_destroy (w);
+
+    ok ((snap = blobsnap_open (path)) != NULL,
+        "blobsnap_open works");
+    ok (blobsnap_count (snap) == 0,
+        "blobsnap_count is 0");
+    ok (blobsnap_root (snap) && !strcmp (blobsnap_root (snap), "sha1-1234"),
+        "blobsnap_root returns root");
+    errno = 0;
+    ok (blobsnap_get (snap, "sha1-1234", NULL, NULL) < 0 && errno == ENOENT,
+        "blobsnap_get fails with ENOENT");
+    blobsnap_close (snap);
+    (void)unlink (path);
+}
+
+void test_many (int count)
+{
+    char path[PATH_MAX];
+    char blobref[64];
+    char blob[64];
+    struct blobsnap_writer *w;
+    struct blobsnap *snap;
+    const void *data;
+    int len;
+    int errors;
+    int i;
+
+    make_path (path, sizeof (path), "many");
+    if (!(w = blobsnap_writer_create (path, "sha1-root")))
+        BAIL_OUT ("blobsnap_writer_create failed");
+    errors = 0;
+    for (i = 0; i < count; i++) {
+        snprintf (blobref, sizeof (blobref), "sha1-%08d", i);
+        snprintf (blob, sizeof (blob), "blob %d", i);
+        if (blobsnap_writer_append (w, blobref, blob, strlen (blob)) < 0)
+            errors++;
+    }
+    ok (errors == 0,
+        "blobsnap_writer_append added %d blobs", count);
+    ok (access (path, F_OK) < 0,
+        "snapshot is not in place before commit");
+    ok (blobsnap_writer_commit (w) == 0,
+        "blobsnap_writer_commit works");
+    blobsnap_writer_destroy (w);
+
+    ok ((snap = blobsnap_open (path)) != NULL,
+        "blobsnap_open works");
+    ok (blobsnap_count (snap) == count,
+        "blobsnap_count is %d", count);
+    errors = 0;
+    for (i = 0; i < count; i++) {
+        snprintf (blobref, sizeof (blobref), "sha1-%08d", i);
+        snprintf (blob, sizeof (blob), "blob %d", i);
+        if (blobsnap_get (snap, blobref, &data, &len) < 0
+            || len != strlen (blob)
+            || memcmp (data, blob, len) != 0)
+            errors++;
+    }
+    ok (errors == 0,
+        "blobsnap_get finds every blob");
+    errors = 0;
+    for (i = count; i < count * 2; i++) {
+        snprintf (blobref, sizeof (blobref), "sha1-%08d", i);
+        if (blobsnap_get (snap, blobref, &data, &len) == 0 || errno != ENOENT)
+            errors++;
+    }
+    ok (errors == 0,
+        "blobsnap_get fails with ENOENT for blobs not added");
+    blobsnap_close (snap);
+    (void)unlink (path);
+}
+
+void test_badargs (void)
+{
+    char path[PATH_MAX];
+    struct blobsnap_writer *w;
+    int fd;
+
+    errno = 0;
+    ok (blobsnap_writer_create (NULL, "x") == NULL && errno == EINVAL,
+        "blobsnap_writer_create path=NULL fails with EINVAL");
+    errno = 0;
+    ok (blobsnap_open (NULL) == NULL && errno == EINVAL,
+        "blobsnap_open path=NULL fails with EINVAL");
+    errno = 0;
+    ok (blobsnap_get (NULL, "x", NULL, NULL) < 0 && errno == EINVAL,
+        "blobsnap_get snap=NULL fails with EINVAL");
+
+    make_path (path, sizeof (path), "dup");
+    if (!(w = blobsnap_writer_create (path, "sha1-root")))
+        BAIL_OUT ("blobsnap_writer_create failed");
+    errno = 0;
+    ok (blobsnap_writer_append (w, "sha1-1", NULL, 1) < 0 && errno == EINVAL,
+        "blobsnap_writer_append data=NULL len=1 fails with EINVAL");
+    blobsnap_writer_destroy (w);
+    ok (access (path, F_OK) < 0,
+        "destroying an uncommitted writer leaves no snapshot");
+
+    make_path (path, sizeof (path), "bad");
+    if ((fd = open (path, O_WRONLY | O_CREAT | O_TRUNC, 0600)) < 0
+        || write (fd, "FLXSNAPXgarbagegarbagegarbagegarbage", 36) != 36)
+        BAIL_OUT ("could not create bad snapshot");
+    close (fd);
+    errno = 0;
+    ok (blobsnap_open (path) == NULL && errno == EPROTO,
+        "blobsnap_open fails with EPROTO on bad magic");
+    (void)unlink (path);
+
+    lives_ok ({blobsnap_close (NULL);},
+        "blobsnap_close snap=NULL doesnt crash");
+    lives_ok ({blobsnap_writer_destroy (NULL);},
+        "blobsnap_writer_destroy w=NULL doesnt crash");
+}
+
+int main (int argc, char *argv[])
+{
+    const char *tmp = getenv ("TMPDIR");
+
+    plan (NO_PLAN);
+
+    if (snprintf (dir, sizeof (dir), "%s/blobsnap.XXXXXX",
+                  tmp ? tmp : "/tmp") >= sizeof (dir))
+        BAIL_OUT ("snprintf failed creating tmp directory");
+    if (!mkdtemp (dir))
+        BAIL_OUT ("could not create tmp directory");
+
+    test_empty ();
+    test_many (1);
+    test_many (10000);
+    test_badargs ();
+
+    if (rmdir (dir) < 0)
+        diag ("rmdir %s: %s", dir, strerror (errno));
+
+    done_testing ();
+    return (0);
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,116 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/common/libutil/bloom.h"
+
+static int key (char *buf, size_t size, int i)
+{
+    return snprintf (buf, size, "sha1-%040d", i);
+}
+
+void test_basic (void)
+{
+    struct bloom *b;
+    char buf[64];
+    int len;
+
+    errno = 0;
+    ok (bloom_create (0, 7) == NULL && errno == EINVAL,
+        "bloom_create nbits=0 fails with EINVAL");
+    errno = 0;
+    ok (bloom_create (1024, 0) == NULL && errno == EINVAL,
+        "bloom_create nhash=0 fails with EINVAL");
+
+    ok ((b = bloom_create (10000, 7)) != NULL,
+        "bloom_create works");
+    ok (bloom_count (b) == 0,
+        "bloom_count is 0");
+    len = key (buf, sizeof (buf), 42);
+    ok (!bloom_check (b, buf, len),
+        "bloom_check on empty filter returns false");
+    bloom_add (b, buf, len);
+    ok (bloom_check (b, buf, len),
+        "bloom_check of added key returns true");
+    ok (bloom_count (b) == 1,
+        "bloom_count is 1");
+    bloom_add (b, "", 0);
+    ok (bloom_check (b, "", 0),
+        "empty key can be added");
+    bloom_clear (b);
+    ok (!bloom_check (b, buf, len) && bloom_count (b) == 0,
+        "bloom_clear removes all keys");
+    bloom_destroy (b);
+
+    lives_ok ({bloom_destroy (NULL);},
+        "bloom_destroy b=NULL doesnt crash");
+    lives_ok ({bloom_add (NULL, "a", 1);},
+        "bloom_add b=NULL doesnt crash");
+    ok (!bloom_check (NULL, "a", 1),
+        "bloom_check b=NULL returns false");
+}
+
+/* Fill a filter at 10 bits per key and check that there are no false
+ * negatives and that the false positive rate is near the expected 1%.
+ */
+void test_rate (void)
+{
+    struct bloom *b;
+    char buf[64];
+    int n = 10000;
+    int missing = 0;
+    int fp = 0;
+
+    if (!(b = bloom_create (n * 10, 7)))
+        BAIL_OUT ("bloom_create failed");
+    for (int i = 0; i < n; i++) {
+        int len = key (buf, sizeof (buf), i);
+        bloom_add (b, buf, len);
+    }
+    for (int i = 0; i < n; i++) {
+        int len = key (buf, sizeof (buf), i);
+        if (!bloom_check (b, buf, len))
+            missing++;
+    }
+    ok (missing == 0,
+        "all %d added keys are found", n);
+    for (int i = n; i < 2 * n; i++) {
+        int len = key (buf, sizeof (buf), i);
+        if (bloom_check (b, buf, len))
+            fp++;
+    }
+    diag ("%d/%d false positives", fp, n);
+    ok (fp < n / 50,
+        "false positive rate is under 2%%");
+    bloom_destroy (b);
+}
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    test_basic ();
+    test_rate ();
+
+    done_testing ();
+    return (0);
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
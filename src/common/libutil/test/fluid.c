@@ -322,6 +322,74 @@ void test_basic (void)
         "fluid_decode type=MNEMONIC fails on unknown words xx-xx-xx--xx-xx-xx");
 }
 
+void test_range (void)
+{
+    struct fluid_generator gen;
+    fluid_t id, id2, lastid;
+    int i;
+    int errors;
+
+    ok (fluid_init (&gen, 1, 0) == 0,
+        "fluid_init id=1 timestamp=0 works");
+    ok (fluid_range_max (&gen) == 1023,
+        "fluid_range_max is 1023 with default bits");
+    ok (fluid_generate_range (&gen, 0, &id) < 0,
+        "fluid_generate_range count=0 fails");
+    ok (fluid_generate_range (&gen, 1024, &id) < 0,
+        "fluid_generate_range count=1024 fails");
+    ok (fluid_generate_range (&gen, 100, &id) == 0
+        && ((id >> 10) & 0x3fff) == 1,
+        "fluid_generate_range count=100 works");
+    ok (fluid_generate (&gen, &id2) == 0 && id2 > id + 99,
+        "fluid_generate after range does not overlap it");
+
+    /* Ranges never overlap and always increase
+     */
+    errors = 0;
+    lastid = id2;
+    for (i = 0; i < 4096; i++) {
+        if (fluid_generate_range (&gen, 1000, &id) < 0)
+            BAIL_OUT ("fluid_generate_range unexpectedly failed");
+        if (id <= lastid)
+            errors++;
+        lastid = id + 999;
+    }
+    ok (errors == 0,
+        "fluid_generate_range count=1000 worked 4K times without overlap");
+}
+
+void test_bits (void)
+{
+    struct fluid_generator gen;
+    const uint64_t ts = 1000;
+    fluid_t id, id2;
+
+    ok (fluid_init_bits (&gen, 0, -1, 0) < 0,
+        "fluid_init_bits id_bits=-1 fails");
+    ok (fluid_init_bits (&gen, 0, FLUID_ID_BITS_DEFAULT + 1, 0) < 0,
+        "fluid_init_bits id_bits=FLUID_ID_BITS_DEFAULT+1 fails");
+    ok (fluid_init_bits (&gen, 4, 2, 0) < 0,
+        "fluid_init_bits fails with id that doesn't fit in id_bits");
+
+    ok (fluid_init_bits (&gen, 0, 0, ts) == 0,
+        "fluid_init_bits id_bits=0 works");
+    ok (fluid_range_max (&gen) == (1<<24) - 1,
+        "fluid_range_max is 2^24-1 with id_bits=0");
+    ok (fluid_generate_range (&gen, 100000, &id) == 0
+        && fluid_generate (&gen, &id2) == 0
+        && id2 >= id + 100000,
+        "fluid_generate_range count=100000 works with id_bits=0");
+    ok (fluid_get_timestamp (id) >= ts,
+        "fluid_get_timestamp works with id_bits=0");
+
+    ok (fluid_init_bits (&gen, 3, 2, ts) == 0,
+        "fluid_init_bits id=3 id_bits=2 works");
+    ok (fluid_generate (&gen, &id) == 0
+        && ((id >> 22) & 3) == 3
+        && fluid_get_timestamp (id) >= ts,
+        "fluid_generate places id in the configured bits");
+}
+
 int main (int argc, char *argv[])
 {
     plan (NO_PLAN);
@@ -332,6 +400,8 @@ int main (int argc, char *argv[])
     test_basic ();
     test_f58 ();
     test_fluid_parse ();
+    test_range ();
+    test_bits ();
 
     done_testing ();
     return 0;
@@ -0,0 +1,81 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#include <string.h>
+#include <jansson.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/common/libutil/loghist.h"
+
+int main (int argc, char **argv)
+{
+    struct loghist lh;
+    json_t *o;
+    json_t *hist;
+    int count;
+    double total, max;
+
+    plan (NO_PLAN);
+
+    memset (&lh, 0, sizeof (lh));
+    o = loghist_encode (&lh);
+    ok (o != NULL
+        && json_unpack (o, "{s:i s:o}", "count", &count, "hist", &hist) == 0
+        && count == 0
+        && json_array_size (hist) == 0,
+        "loghist_encode of an empty histogram has no buckets");
+    json_decref (o);
+
+    loghist_add (&lh, 0.);
+    loghist_add (&lh, -1.);
+    ok (lh.count == 2 && lh.hist[0] == 2 && lh.total == 0.,
+        "zero and negative durations count in the first bucket");
+    loghist_add (&lh, 0.0000015);
+    ok (lh.hist[1] == 1,
+        "1.5us counts in bucket 1");
+    loghist_add (&lh, 0.003);
+    ok (lh.hist[12] == 1,
+        "3ms counts in bucket 12");
+    loghist_add (&lh, 1E9);
+    ok (lh.hist[LOGHIST_BUCKETS - 1] == 1,
+        "a very long duration counts in the last bucket");
+    ok (lh.max == 1E9,
+        "max is the longest duration");
+
+    o = loghist_encode (&lh);
+    ok (o != NULL
+        && json_unpack (o, "{s:i s:F s:F s:o}",
+                        "count", &count,
+                        "total", &total,
+                        "max", &max,
+                        "hist", &hist) == 0
+        && count == 5
+        && max == 1E9
+        && json_array_size (hist) == LOGHIST_BUCKETS
+        && json_integer_value (json_array_get (hist, 12)) == 1,
+        "loghist_encode works");
+    json_decref (o);
+
+    loghist_clear (&lh);
+    loghist_add (&lh, 0.003);
+    o = loghist_encode (&lh);
+    ok (o != NULL
+        && json_unpack (o, "{s:o}", "hist", &hist) == 0
+        && json_array_size (hist) == 13,
+        "loghist_encode trims trailing empty buckets");
+    json_decref (o);
+
+    done_testing ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -59,6 +59,37 @@ void test_basic ()
     lru_cache_destroy (lru);
 }
 
+void test_purge_last ()
+{
+    lru_cache_t *lru;
+    int *ip;
+
+    lru = lru_cache_create (3);
+    lru_cache_set_free_f (lru, free);
+
+    errno = 0;
+    ok (lru_cache_purge_last (lru) < 0 && errno == ENOENT,
+        "lru_cache_purge_last on empty cache fails with ENOENT");
+
+    ip = xzmalloc (sizeof (*ip));
+    ok (lru_cache_put (lru, "a", ip) == 0, "lru_cache_put (a)");
+    ip = xzmalloc (sizeof (*ip));
+    ok (lru_cache_put (lru, "b", ip) == 0, "lru_cache_put (b)");
+    ip = xzmalloc (sizeof (*ip));
+    ok (lru_cache_put (lru, "c", ip) == 0, "lru_cache_put (c)");
+    ok (lru_cache_get (lru, "a") != NULL, "move a to front of list");
+
+    ok (lru_cache_purge_last (lru) == 0, "lru_cache_purge_last ()");
+    ok (lru_cache_check (lru, "b") == false, "b was purged");
+    ok (lru_cache_size (lru) == 2, "lru_cache_size == 2");
+    ok (lru_cache_purge_last (lru) == 0, "lru_cache_purge_last ()");
+    ok (lru_cache_check (lru, "c") == false, "c was purged");
+    ok (lru_cache_check (lru, "a"), "a is still cached");
+    ok (lru_cache_selfcheck (lru) == 0, "lru_cache_selfcheck ()");
+
+    lru_cache_destroy (lru);
+}
+
 void fake_int_free (int *iptr)
 {
     /*  Note this has been "freed" by setting to -1 */
@@ -116,6 +147,7 @@ int main (int argc, char *argv[])
 {
     plan (NO_PLAN);
     test_basic ();
+    test_purge_last ();
     test_free_fn ();
     test_corruption ();
     done_testing ();
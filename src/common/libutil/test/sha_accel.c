@@ -0,0 +1,146 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <string.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/common/libutil/sha1.h"
+#include "src/common/libutil/sha256.h"
+#include "src/common/libutil/sha_accel.h"
+
+/* Portable block functions, not exported in the headers.
+ */
+void SHA1_Transform (uint32_t state[5], const uint8_t buffer[64]);
+void sha256_transform (SHA256_CTX *ctx, const BYTE data[]);
+
+#define NBLOCKS 64
+
+static void fill (uint8_t *buf, size_t len)
+{
+    uint32_t x = 12345;
+
+    for (size_t i = 0; i < len; i++) {
+        x = x * 1103515245 + 12345;
+        buf[i] = x >> 16;
+    }
+}
+
+void test_sha1 (void)
+{
+    uint8_t data[NBLOCKS * 64];
+    uint32_t init[5] = {
+        0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0,
+    };
+    uint32_t a[5];
+    uint32_t b[5];
+
+    if (!sha1_accel_available ()) {
+        skip (1, 2, "no SHA-1 instructions on this CPU");
+        end_skip;
+        return;
+    }
+    fill (data, sizeof (data));
+    memcpy (a, init, sizeof (init));
+    memcpy (b, init, sizeof (init));
+    for (int i = 0; i < NBLOCKS; i++)
+        SHA1_Transform (a, data + 64 * i);
+    ok (sha1_accel_blocks (b, data, NBLOCKS) == true,
+        "sha1_accel_blocks works");
+    ok (memcmp (a, b, sizeof (a)) == 0,
+        "sha1_accel_blocks agrees with the portable transform");
+}
+
+void test_sha256 (void)
+{
+    uint8_t data[NBLOCKS * 64];
+    SHA256_CTX ctx;
+    uint32_t b[8];
+
+    if (!sha256_accel_available ()) {
+        skip (1, 2, "no SHA-256 instructions on this CPU");
+        end_skip;
+        return;
+    }
+    fill (data, sizeof (data));
+    sha256_init (&ctx);
+    memcpy (b, ctx.state, sizeof (b));
+    for (int i = 0; i < NBLOCKS; i++)
+        sha256_transform (&ctx, data + 64 * i);
+    ok (sha256_accel_blocks (b, data, NBLOCKS) == true,
+        "sha256_accel_blocks works");
+    ok (memcmp (ctx.state, b, sizeof (b)) == 0,
+        "sha256_accel_blocks agrees with the portable transform");
+}
+
+/* Hash the same buffer with different update splits, so whole blocks
+ * take the accelerated path from both aligned and partial-block starts.
+ */
+void test_split_updates (void)
+{
+    static uint8_t data[10000];
+    uint8_t d1[SHA1_DIGEST_SIZE], d1x[SHA1_DIGEST_SIZE];
+    uint8_t d256[SHA256_BLOCK_SIZE], d256x[SHA256_BLOCK_SIZE];
+    int errors = 0;
+
+    fill (data, sizeof (data));
+    for (size_t split = 0; split < 200; split += 7) {
+        SHA1_CTX c1;
+        SHA256_CTX c256;
+
+        SHA1_Init (&c1);
+        for (size_t i = 0; i < sizeof (data); i++)
+            SHA1_Update (&c1, data + i, 1);
+        SHA1_Final (&c1, d1);
+        SHA1_Init (&c1);
+        SHA1_Update (&c1, data, split);
+        SHA1_Update (&c1, data + split, sizeof (data) - split);
+        SHA1_Final (&c1, d1x);
+
+        sha256_init (&c256);
+        for (size_t i = 0; i < sizeof (data); i++)
+            sha256_update (&c256, data + i, 1);
+        sha256_final (&c256, d256);
+        sha256_init (&c256);
+        sha256_update (&c256, data, split);
+        sha256_update (&c256, data + split, sizeof (data) - split);
+        sha256_final (&c256, d256x);
+
+        if (memcmp (d1, d1x, sizeof (d1)) != 0
+            || memcmp (d256, d256x, sizeof (d256)) != 0) {
+            diag ("split at %zu differs", split);
+            errors++;
+        }
+    }
+    ok (errors == 0,
+        "bulk updates agree with bytewise updates at all split points");
+}
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    diag ("sha1 accel %s, sha256 accel %s",
+          sha1_accel_available () ? "yes" : "no",
+          sha256_accel_available () ? "yes" : "no");
+    test_sha1 ();
+    test_sha256 ();
+    test_split_updates ();
+
+    done_testing ();
+    return (0);
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
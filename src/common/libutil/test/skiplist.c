@@ -0,0 +1,255 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <stdbool.h>
+#include <errno.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/common/libutil/skiplist.h"
+
+struct item {
+    int key;
+    int seq;
+    void *handle;
+};
+
+static int destroyed;
+
+static int item_cmp (const void *a, const void *b)
+{
+    const struct item *i1 = a;
+    const struct item *i2 = b;
+
+    return i1->key < i2->key ? -1 : i1->key > i2->key ? 1 : 0;
+}
+
+static void item_destructor (void **item)
+{
+    if (item && *item) {
+        destroyed++;
+        *item = NULL;
+    }
+}
+
+/* Return true if items are in key order, with equal keys in seq order.
+ */
+static bool check_order (struct skiplist *sl, size_t *countp)
+{
+    struct item *prev = NULL;
+    struct item *it;
+    size_t count = 0;
+
+    it = skiplist_first (sl);
+    while (it) {
+        if (prev && (prev->key > it->key
+                     || (prev->key == it->key && prev->seq > it->seq)))
+            return false;
+        count++;
+        prev = it;
+        it = skiplist_next (sl);
+    }
+    *countp = count;
+    return true;
+}
+
+void test_basic (void)
+{
+    struct skiplist *sl;
+    struct item items[5] = {
+        { .key = 3, .seq = 0 },
+        { .key = 1, .seq = 1 },
+        { .key = 3, .seq = 2 },
+        { .key = 2, .seq = 3 },
+        { .key = 0, .seq = 4 },
+    };
+    struct item *it;
+    size_t count;
+    int i;
+
+    ok ((sl = skiplist_create (item_cmp)) != NULL,
+        "skiplist_create works");
+    ok (skiplist_size (sl) == 0,
+        "skiplist_size is 0");
+    ok (skiplist_first (sl) == NULL && skiplist_last (sl) == NULL,
+        "skiplist_first/last return NULL on empty list");
+    for (i = 0; i < 5; i++) {
+        if (!(items[i].handle = skiplist_insert (sl, &items[i])))
+            BAIL_OUT ("skiplist_insert failed");
+    }
+    ok (skiplist_size (sl) == 5,
+        "skiplist_size is 5 after 5 inserts");
+    ok (skiplist_handle_item (items[2].handle) == &items[2],
+        "skiplist_handle_item returns item");
+    ok (check_order (sl, &count) && count == 5,
+        "items iterate in order, with equal keys in insertion order");
+    ok (skiplist_first (sl) == &items[4],
+        "skiplist_first returns lowest key");
+
+    items[4].key = 4;
+    skiplist_reorder (sl, items[4].handle);
+    ok (skiplist_first (sl) == &items[1],
+        "skiplist_reorder moved item from head");
+    ok (check_order (sl, &count) && count == 5,
+        "items are in order after reorder");
+
+    it = skiplist_first (sl);
+    skiplist_delete (sl, items[1].handle);
+    it = skiplist_next (sl);
+    ok (it == &items[3],
+        "skiplist_next after deleting current item continues with next");
+    ok (skiplist_size (sl) == 4,
+        "skiplist_size is 4 after delete");
+
+    skiplist_destroy (sl);
+}
+
+void test_seek (void)
+{
+    struct skiplist *sl;
+    struct item items[4] = {
+        { .key = 1 }, { .key = 3 }, { .key = 3 }, { .key = 5 },
+    };
+    struct item key;
+    int i;
+
+    if (!(sl = skiplist_create (item_cmp)))
+        BAIL_OUT ("skiplist_create failed");
+    ok (skiplist_seek (sl, &items[0]) == NULL,
+        "skiplist_seek on empty list returns NULL");
+    for (i = 0; i < 4; i++) {
+        if (!skiplist_insert (sl, &items[i]))
+            BAIL_OUT ("skiplist_insert failed");
+    }
+    key.key = 0;
+    ok (skiplist_seek (sl, &key) == &items[0],
+        "skiplist_seek before first item returns first item");
+    key.key = 1;
+    ok (skiplist_seek (sl, &key) == &items[1]
+        && skiplist_next (sl) == &items[2]
+        && skiplist_next (sl) == &items[3]
+        && skiplist_next (sl) == NULL,
+        "skiplist_seek to existing key returns next item, then iterates");
+    key.key = 4;
+    ok (skiplist_seek (sl, &key) == &items[3],
+        "skiplist_seek to absent key returns next larger item");
+    key.key = 3;
+    ok (skiplist_seek (sl, &key) == &items[3],
+        "skiplist_seek skips all items that compare equal to key");
+    key.key = 5;
+    ok (skiplist_seek (sl, &key) == NULL
+        && skiplist_next (sl) == NULL,
+        "skiplist_seek past last item returns NULL");
+    ok (skiplist_seek (NULL, &key) == NULL,
+        "skiplist_seek sl=NULL returns NULL");
+    ok (skiplist_last (sl) == &items[3]
+        && skiplist_prev (sl) == &items[2]
+        && skiplist_prev (sl) == &items[1]
+        && skiplist_prev (sl) == &items[0]
+        && skiplist_prev (sl) == NULL,
+        "skiplist_last and skiplist_prev iterate in reverse order");
+    skiplist_destroy (sl);
+}
+
+void test_many (int count)
+{
+    struct skiplist *sl;
+    struct item *items;
+    size_t n;
+    int i;
+    int errors;
+
+    if (!(items = calloc (count, sizeof (items[0]))))
+        BAIL_OUT ("out of memory");
+    if (!(sl = skiplist_create (item_cmp)))
+        BAIL_OUT ("skiplist_create failed");
+    skiplist_set_destructor (sl, item_destructor);
+    srand (42);
+    errors = 0;
+    for (i = 0; i < count; i++) {
+        items[i].key = rand () % 32;
+        items[i].seq = i;
+        if (!(items[i].handle = skiplist_insert (sl, &items[i])))
+            errors++;
+    }
+    ok (errors == 0 && skiplist_size (sl) == count,
+        "inserted %d items with random keys", count);
+    ok (check_order (sl, &n) && n == count,
+        "items iterate in order");
+
+    /* Change keys of every 3rd item.  Reordered items go after other
+     * items with the same key, so give them a new seq too.
+     */
+    for (i = 0; i < count; i += 3) {
+        items[i].key = rand () % 32;
+        items[i].seq = count + i;
+        skiplist_reorder (sl, items[i].handle);
+    }
+    ok (check_order (sl, &n) && n == count,
+        "items are in order after reordering 1/3 of them");
+
+    destroyed = 0;
+    for (i = 1; i < count; i += 2)
+        skiplist_delete (sl, items[i].handle);
+    ok (destroyed == count / 2,
+        "destructor was called for each deleted item");
+    ok (check_order (sl, &n) && n == count - count / 2
+        && skiplist_size (sl) == n,
+        "items are in order after deleting half of them");
+
+    destroyed = 0;
+    skiplist_destroy (sl);
+    ok (destroyed == count - count / 2,
+        "skiplist_destroy called destructor on remaining items");
+    free (items);
+}
+
+void test_badargs (void)
+{
+    errno = 0;
+    ok (skiplist_create (NULL) == NULL && errno == EINVAL,
+        "skiplist_create cmp=NULL fails with EINVAL");
+    errno = 0;
+    ok (skiplist_insert (NULL, NULL) == NULL && errno == EINVAL,
+        "skiplist_insert sl=NULL fails with EINVAL");
+    ok (skiplist_size (NULL) == 0,
+        "skiplist_size sl=NULL returns 0");
+    ok (skiplist_last (NULL) == NULL && skiplist_prev (NULL) == NULL,
+        "skiplist_last/prev sl=NULL return NULL");
+    ok (skiplist_first (NULL) == NULL && skiplist_next (NULL) == NULL,
+        "skiplist_first/next sl=NULL return NULL");
+    lives_ok ({skiplist_delete (NULL, NULL);},
+        "skiplist_delete sl=NULL doesnt crash");
+    lives_ok ({skiplist_reorder (NULL, NULL);},
+        "skiplist_reorder sl=NULL doesnt crash");
+    lives_ok ({skiplist_destroy (NULL);},
+        "skiplist_destroy sl=NULL doesnt crash");
+}
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    test_basic ();
+    test_seek ();
+    test_many (1);
+    test_many (100000);
+    test_badargs ();
+
+    done_testing ();
+    return (0);
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
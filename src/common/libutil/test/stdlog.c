@@ -85,6 +85,31 @@ void test_split (void)
         "stdlog_split message got NULL");
 }
 
+void test_repeat (void)
+{
+    char buf[128];
+    const char *ranks;
+    int rankslen;
+    int count;
+    int n;
+
+    n = stdlog_repeat_encode (buf, sizeof (buf), 42, "1-7,9");
+    ok (n == strlen (buf) && !strcmp (buf, "[flux@0 count=\"42\" ranks=\"1-7,9\"]"),
+        "stdlog_repeat_encode works: %s", buf);
+    ok (stdlog_repeat_decode (buf, n, &count, &ranks, &rankslen) == 0
+        && count == 42 && rankslen == 5 && !strncmp (ranks, "1-7,9", 5),
+        "stdlog_repeat_decode works");
+    ok (stdlog_repeat_decode (buf, n - 1, &count, &ranks, &rankslen) < 0,
+        "stdlog_repeat_decode fails on truncated input");
+    ok (stdlog_repeat_decode (STDLOG_NILVALUE, 1, &count, NULL, NULL) < 0,
+        "stdlog_repeat_decode fails on nil structured data");
+    const char *zero = "[flux@0 count=\"0\" ranks=\"1\"]";
+    ok (stdlog_repeat_decode (zero, strlen (zero), &count, NULL, NULL) < 0,
+        "stdlog_repeat_decode fails on zero count");
+    ok (stdlog_repeat_encode (buf, sizeof (buf), 0, "1") < 0,
+        "stdlog_repeat_encode fails on zero count");
+}
+
 int main(int argc, char** argv)
 {
     char buf[2048];
@@ -150,6 +175,7 @@ int main(int argc, char** argv)
     }
 
     test_split ();
+    test_repeat ();
 
     done_testing();
 }
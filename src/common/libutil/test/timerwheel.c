@@ -0,0 +1,263 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <string.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/common/libutil/timerwheel.h"
+
+struct timer {
+    struct timerwheel_entry e;  // must be first
+    uint64_t fired_at;
+    int count;
+};
+
+struct run_ctx {
+    struct timerwheel *tw;
+    uint64_t last_expires;
+    int fired;
+    int early;
+    int late;
+    int misordered;
+    uint64_t repeat;        // if nonzero, re-add fired timers
+    struct timer *remove;   // if set, remove this timer from callback
+};
+
+static void fire_cb (struct timerwheel_entry *e, void *arg)
+{
+    struct run_ctx *ctx = arg;
+    struct timer *t = (struct timer *)e;
+    uint64_t now = timerwheel_now (ctx->tw);
+
+    if (now < e->expires)
+        ctx->early++;
+    if (now > e->expires)
+        ctx->late++;
+    if (e->expires < ctx->last_expires)
+        ctx->misordered++;
+    ctx->last_expires = e->expires;
+    t->fired_at = now;
+    t->count++;
+    ctx->fired++;
+    if (ctx->remove) {
+        timerwheel_remove (ctx->tw, &ctx->remove->e);
+        ctx->remove = NULL;
+    }
+    if (ctx->repeat)
+        timerwheel_add (ctx->tw, e, now + ctx->repeat);
+}
+
+void test_basic (void)
+{
+    struct timerwheel *tw;
+    struct timer t;
+    struct run_ctx ctx;
+    uint64_t next;
+
+    memset (&t, 0, sizeof (t));
+    memset (&ctx, 0, sizeof (ctx));
+
+    ok ((tw = timerwheel_create (1000)) != NULL,
+        "timerwheel_create works");
+    ctx.tw = tw;
+    ok (timerwheel_now (tw) == 1000,
+        "timerwheel_now returns initial tick");
+    ok (timerwheel_count (tw) == 0,
+        "timerwheel_count is 0");
+    ok (timerwheel_next (tw, &next) < 0,
+        "timerwheel_next fails on empty wheel");
+    ok (!timerwheel_entry_active (&t.e),
+        "zeroed entry is not active");
+
+    timerwheel_add (tw, &t.e, 1010);
+    ok (timerwheel_entry_active (&t.e) && timerwheel_count (tw) == 1,
+        "timerwheel_add works");
+    ok (timerwheel_next (tw, &next) == 0 && next == 1010,
+        "timerwheel_next returns expiration tick");
+    timerwheel_run (tw, 1009, fire_cb, &ctx);
+    ok (ctx.fired == 0 && timerwheel_now (tw) == 1009,
+        "timerwheel_run before expiration does nothing");
+    timerwheel_run (tw, 1010, fire_cb, &ctx);
+    ok (ctx.fired == 1 && t.fired_at == 1010,
+        "timerwheel_run at expiration fires entry");
+    ok (!timerwheel_entry_active (&t.e) && timerwheel_count (tw) == 0,
+        "fired entry is no longer active");
+
+    timerwheel_add (tw, &t.e, 1020);
+    timerwheel_remove (tw, &t.e);
+    ok (!timerwheel_entry_active (&t.e) && timerwheel_count (tw) == 0,
+        "timerwheel_remove works");
+    timerwheel_remove (tw, &t.e);
+    ok (timerwheel_count (tw) == 0,
+        "timerwheel_remove of inactive entry is a no-op");
+    timerwheel_run (tw, 1100, fire_cb, &ctx);
+    ok (ctx.fired == 1,
+        "removed entry does not fire");
+
+    timerwheel_add (tw, &t.e, 5);
+    ok (timerwheel_next (tw, &next) == 0 && next == 1101,
+        "entry added in the past expires on the next tick");
+    timerwheel_run (tw, 1101, fire_cb, &ctx);
+    ok (ctx.fired == 2,
+        "and fires");
+
+    timerwheel_add (tw, &t.e, 2000);
+    timerwheel_add (tw, &t.e, 1200);
+    ok (timerwheel_count (tw) == 1,
+        "re-adding an active entry does not duplicate it");
+    timerwheel_run (tw, 1199, fire_cb, &ctx);
+    ok (ctx.fired == 2,
+        "moved entry does not fire before its new tick");
+    ok (timerwheel_next (tw, &next) == 0 && next == 1200,
+        "timerwheel_next returns new expiration tick after cascade");
+    timerwheel_add (tw, &t.e, 1300);
+    timerwheel_destroy (tw);
+    ok (!timerwheel_entry_active (&t.e),
+        "timerwheel_destroy unlinks active entries");
+
+    lives_ok ({timerwheel_destroy (NULL);},
+        "timerwheel_destroy tw=NULL doesnt crash");
+    lives_ok ({timerwheel_run (NULL, 0, NULL, NULL);},
+        "timerwheel_run tw=NULL doesnt crash");
+}
+
+/* Add timers at a wide range of distances, including beyond the range
+ * of the top level, and check that each fires exactly once, on time.
+ */
+void test_distances (void)
+{
+    struct timerwheel *tw;
+    struct run_ctx ctx;
+    uint64_t start = 12345;
+    uint64_t d[] = { 1, 2, 63, 64, 65, 100, 4095, 4096, 4097, 262143,
+                     262144, 262145, 16777215, 16777216, 16777217,
+                     100000000 };
+    int n = sizeof (d) / sizeof (d[0]);
+    struct timer t[n];
+    uint64_t next;
+    int runs = 0;
+    int errors = 0;
+
+    memset (t, 0, sizeof (t));
+    memset (&ctx, 0, sizeof (ctx));
+    if (!(tw = timerwheel_create (start)))
+        BAIL_OUT ("timerwheel_create failed");
+    ctx.tw = tw;
+
+    for (int i = n - 1; i >= 0; i--)
+        timerwheel_add (tw, &t[i].e, start + d[i]);
+    ok (timerwheel_count (tw) == n,
+        "added %d timers", n);
+    while (timerwheel_next (tw, &next) == 0) {
+        timerwheel_run (tw, next, fire_cb, &ctx);
+        runs++;
+    }
+    for (int i = 0; i < n; i++) {
+        if (t[i].count != 1 || t[i].fired_at != start + d[i]) {
+            diag ("timer +%ju fired %d times at +%ju",
+                  (uintmax_t)d[i], t[i].count,
+                  (uintmax_t)(t[i].fired_at - start));
+            errors++;
+        }
+    }
+    ok (errors == 0 && ctx.early == 0 && ctx.late == 0,
+        "all timers fired exactly once at their expiration tick");
+    ok (ctx.misordered == 0,
+        "timers fired in order");
+    diag ("%d runs", runs);
+    ok (runs < 500,
+        "idle ticks were skipped");
+    timerwheel_destroy (tw);
+}
+
+/* Run a population of repeating timers, advancing the wheel by
+ * irregular steps, and check that none fire early or miss a period.
+ */
+void test_repeat (void)
+{
+    struct timerwheel *tw;
+    struct run_ctx ctx;
+    struct timer t[256];
+    uint64_t now = 7;
+    int errors = 0;
+
+    memset (t, 0, sizeof (t));
+    memset (&ctx, 0, sizeof (ctx));
+    if (!(tw = timerwheel_create (now)))
+        BAIL_OUT ("timerwheel_create failed");
+    ctx.tw = tw;
+    ctx.repeat = 100;
+
+    for (int i = 0; i < 256; i++)
+        timerwheel_add (tw, &t[i].e, now + 1 + i * 37 % 100);
+    while (now < 100007) {
+        now += 1 + now % 13;
+        timerwheel_run (tw, now, fire_cb, &ctx);
+    }
+    ok (ctx.early == 0,
+        "no repeating timer fired early");
+    for (int i = 0; i < 256; i++) {
+        if (t[i].count < 999 || t[i].count > 1001)
+            errors++;
+    }
+    ok (errors == 0,
+        "each repeating timer fired once per period");
+    ok (timerwheel_count (tw) == 256,
+        "all repeating timers are still active");
+    timerwheel_destroy (tw);
+}
+
+void test_remove_from_cb (void)
+{
+    struct timerwheel *tw;
+    struct run_ctx ctx;
+    struct timer t1, t2;
+
+    memset (&t1, 0, sizeof (t1));
+    memset (&t2, 0, sizeof (t2));
+    memset (&ctx, 0, sizeof (ctx));
+    if (!(tw = timerwheel_create (0)))
+        BAIL_OUT ("timerwheel_create failed");
+    ctx.tw = tw;
+
+    /* Both timers expire on the same tick.  The first to fire removes
+     * the second.
+     */
+    timerwheel_add (tw, &t1.e, 10);
+    timerwheel_add (tw, &t2.e, 10);
+    ctx.remove = &t2;
+    timerwheel_run (tw, 20, fire_cb, &ctx);
+    ok (ctx.fired == 1 && t1.count == 1 && t2.count == 0,
+        "timer removed by callback on the same tick does not fire");
+    ok (timerwheel_count (tw) == 0,
+        "wheel is empty");
+    timerwheel_destroy (tw);
+}
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    test_basic ();
+    test_distances ();
+    test_repeat ();
+    test_remove_from_cb ();
+
+    done_testing ();
+    return (0);
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
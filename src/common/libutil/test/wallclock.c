@@ -14,6 +14,8 @@
 
 #include <string.h>
 #include <ctype.h>
+#include <errno.h>
+#include <time.h>
 
 int main(int argc, char** argv)
 {
@@ -41,5 +43,34 @@ int main(int argc, char** argv)
     ok (count <= 6,
 	"RFC 5424: no more than 6 optional TIME-SECFRAC digits");
 
+    time_t sec;
+    unsigned long usec;
+    char buf2[WALLCLOCK_MAXLEN];
+
+    ok (wallclock_parse_zulu (buf, &sec, &usec) == 0,
+        "wallclock_parse_zulu() parses wallclock_get_zulu() output");
+    ok (wallclock_format_zulu (sec, usec, buf2, sizeof (buf2)) == 27
+        && !strcmp (buf, buf2),
+        "wallclock_format_zulu() reproduces the original timestamp");
+    ok (wallclock_parse_zulu ("1985-04-12T23:20:50.520000Z", &sec, &usec) == 0
+        && sec == 482196050 && usec == 520000,
+        "wallclock_parse_zulu() returns expected time");
+    errno = 0;
+    ok (wallclock_parse_zulu ("1985-04-12T23:20:50.52Z", &sec, &usec) < 0
+        && errno == EINVAL,
+        "wallclock_parse_zulu() fails on short TIME-SECFRAC");
+    errno = 0;
+    ok (wallclock_parse_zulu ("1985-13-12T23:20:50.520000Z", &sec, &usec) < 0
+        && errno == EINVAL,
+        "wallclock_parse_zulu() fails on out of range month");
+    errno = 0;
+    ok (wallclock_parse_zulu ("1985-04-12T19:20:50.520000-04:00",
+                              &sec, &usec) < 0
+        && errno == EINVAL,
+        "wallclock_parse_zulu() fails on non-UTC timestamp");
+    errno = 0;
+    ok (wallclock_format_zulu (0, 0, buf2, 8) < 0 && errno == EINVAL,
+        "wallclock_format_zulu() fails with short buffer");
+
     done_testing();
 }
@@ -0,0 +1,258 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* timerwheel.c - hierarchical timer wheel
+ *
+ * An entry that expires 'delta' ticks from now is placed in the lowest
+ * level L for which delta < 64^(L+1), in slot (expires >> 6L) & 63.
+ * Each time the wheel crosses a multiple of 64^L ticks, the level L slot
+ * for the new period is "cascaded": its entries are re-placed relative
+ * to the current tick, which moves them to a lower level.  The level 0
+ * slot for the current tick then holds exactly the entries that expire.
+ *
+ * A bitmap of occupied slots per level lets timerwheel_next() find the
+ * next tick with work in constant time, so timerwheel_run() skips idle
+ * ticks rather than stepping through them.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <errno.h>
+
+#include "timerwheel.h"
+
+#define WHEEL_BITS      6
+#define WHEEL_SLOTS     (1 << WHEEL_BITS)
+#define WHEEL_MASK      (WHEEL_SLOTS - 1)
+#define WHEEL_LEVELS    4
+
+#define LEVEL_SHIFT(l)  ((l) * WHEEL_BITS)
+#define LEVEL_SPAN(l)   ((uint64_t)1 << LEVEL_SHIFT ((l) + 1))
+
+struct timerwheel {
+    uint64_t now;
+    size_t count;
+    uint64_t occupied[WHEEL_LEVELS];
+    struct timerwheel_entry slot[WHEEL_LEVELS][WHEEL_SLOTS];
+};
+
+static void slot_init (struct timerwheel_entry *head)
+{
+    head->next = head->prev = head;
+}
+
+static bool slot_empty (struct timerwheel_entry *head)
+{
+    return head->next == head;
+}
+
+static void entry_unlink (struct timerwheel *tw, struct timerwheel_entry *e)
+{
+    struct timerwheel_entry *next = e->next;
+
+    e->prev->next = next;
+    next->prev = e->prev;
+    e->next = e->prev = NULL;
+    tw->count--;
+
+    /* When the last entry is removed from a slot, its next and prev are
+     * both the list head, which is located in tw->slot[][], so the slot
+     * can be recovered to clear its occupied bit.
+     */
+    if (next == next->next) {
+        size_t index = next - &tw->slot[0][0];
+        tw->occupied[index / WHEEL_SLOTS] &= ~(1ULL << (index % WHEEL_SLOTS));
+    }
+}
+
+/* Place 'e' in the wheel.  'min' is the earliest tick the entry may be
+ * placed at: the current tick during a cascade, or the next tick otherwise.
+ */
+static void entry_place (struct timerwheel *tw,
+                         struct timerwheel_entry *e,
+                         uint64_t min)
+{
+    uint64_t expires = e->expires < min ? min : e->expires;
+    uint64_t delta = expires - tw->now;
+    struct timerwheel_entry *head;
+    int level;
+    int index;
+
+    for (level = 0; level < WHEEL_LEVELS - 1; level++) {
+        if (delta < LEVEL_SPAN (level))
+            break;
+    }
+    if (delta >= LEVEL_SPAN (level))
+        expires = tw->now + LEVEL_SPAN (level) - 1;
+    index = (expires >> LEVEL_SHIFT (level)) & WHEEL_MASK;
+
+    head = &tw->slot[level][index];
+    e->next = head;
+    e->prev = head->prev;
+    head->prev->next = e;
+    head->prev = e;
+    tw->occupied[level] |= 1ULL << index;
+    tw->count++;
+}
+
+static void cascade (struct timerwheel *tw, int level, int index)
+{
+    struct timerwheel_entry *head = &tw->slot[level][index];
+
+    while (!slot_empty (head)) {
+        struct timerwheel_entry *e = head->next;
+        entry_unlink (tw, e);
+        entry_place (tw, e, tw->now);
+    }
+}
+
+struct timerwheel *timerwheel_create (uint64_t now)
+{
+    struct timerwheel *tw;
+
+    if (!(tw = calloc (1, sizeof (*tw))))
+        return NULL;
+    tw->now = now;
+    for (int level = 0; level < WHEEL_LEVELS; level++) {
+        for (int index = 0; index < WHEEL_SLOTS; index++)
+            slot_init (&tw->slot[level][index]);
+    }
+    return tw;
+}
+
+void timerwheel_destroy (struct timerwheel *tw)
+{
+    if (tw) {
+        int saved_errno = errno;
+        for (int level = 0; level < WHEEL_LEVELS; level++) {
+            for (int index = 0; index < WHEEL_SLOTS; index++) {
+                struct timerwheel_entry *head = &tw->slot[level][index];
+                while (!slot_empty (head))
+                    entry_unlink (tw, head->next);
+            }
+        }
+        free (tw);
+        errno = saved_errno;
+    }
+}
+
+bool timerwheel_entry_active (struct timerwheel_entry *e)
+{
+    return e && e->next != NULL;
+}
+
+void timerwheel_add (struct timerwheel *tw,
+                     struct timerwheel_entry *e,
+                     uint64_t expires)
+{
+    if (!tw || !e)
+        return;
+    if (timerwheel_entry_active (e))
+        entry_unlink (tw, e);
+    e->expires = expires;
+    entry_place (tw, e, tw->now + 1);
+}
+
+void timerwheel_remove (struct timerwheel *tw, struct timerwheel_entry *e)
+{
+    if (tw && timerwheel_entry_active (e))
+        entry_unlink (tw, e);
+}
+
+/* Rotate 'x' right by 'n' bits, 0 <= n < 64.
+ */
+static uint64_t rotr64 (uint64_t x, int n)
+{
+    if (n == 0)
+        return x;
+    return (x >> n) | (x << (64 - n));
+}
+
+int timerwheel_next (struct timerwheel *tw, uint64_t *tick)
+{
+    uint64_t next = UINT64_MAX;
+
+    if (!tw || tw->count == 0)
+        return -1;
+    /* The earliest work at level L is the next period boundary (tick at
+     * level 0) whose slot is occupied.  Search the slots after the current
+     * one, wrapping around to the current slot last.
+     */
+    for (int level = 0; level < WHEEL_LEVELS; level++) {
+        uint64_t base;
+        uint64_t bits;
+        uint64_t t;
+
+        if (tw->occupied[level] == 0)
+            continue;
+        base = tw->now >> LEVEL_SHIFT (level);
+        bits = rotr64 (tw->occupied[level], (base + 1) & WHEEL_MASK);
+        t = (base + 1 + __builtin_ctzll (bits)) << LEVEL_SHIFT (level);
+        if (t < next)
+            next = t;
+    }
+    if (tick)
+        *tick = next;
+    return 0;
+}
+
+void timerwheel_run (struct timerwheel *tw,
+                     uint64_t now,
+                     timerwheel_f cb,
+                     void *arg)
+{
+    if (!tw)
+        return;
+    while (tw->now < now) {
+        struct timerwheel_entry *head;
+        uint64_t next;
+
+        if (timerwheel_next (tw, &next) < 0 || next > now) {
+            tw->now = now;
+            break;
+        }
+        tw->now = next;
+
+        /* Cascade level L when all the levels below it have wrapped.
+         */
+        for (int level = 1; level < WHEEL_LEVELS; level++) {
+            int index = (tw->now >> LEVEL_SHIFT (level)) & WHEEL_MASK;
+            if ((tw->now & (((uint64_t)1 << LEVEL_SHIFT (level)) - 1)) != 0)
+                break;
+            cascade (tw, level, index);
+        }
+
+        head = &tw->slot[0][tw->now & WHEEL_MASK];
+        while (!slot_empty (head)) {
+            struct timerwheel_entry *e = head->next;
+            entry_unlink (tw, e);
+            if (e->expires > tw->now) // parked entry, not yet due
+                entry_place (tw, e, tw->now + 1);
+            else if (cb)
+                cb (e, arg);
+        }
+    }
+}
+
+uint64_t timerwheel_now (struct timerwheel *tw)
+{
+    return tw ? tw->now : 0;
+}
+
+size_t timerwheel_count (struct timerwheel *tw)
+{
+    return tw ? tw->count : 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
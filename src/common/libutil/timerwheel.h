@@ -0,0 +1,83 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _UTIL_TIMERWHEEL_H
+#define _UTIL_TIMERWHEEL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Hierarchical timer wheel with O(1) add and remove.
+ *
+ * Time is measured in integer ticks.  Entries are embedded in the
+ * caller's structure and are linked into one of 4 levels of 64 slots.
+ * Entries more than 64^4 ticks in the future are parked in the top
+ * level and re-cascaded until they come into range.
+ *
+ * timerwheel_run() advances the wheel and calls the callback for each
+ * entry whose expiration tick has been reached.  An entry never expires
+ * before its tick.
+ */
+
+struct timerwheel_entry {
+    struct timerwheel_entry *next;  // private
+    struct timerwheel_entry *prev;  // private
+    uint64_t expires;
+};
+
+struct timerwheel;
+
+typedef void (*timerwheel_f)(struct timerwheel_entry *e, void *arg);
+
+struct timerwheel *timerwheel_create (uint64_t now);
+void timerwheel_destroy (struct timerwheel *tw);
+
+/* Add entry 'e' to expire at tick 'expires'.  If 'expires' is not in
+ * the future, the entry expires on the next tick.  If 'e' is already
+ * in the wheel it is moved.
+ */
+void timerwheel_add (struct timerwheel *tw,
+                     struct timerwheel_entry *e,
+                     uint64_t expires);
+
+/* Remove 'e' from the wheel.  This is a no-op if 'e' is not in the wheel.
+ */
+void timerwheel_remove (struct timerwheel *tw, struct timerwheel_entry *e);
+
+bool timerwheel_entry_active (struct timerwheel_entry *e);
+
+/* Advance the wheel to tick 'now', calling 'cb' for each entry that
+ * expires, in expiration order.  Entries are removed before 'cb' is
+ * called, so 'cb' may re-add them, and may add or remove other entries.
+ */
+void timerwheel_run (struct timerwheel *tw,
+                     uint64_t now,
+                     timerwheel_f cb,
+                     void *arg);
+
+/* Get the next tick at which timerwheel_run() has work to do.
+ * Returns -1 if the wheel is empty.
+ */
+int timerwheel_next (struct timerwheel *tw, uint64_t *tick);
+
+/* Get the tick the wheel has been advanced to.
+ */
+uint64_t timerwheel_now (struct timerwheel *tw);
+
+/* Get the number of entries in the wheel.
+ */
+size_t timerwheel_count (struct timerwheel *tw);
+
+#endif /* !_UTIL_TIMERWHEEL_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -15,6 +15,7 @@
 #include <errno.h>
 #include <stdio.h>
 #include <string.h>
+#include <ctype.h>
 
 #include "wallclock.h"
 
@@ -27,20 +28,16 @@
  *   2003-08-24T05:14:15.000003-07:00
  */
 
-int wallclock_get_zulu (char *buf, size_t len)
+int wallclock_format_zulu (time_t sec, unsigned long usec,
+                           char *buf, size_t len)
 {
-    struct timespec ts;
     struct tm tm;
-    time_t t;
 
-    if (len < WALLCLOCK_MAXLEN) {
+    if (len < WALLCLOCK_MAXLEN || usec >= 1000000) {
         errno = EINVAL;
         return -1;
     }
-    if (clock_gettime (CLOCK_REALTIME, &ts) < 0)
-        return -1;
-    t = ts.tv_sec;
-    if (!gmtime_r (&t, &tm)) {
+    if (!gmtime_r (&sec, &tm)) {
         errno = EINVAL;
         return -1;
     }
@@ -48,13 +45,65 @@ int wallclock_get_zulu (char *buf, size_t len)
         errno = EINVAL;
         return -1;
     }
-    if (snprintf (buf+19, len-19, ".%.6luZ", ts.tv_nsec/1000) >= len - 20) {
+    if (snprintf (buf+19, len-19, ".%.6luZ", usec) >= len - 20) {
         errno = EINVAL;
         return -1;
     }
     return strlen (buf);
 }
 
+int wallclock_get_zulu (char *buf, size_t len)
+{
+    struct timespec ts;
+
+    if (clock_gettime (CLOCK_REALTIME, &ts) < 0)
+        return -1;
+    return wallclock_format_zulu (ts.tv_sec, ts.tv_nsec/1000, buf, len);
+}
+
+/* Accept only the exact form produced by wallclock_format_zulu(),
+ * so that a parsed timestamp can be reproduced byte for byte.
+ */
+int wallclock_parse_zulu (const char *s, time_t *sec, unsigned long *usec)
+{
+    struct tm tm, check;
+    unsigned int frac;
+    time_t t;
+    int n = 0;
+    int i;
+
+    if (!s || !sec || !usec || strlen (s) != 27)
+        goto inval;
+    for (i = 0; i < 26; i++) {
+        if (i == 4 || i == 7 || i == 10 || i == 13 || i == 16 || i == 19)
+            continue;
+        if (!isdigit (s[i]))
+            goto inval;
+    }
+    memset (&tm, 0, sizeof (tm));
+    if (sscanf (s, "%4d-%2d-%2dT%2d:%2d:%2d.%6uZ%n",
+                &tm.tm_year, &tm.tm_mon, &tm.tm_mday,
+                &tm.tm_hour, &tm.tm_min, &tm.tm_sec, &frac, &n) != 7
+        || n != 27)
+        goto inval;
+    tm.tm_year -= 1900;
+    tm.tm_mon -= 1;
+    check = tm;
+    if ((t = timegm (&tm)) == (time_t)-1)
+        goto inval;
+    /* timegm() normalizes out of range fields, e.g. month 13 */
+    if (tm.tm_year != check.tm_year || tm.tm_mon != check.tm_mon
+        || tm.tm_mday != check.tm_mday || tm.tm_hour != check.tm_hour
+        || tm.tm_min != check.tm_min || tm.tm_sec != check.tm_sec)
+        goto inval;
+    *sec = t;
+    *usec = frac;
+    return 0;
+inval:
+    errno = EINVAL;
+    return -1;
+}
+
 /*
  * vi:tabstop=4 shiftwidth=4 expandtab
  */
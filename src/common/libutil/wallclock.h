@@ -13,8 +13,18 @@
 
 #define WALLCLOCK_MAXLEN    33
 
+#include <time.h>
+
 int wallclock_get_zulu (char *buf, size_t len);
 
+/* Format/parse the RFC 5424 timestamp produced by wallclock_get_zulu(),
+ * e.g. 2016-06-10T18:01:18.479194Z.  wallclock_parse_zulu() fails with
+ * EINVAL on any other form.
+ */
+int wallclock_format_zulu (time_t sec, unsigned long usec,
+                           char *buf, size_t len);
+int wallclock_parse_zulu (const char *s, time_t *sec, unsigned long *usec);
+
 #endif /* !_UTIL_WALLCLOCK_H */
 
 /*
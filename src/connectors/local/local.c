@@ -198,6 +198,41 @@ static int override_retry_count (struct usock_retry_params *retry)
     return 0;
 }
 
+/* If FLUX_LOCAL_CONNECTOR_SHMEM_SIZE is set to a nonzero size in bytes,
+ * ask connector-local to switch this connection to shared memory rings
+ * of that size, so large messages bypass the socket.  If the broker
+ * refuses or the attach fails for any reason, carry on with the socket.
+ */
+static int shmem_attach (struct local_connector *ctx)
+{
+    const char *s;
+    char *endptr;
+    unsigned long size;
+    struct shmring *ring;
+    flux_msg_t *msg;
+
+    if (!(s = getenv ("FLUX_LOCAL_CONNECTOR_SHMEM_SIZE")))
+        return 0;
+    errno = 0;
+    size = strtoul (s, &endptr, 10);
+    if (errno != 0 || *endptr != '\0') {
+        errno = EINVAL;
+        return -1;
+    }
+    if (size == 0)
+        return 0;
+    if (!(ring = shmring_create (size)))
+        return 0;
+    if (!(msg = flux_request_encode ("local.shmem-attach", NULL))) {
+        shmring_destroy (ring);
+        return -1;
+    }
+    if (usock_client_attach_shmring (ctx->uclient, ring, msg) < 0)
+        shmring_destroy (ring);
+    flux_msg_destroy (msg);
+    return 0;
+}
+
 /* Path is interpreted as the directory containing the unix domain socket.
  */
 flux_t *connector_init (const char *path, int flags)
@@ -220,6 +255,8 @@ flux_t *connector_init (const char *path, int flags)
         goto error;
     if (!(ctx->uclient = usock_client_create (ctx->fd)))
         goto error;
+    if (shmem_attach (ctx) < 0)
+        goto error;
     if (!(ctx->h = flux_handle_create (ctx, &handle_ops, flags)))
         goto error;
     return ctx->h;
@@ -18,21 +18,30 @@
 #include <sys/param.h>
 #include <sys/un.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+#include <sys/wait.h>
+#include <fcntl.h>
 #include <signal.h>
 #include <poll.h>
 #include <unistd.h>
+#include <stdint.h>
+#include <inttypes.h>
 #include <argz.h>
 #include <flux/core.h>
 
 #include "src/common/libutil/log.h"
 #include "src/common/libutil/popen2.h"
 #include "src/common/libutil/errno_safe.h"
+#include "src/common/libutil/fdwalk.h"
+#include "src/common/libutil/fsd.h"
 #include "src/common/libyuarel/yuarel.h"
 #include "src/common/librouter/usock.h"
 
 struct ssh_connector {
     struct usock_client *uclient;
     struct popen2_child *p;
+    int fd;                     // socket of persistent proxy, if any
     flux_t *h;
 };
 
@@ -108,6 +117,8 @@ static void op_fini (void *impl)
         int saved_errno = errno;
         usock_client_destroy (ctx->uclient);
         pclose2 (ctx->p);
+        if (ctx->fd >= 0)
+            (void)close (ctx->fd);
         free (ctx);
         errno = saved_errno;
     }
@@ -136,6 +147,12 @@ static char *which (const char *prog, char *buf, size_t size)
     return result;
 }
 
+static void close_nonstdio_fd (void *arg, int fd)
+{
+    if (fd != STDIN_FILENO && fd != STDOUT_FILENO && fd != STDERR_FILENO)
+        (void)close (fd);
+}
+
 /* uri_path is interpreted as:
  *   [user@]hostname[:port]/unix-path
  * Sets *argvp, *argbuf (caller must free).
@@ -220,17 +237,222 @@ error:
     return -1;
 }
 
+/* Persistent proxy
+ *
+ * If FLUX_SSH_PERSIST is set, the connector does not run its own ssh
+ * command.  Instead it connects to a "flux proxy --listen" process that is
+ * shared by all clients of the same URI, which holds a single ssh
+ * connection open and routes messages for all of them, like an ssh
+ * ControlMaster.  If the proxy is not running, the first client starts
+ * it in the background, and it exits after no clients have been connected
+ * for FLUX_SSH_PERSIST (FSD, or 0 to persist until the connection fails).
+ *
+ * Proxy sockets live in a private directory, ${TMPDIR:-/tmp}/flux-ssh-UID,
+ * and are named by a hash of the URI and commands, so that their paths are
+ * short enough for a unix domain socket.  A lock file next to the socket
+ * serializes clients that find no proxy running so that only one starts.
+ */
+
+/* FNV-1a hash of 's' and a terminating newline, continuing from 'hash'.
+ */
+static uint64_t fnv1a (uint64_t hash, const char *s)
+{
+    do {
+        hash ^= (unsigned char)(*s ? *s : '\n');
+        hash *= 0x100000001b3ULL;
+    } while (*s++);
+    return hash;
+}
+
+static int persist_sockpath (const char *uri_path,
+                             const char *ssh_cmd,
+                             const char *flux_cmd,
+                             char *buf,
+                             size_t size)
+{
+    const char *tmpdir = getenv ("TMPDIR");
+    char dir[PATH_MAX + 1];
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    struct stat sb;
+
+    if (!tmpdir || tmpdir[0] != '/')
+        tmpdir = "/tmp";
+    if (snprintf (dir,
+                  sizeof (dir),
+                  "%s/flux-ssh-%ju",
+                  tmpdir,
+                  (uintmax_t)getuid ()) >= sizeof (dir))
+        goto inval;
+    if (mkdir (dir, 0700) < 0 && errno != EEXIST)
+        return -1;
+    if (lstat (dir, &sb) < 0)
+        return -1;
+    if (!S_ISDIR (sb.st_mode)
+        || sb.st_uid != getuid ()
+        || (sb.st_mode & 077) != 0) {
+        fprintf (stderr, "ssh-connector: %s: not a private directory\n", dir);
+        errno = EPERM;
+        return -1;
+    }
+    hash = fnv1a (hash, uri_path);
+    hash = fnv1a (hash, ssh_cmd);
+    hash = fnv1a (hash, flux_cmd);
+    if (snprintf (buf, size, "%s/%016" PRIx64, dir, hash) >= size)
+        goto inval;
+    return 0;
+inval:
+    errno = EINVAL;
+    return -1;
+}
+
+/* Connect to the proxy at 'sockpath' and complete the auth handshake.
+ */
+static int persist_open (struct ssh_connector *ctx,
+                         const char *sockpath,
+                         struct usock_retry_params retry)
+{
+    int fd;
+
+    if ((fd = usock_client_connect (sockpath, retry)) < 0)
+        return -1;
+    if (!(ctx->uclient = usock_client_create (fd))) {
+        ERRNO_SAFE_WRAP (close, fd);
+        return -1;
+    }
+    ctx->fd = fd;
+    return 0;
+}
+
+/* Start "flux proxy --listen=SOCKPATH --idle-timeout=PERSIST ssh://PATH"
+ * as a daemon, as flux-terminus does for its server.
+ */
+static int persist_spawn (const char *sockpath,
+                          const char *persist,
+                          const char *uri_path)
+{
+    char buf[PATH_MAX + 1];
+    const char *flux_cmd;
+    char *argv[6] = { NULL };
+    pid_t pid;
+    int status;
+    int rc = -1;
+
+    if (!(flux_cmd = which ("flux", buf, sizeof (buf))))
+        flux_cmd = "flux";
+    argv[0] = (char *)flux_cmd;
+    argv[1] = "proxy";
+    if (asprintf (&argv[2], "--listen=%s", sockpath) < 0
+        || asprintf (&argv[3], "--idle-timeout=%s", persist) < 0
+        || asprintf (&argv[4], "ssh://%s", uri_path) < 0)
+        goto done;
+    if ((pid = fork ()) < 0)
+        goto done;
+    if (pid == 0) {
+        int fd;
+
+        /* Child: detach from the session and fork again, so the proxy
+         * is not a child of the client process.
+         * N.B. only async-signal-safe calls between fork() and exec().
+         */
+        (void)setsid ();
+        if (fork () != 0)
+            _exit (0);
+        if ((fd = open ("/dev/null", O_RDWR)) >= 0) {
+            (void)dup2 (fd, STDIN_FILENO);
+            (void)dup2 (fd, STDOUT_FILENO);
+            (void)dup2 (fd, STDERR_FILENO);
+        }
+        (void)fdwalk (close_nonstdio_fd, NULL);
+        if (chdir ("/") < 0)
+            _exit (1);
+        execvp (argv[0], argv);
+        _exit (127);
+    }
+    if (waitpid (pid, &status, 0) < 0)
+        goto done;
+    rc = 0;
+done:
+    ERRNO_SAFE_WRAP (free, argv[2]);
+    ERRNO_SAFE_WRAP (free, argv[3]);
+    ERRNO_SAFE_WRAP (free, argv[4]);
+    return rc;
+}
+
+static int persist_connect (struct ssh_connector *ctx,
+                            const char *uri_path,
+                            const char *ssh_cmd,
+                            const char *flux_cmd,
+                            const char *persist)
+{
+    /* Allow for the ssh handshake in a newly started proxy.
+     */
+    struct usock_retry_params retry = {
+        .max_retry = 12,
+        .min_delay = 0.016,
+        .max_delay = 2,
+    };
+    char sockpath[PATH_MAX + 1];
+    char lockpath[PATH_MAX + 1];
+    double timeout;
+    int lockfd;
+
+    if (fsd_parse_duration (persist, &timeout) < 0) {
+        fprintf (stderr, "ssh-connector: invalid FLUX_SSH_PERSIST value\n");
+        errno = EINVAL;
+        return -1;
+    }
+    if (persist_sockpath (uri_path,
+                          ssh_cmd,
+                          flux_cmd,
+                          sockpath,
+                          sizeof (sockpath)) < 0)
+        return -1;
+    if (persist_open (ctx, sockpath, USOCK_RETRY_NONE) == 0)
+        return 0;
+    if (snprintf (lockpath,
+                  sizeof (lockpath),
+                  "%s.lock",
+                  sockpath) >= sizeof (lockpath)) {
+        errno = EINVAL;
+        return -1;
+    }
+    if ((lockfd = open (lockpath, O_RDWR | O_CREAT | O_CLOEXEC, 0600)) < 0)
+        return -1;
+    if (flock (lockfd, LOCK_EX) < 0)
+        goto error;
+    /* Another client may have started the proxy while we waited.
+     */
+    if (persist_open (ctx, sockpath, USOCK_RETRY_NONE) < 0) {
+        if (persist_spawn (sockpath, persist, uri_path) < 0
+            || persist_open (ctx, sockpath, retry) < 0) {
+            fprintf (stderr,
+                     "ssh-connector: persistent proxy for ssh://%s"
+                     " did not start: %s\n",
+                     uri_path,
+                     strerror (errno));
+            goto error;
+        }
+    }
+    (void)close (lockfd); // releases lock
+    return 0;
+error:
+    ERRNO_SAFE_WRAP (close, lockfd);
+    return -1;
+}
+
 flux_t *connector_init (const char *path, int flags)
 {
     struct ssh_connector *ctx;
     char buf[PATH_MAX + 1];
     const char *ssh_cmd;
     const char *flux_cmd;
+    const char *persist;
     char *argbuf = NULL;
     char **argv = NULL;
 
     if (!(ctx = calloc (1, sizeof (*ctx))))
         return NULL;
+    ctx->fd = -1;
 
     /* FLUX_SSH may be used to select a different remote shell command
      * from the compiled-in default.  Most rsh variants ought to work.
@@ -253,6 +475,15 @@ flux_t *connector_init (const char *path, int flags)
     if (build_ssh_command (path, ssh_cmd, flux_cmd, &argv, &argbuf) < 0)
         goto error;
 
+    /* FLUX_SSH_PERSIST may be set to share one ssh connection among
+     * clients through a persistent proxy (see above).
+     */
+    if ((persist = getenv ("FLUX_SSH_PERSIST")) && strlen (persist) > 0) {
+        if (persist_connect (ctx, path, ssh_cmd, flux_cmd, persist) < 0)
+            goto error;
+        goto handle;
+    }
+
     /* Start the ssh command
      */
     if (!(ctx->p = popen2 (ssh_cmd, argv))) {
@@ -272,6 +503,7 @@ flux_t *connector_init (const char *path, int flags)
      */
     if (!(ctx->uclient = usock_client_create (popen2_get_fd (ctx->p))))
         goto error;
+handle:
     if (!(ctx->h = flux_handle_create (ctx, &handle_ops, flags)))
         goto error;
     free (argbuf);
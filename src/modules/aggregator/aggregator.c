@@ -8,7 +8,16 @@
  * SPDX-License-Identifier: LGPL-3.0
 \************************************************************/
 
-/* aggregator.c - reduction based numerical aggreagator */
+/* aggregator.c - reduction based numerical aggreagator
+ *
+ * By default, entries with distinct values are kept separately, keyed by
+ * the ids that pushed them.  If a push names a reduction operator with
+ * "reduce", values are combined at each level of the TBON so that a single
+ * entry is forwarded upstream regardless of the number of ids.
+ *
+ * Completion is tracked with a bitmap of the ids pushed so far, so that
+ * an id pushed more than once is only counted once.
+ */
 
 #if HAVE_CONFIG_H
 #include "config.h"
@@ -20,6 +29,16 @@
 
 #include "src/common/libidset/idset.h"
 
+enum reduce_op {
+    REDUCE_NONE = 0,
+    REDUCE_SUM,
+    REDUCE_MIN,
+    REDUCE_MAX,
+    REDUCE_IDSET,
+};
+
+static const char *reduce_names[] = { NULL, "sum", "min", "max", "idset" };
+
 struct aggregator {
     flux_t *h;
     uint32_t rank;
@@ -48,8 +67,10 @@ struct aggregate {
     double timeout;          /* timeout                                      */
     int sink_retries;        /* number of times left to try to sink to kvs   */
     uint32_t fwd_count;      /* forward at this many                         */
+    enum reduce_op op;       /* reduction operator, or REDUCE_NONE           */
     char *key;               /* KVS key into which to sink the aggregate     */
     uint32_t count;          /* count of current total entries               */
+    struct idset *ranks;     /* ids pushed so far, for count                 */
     uint32_t total;          /* expected total entries (used for sink)       */
     zlist_t *entries;        /* list of individual entries                   */
     json_t *summary;         /* optional summary stats for this aggregate    */
@@ -164,53 +185,173 @@ static struct aggregate_entry *
         ae->value = value;
 
         /* Update aggregate summary statistics on rank 0 only */
-        if (ag->ctx->rank == 0 && aggregate_update_summary (ag, value) < 0)
+        if (ag->ctx->rank == 0
+            && ag->op == REDUCE_NONE
+            && aggregate_update_summary (ag, value) < 0)
             flux_log_error (ag->ctx->h, "aggregate_update_summary");
         zlist_push (ag->entries, ae);
     }
     return (ae);
 }
 
-int add_string_to_idset (struct idset *idset, const char *s)
+static int reduce_op_parse (const char *s, enum reduce_op *op)
 {
-    struct idset *nids;
+    int i;
+
+    if (!s) {
+        *op = REDUCE_NONE;
+        return (0);
+    }
+    for (i = 1; i < sizeof (reduce_names) / sizeof (reduce_names[0]); i++) {
+        if (!strcmp (s, reduce_names[i])) {
+            *op = i;
+            return (0);
+        }
+    }
+    errno = EINVAL;
+    return (-1);
+}
+
+static json_t *reduce_number (enum reduce_op op, json_t *a, json_t *b)
+{
+    double x = json_number_value (a);
+    double y = json_number_value (b);
+
+    switch (op) {
+        case REDUCE_SUM:
+            if (json_is_integer (a) && json_is_integer (b))
+                return json_integer (json_integer_value (a)
+                                     + json_integer_value (b));
+            return json_real (x + y);
+        case REDUCE_MIN:
+            return json_incref (y < x ? b : a);
+        case REDUCE_MAX:
+            return json_incref (y > x ? b : a);
+        default:
+            break;
+    }
+    errno = EINVAL;
+    return (NULL);
+}
+
+static json_t *reduce_idset (json_t *a, json_t *b)
+{
+    struct idset *x = NULL;
+    struct idset *y = NULL;
     unsigned int id;
-    int rc = -1;
+    char *s = NULL;
+    json_t *result = NULL;
 
-    if (!(nids = idset_decode (s)))
-        return (-1);
-    id = idset_first (nids);
+    if (!(x = idset_decode (json_string_value (a)))
+        || !(y = idset_decode (json_string_value (b))))
+        goto out;
+    id = idset_first (y);
     while (id != IDSET_INVALID_ID) {
-        if (idset_set (idset, id) < 0)
-            goto done;
-        id = idset_next (nids, id);
+        if (idset_set (x, id) < 0)
+            goto out;
+        id = idset_next (y, id);
     }
-    rc = 0;
-done:
-    idset_destroy (nids);
-    return rc;
+    if (!(s = idset_encode (x, IDSET_FLAG_RANGE)))
+        goto out;
+    if (!(result = json_string (s)))
+        errno = ENOMEM;
+out:
+    free (s);
+    idset_destroy (x);
+    idset_destroy (y);
+    return (result);
+}
+
+static bool reduce_valid (enum reduce_op op, json_t *value)
+{
+    if (op == REDUCE_IDSET)
+        return json_is_string (value);
+    return json_is_number (value);
+}
+
+/*  Combine values `a` and `b` with reduction operator `op`.
+ *   Return a new reference, or NULL with errno set to EINVAL if the
+ *   values are of the wrong type for `op`.
+ */
+static json_t *reduce_values (enum reduce_op op, json_t *a, json_t *b)
+{
+    if (!reduce_valid (op, a) || !reduce_valid (op, b)) {
+        errno = EINVAL;
+        return (NULL);
+    }
+    if (op == REDUCE_IDSET)
+        return reduce_idset (a, b);
+    return reduce_number (op, a, b);
+}
+
+/*  Combine `value` into the single entry of reducing aggregate `ag`,
+ *   creating the entry if this is the first push.
+ */
+static struct aggregate_entry *
+    aggregate_entry_reduce (struct aggregate *ag, json_t *value)
+{
+    struct aggregate_entry *ae;
+    json_t *result;
+
+    if (!(ae = zlist_first (ag->entries))) {
+        if (!reduce_valid (ag->op, value)) {
+            errno = EINVAL;
+            return (NULL);
+        }
+        ae = aggregate_entry_add (ag, value);
+    }
+    else {
+        if (!(result = reduce_values (ag->op, ae->value, value)))
+            return (NULL);
+        json_decref (ae->value);
+        ae->value = result;
+    }
+    /* Summary stats on rank 0 are those of the reduced value */
+    if (ae && ag->ctx->rank == 0) {
+        json_decref (ag->summary);
+        ag->summary = NULL;
+        if (aggregate_update_summary (ag, ae->value) < 0)
+            flux_log_error (ag->ctx->h, "aggregate_update_summary");
+    }
+    return (ae);
 }
 
 /*  Push a new (ids, value) pair onto aggregate `ag`.
  *   If an existing matching entry is found, add ids to its nodeset.
  *   o/w, add a new entry. In either case update current count with
- *   the number of `ids` added.
+ *   the number of `ids` not previously pushed.
  */
 static int aggregate_push (struct aggregate *ag, json_t *value, const char *ids)
 {
-    int count;
-    struct aggregate_entry *ae = aggregate_entry_find (ag, value);
-    if ((ae == NULL) && !(ae = aggregate_entry_add (ag, value)))
-        return (-1);
+    struct aggregate_entry *ae;
+    struct idset *nids;
+    unsigned int id;
+    int rc = -1;
 
-    count = idset_count (ae->ids);
-    if (add_string_to_idset (ae->ids, ids) < 0)
+    if (!(nids = idset_decode (ids)))
         return (-1);
+    if (ag->op != REDUCE_NONE)
+        ae = aggregate_entry_reduce (ag, value);
+    else if (!(ae = aggregate_entry_find (ag, value)))
+        ae = aggregate_entry_add (ag, value);
+    if (!ae)
+        goto done;
 
-    /* Update count */
-    ag->count += (idset_count (ae->ids) - count);
-
-    return (0);
+    id = idset_first (nids);
+    while (id != IDSET_INVALID_ID) {
+        if (idset_set (ae->ids, id) < 0)
+            goto done;
+        if (!idset_test (ag->ranks, id)) {
+            if (idset_set (ag->ranks, id) < 0)
+                goto done;
+            ag->count++;
+        }
+        id = idset_next (nids, id);
+    }
+    rc = 0;
+done:
+    idset_destroy (nids);
+    return (rc);
 }
 
 /*  Push JSON object of aggregate entries onto aggregate `ag`
@@ -282,21 +423,31 @@ static int aggregate_forward (flux_t *h, struct aggregate *ag)
 {
     int rc = 0;
     flux_future_t *f;
+    json_t *payload;
     json_t *o = aggregate_entries_tojson (ag);
 
     if (o == NULL) {
         flux_log (h, LOG_ERR, "forward: aggregate_entries_tojson failed");
         return (-1);
     }
+    if (!(payload = json_pack ("{s:s,s:i,s:i,s:f,s:o}",
+                               "key", ag->key,
+                               "count", ag->count,
+                               "total", ag->total,
+                               "timeout", ag->timeout,
+                               "entries", o))
+        || (ag->op != REDUCE_NONE
+            && json_object_set_new (payload,
+                                    "reduce",
+                                    json_string (reduce_names[ag->op])) < 0)) {
+        flux_log (h, LOG_ERR, "forward: failed to encode payload");
+        json_decref (payload);
+        return (-1);
+    }
     flux_log (h, LOG_DEBUG, "forward: %s: count=%d total=%d",
                  ag->key, ag->count, ag->total);
     if (!(f = flux_rpc_pack (h, "aggregator.push", FLUX_NODEID_UPSTREAM, 0,
-                                "{s:s,s:i,s:i,s:f,s:o}",
-                                "key", ag->key,
-                                "count", ag->count,
-                                "total", ag->total,
-                                "timeout", ag->timeout,
-                                "entries", o)) ||
+                                "o", payload)) ||
         (flux_future_then (f, -1., forward_continuation, (void *) ag) < 0)) {
         flux_log_error (h, "flux_rpc: aggregator.push");
         flux_future_destroy (f);
@@ -474,6 +625,7 @@ static void aggregate_destroy (struct aggregate *ag)
         ae = zlist_next (ag->entries);
     }
     zlist_destroy (&ag->entries);
+    idset_destroy (ag->ranks);
     json_decref (ag->summary);
     flux_watcher_destroy (ag->tw);
     free (ag->key);
@@ -517,7 +669,9 @@ static struct aggregate *
         return NULL;
 
     ag->ctx = ctx;
-    if (!(ag->key = strdup (key)) || !(ag->entries = zlist_new ())) {
+    if (!(ag->key = strdup (key))
+        || !(ag->entries = zlist_new ())
+        || !(ag->ranks = idset_create (0, IDSET_FLAG_AUTOGROW))) {
         flux_log_error (h, "aggregate_create: memory allocation error");
         aggregate_destroy (ag);
         return (NULL);
@@ -590,7 +744,8 @@ error:
 static struct aggregate *
 aggregator_new_aggregate (struct aggregator *ctx, const char *key,
                           int64_t total,
-                          double timeout)
+                          double timeout,
+                          enum reduce_op op)
 {
     struct aggregate *ag = aggregate_create (ctx, key);
     if (ag == NULL)
@@ -603,6 +758,7 @@ aggregator_new_aggregate (struct aggregator *ctx, const char *key,
     zhash_freefn (ctx->aggregates, key, (zhash_free_fn *) aggregate_destroy);
     ag->timeout = timeout;
     ag->total = total;
+    ag->op = op;
     aggregate_timer_start (ag, timeout * ctx->timer_scale);
     return (ag);
 }
@@ -621,20 +777,29 @@ static void push_cb (flux_t *h, flux_msg_handler_t *mh,
     int64_t fwd_count = 0;
     int64_t total = 0;
     json_t *entries = NULL;
+    const char *reduce = NULL;
+    enum reduce_op op;
 
-    if (flux_msg_unpack (msg, "{s:s,s:I,s:o,s?F,s?I}",
+    if (flux_msg_unpack (msg, "{s:s,s:I,s:o,s?F,s?I,s?s}",
                               "key", &key,
                               "total", &total,
                               "entries", &entries,
                               "timeout", &timeout,
-                              "fwd_count", &fwd_count) < 0)
+                              "fwd_count", &fwd_count,
+                              "reduce", &reduce) < 0)
+        goto error;
+    if (reduce_op_parse (reduce, &op) < 0)
         goto error;
 
     if (!(ag = zhash_lookup (ctx->aggregates, key)) &&
-        !(ag = aggregator_new_aggregate (ctx, key, total, timeout))) {
+        !(ag = aggregator_new_aggregate (ctx, key, total, timeout, op))) {
         flux_log_error (ctx->h, "failed to get new aggregate");
         goto error;
     }
+    if (ag->op != op) {
+        errno = EINVAL;
+        goto error;
+    }
 
     if (fwd_count > 0)
         ag->fwd_count = fwd_count;
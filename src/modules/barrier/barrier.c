@@ -11,13 +11,24 @@
 /* distributed barrier service
  *
  * Each client sends a barrier.enter request with (name, nprocs) tuple.
- * The request is cached on the local broker rank, and after a short
- * delay to await concurrent requests, a count is sent upstream
- * via the internal barrier.update request (no response).  Once the
+ * The request is cached on the local broker rank, and a count is sent
+ * upstream via the internal barrier.update request (no response).  Once the
  * count reaches nprocs a barrier.exit event is published.  Upon receiving
  * the barrier.exit event, cached barrier.enter requests on all ranks are
  * answered.
  *
+ * The barrier.update payload is binary: count, nprocs, and owner as
+ * 32-bit integers in network byte order, followed by the NUL-terminated
+ * barrier name.
+ *
+ * If the module is loaded with the "tree" option (on all ranks), the
+ * barrier.update request expects a response, which is sent when the
+ * barrier completes.  Rank 0 then answers the barrier.update requests
+ * of its children instead of publishing barrier.exit, and each rank
+ * answers those of its own children in turn, so completion reaches only
+ * the subtrees that participated in the barrier.  Aborts are still
+ * published as barrier.exit events.
+ *
  * The barrier.exit event contains an errnum field.  If zero, the barrier
  * completed successfully.  If non-zero, the barrier is aborted with an
  * error.  An error may occur if a client tries to enter the barrier twice,
@@ -26,7 +37,10 @@
  * Notes:
  * - Guests may use the barrier service.
  * - Barrier names must be unique, per user, across the instance.
- * - Upon receipt of a barrier.enter or barrier.update request, a timer
+ * - A barrier.enter or barrier.update request is forwarded upstream
+ *   immediately if nothing was forwarded for the barrier within the last
+ *   reduction_timeout, or if the count seen by this rank reaches nprocs,
+ *   i.e. all participants are in this subtree.  Otherwise, a timer
  *   is started to open a short window in time, within which concurrent
  *   requests may be batched.  After expiration, a combined request is
  *   sent upstream.
@@ -43,6 +57,7 @@
 #include <string.h>
 #include <errno.h>
 #include <stdbool.h>
+#include <arpa/inet.h>
 #include <flux/core.h>
 #include <czmq.h>
 
@@ -56,17 +71,28 @@ struct barrier_ctx {
     zhash_t *barriers;
     flux_t *h;
     uint32_t rank;
+    bool tree;
 };
 
 struct barrier {
     char *name;
     int nprocs;
-    int count;
+    int count;              // count not yet forwarded upstream
+    int total;              // count seen by this rank
     zhash_t *clients;
+    zlist_t *updates;       // barrier.update requests awaiting response
+    zlist_t *futures;       // forwarded barrier.update RPCs
     struct barrier_ctx *ctx;
     int errnum;
     flux_watcher_t *timer;
     bool timer_armed;
+    double t_forward;
+    uint32_t owner;
+};
+
+struct update_header {
+    uint32_t count;
+    uint32_t nprocs;
     uint32_t owner;
 };
 
@@ -80,6 +106,8 @@ static void reduction_timeout_cb (flux_reactor_t *r,
                                   int revents,
                                   void *arg);
 
+static void barrier_finish (struct barrier *b, int errnum);
+
 static void barrier_ctx_destroy (struct barrier_ctx *ctx)
 {
     if (ctx) {
@@ -115,6 +143,18 @@ static void barrier_destroy (struct barrier *b)
         int saved_errno = errno;
         flux_log (b->ctx->h, LOG_DEBUG, "destroy %s %d", b->name, b->nprocs);
         zhash_destroy (&b->clients);
+        if (b->updates) {
+            const flux_msg_t *msg;
+            while ((msg = zlist_pop (b->updates)))
+                flux_msg_decref (msg);
+            zlist_destroy (&b->updates);
+        }
+        if (b->futures) {
+            flux_future_t *f;
+            while ((f = zlist_pop (b->futures)))
+                flux_future_destroy (f);
+            zlist_destroy (&b->futures);
+        }
         free (b->name);
         flux_watcher_destroy (b->timer);
         free (b);
@@ -135,7 +175,9 @@ static struct barrier *barrier_create (struct barrier_ctx *ctx,
     if (!(b->name = strdup (name)))
         goto error;
     b->nprocs = nprocs;
-    if (!(b->clients = zhash_new ())) {
+    if (!(b->clients = zhash_new ())
+        || !(b->updates = zlist_new ())
+        || !(b->futures = zlist_new ())) {
         errno = ENOMEM;
         goto error;
     }
@@ -239,73 +281,135 @@ static struct barrier *barrier_lookup_create (struct barrier_ctx *ctx,
     return b;
 }
 
-/* If the count has been reached, terminate the barrier;
- * o/w set timer to pass count upstream and zero it here.
- */
-static int barrier_update (struct barrier *b, int count)
+static void update_continuation (flux_future_t *f, void *arg)
 {
-    b->count += count;
-    if (b->count == b->nprocs) {
-        if (exit_event_send (b->ctx->h, b->name, b->owner, 0) < 0) {
-            flux_log_error (b->ctx->h, "exit_event_send");
-            return -1;
-        }
-    }
-    else if (b->ctx->rank > 0 && !b->timer_armed) {
-        flux_timer_watcher_reset (b->timer, reduction_timeout, 0.);
-        flux_watcher_start (b->timer);
-        b->timer_armed = true;
-    }
-    return 0;
+    struct barrier *b = arg;
+    int errnum = 0;
+
+    if (flux_future_get (f, NULL) < 0)
+        errnum = errno;
+    barrier_finish (b, errnum);
 }
 
 static void send_update_request (flux_t *h, struct barrier *b)
 {
     flux_future_t *f;
+    struct update_header hdr;
+    size_t namelen = strlen (b->name) + 1;
+    size_t len = sizeof (hdr) + namelen;
+    char *buf;
 
-    if (!(f = flux_rpc_pack (h,
-                             "barrier.update",
-                             FLUX_NODEID_UPSTREAM,
-                             FLUX_RPC_NORESPONSE,
-                             "{s:s s:i s:i s:i}",
-                             "name", b->name,
-                             "count", b->count,
-                             "nprocs", b->nprocs,
-                             "owner", b->owner))) {
+    if (!(buf = malloc (len))) {
+        flux_log_error (h, "sending barrier.update request");
+        return;
+    }
+    hdr.count = htonl (b->count);
+    hdr.nprocs = htonl (b->nprocs);
+    hdr.owner = htonl (b->owner);
+    memcpy (buf, &hdr, sizeof (hdr));
+    memcpy (buf + sizeof (hdr), b->name, namelen);
+
+    if (!(f = flux_rpc_raw (h,
+                            "barrier.update",
+                            buf,
+                            len,
+                            FLUX_NODEID_UPSTREAM,
+                            b->ctx->tree ? 0 : FLUX_RPC_NORESPONSE))) {
         flux_log_error (h, "sending barrier.update request");
         goto done;
     }
+    if (b->ctx->tree) {
+        if (flux_future_then (f, -1., update_continuation, b) < 0
+            || zlist_append (b->futures, f) < 0) {
+            flux_log_error (h, "sending barrier.update request");
+            goto done;
+        }
+        f = NULL;
+    }
 done:
     flux_future_destroy (f);
+    free (buf);
+}
+
+/* If the count has been reached, terminate the barrier;
+ * o/w pass count upstream, now or when the timer expires, and zero it here.
+ */
+static int barrier_update (struct barrier *b, int count)
+{
+    flux_reactor_t *r = flux_get_reactor (b->ctx->h);
+
+    b->count += count;
+    b->total += count;
+    if (b->count == b->nprocs && (b->ctx->rank == 0 || !b->ctx->tree)) {
+        if (b->ctx->tree)
+            barrier_finish (b, 0);
+        else if (exit_event_send (b->ctx->h, b->name, b->owner, 0) < 0) {
+            flux_log_error (b->ctx->h, "exit_event_send");
+            return -1;
+        }
+    }
+    else if (b->ctx->rank > 0) {
+        if (b->total == b->nprocs
+            || (!b->timer_armed
+                && flux_reactor_now (r) - b->t_forward >= reduction_timeout)) {
+            flux_watcher_stop (b->timer);
+            b->timer_armed = false;
+            send_update_request (b->ctx->h, b);
+            b->count = 0;
+            b->t_forward = flux_reactor_now (r);
+        }
+        else if (!b->timer_armed) {
+            flux_timer_watcher_reset (b->timer, reduction_timeout, 0.);
+            flux_watcher_start (b->timer);
+            b->timer_armed = true;
+        }
+    }
+    return 0;
 }
 
 /* Handle count update from downstream barrier module.
- * No response is expected.
+ * A response is expected only from a module loaded with "tree".
  */
 static void update_request_cb (flux_t *h, flux_msg_handler_t *mh,
                                const flux_msg_t *msg, void *arg)
 {
     struct barrier_ctx *ctx = arg;
     struct barrier *b;
+    const char *buf;
+    int len;
+    struct update_header hdr;
     const char *name;
-    int count, nprocs;
-    int owner;
 
-    if (flux_request_unpack (msg,
-                             NULL,
-                             "{s:s s:i s:i s:i !}",
-                             "name", &name,
-                             "count", &count,
-                             "nprocs", &nprocs,
-                             "owner", &owner) < 0) {
-        flux_log_error (h, "barrier.update request");
-        return;
+    if (flux_request_decode_raw (msg, NULL, (const void **)&buf, &len) < 0)
+        goto error;
+    if (len <= sizeof (hdr) || buf[len - 1] != '\0') {
+        errno = EPROTO;
+        goto error;
     }
-    if (!(b = barrier_lookup_create (ctx, name, nprocs, owner))) {
+    memcpy (&hdr, buf, sizeof (hdr));
+    name = buf + sizeof (hdr);
+    if (!(b = barrier_lookup_create (ctx,
+                                     name,
+                                     ntohl (hdr.nprocs),
+                                     ntohl (hdr.owner)))) {
         flux_log_error (h, "barrier_lookup_create");
-        return;
+        goto error_respond;
     }
-    barrier_update (b, count);
+    if (!flux_msg_is_noresponse (msg)) {
+        if (zlist_append (b->updates, (void *)flux_msg_incref (msg)) < 0) {
+            flux_msg_decref (msg);
+            errno = ENOMEM;
+            goto error_respond;
+        }
+    }
+    barrier_update (b, ntohl (hdr.count));
+    return;
+error:
+    flux_log_error (h, "barrier.update request");
+error_respond:
+    if (!flux_msg_is_noresponse (msg)
+        && flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "barrier.update: flux_respond_error");
 }
 
 /* Handle client request to enter barrier.
@@ -415,8 +519,6 @@ static void exit_event_cb (flux_t *h, flux_msg_handler_t *mh,
     struct barrier *b;
     const char *name;
     int errnum;
-    const char *key;
-    const flux_msg_t *req;
     int owner;
 
     if (flux_event_unpack (msg, NULL, "{s:s s:i s:i !}",
@@ -426,19 +528,41 @@ static void exit_event_cb (flux_t *h, flux_msg_handler_t *mh,
         flux_log_error (h, "%s: decoding event", __FUNCTION__);
         return;
     }
-    if ((b = barrier_lookup (ctx, name, owner))) {
-        b->errnum = errnum;
-        FOREACH_ZHASH (b->clients, key, req) {
-            int rc;
-            if (b->errnum == 0)
-                rc = flux_respond (h, req, NULL);
-            else
-                rc = flux_respond_error (h, req, b->errnum, NULL);
-            if (rc < 0)
-                flux_log_error (h, "%s: sending enter response", __FUNCTION__);
-        }
-        barrier_delete (ctx, name, owner);
+    if ((b = barrier_lookup (ctx, name, owner)))
+        barrier_finish (b, errnum);
+}
+
+/* Answer cached barrier.enter requests, and barrier.update requests from
+ * downstream, then destroy the barrier.
+ */
+static void barrier_finish (struct barrier *b, int errnum)
+{
+    flux_t *h = b->ctx->h;
+    const char *key;
+    const flux_msg_t *req;
+
+    b->errnum = errnum;
+    FOREACH_ZHASH (b->clients, key, req) {
+        int rc;
+        if (b->errnum == 0)
+            rc = flux_respond (h, req, NULL);
+        else
+            rc = flux_respond_error (h, req, b->errnum, NULL);
+        if (rc < 0)
+            flux_log_error (h, "%s: sending enter response", __FUNCTION__);
     }
+    req = zlist_first (b->updates);
+    while (req) {
+        int rc;
+        if (b->errnum == 0)
+            rc = flux_respond (h, req, NULL);
+        else
+            rc = flux_respond_error (h, req, b->errnum, NULL);
+        if (rc < 0)
+            flux_log_error (h, "%s: sending update response", __FUNCTION__);
+        req = zlist_next (b->updates);
+    }
+    barrier_delete (b->ctx, b->name, b->owner);
 }
 
 static void reduction_timeout_cb (flux_reactor_t *r, flux_watcher_t *w,
@@ -451,9 +575,27 @@ static void reduction_timeout_cb (flux_reactor_t *r, flux_watcher_t *w,
     if (b->count > 0) {
         send_update_request (b->ctx->h, b);
         b->count = 0;
+        b->t_forward = flux_reactor_now (r);
     }
 }
 
+static int parse_args (flux_t *h, struct barrier_ctx *ctx,
+                       int argc, char **argv)
+{
+    int i;
+
+    for (i = 0; i < argc; i++) {
+        if (!strcmp (argv[i], "tree"))
+            ctx->tree = true;
+        else {
+            errno = EINVAL;
+            flux_log_error (h, "%s", argv[i]);
+            return -1;
+        }
+    }
+    return 0;
+}
+
 static struct flux_msg_handler_spec htab[] = {
     {   FLUX_MSGTYPE_REQUEST,
         "barrier.enter",
@@ -488,6 +630,8 @@ int mod_main (flux_t *h, int argc, char **argv)
         flux_log_error (h, "barrier_ctx_create");
         goto done;
     }
+    if (parse_args (h, ctx, argc, argv) < 0)
+        goto done;
     if (flux_event_subscribe (h, "barrier.") < 0) {
         flux_log_error (h, "flux_event_subscribe");
         goto done;
@@ -0,0 +1,531 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* iothread.c - connector-local client I/O thread
+ *
+ * Each thread runs its own reactor, and owns the usock connections of
+ * the clients it was handed.  Requests from the module thread arrive on
+ * 'inq' and notifications for it are posted to 'outq'.  Each queue has
+ * exactly one producer and one consumer, which is what threadq requires.
+ *
+ * A message and its copies made with flux_msg_copy() share the payload,
+ * which caches the decoded json_t, and jansson objects are not thread
+ * safe.  So each queued message is a private copy with its own payload,
+ * owned by the consumer once queued.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <pthread.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <czmq.h>
+#include <flux/core.h>
+
+#include "src/common/librouter/usock.h"
+#include "src/common/librouter/threadq.h"
+
+#include "iothread.h"
+
+#define UUID_STR_LEN 37     // defined in later libuuid headers
+
+enum iomsg_type {
+    IOMSG_CONNECT,  // module -> thread: authenticated client socket
+    IOMSG_SEND,     // module -> thread: message for a client
+    IOMSG_STOP,     // module -> thread: destroy clients and exit
+    IOMSG_ADD,      // thread -> module: client is connected
+    IOMSG_RECV,     // thread -> module: message from a client
+    IOMSG_DEL,      // thread -> module: client is gone ("" = connect failed)
+};
+
+struct iomsg {
+    enum iomsg_type type;
+    char uuid[UUID_STR_LEN];
+    int fd;
+    struct flux_msg_cred cred;
+    flux_msg_t *msg;
+    int errnum;
+};
+
+struct iothread {
+    int id;
+    pthread_t tid;
+    bool started;
+
+    /* I/O thread
+     */
+    flux_reactor_t *r;
+    flux_watcher_t *inq_w;
+    zhashx_t *conns;            // uuid => struct usock_conn
+    bool stopping;
+
+    /* module thread
+     */
+    flux_watcher_t *outq_w;
+    const struct iothread_ops *ops;
+    void *arg;
+    int load;
+
+    struct threadq *inq;
+    struct threadq *outq;
+
+    /* Written by one thread, read by the other, with __atomic builtins.
+     */
+    int hwm;
+    int allow_shmem;
+    struct iothread_stats stats;
+};
+
+static void stat_add (int *val, int n)
+{
+    (void)__atomic_add_fetch (val, n, __ATOMIC_RELAXED);
+}
+
+static void stat_inc (uint64_t *val)
+{
+    (void)__atomic_add_fetch (val, 1, __ATOMIC_RELAXED);
+}
+
+static void iomsg_destroy (struct iomsg *iom)
+{
+    if (iom) {
+        int saved_errno = errno;
+        if (iom->type == IOMSG_CONNECT && iom->fd >= 0)
+            (void)close (iom->fd);
+        flux_msg_destroy (iom->msg);
+        free (iom);
+        errno = saved_errno;
+    }
+}
+
+/* Copy 'msg', including its payload bytes, for the other thread.
+ */
+static flux_msg_t *msg_copy_private (const flux_msg_t *msg)
+{
+    flux_msg_t *cpy;
+    const void *buf;
+    int size;
+
+    if (!(cpy = flux_msg_copy (msg, false)))
+        return NULL;
+    if (flux_msg_has_payload (msg)) {
+        if (flux_msg_get_payload (msg, &buf, &size) < 0
+            || flux_msg_set_payload (cpy, buf, size) < 0) {
+            flux_msg_destroy (cpy);
+            return NULL;
+        }
+    }
+    return cpy;
+}
+
+static struct iomsg *iomsg_create (enum iomsg_type type,
+                                   const char *uuid,
+                                   const flux_msg_t *msg,
+                                   int errnum)
+{
+    struct iomsg *iom;
+
+    if (!(iom = calloc (1, sizeof (*iom))))
+        return NULL;
+    iom->type = type;
+    iom->fd = -1;
+    if (uuid)
+        (void)snprintf (iom->uuid, sizeof (iom->uuid), "%s", uuid);
+    if (msg && !(iom->msg = msg_copy_private (msg))) {
+        free (iom);
+        return NULL;
+    }
+    iom->errnum = errnum;
+    return iom;
+}
+
+/* Queue 'iom'.  Once queued, it belongs to the consumer.
+ */
+static int iomsg_post (struct threadq *q, struct iomsg *iom)
+{
+    if (threadq_push (q, iom) < 0) {
+        iom->fd = -1; // caller keeps the fd on failure
+        iomsg_destroy (iom);
+        return -1;
+    }
+    return 0;
+}
+
+/* Queue a notification or request, with a copy of 'msg', if any.
+ */
+static int iomsg_push (struct threadq *q,
+                       enum iomsg_type type,
+                       const char *uuid,
+                       const flux_msg_t *msg,
+                       int errnum)
+{
+    struct iomsg *iom;
+
+    if (!(iom = iomsg_create (type, uuid, msg, errnum)))
+        return -1;
+    return iomsg_post (q, iom);
+}
+
+/* N.B. The stats below are updated by the I/O thread only.
+ */
+
+static void conn_error (struct usock_conn *conn, int errnum, void *arg)
+{
+    struct iothread *t = arg;
+    const char *uuid = usock_conn_get_uuid (conn);
+
+    (void)iomsg_push (t->outq, IOMSG_DEL, uuid, NULL, errnum);
+    zhashx_delete (t->conns, uuid);
+    usock_conn_destroy (conn);
+    stat_add (&t->stats.connections, -1);
+}
+
+/* Handle local.shmem-attach from the client on this thread,
+ * since the ring fds belong to the connection.
+ */
+static void shmem_attach_request (struct iothread *t,
+                                  struct usock_conn *conn,
+                                  const flux_msg_t *msg)
+{
+    flux_msg_t *rmsg;
+    int errnum = 0;
+
+    if (!__atomic_load_n (&t->allow_shmem, __ATOMIC_RELAXED))
+        errnum = ENOSYS;
+    else if (usock_conn_attach_shmring (conn) < 0)
+        errnum = errno;
+    if (!(rmsg = flux_response_derive (msg, errnum))
+        || usock_conn_send (conn, rmsg) < 0)
+        stat_inc (&t->stats.txdrop);
+    flux_msg_destroy (rmsg);
+}
+
+static void conn_recv (struct usock_conn *conn, flux_msg_t *msg, void *arg)
+{
+    struct iothread *t = arg;
+    const char *topic;
+    int type;
+
+    if (flux_msg_get_type (msg, &type) == 0
+        && type == FLUX_MSGTYPE_REQUEST
+        && flux_msg_get_topic (msg, &topic) == 0
+        && !strcmp (topic, "local.shmem-attach")) {
+        shmem_attach_request (t, conn, msg);
+        return;
+    }
+    if (iomsg_push (t->outq,
+                    IOMSG_RECV,
+                    usock_conn_get_uuid (conn),
+                    msg,
+                    0) == 0)
+        stat_inc (&t->stats.rx);
+}
+
+static void thread_connect (struct iothread *t,
+                            int fd,
+                            const struct flux_msg_cred *cred)
+{
+    struct usock_conn *conn;
+    struct iomsg *iom;
+    const char *uuid;
+
+    if (t->stopping || !(conn = usock_conn_adopt (t->r, fd))) {
+        (void)close (fd);
+        goto error;
+    }
+    uuid = usock_conn_get_uuid (conn);
+    if (zhashx_insert (t->conns, uuid, conn) < 0) {
+        usock_conn_destroy (conn);
+        errno = EEXIST;
+        goto error;
+    }
+    usock_conn_set_hwm (conn, __atomic_load_n (&t->hwm, __ATOMIC_RELAXED));
+    usock_conn_set_error_cb (conn, conn_error, t);
+    usock_conn_set_recv_cb (conn, conn_recv, t);
+    stat_add (&t->stats.connections, 1);
+    stat_inc (&t->stats.connects);
+
+    /* Post ADD before completing the handshake, since a handshake
+     * failure calls conn_error(), which posts DEL.
+     */
+    if (!(iom = iomsg_create (IOMSG_ADD, uuid, NULL, 0))) {
+        conn_error (conn, errno, t);
+        return;
+    }
+    iom->cred = *cred;
+    if (iomsg_post (t->outq, iom) < 0) {
+        conn_error (conn, errno, t);
+        return;
+    }
+    usock_conn_accept (conn, cred);
+    return;
+error:
+    (void)iomsg_push (t->outq, IOMSG_DEL, "", NULL, errno);
+}
+
+static void thread_send (struct iothread *t,
+                         const char *uuid,
+                         const flux_msg_t *msg)
+{
+    struct usock_conn *conn;
+
+    if (!(conn = zhashx_lookup (t->conns, uuid))
+        || usock_conn_send (conn, msg) < 0) {
+        stat_inc (&t->stats.txdrop);
+        return;
+    }
+    stat_inc (&t->stats.tx);
+}
+
+/* Destroy connections without notifying the module thread,
+ * which is shutting down.
+ */
+static void thread_purge (struct iothread *t)
+{
+    struct usock_conn *conn;
+
+    while ((conn = zhashx_first (t->conns))) {
+        zhashx_delete (t->conns, usock_conn_get_uuid (conn));
+        usock_conn_destroy (conn);
+        stat_add (&t->stats.connections, -1);
+    }
+}
+
+static void inq_cb (flux_reactor_t *r,
+                    flux_watcher_t *w,
+                    int revents,
+                    void *arg)
+{
+    struct iothread *t = arg;
+    struct iomsg *iom;
+
+    threadq_clear (t->inq);
+    while ((iom = threadq_pop (t->inq))) {
+        switch (iom->type) {
+            case IOMSG_CONNECT:
+                thread_connect (t, iom->fd, &iom->cred);
+                iom->fd = -1;
+                break;
+            case IOMSG_SEND:
+                thread_send (t, iom->uuid, iom->msg);
+                break;
+            case IOMSG_STOP:
+                t->stopping = true;
+                thread_purge (t);
+                flux_reactor_stop (r);
+                break;
+            default:
+                break;
+        }
+        iomsg_destroy (iom);
+    }
+}
+
+static void outq_cb (flux_reactor_t *r,
+                     flux_watcher_t *w,
+                     int revents,
+                     void *arg)
+{
+    struct iothread *t = arg;
+    struct iomsg *iom;
+
+    threadq_clear (t->outq);
+    while ((iom = threadq_pop (t->outq))) {
+        switch (iom->type) {
+            case IOMSG_ADD:
+                if (t->ops->add)
+                    t->ops->add (t, iom->uuid, &iom->cred, t->arg);
+                break;
+            case IOMSG_RECV:
+                if (t->ops->recv)
+                    t->ops->recv (t, iom->uuid, iom->msg, t->arg);
+                break;
+            case IOMSG_DEL:
+                t->load--;
+                if (strlen (iom->uuid) > 0 && t->ops->del)
+                    t->ops->del (t, iom->uuid, iom->errnum, t->arg);
+                break;
+            default:
+                break;
+        }
+        iomsg_destroy (iom);
+    }
+}
+
+static void *thread_main (void *arg)
+{
+    struct iothread *t = arg;
+
+    if (flux_reactor_run (t->r, 0) < 0)
+        thread_purge (t);
+    return NULL;
+}
+
+int iothread_connect (struct iothread *t,
+                      int fd,
+                      const struct flux_msg_cred *cred)
+{
+    struct iomsg *iom;
+
+    if (!t || fd < 0 || !cred) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!(iom = iomsg_create (IOMSG_CONNECT, NULL, NULL, 0)))
+        return -1;
+    iom->fd = fd;
+    iom->cred = *cred;
+    if (iomsg_post (t->inq, iom) < 0)
+        return -1;
+    t->load++;
+    return 0;
+}
+
+int iothread_send (struct iothread *t,
+                   const char *uuid,
+                   const flux_msg_t *msg)
+{
+    if (!t || !uuid || !msg) {
+        errno = EINVAL;
+        return -1;
+    }
+    return iomsg_push (t->inq, IOMSG_SEND, uuid, msg, 0);
+}
+
+int iothread_load (struct iothread *t)
+{
+    return t ? t->load : 0;
+}
+
+int iothread_get_id (struct iothread *t)
+{
+    return t ? t->id : -1;
+}
+
+void iothread_set_hwm (struct iothread *t, int hwm)
+{
+    if (t)
+        __atomic_store_n (&t->hwm, hwm, __ATOMIC_RELAXED);
+}
+
+void iothread_set_shmem (struct iothread *t, bool allow)
+{
+    if (t)
+        __atomic_store_n (&t->allow_shmem, allow ? 1 : 0, __ATOMIC_RELAXED);
+}
+
+void iothread_get_stats (struct iothread *t, struct iothread_stats *stats)
+{
+    if (t && stats) {
+        stats->connections = __atomic_load_n (&t->stats.connections,
+                                              __ATOMIC_RELAXED);
+        stats->connects = __atomic_load_n (&t->stats.connects,
+                                           __ATOMIC_RELAXED);
+        stats->rx = __atomic_load_n (&t->stats.rx, __ATOMIC_RELAXED);
+        stats->tx = __atomic_load_n (&t->stats.tx, __ATOMIC_RELAXED);
+        stats->txdrop = __atomic_load_n (&t->stats.txdrop, __ATOMIC_RELAXED);
+    }
+}
+
+static void drain (struct threadq *q)
+{
+    struct iomsg *iom;
+
+    while ((iom = threadq_pop (q)))
+        iomsg_destroy (iom);
+}
+
+void iothread_destroy (struct iothread *t)
+{
+    if (t) {
+        int saved_errno = errno;
+        if (t->started) {
+            /* If the thread can't be told to stop, leave it running
+             * with everything it uses.
+             */
+            if (iomsg_push (t->inq, IOMSG_STOP, NULL, NULL, 0) < 0) {
+                (void)pthread_detach (t->tid);
+                flux_watcher_destroy (t->outq_w);
+                errno = saved_errno;
+                return;
+            }
+            (void)pthread_join (t->tid, NULL);
+        }
+        flux_watcher_destroy (t->outq_w);
+        drain (t->outq);
+        drain (t->inq);
+        if (t->conns) {
+            thread_purge (t);
+            zhashx_destroy (&t->conns);
+        }
+        flux_watcher_destroy (t->inq_w);
+        flux_reactor_destroy (t->r);
+        threadq_destroy (t->outq);
+        threadq_destroy (t->inq);
+        free (t);
+        errno = saved_errno;
+    }
+}
+
+struct iothread *iothread_create (flux_reactor_t *r,
+                                  int id,
+                                  const struct iothread_ops *ops,
+                                  void *arg)
+{
+    struct iothread *t;
+    int e;
+
+    if (!r || !ops) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(t = calloc (1, sizeof (*t))))
+        return NULL;
+    t->id = id;
+    t->ops = ops;
+    t->arg = arg;
+    t->allow_shmem = 1;
+    if (!(t->inq = threadq_create ())
+        || !(t->outq = threadq_create ())
+        || !(t->r = flux_reactor_create (0))
+        || !(t->inq_w = flux_fd_watcher_create (t->r,
+                                                threadq_pollfd (t->inq),
+                                                FLUX_POLLIN,
+                                                inq_cb,
+                                                t))
+        || !(t->outq_w = flux_fd_watcher_create (r,
+                                                 threadq_pollfd (t->outq),
+                                                 FLUX_POLLIN,
+                                                 outq_cb,
+                                                 t)))
+        goto error;
+    if (!(t->conns = zhashx_new ())) {
+        errno = ENOMEM;
+        goto error;
+    }
+    flux_watcher_start (t->inq_w);
+    flux_watcher_start (t->outq_w);
+    if ((e = pthread_create (&t->tid, NULL, thread_main, t)) != 0) {
+        errno = e;
+        goto error;
+    }
+    t->started = true;
+    return t;
+error:
+    iothread_destroy (t);
+    return NULL;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,105 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _CONNECTOR_LOCAL_IOTHREAD_H
+#define _CONNECTOR_LOCAL_IOTHREAD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <flux/core.h>
+
+/* iothread - serve a share of connector-local clients' socket I/O
+ * from a dedicated thread with its own reactor.
+ *
+ * The module thread accepts and authenticates new clients, then hands
+ * the socket to an I/O thread with iothread_connect().  From then on the
+ * I/O thread reads, frames, and writes that client's messages.  Traffic
+ * crosses between the threads on a pair of lock-free queues, and the
+ * callbacks below are invoked from the module thread's reactor, so the
+ * router is only ever touched by the module thread.
+ */
+
+struct iothread;
+
+struct iothread_ops {
+    /* Client 'uuid' is ready to exchange messages.
+     */
+    void (*add)(struct iothread *t,
+                const char *uuid,
+                const struct flux_msg_cred *cred,
+                void *arg);
+    /* Client 'uuid' sent 'msg'.  The message is destroyed when the
+     * callback returns.
+     */
+    void (*recv)(struct iothread *t,
+                 const char *uuid,
+                 flux_msg_t *msg,
+                 void *arg);
+    /* Client 'uuid' disconnected or failed with 'errnum'.
+     */
+    void (*del)(struct iothread *t,
+                const char *uuid,
+                int errnum,
+                void *arg);
+};
+
+struct iothread_stats {
+    int connections;    // current clients
+    uint64_t connects;  // clients served since start
+    uint64_t rx;        // messages received from clients
+    uint64_t tx;        // messages queued to clients
+    uint64_t txdrop;    // messages to clients dropped (hwm, disconnected)
+};
+
+/* Start an I/O thread.  'r' is the module thread's reactor, on which
+ * the callbacks in 'ops' are invoked.
+ */
+struct iothread *iothread_create (flux_reactor_t *r,
+                                  int id,
+                                  const struct iothread_ops *ops,
+                                  void *arg);
+
+/* Stop the thread, destroying its clients without calling ops->del,
+ * and wait for it to exit.
+ */
+void iothread_destroy (struct iothread *t);
+
+/* Hand an authenticated client socket to the thread, which takes
+ * ownership of 'fd' and completes the handshake with 'cred'.
+ */
+int iothread_connect (struct iothread *t,
+                      int fd,
+                      const struct flux_msg_cred *cred);
+
+/* Queue a copy of 'msg' for client 'uuid'.
+ */
+int iothread_send (struct iothread *t,
+                   const char *uuid,
+                   const flux_msg_t *msg);
+
+/* Clients handed to this thread that it has not yet reported deleted.
+ * Useful for spreading new clients across threads.
+ */
+int iothread_load (struct iothread *t);
+
+int iothread_get_id (struct iothread *t);
+
+/* Settings applied by the thread to clients as they connect.
+ */
+void iothread_set_hwm (struct iothread *t, int hwm);
+void iothread_set_shmem (struct iothread *t, bool allow);
+
+void iothread_get_stats (struct iothread *t, struct iothread_stats *stats);
+
+#endif /* !_CONNECTOR_LOCAL_IOTHREAD_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
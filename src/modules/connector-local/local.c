@@ -26,6 +26,7 @@
 #include <sys/socket.h>
 #include <ctype.h>
 #include <czmq.h>
+#include <jansson.h>
 #include <inttypes.h>
 #include <flux/core.h>
 
@@ -33,6 +34,8 @@
 #include "src/common/librouter/usock.h"
 #include "src/common/librouter/router.h"
 
+#include "iothread.h"
+
 enum {
     DEBUG_AUTHFAIL_ONESHOT = 1, /* force auth to fail one time */
     DEBUG_OWNERDROP_ONESHOT = 4,/* drop OWNER role to USER on next connection */
@@ -45,9 +48,24 @@ struct connector_local {
     uid_t instance_owner;
     int allow_guest_user;
     int allow_root_owner;
+    int send_hwm;
+    int allow_shmem;
+    int io_threads;
+    struct iothread **threads;  // io_threads entries, if io_threads > 0
+    zhashx_t *proxies;          // uuid => struct proxy, with threads
     flux_msg_handler_t **handlers;
 };
 
+/* With I/O threads, a client's route entry stays on the module thread,
+ * and a 'struct proxy' forwards messages for it to the client's thread.
+ */
+struct proxy {
+    struct iothread *t;
+    struct router_entry *entry;
+    struct flux_msg_cred cred;
+    char *uuid;
+};
+
 /* A 'struct route_entry' is attached to the 'struct usock_conn' aux hash
  * so that when the client is destroyed, its route is also destroyed.
  * This also helps bridge uconn_recv() to router_entry_recv().
@@ -122,12 +140,47 @@ static void uconn_error (struct usock_conn *uconn, int errnum, void *arg)
     usock_conn_destroy (uconn);
 }
 
+/* Handle local.shmem-attach request from client, which carries the
+ * shared memory ring fds.  If successful, the response and all further
+ * traffic with this client go through the rings.  Otherwise the error
+ * response goes through the socket and the client carries on there.
+ */
+static void shmem_attach_request (struct connector_local *ctx,
+                                  struct usock_conn *uconn,
+                                  const flux_msg_t *msg)
+{
+    flux_msg_t *rmsg;
+    int errnum = 0;
+
+    if (!ctx->allow_shmem)
+        errnum = ENOSYS;
+    else if (usock_conn_attach_shmring (uconn) < 0)
+        errnum = errno;
+    if (!(rmsg = flux_response_derive (msg, errnum))
+        || usock_conn_send (uconn, rmsg) < 0) {
+        flux_log_error (ctx->h,
+                        "client=%.5s: error responding to shmem-attach",
+                        usock_conn_get_uuid (uconn));
+    }
+    flux_msg_destroy (rmsg);
+}
+
 /* Usock client sends message to router.
  */
 static void uconn_recv (struct usock_conn *uconn, flux_msg_t *msg, void *arg)
 {
+    struct connector_local *ctx = arg;
     struct router_entry *entry = usock_conn_aux_get (uconn, route_auxkey);
+    const char *topic;
+    int type;
 
+    if (flux_msg_get_type (msg, &type) == 0
+        && type == FLUX_MSGTYPE_REQUEST
+        && flux_msg_get_topic (msg, &topic) == 0
+        && !strcmp (topic, "local.shmem-attach")) {
+        shmem_attach_request (ctx, uconn, msg);
+        return;
+    }
     router_entry_recv (entry, msg);
 }
 
@@ -154,8 +207,150 @@ static int uconn_send (const flux_msg_t *msg, void *arg)
     return usock_conn_send (uconn, msg);
 }
 
+/* Router sends message to a client served by an I/O thread.
+ * The event privacy check is made here, where the router logs its failure,
+ * as it does for uconn_send().
+ */
+static int proxy_send (const flux_msg_t *msg, void *arg)
+{
+    struct proxy *proxy = arg;
+    int type;
+
+    if (flux_msg_get_type (msg, &type) < 0)
+        return -1;
+    if (type == FLUX_MSGTYPE_EVENT
+        && auth_check_event_privacy (msg, &proxy->cred) < 0)
+        return -1;
+    return iothread_send (proxy->t, proxy->uuid, msg);
+}
+
+static void proxy_destroy (struct proxy *proxy)
+{
+    if (proxy) {
+        int saved_errno = errno;
+        router_entry_delete (proxy->entry);
+        free (proxy->uuid);
+        free (proxy);
+        errno = saved_errno;
+    }
+}
+
+// zhashx_destructor_t footprint
+static void proxy_destructor (void **item)
+{
+    if (item) {
+        proxy_destroy (*item);
+        *item = NULL;
+    }
+}
+
+/* I/O thread has completed the handshake with a client.
+ */
+static void thread_add (struct iothread *t,
+                        const char *uuid,
+                        const struct flux_msg_cred *cred,
+                        void *arg)
+{
+    struct connector_local *ctx = arg;
+    struct proxy *proxy;
+
+    if (!(proxy = calloc (1, sizeof (*proxy)))
+        || !(proxy->uuid = strdup (uuid)))
+        goto error;
+    proxy->t = t;
+    proxy->cred = *cred;
+    if (!(proxy->entry = router_entry_add (ctx->router,
+                                           uuid,
+                                           proxy_send,
+                                           proxy)))
+        goto error;
+    if (zhashx_insert (ctx->proxies, uuid, proxy) < 0) {
+        errno = EEXIST;
+        goto error;
+    }
+    return;
+error:
+    flux_log_error (ctx->h, "client=%.5s: error adding route", uuid);
+    proxy_destroy (proxy);
+}
+
+/* I/O thread received a message from a client.
+ */
+static void thread_recv (struct iothread *t,
+                         const char *uuid,
+                         flux_msg_t *msg,
+                         void *arg)
+{
+    struct connector_local *ctx = arg;
+    struct proxy *proxy;
+
+    if ((proxy = zhashx_lookup (ctx->proxies, uuid)))
+        router_entry_recv (proxy->entry, msg);
+}
+
+/* I/O thread lost a client.  Log errors like uconn_error().
+ */
+static void thread_del (struct iothread *t,
+                        const char *uuid,
+                        int errnum,
+                        void *arg)
+{
+    struct connector_local *ctx = arg;
+    struct proxy *proxy;
+
+    if (!(proxy = zhashx_lookup (ctx->proxies, uuid)))
+        return;
+    if (errnum != 0
+        && errnum != EPIPE
+        && errnum != EPROTO
+        && errnum != ECONNRESET) {
+        errno = errnum;
+        flux_log_error (ctx->h,
+                        "client=%.5s userid=%u",
+                        uuid,
+                        (unsigned int)proxy->cred.userid);
+    }
+    zhashx_delete (ctx->proxies, uuid);
+}
+
+static const struct iothread_ops thread_ops = {
+    .add = thread_add,
+    .recv = thread_recv,
+    .del = thread_del,
+};
+
+/* Hand an authenticated client to the I/O thread with the fewest clients.
+ * The thread completes the handshake.
+ */
+static void handoff (struct connector_local *ctx,
+                     struct usock_conn *uconn,
+                     const struct flux_msg_cred *cred)
+{
+    struct iothread *t = ctx->threads[0];
+    int fd;
+    int i;
+
+    for (i = 1; i < ctx->io_threads; i++) {
+        if (iothread_load (ctx->threads[i]) < iothread_load (t))
+            t = ctx->threads[i];
+    }
+    if ((fd = usock_conn_release (uconn)) < 0
+        || iothread_connect (t, fd, cred) < 0) {
+        flux_log_error (ctx->h,
+                        "client=%.5s: error handing off to I/O thread",
+                        usock_conn_get_uuid (uconn));
+        usock_conn_reject (uconn, errno);
+        usock_conn_destroy (uconn);
+        if (fd >= 0)
+            (void)close (fd);
+        return;
+    }
+    usock_conn_destroy (uconn);
+}
+
 /* Accept a connection from new client.
- * This function must call usock_conn_accept() or usock_conn_reject().
+ * This function must call usock_conn_accept() or usock_conn_reject(),
+ * or hand the connection off to an I/O thread, which accepts it.
  */
 static void acceptor_cb (struct usock_conn *uconn, void *arg)
 {
@@ -169,6 +364,10 @@ static void acceptor_cb (struct usock_conn *uconn, void *arg)
                              initial_cred->userid,
                              &cred) < 0)
         goto error;
+    if (ctx->threads) {
+        handoff (ctx, uconn, &cred);
+        return;
+    }
     if (!(entry = router_entry_add (ctx->router,
                                     usock_conn_get_uuid (uconn),
                                     uconn_send,
@@ -181,6 +380,7 @@ static void acceptor_cb (struct usock_conn *uconn, void *arg)
         router_entry_delete (entry);
         goto error;
     }
+    usock_conn_set_hwm (uconn, ctx->send_hwm);
     usock_conn_set_error_cb (uconn, uconn_error, ctx);
     usock_conn_set_recv_cb (uconn, uconn_recv, ctx);
     usock_conn_accept (uconn, &cred);
@@ -201,6 +401,25 @@ error:
  *
  * Missing [access] keys are interpreted as false.
  * [access] keys other than the above are not allowed.
+ *
+ * Also parse [connector-local] table:
+ *
+ * send-hwm = N
+ *   Limit each client's output queue to N messages.  A client whose queue
+ *   overflows is disconnected with ENOBUFS (logged), so that it sees an
+ *   error instead of waiting for a response that was dropped.
+ *   A value of 0 (the default) means unlimited.  A new value applies to
+ *   clients that connect after it is set.
+ *
+ * shmem = false
+ *   Refuse client requests to switch to shared memory rings.
+ *
+ * io-threads = N
+ *   Serve client socket I/O from N threads, each with its own reactor.
+ *   Connections are accepted and authenticated by the module thread, then
+ *   spread across the I/O threads.  A value of 0 (the default) serves all
+ *   clients from the module thread.  The value is read when the module
+ *   is loaded; a new value takes effect the next time it is loaded.
  */
 int parse_config (struct connector_local *ctx,
                   const flux_conf_t *conf,
@@ -210,6 +429,10 @@ int parse_config (struct connector_local *ctx,
     flux_conf_error_t error;
     int allow_guest_user = 0;
     int allow_root_owner = 0;
+    int send_hwm = 0;
+    int allow_shmem = 1;
+    int io_threads = 0;
+    int i;
 
     if (flux_conf_unpack (conf,
                           &error,
@@ -225,6 +448,50 @@ int parse_config (struct connector_local *ctx,
                         error.errbuf);
         return -1;
     }
+    if (flux_conf_unpack (conf,
+                          &error,
+                          "{s?:{s?:i s?:b s?:i !}}",
+                          "connector-local",
+                            "send-hwm",
+                            &send_hwm,
+                            "shmem",
+                            &allow_shmem,
+                            "io-threads",
+                            &io_threads) < 0) {
+        (void)snprintf (errbuf,
+                        errbufsize,
+                        "error parsing [connector-local] configuration: %s",
+                        error.errbuf);
+        return -1;
+    }
+    if (send_hwm < 0) {
+        (void)snprintf (errbuf,
+                        errbufsize,
+                        "[connector-local] send-hwm must be >= 0");
+        errno = EINVAL;
+        return -1;
+    }
+    if (io_threads < 0) {
+        (void)snprintf (errbuf,
+                        errbufsize,
+                        "[connector-local] io-threads must be >= 0");
+        errno = EINVAL;
+        return -1;
+    }
+    ctx->send_hwm = send_hwm;
+    ctx->allow_shmem = allow_shmem;
+    if (!ctx->threads)
+        ctx->io_threads = io_threads;
+    else if (io_threads != ctx->io_threads) {
+        flux_log (ctx->h,
+                  LOG_INFO,
+                  "io-threads=%d takes effect when module is reloaded",
+                  io_threads);
+    }
+    for (i = 0; ctx->threads && i < ctx->io_threads; i++) {
+        iothread_set_hwm (ctx->threads[i], ctx->send_hwm);
+        iothread_set_shmem (ctx->threads[i], ctx->allow_shmem);
+    }
     ctx->allow_guest_user = allow_guest_user;
     ctx->allow_root_owner = allow_root_owner;
     flux_log (ctx->h,
@@ -235,6 +502,12 @@ int parse_config (struct connector_local *ctx,
               LOG_DEBUG,
               "allow-root-owner=%s",
               ctx->allow_root_owner ? "true" : "false");
+    flux_log (ctx->h, LOG_DEBUG, "send-hwm=%d", ctx->send_hwm);
+    flux_log (ctx->h,
+              LOG_DEBUG,
+              "shmem=%s",
+              ctx->allow_shmem ? "true" : "false");
+    flux_log (ctx->h, LOG_DEBUG, "io-threads=%d", ctx->io_threads);
     return 0;
 }
 
@@ -266,8 +539,64 @@ error:
         flux_log_error (h, "error responding to config-reload request");
 }
 
+/* Respond with the module's message counters, as the default handler
+ * does, plus the counters of each I/O thread.
+ */
+static void stats_cb (flux_t *h,
+                      flux_msg_handler_t *mh,
+                      const flux_msg_t *msg,
+                      void *arg)
+{
+    struct connector_local *ctx = arg;
+    flux_msgcounters_t mcs;
+    json_t *threads;
+    int i;
+
+    if (!(threads = json_array ()))
+        goto nomem;
+    for (i = 0; ctx->threads && i < ctx->io_threads; i++) {
+        struct iothread_stats st;
+        json_t *o;
+
+        iothread_get_stats (ctx->threads[i], &st);
+        if (!(o = json_pack ("{s:i s:i s:I s:I s:I s:I}",
+                             "id", iothread_get_id (ctx->threads[i]),
+                             "connections", st.connections,
+                             "connects", (json_int_t)st.connects,
+                             "rx", (json_int_t)st.rx,
+                             "tx", (json_int_t)st.tx,
+                             "txdrop", (json_int_t)st.txdrop))
+            || json_array_append_new (threads, o) < 0) {
+            json_decref (o);
+            goto nomem;
+        }
+    }
+    flux_get_msgcounters (h, &mcs);
+    if (flux_respond_pack (h,
+                           msg,
+                           "{s:i s:i s:i s:i s:i s:i s:i s:i s:O}",
+                           "#request (tx)", mcs.request_tx,
+                           "#request (rx)", mcs.request_rx,
+                           "#response (tx)", mcs.response_tx,
+                           "#response (rx)", mcs.response_rx,
+                           "#event (tx)", mcs.event_tx,
+                           "#event (rx)", mcs.event_rx,
+                           "#keepalive (tx)", mcs.keepalive_tx,
+                           "#keepalive (rx)", mcs.keepalive_rx,
+                           "io-threads", threads) < 0)
+        flux_log_error (h, "error responding to stats-get request");
+    json_decref (threads);
+    return;
+nomem:
+    errno = ENOMEM;
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "error responding to stats-get request");
+    json_decref (threads);
+}
+
 static const struct flux_msg_handler_spec htab[] = {
     { FLUX_MSGTYPE_REQUEST,  "connector-local.config-reload", reload_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST,  "connector-local.stats.get", stats_cb, 0 },
     FLUX_MSGHANDLER_TABLE_END,
 };
 
@@ -319,6 +648,34 @@ int mod_main (flux_t *h, int argc, char **argv)
     cleanup_push_string (cleanup_file, sockpath);
     usock_server_set_acceptor (ctx.server, acceptor_cb, &ctx);
 
+    /* Start I/O threads, if configured
+     */
+    if (ctx.io_threads > 0) {
+        int i;
+        if (!(ctx.proxies = zhashx_new ())) {
+            errno = ENOMEM;
+            flux_log_error (h, "zhashx_new");
+            goto done;
+        }
+        zhashx_set_destructor (ctx.proxies, proxy_destructor);
+        if (!(ctx.threads = calloc (ctx.io_threads,
+                                    sizeof (ctx.threads[0])))) {
+            flux_log_error (h, "error allocating I/O threads");
+            goto done;
+        }
+        for (i = 0; i < ctx.io_threads; i++) {
+            if (!(ctx.threads[i] = iothread_create (flux_get_reactor (h),
+                                                    i,
+                                                    &thread_ops,
+                                                    &ctx))) {
+                flux_log_error (h, "error starting I/O thread");
+                goto done;
+            }
+            iothread_set_hwm (ctx.threads[i], ctx.send_hwm);
+            iothread_set_shmem (ctx.threads[i], ctx.allow_shmem);
+        }
+    }
+
     if (flux_msg_handler_addvec (h, htab, &ctx, &ctx.handlers) < 0)
         goto done;
 
@@ -333,6 +690,13 @@ int mod_main (flux_t *h, int argc, char **argv)
     rc = 0;
 done:
     flux_msg_handler_delvec (ctx.handlers);
+    if (ctx.threads) {
+        int i;
+        for (i = 0; i < ctx.io_threads; i++)
+            iothread_destroy (ctx.threads[i]);
+        free (ctx.threads);
+    }
+    zhashx_destroy (&ctx.proxies); // destroy before router
     usock_server_destroy (ctx.server); // destroy before router
     router_destroy (ctx.router);
     return rc;
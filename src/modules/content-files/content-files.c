@@ -11,11 +11,17 @@
 /* content-files.c - content addressable storage with files back end
  *
  * This is mainly for demo/experimentation purposes.
- * The "store" is a flat directory with blobrefs as filenames.
- * As such, it is hungry for inodes and may run the file system out of them
- * if used in anger!
+ * The "store" is a directory with blobrefs as filenames, spread over
+ * hashed subdirectories (see filedb.c).  As such, it is hungry for inodes
+ * and may run the file system out of them if used in anger!
  *
- * There are four main operations (RPC handlers):
+ * The content-backing requests are handled on a pool of worker threads
+ * (see flux_module_set_workers(3)), so the module thread only forwards
+ * them and a slow file system does not stall the reactor.  The handlers
+ * only read the shared module context.  Set workers=0 to handle all
+ * requests in the module thread.
+ *
+ * There are seven main operations (RPC handlers):
  *
  * content-backing.load:
  * Given a blobref, lookup blob and return it or a "not found" error.
@@ -23,6 +29,12 @@
  * content-backing.store:
  * Given a blob, store it and return its blobref
  *
+ * content-backing.load-batch, content-backing.store-batch:
+ * As above, for a batch of blobs in one message.
+ *
+ * content-backing.has:
+ * Given a batch of blobrefs, report which blobs are stored.
+ *
  * kvs-checkpoint.get:
  * Given a string key, lookup string value and return it or a "not found" error.
  *
@@ -55,16 +67,21 @@
 
 #include "src/common/libutil/blobref.h"
 #include "src/common/libutil/log.h"
+#include "src/common/libutil/blobbatch.h"
 
 #include "src/common/libcontent/content-util.h"
 
 #include "filedb.h"
 
+#define DEFAULT_WORKERS 4
+
 struct content_files {
     flux_msg_handler_t **handlers;
+    flux_msg_handler_t **backing_handlers;
     char *dbpath;
     flux_t *h;
     const char *hashfun;
+    int workers;
 };
 
 /* Handle a content-backing.load request from the rank 0 broker's
@@ -141,6 +158,174 @@ error:
         flux_log_error (h, "error responding to store request");
 }
 
+/* Handle a content-backing.load-batch request.  The raw request payload
+ * is a batch of blobref strings, and the raw response payload a batch of
+ * blobs in the same order (see blobbatch.h).  A blob that could not be
+ * loaded is recorded as an error in its place in the response.
+ */
+static void load_batch_cb (flux_t *h,
+                           flux_msg_handler_t *mh,
+                           const flux_msg_t *msg,
+                           void *arg)
+{
+    struct content_files *ctx = arg;
+    const void *buf;
+    int len;
+    struct blobbatch *req = NULL;
+    struct blobbatch *rsp = NULL;
+    const char *errstr = NULL;
+    int i;
+
+    if (flux_request_decode_raw (msg, NULL, &buf, &len) < 0)
+        goto error;
+    if (!(req = blobbatch_decode (buf, len))) {
+        errstr = "malformed batch";
+        goto error;
+    }
+    if (!(rsp = blobbatch_create ()))
+        goto error;
+    for (i = 0; i < blobbatch_count (req); i++) {
+        const char *blobref;
+        void *data = NULL;
+        size_t size;
+        int rc;
+
+        if (!(blobref = blobbatch_get_string (req, i))
+            || blobref_validate (blobref) < 0) {
+            rc = blobbatch_append_error (rsp, EPROTO);
+        }
+        else if (filedb_get (ctx->dbpath, blobref, &data, &size, NULL) < 0)
+            rc = blobbatch_append_error (rsp, errno);
+        else
+            rc = blobbatch_append (rsp, data, size);
+        free (data);
+        if (rc < 0)
+            goto error;
+    }
+    blobbatch_encode (rsp, &buf, &len);
+    if (flux_respond_raw (h, msg, buf, len) < 0)
+        flux_log_error (h, "error responding to load-batch request");
+    blobbatch_destroy (req);
+    blobbatch_destroy (rsp);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, errstr) < 0)
+        flux_log_error (h, "error responding to load-batch request");
+    blobbatch_destroy (req);
+    blobbatch_destroy (rsp);
+}
+
+/* Handle a content-backing.has request.  The raw request payload is a
+ * batch of blobref strings, and the raw response payload a batch in the
+ * same order, with an empty item for each blob that is stored and an
+ * error (ENOENT) for each that is not.
+ */
+static void has_cb (flux_t *h,
+                    flux_msg_handler_t *mh,
+                    const flux_msg_t *msg,
+                    void *arg)
+{
+    struct content_files *ctx = arg;
+    const void *buf;
+    int len;
+    struct blobbatch *req = NULL;
+    struct blobbatch *rsp = NULL;
+    const char *errstr = NULL;
+    int i;
+
+    if (flux_request_decode_raw (msg, NULL, &buf, &len) < 0)
+        goto error;
+    if (!(req = blobbatch_decode (buf, len))) {
+        errstr = "malformed batch";
+        goto error;
+    }
+    if (!(rsp = blobbatch_create ()))
+        goto error;
+    for (i = 0; i < blobbatch_count (req); i++) {
+        const char *blobref;
+        int rc;
+
+        if (!(blobref = blobbatch_get_string (req, i))
+            || blobref_validate (blobref) < 0) {
+            rc = blobbatch_append_error (rsp, EPROTO);
+        }
+        else if (filedb_has (ctx->dbpath, blobref, NULL) < 0)
+            rc = blobbatch_append_error (rsp, errno);
+        else
+            rc = blobbatch_append (rsp, NULL, 0);
+        if (rc < 0)
+            goto error;
+    }
+    blobbatch_encode (rsp, &buf, &len);
+    if (flux_respond_raw (h, msg, buf, len) < 0)
+        flux_log_error (h, "error responding to has request");
+    blobbatch_destroy (req);
+    blobbatch_destroy (rsp);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, errstr) < 0)
+        flux_log_error (h, "error responding to has request");
+    blobbatch_destroy (req);
+    blobbatch_destroy (rsp);
+}
+
+/* Handle a content-backing.store-batch request.  The raw request payload
+ * is a batch of blobs, and the raw response payload a batch of blobref
+ * strings in the same order.
+ */
+static void store_batch_cb (flux_t *h,
+                            flux_msg_handler_t *mh,
+                            const flux_msg_t *msg,
+                            void *arg)
+{
+    struct content_files *ctx = arg;
+    const void *buf;
+    int len;
+    struct blobbatch *req = NULL;
+    struct blobbatch *rsp = NULL;
+    const char *errstr = NULL;
+    int i;
+
+    if (flux_request_decode_raw (msg, NULL, &buf, &len) < 0)
+        goto error;
+    if (!(req = blobbatch_decode (buf, len))) {
+        errstr = "malformed batch";
+        goto error;
+    }
+    if (!(rsp = blobbatch_create ()))
+        goto error;
+    for (i = 0; i < blobbatch_count (req); i++) {
+        const void *data;
+        int size;
+        char blobref[BLOBREF_MAX_STRING_SIZE];
+        int rc;
+
+        if (blobbatch_get (req, i, &data, &size) < 0
+            || blobref_hash (ctx->hashfun,
+                             (uint8_t *)data,
+                             size,
+                             blobref,
+                             sizeof (blobref)) < 0
+            || filedb_put (ctx->dbpath, blobref, data, size, NULL) < 0)
+            rc = blobbatch_append_error (rsp, errno);
+        else
+            rc = blobbatch_append (rsp, blobref, strlen (blobref) + 1);
+        if (rc < 0)
+            goto error;
+    }
+    blobbatch_encode (rsp, &buf, &len);
+    if (flux_respond_raw (h, msg, buf, len) < 0)
+        flux_log_error (h, "error responding to store-batch request");
+    blobbatch_destroy (req);
+    blobbatch_destroy (rsp);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, errstr) < 0)
+        flux_log_error (h, "error responding to store-batch request");
+    blobbatch_destroy (req);
+    blobbatch_destroy (rsp);
+}
+
 /* Handle a kvs-checkpoint.get request from the rank 0 kvs module.
  * The KVS stores its last root reference here for restart purposes.
  *
@@ -215,26 +400,57 @@ static void content_files_destroy (struct content_files *ctx)
     if (ctx) {
         int saved_errno = errno;
         flux_msg_handler_delvec (ctx->handlers);
+        flux_msg_handler_delvec (ctx->backing_handlers);
         free (ctx->dbpath);
         free (ctx);
         errno = saved_errno;
     }
 }
 
-/* Table of message handler callbacks registered below.
+/* Tables of message handler callbacks registered below.
  * The topic strings in the table consist of <service name>.<method>.
+ * The backing_htab handlers run in the worker threads, if any.
  */
-static const struct flux_msg_handler_spec htab[] = {
+static const struct flux_msg_handler_spec backing_htab[] = {
     { FLUX_MSGTYPE_REQUEST, "content-backing.load",    load_cb, 0 },
     { FLUX_MSGTYPE_REQUEST, "content-backing.store",   store_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST, "content-backing.load-batch", load_batch_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST, "content-backing.store-batch", store_batch_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST, "content-backing.has", has_cb, 0 },
+    FLUX_MSGHANDLER_TABLE_END,
+};
+
+static const struct flux_msg_handler_spec htab[] = {
     { FLUX_MSGTYPE_REQUEST, "kvs-checkpoint.get", checkpoint_get_cb, 0 },
     { FLUX_MSGTYPE_REQUEST, "kvs-checkpoint.put", checkpoint_put_cb, 0 },
     FLUX_MSGHANDLER_TABLE_END,
 };
 
+/* Worker thread main for flux_module_set_workers().
+ */
+static int worker_main (flux_t *h, int index, void *arg)
+{
+    struct content_files *ctx = arg;
+    flux_msg_handler_t **handlers = NULL;
+    int rc = -1;
+
+    if (flux_msg_handler_addvec (h, backing_htab, ctx, &handlers) < 0) {
+        flux_log_error (h, "flux_msg_handler_addvec");
+        return -1;
+    }
+    if (flux_reactor_run (flux_get_reactor (h), 0) < 0) {
+        flux_log_error (h, "flux_reactor_run");
+        goto done;
+    }
+    rc = 0;
+done:
+    flux_msg_handler_delvec (handlers);
+    return rc;
+}
+
 /* Create module context and perform some initialization.
  */
-static struct content_files *content_files_create (flux_t *h)
+static struct content_files *content_files_create (flux_t *h, int workers)
 {
     struct content_files *ctx;
     const char *backing_path;
@@ -242,6 +458,7 @@ static struct content_files *content_files_create (flux_t *h)
     if (!(ctx = calloc (1, sizeof (*ctx))))
         return NULL;
     ctx->h = h;
+    ctx->workers = workers;
 
     /* Some tunables:
      * - the hash function, e.g. sha1, sha256
@@ -282,18 +499,43 @@ static struct content_files *content_files_create (flux_t *h)
     }
     if (flux_msg_handler_addvec (h, htab, ctx, &ctx->handlers) < 0)
         goto error;
+    if (ctx->workers == 0) {
+        if (flux_msg_handler_addvec (h,
+                                     backing_htab,
+                                     ctx,
+                                     &ctx->backing_handlers) < 0)
+            goto error;
+    }
     return ctx;
 error:
     content_files_destroy (ctx);
     return NULL;
 }
 
-static int parse_args (flux_t *h, int argc, char **argv, bool *testing)
+static int parse_args (flux_t *h,
+                       int argc,
+                       char **argv,
+                       bool *testing,
+                       int *workers)
 {
     int i;
     for (i = 0; i < argc; i++) {
         if (!strcmp (argv[i], "testing"))
             *testing = true;
+        else if (!strncmp (argv[i], "workers=", 8)) {
+            char *endptr;
+            long n;
+
+            errno = 0;
+            n = strtol (argv[i] + 8, &endptr, 10);
+            if (errno != 0 || *endptr != '\0' || endptr == argv[i] + 8
+                || n < 0 || n > 256) {
+                errno = EINVAL;
+                flux_log_error (h, "%s", argv[i]);
+                return -1;
+            }
+            *workers = n;
+        }
         else {
             errno = EINVAL;
             flux_log_error (h, "%s", argv[i]);
@@ -319,14 +561,39 @@ int mod_main (flux_t *h, int argc, char **argv)
 {
     struct content_files *ctx;
     bool testing = false;
+    int workers = DEFAULT_WORKERS;
     int rc = -1;
 
-    if (parse_args (h, argc, argv, &testing) < 0)
+    if (parse_args (h, argc, argv, &testing, &workers) < 0)
         return -1;
-    if (!(ctx = content_files_create (h))) {
+    if (!(ctx = content_files_create (h, workers))) {
         flux_log_error (h, "content_files_create failed");
         return -1;
     }
+    /* The workers are joined when the module handle is closed, after
+     * mod_main() returns, so the context they share must live until then.
+     * Handle aux items are destroyed in reverse order of creation, so
+     * setting it before the workers are started ensures they are joined
+     * before it is destroyed.
+     */
+    if (flux_aux_set (h,
+                      "content-files",
+                      ctx,
+                      (flux_free_f)content_files_destroy) < 0) {
+        content_files_destroy (ctx);
+        return -1;
+    }
+    if (ctx->workers > 0) {
+        if (flux_module_set_workers (h,
+                                     ctx->workers,
+                                     "content-backing.*",
+                                     NULL,
+                                     worker_main,
+                                     ctx) < 0) {
+            flux_log_error (h, "flux_module_set_workers");
+            return -1;
+        }
+    }
     if (!testing) {
         if (content_register_backing_store (h, "content-files") < 0)
             goto done;
@@ -346,7 +613,6 @@ int mod_main (flux_t *h, int argc, char **argv)
 
     rc = 0;
 done:
-    content_files_destroy (ctx);
     return rc;
 }
 
@@ -19,6 +19,8 @@
 #include <string.h>
 #include <errno.h>
 #include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
 
 #include "src/common/libutil/read_all.h"
 #include "src/common/libutil/errno_safe.h"
@@ -26,16 +28,34 @@
 #include "filedb.h"
 
 
-int filedb_get (const char *dbpath,
-                const char *key,
-                void **datap,
-                size_t *sizep,
-                const char **errstr)
+/* Files are spread over two levels of 256 subdirectories, named for the
+ * first two bytes of a hash of the key, so that no directory grows large
+ * enough to slow down lookups.  Files stored by earlier versions directly
+ * in the dbpath directory are still found by filedb_get() and filedb_has().
+ */
+static uint32_t key_hash (const char *key)
 {
-    char path[1024];
-    int fd;
-    void *data;
-    ssize_t size;
+    uint32_t h = 2166136261u; // FNV-1a
+
+    while (*key) {
+        h ^= (unsigned char)*key++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/* Build the path to 'key' in 'path', in the fan-out layout, or if 'flat'
+ * is true, directly in dbpath.
+ */
+static int key_path (const char *dbpath,
+                     const char *key,
+                     bool flat,
+                     char *path,
+                     size_t size,
+                     const char **errstr)
+{
+    uint32_t h;
+    int n;
 
     if (strlen (key) == 0 || strchr (key, '/') || !strcmp (key, "..")
                           || !strcmp (key, ".")) {
@@ -44,14 +64,72 @@ int filedb_get (const char *dbpath,
             *errstr = "invalid key name";
         return -1;
     }
-    if (snprintf (path, sizeof (path), "%s/%s", dbpath, key) >= sizeof (path)) {
+    if (flat)
+        n = snprintf (path, size, "%s/%s", dbpath, key);
+    else {
+        h = key_hash (key);
+        n = snprintf (path,
+                      size,
+                      "%s/%02x/%02x/%s",
+                      dbpath,
+                      (unsigned int)(h >> 24),
+                      (unsigned int)((h >> 16) & 0xff),
+                      key);
+    }
+    if (n >= size) {
         errno = EOVERFLOW;
         if (errstr)
             *errstr = "key name too long for internal buffer";
         return -1;
     }
-    if ((fd = open (path, O_RDONLY)) < 0)
+    return 0;
+}
+
+/* Create the fan-out directories for 'key'.  The file name component of
+ * 'path', as built by key_path(), is temporarily truncated.
+ */
+static int make_dirs (char *path)
+{
+    char *top;
+    char *leaf;
+
+    if (!(leaf = strrchr (path, '/')))
+        return -1;
+    *leaf = '\0';
+    top = strrchr (path, '/');
+    *top = '\0';
+    if (mkdir (path, 0700) < 0 && errno != EEXIST)
+        goto error;
+    *top = '/';
+    if (mkdir (path, 0700) < 0 && errno != EEXIST)
+        goto error;
+    *leaf = '/';
+    return 0;
+error:
+    *top = '/';
+    *leaf = '/';
+    return -1;
+}
+
+int filedb_get (const char *dbpath,
+                const char *key,
+                void **datap,
+                size_t *sizep,
+                const char **errstr)
+{
+    char path[1024];
+    int fd;
+    void *data;
+    ssize_t size;
+
+    if (key_path (dbpath, key, false, path, sizeof (path), errstr) < 0)
         return -1;
+    if ((fd = open (path, O_RDONLY)) < 0) {
+        if (errno != ENOENT
+            || key_path (dbpath, key, true, path, sizeof (path), errstr) < 0
+            || (fd = open (path, O_RDONLY)) < 0)
+            return -1;
+    }
     if ((size = read_all (fd, &data)) < 0) {
         ERRNO_SAFE_WRAP (close, fd);
         return -1;
@@ -65,6 +143,30 @@ int filedb_get (const char *dbpath,
     return 0;
 }
 
+int filedb_has (const char *dbpath, const char *key, const char **errstr)
+{
+    char path[1024];
+    struct stat sb;
+
+    if (key_path (dbpath, key, false, path, sizeof (path), errstr) < 0)
+        return -1;
+    if (stat (path, &sb) < 0) {
+        if (errno != ENOENT
+            || key_path (dbpath, key, true, path, sizeof (path), errstr) < 0
+            || stat (path, &sb) < 0)
+            return -1;
+    }
+    if (!S_ISREG (sb.st_mode)) {
+        errno = ENOENT;
+        return -1;
+    }
+    return 0;
+}
+
+/* Write to a temporary file and rename it into place, so that a reader
+ * never sees a partially written file, even while another thread is
+ * storing the same key.
+ */
 int filedb_put (const char *dbpath,
                 const char *key,
                 const void *data,
@@ -72,30 +174,31 @@ int filedb_put (const char *dbpath,
                 const char **errstr)
 {
     char path[1024];
+    char tmp[1024 + 16];
     int fd;
 
-    if (strlen (key) == 0 || strchr (key, '/') || !strcmp (key, "..")
-                          || !strcmp (key, ".")) {
-        errno = EINVAL;
-        if (errstr)
-            *errstr = "invalid key";
+    if (key_path (dbpath, key, false, path, sizeof (path), errstr) < 0)
         return -1;
+    (void)snprintf (tmp, sizeof (tmp), "%s.XXXXXX", path);
+    if ((fd = mkstemp (tmp)) < 0) {
+        if (errno != ENOENT || make_dirs (path) < 0)
+            return -1;
+        (void)snprintf (tmp, sizeof (tmp), "%s.XXXXXX", path);
+        if ((fd = mkstemp (tmp)) < 0)
+            return -1;
     }
-    if (snprintf (path, sizeof (path), "%s/%s", dbpath, key) >= sizeof (path)) {
-        errno = EOVERFLOW;
-        if (errstr)
-            *errstr = "key name too long for internal buffer";
-        return -1;
-    }
-    if ((fd = open (path, O_WRONLY | O_CREAT, 0666)) < 0)
-        return -1;
     if (write_all (fd, data, size) < 0) {
         ERRNO_SAFE_WRAP (close, fd);
-        return -1;
+        goto error;
     }
     if (close (fd) < 0)
-        return -1;
+        goto error;
+    if (rename (tmp, path) < 0)
+        goto error;
     return 0;
+error:
+    ERRNO_SAFE_WRAP (unlink, tmp);
+    return -1;
 }
 
 /*
@@ -24,9 +24,17 @@ int filedb_get (const char *dbpath,
                 size_t *sizep,
                 const char **errstr);
 
+/* Check whether file named 'key' exists in the dbpath directory.
+ * Returns 0 if it does, -1 with errno set (ENOENT if it does not).
+ * Pass '*errstr' in pre-set to NULL and if a human readable error message
+ * is appropriate, it is assigned on error (do not free).
+ */
+int filedb_has (const char *dbpath, const char *key, const char **errstr);
 
 /* Put file named 'key' with content 'data' and length 'size' to the
- * dbpath directory.  On success, 0 is returned.
+ * dbpath directory, replacing any existing file atomically.  Files are
+ * placed in hashed subdirectories of dbpath, which are created as needed.
+ * It is safe to call this from multiple threads.  On success, 0 is returned.
  * On failure, -1 is returned with errno set.
  * Pass '*errstr' in pre-set to NULL and if a human readable error message
  * is appropriate, it is assigned on error (do not free).
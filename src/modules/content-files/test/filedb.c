@@ -15,6 +15,10 @@
 #include <stdio.h>
 #include <string.h>
 #include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
 
 #include "src/common/libtap/tap.h"
 #include "src/modules/content-files/filedb.h"
@@ -52,6 +56,19 @@ void test_badargs (const char *dbpath)
         && errno == ENOENT,
         "filedb_get key=\"\" failed with ENOENT");
 
+    /* has */
+
+    errno = 0;
+    errstr = NULL;
+    ok (filedb_has (dbpath, "..", &errstr) < 0 && errno == EINVAL,
+        "filedb_has key=\"..\" failed with EINVAL");
+    ok (errstr != NULL,
+        "and error string was set");
+
+    errno = 0;
+    ok (filedb_has (dbpath, "noexist", &errstr) < 0 && errno == ENOENT,
+        "filedb_has key=\"noexist\" failed with ENOENT");
+
     /* put */
 
     errno = 0;
@@ -89,6 +106,8 @@ void test_simple (const char *dbpath)
     ok (data && size == sizeof (val1) && memcmp (data, val1, size) == 0,
         "and returned data matches");
     free (data);
+    ok (filedb_has (dbpath, "key1", &errstr) == 0,
+        "filedb_has key1 works");
 
     /* overwrite key is allowed (e.g. for checkpoint support) */
 
@@ -98,6 +117,87 @@ void test_simple (const char *dbpath)
         "filedb_get key1 works");
     ok (data && size == sizeof (val2) && memcmp (data, val2, size) == 0,
         "and returned the updated data");
+    free (data);
+
+    ok (filedb_put (dbpath, "key1", val1, sizeof (val1), &errstr) == 0,
+        "filedb_put key1={abc} works (overwrite with shorter value)");
+    ok (filedb_get (dbpath, "key1", &data, &size, &errstr) == 0,
+        "filedb_get key1 works");
+    ok (data && size == sizeof (val1) && memcmp (data, val1, size) == 0,
+        "and returned the shorter data");
+}
+
+/* Files written directly in dbpath by earlier versions are still found.
+ */
+void test_flat (const char *dbpath)
+{
+    char path[1024];
+    char val[] = { 'f', 'l', 'a', 't' };
+    char val2[] = { 'n', 'e', 'w' };
+    const char *errstr;
+    void *data;
+    size_t size;
+    FILE *f;
+
+    (void)snprintf (path, sizeof (path), "%s/flatkey", dbpath);
+    if (!(f = fopen (path, "w"))
+        || fwrite (val, sizeof (val), 1, f) != 1
+        || fclose (f) != 0)
+        BAIL_OUT ("could not create %s", path);
+
+    ok (filedb_has (dbpath, "flatkey", &errstr) == 0,
+        "filedb_has finds key in flat layout");
+    data = NULL;
+    ok (filedb_get (dbpath, "flatkey", &data, &size, &errstr) == 0
+        && size == sizeof (val) && memcmp (data, val, size) == 0,
+        "filedb_get reads key from flat layout");
+    free (data);
+
+    ok (filedb_put (dbpath, "flatkey", val2, sizeof (val2), &errstr) == 0,
+        "filedb_put flatkey works");
+    data = NULL;
+    ok (filedb_get (dbpath, "flatkey", &data, &size, &errstr) == 0
+        && size == sizeof (val2) && memcmp (data, val2, size) == 0,
+        "filedb_get returns the new value, not the flat one");
+    free (data);
+    ok (unlink (path) == 0,
+        "the flat file is not the one that was written");
+}
+
+/* Stored files land in two levels of subdirectories.
+ */
+void test_fanout (const char *dbpath)
+{
+    char val[] = { 'x' };
+    char key[64];
+    const char *errstr;
+    int errors = 0;
+    DIR *dir;
+    struct dirent *d;
+    int regular = 0;
+
+    for (int i = 0; i < 100; i++) {
+        (void)snprintf (key, sizeof (key), "fan%d", i);
+        if (filedb_put (dbpath, key, val, sizeof (val), &errstr) < 0
+            || filedb_has (dbpath, key, &errstr) < 0)
+            errors++;
+    }
+    ok (errors == 0,
+        "stored and found 100 keys");
+
+    if (!(dir = opendir (dbpath)))
+        BAIL_OUT ("opendir %s failed", dbpath);
+    while ((d = readdir (dir))) {
+        char path[1024];
+        struct stat sb;
+
+        (void)snprintf (path, sizeof (path), "%s/%s", dbpath, d->d_name);
+        if (lstat (path, &sb) == 0 && S_ISREG (sb.st_mode))
+            regular++;
+    }
+    closedir (dir);
+    ok (regular == 0,
+        "no files were stored in the top level directory");
 }
 
 int main (int argc, char *argv[])
@@ -117,6 +217,8 @@ int main (int argc, char *argv[])
 
     test_badargs (dir);
     test_simple (dir);
+    test_flat (dir);
+    test_fanout (dir);
 
     if (unlink_recursive (dir) < 0)
         BAIL_OUT ("unlink_recursive failed");
@@ -0,0 +1,966 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* content-pack.c - content addressable storage with packfile back end
+ *
+ * Blobs are appended to large segment files and indexed in memory by
+ * blobref (see packdb.c), which suits the append-mostly, immutable
+ * content of the KVS.  Loads are answered straight from the read-only
+ * mapping of a segment.
+ *
+ * Appends are synced in groups to reduce the sync rate.  The pending
+ * appends are synced once the broker has no more requests ready for the
+ * module, or once sync-max blobs are pending, and store responses are
+ * deferred until then.  A checkpoint put first syncs pending appends,
+ * so a checkpoint never refers to blobs that are not yet durable.
+ * Likewise, a content-backing.has response is deferred while appends
+ * are pending, since it may report a blob that is not yet durable.
+ *
+ * Content is never removed by the content service itself, so blobs the
+ * KVS no longer references accumulate.  A content-pack.compact request
+ * walks the KVS from the checkpointed roots and any roots in the request,
+ * marking each blob reached, then rewrites segments that are mostly
+ * unreachable.  Blobs stored by other users of the content service and
+ * not reachable from a KVS root are lost, so compaction is only safe
+ * when the KVS is the only such user, and the caller should pass the
+ * current root of each KVS namespace in use.
+ *
+ * Module options:
+ *   segment-size=BYTES   start a new segment at this size (default 256M)
+ *   sync-max=N           maximum blobs pending sync (default 1024)
+ *
+ * The RPC handlers are as described in content-files.c, plus:
+ *
+ * content-pack.compact:
+ * Given optional "roots", an array of blobrefs, and "threshold", the
+ * live fraction under which a segment is rewritten (default 0.5),
+ * compact and return the number of segments removed and blobs dropped.
+ *
+ * content-pack.stats-get:
+ * Return the number of segments and blobs, and the total segment size.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <czmq.h>
+#include <jansson.h>
+#include <flux/core.h>
+
+#include "src/common/libutil/blobref.h"
+#include "src/common/libutil/log.h"
+#include "src/common/libutil/errno_safe.h"
+#include "src/common/libutil/blobbatch.h"
+#include "src/common/libkvs/treeobj.h"
+
+#include "src/common/libcontent/content-util.h"
+
+#include "packdb.h"
+
+#define DEFAULT_SEGMENT_SIZE (256*1024*1024)
+#define DEFAULT_SYNC_MAX 1024
+#define DEFAULT_THRESHOLD 0.5
+
+/* A response held until pending appends are synced.
+ */
+struct sync_response {
+    const flux_msg_t *msg;
+    void *buf;
+    int len;
+};
+
+struct content_pack {
+    flux_msg_handler_t **handlers;
+    flux_watcher_t *check_w;
+    struct packdb *db;
+    char *dbpath;
+    flux_t *h;
+    const char *hashfun;
+    zlist_t *sync_responses;
+    int sync_count;
+    int sync_max;
+    size_t segment_size;
+};
+
+static void sync_response_destroy (struct sync_response *rsp)
+{
+    if (rsp) {
+        int saved_errno = errno;
+        flux_msg_decref (rsp->msg);
+        free (rsp->buf);
+        free (rsp);
+        errno = saved_errno;
+    }
+}
+
+/* Sync pending appends, then send deferred responses, or fail them with
+ * the sync error.  Returns 0 on success, -1 on error with errno set.
+ */
+static int pack_sync (struct content_pack *ctx)
+{
+    struct sync_response *rsp;
+    const char *errstr = NULL;
+    int errnum = 0;
+    int rc = 0;
+
+    if (packdb_sync (ctx->db, &errstr) < 0) {
+        flux_log_error (ctx->h, "sync");
+        errnum = errno;
+        rc = -1;
+    }
+    ctx->sync_count = 0;
+    while ((rsp = zlist_pop (ctx->sync_responses))) {
+        if (errnum) {
+            if (flux_respond_error (ctx->h, rsp->msg, errnum, errstr) < 0)
+                flux_log_error (ctx->h, "error responding to request");
+        }
+        else {
+            if (flux_respond_raw (ctx->h, rsp->msg, rsp->buf, rsp->len) < 0)
+                flux_log_error (ctx->h, "error responding to request");
+        }
+        sync_response_destroy (rsp);
+    }
+    if (rc < 0)
+        errno = errnum;
+    return rc;
+}
+
+/* Respond to 'msg' with 'len' bytes of 'buf' now, or if appends are
+ * pending, once they are synced, which happens now if 'count' more
+ * blobs brings the number pending to sync_max.
+ * Returns 0 on success, -1 on error with errno set.
+ */
+static int respond_synced (struct content_pack *ctx,
+                           const flux_msg_t *msg,
+                           const void *buf,
+                           int len,
+                           int count)
+{
+    struct sync_response *rsp;
+
+    if (!packdb_dirty (ctx->db))
+        return flux_respond_raw (ctx->h, msg, buf, len);
+    if (!(rsp = calloc (1, sizeof (*rsp)))
+        || (len > 0 && !(rsp->buf = malloc (len)))
+        || zlist_append (ctx->sync_responses, rsp) < 0) {
+        sync_response_destroy (rsp);
+        errno = ENOMEM;
+        return -1;
+    }
+    if (len > 0)
+        memcpy (rsp->buf, buf, len);
+    rsp->len = len;
+    rsp->msg = flux_msg_incref (msg);
+    ctx->sync_count += count;
+    if (ctx->sync_count >= ctx->sync_max)
+        (void)pack_sync (ctx);
+    return 0;
+}
+
+/* Sync once there are no more requests ready to be handled.
+ */
+static void sync_check_cb (flux_reactor_t *r,
+                           flux_watcher_t *w,
+                           int revents,
+                           void *arg)
+{
+    struct content_pack *ctx = arg;
+
+    if (packdb_dirty (ctx->db) && !(flux_pollevents (ctx->h) & FLUX_POLLIN))
+        (void)pack_sync (ctx);
+}
+
+/* Handle a content-backing.load request.  The raw request payload is a
+ * blobref string, including NULL terminator.  The raw response payload
+ * is the blob content, sent from the segment mapping without a copy.
+ */
+static void load_cb (flux_t *h,
+                     flux_msg_handler_t *mh,
+                     const flux_msg_t *msg,
+                     void *arg)
+{
+    struct content_pack *ctx = arg;
+    const char *blobref;
+    int blobref_size;
+    const void *data;
+    size_t size;
+    const char *errstr = NULL;
+
+    if (flux_request_decode_raw (msg,
+                                 NULL,
+                                 (const void **)&blobref,
+                                 &blobref_size) < 0)
+        goto error;
+    if (!blobref || blobref[blobref_size - 1] != '\0'
+                 || blobref_validate (blobref) < 0) {
+        errno = EPROTO;
+        errstr = "invalid blobref";
+        goto error;
+    }
+    if (packdb_get (ctx->db, blobref, &data, &size) < 0)
+        goto error;
+    if (flux_respond_raw (h, msg, data, size) < 0)
+        flux_log_error (h, "error responding to load request");
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, errstr) < 0)
+        flux_log_error (h, "error responding to load request");
+}
+
+/* Handle a content-backing.store request.  The raw request payload is the
+ * blob content.  The raw response payload is a blobref string including
+ * NULL terminator.  The response is deferred until the blob is durable.
+ */
+static void store_cb (flux_t *h,
+                      flux_msg_handler_t *mh,
+                      const flux_msg_t *msg,
+                      void *arg)
+{
+    struct content_pack *ctx = arg;
+    const void *data;
+    int size;
+    char blobref[BLOBREF_MAX_STRING_SIZE];
+    const char *errstr = NULL;
+
+    if (flux_request_decode_raw (msg, NULL, &data, &size) < 0)
+        goto error;
+    if (blobref_hash (ctx->hashfun,
+                      (uint8_t *)data,
+                      size,
+                      blobref,
+                      sizeof (blobref)) < 0)
+        goto error;
+    if (packdb_put (ctx->db, blobref, data, size, &errstr) < 0)
+        goto error;
+    if (respond_synced (ctx, msg, blobref, strlen (blobref) + 1, 1) < 0)
+        flux_log_error (h, "error responding to store request");
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, errstr) < 0)
+        flux_log_error (h, "error responding to store request");
+}
+
+/* Handle a content-backing.load-batch request.  The raw request payload
+ * is a batch of blobref strings, and the raw response payload a batch of
+ * blobs in the same order (see blobbatch.h).
+ */
+static void load_batch_cb (flux_t *h,
+                           flux_msg_handler_t *mh,
+                           const flux_msg_t *msg,
+                           void *arg)
+{
+    struct content_pack *ctx = arg;
+    const void *buf;
+    int len;
+    struct blobbatch *req = NULL;
+    struct blobbatch *rsp = NULL;
+    const char *errstr = NULL;
+    int i;
+
+    if (flux_request_decode_raw (msg, NULL, &buf, &len) < 0)
+        goto error;
+    if (!(req = blobbatch_decode (buf, len))) {
+        errstr = "malformed batch";
+        goto error;
+    }
+    if (!(rsp = blobbatch_create ()))
+        goto error;
+    for (i = 0; i < blobbatch_count (req); i++) {
+        const char *blobref;
+        const void *data;
+        size_t size;
+        int rc;
+
+        if (!(blobref = blobbatch_get_string (req, i))
+            || blobref_validate (blobref) < 0) {
+            rc = blobbatch_append_error (rsp, EPROTO);
+        }
+        else if (packdb_get (ctx->db, blobref, &data, &size) < 0)
+            rc = blobbatch_append_error (rsp, errno);
+        else
+            rc = blobbatch_append (rsp, data, size);
+        if (rc < 0)
+            goto error;
+    }
+    blobbatch_encode (rsp, &buf, &len);
+    if (flux_respond_raw (h, msg, buf, len) < 0)
+        flux_log_error (h, "error responding to load-batch request");
+    blobbatch_destroy (req);
+    blobbatch_destroy (rsp);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, errstr) < 0)
+        flux_log_error (h, "error responding to load-batch request");
+    blobbatch_destroy (req);
+    blobbatch_destroy (rsp);
+}
+
+/* Handle a content-backing.has request.  The raw request payload is a
+ * batch of blobref strings, and the raw response payload a batch in the
+ * same order, with an empty item for each blob that is stored and an
+ * error (ENOENT) for each that is not.
+ */
+static void has_cb (flux_t *h,
+                    flux_msg_handler_t *mh,
+                    const flux_msg_t *msg,
+                    void *arg)
+{
+    struct content_pack *ctx = arg;
+    const void *buf;
+    int len;
+    struct blobbatch *req = NULL;
+    struct blobbatch *rsp = NULL;
+    const char *errstr = NULL;
+    int i;
+
+    if (flux_request_decode_raw (msg, NULL, &buf, &len) < 0)
+        goto error;
+    if (!(req = blobbatch_decode (buf, len))) {
+        errstr = "malformed batch";
+        goto error;
+    }
+    if (!(rsp = blobbatch_create ()))
+        goto error;
+    for (i = 0; i < blobbatch_count (req); i++) {
+        const char *blobref;
+        int rc;
+
+        if (!(blobref = blobbatch_get_string (req, i))
+            || blobref_validate (blobref) < 0) {
+            rc = blobbatch_append_error (rsp, EPROTO);
+        }
+        else if (packdb_has (ctx->db, blobref) < 0)
+            rc = blobbatch_append_error (rsp, errno);
+        else
+            rc = blobbatch_append (rsp, NULL, 0);
+        if (rc < 0)
+            goto error;
+    }
+    blobbatch_encode (rsp, &buf, &len);
+    if (respond_synced (ctx, msg, buf, len, 0) < 0)
+        flux_log_error (h, "error responding to has request");
+    blobbatch_destroy (req);
+    blobbatch_destroy (rsp);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, errstr) < 0)
+        flux_log_error (h, "error responding to has request");
+    blobbatch_destroy (req);
+    blobbatch_destroy (rsp);
+}
+
+/* Handle a content-backing.store-batch request.  The raw request payload
+ * is a batch of blobs, and the raw response payload a batch of blobref
+ * strings in the same order.
+ */
+static void store_batch_cb (flux_t *h,
+                            flux_msg_handler_t *mh,
+                            const flux_msg_t *msg,
+                            void *arg)
+{
+    struct content_pack *ctx = arg;
+    const void *buf;
+    int len;
+    struct blobbatch *req = NULL;
+    struct blobbatch *rsp = NULL;
+    const char *errstr = NULL;
+    int i;
+
+    if (flux_request_decode_raw (msg, NULL, &buf, &len) < 0)
+        goto error;
+    if (!(req = blobbatch_decode (buf, len))) {
+        errstr = "malformed batch";
+        goto error;
+    }
+    if (!(rsp = blobbatch_create ()))
+        goto error;
+    for (i = 0; i < blobbatch_count (req); i++) {
+        const void *data;
+        int size;
+        char blobref[BLOBREF_MAX_STRING_SIZE];
+        int rc;
+
+        if (blobbatch_get (req, i, &data, &size) < 0
+            || blobref_hash (ctx->hashfun,
+                             (uint8_t *)data,
+                             size,
+                             blobref,
+                             sizeof (blobref)) < 0
+            || packdb_put (ctx->db, blobref, data, size, NULL) < 0)
+            rc = blobbatch_append_error (rsp, errno);
+        else
+            rc = blobbatch_append (rsp, blobref, strlen (blobref) + 1);
+        if (rc < 0)
+            goto error;
+    }
+    blobbatch_encode (rsp, &buf, &len);
+    if (respond_synced (ctx, msg, buf, len, blobbatch_count (req)) < 0)
+        flux_log_error (h, "error responding to store-batch request");
+    blobbatch_destroy (req);
+    blobbatch_destroy (rsp);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, errstr) < 0)
+        flux_log_error (h, "error responding to store-batch request");
+    blobbatch_destroy (req);
+    blobbatch_destroy (rsp);
+}
+
+/* Handle a kvs-checkpoint.get request from the rank 0 kvs module.
+ * The KVS stores its last root reference here for restart purposes.
+ */
+static void checkpoint_get_cb (flux_t *h,
+                               flux_msg_handler_t *mh,
+                               const flux_msg_t *msg,
+                               void *arg)
+{
+    struct content_pack *ctx = arg;
+    const char *key;
+    void *data = NULL;
+    size_t size;
+    const char *errstr = NULL;
+
+    if (flux_request_unpack (msg, NULL, "{s:s}", "key", &key) < 0)
+        goto error;
+    if (packdb_meta_get (ctx->db, key, &data, &size) < 0)
+        goto error;
+    if (flux_respond_pack (h,
+                           msg,
+                           "{s:s}",
+                           "value",
+                           size > 0 ? data : "") < 0)
+        flux_log_error (h, "error responding to kvs-checkpoint.get request");
+    free (data);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, errstr) < 0)
+        flux_log_error (h, "error responding to kvs-checkpoint.get request");
+    free (data);
+}
+
+/* Handle a kvs-checkpoint.put request from the rank 0 kvs module.
+ * Pending appends are synced, and their responses sent, first.
+ */
+static void checkpoint_put_cb (flux_t *h,
+                               flux_msg_handler_t *mh,
+                               const flux_msg_t *msg,
+                               void *arg)
+{
+    struct content_pack *ctx = arg;
+    const char *key;
+    const char *value;
+    const char *errstr = NULL;
+
+    if (flux_request_unpack (msg,
+                             NULL,
+                             "{s:s s:s}",
+                             "key",
+                             &key,
+                             "value",
+                             &value) < 0)
+        goto error;
+    if (pack_sync (ctx) < 0)
+        goto error;
+    if (packdb_meta_put (ctx->db, key, value, strlen (value), &errstr) < 0)
+        goto error;
+    if (flux_respond (h, msg, NULL) < 0)
+        flux_log_error (h, "error responding to kvs-checkpoint.put request");
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, errstr) < 0)
+        flux_log_error (h, "error responding to kvs-checkpoint.put request");
+}
+
+/* State of a KVS reachability walk.  'live' is the set of blobrefs
+ * reached, and 'todo' the blobrefs of treeobjs not yet visited.
+ */
+struct walk {
+    struct content_pack *ctx;
+    zhashx_t *live;
+    zlist_t *todo;
+    const char *errstr;
+};
+
+static int walk_mark (struct walk *w, const char *blobref, bool visit)
+{
+    char *cpy;
+
+    if (zhashx_lookup (w->live, blobref))
+        return 0;
+    if (zhashx_insert (w->live, blobref, (void *)1) < 0)
+        goto nomem;
+    if (visit) {
+        if (!(cpy = strdup (blobref)))
+            goto nomem;
+        if (zlist_append (w->todo, cpy) < 0) {
+            free (cpy);
+            goto nomem;
+        }
+    }
+    return 0;
+nomem:
+    errno = ENOMEM;
+    return -1;
+}
+
+/* Mark the blobs that treeobj 'obj' refers to.  The blob of a valref
+ * is opaque, but the blob of a dirref is a treeobj to be visited.
+ */
+static int walk_treeobj (struct walk *w, const json_t *obj)
+{
+    json_t *data;
+    const char *key;
+    json_t *o;
+    int count;
+
+    if (treeobj_is_valref (obj) || treeobj_is_dirref (obj)) {
+        bool visit = treeobj_is_dirref (obj);
+
+        if ((count = treeobj_get_count (obj)) < 0)
+            return -1;
+        for (int i = 0; i < count; i++) {
+            const char *blobref = treeobj_get_blobref (obj, i);
+            if (!blobref || walk_mark (w, blobref, visit) < 0)
+                return -1;
+        }
+    }
+    else if (treeobj_is_dir (obj)) {
+        if (!(data = treeobj_get_data ((json_t *)obj)))
+            return -1;
+        json_object_foreach (data, key, o) {
+            if (walk_treeobj (w, o) < 0)
+                return -1;
+        }
+    }
+    else if (treeobj_is_dirshard (obj)) {
+        json_t *shards;
+
+        if (!(data = treeobj_get_data ((json_t *)obj))
+            || !(shards = json_object_get (data, "shards"))) {
+            errno = EPROTO;
+            return -1;
+        }
+        json_object_foreach (shards, key, o) {
+            if (walk_treeobj (w, o) < 0)
+                return -1;
+        }
+    }
+    return 0;
+}
+
+/* Visit each treeobj blob reachable from the roots already queued.
+ * A blob that is missing or is not a treeobj fails the walk, since that
+ * means the roots are not what the caller thought they were.
+ */
+static int walk_run (struct walk *w)
+{
+    char *blobref;
+
+    while ((blobref = zlist_pop (w->todo))) {
+        const void *data;
+        size_t size;
+        json_t *obj;
+        int rc;
+
+        if (packdb_get (w->ctx->db, blobref, &data, &size) < 0) {
+            flux_log_error (w->ctx->h, "compact: %s", blobref);
+            w->errstr = "a reachable blob is not stored";
+            free (blobref);
+            return -1;
+        }
+        if (!(obj = treeobj_decodeb (data, size))) {
+            flux_log (w->ctx->h, LOG_ERR, "compact: %s is not a treeobj",
+                      blobref);
+            w->errstr = "a reachable blob is not a treeobj";
+            free (blobref);
+            errno = EPROTO;
+            return -1;
+        }
+        rc = walk_treeobj (w, obj);
+        ERRNO_SAFE_WRAP (json_decref, obj);
+        free (blobref);
+        if (rc < 0)
+            return -1;
+    }
+    return 0;
+}
+
+static void walk_destroy (struct walk *w)
+{
+    if (w) {
+        int saved_errno = errno;
+        char *s;
+        zhashx_destroy (&w->live);
+        if (w->todo) {
+            while ((s = zlist_pop (w->todo)))
+                free (s);
+            zlist_destroy (&w->todo);
+        }
+        free (w);
+        errno = saved_errno;
+    }
+}
+
+static struct walk *walk_create (struct content_pack *ctx)
+{
+    struct walk *w;
+
+    if (!(w = calloc (1, sizeof (*w))))
+        return NULL;
+    w->ctx = ctx;
+    if (!(w->live = zhashx_new ()) || !(w->todo = zlist_new ())) {
+        walk_destroy (w);
+        errno = ENOMEM;
+        return NULL;
+    }
+    return w;
+}
+
+/* Queue each checkpointed root.  A value that is not a blobref is not a
+ * KVS root, and is skipped.
+ */
+static void walk_checkpoint_cb (const char *key,
+                                const void *data,
+                                size_t size,
+                                void *arg)
+{
+    struct walk *w = arg;
+
+    if (blobref_validate (data) == 0) {
+        if (walk_mark (w, data, true) < 0)
+            w->errstr = "out of memory";
+    }
+}
+
+static bool walk_live (const char *blobref, void *arg)
+{
+    struct walk *w = arg;
+
+    return zhashx_lookup (w->live, blobref) != NULL;
+}
+
+/* Handle a content-pack.compact request.  The walk and compaction run to
+ * completion in this handler, so no blob can be stored between them.
+ */
+static void compact_cb (flux_t *h,
+                        flux_msg_handler_t *mh,
+                        const flux_msg_t *msg,
+                        void *arg)
+{
+    struct content_pack *ctx = arg;
+    json_t *roots = NULL;
+    double threshold = DEFAULT_THRESHOLD;
+    struct walk *w = NULL;
+    const char *errstr = NULL;
+    size_t index;
+    json_t *o;
+    int segments;
+    size_t blobs;
+
+    if (flux_request_unpack (msg,
+                             NULL,
+                             "{s?o s?F}",
+                             "roots", &roots,
+                             "threshold", &threshold) < 0)
+        goto error;
+    if ((roots && !json_is_array (roots))
+        || !(threshold > 0 && threshold <= 1)) {
+        errno = EPROTO;
+        goto error;
+    }
+    if (pack_sync (ctx) < 0)
+        goto error;
+    if (!(w = walk_create (ctx)))
+        goto error;
+    json_array_foreach (roots, index, o) {
+        const char *blobref = json_string_value (o);
+        if (!blobref || blobref_validate (blobref) < 0) {
+            errno = EPROTO;
+            errstr = "invalid root blobref";
+            goto error;
+        }
+        if (walk_mark (w, blobref, true) < 0)
+            goto error;
+    }
+    if (packdb_meta_foreach (ctx->db, walk_checkpoint_cb, w) < 0)
+        goto error;
+    if (w->errstr) {
+        errno = ENOMEM;
+        errstr = w->errstr;
+        goto error;
+    }
+    if (zhashx_size (w->live) == 0) {
+        errno = EINVAL;
+        errstr = "there are no KVS roots to compact from";
+        goto error;
+    }
+    if (walk_run (w) < 0) {
+        errstr = w->errstr;
+        goto error;
+    }
+    if (packdb_compact (ctx->db,
+                        threshold,
+                        walk_live,
+                        w,
+                        &segments,
+                        &blobs,
+                        &errstr) < 0)
+        goto error;
+    flux_log (h,
+              LOG_INFO,
+              "compact: %zu live blobs, removed %d segments, dropped %zu blobs",
+              zhashx_size (w->live),
+              segments,
+              blobs);
+    if (flux_respond_pack (h,
+                           msg,
+                           "{s:i s:I s:I}",
+                           "segments", segments,
+                           "blobs", (json_int_t)blobs,
+                           "live", (json_int_t)zhashx_size (w->live)) < 0)
+        flux_log_error (h, "error responding to compact request");
+    walk_destroy (w);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, errstr) < 0)
+        flux_log_error (h, "error responding to compact request");
+    walk_destroy (w);
+}
+
+static void stats_cb (flux_t *h,
+                      flux_msg_handler_t *mh,
+                      const flux_msg_t *msg,
+                      void *arg)
+{
+    struct content_pack *ctx = arg;
+    struct packdb_stats stats;
+
+    packdb_get_stats (ctx->db, &stats);
+    if (flux_respond_pack (h,
+                           msg,
+                           "{s:i s:I s:I}",
+                           "segments", stats.segments,
+                           "blobs", (json_int_t)stats.blobs,
+                           "bytes", (json_int_t)stats.bytes) < 0)
+        flux_log_error (h, "error responding to stats-get request");
+}
+
+/* Destroy module context.  Deferred responses are sent first.
+ */
+static void content_pack_destroy (struct content_pack *ctx)
+{
+    if (ctx) {
+        int saved_errno = errno;
+        flux_msg_handler_delvec (ctx->handlers);
+        flux_watcher_destroy (ctx->check_w);
+        if (ctx->sync_responses) {
+            if (ctx->db)
+                (void)pack_sync (ctx);
+            zlist_destroy (&ctx->sync_responses);
+        }
+        packdb_close (ctx->db);
+        free (ctx->dbpath);
+        free (ctx);
+        errno = saved_errno;
+    }
+}
+
+/* Table of message handler callbacks registered below.
+ * The topic strings in the table consist of <service name>.<method>.
+ */
+static const struct flux_msg_handler_spec htab[] = {
+    { FLUX_MSGTYPE_REQUEST, "content-backing.load",    load_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST, "content-backing.store",   store_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST, "content-backing.load-batch", load_batch_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST, "content-backing.store-batch", store_batch_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST, "content-backing.has", has_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST, "kvs-checkpoint.get", checkpoint_get_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST, "kvs-checkpoint.put", checkpoint_put_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST, "content-pack.compact", compact_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST, "content-pack.stats-get", stats_cb, 0 },
+    FLUX_MSGHANDLER_TABLE_END,
+};
+
+/* Create module context and perform some initialization.
+ */
+static struct content_pack *content_pack_create (flux_t *h,
+                                                 size_t segment_size,
+                                                 int sync_max)
+{
+    struct content_pack *ctx;
+    const char *backing_path;
+    const char *errstr = NULL;
+
+    if (!(ctx = calloc (1, sizeof (*ctx))))
+        return NULL;
+    ctx->h = h;
+    ctx->segment_size = segment_size;
+    ctx->sync_max = sync_max;
+    if (!(ctx->sync_responses = zlist_new ())) {
+        errno = ENOMEM;
+        goto error;
+    }
+    if (!(ctx->hashfun = flux_attr_get (h, "content.hash"))) {
+        flux_log_error (h, "content.hash");
+        goto error;
+    }
+
+    /* If 'content.backing-path' attribute is already set, then:
+     * - value is the db directory
+     * - if it exists, preserve existing content; else create empty
+     * Otherwise:
+     * - ${rundir}/content.pack is the backing path
+     * - set 'content.backing-path' to this name
+     * - ${rundir} is cleaned up recursively by broker atexit(3) handler
+     */
+    backing_path = flux_attr_get (h, "content.backing-path");
+    if (backing_path) {
+        if (!(ctx->dbpath = strdup (backing_path)))
+            goto error;
+        if (mkdir (ctx->dbpath, 0700) < 0 && errno != EEXIST)
+            goto error;
+    }
+    else {
+        const char *rundir = flux_attr_get (h, "rundir");
+        if (!rundir) {
+            flux_log_error (h, "rundir");
+            goto error;
+        }
+        if (asprintf (&ctx->dbpath, "%s/content.pack", rundir) < 0)
+            goto error;
+        if (flux_attr_set (h, "content.backing-path", ctx->dbpath) < 0)
+            goto error;
+        if (mkdir (ctx->dbpath, 0700) < 0)
+            goto error;
+    }
+    if (!(ctx->db = packdb_open (ctx->dbpath, ctx->segment_size, &errstr))) {
+        flux_log_error (h,
+                        "%s: %s",
+                        ctx->dbpath,
+                        errstr ? errstr : strerror (errno));
+        goto error;
+    }
+    if (!(ctx->check_w = flux_check_watcher_create (flux_get_reactor (h),
+                                                    sync_check_cb,
+                                                    ctx)))
+        goto error;
+    flux_watcher_start (ctx->check_w);
+    if (flux_msg_handler_addvec (h, htab, ctx, &ctx->handlers) < 0)
+        goto error;
+    return ctx;
+error:
+    content_pack_destroy (ctx);
+    return NULL;
+}
+
+static int parse_size (const char *s, long long *valp)
+{
+    char *endptr;
+    long long n;
+
+    errno = 0;
+    n = strtoll (s, &endptr, 10);
+    if (errno != 0 || endptr == s || n <= 0)
+        goto inval;
+    if (*endptr == 'K' || *endptr == 'M' || *endptr == 'G') {
+        int shift = *endptr == 'K' ? 10 : *endptr == 'M' ? 20 : 30;
+        if (n > (LLONG_MAX >> shift))
+            goto inval;
+        n <<= shift;
+        endptr++;
+    }
+    if (*endptr != '\0')
+        goto inval;
+    *valp = n;
+    return 0;
+inval:
+    errno = EINVAL;
+    return -1;
+}
+
+static int parse_args (flux_t *h,
+                       int argc,
+                       char **argv,
+                       bool *testing,
+                       size_t *segment_size,
+                       int *sync_max)
+{
+    int i;
+    for (i = 0; i < argc; i++) {
+        long long n;
+
+        if (!strcmp (argv[i], "testing"))
+            *testing = true;
+        else if (!strncmp (argv[i], "segment-size=", 13)) {
+            if (parse_size (argv[i] + 13, &n) < 0 || n < 4096) {
+                errno = EINVAL;
+                flux_log_error (h, "%s", argv[i]);
+                return -1;
+            }
+            *segment_size = n;
+        }
+        else if (!strncmp (argv[i], "sync-max=", 9)) {
+            if (parse_size (argv[i] + 9, &n) < 0 || n > INT_MAX) {
+                errno = EINVAL;
+                flux_log_error (h, "%s", argv[i]);
+                return -1;
+            }
+            *sync_max = n;
+        }
+        else {
+            errno = EINVAL;
+            flux_log_error (h, "%s", argv[i]);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int mod_main (flux_t *h, int argc, char **argv)
+{
+    struct content_pack *ctx;
+    bool testing = false;
+    size_t segment_size = DEFAULT_SEGMENT_SIZE;
+    int sync_max = DEFAULT_SYNC_MAX;
+    int rc = -1;
+
+    if (parse_args (h, argc, argv, &testing, &segment_size, &sync_max) < 0)
+        return -1;
+    if (!(ctx = content_pack_create (h, segment_size, sync_max))) {
+        flux_log_error (h, "content_pack_create failed");
+        return -1;
+    }
+    if (!testing) {
+        if (content_register_backing_store (h, "content-pack") < 0)
+            goto done;
+    }
+    if (content_register_service (h, "content-backing") < 0)
+        goto done;
+    if (content_register_service (h, "kvs-checkpoint") < 0)
+        goto done;
+    if (flux_reactor_run (flux_get_reactor (h), 0) < 0) {
+        flux_log_error (h, "flux_reactor_run");
+        goto done;
+    }
+    if (!testing) {
+        if (content_unregister_backing_store (h) < 0)
+            goto done;
+    }
+    rc = 0;
+done:
+    content_pack_destroy (ctx);
+    return rc;
+}
+
+MOD_NAME ("content-pack");
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,1123 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* packdb.c - log-structured blob store
+ *
+ * Blobs are appended to segment files "seg-NNNNNNNN" as records:
+ *
+ *   magic (4) | reflen (4) | size (4) | blobref (reflen) | data (size)
+ *
+ * padded to a multiple of 8 bytes, with integers in network byte order.
+ * Each segment is mapped read-only, so a lookup returns a pointer into
+ * the mapping.  The active segment is mapped at its full size up front,
+ * so its mapping covers records appended later.
+ *
+ * Once the active segment is full it is synced and sealed by writing
+ * "seg-NNNNNNNN.idx", which lists the offset, size, and blobref of each
+ * record, so that opening the packdb reads the index rather than the
+ * segment.  A segment without an index was active when the packdb was
+ * last closed.  It is scanned, and each record is checked against its
+ * blobref, so a record torn by a crash is found and truncated.
+ *
+ * The in-memory index is an open addressing hash table keyed by blobref.
+ * Its keys point into the segment or index mappings rather than being
+ * copied.
+ *
+ * Compaction copies the live blobs of sparse sealed segments to the
+ * active segment, syncs it, then removes the old segments.  A crash part
+ * way leaves duplicate copies, which are harmless.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <arpa/inet.h>
+
+#include "src/common/libutil/blobref.h"
+#include "src/common/libutil/read_all.h"
+
+#include "packdb.h"
+
+#define SEGMENT_MAGIC       "FLXPACK1"
+#define INDEX_MAGIC         "FLXPIDX1"
+#define MAGIC_SIZE          8
+#define RECORD_MAGIC        0x504b5242  // "PKRB"
+#define RECORD_HDR_SIZE     12
+#define INDEX_HDR_SIZE      16
+#define META_PREFIX         "meta."
+
+#define ALIGN8(n)           (((n) + 7) & ~(size_t)7)
+
+struct segment {
+    unsigned int id;
+    int fd;                 // open while active, else -1
+    char *base;             // read-only mapping of the segment
+    size_t mapsize;
+    size_t used;            // bytes in the file
+    size_t synced;          // bytes known to be durable
+    char *idx;              // mapping of the index, if loaded from one
+    size_t idxsize;
+    size_t live;            // live bytes, during compaction
+    bool victim;
+};
+
+struct entry {
+    const char *ref;        // not NULL-terminated; NULL if slot is empty
+    struct segment *seg;
+    uint64_t offset;        // of the record in seg
+    uint32_t size;
+    uint32_t hash;
+    uint16_t reflen;
+    uint8_t live;
+};
+
+struct packdb {
+    char *dbpath;
+    int dirfd;
+    size_t segment_size;
+    struct segment **segs;  // in order of id, active last if any
+    int nsegs;
+    struct segment *active;
+    unsigned int next_id;
+    bool dir_dirty;
+    struct entry *table;
+    size_t capacity;        // a power of 2
+    size_t count;
+};
+
+static uint32_t ref_hash (const char *ref, size_t len)
+{
+    uint32_t h = 2166136261U;
+
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)ref[i];
+        h *= 16777619U;
+    }
+    return h;
+}
+
+static struct entry *table_find (struct packdb *db,
+                                 const char *ref,
+                                 size_t reflen)
+{
+    uint32_t hash;
+    size_t i;
+
+    if (db->capacity == 0)
+        return NULL;
+    hash = ref_hash (ref, reflen);
+    i = hash & (db->capacity - 1);
+    while (db->table[i].ref) {
+        struct entry *e = &db->table[i];
+        if (e->hash == hash
+            && e->reflen == reflen
+            && memcmp (e->ref, ref, reflen) == 0)
+            return e;
+        i = (i + 1) & (db->capacity - 1);
+    }
+    return NULL;
+}
+
+static void table_place (struct entry *table,
+                         size_t capacity,
+                         const struct entry *e)
+{
+    size_t i = e->hash & (capacity - 1);
+
+    while (table[i].ref)
+        i = (i + 1) & (capacity - 1);
+    table[i] = *e;
+}
+
+/* Rebuild the table with room for at least 'count' entries at a load
+ * factor of at most 1/2, dropping entries in victim segments.
+ */
+static int table_rebuild (struct packdb *db, size_t count)
+{
+    size_t capacity = 1024;
+    struct entry *table;
+    size_t n = 0;
+
+    while (capacity < count * 2) {
+        if (capacity > SIZE_MAX / 2 / sizeof (*table)) {
+            errno = ENOMEM;
+            return -1;
+        }
+        capacity *= 2;
+    }
+    if (!(table = calloc (capacity, sizeof (*table))))
+        return -1;
+    for (size_t i = 0; i < db->capacity; i++) {
+        struct entry *e = &db->table[i];
+        if (e->ref && !e->seg->victim) {
+            table_place (table, capacity, e);
+            n++;
+        }
+    }
+    free (db->table);
+    db->table = table;
+    db->capacity = capacity;
+    db->count = n;
+    return 0;
+}
+
+static int table_insert (struct packdb *db, const struct entry *e)
+{
+    if ((db->count + 1) * 2 > db->capacity) {
+        if (table_rebuild (db, db->count + 1) < 0)
+            return -1;
+    }
+    table_place (db->table, db->capacity, e);
+    db->count++;
+    return 0;
+}
+
+static int pwrite_all (int fd, const void *buf, size_t len, off_t offset)
+{
+    const char *p = buf;
+
+    while (len > 0) {
+        ssize_t n = pwrite (fd, p, len, offset);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        p += n;
+        len -= n;
+        offset += n;
+    }
+    return 0;
+}
+
+static size_t record_size (size_t reflen, size_t size)
+{
+    return ALIGN8 (RECORD_HDR_SIZE + reflen + size);
+}
+
+/* Parse the record at 'offset' in the first 'len' bytes of 'base'.
+ */
+static int record_parse (const char *base,
+                         size_t len,
+                         size_t offset,
+                         const char **refp,
+                         size_t *reflenp,
+                         size_t *sizep)
+{
+    uint32_t hdr[3];
+
+    if (len < offset || len - offset < RECORD_HDR_SIZE)
+        return -1;
+    memcpy (hdr, base + offset, RECORD_HDR_SIZE);
+    if (ntohl (hdr[0]) != RECORD_MAGIC
+        || ntohl (hdr[1]) == 0
+        || ntohl (hdr[1]) >= BLOBREF_MAX_STRING_SIZE
+        || len - offset < record_size (ntohl (hdr[1]), ntohl (hdr[2])))
+        return -1;
+    *refp = base + offset + RECORD_HDR_SIZE;
+    *reflenp = ntohl (hdr[1]);
+    *sizep = ntohl (hdr[2]);
+    return 0;
+}
+
+/* Check that 'data' hashes to the 'reflen' byte blobref 'ref'.
+ */
+static bool record_valid (const char *ref,
+                          size_t reflen,
+                          const void *data,
+                          size_t size)
+{
+    char buf[BLOBREF_MAX_STRING_SIZE];
+    char hashtype[BLOBREF_MAX_STRING_SIZE];
+    const char *dash;
+
+    if (!(dash = memchr (ref, '-', reflen)) || size > INT_MAX)
+        return false;
+    memcpy (hashtype, ref, dash - ref);
+    hashtype[dash - ref] = '\0';
+    if (blobref_hash (hashtype, data, size, buf, sizeof (buf)) < 0)
+        return false;
+    return strlen (buf) == reflen && memcmp (buf, ref, reflen) == 0;
+}
+
+static int index_entry (struct packdb *db,
+                        struct segment *seg,
+                        const char *ref,
+                        size_t reflen,
+                        size_t offset,
+                        size_t size)
+{
+    struct entry e;
+
+    if (table_find (db, ref, reflen))
+        return 0; // duplicate left by an interrupted compaction
+    e.ref = ref;
+    e.seg = seg;
+    e.offset = offset;
+    e.size = size;
+    e.hash = ref_hash (ref, reflen);
+    e.reflen = reflen;
+    e.live = 0;
+    return table_insert (db, &e);
+}
+
+static void segment_destroy (struct segment *seg)
+{
+    if (seg) {
+        int saved_errno = errno;
+        if (seg->base)
+            (void)munmap (seg->base, seg->mapsize);
+        if (seg->idx)
+            (void)munmap (seg->idx, seg->idxsize);
+        if (seg->fd >= 0)
+            (void)close (seg->fd);
+        free (seg);
+        errno = saved_errno;
+    }
+}
+
+static size_t page_align (size_t n)
+{
+    size_t pagesize = sysconf (_SC_PAGESIZE);
+
+    return (n + pagesize - 1) / pagesize * pagesize;
+}
+
+/* Open segment 'id' and map 'mapsize' bytes of it, or the whole file if
+ * larger.  If 'create' is true, the file is created with just a header.
+ */
+static struct segment *segment_open (struct packdb *db,
+                                     unsigned int id,
+                                     size_t mapsize,
+                                     bool create)
+{
+    struct segment *seg;
+    char name[64];
+    struct stat sb;
+    char magic[MAGIC_SIZE];
+
+    if (!(seg = calloc (1, sizeof (*seg))))
+        return NULL;
+    seg->id = id;
+    snprintf (name, sizeof (name), "seg-%08u", id);
+    seg->fd = openat (db->dirfd,
+                      name,
+                      create ? O_RDWR | O_CREAT | O_EXCL : O_RDWR,
+                      0600);
+    if (seg->fd < 0)
+        goto error;
+    if (create) {
+        if (pwrite_all (seg->fd, SEGMENT_MAGIC, MAGIC_SIZE, 0) < 0)
+            goto error;
+        db->dir_dirty = true;
+    }
+    if (fstat (seg->fd, &sb) < 0)
+        goto error;
+    if (sb.st_size < MAGIC_SIZE
+        || pread (seg->fd, magic, MAGIC_SIZE, 0) != MAGIC_SIZE
+        || memcmp (magic, SEGMENT_MAGIC, MAGIC_SIZE) != 0) {
+        errno = EINVAL;
+        goto error;
+    }
+    seg->used = seg->synced = sb.st_size;
+    if (mapsize < seg->used)
+        mapsize = seg->used;
+    seg->mapsize = page_align (mapsize);
+    seg->base = mmap (NULL, seg->mapsize, PROT_READ, MAP_SHARED, seg->fd, 0);
+    if (seg->base == MAP_FAILED) {
+        seg->base = NULL;
+        goto error;
+    }
+    return seg;
+error:
+    segment_destroy (seg);
+    return NULL;
+}
+
+static int segment_append (struct packdb *db, struct segment *seg)
+{
+    struct segment **segs;
+
+    if (!(segs = realloc (db->segs, (db->nsegs + 1) * sizeof (segs[0]))))
+        return -1;
+    db->segs = segs;
+    db->segs[db->nsegs++] = seg;
+    if (seg->id >= db->next_id)
+        db->next_id = seg->id + 1;
+    return 0;
+}
+
+/* Index a segment by scanning its records, truncating it at the first
+ * record that is torn or does not match its blobref.
+ */
+static int segment_scan (struct packdb *db, struct segment *seg)
+{
+    size_t offset = MAGIC_SIZE;
+
+    while (offset < seg->used) {
+        const char *ref;
+        size_t reflen;
+        size_t size;
+
+        if (record_parse (seg->base, seg->used, offset, &ref, &reflen, &size)
+                < 0
+            || !record_valid (ref, reflen, ref + reflen, size))
+            break;
+        if (index_entry (db, seg, ref, reflen, offset, size) < 0)
+            return -1;
+        offset += record_size (reflen, size);
+    }
+    if (offset < seg->used) {
+        if (ftruncate (seg->fd, offset) < 0 || fdatasync (seg->fd) < 0)
+            return -1;
+        seg->used = seg->synced = offset;
+    }
+    return 0;
+}
+
+/* Index a sealed segment from its index file.
+ */
+static int segment_load_index (struct packdb *db,
+                               struct segment *seg,
+                               int fd)
+{
+    struct stat sb;
+    size_t offset = INDEX_HDR_SIZE;
+
+    if (fstat (fd, &sb) < 0)
+        return -1;
+    if (sb.st_size < INDEX_HDR_SIZE)
+        goto inval;
+    seg->idxsize = sb.st_size;
+    seg->idx = mmap (NULL, seg->idxsize, PROT_READ, MAP_SHARED, fd, 0);
+    if (seg->idx == MAP_FAILED) {
+        seg->idx = NULL;
+        return -1;
+    }
+    if (memcmp (seg->idx, INDEX_MAGIC, MAGIC_SIZE) != 0)
+        goto inval;
+    while (offset < seg->idxsize) {
+        uint32_t hdr[4];
+        uint64_t recoff;
+        size_t reflen;
+        size_t size;
+
+        if (seg->idxsize - offset < sizeof (hdr))
+            goto inval;
+        memcpy (hdr, seg->idx + offset, sizeof (hdr));
+        recoff = ((uint64_t)ntohl (hdr[0]) << 32) | ntohl (hdr[1]);
+        size = ntohl (hdr[2]);
+        reflen = ntohl (hdr[3]);
+        if (reflen == 0
+            || reflen >= BLOBREF_MAX_STRING_SIZE
+            || seg->idxsize - offset < ALIGN8 (sizeof (hdr) + reflen)
+            || recoff < MAGIC_SIZE
+            || recoff > seg->used
+            || seg->used - recoff < record_size (reflen, size))
+            goto inval;
+        if (index_entry (db,
+                         seg,
+                         seg->idx + offset + sizeof (hdr),
+                         reflen,
+                         recoff,
+                         size) < 0)
+            return -1;
+        offset += ALIGN8 (sizeof (hdr) + reflen);
+    }
+    return 0;
+inval:
+    errno = EINVAL;
+    return -1;
+}
+
+static int sync_dir (struct packdb *db)
+{
+    if (db->dir_dirty) {
+        if (fsync (db->dirfd) < 0)
+            return -1;
+        db->dir_dirty = false;
+    }
+    return 0;
+}
+
+/* Sync 'seg' and write its index, so it is no longer scanned on open.
+ */
+static int segment_seal (struct packdb *db, struct segment *seg)
+{
+    char name[64];
+    char tmp[64];
+    char *buf = NULL;
+    size_t len = INDEX_HDR_SIZE;
+    size_t alloc = 0;
+    int fd = -1;
+
+    if (fdatasync (seg->fd) < 0)
+        return -1;
+    seg->synced = seg->used;
+    for (size_t i = 0; i < db->capacity; i++) {
+        struct entry *e = &db->table[i];
+        uint32_t hdr[4];
+        size_t need;
+
+        if (!e->ref || e->seg != seg)
+            continue;
+        need = len + ALIGN8 (sizeof (hdr) + e->reflen);
+        if (need > alloc) {
+            size_t n = alloc ? alloc * 2 : 65536;
+            char *nbuf;
+
+            while (n < need)
+                n *= 2;
+            if (!(nbuf = realloc (buf, n)))
+                goto error;
+            buf = nbuf;
+            alloc = n;
+        }
+        hdr[0] = htonl ((uint32_t)(e->offset >> 32));
+        hdr[1] = htonl ((uint32_t)e->offset);
+        hdr[2] = htonl (e->size);
+        hdr[3] = htonl (e->reflen);
+        memset (buf + len, 0, need - len);
+        memcpy (buf + len, hdr, sizeof (hdr));
+        memcpy (buf + len + sizeof (hdr), e->ref, e->reflen);
+        len = need;
+    }
+    if (!buf && !(buf = calloc (1, INDEX_HDR_SIZE)))
+        goto error;
+    memcpy (buf, INDEX_MAGIC, MAGIC_SIZE);
+    memset (buf + MAGIC_SIZE, 0, INDEX_HDR_SIZE - MAGIC_SIZE);
+
+    snprintf (name, sizeof (name), "seg-%08u.idx", seg->id);
+    snprintf (tmp, sizeof (tmp), "seg-%08u.idx.tmp", seg->id);
+    if ((fd = openat (db->dirfd, tmp, O_WRONLY | O_CREAT | O_TRUNC, 0600)) < 0
+        || pwrite_all (fd, buf, len, 0) < 0
+        || fdatasync (fd) < 0
+        || renameat (db->dirfd, tmp, db->dirfd, name) < 0)
+        goto error;
+    db->dir_dirty = true;
+    if (sync_dir (db) < 0)
+        goto error;
+    (void)close (fd);
+    (void)close (seg->fd);
+    seg->fd = -1;
+    free (buf);
+    return 0;
+error:
+    if (fd >= 0) {
+        int saved_errno = errno;
+        (void)close (fd);
+        (void)unlinkat (db->dirfd, tmp, 0);
+        errno = saved_errno;
+    }
+    free (buf);
+    return -1;
+}
+
+/* Seal the active segment, if any, and start a new one with room for
+ * at least 'need' bytes of records.
+ */
+static int segment_rotate (struct packdb *db, size_t need)
+{
+    struct segment *seg;
+    size_t mapsize = db->segment_size;
+
+    if (db->active) {
+        if (segment_seal (db, db->active) < 0)
+            return -1;
+        db->active = NULL;
+    }
+    if (need > SIZE_MAX - MAGIC_SIZE) {
+        errno = EFBIG;
+        return -1;
+    }
+    if (mapsize < MAGIC_SIZE + need)
+        mapsize = MAGIC_SIZE + need;
+    if (!(seg = segment_open (db, db->next_id, mapsize, true)))
+        return -1;
+    if (segment_append (db, seg) < 0) {
+        char name[64];
+        snprintf (name, sizeof (name), "seg-%08u", seg->id);
+        (void)unlinkat (db->dirfd, name, 0);
+        segment_destroy (seg);
+        return -1;
+    }
+    db->active = seg;
+    return 0;
+}
+
+/* Append a record to the active segment, starting a new one if needed.
+ * On success, the segment and offset of the new record are assigned.
+ */
+static int record_append (struct packdb *db,
+                          const char *ref,
+                          size_t reflen,
+                          const void *data,
+                          size_t size,
+                          struct segment **segp,
+                          size_t *offsetp)
+{
+    static const char pad[8];
+    size_t recsize = record_size (reflen, size);
+    size_t padlen = recsize - (RECORD_HDR_SIZE + reflen + size);
+    struct segment *seg = db->active;
+    uint32_t hdr[3];
+    size_t offset;
+
+    if (!seg || seg->mapsize - seg->used < recsize) {
+        if (segment_rotate (db, recsize) < 0)
+            return -1;
+        seg = db->active;
+    }
+    offset = seg->used;
+    hdr[0] = htonl (RECORD_MAGIC);
+    hdr[1] = htonl (reflen);
+    hdr[2] = htonl (size);
+    if (pwrite_all (seg->fd, hdr, RECORD_HDR_SIZE, offset) < 0
+        || pwrite_all (seg->fd, ref, reflen, offset + RECORD_HDR_SIZE) < 0
+        || pwrite_all (seg->fd,
+                       data,
+                       size,
+                       offset + RECORD_HDR_SIZE + reflen) < 0
+        || pwrite_all (seg->fd,
+                       pad,
+                       padlen,
+                       offset + RECORD_HDR_SIZE + reflen + size) < 0) {
+        int saved_errno = errno;
+        (void)ftruncate (seg->fd, offset);
+        errno = saved_errno;
+        return -1;
+    }
+    seg->used += recsize;
+    *segp = seg;
+    *offsetp = offset;
+    return 0;
+}
+
+/* Open a directory stream on the packdb directory.  It is opened anew
+ * rather than dup()ed so that it has its own file offset.
+ */
+static DIR *open_dir (struct packdb *db)
+{
+    DIR *dir;
+    int fd;
+
+    if ((fd = openat (db->dirfd, ".", O_RDONLY | O_DIRECTORY)) < 0)
+        return NULL;
+    if (!(dir = fdopendir (fd))) {
+        int saved_errno = errno;
+        (void)close (fd);
+        errno = saved_errno;
+    }
+    return dir;
+}
+
+static int compare_id (const void *a, const void *b)
+{
+    unsigned int x = *(const unsigned int *)a;
+    unsigned int y = *(const unsigned int *)b;
+
+    return x < y ? -1 : x > y ? 1 : 0;
+}
+
+/* List the segment ids in the packdb directory in ascending order,
+ * removing leftover temporary files.
+ */
+static int list_segments (struct packdb *db, unsigned int **idsp, int *countp)
+{
+    DIR *dir;
+    struct dirent *ent;
+    unsigned int *ids = NULL;
+    int count = 0;
+
+    if (!(dir = open_dir (db)))
+        return -1;
+    while ((ent = readdir (dir))) {
+        unsigned int id;
+        char c;
+        unsigned int *nids;
+        size_t len = strlen (ent->d_name);
+
+        if (len > 4 && !strcmp (ent->d_name + len - 4, ".tmp")) {
+            (void)unlinkat (db->dirfd, ent->d_name, 0);
+            continue;
+        }
+        if (len != 12 || sscanf (ent->d_name, "seg-%8u%c", &id, &c) != 1)
+            continue;
+        if (!(nids = realloc (ids, (count + 1) * sizeof (ids[0]))))
+            goto error;
+        ids = nids;
+        ids[count++] = id;
+    }
+    (void)closedir (dir);
+    qsort (ids, count, sizeof (ids[0]), compare_id);
+    *idsp = ids;
+    *countp = count;
+    return 0;
+error:
+    (void)closedir (dir);
+    free (ids);
+    return -1;
+}
+
+static int packdb_load (struct packdb *db, const char **errstr)
+{
+    unsigned int *ids;
+    int count;
+    struct segment *unsealed = NULL;
+
+    if (list_segments (db, &ids, &count) < 0)
+        return -1;
+    for (int i = 0; i < count; i++) {
+        struct segment *seg;
+        char name[64];
+        int fd;
+        bool last = (i == count - 1);
+
+        snprintf (name, sizeof (name), "seg-%08u.idx", ids[i]);
+        fd = openat (db->dirfd, name, O_RDONLY);
+        if (fd < 0 && errno != ENOENT)
+            goto error;
+        if (!(seg = segment_open (db,
+                                  ids[i],
+                                  fd < 0 && last ? db->segment_size : 0,
+                                  false))) {
+            if (errno == EINVAL && errstr)
+                *errstr = "corrupt packdb segment";
+            if (fd >= 0)
+                (void)close (fd);
+            goto error;
+        }
+        if (segment_append (db, seg) < 0) {
+            segment_destroy (seg);
+            if (fd >= 0)
+                (void)close (fd);
+            goto error;
+        }
+        if (fd >= 0) {
+            int rc = segment_load_index (db, seg, fd);
+            (void)close (fd);
+            if (rc < 0) {
+                if (errno == EINVAL && errstr)
+                    *errstr = "corrupt packdb index";
+                goto error;
+            }
+            (void)close (seg->fd);
+            seg->fd = -1;
+        }
+        else {
+            if (segment_scan (db, seg) < 0)
+                goto error;
+            /* A crash may leave more than one segment unsealed.
+             * Only the last one is appended to.
+             */
+            if (unsealed && segment_seal (db, unsealed) < 0)
+                goto error;
+            unsealed = seg;
+        }
+    }
+    if (unsealed) {
+        if (unsealed == db->segs[db->nsegs - 1])
+            db->active = unsealed;
+        else if (segment_seal (db, unsealed) < 0)
+            goto error;
+    }
+    free (ids);
+    return 0;
+error:
+    free (ids);
+    return -1;
+}
+
+struct packdb *packdb_open (const char *dbpath,
+                            size_t segment_size,
+                            const char **errstr)
+{
+    struct packdb *db;
+
+    if (!dbpath || segment_size == 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(db = calloc (1, sizeof (*db))))
+        return NULL;
+    db->dirfd = -1;
+    db->segment_size = segment_size;
+    if (!(db->dbpath = strdup (dbpath)))
+        goto error;
+    if ((db->dirfd = open (dbpath, O_RDONLY | O_DIRECTORY)) < 0)
+        goto error;
+    if (table_rebuild (db, 0) < 0)
+        goto error;
+    if (packdb_load (db, errstr) < 0)
+        goto error;
+    return db;
+error:
+    packdb_close (db);
+    return NULL;
+}
+
+void packdb_close (struct packdb *db)
+{
+    if (db) {
+        int saved_errno = errno;
+        (void)packdb_sync (db, NULL);
+        for (int i = 0; i < db->nsegs; i++)
+            segment_destroy (db->segs[i]);
+        free (db->segs);
+        free (db->table);
+        if (db->dirfd >= 0)
+            (void)close (db->dirfd);
+        free (db->dbpath);
+        free (db);
+        errno = saved_errno;
+    }
+}
+
+static const char *entry_data (struct entry *e)
+{
+    return e->seg->base + e->offset + RECORD_HDR_SIZE + e->reflen;
+}
+
+int packdb_get (struct packdb *db,
+                const char *blobref,
+                const void **datap,
+                size_t *sizep)
+{
+    struct entry *e;
+
+    if (!db || !blobref) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!(e = table_find (db, blobref, strlen (blobref)))) {
+        errno = ENOENT;
+        return -1;
+    }
+    if (datap)
+        *datap = entry_data (e);
+    if (sizep)
+        *sizep = e->size;
+    return 0;
+}
+
+int packdb_has (struct packdb *db, const char *blobref)
+{
+    return packdb_get (db, blobref, NULL, NULL);
+}
+
+int packdb_put (struct packdb *db,
+                const char *blobref,
+                const void *data,
+                size_t size,
+                const char **errstr)
+{
+    size_t reflen;
+    struct segment *seg;
+    size_t offset;
+
+    if (!db || !blobref || (size > 0 && !data)) {
+        errno = EINVAL;
+        return -1;
+    }
+    reflen = strlen (blobref);
+    if (reflen == 0 || reflen >= BLOBREF_MAX_STRING_SIZE) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (size > UINT32_MAX) {
+        errno = EFBIG;
+        return -1;
+    }
+    if (table_find (db, blobref, reflen))
+        return 0;
+    if (record_append (db, blobref, reflen, data, size, &seg, &offset) < 0)
+        return -1;
+    if (index_entry (db,
+                     seg,
+                     seg->base + offset + RECORD_HDR_SIZE,
+                     reflen,
+                     offset,
+                     size) < 0)
+        return -1;
+    return 0;
+}
+
+bool packdb_dirty (struct packdb *db)
+{
+    return db && db->active && db->active->synced < db->active->used;
+}
+
+int packdb_sync (struct packdb *db, const char **errstr)
+{
+    if (!db) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (packdb_dirty (db)) {
+        if (fdatasync (db->active->fd) < 0)
+            return -1;
+        db->active->synced = db->active->used;
+    }
+    return sync_dir (db);
+}
+
+/* Remove the segments marked as victims, whose entries have already
+ * been dropped from the table.
+ */
+static void remove_victims (struct packdb *db)
+{
+    int n = 0;
+
+    for (int i = 0; i < db->nsegs; i++) {
+        struct segment *seg = db->segs[i];
+        if (seg->victim) {
+            char name[64];
+            snprintf (name, sizeof (name), "seg-%08u.idx", seg->id);
+            (void)unlinkat (db->dirfd, name, 0);
+            snprintf (name, sizeof (name), "seg-%08u", seg->id);
+            (void)unlinkat (db->dirfd, name, 0);
+            segment_destroy (seg);
+            db->dir_dirty = true;
+        }
+        else
+            db->segs[n++] = seg;
+    }
+    db->nsegs = n;
+}
+
+int packdb_compact (struct packdb *db,
+                    double threshold,
+                    packdb_live_f live,
+                    void *arg,
+                    int *segmentsp,
+                    size_t *blobsp,
+                    const char **errstr)
+{
+    int candidates;
+    int victims = 0;
+    size_t dropped = 0;
+
+    if (!db || !live || !(threshold > 0 && threshold <= 1)) {
+        errno = EINVAL;
+        return -1;
+    }
+    /* Segments are kept in order of id, with the active one last.
+     */
+    candidates = db->nsegs - (db->active ? 2 : 1);
+    for (int i = 0; i < db->nsegs; i++) {
+        db->segs[i]->live = 0;
+        db->segs[i]->victim = (i < candidates);
+    }
+    for (size_t i = 0; i < db->capacity; i++) {
+        struct entry *e = &db->table[i];
+        char blobref[BLOBREF_MAX_STRING_SIZE];
+
+        if (!e->ref || !e->seg->victim)
+            continue;
+        memcpy (blobref, e->ref, e->reflen);
+        blobref[e->reflen] = '\0';
+        e->live = live (blobref, arg) ? 1 : 0;
+        if (e->live)
+            e->seg->live += record_size (e->reflen, e->size);
+    }
+    for (int i = 0; i < candidates; i++) {
+        struct segment *seg = db->segs[i];
+        size_t total = seg->used - MAGIC_SIZE;
+
+        if ((double)seg->live < threshold * total)
+            victims++;
+        else
+            seg->victim = false;
+    }
+    if (victims == 0)
+        goto done;
+    /* Copy live blobs out of the victims.  Entries are updated in place,
+     * so the table may be walked while records are appended.
+     */
+    for (size_t i = 0; i < db->capacity; i++) {
+        struct entry *e = &db->table[i];
+        struct segment *seg;
+        size_t offset;
+
+        if (!e->ref || !e->seg->victim)
+            continue;
+        if (!e->live) {
+            dropped++;
+            continue;
+        }
+        if (record_append (db,
+                           e->ref,
+                           e->reflen,
+                           entry_data (e),
+                           e->size,
+                           &seg,
+                           &offset) < 0)
+            goto error;
+        e->seg = seg;
+        e->offset = offset;
+        e->ref = seg->base + offset + RECORD_HDR_SIZE;
+    }
+    if (packdb_sync (db, errstr) < 0)
+        goto error;
+    if (table_rebuild (db, db->count - dropped) < 0)
+        goto error;
+    remove_victims (db);
+    if (sync_dir (db) < 0)
+        goto error;
+done:
+    for (int i = 0; i < db->nsegs; i++)
+        db->segs[i]->victim = false;
+    if (segmentsp)
+        *segmentsp = victims;
+    if (blobsp)
+        *blobsp = dropped;
+    return 0;
+error:
+    /* Copies already made are harmless.  They are indexed in place of
+     * the originals, so the victims must not be removed.
+     */
+    for (int i = 0; i < db->nsegs; i++)
+        db->segs[i]->victim = false;
+    return -1;
+}
+
+static int meta_name (const char *key, char *buf, size_t size)
+{
+    if (!key
+        || *key == '\0'
+        || strchr (key, '/')
+        || snprintf (buf, size, "%s%s", META_PREFIX, key) >= size) {
+        errno = EINVAL;
+        return -1;
+    }
+    return 0;
+}
+
+int packdb_meta_get (struct packdb *db,
+                     const char *key,
+                     void **datap,
+                     size_t *sizep)
+{
+    char name[PATH_MAX];
+    void *data;
+    ssize_t size;
+    int fd;
+
+    if (!db || !datap || meta_name (key, name, sizeof (name)) < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    if ((fd = openat (db->dirfd, name, O_RDONLY)) < 0)
+        return -1;
+    size = read_all (fd, &data);
+    if (size < 0) {
+        int saved_errno = errno;
+        (void)close (fd);
+        errno = saved_errno;
+        return -1;
+    }
+    (void)close (fd);
+    *datap = data;
+    if (sizep)
+        *sizep = size;
+    return 0;
+}
+
+int packdb_meta_put (struct packdb *db,
+                     const char *key,
+                     const void *data,
+                     size_t size,
+                     const char **errstr)
+{
+    char name[PATH_MAX];
+    char tmp[PATH_MAX];
+    int fd;
+
+    if (!db
+        || (size > 0 && !data)
+        || meta_name (key, name, sizeof (name)) < 0
+        || snprintf (tmp, sizeof (tmp), "%s.tmp", name) >= sizeof (tmp)) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (packdb_sync (db, errstr) < 0)
+        return -1;
+    if ((fd = openat (db->dirfd, tmp, O_WRONLY | O_CREAT | O_TRUNC, 0600)) < 0)
+        return -1;
+    if (pwrite_all (fd, data, size, 0) < 0
+        || fdatasync (fd) < 0
+        || renameat (db->dirfd, tmp, db->dirfd, name) < 0) {
+        int saved_errno = errno;
+        (void)close (fd);
+        (void)unlinkat (db->dirfd, tmp, 0);
+        errno = saved_errno;
+        return -1;
+    }
+    (void)close (fd);
+    db->dir_dirty = true;
+    return sync_dir (db);
+}
+
+int packdb_meta_foreach (struct packdb *db, packdb_meta_f cb, void *arg)
+{
+    DIR *dir;
+    struct dirent *ent;
+    size_t plen = strlen (META_PREFIX);
+
+    if (!db || !cb) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!(dir = open_dir (db)))
+        return -1;
+    while ((ent = readdir (dir))) {
+        const char *key = ent->d_name + plen;
+        size_t len = strlen (ent->d_name);
+        void *data;
+        size_t size;
+
+        if (strncmp (ent->d_name, META_PREFIX, plen) != 0
+            || (len > 4 && !strcmp (ent->d_name + len - 4, ".tmp")))
+            continue;
+        if (packdb_meta_get (db, key, &data, &size) < 0)
+            continue;
+        cb (key, data, size, arg);
+        free (data);
+    }
+    (void)closedir (dir);
+    return 0;
+}
+
+void packdb_get_stats (struct packdb *db, struct packdb_stats *stats)
+{
+    if (db && stats) {
+        memset (stats, 0, sizeof (*stats));
+        stats->segments = db->nsegs;
+        stats->blobs = db->count;
+        for (int i = 0; i < db->nsegs; i++)
+            stats->bytes += db->segs[i]->used;
+    }
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,132 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _CONTENT_PACK_PACKDB_H
+#define _CONTENT_PACK_PACKDB_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* A packdb is a directory of append-only segment files holding blobs
+ * keyed by blobref.  It is not thread safe.
+ */
+struct packdb;
+
+struct packdb_stats {
+    int segments;           // segment files, including the active one
+    size_t blobs;           // distinct blobs indexed
+    size_t bytes;           // total size of segment files
+};
+
+/* Return true if the blob named 'blobref' should survive compaction.
+ */
+typedef bool (*packdb_live_f)(const char *blobref, void *arg);
+
+/* Open the packdb in existing directory 'dbpath', indexing its segments.
+ * A segment that was not sealed is scanned, and any torn record at its
+ * end is truncated.  New segments are started once the active one would
+ * exceed 'segment_size' bytes.
+ * On failure, NULL is returned with errno set.
+ * Pass '*errstr' in pre-set to NULL and if a human readable error message
+ * is appropriate, it is assigned on error (do not free).
+ */
+struct packdb *packdb_open (const char *dbpath,
+                            size_t segment_size,
+                            const char **errstr);
+
+/* Sync any pending appends, then close the packdb.
+ */
+void packdb_close (struct packdb *db);
+
+/* Look up the blob named 'blobref'.  On success, 'datap' and 'sizep' are
+ * assigned the blob content, which points into a read-only mapping of its
+ * segment, and remains valid until the next packdb_compact() or
+ * packdb_close().  Returns 0 on success, -1 with errno set (ENOENT if the
+ * blob is not stored).
+ */
+int packdb_get (struct packdb *db,
+                const char *blobref,
+                const void **datap,
+                size_t *sizep);
+
+/* Returns 0 if the blob named 'blobref' is stored, -1 with errno set
+ * (ENOENT if it is not).
+ */
+int packdb_has (struct packdb *db, const char *blobref);
+
+/* Append blob 'data' of length 'size' named 'blobref' to the active
+ * segment, unless it is already stored.  The append is not durable until
+ * the next packdb_sync().  Returns 0 on success, -1 with errno set.
+ * Pass '*errstr' in pre-set to NULL and if a human readable error message
+ * is appropriate, it is assigned on error (do not free).
+ */
+int packdb_put (struct packdb *db,
+                const char *blobref,
+                const void *data,
+                size_t size,
+                const char **errstr);
+
+/* Returns true if there are appends that have not been synced.
+ */
+bool packdb_dirty (struct packdb *db);
+
+/* Make all appends so far durable.  Returns 0 on success, -1 with errno set.
+ */
+int packdb_sync (struct packdb *db, const char **errstr);
+
+/* Rewrite the sealed segments in which the blobs for which 'live' returns
+ * true make up less than 'threshold' of the segment (0 < threshold <= 1),
+ * copying those blobs to the active segment, then remove them.  Blobs for
+ * which 'live' returns false are lost.  The active segment and the most
+ * recently sealed one are never rewritten, which spares blobs stored
+ * shortly before the caller determined what is live.
+ * On success, 0 is returned and the number of segments removed and
+ * blobs dropped are assigned to 'segmentsp' and 'blobsp' if non-NULL.
+ * On failure, -1 is returned with errno set.
+ */
+int packdb_compact (struct packdb *db,
+                    double threshold,
+                    packdb_live_f live,
+                    void *arg,
+                    int *segmentsp,
+                    size_t *blobsp,
+                    const char **errstr);
+
+/* Get/put a small value named 'key' stored beside the segments, replacing
+ * any existing value atomically.  Pending appends are synced before a put,
+ * so a value never refers to blobs that are not durable.  Returned data
+ * is NULL-terminated, with the terminator not included in 'sizep', and
+ * must be freed.  Return 0 on success, -1 with errno set.
+ */
+int packdb_meta_get (struct packdb *db,
+                     const char *key,
+                     void **datap,
+                     size_t *sizep);
+int packdb_meta_put (struct packdb *db,
+                     const char *key,
+                     const void *data,
+                     size_t size,
+                     const char **errstr);
+
+/* Call 'cb' with the value of each key stored by packdb_meta_put().
+ */
+typedef void (*packdb_meta_f)(const char *key,
+                              const void *data,
+                              size_t size,
+                              void *arg);
+int packdb_meta_foreach (struct packdb *db, packdb_meta_f cb, void *arg);
+
+void packdb_get_stats (struct packdb *db, struct packdb_stats *stats);
+
+#endif /* !_CONTENT_PACK_PACKDB_H */
+
+/*
+ * vi:ts=4 sw=4 expandtab
+ */
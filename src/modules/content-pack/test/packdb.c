@@ -0,0 +1,336 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/modules/content-pack/packdb.h"
+#include "src/common/libutil/blobref.h"
+#include "src/common/libutil/unlink_recursive.h"
+
+#define NBLOBS 100
+#define BLOBSIZE 200
+
+static char blobs[NBLOBS][BLOBSIZE];
+static char refs[NBLOBS][BLOBREF_MAX_STRING_SIZE];
+
+static void make_blobs (void)
+{
+    for (int i = 0; i < NBLOBS; i++) {
+        memset (blobs[i], 0, BLOBSIZE);
+        snprintf (blobs[i], BLOBSIZE, "blob %d", i);
+        if (blobref_hash ("sha1",
+                          blobs[i],
+                          BLOBSIZE,
+                          refs[i],
+                          sizeof (refs[i])) < 0)
+            BAIL_OUT ("blobref_hash failed");
+    }
+}
+
+static void make_dir (char *buf, size_t size, const char *dir, const char *sub)
+{
+    if (snprintf (buf, size, "%s/%s", dir, sub) >= size)
+        BAIL_OUT ("internal buffer overflow");
+    if (mkdir (buf, 0700) < 0)
+        BAIL_OUT ("mkdir %s failed", buf);
+}
+
+static int count_found (struct packdb *db, int start, int stride)
+{
+    int n = 0;
+
+    for (int i = start; i < NBLOBS; i += stride) {
+        const void *data;
+        size_t size;
+        if (packdb_get (db, refs[i], &data, &size) == 0
+            && size == BLOBSIZE
+            && memcmp (data, blobs[i], BLOBSIZE) == 0)
+            n++;
+    }
+    return n;
+}
+
+static bool is_even (const char *blobref, void *arg)
+{
+    for (int i = 0; i < NBLOBS; i += 2) {
+        if (!strcmp (refs[i], blobref))
+            return true;
+    }
+    return false;
+}
+
+void test_badargs (const char *dir)
+{
+    struct packdb *db;
+    const void *data;
+    size_t size;
+
+    errno = 0;
+    ok (packdb_open (NULL, 1024, NULL) == NULL && errno == EINVAL,
+        "packdb_open dbpath=NULL fails with EINVAL");
+    errno = 0;
+    ok (packdb_open (dir, 0, NULL) == NULL && errno == EINVAL,
+        "packdb_open segment_size=0 fails with EINVAL");
+    errno = 0;
+    ok (packdb_open ("/noexist", 1024, NULL) == NULL && errno == ENOENT,
+        "packdb_open dbpath=/noexist fails with ENOENT");
+
+    if (!(db = packdb_open (dir, 1024, NULL)))
+        BAIL_OUT ("packdb_open failed");
+    errno = 0;
+    ok (packdb_get (db, "sha1-noexist", &data, &size) < 0 && errno == ENOENT,
+        "packdb_get of unknown blob fails with ENOENT");
+    errno = 0;
+    ok (packdb_has (db, "sha1-noexist") < 0 && errno == ENOENT,
+        "packdb_has of unknown blob fails with ENOENT");
+    errno = 0;
+    ok (packdb_put (db, "", "x", 1, NULL) < 0 && errno == EINVAL,
+        "packdb_put blobref=\"\" fails with EINVAL");
+    errno = 0;
+    ok (packdb_put (db, "sha1-x", NULL, 1, NULL) < 0 && errno == EINVAL,
+        "packdb_put data=NULL size=1 fails with EINVAL");
+    errno = 0;
+    ok (packdb_meta_put (db, "a/b", "x", 1, NULL) < 0 && errno == EINVAL,
+        "packdb_meta_put key=\"a/b\" fails with EINVAL");
+    errno = 0;
+    ok (packdb_compact (db, 0, is_even, NULL, NULL, NULL, NULL) < 0
+        && errno == EINVAL,
+        "packdb_compact threshold=0 fails with EINVAL");
+    packdb_close (db);
+
+    lives_ok ({packdb_close (NULL);},
+        "packdb_close db=NULL doesnt crash");
+}
+
+void test_simple (const char *dir)
+{
+    struct packdb *db;
+    struct packdb_stats stats;
+    const void *data;
+    size_t size;
+
+    if (!(db = packdb_open (dir, 1024*1024, NULL)))
+        BAIL_OUT ("packdb_open failed");
+    ok (packdb_put (db, refs[0], blobs[0], BLOBSIZE, NULL) == 0,
+        "packdb_put works");
+    ok (packdb_dirty (db),
+        "packdb is dirty");
+    ok (packdb_get (db, refs[0], &data, &size) == 0
+        && size == BLOBSIZE
+        && memcmp (data, blobs[0], BLOBSIZE) == 0,
+        "packdb_get returns blob before sync");
+    ok (packdb_has (db, refs[0]) == 0,
+        "packdb_has finds blob");
+    ok (packdb_sync (db, NULL) == 0 && !packdb_dirty (db),
+        "packdb_sync works");
+    ok (packdb_sync (db, NULL) == 0,
+        "packdb_sync with nothing to sync works");
+    ok (packdb_put (db, refs[0], blobs[0], BLOBSIZE, NULL) == 0
+        && !packdb_dirty (db),
+        "packdb_put of a stored blob does not append it again");
+    ok (packdb_put (db, "sha1-empty", NULL, 0, NULL) == 0
+        && packdb_get (db, "sha1-empty", &data, &size) == 0
+        && size == 0,
+        "packdb_put of empty blob works");
+    packdb_get_stats (db, &stats);
+    ok (stats.segments == 1 && stats.blobs == 2,
+        "packdb_get_stats reports 1 segment and 2 blobs");
+    packdb_close (db);
+
+    /* The empty blob does not match its made up blobref, so it is
+     * discarded as torn when the unsealed segment is scanned.
+     */
+    if (!(db = packdb_open (dir, 1024*1024, NULL)))
+        BAIL_OUT ("packdb_open failed");
+    ok (packdb_get (db, refs[0], &data, &size) == 0
+        && size == BLOBSIZE
+        && memcmp (data, blobs[0], BLOBSIZE) == 0,
+        "blob survives reopen");
+    ok (packdb_has (db, "sha1-empty") < 0 && errno == ENOENT,
+        "record that does not match its blobref was truncated");
+    packdb_close (db);
+}
+
+void test_segments (const char *dir)
+{
+    struct packdb *db;
+    struct packdb_stats stats;
+    char path[1024];
+    struct stat sb;
+    int segments;
+    int removed;
+    size_t dropped;
+
+    if (!(db = packdb_open (dir, 4096, NULL)))
+        BAIL_OUT ("packdb_open failed");
+    for (int i = 0; i < NBLOBS; i++) {
+        if (packdb_put (db, refs[i], blobs[i], BLOBSIZE, NULL) < 0)
+            BAIL_OUT ("packdb_put failed");
+    }
+    packdb_get_stats (db, &stats);
+    segments = stats.segments;
+    ok (segments > 1 && stats.blobs == NBLOBS,
+        "%d blobs were spread over %d segments", NBLOBS, segments);
+    ok (count_found (db, 0, 1) == NBLOBS,
+        "all blobs can be read back");
+    packdb_close (db);
+
+    snprintf (path, sizeof (path), "%s/seg-00000000.idx", dir);
+    ok (stat (path, &sb) == 0,
+        "first segment was sealed with an index");
+
+    if (!(db = packdb_open (dir, 4096, NULL)))
+        BAIL_OUT ("packdb_open failed");
+    packdb_get_stats (db, &stats);
+    ok (stats.segments == segments && stats.blobs == NBLOBS,
+        "reopened packdb has the same segments and blobs");
+    ok (count_found (db, 0, 1) == NBLOBS,
+        "all blobs can be read back after reopen");
+
+    ok (packdb_compact (db, 0.9, is_even, NULL, &removed, &dropped, NULL) == 0
+        && removed > 0 && removed <= segments - 2 && dropped > 0,
+        "packdb_compact removed half empty segments");
+    diag ("removed %d segments, dropped %zu blobs", removed, dropped);
+    ok (count_found (db, 0, 2) == NBLOBS / 2,
+        "live blobs can be read back");
+    ok (count_found (db, 1, 2) < NBLOBS / 2,
+        "some dead blobs are gone");
+    packdb_close (db);
+
+    if (!(db = packdb_open (dir, 4096, NULL)))
+        BAIL_OUT ("packdb_open failed");
+    ok (count_found (db, 0, 2) == NBLOBS / 2,
+        "live blobs can be read back after reopen");
+    packdb_close (db);
+}
+
+void test_torn (const char *dir)
+{
+    struct packdb *db;
+    char path[1024];
+    int fd;
+
+    if (!(db = packdb_open (dir, 1024*1024, NULL)))
+        BAIL_OUT ("packdb_open failed");
+    for (int i = 0; i < 10; i++) {
+        if (packdb_put (db, refs[i], blobs[i], BLOBSIZE, NULL) < 0)
+            BAIL_OUT ("packdb_put failed");
+    }
+    packdb_close (db);
+
+    /* Simulate a crash part way through an append.
+     */
+    snprintf (path, sizeof (path), "%s/seg-00000000", dir);
+    if ((fd = open (path, O_WRONLY | O_APPEND)) < 0
+        || write (fd, "\x50\x4b\x52\x42\0\0\0\x2d", 8) != 8
+        || close (fd) < 0)
+        BAIL_OUT ("could not append to %s", path);
+
+    ok ((db = packdb_open (dir, 1024*1024, NULL)) != NULL,
+        "packdb_open works with a torn record");
+    ok (count_found (db, 0, 1) == 10,
+        "blobs before the torn record can be read back");
+    ok (packdb_put (db, refs[10], blobs[10], BLOBSIZE, NULL) == 0,
+        "packdb_put works");
+    packdb_close (db);
+
+    if (!(db = packdb_open (dir, 1024*1024, NULL)))
+        BAIL_OUT ("packdb_open failed");
+    ok (count_found (db, 0, 1) == 11,
+        "blob appended after the torn record was truncated can be read back");
+    packdb_close (db);
+}
+
+static void meta_cb (const char *key, const void *data, size_t size, void *arg)
+{
+    int *count = arg;
+
+    if (!strcmp (key, "kvs-primary") && size == 3 && !memcmp (data, "baz", 3))
+        (*count)++;
+}
+
+void test_meta (const char *dir)
+{
+    struct packdb *db;
+    void *data;
+    size_t size;
+    int count = 0;
+
+    if (!(db = packdb_open (dir, 1024*1024, NULL)))
+        BAIL_OUT ("packdb_open failed");
+    errno = 0;
+    ok (packdb_meta_get (db, "kvs-primary", &data, &size) < 0
+        && errno == ENOENT,
+        "packdb_meta_get of unknown key fails with ENOENT");
+    ok (packdb_put (db, refs[0], blobs[0], BLOBSIZE, NULL) == 0
+        && packdb_meta_put (db, "kvs-primary", "bar", 3, NULL) == 0,
+        "packdb_meta_put works");
+    ok (!packdb_dirty (db),
+        "packdb_meta_put synced pending appends");
+    ok (packdb_meta_get (db, "kvs-primary", &data, &size) == 0
+        && size == 3
+        && !strcmp (data, "bar"),
+        "packdb_meta_get returns value");
+    free (data);
+    ok (packdb_meta_put (db, "kvs-primary", "baz", 3, NULL) == 0
+        && packdb_meta_foreach (db, meta_cb, &count) == 0
+        && count == 1,
+        "packdb_meta_foreach returns the updated value");
+    packdb_close (db);
+}
+
+int main (int argc, char *argv[])
+{
+    char dir[1024];
+    char sub[1024];
+    const char *tmp = getenv ("TMPDIR");
+
+    plan (NO_PLAN);
+
+    if (!tmp)
+        tmp = "/tmp";
+    if (snprintf (dir, sizeof (dir), "%s/packdb.XXXXXX", tmp) >= sizeof (dir))
+        BAIL_OUT ("internal buffer ovverflow");
+    if (!mkdtemp (dir))
+        BAIL_OUT ("mkdtemp failed");
+    diag ("mkdir %s", dir);
+
+    make_blobs ();
+
+    make_dir (sub, sizeof (sub), dir, "badargs");
+    test_badargs (sub);
+    make_dir (sub, sizeof (sub), dir, "simple");
+    test_simple (sub);
+    make_dir (sub, sizeof (sub), dir, "segments");
+    test_segments (sub);
+    make_dir (sub, sizeof (sub), dir, "torn");
+    test_torn (sub);
+    make_dir (sub, sizeof (sub), dir, "meta");
+    test_meta (sub);
+
+    if (unlink_recursive (dir) < 0)
+        BAIL_OUT ("unlink_recursive failed");
+
+    done_testing ();
+    return (0);
+}
+
+// vi: ts=4 sw=4 expandtab
@@ -11,11 +11,15 @@
 #if HAVE_CONFIG_H
 #include "config.h"
 #endif
+#include <pthread.h>
+#include <inttypes.h>
+#include <czmq.h>
 #include <jansson.h>
 #include <flux/core.h>
 
 #include "src/common/libutil/blobref.h"
 #include "src/common/libutil/log.h"
+#include "src/common/libutil/blobbatch.h"
 
 #include "src/common/libcontent/content-util.h"
 
@@ -26,11 +30,46 @@
 
 #include "s3.h"
 
+/* The content-backing requests are handled on a pool of worker threads
+ * (see flux_module_set_workers(3)), each with its own keep-alive
+ * connections to the endpoint, so a slow request does not stall the
+ * module reactor or other requests.  Within a batch, up to 16 objects
+ * are transferred concurrently.
+ *
+ * If pack-threshold is set, blobs of up to that size that arrive in the
+ * same store-batch request are stored together in one "pack-<blobref>"
+ * object, which is listed in a "packidx-<blobref>" object with one
+ * "<blobref> <offset> <size>" line per blob.  The pack indexes are read
+ * at module load and kept in memory, and packed blobs are loaded with
+ * ranged gets.
+ */
+#define DEFAULT_WORKERS 4
+
+#define PACK_PREFIX     "pack-"
+#define PACKIDX_PREFIX  "packidx-"
+#define PACK_KEY_SIZE   (BLOBREF_MAX_STRING_SIZE + 16)
+
+struct pack_entry {
+    char pack[PACK_KEY_SIZE];
+    uint64_t offset;
+    size_t size;
+};
+
 struct content_s3 {
     flux_msg_handler_t **handlers;
+    flux_msg_handler_t **backing_handlers;
     struct s3_config *cfg;
     flux_t *h;
     const char *hashfun;
+    struct s3_worker *local;    // if workers = 0
+
+    pthread_mutex_t lock;       // protects packs
+    zhashx_t *packs;            // blobref => struct pack_entry
+};
+
+struct s3_worker {
+    struct content_s3 *ctx;
+    struct s3_conn *conn;
 };
 
 static void s3_config_destroy (struct s3_config *ctx)
@@ -48,12 +87,51 @@ static void s3_config_destroy (struct s3_config *ctx)
 
 /* Destroy module context.
  */
+static void free_pack_entry (void **item)
+{
+    if (item) {
+        free (*item);
+        *item = NULL;
+    }
+}
+
+static void s3_worker_destroy (struct s3_worker *w)
+{
+    if (w) {
+        int saved_errno = errno;
+        s3_conn_destroy (w->conn);
+        free (w);
+        errno = saved_errno;
+    }
+}
+
+static struct s3_worker *s3_worker_create (struct content_s3 *ctx)
+{
+    struct s3_worker *w;
+    const char *errstr = NULL;
+
+    if (!(w = calloc (1, sizeof (*w))))
+        return NULL;
+    w->ctx = ctx;
+    if (!(w->conn = s3_conn_create (&errstr))) {
+        flux_log (ctx->h, LOG_ERR, "s3_conn_create: %s",
+                  errstr ? errstr : strerror (errno));
+        s3_worker_destroy (w);
+        return NULL;
+    }
+    return w;
+}
+
 static void content_s3_destroy (struct content_s3 *ctx)
 {
     if (ctx) {
         int saved_errno = errno;
         flux_msg_handler_delvec (ctx->handlers);
+        flux_msg_handler_delvec (ctx->backing_handlers);
+        s3_worker_destroy (ctx->local);
         s3_config_destroy (ctx->cfg);
+        zhashx_destroy (&ctx->packs);
+        pthread_mutex_destroy (&ctx->lock);
         free (ctx);
         errno = saved_errno;
     }
@@ -150,10 +228,12 @@ static struct s3_config *parse_config (const flux_conf_t *conf,
 
     cfg->retries = 5;
     cfg->is_secure = 0;
+    cfg->workers = DEFAULT_WORKERS;
+    cfg->pack_threshold = 0;
 
     if (flux_conf_unpack (conf,
                           &error,
-                          "{s:{s:s, s:s, s:s, s?:b !} }",
+                          "{s:{s:s, s:s, s:s, s?:b s?:i s?:i !} }",
                           "content-s3",
                           "credential-file",
                           &cred_file,
@@ -162,10 +242,24 @@ static struct s3_config *parse_config (const flux_conf_t *conf,
                           "uri",
                           &uri,
                           "virtual-host-style",
-                          &is_virtual_host) < 0) {
+                          &is_virtual_host,
+                          "workers",
+                          &cfg->workers,
+                          "pack-threshold",
+                          &cfg->pack_threshold) < 0) {
         snprintf(errbuff, eb_size, "%s", error.errbuf);
         goto error;
     }
+    if (cfg->workers < 0 || cfg->workers > 256) {
+        snprintf (errbuff, eb_size, "workers must be from 0 to 256");
+        errno = EINVAL;
+        goto error;
+    }
+    if (cfg->pack_threshold < 0) {
+        snprintf (errbuff, eb_size, "pack-threshold must be >= 0");
+        errno = EINVAL;
+        goto error;
+    }
 
     if (!(cpy = strdup (uri)))
         goto error;
@@ -226,7 +320,7 @@ static void config_reload_cb (flux_t *h,
         errstr = errbuf;
         goto error;
     }
-    free (cfg);
+    s3_config_destroy (cfg);
     flux_log (h, LOG_WARNING, "config-reload: changes will not take effect until next flux restart");
 
     if (flux_set_conf (h, flux_conf_incref (conf)) < 0) {
@@ -243,6 +337,122 @@ error:
         flux_log_error (h, "error responding to config-reload request");
 }
 
+/* Look up 'blobref' in the pack index.  If found, point 'obj' at its
+ * range in the pack object and return true.
+ * N.B. entries are never removed while the module is running, so the
+ * pack key remains valid after the lock is dropped.
+ */
+static bool pack_lookup (struct content_s3 *ctx,
+                         const char *blobref,
+                         struct s3_object *obj)
+{
+    struct pack_entry *entry;
+
+    if (ctx->cfg->pack_threshold == 0 && zhashx_size (ctx->packs) == 0)
+        return false;
+    pthread_mutex_lock (&ctx->lock);
+    entry = zhashx_lookup (ctx->packs, blobref);
+    pthread_mutex_unlock (&ctx->lock);
+    if (!entry)
+        return false;
+    obj->key = entry->pack;
+    obj->offset = entry->offset;
+    obj->count = entry->size;
+    return true;
+}
+
+/* Add an entry to the pack index.  If 'blobref' is already indexed,
+ * keep the existing entry.
+ */
+static int pack_insert (struct content_s3 *ctx,
+                        const char *blobref,
+                        const char *pack,
+                        uint64_t offset,
+                        size_t size)
+{
+    struct pack_entry *entry;
+
+    if (!(entry = calloc (1, sizeof (*entry))))
+        return -1;
+    if (snprintf (entry->pack, sizeof (entry->pack), "%s", pack)
+                  >= sizeof (entry->pack)) {
+        free (entry);
+        errno = EINVAL;
+        return -1;
+    }
+    entry->offset = offset;
+    entry->size = size;
+    pthread_mutex_lock (&ctx->lock);
+    if (zhashx_insert (ctx->packs, blobref, entry) < 0)
+        free (entry);
+    pthread_mutex_unlock (&ctx->lock);
+    return 0;
+}
+
+/* Parse pack index 'buf' for pack object 'pack' into the pack index.
+ */
+static int pack_index_parse (struct content_s3 *ctx,
+                             const char *pack,
+                             char *buf)
+{
+    char *saveptr = NULL;
+    char *line;
+
+    for (line = strtok_r (buf, "\n", &saveptr);
+         line != NULL;
+         line = strtok_r (NULL, "\n", &saveptr)) {
+        char blobref[BLOBREF_MAX_STRING_SIZE];
+        uintmax_t offset;
+        size_t size;
+
+        if (sscanf (line, "%71s %ju %zu", blobref, &offset, &size) != 3
+            || blobref_validate (blobref) < 0) {
+            errno = EPROTO;
+            return -1;
+        }
+        if (pack_insert (ctx, blobref, pack, offset, size) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+static int pack_index_load_cb (const char *key, void *arg)
+{
+    struct content_s3 *ctx = arg;
+    char pack[PACK_KEY_SIZE];
+    void *data = NULL;
+    size_t size;
+    char *buf;
+    int rc;
+
+    if (snprintf (pack, sizeof (pack), PACK_PREFIX "%s",
+                  key + strlen (PACKIDX_PREFIX)) >= sizeof (pack)) {
+        flux_log (ctx->h, LOG_ERR, "%s: key is too long", key);
+        return 0;
+    }
+    if (s3_get (ctx->cfg, key, &data, &size, NULL) < 0)
+        return -1;
+    if (!(buf = strndup (data, size))) {
+        free (data);
+        return -1;
+    }
+    free (data);
+    if ((rc = pack_index_parse (ctx, pack, buf)) < 0)
+        flux_log_error (ctx->h, "%s", key);
+    free (buf);
+    return rc;
+}
+
+/* Load blobs named by 'objs[i].key' (blobrefs), from packs if indexed.
+ * On return objs[i].key may point to a pack key.
+ */
+static int load_objects (struct s3_worker *w, struct s3_object *objs, int n)
+{
+    for (int i = 0; i < n; i++)
+        (void)pack_lookup (w->ctx, objs[i].key, &objs[i]);
+    return s3_get_multi (w->ctx->cfg, w->conn, objs, n);
+}
+
 /* Handle a content-backing.load request from the rank 0 broker's
  * content-cache service.  The raw request payload is a blobref string,
  * including NULL terminator.  The raw response payload is the blob content.
@@ -250,11 +460,10 @@ error:
  */
 static void load_cb (flux_t *h, flux_msg_handler_t *mh, const flux_msg_t *msg, void *arg)
 {
-    struct content_s3 *ctx = arg;
+    struct s3_worker *w = arg;
     const char *blobref;
     int blobref_size;
-    void *data = NULL;
-    size_t size;
+    struct s3_object obj = { 0 };
     const char *errstr = NULL;
 
     if (flux_request_decode_raw (msg,
@@ -268,17 +477,19 @@ static void load_cb (flux_t *h, flux_msg_handler_t *mh, const flux_msg_t *msg, v
         errstr = "invalid blobref";
         goto error;
     }
-    if (s3_get (ctx->cfg, blobref, &data, &size, &errstr) < 0)
+    obj.key = blobref;
+    if (load_objects (w, &obj, 1) < 0) {
+        errstr = obj.errstr;
         goto error;
-    if (flux_respond_raw (h, msg, data, size) < 0)
+    }
+    if (flux_respond_raw (h, msg, obj.data, obj.size) < 0)
         flux_log_error (h, "error responding to load request");
-    free (data);
+    free (obj.data);
     return;
 
 error:
     if (flux_respond_error (h, msg, errno, errstr) < 0)
         flux_log_error (h, "error responding to load request");
-    free (data);
 }
 
 /* Handle a content-backing.store request from the rank 0 broker's
@@ -288,22 +499,28 @@ error:
  */
 void store_cb (flux_t *h, flux_msg_handler_t *mh, const flux_msg_t *msg, void *arg)
 {
-    struct content_s3 *ctx = arg;
+    struct s3_worker *w = arg;
     const void *data;
     int size;
     char blobref[BLOBREF_MAX_STRING_SIZE];
+    struct s3_object obj = { 0 };
     const char *errstr = NULL;
 
     if (flux_request_decode_raw (msg, NULL, &data, &size) < 0)
         goto error;
-    if (blobref_hash (ctx->hashfun,
+    if (blobref_hash (w->ctx->hashfun,
                       (uint8_t *)data,
                       size,
                       blobref,
                       sizeof (blobref)) < 0)
         goto error;
-    if (s3_put (ctx->cfg, blobref, data, size, &errstr) < 0)
+    obj.key = blobref;
+    obj.data = (void *)data;
+    obj.size = size;
+    if (s3_put_multi (w->ctx->cfg, w->conn, &obj, 1) < 0) {
+        errstr = obj.errstr;
         goto error;
+    }
     if (flux_respond_raw (h, msg, blobref, strlen (blobref) + 1) < 0)
         flux_log_error (h, "error responding to store request");
     return;
@@ -313,6 +530,265 @@ error:
         flux_log_error (h, "error responding to store request");
 }
 
+/* Handle a content-backing.load-batch request.  The raw request payload
+ * is a batch of blobref strings, and the raw response payload a batch of
+ * blobs in the same order (see blobbatch.h).  A blob that could not be
+ * loaded is recorded as an error in its place in the response.
+ */
+static void load_batch_cb (flux_t *h, flux_msg_handler_t *mh, const flux_msg_t *msg, void *arg)
+{
+    struct s3_worker *w = arg;
+    const void *buf;
+    int len;
+    struct blobbatch *req = NULL;
+    struct blobbatch *rsp = NULL;
+    struct s3_object *objs = NULL;
+    int count = 0;
+    const char *errstr = NULL;
+    int i;
+
+    if (flux_request_decode_raw (msg, NULL, &buf, &len) < 0)
+        goto error;
+    if (!(req = blobbatch_decode (buf, len))) {
+        errstr = "malformed batch";
+        goto error;
+    }
+    if (!(rsp = blobbatch_create ()))
+        goto error;
+    count = blobbatch_count (req);
+    if (!(objs = calloc (count ? count : 1, sizeof (objs[0]))))
+        goto error;
+    for (i = 0; i < count; i++) {
+        const char *blobref;
+
+        if (!(blobref = blobbatch_get_string (req, i))
+            || blobref_validate (blobref) < 0)
+            objs[i].key = ""; // fails key validation with EINVAL
+        else
+            objs[i].key = blobref;
+    }
+    (void)load_objects (w, objs, count);
+    for (i = 0; i < count; i++) {
+        int rc;
+
+        if (objs[i].errnum == EINVAL)
+            rc = blobbatch_append_error (rsp, EPROTO);
+        else if (objs[i].errnum != 0)
+            rc = blobbatch_append_error (rsp, objs[i].errnum);
+        else
+            rc = blobbatch_append (rsp, objs[i].data, objs[i].size);
+        if (rc < 0)
+            goto error;
+    }
+    blobbatch_encode (rsp, &buf, &len);
+    if (flux_respond_raw (h, msg, buf, len) < 0)
+        flux_log_error (h, "error responding to load-batch request");
+    goto done;
+
+error:
+    if (flux_respond_error (h, msg, errno, errstr) < 0)
+        flux_log_error (h, "error responding to load-batch request");
+done:
+    if (objs) {
+        for (i = 0; i < count; i++)
+            free (objs[i].data);
+        free (objs);
+    }
+    blobbatch_destroy (req);
+    blobbatch_destroy (rsp);
+}
+
+/* Store the blobs in 'objs' whose size is within the pack threshold in
+ * one pack object, then record them in a new pack index object and in
+ * the in-memory pack index.  Each packed object is marked done by giving
+ * it a NULL key, or it is left for s3_put_multi() if packing fails.
+ * Blobs that are already packed are not stored again.
+ */
+static void store_pack (struct s3_worker *w, struct s3_object *objs, int n)
+{
+    struct content_s3 *ctx = w->ctx;
+    char *pack = NULL;
+    size_t pack_size = 0;
+    uint64_t *offsets = NULL;
+    char *idx = NULL;
+    size_t idx_size = 0;
+    FILE *f = NULL;
+    char ref[BLOBREF_MAX_STRING_SIZE];
+    char pack_key[PACK_KEY_SIZE];
+    char idx_key[PACK_KEY_SIZE];
+    struct s3_object put[2] = { { 0 } };
+    int npacked = 0;
+    int i;
+
+    for (i = 0; i < n; i++) {
+        struct s3_object tmp;
+
+        if (objs[i].size > ctx->cfg->pack_threshold)
+            continue;
+        if (pack_lookup (ctx, objs[i].key, &tmp))
+            objs[i].key = NULL;
+        else
+            npacked++;
+    }
+    if (npacked < 2)
+        return;
+    if (!(offsets = calloc (n, sizeof (offsets[0])))
+        || !(f = open_memstream (&pack, &pack_size)))
+        goto done;
+    for (i = 0; i < n; i++) {
+        if (!objs[i].key || objs[i].size > ctx->cfg->pack_threshold)
+            continue;
+        offsets[i] = ftell (f);
+        if (objs[i].size > 0 && fwrite (objs[i].data, objs[i].size, 1, f) != 1)
+            goto done;
+    }
+    if (fclose (f) != 0) {
+        f = NULL;
+        goto done;
+    }
+    if (!(f = open_memstream (&idx, &idx_size)))
+        goto done;
+    for (i = 0; i < n; i++) {
+        if (!objs[i].key || objs[i].size > ctx->cfg->pack_threshold)
+            continue;
+        fprintf (f, "%s %ju %zu\n", objs[i].key,
+                 (uintmax_t)offsets[i], objs[i].size);
+    }
+    if (fclose (f) != 0) {
+        f = NULL;
+        goto done;
+    }
+    f = NULL;
+    if (blobref_hash (ctx->hashfun, pack, pack_size, ref, sizeof (ref)) < 0)
+        goto done;
+    (void)snprintf (pack_key, sizeof (pack_key), PACK_PREFIX "%s", ref);
+    (void)snprintf (idx_key, sizeof (idx_key), PACKIDX_PREFIX "%s", ref);
+
+    /* Store the pack before its index, so an index never names a
+     * missing pack.
+     */
+    put[0].key = pack_key;
+    put[0].data = pack;
+    put[0].size = pack_size;
+    put[1].key = idx_key;
+    put[1].data = idx;
+    put[1].size = idx_size;
+    if (s3_put_multi (ctx->cfg, w->conn, &put[0], 1) < 0
+        || s3_put_multi (ctx->cfg, w->conn, &put[1], 1) < 0) {
+        flux_log (ctx->h, LOG_ERR, "error storing %s: %s", pack_key,
+                  put[0].errstr ? put[0].errstr
+                  : put[1].errstr ? put[1].errstr : "failed");
+        goto done; // fall back to storing blobs individually
+    }
+    for (i = 0; i < n; i++) {
+        if (!objs[i].key || objs[i].size > ctx->cfg->pack_threshold)
+            continue;
+        if (pack_insert (ctx, objs[i].key, pack_key, offsets[i],
+                         objs[i].size) < 0)
+            flux_log_error (ctx->h, "error indexing %s", objs[i].key);
+        objs[i].key = NULL;
+    }
+done:
+    if (f)
+        fclose (f);
+    free (offsets);
+    free (pack);
+    free (idx);
+}
+
+/* Handle a content-backing.store-batch request.  The raw request payload
+ * is a batch of blobs, and the raw response payload a batch of blobref
+ * strings in the same order.
+ */
+static void store_batch_cb (flux_t *h, flux_msg_handler_t *mh, const flux_msg_t *msg, void *arg)
+{
+    struct s3_worker *w = arg;
+    struct content_s3 *ctx = w->ctx;
+    const void *buf;
+    int len;
+    struct blobbatch *req = NULL;
+    struct blobbatch *rsp = NULL;
+    struct s3_object *objs = NULL;
+    char (*refs)[BLOBREF_MAX_STRING_SIZE] = NULL;
+    int *errnums = NULL;
+    int count = 0;
+    int nput = 0;
+    int nrest;
+    const char *errstr = NULL;
+    int i;
+
+    if (flux_request_decode_raw (msg, NULL, &buf, &len) < 0)
+        goto error;
+    if (!(req = blobbatch_decode (buf, len))) {
+        errstr = "malformed batch";
+        goto error;
+    }
+    if (!(rsp = blobbatch_create ()))
+        goto error;
+    count = blobbatch_count (req);
+    if (!(objs = calloc (count ? count : 1, sizeof (objs[0])))
+        || !(refs = calloc (count ? count : 1, sizeof (refs[0])))
+        || !(errnums = calloc (count ? count : 1, sizeof (errnums[0]))))
+        goto error;
+    for (i = 0; i < count; i++) {
+        const void *data;
+        int size;
+
+        if (blobbatch_get (req, i, &data, &size) < 0
+            || blobref_hash (ctx->hashfun,
+                             (uint8_t *)data,
+                             size,
+                             refs[i],
+                             sizeof (refs[i])) < 0) {
+            errnums[i] = errno;
+            continue;
+        }
+        objs[nput].key = refs[i];
+        objs[nput].data = (void *)data;
+        objs[nput].size = size;
+        nput++;
+    }
+    if (ctx->cfg->pack_threshold > 0)
+        store_pack (w, objs, nput);
+
+    /* Compact away objects that were packed, and put the rest.
+     */
+    for (i = 0, nrest = 0; i < nput; i++) {
+        if (objs[i].key)
+            objs[nrest++] = objs[i];
+    }
+    (void)s3_put_multi (ctx->cfg, w->conn, objs, nrest);
+    for (i = 0, nput = 0; i < count; i++) {
+        if (errnums[i] == 0 && nput < nrest && objs[nput].key == refs[i])
+            errnums[i] = objs[nput++].errnum;
+    }
+
+    for (i = 0; i < count; i++) {
+        int rc;
+
+        if (errnums[i] != 0)
+            rc = blobbatch_append_error (rsp, errnums[i]);
+        else
+            rc = blobbatch_append (rsp, refs[i], strlen (refs[i]) + 1);
+        if (rc < 0)
+            goto error;
+    }
+    blobbatch_encode (rsp, &buf, &len);
+    if (flux_respond_raw (h, msg, buf, len) < 0)
+        flux_log_error (h, "error responding to store-batch request");
+    goto done;
+
+error:
+    if (flux_respond_error (h, msg, errno, errstr) < 0)
+        flux_log_error (h, "error responding to store-batch request");
+done:
+    free (objs);
+    free (refs);
+    free (errnums);
+    blobbatch_destroy (req);
+    blobbatch_destroy (rsp);
+}
+
 /* Handle a kvs-checkpoint.get request from the rank 0 kvs module.
  * The KVS stores its last root reference here for restart purposes.
  *
@@ -386,18 +862,52 @@ error:
         flux_log_error (h, "error responding to kvs-checkpoint.put request");
 }
 
-/* Table of message handler callbacks registered below.
+/* Tables of message handler callbacks registered below.
  * The topic strings in the table consist of <service name>.<method>.
+ * The backing_htab handlers run in the worker threads, if any, and are
+ * passed a struct s3_worker.
  */
-static const struct flux_msg_handler_spec htab[] = {
+static const struct flux_msg_handler_spec backing_htab[] = {
     { FLUX_MSGTYPE_REQUEST, "content-backing.load",    load_cb, 0 },
     { FLUX_MSGTYPE_REQUEST, "content-backing.store",   store_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST, "content-backing.load-batch", load_batch_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST, "content-backing.store-batch", store_batch_cb, 0 },
+    FLUX_MSGHANDLER_TABLE_END,
+};
+
+static const struct flux_msg_handler_spec htab[] = {
     { FLUX_MSGTYPE_REQUEST, "kvs-checkpoint.get", checkpoint_get_cb, 0 },
     { FLUX_MSGTYPE_REQUEST, "kvs-checkpoint.put", checkpoint_put_cb, 0 },
     { FLUX_MSGTYPE_REQUEST, "content-s3.config-reload", config_reload_cb, 0 },
     FLUX_MSGHANDLER_TABLE_END,
 };
 
+/* Worker thread main for flux_module_set_workers().
+ */
+static int worker_main (flux_t *h, int index, void *arg)
+{
+    struct content_s3 *ctx = arg;
+    struct s3_worker *w;
+    flux_msg_handler_t **handlers = NULL;
+    int rc = -1;
+
+    if (!(w = s3_worker_create (ctx)))
+        return -1;
+    if (flux_msg_handler_addvec (h, backing_htab, w, &handlers) < 0) {
+        flux_log_error (h, "flux_msg_handler_addvec");
+        goto done;
+    }
+    if (flux_reactor_run (flux_get_reactor (h), 0) < 0) {
+        flux_log_error (h, "flux_reactor_run");
+        goto done;
+    }
+    rc = 0;
+done:
+    flux_msg_handler_delvec (handlers);
+    s3_worker_destroy (w);
+    return rc;
+}
+
 /* Create the s3 context, initalize the connection, and
  * create the working bucket
  */
@@ -410,6 +920,10 @@ static struct content_s3 *content_s3_create (flux_t *h)
     if (!(ctx = calloc (1, sizeof (*ctx))))
         return NULL;
     ctx->h = h;
+    pthread_mutex_init (&ctx->lock, NULL);
+    if (!(ctx->packs = zhashx_new ()))
+        goto nomem;
+    zhashx_set_destructor (ctx->packs, (zhashx_destructor_fn *)free_pack_entry);
 
     if (!(ctx->hashfun = flux_attr_get (h, "content.hash"))) {
         flux_log_error (h, "content.hash");
@@ -432,11 +946,31 @@ static struct content_s3 *content_s3_create (flux_t *h)
         goto error;
     }
 
+    if (s3_list (ctx->cfg,
+                 PACKIDX_PREFIX,
+                 pack_index_load_cb,
+                 ctx,
+                 &errstr) < 0) {
+        flux_log (h, LOG_ERR, "content-s3 loading pack indexes: %s",
+                  errstr ? errstr : strerror (errno));
+        goto error;
+    }
+
     if (flux_msg_handler_addvec (h, htab, ctx, &ctx->handlers) < 0)
         goto error;
+    if (ctx->cfg->workers == 0) {
+        if (!(ctx->local = s3_worker_create (ctx))
+            || flux_msg_handler_addvec (h,
+                                        backing_htab,
+                                        ctx->local,
+                                        &ctx->backing_handlers) < 0)
+            goto error;
+    }
 
     return ctx;
 
+nomem:
+    errno = ENOMEM;
 error:
     content_s3_destroy (ctx);
     return NULL;
@@ -451,6 +985,30 @@ int mod_main (flux_t *h, int argc, char **argv)
         flux_log_error (h, "content_s3_create failed");
         return -1;
     }
+    /* The workers are joined when the module handle is closed, after
+     * mod_main() returns, so the context they share must live until then.
+     * Handle aux items are destroyed in reverse order of creation, so
+     * setting it before the workers are started ensures they are joined
+     * before it is destroyed.
+     */
+    if (flux_aux_set (h,
+                      "content-s3",
+                      ctx,
+                      (flux_free_f)content_s3_destroy) < 0) {
+        content_s3_destroy (ctx);
+        return -1;
+    }
+    if (ctx->cfg->workers > 0) {
+        if (flux_module_set_workers (h,
+                                     ctx->cfg->workers,
+                                     "content-backing.*",
+                                     NULL,
+                                     worker_main,
+                                     ctx) < 0) {
+            flux_log_error (h, "flux_module_set_workers");
+            return -1;
+        }
+    }
     if (content_register_backing_store (h, "content-s3") < 0)
         goto done;
     if (content_register_service (h, "content-backing") < 0)
@@ -466,7 +1024,6 @@ int mod_main (flux_t *h, int argc, char **argv)
 
     rc = 0;
 done:
-    content_s3_destroy (ctx);
     return rc;
 }
 
@@ -17,6 +17,7 @@
 #include <stdio.h>
 #include <libs3.h>
 #include <stdlib.h>
+#include <stdbool.h>
 
 #include "src/common/libutil/errno_safe.h"
 
@@ -34,8 +35,18 @@
     S3_put_object(ctx, key, size, prop, req, 0, cb, data)
 #define S3_get_object(ctx, key, cond, start, cnt, req, cb, data) \
     S3_get_object(ctx, key, cond, start, cnt, req, 0, cb, data)
+#define S3_list_bucket(ctx, prefix, marker, delim, max, req, cb, data) \
+    S3_list_bucket(ctx, prefix, marker, delim, max, req, 0, cb, data)
 #endif
 
+/* Requests started at once by s3_put_multi() and s3_get_multi().
+ */
+#define S3_MAX_INFLIGHT 16
+
+struct s3_conn {
+    S3RequestContext *req;
+};
+
 static S3Protocol protocol = S3ProtocolHTTP;
 static S3UriStyle uri_style = S3UriStylePath;
 
@@ -116,6 +127,56 @@ void s3_cleanup (void)
     S3_deinitialize ();
 }
 
+struct s3_conn *s3_conn_create (const char **errstr)
+{
+    struct s3_conn *conn;
+    S3Status status;
+
+    if (!(conn = calloc (1, sizeof (*conn))))
+        return NULL;
+    if ((status = S3_create_request_context (&conn->req)) != S3StatusOK) {
+        free (conn);
+        errno = ENOMEM;
+        if (errstr)
+            *errstr = S3_get_status_name (status);
+        return NULL;
+    }
+    return conn;
+}
+
+void s3_conn_destroy (struct s3_conn *conn)
+{
+    if (conn) {
+        int saved_errno = errno;
+        S3_destroy_request_context (conn->req);
+        free (conn);
+        errno = saved_errno;
+    }
+}
+
+static int validate_key (const char *key, const char **errstr)
+{
+    if (strlen (key) == 0 || strchr (key, '/') || !strcmp (key, "..")
+                          || !strcmp (key, ".")) {
+        errno = EINVAL;
+        if (errstr)
+            *errstr = "invalid key";
+        return -1;
+    }
+    return 0;
+}
+
+static void bucket_context_init (struct s3_config *cfg, S3BucketContext *ctx)
+{
+    memset (ctx, 0, sizeof (*ctx));
+    ctx->hostName = NULL;
+    ctx->bucketName = cfg->bucket;
+    ctx->protocol = protocol;
+    ctx->uriStyle = uri_style;
+    ctx->accessKeyId = cfg->access_key;
+    ctx->secretAccessKey = cfg->secret_key;
+}
+
 int s3_bucket_create (struct s3_config *cfg, const char **errstr)
 {
     int retries = cfg->retries;
@@ -298,6 +359,287 @@ int s3_get (struct s3_config *cfg, const char *key, void **datap, size_t *sizep,
     return 0;
 }
 
+/* Set the result of 'obj' from a completed request.
+ */
+static void set_result (struct s3_object *obj, S3Status status, bool get)
+{
+    if (status == S3StatusOK)
+        obj->errnum = 0;
+    else {
+        if (get && status == S3StatusErrorNoSuchKey)
+            obj->errnum = ENOENT;
+        else
+            obj->errnum = EREMOTEIO;
+        obj->errstr = S3_get_status_name (status);
+    }
+}
+
+/* Start the requests for the pending objects in a window of 'n' objects
+ * on 'conn', then run them all to completion, retrying those that fail
+ * with a retryable status.  Finally set each object's result.
+ */
+typedef void (*start_f)(S3BucketContext *bucket_ctx,
+                        struct s3_conn *conn,
+                        struct s3_object *obj,
+                        struct cb_data *cbd);
+
+static void run_window (struct s3_config *cfg,
+                        S3BucketContext *bucket_ctx,
+                        struct s3_conn *conn,
+                        struct s3_object *win,
+                        int n,
+                        bool get,
+                        start_f start)
+{
+    struct cb_data cbd[S3_MAX_INFLIGHT];
+    bool pending[S3_MAX_INFLIGHT];
+    int retries = cfg->retries;
+    int npending = 0;
+
+    memset (cbd, 0, sizeof (cbd));
+    for (int i = 0; i < n; i++) {
+        win[i].errnum = 0;
+        win[i].errstr = NULL;
+        if (get) {
+            win[i].data = NULL;
+            win[i].size = 0;
+        }
+        if (validate_key (win[i].key, &win[i].errstr) < 0) {
+            win[i].errnum = errno;
+            pending[i] = false;
+        }
+        else {
+            pending[i] = true;
+            npending++;
+        }
+    }
+    while (npending > 0 && retries-- > 0) {
+        for (int i = 0; i < n; i++) {
+            if (pending[i]) {
+                cbd[i].status = S3StatusOK;
+                start (bucket_ctx, conn, &win[i], &cbd[i]);
+            }
+        }
+        (void)S3_runall_request_context (conn->req);
+        for (int i = 0; i < n; i++) {
+            if (pending[i] && (cbd[i].status == S3StatusOK
+                               || !S3_status_is_retryable (cbd[i].status))) {
+                pending[i] = false;
+                npending--;
+            }
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        if (win[i].errnum != 0)
+            continue;
+        set_result (&win[i], cbd[i].status, get);
+        if (get) {
+            if (win[i].errnum == 0
+                && win[i].count > 0 && cbd[i].size != win[i].count) {
+                win[i].errnum = EREMOTEIO;
+                win[i].errstr = "short read";
+            }
+            if (win[i].errnum == 0) {
+                win[i].data = cbd[i].data;
+                win[i].size = cbd[i].size;
+            }
+            else
+                free (cbd[i].data);
+        }
+    }
+}
+
+static int multi_result (struct s3_object *objs, int count)
+{
+    for (int i = 0; i < count; i++) {
+        if (objs[i].errnum != 0) {
+            errno = objs[i].errnum;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static void start_put (S3BucketContext *bucket_ctx,
+                       struct s3_conn *conn,
+                       struct s3_object *obj,
+                       struct cb_data *cbd)
+{
+    static S3PutObjectHandler put_obj_hndl = {
+        .responseHandler = {
+            .propertiesCallback = &response_props_cb,
+            .completeCallback = &response_complete_cb
+        },
+        .putObjectDataCallback = &put_object_cb
+    };
+
+    cbd->data = obj->data;
+    cbd->size = obj->size;
+    cbd->count = 0;
+    S3_put_object (bucket_ctx,
+                   obj->key,
+                   obj->size,
+                   NULL, // putProperties (NULL for none)
+                   conn->req,
+                   &put_obj_hndl,
+                   cbd);
+}
+
+static void start_get (S3BucketContext *bucket_ctx,
+                       struct s3_conn *conn,
+                       struct s3_object *obj,
+                       struct cb_data *cbd)
+{
+    static S3GetObjectHandler get_obj_hndl = {
+        .responseHandler = {
+            .propertiesCallback = &response_props_cb,
+            .completeCallback = &response_complete_cb
+        },
+        .getObjectDataCallback = &get_object_cb
+    };
+
+    free (cbd->data); // discard partial data from a failed attempt
+    cbd->data = NULL;
+    cbd->size = 0;
+    cbd->count = 0;
+    S3_get_object (bucket_ctx,
+                   obj->key,
+                   NULL, // getConditions (NULL for none)
+                   obj->offset,
+                   obj->count,
+                   conn->req,
+                   &get_obj_hndl,
+                   cbd);
+}
+
+static int run_multi (struct s3_config *cfg,
+                      struct s3_conn *conn,
+                      struct s3_object *objs,
+                      int count,
+                      bool get,
+                      start_f start)
+{
+    S3BucketContext bucket_ctx;
+
+    bucket_context_init (cfg, &bucket_ctx);
+    for (int i = 0; i < count; i += S3_MAX_INFLIGHT) {
+        int n = count - i < S3_MAX_INFLIGHT ? count - i : S3_MAX_INFLIGHT;
+        run_window (cfg, &bucket_ctx, conn, objs + i, n, get, start);
+    }
+    return multi_result (objs, count);
+}
+
+int s3_put_multi (struct s3_config *cfg,
+                  struct s3_conn *conn,
+                  struct s3_object *objs,
+                  int count)
+{
+    return run_multi (cfg, conn, objs, count, false, start_put);
+}
+
+int s3_get_multi (struct s3_config *cfg,
+                  struct s3_conn *conn,
+                  struct s3_object *objs,
+                  int count)
+{
+    return run_multi (cfg, conn, objs, count, true, start_get);
+}
+
+struct list_data {
+    s3_list_f cb;
+    void *arg;
+    int errnum;
+    bool truncated;
+    char *marker;
+    S3Status status;
+};
+
+static void list_complete_cb (S3Status status,
+                              const S3ErrorDetails *error,
+                              void *data)
+{
+    struct list_data *ctx = data;
+    ctx->status = status;
+}
+
+static S3Status list_bucket_cb (int is_truncated,
+                                const char *next_marker,
+                                int contents_count,
+                                const S3ListBucketContent *contents,
+                                int common_prefixes_count,
+                                const char **common_prefixes,
+                                void *data)
+{
+    struct list_data *ctx = data;
+    const char *last = NULL;
+
+    for (int i = 0; i < contents_count; i++) {
+        if (ctx->cb (contents[i].key, ctx->arg) < 0) {
+            ctx->errnum = errno;
+            return S3StatusAbortedByCallback;
+        }
+        last = contents[i].key;
+    }
+    ctx->truncated = is_truncated ? true : false;
+    if (next_marker)
+        last = next_marker;
+    if (last) {
+        free (ctx->marker);
+        if (!(ctx->marker = strdup (last))) {
+            ctx->errnum = ENOMEM;
+            return S3StatusAbortedByCallback;
+        }
+    }
+    return S3StatusOK;
+}
+
+int s3_list (struct s3_config *cfg,
+             const char *prefix,
+             s3_list_f cb,
+             void *arg,
+             const char **errstr)
+{
+    S3BucketContext bucket_ctx;
+    S3ListBucketHandler list_hndl = {
+        .responseHandler = {
+            .propertiesCallback = &response_props_cb,
+            .completeCallback = &list_complete_cb
+        },
+        .listBucketCallback = &list_bucket_cb
+    };
+    struct list_data ctx = { .cb = cb, .arg = arg };
+
+    bucket_context_init (cfg, &bucket_ctx);
+    do {
+        int retries = cfg->retries;
+
+        ctx.truncated = false;
+        do {
+            ctx.status = S3StatusOK;
+            S3_list_bucket (&bucket_ctx,
+                            prefix,
+                            ctx.marker,
+                            NULL, // delimiter
+                            0,    // maxkeys (0 for the server default)
+                            NULL, // requestContext (NULL for synchronous operation)
+                            &list_hndl,
+                            &ctx);
+            retries--;
+        } while (ctx.errnum == 0
+                 && S3_status_is_retryable (ctx.status)
+                 && retries > 0);
+        if (ctx.errnum != 0 || ctx.status != S3StatusOK) {
+            errno = ctx.errnum ? ctx.errnum : EREMOTEIO;
+            if (errstr && ctx.errnum == 0)
+                *errstr = S3_get_status_name (ctx.status);
+            free (ctx.marker);
+            return -1;
+        }
+    } while (ctx.truncated);
+    free (ctx.marker);
+    return 0;
+}
+
 /*
  * vi:ts=4 sw=4 expandtab
  */
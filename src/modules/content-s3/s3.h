@@ -11,6 +11,9 @@
 #ifndef _CONTENT_S3_S3_H
 #define _CONTENT_S3_S3_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 /* Configuration info needed for all s3 calls
  */
 struct s3_config {
@@ -21,6 +24,8 @@ struct s3_config {
     char *access_key;   // access key id string
     char *secret_key;   // secret access key id string
     char *hostname;     // hostname string
+    int workers;        // number of worker threads
+    int pack_threshold; // pack blobs up to this size, 0 = disabled
 };
 
 /* Initialize the s3 connection.
@@ -64,6 +69,52 @@ int s3_get(struct s3_config *cfg,
            size_t *sizep,
            const char **errstr);
 
+/* A connection context holding keep-alive connections to the endpoint,
+ * for use by s3_put_multi() and s3_get_multi().  A context may only be
+ * used by one thread at a time.
+ */
+struct s3_conn;
+
+struct s3_conn *s3_conn_create (const char **errstr);
+void s3_conn_destroy (struct s3_conn *conn);
+
+/* An object for s3_put_multi() or s3_get_multi().
+ */
+struct s3_object {
+    const char *key;
+    void *data;         // put: data to store, get: result (caller frees)
+    size_t size;        // put: size of data, get: size of result
+    uint64_t offset;    // get: first byte to read
+    uint64_t count;     // get: number of bytes to read, or 0 for all
+    int errnum;         // result: 0 on success, or errno
+    const char *errstr; // result: human readable error, if any
+};
+
+/* Put or get 'count' objects, running up to 16 requests concurrently on
+ * 'conn'.  The result of each is set in its 'errnum'.  Returns 0 if all
+ * succeeded, or -1 with errno set to the first failure.
+ */
+int s3_put_multi (struct s3_config *cfg,
+                  struct s3_conn *conn,
+                  struct s3_object *objs,
+                  int count);
+int s3_get_multi (struct s3_config *cfg,
+                  struct s3_conn *conn,
+                  struct s3_object *objs,
+                  int count);
+
+/* Call 'cb' with the key of each object in the bucket that starts with
+ * 'prefix'.  If 'cb' returns -1, stop and fail with its errno.
+ * Returns 0 on success, -1 on failure with errno set.
+ */
+typedef int (*s3_list_f)(const char *key, void *arg);
+
+int s3_list (struct s3_config *cfg,
+             const char *prefix,
+             s3_list_f cb,
+             void *arg,
+             const char **errstr);
+
 #endif
 
 /*
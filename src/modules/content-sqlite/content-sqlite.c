@@ -8,34 +8,132 @@
  * SPDX-License-Identifier: LGPL-3.0
 \************************************************************/
 
-/* content-sqlite.c - content addressable storage with sqlite back end */
+/* content-sqlite.c - content addressable storage with sqlite back end
+ *
+ * Stores are grouped into transactions to reduce the sync rate.  A
+ * transaction is committed once the broker has no more requests ready
+ * for the module, or once it contains txn_max blobs, and store responses
+ * are deferred until then.  A checkpoint put first commits any pending
+ * transaction, so a checkpoint never refers to blobs that are not yet
+ * stored.  Likewise, a content-backing.has response that reports a blob
+ * in the open transaction is deferred until it commits.
+ *
+ * Module options:
+ *   journal-mode=MODE    sqlite journal_mode pragma (default WAL)
+ *   synchronous=MODE     sqlite synchronous pragma (default OFF)
+ *   mmap-size=BYTES      sqlite mmap_size pragma (default: sqlite's)
+ *   cache-size=N         sqlite cache_size pragma (default: sqlite's)
+ *   transaction-max=N    maximum blobs per transaction (default 1024)
+ *   codec=NAME           compress new blobs with none, lz4 (default), or zstd
+ *   zstd-level=N         zstd compression level (default 3)
+ *   zstd-dict=PATH       compress with a trained zstd dictionary
+ *   compression-threshold=N  compress blobs >= N bytes (default 256)
+ *   gc-batch=N           rows examined per garbage collection batch
+ *                        (default 1024)
+ *
+ * Each row records the codec used to store it, so the codec may change
+ * between runs.  Rows from before the codec column was added have NULL
+ * there, and are LZ4 compressed if their size is not -1.  A zstd frame
+ * carries the ID of its dictionary, if any, and dictionaries are kept in
+ * the dicts table so that any blob stored with one can be loaded later.
+ *
+ * A content-backing.gc request deletes the blobs that cannot be reached
+ * from the KVS, while the instance runs.  The rows present when it starts
+ * are the candidates.  Blobs reachable from the checkpointed roots and
+ * the current root of each namespace are marked in a bloom filter, by
+ * walking the KVS through the content service, so that blobs not yet
+ * written back are seen.  Blobs loaded, stored, or probed while the run
+ * is active are marked too, as they may become reachable again behind
+ * its back, and the content and KVS caches are dropped at the start so
+ * that reuse of a blob passes through here.  Once the walk is done, the
+ * roots are fetched and walked again, to take in commits that raced with
+ * the start of the run.  Then the candidates are swept in batches of
+ * gc-batch rows on a timer, deleting those not marked.  A false positive
+ * only keeps a garbage blob for another run.  Progress is reported in
+ * the "gc" object of content-backing.stats.get, and the request is
+ * answered when the run is done.
+ *
+ * Deleting blobs is only safe if everything that refers to them is
+ * reachable from the KVS.  Blobs stored by other means, such as
+ * flux content store, are deleted by the next run, and a blob that a
+ * cache on another rank holds clean may be deduplicated there against
+ * a deleted copy.  An ephemeral namespace keeps part of its tree outside
+ * the content store, so garbage collection fails with ENOTSUP while one
+ * exists.
+ */
 
 #if HAVE_CONFIG_H
 #include "config.h"
 #endif
+#include <limits.h>
+#include <strings.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <sqlite3.h>
 #include <czmq.h>
+#include <jansson.h>
 #include <lz4.h>
+#if HAVE_ZSTD
+#include <zstd.h>
+#endif
 #include <flux/core.h>
 
 #include "src/common/libutil/blobref.h"
 #include "src/common/libutil/log.h"
 #include "src/common/libutil/errno_safe.h"
+#include "src/common/libutil/blobbatch.h"
+#include "src/common/libutil/read_all.h"
+#include "src/common/libutil/bloom.h"
+#include "src/common/libkvs/treeobj.h"
 
 #include "src/common/libcontent/content-util.h"
 
-const size_t lzo_buf_chunksize = 1024*1024;
-const size_t compression_threshold = 256; /* compress blobs >= this size */
+const size_t codec_buf_chunksize = 1024*1024;
+const int default_compression_threshold = 256;
+const int default_zstd_level = 3;
+const int default_txn_max = 1024;
+const int default_gc_batch = 1024;
+const double gc_sweep_delay = 0.01;
+
+/* Garbage collection keeps up to GC_MAX_INFLIGHT loads and KVS requests
+ * in flight while marking, and sizes its bloom filter at GC_BLOOM_BITS
+ * bits per candidate row, for a false positive rate of about 1%.
+ */
+#define GC_MAX_INFLIGHT 256
+#define GC_BLOOM_BITS 10
+#define GC_BLOOM_HASHES 7
+
+enum {
+    CODEC_NONE = 0,
+    CODEC_LZ4 = 1,
+    CODEC_ZSTD = 2,
+    CODEC_COUNT,
+};
+
+static const char *codec_names[] = { "none", "lz4", "zstd" };
 
 const char *sql_create_table = "CREATE TABLE if not exists objects("
                                "  hash CHAR(20) PRIMARY KEY,"
                                "  size INT,"
-                               "  object BLOB"
+                               "  object BLOB,"
+                               "  codec INT"
                                ");";
-const char *sql_load = "SELECT object,size FROM objects"
+const char *sql_check_codec = "SELECT codec FROM objects LIMIT 0";
+const char *sql_add_codec = "ALTER TABLE objects ADD COLUMN codec INT";
+const char *sql_load = "SELECT object,size,codec FROM objects"
                        "  WHERE hash = ?1 LIMIT 1";
-const char *sql_store = "INSERT INTO objects (hash,size,object) "
-                        "  values (?1, ?2, ?3)";
+const char *sql_has = "SELECT 1 FROM objects"
+                      "  WHERE hash = ?1 LIMIT 1";
+const char *sql_store = "INSERT INTO objects (hash,size,object,codec) "
+                        "  values (?1, ?2, ?3, ?4)";
+
+const char *sql_create_table_dicts = "CREATE TABLE if not exists dicts("
+                                     "  id INT PRIMARY KEY,"
+                                     "  dict BLOB"
+                                     ");";
+const char *sql_dict_get = "SELECT dict FROM dicts WHERE id = ?1";
+const char *sql_dict_put = "INSERT OR IGNORE INTO dicts (id,dict) "
+                           "  values (?1, ?2)";
 
 const char *sql_create_table_checkpt = "CREATE TABLE if not exists checkpt("
                                        "  key TEXT UNIQUE,"
@@ -45,6 +143,50 @@ const char *sql_checkpt_get = "SELECT value FROM checkpt"
                               "  WHERE key = ?1";
 const char *sql_checkpt_put = "REPLACE INTO checkpt (key,value) "
                               "  values (?1, ?2)";
+const char *sql_checkpt_list = "SELECT value FROM checkpt";
+
+const char *sql_gc_horizon = "SELECT max(rowid) FROM objects";
+const char *sql_gc_scan = "SELECT rowid,hash,length(object) FROM objects"
+                          "  WHERE rowid > ?1 AND rowid <= ?2"
+                          "  ORDER BY rowid LIMIT ?3";
+const char *sql_gc_delete = "DELETE FROM objects WHERE rowid = ?1";
+
+enum {
+    GC_IDLE = 0,
+    GC_MARK = 1,
+    GC_SWEEP = 2,
+};
+
+static const char *gc_state_names[] = { "idle", "mark", "sweep" };
+
+/* State of the garbage collection run, if any, and totals over all runs
+ * since the module was loaded.
+ */
+struct content_gc {
+    int state;
+    const flux_msg_t *request;  // content-backing.gc request of this run
+    struct bloom *marked;       // blobrefs that must be kept
+    zhashx_t *visited;          // dir blobrefs already queued
+    zlist_t *dirs;              // dir blobrefs to load and walk
+    int inflight;
+    bool remark;                // second walk from the latest roots
+    int errnum;
+    char errstr[128];
+    int64_t horizon;            // last rowid that is a candidate
+    int64_t cursor;             // last rowid swept
+    int64_t *rowids;            // rows to delete in a sweep batch
+    int64_t *sizes;
+    flux_watcher_t *sweep_w;
+    double t_start;
+    int64_t roots;
+    int64_t dirs_walked;
+    int64_t scanned;
+    int64_t deleted;
+    int64_t deleted_bytes;
+    int64_t runs;
+    int64_t total_deleted;
+    int64_t total_deleted_bytes;
+};
 
 struct content_sqlite {
     flux_msg_handler_t **handlers;
@@ -52,14 +194,63 @@ struct content_sqlite {
     sqlite3 *db;
     sqlite3_stmt *load_stmt;
     sqlite3_stmt *store_stmt;
+    sqlite3_stmt *has_stmt;
     sqlite3_stmt *checkpt_get_stmt;
     sqlite3_stmt *checkpt_put_stmt;
+    sqlite3_stmt *gc_scan_stmt;
+    sqlite3_stmt *gc_delete_stmt;
     flux_t *h;
     const char *hashfun;
-    size_t lzo_bufsize;
-    void *lzo_buf;
+    size_t codec_bufsize;
+    void *codec_buf;
+    const char *journal_mode;
+    const char *synchronous;
+    long long mmap_size;        // -1 = sqlite default
+    long long cache_size;
+    bool cache_size_set;
+    int txn_max;
+    bool txn_active;            // BEGIN has been issued
+    int txn_count;              // blobs stored in the open transaction
+    zlist_t *txn_responses;     // responses deferred until COMMIT
+    flux_watcher_t *check_w;
+    int codec;                  // codec for new blobs
+    int compression_threshold;
+    int zstd_level;
+    const char *zstd_dict_path;
+    unsigned int zstd_dict_id;
+    struct codec_stats {
+        int64_t count;
+        int64_t raw_bytes;
+        int64_t stored_bytes;
+    } stats[CODEC_COUNT];       // blobs stored since module load, by codec
+    int gc_batch;
+    struct content_gc gc;
+#if HAVE_ZSTD
+    ZSTD_CCtx *cctx;
+    ZSTD_DCtx *dctx;
+    ZSTD_CDict *cdict;
+    zhashx_t *ddicts;           // dictionary ID => ZSTD_DDict
+    sqlite3_stmt *dict_get_stmt;
+    sqlite3_stmt *dict_put_stmt;
+#endif
+};
+
+/* A store response held until the transaction that contains it commits.
+ */
+struct txn_response {
+    const flux_msg_t *msg;
+    void *buf;
+    int len;
 };
 
+/* Mark 'blobref' to be kept by an active garbage collection run.
+ */
+static void gc_touch (struct content_sqlite *ctx, const char *blobref)
+{
+    if (ctx->gc.state != GC_IDLE)
+        bloom_add (ctx->gc.marked, blobref, strlen (blobref));
+}
+
 static void log_sqlite_error (struct content_sqlite *ctx, const char *fmt, ...)
 {
     char buf[64];
@@ -108,18 +299,202 @@ static void set_errno_from_sqlite_error (struct content_sqlite *ctx)
     }
 }
 
-static int grow_lzo_buf (struct content_sqlite *ctx, size_t size)
+static int grow_codec_buf (struct content_sqlite *ctx, size_t size)
 {
-    size_t newsize = ctx->lzo_bufsize;
+    size_t newsize = ctx->codec_bufsize;
     void *newbuf;
     while (newsize < size)
-        newsize += lzo_buf_chunksize;
-    if (!(newbuf = realloc (ctx->lzo_buf, newsize))) {
+        newsize += codec_buf_chunksize;
+    if (!(newbuf = realloc (ctx->codec_buf, newsize))) {
+        errno = ENOMEM;
+        return -1;
+    }
+    ctx->codec_bufsize = newsize;
+    ctx->codec_buf = newbuf;
+    return 0;
+}
+
+#if HAVE_ZSTD
+static void ddict_destroy (void **item)
+{
+    if (item) {
+        ZSTD_freeDDict (*item);
+        *item = NULL;
+    }
+}
+
+/* Get the decompression dictionary identified by 'id', reading it from
+ * the dicts table the first time it is needed.
+ */
+static ZSTD_DDict *get_ddict (struct content_sqlite *ctx, unsigned int id)
+{
+    ZSTD_DDict *ddict;
+    char key[16];
+
+    snprintf (key, sizeof (key), "%u", id);
+    if ((ddict = zhashx_lookup (ctx->ddicts, key)))
+        return ddict;
+    if (sqlite3_bind_int64 (ctx->dict_get_stmt, 1, id) != SQLITE_OK) {
+        log_sqlite_error (ctx, "load: binding dict id");
+        set_errno_from_sqlite_error (ctx);
+        goto error;
+    }
+    if (sqlite3_step (ctx->dict_get_stmt) != SQLITE_ROW) {
+        flux_log (ctx->h, LOG_ERR, "load: zstd dictionary %u not found", id);
+        errno = EINVAL;
+        goto error;
+    }
+    if (!(ddict = ZSTD_createDDict (
+                    sqlite3_column_blob (ctx->dict_get_stmt, 0),
+                    sqlite3_column_bytes (ctx->dict_get_stmt, 0)))) {
         errno = ENOMEM;
+        goto error;
+    }
+    (void)zhashx_insert (ctx->ddicts, key, ddict);
+    sqlite3_reset (ctx->dict_get_stmt);
+    return ddict;
+error:
+    ERRNO_SAFE_WRAP (sqlite3_reset, ctx->dict_get_stmt);
+    return NULL;
+}
+#endif
+
+/* Decompress 'size' bytes of 'data' stored with 'codec' to ctx->codec_buf,
+ * which must have room for 'uncompressed_size' bytes.
+ * Returns 0 on success, -1 on error with errno set.
+ */
+static int codec_decompress (struct content_sqlite *ctx,
+                             int codec,
+                             const void *data,
+                             int size,
+                             int uncompressed_size)
+{
+    int r;
+
+    switch (codec) {
+        case CODEC_LZ4:
+            r = LZ4_decompress_safe (data,
+                                     ctx->codec_buf,
+                                     size,
+                                     uncompressed_size);
+            if (r < 0) {
+                errno = EINVAL;
+                return -1;
+            }
+            break;
+#if HAVE_ZSTD
+        case CODEC_ZSTD: {
+            unsigned int id = ZSTD_getDictID_fromFrame (data, size);
+            size_t n;
+
+            if (id != 0) {
+                ZSTD_DDict *ddict;
+                if (!(ddict = get_ddict (ctx, id)))
+                    return -1;
+                n = ZSTD_decompress_usingDDict (ctx->dctx,
+                                                ctx->codec_buf,
+                                                uncompressed_size,
+                                                data,
+                                                size,
+                                                ddict);
+            }
+            else
+                n = ZSTD_decompressDCtx (ctx->dctx,
+                                         ctx->codec_buf,
+                                         uncompressed_size,
+                                         data,
+                                         size);
+            if (ZSTD_isError (n)) {
+                errno = EINVAL;
+                return -1;
+            }
+            r = n;
+            break;
+        }
+#endif
+        default:
+            flux_log (ctx->h, LOG_ERR, "load: unsupported codec %d", codec);
+            errno = EINVAL;
+            return -1;
+    }
+    if (r != uncompressed_size) {
+        flux_log (ctx->h, LOG_ERR, "load: blob size mismatch");
+        errno = EINVAL;
         return -1;
     }
-    ctx->lzo_bufsize = newsize;
-    ctx->lzo_buf = newbuf;
+    return 0;
+}
+
+/* Compress 'size' bytes of 'data' with the configured codec, if it is
+ * large enough, placing the result in ctx->codec_buf.  If the result
+ * would be no smaller, the blob is stored uncompressed.  On success,
+ * '*codecp' is set to the codec used and '*sizep' to the stored size.
+ * Returns 0 on success, -1 on error with errno set.
+ */
+static int codec_compress (struct content_sqlite *ctx,
+                           const void *data,
+                           int size,
+                           int *codecp,
+                           int *sizep)
+{
+    int r = 0;
+
+    *codecp = CODEC_NONE;
+    *sizep = size;
+    if (size < ctx->compression_threshold || size == 0)
+        return 0;
+    switch (ctx->codec) {
+        case CODEC_LZ4: {
+            int out_len = LZ4_compressBound (size);
+            if (ctx->codec_bufsize < out_len
+                && grow_codec_buf (ctx, out_len) < 0)
+                return -1;
+            if ((r = LZ4_compress_default (data,
+                                           ctx->codec_buf,
+                                           size,
+                                           out_len)) == 0) {
+                errno = EINVAL;
+                return -1;
+            }
+            break;
+        }
+#if HAVE_ZSTD
+        case CODEC_ZSTD: {
+            size_t out_len = ZSTD_compressBound (size);
+            size_t n;
+
+            if (ctx->codec_bufsize < out_len
+                && grow_codec_buf (ctx, out_len) < 0)
+                return -1;
+            if (ctx->cdict)
+                n = ZSTD_compress_usingCDict (ctx->cctx,
+                                              ctx->codec_buf,
+                                              out_len,
+                                              data,
+                                              size,
+                                              ctx->cdict);
+            else
+                n = ZSTD_compressCCtx (ctx->cctx,
+                                       ctx->codec_buf,
+                                       out_len,
+                                       data,
+                                       size,
+                                       ctx->zstd_level);
+            if (ZSTD_isError (n)) {
+                errno = EINVAL;
+                return -1;
+            }
+            r = n;
+            break;
+        }
+#endif
+        default:
+            return 0;
+    }
+    if (r < size) {
+        *codecp = ctx->codec;
+        *sizep = r;
+    }
     return 0;
 }
 
@@ -138,6 +513,7 @@ static int content_sqlite_load (struct content_sqlite *ctx,
     const void *data = NULL;
     int size = 0;
     int uncompressed_size;
+    int codec;
 
     if ((hash_len = blobref_strtohash (blobref, hash, sizeof (hash))) < 0) {
         errno = ENOENT;
@@ -171,26 +547,25 @@ static int content_sqlite_load (struct content_sqlite *ctx,
         goto error;
     }
     uncompressed_size = sqlite3_column_int (ctx->load_stmt, 1);
-    if (uncompressed_size != -1) {
-        if (ctx->lzo_bufsize < uncompressed_size
-                                && grow_lzo_buf (ctx, uncompressed_size) < 0)
-            goto error;
-        int r = LZ4_decompress_safe (data,
-                                     ctx->lzo_buf,
-                                     size,
-                                     uncompressed_size);
-        if (r < 0) {
+    if (sqlite3_column_type (ctx->load_stmt, 2) == SQLITE_NULL)
+        codec = uncompressed_size == -1 ? CODEC_NONE : CODEC_LZ4;
+    else
+        codec = sqlite3_column_int (ctx->load_stmt, 2);
+    if (codec != CODEC_NONE) {
+        if (uncompressed_size < 0) {
+            flux_log (ctx->h, LOG_ERR, "load: invalid blob size");
             errno = EINVAL;
             goto error;
         }
-        if (r != uncompressed_size) {
-            flux_log (ctx->h, LOG_ERR, "load: blob size mismatch");
-            errno = EINVAL;
+        if (ctx->codec_bufsize < uncompressed_size
+                                && grow_codec_buf (ctx, uncompressed_size) < 0)
             goto error;
-        }
-        data = ctx->lzo_buf;
+        if (codec_decompress (ctx, codec, data, size, uncompressed_size) < 0)
+            goto error;
+        data = ctx->codec_buf;
         size = uncompressed_size;
     }
+    gc_touch (ctx, blobref);
     *datap = data;
     *sizep = size;
     return 0;
@@ -199,6 +574,39 @@ error:
     return -1;
 }
 
+/* Check whether blob is in objects table.
+ * Returns 0 if it is, -1 with errno set (ENOENT if it is not).
+ */
+static int content_sqlite_has (struct content_sqlite *ctx, const char *blobref)
+{
+    uint8_t hash[BLOBREF_MAX_DIGEST_SIZE];
+    int hash_len;
+    int rc = -1;
+
+    if ((hash_len = blobref_strtohash (blobref, hash, sizeof (hash))) < 0) {
+        errno = ENOENT;
+        return -1;
+    }
+    if (sqlite3_bind_text (ctx->has_stmt,
+                           1,
+                           (char *)hash,
+                           hash_len,
+                           SQLITE_STATIC) != SQLITE_OK) {
+        log_sqlite_error (ctx, "has: binding key");
+        set_errno_from_sqlite_error (ctx);
+        goto done;
+    }
+    if (sqlite3_step (ctx->has_stmt) != SQLITE_ROW) {
+        errno = ENOENT;
+        goto done;
+    }
+    gc_touch (ctx, blobref);
+    rc = 0;
+done:
+    ERRNO_SAFE_WRAP (sqlite3_reset, ctx->has_stmt);
+    return rc;
+}
+
 /* Store blob to objects table, compressing if necessary.
  * Blobref resulting from hash over 'data' is stored to 'blobref'.
  * Returns 0 on success, -1 on error with errno set.
@@ -212,6 +620,8 @@ static int content_sqlite_store (struct content_sqlite *ctx,
     uint8_t hash[BLOBREF_MAX_DIGEST_SIZE];
     int hash_len;
     int uncompressed_size = -1;
+    int codec;
+    int stored_size;
 
     if (blobref_hash (ctx->hashfun,
                       (uint8_t *)data,
@@ -221,19 +631,13 @@ static int content_sqlite_store (struct content_sqlite *ctx,
         return -1;
     if ((hash_len = blobref_strtohash (blobref, hash, sizeof (hash))) < 0)
         return -1;
-    if (size >= compression_threshold) {
-        int r;
-        int out_len = LZ4_compressBound(size);
-        if (ctx->lzo_bufsize < out_len && grow_lzo_buf (ctx, out_len) < 0)
-            return -1;
-        r = LZ4_compress_default (data, ctx->lzo_buf, size, out_len);
-        if (r == 0) {
-            errno = EINVAL;
-            return -1;
-        }
+    gc_touch (ctx, blobref);
+    if (codec_compress (ctx, data, size, &codec, &stored_size) < 0)
+        return -1;
+    if (codec != CODEC_NONE) {
         uncompressed_size = size;
-        size = r;
-        data = ctx->lzo_buf;
+        size = stored_size;
+        data = ctx->codec_buf;
     }
     if (sqlite3_bind_text (ctx->store_stmt,
                            1,
@@ -260,12 +664,24 @@ static int content_sqlite_store (struct content_sqlite *ctx,
         set_errno_from_sqlite_error (ctx);
         goto error;
     }
-    if (sqlite3_step (ctx->store_stmt) != SQLITE_DONE
-                    && sqlite3_errcode (ctx->db) != SQLITE_CONSTRAINT) {
-        log_sqlite_error (ctx, "store: executing stmt");
+    if (sqlite3_bind_int (ctx->store_stmt, 4, codec) != SQLITE_OK) {
+        log_sqlite_error (ctx, "store: binding codec");
         set_errno_from_sqlite_error (ctx);
         goto error;
     }
+    if (sqlite3_step (ctx->store_stmt) != SQLITE_DONE) {
+        if (sqlite3_errcode (ctx->db) != SQLITE_CONSTRAINT) {
+            log_sqlite_error (ctx, "store: executing stmt");
+            set_errno_from_sqlite_error (ctx);
+            goto error;
+        }
+    }
+    else {
+        ctx->stats[codec].count++;
+        ctx->stats[codec].raw_bytes += codec == CODEC_NONE ? size
+                                                           : uncompressed_size;
+        ctx->stats[codec].stored_bytes += size;
+    }
     sqlite3_reset (ctx->store_stmt);
     return 0;
 error:
@@ -273,6 +689,132 @@ error:
     return -1;
 }
 
+static void txn_response_destroy (struct txn_response *rsp)
+{
+    if (rsp) {
+        int saved_errno = errno;
+        flux_msg_decref (rsp->msg);
+        free (rsp->buf);
+        free (rsp);
+        errno = saved_errno;
+    }
+}
+
+/* Respond to all deferred store requests, with 'errnum' if nonzero.
+ */
+static void txn_respond (struct content_sqlite *ctx, int errnum)
+{
+    struct txn_response *rsp;
+
+    while ((rsp = zlist_pop (ctx->txn_responses))) {
+        if (errnum) {
+            if (flux_respond_error (ctx->h, rsp->msg, errnum, NULL) < 0)
+                flux_log_error (ctx->h, "store: flux_respond_error");
+        }
+        else {
+            if (flux_respond_raw (ctx->h, rsp->msg, rsp->buf, rsp->len) < 0)
+                flux_log_error (ctx->h, "store: flux_respond_raw");
+        }
+        txn_response_destroy (rsp);
+    }
+}
+
+/* Open a transaction if one is not already open.
+ * Returns 0 on success, -1 on error with errno set.
+ */
+static int txn_begin (struct content_sqlite *ctx)
+{
+    if (ctx->txn_active)
+        return 0;
+    if (sqlite3_exec (ctx->db, "BEGIN", NULL, NULL, NULL) != SQLITE_OK) {
+        log_sqlite_error (ctx, "begin transaction");
+        set_errno_from_sqlite_error (ctx);
+        return -1;
+    }
+    ctx->txn_active = true;
+    ctx->txn_count = 0;
+    return 0;
+}
+
+/* Commit the open transaction, if any, then send deferred responses.
+ * On failure, the transaction is rolled back and the deferred requests
+ * fail.  Returns 0 on success, -1 on error with errno set.
+ */
+static int txn_commit (struct content_sqlite *ctx)
+{
+    if (!ctx->txn_active)
+        return 0;
+    ctx->txn_active = false;
+    if (sqlite3_exec (ctx->db, "COMMIT", NULL, NULL, NULL) != SQLITE_OK) {
+        log_sqlite_error (ctx, "commit transaction");
+        set_errno_from_sqlite_error (ctx);
+        if (!sqlite3_get_autocommit (ctx->db))
+            ERRNO_SAFE_WRAP (sqlite3_exec, ctx->db, "ROLLBACK", NULL, NULL,
+                             NULL);
+        ERRNO_SAFE_WRAP (txn_respond, ctx, errno);
+        return -1;
+    }
+    txn_respond (ctx, 0);
+    return 0;
+}
+
+/* After a failed store, check whether sqlite rolled back the open
+ * transaction on its own (e.g. on SQLITE_FULL or SQLITE_IOERR), and if so,
+ * fail the deferred requests whose blobs were lost.
+ * Returns true if the transaction was rolled back.
+ */
+static bool txn_aborted (struct content_sqlite *ctx)
+{
+    if (ctx->txn_active && sqlite3_get_autocommit (ctx->db)) {
+        ctx->txn_active = false;
+        ERRNO_SAFE_WRAP (txn_respond, ctx, errno);
+        return true;
+    }
+    return false;
+}
+
+/* Hold a response of 'len' bytes of 'buf' to 'msg' until the open
+ * transaction commits, which happens now if it has grown to txn_max blobs.
+ * Returns 0 on success, -1 on error with errno set.
+ */
+static int txn_defer_response (struct content_sqlite *ctx,
+                               const flux_msg_t *msg,
+                               const void *buf,
+                               int len,
+                               int count)
+{
+    struct txn_response *rsp;
+
+    if (!(rsp = calloc (1, sizeof (*rsp)))
+        || (len > 0 && !(rsp->buf = malloc (len)))
+        || zlist_append (ctx->txn_responses, rsp) < 0) {
+        txn_response_destroy (rsp);
+        errno = ENOMEM;
+        return -1;
+    }
+    if (len > 0)
+        memcpy (rsp->buf, buf, len);
+    rsp->len = len;
+    rsp->msg = flux_msg_incref (msg);
+    ctx->txn_count += count;
+    if (ctx->txn_count >= ctx->txn_max)
+        (void)txn_commit (ctx);
+    return 0;
+}
+
+/* Commit once there are no more requests ready to be handled.
+ */
+static void txn_check_cb (flux_reactor_t *r,
+                          flux_watcher_t *w,
+                          int revents,
+                          void *arg)
+{
+    struct content_sqlite *ctx = arg;
+
+    if (ctx->txn_active && !(flux_pollevents (ctx->h) & FLUX_POLLIN))
+        (void)txn_commit (ctx);
+}
+
 static void load_cb (flux_t *h,
                      flux_msg_handler_t *mh,
                      const flux_msg_t *msg,
@@ -321,16 +863,190 @@ void store_cb (flux_t *h,
         flux_log_error (h, "store: request decode failed");
         goto error;
     }
-    if (content_sqlite_store (ctx, data, size, blobref, sizeof (blobref)) < 0)
+    if (txn_begin (ctx) < 0)
+        goto error;
+    if (content_sqlite_store (ctx, data, size, blobref, sizeof (blobref)) < 0) {
+        (void)txn_aborted (ctx);
+        goto error;
+    }
+    if (txn_defer_response (ctx, msg, blobref, strlen (blobref) + 1, 1) < 0)
         goto error;
-    if (flux_respond_raw (h, msg, blobref, strlen (blobref) + 1) < 0)
-        flux_log_error (h, "store: flux_respond_raw");
     return;
 error:
     if (flux_respond_error (h, msg, errno, NULL) < 0)
         flux_log_error (h, "store: flux_respond_error");
 }
 
+/* Load each blob of a batch.  A blob that could not be loaded is
+ * recorded as an error in its place in the response.
+ */
+static void load_batch_cb (flux_t *h,
+                           flux_msg_handler_t *mh,
+                           const flux_msg_t *msg,
+                           void *arg)
+{
+    struct content_sqlite *ctx = arg;
+    const void *buf;
+    int len;
+    struct blobbatch *req = NULL;
+    struct blobbatch *rsp = NULL;
+    int i;
+
+    if (flux_request_decode_raw (msg, NULL, &buf, &len) < 0) {
+        flux_log_error (h, "load-batch: request decode failed");
+        goto error;
+    }
+    if (!(req = blobbatch_decode (buf, len))) {
+        flux_log_error (h, "load-batch: malformed request");
+        goto error;
+    }
+    if (!(rsp = blobbatch_create ()))
+        goto error;
+    for (i = 0; i < blobbatch_count (req); i++) {
+        const char *blobref;
+        const void *data;
+        int size;
+        int rc;
+
+        if (!(blobref = blobbatch_get_string (req, i))
+            || content_sqlite_load (ctx, blobref, &data, &size) < 0) {
+            rc = blobbatch_append_error (rsp, errno);
+        }
+        else {
+            rc = blobbatch_append (rsp, data, size);
+            (void )sqlite3_reset (ctx->load_stmt);
+        }
+        if (rc < 0)
+            goto error;
+    }
+    blobbatch_encode (rsp, &buf, &len);
+    if (flux_respond_raw (h, msg, buf, len) < 0)
+        flux_log_error (h, "load-batch: flux_respond_raw");
+    blobbatch_destroy (req);
+    blobbatch_destroy (rsp);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "load-batch: flux_respond_error");
+    blobbatch_destroy (req);
+    blobbatch_destroy (rsp);
+}
+
+/* Store each blob of a batch, in the open transaction.
+ */
+static void store_batch_cb (flux_t *h,
+                            flux_msg_handler_t *mh,
+                            const flux_msg_t *msg,
+                            void *arg)
+{
+    struct content_sqlite *ctx = arg;
+    const void *buf;
+    int len;
+    struct blobbatch *req = NULL;
+    struct blobbatch *rsp = NULL;
+    int i;
+
+    if (flux_request_decode_raw (msg, NULL, &buf, &len) < 0) {
+        flux_log_error (h, "store-batch: request decode failed");
+        goto error;
+    }
+    if (!(req = blobbatch_decode (buf, len))) {
+        flux_log_error (h, "store-batch: malformed request");
+        goto error;
+    }
+    if (!(rsp = blobbatch_create ()))
+        goto error;
+    if (txn_begin (ctx) < 0)
+        goto error;
+    for (i = 0; i < blobbatch_count (req); i++) {
+        const void *data;
+        int size;
+        char blobref[BLOBREF_MAX_STRING_SIZE];
+        int rc;
+
+        if (blobbatch_get (req, i, &data, &size) < 0
+            || content_sqlite_store (ctx,
+                                     data,
+                                     size,
+                                     blobref,
+                                     sizeof (blobref)) < 0) {
+            if (txn_aborted (ctx))
+                goto error; // blobs stored so far were rolled back
+            rc = blobbatch_append_error (rsp, errno);
+        }
+        else
+            rc = blobbatch_append (rsp, blobref, strlen (blobref) + 1);
+        if (rc < 0)
+            goto error;
+    }
+    blobbatch_encode (rsp, &buf, &len);
+    if (txn_defer_response (ctx, msg, buf, len, blobbatch_count (req)) < 0)
+        goto error;
+    blobbatch_destroy (req);
+    blobbatch_destroy (rsp);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "store-batch: flux_respond_error");
+    blobbatch_destroy (req);
+    blobbatch_destroy (rsp);
+}
+
+/* Report which blobs of a batch are in the objects table.  A blob that
+ * is present is an empty item in the response, and one that is not is
+ * an ENOENT error.
+ */
+static void has_cb (flux_t *h,
+                    flux_msg_handler_t *mh,
+                    const flux_msg_t *msg,
+                    void *arg)
+{
+    struct content_sqlite *ctx = arg;
+    const void *buf;
+    int len;
+    struct blobbatch *req = NULL;
+    struct blobbatch *rsp = NULL;
+    int i;
+
+    if (flux_request_decode_raw (msg, NULL, &buf, &len) < 0) {
+        flux_log_error (h, "has: request decode failed");
+        goto error;
+    }
+    if (!(req = blobbatch_decode (buf, len))) {
+        flux_log_error (h, "has: malformed request");
+        goto error;
+    }
+    if (!(rsp = blobbatch_create ()))
+        goto error;
+    for (i = 0; i < blobbatch_count (req); i++) {
+        const char *blobref;
+        int rc;
+
+        if (!(blobref = blobbatch_get_string (req, i))
+            || content_sqlite_has (ctx, blobref) < 0)
+            rc = blobbatch_append_error (rsp, errno);
+        else
+            rc = blobbatch_append (rsp, NULL, 0);
+        if (rc < 0)
+            goto error;
+    }
+    blobbatch_encode (rsp, &buf, &len);
+    if (ctx->txn_active) {
+        if (txn_defer_response (ctx, msg, buf, len, 0) < 0)
+            goto error;
+    }
+    else if (flux_respond_raw (h, msg, buf, len) < 0)
+        flux_log_error (h, "has: flux_respond_raw");
+    blobbatch_destroy (req);
+    blobbatch_destroy (rsp);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "has: flux_respond_error");
+    blobbatch_destroy (req);
+    blobbatch_destroy (rsp);
+}
+
 void checkpoint_get_cb (flux_t *h,
                         flux_msg_handler_t *mh,
                         const flux_msg_t *msg,
@@ -389,6 +1105,10 @@ void checkpoint_put_cb (flux_t *h,
         errno = EINVAL;
         goto error;
     }
+    /* The checkpoint may refer to blobs in the open transaction.
+     */
+    if (txn_commit (ctx) < 0)
+        goto error;
     if (sqlite3_bind_text (ctx->checkpt_put_stmt,
                            1,
                            (char *)key,
@@ -423,17 +1143,668 @@ error:
     (void )sqlite3_reset (ctx->checkpt_put_stmt);
 }
 
-static void content_sqlite_closedb (struct content_sqlite *ctx)
+/* Garbage collection
+ */
+
+static void gc_send (struct content_sqlite *ctx);
+
+static void gc_set_error (struct content_sqlite *ctx,
+                          int errnum,
+                          const char *fmt, ...)
 {
-    if (ctx) {
-        int saved_errno = errno;
-        if (ctx->store_stmt) {
-            if (sqlite3_finalize (ctx->store_stmt) != SQLITE_OK)
-                log_sqlite_error (ctx, "sqlite_finalize store_stmt");
-        }
-        if (ctx->load_stmt) {
-            if (sqlite3_finalize (ctx->load_stmt) != SQLITE_OK)
-                log_sqlite_error (ctx, "sqlite_finalize load_stmt");
+    struct content_gc *gc = &ctx->gc;
+    va_list ap;
+
+    if (gc->errnum)
+        return;
+    gc->errnum = errnum;
+    va_start (ap, fmt);
+    (void)vsnprintf (gc->errstr, sizeof (gc->errstr), fmt, ap);
+    va_end (ap);
+}
+
+/* End the run, answering its request, and free what it used.
+ */
+static void gc_finish (struct content_sqlite *ctx)
+{
+    struct content_gc *gc = &ctx->gc;
+    char *blobref;
+
+    if (gc->errnum) {
+        flux_log (ctx->h, LOG_ERR, "gc: %s: %s",
+                  gc->errstr, flux_strerror (gc->errnum));
+        if (flux_respond_error (ctx->h,
+                                gc->request,
+                                gc->errnum,
+                                gc->errstr) < 0)
+            flux_log_error (ctx->h, "gc: flux_respond_error");
+    }
+    else {
+        double t = flux_reactor_now (flux_get_reactor (ctx->h)) - gc->t_start;
+
+        flux_log (ctx->h, LOG_INFO,
+                  "gc: deleted %jd of %jd blobs (%jd bytes) in %.1fs",
+                  (intmax_t)gc->deleted,
+                  (intmax_t)gc->scanned,
+                  (intmax_t)gc->deleted_bytes,
+                  t);
+        if (flux_respond_pack (ctx->h,
+                               gc->request,
+                               "{s:I s:I s:I s:I s:I s:f}",
+                               "roots", (json_int_t)gc->roots,
+                               "dirs", (json_int_t)gc->dirs_walked,
+                               "scanned", (json_int_t)gc->scanned,
+                               "deleted", (json_int_t)gc->deleted,
+                               "deleted_bytes",
+                               (json_int_t)gc->deleted_bytes,
+                               "time", t) < 0)
+            flux_log_error (ctx->h, "gc: flux_respond_pack");
+    }
+    flux_msg_decref (gc->request);
+    gc->request = NULL;
+    flux_watcher_stop (gc->sweep_w);
+    bloom_destroy (gc->marked);
+    gc->marked = NULL;
+    zhashx_destroy (&gc->visited);
+    if (gc->dirs) {
+        while ((blobref = zlist_pop (gc->dirs)))
+            free (blobref);
+        zlist_destroy (&gc->dirs);
+    }
+    free (gc->rowids);
+    gc->rowids = NULL;
+    free (gc->sizes);
+    gc->sizes = NULL;
+    gc->state = GC_IDLE;
+}
+
+/* Mark 'blobref' and queue it to be walked, unless that was done already.
+ * Returns 1 if queued, 0 if not, -1 on error with errno set.
+ */
+static int gc_queue_dir (struct content_sqlite *ctx, const char *blobref)
+{
+    struct content_gc *gc = &ctx->gc;
+    char *cpy;
+
+    bloom_add (gc->marked, blobref, strlen (blobref));
+    if (zhashx_lookup (gc->visited, blobref))
+        return 0;
+    if (zhashx_insert (gc->visited, blobref, (void *)1) < 0
+        || !(cpy = strdup (blobref)))
+        goto nomem;
+    if (zlist_append (gc->dirs, cpy) < 0) {
+        free (cpy);
+        goto nomem;
+    }
+    return 1;
+nomem:
+    errno = ENOMEM;
+    return -1;
+}
+
+static int gc_queue_root (struct content_sqlite *ctx, const char *blobref)
+{
+    int rc;
+
+    if ((rc = gc_queue_dir (ctx, blobref)) < 0)
+        return -1;
+    ctx->gc.roots += rc;
+    return 0;
+}
+
+/* Mark the blobs that treeobj 'obj' refers to, queueing dirs to be walked.
+ */
+static int gc_mark_treeobj (struct content_sqlite *ctx, const json_t *obj)
+{
+    json_t *data = treeobj_get_data ((json_t *)obj);
+    const char *key;
+    json_t *o;
+
+    if (treeobj_is_valref (obj) || treeobj_is_dirref (obj)) {
+        bool dir = treeobj_is_dirref (obj);
+        int count = treeobj_get_count (obj);
+
+        for (int i = 0; i < count; i++) {
+            const char *blobref = treeobj_get_blobref (obj, i);
+            if (!blobref)
+                return -1;
+            if (dir) {
+                if (gc_queue_dir (ctx, blobref) < 0)
+                    return -1;
+            }
+            else
+                bloom_add (ctx->gc.marked, blobref, strlen (blobref));
+        }
+        return 0;
+    }
+    if (treeobj_is_dirshard (obj))
+        data = json_object_get (data, "shards");
+    else if (!treeobj_is_dir (obj))
+        return 0;
+    json_object_foreach (data, key, o) {
+        if (gc_mark_treeobj (ctx, o) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+static void gc_load_continuation (flux_future_t *f, void *arg)
+{
+    struct content_sqlite *ctx = arg;
+    struct content_gc *gc = &ctx->gc;
+    const char *blobref = flux_future_aux_get (f, "blobref");
+    const void *data;
+    int size;
+    json_t *obj;
+
+    gc->inflight--;
+    if (gc->errnum)
+        goto done;
+    if (flux_content_load_get (f, &data, &size) < 0) {
+        gc_set_error (ctx, errno, "error loading %s", blobref);
+        goto done;
+    }
+    if (!(obj = treeobj_decodeb (data, size))) {
+        gc_set_error (ctx, EPROTO, "%s is not a treeobj", blobref);
+        goto done;
+    }
+    if (gc_mark_treeobj (ctx, obj) < 0)
+        gc_set_error (ctx, errno, "error walking %s", blobref);
+    json_decref (obj);
+    gc->dirs_walked++;
+done:
+    flux_future_destroy (f);
+    gc_send (ctx);
+}
+
+/* Commit any deleted rows and look for more once the broker has nothing
+ * else for the module, so the sweep gives way to the content service.
+ */
+static void gc_sweep_cb (flux_reactor_t *r,
+                         flux_watcher_t *w,
+                         int revents,
+                         void *arg)
+{
+    struct content_sqlite *ctx = arg;
+    struct content_gc *gc = &ctx->gc;
+    int count = 0;
+    int n = 0;
+
+    if ((flux_pollevents (ctx->h) & FLUX_POLLIN))
+        goto again;
+    if (sqlite3_bind_int64 (ctx->gc_scan_stmt, 1, gc->cursor) != SQLITE_OK
+        || sqlite3_bind_int64 (ctx->gc_scan_stmt, 2, gc->horizon) != SQLITE_OK
+        || sqlite3_bind_int (ctx->gc_scan_stmt, 3, ctx->gc_batch) != SQLITE_OK)
+        goto error;
+    while (sqlite3_step (ctx->gc_scan_stmt) == SQLITE_ROW) {
+        const void *hash = sqlite3_column_blob (ctx->gc_scan_stmt, 1);
+        int hash_len = sqlite3_column_bytes (ctx->gc_scan_stmt, 1);
+        char blobref[BLOBREF_MAX_STRING_SIZE];
+
+        gc->cursor = sqlite3_column_int64 (ctx->gc_scan_stmt, 0);
+        count++;
+        /* A row whose hash is not of the current hash type is kept.
+         */
+        if (blobref_hashtostr (ctx->hashfun,
+                               hash,
+                               hash_len,
+                               blobref,
+                               sizeof (blobref)) < 0
+            || bloom_check (gc->marked, blobref, strlen (blobref)))
+            continue;
+        gc->rowids[n] = gc->cursor;
+        gc->sizes[n] = sqlite3_column_int64 (ctx->gc_scan_stmt, 2);
+        n++;
+    }
+    sqlite3_reset (ctx->gc_scan_stmt);
+    gc->scanned += count;
+    if (n > 0) {
+        if (txn_begin (ctx) < 0)
+            goto error_nolog;
+        for (int i = 0; i < n; i++) {
+            if (sqlite3_bind_int64 (ctx->gc_delete_stmt,
+                                    1,
+                                    gc->rowids[i]) != SQLITE_OK
+                || sqlite3_step (ctx->gc_delete_stmt) != SQLITE_DONE) {
+                ERRNO_SAFE_WRAP (sqlite3_reset, ctx->gc_delete_stmt);
+                (void)txn_aborted (ctx);
+                goto error;
+            }
+            sqlite3_reset (ctx->gc_delete_stmt);
+            gc->deleted++;
+            gc->deleted_bytes += gc->sizes[i];
+            gc->total_deleted++;
+            gc->total_deleted_bytes += gc->sizes[i];
+        }
+        ctx->txn_count += n;
+        if (ctx->txn_count >= ctx->txn_max)
+            (void)txn_commit (ctx);
+    }
+    if (count < ctx->gc_batch) {
+        if (txn_commit (ctx) < 0)
+            gc_set_error (ctx, errno, "error committing deletions");
+        gc_finish (ctx);
+        return;
+    }
+again:
+    flux_timer_watcher_reset (w, gc_sweep_delay, 0.);
+    flux_watcher_start (w);
+    return;
+error:
+    log_sqlite_error (ctx, "gc: sweep");
+    set_errno_from_sqlite_error (ctx);
+    ERRNO_SAFE_WRAP (sqlite3_reset, ctx->gc_scan_stmt);
+error_nolog:
+    gc_set_error (ctx, errno, "error sweeping");
+    gc_finish (ctx);
+}
+
+static int gc_roots (struct content_sqlite *ctx);
+
+/* Start another load whenever there is room, and move on once the walk
+ * has finished: to the second walk, then to the sweep.
+ */
+static void gc_send (struct content_sqlite *ctx)
+{
+    struct content_gc *gc = &ctx->gc;
+    flux_future_t *f;
+    char *blobref;
+
+    while (!gc->errnum
+           && gc->inflight < GC_MAX_INFLIGHT
+           && (blobref = zlist_pop (gc->dirs))) {
+        if (!(f = flux_content_load (ctx->h, blobref, 0))) {
+            gc_set_error (ctx, errno, "error loading %s", blobref);
+            free (blobref);
+            break;
+        }
+        if (flux_future_aux_set (f, "blobref", blobref, free) < 0) {
+            gc_set_error (ctx, errno, "error loading %s", blobref);
+            free (blobref);
+            flux_future_destroy (f);
+            break;
+        }
+        if (flux_future_then (f, -1., gc_load_continuation, ctx) < 0) {
+            gc_set_error (ctx, errno, "error loading %s", blobref);
+            flux_future_destroy (f);
+            break;
+        }
+        gc->inflight++;
+    }
+    if (gc->inflight > 0)
+        return;
+    if (gc->errnum)
+        gc_finish (ctx);
+    else if (zlist_size (gc->dirs) == 0) {
+        if (!gc->remark) {
+            gc->remark = true;
+            (void)gc_roots (ctx);
+            gc_send (ctx);
+        }
+        else {
+            gc->state = GC_SWEEP;
+            flux_timer_watcher_reset (gc->sweep_w, 0., 0.);
+            flux_watcher_start (gc->sweep_w);
+        }
+    }
+}
+
+static void gc_getroot_continuation (flux_future_t *f, void *arg)
+{
+    struct content_sqlite *ctx = arg;
+    struct content_gc *gc = &ctx->gc;
+    const char *ns = flux_future_aux_get (f, "namespace");
+    const char *rootref;
+
+    gc->inflight--;
+    if (gc->errnum)
+        goto done;
+    if (flux_rpc_get_unpack (f, "{s:s}", "rootref", &rootref) < 0) {
+        if (errno != ENOTSUP) // namespace was removed
+            gc_set_error (ctx, errno, "error getting root of %s", ns);
+        goto done;
+    }
+    if (gc_queue_root (ctx, rootref) < 0)
+        gc_set_error (ctx, errno, "error queueing root of %s", ns);
+done:
+    flux_future_destroy (f);
+    gc_send (ctx);
+}
+
+static void gc_namespaces_continuation (flux_future_t *f, void *arg)
+{
+    struct content_sqlite *ctx = arg;
+    struct content_gc *gc = &ctx->gc;
+    json_t *namespaces;
+    size_t index;
+    json_t *entry;
+
+    gc->inflight--;
+    if (gc->errnum)
+        goto done;
+    if (flux_rpc_get_unpack (f, "{s:o}", "namespaces", &namespaces) < 0) {
+        if (errno != ENOSYS) // kvs is not loaded, the checkpoint will do
+            gc_set_error (ctx, errno, "error listing KVS namespaces");
+        goto done;
+    }
+    json_array_foreach (namespaces, index, entry) {
+        const char *ns;
+        int flags;
+        char *cpy = NULL;
+        flux_future_t *f2 = NULL;
+
+        if (json_unpack (entry,
+                         "{s:s s:i}",
+                         "namespace", &ns,
+                         "flags", &flags) < 0) {
+            gc_set_error (ctx, EPROTO, "error listing KVS namespaces");
+            break;
+        }
+        if ((flags & FLUX_KVS_NAMESPACE_EPHEMERAL)) {
+            gc_set_error (ctx, ENOTSUP, "namespace %s is ephemeral", ns);
+            break;
+        }
+        if (!(cpy = strdup (ns))
+            || !(f2 = flux_rpc_pack (ctx->h,
+                                     "kvs.getroot",
+                                     0,
+                                     0,
+                                     "{s:s}",
+                                     "namespace", ns))
+            || flux_future_aux_set (f2, "namespace", cpy, free) < 0) {
+            gc_set_error (ctx, errno, "error getting root of %s", ns);
+            free (cpy);
+            flux_future_destroy (f2);
+            break;
+        }
+        if (flux_future_then (f2, -1., gc_getroot_continuation, ctx) < 0) {
+            gc_set_error (ctx, errno, "error getting root of %s", ns);
+            flux_future_destroy (f2);
+            break;
+        }
+        gc->inflight++;
+    }
+done:
+    flux_future_destroy (f);
+    gc_send (ctx);
+}
+
+/* Queue the roots recorded in the checkpt table, then ask the KVS for
+ * the root of each namespace.  Returns 0 on success, -1 on error with
+ * the run's error set.
+ */
+static int gc_roots (struct content_sqlite *ctx)
+{
+    struct content_gc *gc = &ctx->gc;
+    sqlite3_stmt *stmt;
+    flux_future_t *f;
+
+    if (sqlite3_prepare_v2 (ctx->db,
+                            sql_checkpt_list,
+                            -1,
+                            &stmt,
+                            NULL) != SQLITE_OK) {
+        log_sqlite_error (ctx, "gc: preparing checkpt list stmt");
+        set_errno_from_sqlite_error (ctx);
+        gc_set_error (ctx, errno, "error reading checkpoints");
+        return -1;
+    }
+    while (sqlite3_step (stmt) == SQLITE_ROW) {
+        const char *value = (const char *)sqlite3_column_text (stmt, 0);
+
+        if (value
+            && blobref_validate (value) == 0
+            && gc_queue_root (ctx, value) < 0) {
+            gc_set_error (ctx, errno, "error queueing checkpoint %s", value);
+            sqlite3_finalize (stmt);
+            return -1;
+        }
+    }
+    sqlite3_finalize (stmt);
+    if (!(f = flux_rpc (ctx->h, "kvs.namespace-list", NULL, 0, 0))
+        || flux_future_then (f, -1., gc_namespaces_continuation, ctx) < 0) {
+        gc_set_error (ctx, errno, "error listing KVS namespaces");
+        flux_future_destroy (f);
+        return -1;
+    }
+    gc->inflight++;
+    return 0;
+}
+
+/* Drop clean entries from the KVS cache, which would otherwise let the
+ * KVS reuse a candidate blob without storing it again.
+ */
+static void gc_kvs_dropcache_continuation (flux_future_t *f, void *arg)
+{
+    struct content_sqlite *ctx = arg;
+    struct content_gc *gc = &ctx->gc;
+
+    gc->inflight--;
+    if (flux_future_get (f, NULL) < 0 && errno != ENOSYS)
+        gc_set_error (ctx, errno, "error dropping KVS cache");
+    flux_future_destroy (f);
+    if (!gc->errnum)
+        (void)gc_roots (ctx);
+    gc_send (ctx);
+}
+
+/* Likewise for the content cache of this broker.
+ */
+static void gc_dropcache_continuation (flux_future_t *f, void *arg)
+{
+    struct content_sqlite *ctx = arg;
+    struct content_gc *gc = &ctx->gc;
+    flux_future_t *f2;
+
+    gc->inflight--;
+    if (flux_future_get (f, NULL) < 0)
+        gc_set_error (ctx, errno, "error dropping content cache");
+    else if (!(f2 = flux_rpc (ctx->h, "kvs.dropcache", NULL, 0, 0))
+        || flux_future_then (f2,
+                             -1.,
+                             gc_kvs_dropcache_continuation,
+                             ctx) < 0) {
+        gc_set_error (ctx, errno, "error dropping KVS cache");
+        flux_future_destroy (f2);
+    }
+    else
+        gc->inflight++;
+    flux_future_destroy (f);
+    gc_send (ctx);
+}
+
+/* Get the last rowid of the objects table, or 0 if it is empty.
+ */
+static int gc_get_horizon (struct content_sqlite *ctx, int64_t *horizon)
+{
+    sqlite3_stmt *stmt;
+    int rc = -1;
+
+    if (sqlite3_prepare_v2 (ctx->db,
+                            sql_gc_horizon,
+                            -1,
+                            &stmt,
+                            NULL) != SQLITE_OK) {
+        log_sqlite_error (ctx, "gc: preparing horizon stmt");
+        set_errno_from_sqlite_error (ctx);
+        return -1;
+    }
+    if (sqlite3_step (stmt) != SQLITE_ROW) {
+        log_sqlite_error (ctx, "gc: executing horizon stmt");
+        set_errno_from_sqlite_error (ctx);
+        goto done;
+    }
+    *horizon = sqlite3_column_int64 (stmt, 0); // NULL reads as 0
+    rc = 0;
+done:
+    sqlite3_finalize (stmt);
+    return rc;
+}
+
+static void gc_cb (flux_t *h,
+                   flux_msg_handler_t *mh,
+                   const flux_msg_t *msg,
+                   void *arg)
+{
+    struct content_sqlite *ctx = arg;
+    struct content_gc *gc = &ctx->gc;
+    flux_future_t *f;
+    int64_t horizon;
+    size_t nbits;
+
+    if (flux_request_decode (msg, NULL, NULL) < 0)
+        goto error;
+    if (gc->state != GC_IDLE) {
+        errno = EBUSY;
+        goto error;
+    }
+    /* Blobs in the open transaction are candidates too.
+     */
+    if (txn_commit (ctx) < 0 || gc_get_horizon (ctx, &horizon) < 0)
+        goto error;
+    nbits = ((size_t)horizon + 1024) * GC_BLOOM_BITS;
+    if (!(gc->marked = bloom_create (nbits, GC_BLOOM_HASHES))
+        || !(gc->visited = zhashx_new ())
+        || !(gc->dirs = zlist_new ())
+        || !(gc->rowids = calloc (ctx->gc_batch, sizeof (gc->rowids[0])))
+        || !(gc->sizes = calloc (ctx->gc_batch, sizeof (gc->sizes[0]))))
+        goto nomem;
+    gc->request = flux_msg_incref (msg);
+    gc->state = GC_MARK;
+    gc->remark = false;
+    gc->errnum = 0;
+    gc->horizon = horizon;
+    gc->cursor = 0;
+    gc->t_start = flux_reactor_now (flux_get_reactor (h));
+    gc->roots = 0;
+    gc->dirs_walked = 0;
+    gc->scanned = 0;
+    gc->deleted = 0;
+    gc->deleted_bytes = 0;
+    gc->runs++;
+    flux_log (h, LOG_INFO, "gc: started with %jd candidate rows",
+              (intmax_t)horizon);
+    if (!(f = flux_rpc (h, "content.dropcache", NULL, 0, 0))
+        || flux_future_then (f, -1., gc_dropcache_continuation, ctx) < 0) {
+        gc_set_error (ctx, errno, "error dropping content cache");
+        flux_future_destroy (f);
+        gc_finish (ctx);
+        return;
+    }
+    gc->inflight++;
+    return;
+nomem:
+    errno = ENOMEM;
+    bloom_destroy (gc->marked);
+    gc->marked = NULL;
+    zhashx_destroy (&gc->visited);
+    zlist_destroy (&gc->dirs);
+    free (gc->rowids);
+    gc->rowids = NULL;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "gc: flux_respond_error");
+}
+
+/* Report the codec in use and the compression achieved on blobs stored
+ * since the module was loaded.
+ */
+static void stats_get_cb (flux_t *h,
+                          flux_msg_handler_t *mh,
+                          const flux_msg_t *msg,
+                          void *arg)
+{
+    struct content_sqlite *ctx = arg;
+    struct content_gc *gc = &ctx->gc;
+    json_t *codecs = NULL;
+    json_t *gcstats = NULL;
+    size_t queued = 0;
+    size_t marked = 0;
+    int64_t raw = 0;
+    int64_t stored = 0;
+    int i;
+
+    if (flux_request_decode (msg, NULL, NULL) < 0)
+        goto error;
+    if (!(codecs = json_object ()))
+        goto nomem;
+    for (i = 0; i < CODEC_COUNT; i++) {
+        struct codec_stats *st = &ctx->stats[i];
+        json_t *o;
+
+        if (!(o = json_pack ("{s:I s:I s:I}",
+                             "count", (json_int_t)st->count,
+                             "raw", (json_int_t)st->raw_bytes,
+                             "stored", (json_int_t)st->stored_bytes))
+            || json_object_set_new (codecs, codec_names[i], o) < 0) {
+            json_decref (o);
+            goto nomem;
+        }
+        raw += st->raw_bytes;
+        stored += st->stored_bytes;
+    }
+    /* The current run's counts, if one is active, else the last run's.
+     * 'cursor' reaches 'horizon' as the sweep proceeds.
+     */
+    if (gc->state != GC_IDLE) {
+        queued = zlist_size (gc->dirs);
+        marked = bloom_count (gc->marked);
+    }
+    if (!(gcstats = json_pack ("{s:s s:I s:I s:I s:I s:I s:I s:I s:I s:I"
+                               " s:I s:I s:I}",
+                               "state", gc_state_names[gc->state],
+                               "runs", (json_int_t)gc->runs,
+                               "roots", (json_int_t)gc->roots,
+                               "dirs", (json_int_t)gc->dirs_walked,
+                               "queued", (json_int_t)queued,
+                               "marked", (json_int_t)marked,
+                               "horizon", (json_int_t)gc->horizon,
+                               "cursor", (json_int_t)gc->cursor,
+                               "scanned", (json_int_t)gc->scanned,
+                               "deleted", (json_int_t)gc->deleted,
+                               "deleted_bytes", (json_int_t)gc->deleted_bytes,
+                               "total_deleted", (json_int_t)gc->total_deleted,
+                               "total_deleted_bytes",
+                               (json_int_t)gc->total_deleted_bytes)))
+        goto nomem;
+    if (flux_respond_pack (h,
+                           msg,
+                           "{s:s s:I s:f s:O s:O}",
+                           "codec", codec_names[ctx->codec],
+                           "zstd-dict", (json_int_t)ctx->zstd_dict_id,
+                           "ratio", stored > 0 ? (double)raw / stored : 1.,
+                           "codecs", codecs,
+                           "gc", gcstats) < 0)
+        flux_log_error (h, "stats: flux_respond_pack");
+    json_decref (codecs);
+    json_decref (gcstats);
+    return;
+nomem:
+    errno = ENOMEM;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "stats: flux_respond_error");
+    json_decref (codecs);
+    json_decref (gcstats);
+}
+
+static void content_sqlite_closedb (struct content_sqlite *ctx)
+{
+    if (ctx) {
+        int saved_errno = errno;
+        if (ctx->db)
+            (void)txn_commit (ctx);
+        if (ctx->store_stmt) {
+            if (sqlite3_finalize (ctx->store_stmt) != SQLITE_OK)
+                log_sqlite_error (ctx, "sqlite_finalize store_stmt");
+        }
+        if (ctx->load_stmt) {
+            if (sqlite3_finalize (ctx->load_stmt) != SQLITE_OK)
+                log_sqlite_error (ctx, "sqlite_finalize load_stmt");
+        }
+        if (ctx->has_stmt) {
+            if (sqlite3_finalize (ctx->has_stmt) != SQLITE_OK)
+                log_sqlite_error (ctx, "sqlite_finalize has_stmt");
         }
         if (ctx->checkpt_get_stmt) {
             if (sqlite3_finalize (ctx->checkpt_get_stmt) != SQLITE_OK)
@@ -443,6 +1814,24 @@ static void content_sqlite_closedb (struct content_sqlite *ctx)
             if (sqlite3_finalize (ctx->checkpt_put_stmt) != SQLITE_OK)
                 log_sqlite_error (ctx, "sqlite_finalize checkpt_put_stmt");
         }
+        if (ctx->gc_scan_stmt) {
+            if (sqlite3_finalize (ctx->gc_scan_stmt) != SQLITE_OK)
+                log_sqlite_error (ctx, "sqlite_finalize gc_scan_stmt");
+        }
+        if (ctx->gc_delete_stmt) {
+            if (sqlite3_finalize (ctx->gc_delete_stmt) != SQLITE_OK)
+                log_sqlite_error (ctx, "sqlite_finalize gc_delete_stmt");
+        }
+#if HAVE_ZSTD
+        if (ctx->dict_get_stmt) {
+            if (sqlite3_finalize (ctx->dict_get_stmt) != SQLITE_OK)
+                log_sqlite_error (ctx, "sqlite_finalize dict_get_stmt");
+        }
+        if (ctx->dict_put_stmt) {
+            if (sqlite3_finalize (ctx->dict_put_stmt) != SQLITE_OK)
+                log_sqlite_error (ctx, "sqlite_finalize dict_put_stmt");
+        }
+#endif
         if (ctx->db) {
             if (sqlite3_close (ctx->db) != SQLITE_OK)
                 log_sqlite_error (ctx, "sqlite3_close");
@@ -451,46 +1840,144 @@ static void content_sqlite_closedb (struct content_sqlite *ctx)
     }
 }
 
+/* Add the codec column to an objects table created before it existed.
+ */
+static int content_sqlite_migrate (struct content_sqlite *ctx)
+{
+    sqlite3_stmt *stmt;
+
+    if (sqlite3_prepare_v2 (ctx->db,
+                            sql_check_codec,
+                            -1,
+                            &stmt,
+                            NULL) == SQLITE_OK) {
+        sqlite3_finalize (stmt);
+        return 0;
+    }
+    if (sqlite3_exec (ctx->db, sql_add_codec, NULL, NULL, NULL) != SQLITE_OK) {
+        log_sqlite_error (ctx, "adding codec column to object table");
+        return -1;
+    }
+    flux_log (ctx->h, LOG_INFO, "added codec column to object table");
+    return 0;
+}
+
+#if HAVE_ZSTD
+/* Read the zstd dictionary ctx->zstd_dict_path, record it in the dicts
+ * table so blobs compressed with it can always be loaded, and prepare it
+ * for compression.
+ */
+static int load_zstd_dict (struct content_sqlite *ctx)
+{
+    void *buf = NULL;
+    ssize_t len;
+    int fd;
+
+    if ((fd = open (ctx->zstd_dict_path, O_RDONLY)) < 0) {
+        flux_log_error (ctx->h, "%s", ctx->zstd_dict_path);
+        return -1;
+    }
+    if ((len = read_all (fd, &buf)) < 0) {
+        flux_log_error (ctx->h, "%s", ctx->zstd_dict_path);
+        ERRNO_SAFE_WRAP (close, fd);
+        return -1;
+    }
+    close (fd);
+    if (!(ctx->zstd_dict_id = ZSTD_getDictID_fromDict (buf, len))) {
+        flux_log (ctx->h, LOG_ERR, "%s: not a zstd dictionary",
+                  ctx->zstd_dict_path);
+        errno = EINVAL;
+        goto error;
+    }
+    if (sqlite3_bind_int64 (ctx->dict_put_stmt,
+                            1,
+                            ctx->zstd_dict_id) != SQLITE_OK
+        || sqlite3_bind_blob (ctx->dict_put_stmt,
+                              2,
+                              buf,
+                              len,
+                              SQLITE_STATIC) != SQLITE_OK
+        || sqlite3_step (ctx->dict_put_stmt) != SQLITE_DONE) {
+        log_sqlite_error (ctx, "storing zstd dictionary");
+        set_errno_from_sqlite_error (ctx);
+        ERRNO_SAFE_WRAP (sqlite3_reset, ctx->dict_put_stmt);
+        goto error;
+    }
+    sqlite3_reset (ctx->dict_put_stmt);
+    if (!(ctx->cdict = ZSTD_createCDict (buf, len, ctx->zstd_level))) {
+        errno = ENOMEM;
+        goto error;
+    }
+    free (buf);
+    return 0;
+error:
+    ERRNO_SAFE_WRAP (free, buf);
+    return -1;
+}
+#endif
+
 /* Open the database file ctx->dbfile and set up the database.
  */
 static int content_sqlite_opendb (struct content_sqlite *ctx)
 {
     int flags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE;
+    char s[128];
 
     if (sqlite3_open_v2 (ctx->dbfile, &ctx->db, flags, NULL) != SQLITE_OK) {
         log_sqlite_error (ctx, "opening %s", ctx->dbfile);
         goto error;
     }
+    /* locking_mode=EXCLUSIVE is set first so that WAL mode works without
+     * a shared memory index.
+     */
     if (sqlite3_exec (ctx->db,
-                      "PRAGMA journal_mode=OFF",
+                      "PRAGMA locking_mode=EXCLUSIVE",
                       NULL,
                       NULL,
                       NULL) != SQLITE_OK) {
+        log_sqlite_error (ctx, "setting sqlite 'locking_mode' pragma");
+        goto error;
+    }
+    snprintf (s, sizeof (s), "PRAGMA journal_mode=%s", ctx->journal_mode);
+    if (sqlite3_exec (ctx->db, s, NULL, NULL, NULL) != SQLITE_OK) {
         log_sqlite_error (ctx, "setting sqlite 'journal_mode' pragma");
         goto error;
     }
-    if (sqlite3_exec (ctx->db,
-                      "PRAGMA synchronous=OFF",
-                      NULL,
-                      NULL,
-                      NULL) != SQLITE_OK) {
+    snprintf (s, sizeof (s), "PRAGMA synchronous=%s", ctx->synchronous);
+    if (sqlite3_exec (ctx->db, s, NULL, NULL, NULL) != SQLITE_OK) {
         log_sqlite_error (ctx, "setting sqlite 'synchronous' pragma");
         goto error;
     }
+    if (ctx->mmap_size >= 0) {
+        snprintf (s, sizeof (s), "PRAGMA mmap_size=%lld", ctx->mmap_size);
+        if (sqlite3_exec (ctx->db, s, NULL, NULL, NULL) != SQLITE_OK) {
+            log_sqlite_error (ctx, "setting sqlite 'mmap_size' pragma");
+            goto error;
+        }
+    }
+    if (ctx->cache_size_set) {
+        snprintf (s, sizeof (s), "PRAGMA cache_size=%lld", ctx->cache_size);
+        if (sqlite3_exec (ctx->db, s, NULL, NULL, NULL) != SQLITE_OK) {
+            log_sqlite_error (ctx, "setting sqlite 'cache_size' pragma");
+            goto error;
+        }
+    }
     if (sqlite3_exec (ctx->db,
-                      "PRAGMA locking_mode=EXCLUSIVE",
+                      sql_create_table,
                       NULL,
                       NULL,
                       NULL) != SQLITE_OK) {
-        log_sqlite_error (ctx, "setting sqlite 'locking_mode' pragma");
+        log_sqlite_error (ctx, "creating object table");
         goto error;
     }
+    if (content_sqlite_migrate (ctx) < 0)
+        goto error;
     if (sqlite3_exec (ctx->db,
-                      sql_create_table,
+                      sql_create_table_dicts,
                       NULL,
                       NULL,
                       NULL) != SQLITE_OK) {
-        log_sqlite_error (ctx, "creating object table");
+        log_sqlite_error (ctx, "creating dicts table");
         goto error;
     }
     if (sqlite3_exec (ctx->db,
@@ -517,6 +2004,14 @@ static int content_sqlite_opendb (struct content_sqlite *ctx)
         log_sqlite_error (ctx, "preparing store stmt");
         goto error;
     }
+    if (sqlite3_prepare_v2 (ctx->db,
+                            sql_has,
+                            -1,
+                            &ctx->has_stmt,
+                            NULL) != SQLITE_OK) {
+        log_sqlite_error (ctx, "preparing has stmt");
+        goto error;
+    }
     if (sqlite3_prepare_v2 (ctx->db,
                             sql_checkpt_get,
                             -1,
@@ -533,6 +2028,42 @@ static int content_sqlite_opendb (struct content_sqlite *ctx)
         log_sqlite_error (ctx, "preparing checkpt_put stmt");
         goto error;
     }
+    if (sqlite3_prepare_v2 (ctx->db,
+                            sql_gc_scan,
+                            -1,
+                            &ctx->gc_scan_stmt,
+                            NULL) != SQLITE_OK) {
+        log_sqlite_error (ctx, "preparing gc_scan stmt");
+        goto error;
+    }
+    if (sqlite3_prepare_v2 (ctx->db,
+                            sql_gc_delete,
+                            -1,
+                            &ctx->gc_delete_stmt,
+                            NULL) != SQLITE_OK) {
+        log_sqlite_error (ctx, "preparing gc_delete stmt");
+        goto error;
+    }
+#if HAVE_ZSTD
+    if (sqlite3_prepare_v2 (ctx->db,
+                            sql_dict_get,
+                            -1,
+                            &ctx->dict_get_stmt,
+                            NULL) != SQLITE_OK) {
+        log_sqlite_error (ctx, "preparing dict_get stmt");
+        goto error;
+    }
+    if (sqlite3_prepare_v2 (ctx->db,
+                            sql_dict_put,
+                            -1,
+                            &ctx->dict_put_stmt,
+                            NULL) != SQLITE_OK) {
+        log_sqlite_error (ctx, "preparing dict_put stmt");
+        goto error;
+    }
+    if (ctx->zstd_dict_path && load_zstd_dict (ctx) < 0)
+        return -1;
+#endif
     return 0;
 error:
     set_errno_from_sqlite_error (ctx);
@@ -544,8 +2075,26 @@ static void content_sqlite_destroy (struct content_sqlite *ctx)
     if (ctx) {
         int saved_errno = errno;
         flux_msg_handler_delvec (ctx->handlers);
+        flux_watcher_destroy (ctx->check_w);
+        if (ctx->gc.state != GC_IDLE) {
+            gc_set_error (ctx, ECANCELED, "module is unloading");
+            gc_finish (ctx);
+        }
+        flux_watcher_destroy (ctx->gc.sweep_w);
+#if HAVE_ZSTD
+        ZSTD_freeCCtx (ctx->cctx);
+        ZSTD_freeDCtx (ctx->dctx);
+        ZSTD_freeCDict (ctx->cdict);
+        zhashx_destroy (&ctx->ddicts);
+#endif
+        if (ctx->txn_responses) {
+            struct txn_response *rsp;
+            while ((rsp = zlist_pop (ctx->txn_responses)))
+                txn_response_destroy (rsp);
+            zlist_destroy (&ctx->txn_responses);
+        }
         free (ctx->dbfile);
-        free (ctx->lzo_buf);
+        free (ctx->codec_buf);
         free (ctx);
         errno = saved_errno;
     }
@@ -554,8 +2103,13 @@ static void content_sqlite_destroy (struct content_sqlite *ctx)
 static const struct flux_msg_handler_spec htab[] = {
     { FLUX_MSGTYPE_REQUEST, "content-backing.load",    load_cb, 0 },
     { FLUX_MSGTYPE_REQUEST, "content-backing.store",   store_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST, "content-backing.load-batch", load_batch_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST, "content-backing.store-batch", store_batch_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST, "content-backing.has", has_cb, 0 },
     { FLUX_MSGTYPE_REQUEST, "kvs-checkpoint.get", checkpoint_get_cb, 0 },
     { FLUX_MSGTYPE_REQUEST, "kvs-checkpoint.put", checkpoint_put_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST, "content-backing.stats.get", stats_get_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST, "content-backing.gc", gc_cb, 0 },
     FLUX_MSGHANDLER_TABLE_END,
 };
 
@@ -566,10 +2120,38 @@ static struct content_sqlite *content_sqlite_create (flux_t *h)
 
     if (!(ctx = calloc (1, sizeof (*ctx))))
         return NULL;
-    if (!(ctx->lzo_buf = calloc (1, lzo_buf_chunksize)))
+    if (!(ctx->codec_buf = calloc (1, codec_buf_chunksize)))
         goto error;
-    ctx->lzo_bufsize = lzo_buf_chunksize;
+    ctx->codec_bufsize = codec_buf_chunksize;
     ctx->h = h;
+    ctx->journal_mode = "WAL";
+    ctx->synchronous = "OFF";
+    ctx->mmap_size = -1;
+    ctx->txn_max = default_txn_max;
+    ctx->codec = CODEC_LZ4;
+    ctx->compression_threshold = default_compression_threshold;
+    ctx->zstd_level = default_zstd_level;
+    ctx->gc_batch = default_gc_batch;
+#if HAVE_ZSTD
+    if (!(ctx->cctx = ZSTD_createCCtx ())
+        || !(ctx->dctx = ZSTD_createDCtx ())
+        || !(ctx->ddicts = zhashx_new ()))
+        goto error;
+    zhashx_set_destructor (ctx->ddicts, ddict_destroy);
+#endif
+    if (!(ctx->txn_responses = zlist_new ()))
+        goto error;
+    if (!(ctx->check_w = flux_check_watcher_create (flux_get_reactor (h),
+                                                    txn_check_cb,
+                                                    ctx)))
+        goto error;
+    flux_watcher_start (ctx->check_w);
+    if (!(ctx->gc.sweep_w = flux_timer_watcher_create (flux_get_reactor (h),
+                                                       0.,
+                                                       0.,
+                                                       gc_sweep_cb,
+                                                       ctx)))
+        goto error;
 
     /* Some tunables:
      * - the hash function, e.g. sha1, sha256
@@ -613,6 +2195,130 @@ error:
     return NULL;
 }
 
+static const char *pragma_value (const char *val, const char **choices)
+{
+    int i;
+    for (i = 0; choices[i] != NULL; i++) {
+        if (!strcasecmp (val, choices[i]))
+            return choices[i];
+    }
+    errno = EINVAL;
+    return NULL;
+}
+
+static int parse_ll (const char *s, long long *val)
+{
+    char *endptr;
+
+    errno = 0;
+    *val = strtoll (s, &endptr, 10);
+    if (errno != 0 || endptr == s || *endptr != '\0') {
+        errno = EINVAL;
+        return -1;
+    }
+    return 0;
+}
+
+static int parse_args (struct content_sqlite *ctx, int argc, char **argv)
+{
+    const char *journal_modes[] = {
+        "DELETE", "TRUNCATE", "PERSIST", "MEMORY", "WAL", "OFF", NULL
+    };
+    const char *sync_modes[] = { "OFF", "NORMAL", "FULL", "EXTRA", NULL };
+    long long val;
+    int i;
+
+    for (i = 0; i < argc; i++) {
+        if (!strncmp (argv[i], "journal-mode=", 13)) {
+            if (!(ctx->journal_mode = pragma_value (argv[i] + 13,
+                                                    journal_modes)))
+                goto error;
+        }
+        else if (!strncmp (argv[i], "synchronous=", 12)) {
+            if (!(ctx->synchronous = pragma_value (argv[i] + 12, sync_modes)))
+                goto error;
+        }
+        else if (!strncmp (argv[i], "mmap-size=", 10)) {
+            if (parse_ll (argv[i] + 10, &val) < 0 || val < 0) {
+                errno = EINVAL;
+                goto error;
+            }
+            ctx->mmap_size = val;
+        }
+        else if (!strncmp (argv[i], "cache-size=", 11)) {
+            if (parse_ll (argv[i] + 11, &val) < 0)
+                goto error;
+            ctx->cache_size = val;
+            ctx->cache_size_set = true;
+        }
+        else if (!strncmp (argv[i], "codec=", 6)) {
+            const char *name = argv[i] + 6;
+            int codec;
+            for (codec = 0; codec < CODEC_COUNT; codec++) {
+                if (!strcmp (name, codec_names[codec]))
+                    break;
+            }
+#if !HAVE_ZSTD
+            if (codec == CODEC_ZSTD) {
+                flux_log (ctx->h, LOG_ERR, "not built with zstd support");
+                codec = CODEC_COUNT;
+            }
+#endif
+            if (codec == CODEC_COUNT) {
+                errno = EINVAL;
+                goto error;
+            }
+            ctx->codec = codec;
+        }
+        else if (!strncmp (argv[i], "zstd-level=", 11)) {
+            if (parse_ll (argv[i] + 11, &val) < 0
+                || val < INT_MIN || val > INT_MAX) {
+                errno = EINVAL;
+                goto error;
+            }
+            ctx->zstd_level = val;
+        }
+        else if (!strncmp (argv[i], "zstd-dict=", 10)) {
+            ctx->zstd_dict_path = argv[i] + 10;
+        }
+        else if (!strncmp (argv[i], "compression-threshold=", 22)) {
+            if (parse_ll (argv[i] + 22, &val) < 0
+                || val < 0 || val > INT_MAX) {
+                errno = EINVAL;
+                goto error;
+            }
+            ctx->compression_threshold = val;
+        }
+        else if (!strncmp (argv[i], "transaction-max=", 16)) {
+            if (parse_ll (argv[i] + 16, &val) < 0 || val < 1 || val > INT_MAX) {
+                errno = EINVAL;
+                goto error;
+            }
+            ctx->txn_max = val;
+        }
+        else if (!strncmp (argv[i], "gc-batch=", 9)) {
+            if (parse_ll (argv[i] + 9, &val) < 0 || val < 1 || val > INT_MAX) {
+                errno = EINVAL;
+                goto error;
+            }
+            ctx->gc_batch = val;
+        }
+        else {
+            errno = EINVAL;
+            goto error;
+        }
+    }
+    if (ctx->zstd_dict_path && ctx->codec != CODEC_ZSTD) {
+        flux_log (ctx->h, LOG_ERR, "zstd-dict requires codec=zstd");
+        errno = EINVAL;
+        return -1;
+    }
+    return 0;
+error:
+    flux_log_error (ctx->h, "%s", argv[i]);
+    return -1;
+}
+
 int mod_main (flux_t *h, int argc, char **argv)
 {
     struct content_sqlite *ctx;
@@ -621,6 +2327,10 @@ int mod_main (flux_t *h, int argc, char **argv)
         flux_log_error (h, "content_sqlite_create failed");
         return -1;
     }
+    if (parse_args (ctx, argc, argv) < 0) {
+        content_sqlite_destroy (ctx);
+        return -1;
+    }
     if (content_sqlite_opendb(ctx) < 0)
         goto done;
     if (content_register_backing_store (h, "content-sqlite") < 0)
@@ -28,6 +28,7 @@
 #include <stdbool.h>
 #include <sys/time.h>
 #include <ctype.h>
+#include <limits.h>
 #include <flux/core.h>
 #include <czmq.h>
 #include <jansson.h>
@@ -44,8 +45,13 @@ struct cron_ctx {
     uint64_t               next_id;         /* Id for next cron entry        */
     char *                 sync_event;      /* If set, sync entries to event */
     flux_msg_handler_t *   mh;              /* sync event message handler    */
-    zlist_t    *           entries;
+    zlistx_t   *           entries;
+    zhashx_t   *           entries_by_id;   /* entries hashed by id          */
     zlist_t    *           deferred;        /* list of deferred entries      */
+    zlist_t    *           throttled;       /* entries waiting for a launch
+                                               slot, in order of arrival     */
+    int                    max_tasks;       /* max running tasks, 0=no limit */
+    int                    running;         /* number of running tasks       */
     double                 last_sync;       /* timestamp of last sync event  */
     double                 sync_epsilon;    /* allow tasks to run for this
                                                number of seconds after last-
@@ -89,7 +95,7 @@ static void timeout_cb (flux_t *h, cron_task_t *t, void *arg)
     cron_task_kill (t, SIGTERM);
 }
 
-static int cron_entry_run_task (cron_entry_t *e)
+static int cron_entry_launch_task (cron_entry_t *e)
 {
     flux_t *h = e->ctx->h;
     if (cron_task_run (e->task, e->rank, e->command, e->cwd, e->env) < 0) {
@@ -98,10 +104,44 @@ static int cron_entry_run_task (cron_entry_t *e)
         cron_entry_finished_handler (h, e->task, e);
         return (-1);
     }
+    e->running = 1;
+    e->ctx->running++;
     e->stats.lastrun = get_timestamp ();
     return (0);
 }
 
+/*  Launch the task for entry `e`, unless max_tasks tasks are already
+ *   running, in which case queue the entry until a running task finishes.
+ */
+static int cron_entry_run_task (cron_entry_t *e)
+{
+    cron_ctx_t *ctx = e->ctx;
+
+    if (ctx->max_tasks > 0 && ctx->running >= ctx->max_tasks) {
+        if (zlist_append (ctx->throttled, e) < 0)
+            return (-1);
+        e->throttled = 1;
+        flux_log (ctx->h, LOG_DEBUG,
+                  "cron-%ju: waiting for one of %d running tasks to finish",
+                  e->id, ctx->running);
+        return (0);
+    }
+    return cron_entry_launch_task (e);
+}
+
+/*  Launch throttled tasks, in order, while launch slots are available.
+ */
+static void cron_ctx_run_throttled (cron_ctx_t *ctx)
+{
+    cron_entry_t *e;
+
+    while ((ctx->max_tasks == 0 || ctx->running < ctx->max_tasks)
+           && (e = zlist_pop (ctx->throttled))) {
+        e->throttled = 0;
+        (void)cron_entry_launch_task (e);
+    }
+}
+
 static int cron_entry_increment (cron_entry_t *e)
 {
     ++e->stats.total;
@@ -208,6 +248,16 @@ static void cron_entry_finished_handler (flux_t *h, cron_task_t *t, void *arg)
         return;
     e->task = NULL;
 
+    /*
+     *   Release the launch slot held by this task, if any, to the
+     *    next throttled entry.
+     */
+    if (e->running) {
+        e->running = 0;
+        e->ctx->running--;
+        cron_ctx_run_throttled (e->ctx);
+    }
+
     /*
      *   If destruction of this cron entry has been requested, complete
      *    the destroy here.
@@ -280,6 +330,17 @@ static void cron_entry_destroy (cron_entry_t *e)
     cron_entry_stop (e);
     e->destroyed = 1;
 
+    /*
+     *  A task that is waiting for a launch slot has not started yet,
+     *   so it can be dropped.
+     */
+    if (e->throttled) {
+        zlist_remove (e->ctx->throttled, e);
+        e->throttled = 0;
+        cron_task_destroy (e->task);
+        e->task = NULL;
+    }
+
     /*
      *  If we have a task still running, we  have to leave cron_entry
      *   around until the task is complete.
@@ -290,8 +351,11 @@ static void cron_entry_destroy (cron_entry_t *e)
     /*
      *  Before destroying entry, remove it from entries list:
      */
-    if (e->ctx && e->ctx->entries)
-        zlist_remove (e->ctx->entries, e);
+    if (e->ctx && e->handle) {
+        zhashx_delete (e->ctx->entries_by_id, &e->id);
+        zlistx_delete (e->ctx->entries, e->handle);
+        e->handle = NULL;
+    }
 
     if (e->data) {
         e->ops.destroy (e->data);
@@ -490,12 +554,18 @@ static void cron_ctx_destroy (cron_ctx_t *ctx)
 
     if (ctx->entries) {
         cron_entry_t *e;
-        while ((e = zlist_pop (ctx->entries)))
+        while ((e = zlistx_detach (ctx->entries, NULL))) {
+            zhashx_delete (ctx->entries_by_id, &e->id);
+            e->handle = NULL;
             cron_entry_destroy (e);
-        zlist_destroy (&ctx->entries);
+        }
+        zlistx_destroy (&ctx->entries);
     }
+    zhashx_destroy (&ctx->entries_by_id);
     if (ctx->deferred)
         zlist_destroy (&ctx->deferred);
+    if (ctx->throttled)
+        zlist_destroy (&ctx->throttled);
     free (ctx->cwd);
     free (ctx);
 }
@@ -526,6 +596,28 @@ static int cron_ctx_sync_event_init (cron_ctx_t *ctx, const char *topic)
     return (0);
 }
 
+/*  Hash int64_t cron entry id in `key`.
+ *   N.B. zhashx_hash_fn signature
+ */
+static size_t entry_hasher (const void *key)
+{
+    const int64_t *id = key;
+    return *id;
+}
+
+#define NUMCMP(a,b) ((a)==(b)?0:((a)<(b)?-1:1))
+
+/*  Compare hash keys.
+ *   N.B. zhashx_comparator_fn signature
+ */
+static int entry_hash_key_cmp (const void *key1, const void *key2)
+{
+    const int64_t *id1 = key1;
+    const int64_t *id2 = key2;
+
+    return NUMCMP (*id1, *id2);
+}
+
 static cron_ctx_t * cron_ctx_create (flux_t *h)
 {
     cron_ctx_t *ctx = calloc (1, sizeof (*ctx));
@@ -542,11 +634,17 @@ static cron_ctx_t * cron_ctx_create (flux_t *h)
     ctx->sync_epsilon = 0.015;
     ctx->mh = NULL;
 
-    if (!(ctx->entries = zlist_new ())
-        || !(ctx->deferred = zlist_new ())) {
+    if (!(ctx->entries = zlistx_new ())
+        || !(ctx->entries_by_id = zhashx_new ())
+        || !(ctx->deferred = zlist_new ())
+        || !(ctx->throttled = zlist_new ())) {
         flux_log_error (h, "cron_ctx_create: zlist_new");
         goto error;
     }
+    zhashx_set_key_hasher (ctx->entries_by_id, entry_hasher);
+    zhashx_set_key_comparator (ctx->entries_by_id, entry_hash_key_cmp);
+    zhashx_set_key_duplicator (ctx->entries_by_id, NULL);
+    zhashx_set_key_destructor (ctx->entries_by_id, NULL);
 
     if (!(ctx->cwd = get_current_dir_name ())) {
         flux_log_error (h, "cron_ctx_create: get_get_current_dir_name");
@@ -647,7 +745,9 @@ static void cron_create_handler (flux_t *h, flux_msg_handler_t *w,
     if (!(e = cron_entry_create (ctx, msg)))
         goto error;
 
-    if (zlist_append (ctx->entries, e) < 0) {
+    if (!(e->handle = zlistx_add_end (ctx->entries, e))
+        || zhashx_insert (ctx->entries_by_id, &e->id, e) < 0) {
+        cron_entry_destroy (e);
         errno = ENOMEM;
         goto error;
     }
@@ -708,10 +808,7 @@ error:
 
 static cron_entry_t *cron_ctx_find_entry (cron_ctx_t *ctx, int64_t id)
 {
-    cron_entry_t *e = zlist_first (ctx->entries);
-    while (e && e->id != id)
-        e = zlist_next (ctx->entries);
-    return (e);
+    return zhashx_lookup (ctx->entries_by_id, &id);
 }
 
 /*
@@ -841,14 +938,14 @@ static void cron_ls_handler (flux_t *h, flux_msg_handler_t *w,
         return;
     }
 
-    e = zlist_first (ctx->entries);
+    e = zlistx_first (ctx->entries);
     while (e) {
         json_t *entry = cron_entry_to_json (e);
         if (entry == NULL)
             flux_log_error (h, "cron_entry_to_json");
         else
             json_array_append_new (entries, entry);
-        e = zlist_next (ctx->entries);
+        e = zlistx_next (ctx->entries);
     }
     json_object_set_new (out, "entries", entries);
 
@@ -883,6 +980,16 @@ static void process_args (cron_ctx_t *ctx, int ac, char **av)
             if (fsd_parse_duration (s, &ctx->sync_epsilon) < 0)
                 flux_log_error (ctx->h, "option %s ignored", av[i]);
         }
+        else if (strncmp (av[i], "max_tasks=", 10) == 0) {
+            char *endptr;
+            long l;
+            errno = 0;
+            l = strtol ((av[i])+10, &endptr, 10);
+            if (errno != 0 || *endptr != '\0' || l < 0 || l > INT_MAX)
+                flux_log (ctx->h, LOG_ERR, "option %s ignored", av[i]);
+            else
+                ctx->max_tasks = l;
+        }
         else
             flux_log (ctx->h, LOG_ERR, "Unknown option `%s'", av[i]);
     }
@@ -68,6 +68,9 @@ struct cron_entry {
     int                 repeat;             /* Total number of times to run  */
 
     unsigned int        stopped:1;          /* This entry is inactive        */
+    unsigned int        running:1;          /* Task counts against max_tasks */
+    unsigned int        throttled:1;        /* Task waits on ctx->throttled  */
+    void *              handle;             /* Handle in ctx->entries        */
 
     char *                 typename;        /* Name of this type             */
     struct cron_entry_ops  ops;             /* Type-specific operations      */
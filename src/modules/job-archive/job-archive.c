@@ -8,7 +8,14 @@
  * SPDX-License-Identifier: LGPL-3.0
 \************************************************************/
 
-/* job-archive: archive job data service for flux */
+/* job-archive: archive job data service for flux
+ *
+ * Inactive jobs are fetched from job-info with job-info.list-inactive,
+ * then each job's eventlog, jobspec, and R with job-info.lookup, and
+ * stored in one sqlite transaction per round.  A round is started when
+ * job-info.state-watch reports that jobs became inactive, or when the
+ * period timer expires, in case job-info was not available to watch.
+ */
 
 #if HAVE_CONFIG_H
 #include "config.h"
@@ -44,21 +51,64 @@ const char *sql_create_table = "CREATE TABLE if not exists jobs("
                                "  t_inactive REAL,"
                                "  eventlog TEXT,"
                                "  jobspec TEXT,"
-                               "  R TEXT"
+                               "  R TEXT,"
+                               "  name TEXT,"
+                               "  nnodes INT,"
+                               "  ntasks INT,"
+                               "  result TEXT"
     ");";
 
-const char *sql_store =                               \
-    "INSERT INTO jobs"                                \
-    "("                                               \
-    "  id,userid,ranks,"                              \
-    "  t_submit,t_sched,t_run,t_cleanup,t_inactive,"  \
-    "  eventlog,jobspec,R"                            \
-    ") values ("                                      \
-    "  ?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8, ?9, ?10, ?11"  \
+/* Scalar columns extracted from job-info, so that reports need not
+ * parse eventlog, jobspec, or R.  They are added to tables created
+ * before they existed, and are NULL for jobs archived before then.
+ */
+static const struct {
+    const char *name;
+    const char *type;
+} extracted_columns[] = {
+    { "name", "TEXT" },
+    { "nnodes", "INT" },
+    { "ntasks", "INT" },
+    { "result", "TEXT" },
+};
+
+/* Indices and a per-day view of the scalar columns, for reports that
+ * select jobs by day or user.
+ */
+const char *sql_create_extras =
+    "CREATE INDEX if not exists jobs_t_inactive ON jobs(t_inactive);"
+    "CREATE INDEX if not exists jobs_userid ON jobs(userid);"
+    "CREATE VIEW if not exists jobs_summary AS SELECT"
+    "  date(t_inactive, 'unixepoch') AS day,"
+    "  id,userid,name,nnodes,ntasks,result,"
+    "  t_submit,t_sched,t_run,t_cleanup,t_inactive"
+    " FROM jobs;";
+
+const char *sql_store =                                   \
+    "INSERT INTO jobs"                                    \
+    "("                                                   \
+    "  id,userid,ranks,"                                  \
+    "  t_submit,t_sched,t_run,t_cleanup,t_inactive,"      \
+    "  eventlog,jobspec,R,"                               \
+    "  name,nnodes,ntasks,result"                         \
+    ") values ("                                          \
+    "  ?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8, ?9, ?10, ?11,"     \
+    "  ?12, ?13, ?14, ?15"                                \
     ")";
 
 const char *sql_since = "SELECT MAX(t_inactive) FROM jobs;";
 
+/* Inactive jobs that job-info has evicted are listed from here,
+ * newest first, by job-archive.list.
+ */
+const char *sql_list =                                        \
+    "SELECT"                                                  \
+    "  id,userid,ranks,"                                      \
+    "  t_submit,t_sched,t_run,t_cleanup,t_inactive,name"      \
+    " FROM jobs"                                              \
+    " WHERE t_inactive <= ?1 AND (?2 < 0 OR userid = ?2)"     \
+    " ORDER BY t_inactive DESC LIMIT ?3";
+
 struct job_archive_ctx {
     flux_t *h;
     char *dbpath;
@@ -67,10 +117,18 @@ struct job_archive_ctx {
     flux_watcher_t *w;
     sqlite3 *db;
     sqlite3_stmt *store_stmt;
+    sqlite3_stmt *list_stmt;
+    flux_msg_handler_t **handlers;
+    flux_future_t *watch_f;
+    bool busy;              // archive round in progress
+    bool again;             // start another round when done
+    bool txn;               // sqlite transaction open
     double since;
     int kvs_lookup_count;
 };
 
+static void archive_start (struct job_archive_ctx *ctx);
+
 static void log_sqlite_error (struct job_archive_ctx *ctx, const char *fmt, ...)
 {
     char buf[128];
@@ -98,10 +156,16 @@ static void job_archive_ctx_destroy (struct job_archive_ctx *ctx)
     if (ctx) {
         free (ctx->dbpath);
         flux_watcher_destroy (ctx->w);
+        flux_future_destroy (ctx->watch_f);
+        flux_msg_handler_delvec (ctx->handlers);
         if (ctx->store_stmt) {
             if (sqlite3_finalize (ctx->store_stmt) != SQLITE_OK)
                 log_sqlite_error (ctx, "sqlite_finalize store_stmt");
         }
+        if (ctx->list_stmt) {
+            if (sqlite3_finalize (ctx->list_stmt) != SQLITE_OK)
+                log_sqlite_error (ctx, "sqlite_finalize list_stmt");
+        }
         if (ctx->db) {
             if (sqlite3_close (ctx->db) != SQLITE_OK)
                 log_sqlite_error (ctx, "sqlite3_close");
@@ -166,6 +230,56 @@ int job_archive_since_init (struct job_archive_ctx *ctx)
     return 0;
 }
 
+static int column_cb (void *arg, int argc, char **argv, char **colname)
+{
+    bool *found = arg;
+    int i;
+
+    for (i = 0; i < argc; i++) {
+        if (!strcmp (colname[i], "name") && argv[i])
+            *found = true;
+    }
+    return 0;
+}
+
+/* Add extracted columns missing from a table created by an older
+ * job-archive.
+ */
+static int job_archive_add_columns (struct job_archive_ctx *ctx)
+{
+    char buf[128];
+    int i;
+
+    for (i = 0; i < sizeof (extracted_columns) /
+                    sizeof (extracted_columns[0]); i++) {
+        bool found = false;
+
+        snprintf (buf,
+                  sizeof (buf),
+                  "SELECT name FROM pragma_table_info('jobs')"
+                  " WHERE name = '%s';",
+                  extracted_columns[i].name);
+        if (sqlite3_exec (ctx->db, buf, column_cb, &found, NULL) != SQLITE_OK) {
+            log_sqlite_error (ctx, "checking for column %s",
+                              extracted_columns[i].name);
+            return -1;
+        }
+        if (found)
+            continue;
+        snprintf (buf,
+                  sizeof (buf),
+                  "ALTER TABLE jobs ADD COLUMN %s %s;",
+                  extracted_columns[i].name,
+                  extracted_columns[i].type);
+        if (sqlite3_exec (ctx->db, buf, NULL, NULL, NULL) != SQLITE_OK) {
+            log_sqlite_error (ctx, "adding column %s",
+                              extracted_columns[i].name);
+            return -1;
+        }
+    }
+    return 0;
+}
+
 int job_archive_init (struct job_archive_ctx *ctx)
 {
     int flags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE;
@@ -210,6 +324,16 @@ int job_archive_init (struct job_archive_ctx *ctx)
         log_sqlite_error (ctx, "creating object table");
         goto error;
     }
+    if (job_archive_add_columns (ctx) < 0)
+        goto error;
+    if (sqlite3_exec (ctx->db,
+                      sql_create_extras,
+                      NULL,
+                      NULL,
+                      NULL) != SQLITE_OK) {
+        log_sqlite_error (ctx, "creating indices and view");
+        goto error;
+    }
 
     if (sqlite3_prepare_v2 (ctx->db,
                             sql_store,
@@ -220,6 +344,15 @@ int job_archive_init (struct job_archive_ctx *ctx)
         goto error;
     }
 
+    if (sqlite3_prepare_v2 (ctx->db,
+                            sql_list,
+                            -1,
+                            &ctx->list_stmt,
+                            NULL) != SQLITE_OK) {
+        log_sqlite_error (ctx, "preparing list stmt");
+        goto error;
+    }
+
     if (job_archive_since_init (ctx) < 0)
         goto error;
 
@@ -252,6 +385,47 @@ void json_decref_wrapper (void *arg)
     json_decref ((json_t *)arg);
 }
 
+/* Run sqlite statement 'sql', retrying while the database is busy.
+ */
+static int exec_busy_retry (struct job_archive_ctx *ctx, const char *sql)
+{
+    int rc;
+
+    while ((rc = sqlite3_exec (ctx->db,
+                               sql,
+                               NULL,
+                               NULL,
+                               NULL)) == SQLITE_BUSY) {
+        flux_log (ctx->h, LOG_DEBUG, "%s: BUSY", __FUNCTION__);
+        usleep (1000);
+    }
+    if (rc != SQLITE_OK) {
+        log_sqlite_error (ctx, "%s", sql);
+        return -1;
+    }
+    return 0;
+}
+
+/* Archive round is complete.  Commit the jobs stored, then start
+ * another round if jobs became inactive meanwhile, else wait for the
+ * next inactive jobs or the period timer.
+ */
+static void archive_done (struct job_archive_ctx *ctx)
+{
+    if (ctx->txn) {
+        (void)exec_busy_retry (ctx, "COMMIT");
+        ctx->txn = false;
+    }
+    ctx->busy = false;
+    if (ctx->again) {
+        ctx->again = false;
+        archive_start (ctx);
+        return;
+    }
+    flux_timer_watcher_reset (ctx->w, ctx->period, 0.);
+    flux_watcher_start (ctx->w);
+}
+
 void job_info_lookup_continuation (flux_future_t *f, void *arg)
 {
     struct job_archive_ctx *ctx = arg;
@@ -267,6 +441,10 @@ void job_info_lookup_continuation (flux_future_t *f, void *arg)
     const char *eventlog = NULL;
     const char *jobspec = NULL;
     const char *R = NULL;
+    const char *name = NULL;
+    int nnodes = -1;
+    int ntasks = -1;
+    int result = -1;
     char idbuf[64];
 
     if (flux_rpc_get_unpack (f, "{s:s s:s s?:s}",
@@ -282,7 +460,8 @@ void job_info_lookup_continuation (flux_future_t *f, void *arg)
         goto out;
     }
 
-    if (json_unpack (job, "{s:I s:i s?:s s:f s?:f s?:f s?:f s:f}",
+    if (json_unpack (job, "{s:I s:i s?:s s:f s?:f s?:f s?:f s:f"
+                          " s?:s s?:i s?:i s?:i}",
                      "id", &id,
                      "userid", &userid,
                      "ranks", &ranks,
@@ -290,7 +469,11 @@ void job_info_lookup_continuation (flux_future_t *f, void *arg)
                      "t_sched", &t_sched,
                      "t_run", &t_run,
                      "t_cleanup", &t_cleanup,
-                     "t_inactive", &t_inactive) < 0) {
+                     "t_inactive", &t_inactive,
+                     "name", &name,
+                     "nnodes", &nnodes,
+                     "ntasks", &ntasks,
+                     "result", &result) < 0) {
         flux_log (ctx->h, LOG_ERR, "%s: parse job", __FUNCTION__);
         goto out;
     }
@@ -372,6 +555,34 @@ void job_info_lookup_continuation (flux_future_t *f, void *arg)
         log_sqlite_error (ctx, "store: binding R");
         goto out;
     }
+    if ((name ? sqlite3_bind_text (ctx->store_stmt,
+                                   12,
+                                   name,
+                                   strlen (name),
+                                   SQLITE_STATIC)
+              : sqlite3_bind_null (ctx->store_stmt, 12)) != SQLITE_OK) {
+        log_sqlite_error (ctx, "store: binding name");
+        goto out;
+    }
+    if ((nnodes >= 0 ? sqlite3_bind_int (ctx->store_stmt, 13, nnodes)
+                     : sqlite3_bind_null (ctx->store_stmt, 13)) != SQLITE_OK) {
+        log_sqlite_error (ctx, "store: binding nnodes");
+        goto out;
+    }
+    if ((ntasks >= 0 ? sqlite3_bind_int (ctx->store_stmt, 14, ntasks)
+                     : sqlite3_bind_null (ctx->store_stmt, 14)) != SQLITE_OK) {
+        log_sqlite_error (ctx, "store: binding ntasks");
+        goto out;
+    }
+    if ((result >= 0 ? sqlite3_bind_text (ctx->store_stmt,
+                                          15,
+                                          flux_job_resulttostr (result, false),
+                                          -1,
+                                          SQLITE_STATIC)
+                     : sqlite3_bind_null (ctx->store_stmt, 15)) != SQLITE_OK) {
+        log_sqlite_error (ctx, "store: binding result");
+        goto out;
+    }
     while (sqlite3_step (ctx->store_stmt) != SQLITE_DONE) {
         /* due to rounding errors in sqlite, duplicate entries could be
          * written out on occassion leading to a SQLITE_CONSTRAINT error.
@@ -401,10 +612,8 @@ out:
     sqlite3_reset (ctx->store_stmt);
     flux_future_destroy (f);
     if (ctx->kvs_lookup_count
-        && (--(ctx->kvs_lookup_count)) == 0) {
-        flux_timer_watcher_reset (ctx->w, ctx->period, 0.);
-        flux_watcher_start (ctx->w);
-    }
+        && (--(ctx->kvs_lookup_count)) == 0)
+        archive_done (ctx);
 }
 
 int job_info_lookup (struct job_archive_ctx *ctx, json_t *job)
@@ -475,40 +684,229 @@ void job_list_inactive_continuation (flux_future_t *f, void *arg)
 
     if (flux_rpc_get_unpack (f, "{s:o}", "jobs", &jobs) < 0) {
         flux_log_error (ctx->h, "%s: flux_rpc_get_unpack", __FUNCTION__);
-        return;
-    }
+        goto done;
+    }
+    /* Store this round's jobs in one transaction, committed when
+     * all lookups have completed.  Without it, each insert is its
+     * own transaction.
+     */
+    if (json_array_size (jobs) > 0 && exec_busy_retry (ctx, "BEGIN") == 0)
+        ctx->txn = true;
     json_array_foreach (jobs, index, value) {
         if (job_info_lookup (ctx, value) < 0)
             break;
     }
-    /* If no new inactive jobs, still need to reset timer */
-    if (!ctx->kvs_lookup_count) {
-        flux_timer_watcher_reset (ctx->w, ctx->period, 0.);
-        flux_watcher_start (ctx->w);
-    }
+done:
+    /* If no new inactive jobs, the round is already over */
+    if (!ctx->kvs_lookup_count)
+        archive_done (ctx);
     flux_future_destroy (f);
 }
 
-void job_archive_cb (flux_reactor_t *r,
-                     flux_watcher_t *w,
-                     int revents,
-                     void *arg)
+static void archive_start (struct job_archive_ctx *ctx)
 {
-    struct job_archive_ctx *ctx = arg;
     char *attrs = "[\"userid\", \"ranks\", \"t_submit\", \"t_sched\", " \
-                   "\"t_run\", \"t_cleanup\", \"t_inactive\"]";
+                   "\"t_run\", \"t_cleanup\", \"t_inactive\", " \
+                   "\"name\", \"nnodes\", \"ntasks\", \"result\"]";
     flux_future_t *f;
 
+    if (ctx->busy) {
+        ctx->again = true;
+        return;
+    }
+    flux_watcher_stop (ctx->w);
     if (!(f = flux_job_list_inactive (ctx->h, 0, ctx->since, attrs))) {
         flux_log_error (ctx->h, "%s: flux_job_list_inactive", __FUNCTION__);
-        return;
+        goto error;
     }
     if (flux_future_then (f, -1, job_list_inactive_continuation, ctx) < 0) {
         flux_log_error (ctx->h, "%s: flux_future_then", __FUNCTION__);
+        flux_future_destroy (f);
+        goto error;
+    }
+    ctx->busy = true;
+    return;
+error:
+    flux_timer_watcher_reset (ctx->w, ctx->period, 0.);
+    flux_watcher_start (ctx->w);
+}
+
+/* job-info.state-watch response.  Start a round if any job became
+ * inactive.  If the watch fails, e.g. job-info was reloaded, fall back
+ * to the period timer, which tries to watch again.
+ */
+static void state_watch_continuation (flux_future_t *f, void *arg)
+{
+    struct job_archive_ctx *ctx = arg;
+    json_t *transitions;
+    size_t index;
+    json_t *value;
+
+    if (flux_rpc_get_unpack (f, "{s:o}", "transitions", &transitions) < 0) {
+        if (errno != ENODATA)
+            flux_log (ctx->h, LOG_DEBUG, "job-info.state-watch: %s",
+                      strerror (errno));
+        flux_future_destroy (f);
+        ctx->watch_f = NULL;
+        return;
+    }
+    json_array_foreach (transitions, index, value) {
+        const char *state = json_string_value (json_array_get (value, 1));
+
+        if (state && !strcmp (state, "INACTIVE")) {
+            archive_start (ctx);
+            break;
+        }
+    }
+    flux_future_reset (f);
+}
+
+static void state_watch_start (struct job_archive_ctx *ctx)
+{
+    flux_future_t *f;
+
+    if (!(f = flux_rpc_pack (ctx->h,
+                             "job-info.state-watch",
+                             FLUX_NODEID_ANY,
+                             FLUX_RPC_STREAMING,
+                             "{s:i}",
+                             "userid", FLUX_USERID_UNKNOWN))
+        || flux_future_then (f, -1, state_watch_continuation, ctx) < 0) {
+        flux_log_error (ctx->h, "%s: job-info.state-watch", __FUNCTION__);
+        flux_future_destroy (f);
         return;
     }
+    ctx->watch_f = f;
 }
 
+void job_archive_cb (flux_reactor_t *r,
+                     flux_watcher_t *w,
+                     int revents,
+                     void *arg)
+{
+    struct job_archive_ctx *ctx = arg;
+
+    if (!ctx->watch_f)
+        state_watch_start (ctx);
+    archive_start (ctx);
+}
+
+static json_t *list_row_to_json (sqlite3_stmt *stmt)
+{
+    const char *s;
+    char *endptr;
+    unsigned long long id;
+    json_t *o;
+
+    if (!(s = (const char *)sqlite3_column_text (stmt, 0)))
+        goto inval;
+    errno = 0;
+    id = strtoull (s, &endptr, 10);
+    if (errno != 0 || *endptr != '\0')
+        goto inval;
+    if (!(o = json_pack ("{s:I s:i s:f s:f s:f s:f s:f s:i}",
+                         "id", (json_int_t)id,
+                         "userid", sqlite3_column_int (stmt, 1),
+                         "t_submit", sqlite3_column_double (stmt, 3),
+                         "t_sched", sqlite3_column_double (stmt, 4),
+                         "t_run", sqlite3_column_double (stmt, 5),
+                         "t_cleanup", sqlite3_column_double (stmt, 6),
+                         "t_inactive", sqlite3_column_double (stmt, 7),
+                         "state", FLUX_JOB_INACTIVE)))
+        goto nomem;
+    if ((s = (const char *)sqlite3_column_text (stmt, 2))
+        && json_object_set_new (o, "ranks", json_string (s)) < 0) {
+        json_decref (o);
+        goto nomem;
+    }
+    if ((s = (const char *)sqlite3_column_text (stmt, 8))
+        && json_object_set_new (o, "name", json_string (s)) < 0) {
+        json_decref (o);
+        goto nomem;
+    }
+    return o;
+inval:
+    errno = EINVAL;
+    return NULL;
+nomem:
+    errno = ENOMEM;
+    return NULL;
+}
+
+/* job-archive.list {"max_entries":i, "before":f, "userid":i}
+ * Respond with {"jobs":[...]}, the archived jobs with t_inactive <= before,
+ * newest first.  max_entries=0 is unlimited.
+ */
+static void list_cb (flux_t *h,
+                     flux_msg_handler_t *mh,
+                     const flux_msg_t *msg,
+                     void *arg)
+{
+    struct job_archive_ctx *ctx = arg;
+    int max_entries;
+    double before;
+    uint32_t userid;
+    json_t *jobs = NULL;
+    json_t *o;
+    int rc;
+
+    if (flux_request_unpack (msg, NULL, "{s:i s:f s:i}",
+                             "max_entries", &max_entries,
+                             "before", &before,
+                             "userid", &userid) < 0)
+        goto error;
+    if (max_entries < 0) {
+        errno = EPROTO;
+        goto error;
+    }
+    if (sqlite3_bind_double (ctx->list_stmt, 1, before) != SQLITE_OK
+        || sqlite3_bind_int64 (ctx->list_stmt,
+                               2,
+                               userid == FLUX_USERID_UNKNOWN
+                               ? -1 : userid) != SQLITE_OK
+        || sqlite3_bind_int (ctx->list_stmt,
+                             3,
+                             max_entries > 0 ? max_entries : -1) != SQLITE_OK) {
+        log_sqlite_error (ctx, "list: binding values");
+        errno = EINVAL;
+        goto error_reset;
+    }
+    if (!(jobs = json_array ())) {
+        errno = ENOMEM;
+        goto error_reset;
+    }
+    while ((rc = sqlite3_step (ctx->list_stmt)) == SQLITE_ROW) {
+        if (!(o = list_row_to_json (ctx->list_stmt)))
+            goto error_reset;
+        if (json_array_append_new (jobs, o) < 0) {
+            json_decref (o);
+            errno = ENOMEM;
+            goto error_reset;
+        }
+    }
+    if (rc != SQLITE_DONE) {
+        log_sqlite_error (ctx, "list: executing stmt");
+        errno = EIO;
+        goto error_reset;
+    }
+    sqlite3_reset (ctx->list_stmt);
+    if (flux_respond_pack (h, msg, "{s:O}", "jobs", jobs) < 0)
+        flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
+    json_decref (jobs);
+    return;
+error_reset:
+    sqlite3_reset (ctx->list_stmt);
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+    json_decref (jobs);
+}
+
+static const struct flux_msg_handler_spec htab[] = {
+    { FLUX_MSGTYPE_REQUEST, "job-archive.list", list_cb, FLUX_ROLE_USER },
+    FLUX_MSGHANDLER_TABLE_END,
+};
+
 static void process_config (struct job_archive_ctx *ctx, int ac, char **av)
 {
     flux_conf_error_t err;
@@ -584,6 +982,12 @@ int mod_main (flux_t *h, int ac, char **av)
         }
 
         flux_watcher_start (ctx->w);
+        state_watch_start (ctx);
+
+        if (flux_msg_handler_addvec (h, htab, ctx, &ctx->handlers) < 0) {
+            flux_log_error (h, "flux_msg_handler_addvec");
+            goto done;
+        }
     }
 
     if ((rc = flux_reactor_run (flux_get_reactor (h), 0)) < 0)
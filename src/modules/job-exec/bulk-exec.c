@@ -15,17 +15,54 @@
 #include <sys/wait.h>
 #define EXIT_CODE(x) __W_EXITCODE(x,0)
 
+#include <stdlib.h>
+#include <string.h>
 #include <flux/core.h>
 #include <flux/idset.h>
 #include <czmq.h>
+#include <jansson.h>
 
 #include "src/common/libutil/aux.h"
+#include "src/common/libutil/kary.h"
+#include "src/common/libsubprocess/command.h"
 #include "bulk-exec.h"
 
+/*  Ranks are held in an ascending array, launched in order from 'next' */
 struct exec_cmd {
+    uint32_t *ranks;
+    int count;
+    int next;
+    flux_cmd_t *cmd;
+    int flags;
+};
+
+/*  Per-rank state for ranks launched directly from this rank.  The
+ *   table is sorted by rank, so a rank is found by binary search and
+ *   kill, write and cleanup are a walk over one array.
+ */
+struct exec_rank {
+    uint32_t rank;
+    flux_subprocess_t *p;    /* NULL until launched */
+};
+
+/*  Ranks in the current exit batch with the same wait status */
+struct exit_code {
+    int status;
     struct idset *ranks;
+};
+
+/*  Commands for the subtree rooted at a TBON child are relayed through
+ *   job-exec on that child, which reports start, exit, output and errors
+ *   for the whole subtree in a single streaming response.
+ */
+struct exec_relay {
+    struct bulk_exec *exec;
+    uint32_t child;
+    struct idset *ranks;     /* Ranks that have not yet exited */
     flux_cmd_t *cmd;
     int flags;
+    int responses;
+    flux_future_t *f;        /* NULL until relay request is sent */
 };
 
 struct bulk_exec {
@@ -41,18 +78,30 @@ struct bulk_exec {
     int exit_status;         /* Largest wait status of all complete procs */
 
     unsigned int active:1;
+    unsigned int tree_kill:1;  /* Route bulk_exec_imp_kill() via TBON */
 
     flux_watcher_t *prep;
     flux_watcher_t *check;
     flux_watcher_t *idle;
 
     struct idset *exit_batch;         /* Support for batched exit notify */
+    zlist_t *exit_codes;              /* exit_batch ranks by wait status */
     flux_watcher_t *exit_batch_timer; /* Timer for batched exit notify */
 
     flux_subprocess_ops_t ops;
 
     zlist_t *commands;
-    zlist_t *processes;
+
+    struct exec_rank *ranks; /* Direct ranks, sorted by rank */
+    int nranks;
+    int nprocs;              /* Number of subprocesses created */
+
+    flux_jobid_t id;         /* Relay id for tree launch */
+    int tree_k;              /* TBON arity, or 0 for direct launch */
+    uint32_t rank;
+    uint32_t size;
+    zlist_t *relays;
+    int relays_unsent;
 
     struct bulk_exec_ops *handlers;
     void *arg;
@@ -65,7 +114,14 @@ int bulk_exec_rc (struct bulk_exec *exec)
 
 int bulk_exec_current (struct bulk_exec *exec)
 {
-    return zlist_size (exec->processes);
+    int count = exec->nprocs;
+    struct exec_relay *r = zlist_first (exec->relays);
+    while (r) {
+        if (r->f)
+            count += idset_count (r->ranks);
+        r = zlist_next (exec->relays);
+    }
+    return count;
 }
 
 int bulk_exec_total (struct bulk_exec *exec)
@@ -76,26 +132,159 @@ int bulk_exec_total (struct bulk_exec *exec)
 int bulk_exec_write (struct bulk_exec *exec, const char *stream,
                      const char *buf, size_t len)
 {
-    flux_subprocess_t *p = zlist_first (exec->processes);
-    while (p) {
-        if (flux_subprocess_write (p, stream, buf, len) < len)
+    int i;
+    for (i = 0; i < exec->nranks; i++) {
+        flux_subprocess_t *p = exec->ranks[i].p;
+        if (p && flux_subprocess_write (p, stream, buf, len) < len)
             return -1;
-        p = zlist_next (exec->processes);
     }
     return 0;
 }
 
 int bulk_exec_close (struct bulk_exec *exec, const char *stream)
 {
-    flux_subprocess_t *p = zlist_first (exec->processes);
-    while (p) {
-        if (flux_subprocess_close (p, stream) < 0)
+    int i;
+    for (i = 0; i < exec->nranks; i++) {
+        flux_subprocess_t *p = exec->ranks[i].p;
+        if (p && flux_subprocess_close (p, stream) < 0)
             return -1;
-        p = zlist_next (exec->processes);
     }
     return 0;
 }
 
+static struct exec_rank *exec_rank_lookup (struct bulk_exec *exec,
+                                           uint32_t rank)
+{
+    int lo = 0;
+    int hi = exec->nranks - 1;
+
+    while (lo <= hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (exec->ranks[mid].rank == rank)
+            return &exec->ranks[mid];
+        if (exec->ranks[mid].rank < rank)
+            lo = mid + 1;
+        else
+            hi = mid - 1;
+    }
+    return NULL;
+}
+
+/*  Merge ascending 'ranks' into the rank table.  A rank may only be
+ *   launched once per bulk_exec object, so fail with EEXIST if any
+ *   rank is already present.
+ */
+static int exec_rank_add (struct bulk_exec *exec,
+                          const uint32_t *ranks,
+                          int count)
+{
+    struct exec_rank *table;
+    int i = 0;
+    int j = 0;
+    int n = 0;
+
+    if (count == 0)
+        return 0;
+    if (!(table = calloc (exec->nranks + count, sizeof (*table))))
+        return -1;
+    while (i < exec->nranks || j < count) {
+        if (j == count
+            || (i < exec->nranks && exec->ranks[i].rank < ranks[j]))
+            table[n++] = exec->ranks[i++];
+        else if (i == exec->nranks || ranks[j] < exec->ranks[i].rank)
+            table[n++].rank = ranks[j++];
+        else {
+            free (table);
+            errno = EEXIST;
+            return -1;
+        }
+    }
+    free (exec->ranks);
+    exec->ranks = table;
+    exec->nranks = n;
+    return 0;
+}
+
+/*  Return the ids in 'ids' as an ascending array, with length in 'count'.
+ */
+static uint32_t *idset_to_array (const struct idset *ids, int *count)
+{
+    uint32_t *ranks;
+    unsigned int id;
+    int n = 0;
+
+    if (!(ranks = calloc (idset_count (ids) + 1, sizeof (*ranks))))
+        return NULL;
+    id = idset_first (ids);
+    while (id != IDSET_INVALID_ID) {
+        ranks[n++] = id;
+        id = idset_next (ids, id);
+    }
+    *count = n;
+    return ranks;
+}
+
+static void exit_code_destroy (void *arg)
+{
+    struct exit_code *ec = arg;
+    if (ec) {
+        idset_destroy (ec->ranks);
+        free (ec);
+    }
+}
+
+static struct exit_code *exit_code_get (struct bulk_exec *exec, int status)
+{
+    struct exit_code *ec = zlist_first (exec->exit_codes);
+    while (ec) {
+        if (ec->status == status)
+            return ec;
+        ec = zlist_next (exec->exit_codes);
+    }
+    if (!(ec = calloc (1, sizeof (*ec))))
+        return NULL;
+    ec->status = status;
+    if (!(ec->ranks = idset_create (0, IDSET_FLAG_AUTOGROW))
+        || zlist_append (exec->exit_codes, ec) < 0) {
+        exit_code_destroy (ec);
+        return NULL;
+    }
+    zlist_freefn (exec->exit_codes, ec, exit_code_destroy, true);
+    return ec;
+}
+
+json_t *bulk_exec_exit_codes (struct bulk_exec *exec)
+{
+    struct exit_code *ec;
+    json_t *o;
+
+    if (!(o = json_object ()))
+        goto nomem;
+    ec = zlist_first (exec->exit_codes);
+    while (ec) {
+        char key[16];
+        char *s;
+        json_t *val;
+
+        if (!(s = idset_encode (ec->ranks, IDSET_FLAG_RANGE)))
+            goto error;
+        val = json_string (s);
+        free (s);
+        snprintf (key, sizeof (key), "%d", ec->status);
+        if (!val || json_object_set_new (o, key, val) < 0) {
+            json_decref (val);
+            goto nomem;
+        }
+        ec = zlist_next (exec->exit_codes);
+    }
+    return o;
+nomem:
+    errno = ENOMEM;
+error:
+    json_decref (o);
+    return NULL;
+}
+
 static int exec_exit_notify (struct bulk_exec *exec)
 {
     if (exec->handlers->on_exit)
@@ -105,6 +294,7 @@ static int exec_exit_notify (struct bulk_exec *exec)
         exec->exit_batch_timer = NULL;
         idset_range_clear (exec->exit_batch, 0, INT_MAX);
     }
+    zlist_purge (exec->exit_codes);
     return 0;
 }
 
@@ -115,21 +305,29 @@ static void exit_batch_cb (flux_reactor_t *r, flux_watcher_t *w,
     exec_exit_notify (exec);
 }
 
-/*  Append completed subprocess 'p' to the current batch for exit
+/*  Append completed 'rank' to the current batch for exit
  *   notification. If this is the first exited process in the batch,
  *   then start a timer which will fire and call the function to
  *   notify bulk_exec user of the batch of subprocess exits.
  *
  *  This appraoch avoids unecessarily calling into user's callback
- *   multiple times when all tasks exit within 0.01s.
+ *   multiple times when all tasks exit within 0.01s.  Exits relayed
+ *   from TBON children are merged into the same batch, so each level
+ *   of the tree sends one exit response per batch.
  */
-static void exit_batch_append (struct bulk_exec *exec, flux_subprocess_t *p)
+static void exit_batch_append (struct bulk_exec *exec, int rank, int status)
 {
-    int rank = flux_subprocess_rank (p);
+    struct exit_code *ec;
+
     if (idset_set (exec->exit_batch, rank) < 0) {
         flux_log_error (exec->h, "exit_batch_append:idset_set");
         return;
     }
+    if (!(ec = exit_code_get (exec, status))
+        || idset_set (ec->ranks, rank) < 0) {
+        flux_log_error (exec->h, "exit_batch_append:exit_code");
+        return;
+    }
     if (!exec->exit_batch_timer) {
         flux_reactor_t *r = flux_get_reactor (exec->h);
         /*  XXX: batch timer should eventually be configurable by caller */
@@ -145,57 +343,106 @@ static void exit_batch_append (struct bulk_exec *exec, flux_subprocess_t *p)
     }
 }
 
-static void exec_add_completed (struct bulk_exec *exec, flux_subprocess_t *p)
+static void exec_check_complete (struct bulk_exec *exec)
 {
-    /* Append this process to the current batch for notification */
-    exit_batch_append (exec, p);
-
-    if (++exec->complete == exec->total) {
+    if (exec->complete == exec->total) {
         exec_exit_notify (exec);
         if (exec->handlers->on_complete)
             (*exec->handlers->on_complete) (exec, exec->arg);
     }
 }
 
-static void exec_complete_cb (flux_subprocess_t *p)
+static void exec_set_status (struct bulk_exec *exec, int status)
 {
-    int status = flux_subprocess_status (p);
-    struct bulk_exec *exec = flux_subprocess_aux_get (p, "job-exec::exec");
-
     if (status > exec->exit_status)
         exec->exit_status = status;
+}
+
+static void exec_add_completed (struct bulk_exec *exec, int rank, int status)
+{
+    exec_set_status (exec, status);
+    /* Append this process to the current batch for notification */
+    exit_batch_append (exec, rank, status);
+    exec->complete++;
+    exec_check_complete (exec);
+}
+
+static void exec_add_completed_ranks (struct bulk_exec *exec,
+                                      const struct idset *ranks,
+                                      int status)
+{
+    unsigned int rank = idset_first (ranks);
+    if (rank == IDSET_INVALID_ID)
+        return;
+    exec_set_status (exec, status);
+    while (rank != IDSET_INVALID_ID) {
+        exit_batch_append (exec, rank, status);
+        exec->complete++;
+        rank = idset_next (ranks, rank);
+    }
+    exec_check_complete (exec);
+}
+
+static void exec_add_started (struct bulk_exec *exec, int count)
+{
+    exec->started += count;
+    if (count > 0 && exec->started == exec->total) {
+        if (exec->handlers->on_start)
+            (*exec->handlers->on_start) (exec, exec->arg);
+    }
+}
+
+static int errno_to_status (int errnum)
+{
+    if (errnum == EPERM || errnum == EACCES)
+        return EXIT_CODE(126);
+    else if (errnum == ENOENT)
+        return EXIT_CODE(127);
+    else if (errnum == EHOSTUNREACH)
+        return EXIT_CODE(68);
+    return EXIT_CODE(1);
+}
+
+static void exec_error (struct bulk_exec *exec, int rank, int errnum)
+{
+    if (exec->handlers->on_error)
+        (*exec->handlers->on_error) (exec, rank, errnum, exec->arg);
+}
+
+static void exec_output (struct bulk_exec *exec,
+                         int rank,
+                         const char *stream,
+                         const char *s,
+                         int len)
+{
+    if (exec->handlers->on_output)
+        (*exec->handlers->on_output) (exec, rank, stream, s, len, exec->arg);
+    else
+        flux_log (exec->h, LOG_INFO, "rank %d: %s: %s", rank, stream, s);
+}
+
+static void exec_complete_cb (flux_subprocess_t *p)
+{
+    struct bulk_exec *exec = flux_subprocess_aux_get (p, "job-exec::exec");
 
-    exec_add_completed (exec, p);
+    exec_add_completed (exec,
+                        flux_subprocess_rank (p),
+                        flux_subprocess_status (p));
 }
 
 static void exec_state_cb (flux_subprocess_t *p, flux_subprocess_state_t state)
 {
     struct bulk_exec *exec = flux_subprocess_aux_get (p, "job-exec::exec");
-    if (state == FLUX_SUBPROCESS_RUNNING) {
-        if (++exec->started == exec->total) {
-            if (exec->handlers->on_start)
-                (*exec->handlers->on_start) (exec, exec->arg);
-        }
-    }
+    if (state == FLUX_SUBPROCESS_RUNNING)
+        exec_add_started (exec, 1);
     else if (state == FLUX_SUBPROCESS_FAILED
             || state == FLUX_SUBPROCESS_EXEC_FAILED) {
         int errnum = flux_subprocess_fail_errno (p);
-        int code = EXIT_CODE(1);
-
-        if (errnum == EPERM || errnum == EACCES)
-            code = EXIT_CODE(126);
-        else if (errnum == ENOENT)
-            code = EXIT_CODE(127);
-        else if (errnum == EHOSTUNREACH)
-            code = EXIT_CODE(68);
 
-        if (code > exec->exit_status)
-            exec->exit_status = code;
-
-        if (exec->handlers->on_error)
-            (*exec->handlers->on_error) (exec, p, exec->arg);
-
-        exec_add_completed (exec, p);
+        exec_error (exec, flux_subprocess_rank (p), errnum);
+        exec_add_completed (exec,
+                            flux_subprocess_rank (p),
+                            errno_to_status (errnum));
     }
 }
 
@@ -209,34 +456,32 @@ static void exec_output_cb (flux_subprocess_t *p, const char *stream)
         flux_log_error (exec->h, "flux_subprocess_getline");
         return;
     }
-    if (len) {
-        int rank = flux_subprocess_rank (p);
-        if (exec->handlers->on_output)
-            (*exec->handlers->on_output) (exec, p, stream, s, len, exec->arg);
-        else
-            flux_log (exec->h, LOG_INFO, "rank %d: %s: %s", rank, stream, s);
-    }
+    if (len)
+        exec_output (exec, flux_subprocess_rank (p), stream, s, len);
 }
 
 static void exec_cmd_destroy (void *arg)
 {
     struct exec_cmd *cmd = arg;
-    idset_destroy (cmd->ranks);
+    free (cmd->ranks);
     flux_cmd_destroy (cmd->cmd);
     free (cmd);
 }
 
-static struct exec_cmd *exec_cmd_create (const struct idset *ranks,
+static struct exec_cmd *exec_cmd_create (const uint32_t *ranks,
+                                         int count,
                                          flux_cmd_t *cmd,
                                          int flags)
 {
     struct exec_cmd *c = calloc (1, sizeof (*c));
     if (!c)
         return NULL;
-    if (!(c->ranks = idset_copy (ranks))) {
-        fprintf (stderr, "exec_cmd_create: idset_copy failed");
+    if (!(c->ranks = calloc (count + 1, sizeof (*c->ranks)))) {
+        fprintf (stderr, "exec_cmd_create: out of memory");
         goto err;
     }
+    memcpy (c->ranks, ranks, count * sizeof (*c->ranks));
+    c->count = count;
     if (!(c->cmd = flux_cmd_copy (cmd))) {
         fprintf (stderr, "exec_cmd_create: flux_cmd_copy failed");
         goto err;
@@ -248,6 +493,219 @@ err:
     return NULL;
 }
 
+static void exec_relay_destroy (void *arg)
+{
+    struct exec_relay *r = arg;
+    if (r) {
+        int saved_errno = errno;
+        flux_future_destroy (r->f);
+        idset_destroy (r->ranks);
+        flux_cmd_destroy (r->cmd);
+        free (r);
+        errno = saved_errno;
+    }
+}
+
+static struct exec_relay *exec_relay_create (struct bulk_exec *exec,
+                                             uint32_t child,
+                                             flux_cmd_t *cmd,
+                                             int flags)
+{
+    struct exec_relay *r = calloc (1, sizeof (*r));
+    if (!r)
+        return NULL;
+    r->exec = exec;
+    r->child = child;
+    r->flags = flags;
+    if (!(r->ranks = idset_create (0, IDSET_FLAG_AUTOGROW))
+        || !(r->cmd = flux_cmd_copy (cmd))) {
+        exec_relay_destroy (r);
+        return NULL;
+    }
+    return r;
+}
+
+static int exec_push_direct (struct bulk_exec *exec,
+                             const uint32_t *ranks,
+                             int count,
+                             flux_cmd_t *cmd,
+                             int flags)
+{
+    struct exec_cmd *c = exec_cmd_create (ranks, count, cmd, flags);
+    if (!c)
+        return -1;
+
+    if (zlist_append (exec->commands, c) < 0) {
+        exec_cmd_destroy (c);
+        return -1;
+    }
+    zlist_freefn (exec->commands, c, exec_cmd_destroy, true);
+    if (exec_rank_add (exec, ranks, count) < 0) {
+        int saved_errno = errno;
+        zlist_remove (exec->commands, c);
+        errno = saved_errno;
+        return -1;
+    }
+    return 0;
+}
+
+/*  Relay request failed.  If job-exec is not loaded on the child,
+ *   fall back to direct launch of the subtree.  Otherwise, all ranks
+ *   in the subtree that have not yet exited are considered failed.
+ */
+static void exec_relay_fail (struct exec_relay *r, int errnum)
+{
+    struct bulk_exec *exec = r->exec;
+    uint32_t child = r->child;
+    struct idset *ranks = r->ranks;
+
+    if (errnum == ENOSYS && r->responses == 0) {
+        uint32_t *direct;
+        int count;
+
+        flux_log (exec->h, LOG_DEBUG,
+                  "job-exec not loaded on rank %u, launching directly",
+                  child);
+        if ((direct = idset_to_array (ranks, &count))) {
+            int rc = exec_push_direct (exec, direct, count,
+                                       r->cmd, r->flags);
+            free (direct);
+            if (rc == 0) {
+                zlist_remove (exec->relays, r);
+                flux_watcher_start (exec->prep);
+                flux_watcher_start (exec->check);
+                return;
+            }
+        }
+        errnum = errno;
+    }
+    r->ranks = NULL;
+    zlist_remove (exec->relays, r);
+
+    exec_error (exec, child, errnum);
+    exec_add_completed_ranks (exec, ranks, errno_to_status (errnum));
+    idset_destroy (ranks);
+}
+
+/*  Merge exits relayed from a subtree, {"status":"ranks", ...},
+ *   into the current exit batch.
+ */
+static int exec_relay_exited (struct exec_relay *r, json_t *exits)
+{
+    const char *key;
+    json_t *val;
+
+    json_object_foreach (exits, key, val) {
+        struct idset *ranks;
+        unsigned int rank;
+        char *endptr;
+        long status;
+
+        errno = 0;
+        status = strtol (key, &endptr, 10);
+        if (errno != 0 || *endptr != '\0'
+            || !json_is_string (val)
+            || !(ranks = idset_decode (json_string_value (val)))) {
+            errno = EPROTO;
+            return -1;
+        }
+        rank = idset_first (ranks);
+        while (rank != IDSET_INVALID_ID) {
+            (void) idset_clear (r->ranks, rank);
+            rank = idset_next (ranks, rank);
+        }
+        exec_add_completed_ranks (r->exec, ranks, status);
+        idset_destroy (ranks);
+    }
+    return 0;
+}
+
+static void exec_relay_continuation (flux_future_t *f, void *arg)
+{
+    struct exec_relay *r = arg;
+    struct bulk_exec *exec = r->exec;
+    const char *type;
+    const char *stream;
+    const char *s;
+    json_t *exits;
+    int rank;
+    int n;
+
+    if (flux_rpc_get_unpack (f, "{s:s}", "type", &type) < 0) {
+        if (errno != ENODATA)
+            exec_relay_fail (r, errno);
+        else if (idset_count (r->ranks) > 0)
+            exec_relay_fail (r, EPROTO);
+        else
+            zlist_remove (exec->relays, r);
+        return;
+    }
+    r->responses++;
+    if (!strcmp (type, "start")
+        && flux_rpc_get_unpack (f, "{s:i}", "count", &n) == 0)
+        exec_add_started (exec, n);
+    else if (!strcmp (type, "exit")
+        && flux_rpc_get_unpack (f, "{s:o}", "exits", &exits) == 0) {
+        if (exec_relay_exited (r, exits) < 0)
+            flux_log_error (exec->h, "relay: invalid exit response");
+    }
+    else if (!strcmp (type, "output")
+        && flux_rpc_get_unpack (f, "{s:i s:s s:s}",
+                                "rank", &rank,
+                                "stream", &stream,
+                                "data", &s) == 0)
+        exec_output (exec, rank, stream, s, strlen (s));
+    else if (!strcmp (type, "error")
+        && flux_rpc_get_unpack (f, "{s:i s:i}",
+                                "rank", &rank,
+                                "errnum", &n) == 0)
+        exec_error (exec, rank, n);
+    else
+        flux_log (exec->h, LOG_ERR, "relay: invalid %s response", type);
+    flux_future_reset (f);
+}
+
+static int exec_relay_send (struct bulk_exec *exec, struct exec_relay *r)
+{
+    char *cmd = NULL;
+    char *ranks = NULL;
+    int rc = -1;
+
+    if (!(cmd = flux_cmd_tojson (r->cmd))
+        || !(ranks = idset_encode (r->ranks, IDSET_FLAG_RANGE)))
+        goto out;
+    if (!(r->f = flux_rpc_pack (exec->h,
+                                "job-exec.relay",
+                                r->child,
+                                FLUX_RPC_STREAMING,
+                                "{s:I s:s s:s s:i}",
+                                "id", exec->id,
+                                "ranks", ranks,
+                                "cmd", cmd,
+                                "flags", r->flags))
+        || flux_future_then (r->f, -1., exec_relay_continuation, r) < 0)
+        goto out;
+    rc = 0;
+out:
+    free (cmd);
+    free (ranks);
+    return rc;
+}
+
+static int exec_start_relays (struct bulk_exec *exec)
+{
+    struct exec_relay *r = zlist_first (exec->relays);
+    while (r && exec->relays_unsent > 0) {
+        if (!r->f) {
+            if (exec_relay_send (exec, r) < 0)
+                return -1;
+            exec->relays_unsent--;
+        }
+        r = zlist_next (exec->relays);
+    }
+    return 0;
+}
+
 static void subprocess_destroy_finish (flux_future_t *f, void *arg)
 {
     flux_subprocess_t *p = arg;
@@ -274,29 +732,30 @@ static int exec_start_cmd (struct bulk_exec *exec,
                            int max)
 {
     int count = 0;
-    uint32_t rank;
-    rank = idset_first (cmd->ranks);
-    while (rank != IDSET_INVALID_ID && (max < 0 || count < max)) {
-        flux_subprocess_t *p = flux_rexec (exec->h,
-                                           rank,
-                                           cmd->flags,
-                                           cmd->cmd,
-                                           &exec->ops);
-        if (!p)
+    while (cmd->next < cmd->count && (max < 0 || count < max)) {
+        uint32_t rank = cmd->ranks[cmd->next];
+        struct exec_rank *er = exec_rank_lookup (exec, rank);
+        flux_subprocess_t *p;
+
+        if (!er || er->p) {
+            errno = EINVAL;
+            return -1;
+        }
+        if (!(p = flux_rexec (exec->h,
+                              rank,
+                              cmd->flags,
+                              cmd->cmd,
+                              &exec->ops)))
             return -1;
-        if (flux_subprocess_aux_set (p, "job-exec::exec", exec, NULL) < 0
-           || zlist_append (exec->processes, p) < 0) {
+        if (flux_subprocess_aux_set (p, "job-exec::exec", exec, NULL) < 0) {
             if (subprocess_destroy (exec->h, p) < 0)
                 flux_log_error (exec->h, "Unable to destroy pid %ju",
                         (uintmax_t) flux_subprocess_pid (p));
             return -1;
         }
-        zlist_freefn (exec->processes, p,
-                     (zlist_free_fn *) flux_subprocess_unref,
-                     true);
-
-        idset_clear (cmd->ranks, rank);
-        rank = idset_next (cmd->ranks, rank);
+        er->p = p;
+        exec->nprocs++;
+        cmd->next++;
         count++;
     }
     return count;
@@ -310,6 +769,10 @@ void bulk_exec_stop (struct bulk_exec *exec)
 
 static int exec_start_cmds (struct bulk_exec *exec, int max)
 {
+    if (exec_start_relays (exec) < 0) {
+        flux_log_error (exec->h, "exec_start_relays failed");
+        return -1;
+    }
     while (zlist_size (exec->commands) && (max != 0)) {
         struct exec_cmd *cmd = zlist_first (exec->commands);
         int rc = exec_start_cmd (exec, cmd, max);
@@ -317,7 +780,7 @@ static int exec_start_cmds (struct bulk_exec *exec, int max)
             flux_log_error (exec->h, "exec_start_cmd failed");
             return -1;
         }
-        if (idset_count (cmd->ranks) == 0)
+        if (cmd->next == cmd->count)
             zlist_remove (exec->commands, cmd);
         if (max > 0)
             max -= rc;
@@ -333,7 +796,7 @@ static void prep_cb (flux_reactor_t *r, flux_watcher_t *w,
     struct bulk_exec *exec = arg;
 
     /* Don't block in reactor if there are commands to run */
-    if (zlist_size (exec->commands) > 0) {
+    if (zlist_size (exec->commands) > 0 || exec->relays_unsent > 0) {
         flux_watcher_start (exec->idle);
         flux_watcher_start (exec->check);
     }
@@ -349,17 +812,21 @@ static void check_cb (flux_reactor_t *r, flux_watcher_t *w,
     flux_watcher_stop (exec->check);
     if (exec_start_cmds (exec, exec->max_start_per_loop) < 0) {
         bulk_exec_stop (exec);
-        if (exec->handlers->on_error)
-            (*exec->handlers->on_error) (exec, NULL, exec->arg);
+        exec_error (exec, -1, errno);
     }
 }
 
 void bulk_exec_destroy (struct bulk_exec *exec)
 {
     if (exec) {
-        zlist_destroy (&exec->processes);
+        int i;
+        zlist_destroy (&exec->relays);
+        for (i = 0; i < exec->nranks; i++)
+            flux_subprocess_unref (exec->ranks[i].p);
+        free (exec->ranks);
         zlist_destroy (&exec->commands);
         idset_destroy (exec->exit_batch);
+        zlist_destroy (&exec->exit_codes);
         flux_watcher_destroy (exec->prep);
         flux_watcher_destroy (exec->check);
         flux_watcher_destroy (exec->idle);
@@ -382,9 +849,10 @@ struct bulk_exec * bulk_exec_create (struct bulk_exec_ops *ops, void *arg)
     exec->ops = sp_ops;
     exec->handlers = ops;
     exec->arg = arg;
-    exec->processes = zlist_new ();
     exec->commands = zlist_new ();
+    exec->relays = zlist_new ();
     exec->exit_batch = idset_create (0, IDSET_FLAG_AUTOGROW);
+    exec->exit_codes = zlist_new ();
     exec->max_start_per_loop = 1;
 
     return exec;
@@ -400,22 +868,141 @@ int bulk_exec_set_max_per_loop (struct bulk_exec *exec, int max)
     return 0;
 }
 
-int bulk_exec_push_cmd (struct bulk_exec *exec,
-                       const struct idset *ranks,
-                       flux_cmd_t *cmd,
-                       int flags)
+static int tree_params (flux_t *h, int *kp, uint32_t *rankp, uint32_t *sizep)
 {
-    struct exec_cmd *c = exec_cmd_create (ranks, cmd, flags);
-    if (!c)
+    const char *s;
+    char *endptr;
+    long k;
+
+    if (flux_get_rank (h, rankp) < 0
+        || flux_get_size (h, sizep) < 0
+        || !(s = flux_attr_get (h, "tbon.arity")))
+        return -1;
+    errno = 0;
+    k = strtol (s, &endptr, 10);
+    if (errno != 0 || *endptr != '\0' || k < 1 || k > INT_MAX) {
+        errno = EINVAL;
         return -1;
+    }
+    *kp = k;
+    return 0;
+}
 
-    if (zlist_append (exec->commands, c) < 0) {
-        exec_cmd_destroy (c);
+int bulk_exec_set_tree (struct bulk_exec *exec, flux_t *h, flux_jobid_t id)
+{
+    if (tree_params (h, &exec->tree_k, &exec->rank, &exec->size) < 0)
+        return -1;
+    exec->id = id;
+    exec->tree_kill = 1;
+    return 0;
+}
+
+void bulk_exec_set_tree_kill (struct bulk_exec *exec, bool enable)
+{
+    exec->tree_kill = enable;
+}
+
+static struct exec_relay *exec_relay_find (zlist_t *l, uint32_t child)
+{
+    struct exec_relay *r = zlist_first (l);
+    while (r && r->child != child)
+        r = zlist_next (l);
+    return r;
+}
+
+/*  Split 'ranks' into this rank, which is launched directly, and the
+ *   subtrees of TBON children, which are relayed.
+ */
+static int exec_push_tree (struct bulk_exec *exec,
+                           const uint32_t *ranks,
+                           int count,
+                           flux_cmd_t *cmd,
+                           int flags)
+{
+    uint32_t *direct;
+    int ndirect = 0;
+    zlist_t *relays;
+    struct exec_relay *r;
+    int i;
+    int rc = -1;
+
+    if (!(direct = calloc (count + 1, sizeof (*direct))))
+        return -1;
+    if (!(relays = zlist_new ())) {
+        free (direct);
+        errno = ENOMEM;
         return -1;
     }
-    zlist_freefn (exec->commands, c, exec_cmd_destroy, true);
+    for (i = 0; i < count; i++) {
+        uint32_t rank = ranks[i];
+        uint32_t child = kary_child_route (exec->tree_k,
+                                           exec->size,
+                                           exec->rank,
+                                           rank);
+        if (rank == exec->rank || child == KARY_NONE)
+            direct[ndirect++] = rank;
+        else {
+            if (!(r = exec_relay_find (relays, child))) {
+                if (!(r = exec_relay_create (exec, child, cmd, flags)))
+                    goto out;
+                if (zlist_append (relays, r) < 0) {
+                    exec_relay_destroy (r);
+                    errno = ENOMEM;
+                    goto out;
+                }
+            }
+            if (idset_set (r->ranks, rank) < 0)
+                goto out;
+        }
+    }
+    if (ndirect > 0
+        && exec_push_direct (exec, direct, ndirect, cmd, flags) < 0)
+        goto out;
+    while ((r = zlist_pop (relays))) {
+        if (zlist_append (exec->relays, r) < 0) {
+            exec_relay_destroy (r);
+            errno = ENOMEM;
+            goto out;
+        }
+        zlist_freefn (exec->relays, r, exec_relay_destroy, true);
+        exec->relays_unsent++;
+    }
+    rc = 0;
+out:
+    while ((r = zlist_pop (relays)))
+        exec_relay_destroy (r);
+    zlist_destroy (&relays);
+    free (direct);
+    return rc;
+}
 
-    exec->total += idset_count (ranks);
+int bulk_exec_push_ranks (struct bulk_exec *exec,
+                          const uint32_t *ranks,
+                          int count,
+                          flux_cmd_t *cmd,
+                          int flags)
+{
+    int rc;
+    int i;
+
+    if (!ranks || count < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    for (i = 1; i < count; i++) {
+        if (ranks[i] <= ranks[i - 1]) {
+            errno = EINVAL;
+            return -1;
+        }
+    }
+    if (exec->tree_k > 0)
+        rc = exec_push_tree (exec, ranks, count, cmd, flags);
+    else
+        rc = exec_push_direct (exec, ranks, count, cmd, flags);
+    if (rc < 0)
+        return -1;
+
+    exec->total += count;
     if (exec->active) {
         flux_watcher_start (exec->prep);
         flux_watcher_start (exec->check);
@@ -424,6 +1011,22 @@ int bulk_exec_push_cmd (struct bulk_exec *exec,
     return 0;
 }
 
+int bulk_exec_push_cmd (struct bulk_exec *exec,
+                       const struct idset *ranks,
+                       flux_cmd_t *cmd,
+                       int flags)
+{
+    uint32_t *array;
+    int count;
+    int rc;
+
+    if (!(array = idset_to_array (ranks, &count)))
+        return -1;
+    rc = bulk_exec_push_ranks (exec, array, count, cmd, flags);
+    free (array);
+    return rc;
+}
+
 int bulk_exec_start (flux_t *h, struct bulk_exec *exec)
 {
     flux_reactor_t *r = flux_get_reactor (h);
@@ -440,23 +1043,44 @@ int bulk_exec_start (flux_t *h, struct bulk_exec *exec)
 
 /*  Cancel all pending commands.
  */
+static void exec_cancel_rank (struct bulk_exec *exec, uint32_t rank)
+{
+    exec->complete++;
+    if (idset_set (exec->exit_batch, rank) < 0)
+        flux_log_error (exec->h, "bulk_exec_cancel: idset_set");
+}
+
 int bulk_exec_cancel (struct bulk_exec *exec)
 {
     struct exec_cmd *cmd = zlist_first (exec->commands);
-    if (!cmd)
+    struct exec_relay *r;
+
+    if (!cmd && exec->relays_unsent == 0)
         return 0;
 
     while (cmd) {
-        uint32_t rank = idset_first (cmd->ranks);
-        while (rank != IDSET_INVALID_ID) {
-            exec->complete++;
-            if (idset_set (exec->exit_batch, rank) < 0)
-                flux_log_error (exec->h, "bulk_exec_cance: idset_set");
-            rank = idset_next (cmd->ranks, rank);
-        }
+        int i;
+        for (i = cmd->next; i < cmd->count; i++)
+            exec_cancel_rank (exec, cmd->ranks[i]);
         cmd = zlist_next (exec->commands);
     }
     zlist_purge (exec->commands);
+
+    /*  Relays that have not been sent are pending commands too */
+    r = zlist_first (exec->relays);
+    while (r) {
+        struct exec_relay *next = zlist_next (exec->relays);
+        if (!r->f) {
+            unsigned int rank = idset_first (r->ranks);
+            while (rank != IDSET_INVALID_ID) {
+                exec_cancel_rank (exec, rank);
+                rank = idset_next (r->ranks, rank);
+            }
+            zlist_remove (exec->relays, r);
+        }
+        r = next;
+    }
+    exec->relays_unsent = 0;
     exec_exit_notify (exec);
 
     if (exec->complete == exec->total) {
@@ -468,14 +1092,18 @@ int bulk_exec_cancel (struct bulk_exec *exec)
 
 flux_future_t *bulk_exec_kill (struct bulk_exec *exec, int signum)
 {
-    flux_subprocess_t *p = zlist_first (exec->processes);
+    struct exec_relay *r;
     flux_future_t *cf = NULL;
+    int i;
 
     if (!(cf = flux_future_wait_all_create ()))
         return NULL;
     flux_future_set_flux (cf, exec->h);
 
-    while (p) {
+    for (i = 0; i < exec->nranks; i++) {
+        flux_subprocess_t *p = exec->ranks[i].p;
+        if (!p)
+            continue;
         if (flux_subprocess_state (p) == FLUX_SUBPROCESS_RUNNING
             || flux_subprocess_state (p) == FLUX_SUBPROCESS_INIT) {
             flux_future_t *f = NULL;
@@ -488,14 +1116,41 @@ flux_future_t *bulk_exec_kill (struct bulk_exec *exec, int signum)
                 else
                     flux_future_fulfill_error (cf, err, "Internal error");
             }
-            (void) snprintf (s, sizeof (s)-1, "%u",
-                            flux_subprocess_rank (p));
+            (void) snprintf (s, sizeof (s)-1, "%u", exec->ranks[i].rank);
             if (flux_future_push (cf, s, f) < 0) {
                 fprintf (stderr, "flux_future_push: %s\n", strerror (errno));
                 flux_future_destroy (f);
             }
         }
-        p = zlist_next (exec->processes);
+    }
+
+    /*  Forward the signal to relayed subtrees
+     */
+    r = zlist_first (exec->relays);
+    while (r) {
+        if (r->f) {
+            flux_future_t *f;
+            char s[64];
+            if (!(f = flux_rpc_pack (exec->h,
+                                     "job-exec.kill",
+                                     r->child,
+                                     0,
+                                     "{s:I s:i}",
+                                     "id", exec->id,
+                                     "signum", signum))) {
+                flux_log_error (exec->h, "bulk_exec_kill: relay rank %u",
+                                r->child);
+            }
+            else {
+                (void) snprintf (s, sizeof (s), "relay.%u", r->child);
+                if (flux_future_push (cf, s, f) < 0) {
+                    fprintf (stderr, "flux_future_push: %s\n",
+                             strerror (errno));
+                    flux_future_destroy (f);
+                }
+            }
+        }
+        r = zlist_next (exec->relays);
     }
 
     /*  If no child futures were pushed into the wait_all future `cf`,
@@ -510,14 +1165,89 @@ flux_future_t *bulk_exec_kill (struct bulk_exec *exec, int signum)
     return cf;
 }
 
+/*  "flux-imp kill" fan-out.  Each (rank, pid) pair is either killed with
+ *   a local bulk_exec of "flux-imp kill <signal> <pid>", for this rank
+ *   and ranks with no TBON route, or forwarded with the pairs for the
+ *   rest of its subtree to job-exec on the TBON child it routes through.
+ *   Each level reports the ranks it signaled as one idset, so a wide job
+ *   is signaled in O(depth) hops with one request per TBON child.
+ */
+struct imp_kill_child {
+    struct imp_kill *ik;
+    uint32_t child;
+    struct idset *ranks;
+    json_t *pids;            /* in 'ranks' order */
+    flux_future_t *f;
+};
+
+struct imp_kill {
+    flux_t *h;
+    flux_future_t *f;        /* fulfilled with idset of signaled ranks */
+    char *imp_path;
+    int signum;
+    int tree_k;              /* TBON arity, or 0 to kill directly */
+    uint32_t rank;
+    uint32_t size;
+    struct bulk_exec *local;
+    unsigned int local_busy:1;
+    unsigned int done:1;
+    zlist_t *children;
+    int children_pending;
+    struct idset *signaled;
+};
+
+static void imp_kill_child_destroy (void *arg)
+{
+    struct imp_kill_child *c = arg;
+    if (c) {
+        int saved_errno = errno;
+        flux_future_destroy (c->f);
+        idset_destroy (c->ranks);
+        json_decref (c->pids);
+        free (c);
+        errno = saved_errno;
+    }
+}
+
+static void imp_kill_destroy (struct imp_kill *ik)
+{
+    if (ik) {
+        int saved_errno = errno;
+        bulk_exec_destroy (ik->local);
+        zlist_destroy (&ik->children);
+        idset_destroy (ik->signaled);
+        free (ik->imp_path);
+        free (ik);
+        errno = saved_errno;
+    }
+}
+
+static void imp_kill_check (struct imp_kill *ik)
+{
+    if (!ik->done && !ik->local_busy && ik->children_pending == 0) {
+        ik->done = 1;
+        flux_future_fulfill (ik->f, ik->signaled,
+                             (flux_free_f) idset_destroy);
+        ik->signaled = NULL;
+    }
+}
+
+static void imp_kill_add_signaled (struct imp_kill *ik, const char *ranks)
+{
+    struct idset *ids;
+
+    if (!(ids = idset_decode (ranks)) || idset_add (ik->signaled, ids) < 0)
+        flux_log_error (ik->h, "imp kill: error recording ranks %s", ranks);
+    idset_destroy (ids);
+}
+
 static void imp_kill_output (struct bulk_exec *kill,
-                             flux_subprocess_t *p,
+                             int rank,
                              const char *stream,
                              const char *data,
                              int len,
                              void *arg)
 {
-    int rank = flux_subprocess_rank (p);
     flux_log (kill->h, LOG_INFO,
               "rank%d: flux-imp kill: %s: %s",
               rank,
@@ -525,123 +1255,313 @@ static void imp_kill_output (struct bulk_exec *kill,
               data);
 }
 
+/*  Ranks on which flux-imp kill exited with status 0 were signaled */
+static void imp_kill_exit (struct bulk_exec *kill,
+                           void *arg,
+                           const struct idset *ranks)
+{
+    struct imp_kill *ik = arg;
+    json_t *codes;
+    const char *s;
+
+    if (!(codes = bulk_exec_exit_codes (kill))) {
+        flux_log_error (ik->h, "imp kill: bulk_exec_exit_codes");
+        return;
+    }
+    if (json_unpack (codes, "{s:s}", "0", &s) == 0)
+        imp_kill_add_signaled (ik, s);
+    json_decref (codes);
+}
+
 static void imp_kill_complete (struct bulk_exec *kill, void *arg)
 {
-    flux_future_t *f = arg;
-    if (bulk_exec_rc (kill) < 0)
-        flux_future_fulfill_error (f, 0, NULL);
-    else
-        flux_future_fulfill (f, NULL, NULL);
+    struct imp_kill *ik = arg;
+    ik->local_busy = 0;
+    imp_kill_check (ik);
 }
 
 static void imp_kill_error (struct bulk_exec *kill,
-                            flux_subprocess_t *p,
+                            int rank,
+                            int errnum,
                             void *arg)
 {
-    flux_log_error (kill->h,
-                    "imp kill: rank=%d: failed",
-                    flux_subprocess_rank (p));
+    flux_log (kill->h, LOG_ERR,
+              "imp kill: rank=%d: failed: %s",
+              rank,
+              flux_strerror (errnum));
 }
 
 
 struct bulk_exec_ops imp_kill_ops = {
     .on_output = imp_kill_output,
+    .on_exit = imp_kill_exit,
     .on_error = imp_kill_error,
     .on_complete = imp_kill_complete,
 };
 
-static int bulk_exec_push_one (struct bulk_exec *exec,
-                               int rank,
-                               flux_cmd_t *cmd,
-                               int flags)
+static int imp_kill_local (struct imp_kill *ik, uint32_t rank, pid_t pid)
 {
+    flux_cmd_t *cmd;
     int rc = -1;
-    struct idset *ids = idset_create (0, IDSET_FLAG_AUTOGROW);
-    if (!ids || idset_set (ids, rank) < 0)
+
+    if (!ik->local && !(ik->local = bulk_exec_create (&imp_kill_ops, ik)))
         return -1;
-    rc = bulk_exec_push_cmd (exec, ids, cmd, flags);
-    idset_destroy (ids);
+    if (!(cmd = flux_cmd_create (0, NULL, environ))
+        || flux_cmd_setcwd (cmd, "/tmp") < 0
+        || flux_cmd_argv_append (cmd, ik->imp_path) < 0
+        || flux_cmd_argv_append (cmd, "kill") < 0
+        || flux_cmd_argv_appendf (cmd, "%d", ik->signum) < 0
+        || flux_cmd_argv_appendf (cmd, "%ld", (long) pid) < 0) {
+        flux_log_error (ik->h, "bulk_exec_imp_kill: flux_cmd_argv_append");
+        goto out;
+    }
+    if (bulk_exec_push_ranks (ik->local, &rank, 1, cmd, 0) < 0) {
+        flux_log_error (ik->h, "bulk_exec_imp_kill: push_cmd");
+        goto out;
+    }
+    ik->local_busy = 1;
+    rc = 0;
+out:
+    flux_cmd_destroy (cmd);
     return rc;
 }
 
-/*  Kill all currently executing processes in bulk-exec object `exec`
- *   using "flux-imp kill" helper for processes potentially running
- *   under a different userid.
- *
- *  Spawns "flux-imp kill <signal> <pid>" on each rank.
+static int imp_kill_start_local (struct imp_kill *ik)
+{
+    if (ik->local && !ik->local->active
+        && bulk_exec_start (ik->h, ik->local) < 0) {
+        flux_log_error (ik->h, "bulk_exec_start");
+        return -1;
+    }
+    return 0;
+}
+
+/*  job-exec is not loaded on (or could not be reached at) TBON child
+ *   c->child: kill its subtree directly from here instead.
  */
-flux_future_t *bulk_exec_imp_kill (struct bulk_exec *exec,
-                                   const char *imp_path,
-                                   int signum)
+static int imp_kill_child_fallback (struct imp_kill_child *c)
 {
-    struct bulk_exec *killcmd = NULL;
-    flux_subprocess_t *p = NULL;
-    flux_future_t *f = NULL;
-    int count = 0;
+    struct imp_kill *ik = c->ik;
+    unsigned int rank = idset_first (c->ranks);
+    size_t index = 0;
 
-    /* Empty future for return value
-     */
-    if (!(f = flux_future_create (NULL, NULL))) {
-        flux_log_error (exec->h, "bulk_exec_imp_kill: future_create");
-        goto err;
+    while (rank != IDSET_INVALID_ID) {
+        pid_t pid = json_integer_value (json_array_get (c->pids, index++));
+        if (imp_kill_local (ik, rank, pid) < 0)
+            return -1;
+        rank = idset_next (c->ranks, rank);
     }
-    flux_future_set_flux (f, exec->h);
-
-    if (!(killcmd = bulk_exec_create (&imp_kill_ops, f)))
-        return NULL;
+    return imp_kill_start_local (ik);
+}
 
-    /*  Tie bulk exec object destruction to future */
-    flux_future_aux_set (f, NULL, killcmd, (flux_free_f) bulk_exec_destroy);
+static void imp_kill_child_continuation (flux_future_t *f, void *arg)
+{
+    struct imp_kill_child *c = arg;
+    struct imp_kill *ik = c->ik;
+    const char *ranks;
+
+    if (flux_rpc_get_unpack (f, "{s:s}", "ranks", &ranks) == 0)
+        imp_kill_add_signaled (ik, ranks);
+    else if (errno == ENOSYS) {
+        flux_log (ik->h, LOG_DEBUG,
+                  "job-exec not loaded on rank %u, killing directly",
+                  c->child);
+        if (imp_kill_child_fallback (c) < 0)
+            flux_log_error (ik->h, "imp kill: rank %u subtree", c->child);
+    }
+    else
+        flux_log_error (ik->h, "imp kill: relay rank %u", c->child);
+    ik->children_pending--;
+    imp_kill_check (ik);
+}
 
-    p = zlist_first (exec->processes);
-    while (p) {
-        if ((flux_subprocess_state (p) == FLUX_SUBPROCESS_RUNNING
-            || flux_subprocess_state (p) == FLUX_SUBPROCESS_INIT)) {
+static int imp_kill_child_send (struct imp_kill_child *c)
+{
+    struct imp_kill *ik = c->ik;
+    char *ranks;
+    int rc = -1;
 
-            pid_t pid = flux_subprocess_pid (p);
-            int rank = flux_subprocess_rank (p);
-            flux_cmd_t *cmd = flux_cmd_create (0, NULL, environ);
-
-            if (!cmd
-                || flux_cmd_setcwd (cmd, "/tmp") < 0
-                || flux_cmd_argv_append (cmd, imp_path) < 0
-                || flux_cmd_argv_append (cmd, "kill") < 0
-                || flux_cmd_argv_appendf (cmd, "%d", signum) < 0
-                || flux_cmd_argv_appendf (cmd, "%ld", (long) pid)) {
-                flux_log_error (exec->h,
-                                "bulk_exec_imp_kill: flux_cmd_argv_append");
-                goto err;
-            }
+    if (!(ranks = idset_encode (c->ranks, IDSET_FLAG_RANGE)))
+        return -1;
+    if (!(c->f = flux_rpc_pack (ik->h,
+                                "job-exec.imp-kill",
+                                c->child,
+                                0,
+                                "{s:s s:i s:s s:O}",
+                                "imp", ik->imp_path,
+                                "signum", ik->signum,
+                                "ranks", ranks,
+                                "pids", c->pids))
+        || flux_future_then (c->f, -1., imp_kill_child_continuation, c) < 0)
+        goto out;
+    ik->children_pending++;
+    rc = 0;
+out:
+    free (ranks);
+    return rc;
+}
 
-            if (bulk_exec_push_one (killcmd, rank, cmd, 0) < 0) {
-                flux_log_error (exec->h, "bulk_exec_imp_kill: push_cmd");
-                goto err;
-            }
+static struct imp_kill_child *imp_kill_child_get (struct imp_kill *ik,
+                                                  uint32_t child)
+{
+    struct imp_kill_child *c = zlist_first (ik->children);
+    while (c) {
+        if (c->child == child)
+            return c;
+        c = zlist_next (ik->children);
+    }
+    if (!(c = calloc (1, sizeof (*c))))
+        return NULL;
+    c->ik = ik;
+    c->child = child;
+    if (!(c->ranks = idset_create (0, IDSET_FLAG_AUTOGROW))
+        || !(c->pids = json_array ())
+        || zlist_append (ik->children, c) < 0) {
+        imp_kill_child_destroy (c);
+        errno = ENOMEM;
+        return NULL;
+    }
+    zlist_freefn (ik->children, c, imp_kill_child_destroy, true);
+    return c;
+}
 
-            count++;
-            flux_cmd_destroy (cmd);
-        }
-        p = zlist_next (exec->processes);
+static int imp_kill_route (struct imp_kill *ik, uint32_t rank, pid_t pid)
+{
+    struct imp_kill_child *c;
+    json_t *o;
+    uint32_t child = KARY_NONE;
+
+    if (ik->tree_k > 0)
+        child = kary_child_route (ik->tree_k, ik->size, ik->rank, rank);
+    if (rank == ik->rank || child == KARY_NONE)
+        return imp_kill_local (ik, rank, pid);
+    if (!(c = imp_kill_child_get (ik, child))
+        || idset_set (c->ranks, rank) < 0)
+        return -1;
+    if (!(o = json_integer (pid)) || json_array_append_new (c->pids, o) < 0) {
+        json_decref (o);
+        errno = ENOMEM;
+        return -1;
     }
+    return 0;
+}
+
+flux_future_t *bulk_exec_imp_kill_ranks (flux_t *h,
+                                         const char *imp_path,
+                                         int signum,
+                                         const uint32_t *ranks,
+                                         const pid_t *pids,
+                                         int count,
+                                         bool tree)
+{
+    struct imp_kill *ik;
+    struct imp_kill_child *c;
+    flux_future_t *f;
+    int i;
 
+    if (!h || !imp_path || !ranks || !pids || count < 0) {
+        errno = EINVAL;
+        return NULL;
+    }
     if (count == 0) {
         errno = ENOENT;
-        goto err;
+        return NULL;
     }
-
-    bulk_exec_aux_set (killcmd, "future", f, NULL);
-
-    if (bulk_exec_start (exec->h, killcmd) < 0) {
-        flux_log_error (exec->h, "bulk_exec_start");
-        goto err;
+    for (i = 1; i < count; i++) {
+        if (ranks[i] <= ranks[i - 1]) {
+            errno = EINVAL;
+            return NULL;
+        }
     }
-
+    if (!(f = flux_future_create (NULL, NULL)))
+        return NULL;
+    flux_future_set_flux (f, h);
+    if (!(ik = calloc (1, sizeof (*ik))))
+        goto error;
+    if (flux_future_aux_set (f, NULL, ik,
+                             (flux_free_f) imp_kill_destroy) < 0) {
+        imp_kill_destroy (ik);
+        goto error;
+    }
+    ik->h = h;
+    ik->f = f;
+    ik->signum = signum;
+    if (!(ik->imp_path = strdup (imp_path))
+        || !(ik->children = zlist_new ())
+        || !(ik->signaled = idset_create (0, IDSET_FLAG_AUTOGROW)))
+        goto nomem;
+    /*  Without TBON parameters, fall back to killing every rank directly */
+    if (tree && tree_params (h, &ik->tree_k, &ik->rank, &ik->size) < 0)
+        ik->tree_k = 0;
+
+    for (i = 0; i < count; i++) {
+        if (imp_kill_route (ik, ranks[i], pids[i]) < 0)
+            goto error;
+    }
+    c = zlist_first (ik->children);
+    while (c) {
+        if (imp_kill_child_send (c) < 0) {
+            flux_log_error (h, "imp kill: relay rank %u", c->child);
+            if (imp_kill_child_fallback (c) < 0)
+                goto error;
+        }
+        c = zlist_next (ik->children);
+    }
+    if (imp_kill_start_local (ik) < 0)
+        goto error;
     return f;
-err:
+nomem:
+    errno = ENOMEM;
+error:
     flux_future_destroy (f);
     return NULL;
 }
 
+/*  Kill all currently executing processes in bulk-exec object `exec`
+ *   using "flux-imp kill" helper for processes potentially running
+ *   under a different userid.
+ *
+ *  Spawns "flux-imp kill <signal> <pid>" on each rank, through the
+ *   TBON if enabled with bulk_exec_set_tree_kill().
+ */
+flux_future_t *bulk_exec_imp_kill (struct bulk_exec *exec,
+                                   const char *imp_path,
+                                   int signum)
+{
+    flux_future_t *f = NULL;
+    uint32_t *ranks;
+    pid_t *pids;
+    int count = 0;
+    int i;
+
+    ranks = calloc (exec->nranks + 1, sizeof (*ranks));
+    pids = calloc (exec->nranks + 1, sizeof (*pids));
+    if (!ranks || !pids) {
+        flux_log_error (exec->h, "bulk_exec_imp_kill: calloc");
+        goto out;
+    }
+    for (i = 0; i < exec->nranks; i++) {
+        flux_subprocess_t *p = exec->ranks[i].p;
+        if (p && (flux_subprocess_state (p) == FLUX_SUBPROCESS_RUNNING
+            || flux_subprocess_state (p) == FLUX_SUBPROCESS_INIT)) {
+            ranks[count] = exec->ranks[i].rank;
+            pids[count] = flux_subprocess_pid (p);
+            count++;
+        }
+    }
+    f = bulk_exec_imp_kill_ranks (exec->h,
+                                  imp_path,
+                                  signum,
+                                  ranks,
+                                  pids,
+                                  count,
+                                  exec->tree_kill);
+out:
+    free (ranks);
+    free (pids);
+    return f;
+}
+
 int bulk_exec_aux_set (struct bulk_exec *exec, const char *key,
                        void *val, flux_free_f free_fn)
 {
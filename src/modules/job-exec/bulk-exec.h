@@ -13,7 +13,10 @@
 #ifndef HAVE_JOB_EXEC_BULK_EXEC_H
 #define HAVE_JOB_EXEC_BULK_EXEC_H 1
 
+#include <stdbool.h>
+#include <sys/types.h>
 #include <flux/core.h>
+#include <jansson.h>
 
 struct bulk_exec;
 
@@ -23,14 +26,16 @@ typedef void (*exec_exit_f) (struct bulk_exec *, void *arg,
                              const struct idset *ranks);
 
 typedef void (*exec_io_f)   (struct bulk_exec *,
-                             flux_subprocess_t *,
+                             int rank,
                              const char *stream,
 			     const char *data,
 			     int data_len,
                              void *arg);
 
+/*  'rank' is -1 for internal errors not associated with a rank */
 typedef void (*exec_error_f) (struct bulk_exec *,
-                              flux_subprocess_t *,
+                              int rank,
+                              int errnum,
                               void *arg);
 
 struct bulk_exec_ops {
@@ -55,6 +60,22 @@ int bulk_exec_aux_set (struct bulk_exec *exec,
  */
 int bulk_exec_set_max_per_loop (struct bulk_exec *exec, int max);
 
+/*  Launch commands pushed after this call along the TBON: ranks in the
+ *   subtree of each TBON child are relayed through the job-exec module
+ *   on that child (falling back to direct launch if it is not loaded),
+ *   so this rank handles one request per child instead of one per rank.
+ *   'id' identifies the relayed commands on remote ranks.
+ *   bulk_exec_write() and bulk_exec_close() do not reach relayed ranks.
+ */
+int bulk_exec_set_tree (struct bulk_exec *exec,
+                        flux_t *h,
+                        flux_jobid_t id);
+
+/*  Route bulk_exec_imp_kill() along the TBON even if commands are
+ *   launched directly.  Implied by bulk_exec_set_tree().
+ */
+void bulk_exec_set_tree_kill (struct bulk_exec *exec, bool enable);
+
 void bulk_exec_destroy (struct bulk_exec *exec);
 
 int bulk_exec_push_cmd (struct bulk_exec *exec,
@@ -62,6 +83,16 @@ int bulk_exec_push_cmd (struct bulk_exec *exec,
                        flux_cmd_t *cmd,
                        int flags);
 
+/*  As bulk_exec_push_cmd(), but 'ranks' is an array of 'count' ranks
+ *   in strictly ascending order, e.g. from resource_set_rank_array().
+ *   A rank may be pushed only once per bulk_exec object.
+ */
+int bulk_exec_push_ranks (struct bulk_exec *exec,
+                          const uint32_t *ranks,
+                          int count,
+                          flux_cmd_t *cmd,
+                          int flags);
+
 int bulk_exec_start (flux_t *h, struct bulk_exec *exec);
 
 flux_future_t * bulk_exec_kill (struct bulk_exec *exec, int signal);
@@ -70,11 +101,32 @@ flux_future_t *bulk_exec_imp_kill (struct bulk_exec *exec,
                                    const char *imp_path,
                                    int signal);
 
+/*  Run "imp_path kill signal pids[i]" on ranks[i], for 'count' ranks in
+ *   strictly ascending order.  If 'tree' is true, ranks in the subtree
+ *   of each TBON child are forwarded to job-exec on that child, falling
+ *   back to a direct kill if it is not loaded.  The future is fulfilled
+ *   with a (const struct idset *) of ranks where the kill succeeded.
+ */
+flux_future_t *bulk_exec_imp_kill_ranks (flux_t *h,
+                                         const char *imp_path,
+                                         int signal,
+                                         const uint32_t *ranks,
+                                         const pid_t *pids,
+                                         int count,
+                                         bool tree);
+
 int bulk_exec_cancel (struct bulk_exec *exec);
 
 /* Returns max wait status returned from all exited processes */
 int bulk_exec_rc (struct bulk_exec *exec);
 
+/* From the on_exit callback, return the current batch of exits as a
+ *  JSON object mapping each wait status (as a string) to an idset string
+ *  of the ranks that exited with it.  Ranks cancelled before they were
+ *  launched are not included.  Caller must json_decref() the result.
+ */
+json_t *bulk_exec_exit_codes (struct bulk_exec *exec);
+
 /* Returns current number of processes starting/running */
 int bulk_exec_current (struct bulk_exec *exec);
 
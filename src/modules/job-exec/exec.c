@@ -14,6 +14,14 @@
  *
  * Launch configured job shell, one per rank.
  *
+ * Unless disabled with tree-launch=0, job shells are launched along
+ * the TBON: rank 0 sends one request per TBON child, and job-exec on
+ * that child launches shells in its subtree and reports back exit
+ * status and output for the whole subtree.  Multiuser jobs are always
+ * launched directly, since the IMP input is written after all shells
+ * have started, but signals are still delivered to them along the TBON
+ * with "flux-imp kill" relayed through job-exec on each TBON child.
+ *
  * TEST CONFIGURATION
  *
  * Test and other configuration may be presented in the jobspec
@@ -40,6 +48,7 @@ extern char **environ;
 static const char *default_cwd = "/tmp";
 static const char *default_job_shell = NULL;
 static const char *flux_imp_path = NULL;
+static int tree_launch = 1;
 
 /* Configuration for "bulk" execution implementation. Used only for testing
  *  for now.
@@ -137,7 +146,7 @@ static void complete_cb (struct bulk_exec *exec, void *arg)
                             bulk_exec_rc (exec));
 }
 
-static void output_cb (struct bulk_exec *exec, flux_subprocess_t *p,
+static void output_cb (struct bulk_exec *exec, int rank,
                        const char *stream,
                        const char *data,
                        int data_len,
@@ -146,17 +155,19 @@ static void output_cb (struct bulk_exec *exec, flux_subprocess_t *p,
     struct jobinfo *job = arg;
     flux_log (job->h, LOG_INFO, "%ju: %d: %s: %s",
                       (uintmax_t) job->id,
-                      flux_subprocess_rank (p),
+                      rank,
                       stream, data);
 }
 
-static void error_cb (struct bulk_exec *exec, flux_subprocess_t *p, void *arg)
+static void error_cb (struct bulk_exec *exec, int rank, int errnum, void *arg)
 {
     struct jobinfo *job = arg;
-    const char *arg0 = flux_cmd_arg (flux_subprocess_get_cmd (p), 0);
-    jobinfo_fatal_error (job, flux_subprocess_fail_errno (p),
-                              "cmd=%s: rank=%d failed",
-                              arg0, flux_subprocess_rank (p));
+    const char *arg0 = job->multiuser ? flux_imp_path : job_shell_path (job);
+    if (rank < 0)
+        jobinfo_fatal_error (job, errnum, "cmd=%s: launch failed", arg0);
+    else
+        jobinfo_fatal_error (job, errnum, "cmd=%s: rank=%d failed",
+                             arg0, rank);
 }
 
 static struct bulk_exec_ops exec_ops = {
@@ -172,7 +183,8 @@ static int exec_init (struct jobinfo *job)
     flux_cmd_t *cmd = NULL;
     struct exec_conf *conf = NULL;
     struct bulk_exec *exec = NULL;
-    const struct idset *ranks = NULL;
+    const uint32_t *ranks = NULL;
+    int nranks;
 
     if (job->multiuser && !flux_imp_path) {
         flux_log (job->h,
@@ -181,14 +193,20 @@ static int exec_init (struct jobinfo *job)
         goto err;
     }
 
-    if (!(ranks = resource_set_ranks (job->R))) {
-        flux_log_error (job->h, "exec_init: resource_set_ranks");
+    if (!(ranks = resource_set_rank_array (job->R, &nranks))) {
+        flux_log_error (job->h, "exec_init: resource_set_rank_array");
         goto err;
     }
     if (!(exec = bulk_exec_create (&exec_ops, job))) {
         flux_log_error (job->h, "exec_init: bulk_exec_create");
         goto err;
     }
+    if (tree_launch && !job->multiuser
+        && bulk_exec_set_tree (exec, job->h, job->id) < 0) {
+        flux_log_error (job->h, "exec_init: bulk_exec_set_tree");
+        goto err;
+    }
+    bulk_exec_set_tree_kill (exec, tree_launch);
     if (!(conf = exec_conf_create (job->jobspec))) {
         flux_log_error (job->h, "exec_init: exec_conf_create");
         goto err;
@@ -223,8 +241,8 @@ static int exec_init (struct jobinfo *job)
         flux_log_error (job->h, "exec_init: flux_cmd_setcwd");
         goto err;
     }
-    if (bulk_exec_push_cmd (exec, ranks, cmd, 0) < 0) {
-        flux_log_error (job->h, "exec_init: bulk_exec_push_cmd");
+    if (bulk_exec_push_ranks (exec, ranks, nranks, cmd, 0) < 0) {
+        flux_log_error (job->h, "exec_init: bulk_exec_push_ranks");
         goto err;
     }
     flux_cmd_destroy (cmd);
@@ -281,7 +299,17 @@ static int exec_start (struct jobinfo *job)
 static void exec_kill_cb (flux_future_t *f, void *arg)
 {
     struct jobinfo *job = arg;
-    if (flux_future_get (f, NULL) < 0 && errno != ENOENT)
+    const struct idset *ranks;
+
+    if (job->multiuser && flux_future_get (f, (const void **) &ranks) == 0) {
+        char *s = idset_encode (ranks, IDSET_FLAG_RANGE);
+        flux_log (job->h, LOG_DEBUG,
+                  "exec_kill: %ju: signaled ranks %s",
+                  (uintmax_t) job->id,
+                  s ? s : "(unknown)");
+        free (s);
+    }
+    else if (flux_future_get (f, NULL) < 0 && errno != ENOENT)
         flux_log_error (job->h, "%ju: exec_kill", (uintmax_t) job->id);
     jobinfo_decref (job);
     flux_future_destroy (f);
@@ -373,12 +401,26 @@ static int exec_config (flux_t *h, int argc, char **argv)
         return -1;
     }
 
+    /*  Check configuration for exec.tree-launch */
+    if (flux_conf_unpack (flux_get_conf (h),
+                          &err,
+                          "{s?:{s?b}}",
+                          "exec",
+                            "tree-launch", &tree_launch) < 0) {
+        flux_log (h, LOG_ERR,
+                  "error reading config value exec.tree-launch: %s",
+                  err.errbuf);
+        return -1;
+    }
+
     /* Finally, override values on cmdline */
     for (int i = 0; i < argc; i++) {
         if (strncmp (argv[i], "job-shell=", 10) == 0)
             default_job_shell = argv[i]+10;
         else if (strncmp (argv[i], "imp=", 4) == 0)
             flux_imp_path = argv[i]+4;
+        else if (strncmp (argv[i], "tree-launch=", 12) == 0)
+            tree_launch = strcmp (argv[i]+12, "0") != 0;
     }
     flux_log (h, LOG_DEBUG, "using default shell path %s", default_job_shell);
     if (flux_imp_path)
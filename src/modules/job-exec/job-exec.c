@@ -24,6 +24,12 @@
  *
  * For details of startup protocol, see job-manager/start.c.
  *
+ * The exec service offers a batch size of 'batch-size' jobs in its hello
+ * request (option batch-size=N or [exec] batch-size, default 128, 0 to
+ * disable).  If accepted, jobs arrive in start-batch requests, and their
+ * responses are queued and sent as one start-batch response just before
+ * the reactor blocks, or when 'batch-size' responses are queued.
+ *
  * JOB INIT:
  *
  * On reciept of a start request, the exec service enters initialization
@@ -53,6 +59,11 @@
  * the exec implementation's "cleanup" method on the completed ranks.
  * (NB: currently a subset of ranks is not supported)
  *
+ * JOB SHELL LAUNCH:
+ *
+ * The module is loaded on all ranks.  On ranks other than 0 it only
+ * relays job shell launch requests for its TBON subtree (see relay.c).
+ *
  * JOB FINALIZATION:
  *
  * Once cleanup tasks have completed, the exec implementation should call
@@ -66,6 +77,18 @@
  *  - the final "release final=true" response is sent to the job manager
  *  - the local job object is destroyed
  *
+ * STATS
+ *
+ * job-exec.stats.get responds with
+ * {"jobs":i, "batch":i, "latency":{stage:stats}}, where "batch" is the
+ * negotiated batch size, and stats is a histogram described in loghist.h,
+ * for these stages:
+ *
+ *   init    start request -> execution (jobspec, R, guest namespace)
+ *   launch  execution -> all job shells running, and "start" response
+ *
+ * job-exec.stats.clear clears the histograms.
+ *
  * TEST CONFIGURATION
  *
  * The job-exec module supports an object in the jobspec under
@@ -100,9 +123,13 @@
 #include "src/common/libeventlog/eventlog.h"
 #include "src/common/libutil/fsd.h"
 #include "src/common/libutil/errno_safe.h"
+#include "src/common/libutil/monotime.h"
+#include "src/common/libutil/loghist.h"
 #include "job-exec.h"
+#include "relay.h"
 
 static double kill_timeout=5.0;
+static int batch_size=128;
 
 extern struct exec_implementation testexec;
 extern struct exec_implementation bulkexec;
@@ -117,6 +144,15 @@ struct job_exec_ctx {
     flux_t *              h;
     flux_msg_handler_t ** handlers;
     zhashx_t *            jobs;
+    struct relay_ctx *    relay;
+
+    int                   batch;     /* negotiated batch size, 0=none */
+    json_t *              responses; /* queued start-batch responses */
+    const flux_msg_t *    batch_req; /* request to send them on */
+    flux_watcher_t *      prep;
+
+    struct loghist        init_latency;
+    struct loghist        launch_latency;
 };
 
 void jobinfo_incref (struct jobinfo *job)
@@ -253,12 +289,83 @@ int jobinfo_emit_event_pack_nowait (struct jobinfo *job,
     return rc;
 }
 
-static int jobid_exception (flux_t *h, flux_jobid_t id,
-                            const flux_msg_t *msg,
-                            const char *type,
-                            int severity,
-                            int errnum,
-                            const char *text)
+/*  Send queued start-batch responses, if any.
+ */
+static int responses_flush (struct job_exec_ctx *ctx)
+{
+    int rc = 0;
+
+    if (json_array_size (ctx->responses) == 0)
+        return 0;
+    if (flux_respond_pack (ctx->h, ctx->batch_req, "{s:O}",
+                                                   "responses",
+                                                   ctx->responses) < 0) {
+        flux_log_error (ctx->h, "start-batch: flux_respond_pack");
+        rc = -1;
+    }
+    json_array_clear (ctx->responses);
+    flux_msg_decref (ctx->batch_req);
+    ctx->batch_req = NULL;
+    return rc;
+}
+
+static void prep_cb (flux_reactor_t *r, flux_watcher_t *w,
+                     int revents, void *arg)
+{
+    (void)responses_flush (arg);
+}
+
+/*  Respond to the job-manager for 'job' with a response of 'type'
+ *   carrying 'data', built from 'fmt' and args.  If the job arrived in
+ *   a start-batch request, queue the response for the next start-batch
+ *   response instead.
+ */
+static int jobinfo_respond_pack (struct jobinfo *job,
+                                 const char *type,
+                                 const char *fmt, ...)
+{
+    struct job_exec_ctx *ctx = job->ctx;
+    json_t *data;
+    json_t *entry;
+    va_list ap;
+    int rc;
+
+    va_start (ap, fmt);
+    data = json_vpack_ex (NULL, 0, fmt, ap);
+    va_end (ap);
+    if (!data) {
+        errno = ENOMEM;
+        return -1;
+    }
+    if (!job->batched) {
+        rc = flux_respond_pack (ctx->h, job->req, "{s:I s:s s:o}",
+                                                  "id", job->id,
+                                                  "type", type,
+                                                  "data", data);
+        return rc;
+    }
+    if (!(entry = json_pack ("{s:I s:s s:o}",
+                             "id", job->id,
+                             "type", type,
+                             "data", data))
+        || json_array_append_new (ctx->responses, entry) < 0) {
+        errno = ENOMEM;
+        return -1;
+    }
+    if (ctx->batch_req != job->req) {
+        flux_msg_decref (ctx->batch_req);
+        ctx->batch_req = flux_msg_incref (job->req);
+    }
+    if (json_array_size (ctx->responses) >= ctx->batch)
+        return responses_flush (ctx);
+    return 0;
+}
+
+static int jobinfo_exception (struct jobinfo *job,
+                              const char *type,
+                              int severity,
+                              int errnum,
+                              const char *text)
 {
     char note [256];
     if (errnum)
@@ -268,48 +375,31 @@ static int jobid_exception (flux_t *h, flux_jobid_t id,
                                         strerror (errnum));
     else
         snprintf (note, sizeof (note), "%s", text ? text : "");
-    return flux_respond_pack (h, msg, "{s:I s:s s:{s:i s:s s:s}}",
-                                      "id", id,
-                                      "type", "exception",
-                                      "data",
-                                      "severity", severity,
-                                      "type", type,
-                                      "note", note);
+    return jobinfo_respond_pack (job, "exception", "{s:i s:s s:s}",
+                                                   "severity", severity,
+                                                   "type", type,
+                                                   "note", note);
 }
 
 static int jobinfo_respond_error (struct jobinfo *job, int errnum,
                                   const char *msg)
 {
-    return jobid_exception (job->ctx->h,
-                            job->id,
-                            job->req,
-                            "exec",
-                            0,
-                            errnum,
-                            msg);
+    return jobinfo_exception (job, "exec", 0, errnum, msg);
 }
 
 static int jobinfo_send_release (struct jobinfo *job,
                                  const struct idset *idset)
 {
-    int rc;
-    flux_t *h = job->ctx->h;
     // XXX: idset ignored for now. Always release all resources
-    rc = flux_respond_pack (h, job->req, "{s:I s:s s{s:s s:b}}",
-                                         "id", job->id,
-                                         "type", "release",
-                                         "data", "ranks", "all",
+    return jobinfo_respond_pack (job, "release", "{s:s s:b}",
+                                                 "ranks", "all",
                                                  "final", true);
-    return rc;
 }
 
 static int jobinfo_respond (flux_t *h, struct jobinfo *job,
                             const char *event, int status)
 {
-    return flux_respond_pack (h, job->req, "{s:I s:s s:{}}",
-                                           "id", job->id,
-                                           "type", event,
-                                           "data");
+    return jobinfo_respond_pack (job, event, "{}");
 }
 
 static void jobinfo_complete (struct jobinfo *job, const struct idset *ranks)
@@ -320,11 +410,9 @@ static void jobinfo_complete (struct jobinfo *job, const struct idset *ranks)
         jobinfo_emit_event_pack_nowait (job, "complete",
                                         "{ s:i }",
                                         "status", job->wait_status);
-        if (flux_respond_pack (h, job->req, "{s:I s:s s:{s:i}}",
-                                            "id", job->id,
-                                            "type", "finish",
-                                            "data",
-                                            "status", job->wait_status) < 0)
+        if (jobinfo_respond_pack (job, "finish", "{s:i}",
+                                                "status",
+                                                job->wait_status) < 0)
             flux_log_error (h, "jobinfo_complete: flux_respond");
     }
 }
@@ -335,6 +423,9 @@ void jobinfo_started (struct jobinfo *job, const char *fmt, ...)
     if (h && job->req) {
         va_list ap;
         va_start (ap, fmt);
+        if (!job->running)
+            loghist_add (&job->ctx->launch_latency,
+                         monotime_since (job->t_execute) / 1000.);
         job->running = 1;
         va_end (ap);
         if (jobinfo_respond (h, job, "start", 0) < 0)
@@ -657,6 +748,9 @@ error_release:
 
 static int jobinfo_start_execution (struct jobinfo *job)
 {
+    monotime (&job->t_execute);
+    loghist_add (&job->ctx->init_latency,
+                 monotime_since (job->t_request) / 1000.);
     jobinfo_emit_event_pack_nowait (job, "starting", NULL);
     /* Set started flag before calling 'start' method because we want to
      *  be sure to clean up properly if an exception occurs
@@ -727,8 +821,8 @@ static void timelimit_cb (flux_reactor_t *r,
     /*  Timelimit reached. Generate "timeout" exception and send SIGALRM.
      *  Wait for a gracetime then forcibly terminate job.
      */
-    if (jobid_exception (job->h, job->id, job->req, "timeout", 0, 0,
-                         "resource allocation expired") < 0)
+    if (jobinfo_exception (job, "timeout", 0, 0,
+                           "resource allocation expired") < 0)
         flux_log_error (job->h,
                         "failed to generate timeout exception for %ju",
                         job->id);
@@ -785,12 +879,19 @@ static int jobinfo_set_expiration (struct jobinfo *job)
 static void jobinfo_start_continue (flux_future_t *f, void *arg)
 {
     json_error_t error;
-    const char *R = NULL;
     const char *jobspec = NULL;
     struct jobinfo *job = arg;
+    flux_future_t *f_ns = flux_future_get_child (f, "ns");
 
-    if (flux_future_get (flux_future_get_child (f, "ns"), NULL) < 0) {
-        jobinfo_fatal_error (job, errno, "failed to create guest ns");
+    if (flux_future_get (f_ns, NULL) < 0) {
+        /* R is parsed before the namespace is created, so a missing
+         * or invalid R is also reported here.
+         */
+        if (!job->R)
+            jobinfo_fatal_error (job, errno, "unable to read R: %s",
+                                 future_strerror (f_ns, errno));
+        else
+            jobinfo_fatal_error (job, errno, "failed to create guest ns");
         goto done;
     }
     job->has_namespace = 1;
@@ -805,14 +906,6 @@ static void jobinfo_start_continue (flux_future_t *f, void *arg)
         jobinfo_fatal_error (job, errno, "unable to fetch jobspec");
         goto done;
     }
-    if (!(R = jobinfo_kvs_lookup_get (f, "R"))) {
-        jobinfo_fatal_error (job, errno, "job does not have allocation");
-        goto done;
-    }
-    if (!(job->R = resource_set_create (R, &error))) {
-        jobinfo_fatal_error (job, errno, "reading R: %s", error.text);
-        goto done;
-    }
     if (jobinfo_set_expiration (job) < 0)
         goto done;
     if (job->multiuser) {
@@ -898,20 +991,50 @@ error:
     flux_future_destroy (fprev);
 }
 
-static flux_future_t *ns_create_and_link (flux_t *h,
-                                          struct jobinfo *job,
-                                          int flags)
+/*  Parse R from the lookup in 'fprev', then create the guest namespace
+ *   owned by the first rank of the job.  The job shell leader runs there,
+ *   so its output and PMI commits no longer all go through rank 0.
+ */
+static void ns_create_and_link (flux_future_t *fprev, void *arg)
 {
+    flux_t *h = flux_future_get_flux (fprev);
+    struct jobinfo *job = arg;
     flux_future_t *f = NULL;
     flux_future_t *f2 = NULL;
-
-    if (!(f = flux_kvs_namespace_create (h, job->ns, job->userid, flags))
+    json_error_t error;
+    const char *R;
+    uint32_t size;
+    unsigned int rank;
+
+    if (flux_kvs_lookup_get (fprev, &R) < 0) {
+        flux_future_continue_error (fprev,
+                                    errno,
+                                    "job does not have allocation");
+        goto done;
+    }
+    if (!(job->R = resource_set_create (R, &error))) {
+        flux_future_continue_error (fprev, errno, error.text);
+        goto done;
+    }
+    rank = idset_first (resource_set_ranks (job->R));
+    if (rank == IDSET_INVALID_ID
+        || flux_get_size (h, &size) < 0
+        || rank >= size)
+        rank = 0;
+    if (!(f = flux_kvs_namespace_create_rank (h,
+                                              job->ns,
+                                              job->userid,
+                                              rank,
+                                              0))
         || !(f2 = flux_future_and_then (f, namespace_link, job))) {
-        flux_log_error (h, "namespace_move: flux_future_and_then");
+        flux_log_error (h, "ns_create_and_link: flux_future_and_then");
+        flux_future_continue_error (fprev, errno, NULL);
         flux_future_destroy (f);
-        return NULL;
+        goto done;
     }
-    return f2;
+    flux_future_continue (fprev, f2);
+done:
+    flux_future_destroy (fprev);
 }
 
 /*  Asynchronously fetch job data from KVS and create namespace.
@@ -919,13 +1042,11 @@ static flux_future_t *ns_create_and_link (flux_t *h,
 static flux_future_t *jobinfo_start_init (struct jobinfo *job)
 {
     flux_t *h = job->ctx->h;
+    flux_future_t *f_R = NULL;
     flux_future_t *f_kvs = NULL;
     flux_future_t *f = flux_future_wait_all_create ();
     flux_future_set_flux (f, job->ctx->h);
 
-    if (!(f_kvs = flux_jobid_kvs_lookup (h, job->id, 0, "R"))
-        || flux_future_push (f, "R", f_kvs) < 0)
-        goto err;
     if (!(f_kvs = flux_jobid_kvs_lookup (h, job->id, 0, "jobspec"))
         || flux_future_push (f, "jobspec", f_kvs) < 0)
         goto err;
@@ -934,25 +1055,35 @@ static flux_future_t *jobinfo_start_init (struct jobinfo *job)
         || flux_future_push (f, "J", f_kvs) < 0)) {
         goto err;
     }
-    if (!(f_kvs = ns_create_and_link (h, job, 0))
+    /* R is needed to place the guest namespace, see ns_create_and_link()
+     */
+    if (!(f_R = flux_jobid_kvs_lookup (h, job->id, 0, "R"))
+        || !(f_kvs = flux_future_and_then (f_R, ns_create_and_link, job))
         || flux_future_push (f, "ns", f_kvs))
         goto err;
 
     return f;
 err:
     flux_log_error (job->ctx->h, "jobinfo_kvs_lookup/namespace_create");
+    if (!f_kvs)
+        flux_future_destroy (f_R);
     flux_future_destroy (f_kvs);
     flux_future_destroy (f);
     return NULL;
 }
 
-static int job_start (struct job_exec_ctx *ctx, const flux_msg_t *msg)
+static int job_start (struct job_exec_ctx *ctx,
+                      const flux_msg_t *msg,
+                      flux_jobid_t id,
+                      uint32_t userid,
+                      bool batched)
 {
     flux_future_t *f = NULL;
     struct jobinfo *job;
 
     if (!(job = jobinfo_new ()))
         return -1;
+    monotime (&job->t_request);
 
     /* Copy flux handle for each job to allow implementation access.
      * (This could also be done with an accessor, but choose the simpler
@@ -964,14 +1095,9 @@ static int job_start (struct job_exec_ctx *ctx, const flux_msg_t *msg)
     job->req = flux_msg_incref (msg);
 
     job->ctx = ctx;
-
-    if (flux_request_unpack (job->req, NULL, "{s:I, s:i}",
-                                             "id", &job->id,
-                                             "userid", &job->userid) < 0) {
-        flux_log_error (ctx->h, "start: flux_request_unpack");
-        jobinfo_decref (job);
-        return -1;
-    }
+    job->id = id;
+    job->userid = userid;
+    job->batched = batched;
 
     if (job->userid != getuid ())
         job->multiuser = 1;
@@ -1009,8 +1135,16 @@ static void start_cb (flux_t *h, flux_msg_handler_t *mh,
                       const flux_msg_t *msg, void *arg)
 {
     struct job_exec_ctx *ctx = arg;
+    flux_jobid_t id;
+    uint32_t userid;
 
-    if (job_start (ctx, msg) < 0) {
+    if (flux_request_unpack (msg, NULL, "{s:I, s:i}",
+                                        "id", &id,
+                                        "userid", &userid) < 0) {
+        flux_log_error (h, "start: flux_request_unpack");
+        return;
+    }
+    if (job_start (ctx, msg, id, userid, false) < 0) {
         flux_log_error (h, "job_start");
         /* The following "normal" RPC response will trigger the job-manager's
          * teardown of the exec system interface.
@@ -1020,6 +1154,40 @@ static void start_cb (flux_t *h, flux_msg_handler_t *mh,
     }
 }
 
+static void start_batch_cb (flux_t *h, flux_msg_handler_t *mh,
+                            const flux_msg_t *msg, void *arg)
+{
+    struct job_exec_ctx *ctx = arg;
+    json_t *jobs;
+    json_t *entry;
+    size_t index;
+
+    if (flux_request_unpack (msg, NULL, "{s:o}", "jobs", &jobs) < 0
+        || !json_is_array (jobs)) {
+        flux_log_error (h, "start-batch: flux_request_unpack");
+        return;
+    }
+    json_array_foreach (jobs, index, entry) {
+        flux_jobid_t id;
+        uint32_t userid;
+
+        if (json_unpack (entry, "{s:I s:i}", "id", &id,
+                                             "userid", &userid) < 0) {
+            flux_log (h, LOG_ERR, "start-batch: malformed job entry");
+            continue;
+        }
+        if (job_start (ctx, msg, id, userid, true) < 0) {
+            flux_log_error (h, "job_start");
+            /* As with job-exec.start, this tears down the interface.
+             */
+            (void)responses_flush (ctx);
+            if (flux_respond_error (h, msg, errno, NULL) < 0)
+                flux_log_error (h, "job-exec.start-batch respond_error");
+            return;
+        }
+    }
+}
+
 static void exception_cb (flux_t *h, flux_msg_handler_t *mh,
                           const flux_msg_t *msg, void *arg)
 {
@@ -1055,11 +1223,61 @@ static void exception_cb (flux_t *h, flux_msg_handler_t *mh,
     }
 }
 
+static void stats_get_cb (flux_t *h, flux_msg_handler_t *mh,
+                          const flux_msg_t *msg, void *arg)
+{
+    struct job_exec_ctx *ctx = arg;
+    json_t *init = NULL;
+    json_t *launch = NULL;
+
+    if (flux_request_decode (msg, NULL, NULL) < 0)
+        goto error;
+    if (!(init = loghist_encode (&ctx->init_latency))
+        || !(launch = loghist_encode (&ctx->launch_latency)))
+        goto error;
+    if (flux_respond_pack (h, msg, "{s:i s:i s:{s:O s:O}}",
+                           "jobs", (int)zhashx_size (ctx->jobs),
+                           "batch", ctx->batch,
+                           "latency",
+                             "init", init,
+                             "launch", launch) < 0)
+        flux_log_error (h, "stats_get: flux_respond_pack");
+    json_decref (init);
+    json_decref (launch);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "stats_get: flux_respond_error");
+    ERRNO_SAFE_WRAP (json_decref, init);
+    ERRNO_SAFE_WRAP (json_decref, launch);
+}
+
+static void stats_clear_cb (flux_t *h, flux_msg_handler_t *mh,
+                            const flux_msg_t *msg, void *arg)
+{
+    struct job_exec_ctx *ctx = arg;
+
+    if (flux_request_decode (msg, NULL, NULL) < 0)
+        goto error;
+    loghist_clear (&ctx->init_latency);
+    loghist_clear (&ctx->launch_latency);
+    if (flux_respond (h, msg, NULL) < 0)
+        flux_log_error (h, "stats_clear: flux_respond");
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "stats_clear: flux_respond_error");
+}
+
 static void job_exec_ctx_destroy (struct job_exec_ctx *ctx)
 {
     if (ctx == NULL)
         return;
+    (void)responses_flush (ctx);
+    flux_watcher_destroy (ctx->prep);
+    json_decref (ctx->responses);
     zhashx_destroy (&ctx->jobs);
+    relay_ctx_destroy (ctx->relay);
     flux_msg_handler_delvec (ctx->handlers);
     free (ctx);
 }
@@ -1074,29 +1292,50 @@ static struct job_exec_ctx * job_exec_ctx_create (flux_t *h)
         ERRNO_SAFE_WRAP (free, ctx);
         return NULL;
     }
+    if (!(ctx->responses = json_array ())
+        || !(ctx->prep = flux_prepare_watcher_create (flux_get_reactor (h),
+                                                      prep_cb,
+                                                      ctx))) {
+        job_exec_ctx_destroy (ctx);
+        errno = ENOMEM;
+        return NULL;
+    }
+    flux_watcher_start (ctx->prep);
     return (ctx);
 }
 
-static int exec_hello (flux_t *h, const char *service)
+/*  Offer 'batch_size' in hello.  A job-manager that does not batch
+ *   responds without payload.
+ */
+static int exec_hello (struct job_exec_ctx *ctx, const char *service)
 {
+    flux_t *h = ctx->h;
     int rc = -1;
     flux_future_t *f;
+    const char *s;
     if (!(f = flux_rpc_pack (h, "job-manager.exec-hello",
                              FLUX_NODEID_ANY, 0,
-                             "{s:s}",
-                             "service", service))) {
+                             "{s:s s:i}",
+                             "service", service,
+                             "batch", batch_size))) {
         flux_log_error (h, "flux_rpc (job-manager.exec-hello)");
         return -1;
     }
-    if ((rc = flux_future_get (f, NULL)) < 0)
+    if (flux_rpc_get (f, &s) < 0
+        || (s && flux_rpc_get_unpack (f, "{s?:i}",
+                                         "batch", &ctx->batch) < 0)) {
         flux_log_error (h, "job-manager.exec-hello");
+        goto out;
+    }
+    rc = 0;
+out:
     flux_future_destroy (f);
     return rc;
 }
 
 /*  Initialize job-exec module from defaults, config, cmdline,
- *   in that order. Currently only the kill-timeout is
- *   set here.
+ *   in that order. Currently only the kill-timeout and batch-size
+ *   are set here.
  */
 static int job_exec_initialize (flux_t *h, int argc, char **argv)
 {
@@ -1105,9 +1344,10 @@ static int job_exec_initialize (flux_t *h, int argc, char **argv)
 
     if (flux_conf_unpack (flux_get_conf (h),
                           &err,
-                          "{s?{s?s}}",
+                          "{s?{s?s s?i}}",
                           "exec",
-                            "kill-timeout", &kto) < 0) {
+                            "kill-timeout", &kto,
+                            "batch-size", &batch_size) < 0) {
         flux_log (h, LOG_ERR,
                   "error reading config value exec.kill-timeout: %s",
                   err.errbuf);
@@ -1117,6 +1357,21 @@ static int job_exec_initialize (flux_t *h, int argc, char **argv)
     for (int i = 0; i < argc; i++) {
         if (strncmp (argv[i], "kill-timeout=", 13) == 0)
             kto = argv[i] + 13;
+        else if (strncmp (argv[i], "batch-size=", 11) == 0) {
+            char *endptr;
+            errno = 0;
+            batch_size = strtol (argv[i] + 11, &endptr, 10);
+            if (errno != 0 || *endptr != '\0') {
+                flux_log (h, LOG_ERR, "invalid batch-size: %s", argv[i] + 11);
+                errno = EINVAL;
+                return -1;
+            }
+        }
+    }
+    if (batch_size < 0) {
+        flux_log (h, LOG_ERR, "invalid batch-size: %d", batch_size);
+        errno = EINVAL;
+        return -1;
     }
 
     if (kto) {
@@ -1144,7 +1399,10 @@ static int configure_implementations (flux_t *h, int argc, char **argv)
 
 static const struct flux_msg_handler_spec htab[]  = {
     { FLUX_MSGTYPE_REQUEST, "job-exec.start", start_cb,     0 },
+    { FLUX_MSGTYPE_REQUEST, "job-exec.start-batch", start_batch_cb, 0 },
     { FLUX_MSGTYPE_EVENT,   "job-exception",  exception_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST, "job-exec.stats.get", stats_get_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST, "job-exec.stats.clear", stats_clear_cb, 0 },
     FLUX_MSGHANDLER_TABLE_END
 };
 
@@ -1152,8 +1410,21 @@ int mod_main (flux_t *h, int argc, char **argv)
 {
     int saved_errno = 0;
     int rc = -1;
+    uint32_t rank;
     struct job_exec_ctx *ctx = job_exec_ctx_create (h);
 
+    if (flux_get_rank (h, &rank) < 0) {
+        flux_log_error (h, "flux_get_rank");
+        goto out;
+    }
+    if (!(ctx->relay = relay_ctx_create (h))) {
+        flux_log_error (h, "relay_ctx_create");
+        goto out;
+    }
+    if (rank > 0) {
+        rc = flux_reactor_run (flux_get_reactor (h), 0);
+        goto out;
+    }
     if (job_exec_initialize (h, argc, argv) < 0
         || configure_implementations (h, argc, argv) < 0) {
         flux_log_error (h, "job-exec: module initialization failed");
@@ -1168,13 +1439,13 @@ int mod_main (flux_t *h, int argc, char **argv)
         flux_log_error (h, "flux_event_subscribe");
         goto out;
     }
-    if (exec_hello (h, "job-exec") < 0)
+    if (exec_hello (ctx, "job-exec") < 0)
         goto out;
 
     rc = flux_reactor_run (flux_get_reactor (h), 0);
 out:
     saved_errno = errno;
-    if (flux_event_unsubscribe (h, "job-exception") < 0)
+    if (rank == 0 && flux_event_unsubscribe (h, "job-exception") < 0)
         flux_log_error (h, "flux_event_unsubscribe ('job-exception')");
     job_exec_ctx_destroy (ctx);
     errno = saved_errno;
@@ -11,6 +11,7 @@
 #ifndef HAVE_JOB_EXEC_H
 #define HAVE_JOB_EXEC_H 1
 
+#include <time.h>
 #include <jansson.h>
 #include <flux/core.h>
 #include <flux/idset.h>
@@ -71,6 +72,7 @@ struct jobinfo {
     uint8_t               multiuser:1;
     uint8_t               has_namespace:1;
     uint8_t               exception_in_progress:1;
+    uint8_t               batched:1;     /* arrived in start-batch request */
 
     uint8_t               started:1;     /* some or all shells are starting */
     uint8_t               running:1;     /* all shells are running */
@@ -78,6 +80,9 @@ struct jobinfo {
 
     int                   wait_status;
 
+    struct timespec       t_request;  /* start request received */
+    struct timespec       t_execute;  /* implementation start called */
+
     double                kill_timeout; /* grace time between sigterm,kill */
     flux_watcher_t       *kill_timer;
     flux_watcher_t       *expiration_timer;
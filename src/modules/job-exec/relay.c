@@ -0,0 +1,451 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* relay.c - launch job shells on behalf of a TBON parent
+ *
+ * job-exec.relay {"id":I, "ranks":s, "cmd":s, "flags":i}
+ *
+ * Launches 'cmd' on 'ranks', all of which are in the TBON subtree rooted
+ * at this rank, using bulk-exec in tree mode, so the request is relayed
+ * further down the tree.  The streaming response reports on the whole
+ * subtree:
+ *
+ *  {"type":"start", "count":i}                 - all shells are running
+ *  {"type":"exit", "exits":{"status":s, ...}}  - ranks (idset) that
+ *                                                 exited, by wait status
+ *  {"type":"output", "rank":i, "stream":s, "data":s}
+ *  {"type":"error", "rank":i, "errnum":i}      - launch failed on rank
+ *
+ * followed by ENODATA once all shells have exited.
+ *
+ * job-exec.kill {"id":I, "signum":i}
+ *
+ * Sends 'signum' to shells launched by relay 'id' and its subtree.
+ *
+ * job-exec.imp-kill {"imp":s, "signum":i, "ranks":s, "pids":[i,...]}
+ *
+ * Runs "imp kill signum pid" for each rank in 'ranks' (an idset in the
+ * TBON subtree rooted at this rank) and the pid at the same position in
+ * 'pids', forwarding further down the tree.  Responds {"ranks":s} with
+ * the ranks that were signaled.
+ */
+
+#if HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <czmq.h>
+#include <flux/core.h>
+#include <flux/idset.h>
+
+#include "src/common/libjob/job_hash.h"
+#include "src/common/libsubprocess/command.h"
+#include "bulk-exec.h"
+#include "relay.h"
+
+struct relay_ctx {
+    flux_t *h;
+    flux_msg_handler_t **handlers;
+    zhashx_t *relays;
+};
+
+struct relay {
+    flux_jobid_t id;
+    struct relay_ctx *ctx;
+    const flux_msg_t *msg;
+    struct bulk_exec *exec;
+    flux_watcher_t *reap;
+};
+
+static void relay_destroy (struct relay *r)
+{
+    if (r) {
+        int saved_errno = errno;
+        bulk_exec_destroy (r->exec);
+        flux_watcher_destroy (r->reap);
+        flux_msg_decref (r->msg);
+        free (r);
+        errno = saved_errno;
+    }
+}
+
+static void relay_destructor (void **item)
+{
+    if (item) {
+        relay_destroy (*item);
+        *item = NULL;
+    }
+}
+
+static void relay_respond_error_log (struct relay *r)
+{
+    flux_log_error (r->ctx->h, "%ju: relay: error responding",
+                    (uintmax_t) r->id);
+}
+
+static void start_cb (struct bulk_exec *exec, void *arg)
+{
+    struct relay *r = arg;
+    if (flux_respond_pack (r->ctx->h,
+                           r->msg,
+                           "{s:s s:i}",
+                           "type", "start",
+                           "count", bulk_exec_total (exec)) < 0)
+        relay_respond_error_log (r);
+}
+
+static void exit_cb (struct bulk_exec *exec,
+                     void *arg,
+                     const struct idset *ranks)
+{
+    struct relay *r = arg;
+    json_t *exits;
+
+    if (!(exits = bulk_exec_exit_codes (exec))) {
+        flux_log_error (r->ctx->h, "%ju: relay: bulk_exec_exit_codes",
+                        (uintmax_t) r->id);
+        return;
+    }
+    if (flux_respond_pack (r->ctx->h,
+                           r->msg,
+                           "{s:s s:o}",
+                           "type", "exit",
+                           "exits", exits) < 0)
+        relay_respond_error_log (r);
+}
+
+static void reap_cb (flux_reactor_t *reactor,
+                     flux_watcher_t *w,
+                     int revents,
+                     void *arg)
+{
+    struct relay *r = arg;
+    zhashx_delete (r->ctx->relays, &r->id);
+}
+
+/*  All shells in the subtree have exited.  End the response stream, and
+ *   destroy the relay once it is safe to destroy its bulk_exec object.
+ */
+static void complete_cb (struct bulk_exec *exec, void *arg)
+{
+    struct relay *r = arg;
+    flux_reactor_t *reactor = flux_get_reactor (r->ctx->h);
+
+    if (flux_respond_error (r->ctx->h, r->msg, ENODATA, NULL) < 0)
+        relay_respond_error_log (r);
+    if (!(r->reap = flux_timer_watcher_create (reactor, 0., 0., reap_cb, r))) {
+        flux_log_error (r->ctx->h, "%ju: relay: timer create",
+                        (uintmax_t) r->id);
+        return;
+    }
+    flux_watcher_start (r->reap);
+}
+
+static void output_cb (struct bulk_exec *exec,
+                       int rank,
+                       const char *stream,
+                       const char *data,
+                       int data_len,
+                       void *arg)
+{
+    struct relay *r = arg;
+    if (flux_respond_pack (r->ctx->h,
+                           r->msg,
+                           "{s:s s:i s:s s:s#}",
+                           "type", "output",
+                           "rank", rank,
+                           "stream", stream,
+                           "data", data, data_len) < 0)
+        relay_respond_error_log (r);
+}
+
+static void error_cb (struct bulk_exec *exec, int rank, int errnum, void *arg)
+{
+    struct relay *r = arg;
+    if (flux_respond_pack (r->ctx->h,
+                           r->msg,
+                           "{s:s s:i s:i}",
+                           "type", "error",
+                           "rank", rank,
+                           "errnum", errnum) < 0)
+        relay_respond_error_log (r);
+}
+
+static struct bulk_exec_ops relay_ops = {
+    .on_start =     start_cb,
+    .on_exit =      exit_cb,
+    .on_complete =  complete_cb,
+    .on_output =    output_cb,
+    .on_error =     error_cb
+};
+
+static struct relay *relay_create (struct relay_ctx *ctx,
+                                   const flux_msg_t *msg,
+                                   flux_jobid_t id,
+                                   const char *ranks,
+                                   const char *cmd,
+                                   int flags)
+{
+    struct relay *r;
+    struct idset *ids = NULL;
+    flux_cmd_t *c = NULL;
+
+    if (!(r = calloc (1, sizeof (*r))))
+        return NULL;
+    r->id = id;
+    r->ctx = ctx;
+    r->msg = flux_msg_incref (msg);
+    if (!(ids = idset_decode (ranks))
+        || !(c = flux_cmd_fromjson (cmd, NULL))) {
+        errno = EPROTO;
+        goto error;
+    }
+    if (!(r->exec = bulk_exec_create (&relay_ops, r))
+        || bulk_exec_set_tree (r->exec, ctx->h, id) < 0
+        || bulk_exec_push_cmd (r->exec, ids, c, flags) < 0)
+        goto error;
+    idset_destroy (ids);
+    flux_cmd_destroy (c);
+    return r;
+error:
+    idset_destroy (ids);
+    flux_cmd_destroy (c);
+    relay_destroy (r);
+    return NULL;
+}
+
+static void relay_request_cb (flux_t *h,
+                              flux_msg_handler_t *mh,
+                              const flux_msg_t *msg,
+                              void *arg)
+{
+    struct relay_ctx *ctx = arg;
+    struct relay *r = NULL;
+    flux_jobid_t id;
+    const char *ranks;
+    const char *cmd;
+    int flags;
+
+    if (flux_request_unpack (msg, NULL, "{s:I s:s s:s s:i}",
+                             "id", &id,
+                             "ranks", &ranks,
+                             "cmd", &cmd,
+                             "flags", &flags) < 0)
+        goto error;
+    if (!flux_msg_is_streaming (msg)) {
+        errno = EPROTO;
+        goto error;
+    }
+    if (zhashx_lookup (ctx->relays, &id)) {
+        errno = EEXIST;
+        goto error;
+    }
+    if (!(r = relay_create (ctx, msg, id, ranks, cmd, flags)))
+        goto error;
+    if (zhashx_insert (ctx->relays, &r->id, r) < 0) {
+        relay_destroy (r);
+        errno = EEXIST;
+        goto error;
+    }
+    if (bulk_exec_start (h, r->exec) < 0) {
+        zhashx_delete (ctx->relays, &id);
+        goto error;
+    }
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "error responding to job-exec.relay request");
+}
+
+static void kill_continuation (flux_future_t *f, void *arg)
+{
+    struct relay_ctx *ctx = arg;
+    const flux_msg_t *msg = flux_future_aux_get (f, "msg");
+    int rc;
+
+    if ((rc = flux_future_get (f, NULL)) < 0 && errno == ENOENT)
+        rc = 0;
+    if (rc < 0) {
+        if (flux_respond_error (ctx->h, msg, errno, NULL) < 0)
+            flux_log_error (ctx->h, "error responding to job-exec.kill");
+    }
+    else if (flux_respond (ctx->h, msg, NULL) < 0)
+        flux_log_error (ctx->h, "error responding to job-exec.kill");
+    flux_future_destroy (f);
+}
+
+static void kill_request_cb (flux_t *h,
+                             flux_msg_handler_t *mh,
+                             const flux_msg_t *msg,
+                             void *arg)
+{
+    struct relay_ctx *ctx = arg;
+    struct relay *r;
+    flux_future_t *f;
+    flux_jobid_t id;
+    int signum;
+
+    if (flux_request_unpack (msg, NULL, "{s:I s:i}",
+                             "id", &id,
+                             "signum", &signum) < 0)
+        goto error;
+    if (!(r = zhashx_lookup (ctx->relays, &id))) {
+        errno = ENOENT;
+        goto error;
+    }
+    if (!(f = bulk_exec_kill (r->exec, signum)))
+        goto error;
+    if (flux_future_aux_set (f,
+                             "msg",
+                             (void *) flux_msg_incref (msg),
+                             (flux_free_f) flux_msg_decref) < 0) {
+        flux_msg_decref (msg);
+        flux_future_destroy (f);
+        goto error;
+    }
+    if (flux_future_then (f, -1., kill_continuation, ctx) < 0) {
+        flux_future_destroy (f);
+        goto error;
+    }
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "error responding to job-exec.kill request");
+}
+
+static void imp_kill_continuation (flux_future_t *f, void *arg)
+{
+    struct relay_ctx *ctx = arg;
+    const flux_msg_t *msg = flux_future_aux_get (f, "msg");
+    const struct idset *ids;
+    char *ranks = NULL;
+
+    if (flux_future_get (f, (const void **) &ids) < 0
+        || !(ranks = idset_encode (ids, IDSET_FLAG_RANGE))) {
+        if (flux_respond_error (ctx->h, msg, errno, NULL) < 0)
+            flux_log_error (ctx->h, "error responding to job-exec.imp-kill");
+    }
+    else if (flux_respond_pack (ctx->h, msg, "{s:s}", "ranks", ranks) < 0)
+        flux_log_error (ctx->h, "error responding to job-exec.imp-kill");
+    free (ranks);
+    flux_future_destroy (f);
+}
+
+static void imp_kill_request_cb (flux_t *h,
+                                 flux_msg_handler_t *mh,
+                                 const flux_msg_t *msg,
+                                 void *arg)
+{
+    struct relay_ctx *ctx = arg;
+    const char *imp;
+    const char *s;
+    json_t *o;
+    struct idset *ids = NULL;
+    uint32_t *ranks = NULL;
+    pid_t *pids = NULL;
+    flux_future_t *f;
+    unsigned int rank;
+    int signum;
+    int count;
+    int i = 0;
+
+    if (flux_request_unpack (msg, NULL, "{s:s s:i s:s s:o}",
+                             "imp", &imp,
+                             "signum", &signum,
+                             "ranks", &s,
+                             "pids", &o) < 0)
+        goto error;
+    if (!(ids = idset_decode (s))
+        || !json_is_array (o)
+        || (count = idset_count (ids)) != json_array_size (o)) {
+        errno = EPROTO;
+        goto error;
+    }
+    if (!(ranks = calloc (count + 1, sizeof (*ranks)))
+        || !(pids = calloc (count + 1, sizeof (*pids))))
+        goto error;
+    rank = idset_first (ids);
+    while (rank != IDSET_INVALID_ID) {
+        json_t *pid = json_array_get (o, i);
+        if (!json_is_integer (pid)) {
+            errno = EPROTO;
+            goto error;
+        }
+        ranks[i] = rank;
+        pids[i++] = json_integer_value (pid);
+        rank = idset_next (ids, rank);
+    }
+    if (!(f = bulk_exec_imp_kill_ranks (h, imp, signum,
+                                        ranks, pids, count, true)))
+        goto error;
+    if (flux_future_aux_set (f,
+                             "msg",
+                             (void *) flux_msg_incref (msg),
+                             (flux_free_f) flux_msg_decref) < 0) {
+        flux_msg_decref (msg);
+        flux_future_destroy (f);
+        goto error;
+    }
+    if (flux_future_then (f, -1., imp_kill_continuation, ctx) < 0) {
+        flux_future_destroy (f);
+        goto error;
+    }
+    idset_destroy (ids);
+    free (ranks);
+    free (pids);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "error responding to job-exec.imp-kill request");
+    idset_destroy (ids);
+    free (ranks);
+    free (pids);
+}
+
+static const struct flux_msg_handler_spec htab[] = {
+    { FLUX_MSGTYPE_REQUEST, "job-exec.relay", relay_request_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST, "job-exec.kill",  kill_request_cb,  0 },
+    { FLUX_MSGTYPE_REQUEST, "job-exec.imp-kill", imp_kill_request_cb, 0 },
+    FLUX_MSGHANDLER_TABLE_END
+};
+
+void relay_ctx_destroy (struct relay_ctx *ctx)
+{
+    if (ctx) {
+        int saved_errno = errno;
+        flux_msg_handler_delvec (ctx->handlers);
+        zhashx_destroy (&ctx->relays);
+        free (ctx);
+        errno = saved_errno;
+    }
+}
+
+struct relay_ctx *relay_ctx_create (flux_t *h)
+{
+    struct relay_ctx *ctx;
+
+    if (!(ctx = calloc (1, sizeof (*ctx))))
+        return NULL;
+    ctx->h = h;
+    if (!(ctx->relays = job_hash_create ())) {
+        errno = ENOMEM;
+        goto error;
+    }
+    zhashx_set_destructor (ctx->relays, relay_destructor);
+    if (flux_msg_handler_addvec (h, htab, ctx, &ctx->handlers) < 0)
+        goto error;
+    return ctx;
+error:
+    relay_ctx_destroy (ctx);
+    return NULL;
+}
+
+/* vi: ts=4 sw=4 expandtab
+ */
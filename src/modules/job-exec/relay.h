@@ -0,0 +1,27 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* Relay job shell launch requests for a TBON subtree (see bulk-exec.h) */
+
+#ifndef HAVE_JOB_EXEC_RELAY_H
+#define HAVE_JOB_EXEC_RELAY_H 1
+
+#include <flux/core.h>
+
+struct relay_ctx;
+
+struct relay_ctx *relay_ctx_create (flux_t *h);
+
+void relay_ctx_destroy (struct relay_ctx *ctx);
+
+#endif /* !HAVE_JOB_EXEC_RELAY_H */
+
+/* vi: ts=4 sw=4 expandtab
+ */
@@ -9,12 +9,15 @@
 \************************************************************/
 
 #include <errno.h>
+#include <stdlib.h>
 #include "rset.h"
 
 struct resource_set {
     json_t *R;
     const json_t *R_lite;
     struct idset *ranks;
+    uint32_t *rank_array;   /* 'ranks' in ascending order */
+    int nranks;
 
     double starttime;
     double expiration;
@@ -26,6 +29,7 @@ void resource_set_destroy (struct resource_set *r)
         r->R_lite = NULL;
         json_decref (r->R);
         idset_destroy (r->ranks);
+        free (r->rank_array);
         free (r);
     }
 }
@@ -80,6 +84,25 @@ err:
     return NULL;
 }
 
+/*  Flatten the ranks idset into a sorted array once, so callers can
+ *   index and search it instead of walking the idset per operation.
+ */
+static int rset_rank_array (struct resource_set *r)
+{
+    unsigned int rank;
+    int n = 0;
+
+    r->nranks = idset_count (r->ranks);
+    if (!(r->rank_array = calloc (r->nranks + 1, sizeof (uint32_t))))
+        return -1;
+    rank = idset_first (r->ranks);
+    while (rank != IDSET_INVALID_ID) {
+        r->rank_array[n++] = rank;
+        rank = idset_next (r->ranks, rank);
+    }
+    return 0;
+}
+
 static int rset_read_time_window (struct resource_set *r, json_error_t *errp)
 {
     if (!r || !r->R_lite) {
@@ -122,6 +145,11 @@ struct resource_set * resource_set_create (const char *R, json_error_t *errp)
                     "R_lite: failed to read target rank list");
         goto err;
     }
+    if (rset_rank_array (r) < 0) {
+        if (errp)
+            snprintf (errp->text, sizeof (errp->text), "out of memory");
+        goto err;
+    }
     if (rset_read_time_window (r, errp) < 0)
         goto err;
     return (r);
@@ -135,6 +163,31 @@ const struct idset * resource_set_ranks (struct resource_set *r)
     return r->ranks;
 }
 
+const uint32_t *resource_set_rank_array (struct resource_set *r, int *count)
+{
+    if (count)
+        *count = r->nranks;
+    return r->rank_array;
+}
+
+int resource_set_rank_index (struct resource_set *r, uint32_t rank)
+{
+    int lo = 0;
+    int hi = r->nranks - 1;
+
+    while (lo <= hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (r->rank_array[mid] == rank)
+            return mid;
+        if (r->rank_array[mid] < rank)
+            lo = mid + 1;
+        else
+            hi = mid - 1;
+    }
+    errno = ENOENT;
+    return -1;
+}
+
 double resource_set_starttime (struct resource_set *r)
 {
     return r->starttime;
@@ -10,6 +10,7 @@
 
 #ifndef HAVE_JOB_EXEC_RSET_H
 #define HAVE_JOB_EXEC_RSET_H 1
+#include <stdint.h>
 #include <flux/idset.h>
 #include <jansson.h>
 
@@ -21,6 +22,18 @@ void resource_set_destroy (struct resource_set *rset);
 
 const struct idset * resource_set_ranks (struct resource_set *rset);
 
+/*  Return the ranks of rset in ascending order, with the number of
+ *   ranks in 'count'.  The array is built once at create time and is
+ *   valid for the life of rset.
+ */
+const uint32_t *resource_set_rank_array (struct resource_set *rset,
+                                         int *count);
+
+/*  Return the index of 'rank' in the rank array, or -1 with errno set
+ *   to ENOENT if rank is not in rset.
+ */
+int resource_set_rank_index (struct resource_set *rset, uint32_t rank);
+
 double resource_set_starttime (struct resource_set *rset);
 
 double resource_set_expiration (struct resource_set *rset);
@@ -41,28 +41,30 @@ void complete (struct bulk_exec *exec, void *arg)
 void exited (struct bulk_exec *exec, void *arg, const struct idset *ids)
 {
     char *s = idset_encode (ids, IDSET_FLAG_RANGE);
+    json_t *codes = bulk_exec_exit_codes (exec);
+    const char *key;
+    json_t *val;
+
     log_msg ("ranks %s: exited", s);
+    json_object_foreach (codes, key, val)
+        log_msg ("ranks %s: status %s", json_string_value (val), key);
+    json_decref (codes);
     free (s);
 }
 
-void on_error (struct bulk_exec *exec, flux_subprocess_t *p, void *arg)
+void on_error (struct bulk_exec *exec, int rank, int errnum, void *arg)
 {
-    if (p) {
-        flux_subprocess_state_t state = flux_subprocess_state (p);
-        log_msg ("%d: pid %ju: %s", flux_subprocess_rank (p),
-                (uintmax_t) flux_subprocess_pid (p),
-                flux_subprocess_state_string (state));
-    }
+    if (rank >= 0)
+        log_msg ("%d: %s", rank, flux_strerror (errnum));
     flux_future_t *f = bulk_exec_kill (exec, 9);
     if (flux_future_get (f, NULL) < 0)
         log_err_exit ("bulk_exec_kill");
 }
 
-void on_output (struct bulk_exec *exec, flux_subprocess_t *p,
+void on_output (struct bulk_exec *exec, int rank,
                 const char *stream, const char *data,
                 int data_len, void *arg)
 {
-    int rank = flux_subprocess_rank (p);
     FILE *fp = strcmp (stream, "stdout") == 0 ? stdout : stderr;
     fprintf (fp, "%d: %s", rank, data);
 }
@@ -10,6 +10,7 @@
 
 #include <errno.h>
 #include <string.h>
+#include <stdbool.h>
 
 #include "src/common/libtap/tap.h"
 #include "rset.h"
@@ -64,6 +65,20 @@ struct resource_set_test {
     "    } " \
     "}"
 
+#define MULTI_R \
+    "{ \"version\": 1," \
+    "  \"execution\": { " \
+    "    \"R_lite\": " \
+    "       [ {\"rank\": \"7,9\", " \
+    "          \"children\": { \"core\": \"0-3\" } " \
+    "         }, " \
+    "         {\"rank\": \"2-4\", " \
+    "          \"children\": { \"core\": \"0-1\" } " \
+    "         } " \
+    "       ] " \
+    "    } " \
+    "}"
+
 struct resource_set_test tests[] = {
 
     { "no R_lite",
@@ -89,6 +104,41 @@ struct resource_set_test tests[] = {
     RESOURCE_SET_TEST_END
 };
 
+static void test_rank_array (void)
+{
+    uint32_t expected[] = { 2, 3, 4, 7, 9 };
+    struct resource_set *r;
+    const uint32_t *ranks;
+    json_error_t err;
+    int count = -1;
+    int i;
+    bool match = true;
+
+    if (!(r = resource_set_create (MULTI_R, &err)))
+        BAIL_OUT ("resource_set_create: %s", err.text);
+    ranks = resource_set_rank_array (r, &count);
+    ok (ranks != NULL && count == 5,
+        "resource_set_rank_array returns 5 ranks");
+    for (i = 0; i < count && i < 5; i++) {
+        if (ranks[i] != expected[i])
+            match = false;
+    }
+    ok (match,
+        "rank array is in ascending order across R_lite entries");
+    for (i = 0; i < 5; i++) {
+        ok (resource_set_rank_index (r, expected[i]) == i,
+            "resource_set_rank_index (%u) = %d",
+            (unsigned int) expected[i], i);
+    }
+    errno = 0;
+    ok (resource_set_rank_index (r, 5) < 0 && errno == ENOENT,
+        "resource_set_rank_index of missing rank fails with ENOENT");
+    errno = 0;
+    ok (resource_set_rank_index (r, 10) < 0 && errno == ENOENT,
+        "resource_set_rank_index past last rank fails with ENOENT");
+    resource_set_destroy (r);
+}
+
 int main (int ac, char *av[])
 {
     struct resource_set_test *e = NULL;
@@ -133,6 +183,7 @@ int main (int ac, char *av[])
         resource_set_destroy (r);
         e++;
     }
+    test_rank_array ();
 
     done_testing ();
 }
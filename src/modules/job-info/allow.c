@@ -27,17 +27,19 @@
 static int eventlog_get_userid (struct info_ctx *ctx, const char *s,
                                 int *useridp)
 {
-    json_t *a = NULL;
+    struct eventlog_iter *iter;
     json_t *entry = NULL;
     const char *name = NULL;
     json_t *context = NULL;
     int rv = -1;
 
-    if (!(a = eventlog_decode (s))) {
-        flux_log_error (ctx->h, "%s: eventlog_decode", __FUNCTION__);
-        goto error;
+    if (!(iter = eventlog_iter_create (s))) {
+        flux_log_error (ctx->h, "%s: eventlog_iter_create", __FUNCTION__);
+        return -1;
     }
-    if (!(entry = json_array_get (a, 0))) {
+    if (eventlog_iter_next (iter, NULL, NULL) <= 0
+        || !(entry = eventlog_iter_entry (iter))) {
+        flux_log_error (ctx->h, "%s: eventlog_decode", __FUNCTION__);
         errno = EINVAL;
         goto error;
     }
@@ -56,7 +58,7 @@ static int eventlog_get_userid (struct info_ctx *ctx, const char *s,
     }
     rv = 0;
 error:
-    json_decref (a);
+    eventlog_iter_destroy (iter);
     return rv;
 }
 
@@ -71,6 +71,7 @@ struct guest_watch_ctx {
     flux_jobid_t id;
     char *path;
     int flags;
+    int start;
     bool cancel;
 
     /* transition possibilities
@@ -113,6 +114,9 @@ struct guest_watch_ctx {
 
     /* data from guest namespace */
     int offset;
+
+    /* index of next entry, those before 'start' are not sent */
+    int index;
 };
 
 static int get_main_eventlog (struct guest_watch_ctx *gw);
@@ -128,6 +132,7 @@ static void guest_watch_ctx_destroy (void *data)
 {
     if (data) {
         struct guest_watch_ctx *gw = data;
+        (void)flux_msglist_remove (gw->ctx->guest_watch_requests, gw);
         flux_msg_decref (gw->msg);
         free (gw->path);
         flux_future_destroy (gw->get_main_eventlog_f);
@@ -142,7 +147,8 @@ static struct guest_watch_ctx *guest_watch_ctx_create (struct info_ctx *ctx,
                                                        const flux_msg_t *msg,
                                                        flux_jobid_t id,
                                                        const char *path,
-                                                       int flags)
+                                                       int flags,
+                                                       int start)
 {
     struct guest_watch_ctx *gw = calloc (1, sizeof (*gw));
     int saved_errno;
@@ -157,6 +163,7 @@ static struct guest_watch_ctx *guest_watch_ctx_create (struct info_ctx *ctx,
         goto error;
     }
     gw->flags = flags;
+    gw->start = start;
     gw->state = GUEST_WATCH_STATE_INIT;
 
     gw->msg = flux_msg_incref (msg);
@@ -315,23 +322,26 @@ error:
 static int check_guest_namespace_status (struct guest_watch_ctx *gw,
                                          const char *s)
 {
-    json_t *a = NULL;
-    size_t index;
-    json_t *event;
+    struct eventlog_iter *eviter;
+    const char *name;
+    int rc;
     int rv = -1;
 
-    if (!(a = eventlog_decode (s)))
-        goto error;
+    if (!(eviter = eventlog_iter_create (s)))
+        return -1;
 
-    json_array_foreach (a, index, event) {
-        const char *name;
-        json_t *context = NULL;
-        if (eventlog_entry_parse (event, NULL, &name, &context) < 0)
-            goto error;
+    while ((rc = eventlog_iter_next (eviter, NULL, &name)) > 0) {
         if (!strcmp (name, "start"))
             gw->guest_started = true;
         if (!strcmp (name, "release")) {
-            void *iter = json_object_iter (context);
+            json_t *event;
+            json_t *context = NULL;
+            void *iter;
+
+            if (!(event = eventlog_iter_entry (eviter))
+                || eventlog_entry_parse (event, NULL, NULL, &context) < 0)
+                goto error;
+            iter = json_object_iter (context);
             while (iter && !gw->guest_released) {
                 const char *key = json_object_iter_key (iter);
                 if (!strcmp (key, "final")) {
@@ -343,10 +353,12 @@ static int check_guest_namespace_status (struct guest_watch_ctx *gw,
             }
         }
     }
+    if (rc < 0)
+        goto error;
 
     rv = 0;
 error:
-    json_decref (a);
+    eventlog_iter_destroy (eviter);
     return rv;
 }
 
@@ -648,7 +660,8 @@ static void guest_namespace_watch_continuation (flux_future_t *f, void *arg)
         goto error;
     }
 
-    if (flux_respond_pack (ctx->h, gw->msg, "{s:s}", "event", event) < 0) {
+    if (gw->index++ >= gw->start
+        && flux_respond_pack (ctx->h, gw->msg, "{s:s}", "event", event) < 0) {
         flux_log_error (ctx->h, "%s: flux_respond_pack",
                         __FUNCTION__);
         goto error_cancel;
@@ -780,9 +793,10 @@ static void main_namespace_lookup_continuation (flux_future_t *f, void *arg)
 
     input = s + gw->offset;
     while (eventlog_parse_next (&input, &tok, &toklen)) {
-        if (flux_respond_pack (ctx->h, gw->msg,
-                               "{s:s#}",
-                               "event", tok, toklen) < 0) {
+        if (gw->index++ >= gw->start
+            && flux_respond_pack (ctx->h, gw->msg,
+                                  "{s:s#}",
+                                  "event", tok, toklen) < 0) {
             flux_log_error (ctx->h, "%s: flux_respond_pack",
                             __FUNCTION__);
             goto error;
@@ -810,6 +824,7 @@ void guest_watch_cb (flux_t *h, flux_msg_handler_t *mh,
     flux_jobid_t id;
     const char *path = NULL;
     int flags;
+    int start = 0;
     const char *errmsg = NULL;
 
     if (flux_request_unpack (msg, NULL, "{s:I s:s s:i}",
@@ -825,13 +840,26 @@ void guest_watch_cb (flux_t *h, flux_msg_handler_t *mh,
                  "RPC flag";
         goto error;
     }
+    /* The guest eventlog may move to the main KVS namespace while it
+     * is watched, so the end is not known up front.
+     */
+    (void)flux_request_unpack (msg, NULL, "{s:i}", "start", &start);
+    if (start < 0) {
+        errno = EINVAL;
+        errmsg = "negative start is not supported for guest eventlogs";
+        goto error;
+    }
 
-    if (!(gw = guest_watch_ctx_create (ctx, msg, id, path, flags)))
+    if (!(gw = guest_watch_ctx_create (ctx, msg, id, path, flags, start)))
         goto error;
 
     if (get_main_eventlog (gw) < 0)
         goto error;
 
+    if (flux_msglist_append (ctx->guest_watch_requests, msg, gw) < 0) {
+        flux_log_error (h, "%s: flux_msglist_append", __FUNCTION__);
+        goto error;
+    }
     if (zlist_append (ctx->guest_watchers, gw) < 0) {
         flux_log_error (h, "%s: zlist_append", __FUNCTION__);
         goto error;
@@ -847,36 +875,15 @@ error:
     guest_watch_ctx_destroy (gw);
 }
 
-/* Cancel guest_watch 'gw' if it matches (sender, matchtag).
- * matchtag=FLUX_MATCHTAG_NONE matches any matchtag.
- */
-static void guest_watch_cancel (struct info_ctx *ctx,
-                                struct guest_watch_ctx *gw,
-                                const char *sender, uint32_t matchtag)
-{
-    uint32_t t;
-    char *s;
-
-    if (matchtag != FLUX_MATCHTAG_NONE
-        && (flux_msg_get_matchtag (gw->msg, &t) < 0 || matchtag != t))
-        return;
-    if (flux_msg_get_route_first (gw->msg, &s) < 0)
-        return;
-    if (!strcmp (sender, s))
-        send_cancel (gw, NULL);
-    free (s);
-}
-
 void guest_watchers_cancel (struct info_ctx *ctx,
-                            const char *sender, uint32_t matchtag)
+                            const flux_msg_t *msg, uint32_t matchtag)
 {
     struct guest_watch_ctx *gw;
 
-    gw = zlist_first (ctx->guest_watchers);
-    while (gw) {
-        guest_watch_cancel (ctx, gw, sender, matchtag);
-        gw = zlist_next (ctx->guest_watchers);
-    }
+    while ((gw = flux_msglist_pop_sender (ctx->guest_watch_requests,
+                                          msg,
+                                          matchtag)))
+        send_cancel (gw, NULL);
 }
 
 void guest_watch_cancel_cb (flux_t *h, flux_msg_handler_t *mh,
@@ -884,18 +891,12 @@ void guest_watch_cancel_cb (flux_t *h, flux_msg_handler_t *mh,
 {
     struct info_ctx *ctx = arg;
     uint32_t matchtag;
-    char *sender;
 
     if (flux_request_unpack (msg, NULL, "{s:i}", "matchtag", &matchtag) < 0) {
         flux_log_error (h, "%s: flux_request_unpack", __FUNCTION__);
         return;
     }
-    if (flux_msg_get_route_first (msg, &sender) < 0) {
-        flux_log_error (h, "%s: flux_msg_get_route_first", __FUNCTION__);
-        return;
-    }
-    guest_watchers_cancel (ctx, sender, matchtag);
-    free (sender);
+    guest_watchers_cancel (ctx, msg, matchtag);
 }
 
 void guest_watch_cleanup (struct info_ctx *ctx)
@@ -19,9 +19,9 @@ void guest_watch_cb (flux_t *h, flux_msg_handler_t *mh,
 void guest_watch_cancel_cb (flux_t *h, flux_msg_handler_t *mh,
                             const flux_msg_t *msg, void *arg);
 
-/* Cancel all lookups that match (sender, matchtag). */
+/* Cancel all lookups from the sender of 'msg' that match matchtag. */
 void guest_watchers_cancel (struct info_ctx *ctx,
-                            const char *sender, uint32_t matchtag);
+                            const flux_msg_t *msg, uint32_t matchtag);
 
 void guest_watch_cleanup (struct info_ctx *ctx);
 
@@ -22,9 +22,15 @@ struct info_ctx {
     zlist_t *lookups;
     zlist_t *watchers;
     zlist_t *guest_watchers;
+    struct flux_msglist *watch_requests;       // watchers by sender
+    struct flux_msglist *guest_watch_requests; // guest_watchers by sender
+    struct flux_msglist *state_watch_requests; // state_watchers by sender
     struct job_state_ctx *jsctx;
+    struct lookup_cache *lookup_cache;
     zlistx_t *idsync_lookups;
     zhashx_t *idsync_waits;
+    zlistx_t *state_watchers;
+    flux_watcher_t *state_watch_prep;
 };
 
 #endif /* _FLUX_JOB_INFO_INFO_H */
@@ -14,6 +14,12 @@
 #include <czmq.h>
 #include <flux/core.h>
 
+#include "src/common/libutil/fsd.h"
+
+#define LOAD_CONCURRENCY_DEFAULT 128
+#define LOOKUP_CACHE_COUNT 1024
+#define LOOKUP_CACHE_SIZE_DEFAULT (16*1024*1024)
+
 #include "info.h"
 #include "allow.h"
 #include "job_state.h"
@@ -22,24 +28,20 @@
 #include "watch.h"
 #include "guest_watch.h"
 #include "idsync.h"
+#include "state_watch.h"
 
 static void disconnect_cb (flux_t *h, flux_msg_handler_t *mh,
                            const flux_msg_t *msg, void *arg)
 {
     struct info_ctx *ctx = arg;
-    char *sender;
 
     if (flux_request_decode (msg, NULL, NULL) < 0) {
         flux_log_error (h, "%s: flux_request_decode", __FUNCTION__);
         return;
     }
-    if (flux_msg_get_route_first (msg, &sender) < 0) {
-        flux_log_error (h, "%s: flux_msg_get_route_first", __FUNCTION__);
-        return;
-    }
-    watchers_cancel (ctx, sender, FLUX_MATCHTAG_NONE);
-    guest_watchers_cancel (ctx, sender, FLUX_MATCHTAG_NONE);
-    free (sender);
+    watchers_cancel (ctx, msg, FLUX_MATCHTAG_NONE);
+    guest_watchers_cancel (ctx, msg, FLUX_MATCHTAG_NONE);
+    state_watchers_cancel (ctx, msg, FLUX_MATCHTAG_NONE);
 }
 
 static void stats_cb (flux_t *h, flux_msg_handler_t *mh,
@@ -49,22 +51,40 @@ static void stats_cb (flux_t *h, flux_msg_handler_t *mh,
     int lookups = zlist_size (ctx->lookups);
     int watchers = zlist_size (ctx->watchers);
     int guest_watchers = zlist_size (ctx->guest_watchers);
-    int pending = zlistx_size (ctx->jsctx->pending);
-    int running = zlistx_size (ctx->jsctx->running);
-    int inactive = zlistx_size (ctx->jsctx->inactive);
+    int state_watchers = zlistx_size (ctx->state_watchers);
+    int pending = skiplist_size (ctx->jsctx->pending);
+    int running = skiplist_size (ctx->jsctx->running);
+    int inactive = skiplist_size (ctx->jsctx->inactive);
     int idsync_lookups = zlistx_size (ctx->idsync_lookups);
     int idsync_waits = zhashx_size (ctx->idsync_waits);
-    if (flux_respond_pack (h, msg, "{s:i s:i s:i s:{s:i s:i s:i} s:{s:i s:i}}",
+    json_t *cache;
+
+    if (!(cache = lookup_cache_stats (ctx->lookup_cache))) {
+        errno = ENOMEM;
+        goto error;
+    }
+    if (flux_respond_pack (h, msg,
+                           "{s:i s:i s:i s:i s:i s:{s:i s:i s:i s:i}"
+                           " s:{s:i s:i} s:{s:b s:i} s:o}",
                            "lookups", lookups,
+                           "loading", ctx->jsctx->loading
+                                      ? ctx->jsctx->load_remaining : 0,
                            "watchers", watchers,
                            "guest_watchers", guest_watchers,
+                           "state_watchers", state_watchers,
                            "jobs",
                            "pending", pending,
                            "running", running,
                            "inactive", inactive,
+                           "evicted", ctx->jsctx->evicted_count,
                            "idsync",
                            "lookups", idsync_lookups,
-                           "waits", idsync_waits) < 0) {
+                           "waits", idsync_waits,
+                           "journal",
+                           "running", ctx->jsctx->journal ? 1 : 0,
+                           "state_lookups",
+                           ctx->jsctx->state_lookups,
+                           "lookup_cache", cache) < 0) {
         flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
         goto error;
     }
@@ -128,6 +148,16 @@ static const struct flux_msg_handler_spec htab[] = {
       .cb           = guest_watch_cancel_cb,
       .rolemask     = FLUX_ROLE_USER
     },
+    { .typemask     = FLUX_MSGTYPE_REQUEST,
+      .topic_glob   = "job-info.state-watch",
+      .cb           = state_watch_cb,
+      .rolemask     = FLUX_ROLE_USER
+    },
+    { .typemask     = FLUX_MSGTYPE_REQUEST,
+      .topic_glob   = "job-info.state-watch-cancel",
+      .cb           = state_watch_cancel_cb,
+      .rolemask     = FLUX_ROLE_USER
+    },
     { .typemask     = FLUX_MSGTYPE_REQUEST,
       .topic_glob   = "job-info.list",
       .cb           = list_cb,
@@ -204,8 +234,14 @@ static void info_ctx_destroy (struct info_ctx *ctx)
         }
         if (ctx->jsctx)
             job_state_destroy (ctx->jsctx);
+        lookup_cache_destroy (ctx->lookup_cache);
         if (ctx->idsync_lookups)
             idsync_cleanup (ctx);
+        if (ctx->state_watchers)
+            state_watch_cleanup (ctx);
+        flux_msglist_destroy (ctx->watch_requests);
+        flux_msglist_destroy (ctx->guest_watch_requests);
+        flux_msglist_destroy (ctx->state_watch_requests);
         free (ctx);
         errno = saved_errno;
     }
@@ -225,27 +261,128 @@ static struct info_ctx *info_ctx_create (flux_t *h)
         goto error;
     if (!(ctx->guest_watchers = zlist_new ()))
         goto error;
+    if (!(ctx->watch_requests = flux_msglist_create ())
+        || !(ctx->guest_watch_requests = flux_msglist_create ())
+        || !(ctx->state_watch_requests = flux_msglist_create ()))
+        goto error;
     if (!(ctx->jsctx = job_state_create (h)))
         goto error;
     if (idsync_setup (ctx) < 0)
         goto error;
+    if (state_watch_setup (ctx) < 0)
+        goto error;
     return ctx;
 error:
     info_ctx_destroy (ctx);
     return NULL;
 }
 
+/* Set options from the [job-info] table of the config file, or module
+ * options, which override it:
+ *   inactive-limit=N          - keep at most N inactive jobs
+ *   inactive-age-limit=FSD    - keep inactive jobs for at most FSD
+ *   load-concurrency=N        - read up to N jobs at once at startup
+ *   lookup-cache-size=N       - cache up to N bytes of inactive job
+ *                               lookups (0 disables the cache)
+ */
+static int process_config (struct info_ctx *ctx,
+                           int argc,
+                           char **argv,
+                           int *concurrency)
+{
+    flux_conf_error_t err;
+    int limit = 0;
+    int cache_size = LOOKUP_CACHE_SIZE_DEFAULT;
+    const char *age_limit = NULL;
+    double age = 0.;
+    int i;
+
+    if (flux_conf_unpack (flux_get_conf (ctx->h),
+                          &err,
+                          "{s?{s?i s?s s?i s?i}}",
+                          "job-info",
+                            "inactive-limit", &limit,
+                            "inactive-age-limit", &age_limit,
+                            "load-concurrency", concurrency,
+                            "lookup-cache-size", &cache_size) < 0) {
+        flux_log (ctx->h, LOG_ERR,
+                  "error reading job-info config: %s",
+                  err.errbuf);
+        return -1;
+    }
+    for (i = 0; i < argc; i++) {
+        if (!strncmp (argv[i], "inactive-limit=", 15)) {
+            char *endptr;
+            errno = 0;
+            limit = strtol (argv[i] + 15, &endptr, 10);
+            if (errno != 0 || *endptr != '\0') {
+                flux_log (ctx->h, LOG_ERR, "invalid option: %s", argv[i]);
+                errno = EINVAL;
+                return -1;
+            }
+        }
+        else if (!strncmp (argv[i], "inactive-age-limit=", 19))
+            age_limit = argv[i] + 19;
+        else if (!strncmp (argv[i], "load-concurrency=", 17)) {
+            char *endptr;
+            errno = 0;
+            *concurrency = strtol (argv[i] + 17, &endptr, 10);
+            if (errno != 0 || *endptr != '\0') {
+                flux_log (ctx->h, LOG_ERR, "invalid option: %s", argv[i]);
+                errno = EINVAL;
+                return -1;
+            }
+        }
+        else if (!strncmp (argv[i], "lookup-cache-size=", 18)) {
+            char *endptr;
+            errno = 0;
+            cache_size = strtol (argv[i] + 18, &endptr, 10);
+            if (errno != 0 || *endptr != '\0' || cache_size < 0) {
+                flux_log (ctx->h, LOG_ERR, "invalid option: %s", argv[i]);
+                errno = EINVAL;
+                return -1;
+            }
+        }
+        else {
+            flux_log (ctx->h, LOG_ERR, "Unknown option `%s'", argv[i]);
+            errno = EINVAL;
+            return -1;
+        }
+    }
+    if (age_limit && fsd_parse_duration (age_limit, &age) < 0) {
+        flux_log (ctx->h, LOG_ERR, "invalid inactive-age-limit: %s",
+                  age_limit);
+        return -1;
+    }
+    if (job_state_set_retention (ctx->jsctx, limit, age) < 0) {
+        flux_log_error (ctx->h, "error setting inactive job retention");
+        return -1;
+    }
+    if (cache_size > 0
+        && !(ctx->lookup_cache = lookup_cache_create (LOOKUP_CACHE_COUNT,
+                                                      cache_size))) {
+        flux_log_error (ctx->h, "error creating lookup cache");
+        return -1;
+    }
+    return 0;
+}
+
 int mod_main (flux_t *h, int argc, char **argv)
 {
     struct info_ctx *ctx;
+    int concurrency = LOAD_CONCURRENCY_DEFAULT;
     int rc = -1;
 
     if (!(ctx = info_ctx_create (h))) {
         flux_log_error (h, "initialization error");
         goto done;
     }
-    if (job_state_init_from_kvs (ctx) < 0)
+    if (process_config (ctx, argc, argv, &concurrency) < 0)
+        goto done;
+    if (job_state_init_from_kvs (ctx, concurrency) < 0) {
+        flux_log_error (h, "error reading jobs from KVS");
         goto done;
+    }
     if (flux_reactor_run (flux_get_reactor (h), 0) < 0)
         goto done;
     rc = 0;
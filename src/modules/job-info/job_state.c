@@ -18,6 +18,7 @@
 #include <flux/core.h>
 
 #include "src/common/libeventlog/eventlog.h"
+#include "src/common/libjob/jobspec_summary.h"
 #include "src/common/libutil/fluid.h"
 #include "src/common/libjob/job_hash.h"
 #include "src/common/libidset/idset.h"
@@ -25,20 +26,31 @@
 #include "job_state.h"
 #include "idsync.h"
 #include "job_util.h"
+#include "state_watch.h"
 
 #define NUMCMP(a,b) ((a)==(b)?0:((a)<(b)?-1:1))
 
+/* A job being read from the KVS at startup */
+struct job_load {
+    struct info_ctx *ctx;
+    flux_jobid_t id;
+    flux_future_t *f;       // eventlog and jobspec lookups
+    flux_future_t *f_R;
+    struct job *job;        // not yet inserted in index
+};
+
 struct state_transition {
     flux_job_state_t state;
     bool processed;
     double timestamp;
+    json_t *data;           // job data from job-manager.journal, if any
 };
 
 static void process_next_state (struct info_ctx *ctx, struct job *job);
 
 /* Compare items for sorting in list, priority first (higher priority
  * before lower priority), t_submit second (earlier submission time
- * first) N.B. zlistx_comparator_fn signature
+ * first), jobid last.  N.B. skiplist_compare_f signature
  */
 static int job_priority_cmp (const void *a1, const void *a2)
 {
@@ -46,30 +58,37 @@ static int job_priority_cmp (const void *a1, const void *a2)
     const struct job *j2 = a2;
     int rc;
 
-    if ((rc = (-1)*NUMCMP (j1->priority, j2->priority)) == 0)
-        rc = NUMCMP (j1->t_submit, j2->t_submit);
+    if ((rc = (-1)*NUMCMP (j1->priority, j2->priority)) == 0
+        && (rc = NUMCMP (j1->t_submit, j2->t_submit)) == 0)
+        rc = NUMCMP (j1->id, j2->id);
     return rc;
 }
 
 /* Compare items for sorting in list by timestamp (note that sorting
  * is in reverse order, most recently (i.e. bigger timestamp)
- * running/completed comes first).  N.B. zlistx_comparator_fn
- * signature
+ * running/completed comes first), then by jobid.
+ * N.B. skiplist_compare_f signature
  */
 static int job_running_cmp (const void *a1, const void *a2)
 {
     const struct job *j1 = a1;
     const struct job *j2 = a2;
+    int rc;
 
-    return NUMCMP (j2->t_run, j1->t_run);
+    if ((rc = NUMCMP (j2->t_run, j1->t_run)) == 0)
+        rc = NUMCMP (j1->id, j2->id);
+    return rc;
 }
 
 static int job_inactive_cmp (const void *a1, const void *a2)
 {
     const struct job *j1 = a1;
     const struct job *j2 = a2;
+    int rc;
 
-    return NUMCMP (j2->t_inactive, j1->t_inactive);
+    if ((rc = NUMCMP (j2->t_inactive, j1->t_inactive)) == 0)
+        rc = NUMCMP (j1->id, j2->id);
+    return rc;
 }
 
 static void job_destroy (void *data)
@@ -93,6 +112,50 @@ static void job_destroy_wrapper (void **data)
     job_destroy (*job);
 }
 
+static void user_jobs_destroy (struct user_jobs *uj)
+{
+    if (uj) {
+        int saved_errno = errno;
+        skiplist_destroy (uj->pending);
+        skiplist_destroy (uj->running);
+        skiplist_destroy (uj->inactive);
+        free (uj);
+        errno = saved_errno;
+    }
+}
+
+static void user_jobs_destructor (void **item)
+{
+    if (item) {
+        user_jobs_destroy (*item);
+        *item = NULL;
+    }
+}
+
+static struct user_jobs *user_jobs_create (uint32_t userid)
+{
+    struct user_jobs *uj;
+
+    if (!(uj = calloc (1, sizeof (*uj))))
+        return NULL;
+    uj->key = userid;
+    if (!(uj->pending = skiplist_create (job_priority_cmp))
+        || !(uj->running = skiplist_create (job_running_cmp))
+        || !(uj->inactive = skiplist_create (job_inactive_cmp))) {
+        user_jobs_destroy (uj);
+        return NULL;
+    }
+    return uj;
+}
+
+struct user_jobs *job_state_user_jobs (struct job_state_ctx *jsctx,
+                                       uint32_t userid)
+{
+    flux_jobid_t key = userid;
+
+    return zhashx_lookup (jsctx->users, &key);
+}
+
 void flux_msg_destroy_wrapper (void **data)
 {
     if (data) {
@@ -101,6 +164,34 @@ void flux_msg_destroy_wrapper (void **data)
     }
 }
 
+static void json_decref_wrapper (void **data)
+{
+    if (data) {
+        json_t **ptr = (json_t **)data;
+        json_decref (*ptr);
+    }
+}
+
+static void job_load_destroy (struct job_load *jl)
+{
+    if (jl) {
+        int saved_errno = errno;
+        flux_future_destroy (jl->f);
+        flux_future_destroy (jl->f_R);
+        job_destroy (jl->job);
+        free (jl);
+        errno = saved_errno;
+    }
+}
+
+static void job_load_destructor (void **item)
+{
+    if (item) {
+        job_load_destroy (*item);
+        *item = NULL;
+    }
+}
+
 static struct job *job_create (struct info_ctx *ctx, flux_jobid_t id)
 {
     struct job *job = NULL;
@@ -140,17 +231,18 @@ struct job_state_ctx *job_state_create (flux_t *h)
         goto error;
     zhashx_set_destructor (jsctx->index, job_destroy_wrapper);
 
-    if (!(jsctx->pending = zlistx_new ()))
+    if (!(jsctx->pending = skiplist_create (job_priority_cmp)))
         goto error;
-    zlistx_set_comparator (jsctx->pending, job_priority_cmp);
 
-    if (!(jsctx->running = zlistx_new ()))
+    if (!(jsctx->running = skiplist_create (job_running_cmp)))
         goto error;
-    zlistx_set_comparator (jsctx->running, job_running_cmp);
 
-    if (!(jsctx->inactive = zlistx_new ()))
+    if (!(jsctx->inactive = skiplist_create (job_inactive_cmp)))
         goto error;
-    zlistx_set_comparator (jsctx->inactive, job_inactive_cmp);
+
+    if (!(jsctx->users = job_hash_create ()))
+        goto error;
+    zhashx_set_destructor (jsctx->users, user_jobs_destructor);
 
     if (!(jsctx->processing = zlistx_new ()))
         goto error;
@@ -160,7 +252,15 @@ struct job_state_ctx *job_state_create (flux_t *h)
 
     if (!(jsctx->transitions = zlistx_new ()))
         goto error;
-    zlistx_set_destructor (jsctx->transitions, flux_msg_destroy_wrapper);
+    zlistx_set_destructor (jsctx->transitions, json_decref_wrapper);
+
+    if (!(jsctx->loads = zlistx_new ()))
+        goto error;
+    zlistx_set_destructor (jsctx->loads, job_load_destructor);
+
+    if (!(jsctx->deferred = zlistx_new ()))
+        goto error;
+    zlistx_set_destructor (jsctx->deferred, flux_msg_destroy_wrapper);
 
     if (flux_event_subscribe (h, "job-state") < 0) {
         flux_log_error (h, "flux_event_subscribe");
@@ -185,6 +285,7 @@ void job_state_destroy (void *data)
 {
     struct job_state_ctx *jsctx = data;
     if (jsctx) {
+        flux_future_destroy (jsctx->journal);
         /* Don't destroy processing until futures are complete */
         if (jsctx->futures) {
             flux_future_t *f;
@@ -198,16 +299,21 @@ void job_state_destroy (void *data)
             }
             zlistx_destroy (&jsctx->futures);
         }
+        if (jsctx->loads)
+            zlistx_destroy (&jsctx->loads);
+        if (jsctx->deferred)
+            zlistx_destroy (&jsctx->deferred);
+        free (jsctx->load_ids);
         /* Destroy index last, as it is the one that will actually
          * destroy the job objects */
         if (jsctx->processing)
             zlistx_destroy (&jsctx->processing);
-        if (jsctx->inactive)
-            zlistx_destroy (&jsctx->inactive);
-        if (jsctx->running)
-            zlistx_destroy (&jsctx->running);
-        if (jsctx->pending)
-            zlistx_destroy (&jsctx->pending);
+        flux_watcher_destroy (jsctx->evict_w);
+        if (jsctx->users)
+            zhashx_destroy (&jsctx->users);
+        skiplist_destroy (jsctx->inactive);
+        skiplist_destroy (jsctx->running);
+        skiplist_destroy (jsctx->pending);
         if (jsctx->index)
             zhashx_destroy (&jsctx->index);
         if (jsctx->transitions)
@@ -217,20 +323,6 @@ void job_state_destroy (void *data)
     }
 }
 
-/* zlistx_insert() and zlistx_reorder() take a 'low_value' parameter
- * which indicates which end of the list to search from.
- * false=search begins at tail (lowest priority, youngest)
- * true=search begins at head (highest priority, oldest)
- * Attempt to minimize search distance based on job priority.
- */
-static bool search_direction (struct job *job)
-{
-    if (job->priority > FLUX_JOB_PRIORITY_DEFAULT)
-        return true;
-    else
-        return false;
-}
-
 static int *state_counter (struct info_ctx *ctx,
                            struct job *job,
                            flux_job_state_t state)
@@ -281,82 +373,243 @@ static void update_job_state (struct info_ctx *ctx,
         (*increment)++;
 }
 
-static void job_insert_list (struct job_state_ctx *jsctx,
-                             struct job *job,
-                             flux_job_state_t newstate)
+/* Return the list among 'pending', 'running', 'inactive' for 'state',
+ * or NULL for FLUX_JOB_NEW (the processing list).
+ */
+static struct skiplist *select_list (flux_job_state_t state,
+                                     struct skiplist *pending,
+                                     struct skiplist *running,
+                                     struct skiplist *inactive)
 {
-    /* Note: comparator is set for running & inactive lists, but the
-     * sort calls are not called on zlistx_add_start() */
-    if (newstate == FLUX_JOB_DEPEND
-        || newstate == FLUX_JOB_SCHED) {
-        if (!(job->list_handle = zlistx_insert (jsctx->pending,
-                                                job,
-                                                search_direction (job))))
-            flux_log_error (jsctx->h, "%s: zlistx_insert",
-                            __FUNCTION__);
+    if (state == FLUX_JOB_NEW)
+        return NULL;
+    else if (state == FLUX_JOB_DEPEND
+             || state == FLUX_JOB_SCHED)
+        return pending;
+    else if (state == FLUX_JOB_RUN
+             || state == FLUX_JOB_CLEANUP)
+        return running;
+    else /* state == FLUX_JOB_INACTIVE */
+        return inactive;
+}
+
+static struct skiplist *get_list (struct job_state_ctx *jsctx,
+                                  flux_job_state_t state)
+{
+    return select_list (state,
+                        jsctx->pending,
+                        jsctx->running,
+                        jsctx->inactive);
+}
+
+static struct skiplist *get_user_list (struct job_state_ctx *jsctx,
+                                       struct job *job,
+                                       flux_job_state_t state)
+{
+    struct user_jobs *uj;
+
+    if (!(uj = job_state_user_jobs (jsctx, job->userid))) {
+        if (!(uj = user_jobs_create (job->userid)))
+            return NULL;
+        if (zhashx_insert (jsctx->users, &uj->key, uj) < 0) {
+            user_jobs_destroy (uj);
+            errno = EEXIST;
+            return NULL;
+        }
     }
-    else if (newstate == FLUX_JOB_RUN
-             || newstate == FLUX_JOB_CLEANUP) {
-        if (!(job->list_handle = zlistx_add_start (jsctx->running,
-                                                   job)))
-            flux_log_error (jsctx->h, "%s: zlistx_add_start",
-                            __FUNCTION__);
+    return select_list (state, uj->pending, uj->running, uj->inactive);
+}
+
+static bool evict_needed (struct job_state_ctx *jsctx,
+                          struct job *job,
+                          double now)
+{
+    if (job->t_inactive <= jsctx->evicted_t_inactive)
+        return true;
+    if (jsctx->inactive_limit > 0
+        && skiplist_size (jsctx->inactive) > jsctx->inactive_limit)
+        return true;
+    if (jsctx->inactive_age_limit > 0.
+        && now - job->t_inactive > jsctx->inactive_age_limit)
+        return true;
+    return false;
+}
+
+/* Remove 'job' from the inactive lists and destroy it.
+ */
+static void job_evict (struct job_state_ctx *jsctx, struct job *job)
+{
+    struct user_jobs *uj = job_state_user_jobs (jsctx, job->userid);
+
+    skiplist_delete (jsctx->inactive, job->list_handle);
+    if (uj && job->user_handle)
+        skiplist_delete (uj->inactive, job->user_handle);
+    if (job->t_inactive > jsctx->evicted_t_inactive)
+        jsctx->evicted_t_inactive = job->t_inactive;
+    jsctx->evicted_count++;
+    zhashx_delete (jsctx->index, &job->id);
+}
+
+/* Evict the oldest inactive jobs until the retention limits are met.
+ * Jobs are evicted from a timer callback rather than on transition to
+ * INACTIVE, so no job is destroyed while its state is being processed.
+ */
+static void evict_cb (flux_reactor_t *r,
+                      flux_watcher_t *w,
+                      int revents,
+                      void *arg)
+{
+    struct job_state_ctx *jsctx = arg;
+    double now = flux_reactor_now (r);
+    int count = jsctx->evicted_count;
+    struct job *job;
+
+    while ((job = skiplist_last (jsctx->inactive))
+           && evict_needed (jsctx, job, now))
+        job_evict (jsctx, job);
+    if (jsctx->evicted_count > count)
+        flux_log (jsctx->h, LOG_DEBUG, "evicted %d inactive jobs",
+                  jsctx->evicted_count - count);
+}
+
+/* Jobs age with no event to trigger eviction, so if there is an age
+ * limit, check periodically.
+ */
+static double evict_period (struct job_state_ctx *jsctx)
+{
+    if (jsctx->inactive_age_limit > 0.)
+        return jsctx->inactive_age_limit < 60. ? jsctx->inactive_age_limit
+                                               : 60.;
+    return 0.;
+}
+
+int job_state_set_retention (struct job_state_ctx *jsctx,
+                             int limit,
+                             double age_limit)
+{
+
+    if (limit < 0 || age_limit < 0.) {
+        errno = EINVAL;
+        return -1;
     }
-    else { /* newstate == FLUX_JOB_INACTIVE */
-        if (!(job->list_handle = zlistx_add_start (jsctx->inactive,
-                                                   job)))
-            flux_log_error (jsctx->h, "%s: zlistx_add_start",
-                            __FUNCTION__);
+    jsctx->inactive_limit = limit;
+    jsctx->inactive_age_limit = age_limit;
+    flux_watcher_destroy (jsctx->evict_w);
+    jsctx->evict_w = NULL;
+    if (limit == 0 && age_limit == 0.)
+        return 0;
+    if (!(jsctx->evict_w = flux_timer_watcher_create (flux_get_reactor (jsctx->h),
+                                                      0.,
+                                                      evict_period (jsctx),
+                                                      evict_cb,
+                                                      jsctx)))
+        return -1;
+    flux_watcher_start (jsctx->evict_w);
+    return 0;
+}
+
+/* Arrange for evict_cb() to run soon if 'job' should be evicted.
+ */
+static void evict_check (struct job_state_ctx *jsctx, struct job *job)
+{
+    if (jsctx->evict_w
+        && evict_needed (jsctx,
+                         job,
+                         flux_reactor_now (flux_get_reactor (jsctx->h)))) {
+        flux_timer_watcher_reset (jsctx->evict_w, 0., evict_period (jsctx));
+        flux_watcher_start (jsctx->evict_w);
     }
 }
 
+/* "clean" is at or near the end of an inactive job's eventlog,
+ * so scan it in reverse.
+ */
+bool job_state_evicted (struct job_state_ctx *jsctx, const char *eventlog)
+{
+    struct eventlog_iter *iter;
+    const char *name;
+    double timestamp;
+    bool evicted = false;
+    int rc;
+
+    if (jsctx->evicted_count == 0 || !(iter = eventlog_iter_create (eventlog)))
+        return false;
+    while ((rc = eventlog_iter_prev (iter, &timestamp, &name)) != 0) {
+        if (rc > 0 && !strcmp (name, "clean")) {
+            evicted = (timestamp <= jsctx->evicted_t_inactive);
+            break;
+        }
+    }
+    eventlog_iter_destroy (iter);
+    return evicted;
+}
+
+/* N.B. job timestamps and userid must be set before the job is placed
+ * on a sorted list.  They are not changed while it is there.
+ */
+static void job_insert_list (struct job_state_ctx *jsctx,
+                             struct job *job,
+                             flux_job_state_t newstate)
+{
+    struct skiplist *ulist;
+
+    if (!(job->list_handle = skiplist_insert (get_list (jsctx, newstate),
+                                              job)))
+        flux_log_error (jsctx->h, "%s: skiplist_insert", __FUNCTION__);
+    if (!(ulist = get_user_list (jsctx, job, newstate))
+        || !(job->user_handle = skiplist_insert (ulist, job)))
+        flux_log_error (jsctx->h, "%s: user skiplist_insert", __FUNCTION__);
+    if (newstate == FLUX_JOB_INACTIVE)
+        evict_check (jsctx, job);
+}
+
 /* remove job from one list and move it to another based on the
  * newstate */
 static void job_change_list (struct job_state_ctx *jsctx,
                              struct job *job,
-                             zlistx_t *oldlist,
+                             flux_job_state_t oldstate,
                              flux_job_state_t newstate)
 {
-    if (zlistx_detach (oldlist, job->list_handle) < 0)
-        flux_log_error (jsctx->h, "%s: zlistx_detach",
-                        __FUNCTION__);
+    if (oldstate == FLUX_JOB_NEW) {
+        if (zlistx_detach (jsctx->processing, job->list_handle) < 0)
+            flux_log_error (jsctx->h, "%s: zlistx_detach",
+                            __FUNCTION__);
+    }
+    else {
+        struct user_jobs *uj = job_state_user_jobs (jsctx, job->userid);
+
+        skiplist_delete (get_list (jsctx, oldstate), job->list_handle);
+        if (uj && job->user_handle)
+            skiplist_delete (select_list (oldstate,
+                                          uj->pending,
+                                          uj->running,
+                                          uj->inactive),
+                             job->user_handle);
+    }
     job->list_handle = NULL;
+    job->user_handle = NULL;
 
     job_insert_list (jsctx, job, newstate);
 }
 
-static zlistx_t *get_list (struct job_state_ctx *jsctx, flux_job_state_t state)
-{
-    if (state == FLUX_JOB_NEW)
-        return jsctx->processing;
-    else if (state == FLUX_JOB_DEPEND
-             || state == FLUX_JOB_SCHED)
-        return jsctx->pending;
-    else if (state == FLUX_JOB_RUN
-             || state == FLUX_JOB_CLEANUP)
-        return jsctx->running;
-    else /* state == FLUX_JOB_INACTIVE */
-        return jsctx->inactive;
-}
-
 static void update_job_state_and_list (struct info_ctx *ctx,
                                        struct job *job,
                                        flux_job_state_t newstate,
                                        double timestamp)
 {
-    zlistx_t *oldlist, *newlist;
     struct job_state_ctx *jsctx = job->ctx->jsctx;
-
-    oldlist = get_list (jsctx, job->state);
-    newlist = get_list (jsctx, newstate);
+    flux_job_state_t oldstate = job->state;
 
     /* must call before job_change_list(), to ensure timestamps are
      * set before any sorting based on timestamps are done
      */
     update_job_state (ctx, job, newstate, timestamp);
 
-    if (oldlist != newlist)
-        job_change_list (jsctx, job, oldlist, newstate);
+    if (oldstate == FLUX_JOB_NEW
+        || get_list (jsctx, oldstate) != get_list (jsctx, newstate))
+        job_change_list (jsctx, job, oldstate, newstate);
+
+    state_watch_notify (ctx, job, newstate, timestamp);
 }
 
 static void list_id_respond (struct info_ctx *ctx,
@@ -450,37 +703,6 @@ out:
     return rc;
 }
 
-struct res_level {
-    const char *type;
-    int count;
-    json_t *with;
-};
-
-static int parse_res_level (struct info_ctx *ctx,
-                            struct job *job,
-                            json_t *o,
-                            struct res_level *resp)
-{
-    json_error_t error;
-    struct res_level res;
-
-    res.with = NULL;
-    /* For jobspec version 1, expect exactly one array element per level.
-     */
-    if (json_unpack_ex (o, &error, 0,
-                        "[{s:s s:i s?o}]",
-                        "type", &res.type,
-                        "count", &res.count,
-                        "with", &res.with) < 0) {
-        flux_log (ctx->h, LOG_ERR,
-                  "%s: job %ju invalid jobspec: %s",
-                  __FUNCTION__, (uintmax_t)job->id, error.text);
-        return -1;
-    }
-    *resp = res;
-    return 0;
-}
-
 /* Return basename of path if there is a '/' in path.  Otherwise return
  * full path */
 const char *
@@ -498,13 +720,39 @@ parse_job_name (const char *path)
     return path;
 }
 
+/* Set the job name to 'name', or if NULL because the user did not
+ * specify job.name, to arg 0 of the command.
+ */
+static int job_name_set (struct info_ctx *ctx,
+                         struct job *job,
+                         const char *name)
+{
+    json_t *arg0;
+
+    if (name) {
+        job->name = name;
+        return 0;
+    }
+    arg0 = json_array_get (job->jobspec_cmd, 0);
+    if (!arg0 || !json_is_string (arg0)) {
+        flux_log (ctx->h, LOG_ERR,
+                  "%s: job %ju invalid job command",
+                  __FUNCTION__, (uintmax_t)job->id);
+        return -1;
+    }
+    job->name = parse_job_name (json_string_value (arg0));
+    assert (job->name);
+    return 0;
+}
+
 static int jobspec_parse (struct info_ctx *ctx,
                           struct job *job,
                           const char *s)
 {
     json_error_t error;
     json_t *jobspec = NULL;
-    json_t *tasks, *resources, *command, *jobspec_job = NULL;
+    json_t *jobspec_job = NULL;
+    struct jobspec_summary summary;
     int rc = -1;
 
     if (!(jobspec = json_loads (s, 0, &error))) {
@@ -536,125 +784,17 @@ static int jobspec_parse (struct info_ctx *ctx,
         job->jobspec_job = json_incref (jobspec_job);
     }
 
-    if (json_unpack_ex (jobspec, &error, 0,
-                        "{s:o}",
-                        "tasks", &tasks) < 0) {
-        flux_log (ctx->h, LOG_ERR,
-                  "%s: job %ju invalid jobspec: %s",
-                  __FUNCTION__, (uintmax_t)job->id, error.text);
-        goto error;
-    }
-    if (json_unpack_ex (tasks, &error, 0,
-                        "[{s:o}]",
-                        "command", &command) < 0) {
+    if (jobspec_summary_parse (jobspec, &summary, &error) < 0) {
         flux_log (ctx->h, LOG_ERR,
                   "%s: job %ju invalid jobspec: %s",
                   __FUNCTION__, (uintmax_t)job->id, error.text);
         goto error;
     }
 
-    if (!json_is_array (command)) {
-        flux_log (ctx->h, LOG_ERR,
-                  "%s: job %ju invalid jobspec",
-                  __FUNCTION__, (uintmax_t)job->id);
+    job->jobspec_cmd = json_incref (summary.command);
+    job->ntasks = summary.task_count;
+    if (job_name_set (ctx, job, summary.name) < 0)
         goto error;
-    }
-
-    job->jobspec_cmd = json_incref (command);
-
-    if (job->jobspec_job) {
-        if (json_unpack_ex (job->jobspec_job, &error, 0,
-                            "{s?:s}",
-                            "name", &job->name) < 0) {
-            flux_log (ctx->h, LOG_ERR,
-                      "%s: job %ju invalid job dictionary: %s",
-                      __FUNCTION__, (uintmax_t)job->id, error.text);
-            goto error;
-        }
-    }
-
-    /* If user did not specify job.name, we treat arg 0 of the command
-     * as the job name */
-    if (!job->name) {
-        json_t *arg0 = json_array_get (job->jobspec_cmd, 0);
-        if (!arg0 || !json_is_string (arg0)) {
-            flux_log (ctx->h, LOG_ERR,
-                      "%s: job %ju invalid job command",
-                      __FUNCTION__, (uintmax_t)job->id);
-            goto error;
-        }
-        job->name = parse_job_name (json_string_value (arg0));
-        assert (job->name);
-    }
-
-    if (json_unpack_ex (jobspec, &error, 0,
-                        "{s:o}",
-                        "resources", &resources) < 0) {
-        flux_log (ctx->h, LOG_ERR,
-                  "%s: job %ju invalid jobspec: %s",
-                  __FUNCTION__, (uintmax_t)job->id, error.text);
-        goto error;
-    }
-
-    /* Set job->ntasks
-     */
-    if (json_unpack_ex (tasks, NULL, 0,
-                        "[{s:{s:i}}]",
-                        "count", "total", &job->ntasks) < 0) {
-        int per_slot, slot_count = 0;
-        struct res_level res[3];
-
-        if (json_unpack_ex (tasks, NULL, 0,
-                            "[{s:{s:i}}]",
-                            "count", "per_slot", &per_slot) < 0) {
-            flux_log (ctx->h, LOG_ERR,
-                      "%s: job %ju invalid jobspec: %s",
-                      __FUNCTION__, (uintmax_t)job->id, error.text);
-            goto error;
-        }
-        if (per_slot != 1) {
-            flux_log (ctx->h, LOG_ERR,
-                      "%s: job %ju: per_slot count: expected 1 got %d: %s",
-                      __FUNCTION__, (uintmax_t)job->id, per_slot,
-                      error.text);
-            goto error;
-        }
-        /* For jobspec version 1, expect either:
-         * - node->slot->core->NIL
-         * - slot->core->NIL
-         * Set job->slot_count and job->cores_per_slot.
-         */
-        memset (res, 0, sizeof (res));
-        if (parse_res_level (ctx, job, resources, &res[0]) < 0)
-            goto error;
-        if (res[0].with && parse_res_level (ctx, job, res[0].with, &res[1]) < 0)
-            goto error;
-        if (res[1].with && parse_res_level (ctx, job, res[1].with, &res[2]) < 0)
-            goto error;
-        if (res[0].type != NULL && !strcmp (res[0].type, "slot")
-            && res[1].type != NULL && !strcmp (res[1].type, "core")
-            && res[1].with == NULL) {
-            slot_count = res[0].count;
-        }
-        else if (res[0].type != NULL && !strcmp (res[0].type, "node")
-                 && res[1].type != NULL && !strcmp (res[1].type, "slot")
-                 && res[2].type != NULL && !strcmp (res[2].type, "core")
-                 && res[2].with == NULL) {
-            slot_count = res[0].count * res[1].count;
-        }
-        else {
-            flux_log (ctx->h, LOG_ERR,
-                      "%s: job %ju: Unexpected resources: %s->%s->%s%s",
-                      __FUNCTION__,
-                      (uintmax_t)job->id,
-                      res[0].type ? res[0].type : "NULL",
-                      res[1].type ? res[1].type : "NULL",
-                      res[2].type ? res[2].type : "NULL",
-                      res[2].with ? "->..." : NULL);
-            goto error;
-        }
-        job->ntasks = slot_count;
-    }
 
     rc = 0;
 error:
@@ -662,6 +802,50 @@ error:
     return rc;
 }
 
+/* Apply DEPEND transition data from the job-manager journal:
+ *   {"userid":i, "priority":i, "flags":i,
+ *    "jobspec":{"ntasks":i, "command":o, "job"?:o}}
+ * Return 1 if applied, or 0 if the data is incomplete, so the job must be
+ * looked up in the KVS.
+ */
+static int state_depend_data (struct info_ctx *ctx,
+                              struct job *job,
+                              json_t *data)
+{
+    uint32_t userid;
+    int priority;
+    int flags;
+    int ntasks;
+    json_t *command;
+    json_t *jobspec_job = NULL;
+    const char *name = NULL;
+
+    if (json_unpack (data,
+                     "{s:i s:i s:i s:{s:i s:o s?:o}}",
+                     "userid", &userid,
+                     "priority", &priority,
+                     "flags", &flags,
+                     "jobspec",
+                       "ntasks", &ntasks,
+                       "command", &command,
+                       "job", &jobspec_job) < 0
+        || (jobspec_job && !json_is_object (jobspec_job)))
+        return 0;
+    job->userid = userid;
+    job->priority = priority;
+    job->flags = flags;
+    job->ntasks = ntasks;
+    json_decref (job->jobspec_cmd);
+    job->jobspec_cmd = json_incref (command);
+    json_decref (job->jobspec_job);
+    job->jobspec_job = json_incref (jobspec_job);
+    if (jobspec_job)
+        (void)json_unpack (jobspec_job, "{s?:s}", "name", &name);
+    if (job_name_set (ctx, job, name) < 0)
+        return -1;
+    return 1;
+}
+
 static void state_depend_lookup_continuation (flux_future_t *f, void *arg)
 {
     struct job *job = arg;
@@ -833,6 +1017,23 @@ error:
     return rc;
 }
 
+/* Apply RUN transition data from the job-manager journal:  {"R"?:s}.
+ * Return 1 if applied, 0 if R must be looked up in the KVS, or -1 if
+ * R is invalid.
+ */
+static int state_run_data (struct info_ctx *ctx,
+                           struct job *job,
+                           json_t *data)
+{
+    const char *s;
+
+    if (json_unpack (data, "{s:s}", "R", &s) < 0)
+        return 0;
+    if (R_lookup_parse (ctx, job, s) < 0)
+        return -1;
+    return 1;
+}
+
 static void state_run_lookup_continuation (flux_future_t *f, void *arg)
 {
     struct job *job = arg;
@@ -985,6 +1186,52 @@ static int eventlog_inactive_finish (struct info_ctx *ctx,
     return 0;
 }
 
+/* Apply INACTIVE transition data from the job-manager journal:
+ *   {"success":b, "exception"?:o}
+ * where "exception" is the context of the most severe exception.
+ * Return 1 if applied, 0 if the eventlog must be looked up in the KVS,
+ * or -1 if the exception is invalid.
+ */
+static int state_inactive_data (struct info_ctx *ctx,
+                                struct job *job,
+                                json_t *data)
+{
+    int success;
+    json_t *context = NULL;
+
+    if (json_unpack (data,
+                     "{s:b s?:o}",
+                     "success", &success,
+                     "exception", &context) < 0)
+        return 0;
+    job->success = success ? true : false;
+    if (context) {
+        const char *type;
+        int severity;
+        const char *note = NULL;
+
+        if (json_unpack (context,
+                         "{s:s s:i s?:s}",
+                         "type", &type,
+                         "severity", &severity,
+                         "note", &note) < 0) {
+            flux_log (ctx->h, LOG_ERR,
+                      "%s: job %ju parse exception",
+                      __FUNCTION__, (uintmax_t)job->id);
+            return -1;
+        }
+        job->exception_occurred = true;
+        job->exception_severity = severity;
+        job->exception_type = type;
+        job->exception_note = note;
+        json_decref (job->exception_context);
+        job->exception_context = json_incref (context);
+    }
+    if (eventlog_inactive_finish (ctx, job) < 0)
+        return -1;
+    return 1;
+}
+
 static void state_inactive_lookup_continuation (flux_future_t *f, void *arg)
 {
     struct job *job = arg;
@@ -1047,13 +1294,16 @@ static flux_future_t *state_inactive_lookup (struct job_state_ctx *jsctx,
 static void state_transition_destroy (void *data)
 {
     struct state_transition *st = data;
-    if (st)
+    if (st) {
+        json_decref (st->data);
         free (st);
+    }
 }
 
 static int add_state_transition (struct job *job,
                                  flux_job_state_t newstate,
-                                 double timestamp)
+                                 double timestamp,
+                                 json_t *data)
 {
     struct state_transition *st = NULL;
     int saved_errno;
@@ -1063,6 +1313,7 @@ static int add_state_transition (struct job *job,
     st->state = newstate;
     st->processed = false;
     st->timestamp = timestamp;
+    st->data = json_incref (data);
 
     if (zlist_append (job->next_states, st) < 0) {
         errno = ENOMEM;
@@ -1079,6 +1330,25 @@ static int add_state_transition (struct job *job,
     return -1;
 }
 
+/* Apply job data carried by transition 'st' from the job-manager journal.
+ * Return 1 if applied, 0 if the data must be looked up in the KVS instead,
+ * or -1 if it is invalid.
+ */
+static int state_data_apply (struct info_ctx *ctx,
+                             struct job *job,
+                             struct state_transition *st)
+{
+    if (!st->data)
+        return 0;
+    if (st->state == FLUX_JOB_DEPEND)
+        return state_depend_data (ctx, job, st->data);
+    if (st->state == FLUX_JOB_RUN)
+        return state_run_data (ctx, job, st->data);
+    if (st->state == FLUX_JOB_INACTIVE)
+        return state_inactive_data (ctx, job, st->data);
+    return 0;
+}
+
 static void process_next_state (struct info_ctx *ctx, struct job *job)
 {
     struct state_transition *st;
@@ -1090,6 +1360,19 @@ static void process_next_state (struct info_ctx *ctx, struct job *job)
             || st->state == FLUX_JOB_RUN
             || st->state == FLUX_JOB_INACTIVE) {
             flux_future_t *f = NULL;
+            int rc;
+
+            if ((rc = state_data_apply (ctx, job, st)) < 0) {
+                st->processed = true;
+                return;
+            }
+            if (rc > 0) {
+                update_job_state_and_list (ctx, job, st->state, st->timestamp);
+                if (st->state == FLUX_JOB_DEPEND)
+                    check_waiting_id (ctx, job);
+                zlist_remove (job->next_states, st);
+                continue;
+            }
 
             if (st->state == FLUX_JOB_DEPEND) {
                 /* get initial job information, such as userid,
@@ -1121,6 +1404,7 @@ static void process_next_state (struct info_ctx *ctx, struct job *job)
                 return;
             }
 
+            jsctx->state_lookups++;
             st->processed = true;
             break;
         }
@@ -1133,8 +1417,12 @@ static void process_next_state (struct info_ctx *ctx, struct job *job)
     }
 }
 
+/* Parse [id, state, timestamp, data?], where 'data' is optional job data
+ * from the job-manager journal.
+ */
 static int parse_transition (json_t *transition, flux_jobid_t *id,
-                             flux_job_state_t *state, double *timestamp)
+                             flux_job_state_t *state, double *timestamp,
+                             json_t **data)
 {
     json_t *o;
 
@@ -1159,9 +1447,25 @@ static int parse_transition (json_t *transition, flux_jobid_t *id,
         return -1;
 
     (*timestamp) = json_real_value (o);
+
+    if ((o = json_array_get (transition, 3))
+        && !json_is_object (o))
+        return -1;
+
+    (*data) = o;
     return 0;
 }
 
+/* Return the last state 'job' has reached or will reach once the
+ * transitions already queued have been processed.
+ */
+static flux_job_state_t last_state (struct job *job)
+{
+    struct state_transition *st = zlist_tail (job->next_states);
+
+    return st ? st->state : job->state;
+}
+
 static void update_jobs (struct info_ctx *ctx, json_t *transitions)
 {
     struct job_state_ctx *jsctx = ctx->jsctx;
@@ -1178,13 +1482,28 @@ static void update_jobs (struct info_ctx *ctx, json_t *transitions)
         flux_jobid_t id;
         flux_job_state_t state;
         double timestamp;
+        json_t *data;
 
-        if (parse_transition (value, &id, &state, &timestamp) < 0) {
+        if (parse_transition (value, &id, &state, &timestamp, &data) < 0) {
             flux_log (jsctx->h, LOG_ERR, "%s: transition EPROTO", __FUNCTION__);
             return;
         }
 
-        if (!(job = zhashx_lookup (jsctx->index, &id))) {
+        /* A transition may be received in both a job-state event and the
+         * job-manager journal.  States only advance, so ignore one that
+         * the job has already reached, or that belongs to a job that has
+         * since been evicted.
+         */
+        if ((job = zhashx_lookup (jsctx->index, &id))) {
+            if (state <= last_state (job))
+                continue;
+        }
+        else if (state != FLUX_JOB_DEPEND
+                 && jsctx->evicted_count > 0
+                 && timestamp <= jsctx->evicted_t_inactive)
+            continue;
+
+        if (!job) {
             if (!(job = job_create (ctx, id))){
                 flux_log_error (jsctx->h, "%s: job_create", __FUNCTION__);
                 return;
@@ -1201,7 +1520,7 @@ static void update_jobs (struct info_ctx *ctx, json_t *transitions)
             }
         }
 
-        if (add_state_transition (job, state, timestamp) < 0) {
+        if (add_state_transition (job, state, timestamp, data) < 0) {
             flux_log_error (jsctx->h, "%s: add_state_transition",
                             __FUNCTION__);
             return;
@@ -1212,36 +1531,86 @@ static void update_jobs (struct info_ctx *ctx, json_t *transitions)
 
 }
 
+/* Process 'transitions', or hold them for later if paused.
+ */
+static void job_state_transitions (struct info_ctx *ctx, json_t *transitions)
+{
+    if (ctx->jsctx->pause) {
+        if (!zlistx_add_end (ctx->jsctx->transitions,
+                             json_incref (transitions))) {
+            flux_log_error (ctx->h, "%s: zlistx_add_end", __FUNCTION__);
+            json_decref (transitions);
+        }
+    }
+    else
+        update_jobs (ctx, transitions);
+}
+
+static void journal_continuation (flux_future_t *f, void *arg)
+{
+    struct info_ctx *ctx = arg;
+    json_t *transitions;
+
+    if (flux_rpc_get_unpack (f, "{s:o}", "transitions", &transitions) < 0) {
+        /* ENODATA if the job-manager unloaded, ENOSYS if it isn't loaded.
+         * The journal is restarted by the next job-state event.
+         */
+        if (errno != ENODATA && errno != ENOSYS)
+            flux_log_error (ctx->h, "%s: job-manager.journal", __FUNCTION__);
+        flux_future_destroy (f);
+        ctx->jsctx->journal = NULL;
+        return;
+    }
+    job_state_transitions (ctx, transitions);
+    flux_future_reset (f);
+}
+
+/* Start the job-manager journal if it isn't running.  Only on rank 0,
+ * where the job-manager runs, so each journal response arrives just ahead
+ * of the job-state event for the same transitions, which it makes
+ * redundant.  Elsewhere, job state is followed with events only.
+ */
+static void journal_start (struct info_ctx *ctx)
+{
+    struct job_state_ctx *jsctx = ctx->jsctx;
+    flux_future_t *f;
+    uint32_t rank;
+
+    if (jsctx->journal || jsctx->loading)
+        return;
+    if (flux_get_rank (ctx->h, &rank) < 0 || rank != 0)
+        return;
+    if (!(f = flux_rpc (ctx->h,
+                        "job-manager.journal",
+                        NULL,
+                        FLUX_NODEID_ANY,
+                        FLUX_RPC_STREAMING))
+        || flux_future_then (f, -1, journal_continuation, ctx) < 0) {
+        flux_log_error (ctx->h, "%s: job-manager.journal", __FUNCTION__);
+        flux_future_destroy (f);
+        return;
+    }
+    jsctx->journal = f;
+}
+
 void job_state_cb (flux_t *h, flux_msg_handler_t *mh,
                    const flux_msg_t *msg, void *arg)
 {
     struct info_ctx *ctx = arg;
     json_t *transitions;
 
-    if (ctx->jsctx->pause) {
-        flux_msg_t *cpy;
+    if (job_state_defer (ctx->jsctx, msg))
+        return;
 
-        if (!(cpy = flux_msg_copy (msg, true))) {
-            flux_log_error (h, "%s: flux_msg_copy", __FUNCTION__);
-            return;
-        }
-        if (!zlistx_add_end (ctx->jsctx->transitions, cpy)) {
-            flux_log_error (h, "%s: zlistx_add_end", __FUNCTION__);
-            flux_msg_destroy (cpy);
-        }
-    }
-    else {
-        if (flux_event_unpack (msg, NULL, "{s:o}",
-                               "transitions",
-                               &transitions) < 0) {
-            flux_log_error (h, "%s: flux_event_unpack", __FUNCTION__);
-            return;
-        }
+    journal_start (ctx);
 
-        update_jobs (ctx, transitions);
+    if (flux_event_unpack (msg, NULL, "{s:o}",
+                           "transitions",
+                           &transitions) < 0) {
+        flux_log_error (h, "%s: flux_event_unpack", __FUNCTION__);
+        return;
     }
-
-    return;
+    job_state_transitions (ctx, transitions);
 }
 
 static int parse_annotation (json_t *annotation, flux_jobid_t *id, json_t **aValue)
@@ -1301,20 +1670,91 @@ static void update_annotations (struct info_ctx *ctx, json_t *annotations)
 
 }
 
+/* Apply [id, {key:value|null, ...}] deltas, which replace or remove only
+ * the listed top level annotation keys.
+ */
+static void update_annotation_deltas (struct info_ctx *ctx, json_t *deltas)
+{
+    struct job_state_ctx *jsctx = ctx->jsctx;
+    size_t index;
+    json_t *value;
+
+    if (!json_is_array (deltas)) {
+        flux_log (ctx->h, LOG_ERR, "annotation deltas are not an array");
+        return;
+    }
+
+    json_array_foreach (deltas, index, value) {
+        struct job *job;
+        flux_jobid_t id;
+        json_t *aValue;
+        const char *key;
+        json_t *v;
+
+        if (parse_annotation (value, &id, &aValue) < 0
+            || !json_is_object (aValue)) {
+            flux_log (jsctx->h, LOG_ERR, "%s: annotation parse error",
+                      __FUNCTION__);
+            return;
+        }
+
+        if (!(job = zhashx_lookup (jsctx->index, &id))) {
+            flux_log_error (jsctx->h, "%s: job %ju not found",
+                            __FUNCTION__, (uintmax_t)id);
+            continue;
+        }
+        /* Annotations may be shared with the event they came from, so
+         * update a copy.
+         */
+        if (job->annotations) {
+            json_t *cpy = json_copy (job->annotations);
+            json_decref (job->annotations);
+            job->annotations = cpy;
+        }
+        else
+            job->annotations = json_object ();
+        if (!job->annotations) {
+            flux_log (jsctx->h, LOG_ERR, "%s: out of memory", __FUNCTION__);
+            return;
+        }
+        json_object_foreach (aValue, key, v) {
+            if (json_is_null (v))
+                (void)json_object_del (job->annotations, key);
+            else if (json_object_set (job->annotations, key, v) < 0) {
+                flux_log (jsctx->h, LOG_ERR, "%s: out of memory",
+                          __FUNCTION__);
+                return;
+            }
+        }
+        if (json_object_size (job->annotations) == 0) {
+            json_decref (job->annotations);
+            job->annotations = NULL;
+        }
+    }
+}
+
 void job_annotations_cb (flux_t *h, flux_msg_handler_t *mh,
                          const flux_msg_t *msg, void *arg)
 {
     struct info_ctx *ctx = arg;
     json_t *annotations;
+    json_t *deltas = NULL;
 
-    if (flux_event_unpack (msg, NULL, "{s:o}",
+    if (job_state_defer (ctx->jsctx, msg))
+        return;
+
+    if (flux_event_unpack (msg, NULL, "{s:o s?o}",
                            "annotations",
-                           &annotations) < 0) {
+                           &annotations,
+                           "deltas",
+                           &deltas) < 0) {
         flux_log_error (h, "%s: flux_event_unpack", __FUNCTION__);
         return;
     }
 
     update_annotations (ctx, annotations);
+    if (deltas)
+        update_annotation_deltas (ctx, deltas);
 
     return;
 }
@@ -1342,14 +1782,14 @@ void job_state_unpause_cb (flux_t *h, flux_msg_handler_t *mh,
                            const flux_msg_t *msg, void *arg)
 {
     struct info_ctx *ctx = arg;
-    flux_msg_t *tmsg;
+    json_t *transitions;
 
     ctx->jsctx->pause = false;
 
-    tmsg = zlistx_first (ctx->jsctx->transitions);
-    while (tmsg) {
-        job_state_cb (h, mh, tmsg, ctx);
-        tmsg = zlistx_next (ctx->jsctx->transitions);
+    transitions = zlistx_first (ctx->jsctx->transitions);
+    while (transitions) {
+        update_jobs (ctx, transitions);
+        transitions = zlistx_next (ctx->jsctx->transitions);
     }
 
     if (flux_respond (h, msg, NULL) < 0) {
@@ -1495,17 +1935,10 @@ static int depthfirst_count_depth (const char *s)
     return count;
 }
 
-static int depthfirst_map_one (struct info_ctx *ctx, const char *key,
-                               int dirskip)
+static int load_ids_append (struct job_state_ctx *jsctx, const char *key,
+                            int dirskip)
 {
-    struct job *job = NULL;
     flux_jobid_t id;
-    flux_future_t *f1 = NULL;
-    flux_future_t *f2 = NULL;
-    flux_future_t *f3 = NULL;
-    const char *eventlog, *jobspec, *R;
-    char path[64];
-    int rc = -1;
 
     if (strlen (key) <= dirskip) {
         errno = EINVAL;
@@ -1513,66 +1946,18 @@ static int depthfirst_map_one (struct info_ctx *ctx, const char *key,
     }
     if (fluid_decode (key + dirskip + 1, &id, FLUID_STRING_DOTHEX) < 0)
         return -1;
-    if (flux_job_kvs_key (path, sizeof (path), id, "eventlog") < 0) {
-        errno = EINVAL;
-        return -1;
-    }
-    if (!(f1 = flux_kvs_lookup (ctx->h, NULL, 0, path)))
-        goto done;
-    if (flux_kvs_lookup_get (f1, &eventlog) < 0)
-        goto done;
-
-    if (!(job = eventlog_restart_parse (ctx, eventlog, id)))
-        goto done;
-
-    if (flux_job_kvs_key (path, sizeof (path), id, "jobspec") < 0) {
-        errno = EINVAL;
-        goto done;
-    }
-    if (!(f2 = flux_kvs_lookup (ctx->h, NULL, 0, path)))
-        goto done;
-    if (flux_kvs_lookup_get (f2, &jobspec) < 0)
-        goto done;
-
-    if (jobspec_parse (ctx, job, jobspec) < 0)
-        goto done;
+    if (jsctx->load_ids_count == jsctx->load_ids_size) {
+        int size = jsctx->load_ids_size ? jsctx->load_ids_size * 2 : 1024;
+        flux_jobid_t *ids;
 
-    if (job->states_mask & FLUX_JOB_RUN) {
-        if (flux_job_kvs_key (path, sizeof (path), id, "R") < 0) {
-            errno = EINVAL;
+        if (!(ids = realloc (jsctx->load_ids, size * sizeof (ids[0]))))
             return -1;
-        }
-        if (!(f3 = flux_kvs_lookup (ctx->h, NULL, 0, path)))
-            goto done;
-        if (flux_kvs_lookup_get (f3, &R) < 0)
-            goto done;
-
-        if (R_lookup_parse (ctx, job, R) < 0)
-            goto done;
-    }
-
-    if (job->states_mask & FLUX_JOB_INACTIVE) {
-        if (eventlog_inactive_parse (ctx, job, eventlog) < 0)
-            goto done;
-
-        if (eventlog_inactive_finish (ctx, job) < 0)
-            goto done;
+        jsctx->load_ids = ids;
+        jsctx->load_ids_size = size;
     }
-
-    if (zhashx_insert (ctx->jsctx->index, &job->id, job) < 0) {
-        flux_log_error (ctx->h, "%s: zhashx_insert", __FUNCTION__);
-        goto done;
-    }
-    job_insert_list (ctx->jsctx, job, job->state);
-
-    rc = 1;
-done:
-    if (rc < 0)
-        job_destroy (job);
-    flux_future_destroy (f1);
-    flux_future_destroy (f2);
-    flux_future_destroy (f3);
-    return rc;
+    jsctx->load_ids[jsctx->load_ids_count++] = id;
+    jsctx->load_remaining++;
+    return 1;
 }
 
 static int depthfirst_map (struct info_ctx *ctx, const char *key,
@@ -1604,7 +1989,7 @@ static int depthfirst_map (struct info_ctx *ctx, const char *key,
         if (!(nkey = flux_kvsdir_key_at (dir, name)))
             goto done_destroyitr;
         if (path_level == 3) // orig 'key' = .A.B.C, thus 'nkey' is complete
-            n = depthfirst_map_one (ctx, nkey, dirskip);
+            n = load_ids_append (ctx->jsctx, nkey, dirskip);
         else
             n = depthfirst_map (ctx, nkey, dirskip);
         if (n < 0) {
@@ -1624,23 +2009,219 @@ done:
     return rc;
 }
 
-/* Read jobs present in the KVS at startup. */
-int job_state_init_from_kvs (struct info_ctx *ctx)
+static flux_future_t *load_lookup (struct info_ctx *ctx,
+                                   flux_jobid_t id,
+                                   const char *key)
 {
-    const char *dirname = "job";
-    int dirskip = strlen (dirname);
-    int count;
+    char path[64];
+
+    if (flux_job_kvs_key (path, sizeof (path), id, key) < 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+    return flux_kvs_lookup (ctx->h, NULL, 0, path);
+}
+
+/* All jobs have been read.  Requeue the messages deferred meanwhile,
+ * in the order they were received.
+ */
+static void load_complete (struct info_ctx *ctx)
+{
+    struct job_state_ctx *jsctx = ctx->jsctx;
+    flux_msg_t *msg;
+
+    flux_log (ctx->h, LOG_DEBUG, "%s: read %d jobs",
+              __FUNCTION__, jsctx->load_count);
+    jsctx->loading = false;
+    free (jsctx->load_ids);
+    jsctx->load_ids = NULL;
+    jsctx->load_ids_count = jsctx->load_ids_size = jsctx->load_next = 0;
+    msg = zlistx_first (jsctx->deferred);
+    while (msg) {
+        if (flux_requeue (ctx->h, msg, FLUX_RQ_TAIL) < 0)
+            flux_log_error (ctx->h, "%s: flux_requeue", __FUNCTION__);
+        msg = zlistx_next (jsctx->deferred);
+    }
+    zlistx_purge (jsctx->deferred);
+    journal_start (ctx);
+}
+
+static void load_continuation (flux_future_t *f, void *arg);
 
-    count = depthfirst_map (ctx, dirname, dirskip);
-    if (count < 0)
+static int load_start (struct info_ctx *ctx, flux_jobid_t id)
+{
+    struct job_load *jl;
+    flux_future_t *f = NULL;
+
+    if (!(jl = calloc (1, sizeof (*jl))))
         return -1;
-    flux_log (ctx->h, LOG_DEBUG, "%s: read %d jobs", __FUNCTION__, count);
+    jl->ctx = ctx;
+    jl->id = id;
+    if (!(jl->f = flux_future_wait_all_create ()))
+        goto error;
+    flux_future_set_flux (jl->f, ctx->h);
+    if (!(f = load_lookup (ctx, id, "eventlog"))
+        || flux_future_push (jl->f, "eventlog", f) < 0)
+        goto error;
+    if (!(f = load_lookup (ctx, id, "jobspec"))
+        || flux_future_push (jl->f, "jobspec", f) < 0)
+        goto error;
+    f = NULL;
+    if (flux_future_then (jl->f, -1, load_continuation, jl) < 0)
+        goto error;
+    if (!zlistx_add_end (ctx->jsctx->loads, jl)) {
+        errno = ENOMEM;
+        goto error;
+    }
+    return 0;
+error:
+    flux_future_destroy (f);
+    job_load_destroy (jl);
+    return -1;
+}
 
-    zlistx_sort (ctx->jsctx->running);
-    zlistx_sort (ctx->jsctx->inactive);
+/* Keep up to load_max jobs being looked up until all have been read.
+ */
+static int load_continue (struct info_ctx *ctx)
+{
+    struct job_state_ctx *jsctx = ctx->jsctx;
+
+    while (zlistx_size (jsctx->loads) < jsctx->load_max
+           && jsctx->load_next < jsctx->load_ids_count) {
+        if (load_start (ctx, jsctx->load_ids[jsctx->load_next++]) < 0)
+            return -1;
+    }
+    if (zlistx_size (jsctx->loads) == 0)
+        load_complete (ctx);
     return 0;
 }
 
+/* Remove 'jl' from the loads list, destroying it, and look up the next
+ * job.  Any error reading a job fails the module, as it did when jobs
+ * were read synchronously before entering the reactor.
+ */
+static void load_done (struct job_load *jl, int rc)
+{
+    struct info_ctx *ctx = jl->ctx;
+    struct job_state_ctx *jsctx = ctx->jsctx;
+    void *handle;
+
+    if ((handle = zlistx_find (jsctx->loads, jl)))
+        zlistx_delete (jsctx->loads, handle);
+    jsctx->load_remaining--;
+    if (rc < 0 || load_continue (ctx) < 0) {
+        flux_log_error (ctx->h, "error reading jobs from KVS");
+        flux_reactor_stop_error (flux_get_reactor (ctx->h));
+    }
+}
+
+static int load_finish (struct job_load *jl)
+{
+    struct info_ctx *ctx = jl->ctx;
+    struct job *job = jl->job;
+
+    if (job->states_mask & FLUX_JOB_INACTIVE) {
+        const char *eventlog;
+
+        if (flux_kvs_lookup_get (flux_future_get_child (jl->f, "eventlog"),
+                                 &eventlog) < 0
+            || eventlog_inactive_parse (ctx, job, eventlog) < 0
+            || eventlog_inactive_finish (ctx, job) < 0)
+            return -1;
+    }
+    if (zhashx_insert (ctx->jsctx->index, &job->id, job) < 0) {
+        flux_log_error (ctx->h, "%s: zhashx_insert", __FUNCTION__);
+        return -1;
+    }
+    jl->job = NULL;
+    job_insert_list (ctx->jsctx, job, job->state);
+    ctx->jsctx->load_count++;
+    check_waiting_id (ctx, job);
+    return 0;
+}
+
+static void load_R_continuation (flux_future_t *f, void *arg)
+{
+    struct job_load *jl = arg;
+    const char *R;
+    int rc = -1;
+
+    if (flux_kvs_lookup_get (f, &R) < 0) {
+        flux_log_error (jl->ctx->h, "%s: error reading R for %ju",
+                        __FUNCTION__, (uintmax_t)jl->id);
+        goto done;
+    }
+    if (R_lookup_parse (jl->ctx, jl->job, R) < 0)
+        goto done;
+    rc = load_finish (jl);
+done:
+    load_done (jl, rc);
+}
+
+static void load_continuation (flux_future_t *f, void *arg)
+{
+    struct job_load *jl = arg;
+    struct info_ctx *ctx = jl->ctx;
+    const char *eventlog;
+    const char *jobspec;
+    int rc = -1;
+
+    if (flux_kvs_lookup_get (flux_future_get_child (f, "eventlog"),
+                             &eventlog) < 0
+        || flux_kvs_lookup_get (flux_future_get_child (f, "jobspec"),
+                                &jobspec) < 0) {
+        flux_log_error (ctx->h, "%s: error reading job %ju",
+                        __FUNCTION__, (uintmax_t)jl->id);
+        goto done;
+    }
+    if (!(jl->job = eventlog_restart_parse (ctx, eventlog, jl->id))
+        || jobspec_parse (ctx, jl->job, jobspec) < 0)
+        goto done;
+
+    /* R is only present once the job has been allocated resources */
+    if (jl->job->states_mask & FLUX_JOB_RUN) {
+        if (!(jl->f_R = load_lookup (ctx, jl->id, "R"))
+            || flux_future_then (jl->f_R, -1, load_R_continuation, jl) < 0)
+            goto done;
+        return;
+    }
+    rc = load_finish (jl);
+done:
+    load_done (jl, rc);
+}
+
+bool job_state_defer (struct job_state_ctx *jsctx, const flux_msg_t *msg)
+{
+    if (!jsctx->loading)
+        return false;
+    if (!zlistx_add_end (jsctx->deferred, (flux_msg_t *)flux_msg_incref (msg))) {
+        flux_log_error (jsctx->h, "%s: zlistx_add_end", __FUNCTION__);
+        flux_msg_decref (msg);
+        return false;
+    }
+    return true;
+}
+
+/* Find jobs present in the KVS at startup, then begin reading them.
+ * The reads complete once the reactor is running.
+ */
+int job_state_init_from_kvs (struct info_ctx *ctx, int concurrency)
+{
+    struct job_state_ctx *jsctx = ctx->jsctx;
+    const char *dirname = "job";
+    int dirskip = strlen (dirname);
+
+    if (concurrency < 1) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (depthfirst_map (ctx, dirname, dirskip) < 0)
+        return -1;
+    jsctx->load_max = concurrency;
+    jsctx->loading = true;
+    return load_continue (ctx);
+}
+
 /*
  * vi:tabstop=4 shiftwidth=4 expandtab
  */
@@ -14,6 +14,8 @@
 #include <flux/core.h>
 #include <jansson.h>
 
+#include "src/common/libutil/skiplist.h"
+
 #include "info.h"
 
 /* To handle the common case of user queries on job state, we will
@@ -29,18 +31,49 @@
  *   are sorted by job completion time (later completion times
  *   first)
  *
+ * Ties are broken by jobid, so each list has a strict order and a
+ * position in it can be used as a job-info.list cursor.  The lists
+ * are skiplists so that a cursor can be found in O(log n).
+ *
+ * The same three lists are kept per userid in `users`, so a query for
+ * one user's jobs does not walk every job.
+ *
  * There is also an additional list `processing` that stores jobs that
  * cannot yet be stored on one of the lists above.
  *
+ * If a retention limit is set, the oldest inactive jobs beyond it are
+ * evicted from memory.  All jobs with t_inactive at or before
+ * `evicted_t_inactive` have been evicted, and can only be found in
+ * the KVS or the job-archive database.
+ *
  * The list `futures` is used to store in process futures.
+ *
+ * At startup, jobs are read from the KVS with up to `load_max` jobs
+ * being looked up at once.  List queries are answered for the jobs
+ * read so far, but job-state and job-annotations events, and
+ * list-inactive requests, are deferred until all jobs have been read.
+ *
+ * Job state transitions are received in job-state events.  On rank 0,
+ * they are also streamed by the job-manager journal, along with the job
+ * data (jobspec summary, R, result) that would otherwise be looked up in
+ * the KVS, see job-manager/journal.c.  Each transition is processed once,
+ * from whichever source delivers it first.
  */
 
+struct user_jobs {
+    flux_jobid_t key;       // userid, widened for job_hash
+    struct skiplist *pending;
+    struct skiplist *running;
+    struct skiplist *inactive;
+};
+
 struct job_state_ctx {
     flux_t *h;
     zhashx_t *index;
-    zlistx_t *pending;
-    zlistx_t *running;
-    zlistx_t *inactive;
+    struct skiplist *pending;
+    struct skiplist *running;
+    struct skiplist *inactive;
+    zhashx_t *users;
     zlistx_t *processing;
     zlistx_t *futures;
 
@@ -51,10 +84,32 @@ struct job_state_ctx {
     int cleanup_count;
     int inactive_count;
 
+    /* inactive job retention, 0 = unlimited */
+    int inactive_limit;
+    double inactive_age_limit;
+    flux_watcher_t *evict_w;
+    int evicted_count;
+    double evicted_t_inactive;
+
+    /* reading jobs from the KVS at startup */
+    bool loading;
+    int load_max;
+    int load_count;             // jobs read
+    int load_remaining;         // jobs not yet read
+    flux_jobid_t *load_ids;
+    int load_ids_count;
+    int load_ids_size;
+    int load_next;              // index of next id in load_ids to look up
+    zlistx_t *loads;            // jobs being looked up
+    zlistx_t *deferred;         // messages to requeue when loaded
+
     /* debug/testing - if paused store job transitions on list for
      * processing later */
     bool pause;
     zlistx_t *transitions;
+
+    flux_future_t *journal;     // job-manager.journal stream, if running
+    int state_lookups;          // KVS lookups made for state transitions
 };
 
 struct job {
@@ -97,7 +152,8 @@ struct job {
      */
     zlist_t *next_states;
     unsigned int states_mask;
-    void *list_handle;
+    void *list_handle;      // processing zlistx, or a skiplist above
+    void *user_handle;      // skiplist in struct user_jobs
 
     /* timestamp of when we enter the state
      *
@@ -133,7 +189,33 @@ void job_state_pause_cb (flux_t *h, flux_msg_handler_t *mh,
 void job_state_unpause_cb (flux_t *h, flux_msg_handler_t *mh,
                            const flux_msg_t *msg, void *arg);
 
-int job_state_init_from_kvs (struct info_ctx *ctx);
+/* Begin reading jobs present in the KVS.  Jobs are read asynchronously,
+ * with up to 'concurrency' jobs being looked up at once.
+ */
+int job_state_init_from_kvs (struct info_ctx *ctx, int concurrency);
+
+/* If jobs are still being read from the KVS, hold 'msg' to be requeued
+ * once they all have been, and return true.
+ */
+bool job_state_defer (struct job_state_ctx *jsctx, const flux_msg_t *msg);
+
+/* Set limits on the number of inactive jobs kept in memory, and on the
+ * time since they became inactive (seconds).  0 means unlimited.
+ * Call before job_state_init_from_kvs().
+ */
+int job_state_set_retention (struct job_state_ctx *jsctx,
+                             int limit,
+                             double age_limit);
+
+/* Return true if the job with 'eventlog' is not in memory because it
+ * was evicted.
+ */
+bool job_state_evicted (struct job_state_ctx *jsctx, const char *eventlog);
+
+/* Return the lists of jobs owned by 'userid', or NULL if there are none.
+ */
+struct user_jobs *job_state_user_jobs (struct job_state_ctx *jsctx,
+                                       uint32_t userid);
 
 #endif /* ! _FLUX_JOB_INFO_JOB_STATE_H */
 
@@ -35,152 +35,303 @@ void seterror (job_info_error_t *errp, const char *fmt, ...)
     }
 }
 
-/* For a given job, create a JSON object containing the jobid and any
- * additional requested attributes and their values.  Returns JSON
- * object which the caller must free.  On error, return NULL with
- * errno set:
- *
- * EPROTO - malformed attrs array
- * ENOMEM - out of memory
+/* All attributes that may be requested, in the order reported by
+ * job-info.list-attrs.  "t_depend" is an alias for "t_submit".
  */
-json_t *job_to_json (struct job *job, json_t *attrs, job_info_error_t *errp)
+enum job_attr_id {
+    ATTR_USERID,
+    ATTR_PRIORITY,
+    ATTR_T_SUBMIT,
+    ATTR_T_SCHED,
+    ATTR_T_RUN,
+    ATTR_T_CLEANUP,
+    ATTR_T_INACTIVE,
+    ATTR_STATE,
+    ATTR_NAME,
+    ATTR_NTASKS,
+    ATTR_NNODES,
+    ATTR_RANKS,
+    ATTR_SUCCESS,
+    ATTR_EXCEPTION_OCCURRED,
+    ATTR_EXCEPTION_TYPE,
+    ATTR_EXCEPTION_SEVERITY,
+    ATTR_EXCEPTION_NOTE,
+    ATTR_RESULT,
+    ATTR_EXPIRATION,
+    ATTR_ANNOTATIONS,
+};
+
+struct job_attr {
+    const char *name;
+    enum job_attr_id id;
+};
+
+static const struct job_attr attr_table[] = {
+    { "userid", ATTR_USERID },
+    { "priority", ATTR_PRIORITY },
+    { "t_submit", ATTR_T_SUBMIT },
+    { "t_depend", ATTR_T_SUBMIT },
+    { "t_sched", ATTR_T_SCHED },
+    { "t_run", ATTR_T_RUN },
+    { "t_cleanup", ATTR_T_CLEANUP },
+    { "t_inactive", ATTR_T_INACTIVE },
+    { "state", ATTR_STATE },
+    { "name", ATTR_NAME },
+    { "ntasks", ATTR_NTASKS },
+    { "nnodes", ATTR_NNODES },
+    { "ranks", ATTR_RANKS },
+    { "success", ATTR_SUCCESS },
+    { "exception_occurred", ATTR_EXCEPTION_OCCURRED },
+    { "exception_type", ATTR_EXCEPTION_TYPE },
+    { "exception_severity", ATTR_EXCEPTION_SEVERITY },
+    { "exception_note", ATTR_EXCEPTION_NOTE },
+    { "result", ATTR_RESULT },
+    { "expiration", ATTR_EXPIRATION },
+    { "annotations", ATTR_ANNOTATIONS },
+};
+#define ATTR_TABLE_SIZE (sizeof (attr_table) / sizeof (attr_table[0]))
+
+struct job_attrs {
+    size_t count;
+    const struct job_attr *attr[];
+};
+
+void job_attrs_destroy (struct job_attrs *ja)
 {
+    if (ja) {
+        int saved_errno = errno;
+        free (ja);
+        errno = saved_errno;
+    }
+}
+
+static const struct job_attr *attr_lookup (const char *name)
+{
+    int i;
+
+    for (i = 0; i < ATTR_TABLE_SIZE; i++) {
+        if (!strcmp (attr_table[i].name, name))
+            return &attr_table[i];
+    }
+    return NULL;
+}
+
+struct job_attrs *job_attrs_create (json_t *attrs, job_info_error_t *errp)
+{
+    struct job_attrs *ja;
     size_t index;
     json_t *value;
-    json_t *o;
-    json_t *val = NULL;
-
-    memset (errp, 0, sizeof (*errp));
 
-    if (!(o = json_object ()))
-        goto error_nomem;
-    if (!(val = json_integer (job->id)))
-        goto error_nomem;
-    if (json_object_set_new (o, "id", val) < 0) {
-        json_decref (val);
-        goto error_nomem;
+    if (!(ja = calloc (1, sizeof (*ja)
+                          + json_array_size (attrs) * sizeof (ja->attr[0])))) {
+        errno = ENOMEM;
+        return NULL;
     }
     json_array_foreach (attrs, index, value) {
-        const char *attr = json_string_value (value);
-        if (!attr) {
+        const char *name = json_string_value (value);
+        const struct job_attr *attr;
+
+        if (!name) {
             seterror (errp, "attr has no string value");
-            errno = EINVAL;
-            goto error;
+            goto inval;
         }
-        if (!strcmp (attr, "userid")) {
-            val = json_integer (job->userid);
+        if (!(attr = attr_lookup (name))) {
+            seterror (errp, "%s is not a valid attribute", name);
+            goto inval;
         }
-        else if (!strcmp (attr, "priority")) {
-            val = json_integer (job->priority);
+        ja->attr[ja->count++] = attr;
+    }
+    return ja;
+inval:
+    job_attrs_destroy (ja);
+    errno = EINVAL;
+    return NULL;
+}
+
+json_t *job_attrs_list (void)
+{
+    json_t *a;
+    int i;
+
+    if (!(a = json_array ()))
+        goto nomem;
+    for (i = 0; i < ATTR_TABLE_SIZE; i++) {
+        json_t *o;
+        if (!(o = json_string (attr_table[i].name))
+            || json_array_append_new (a, o) < 0) {
+            json_decref (o);
+            goto nomem;
         }
-        else if (!strcmp (attr, "t_submit")
-                 || !strcmp (attr, "t_depend")) {
+    }
+    return a;
+nomem:
+    json_decref (a);
+    errno = ENOMEM;
+    return NULL;
+}
+
+/* Return the value of 'attr' for 'job', or NULL with errno = 0 if the
+ * job has no value for it yet, or errno = ENOMEM on failure.
+ */
+static json_t *attr_value (struct job *job, const struct job_attr *attr)
+{
+    json_t *val = NULL;
+
+    errno = 0;
+    switch (attr->id) {
+        case ATTR_USERID:
+            val = json_integer (job->userid);
+            break;
+        case ATTR_PRIORITY:
+            val = json_integer (job->priority);
+            break;
+        case ATTR_T_SUBMIT:
             if (!(job->states_mask & FLUX_JOB_DEPEND))
-                continue;
+                return NULL;
             val = json_real (job->t_submit);
-        }
-        else if (!strcmp (attr, "t_sched")) {
+            break;
+        case ATTR_T_SCHED:
             if (!(job->states_mask & FLUX_JOB_SCHED))
-                continue;
+                return NULL;
             val = json_real (job->t_sched);
-        }
-        else if (!strcmp (attr, "t_run")) {
+            break;
+        case ATTR_T_RUN:
             if (!(job->states_mask & FLUX_JOB_RUN))
-                continue;
+                return NULL;
             val = json_real (job->t_run);
-        }
-        else if (!strcmp (attr, "t_cleanup")) {
+            break;
+        case ATTR_T_CLEANUP:
             if (!(job->states_mask & FLUX_JOB_CLEANUP))
-                continue;
+                return NULL;
             val = json_real (job->t_cleanup);
-        }
-        else if (!strcmp (attr, "t_inactive")) {
+            break;
+        case ATTR_T_INACTIVE:
             if (!(job->states_mask & FLUX_JOB_INACTIVE))
-                continue;
+                return NULL;
             val = json_real (job->t_inactive);
-        }
-        else if (!strcmp (attr, "state")) {
+            break;
+        case ATTR_STATE:
             val = json_integer (job->state);
-        }
-        else if (!strcmp (attr, "name")) {
+            break;
+        case ATTR_NAME:
             val = json_string (job->name);
-        }
-        else if (!strcmp (attr, "ntasks")) {
+            break;
+        case ATTR_NTASKS:
             val = json_integer (job->ntasks);
-        }
-        else if (!strcmp (attr, "nnodes")) {
+            break;
+        case ATTR_NNODES:
             if (!(job->states_mask & FLUX_JOB_RUN))
-                continue;
+                return NULL;
             val = json_integer (job->nnodes);
-        }
-        else if (!strcmp (attr, "ranks")) {
+            break;
+        case ATTR_RANKS:
             if (!(job->states_mask & FLUX_JOB_RUN))
-                continue;
+                return NULL;
             val = json_string (job->ranks);
-        }
-        else if (!strcmp (attr, "expiration")) {
+            break;
+        case ATTR_EXPIRATION:
             if (!(job->states_mask & FLUX_JOB_RUN))
-                continue;
+                return NULL;
             val = json_real (job->expiration);
-        }
-        else if (!strcmp (attr, "success")) {
+            break;
+        case ATTR_SUCCESS:
             if (!(job->states_mask & FLUX_JOB_INACTIVE))
-                continue;
+                return NULL;
             val = json_boolean (job->success);
-        }
-        else if (!strcmp (attr, "exception_occurred")) {
+            break;
+        case ATTR_EXCEPTION_OCCURRED:
             if (!(job->states_mask & FLUX_JOB_INACTIVE))
-                continue;
+                return NULL;
             val = json_boolean (job->exception_occurred);
-        }
-        else if (!strcmp (attr, "exception_severity")) {
+            break;
+        case ATTR_EXCEPTION_SEVERITY:
             if (!(job->states_mask & FLUX_JOB_INACTIVE)
                 || !job->exception_occurred)
-                continue;
+                return NULL;
             val = json_integer (job->exception_severity);
-        }
-        else if (!strcmp (attr, "exception_type")) {
+            break;
+        case ATTR_EXCEPTION_TYPE:
             if (!(job->states_mask & FLUX_JOB_INACTIVE)
                 || !job->exception_occurred)
-                continue;
+                return NULL;
             val = json_string (job->exception_type);
-        }
-        else if (!strcmp (attr, "exception_note")) {
+            break;
+        case ATTR_EXCEPTION_NOTE:
             if (!(job->states_mask & FLUX_JOB_INACTIVE)
                 || !job->exception_occurred)
-                continue;
+                return NULL;
             val = json_string (job->exception_note);
-        }
-        else if (!strcmp (attr, "result")) {
+            break;
+        case ATTR_RESULT:
             if (!(job->states_mask & FLUX_JOB_INACTIVE))
-                continue;
+                return NULL;
             val = json_integer (job->result);
-        }
-        else if (!strcmp (attr, "annotations")) {
+            break;
+        case ATTR_ANNOTATIONS:
             if (!job->annotations)
+                return NULL;
+            return json_incref (job->annotations);
+    }
+    if (!val)
+        errno = ENOMEM;
+    return val;
+}
+
+json_t *job_to_json_attrs (struct job *job, const struct job_attrs *ja)
+{
+    json_t *o;
+    json_t *val = NULL;
+    size_t i;
+
+    if (!(o = json_object ()))
+        goto error_nomem;
+    if (!(val = json_integer (job->id)))
+        goto error_nomem;
+    if (json_object_set_new_nocheck (o, "id", val) < 0) {
+        json_decref (val);
+        goto error_nomem;
+    }
+    for (i = 0; i < ja->count; i++) {
+        if (!(val = attr_value (job, ja->attr[i]))) {
+            if (errno == 0)
                 continue;
-            val = json_incref (job->annotations);
-        }
-        else {
-            seterror (errp, "%s is not a valid attribute", attr);
-            errno = EINVAL;
-            goto error;
-        }
-        if (val == NULL)
             goto error_nomem;
-        if (json_object_set_new (o, attr, val) < 0) {
+        }
+        /* attribute names come from attr_table, so skip the UTF-8 check */
+        if (json_object_set_new_nocheck (o, ja->attr[i]->name, val) < 0) {
             json_decref (val);
             goto error_nomem;
         }
     }
     return o;
  error_nomem:
-    errno = ENOMEM;
- error:
     ERRNO_SAFE_WRAP (json_decref, o);
+    errno = ENOMEM;
     return NULL;
 }
 
+/* For a given job, create a JSON object containing the jobid and any
+ * additional requested attributes and their values.  Returns JSON
+ * object which the caller must free.  On error, return NULL with
+ * errno set:
+ *
+ * EINVAL - malformed attrs array
+ * ENOMEM - out of memory
+ */
+json_t *job_to_json (struct job *job, json_t *attrs, job_info_error_t *errp)
+{
+    struct job_attrs *ja;
+    json_t *o;
+
+    if (errp)
+        memset (errp, 0, sizeof (*errp));
+    if (!(ja = job_attrs_create (attrs, errp)))
+        return NULL;
+    o = job_to_json_attrs (job, ja);
+    job_attrs_destroy (ja);
+    return o;
+}
+
 /*
  * vi:tabstop=4 shiftwidth=4 expandtab
  */
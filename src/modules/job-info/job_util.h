@@ -22,6 +22,31 @@ typedef struct {
 void __attribute__((format (printf, 2, 3)))
 seterror (job_info_error_t *errp, const char *fmt, ...);
 
+/* A list of requested job attributes, validated once per request so
+ * that encoding each job does not have to look up attribute names.
+ */
+struct job_attrs;
+
+/* Create from a JSON array of attribute names.  On error, return NULL
+ * with errno set and 'errp' filled in:
+ *
+ * EINVAL - attr is not a string or not a valid attribute
+ * ENOMEM - out of memory
+ */
+struct job_attrs *job_attrs_create (json_t *attrs, job_info_error_t *errp);
+void job_attrs_destroy (struct job_attrs *ja);
+
+/* Return a JSON array of all valid attribute names.
+ */
+json_t *job_attrs_list (void);
+
+/* Create a JSON object containing the jobid and the attributes in 'ja'
+ * that have a value for 'job'.  Returns NULL with errno = ENOMEM on error.
+ */
+json_t *job_to_json_attrs (struct job *job, const struct job_attrs *ja);
+
+/* Convenience for a single job, as above, with 'attrs' a JSON array.
+ */
 json_t *job_to_json (struct job *job, json_t *attrs, job_info_error_t *errp);
 
 #endif /* ! _FLUX_JOB_INFO_JOB_UTIL_H */
@@ -13,6 +13,7 @@
 #if HAVE_CONFIG_H
 #include "config.h"
 #endif
+#include <fnmatch.h>
 #include <czmq.h>
 #include <jansson.h>
 #include <flux/core.h>
@@ -24,6 +25,9 @@
 #include "job_util.h"
 #include "job_state.h"
 
+/* Default number of jobs per response for a streaming job-info.list */
+#define LIST_CHUNK_SIZE 100
+
 json_t *get_job_by_id (struct info_ctx *ctx,
                        job_info_error_t *errp,
                        const flux_msg_t *msg,
@@ -31,74 +35,194 @@ json_t *get_job_by_id (struct info_ctx *ctx,
                        json_t *attrs,
                        bool *stall);
 
+/* Constraints on the jobs returned by job-info.list.
+ */
+struct list_filter {
+    uint32_t userid;
+    int states;
+    int results;
+    const char *name;       /* fnmatch(3) pattern for job name, or NULL */
+    double since;           /* skip jobs inactive at or before, if > 0 */
+};
+
 /* Filter test to determine if job desired by caller */
-bool job_filter (struct job *job, uint32_t userid, int states, int results)
+bool job_filter (struct job *job, const struct list_filter *lf)
 {
-    if (!(job->state & states))
+    if (!(job->state & lf->states))
         return false;
-    if (userid != FLUX_USERID_UNKNOWN && job->userid != userid)
+    if (lf->userid != FLUX_USERID_UNKNOWN && job->userid != lf->userid)
         return false;
-    if (job->state & FLUX_JOB_INACTIVE
-        && !(job->result & results))
+    if (job->state & FLUX_JOB_INACTIVE) {
+        if (!(job->result & lf->results))
+            return false;
+        if (job->t_inactive <= lf->since)
+            return false;
+    }
+    if (lf->name && (!job->name || fnmatch (lf->name, job->name, 0) != 0))
         return false;
     return true;
 }
 
+/* Job lists in the order jobs are returned by job-info.list.
+ */
+static const struct {
+    const char *name;
+    int states;
+} job_lists[] = {
+    { "pending", FLUX_JOB_PENDING },
+    { "running", FLUX_JOB_RUNNING },
+    { "inactive", FLUX_JOB_INACTIVE },
+};
+#define JOB_LISTS_COUNT (sizeof (job_lists) / sizeof (job_lists[0]))
+
 /* Put jobs from list onto jobs array, breaking if max_entries has
- * been reached. Returns 1 if jobs array is full, 0 if continue, -1
- * one error with errno set:
+ * been reached.  If 'after' is non-NULL, start with the first job
+ * that sorts after it.  Returns 1 if jobs array is full, with the last
+ * job appended in 'lastp', 0 if continue, -1 one error with errno set:
  *
  * ENOMEM - out of memory
  */
 int get_jobs_from_list (json_t *jobs,
                         job_info_error_t *errp,
-                        zlistx_t *list,
+                        struct skiplist *list,
+                        const struct job *after,
                         int max_entries,
-                        json_t *attrs,
-                        uint32_t userid,
-                        int states,
-                        int results)
+                        const struct job_attrs *ja,
+                        const struct list_filter *lf,
+                        struct job **lastp)
 {
     struct job *job;
 
-    job = zlistx_first (list);
+    if (after)
+        job = skiplist_seek (list, after);
+    else
+        job = skiplist_first (list);
     while (job) {
-        if (job_filter (job, userid, states, results)) {
+        /* The inactive list is sorted by t_inactive, newest first,
+         * so no job after this one satisfies 'since' either.
+         */
+        if ((job->state & FLUX_JOB_INACTIVE) && job->t_inactive <= lf->since)
+            break;
+        if (job_filter (job, lf)) {
             json_t *o;
-            if (!(o = job_to_json (job, attrs, errp)))
+            if (!(o = job_to_json_attrs (job, ja)))
                 return -1;
             if (json_array_append_new (jobs, o) < 0) {
                 json_decref (o);
                 errno = ENOMEM;
                 return -1;
             }
-            if (json_array_size (jobs) == max_entries)
+            if (json_array_size (jobs) == max_entries) {
+                *lastp = job;
                 return 1;
+            }
         }
-        job = zlistx_next (list);
+        job = skiplist_next (list);
     }
 
     return 0;
 }
 
+/* A cursor records the position of the last job returned, as the list
+ * it was on and the sort keys of that list.  It remains valid if that
+ * job changes state, as the position does not refer to the job itself.
+ */
+static json_t *cursor_encode (int list, const struct job *job)
+{
+    json_t *o;
+
+    if (!(o = json_pack ("{s:s s:I s:i s:f s:f s:f}",
+                         "list", job_lists[list].name,
+                         "id", job->id,
+                         "priority", job->priority,
+                         "t_submit", job->t_submit,
+                         "t_run", job->t_run,
+                         "t_inactive", job->t_inactive))) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    return o;
+}
+
+static int cursor_decode (json_t *cursor,
+                          job_info_error_t *errp,
+                          int *listp,
+                          struct job *key)
+{
+    const char *name;
+    int i;
+
+    if (json_unpack (cursor, "{s:s s:I s:i s:F s:F s:F}",
+                     "list", &name,
+                     "id", &key->id,
+                     "priority", &key->priority,
+                     "t_submit", &key->t_submit,
+                     "t_run", &key->t_run,
+                     "t_inactive", &key->t_inactive) < 0)
+        goto error;
+    for (i = 0; i < JOB_LISTS_COUNT; i++) {
+        if (!strcmp (name, job_lists[i].name)) {
+            *listp = i;
+            return 0;
+        }
+    }
+error:
+    seterror (errp, "invalid payload: malformed cursor");
+    errno = EPROTO;
+    return -1;
+}
+
 /* Create a JSON array of 'job' objects.  'max_entries' determines the
- * max number of jobs to return, 0=unlimited.  Returns JSON object
- * which the caller must free.  On error, return NULL with errno set:
+ * max number of jobs to return, 0=unlimited.  If 'cursor' is non-NULL,
+ * resume after the position it records.  If max_entries was reached,
+ * '*cursorp' is set to the position of the last job returned, else NULL.
+ * If inactive jobs were requested and all were returned, but some that
+ * satisfy 'lf->since' have been evicted, '*archivep' is set to
+ * evicted_t_inactive, else 0.
+ * Returns JSON object which the caller must free.  On error, return
+ * NULL with errno set:
  *
- * EPROTO - malformed or empty attrs array, max_entries out of range
+ * EPROTO - malformed cursor
  * ENOMEM - out of memory
  */
 json_t *get_jobs (struct info_ctx *ctx,
                   job_info_error_t *errp,
                   int max_entries,
-                  json_t *attrs,
-                  uint32_t userid,
-                  int states,
-                  int results)
+                  const struct job_attrs *ja,
+                  const struct list_filter *lf,
+                  json_t *cursor,
+                  json_t **cursorp,
+                  double *archivep)
 {
+    struct job_state_ctx *jsctx = ctx->jsctx;
+    struct skiplist *lists[JOB_LISTS_COUNT] = { NULL };
+    struct job key = { 0 };
+    struct job *last = NULL;
     json_t *jobs = NULL;
+    int start = 0;
     int saved_errno;
     int ret = 0;
+    int i;
+
+    if (cursor && cursor_decode (cursor, errp, &start, &key) < 0)
+        return NULL;
+
+    /* Use the per-user lists if the caller asks for one user's jobs,
+     * so other users' jobs are never visited.
+     */
+    if (lf->userid == FLUX_USERID_UNKNOWN) {
+        lists[0] = jsctx->pending;
+        lists[1] = jsctx->running;
+        lists[2] = jsctx->inactive;
+    }
+    else {
+        struct user_jobs *uj = job_state_user_jobs (jsctx, lf->userid);
+        if (uj) {
+            lists[0] = uj->pending;
+            lists[1] = uj->running;
+            lists[2] = uj->inactive;
+        }
+    }
 
     if (!(jobs = json_array ()))
         goto error_nomem;
@@ -106,45 +230,26 @@ json_t *get_jobs (struct info_ctx *ctx,
     /* We return jobs in the following order, pending, running,
      * inactive */
 
-    if (states & FLUX_JOB_PENDING) {
+    for (i = start; i < JOB_LISTS_COUNT && !ret; i++) {
+        if (!(lf->states & job_lists[i].states))
+            continue;
         if ((ret = get_jobs_from_list (jobs,
                                        errp,
-                                       ctx->jsctx->pending,
+                                       lists[i],
+                                       cursor && i == start ? &key : NULL,
                                        max_entries,
-                                       attrs,
-                                       userid,
-                                       states,
-                                       results)) < 0)
+                                       ja,
+                                       lf,
+                                       &last)) < 0)
+            goto error;
+        if (ret && !(*cursorp = cursor_encode (i, last)))
             goto error;
     }
-
-    if (states & FLUX_JOB_RUNNING) {
-        if (!ret) {
-            if ((ret = get_jobs_from_list (jobs,
-                                           errp,
-                                           ctx->jsctx->running,
-                                           max_entries,
-                                           attrs,
-                                           userid,
-                                           states,
-                                           results)) < 0)
-                goto error;
-        }
-    }
-
-    if (states & FLUX_JOB_INACTIVE) {
-        if (!ret) {
-            if ((ret = get_jobs_from_list (jobs,
-                                           errp,
-                                           ctx->jsctx->inactive,
-                                           max_entries,
-                                           attrs,
-                                           userid,
-                                           states,
-                                           results)) < 0)
-                goto error;
-        }
-    }
+    if (!ret
+        && (lf->states & FLUX_JOB_INACTIVE)
+        && jsctx->evicted_count > 0
+        && jsctx->evicted_t_inactive > lf->since)
+        *archivep = jsctx->evicted_t_inactive;
 
     return jobs;
 
@@ -157,24 +262,92 @@ error:
     return NULL;
 }
 
+/* Respond to a streaming job-info.list request with one {"jobs":[...]}
+ * response per 'chunk_size' jobs, resuming each chunk with the cursor
+ * from the previous one, so at most one chunk is held in memory and
+ * the client can handle the first jobs before the last are found.
+ * The stream is terminated with ENODATA.  Returns -1 with errno set
+ * on error, in which case no terminating response was sent.
+ */
+static int list_stream (struct info_ctx *ctx,
+                        const flux_msg_t *msg,
+                        job_info_error_t *errp,
+                        int max_entries,
+                        int chunk_size,
+                        const struct job_attrs *ja,
+                        const struct list_filter *lf,
+                        json_t *cursor_in)
+{
+    json_t *cursor = NULL;
+    double archive_before = 0.;
+    int count = 0;
+
+    do {
+        json_t *jobs;
+        json_t *next = NULL;
+        int n = chunk_size;
+
+        if (max_entries > 0 && max_entries - count < n)
+            n = max_entries - count;
+        if (!(jobs = get_jobs (ctx, errp, n, ja, lf,
+                               cursor ? cursor : cursor_in, &next,
+                               &archive_before)))
+            goto error;
+        json_decref (cursor);
+        cursor = next;
+        count += json_array_size (jobs);
+        if (json_array_size (jobs) > 0
+            && flux_respond_pack (ctx->h, msg, "{s:O}", "jobs", jobs) < 0) {
+            flux_log_error (ctx->h, "%s: flux_respond_pack", __FUNCTION__);
+            json_decref (jobs);
+            goto error;
+        }
+        json_decref (jobs);
+    } while (cursor && (max_entries == 0 || count < max_entries));
+
+    if (archive_before > 0.
+        && flux_respond_pack (ctx->h, msg, "{s:[] s:f}",
+                              "jobs",
+                              "archive_before", archive_before) < 0) {
+        flux_log_error (ctx->h, "%s: flux_respond_pack", __FUNCTION__);
+        goto error;
+    }
+    if (flux_respond_error (ctx->h, msg, ENODATA, NULL) < 0)
+        flux_log_error (ctx->h, "%s: flux_respond_error", __FUNCTION__);
+    json_decref (cursor);
+    return 0;
+error:
+    ERRNO_SAFE_WRAP (json_decref, cursor);
+    return -1;
+}
+
 void list_cb (flux_t *h, flux_msg_handler_t *mh,
               const flux_msg_t *msg, void *arg)
 {
     struct info_ctx *ctx = arg;
-    job_info_error_t err;
+    job_info_error_t err = {{0}};
     json_t *jobs = NULL;
+    json_t *cursor_in = NULL;
+    json_t *cursor = NULL;
+    json_t *resp = NULL;
+    double archive_before = 0.;
     json_t *attrs;
+    struct job_attrs *ja = NULL;
     int max_entries;
-    uint32_t userid;
-    int states;
-    int results;
+    int chunk_size = LIST_CHUNK_SIZE;
+    struct list_filter lf = { .name = NULL, .since = 0. };
 
-    if (flux_request_unpack (msg, NULL, "{s:i s:o s:i s:i s:i}",
+    if (flux_request_unpack (msg, NULL,
+                             "{s:i s:o s:i s:i s:i s?:o s?:i s?:s s?:F}",
                              "max_entries", &max_entries,
                              "attrs", &attrs,
-                             "userid", &userid,
-                             "states", &states,
-                             "results", &results) < 0) {
+                             "userid", &lf.userid,
+                             "states", &lf.states,
+                             "results", &lf.results,
+                             "cursor", &cursor_in,
+                             "chunk_size", &chunk_size,
+                             "name", &lf.name,
+                             "since", &lf.since) < 0) {
         seterror (&err, "invalid payload: %s", flux_msg_last_error (msg));
         errno = EPROTO;
         goto error;
@@ -184,40 +357,75 @@ void list_cb (flux_t *h, flux_msg_handler_t *mh,
         errno = EPROTO;
         goto error;
     }
+    if (chunk_size <= 0) {
+        seterror (&err, "invalid payload: chunk_size must be > 0");
+        errno = EPROTO;
+        goto error;
+    }
     if (!json_is_array (attrs)) {
         seterror (&err, "invalid payload: attrs must be an array");
         errno = EPROTO;
         goto error;
     }
+    if (!(ja = job_attrs_create (attrs, &err)))
+        goto error;
     /* If user sets no states, assume they want all information */
-    if (!states)
-        states = (FLUX_JOB_PENDING
-                  | FLUX_JOB_RUNNING
-                  | FLUX_JOB_INACTIVE);
+    if (!lf.states)
+        lf.states = (FLUX_JOB_PENDING
+                     | FLUX_JOB_RUNNING
+                     | FLUX_JOB_INACTIVE);
 
     /* If user sets no results, assume they want all information */
-    if (!results)
-        results = (FLUX_JOB_RESULT_COMPLETED
-                   | FLUX_JOB_RESULT_FAILED
-                   | FLUX_JOB_RESULT_CANCELLED
-                   | FLUX_JOB_RESULT_TIMEOUT);
+    if (!lf.results)
+        lf.results = (FLUX_JOB_RESULT_COMPLETED
+                      | FLUX_JOB_RESULT_FAILED
+                      | FLUX_JOB_RESULT_CANCELLED
+                      | FLUX_JOB_RESULT_TIMEOUT);
+
+    if (flux_msg_is_streaming (msg)) {
+        if (list_stream (ctx, msg, &err, max_entries, chunk_size,
+                         ja, &lf, cursor_in) < 0)
+            goto error;
+        job_attrs_destroy (ja);
+        return;
+    }
 
     if (!(jobs = get_jobs (ctx, &err, max_entries,
-                           attrs, userid, states, results)))
+                           ja, &lf,
+                           cursor_in, &cursor, &archive_before)))
         goto error;
 
-    if (flux_respond_pack (h, msg, "{s:O}", "jobs", jobs) < 0) {
+    /* A cursor is returned only if max_entries was reached, so there
+     * may be more jobs to fetch.  archive_before is returned if older
+     * inactive jobs must be fetched from job-archive.
+     */
+    if (!(resp = json_pack ("{s:O}", "jobs", jobs))
+        || (cursor && json_object_set (resp, "cursor", cursor) < 0)
+        || (archive_before > 0.
+            && json_object_set_new (resp,
+                                    "archive_before",
+                                    json_real (archive_before)) < 0)) {
+        errno = ENOMEM;
+        goto error;
+    }
+    if (flux_respond_pack (h, msg, "O", resp) < 0) {
         flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
         goto error;
     }
 
+    json_decref (resp);
     json_decref (jobs);
+    json_decref (cursor);
+    job_attrs_destroy (ja);
     return;
 
 error:
     if (flux_respond_error (h, msg, errno, err.text) < 0)
         flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+    json_decref (resp);
     json_decref (jobs);
+    json_decref (cursor);
+    job_attrs_destroy (ja);
 }
 
 /* Create a JSON array of 'job' objects.  'since' limits entries
@@ -225,14 +433,13 @@ error:
  * timestamp.  Returns JSON object which the caller must free.  On
  * error, return NULL with errno set:
  *
- * EPROTO - malformed or empty attrs array
  * ENOMEM - out of memory
  */
 json_t *get_inactive_jobs (struct info_ctx *ctx,
                            job_info_error_t *errp,
                            int max_entries,
                            double since,
-                           json_t *attrs,
+                           const struct job_attrs *ja,
                            const char *name)
 {
     json_t *jobs = NULL;
@@ -242,11 +449,11 @@ json_t *get_inactive_jobs (struct info_ctx *ctx,
     if (!(jobs = json_array ()))
         goto error_nomem;
 
-    job = zlistx_first (ctx->jsctx->inactive);
+    job = skiplist_first (ctx->jsctx->inactive);
     while (job && (job->t_inactive > since)) {
         json_t *o;
         if (!name || strcmp (job->name, name) == 0) {
-            if (!(o = job_to_json (job, attrs, errp)))
+            if (!(o = job_to_json_attrs (job, ja)))
                 goto error;
             if (json_array_append_new (jobs, o) < 0) {
                 json_decref (o);
@@ -256,7 +463,7 @@ json_t *get_inactive_jobs (struct info_ctx *ctx,
             if (json_array_size (jobs) == max_entries)
                 goto out;
         }
-        job = zlistx_next (ctx->jsctx->inactive);
+        job = skiplist_next (ctx->jsctx->inactive);
     }
 
 out:
@@ -280,8 +487,15 @@ void list_inactive_cb (flux_t *h, flux_msg_handler_t *mh,
     int max_entries;
     double since;
     json_t *attrs;
+    struct job_attrs *ja = NULL;
     const char *name = NULL;
 
+    /* A partial answer would let a caller polling with 'since' skip
+     * jobs that have not been read yet.
+     */
+    if (job_state_defer (ctx->jsctx, msg))
+        return;
+
     if (flux_request_unpack (msg, NULL, "{s:i s:F s:o s?:s}",
                              "max_entries", &max_entries,
                              "since", &since,
@@ -300,10 +514,12 @@ void list_inactive_cb (flux_t *h, flux_msg_handler_t *mh,
         errno = EPROTO;
         goto error;
     }
+    if (!(ja = job_attrs_create (attrs, &err)))
+        goto error;
     if (!(jobs = get_inactive_jobs (ctx, &err,
                                     max_entries,
                                     since,
-                                    attrs,
+                                    ja,
                                     name)))
         goto error;
 
@@ -313,12 +529,14 @@ void list_inactive_cb (flux_t *h, flux_msg_handler_t *mh,
     }
 
     json_decref (jobs);
+    job_attrs_destroy (ja);
     return;
 
 error:
     if (flux_respond_error (h, msg, errno, err.text) < 0)
         flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
     json_decref (jobs);
+    job_attrs_destroy (ja);
 }
 
 int wait_id_valid (struct info_ctx *ctx, struct idsync_data *isd)
@@ -365,9 +583,10 @@ void check_id_valid_continuation (flux_future_t *f, void *arg)
 {
     struct idsync_data *isd = arg;
     struct info_ctx *ctx = isd->ctx;
+    const char *eventlog;
     void *handle;
 
-    if (flux_future_get (f, NULL) < 0) {
+    if (flux_kvs_lookup_get (f, &eventlog) < 0) {
         if (flux_respond_error (ctx->h, isd->msg, errno, NULL) < 0)
             flux_log_error (ctx->h, "%s: flux_respond_error", __FUNCTION__);
         goto cleanup;
@@ -377,7 +596,14 @@ void check_id_valid_continuation (flux_future_t *f, void *arg)
          * lookup was done */
         struct job *job;
         if (!(job = zhashx_lookup (ctx->jsctx->index, &isd->id))
-            || job->state == FLUX_JOB_NEW) {
+            && job_state_evicted (ctx->jsctx, eventlog)) {
+            if (flux_respond_error (ctx->h, isd->msg, ENOENT,
+                                    "inactive job evicted from job-info") < 0)
+                flux_log_error (ctx->h, "%s: flux_respond_error",
+                                __FUNCTION__);
+            goto cleanup;
+        }
+        if (!job || job->state == FLUX_JOB_NEW) {
             /* Must wait for job-info to see state change */
             if (wait_id_valid (ctx, isd) < 0)
                 flux_log_error (ctx->h, "%s: wait_id_valid", __FUNCTION__);
@@ -416,11 +642,13 @@ int check_id_valid (struct info_ctx *ctx,
     int saved_errno;
 
     /* Check to see if the ID is legal, job-info may have not yet
-     * seen the ID publication yet */
-    if (flux_job_kvs_key (path, sizeof (path), id, NULL) < 0)
+     * seen the ID publication yet.  The eventlog also shows whether
+     * the job was evicted.
+     */
+    if (flux_job_kvs_key (path, sizeof (path), id, "eventlog") < 0)
         goto error;
 
-    if (!(f = flux_kvs_lookup (ctx->h, NULL, FLUX_KVS_READDIR, path))) {
+    if (!(f = flux_kvs_lookup (ctx->h, NULL, 0, path))) {
         flux_log_error (ctx->h, "%s: flux_kvs_lookup", __FUNCTION__);
         goto error;
     }
@@ -547,42 +775,13 @@ error:
     json_decref (job);
 }
 
-int list_attrs_append (json_t *a, const char *attr)
-{
-    json_t *o = json_string (attr);
-    if (!o) {
-        errno = ENOMEM;
-        return -1;
-    }
-    if (json_array_append_new (a, o) < 0) {
-        json_decref (o);
-        errno = ENOMEM;
-        return -1;
-    }
-    return 0;
-}
-
 void list_attrs_cb (flux_t *h, flux_msg_handler_t *mh,
                     const flux_msg_t *msg, void *arg)
 {
-    const char *attrs[] = { "userid", "priority", "t_submit", "t_depend",
-                            "t_sched", "t_run", "t_cleanup", "t_inactive",
-                            "state", "name", "ntasks", "nnodes", "ranks",
-                            "success", "exception_occurred", "exception_type",
-                            "exception_severity", "exception_note", "result",
-                            "expiration", "annotations", NULL };
     json_t *a = NULL;
-    int i;
 
-    if (!(a = json_array ())) {
-        errno = ENOMEM;
+    if (!(a = job_attrs_list ()))
         goto error;
-    }
-
-    for (i = 0; attrs[i] != NULL; i++) {
-        if (list_attrs_append (a, attrs[i]) < 0)
-            goto error;
-    }
 
     if (flux_respond_pack (h, msg, "{s:o}", "attrs", a) < 0) {
         flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
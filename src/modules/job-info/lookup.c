@@ -8,7 +8,13 @@
  * SPDX-License-Identifier: LGPL-3.0
 \************************************************************/
 
-/* lookup.c - lookup in job-info */
+/* lookup.c - lookup in job-info
+ *
+ * The jobspec, R and eventlog of an inactive job no longer change, so
+ * values looked up for inactive jobs are kept in an LRU cache, bounded
+ * by entry count and total bytes, and later lookups of them are served
+ * without a KVS round trip.
+ */
 
 #if HAVE_CONFIG_H
 #include "config.h"
@@ -17,10 +23,30 @@
 #include <jansson.h>
 #include <flux/core.h>
 
+#include "src/common/libutil/lru_cache.h"
+
 #include "info.h"
 #include "lookup.h"
 #include "allow.h"
 
+/* Values larger than this are not cached.
+ */
+#define LOOKUP_CACHE_MAX_VALSIZE (1024*1024)
+
+struct lookup_cache {
+    lru_cache_t *lru;
+    size_t maxbytes;
+    size_t bytes;
+    int hits;
+    int misses;
+};
+
+struct lookup_cache_entry {
+    struct lookup_cache *lc;
+    char *value;
+    size_t size;
+};
+
 struct lookup_ctx {
     struct info_ctx *ctx;
     const flux_msg_t *msg;
@@ -30,16 +56,148 @@ struct lookup_ctx {
     int flags;
     flux_future_t *f;
     bool allow;
+    json_t *cached;     // key => value, from lookup cache
+    int missing;        // number of keys to look up in the KVS
 };
 
 static void info_lookup_continuation (flux_future_t *fall, void *arg);
 
+static void lookup_cache_entry_destroy (void *data)
+{
+    struct lookup_cache_entry *e = data;
+
+    if (e) {
+        e->lc->bytes -= e->size;
+        free (e->value);
+        free (e);
+    }
+}
+
+struct lookup_cache *lookup_cache_create (int maxcount, size_t maxbytes)
+{
+    struct lookup_cache *lc;
+
+    if (maxcount <= 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(lc = calloc (1, sizeof (*lc))))
+        return NULL;
+    if (!(lc->lru = lru_cache_create (maxcount))) {
+        free (lc);
+        errno = ENOMEM;
+        return NULL;
+    }
+    lru_cache_set_free_f (lc->lru, lookup_cache_entry_destroy);
+    lc->maxbytes = maxbytes;
+    return lc;
+}
+
+void lookup_cache_destroy (struct lookup_cache *lc)
+{
+    if (lc) {
+        int saved_errno = errno;
+        lru_cache_destroy (lc->lru);
+        free (lc);
+        errno = saved_errno;
+    }
+}
+
+json_t *lookup_cache_stats (struct lookup_cache *lc)
+{
+    return json_pack ("{s:i s:I s:i s:i}",
+                      "count", lc ? lru_cache_size (lc->lru) : 0,
+                      "bytes", lc ? (json_int_t)lc->bytes : 0,
+                      "hits", lc ? lc->hits : 0,
+                      "misses", lc ? lc->misses : 0);
+}
+
+/* Only the immutable keys of inactive jobs are cached.
+ */
+static bool lookup_cacheable (struct lookup_ctx *l, const char *key)
+{
+    struct job *job;
+
+    if (!l->ctx->lookup_cache)
+        return false;
+    if (strcmp (key, "jobspec") != 0
+        && strcmp (key, "R") != 0
+        && strcmp (key, "eventlog") != 0)
+        return false;
+    if (!(job = zhashx_lookup (l->ctx->jsctx->index, &l->id))
+        || job->state != FLUX_JOB_INACTIVE)
+        return false;
+    return true;
+}
+
+static void lookup_cache_key (char *buf,
+                              size_t size,
+                              flux_jobid_t id,
+                              const char *key)
+{
+    (void)snprintf (buf, size, "%ju.%s", (uintmax_t)id, key);
+}
+
+static const char *lookup_cache_get (struct lookup_ctx *l, const char *key)
+{
+    struct lookup_cache *lc = l->ctx->lookup_cache;
+    struct lookup_cache_entry *e;
+    char buf[64];
+
+    if (!lookup_cacheable (l, key))
+        return NULL;
+    lookup_cache_key (buf, sizeof (buf), l->id, key);
+    if (!(e = lru_cache_get (lc->lru, buf))) {
+        lc->misses++;
+        return NULL;
+    }
+    lc->hits++;
+    return e->value;
+}
+
+/* Cache 'value', evicting the least recently used entries as needed
+ * to stay within the byte limit.  Failure to cache is not an error.
+ */
+static void lookup_cache_put (struct lookup_ctx *l,
+                              const char *key,
+                              const char *value)
+{
+    struct lookup_cache *lc = l->ctx->lookup_cache;
+    struct lookup_cache_entry *e;
+    size_t size;
+    char buf[64];
+
+    if (!lookup_cacheable (l, key))
+        return;
+    size = strlen (value) + 1;
+    if (size > LOOKUP_CACHE_MAX_VALSIZE || size > lc->maxbytes)
+        return;
+    lookup_cache_key (buf, sizeof (buf), l->id, key);
+    if (lru_cache_check (lc->lru, buf))
+        return;
+    while (lc->bytes + size > lc->maxbytes
+           && lru_cache_purge_last (lc->lru) == 0)
+        ;
+    if (!(e = calloc (1, sizeof (*e))))
+        return;
+    if (!(e->value = strdup (value))) {
+        free (e);
+        return;
+    }
+    e->lc = lc;
+    e->size = size;
+    lc->bytes += size;
+    if (lru_cache_put (lc->lru, buf, e) < 0)
+        lookup_cache_entry_destroy (e);
+}
+
 static void lookup_ctx_destroy (void *data)
 {
     if (data) {
         struct lookup_ctx *ctx = data;
         flux_msg_decref (ctx->msg);
         json_decref (ctx->keys);
+        json_decref (ctx->cached);
         flux_future_destroy (ctx->f);
         free (ctx);
     }
@@ -61,7 +219,8 @@ static struct lookup_ctx *lookup_ctx_create (struct info_ctx *ctx,
     l->id = id;
     l->flags = flags;
 
-    if (!(l->keys = json_copy (keys))) {
+    if (!(l->keys = json_copy (keys))
+        || !(l->cached = json_object ())) {
         errno = ENOMEM;
         goto error;
     }
@@ -77,13 +236,30 @@ error:
     return NULL;
 }
 
+/* Take 'key' from the lookup cache if possible, otherwise push a KVS
+ * lookup of it onto 'fall'.
+ */
 static int lookup_key (struct lookup_ctx *l,
                        flux_future_t *fall,
                        const char *key)
 {
     flux_future_t *f = NULL;
+    const char *value;
     char path[64];
 
+    if (json_object_get (l->cached, key))
+        return 0;
+    if ((value = lookup_cache_get (l, key))) {
+        json_t *o;
+        if (!(o = json_string (value))
+            || json_object_set_new (l->cached, key, o) < 0) {
+            json_decref (o);
+            errno = ENOMEM;
+            goto error;
+        }
+        return 0;
+    }
+
     if (flux_job_kvs_key (path, sizeof (path), l->id, key) < 0) {
         flux_log_error (l->ctx->h, "%s: flux_job_kvs_key", __FUNCTION__);
         goto error;
@@ -98,6 +274,7 @@ static int lookup_key (struct lookup_ctx *l,
         flux_log_error (l->ctx->h, "%s: flux_future_push", __FUNCTION__);
         goto error;
     }
+    l->missing++;
 
     return 0;
 
@@ -106,6 +283,9 @@ error:
     return -1;
 }
 
+/* Look up keys not found in the lookup cache.  If all were found,
+ * l->f is left NULL and the caller may respond right away.
+ */
 static int lookup_keys (struct lookup_ctx *l)
 {
     flux_future_t *fall = NULL;
@@ -133,6 +313,11 @@ static int lookup_keys (struct lookup_ctx *l)
             goto error;
     }
 
+    if (l->missing == 0) {
+        flux_future_destroy (fall);
+        return 0;
+    }
+
     if (flux_future_then (fall,
                           -1,
                           info_lookup_continuation,
@@ -149,9 +334,39 @@ error:
     return -1;
 }
 
-static void info_lookup_continuation (flux_future_t *fall, void *arg)
+/* Get the value of 'key', from the lookup cache or from the KVS lookup
+ * in l->f.  Values from the KVS are added to the cache.
+ */
+static int lookup_get (struct lookup_ctx *l, const char *key, const char **sp)
+{
+    json_t *o;
+    flux_future_t *f;
+    const char *s;
+
+    if ((o = json_object_get (l->cached, key))) {
+        *sp = json_string_value (o);
+        return 0;
+    }
+    if (!l->f || !(f = flux_future_get_child (l->f, key))) {
+        flux_log_error (l->ctx->h,
+                        "%s: flux_future_get_child",
+                        __FUNCTION__);
+        return -1;
+    }
+    if (flux_kvs_lookup_get (f, &s) < 0) {
+        if (errno != ENOENT)
+            flux_log_error (l->ctx->h,
+                            "%s: flux_kvs_lookup_get",
+                            __FUNCTION__);
+        return -1;
+    }
+    lookup_cache_put (l, key, s);
+    *sp = s;
+    return 0;
+}
+
+static void lookup_respond (struct lookup_ctx *l)
 {
-    struct lookup_ctx *l = arg;
     struct info_ctx *ctx = l->ctx;
     const char *s;
     size_t index;
@@ -160,18 +375,8 @@ static void info_lookup_continuation (flux_future_t *fall, void *arg)
     char *data = NULL;
 
     if (!l->allow) {
-        flux_future_t *f;
-
-        if (!(f = flux_future_get_child (fall, "eventlog"))) {
-            flux_log_error (ctx->h, "%s: flux_future_get_child", __FUNCTION__);
-            goto error;
-        }
-
-        if (flux_kvs_lookup_get (f, &s) < 0) {
-            if (errno != ENOENT)
-                flux_log_error (l->ctx->h, "%s: flux_kvs_lookup_get", __FUNCTION__);
+        if (lookup_get (l, "eventlog", &s) < 0)
             goto error;
-        }
 
         if (eventlog_allow (ctx, l->msg, s) < 0)
             goto error;
@@ -182,7 +387,6 @@ static void info_lookup_continuation (flux_future_t *fall, void *arg)
         goto enomem;
 
     json_array_foreach(l->keys, index, key) {
-        flux_future_t *f;
         const char *keystr;
         json_t *str = NULL;
 
@@ -191,16 +395,8 @@ static void info_lookup_continuation (flux_future_t *fall, void *arg)
             goto error;
         }
 
-        if (!(f = flux_future_get_child (fall, keystr))) {
-            flux_log_error (ctx->h, "%s: flux_future_get_child", __FUNCTION__);
+        if (lookup_get (l, keystr, &s) < 0)
             goto error;
-        }
-
-        if (flux_kvs_lookup_get (f, &s) < 0) {
-            if (errno != ENOENT)
-                flux_log_error (l->ctx->h, "%s: flux_kvs_lookup_get", __FUNCTION__);
-            goto error;
-        }
 
         if (!(str = json_string (s)))
             goto enomem;
@@ -232,11 +428,18 @@ error:
         flux_log_error (ctx->h, "%s: flux_respond_error", __FUNCTION__);
 
 done:
-    /* flux future destroyed in lookup_ctx_destroy, which is called
-     * via zlist_remove() */
     json_decref (o);
     free (data);
-    zlist_remove (ctx->lookups, l);
+}
+
+static void info_lookup_continuation (flux_future_t *fall, void *arg)
+{
+    struct lookup_ctx *l = arg;
+
+    lookup_respond (l);
+    /* flux future destroyed in lookup_ctx_destroy, which is called
+     * via zlist_remove() */
+    zlist_remove (l->ctx->lookups, l);
 }
 
 /* If keys array doesn't contain eventlog, flag that we'll need to do
@@ -296,6 +499,12 @@ void lookup_cb (flux_t *h, flux_msg_handler_t *mh,
     if (lookup_keys (l) < 0)
         goto error;
 
+    if (!l->f) {
+        lookup_respond (l);
+        lookup_ctx_destroy (l);
+        return;
+    }
+
     if (zlist_append (ctx->lookups, l) < 0) {
         flux_log_error (h, "%s: zlist_append", __FUNCTION__);
         goto error;
@@ -11,6 +11,7 @@
 #ifndef _FLUX_JOB_INFO_LOOKUP_H
 #define _FLUX_JOB_INFO_LOOKUP_H
 
+#include <jansson.h>
 #include <flux/core.h>
 
 #include "info.h"
@@ -18,6 +19,16 @@
 void lookup_cb (flux_t *h, flux_msg_handler_t *mh,
                 const flux_msg_t *msg, void *arg);
 
+/* Cache of lookups of the jobspec, R and eventlog of inactive jobs,
+ * holding at most 'maxcount' values totaling at most 'maxbytes'.
+ */
+struct lookup_cache *lookup_cache_create (int maxcount, size_t maxbytes);
+void lookup_cache_destroy (struct lookup_cache *lc);
+
+/* Return {"count":i, "bytes":I, "hits":i, "misses":i}, or NULL on error.
+ */
+json_t *lookup_cache_stats (struct lookup_cache *lc);
+
 #endif /* ! _FLUX_JOB_INFO_LOOKUP_H */
 
 /*
@@ -0,0 +1,376 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* state_watch.c - stream job state transitions for many jobs
+ *
+ * job-info.state-watch {"ids":[id, ...]} or {"userid":i}
+ *
+ * Unlike job-info.eventlog-watch, which watches one job eventlog in
+ * the KVS, one state-watch request follows any number of jobs.  It is
+ * fed from the job-state events job-info already receives from the
+ * job-manager, so no KVS watches are created.
+ *
+ * Responses are {"transitions":[[id, state, timestamp], ...]}, in the
+ * format of the job-state event, sent at most once per reactor loop
+ * iteration.  Watching by ids first responds with the current state of
+ * the jobs already known, and ends with ENODATA once they are all
+ * inactive.  Watching by userid follows new transitions of that user's
+ * jobs (FLUX_USERID_UNKNOWN for all users) until canceled.
+ *
+ * Guests may only watch their own jobs.  A watched id owned by another
+ * user is dropped without response.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <jansson.h>
+#include <czmq.h>
+#include <flux/core.h>
+
+#include "src/common/libjob/job_hash.h"
+
+#include "info.h"
+#include "state_watch.h"
+
+struct state_watch {
+    struct info_ctx *ctx;
+    const flux_msg_t *msg;
+    struct flux_msg_cred cred;
+    uint32_t userid;        // watched user, if ids == NULL
+    zhashx_t *ids;          // watched jobs not yet inactive
+    json_t *transitions;    // not yet sent
+    bool done;
+};
+
+static void state_watch_destroy (struct state_watch *sw)
+{
+    if (sw) {
+        int saved_errno = errno;
+        (void)flux_msglist_remove (sw->ctx->state_watch_requests, sw);
+        flux_msg_decref (sw->msg);
+        zhashx_destroy (&sw->ids);
+        json_decref (sw->transitions);
+        free (sw);
+        errno = saved_errno;
+    }
+}
+
+static void state_watch_destructor (void **item)
+{
+    if (item) {
+        state_watch_destroy (*item);
+        *item = NULL;
+    }
+}
+
+static struct state_watch *state_watch_create (struct info_ctx *ctx,
+                                               const flux_msg_t *msg)
+{
+    struct state_watch *sw;
+
+    if (!(sw = calloc (1, sizeof (*sw))))
+        return NULL;
+    sw->ctx = ctx;
+    sw->msg = flux_msg_incref (msg);
+    if (flux_msg_get_cred (msg, &sw->cred) < 0)
+        goto error;
+    if (!(sw->transitions = json_array ())) {
+        errno = ENOMEM;
+        goto error;
+    }
+    return sw;
+error:
+    state_watch_destroy (sw);
+    return NULL;
+}
+
+static bool state_watch_allow (struct state_watch *sw, struct job *job)
+{
+    return flux_msg_cred_authorize (sw->cred, job->userid) == 0;
+}
+
+static int state_watch_append (struct state_watch *sw,
+                               flux_jobid_t id,
+                               flux_job_state_t state,
+                               double timestamp)
+{
+    json_t *o;
+
+    if (!(o = json_pack ("[I,s,f]",
+                         id,
+                         flux_job_statetostr (state, false),
+                         timestamp))
+        || json_array_append_new (sw->transitions, o) < 0) {
+        json_decref (o);
+        errno = ENOMEM;
+        return -1;
+    }
+    return 0;
+}
+
+/* Stop watching 'id'.  A watch by ids is done when none remain.
+ */
+static void state_watch_drop (struct state_watch *sw, flux_jobid_t id)
+{
+    zhashx_delete (sw->ids, &id);
+    if (zhashx_size (sw->ids) == 0)
+        sw->done = true;
+}
+
+static int state_watch_add (struct state_watch *sw,
+                            struct job *job,
+                            flux_job_state_t state,
+                            double timestamp)
+{
+    if (sw->ids) {
+        if (!zhashx_lookup (sw->ids, &job->id))
+            return 0;
+        if (!state_watch_allow (sw, job)) {
+            state_watch_drop (sw, job->id);
+            return 0;
+        }
+    }
+    else if (sw->userid != FLUX_USERID_UNKNOWN && sw->userid != job->userid)
+        return 0;
+    if (state_watch_append (sw, job->id, state, timestamp) < 0)
+        return -1;
+    if (sw->ids && state == FLUX_JOB_INACTIVE)
+        state_watch_drop (sw, job->id);
+    return 0;
+}
+
+static double state_timestamp (struct job *job)
+{
+    switch (job->state) {
+        case FLUX_JOB_DEPEND:
+            return job->t_submit;
+        case FLUX_JOB_SCHED:
+            return job->t_sched;
+        case FLUX_JOB_RUN:
+            return job->t_run;
+        case FLUX_JOB_CLEANUP:
+            return job->t_cleanup;
+        case FLUX_JOB_INACTIVE:
+            return job->t_inactive;
+        default:
+            return 0.;
+    }
+}
+
+static void id_destructor (void **item)
+{
+    if (item) {
+        free (*item);
+        *item = NULL;
+    }
+}
+
+static int state_watch_add_ids (struct state_watch *sw, json_t *ids)
+{
+    struct job_state_ctx *jsctx = sw->ctx->jsctx;
+    size_t index;
+    json_t *value;
+
+    if (!(sw->ids = job_hash_create ()))
+        goto nomem;
+    zhashx_set_destructor (sw->ids, id_destructor);
+    json_array_foreach (ids, index, value) {
+        flux_jobid_t *id;
+        struct job *job;
+
+        if (!json_is_integer (value)) {
+            errno = EPROTO;
+            return -1;
+        }
+        /* job_hash does not copy keys, so the key is the item */
+        if (!(id = malloc (sizeof (*id))))
+            goto nomem;
+        *id = json_integer_value (value);
+        if (zhashx_insert (sw->ids, id, id) < 0) {
+            free (id);
+            continue; // duplicate
+        }
+        if ((job = zhashx_lookup (jsctx->index, id))
+            && job->state != FLUX_JOB_NEW
+            && state_watch_add (sw, job, job->state,
+                                state_timestamp (job)) < 0)
+            return -1;
+    }
+    if (zhashx_size (sw->ids) == 0)
+        sw->done = true;
+    return 0;
+nomem:
+    errno = ENOMEM;
+    return -1;
+}
+
+static void state_watch_prep_cb (flux_reactor_t *r,
+                                 flux_watcher_t *w,
+                                 int revents,
+                                 void *arg)
+{
+    struct info_ctx *ctx = arg;
+    struct state_watch *sw;
+
+    sw = zlistx_first (ctx->state_watchers);
+    while (sw) {
+        if (json_array_size (sw->transitions) > 0) {
+            if (flux_respond_pack (ctx->h, sw->msg, "{s:O}",
+                                   "transitions", sw->transitions) < 0) {
+                flux_log_error (ctx->h, "%s: flux_respond_pack",
+                                __FUNCTION__);
+                sw->done = true;
+            }
+            json_array_clear (sw->transitions);
+        }
+        if (sw->done) {
+            if (flux_respond_error (ctx->h, sw->msg, ENODATA, NULL) < 0)
+                flux_log_error (ctx->h, "%s: flux_respond_error",
+                                __FUNCTION__);
+            zlistx_delete (ctx->state_watchers,
+                           zlistx_cursor (ctx->state_watchers));
+        }
+        sw = zlistx_next (ctx->state_watchers);
+    }
+    flux_watcher_stop (w);
+}
+
+void state_watch_notify (struct info_ctx *ctx,
+                         struct job *job,
+                         flux_job_state_t state,
+                         double timestamp)
+{
+    struct state_watch *sw;
+
+    sw = zlistx_first (ctx->state_watchers);
+    while (sw) {
+        if (state_watch_add (sw, job, state, timestamp) < 0) {
+            flux_log_error (ctx->h, "%s: error queuing transition",
+                            __FUNCTION__);
+            sw->done = true;
+        }
+        sw = zlistx_next (ctx->state_watchers);
+    }
+    if (zlistx_size (ctx->state_watchers) > 0)
+        flux_watcher_start (ctx->state_watch_prep);
+}
+
+void state_watch_cb (flux_t *h, flux_msg_handler_t *mh,
+                     const flux_msg_t *msg, void *arg)
+{
+    struct info_ctx *ctx = arg;
+    struct state_watch *sw = NULL;
+    json_t *ids = NULL;
+    uint32_t userid = FLUX_USERID_UNKNOWN;
+    const char *errmsg = NULL;
+
+    if (flux_request_unpack (msg, NULL, "{s?o s?i}",
+                             "ids", &ids,
+                             "userid", &userid) < 0)
+        goto error;
+    if (!flux_msg_is_streaming (msg)) {
+        errno = EPROTO;
+        errmsg = "state-watch request rejected without streaming RPC flag";
+        goto error;
+    }
+    if (ids && (!json_is_array (ids) || userid != FLUX_USERID_UNKNOWN)) {
+        errno = EPROTO;
+        errmsg = "specify one of ids or userid";
+        goto error;
+    }
+    if (!(sw = state_watch_create (ctx, msg)))
+        goto error;
+    if (ids) {
+        if (state_watch_add_ids (sw, ids) < 0)
+            goto error;
+    }
+    else {
+        if (flux_msg_cred_authorize (sw->cred, userid) < 0) {
+            errmsg = "guests may only watch their own jobs";
+            goto error;
+        }
+        sw->userid = userid;
+    }
+    if (flux_msglist_append (ctx->state_watch_requests, msg, sw) < 0)
+        goto error;
+    if (!zlistx_add_end (ctx->state_watchers, sw)) {
+        errno = ENOMEM;
+        goto error;
+    }
+    if (json_array_size (sw->transitions) > 0 || sw->done)
+        flux_watcher_start (ctx->state_watch_prep);
+    return;
+
+error:
+    if (flux_respond_error (h, msg, errno, errmsg) < 0)
+        flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+    state_watch_destroy (sw);
+}
+
+void state_watchers_cancel (struct info_ctx *ctx,
+                            const flux_msg_t *msg, uint32_t matchtag)
+{
+    struct state_watch *sw;
+
+    while ((sw = flux_msglist_pop_sender (ctx->state_watch_requests,
+                                          msg,
+                                          matchtag))) {
+        sw->done = true;
+        flux_watcher_start (ctx->state_watch_prep);
+    }
+}
+
+void state_watch_cancel_cb (flux_t *h, flux_msg_handler_t *mh,
+                            const flux_msg_t *msg, void *arg)
+{
+    struct info_ctx *ctx = arg;
+    uint32_t matchtag;
+
+    if (flux_request_unpack (msg, NULL, "{s:i}", "matchtag", &matchtag) < 0) {
+        flux_log_error (h, "%s: flux_request_unpack", __FUNCTION__);
+        return;
+    }
+    state_watchers_cancel (ctx, msg, matchtag);
+}
+
+int state_watch_setup (struct info_ctx *ctx)
+{
+    flux_reactor_t *r = flux_get_reactor (ctx->h);
+
+    if (!(ctx->state_watchers = zlistx_new ()))
+        return -1;
+    zlistx_set_destructor (ctx->state_watchers, state_watch_destructor);
+    ctx->state_watch_prep = flux_prepare_watcher_create (r,
+                                                         state_watch_prep_cb,
+                                                         ctx);
+    if (!ctx->state_watch_prep)
+        return -1;
+    return 0;
+}
+
+void state_watch_cleanup (struct info_ctx *ctx)
+{
+    struct state_watch *sw;
+
+    sw = zlistx_first (ctx->state_watchers);
+    while (sw) {
+        if (flux_respond_error (ctx->h, sw->msg, ENOSYS, NULL) < 0)
+            flux_log_error (ctx->h, "%s: flux_respond_error", __FUNCTION__);
+        sw = zlistx_next (ctx->state_watchers);
+    }
+    zlistx_destroy (&ctx->state_watchers);
+    flux_watcher_destroy (ctx->state_watch_prep);
+    ctx->state_watch_prep = NULL;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
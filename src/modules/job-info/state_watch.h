@@ -0,0 +1,45 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _FLUX_JOB_INFO_STATE_WATCH_H
+#define _FLUX_JOB_INFO_STATE_WATCH_H
+
+#include <flux/core.h>
+
+#include "info.h"
+#include "job_state.h"
+
+void state_watch_cb (flux_t *h, flux_msg_handler_t *mh,
+                     const flux_msg_t *msg, void *arg);
+
+void state_watch_cancel_cb (flux_t *h, flux_msg_handler_t *mh,
+                            const flux_msg_t *msg, void *arg);
+
+/* Cancel all state watchers from the sender of 'msg' that match matchtag. */
+void state_watchers_cancel (struct info_ctx *ctx,
+                            const flux_msg_t *msg, uint32_t matchtag);
+
+/* Queue transition of 'job' to 'state' for matching state watchers.
+ * Responses are sent at the end of the reactor loop iteration.
+ */
+void state_watch_notify (struct info_ctx *ctx,
+                         struct job *job,
+                         flux_job_state_t state,
+                         double timestamp);
+
+int state_watch_setup (struct info_ctx *ctx);
+
+void state_watch_cleanup (struct info_ctx *ctx);
+
+#endif /* ! _FLUX_JOB_INFO_STATE_WATCH_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -32,6 +32,8 @@ struct watch_ctx {
     bool guest;
     char *path;
     int flags;
+    int start;          /* index of first entry to send */
+    int index;          /* index of next entry */
     flux_future_t *check_f;
     flux_future_t *watch_f;
     bool allow;
@@ -45,6 +47,7 @@ static void watch_ctx_destroy (void *data)
 {
     if (data) {
         struct watch_ctx *ctx = data;
+        (void)flux_msglist_remove (ctx->ctx->watch_requests, ctx);
         flux_msg_decref (ctx->msg);
         free (ctx->path);
         flux_future_destroy (ctx->check_f);
@@ -58,7 +61,8 @@ static struct watch_ctx *watch_ctx_create (struct info_ctx *ctx,
                                            flux_jobid_t id,
                                            bool guest,
                                            const char *path,
-                                           int flags)
+                                           int flags,
+                                           int start)
 {
     struct watch_ctx *w = calloc (1, sizeof (*w));
     int saved_errno;
@@ -74,6 +78,7 @@ static struct watch_ctx *watch_ctx_create (struct info_ctx *ctx,
         goto error;
     }
     w->flags = flags;
+    w->start = start;
 
     w->msg = flux_msg_incref (msg);
 
@@ -237,6 +242,20 @@ error:
     return rc;
 }
 
+/* A negative start counts back from the end of the eventlog as first
+ * returned by kvs-watch, so resolve it to an index on that response.
+ */
+static void resolve_start (struct watch_ctx *w, const char *s)
+{
+    const char *tok;
+    size_t toklen;
+    int count = 0;
+
+    while (eventlog_parse_next (&s, &tok, &toklen))
+        count++;
+    w->start = count + w->start > 0 ? count + w->start : 0;
+}
+
 static void watch_continuation (flux_future_t *f, void *arg)
 {
     struct watch_ctx *w = arg;
@@ -263,11 +282,15 @@ static void watch_continuation (flux_future_t *f, void *arg)
         w->allow = true;
     }
 
+    if (w->start < 0)
+        resolve_start (w, s);
+
     input = s;
     while (eventlog_parse_next (&input, &tok, &toklen)) {
-        if (flux_respond_pack (ctx->h, w->msg,
-                               "{s:s#}",
-                               "event", tok, toklen) < 0) {
+        if (w->index++ >= w->start
+            && flux_respond_pack (ctx->h, w->msg,
+                                  "{s:s#}",
+                                  "event", tok, toklen) < 0) {
             flux_log_error (ctx->h, "%s: flux_respond_pack",
                             __FUNCTION__);
             goto error_cancel;
@@ -326,6 +349,7 @@ void watch_cb (flux_t *h, flux_msg_handler_t *mh,
     int guest = 0;
     const char *path = NULL;
     int flags;
+    int start = 0;
     const char *errmsg = NULL;
 
     if (flux_request_unpack (msg, NULL, "{s:I s:s s:i}",
@@ -341,8 +365,9 @@ void watch_cb (flux_t *h, flux_msg_handler_t *mh,
         goto error;
     }
     (void)flux_request_unpack (msg, NULL, "{s:b}", "guest", &guest);
+    (void)flux_request_unpack (msg, NULL, "{s:i}", "start", &start);
 
-    if (!(w = watch_ctx_create (ctx, msg, id, guest, path, flags)))
+    if (!(w = watch_ctx_create (ctx, msg, id, guest, path, flags, start)))
         goto error;
 
     /* if user requested an alternate path and that alternate path is
@@ -358,6 +383,10 @@ void watch_cb (flux_t *h, flux_msg_handler_t *mh,
             goto error;
     }
 
+    if (flux_msglist_append (ctx->watch_requests, msg, w) < 0) {
+        flux_log_error (h, "%s: flux_msglist_append", __FUNCTION__);
+        goto error;
+    }
     if (zlist_append (ctx->watchers, w) < 0) {
         flux_log_error (h, "%s: zlist_append", __FUNCTION__);
         goto error;
@@ -373,22 +402,14 @@ error:
     watch_ctx_destroy (w);
 }
 
-/* Cancel watch 'w' if it matches (sender, matchtag).
- * matchtag=FLUX_MATCHTAG_NONE matches any matchtag.
- */
-static void watch_cancel (struct info_ctx *ctx,
-                          struct watch_ctx *w,
-                          const char *sender, uint32_t matchtag)
+void watchers_cancel (struct info_ctx *ctx,
+                      const flux_msg_t *msg, uint32_t matchtag)
 {
-    uint32_t t;
-    char *s;
+    struct watch_ctx *w;
 
-    if (matchtag != FLUX_MATCHTAG_NONE
-        && (flux_msg_get_matchtag (w->msg, &t) < 0 || matchtag != t))
-        return;
-    if (flux_msg_get_route_first (w->msg, &s) < 0)
-        return;
-    if (!strcmp (sender, s)) {
+    while ((w = flux_msglist_pop_sender (ctx->watch_requests,
+                                         msg,
+                                         matchtag))) {
         w->cancel = true;
 
         /* if the watching hasn't started yet, no need to cancel */
@@ -398,19 +419,6 @@ static void watch_cancel (struct info_ctx *ctx,
                                 __FUNCTION__);
         }
     }
-    free (s);
-}
-
-void watchers_cancel (struct info_ctx *ctx,
-                      const char *sender, uint32_t matchtag)
-{
-    struct watch_ctx *w;
-
-    w = zlist_first (ctx->watchers);
-    while (w) {
-        watch_cancel (ctx, w, sender, matchtag);
-        w = zlist_next (ctx->watchers);
-    }
 }
 
 void watch_cancel_cb (flux_t *h, flux_msg_handler_t *mh,
@@ -418,18 +426,12 @@ void watch_cancel_cb (flux_t *h, flux_msg_handler_t *mh,
 {
     struct info_ctx *ctx = arg;
     uint32_t matchtag;
-    char *sender;
 
     if (flux_request_unpack (msg, NULL, "{s:i}", "matchtag", &matchtag) < 0) {
         flux_log_error (h, "%s: flux_request_unpack", __FUNCTION__);
         return;
     }
-    if (flux_msg_get_route_first (msg, &sender) < 0) {
-        flux_log_error (h, "%s: flux_msg_get_route_first", __FUNCTION__);
-        return;
-    }
-    watchers_cancel (ctx, sender, matchtag);
-    free (sender);
+    watchers_cancel (ctx, msg, matchtag);
 }
 
 void watch_cleanup (struct info_ctx *ctx)
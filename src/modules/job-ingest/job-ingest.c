@@ -12,6 +12,7 @@
 #include "config.h"
 #endif
 #include <unistd.h>
+#include <time.h>
 #include <czmq.h>
 #include <jansson.h>
 #include <flux/core.h>
@@ -21,7 +22,10 @@
 #endif
 
 #include "src/common/libutil/fluid.h"
+#include "src/common/libutil/fsd.h"
+#include "src/common/libutil/monotime.h"
 #include "src/common/libjob/sign_none.h"
+#include "src/common/libjob/jobspec_summary.h"
 #include "src/common/libeventlog/eventlog.h"
 
 #include "validate.h"
@@ -41,6 +45,8 @@
  *
  * The jobid is returned to the user in response to the job-ingest.submit RPC.
  * Responses are sent after the job has been successfully ingested.
+ * Jobs refused by job-manager admission control (too many pending jobs)
+ * fail with EAGAIN and are removed from the KVS.
  *
  * Currently all KVS data is committed under job.<fluid-dothex>,
  * where <fluid-dothex> is the jobid converted to 16-bit, 0-padded hex
@@ -65,8 +71,29 @@
  * any given job request is delayed before initiating a KVS commit.
  * Too large, and individual job submit latency will suffer.
  * Too small, and KVS commit overhead will increase.
+ *
+ * A batch is only held that long while an earlier one is still being
+ * committed.  If none is, the batch is flushed as soon as the reactor
+ * has handled the requests already pending, so a lone job is not
+ * delayed, while under load, batches grow to cover the commit latency.
+ * A batch is also flushed once it holds batch_max jobs (0 = unlimited).
+ * Both may be set with batch-timeout=FSD and batch-max=N module options.
+ *
+ * Each job-manager.submit response carries the number of jobs the
+ * job-manager may still admit ("credits", -1 if unlimited).  Credits are
+ * spent as batches are committed.  While none are left, a batch is held
+ * for pace_timeout (pace-timeout=FSD) seconds before it is committed,
+ * so that bulk submitters are slowed down while the queue drains,
+ * rather than having their jobs committed to the KVS only to be refused.
  */
-const double batch_timeout = 0.01;
+const double default_batch_timeout = 0.01;
+const int default_batch_max = 0;
+const double default_pace_timeout = 0.5;
+
+/* Batch size and latency (ms) histograms are log2:  hist[0] < 1,
+ * hist[i] < 2^i, and the last bucket is unbounded.
+ */
+#define BATCH_HIST_BUCKETS 16
 
 /* Timeout (seconds) to wait for validators to terminate when
  * stopped by closing their stdin.  If the timer pops, stop the reactor
@@ -86,6 +113,21 @@ struct job_ingest_ctx {
 
     struct batch *batch;
     flux_watcher_t *timer;
+    double batch_timeout;
+    int batch_max;
+    int batch_inflight;         // batches being committed or announced
+    double pace_timeout;
+    int credits;                // jobs job-manager may admit (-1 = no limit)
+
+    struct {
+        int64_t count;
+        int64_t paced;          // batches held for lack of credits
+        int64_t rejected;       // jobs refused by job-manager
+        int size_max;
+        int size_hist[BATCH_HIST_BUCKETS];
+        double latency_max;
+        int latency_hist[BATCH_HIST_BUCKETS];
+    } batch_stats;
 
     bool shutdown;              // no new jobs are accepted in shutdown mode
     int shutdown_process_count; // number of validators executing at shutdown
@@ -100,11 +142,16 @@ struct job {
     struct flux_msg_cred cred;    // submitting user's creds
     int priority;       // requested job priority
     int flags;          // submit flags
+    double t_ingest;    // wallclock time the request was received
 
     char *jobspec;      // jobspec, not \0 terminated (unwrapped from signed)
     int jobspecsz;      // jobspec string length
 
     struct job_ingest_ctx *ctx;
+    struct bulk *bulk;  // bulk submit request this job belongs to, if any
+    int index;          // position of job within bulk request
+    bool rejected;      // refused by job-manager admission control
+    const char *errmsg; // reason for refusal, valid during response
 };
 
 struct batch {
@@ -112,6 +159,23 @@ struct batch {
     flux_kvs_txn_t *txn;
     zlist_t *jobs;
     json_t *joblist;
+    const flux_msg_t *bulk_msg; // if set, respond once for all jobs
+    struct timespec t_start;    // when batch was created
+    bool committing;            // batch counts toward ctx->batch_inflight
+    bool paced;                 // batch was held for lack of credits
+    flux_watcher_t *pace_timer; // holds a paced bulk batch
+};
+
+/* A job-ingest.submit-bulk request, while its jobs are being validated.
+ * Once all are valid, the jobs are moved to a batch of their own.
+ */
+struct bulk {
+    struct job_ingest_ctx *ctx;
+    const flux_msg_t *msg;
+    zlist_t *jobs;      // jobs in request order
+    int pending;        // count of validations in progress
+    int errnum;         // first validation failure, if any
+    char errbuf[256];
 };
 
 static int make_key (char *buf, int bufsz, struct job *job, const char *name);
@@ -138,19 +202,26 @@ static void job_destroy (struct job *job)
     }
 }
 
+/* Create a job from signed jobspec 'J', which must remain valid
+ * for the lifetime of 'msg'.
+ */
 static struct job *job_create (const flux_msg_t *msg,
+                               const char *J,
+                               int priority,
+                               int flags,
                                struct job_ingest_ctx *ctx)
 {
     struct job *job;
+    struct timespec ts;
 
     if (!(job = calloc (1, sizeof (*job))))
         return NULL;
     job->msg = flux_msg_incref (msg);
-    if (flux_request_unpack (job->msg, NULL, "{s:s s:i s:i}",
-                             "J", &job->J,
-                             "priority", &job->priority,
-                             "flags", &job->flags) < 0)
-        goto error;
+    job->J = J;
+    job->priority = priority;
+    job->flags = flags;
+    if (clock_gettime (CLOCK_REALTIME, &ts) == 0)
+        job->t_ingest = (1E-9 * ts.tv_nsec) + ts.tv_sec;
     if (flux_msg_get_cred (job->msg, &job->cred) < 0)
         goto error;
     job->ctx = ctx;
@@ -172,6 +243,8 @@ static void batch_destroy (struct batch *batch)
             json_decref (batch->joblist);
             flux_kvs_txn_destroy (batch->txn);
         }
+        flux_msg_decref (batch->bulk_msg);
+        flux_watcher_destroy (batch->pace_timer);
         free (batch);
         errno = saved_errno;
     }
@@ -194,6 +267,7 @@ static struct batch *batch_create (struct job_ingest_ctx *ctx)
     if (!(batch->joblist = json_array ()))
         goto nomem;
     batch->ctx = ctx;
+    monotime (&batch->t_start);
     return batch;
 nomem:
     errno = ENOMEM;
@@ -209,6 +283,12 @@ static void batch_respond_error (struct batch *batch,
 {
     flux_t *h = batch->ctx->h;
     struct job *job = zlist_first (batch->jobs);
+
+    if (batch->bulk_msg) {
+        if (flux_respond_error (h, batch->bulk_msg, errnum, errstr) < 0)
+            flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+        return;
+    }
     while (job) {
         if (flux_respond_error (h, job->msg, errnum, errstr) < 0)
             flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
@@ -216,19 +296,95 @@ static void batch_respond_error (struct batch *batch,
     }
 }
 
-/* Respond to all requestors (for each job) with their id.
+/* Respond to a bulk requestor with the ids of all jobs, in order.
+ * The job-manager admits or refuses all jobs of a bulk request together.
+ */
+static void batch_respond_bulk (struct batch *batch)
+{
+    flux_t *h = batch->ctx->h;
+    json_t *ids;
+    struct job *job;
+
+    if ((job = zlist_first (batch->jobs)) && job->rejected) {
+        if (flux_respond_error (h, batch->bulk_msg, EAGAIN, job->errmsg) < 0)
+            flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+        return;
+    }
+    if (!(ids = json_array ()))
+        goto nomem;
+    job = zlist_first (batch->jobs);
+    while (job) {
+        json_t *o = json_integer (job->id);
+        if (!o || json_array_append_new (ids, o) < 0) {
+            json_decref (o);
+            goto nomem;
+        }
+        job = zlist_next (batch->jobs);
+    }
+    if (flux_respond_pack (h, batch->bulk_msg, "{s:O}", "ids", ids) < 0)
+        flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
+    json_decref (ids);
+    return;
+nomem:
+    if (flux_respond_error (h, batch->bulk_msg, ENOMEM, NULL) < 0)
+        flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+    json_decref (ids);
+}
+
+/* Respond to all requestors (for each job) with their id,
+ * or with EAGAIN if the job was refused by the job-manager.
  */
 static void batch_respond_success (struct batch *batch)
 {
     flux_t *h = batch->ctx->h;
     struct job *job = zlist_first (batch->jobs);
+
+    if (batch->bulk_msg) {
+        batch_respond_bulk (batch);
+        return;
+    }
     while (job) {
-        if (flux_respond_pack (h, job->msg, "{s:I}", "id", job->id) < 0)
+        if (job->rejected) {
+            if (flux_respond_error (h, job->msg, EAGAIN, job->errmsg) < 0)
+                flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+        }
+        else if (flux_respond_pack (h, job->msg, "{s:I}", "id", job->id) < 0)
             flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
         job = zlist_next (batch->jobs);
     }
 }
 
+static void batch_hist_add (int *hist, double value)
+{
+    int i = 0;
+
+    while (i < BATCH_HIST_BUCKETS - 1 && value >= (double)(1 << i))
+        i++;
+    hist[i]++;
+}
+
+static void batch_schedule (struct job_ingest_ctx *ctx);
+
+/* The commit of 'batch' has completed (successfully or not) and all
+ * requestors have been answered.  Record its latency, destroy it,
+ * and let any batch that was held waiting for it proceed.
+ */
+static void batch_done (struct batch *batch)
+{
+    struct job_ingest_ctx *ctx = batch->ctx;
+
+    if (batch->committing) {
+        double t = monotime_since (batch->t_start);
+
+        batch_hist_add (ctx->batch_stats.latency_hist, t);
+        if (ctx->batch_stats.latency_max < t)
+            ctx->batch_stats.latency_max = t;
+        ctx->batch_inflight--;
+    }
+    batch_destroy (batch);
+    batch_schedule (ctx);
+}
+
 static void batch_cleanup_continuation (flux_future_t *f, void *arg)
 {
     flux_t *h = flux_future_get_flux (f);
@@ -238,9 +394,10 @@ static void batch_cleanup_continuation (flux_future_t *f, void *arg)
     flux_future_destroy (f);
 }
 
-/* Remove KVS job entries previously committed for all jobs in batch.
+/* Remove KVS job entries previously committed for all jobs in batch,
+ * or if 'rejected_only' is true, for jobs refused by the job-manager.
  */
-static int batch_cleanup (struct batch *batch)
+static int batch_cleanup (struct batch *batch, bool rejected_only)
 {
     flux_t *h = batch->ctx->h;
     flux_kvs_txn_t *txn;
@@ -252,10 +409,12 @@ static int batch_cleanup (struct batch *batch)
         return -1;
     job = zlist_first (batch->jobs);
     while (job) {
-        if (make_key (key, sizeof (key), job, NULL) < 0)
-            goto error;
-        if (flux_kvs_txn_unlink (txn, 0, key) < 0)
-            goto error;
+        if (!rejected_only || job->rejected) {
+            if (make_key (key, sizeof (key), job, NULL) < 0)
+                goto error;
+            if (flux_kvs_txn_unlink (txn, 0, key) < 0)
+                goto error;
+        }
         job = zlist_next (batch->jobs);
     }
     if (!(f = flux_kvs_commit (h, NULL, 0, txn)))
@@ -270,23 +429,65 @@ error:
     return -1;
 }
 
+/* Mark the jobs of 'batch' listed in 'rejected', an array of
+ * [id, errmsg] in batch order from the job-manager.submit response.
+ * Return the number of jobs marked.
+ */
+static int batch_mark_rejected (struct batch *batch, json_t *rejected)
+{
+    size_t index = 0;
+    struct job *job = zlist_first (batch->jobs);
+
+    while (job && index < json_array_size (rejected)) {
+        json_int_t id;
+        const char *errmsg;
+
+        if (json_unpack (json_array_get (rejected, index),
+                         "[I,s]",
+                         &id,
+                         &errmsg) < 0) {
+            flux_log (batch->ctx->h, LOG_ERR, "malformed rejected job entry");
+            break;
+        }
+        if (job->id == id) {
+            job->rejected = true;
+            job->errmsg = errmsg;
+            index++;
+        }
+        job = zlist_next (batch->jobs);
+    }
+    batch->ctx->batch_stats.rejected += index;
+    return index;
+}
+
 /* Get result of announcing job(s) to job manager,
- * and respond to submit request(s).
+ * and respond to submit request(s).  Remove jobs refused by the
+ * job-manager from the KVS, and update credits.
  */
 static void batch_announce_continuation (flux_future_t *f, void *arg)
 {
     struct batch *batch = arg;
     flux_t *h = batch->ctx->h;
+    json_t *rejected;
+    int credits;
 
-    if (flux_future_get (f, NULL) < 0) {
+    if (flux_rpc_get_unpack (f,
+                             "{s:i s:o}",
+                             "credits", &credits,
+                             "rejected", &rejected) < 0) {
         batch_respond_error (batch, errno, future_strerror (f, errno));
-        if (batch_cleanup (batch) < 0)
+        if (batch_cleanup (batch, false) < 0)
             flux_log_error (h, "%s: KVS cleanup failure", __FUNCTION__);
     }
-    else
+    else {
+        batch->ctx->credits = credits;
+        if (batch_mark_rejected (batch, rejected) > 0
+            && batch_cleanup (batch, true) < 0)
+            flux_log_error (h, "%s: KVS cleanup failure", __FUNCTION__);
         batch_respond_success (batch);
+    }
 
-    batch_destroy (batch);
+    batch_done (batch);
     flux_future_destroy (f);
 }
 
@@ -307,9 +508,9 @@ static void batch_announce (struct batch *batch)
 error:
     flux_log_error (h, "%s: error sending RPC", __FUNCTION__);
     batch_respond_error (batch, errno, "error sending job-manager.submit RPC");
-    if (batch_cleanup (batch) < 0)
+    if (batch_cleanup (batch, false) < 0)
         flux_log_error (h, "%s: KVS cleanup failure", __FUNCTION__);
-    batch_destroy (batch);
+    batch_done (batch);
     flux_future_destroy (f);
 }
 
@@ -322,7 +523,7 @@ static void batch_flush_continuation (flux_future_t *f, void *arg)
 
     if (flux_future_get (f, NULL) < 0) {
         batch_respond_error (batch, errno, "KVS commit failed");
-        batch_destroy (batch);
+        batch_done (batch);
     }
     else {
         batch_announce (batch);
@@ -330,20 +531,22 @@ static void batch_flush_continuation (flux_future_t *f, void *arg)
     flux_future_destroy (f);
 }
 
-/* batch timer - expires 'batch_timeout' seconds after batch was created.
- * Replace ctx->batch with a NULL, and pass 'batch' off to a chain of
- * continuations that commit its data to the KVS, respond to requestors,
- * and announce the new jobids.
+/* Pass 'batch' off to a chain of continuations that commit its data
+ * to the KVS, respond to requestors, and announce the new jobids.
  */
-static void batch_flush (flux_reactor_t *r, flux_watcher_t *w,
-                         int revents, void *arg)
+static void batch_commit (struct job_ingest_ctx *ctx, struct batch *batch)
 {
-    struct job_ingest_ctx *ctx = arg;
-    struct batch *batch;
     flux_future_t *f;
+    int size = zlist_size (batch->jobs);
 
-    batch = ctx->batch;
-    ctx->batch = NULL;
+    batch->committing = true;
+    ctx->batch_inflight++;
+    ctx->batch_stats.count++;
+    if (ctx->credits > 0)
+        ctx->credits = size < ctx->credits ? ctx->credits - size : 0;
+    batch_hist_add (ctx->batch_stats.size_hist, size);
+    if (ctx->batch_stats.size_max < size)
+        ctx->batch_stats.size_max = size;
 
     if (!(f = flux_kvs_commit (ctx->h, NULL, 0, batch->txn))) {
         batch_respond_error (batch, errno, "flux_kvs_commit failed");
@@ -352,13 +555,97 @@ static void batch_flush (flux_reactor_t *r, flux_watcher_t *w,
     if (flux_future_then (f, -1., batch_flush_continuation, batch) < 0) {
         batch_respond_error (batch, errno, "flux_future_then (kvs) failed");
         flux_future_destroy (f);
-        if (batch_cleanup (batch) < 0)
+        if (batch_cleanup (batch, false) < 0)
             flux_log_error (ctx->h, "%s: KVS cleanup failure", __FUNCTION__);
         goto error;
     }
     return;
 error:
-    batch_destroy (batch);
+    batch_done (batch);
+}
+
+/* batch timer - expires when batch_schedule() decides ctx->batch is due.
+ * Replace ctx->batch with a NULL, and commit it.
+ */
+static void batch_flush (flux_reactor_t *r, flux_watcher_t *w,
+                         int revents, void *arg)
+{
+    struct job_ingest_ctx *ctx = arg;
+    struct batch *batch;
+
+    if (!(batch = ctx->batch))
+        return;
+    ctx->batch = NULL;
+    flux_watcher_stop (ctx->timer);
+    batch_commit (ctx, batch);
+}
+
+/* (Re-)arm the batch timer for the current batch, if any, according
+ * to the policy described at the top of this file.
+ */
+static void batch_schedule (struct job_ingest_ctx *ctx)
+{
+    double delay = 0.;
+
+    if (!ctx->batch)
+        return;
+    if (ctx->credits == 0 && ctx->pace_timeout > 0.) {
+        if (!ctx->batch->paced) {
+            ctx->batch->paced = true;
+            ctx->batch_stats.paced++;
+        }
+        delay = ctx->pace_timeout
+              - monotime_since (ctx->batch->t_start) / 1000.;
+        if (delay < 0.)
+            delay = 0.;
+        flux_timer_watcher_reset (ctx->timer, delay, 0.);
+        flux_watcher_start (ctx->timer);
+        return;
+    }
+    if (ctx->batch_max > 0 && zlist_size (ctx->batch->jobs) >= ctx->batch_max) {
+        batch_flush (flux_get_reactor (ctx->h), ctx->timer, 0, ctx);
+        return;
+    }
+    if (ctx->batch_inflight > 0) {
+        delay = ctx->batch_timeout
+              - monotime_since (ctx->batch->t_start) / 1000.;
+        if (delay < 0.)
+            delay = 0.;
+    }
+    flux_timer_watcher_reset (ctx->timer, delay, 0.);
+    flux_watcher_start (ctx->timer);
+}
+
+static void bulk_pace_cb (flux_reactor_t *r, flux_watcher_t *w,
+                          int revents, void *arg)
+{
+    struct batch *batch = arg;
+
+    flux_watcher_stop (w);
+    batch_commit (batch->ctx, batch);
+}
+
+/* Commit the batch of a bulk request, after holding it for pace_timeout
+ * if there are no credits, as for other batches in batch_schedule().
+ */
+static void bulk_commit (struct job_ingest_ctx *ctx, struct batch *batch)
+{
+    if (ctx->credits == 0 && ctx->pace_timeout > 0.) {
+        flux_reactor_t *r = flux_get_reactor (ctx->h);
+
+        if ((batch->pace_timer = flux_timer_watcher_create (r,
+                                                            ctx->pace_timeout,
+                                                            0.,
+                                                            bulk_pace_cb,
+                                                            batch))) {
+            batch->paced = true;
+            ctx->batch_stats.paced++;
+            flux_watcher_start (batch->pace_timer);
+            return;
+        }
+        flux_log_error (ctx->h, "%s: error creating pace timer", __FUNCTION__);
+    }
+    batch_commit (ctx, batch);
 }
 
 /* Format key within the KVS directory of 'job'.
@@ -372,6 +659,63 @@ static int make_key (char *buf, int bufsz, struct job *job, const char *name)
     return 0;
 }
 
+/* Summarize jobspec for the job-manager journal, so that job-info need
+ * not read it back from the KVS:
+ *   {"ntasks":i, "command":o, "job"?:o, "counts"?:o}
+ * where "job" is attributes.system.job, and "counts" is
+ *   {"nnodes":i, "nslots":i, "slot_size":i, "duration":f}
+ * which the job-manager passes on in sched.alloc requests, so that a
+ * scheduler need not parse the jobspec for its resource counts.  "counts"
+ * is omitted if any count is out of range, leaving the scheduler to report
+ * the error.  Return NULL if the jobspec can't be summarized, in which case
+ * job-info falls back to the KVS.
+ */
+static json_t *jobspec_summarize (struct job *job)
+{
+    json_t *jobspec;
+    json_t *jobspec_job = NULL;
+    struct jobspec_summary summary;
+    json_t *o = NULL;
+
+    if (!(jobspec = json_loadb (job->jobspec, job->jobspecsz, 0, NULL)))
+        return NULL;
+    if (json_unpack (jobspec,
+                     "{s:{s:{s?:o}}}",
+                     "attributes",
+                     "system",
+                     "job", &jobspec_job) < 0
+        || (jobspec_job && !json_is_object (jobspec_job))
+        || jobspec_summary_parse (jobspec, &summary, NULL) < 0)
+        goto done;
+    if (!(o = json_pack ("{s:i s:O}",
+                         "ntasks", summary.task_count,
+                         "command", summary.command)))
+        goto done;
+    if (jobspec_job && json_object_set (o, "job", jobspec_job) < 0)
+        goto error;
+    if (summary.slot_count > 0
+        && summary.cores_per_slot > 0
+        && summary.node_count >= 0
+        && summary.duration >= 0.) {
+        json_t *counts;
+
+        if (!(counts = json_pack ("{s:i s:i s:i s:f}",
+                                  "nnodes", summary.node_count,
+                                  "nslots", summary.slot_count,
+                                  "slot_size", summary.cores_per_slot,
+                                  "duration", summary.duration))
+            || json_object_set_new (o, "counts", counts) < 0)
+            goto error;
+    }
+done:
+    json_decref (jobspec);
+    return o;
+error:
+    json_decref (o);
+    json_decref (jobspec);
+    return NULL;
+}
+
 /* Add 'job' to 'batch'.
  * On error, ensure that no remnants of job made into KVS transaction.
  */
@@ -380,6 +724,7 @@ static int batch_add_job (struct batch *batch, struct job *job)
     char key[64];
     int saved_errno;
     json_t *jobentry;
+    json_t *summary;
     json_t *entry = NULL;
     char *entrystr = NULL;
     double t;
@@ -413,13 +758,19 @@ static int batch_add_job (struct batch *batch, struct job *job)
     /* get created timestamp in eventlog entry for job */
     if (eventlog_entry_parse (entry, &t, NULL, NULL) < 0)
         goto error;
-    if (!(jobentry = json_pack ("{s:I s:i s:i s:f s:i}",
+    if (!(jobentry = json_pack ("{s:I s:i s:i s:f s:i s:f}",
                                 "id", job->id,
                                 "userid", job->cred.userid,
                                 "priority", job->priority,
                                 "t_submit", t,
-                                "flags", job->flags)))
+                                "flags", job->flags,
+                                "t_ingest", job->t_ingest)))
+        goto nomem;
+    if ((summary = jobspec_summarize (job))
+        && json_object_set_new (jobentry, "jobspec", summary) < 0) {
+        json_decref (jobentry);
         goto nomem;
+    }
     if (json_array_append_new (batch->joblist, jobentry) < 0) {
         json_decref (jobentry);
         goto nomem;
@@ -457,16 +808,16 @@ void validate_continuation (flux_future_t *f, void *arg)
     if (fluid_generate (&ctx->gen, &job->id) < 0)
         goto error;
     /* Add job to the current "batch" of new jobs, creating the batch if
-     * one doesn't exist already.  Submit is finalized upon timer expiration.
+     * one doesn't exist already.  Submit is finalized when the batch is
+     * flushed, as scheduled by batch_schedule().
      */
     if (!ctx->batch) {
         if (!(ctx->batch = batch_create (ctx)))
             goto error;
-        flux_timer_watcher_reset (ctx->timer, batch_timeout, 0.);
-        flux_watcher_start (ctx->timer);
     }
     if (batch_add_job (ctx->batch, job) < 0)
         goto error;
+    batch_schedule (ctx);
     flux_future_destroy (f);
     return;
 error:
@@ -486,61 +837,47 @@ static int valid_flags (int flags)
     return 0;
 }
 
-/* Handle "job-ingest.submit" request to add a new job.
+/* Check submit flags, priority, and signature of 'job' against the
+ * submitting user's credentials, and unwrap(J) -> jobspec, jobspecsz.
+ * On failure, return -1 with errno set, and if available, a message
+ * for the submitting user in 'errmsg' (possibly pointing to 'errbuf').
  */
-static void submit_cb (flux_t *h, flux_msg_handler_t *mh,
-                       const flux_msg_t *msg, void *arg)
+static int job_check (struct job *job,
+                      char *errbuf,
+                      int errbufsz,
+                      const char **errmsg)
 {
-    struct job_ingest_ctx *ctx = arg;
-    struct job *job = NULL;
-    const char *errmsg = NULL;
-    char errbuf[256];
+    struct job_ingest_ctx *ctx = job->ctx;
     int64_t userid_signer;
     const char *mech_type;
-    flux_future_t *f = NULL;
 
-    if (ctx->shutdown) {
-        errno = ENOSYS;
-        goto error;
-    }
-
-    /* Parse request.
-     */
-    if (!(job = job_create (msg, ctx)))
-        goto error;
     /* Validate submit flags.
      */
     if (valid_flags (job->flags) < 0)
-        goto error;
+        return -1;
     /* Validate requested job priority.
      */
     if (job->priority < FLUX_JOB_PRIORITY_MIN
             || job->priority > FLUX_JOB_PRIORITY_MAX) {
-        snprintf (errbuf, sizeof (errbuf), "priority range is [%d:%d]",
+        snprintf (errbuf, errbufsz, "priority range is [%d:%d]",
                   FLUX_JOB_PRIORITY_MIN, FLUX_JOB_PRIORITY_MAX);
-        errmsg = errbuf;
-        errno = EINVAL;
-        goto error;
+        goto inval;
     }
     if (!(job->cred.rolemask & FLUX_ROLE_OWNER)
            && job->priority > FLUX_JOB_PRIORITY_DEFAULT) {
-        snprintf (errbuf, sizeof (errbuf),
+        snprintf (errbuf, errbufsz,
                   "only the instance owner can submit with priority >%d",
                   FLUX_JOB_PRIORITY_DEFAULT);
-        errmsg = errbuf;
-        errno = EINVAL;
-        goto error;
+        goto inval;
     }
     /* Only owner can set FLUX_JOB_WAITABLE.
      */
     if (!(job->cred.rolemask & FLUX_ROLE_OWNER)
             && (job->flags & FLUX_JOB_WAITABLE)) {
         snprintf (errbuf,
-                  sizeof (errbuf),
+                  errbufsz,
                   "only the instance onwer can submit with FLUX_JOB_WAITABLE");
-        errmsg = errbuf;
-        errno = EINVAL;
-        goto error;
+        goto inval;
     }
     /* Validate jobspec signature, and unwrap(J) -> jobspec,  jobspecsz.
      * Userid claimed by signature must match authenticated job->cred.userid.
@@ -552,11 +889,11 @@ static void submit_cb (flux_t *h, flux_msg_handler_t *mh,
     if (flux_sign_unwrap_anymech (ctx->sec, job->J, &jobspec, &job->jobspecsz,
                                   &mech_type, &userid_signer,
                                   FLUX_SIGN_NOVERIFY) < 0) {
-        errmsg = flux_security_last_error (ctx->sec);
-        goto error;
+        *errmsg = flux_security_last_error (ctx->sec);
+        return -1;
     }
     if (!(job->jobspec = malloc (job->jobspecsz)))
-        goto error;
+        return -1;
     memcpy (job->jobspec, jobspec, job->jobspecsz);
 #else
     uint32_t userid_signer_u32;
@@ -566,29 +903,67 @@ static void submit_cb (flux_t *h, flux_msg_handler_t *mh,
      */
     if (sign_none_unwrap (job->J, (void **)&job->jobspec, &job->jobspecsz,
                           &userid_signer_u32) < 0) {
-        errmsg = "could not unwrap jobspec";
-        goto error;
+        *errmsg = "could not unwrap jobspec";
+        return -1;
     }
     mech_type = "none";
     userid_signer = userid_signer_u32;
+    (void)ctx;
 #endif
     if (userid_signer != job->cred.userid) {
-        snprintf (errbuf, sizeof (errbuf),
+        snprintf (errbuf, errbufsz,
                   "signer=%lu != requestor=%lu",
                   (unsigned long)userid_signer,
                   (unsigned long)job->cred.userid);
-        errmsg = errbuf;
-        errno = EPERM;
-        goto error;
+        goto perm;
     }
     if (!(job->cred.rolemask & FLUX_ROLE_OWNER)
                                 && !strcmp (mech_type, "none")) {
-        snprintf (errbuf, sizeof (errbuf),
+        snprintf (errbuf, errbufsz,
                   "only instance owner can use sign-type=none");
-        errmsg = errbuf;
-        errno = EPERM;
+        goto perm;
+    }
+    return 0;
+inval:
+    *errmsg = errbuf;
+    errno = EINVAL;
+    return -1;
+perm:
+    *errmsg = errbuf;
+    errno = EPERM;
+    return -1;
+}
+
+/* Handle "job-ingest.submit" request to add a new job.
+ */
+static void submit_cb (flux_t *h, flux_msg_handler_t *mh,
+                       const flux_msg_t *msg, void *arg)
+{
+    struct job_ingest_ctx *ctx = arg;
+    struct job *job = NULL;
+    const char *errmsg = NULL;
+    char errbuf[256];
+    const char *J;
+    int priority;
+    int flags;
+    flux_future_t *f = NULL;
+
+    if (ctx->shutdown) {
+        errno = ENOSYS;
         goto error;
     }
+
+    /* Parse request.
+     */
+    if (flux_request_unpack (msg, NULL, "{s:s s:i s:i}",
+                             "J", &J,
+                             "priority", &priority,
+                             "flags", &flags) < 0)
+        goto error;
+    if (!(job = job_create (msg, J, priority, flags, ctx)))
+        goto error;
+    if (job_check (job, errbuf, sizeof (errbuf), &errmsg) < 0)
+        goto error;
     /* Validate jobspec asynchronously.
      * Continue submission process in validate_continuation().
      */
@@ -604,6 +979,193 @@ error:
     flux_future_destroy (f);
 }
 
+static void bulk_destroy (struct bulk *bulk)
+{
+    if (bulk) {
+        int saved_errno = errno;
+        if (bulk->jobs) {
+            struct job *job;
+            while ((job = zlist_pop (bulk->jobs)))
+                job_destroy (job);
+            zlist_destroy (&bulk->jobs);
+        }
+        flux_msg_decref (bulk->msg);
+        free (bulk);
+        errno = saved_errno;
+    }
+}
+
+static struct bulk *bulk_create (const flux_msg_t *msg,
+                                 struct job_ingest_ctx *ctx)
+{
+    struct bulk *bulk;
+
+    if (!(bulk = calloc (1, sizeof (*bulk))))
+        return NULL;
+    if (!(bulk->jobs = zlist_new ())) {
+        errno = ENOMEM;
+        goto error;
+    }
+    bulk->msg = flux_msg_incref (msg);
+    bulk->ctx = ctx;
+    return bulk;
+error:
+    bulk_destroy (bulk);
+    return NULL;
+}
+
+/* All jobs in 'bulk' are valid.  Assign jobids, then move the jobs to a
+ * batch of their own and commit it, so that the request is answered
+ * once, with all jobids, after a single KVS commit.
+ */
+static void bulk_finish (struct bulk *bulk)
+{
+    struct job_ingest_ctx *ctx = bulk->ctx;
+    struct batch *batch;
+    struct job *job;
+    fluid_t id = 0;
+    int avail = 0;
+
+    if (!(batch = batch_create (ctx)))
+        goto error;
+    batch->bulk_msg = flux_msg_incref (bulk->msg);
+    /* Reserve jobids in contiguous ranges rather than one at a time.
+     */
+    while ((job = zlist_first (bulk->jobs))) {
+        if (avail == 0) {
+            int count = zlist_size (bulk->jobs);
+            if (count > fluid_range_max (&ctx->gen))
+                count = fluid_range_max (&ctx->gen);
+            if (fluid_generate_range (&ctx->gen, count, &id) < 0)
+                goto error;
+            avail = count;
+        }
+        job->id = id++;
+        avail--;
+        if (batch_add_job (batch, job) < 0)
+            goto error;
+        zlist_remove (bulk->jobs, job);
+    }
+    bulk_commit (ctx, batch);
+    bulk_destroy (bulk);
+    return;
+error:
+    if (flux_respond_error (ctx->h, bulk->msg, errno, NULL) < 0)
+        flux_log_error (ctx->h, "%s: flux_respond_error", __FUNCTION__);
+    batch_destroy (batch);
+    bulk_destroy (bulk);
+}
+
+static void bulk_validate_continuation (flux_future_t *f, void *arg)
+{
+    struct job *job = arg;
+    struct bulk *bulk = job->bulk;
+    flux_t *h = flux_future_get_flux (f);
+
+    if (flux_future_get (f, NULL) < 0 && bulk->errnum == 0) {
+        bulk->errnum = errno;
+        (void)snprintf (bulk->errbuf, sizeof (bulk->errbuf), "job %d: %s",
+                        job->index, future_strerror (f, errno));
+    }
+    flux_future_destroy (f);
+    if (--bulk->pending > 0)
+        return;
+    if (bulk->errnum != 0) {
+        if (flux_respond_error (h, bulk->msg, bulk->errnum, bulk->errbuf) < 0)
+            flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+        bulk_destroy (bulk);
+        return;
+    }
+    bulk_finish (bulk);
+}
+
+/* Handle "job-ingest.submit-bulk" request to add an array of new jobs
+ * with a common priority and flags.  Each job is checked and validated
+ * as in submit_cb(), but the request succeeds only if all pass, and
+ * is answered with an array of jobids in request order.
+ */
+static void submit_bulk_cb (flux_t *h, flux_msg_handler_t *mh,
+                            const flux_msg_t *msg, void *arg)
+{
+    struct job_ingest_ctx *ctx = arg;
+    struct bulk *bulk = NULL;
+    const char *errmsg = NULL;
+    char errbuf[256];
+    char jobbuf[300];
+    json_t *jobs;
+    int priority;
+    int flags;
+    size_t index;
+    json_t *o;
+    struct job *job;
+
+    if (ctx->shutdown) {
+        errno = ENOSYS;
+        goto error;
+    }
+    if (flux_request_unpack (msg, NULL, "{s:o s:i s:i}",
+                             "jobs", &jobs,
+                             "priority", &priority,
+                             "flags", &flags) < 0)
+        goto error;
+    if (!json_is_array (jobs) || json_array_size (jobs) == 0) {
+        errno = EPROTO;
+        goto error;
+    }
+    if (!(bulk = bulk_create (msg, ctx)))
+        goto error;
+    json_array_foreach (jobs, index, o) {
+        const char *J = json_string_value (o);
+
+        if (!J) {
+            errno = EPROTO;
+            goto error;
+        }
+        if (!(job = job_create (msg, J, priority, flags, ctx)))
+            goto error;
+        job->bulk = bulk;
+        job->index = index;
+        if (zlist_append (bulk->jobs, job) < 0) {
+            job_destroy (job);
+            errno = ENOMEM;
+            goto error;
+        }
+        if (job_check (job, errbuf, sizeof (errbuf), &errmsg) < 0) {
+            (void)snprintf (jobbuf, sizeof (jobbuf), "job %d: %s",
+                            (int)index, errmsg ? errmsg : strerror (errno));
+            errmsg = jobbuf;
+            goto error;
+        }
+    }
+    /* Validate jobspecs asynchronously.
+     * Continue submission process in bulk_validate_continuation().
+     * If a request cannot be sent, wait for any already sent to complete.
+     */
+    job = zlist_first (bulk->jobs);
+    while (job) {
+        flux_future_t *f;
+
+        if (!(f = validate_jobspec (ctx->validate, job->jobspec,
+                                    job->jobspecsz))
+            || flux_future_then (f, -1., bulk_validate_continuation, job) < 0) {
+            flux_future_destroy (f);
+            if (bulk->pending == 0)
+                goto error;
+            bulk->errnum = errno;
+            (void)snprintf (bulk->errbuf, sizeof (bulk->errbuf),
+                            "job %d: error starting validation", job->index);
+            break;
+        }
+        bulk->pending++;
+        job = zlist_next (bulk->jobs);
+    }
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, errmsg) < 0)
+        flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+    bulk_destroy (bulk);
+}
+
 static void exit_cb (void *arg)
 {
     struct job_ingest_ctx *ctx = arg;
@@ -651,6 +1213,64 @@ static void shutdown_cb (flux_t *h,
     }
 }
 
+static json_t *batch_hist_encode (const int *hist)
+{
+    json_t *a;
+    int n;
+
+    /* Trim trailing empty buckets.
+     */
+    for (n = BATCH_HIST_BUCKETS; n > 0; n--) {
+        if (hist[n - 1] > 0)
+            break;
+    }
+    if (!(a = json_array ()))
+        return NULL;
+    for (int i = 0; i < n; i++) {
+        json_t *count = json_integer (hist[i]);
+        if (!count || json_array_append_new (a, count) < 0) {
+            json_decref (count);
+            json_decref (a);
+            return NULL;
+        }
+    }
+    return a;
+}
+
+/* Describe the batch policy, credits and pacing, and, as log2 histograms,
+ * the number of jobs per batch and the time (ms) from batch creation
+ * to response.
+ */
+static json_t *batch_stats (struct job_ingest_ctx *ctx)
+{
+    json_t *size_hist = batch_hist_encode (ctx->batch_stats.size_hist);
+    json_t *latency_hist = batch_hist_encode (ctx->batch_stats.latency_hist);
+    json_t *o = NULL;
+
+    if (!size_hist
+        || !latency_hist
+        || !(o = json_pack ("{s:f s:i s:i s:I s:f s:i s:I s:I"
+                            " s:{s:i s:O} s:{s:f s:O}}",
+                            "timeout", ctx->batch_timeout,
+                            "max", ctx->batch_max,
+                            "inflight", ctx->batch_inflight,
+                            "count", (json_int_t)ctx->batch_stats.count,
+                            "pace-timeout", ctx->pace_timeout,
+                            "credits", ctx->credits,
+                            "paced", (json_int_t)ctx->batch_stats.paced,
+                            "rejected", (json_int_t)ctx->batch_stats.rejected,
+                            "size",
+                              "max", ctx->batch_stats.size_max,
+                              "hist", size_hist,
+                            "latency",
+                              "max", ctx->batch_stats.latency_max,
+                              "hist", latency_hist)))
+        errno = ENOMEM;
+    json_decref (size_hist);
+    json_decref (latency_hist);
+    return o;
+}
+
 static void getinfo_cb (flux_t *h,
                         flux_msg_handler_t *mh,
                         const flux_msg_t *msg,
@@ -658,6 +1278,8 @@ static void getinfo_cb (flux_t *h,
 {
     struct job_ingest_ctx *ctx = arg;
     uint64_t timestamp;
+    json_t *validator;
+    json_t *batch;
 
     if (flux_request_decode (msg, NULL, NULL) < 0)
         goto error;
@@ -666,8 +1288,20 @@ static void getinfo_cb (flux_t *h,
                            //       failure or flux running for 35 years?
         goto error;
     }
-    if (flux_respond_pack (h, msg, "{s:I}", "timestamp", timestamp) < 0)
+    if (!(validator = validate_stats (ctx->validate)))
+        goto error;
+    if (!(batch = batch_stats (ctx))) {
+        json_decref (validator);
+        goto error;
+    }
+    if (flux_respond_pack (h, msg, "{s:I s:i s:O s:O}",
+                           "timestamp", timestamp,
+                           "id_bits", ctx->gen.id_bits,
+                           "validator", validator,
+                           "batch", batch) < 0)
         flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
+    json_decref (validator);
+    json_decref (batch);
     return;
 error:
     if (flux_respond_error (h, msg, errno, NULL) < 0)
@@ -677,33 +1311,81 @@ error:
 static const struct flux_msg_handler_spec htab[] = {
     { FLUX_MSGTYPE_REQUEST,  "job-ingest.getinfo", getinfo_cb, 0},
     { FLUX_MSGTYPE_REQUEST,  "job-ingest.submit", submit_cb, FLUX_ROLE_USER },
+    { FLUX_MSGTYPE_REQUEST,
+      "job-ingest.submit-bulk",
+      submit_bulk_cb,
+      FLUX_ROLE_USER
+    },
     { FLUX_MSGTYPE_REQUEST,  "job-ingest.shutdown", shutdown_cb, 0 },
     FLUX_MSGHANDLER_TABLE_END,
 };
 
-/* Configure the validator.
- * Use compiled in path and string for validator program and args,
- * unless overridden with validator=path or schema=path on module load
- * command line.
+/* Parse module options, and configure the batch policy and validator.
+ * Jobspec is checked in-process by default, or with validator=builtin.
+ * An external validator program (e.g. the Python validator, with custom
+ * plugins) is used if validator=path is given on the module load command
+ * line, with args from validator-args=ARGS or the compiled in string.
  */
-int validate_initialize (flux_t *h,
-                         int argc,
-                         char **argv,
-                         struct validate **validate)
+static int parse_args (struct job_ingest_ctx *ctx, int argc, char **argv)
 {
+    flux_t *h = ctx->h;
     const char *usage_message = "Usage: flux module load [OPTIONS] job-ingest "
-                                " [validator-args=ARGS] [validator=PATH]";
-    const char *valpath;
+                                " [validator-args=ARGS] [validator=builtin|PATH]"
+                                " [validator-workers=N]"
+                                " [batch-timeout=FSD] [batch-max=N]"
+                                " [pace-timeout=FSD]";
+    const char *valpath = NULL;
     const char *valargs;
+    int max_workers = 0;
     struct validate *v;
     int i;
 
-    valpath = flux_conf_builtin_get ("jobspec_validate_path", FLUX_CONF_AUTO);
+    ctx->batch_timeout = default_batch_timeout;
+    ctx->batch_max = default_batch_max;
+    ctx->pace_timeout = default_pace_timeout;
+    ctx->credits = -1;
     valargs = flux_conf_builtin_get ("jobspec_validator_args", FLUX_CONF_AUTO);
     for (i = 0; i < argc; i++) {
         if (!strncmp (argv[i], "validator-args=", 15)) {
             valargs = argv[i] + 15;
         }
+        else if (!strncmp (argv[i], "validator-workers=", 18)) {
+            char *endptr;
+            errno = 0;
+            max_workers = strtol (argv[i] + 18, &endptr, 10);
+            if (errno != 0 || *endptr != '\0' || max_workers < 1) {
+                flux_log (h, LOG_ERR, "invalid option %s", argv[i]);
+                errno = EINVAL;
+                return -1;
+            }
+        }
+        else if (!strncmp (argv[i], "batch-timeout=", 14)) {
+            if (fsd_parse_duration (argv[i] + 14, &ctx->batch_timeout) < 0) {
+                flux_log (h, LOG_ERR, "invalid option %s", argv[i]);
+                errno = EINVAL;
+                return -1;
+            }
+        }
+        else if (!strncmp (argv[i], "batch-max=", 10)) {
+            char *endptr;
+            errno = 0;
+            ctx->batch_max = strtol (argv[i] + 10, &endptr, 10);
+            if (errno != 0 || *endptr != '\0' || ctx->batch_max < 0) {
+                flux_log (h, LOG_ERR, "invalid option %s", argv[i]);
+                errno = EINVAL;
+                return -1;
+            }
+        }
+        else if (!strncmp (argv[i], "pace-timeout=", 13)) {
+            if (fsd_parse_duration (argv[i] + 13, &ctx->pace_timeout) < 0) {
+                flux_log (h, LOG_ERR, "invalid option %s", argv[i]);
+                errno = EINVAL;
+                return -1;
+            }
+        }
+        else if (!strcmp (argv[i], "validator=builtin")) {
+            valpath = NULL;
+        }
         else if (!strncmp (argv[i], "validator=", 10)) {
             valpath = argv[i] + 10;
             if (access (valpath, X_OK) < 0) {
@@ -718,11 +1400,11 @@ int validate_initialize (flux_t *h,
             return -1;
         }
     }
-    if (!(v = validate_create (h, valpath, valargs))) {
+    if (!(v = validate_create (h, valpath, valargs, max_workers))) {
         flux_log_error (h, "validate_create");
         return -1;
     }
-    *validate = v;
+    ctx->validate = v;
     return 0;
 }
 
@@ -769,11 +1451,15 @@ int mod_main (flux_t *h, int argc, char **argv)
     }
     /* Initialize FLUID generator.
      * On rank 0, derive the starting timestamp from the job manager's
-     * 'max_jobid' plus one.  On other ranks, ask upstream job-ingest.
+     * 'max_jobid' plus one, and size the generator ID field to fit the
+     * instance size, leaving the remaining bits for the sequence number.
+     * On other ranks, ask upstream job-ingest for both.
      */
     if (rank == 0) {
         flux_future_t *f;
         flux_jobid_t max_jobid;
+        uint32_t size;
+        int id_bits = 0;
 
         if (!(f = flux_rpc (h, "job-manager.getinfo", NULL, 0, 0))) {
             flux_log_error (h, "flux_rpc");
@@ -788,7 +1474,16 @@ int mod_main (flux_t *h, int argc, char **argv)
             goto done;
         }
         flux_future_destroy (f);
-        if (fluid_init (&ctx.gen, 0, fluid_get_timestamp (max_jobid) + 1) < 0) {
+        if (flux_get_size (h, &size) < 0) {
+            flux_log_error (h, "flux_get_size");
+            goto done;
+        }
+        while (id_bits < FLUID_ID_BITS_DEFAULT && (1U<<id_bits) < size)
+            id_bits++;
+        if (fluid_init_bits (&ctx.gen,
+                             0,
+                             id_bits,
+                             fluid_get_timestamp (max_jobid) + 1) < 0) {
             flux_log (h, LOG_ERR, "fluid_init failed");
             errno = EINVAL;
         }
@@ -796,12 +1491,16 @@ int mod_main (flux_t *h, int argc, char **argv)
     else {
         flux_future_t *f;
         uint64_t timestamp;
+        int id_bits = FLUID_ID_BITS_DEFAULT;
 
         if (!(f = flux_rpc (h, "job-ingest.getinfo", NULL, 0, 0))) {
             flux_log_error (h, "flux_rpc");
             goto done;
         }
-        if (flux_rpc_get_unpack (f, "{s:I}", "timestamp", &timestamp) < 0) {
+        if (flux_rpc_get_unpack (f,
+                                 "{s:I s?:i}",
+                                 "timestamp", &timestamp,
+                                 "id_bits", &id_bits) < 0) {
             if (errno == ENOSYS)
                 flux_log_error (h, "job-ingest must be loaded on rank 0 first");
             else
@@ -813,13 +1512,13 @@ int mod_main (flux_t *h, int argc, char **argv)
         /* fluid_init() will fail on rank > 16K.
          * Just skip loading the job module on those ranks.
          */
-        if (fluid_init (&ctx.gen, rank, timestamp) < 0) {
+        if (fluid_init_bits (&ctx.gen, rank, id_bits, timestamp) < 0) {
             flux_log (h, LOG_ERR, "fluid_init failed");
             errno = EINVAL;
         }
     }
     flux_log (h, LOG_DEBUG, "fluid ts=%jums", (uint64_t)ctx.gen.timestamp);
-    if (validate_initialize (h, argc, argv, &ctx.validate) < 0)
+    if (parse_args (&ctx, argc, argv) < 0)
         goto done;
     if (flux_reactor_run (r, 0) < 0) {
         flux_log_error (h, "flux_reactor_run");
@@ -10,9 +10,12 @@
 
 /* validate - asynchronous jobspec validation interface
  *
- * Spawn worker(s) to validate jobspec.  Up to 'DEFAULT_WORKER_COUNT'
- * workers may be active at one time.  They are started lazily, on demand,
- * and stop after a period of inactivity (see "tunables" below).
+ * Spawn worker(s) to validate jobspec.  Up to 'max_workers' (by default
+ * DEFAULT_WORKER_COUNT) workers may be active at one time.  They are
+ * started lazily, on demand, when the backlog or the expected wait at
+ * every running worker grows too large, and stop after a period of
+ * inactivity (see "tunables" below).  The first worker lingers longer
+ * than the others, so the pool shrinks back quickly after a burst.
  *
  * The validator executable and its command line, including the
  * location of jobspec.jsonschema, are currently hardwired.
@@ -21,6 +24,10 @@
  * whitespace or NULL termination.  The encoding is normalized before
  * it is sent to the worker on a single line.
  *
+ * If no validator executable is configured, jobspec is instead checked
+ * in the module by jobspec_validate(), which applies the same rules as
+ * the default Python validator without a process round trip.
+ *
  * The future is fulfilled with the result of validation.  On success,
  * the container will be empty.  On failure, the reason the jobspec
  * did not pass validation (suitable for returning to the submitting user)
@@ -36,42 +43,57 @@
 #include <jansson.h>
 #include <flux/core.h>
 
+#include "src/common/libjob/jobspec_validate.h"
+
 #include "validate.h"
 #include "worker.h"
 
 /* Tunables:
  */
 
-/* The maximum number of concurrent workers.
+/* The default and upper limit of the maximum number of concurrent workers.
  */
-#define MAX_WORKER_COUNT 4
+#define DEFAULT_WORKER_COUNT 4
+#define MAX_WORKER_COUNT 64
 
 /* Start a new worker if backlog reaches this level for all active workers.
  */
 const int worker_queue_threshold = 32;
 
-/* Workers exit once they have been inactive for this many seconds.
+/* Start a new worker if a request would wait this long (ms), estimated
+ * from queue depth and recent latency, at every active worker.
+ */
+const double worker_wait_threshold = 100.;
+
+/* The first worker exits once it has been inactive for this many seconds,
+ * the others after worker_surge_timeout.
  */
 const double worker_inactivity_timeout = 5.0;
+const double worker_surge_timeout = 1.0;
 
 
 
 struct validate {
     flux_t *h;
+    bool builtin;               // use jobspec_validate(), not workers
+    int require_version;        // builtin: --require-version=N
+    int max_workers;
     struct worker *worker[MAX_WORKER_COUNT];
 };
 
 static void validate_killall (struct validate *v)
 {
-    flux_future_t *cf = flux_future_wait_all_create ();
+    flux_future_t *cf;
     flux_future_t *f;
     int i;
-    if (!cf) {
+    if (v->builtin)
+        return;
+    if (!(cf = flux_future_wait_all_create ())) {
         flux_log_error (v->h, "validate_destroy: flux_future_wait_all_create");
         return;
     }
     flux_future_set_flux (cf, v->h);
-    for (i = 0; i < MAX_WORKER_COUNT; i++) {
+    for (i = 0; i < v->max_workers; i++) {
         if ((f = worker_kill (v->worker[i], SIGKILL)))
             flux_future_push (cf, NULL, f);
     }
@@ -92,8 +114,10 @@ int validate_stop_notify (struct validate *v, process_exit_f cb, void *arg)
     int count;
 
     count = 0;
-    for (i = 0; i < MAX_WORKER_COUNT; i++)
-        count += worker_stop_notify (v->worker[i], cb, arg);
+    for (i = 0; i < v->max_workers; i++) {
+        if (v->worker[i])
+            count += worker_stop_notify (v->worker[i], cb, arg);
+    }
     return count;
 }
 
@@ -103,7 +127,7 @@ void validate_destroy (struct validate *v)
         int saved_errno = errno;
         int i;
         validate_killall (v);
-        for (i = 0; i < MAX_WORKER_COUNT; i++)
+        for (i = 0; i < v->max_workers; i++)
             worker_destroy (v->worker[i]);
         free (v);
         errno = saved_errno;
@@ -119,9 +143,53 @@ static bool str_ends_with (const char *str, const char *suffix)
         (!strncmp ((str + str_len) - suffix_len, suffix, suffix_len));
 }
 
+/* The builtin validator accepts the --require-version argument of
+ * validate-jobspec.py.
+ */
+static int parse_builtin_args (struct validate *v, const char *args)
+{
+    char *argz = NULL;
+    size_t argz_len = 0;
+    char *arg = NULL;
+    int rc = -1;
+
+    if (argz_create_sep (args, ',', &argz, &argz_len) != 0) {
+        errno = ENOMEM;
+        return -1;
+    }
+    while ((arg = argz_next (argz, argz_len, arg))) {
+        char *endptr;
+
+        if (!strncmp (arg, "--require-version=", 18))
+            arg += 18;
+        else if (!strcmp (arg, "--require-version")
+                 && (arg = argz_next (argz, argz_len, arg)))
+            ;
+        else {
+            flux_log (v->h, LOG_ERR, "builtin validator: invalid argument %s",
+                      arg ? arg : "--require-version");
+            errno = EINVAL;
+            goto done;
+        }
+        errno = 0;
+        v->require_version = strtol (arg, &endptr, 10);
+        if (errno != 0 || *endptr != '\0' || v->require_version != 1) {
+            flux_log (v->h, LOG_ERR,
+                      "builtin validator: unsupported version %s", arg);
+            errno = EINVAL;
+            goto done;
+        }
+    }
+    rc = 0;
+done:
+    free (argz);
+    return rc;
+}
+
 struct validate *validate_create (flux_t *h,
                                   const char *validate_path,
-                                  const char *validator_args)
+                                  const char *validator_args,
+                                  int max_workers)
 {
     struct validate *v;
     char *argv[5];
@@ -131,11 +199,21 @@ struct validate *validate_create (flux_t *h,
     char *validator_arg = NULL;
     size_t validator_argz_len = 0;
 
+    if (max_workers < 0 || max_workers > MAX_WORKER_COUNT) {
+        errno = EINVAL;
+        return NULL;
+    }
     if (!(v = calloc (1, sizeof (*v))))
         return NULL;
     v->h = h;
+    v->max_workers = max_workers > 0 ? max_workers : DEFAULT_WORKER_COUNT;
 
-    assert (validate_path != NULL);
+    if (!validate_path) {
+        v->builtin = true;
+        if (validator_args && parse_builtin_args (v, validator_args) < 0)
+            goto error;
+        return v;
+    }
 
     if (str_ends_with (validate_path, ".py"))
         argv[argc++] = PYTHON_INTERPRETER;
@@ -162,8 +240,10 @@ struct validate *validate_create (flux_t *h,
     }
     argv[argc] = NULL;
 
-    for (i = 0; i < MAX_WORKER_COUNT; i++) {
-        if (!(v->worker[i] = worker_create (h, worker_inactivity_timeout,
+    for (i = 0; i < v->max_workers; i++) {
+        double timeout = i == 0 ? worker_inactivity_timeout
+                                : worker_surge_timeout;
+        if (!(v->worker[i] = worker_create (h, timeout,
                                             validate_path,
                                             argc, argv)))
             goto error;
@@ -179,27 +259,68 @@ error:
 /* Select worker with least backlog.  If none is running, or the best
  * has a backlog at or beyond threshold, activate a new one, if possible.
  */
+/* Estimate how long (ms) a new request would wait at worker 'w'.
+ */
+static double expected_wait (struct worker *w)
+{
+    return worker_queue_depth (w) * worker_latency (w);
+}
+
 struct worker *select_best_worker (struct validate *v)
 {
     struct worker *best = NULL;
     struct worker *idle = NULL;
     int i;
 
-    for (i = 0; i < MAX_WORKER_COUNT; i++) {
+    for (i = 0; i < v->max_workers; i++) {
         if (worker_is_running (v->worker[i])) {
-            if (!best || (worker_queue_depth (v->worker[i])
-                        < worker_queue_depth (best)))
+            if (!best
+                || worker_queue_depth (v->worker[i]) < worker_queue_depth (best)
+                || (worker_queue_depth (v->worker[i])
+                        == worker_queue_depth (best)
+                    && expected_wait (v->worker[i]) < expected_wait (best)))
                 best = v->worker[i];
         }
         else if (!idle)
             idle = v->worker[i];
     }
-    if (idle && (!best || worker_queue_depth (best) >= worker_queue_threshold))
+    if (idle && (!best
+                 || worker_queue_depth (best) >= worker_queue_threshold
+                 || expected_wait (best) >= worker_wait_threshold))
         best = idle;
 
     return best;
 }
 
+json_t *validate_stats (struct validate *v)
+{
+    json_t *o;
+    json_t *workers = NULL;
+    int i;
+
+    if (!(workers = json_array ()))
+        goto nomem;
+    for (i = 0; i < v->max_workers && !v->builtin; i++) {
+        json_t *entry;
+        if (!(entry = worker_stats (v->worker[i]))
+            || json_array_append_new (workers, entry) < 0) {
+            json_decref (entry);
+            goto nomem;
+        }
+    }
+    if (!(o = json_pack ("{s:b s:i s:O}",
+                         "builtin", v->builtin,
+                         "max-workers", v->builtin ? 0 : v->max_workers,
+                         "workers", workers)))
+        goto nomem;
+    json_decref (workers);
+    return o;
+nomem:
+    json_decref (workers);
+    errno = ENOMEM;
+    return NULL;
+}
+
 flux_future_t *validate_jobspec (struct validate *v, const char *buf, int len)
 {
     flux_future_t *f;
@@ -223,6 +344,21 @@ flux_future_t *validate_jobspec (struct validate *v, const char *buf, int len)
         flux_future_fulfill_error (f, EINVAL, errbuf);
         return f;
     }
+    if (v->builtin) {
+        json_error_t verror;
+
+        if (!(f = flux_future_create (NULL, NULL))) {
+            json_decref (o);
+            return NULL;
+        }
+        flux_future_set_flux (f, v->h);
+        if (jobspec_validate (o, v->require_version, &verror) < 0)
+            flux_future_fulfill_error (f, EINVAL, verror.text);
+        else
+            flux_future_fulfill (f, NULL, NULL);
+        json_decref (o);
+        return f;
+    }
     if (!(s = json_dumps (o, JSON_COMPACT)))
         goto error;
     w = select_best_worker (v);
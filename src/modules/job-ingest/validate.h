@@ -12,6 +12,7 @@
 #define _JOB_INGEST_VALIDATE_H
 
 #include <flux/core.h>
+#include <jansson.h>
 
 #include "types.h"
 
@@ -28,9 +29,19 @@ flux_future_t *validate_jobspec (struct validate *v, const char *buf, int len);
  */
 int validate_stop_notify (struct validate *v, process_exit_f cb, void *arg);
 
+/* Return a new JSON object describing the validator worker pool,
+ * including per-worker queue depth and latency percentiles.
+ */
+json_t *validate_stats (struct validate *v);
+
+/* Create a validator.  If 'validate_path' is NULL, jobspec is validated
+ * in-process.  Otherwise, up to 'max_workers' (0 = default) instances
+ * of the program are spawned as needed.
+ */
 struct validate *validate_create (flux_t *h,
                                   const char *validate_path,
-                                  const char *validator_args);
+                                  const char *validator_args,
+                                  int max_workers);
 
 void validate_destroy (struct validate *v);
 
@@ -32,6 +32,10 @@
  * The broker exec service is used to spawn workers on the local rank,
  * using the libsubprocess API.
  *
+ * The time from request to result is recorded for each completed request.
+ * A moving average is kept for load balancing, and the most recent
+ * LATENCY_SAMPLES are kept for reporting percentiles in worker_stats().
+ *
  * Caveats:
  * - Work is sent to the coprocess with flux_subprocess_write() regardless
  *   of the current queue depth, which may challenge subprocess buffer
@@ -45,16 +49,33 @@
 #include <czmq.h>
 #include <jansson.h>
 #include <flux/core.h>
+
+#include "src/common/libutil/monotime.h"
+
 #include "worker.h"
 
+#define LATENCY_SAMPLES 256
+
+/* Weight of the newest sample in the moving average latency.
+ */
+static const double latency_alpha = 0.1;
+
 const char *worker_auxkey = "flux::worker";
 
+struct request {
+    flux_future_t *f;
+    struct timespec t0;
+};
+
 struct worker {
     flux_t *h;
     char *name;
     flux_subprocess_t *p;
     flux_cmd_t *cmd;
-    zlist_t *queue; // queue of futures (head is currently running)
+    zlist_t *queue; // queue of requests (head is currently running)
+    int64_t requests;                   // count of completed requests
+    double latency_avg;                 // moving average (ms)
+    double latency[LATENCY_SAMPLES];    // ring of recent samples (ms)
     flux_watcher_t *timer;
     double inactivity_timeout;
     zlist_t *trash;
@@ -65,6 +86,28 @@ struct worker {
 static int worker_start (struct worker *w);
 static void worker_stop (struct worker *w);
 
+/* Pop the request at the head of the queue, record its latency,
+ * and return its future.  The caller must drop the queue's reference.
+ */
+static flux_future_t *worker_pop (struct worker *w)
+{
+    struct request *req;
+    flux_future_t *f;
+    double t;
+
+    if (!(req = zlist_pop (w->queue)))
+        return NULL;
+    t = monotime_since (req->t0);
+    w->latency[w->requests % LATENCY_SAMPLES] = t;
+    if (w->requests++ == 0)
+        w->latency_avg = t;
+    else
+        w->latency_avg += latency_alpha * (t - w->latency_avg);
+    f = req->f;
+    free (req);
+    return f;
+}
+
 /* Subprocess completed.
  * Destroy the subprocess, but don't use w->p since that may be a diferent
  * one, if worker_stop() was followed immediately by worker_start().
@@ -199,7 +242,7 @@ static void worker_unexpected_exit (struct worker *w)
     /*  Respond to any pending requests immediately with error above.
      *  The remainder of worker cleanup will happen in the exit callback.
      */
-    while ((f = zlist_pop (w->queue))) {
+    while ((f = worker_pop (w))) {
         worker_fulfill_future (w, f, json_err);
         flux_future_decref (f);
     }
@@ -241,7 +284,7 @@ static void worker_output_cb (flux_subprocess_t *p, const char *stream)
     if (!strcmp (stream, "stdout")) {
         flux_future_t *f;
 
-        if (!(f = zlist_pop (w->queue))) {
+        if (!(f = worker_pop (w))) {
             flux_log (w->h, LOG_ERR, "%s: dropping orphan response: '%s'",
                       w->name, s);
             return;
@@ -267,7 +310,8 @@ flux_subprocess_ops_t worker_ops = {
 flux_future_t *worker_request (struct worker *w, const char *s)
 {
     int bufsz = strlen (s) + 1;
-    char *buf;
+    char *buf = NULL;
+    struct request *req = NULL;
     flux_future_t *f;
     int saved_errno;
 
@@ -278,20 +322,23 @@ flux_future_t *worker_request (struct worker *w, const char *s)
     if (!(f = flux_future_create (NULL, NULL)))
         return NULL;
     flux_future_set_flux (f, w->h);
-    if (!(buf = malloc (bufsz)))
+    if (!(buf = malloc (bufsz)) || !(req = calloc (1, sizeof (*req))))
         goto error;
     memcpy (buf, s, bufsz - 1);
     buf[bufsz - 1] = '\n';
+    req->f = f;
+    monotime (&req->t0);
     worker_active (w);
     if (flux_subprocess_write (w->p, "stdin", buf, bufsz) != bufsz)
         goto error;
-    if (zlist_append (w->queue, f) < 0)
+    if (zlist_append (w->queue, req) < 0)
         goto error;
     flux_future_incref (f); // queue takes a reference on the future
     free (buf);
     return f;
 error:
     saved_errno = errno;
+    free (req);
     free (buf);
     flux_future_destroy (f);
     errno = saved_errno;
@@ -369,17 +416,71 @@ bool worker_is_running (struct worker *w)
     return (w->p ? true : false);
 }
 
+double worker_latency (struct worker *w)
+{
+    return w->latency_avg;
+}
+
+static int compare_double (const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+
+    return (x < y ? -1 : x > y ? 1 : 0);
+}
+
+/* Nearest-rank percentile 'pct' of 'n' sorted samples.
+ */
+static double percentile (const double *sorted, int n, double pct)
+{
+    int rank;
+
+    if (n == 0)
+        return 0.;
+    rank = (int)(pct / 100. * n + 0.5);
+    if (rank < 1)
+        rank = 1;
+    if (rank > n)
+        rank = n;
+    return sorted[rank - 1];
+}
+
+json_t *worker_stats (struct worker *w)
+{
+    double sorted[LATENCY_SAMPLES];
+    int n = w->requests < LATENCY_SAMPLES ? w->requests : LATENCY_SAMPLES;
+    json_t *o;
+
+    memcpy (sorted, w->latency, n * sizeof (sorted[0]));
+    qsort (sorted, n, sizeof (sorted[0]), compare_double);
+    if (!(o = json_pack ("{s:b s:i s:I s:{s:f s:f s:f s:f}}",
+                         "running", worker_is_running (w),
+                         "queue-depth", worker_queue_depth (w),
+                         "requests", (json_int_t)w->requests,
+                         "latency",
+                           "p50", percentile (sorted, n, 50.),
+                           "p90", percentile (sorted, n, 90.),
+                           "p99", percentile (sorted, n, 99.),
+                           "max", n > 0 ? sorted[n - 1] : 0.))) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    return o;
+}
+
 void worker_destroy (struct worker *w)
 {
     if (w) {
         int saved_errno = errno;
         flux_subprocess_t *p;
-        flux_future_t *f;
+        struct request *req;
 
         worker_stop (w); // puts w->p in w->trash
         flux_cmd_destroy (w->cmd);
-        while ((f = zlist_pop (w->queue)))
-            flux_future_decref (f);
+        while ((req = zlist_pop (w->queue))) {
+            flux_future_decref (req->f);
+            free (req);
+        }
         zlist_destroy (&w->queue);
         while ((p = zlist_pop (w->trash)))
             flux_subprocess_destroy (p);
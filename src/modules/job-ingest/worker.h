@@ -12,6 +12,7 @@
 #define _JOB_INGEST_WORKER_H
 
 #include <flux/core.h>
+#include <jansson.h>
 
 #include "types.h"
 
@@ -23,6 +24,15 @@ flux_future_t *worker_request (struct worker *w, const char *s);
 int worker_queue_depth (struct worker *w);
 bool worker_is_running (struct worker *w);
 
+/* Moving average of request latency in milliseconds (0 if none completed).
+ */
+double worker_latency (struct worker *w);
+
+/* Return a new JSON object with the worker's queue depth, completed
+ * request count, and latency percentiles (ms) over recent requests.
+ */
+json_t *worker_stats (struct worker *w);
+
 flux_future_t *worker_kill (struct worker *w, int signo);
 void worker_destroy (struct worker *w);
 struct worker *worker_create (flux_t *h, double inactivity_timeout,
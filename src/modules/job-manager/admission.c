@@ -0,0 +1,355 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* admission.c - limit the number of pending jobs
+ *
+ * A job is pending while in the DEPEND or SCHED state.  With the
+ * max-pending=N and max-pending-user=N module options, job-manager.submit
+ * refuses jobs that would raise the number of pending jobs, or the number
+ * pending for their user, above N.  job-ingest fails refused jobs with
+ * EAGAIN and removes them from the KVS, so submissions that outpace the
+ * scheduler no longer grow the job hash, alloc queue, and KVS without
+ * bound.  All jobs of one user in a submit batch are admitted or refused
+ * together, so a bulk submission is never partly accepted.
+ *
+ * The job-manager.submit response is
+ *   {"credits":i, "rejected":[[id, errmsg], ...]}
+ * where "credits" is the number of jobs that may still be admitted
+ * before the global limit is reached, or -1 if there is none.
+ * job-ingest holds batches back while it has no credits.  A response
+ * with no credits is counted as "paced".
+ *
+ * job-manager.stats.get includes {"admission":{"max-pending":i,
+ * "max-pending-user":i, "pending":i, "rejected":I, "paced":I}}.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <czmq.h>
+#include <jansson.h>
+#include <flux/core.h>
+
+#include "src/common/libutil/errno_safe.h"
+
+#include "job.h"
+#include "admission.h"
+
+struct admission {
+    struct job_manager *ctx;
+    int max_pending;            // 0 = unlimited
+    int max_pending_user;       // 0 = unlimited
+    int pending;
+    zhashx_t *users;            // userid => struct user
+    int64_t rejected;           // jobs refused
+    int64_t paced;              // submit responses with no credits
+};
+
+struct user {
+    int pending;
+};
+
+/* Jobs of one user in a submit request, while it is being filtered.
+ */
+struct tally {
+    int count;
+    bool decided;
+    bool admit;
+    char errmsg[128];
+};
+
+static void item_destructor (void **item)
+{
+    if (item) {
+        free (*item);
+        *item = NULL;
+    }
+}
+
+static void userid_key (char *buf, size_t size, uint32_t userid)
+{
+    (void)snprintf (buf, size, "%lu", (unsigned long)userid);
+}
+
+static int user_pending (struct admission *admission, uint32_t userid)
+{
+    struct user *user;
+    char key[16];
+
+    userid_key (key, sizeof (key), userid);
+    if (!(user = zhashx_lookup (admission->users, key)))
+        return 0;
+    return user->pending;
+}
+
+static void user_adjust (struct admission *admission,
+                         uint32_t userid,
+                         int delta)
+{
+    struct user *user;
+    char key[16];
+
+    userid_key (key, sizeof (key), userid);
+    if (!(user = zhashx_lookup (admission->users, key))) {
+        if (delta < 0 || !(user = calloc (1, sizeof (*user))))
+            return;
+        (void)zhashx_insert (admission->users, key, user);
+    }
+    user->pending += delta;
+    if (user->pending <= 0)
+        zhashx_delete (admission->users, key);
+}
+
+void admission_set_limits (struct admission *admission,
+                           int max_pending,
+                           int max_pending_user)
+{
+    admission->max_pending = max_pending;
+    admission->max_pending_user = max_pending_user;
+}
+
+void admission_update (struct admission *admission,
+                       struct job *job,
+                       flux_job_state_t old_state)
+{
+    bool was_pending;
+    bool is_pending;
+
+    if (!admission)
+        return;
+    was_pending = (old_state & FLUX_JOB_PENDING) ? true : false;
+    is_pending = (job->state & FLUX_JOB_PENDING) ? true : false;
+    if (was_pending == is_pending)
+        return;
+    if (is_pending) {
+        admission->pending++;
+        user_adjust (admission, job->userid, 1);
+    }
+    else {
+        admission->pending--;
+        user_adjust (admission, job->userid, -1);
+    }
+}
+
+static struct tally *tally_get (zhashx_t *tallies, uint32_t userid)
+{
+    struct tally *tally;
+    char key[16];
+
+    userid_key (key, sizeof (key), userid);
+    if (!(tally = zhashx_lookup (tallies, key))) {
+        if (!(tally = calloc (1, sizeof (*tally))))
+            return NULL;
+        (void)zhashx_insert (tallies, key, tally);
+    }
+    return tally;
+}
+
+/* Decide whether to admit the 'tally' jobs of 'userid', given that
+ * 'admitted' jobs of earlier users in the request are being admitted.
+ */
+static void tally_decide (struct admission *admission,
+                          struct tally *tally,
+                          uint32_t userid,
+                          int admitted)
+{
+    int pending = user_pending (admission, userid);
+
+    tally->decided = true;
+    if (admission->max_pending_user > 0
+        && pending + tally->count > admission->max_pending_user) {
+        snprintf (tally->errmsg,
+                  sizeof (tally->errmsg),
+                  "user %lu has %d pending jobs (max-pending-user=%d)",
+                  (unsigned long)userid,
+                  pending,
+                  admission->max_pending_user);
+        return;
+    }
+    if (admission->max_pending > 0
+        && admission->pending + admitted + tally->count
+           > admission->max_pending) {
+        snprintf (tally->errmsg,
+                  sizeof (tally->errmsg),
+                  "job queue is full: %d pending jobs (max-pending=%d)",
+                  admission->pending,
+                  admission->max_pending);
+        return;
+    }
+    tally->admit = true;
+}
+
+int admission_filter (struct admission *admission,
+                      json_t *jobs,
+                      json_t **admittedp,
+                      json_t **rejectedp)
+{
+    zhashx_t *tallies = NULL;
+    json_t *admitted = NULL;
+    json_t *rejected = NULL;
+    size_t index;
+    json_t *el;
+    int count = 0;
+
+    if (!(rejected = json_array ()))
+        goto nomem;
+    if (admission->max_pending == 0 && admission->max_pending_user == 0) {
+        *admittedp = json_incref (jobs);
+        *rejectedp = rejected;
+        return 0;
+    }
+    if (!(admitted = json_array ()) || !(tallies = zhashx_new ()))
+        goto nomem;
+    zhashx_set_destructor (tallies, item_destructor);
+
+    /* Count the jobs of each user, then decide on each user's jobs, in
+     * order of the user's first job in the request.
+     */
+    json_array_foreach (jobs, index, el) {
+        struct tally *tally;
+        int userid;
+
+        if (json_unpack (el, "{s:i}", "userid", &userid) < 0) {
+            errno = EPROTO;
+            goto error;
+        }
+        if (!(tally = tally_get (tallies, userid)))
+            goto nomem;
+        tally->count++;
+    }
+    json_array_foreach (jobs, index, el) {
+        struct tally *tally;
+        flux_jobid_t id;
+        int userid;
+
+        if (json_unpack (el, "{s:I s:i}", "id", &id, "userid", &userid) < 0
+            || !(tally = tally_get (tallies, userid))) {
+            errno = EPROTO;
+            goto error;
+        }
+        if (!tally->decided) {
+            tally_decide (admission, tally, userid, count);
+            if (tally->admit)
+                count += tally->count;
+        }
+        if (tally->admit) {
+            if (json_array_append (admitted, el) < 0)
+                goto nomem;
+        }
+        else {
+            json_t *entry;
+            if (!(entry = json_pack ("[I,s]", id, tally->errmsg))
+                || json_array_append_new (rejected, entry) < 0) {
+                json_decref (entry);
+                goto nomem;
+            }
+        }
+    }
+    if (json_array_size (rejected) > 0) {
+        admission->rejected += json_array_size (rejected);
+        flux_log (admission->ctx->h,
+                  LOG_DEBUG,
+                  "admission: refused %d of %d jobs",
+                  (int)json_array_size (rejected),
+                  (int)json_array_size (jobs));
+    }
+    zhashx_destroy (&tallies);
+    *admittedp = admitted;
+    *rejectedp = rejected;
+    return 0;
+nomem:
+    errno = ENOMEM;
+error:
+    ERRNO_SAFE_WRAP (zhashx_destroy, &tallies);
+    ERRNO_SAFE_WRAP (json_decref, admitted);
+    ERRNO_SAFE_WRAP (json_decref, rejected);
+    return -1;
+}
+
+int admission_credits (struct admission *admission)
+{
+    if (admission->max_pending == 0)
+        return -1;
+    if (admission->pending >= admission->max_pending)
+        return 0;
+    return admission->max_pending - admission->pending;
+}
+
+int admission_respond (struct admission *admission,
+                       const flux_msg_t *msg,
+                       json_t *rejected)
+{
+    int credits = admission_credits (admission);
+
+    if (credits == 0)
+        admission->paced++;
+    return flux_respond_pack (admission->ctx->h,
+                              msg,
+                              "{s:i s:O}",
+                              "credits", credits,
+                              "rejected", rejected);
+}
+
+json_t *admission_stats_encode (struct admission *admission)
+{
+    json_t *o;
+
+    if (!(o = json_pack ("{s:i s:i s:i s:I s:I}",
+                         "max-pending", admission->max_pending,
+                         "max-pending-user", admission->max_pending_user,
+                         "pending", admission->pending,
+                         "rejected", (json_int_t)admission->rejected,
+                         "paced", (json_int_t)admission->paced))) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    return o;
+}
+
+void admission_stats_clear (struct admission *admission)
+{
+    admission->rejected = 0;
+    admission->paced = 0;
+}
+
+void admission_ctx_destroy (struct admission *admission)
+{
+    if (admission) {
+        int saved_errno = errno;
+        zhashx_destroy (&admission->users);
+        free (admission);
+        errno = saved_errno;
+    }
+}
+
+struct admission *admission_ctx_create (struct job_manager *ctx)
+{
+    struct admission *admission;
+
+    if (!(admission = calloc (1, sizeof (*admission))))
+        return NULL;
+    admission->ctx = ctx;
+    if (!(admission->users = zhashx_new ())) {
+        errno = ENOMEM;
+        goto error;
+    }
+    zhashx_set_destructor (admission->users, item_destructor);
+    return admission;
+error:
+    admission_ctx_destroy (admission);
+    return NULL;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
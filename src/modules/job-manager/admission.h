@@ -0,0 +1,67 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _FLUX_JOB_MANAGER_ADMISSION_H
+#define _FLUX_JOB_MANAGER_ADMISSION_H
+
+#include <jansson.h>
+#include <flux/core.h>
+
+#include "job.h"
+#include "job-manager.h"
+
+/* Set the global and per-user limits on pending jobs (0 = unlimited).
+ */
+void admission_set_limits (struct admission *admission,
+                           int max_pending,
+                           int max_pending_user);
+
+/* Update pending job counts after 'job' changed state from 'old_state'.
+ * 'admission' may be NULL, e.g. in unit tests.
+ */
+void admission_update (struct admission *admission,
+                       struct job *job,
+                       flux_job_state_t old_state);
+
+/* Split the 'jobs' array of a job-manager.submit request into jobs that
+ * may be admitted, and [id, errmsg] entries for each job that may not,
+ * in request order.  All jobs of one user are admitted or refused
+ * together.  The caller must json_decref() both arrays.
+ */
+int admission_filter (struct admission *admission,
+                      json_t *jobs,
+                      json_t **admittedp,
+                      json_t **rejectedp);
+
+/* Return the number of jobs that may still be admitted before the
+ * global limit is reached, or -1 if there is no limit.
+ */
+int admission_credits (struct admission *admission);
+
+/* Respond to job-manager.submit request 'msg' with the 'rejected' jobs
+ * from admission_filter(), and the current credits.
+ */
+int admission_respond (struct admission *admission,
+                       const flux_msg_t *msg,
+                       json_t *rejected);
+
+/* Encode/clear stats for job-manager.stats.get/clear.
+ */
+json_t *admission_stats_encode (struct admission *admission);
+void admission_stats_clear (struct admission *admission);
+
+struct admission *admission_ctx_create (struct job_manager *ctx);
+void admission_ctx_destroy (struct admission *admission);
+
+#endif /* ! _FLUX_JOB_MANAGER_ADMISSION_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -26,11 +26,14 @@
 #include <flux/schedutil.h>
 #include <assert.h>
 
+#include "src/common/libutil/skiplist.h"
+
 #include "job.h"
 #include "alloc.h"
 #include "event.h"
 #include "drain.h"
 #include "annotate.h"
+#include "latency.h"
 
 typedef enum {
     SCHED_SINGLE,       // only allow one outstanding sched.alloc request
@@ -40,8 +43,11 @@ typedef enum {
 struct alloc {
     struct job_manager *ctx;
     flux_msg_handler_t **handlers;
-    zlistx_t *queue;
+    struct skiplist *queue; // jobs in priority, then t_submit order
     sched_interface_t mode;
+    int batch;          // max jobs per alloc/free/cancel-batch, 0=no batching
+    json_t *free_batch; // ids of jobs with free request not yet sent
+    json_t *cancel_batch; // ids of jobs with cancel request not yet sent
     bool ready;
     bool disable;
     char *disable_reason;
@@ -52,6 +58,10 @@ struct alloc {
     unsigned int free_pending_count;
 };
 
+/* Upper bound on the batch size a scheduler may negotiate in sched-ready.
+ */
+static const int max_batch = 1024;
+
 /* Initiate teardown.  Clear any alloc/free requests, and clear
  * the alloc->ready flag to stop prep/check from allocating.
  */
@@ -70,18 +80,17 @@ static void interface_teardown (struct alloc *alloc, char *s, int errnum)
              * so they will automatically send alloc again.
              */
             if (job->alloc_pending) {
-                bool fwd = job->priority > FLUX_JOB_PRIORITY_DEFAULT ? true
-                                                                     : false;
                 bool cleared = false;
 
                 assert (job->handle == NULL);
-                if (!(job->handle = zlistx_insert (alloc->queue, job, fwd)))
+                if (!(job->handle = skiplist_insert (alloc->queue,
+                                                     job_incref (job))))
                     flux_log_error (ctx->h, "%s: queue_insert", __FUNCTION__);
                 job->alloc_pending = 0;
                 job->alloc_queued = 1;
                 annotations_clear (job, &cleared);
                 if (cleared) {
-                    if (event_batch_pub_annotations (ctx->event, job) < 0)
+                    if (event_batch_pub_annotations (ctx->event, job, NULL) < 0)
                         flux_log_error (ctx->h,
                                         "%s: event_batch_pub_annotations",
                                         __FUNCTION__);
@@ -96,44 +105,88 @@ static void interface_teardown (struct alloc *alloc, char *s, int errnum)
         alloc->ready = false;
         alloc->alloc_pending_count = 0;
         alloc->free_pending_count = 0;
+        json_array_clear (alloc->free_batch);
+        json_array_clear (alloc->cancel_batch);
         drain_check (alloc->ctx->drain);
     }
 }
 
-/* Handle a sched.free response.
+/* Handle the sched.free response for job 'id'.
  */
-static void free_response_cb (flux_t *h, flux_msg_handler_t *mh,
-                              const flux_msg_t *msg, void *arg)
+static int free_response (struct job_manager *ctx, flux_jobid_t id)
 {
-    struct job_manager *ctx = arg;
-    flux_jobid_t id = 0;
+    flux_t *h = ctx->h;
     struct job *job;
 
-    if (flux_response_decode (msg, NULL, NULL) < 0)
-        goto teardown;
-    if (flux_msg_unpack (msg, "{s:I}", "id", &id) < 0)
-        goto teardown;
     if (!(job = zhashx_lookup (ctx->active_jobs, &id))) {
         flux_log (h, LOG_ERR, "sched.free-response: id=%ju not active",
                   (uintmax_t)id);
         errno = EINVAL;
-        goto teardown;
+        return -1;
     }
     if (!job->has_resources) {
         flux_log (h, LOG_ERR, "sched.free-response: id=%ju not allocated",
                   (uintmax_t)id);
         errno = EINVAL;
-        goto teardown;
+        return -1;
     }
     job->free_pending = 0;
     ctx->alloc->free_pending_count--;
     if (event_job_post_pack (ctx->event, job, "free", NULL) < 0)
+        return -1;
+    return 0;
+}
+
+/* Handle a sched.free response.
+ */
+static void free_response_cb (flux_t *h, flux_msg_handler_t *mh,
+                              const flux_msg_t *msg, void *arg)
+{
+    struct job_manager *ctx = arg;
+    flux_jobid_t id = 0;
+
+    if (flux_response_decode (msg, NULL, NULL) < 0)
+        goto teardown;
+    if (flux_msg_unpack (msg, "{s:I}", "id", &id) < 0)
+        goto teardown;
+    if (free_response (ctx, id) < 0)
         goto teardown;
     return;
 teardown:
     interface_teardown (ctx->alloc, "free response error", errno);
 }
 
+/* Handle a sched.free-batch response, a list of freed job ids.
+ */
+static void free_batch_response_cb (flux_t *h, flux_msg_handler_t *mh,
+                                    const flux_msg_t *msg, void *arg)
+{
+    struct job_manager *ctx = arg;
+    json_t *ids;
+    json_t *entry;
+    size_t index;
+
+    if (flux_response_decode (msg, NULL, NULL) < 0)
+        goto teardown;
+    if (flux_msg_unpack (msg, "{s:o}", "ids", &ids) < 0)
+        goto teardown;
+    if (!json_is_array (ids)) {
+        errno = EPROTO;
+        goto teardown;
+    }
+    json_array_foreach (ids, index, entry) {
+        if (!json_is_integer (entry)) {
+            errno = EPROTO;
+            goto teardown;
+        }
+        if (free_response (ctx, json_integer_value (entry)) < 0)
+            goto teardown;
+    }
+    return;
+teardown:
+    interface_teardown (ctx->alloc, "free response error", errno);
+}
+
 /* Send sched.free request for job.
  * Update flags.
  */
@@ -154,13 +207,74 @@ error:
     return -1;
 }
 
-/* Send sched.cancel request for job.
+/* Send one sched.free-batch request for the jobs in alloc->free_batch.
+ */
+static int free_request_flush (struct alloc *alloc)
+{
+    flux_msg_t *msg;
+
+    if (json_array_size (alloc->free_batch) == 0)
+        return 0;
+    if (!(msg = flux_request_encode ("sched.free-batch", NULL)))
+        return -1;
+    if (flux_msg_pack (msg, "{s:O}", "ids", alloc->free_batch) < 0)
+        goto error;
+    if (flux_send (alloc->ctx->h, msg, 0) < 0)
+        goto error;
+    json_array_clear (alloc->free_batch);
+    flux_msg_destroy (msg);
+    return 0;
+error:
+    flux_msg_destroy (msg);
+    return -1;
+}
+
+/* Send one sched.cancel-batch request for the jobs in alloc->cancel_batch.
+ * Like sched.cancel, it gets no response.
+ */
+static int cancel_request_flush (struct alloc *alloc)
+{
+    flux_future_t *f;
+    flux_t *h = alloc->ctx->h;
+
+    if (json_array_size (alloc->cancel_batch) == 0)
+        return 0;
+    if (!(f = flux_rpc_pack (h,
+                             "sched.cancel-batch",
+                             FLUX_NODEID_ANY,
+                             FLUX_RPC_NORESPONSE,
+                             "{s:O}",
+                             "ids",
+                             alloc->cancel_batch))) {
+        flux_log_error (h, "sending sched.cancel-batch");
+        return -1;
+    }
+    flux_future_destroy (f);
+    json_array_clear (alloc->cancel_batch);
+    return 0;
+}
+
+/* Send sched.cancel request for job, or if batching was negotiated,
+ * add it to the next sched.cancel-batch request.
 */
 int cancel_request (struct alloc *alloc, struct job *job)
 {
     flux_future_t *f;
     flux_t *h = alloc->ctx->h;
 
+    if (alloc->batch > 0) {
+        json_t *id;
+
+        if (!(id = json_integer (job->id))
+            || json_array_append_new (alloc->cancel_batch, id) < 0) {
+            json_decref (id);
+            errno = ENOMEM;
+            return -1;
+        }
+        if (json_array_size (alloc->cancel_batch) >= alloc->batch)
+            return cancel_request_flush (alloc);
+        return 0;
+    }
     if (!(f = flux_rpc_pack (h,
                              "sched.cancel",
                              FLUX_NODEID_ANY,
@@ -175,90 +289,88 @@ int cancel_request (struct alloc *alloc, struct job *job)
     return 0;
 }
 
-/* Handle a sched.alloc response.
- * Update flags.
+/* Handle one sched.alloc response for job 'id'.
+ * Update flags.  If the scheduler included 'R', it is held on the job
+ * until resources are freed, for job-manager.journal and sched-hello.
  */
-static void alloc_response_cb (flux_t *h, flux_msg_handler_t *mh,
-                               const flux_msg_t *msg, void *arg)
+static int alloc_response (struct job_manager *ctx,
+                           flux_jobid_t id,
+                           int type,
+                           const char *note,
+                           json_t *annotations,
+                           json_t *R)
 {
-    struct job_manager *ctx = arg;
+    flux_t *h = ctx->h;
     struct alloc *alloc = ctx->alloc;
-    flux_jobid_t id;
-    int type;
-    char *note = NULL;
-    json_t *annotations = NULL;
     struct job *job;
     bool cleared = false;
+    json_t *changed = NULL;
+    int rc;
 
-    if (flux_response_decode (msg, NULL, NULL) < 0)
-        goto teardown; // ENOSYS here if scheduler not loaded/shutting down
-    if (flux_msg_unpack (msg, "{s:I s:i s?:s s?:o}",
-                              "id", &id,
-                              "type", &type,
-                              "note", &note,
-                              "annotations", &annotations) < 0)
-        goto teardown;
     if (!(job = zhashx_lookup (ctx->active_jobs, &id))) {
         flux_log (h, LOG_ERR, "sched.alloc-response: id=%ju not active",
                   (uintmax_t)id);
         errno = EINVAL;
-        goto teardown;
+        return -1;
     }
     if (!job->alloc_pending) {
         flux_log (h, LOG_ERR, "sched.alloc-response: id=%ju not requested",
                   (uintmax_t)id);
         errno = EINVAL;
-        goto teardown;
+        return -1;
     }
     switch (type) {
     case FLUX_SCHED_ALLOC_SUCCESS:
         alloc->alloc_pending_count--;
         job->alloc_pending = 0;
+        latency_mark (ctx->latency, job, JOB_MARK_ALLOC);
         if (job->has_resources) {
             flux_log (h,
                       LOG_ERR,
                       "sched.alloc-response: id=%ju already allocated",
                       (uintmax_t)id);
             errno = EEXIST;
-            goto teardown;
+            return -1;
         }
-        if (annotations_update (h, job, annotations) < 0)
+        if (annotations_update (h, job, annotations, &changed) < 0)
             flux_log_error (h, "annotations_update: id=%ju", (uintmax_t)id);
-        if (annotations) {
-            if (event_batch_pub_annotations (ctx->event, job) < 0)
+        if (changed) {
+            if (event_batch_pub_annotations (ctx->event, job, changed) < 0)
                 flux_log_error (ctx->h,
                                 "%s: event_batch_pub_annotations: id=%ju",
                                 __FUNCTION__, (uintmax_t)id);
+            json_decref (changed);
         }
-        if (job->annotations) {
-            if (event_job_post_pack (ctx->event, job, "alloc",
-                                     "{ s:O }",
-                                     "annotations", job->annotations) < 0)
-                goto teardown;
-        }
-        else {
-            if (event_job_post_pack (ctx->event, job, "alloc", NULL) < 0)
-                goto teardown;
-        }
+        job->R = json_is_string (R) ? json_incref (R) : NULL;
+        if (job->annotations)
+            rc = event_job_post_pack (ctx->event, job, "alloc",
+                                      "{ s:O }",
+                                      "annotations", job->annotations);
+        else
+            rc = event_job_post_pack (ctx->event, job, "alloc", NULL);
+        if (rc < 0)
+            return -1;
         break;
     case FLUX_SCHED_ALLOC_ANNOTATE: // annotation
         if (!annotations) {
             errno = EPROTO;
-            goto teardown;
+            return -1;
         }
-        if (annotations_update (h, job, annotations) < 0)
+        if (annotations_update (h, job, annotations, &changed) < 0)
             flux_log_error (h, "annotations_update: id=%ju", (uintmax_t)id);
-        if (event_batch_pub_annotations (ctx->event, job) < 0)
+        if (changed
+            && event_batch_pub_annotations (ctx->event, job, changed) < 0)
             flux_log_error (ctx->h,
                             "%s: event_batch_pub_annotations: id=%ju",
                             __FUNCTION__, (uintmax_t)id);
+        json_decref (changed);
         break;
     case FLUX_SCHED_ALLOC_DENY: // error
         alloc->alloc_pending_count--;
         job->alloc_pending = 0;
         annotations_clear (job, &cleared);
         if (cleared) {
-            if (event_batch_pub_annotations (ctx->event, job) < 0)
+            if (event_batch_pub_annotations (ctx->event, job, NULL) < 0)
                 flux_log_error (ctx->h,
                                 "%s: event_batch_pub_annotations: id=%ju",
                                 __FUNCTION__, (uintmax_t)id);
@@ -269,14 +381,14 @@ static void alloc_response_cb (flux_t *h, flux_msg_handler_t *mh,
                                  "severity", 0,
                                  "userid", FLUX_USERID_UNKNOWN,
                                  "note", note ? note : "") < 0)
-            goto teardown;
+            return -1;
         break;
     case FLUX_SCHED_ALLOC_CANCEL:
         alloc->alloc_pending_count--;
         job->alloc_pending = 0;
         annotations_clear (job, &cleared);
         if (cleared) {
-            if (event_batch_pub_annotations (ctx->event, job) < 0)
+            if (event_batch_pub_annotations (ctx->event, job, NULL) < 0)
                 flux_log_error (ctx->h,
                                 "%s: event_batch_pub_annotations: id=%ju",
                                 __FUNCTION__, (uintmax_t)id);
@@ -285,17 +397,113 @@ static void alloc_response_cb (flux_t *h, flux_msg_handler_t *mh,
             flux_log_error (h,
                             "event_job_action id=%ju on alloc cancel",
                             (uintmax_t)id);
-            goto teardown;
+            return -1;
         }
         drain_check (alloc->ctx->drain);
         break;
     default:
         errno = EINVAL;
+        return -1;
+    }
+    return 0;
+}
+
+/* Handle a sched.alloc response.
+ */
+static void alloc_response_cb (flux_t *h, flux_msg_handler_t *mh,
+                               const flux_msg_t *msg, void *arg)
+{
+    struct job_manager *ctx = arg;
+    flux_jobid_t id;
+    int type;
+    const char *note = NULL;
+    json_t *annotations = NULL;
+    json_t *R = NULL;
+
+    if (flux_response_decode (msg, NULL, NULL) < 0)
+        goto teardown; // ENOSYS here if scheduler not loaded/shutting down
+    if (flux_msg_unpack (msg, "{s:I s:i s?:s s?:o s?:o}",
+                              "id", &id,
+                              "type", &type,
+                              "note", &note,
+                              "annotations", &annotations,
+                              "R", &R) < 0)
+        goto teardown;
+    if (alloc_response (ctx, id, type, note, annotations, R) < 0)
+        goto teardown;
+    return;
+teardown:
+    interface_teardown (ctx->alloc, "alloc response error", errno);
+}
+
+/* Handle a sched.alloc-batch response, a list of sched.alloc responses
+ * in the order the scheduler made them.
+ */
+static void alloc_batch_response_cb (flux_t *h, flux_msg_handler_t *mh,
+                                     const flux_msg_t *msg, void *arg)
+{
+    struct job_manager *ctx = arg;
+    json_t *responses;
+    json_t *entry;
+    size_t index;
+
+    if (flux_response_decode (msg, NULL, NULL) < 0)
+        goto teardown;
+    if (flux_msg_unpack (msg, "{s:o}", "responses", &responses) < 0)
+        goto teardown;
+    if (!json_is_array (responses)) {
+        errno = EPROTO;
         goto teardown;
     }
+    json_array_foreach (responses, index, entry) {
+        flux_jobid_t id;
+        int type;
+        const char *note = NULL;
+        json_t *annotations = NULL;
+        json_t *R = NULL;
+
+        if (json_unpack (entry, "{s:I s:i s?:s s?:o s?:o}",
+                                "id", &id,
+                                "type", &type,
+                                "note", &note,
+                                "annotations", &annotations,
+                                "R", &R) < 0) {
+            errno = EPROTO;
+            goto teardown;
+        }
+        if (alloc_response (ctx, id, type, note, annotations, R) < 0)
+            goto teardown;
+    }
     return;
 teardown:
-    interface_teardown (alloc, "alloc response error", errno);
+    interface_teardown (ctx->alloc, "alloc response error", errno);
+}
+
+/* Create the sched.alloc payload for job, which is also its entry in
+ * a sched.alloc-batch request.  Include the resource counts from the
+ * job-ingest jobspec summary, if any, so the scheduler can skip parsing
+ * the jobspec.  They are absent for jobs reloaded from the KVS.
+ */
+static json_t *alloc_request_payload (struct job *job)
+{
+    json_t *o;
+    json_t *counts = NULL;
+
+    if (!(o = json_pack ("{s:I s:i s:i s:f}",
+                         "id", job->id,
+                         "priority", job->priority,
+                         "userid", job->userid,
+                         "t_submit", job->t_submit)))
+        goto nomem;
+    if (job->jobspec)
+        counts = json_object_get (job->jobspec, "counts");
+    if (counts && json_object_set (o, "counts", counts) < 0)
+        goto nomem;
+    return o;
+nomem:
+    json_decref (o);
+    errno = ENOMEM;
+    return NULL;
 }
 
 /* Send sched.alloc request for job.
@@ -304,26 +512,70 @@ teardown:
 int alloc_request (struct alloc *alloc, struct job *job)
 {
     flux_msg_t *msg;
+    json_t *o;
 
-    if (!(msg = flux_request_encode ("sched.alloc", NULL)))
+    if (!(o = alloc_request_payload (job)))
         return -1;
-    if (flux_msg_pack (msg, "{s:I s:i s:i s:f}",
-                            "id", job->id,
-                            "priority", job->priority,
-                            "userid", job->userid,
-                            "t_submit", job->t_submit) < 0)
+    if (!(msg = flux_request_encode ("sched.alloc", NULL)))
+        goto error;
+    if (flux_msg_pack (msg, "O", o) < 0)
         goto error;
     if (flux_send (alloc->ctx->h, msg, 0) < 0)
         goto error;
     flux_msg_destroy (msg);
+    json_decref (o);
     return 0;
 error:
     flux_msg_destroy (msg);
+    json_decref (o);
+    return -1;
+}
+
+/* Send one sched.alloc-batch request for up to alloc->batch jobs from
+ * the head of the queue.  Return the number of jobs sent, or -1 on error.
+ */
+static int alloc_request_batch (struct alloc *alloc)
+{
+    flux_msg_t *msg = NULL;
+    json_t *jobs;
+    struct job *job;
+    int count = 0;
+
+    if (!(jobs = json_array ()))
+        goto nomem;
+    job = skiplist_first (alloc->queue);
+    while (job && count < alloc->batch) {
+        json_t *entry;
+
+        if (!(entry = alloc_request_payload (job)))
+            goto nomem;
+        if (json_array_append_new (jobs, entry) < 0) {
+            json_decref (entry);
+            goto nomem;
+        }
+        count++;
+        job = skiplist_next (alloc->queue);
+    }
+    if (!(msg = flux_request_encode ("sched.alloc-batch", NULL)))
+        goto error;
+    if (flux_msg_pack (msg, "{s:O}", "jobs", jobs) < 0)
+        goto error;
+    if (flux_send (alloc->ctx->h, msg, 0) < 0)
+        goto error;
+    flux_msg_destroy (msg);
+    json_decref (jobs);
+    return count;
+nomem:
+    errno = ENOMEM;
+error:
+    flux_msg_destroy (msg);
+    json_decref (jobs);
     return -1;
 }
 
 /* sched-hello:
  * Scheduler obtains a list of jobs that have resources allocated.
+ * R is included if known, so the scheduler need not look it up.
  */
 static void hello_cb (flux_t *h, flux_msg_handler_t *mh,
                       const flux_msg_t *msg, void *arg)
@@ -347,10 +599,12 @@ static void hello_cb (flux_t *h, flux_msg_handler_t *mh,
                                      "userid", job->userid,
                                      "t_submit", job->t_submit)))
                 goto nomem;
-            if (json_array_append_new (o, entry) < 0) {
+            if (job->R && json_object_set (entry, "R", job->R) < 0) {
                 json_decref (entry);
                 goto nomem;
             }
+            if (json_array_append_new (o, entry) < 0)
+                goto nomem;
         }
         job = zhashx_next (ctx->active_jobs);
     }
@@ -376,10 +630,14 @@ static void ready_cb (flux_t *h, flux_msg_handler_t *mh,
 {
     struct job_manager *ctx = arg;
     const char *mode;
+    int batch = 0;
     int count;
     struct job *job;
+    int rc;
 
-    if (flux_request_unpack (msg, NULL, "{s:s}", "mode", &mode) < 0)
+    if (flux_request_unpack (msg, NULL, "{s:s s?:i}",
+                                        "mode", &mode,
+                                        "batch", &batch) < 0)
         goto error;
     if (!strcmp (mode, "single"))
         ctx->alloc->mode = SCHED_SINGLE;
@@ -389,10 +647,24 @@ static void ready_cb (flux_t *h, flux_msg_handler_t *mh,
         errno = EPROTO;
         goto error;
     }
+    if (batch < 0)
+        batch = 0;
+    if (batch > max_batch)
+        batch = max_batch;
+    ctx->alloc->batch = batch;
     ctx->alloc->ready = true;
-    flux_log (h, LOG_DEBUG, "scheduler: ready %s", mode);
-    count = zlistx_size (ctx->alloc->queue);
-    if (flux_respond_pack (h, msg, "{s:i}", "count", count) < 0)
+    if (batch > 0)
+        flux_log (h, LOG_DEBUG, "scheduler: ready %s batch=%d", mode, batch);
+    else
+        flux_log (h, LOG_DEBUG, "scheduler: ready %s", mode);
+    count = skiplist_size (ctx->alloc->queue);
+    if (batch > 0)
+        rc = flux_respond_pack (h, msg, "{s:i s:i}",
+                                "count", count,
+                                "batch", batch);
+    else
+        rc = flux_respond_pack (h, msg, "{s:i}", "count", count);
+    if (rc < 0)
         flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
     /* Restart any free requests that might have been interrupted
      * when scheduler was last unloaded.
@@ -416,6 +688,7 @@ error:
 
 /* prep:
  * Runs right before reactor calls poll(2).
+ * Send any batched free and cancel requests.
  * If a job can be scheduled, start idle watcher.
  */
 static void prep_cb (flux_reactor_t *r, flux_watcher_t *w,
@@ -424,17 +697,44 @@ static void prep_cb (flux_reactor_t *r, flux_watcher_t *w,
     struct job_manager *ctx = arg;
     struct alloc *alloc = ctx->alloc;
 
+    if (free_request_flush (alloc) < 0) {
+        flux_log_error (ctx->h, "free_request_flush fatal error");
+        flux_reactor_stop_error (flux_get_reactor (ctx->h));
+        return;
+    }
+    if (cancel_request_flush (alloc) < 0) {
+        flux_log_error (ctx->h, "cancel_request_flush fatal error");
+        flux_reactor_stop_error (flux_get_reactor (ctx->h));
+        return;
+    }
     if (!alloc->ready || alloc->disable)
         return;
     if (alloc->mode == SCHED_SINGLE && alloc->alloc_pending_count > 0)
         return;
-    if (zlistx_first (alloc->queue))
+    if (skiplist_size (alloc->queue) > 0)
         flux_watcher_start (alloc->idle);
 }
 
+/* Move job from the queue to alloc pending, after its request was sent.
+ */
+static void alloc_request_sent (struct alloc *alloc, struct job *job)
+{
+    skiplist_delete (alloc->queue, job->handle);
+    job->handle = NULL;
+    job->alloc_pending = 1;
+    job->alloc_queued = 0;
+    alloc->alloc_pending_count++;
+    latency_mark (alloc->ctx->latency, job, JOB_MARK_ALLOC_REQUEST);
+    if ((job->flags & FLUX_JOB_DEBUG))
+        (void)event_job_post_pack (alloc->ctx->event, job,
+                                   "debug.alloc-request", NULL);
+}
+
 /* check:
  * Runs right after reactor calls poll(2).
  * Stop idle watcher, and send next alloc request, if available.
+ * If batching was negotiated in unlimited mode, send the next batch
+ * of jobs from the head of the queue in one request.
  */
 static void check_cb (flux_reactor_t *r, flux_watcher_t *w,
                       int revents, void *arg)
@@ -442,27 +742,33 @@ static void check_cb (flux_reactor_t *r, flux_watcher_t *w,
     struct job_manager *ctx = arg;
     struct alloc *alloc = ctx->alloc;
     struct job *job;
+    int count;
 
     flux_watcher_stop (alloc->idle);
     if (!alloc->ready || alloc->disable)
         return;
     if (alloc->mode == SCHED_SINGLE && alloc->alloc_pending_count > 0)
         return;
-    if ((job = zlistx_first (alloc->queue))) {
+    if (skiplist_size (alloc->queue) == 0)
+        return;
+    if (alloc->mode == SCHED_UNLIMITED && alloc->batch > 1) {
+        if ((count = alloc_request_batch (alloc)) < 0) {
+            flux_log_error (ctx->h, "alloc_request_batch fatal error");
+            flux_reactor_stop_error (flux_get_reactor (ctx->h));
+            return;
+        }
+        /* The jobs sent are exactly the first 'count' in the queue.
+         */
+        while (count-- > 0 && (job = skiplist_first (alloc->queue)))
+            alloc_request_sent (alloc, job);
+    }
+    else if ((job = skiplist_first (alloc->queue))) {
         if (alloc_request (alloc, job) < 0) {
             flux_log_error (ctx->h, "alloc_request fatal error");
             flux_reactor_stop_error (flux_get_reactor (ctx->h));
             return;
         }
-        zlistx_delete (alloc->queue, job->handle);
-        job->handle = NULL;
-        job->alloc_pending = 1;
-        job->alloc_queued = 0;
-        alloc->alloc_pending_count++;
-        if ((job->flags & FLUX_JOB_DEBUG))
-            (void)event_job_post_pack (ctx->event, job,
-                                       "debug.alloc-request", NULL);
-
+        alloc_request_sent (alloc, job);
     }
 }
 
@@ -471,7 +777,20 @@ int alloc_send_free_request (struct alloc *alloc, struct job *job)
 {
     assert (job->state == FLUX_JOB_CLEANUP);
     if (!job->free_pending && alloc->ready) {
-        if (free_request (alloc, job) < 0)
+        if (alloc->batch > 0) {
+            json_t *id;
+
+            if (!(id = json_integer (job->id))
+                || json_array_append_new (alloc->free_batch, id) < 0) {
+                json_decref (id);
+                errno = ENOMEM;
+                return -1;
+            }
+            if (json_array_size (alloc->free_batch) >= alloc->batch
+                && free_request_flush (alloc) < 0)
+                return -1;
+        }
+        else if (free_request (alloc, job) < 0)
             return -1;
         job->free_pending = 1;
         if ((job->flags & FLUX_JOB_DEBUG))
@@ -487,10 +806,11 @@ int alloc_enqueue_alloc_request (struct alloc *alloc, struct job *job)
 {
     assert (job->state == FLUX_JOB_SCHED);
     if (!job->alloc_queued && !job->alloc_pending) {
-        bool fwd = job->priority > FLUX_JOB_PRIORITY_DEFAULT ? true : false;
         assert (job->handle == NULL);
-        if (!(job->handle = zlistx_insert (alloc->queue, job, fwd)))
+        if (!(job->handle = skiplist_insert (alloc->queue, job_incref (job)))) {
+            job_decref (job);
             return -1;
+        }
         job->alloc_queued = 1;
     }
     return 0;
@@ -500,7 +820,7 @@ int alloc_enqueue_alloc_request (struct alloc *alloc, struct job *job)
 void alloc_dequeue_alloc_request (struct alloc *alloc, struct job *job)
 {
     if (job->alloc_queued) {
-        zlistx_delete (alloc->queue, job->handle);
+        skiplist_delete (alloc->queue, job->handle);
         job->handle = NULL;
         job->alloc_queued = 0;
     }
@@ -519,20 +839,18 @@ int alloc_cancel_alloc_request (struct alloc *alloc, struct job *job)
 /* called from list_handle_request() */
 struct job *alloc_queue_first (struct alloc *alloc)
 {
-    return zlistx_first (alloc->queue);
+    return skiplist_first (alloc->queue);
 }
 
 struct job *alloc_queue_next (struct alloc *alloc)
 {
-    return zlistx_next (alloc->queue);
+    return skiplist_next (alloc->queue);
 }
 
 /* called from priority_handle_request() */
 void alloc_queue_reorder (struct alloc *alloc, struct job *job)
 {
-    bool fwd = job->priority > FLUX_JOB_PRIORITY_DEFAULT ? true : false;
-
-    zlistx_reorder (alloc->queue, job->handle, fwd);
+    skiplist_reorder (alloc->queue, job->handle);
 }
 
 int alloc_pending_count (struct alloc *alloc)
@@ -624,7 +942,7 @@ static void alloc_admin_cb (flux_t *h,
                            "reason",
                            reason ? reason : "",
                            "queue_length",
-                           zlistx_size (alloc->queue),
+                           (int)skiplist_size (alloc->queue),
                            "alloc_pending",
                            alloc->alloc_pending_count,
                            "free_pending",
@@ -646,7 +964,9 @@ void alloc_ctx_destroy (struct alloc *alloc)
         flux_watcher_destroy (alloc->prep);
         flux_watcher_destroy (alloc->check);
         flux_watcher_destroy (alloc->idle);
-        zlistx_destroy (&alloc->queue);
+        skiplist_destroy (alloc->queue);
+        json_decref (alloc->free_batch);
+        json_decref (alloc->cancel_batch);
         free (alloc->disable_reason);
         free (alloc);
         errno = saved_errno;
@@ -658,7 +978,9 @@ static const struct flux_msg_handler_spec htab[] = {
     { FLUX_MSGTYPE_REQUEST,  "job-manager.sched-ready", ready_cb, 0},
     { FLUX_MSGTYPE_REQUEST,  "job-manager.alloc-admin", alloc_admin_cb, 0},
     { FLUX_MSGTYPE_RESPONSE, "sched.alloc", alloc_response_cb, 0},
+    { FLUX_MSGTYPE_RESPONSE, "sched.alloc-batch", alloc_batch_response_cb, 0},
     { FLUX_MSGTYPE_RESPONSE, "sched.free", free_response_cb, 0},
+    { FLUX_MSGTYPE_RESPONSE, "sched.free-batch", free_batch_response_cb, 0},
     FLUX_MSGHANDLER_TABLE_END,
 };
 
@@ -670,11 +992,14 @@ struct alloc *alloc_ctx_create (struct job_manager *ctx)
     if (!(alloc = calloc (1, sizeof (*alloc))))
         return NULL;
     alloc->ctx = ctx;
-    if (!(alloc->queue = zlistx_new()))
+    if (!(alloc->queue = skiplist_create (job_comparator)))
         goto error;
-    zlistx_set_destructor (alloc->queue, job_destructor);
-    zlistx_set_comparator (alloc->queue, job_comparator);
-    zlistx_set_duplicator (alloc->queue, job_duplicator);
+    skiplist_set_destructor (alloc->queue, job_destructor);
+    if (!(alloc->free_batch = json_array ())
+        || !(alloc->cancel_batch = json_array ())) {
+        errno = ENOMEM;
+        goto error;
+    }
 
     if (flux_msg_handler_addvec (ctx->h, htab, ctx, &alloc->handlers) < 0)
         goto error;
@@ -18,6 +18,7 @@
  *
  * Action:
  *  -update annotations
+ *  -publish the top level annotation keys whose value changed, if any
  */
 
 #if HAVE_CONFIG_H
@@ -26,6 +27,8 @@
 #include <ctype.h>
 #include <flux/core.h>
 
+#include "src/common/libutil/errno_safe.h"
+
 #include "job.h"
 #include "event.h"
 #include "annotate.h"
@@ -46,53 +49,89 @@ void annotations_clear (struct job *job, bool *cleared)
     }
 }
 
-/* we want to delete items set to 'null', so this is not the same
- * as json_object_update_recursive() in jansson 2.13.1
+static int update_recursive (json_t *orig, json_t *new, bool *changed);
+
+/* Update orig[key] with 'value'.  Set '*changed' if orig was modified.
  */
-int update_annotation_recursive (struct job *job, json_t *orig, json_t *new)
+static int update_key (json_t *orig,
+                       const char *key,
+                       json_t *value,
+                       bool *changed)
 {
-    const char *key;
-    json_t *value;
+    json_t *orig_value = json_object_get (orig, key);
 
-    assert (job && orig && new);
-
-    json_object_foreach (new, key, value) {
-        if (!json_is_null (value)) {
-            json_t *orig_value = json_object_get (orig, key);
+    if (json_is_null (value)) {
+        /* not an error if key doesn't exist in orig */
+        if (orig_value) {
+            (void)json_object_del (orig, key);
+            *changed = true;
+        }
+    }
+    else if (json_is_object (value)) {
+        bool created = false;
 
-            if (json_is_object (value)) {
-                if (!json_is_object (orig_value)) {
-                    json_t *o = json_object ();
-                    if (!o || json_object_set_new (orig, key, o) < 0) {
-                        errno = ENOMEM;
-                        json_decref (o);
-                        return -1;
-                    }
-                    orig_value = o;
-                }
-                if (update_annotation_recursive (job, orig_value, value) < 0)
-                    return -1;
-                /* if object is now empty, remove it */
-                if (!json_object_size (orig_value))
-                    (void)json_object_del (orig, key);
-            }
-            else {
-                if (json_object_set (orig, key, value) < 0) {
-                    errno = ENOMEM;
-                    return -1;
-                }
+        if (!json_is_object (orig_value)) {
+            json_t *o = json_object ();
+            if (!o || json_object_set_new (orig, key, o) < 0) {
+                errno = ENOMEM;
+                json_decref (o);
+                return -1;
             }
+            created = orig_value ? false : true;
+            if (orig_value)
+                *changed = true;
+            orig_value = o;
         }
-        else
-            /* not an error if key doesn't exist in orig */
+        if (update_recursive (orig_value, value, changed) < 0)
+            return -1;
+        /* if object is now empty, remove it */
+        if (!json_object_size (orig_value)) {
             (void)json_object_del (orig, key);
+            if (!created)
+                *changed = true;
+        }
+    }
+    else if (!orig_value || !json_equal (orig_value, value)) {
+        if (json_object_set (orig, key, value) < 0) {
+            errno = ENOMEM;
+            return -1;
+        }
+        *changed = true;
     }
+    return 0;
+}
 
+static int update_recursive (json_t *orig, json_t *new, bool *changed)
+{
+    const char *key;
+    json_t *value;
+
+    json_object_foreach (new, key, value) {
+        if (update_key (orig, key, value, changed) < 0)
+            return -1;
+    }
     return 0;
 }
 
-int annotations_update (flux_t *h, struct job *job, json_t *annotations)
+/* we want to delete items set to 'null', so this is not the same
+ * as json_object_update_recursive() in jansson 2.13.1
+ */
+int update_annotation_recursive (struct job *job, json_t *orig, json_t *new)
 {
+    bool changed = false;
+
+    assert (job && orig && new);
+
+    return update_recursive (orig, new, &changed);
+}
+
+int annotations_update (flux_t *h,
+                        struct job *job,
+                        json_t *annotations,
+                        json_t **changedp)
+{
+    json_t *changed_keys = NULL;
+
     if (annotations) {
         if (!job->annotations) {
             if (!(job->annotations = json_object ())) {
@@ -101,10 +140,25 @@ int annotations_update (flux_t *h, struct job *job, json_t *annotations)
             }
         }
         if (job->annotations) {
-            if (update_annotation_recursive (job,
-                                             job->annotations,
-                                             annotations) < 0)
+            const char *key;
+            json_t *value;
+
+            if (changedp && !(changed_keys = json_array ())) {
+                errno = ENOMEM;
                 return -1;
+            }
+            json_object_foreach (annotations, key, value) {
+                bool changed = false;
+                if (update_key (job->annotations, key, value, &changed) < 0)
+                    goto error;
+                if (changed && changed_keys) {
+                    if (json_array_append_new (changed_keys,
+                                               json_string (key)) < 0) {
+                        errno = ENOMEM;
+                        goto error;
+                    }
+                }
+            }
             /* Special case: if user cleared all entries, assume we no
              * longer need annotations object
              *
@@ -116,8 +170,12 @@ int annotations_update (flux_t *h, struct job *job, json_t *annotations)
                 annotations_clear (job, NULL);
         }
     }
-
+    if (changedp)
+        *changedp = changed_keys;
     return 0;
+error:
+    ERRNO_SAFE_WRAP (json_decref, changed_keys);
+    return -1;
 }
 
 void annotate_handle_request (flux_t *h,
@@ -129,6 +187,7 @@ void annotate_handle_request (flux_t *h,
     struct flux_msg_cred cred;
     flux_jobid_t id;
     json_t *annotations = NULL;
+    json_t *changed = NULL;
     struct job *job;
     const char *errstr = NULL;
 
@@ -146,18 +205,20 @@ void annotate_handle_request (flux_t *h,
         errstr = "guests can only annotate their own jobs";
         goto error;
     }
-    if (annotations_update (ctx->h, job, annotations) < 0)
+    if (annotations_update (ctx->h, job, annotations, &changed) < 0)
         goto error;
-    if (event_batch_pub_annotations (ctx->event, job) < 0) {
+    if (event_batch_pub_annotations (ctx->event, job, changed) < 0) {
         flux_log_error (h, "%s: event_batch_pub_annotations", __FUNCTION__);
         goto error;
     }
     if (flux_respond (h, msg, NULL) < 0)
         flux_log_error (h, "%s: flux_respond", __FUNCTION__);
+    json_decref (changed);
     return;
 error:
     if (flux_respond_error (h, msg, errno, errstr) < 0)
         flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+    json_decref (changed);
 }
 
 void annotate_ctx_destroy (struct annotate *annotate)
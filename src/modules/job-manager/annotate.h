@@ -17,7 +17,15 @@
 #include "job-manager.h"
 
 void annotations_clear (struct job *job, bool *cleared);
-int annotations_update (flux_t *h, struct job *job, json_t *annotations);
+
+/* Update job->annotations with 'annotations', where keys set to null
+ * are deleted.  If 'changed' is non-NULL, set it to a new array of the
+ * top level keys whose value changed, which the caller must decref.
+ */
+int annotations_update (flux_t *h,
+                        struct job *job,
+                        json_t *annotations,
+                        json_t **changed);
 
 struct annotate *annotate_ctx_create (struct job_manager *ctx);
 void annotate_ctx_destroy (struct annotate *annotate);
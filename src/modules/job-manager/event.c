@@ -27,6 +27,23 @@
  * event_job_update(), event_job_action(), and committing the event to
  * the job eventlog, in a delayed batch.
  *
+ * A batch is committed when its timer expires, or as soon as it holds
+ * batch_max_events events.  Consecutive events for the same job are
+ * combined into one KVS append.  State transitions are published in
+ * "job-state" events, and if enabled, also in compact "job-transitions"
+ * events (see flux_job_transition_decode()).  If there are
+ * job-manager.journal listeners, they are sent the transitions along
+ * with job data, before the events are published (see journal.c).
+ *
+ * Annotation changes are coalesced per job in the batch, and published
+ * when the batch completes in a "job-annotations" event:
+ *   {"annotations":[[id, annotations|null], ...],
+ *    "deltas":[[id, {key:value|null, ...}], ...]}
+ * A job whose annotations were replaced or cleared appears in
+ * "annotations" with its full annotations.  Otherwise it appears in
+ * "deltas" with only the top level keys that changed, and null for
+ * keys that were removed.
+ *
  * Notes:
  * - A KVS commit failure is handled as fatal to the job-manager
  * - event_job_action() is idempotent
@@ -44,12 +61,19 @@
 #include "start.h"
 #include "drain.h"
 #include "wait.h"
+#include "jobindex.h"
+#include "latency.h"
+#include "journal.h"
+#include "admission.h"
 
 #include "event.h"
 
 #include "src/common/libeventlog/eventlog.h"
+#include "src/common/libjob/job.h"
+#include "src/common/libjob/job_hash.h"
 
 const double batch_timeout = 0.01;
+const int batch_max_events = 1024;
 
 struct event {
     struct job_manager *ctx;
@@ -57,6 +81,7 @@ struct event {
     flux_watcher_t *timer;
     zlist_t *pending;
     zlist_t *pub_futures;
+    bool compact;
 };
 
 struct event_batch {
@@ -64,8 +89,24 @@ struct event_batch {
     flux_kvs_txn_t *txn;
     flux_future_t *f;
     json_t *state_trans;
-    json_t *annotations;
+    json_t *journal;    // journal entries, if there are listeners
+    zhashx_t *annotations; // id => struct annotations_pub
     zlist_t *responses; // responses deferred until batch complete
+    int count;          // eventlog entries and state transitions
+    char append_key[64];// eventlog key of append not yet in txn
+    char *append_buf;
+    size_t append_len;
+    size_t append_size;
+    uint8_t *trans_buf; // compact transitions
+    size_t trans_len;
+    size_t trans_size;
+};
+
+/* Annotation changes of one job in a batch.
+ */
+struct annotations_pub {
+    struct job *job;
+    json_t *keys;       // object of changed keys, or NULL to publish all
 };
 
 struct event_batch *event_batch_create (struct event *event);
@@ -106,6 +147,24 @@ void publish_continuation (flux_future_t *f, void *arg)
     flux_future_destroy (f);
 }
 
+/* Add the pending eventlog append, if any, to the batch txn.
+ */
+static int event_batch_flush_append (struct event_batch *batch)
+{
+    if (batch->append_len > 0) {
+        if (!batch->txn && !(batch->txn = flux_kvs_txn_create ()))
+            return -1;
+        if (flux_kvs_txn_put (batch->txn,
+                              FLUX_KVS_APPEND,
+                              batch->append_key,
+                              batch->append_buf) < 0)
+            return -1;
+        batch->append_len = 0;
+        batch->append_key[0] = '\0';
+    }
+    return 0;
+}
+
 /* Close the current batch, if any, and commit it.
  */
 void event_batch_commit (struct event *event)
@@ -115,6 +174,9 @@ void event_batch_commit (struct event *event)
 
     if (batch) {
         event->batch = NULL;
+        flux_watcher_stop (event->timer);
+        if (event_batch_flush_append (batch) < 0)
+            goto error;
         if (batch->txn) {
             if (!(batch->f = flux_kvs_commit (ctx->h, NULL, 0, batch->txn)))
                 goto error;
@@ -142,6 +204,27 @@ void timer_cb (flux_reactor_t *r, flux_watcher_t *w, int revents, void *arg)
     event_batch_commit (ctx->event);
 }
 
+/* Track publish future 'f' until it is fulfilled.
+ */
+static void event_publish_future (struct event *event, flux_future_t *f)
+{
+    struct job_manager *ctx = event->ctx;
+
+    if (flux_future_then (f, -1., publish_continuation, event) < 0) {
+        flux_future_destroy (f);
+        flux_log_error (ctx->h, "%s: flux_future_then", __FUNCTION__);
+        goto error;
+    }
+    if (zlist_append (event->pub_futures, f) < 0) {
+        flux_future_destroy (f);
+        flux_log_error (ctx->h, "%s: zlist_append", __FUNCTION__);
+        goto error;
+    }
+    return;
+error:
+    flux_reactor_stop_error (flux_get_reactor (ctx->h));
+}
+
 void event_publish (struct event *event, const char *topic,
                     const char *key, json_t *o)
 {
@@ -155,24 +238,117 @@ void event_publish (struct event *event, const char *topic,
         f = flux_event_publish_pack (ctx->h, topic, 0, "{s:n}", key);
     if (!f) {
         flux_log_error (ctx->h, "%s: flux_event_publish_pack", __FUNCTION__);
-        goto error;
+        flux_reactor_stop_error (flux_get_reactor (ctx->h));
+        return;
     }
-    if (flux_future_then (f, -1., publish_continuation, event) < 0) {
-        flux_future_destroy (f);
-        flux_log_error (ctx->h, "%s: flux_future_then", __FUNCTION__);
-        goto error;
+    event_publish_future (event, f);
+}
+
+void event_publish_raw (struct event *event, const char *topic,
+                        const void *data, int len)
+{
+    struct job_manager *ctx = event->ctx;
+    flux_future_t *f;
+
+    if (!(f = flux_event_publish_raw (ctx->h, topic, 0, data, len))) {
+        flux_log_error (ctx->h, "%s: flux_event_publish_raw", __FUNCTION__);
+        flux_reactor_stop_error (flux_get_reactor (ctx->h));
+        return;
     }
-    if (zlist_append (event->pub_futures, f) < 0) {
-        flux_future_destroy (f);
-        flux_log_error (ctx->h, "%s: zlist_append", __FUNCTION__);
-        goto error;
+    event_publish_future (event, f);
+}
+
+static void annotations_pub_destroy (void **item)
+{
+    if (item && *item) {
+        struct annotations_pub *ap = *item;
+        job_decref (ap->job);
+        json_decref (ap->keys);
+        free (ap);
+        *item = NULL;
+    }
+}
+
+/* Encode the current value of the changed annotations of 'ap->job' as
+ * [id, {key:value|null, ...}].
+ */
+static json_t *annotations_delta_encode (struct annotations_pub *ap)
+{
+    json_t *delta;
+    json_t *entry;
+    const char *key;
+    json_t *dummy;
+
+    if (!(delta = json_object ()))
+        return NULL;
+    json_object_foreach (ap->keys, key, dummy) {
+        json_t *value = NULL;
+        if (ap->job->annotations)
+            value = json_object_get (ap->job->annotations, key);
+        if (json_object_set_new (delta,
+                                 key,
+                                 value ? json_incref (value)
+                                       : json_null ()) < 0) {
+            json_decref (delta);
+            return NULL;
+        }
+    }
+    if (!(entry = json_pack ("[I,o]", ap->job->id, delta))) {
+        json_decref (delta);
+        return NULL;
+    }
+    return entry;
+}
+
+static void annotations_publish (struct event *event, zhashx_t *annotations)
+{
+    flux_t *h = event->ctx->h;
+    struct annotations_pub *ap;
+    json_t *full;
+    json_t *deltas;
+    json_t *o;
+    flux_future_t *f;
+
+    if (!(full = json_array ()) || !(deltas = json_array ())) {
+        json_decref (full);
+        goto nomem;
+    }
+    ap = zhashx_first (annotations);
+    while (ap) {
+        if (ap->keys)
+            o = annotations_delta_encode (ap);
+        /* O? support in jansson 2.8 */
+        else if (ap->job->annotations)
+            o = json_pack ("[I,O]", ap->job->id, ap->job->annotations);
+        else
+            o = json_pack ("[I,n]", ap->job->id);
+        if (!o || json_array_append_new (ap->keys ? deltas : full, o) < 0) {
+            json_decref (o);
+            json_decref (full);
+            json_decref (deltas);
+            goto nomem;
+        }
+        ap = zhashx_next (annotations);
+    }
+    f = flux_event_publish_pack (h,
+                                 "job-annotations",
+                                 0,
+                                 "{s:o s:o}",
+                                 "annotations", full,
+                                 "deltas", deltas);
+    if (!f) {
+        flux_log_error (h, "%s: flux_event_publish_pack", __FUNCTION__);
+        flux_reactor_stop_error (flux_get_reactor (h));
+        return;
     }
+    event_publish_future (event, f);
     return;
-error:
-    flux_reactor_stop_error (flux_get_reactor (ctx->h));
+nomem:
+    flux_log (h, LOG_ERR, "%s: error encoding annotations", __FUNCTION__);
 }
 
 /* Besides cleaning up, this function has the following side effects:
+ * - send journal entries (if any)
  * - publish state transition event (if any)
  * - respond to deferred responses (if any)
  */
@@ -184,6 +360,11 @@ void event_batch_destroy (struct event_batch *batch)
         flux_kvs_txn_destroy (batch->txn);
         if (batch->f)
             (void)flux_future_wait_for (batch->f, -1);
+        if (batch->journal) {
+            if (json_array_size (batch->journal) > 0)
+                journal_send (batch->event->ctx->journal, batch->journal);
+            json_decref (batch->journal);
+        }
         if (batch->state_trans) {
             if (json_array_size (batch->state_trans) > 0)
                 event_publish (batch->event,
@@ -192,13 +373,15 @@ void event_batch_destroy (struct event_batch *batch)
                                batch->state_trans);
             json_decref (batch->state_trans);
         }
+        if (batch->trans_len > 0)
+            event_publish_raw (batch->event,
+                               "job-transitions",
+                               batch->trans_buf,
+                               batch->trans_len);
         if (batch->annotations) {
-            if (json_array_size (batch->annotations) > 0)
-                event_publish (batch->event,
-                               "job-annotations",
-                               "annotations",
-                               batch->annotations);
-            json_decref (batch->annotations);
+            if (zhashx_size (batch->annotations) > 0)
+                annotations_publish (batch->event, batch->annotations);
+            zhashx_destroy (&batch->annotations);
         }
         if (batch->responses) {
             flux_msg_t *msg;
@@ -211,6 +394,8 @@ void event_batch_destroy (struct event_batch *batch)
             zlist_destroy (&batch->responses);
         }
         flux_future_destroy (batch->f);
+        free (batch->append_buf);
+        free (batch->trans_buf);
         free (batch);
         errno = saved_errno;
     }
@@ -240,28 +425,62 @@ int event_batch_start (struct event *event)
     return 0;
 }
 
+/* Grow buffer '*bufp' of allocated size '*sizep' to hold at least 'need'
+ * bytes.
+ */
+static int buf_reserve (void **bufp, size_t *sizep, size_t need)
+{
+    if (need > *sizep) {
+        size_t size = *sizep ? *sizep : 256;
+        void *buf;
+
+        while (size < need)
+            size *= 2;
+        if (!(buf = realloc (*bufp, size))) {
+            errno = ENOMEM;
+            return -1;
+        }
+        *bufp = buf;
+        *sizep = size;
+    }
+    return 0;
+}
+
+/* Eventlog entries for the same job posted in a row are concatenated
+ * into a single append, flushed to the txn when the next event is for
+ * a different job, or when the batch is committed.
+ */
 static int event_batch_commit_event (struct event *event,
                                      struct job *job,
                                      json_t *entry)
 {
+    struct event_batch *batch;
     char key[64];
     char *entrystr = NULL;
+    size_t len;
 
     if (event_batch_start (event) < 0)
         return -1;
+    batch = event->batch;
     if (flux_job_kvs_key (key, sizeof (key), job->id, "eventlog") < 0)
         return -1;
-    if (!event->batch->txn && !(event->batch->txn = flux_kvs_txn_create ()))
-        return -1;
+    if (strcmp (key, batch->append_key) != 0) {
+        if (event_batch_flush_append (batch) < 0)
+            return -1;
+        strcpy (batch->append_key, key);
+    }
     if (!(entrystr = eventlog_entry_encode (entry)))
         return -1;
-    if (flux_kvs_txn_put (event->batch->txn,
-                          FLUX_KVS_APPEND,
-                          key,
-                          entrystr) < 0) {
+    len = strlen (entrystr);
+    if (buf_reserve ((void **)&batch->append_buf,
+                     &batch->append_size,
+                     batch->append_len + len + 1) < 0) {
         free (entrystr);
         return -1;
     }
+    memcpy (batch->append_buf + batch->append_len, entrystr, len + 1);
+    batch->append_len += len;
+    batch->count++;
     free (entrystr);
     return 0;
 }
@@ -286,6 +505,32 @@ int event_batch_pub_state (struct event *event, struct job *job,
         json_decref (o);
         goto nomem;
     }
+    if (journal_listening (event->ctx->journal)) {
+        if (!event->batch->journal) {
+            if (!(event->batch->journal = json_array ()))
+                goto nomem;
+        }
+        if (!(o = journal_entry_create (job, timestamp)))
+            goto error;
+        if (json_array_append_new (event->batch->journal, o) < 0)
+            goto nomem; // N.B. 'o' was released
+    }
+    if (event->compact) {
+        struct event_batch *batch = event->batch;
+
+        if (buf_reserve ((void **)&batch->trans_buf,
+                         &batch->trans_size,
+                         batch->trans_len + FLUX_JOB_TRANSITION_SIZE) < 0)
+            goto error;
+        if (flux_job_transition_encode (batch->trans_buf + batch->trans_len,
+                                        FLUX_JOB_TRANSITION_SIZE,
+                                        job->id,
+                                        job->state,
+                                        timestamp) < 0)
+            goto error;
+        batch->trans_len += FLUX_JOB_TRANSITION_SIZE;
+    }
+    event->batch->count++;
     return 0;
 nomem:
     errno = ENOMEM;
@@ -293,29 +538,54 @@ error:
     return -1;
 }
 
-int event_batch_pub_annotations (struct event *event, struct job *job)
+int event_batch_pub_annotations (struct event *event,
+                                 struct job *job,
+                                 json_t *keys)
 {
-    json_t *o;
+    struct event_batch *batch;
+    struct annotations_pub *ap;
 
     /* do not check for job->annotations == NULL, all annotations
      * being cleared is a possible change.
      */
+    if (keys && json_array_size (keys) == 0)
+        return 0;
     if (event_batch_start (event) < 0)
         goto error;
-    if (!event->batch->annotations) {
-        if (!(event->batch->annotations = json_array ()))
+    batch = event->batch;
+    if (!batch->annotations) {
+        if (!(batch->annotations = job_hash_create ()))
             goto nomem;
+        zhashx_set_destructor (batch->annotations, annotations_pub_destroy);
     }
-    /* O? support in jansson 2.8 */
-    if (job->annotations)
-        o = json_pack ("[I,O]", job->id, job->annotations);
-    else
-        o = json_pack ("[I,n]", job->id);
-    if (!o)
-        goto nomem;
-    if (json_array_append_new (event->batch->annotations, o)) {
-        json_decref (o);
-        goto nomem;
+    if (!(ap = zhashx_lookup (batch->annotations, &job->id))) {
+        if (!(ap = calloc (1, sizeof (*ap))))
+            goto nomem;
+        ap->job = job_incref (job);
+        if (keys && !(ap->keys = json_object ())) {
+            annotations_pub_destroy ((void **)&ap);
+            goto nomem;
+        }
+        (void)zhashx_insert (batch->annotations, &job->id, ap);
+    }
+    if (!keys) {
+        json_decref (ap->keys);
+        ap->keys = NULL;
+    }
+    else if (ap->keys) {
+        size_t index;
+        json_t *key;
+
+        json_array_foreach (keys, index, key) {
+            if (!json_is_string (key)) {
+                errno = EINVAL;
+                goto error;
+            }
+            if (json_object_set (ap->keys,
+                                 json_string_value (key),
+                                 json_true ()) < 0)
+                goto nomem;
+        }
     }
     return 0;
 nomem:
@@ -355,6 +625,7 @@ int event_job_action (struct event *event, struct job *job)
                 return -1;
             break;
         case FLUX_JOB_SCHED:
+            latency_mark (ctx->latency, job, JOB_MARK_SCHED);
             if (alloc_enqueue_alloc_request (ctx->alloc, job) < 0)
                 return -1;
             break;
@@ -392,6 +663,7 @@ int event_job_action (struct event *event, struct job *job)
         case FLUX_JOB_INACTIVE:
             if ((job->flags & FLUX_JOB_WAITABLE))
                 wait_notify_inactive (ctx->wait, job);
+            jobindex_remove (ctx->index, job);
             zhashx_delete (ctx->active_jobs, &job->id);
             drain_check (ctx->drain);
             break;
@@ -453,6 +725,9 @@ int event_release_context_decode (json_t *context,
 /* This function implements state transitions per RFC 21.
  * If FLUX_JOB_WAITABLE flag is set, then on a fatal exception or
  * cleanup event, capture the event in job->end_event for flux_job_wait().
+ * The job result is also tracked for job-manager.journal:  the context
+ * of the most severe exception (the first, among equals), and whether
+ * the job finished with zero status.
  */
 int event_job_update (struct job *job, json_t *event)
 {
@@ -489,6 +764,12 @@ int event_job_update (struct job *job, json_t *event)
             goto inval;
         if (event_exception_context_decode (context, &severity) < 0)
             goto error;
+        if (!job->exception_context
+            || severity < job->exception_severity) {
+            json_decref (job->exception_context);
+            job->exception_context = json_incref (context);
+            job->exception_severity = severity;
+        }
         if (severity == 0) {
             if ((job->flags & FLUX_JOB_WAITABLE) && !job->end_event)
                 job->end_event = json_incref (event);
@@ -507,10 +788,16 @@ int event_job_update (struct job *job, json_t *event)
         if (job->state != FLUX_JOB_CLEANUP)
             goto inval;
         job->has_resources = 0;
+        json_decref (job->R);
+        job->R = NULL;
     }
     else if (!strcmp (name, "finish")) {
+        int status;
         if (job->state != FLUX_JOB_RUN && job->state != FLUX_JOB_CLEANUP)
             goto inval;
+        if (json_unpack (context, "{s:i}", "status", &status) == 0
+            && status == 0)
+            job->success = 1;
         if (job->state == FLUX_JOB_RUN) {
             if ((job->flags & FLUX_JOB_WAITABLE) && !job->end_event)
                 job->end_event = json_incref (event);
@@ -559,6 +846,7 @@ int event_job_post_pack (struct event *event,
     int saved_errno;
     double timestamp;
     flux_job_state_t old_state = job->state;
+    int old_priority = job->priority;
 
     va_start (ap, context_fmt);
     if (get_timestamp_now (&timestamp) < 0)
@@ -572,7 +860,11 @@ int event_job_post_pack (struct event *event,
     if (job->state != old_state) {
         if (event_batch_pub_state (event, job, timestamp) < 0)
             goto error;
+        if (jobindex_update_state (event->ctx->index, job) < 0)
+            goto error;
     }
+    if (job->priority != old_priority)
+        jobindex_reorder (event->ctx->index, job);
 
     /* Keep track of running job count.
      * If queue reaches idle state, event_job_action() triggers any waiters.
@@ -581,10 +873,14 @@ int event_job_post_pack (struct event *event,
         event->ctx->running_jobs++;
     else if (!(job->state & FLUX_JOB_RUNNING) && (old_state & FLUX_JOB_RUNNING))
         event->ctx->running_jobs--;
+    admission_update (event->ctx->admission, job, old_state);
 
     if (event_job_action (event, job) < 0)
         goto error;
 
+    if (event->batch && event->batch->count >= batch_max_events)
+        event_batch_commit (event);
+
     json_decref (entry);
     va_end (ap);
     return 0;
@@ -596,14 +892,37 @@ error:
     return -1;
 }
 
+void event_set_compact (struct event *event, bool enable)
+{
+    event->compact = enable;
+}
+
 /* Finalizes in-flight batch KVS commits and event pubs (synchronously).
  */
+int event_flush (struct event *event)
+{
+    struct event_batch *batch;
+    int rc = 0;
+
+    event_batch_commit (event);
+    batch = zlist_first (event->pending);
+    while (batch) {
+        if (flux_future_get (batch->f, NULL) < 0) {
+            flux_log_error (event->ctx->h, "%s: eventlog update failed",
+                            __FUNCTION__);
+            rc = -1;
+        }
+        batch = zlist_next (event->pending);
+    }
+    return rc;
+}
+
 void event_ctx_destroy (struct event *event)
 {
     if (event) {
         int saved_errno = errno;
-        flux_watcher_destroy (event->timer);
         event_batch_commit (event);
+        flux_watcher_destroy (event->timer);
         if (event->pending) {
             struct event_batch *batch;
             while ((batch = zlist_pop (event->pending)))
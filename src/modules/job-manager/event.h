@@ -36,8 +36,13 @@ int event_batch_pub_state (struct event *event, struct job *job,
                            double timestamp);
 
 /* Add notification of job's annotation change for publication.
+ * 'keys' is an array of the top level keys that changed, or NULL if
+ * the annotations were replaced or cleared.  Changes to a job within
+ * one batch are coalesced, and an empty 'keys' array is ignored.
  */
-int event_batch_pub_annotations (struct event *event, struct job *job);
+int event_batch_pub_annotations (struct event *event,
+                                 struct job *job,
+                                 json_t *keys);
 
 /* Add add response to batch, to be sent upon batch completion.
  */
@@ -55,6 +60,18 @@ int event_job_post_pack (struct event *event,
                          const char *context_fmt,
                          ...);
 
+/* Enable/disable compact "job-transitions" events, published alongside
+ * "job-state" events.
+ */
+void event_set_compact (struct event *event, bool enable);
+
+/* Commit the current batch, if any, and wait for all pending batch
+ * commits to complete.  Use when the reactor is not running, e.g. before
+ * writing the job-manager checkpoint.
+ * Returns 0 on success, -1 on failure with errno set.
+ */
+int event_flush (struct event *event);
+
 void event_ctx_destroy (struct event *event);
 struct event *event_ctx_create (struct job_manager *ctx);
 
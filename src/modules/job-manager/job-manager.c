@@ -11,6 +11,9 @@
 #if HAVE_CONFIG_H
 #include "config.h"
 #endif
+#include <string.h>
+#include <stdlib.h>
+#include <limits.h>
 #include <flux/core.h>
 
 #include "src/common/libjob/job_hash.h"
@@ -28,6 +31,10 @@
 #include "drain.h"
 #include "wait.h"
 #include "annotate.h"
+#include "jobindex.h"
+#include "latency.h"
+#include "journal.h"
+#include "admission.h"
 
 #include "job-manager.h"
 
@@ -52,6 +59,17 @@ error:
         flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
 }
 
+static void disconnect_rpc (flux_t *h,
+                            flux_msg_handler_t *mh,
+                            const flux_msg_t *msg,
+                            void *arg)
+{
+    struct job_manager *ctx = arg;
+
+    wait_disconnect (ctx->wait, msg);
+    journal_disconnect (ctx->journal, msg);
+}
+
 static const struct flux_msg_handler_spec htab[] = {
     {
         FLUX_MSGTYPE_REQUEST,
@@ -65,15 +83,73 @@ static const struct flux_msg_handler_spec htab[] = {
         priority_handle_request,
         FLUX_ROLE_USER
     },
+    {
+        FLUX_MSGTYPE_REQUEST,
+        "job-manager.priorityall",
+        priorityall_handle_request,
+        FLUX_ROLE_USER
+    },
     {
         FLUX_MSGTYPE_REQUEST,
         "job-manager.getinfo",
         getinfo_handle_request,
         FLUX_ROLE_USER
     },
+    {
+        FLUX_MSGTYPE_REQUEST,
+        "job-manager.disconnect",
+        disconnect_rpc,
+        0
+    },
     FLUX_MSGHANDLER_TABLE_END,
 };
 
+static int parse_limit (const char *s, int *valp)
+{
+    char *endptr;
+    long val;
+
+    errno = 0;
+    val = strtol (s, &endptr, 10);
+    if (errno != 0 || *endptr != '\0' || val < 0 || val > INT_MAX) {
+        errno = EINVAL;
+        return -1;
+    }
+    *valp = val;
+    return 0;
+}
+
+static int parse_args (struct job_manager *ctx, int argc, char **argv)
+{
+    int max_pending = 0;
+    int max_pending_user = 0;
+    int i;
+
+    for (i = 0; i < argc; i++) {
+        if (!strcmp (argv[i], "compact-transitions"))
+            event_set_compact (ctx->event, true);
+        else if (!strncmp (argv[i], "max-pending=", 12)) {
+            if (parse_limit (argv[i] + 12, &max_pending) < 0) {
+                flux_log (ctx->h, LOG_ERR, "invalid option %s", argv[i]);
+                return -1;
+            }
+        }
+        else if (!strncmp (argv[i], "max-pending-user=", 17)) {
+            if (parse_limit (argv[i] + 17, &max_pending_user) < 0) {
+                flux_log (ctx->h, LOG_ERR, "invalid option %s", argv[i]);
+                return -1;
+            }
+        }
+        else {
+            flux_log (ctx->h, LOG_ERR, "Unknown module option: '%s'", argv[i]);
+            errno = EINVAL;
+            return -1;
+        }
+    }
+    admission_set_limits (ctx->admission, max_pending, max_pending_user);
+    return 0;
+}
+
 int mod_main (flux_t *h, int argc, char **argv)
 {
     flux_reactor_t *r = flux_get_reactor (h);
@@ -89,10 +165,28 @@ int mod_main (flux_t *h, int argc, char **argv)
     }
     zhashx_set_destructor (ctx.active_jobs, job_destructor);
     zhashx_set_duplicator (ctx.active_jobs, job_duplicator);
+    if (!(ctx.index = jobindex_create ())) {
+        flux_log_error (h, "error creating job index");
+        goto done;
+    }
+    if (!(ctx.latency = latency_ctx_create (&ctx))) {
+        flux_log_error (h, "error creating latency stats");
+        goto done;
+    }
+    if (!(ctx.journal = journal_ctx_create (&ctx))) {
+        flux_log_error (h, "error creating journal");
+        goto done;
+    }
     if (!(ctx.event = event_ctx_create (&ctx))) {
         flux_log_error (h, "error creating event batcher");
         goto done;
     }
+    if (!(ctx.admission = admission_ctx_create (&ctx))) {
+        flux_log_error (h, "error creating admission control");
+        goto done;
+    }
+    if (parse_args (&ctx, argc, argv) < 0)
+        goto done;
     if (!(ctx.submit = submit_ctx_create (&ctx))) {
         flux_log_error (h, "error creating submit interface");
         goto done;
@@ -153,7 +247,11 @@ done:
     alloc_ctx_destroy (ctx.alloc);
     submit_ctx_destroy (ctx.submit);
     event_ctx_destroy (ctx.event);
+    admission_ctx_destroy (ctx.admission);
+    journal_ctx_destroy (ctx.journal);
+    latency_ctx_destroy (ctx.latency);
     zhashx_destroy (&ctx.active_jobs);
+    jobindex_destroy (ctx.index);
     return rc;
 }
 
@@ -26,6 +26,10 @@ struct job_manager {
     struct raise *raise;
     struct kill *kill;
     struct annotate *annotate;
+    struct jobindex *index;
+    struct latency *latency;
+    struct journal *journal;
+    struct admission *admission;
 };
 
 #endif /* !_FLUX_JOB_MANAGER_H */
@@ -26,8 +26,12 @@ void job_decref (struct job *job)
     if (job && --job->refcount == 0) {
         int saved_errno = errno;
         json_decref (job->end_event);
+        json_decref (job->wait_result);
         flux_msg_decref (job->waiter);
         json_decref (job->annotations);
+        json_decref (job->jobspec);
+        json_decref (job->R);
+        json_decref (job->exception_context);
         free (job);
         errno = saved_errno;
     }
@@ -57,32 +61,36 @@ struct job *job_create (void)
 struct job *job_create_from_eventlog (flux_jobid_t id, const char *s)
 {
     struct job *job;
-    json_t *a = NULL;
-    size_t index;
+    struct eventlog_iter *iter = NULL;
     json_t *event;
+    int rc;
 
     if (!(job = job_create ()))
         return NULL;
     job->id = id;
 
-    if (!(a = eventlog_decode (s)))
+    /* Decode one entry at a time to bound memory use on large eventlogs.
+     */
+    if (!(iter = eventlog_iter_create (s)))
         goto error;
-
-    json_array_foreach (a, index, event) {
-        if (event_job_update (job, event) < 0)
+    while ((rc = eventlog_iter_next (iter, NULL, NULL)) > 0) {
+        if (!(event = eventlog_iter_entry (iter))
+            || event_job_update (job, event) < 0)
             goto error;
     }
+    if (rc < 0)
+        goto error;
 
     if (job->state == FLUX_JOB_NEW)
         goto inval;
 
-    json_decref (a);
+    eventlog_iter_destroy (iter);
     return job;
 inval:
     errno = EINVAL;
 error:
     job_decref (job);
-    json_decref (a);
+    eventlog_iter_destroy (iter);
     return NULL;
 }
 
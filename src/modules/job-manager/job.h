@@ -16,6 +16,20 @@
 #include <jansson.h>
 #include "src/common/libjob/job.h"
 
+/* Points in the submit-to-start pipeline of a job, in order.
+ * See latency.h.
+ */
+enum job_mark {
+    JOB_MARK_INGEST,        // job-ingest received the submit request
+    JOB_MARK_SUBMIT,        // job-ingest logged the submit event
+    JOB_MARK_ACCEPT,        // job-manager accepted the job
+    JOB_MARK_SCHED,         // job entered SCHED state
+    JOB_MARK_ALLOC_REQUEST, // alloc request sent to sched
+    JOB_MARK_ALLOC,         // alloc response received
+    JOB_MARK_START,         // start response received from job-exec
+    JOB_MARK_COUNT,
+};
+
 struct job {
     flux_jobid_t id;
     uint32_t userid;
@@ -24,6 +38,7 @@ struct job {
     int flags;
     flux_job_state_t state;
     json_t *end_event;      // event that caused transition to CLEANUP state
+    json_t *wait_result;    // flux_job_wait() result, set when INACTIVE
     const flux_msg_t *waiter; // flux_job_wait() request
 
     uint8_t alloc_queued:1; // queued for alloc, but alloc request not sent
@@ -34,7 +49,20 @@ struct job {
 
     json_t *annotations;
 
-    void *handle;           // zlistx_t handle
+    /* Data for job-manager.journal, see journal.h.
+     */
+    json_t *jobspec;        // jobspec summary from job-ingest, if any
+    json_t *R;              // R from sched.alloc response, until free
+    json_t *exception_context; // context of most severe exception
+    int exception_severity;
+    uint8_t success:1;      // job finished with zero status
+
+    void *handle;           // alloc queue handle
+    void *state_handle;     // jobindex state handle
+    void *user_handle;      // jobindex user handle
+    void *zombie_handle;    // wait zombie queue handle
+    flux_job_state_t index_state; // state of jobindex entry, 0 if none
+    double t_mark[JOB_MARK_COUNT]; // wallclock time of each mark, 0 if none
     int refcount;           // private to job.c
 };
 
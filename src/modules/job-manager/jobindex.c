@@ -0,0 +1,273 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* jobindex.c - secondary indices of active jobs
+ *
+ * Active jobs are hashed by jobid in ctx->active_jobs.  These indices
+ * let job-manager.list find the jobs in a given state, or belonging to
+ * a given user, without walking the whole hash.  Each index is a skiplist
+ * sorted by job_comparator(), so priority order comes for free.
+ *
+ * Per-user indices are created on demand and destroyed when empty.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <errno.h>
+#include <czmq.h>
+
+#include "src/common/libutil/skiplist.h"
+#include "src/common/libjob/job_hash.h"
+
+#include "job.h"
+#include "jobindex.h"
+
+#define NUM_STATES 6 // NEW through INACTIVE, one bit each
+
+struct user {
+    flux_jobid_t key;       // userid, widened for job_hash
+    struct skiplist *jobs;
+};
+
+struct jobindex {
+    struct skiplist *state[NUM_STATES];
+    zhashx_t *users;
+};
+
+static int state_index (flux_job_state_t state)
+{
+    int i;
+
+    for (i = 0; i < NUM_STATES; i++) {
+        if (state == (1 << i))
+            return i;
+    }
+    return -1;
+}
+
+static void user_destroy (struct user *user)
+{
+    if (user) {
+        int saved_errno = errno;
+        skiplist_destroy (user->jobs);
+        free (user);
+        errno = saved_errno;
+    }
+}
+
+static void user_destructor (void **item)
+{
+    if (item) {
+        user_destroy (*item);
+        *item = NULL;
+    }
+}
+
+static struct user *user_create (uint32_t userid)
+{
+    struct user *user;
+
+    if (!(user = calloc (1, sizeof (*user))))
+        return NULL;
+    user->key = userid;
+    if (!(user->jobs = skiplist_create (job_comparator))) {
+        user_destroy (user);
+        return NULL;
+    }
+    return user;
+}
+
+static struct user *user_lookup (struct jobindex *ix, uint32_t userid)
+{
+    flux_jobid_t key = userid;
+
+    return zhashx_lookup (ix->users, &key);
+}
+
+static struct skiplist *state_list (struct jobindex *ix,
+                                    flux_job_state_t state)
+{
+    int i = state_index (state);
+
+    return i < 0 ? NULL : ix->state[i];
+}
+
+void jobindex_destroy (struct jobindex *ix)
+{
+    if (ix) {
+        int saved_errno = errno;
+        int i;
+        zhashx_destroy (&ix->users);
+        for (i = 0; i < NUM_STATES; i++)
+            skiplist_destroy (ix->state[i]);
+        free (ix);
+        errno = saved_errno;
+    }
+}
+
+struct jobindex *jobindex_create (void)
+{
+    struct jobindex *ix;
+    int i;
+
+    if (!(ix = calloc (1, sizeof (*ix))))
+        return NULL;
+    for (i = 0; i < NUM_STATES; i++) {
+        if (!(ix->state[i] = skiplist_create (job_comparator)))
+            goto error;
+    }
+    if (!(ix->users = job_hash_create ()))
+        goto nomem;
+    zhashx_set_destructor (ix->users, user_destructor);
+    return ix;
+nomem:
+    errno = ENOMEM;
+error:
+    jobindex_destroy (ix);
+    return NULL;
+}
+
+static int state_insert (struct jobindex *ix, struct job *job)
+{
+    struct skiplist *sl;
+
+    if (!(sl = state_list (ix, job->state))) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!(job->state_handle = skiplist_insert (sl, job)))
+        return -1;
+    job->index_state = job->state;
+    return 0;
+}
+
+static void state_remove (struct jobindex *ix, struct job *job)
+{
+    if (job->state_handle) {
+        skiplist_delete (state_list (ix, job->index_state), job->state_handle);
+        job->state_handle = NULL;
+        job->index_state = 0;
+    }
+}
+
+int jobindex_insert (struct jobindex *ix, struct job *job)
+{
+    struct user *user;
+
+    if (!ix)
+        return 0;
+    if (!job || job->state_handle || job->user_handle) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!(user = user_lookup (ix, job->userid))) {
+        if (!(user = user_create (job->userid)))
+            return -1;
+        if (zhashx_insert (ix->users, &user->key, user) < 0) {
+            user_destroy (user);
+            errno = EEXIST;
+            return -1;
+        }
+    }
+    if (!(job->user_handle = skiplist_insert (user->jobs, job)))
+        goto error;
+    if (state_insert (ix, job) < 0)
+        goto error;
+    return 0;
+error:
+    jobindex_remove (ix, job);
+    return -1;
+}
+
+void jobindex_remove (struct jobindex *ix, struct job *job)
+{
+    struct user *user;
+
+    if (!ix || !job)
+        return;
+    state_remove (ix, job);
+    if (job->user_handle) {
+        if ((user = user_lookup (ix, job->userid))) {
+            skiplist_delete (user->jobs, job->user_handle);
+            if (skiplist_size (user->jobs) == 0)
+                zhashx_delete (ix->users, &user->key);
+        }
+        job->user_handle = NULL;
+    }
+}
+
+int jobindex_update_state (struct jobindex *ix, struct job *job)
+{
+    if (!ix || !job || !job->state_handle || job->index_state == job->state)
+        return 0;
+    state_remove (ix, job);
+    return state_insert (ix, job);
+}
+
+void jobindex_reorder (struct jobindex *ix, struct job *job)
+{
+    struct user *user;
+
+    if (!ix || !job)
+        return;
+    if (job->state_handle)
+        skiplist_reorder (state_list (ix, job->index_state),
+                          job->state_handle);
+    if (job->user_handle && (user = user_lookup (ix, job->userid)))
+        skiplist_reorder (user->jobs, job->user_handle);
+}
+
+struct job *jobindex_state_first (struct jobindex *ix, flux_job_state_t state)
+{
+    return ix ? skiplist_first (state_list (ix, state)) : NULL;
+}
+
+struct job *jobindex_state_next (struct jobindex *ix, flux_job_state_t state)
+{
+    return ix ? skiplist_next (state_list (ix, state)) : NULL;
+}
+
+struct job *jobindex_user_first (struct jobindex *ix, uint32_t userid)
+{
+    struct user *user;
+
+    if (!ix || !(user = user_lookup (ix, userid)))
+        return NULL;
+    return skiplist_first (user->jobs);
+}
+
+struct job *jobindex_user_next (struct jobindex *ix, uint32_t userid)
+{
+    struct user *user;
+
+    if (!ix || !(user = user_lookup (ix, userid)))
+        return NULL;
+    return skiplist_next (user->jobs);
+}
+
+int jobindex_state_count (struct jobindex *ix, flux_job_state_t state)
+{
+    return ix ? skiplist_size (state_list (ix, state)) : 0;
+}
+
+int jobindex_user_count (struct jobindex *ix, uint32_t userid)
+{
+    struct user *user;
+
+    if (!ix || !(user = user_lookup (ix, userid)))
+        return 0;
+    return skiplist_size (user->jobs);
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,63 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _FLUX_JOB_MANAGER_JOBINDEX_H
+#define _FLUX_JOB_MANAGER_JOBINDEX_H
+
+#include <stdint.h>
+
+#include "job.h"
+
+/* Secondary indices of active jobs, by state and by userid.
+ * Each index is kept in job_comparator() order (priority, then t_submit),
+ * so the first N jobs of an index are the N highest priority jobs.
+ * Jobs are indexed from the end of NEW state until they are removed
+ * from the active job hash.  The index does not hold job references.
+ * A NULL 'ix' is accepted and ignored by all functions.
+ */
+
+struct jobindex *jobindex_create (void);
+void jobindex_destroy (struct jobindex *ix);
+
+/* Add 'job' to the indices for its current state and userid.
+ */
+int jobindex_insert (struct jobindex *ix, struct job *job);
+
+/* Remove 'job' from all indices.  No-op if 'job' is not indexed.
+ */
+void jobindex_remove (struct jobindex *ix, struct job *job);
+
+/* Move 'job' to the index for its current state, after a state change.
+ */
+int jobindex_update_state (struct jobindex *ix, struct job *job);
+
+/* Reposition 'job' after its priority has changed.
+ */
+void jobindex_reorder (struct jobindex *ix, struct job *job);
+
+/* Iterate over jobs in 'state', or owned by 'userid', in priority order.
+ * Return NULL at end of list.  It is not safe to modify the iterated index
+ * (e.g. by posting job events) while iterating.
+ */
+struct job *jobindex_state_first (struct jobindex *ix, flux_job_state_t state);
+struct job *jobindex_state_next (struct jobindex *ix, flux_job_state_t state);
+struct job *jobindex_user_first (struct jobindex *ix, uint32_t userid);
+struct job *jobindex_user_next (struct jobindex *ix, uint32_t userid);
+
+/* Return the number of jobs in 'state', or owned by 'userid'.
+ */
+int jobindex_state_count (struct jobindex *ix, flux_job_state_t state);
+int jobindex_user_count (struct jobindex *ix, uint32_t userid);
+
+#endif /* !_FLUX_JOB_MANAGER_JOBINDEX_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
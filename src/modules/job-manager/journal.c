@@ -0,0 +1,226 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* journal - stream job state transitions to job-manager.journal listeners
+ *
+ * Purpose:
+ *   Handle job-manager.journal streaming RPC, so that job-info can follow
+ *   job state without KVS lookups.
+ *
+ * Responses:
+ *   {"transitions":[[id, state, timestamp, data?], ...]}
+ *   like the "job-state" event, plus an optional object 'data':
+ *   - DEPEND: {"userid":i, "priority":i, "flags":i, "jobspec"?:o}
+ *     where "jobspec" is the summary passed in by job-ingest
+ *   - RUN: {"R"?:s}, if the scheduler returned R in its alloc response
+ *   - INACTIVE: {"success":b, "exception"?:o}
+ *     where "exception" is the context of the most severe exception
+ *   Missing data must be looked up in the KVS.  Responses are sent
+ *   after their batch has been committed to the KVS, before the
+ *   "job-state" event for the same batch is published.
+ *
+ *   When the job-manager unloads, the stream ends with ENODATA.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <flux/core.h>
+#include <jansson.h>
+
+#include "job.h"
+#include "journal.h"
+#include "job-manager.h"
+
+struct journal {
+    struct job_manager *ctx;
+    flux_msg_handler_t **handlers;
+    struct flux_msglist *listeners;
+};
+
+bool journal_listening (struct journal *journal)
+{
+    if (journal && flux_msglist_count (journal->listeners) > 0)
+        return true;
+    return false;
+}
+
+/* Set '*datap' to the data for the current state of 'job', or NULL
+ * if there is none.
+ */
+static int journal_data_create (struct job *job, json_t **datap)
+{
+    json_t *data = NULL;
+
+    switch (job->state) {
+        case FLUX_JOB_DEPEND:
+            if (!(data = json_pack ("{s:i s:i s:i}",
+                                    "userid", job->userid,
+                                    "priority", job->priority,
+                                    "flags", job->flags)))
+                goto nomem;
+            if (job->jobspec
+                && json_object_set (data, "jobspec", job->jobspec) < 0)
+                goto nomem;
+            break;
+        case FLUX_JOB_RUN:
+            if (job->R && !(data = json_pack ("{s:O}", "R", job->R)))
+                goto nomem;
+            break;
+        case FLUX_JOB_INACTIVE:
+            if (!(data = json_pack ("{s:b}", "success", job->success)))
+                goto nomem;
+            if (job->exception_context
+                && json_object_set (data,
+                                    "exception",
+                                    job->exception_context) < 0)
+                goto nomem;
+            break;
+        default:
+            break;
+    }
+    *datap = data;
+    return 0;
+nomem:
+    json_decref (data);
+    errno = ENOMEM;
+    return -1;
+}
+
+json_t *journal_entry_create (struct job *job, double timestamp)
+{
+    json_t *entry;
+    json_t *data = NULL;
+
+    if (!(entry = json_pack ("[I,s,f]",
+                             job->id,
+                             flux_job_statetostr (job->state, false),
+                             timestamp)))
+        goto nomem;
+    if (journal_data_create (job, &data) < 0)
+        goto nomem;
+    if (data && json_array_append_new (entry, data) < 0)
+        goto nomem;
+    return entry;
+nomem:
+    json_decref (entry);
+    errno = ENOMEM;
+    return NULL;
+}
+
+void journal_send (struct journal *journal, json_t *entries)
+{
+    const flux_msg_t *msg;
+
+    if (!journal)
+        return;
+    msg = flux_msglist_first (journal->listeners);
+    while (msg) {
+        if (flux_respond_pack (journal->ctx->h,
+                               msg,
+                               "{s:O}",
+                               "transitions", entries) < 0) {
+            flux_log_error (journal->ctx->h, "error responding to journal");
+            (void)flux_msglist_remove (journal->listeners, (void *)msg);
+            flux_msg_decref (msg);
+        }
+        msg = flux_msglist_next (journal->listeners);
+    }
+}
+
+void journal_disconnect (struct journal *journal, const flux_msg_t *msg)
+{
+    const flux_msg_t *req;
+
+    if (!journal)
+        return;
+    while ((req = flux_msglist_pop_sender (journal->listeners,
+                                           msg,
+                                           FLUX_MATCHTAG_NONE)))
+        flux_msg_decref (req);
+}
+
+static void journal_handle_request (flux_t *h,
+                                    flux_msg_handler_t *mh,
+                                    const flux_msg_t *msg,
+                                    void *arg)
+{
+    struct job_manager *ctx = arg;
+    struct journal *journal = ctx->journal;
+
+    if (flux_request_decode (msg, NULL, NULL) < 0)
+        goto error;
+    if (!flux_msg_is_streaming (msg)) {
+        errno = EPROTO;
+        goto error;
+    }
+    if (flux_msglist_append (journal->listeners,
+                             msg,
+                             (void *)flux_msg_incref (msg)) < 0) {
+        flux_msg_decref (msg);
+        goto error;
+    }
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+}
+
+void journal_ctx_destroy (struct journal *journal)
+{
+    if (journal) {
+        flux_t *h = journal->ctx->h;
+        const flux_msg_t *msg;
+        int saved_errno = errno;
+
+        flux_msg_handler_delvec (journal->handlers);
+        if (journal->listeners) {
+            while ((msg = flux_msglist_pop (journal->listeners))) {
+                if (flux_respond_error (h, msg, ENODATA, NULL) < 0)
+                    flux_log_error (h, "error ending journal");
+                flux_msg_decref (msg);
+            }
+            flux_msglist_destroy (journal->listeners);
+        }
+        free (journal);
+        errno = saved_errno;
+    }
+}
+
+static const struct flux_msg_handler_spec htab[] = {
+    {
+        FLUX_MSGTYPE_REQUEST,
+        "job-manager.journal",
+        journal_handle_request,
+        0
+    },
+    FLUX_MSGHANDLER_TABLE_END,
+};
+
+struct journal *journal_ctx_create (struct job_manager *ctx)
+{
+    struct journal *journal;
+
+    if (!(journal = calloc (1, sizeof (*journal))))
+        return NULL;
+    journal->ctx = ctx;
+    if (!(journal->listeners = flux_msglist_create ()))
+        goto error;
+    if (flux_msg_handler_addvec (ctx->h, htab, ctx, &journal->handlers) < 0)
+        goto error;
+    return journal;
+error:
+    journal_ctx_destroy (journal);
+    return NULL;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
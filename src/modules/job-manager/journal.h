@@ -0,0 +1,47 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _FLUX_JOB_MANAGER_JOURNAL_H
+#define _FLUX_JOB_MANAGER_JOURNAL_H
+
+#include <stdbool.h>
+#include <jansson.h>
+#include <flux/core.h>
+
+#include "job.h"
+#include "job-manager.h"
+
+/* Return true if any job-manager.journal requests are pending,
+ * so event.c can skip building journal entries when nobody listens.
+ */
+bool journal_listening (struct journal *journal);
+
+/* Create a journal entry for the transition of 'job' to its current
+ * state at 'timestamp':  [id, state, timestamp, data], where 'data'
+ * holds what the state's consumers would otherwise read from the KVS.
+ */
+json_t *journal_entry_create (struct job *job, double timestamp);
+
+/* Send array of journal entries to all listeners.
+ */
+void journal_send (struct journal *journal, json_t *entries);
+
+/* Drop journal requests from the sender of disconnect request 'msg'.
+ */
+void journal_disconnect (struct journal *journal, const flux_msg_t *msg);
+
+struct journal *journal_ctx_create (struct job_manager *ctx);
+void journal_ctx_destroy (struct journal *journal);
+
+#endif /* ! _FLUX_JOB_MANAGER_JOURNAL_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -11,10 +11,11 @@
 /* kill - send a signal to a running job
  *
  * Purpose:
- *   Handle job-manager.kill RPC
+ *   Handle job-manager.kill and job-manager.killall RPCs
  *
  * Input:
  * - job id, signum
+ * - killall: userid, and optionally a list of job ids, in place of job id
  *
  * Action:
  * - check for valid job and job state
@@ -33,6 +34,7 @@
 #include "job.h"
 #include "event.h"
 #include "kill.h"
+#include "raise.h"
 #include <job-manager.h>
 
 #ifndef SIGRTMAX
@@ -112,6 +114,7 @@ error:
 
 /* Send a signal to all jobs belonging to 'userid'.
  * Consider userid == FLUX_USERID_UNKNOWN to be a wildcard matching all users.
+ * If "ids" is set, only the listed jobs are considered.
  */
 void killall_handle_request (flux_t *h,
                              flux_msg_handler_t *mh,
@@ -119,6 +122,7 @@ void killall_handle_request (flux_t *h,
                              void *arg)
 {
     struct job_manager *ctx = arg;
+    struct flux_msg_cred cred;
     uint32_t userid;
     int signum;
     const char *errstr = NULL;
@@ -126,25 +130,29 @@ void killall_handle_request (flux_t *h,
     struct job *job;
     flux_future_t *f;
     int dry_run;
-    int count = 0;
+    json_t *ids = NULL;
+    zlistx_t *target_jobs = NULL;
     int error_count = 0;
 
     if (flux_request_unpack (msg,
                              NULL,
-                             "{s:b s:i s:i}",
+                             "{s:b s:i s:i s?:o}",
                              "dry_run",
                              &dry_run,
                              "userid",
                              &userid,
                              "signum",
-                             &signum) < 0) {
+                             &signum,
+                             "ids",
+                             &ids) < 0) {
         errstr = "error decoding request";
         goto error;
     }
     /* Only the instance owner gets to use the userid wildcard.
      * Guests must specify 'userid' = themselves.
      */
-    if (flux_msg_authorize (msg, userid) < 0) {
+    if (flux_msg_get_cred (msg, &cred) < 0
+        || find_jobs_authorize (cred, ids, &userid) < 0) {
         errstr = "guests can only kill their own jobs";
         goto error;
     }
@@ -153,40 +161,36 @@ void killall_handle_request (flux_t *h,
         errno = EINVAL;
         goto error;
     }
-    job = zhashx_first (ctx->active_jobs);
-    while (job) {
-        if (job->state != FLUX_JOB_RUN)
+    if (find_jobs (ctx, userid, FLUX_JOB_RUN, ids, &target_jobs) < 0)
+        goto error;
+    job = zlistx_first (target_jobs);
+    while (job && !dry_run) {
+        if (kill_event_topic_str (topic, sizeof (topic), job->id) < 0) {
+            error_count++;
             goto next;
-        if (userid != FLUX_USERID_UNKNOWN && userid != job->userid)
+        }
+        if (!(f = flux_event_publish_pack (h,
+                                           topic,
+                                           0,
+                                           "{s:i}",
+                                           "signum",
+                                           signum))) {
+            error_count++;
             goto next;
-        count++;
-        if (!dry_run) {
-            if (kill_event_topic_str (topic, sizeof (topic), job->id) < 0) {
-                error_count++;
-                goto next;
-            }
-            if (!(f = flux_event_publish_pack (h,
-                                               topic,
-                                               0,
-                                               "{s:i}",
-                                               "signum",
-                                               signum))) {
-                error_count++;
-                goto next;
-            }
-            flux_future_destroy (f);
         }
+        flux_future_destroy (f);
 next:
-        job = zhashx_next (ctx->active_jobs);
+        job = zlistx_next (target_jobs);
     }
     if (flux_respond_pack (h,
                            msg,
                            "{s:i s:i}",
                            "count",
-                           count,
+                           zlistx_size (target_jobs),
                            "errors",
                            error_count) < 0)
         flux_log_error (h, "%s: flux_respond", __FUNCTION__);
+    zlistx_destroy (&target_jobs);
     return;
 error:
     if (flux_respond_error (h, msg, errno, errstr) < 0)
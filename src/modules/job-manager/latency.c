@@ -0,0 +1,235 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* latency.c - histograms of job submit-to-start stage latency
+ *
+ * Each job records the wallclock time it reaches each mark in
+ * enum job_mark, and the time between consecutive marks is added to a
+ * log2 histogram for the stage between them:
+ *
+ *   validate  ingest received request -> submit event (validation, signing)
+ *   ingest    submit event -> accepted by job-manager (KVS commit, RPC)
+ *   depend    accepted -> SCHED state (depend event)
+ *   queue     SCHED state -> alloc request sent (alloc queue)
+ *   sched     alloc request sent -> alloc response (scheduler)
+ *   exec      alloc response -> start response (job-exec, shell launch)
+ *   total     submit event -> start response
+ *
+ * The ingest timestamps come from job-ingest on the same broker, so all
+ * marks are read from the same clock.  Jobs reloaded from the KVS on
+ * restart have no marks and are not counted.
+ *
+ * job-manager.stats.get responds with {"latency":{stage:stats, ...}},
+ * where stats is described in loghist.h, and the admission control
+ * stats described in admission.c.  job-manager.stats.clear clears the
+ * histograms and admission counters.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+#include <jansson.h>
+#include <flux/core.h>
+
+#include "src/common/libutil/loghist.h"
+#include "src/common/libutil/errno_safe.h"
+
+#include "job.h"
+#include "latency.h"
+#include "admission.h"
+
+/* Name of the stage that ends at each mark.
+ */
+static const char *stage_names[JOB_MARK_COUNT] = {
+    [JOB_MARK_INGEST] = NULL,
+    [JOB_MARK_SUBMIT] = "validate",
+    [JOB_MARK_ACCEPT] = "ingest",
+    [JOB_MARK_SCHED] = "depend",
+    [JOB_MARK_ALLOC_REQUEST] = "queue",
+    [JOB_MARK_ALLOC] = "sched",
+    [JOB_MARK_START] = "exec",
+};
+
+struct latency {
+    struct job_manager *ctx;
+    flux_msg_handler_t **handlers;
+    struct loghist stage[JOB_MARK_COUNT];
+    struct loghist total;
+};
+
+static double wallclock (void)
+{
+    struct timespec ts;
+
+    if (clock_gettime (CLOCK_REALTIME, &ts) < 0)
+        return 0.;
+    return (1E-9 * ts.tv_nsec) + ts.tv_sec;
+}
+
+static void stage_add (struct latency *latency,
+                       struct job *job,
+                       enum job_mark mark)
+{
+    double t0 = job->t_mark[mark - 1];
+    double t1 = job->t_mark[mark];
+
+    if (t0 > 0. && t1 > 0.)
+        loghist_add (&latency->stage[mark], t1 - t0);
+}
+
+void latency_mark (struct latency *latency,
+                   struct job *job,
+                   enum job_mark mark)
+{
+    if (job->t_mark[mark] > 0.)
+        return;
+    job->t_mark[mark] = wallclock ();
+    if (!latency)
+        return;
+    /* The submit mark is set from job-ingest, so the validate stage
+     * is added when the job is accepted.
+     */
+    if (mark == JOB_MARK_ACCEPT)
+        stage_add (latency, job, JOB_MARK_SUBMIT);
+    stage_add (latency, job, mark);
+    if (mark == JOB_MARK_START && job->t_mark[JOB_MARK_SUBMIT] > 0.) {
+        loghist_add (&latency->total, job->t_mark[JOB_MARK_START]
+                                      - job->t_mark[JOB_MARK_SUBMIT]);
+    }
+}
+
+static json_t *latency_encode (struct latency *latency)
+{
+    json_t *o;
+    json_t *stats;
+
+    if (!(o = json_object ()))
+        goto nomem;
+    for (int i = 0; i < JOB_MARK_COUNT; i++) {
+        if (!stage_names[i])
+            continue;
+        if (!(stats = loghist_encode (&latency->stage[i])))
+            goto error;
+        if (json_object_set_new (o, stage_names[i], stats) < 0) {
+            json_decref (stats);
+            goto nomem;
+        }
+    }
+    if (!(stats = loghist_encode (&latency->total)))
+        goto error;
+    if (json_object_set_new (o, "total", stats) < 0) {
+        json_decref (stats);
+        goto nomem;
+    }
+    return o;
+nomem:
+    errno = ENOMEM;
+error:
+    ERRNO_SAFE_WRAP (json_decref, o);
+    return NULL;
+}
+
+static void stats_get_cb (flux_t *h,
+                          flux_msg_handler_t *mh,
+                          const flux_msg_t *msg,
+                          void *arg)
+{
+    struct job_manager *ctx = arg;
+    json_t *o;
+    json_t *admission;
+
+    if (flux_request_decode (msg, NULL, NULL) < 0)
+        goto error;
+    if (!(o = latency_encode (ctx->latency)))
+        goto error;
+    if (!(admission = admission_stats_encode (ctx->admission))) {
+        ERRNO_SAFE_WRAP (json_decref, o);
+        goto error;
+    }
+    if (flux_respond_pack (h,
+                           msg,
+                           "{s:o s:o}",
+                           "latency", o,
+                           "admission", admission) < 0)
+        flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+}
+
+static void stats_clear_cb (flux_t *h,
+                            flux_msg_handler_t *mh,
+                            const flux_msg_t *msg,
+                            void *arg)
+{
+    struct job_manager *ctx = arg;
+
+    if (flux_request_decode (msg, NULL, NULL) < 0)
+        goto error;
+    for (int i = 0; i < JOB_MARK_COUNT; i++)
+        loghist_clear (&ctx->latency->stage[i]);
+    loghist_clear (&ctx->latency->total);
+    admission_stats_clear (ctx->admission);
+    if (flux_respond (h, msg, NULL) < 0)
+        flux_log_error (h, "%s: flux_respond", __FUNCTION__);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+}
+
+void latency_ctx_destroy (struct latency *latency)
+{
+    if (latency) {
+        int saved_errno = errno;
+        flux_msg_handler_delvec (latency->handlers);
+        free (latency);
+        errno = saved_errno;
+    }
+}
+
+static const struct flux_msg_handler_spec htab[] = {
+    {
+        FLUX_MSGTYPE_REQUEST,
+        "job-manager.stats.get",
+        stats_get_cb,
+        0
+    },
+    {
+        FLUX_MSGTYPE_REQUEST,
+        "job-manager.stats.clear",
+        stats_clear_cb,
+        0
+    },
+    FLUX_MSGHANDLER_TABLE_END,
+};
+
+struct latency *latency_ctx_create (struct job_manager *ctx)
+{
+    struct latency *latency;
+
+    if (!(latency = calloc (1, sizeof (*latency))))
+        return NULL;
+    latency->ctx = ctx;
+    if (flux_msg_handler_addvec (ctx->h, htab, ctx, &latency->handlers) < 0)
+        goto error;
+    return latency;
+error:
+    latency_ctx_destroy (latency);
+    return NULL;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
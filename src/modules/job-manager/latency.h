@@ -0,0 +1,32 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _FLUX_JOB_MANAGER_LATENCY_H
+#define _FLUX_JOB_MANAGER_LATENCY_H
+
+#include "job.h"
+#include "job-manager.h"
+
+/* Record that 'job' has reached 'mark' now.  The time since the
+ * previous mark, if the job has one, is added to the histogram of that
+ * stage.  Only the first time a job reaches a mark is recorded.
+ * 'latency' may be NULL, e.g. in unit tests.
+ */
+void latency_mark (struct latency *latency,
+                   struct job *job,
+                   enum job_mark mark);
+
+struct latency *latency_ctx_create (struct job_manager *ctx);
+void latency_ctx_destroy (struct latency *latency);
+
+#endif /* ! _FLUX_JOB_MANAGER_LATENCY_H */
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
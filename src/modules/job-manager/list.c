@@ -15,9 +15,15 @@
  *
  * Input:
  * - max number of jobs to return from head of queue
+ * - optional userid: only list jobs owned by this user
+ * - optional states: only list jobs in these states (bitmask)
  *
  * Output:
  * - array of job objects
+ *
+ * Filtered requests are answered from the job index, so they need not
+ * visit every active job.  Within each state, jobs are listed in priority,
+ * then t_submit order.
  */
 
 #if HAVE_CONFIG_H
@@ -32,6 +38,7 @@
 #include "list.h"
 #include "alloc.h"
 #include "wait.h"
+#include "jobindex.h"
 #include "job-manager.h"
 
 
@@ -68,6 +75,74 @@ int list_append_job (json_t *jobs, struct job *job)
     return 0;
 }
 
+/* List order for filtered requests: same as unfiltered, SCHED first.
+ */
+static const flux_job_state_t list_states[] = {
+    FLUX_JOB_SCHED,
+    FLUX_JOB_DEPEND,
+    FLUX_JOB_RUN,
+    FLUX_JOB_CLEANUP,
+};
+
+static bool list_full (json_t *jobs, int max_entries)
+{
+    return max_entries > 0 && json_array_size (jobs) >= max_entries;
+}
+
+/* List jobs matching 'userid' (if not FLUX_USERID_UNKNOWN) and 'states'.
+ */
+static int list_filtered (struct job_manager *ctx,
+                          json_t *jobs,
+                          int max_entries,
+                          uint32_t userid,
+                          int states)
+{
+    struct job *job;
+    int i;
+
+    for (i = 0; i < sizeof (list_states) / sizeof (list_states[0]); i++) {
+        flux_job_state_t state = list_states[i];
+
+        if (!(states & state))
+            continue;
+        /* Walk whichever index is shorter.
+         */
+        if (userid != FLUX_USERID_UNKNOWN
+            && jobindex_user_count (ctx->index, userid)
+               < jobindex_state_count (ctx->index, state)) {
+            job = jobindex_user_first (ctx->index, userid);
+            while (job && !list_full (jobs, max_entries)) {
+                if (job->state == state) {
+                    if (list_append_job (jobs, job) < 0)
+                        return -1;
+                }
+                job = jobindex_user_next (ctx->index, userid);
+            }
+        }
+        else {
+            job = jobindex_state_first (ctx->index, state);
+            while (job && !list_full (jobs, max_entries)) {
+                if (userid == FLUX_USERID_UNKNOWN || job->userid == userid) {
+                    if (list_append_job (jobs, job) < 0)
+                        return -1;
+                }
+                job = jobindex_state_next (ctx->index, state);
+            }
+        }
+    }
+    if ((states & FLUX_JOB_INACTIVE)) {
+        job = wait_zombie_first (ctx->wait);
+        while (job) {
+            if (userid == FLUX_USERID_UNKNOWN || job->userid == userid) {
+                if (list_append_job (jobs, job) < 0)
+                    return -1;
+            }
+            job = wait_zombie_next (ctx->wait);
+        }
+    }
+    return 0;
+}
+
 void list_handle_request (flux_t *h,
                           flux_msg_handler_t *mh,
                           const flux_msg_t *msg,
@@ -75,16 +150,22 @@ void list_handle_request (flux_t *h,
 {
     struct job_manager *ctx = arg;
     int max_entries;
+    uint32_t userid = FLUX_USERID_UNKNOWN;
+    int states = 0;
     json_t *jobs = NULL;
     struct job *job;
 
     if (flux_request_unpack (msg,
                              NULL,
-                             "{s:i}",
+                             "{s:i s?:i s?:i}",
                              "max_entries",
-                             &max_entries) < 0)
+                             &max_entries,
+                             "userid",
+                             &userid,
+                             "states",
+                             &states) < 0)
         goto error;
-    if (max_entries < 0) {
+    if (max_entries < 0 || states < 0) {
         errno = EPROTO;
         goto error;
     }
@@ -92,6 +173,13 @@ void list_handle_request (flux_t *h,
         errno = ENOMEM;
         goto error;
     }
+    if (userid != FLUX_USERID_UNKNOWN || states != 0) {
+        if (states == 0)
+            states = FLUX_JOB_ACTIVE | FLUX_JOB_INACTIVE;
+        if (list_filtered (ctx, jobs, max_entries, userid, states) < 0)
+            goto error;
+        goto done;
+    }
     /* First list jobs in SCHED (S) state
      * (priority, then t_submit order).
      */
@@ -121,7 +209,7 @@ void list_handle_request (flux_t *h,
             goto error;
         job = wait_zombie_next (ctx->wait);
     }
-
+done:
     if (flux_respond_pack (h, msg, "{s:O}", "jobs", jobs) < 0)
         flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
     json_decref (jobs);
@@ -129,6 +217,7 @@ void list_handle_request (flux_t *h,
 error:
     if (flux_respond_error (h, msg, errno, NULL) < 0)
         flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+    json_decref (jobs);
 }
 
 /*
@@ -18,6 +18,8 @@
  * Input:
  * - job id
  * - new priority
+ * - priorityall: userid, states, and optionally a list of job ids,
+ *   in place of job id
  *
  * Output:
  * - n/a
@@ -34,12 +36,66 @@
 #include "job.h"
 #include "event.h"
 #include "alloc.h"
+#include "raise.h"
 #include "job-manager.h"
 
 #include "priority.h"
 
 #define MAXOF(a,b)   ((a)>(b)?(a):(b))
 
+/* Change the priority of 'job' on behalf of 'cred'.
+ * On failure, set errno and '*errstr' if a message is available.
+ */
+static int priority_job (struct job_manager *ctx,
+                         struct job *job,
+                         struct flux_msg_cred cred,
+                         int priority,
+                         const char **errstr)
+{
+    /* Security: guests can only adjust jobs that they submitted.
+     */
+    if (flux_msg_cred_authorize (cred, job->userid) < 0) {
+        *errstr = "guests can only reprioritize their own jobs";
+        return -1;
+    }
+    /* Security: guests can only reduce priority, or increase up to default.
+     */
+    if (!(cred.rolemask & FLUX_ROLE_OWNER)
+            && priority > MAXOF (FLUX_JOB_PRIORITY_DEFAULT, job->priority)) {
+        *errstr = "guests can only adjust priority <= default";
+        errno = EPERM;
+        return -1;
+    }
+    /* RFC 27 does not yet handle priority changes after alloc request
+     * has been sent to the scheduler.  Also, alloc_queue_reorder() will
+     * segfault if job->handle is NULL, which is the case if the job is
+     * no longer in alloc->queue.
+     */
+    if (job->alloc_pending) {
+        *errstr = "job has made an alloc request to scheduler, "
+                  "priority cannot be changed";
+        errno = EINVAL;
+        return -1;
+    }
+    /* Post event and change job's queue position.
+     */
+    if (event_job_post_pack (ctx->event, job,
+                             "priority",
+                             "{ s:i s:i }",
+                             "userid", cred.userid,
+                             "priority", priority) < 0)
+        return -1;
+    alloc_queue_reorder (ctx->alloc, job);
+    return 0;
+}
+
+static int priority_check (int priority)
+{
+    if (priority < FLUX_JOB_PRIORITY_MIN || priority > FLUX_JOB_PRIORITY_MAX)
+        return -1;
+    return 0;
+}
+
 void priority_handle_request (flux_t *h,
                               flux_msg_handler_t *mh,
                               const flux_msg_t *msg,
@@ -57,7 +113,7 @@ void priority_handle_request (flux_t *h,
                                         "priority", &priority) < 0
                     || flux_msg_get_cred (msg, &cred) < 0)
         goto error;
-    if (priority < FLUX_JOB_PRIORITY_MIN || priority > FLUX_JOB_PRIORITY_MAX) {
+    if (priority_check (priority) < 0) {
         errstr = "priority value is out of range";
         errno = EINVAL;
         goto error;
@@ -67,46 +123,96 @@ void priority_handle_request (flux_t *h,
         errno = EINVAL;
         goto error;
     }
-    /* Security: guests can only adjust jobs that they submitted.
-     */
-    if (flux_msg_cred_authorize (cred, job->userid) < 0) {
-        errstr = "guests can only reprioritize their own jobs";
+    if (priority_job (ctx, job, cred, priority, &errstr) < 0)
         goto error;
-    }
-    /* Security: guests can only reduce priority, or increase up to default.
+    if (flux_respond (h, msg, NULL) < 0)
+        flux_log_error (h, "%s: flux_respond", __FUNCTION__);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, errstr) < 0)
+        flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+}
+
+/* Set priority of all jobs of 'userid' with state matching 'mask'.
+ * Consider userid == FLUX_USERID_UNKNOWN to be a wildcard matching all users.
+ * If "ids" is set, only the listed jobs are considered.
+ * Jobs whose priority cannot be changed are counted as errors.
+ */
+void priorityall_handle_request (flux_t *h,
+                                 flux_msg_handler_t *mh,
+                                 const flux_msg_t *msg,
+                                 void *arg)
+{
+    struct job_manager *ctx = arg;
+    struct flux_msg_cred cred;
+    uint32_t userid;
+    int dry_run;
+    int state_mask;
+    int priority;
+    json_t *ids = NULL;
+    const char *errstr = NULL;
+    zlistx_t *target_jobs = NULL;
+    struct job *job;
+    int error_count = 0;
+
+    if (flux_request_unpack (msg,
+                             NULL,
+                             "{s:b s:i s:i s:i s?:o}",
+                             "dry_run",
+                             &dry_run,
+                             "userid",
+                             &userid,
+                             "states",
+                             &state_mask,
+                             "priority",
+                             &priority,
+                             "ids",
+                             &ids) < 0
+        || flux_msg_get_cred (msg, &cred) < 0)
+        goto error;
+    /* Only the instance owner gets to use the userid wildcard.
+     * Guests must specify 'userid' = themselves.
      */
-    if (!(cred.rolemask & FLUX_ROLE_OWNER)
-            && priority > MAXOF (FLUX_JOB_PRIORITY_DEFAULT, job->priority)) {
-        errstr = "guests can only adjust priority <= default";
-        errno = EPERM;
+    if (find_jobs_authorize (cred, ids, &userid) < 0) {
+        errstr = "guests can only reprioritize their own jobs";
         goto error;
     }
-    /* RFC 27 does not yet handle priority changes after alloc request
-     * has been sent to the scheduler.  Also, alloc_queue_reorder() will
-     * segfault if job->handle is NULL, which is the case if the job is
-     * no longer in alloc->queue.
-     */
-    if (job->alloc_pending) {
-        errstr = "job has made an alloc request to scheduler, "
-                 "priority cannot be changed";
+    if (priority_check (priority) < 0) {
+        errstr = "priority value is out of range";
         errno = EINVAL;
         goto error;
     }
-    /* Post event, change job's queue position, and respond.
-     */
-    if (event_job_post_pack (ctx->event, job,
-                             "priority",
-                             "{ s:i s:i }",
-                             "userid", cred.userid,
-                             "priority", priority) < 0)
+    if (find_jobs (ctx, userid, state_mask, ids, &target_jobs) < 0)
         goto error;
-    alloc_queue_reorder (ctx->alloc, job);
-    if (flux_respond (h, msg, NULL) < 0)
+    if (!dry_run) {
+        job = zlistx_first (target_jobs);
+        while (job) {
+            const char *s = NULL;
+            if (priority_job (ctx, job, cred, priority, &s) < 0) {
+                flux_log (h,
+                          LOG_DEBUG,
+                          "error setting priority on id=%ju: %s",
+                          (uintmax_t)job->id,
+                          s ? s : flux_strerror (errno));
+                error_count++;
+            }
+            job = zlistx_next (target_jobs);
+        }
+    }
+    if (flux_respond_pack (h,
+                           msg,
+                           "{s:i s:i}",
+                           "count",
+                           zlistx_size (target_jobs),
+                           "errors",
+                           error_count) < 0)
         flux_log_error (h, "%s: flux_respond", __FUNCTION__);
+    zlistx_destroy (&target_jobs);
     return;
 error:
     if (flux_respond_error (h, msg, errno, errstr) < 0)
         flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+    zlistx_destroy (&target_jobs);
 }
 
 /*
@@ -21,6 +21,13 @@ void priority_handle_request (flux_t *h,
                               const flux_msg_t *msg,
                               void *arg);
 
+/* Handle a 'priorityall' request - priority adjustment of multiple jobs
+ */
+void priorityall_handle_request (flux_t *h,
+                                 flux_msg_handler_t *mh,
+                                 const flux_msg_t *msg,
+                                 void *arg);
+
 
 #endif /* ! _FLUX_JOB_MANAGER_PRIORITY_H */
 
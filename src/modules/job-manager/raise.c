@@ -11,10 +11,12 @@
 /* raise - raise an exception on a job
  *
  * Purpose:
- *   Handle job-manager.raise RPC
+ *   Handle job-manager.raise and job-manager.raiseall RPCs
  *
  * Input:
  * - job id, severity, type, note (optional)
+ * - raiseall: userid, states, and optionally a list of job ids,
+ *   in place of job id
  *
  * Action:
  * - publish exception event
@@ -150,32 +152,62 @@ error:
         flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
 }
 
-/* Create a list of jobs matching userid, state_mask criteria.
- * FLUX_USERID_UNKNOWN is a wildcard that matches any user.
- */
+static bool job_matches (struct job *job, uint32_t userid, int state_mask)
+{
+    if (!(job->state & state_mask))
+        return false;
+    if (userid != FLUX_USERID_UNKNOWN && userid != job->userid)
+        return false;
+    return true;
+}
+
 int find_jobs (struct job_manager *ctx,
                uint32_t userid,
                int state_mask,
+               json_t *ids,
                zlistx_t **lp)
 {
     zlistx_t *l;
     struct job *job;
 
+    if (ids && !json_is_array (ids)) {
+        errno = EPROTO;
+        return -1;
+    }
     if (!(l = zlistx_new()))
         goto nomem;
     zlistx_set_destructor (l, job_destructor);
     zlistx_set_duplicator (l, job_duplicator);
 
-    job = zhashx_first (ctx->active_jobs);
-    while (job) {
-        if (!(job->state & state_mask))
-            goto next;
-        if (userid != FLUX_USERID_UNKNOWN && userid != job->userid)
-            goto next;
-        if (!zlistx_add_end (l, job))
-            goto nomem;
-next:
-        job = zhashx_next (ctx->active_jobs);
+    if (ids) {
+        size_t index;
+        json_t *entry;
+
+        json_array_foreach (ids, index, entry) {
+            flux_jobid_t id;
+
+            if (!json_is_integer (entry)) {
+                zlistx_destroy (&l);
+                errno = EPROTO;
+                return -1;
+            }
+            id = json_integer_value (entry);
+            if (!(job = zhashx_lookup (ctx->active_jobs, &id))
+                || !job_matches (job, userid, state_mask))
+                continue;
+            if (!zlistx_add_end (l, job))
+                goto nomem;
+        }
+    }
+    else {
+        job = zhashx_first (ctx->active_jobs);
+        while (job) {
+            if (job_matches (job, userid, state_mask)) {
+                if (!zlistx_add_end (l, job))
+                    goto nomem;
+            }
+            job = zhashx_next (ctx->active_jobs);
+        }
     }
     *lp = l;
     return 0;
@@ -185,8 +217,20 @@ nomem:
     return -1;
 }
 
+int find_jobs_authorize (struct flux_msg_cred cred,
+                         json_t *ids,
+                         uint32_t *userid)
+{
+    if (ids
+        && *userid == FLUX_USERID_UNKNOWN
+        && !(cred.rolemask & FLUX_ROLE_OWNER))
+        *userid = cred.userid;
+    return flux_msg_cred_authorize (cred, *userid);
+}
+
 /* Raise exception on all jobs of 'userid' with state matching 'mask'.
  * Consider userid == FLUX_USERID_UNKNOWN to be a wildcard matching all users.
+ * If "ids" is set, only the listed jobs are considered.
  */
 void raiseall_handle_request (flux_t *h,
                               flux_msg_handler_t *mh,
@@ -202,13 +246,14 @@ void raiseall_handle_request (flux_t *h,
     const char *type;
     const char *note = NULL;
     const char *errstr = NULL;
+    json_t *ids = NULL;
     zlistx_t *target_jobs = NULL;
     struct job *job;
     int error_count = 0;
 
     if (flux_request_unpack (msg,
                              NULL,
-                             "{s:b s:i s:i s:i s:s s?:s}",
+                             "{s:b s:i s:i s:i s:s s?:s s?:o}",
                              "dry_run",
                              &dry_run,
                              "userid",
@@ -220,14 +265,16 @@ void raiseall_handle_request (flux_t *h,
                              "type",
                              &type,
                              "note",
-                             &note) < 0)
+                             &note,
+                             "ids",
+                             &ids) < 0)
         goto error;
     if (flux_msg_get_cred (msg, &cred) < 0)
         goto error;
     /* Only the instance owner gets to use the userid wildcard.
      * Guests must specify 'userid' = themselves.
      */
-    if (flux_msg_cred_authorize (cred, userid) < 0) {
+    if (find_jobs_authorize (cred, ids, &userid) < 0) {
         errstr = "guests can only raise exceptions on their own jobs";
         goto error;
     }
@@ -241,7 +288,7 @@ void raiseall_handle_request (flux_t *h,
         errno = EPROTO;
         goto error;
     }
-    if (find_jobs (ctx, userid, state_mask, &target_jobs) < 0)
+    if (find_jobs (ctx, userid, state_mask, ids, &target_jobs) < 0)
         goto error;
     if (!dry_run) {
         job = zlistx_first (target_jobs);
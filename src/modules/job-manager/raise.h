@@ -12,12 +12,33 @@
 #define _FLUX_JOB_MANAGER_RAISE_H
 
 #include <stdint.h>
+#include <jansson.h>
+#include <czmq.h>
 
 #include "job-manager.h"
 
 struct raise *raise_ctx_create (struct job_manager *ctx);
 void raise_ctx_destroy (struct raise *raise);
 
+/* Create a list of jobs matching userid, state_mask criteria.
+ * FLUX_USERID_UNKNOWN is a wildcard that matches any user.
+ * If 'ids' is non-NULL, only the active jobs in that array of job ids
+ * are considered, in array order, and unknown ids are skipped.
+ */
+int find_jobs (struct job_manager *ctx,
+               uint32_t userid,
+               int state_mask,
+               json_t *ids,
+               zlistx_t **lp);
+
+/* Authorize a find_jobs() request on behalf of 'cred'.  Only the instance
+ * owner may use the userid wildcard, except that with a list of 'ids',
+ * the wildcard is narrowed to the guest's own jobs.
+ */
+int find_jobs_authorize (struct flux_msg_cred cred,
+                         json_t *ids,
+                         uint32_t *userid);
+
 /* exposed for unit testing only */
 int raise_check_type (const char *type);
 int raise_check_severity (int severity);
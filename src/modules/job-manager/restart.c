@@ -8,7 +8,13 @@
  * SPDX-License-Identifier: LGPL-3.0
 \************************************************************/
 
-/* restart - reload active jobs from the KVS */
+/* restart - reload active jobs from the KVS
+ *
+ * At shutdown, the checkpoint object records a snapshot of active jobs
+ * along with the tree object of the KVS "job" directory.  At startup,
+ * if the "job" directory is unchanged, jobs are recreated from the
+ * snapshot.  Otherwise, each job is recreated by replaying its eventlog.
+ */
 
 #if HAVE_CONFIG_H
 #include "config.h"
@@ -17,6 +23,7 @@
 #include <argz.h>
 #include <envz.h>
 #include <flux/core.h>
+#include <jansson.h>
 
 #include "src/common/libutil/fluid.h"
 
@@ -24,6 +31,8 @@
 #include "restart.h"
 #include "event.h"
 #include "wait.h"
+#include "jobindex.h"
+#include "admission.h"
 
 /* restart_map callback should return -1 on error to stop map with error,
  * or 0 on success.  'job' is only valid for the duration of the callback.
@@ -136,6 +145,10 @@ static int restart_map_cb (struct job *job, void *arg)
 
     if (zhashx_insert (ctx->active_jobs, &job->id, job) < 0)
         return -1;
+    if (jobindex_insert (ctx->index, job) < 0) {
+        zhashx_delete (ctx->active_jobs, &job->id);
+        return -1;
+    }
     if ((job->flags & FLUX_JOB_WAITABLE))
         wait_notify_active (ctx->wait, job);
     if (event_job_action (ctx->event, job) < 0) {
@@ -145,20 +158,161 @@ static int restart_map_cb (struct job *job, void *arg)
     return 0;
 }
 
+/* Fetch the tree object of the KVS "job" directory.
+ * Set '*treeobj' to JSON null if the directory does not exist.
+ * Caller must json_decref() the result.
+ */
+static int jobdir_treeobj (flux_t *h, json_t **treeobj)
+{
+    flux_future_t *f;
+    const char *s;
+    json_t *o = NULL;
+
+    if (!(f = flux_kvs_lookup (h, NULL, FLUX_KVS_TREEOBJ, "job")))
+        return -1;
+    if (flux_kvs_lookup_get_treeobj (f, &s) < 0) {
+        if (errno != ENOENT)
+            goto error;
+        o = json_null ();
+    }
+    else if (!(o = json_loads (s, 0, NULL))) {
+        errno = EPROTO;
+        goto error;
+    }
+    flux_future_destroy (f);
+    *treeobj = o;
+    return 0;
+error:
+    flux_future_destroy (f);
+    return -1;
+}
+
+/* Encode active jobs as an array of
+ * [id, userid, priority, state, flags, t_submit, has_resources, end_event]
+ * tuples, where end_event is null if not set.
+ */
+static json_t *snapshot_encode (struct job_manager *ctx)
+{
+    json_t *jobs;
+    json_t *entry;
+    struct job *job;
+
+    if (!(jobs = json_array ()))
+        goto nomem;
+    job = zhashx_first (ctx->active_jobs);
+    while (job) {
+        if (!(entry = json_pack ("[I,i,i,i,i,f,b,o]",
+                                 (json_int_t)job->id,
+                                 job->userid,
+                                 job->priority,
+                                 job->state,
+                                 job->flags,
+                                 job->t_submit,
+                                 job->has_resources,
+                                 job->end_event ? json_incref (job->end_event)
+                                                : json_null ()))
+            || json_array_append_new (jobs, entry) < 0) {
+            json_decref (entry);
+            goto nomem;
+        }
+        job = zhashx_next (ctx->active_jobs);
+    }
+    return jobs;
+nomem:
+    json_decref (jobs);
+    errno = ENOMEM;
+    return NULL;
+}
+
+static struct job *snapshot_decode_job (json_t *entry)
+{
+    struct job *job;
+    json_int_t id;
+    int state;
+    int has_resources;
+    json_t *end_event;
+
+    if (!(job = job_create ()))
+        return NULL;
+    if (json_unpack (entry,
+                     "[I,i,i,i,i,F,b,o]",
+                     &id,
+                     &job->userid,
+                     &job->priority,
+                     &state,
+                     &job->flags,
+                     &job->t_submit,
+                     &has_resources,
+                     &end_event) < 0)
+        goto inval;
+    if (!(state & FLUX_JOB_ACTIVE) || (state & (state - 1)) != 0)
+        goto inval;
+    job->id = id;
+    job->state = state;
+    job->has_resources = has_resources ? 1 : 0;
+    if (!json_is_null (end_event))
+        job->end_event = json_incref (end_event);
+    return job;
+inval:
+    job_decref (job);
+    errno = EINVAL;
+    return NULL;
+}
+
+/* Recreate active jobs from checkpoint snapshot.
+ * Returns job count on success, -1 on failure with errno set.
+ */
+static int snapshot_restore (struct job_manager *ctx, json_t *jobs)
+{
+    size_t index;
+    json_t *entry;
+    struct job *job;
+
+    if (!json_is_array (jobs)) {
+        errno = EINVAL;
+        return -1;
+    }
+    json_array_foreach (jobs, index, entry) {
+        if (!(job = snapshot_decode_job (entry)))
+            return -1;
+        if (restart_map_cb (job, ctx) < 0) {
+            job_decref (job);
+            return -1;
+        }
+        job_decref (job);
+    }
+    return json_array_size (jobs);
+}
+
 static int checkpoint_save (struct job_manager *ctx)
 {
     flux_future_t *f = NULL;
-    flux_kvs_txn_t *txn;
+    flux_kvs_txn_t *txn = NULL;
+    json_t *jobs = NULL;
+    json_t *jobdir = NULL;
     int rc = -1;
 
+    /* Ensure all eventlog updates are committed, so the "job" directory
+     * tree object matches the snapshot.
+     */
+    if (event_flush (ctx->event) < 0)
+        goto done;
+    if (jobdir_treeobj (ctx->h, &jobdir) < 0)
+        goto done;
+    if (!(jobs = snapshot_encode (ctx)))
+        goto done;
     if (!(txn = flux_kvs_txn_create ()))
-        return -1;
+        goto done;
     if (flux_kvs_txn_pack (txn,
                            0,
                            checkpoint_key,
-                           "{s:I}",
+                           "{s:I s:O s:O}",
                            "max_jobid",
-                           ctx->max_jobid) < 0)
+                           ctx->max_jobid,
+                           "jobs",
+                           jobs,
+                           "jobdir",
+                           jobdir) < 0)
         goto done;
     if (!(f = flux_kvs_commit (ctx->h, NULL, 0, txn)))
         goto done;
@@ -168,52 +322,70 @@ static int checkpoint_save (struct job_manager *ctx)
 done:
     flux_future_destroy (f);
     flux_kvs_txn_destroy (txn);
+    json_decref (jobs);
+    json_decref (jobdir);
     return rc;
 }
 
-static int checkpoint_restore (struct job_manager *ctx)
+/* Restore misc state from the checkpoint object, and if the "job"
+ * directory has not changed since the checkpoint was written, recreate
+ * active jobs from its snapshot.  Set '*count' to the number of jobs
+ * restored, or -1 if the snapshot could not be used.
+ */
+static int checkpoint_restore (struct job_manager *ctx, int *count)
 {
     flux_future_t *f;
+    json_t *jobs = NULL;
+    json_t *jobdir = NULL;
+    json_t *cur_jobdir = NULL;
 
+    *count = -1;
     if (!(f = flux_kvs_lookup (ctx->h, NULL, 0, checkpoint_key)))
         return -1;
     if (flux_kvs_lookup_get_unpack (f,
-                                    "{s:I}",
+                                    "{s:I s?o s?o}",
                                     "max_jobid",
-                                    &ctx->max_jobid) < 0) {
-        flux_future_destroy (f);
-        return -1;
+                                    &ctx->max_jobid,
+                                    "jobs",
+                                    &jobs,
+                                    "jobdir",
+                                    &jobdir) < 0)
+        goto error;
+    if (jobs) {
+        if (jobdir_treeobj (ctx->h, &cur_jobdir) < 0)
+            goto error;
+        if (!jobdir || !json_equal (jobdir, cur_jobdir))
+            flux_log (ctx->h,
+                      LOG_INFO,
+                      "restart: job directory changed since checkpoint");
+        else if ((*count = snapshot_restore (ctx, jobs)) < 0) {
+            /* Jobs may have been partially restored, so do not fall
+             * back to eventlog replay.
+             */
+            if (zhashx_size (ctx->active_jobs) > 0)
+                goto error;
+            flux_log_error (ctx->h, "restart: ignoring checkpoint snapshot");
+        }
     }
+    json_decref (cur_jobdir);
     flux_future_destroy (f);
     return 0;
+error:
+    json_decref (cur_jobdir);
+    flux_future_destroy (f);
+    return -1;
 }
 
 int restart_from_kvs (struct job_manager *ctx)
 {
     const char *dirname = "job";
     int dirskip = strlen (dirname);
-    int count;
+    int count = -1;
     struct job *job;
 
-    /* Load any active jobs present in the KVS at startup.
+    /* Restore misc state, and active jobs if possible.
      */
-    count = depthfirst_map (ctx->h, dirname, dirskip, restart_map_cb, ctx);
-    if (count < 0)
-        return -1;
-    flux_log (ctx->h, LOG_INFO, "restart: %d jobs", count);
-    /* Initialize the count of "running" jobs
-     */
-    job = zhashx_first (ctx->active_jobs);
-    while (job) {
-        if ((job->state & FLUX_JOB_RUNNING) != 0)
-            ctx->running_jobs++;
-        job = zhashx_next (ctx->active_jobs);
-    }
-    flux_log (ctx->h, LOG_INFO, "restart: %d running jobs", ctx->running_jobs);
-
-    /* Restore misc state.
-     */
-    if (checkpoint_restore (ctx) < 0) {
+    if (checkpoint_restore (ctx, &count) < 0) {
         if (errno != ENOENT) {
             flux_log_error (ctx->h, "restart: %s", checkpoint_key);
             return -1;
@@ -224,6 +396,26 @@ int restart_from_kvs (struct job_manager *ctx)
               LOG_DEBUG,
               "restart: max_jobid=%ju",
               (uintmax_t)ctx->max_jobid);
+    if (count >= 0)
+        flux_log (ctx->h, LOG_INFO, "restart: %d jobs from checkpoint", count);
+    else {
+        /* Load any active jobs present in the KVS at startup.
+         */
+        count = depthfirst_map (ctx->h, dirname, dirskip, restart_map_cb, ctx);
+        if (count < 0)
+            return -1;
+        flux_log (ctx->h, LOG_INFO, "restart: %d jobs", count);
+    }
+    /* Initialize the count of "running" jobs
+     */
+    job = zhashx_first (ctx->active_jobs);
+    while (job) {
+        if ((job->state & FLUX_JOB_RUNNING) != 0)
+            ctx->running_jobs++;
+        admission_update (ctx->admission, job, FLUX_JOB_NEW);
+        job = zhashx_next (ctx->active_jobs);
+    }
+    flux_log (ctx->h, LOG_INFO, "restart: %d running jobs", ctx->running_jobs);
     return 0;
 }
 
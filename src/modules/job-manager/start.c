@@ -20,7 +20,8 @@
  * STARTUP:
  *
  * Exec service sends job-manager.exec-hello request with its service name,
- * {"service":s}.  Job-manager responds with success/failure.
+ * {"service":s, "batch"?:i}.  Job-manager responds with success/failure,
+ * and on success {"batch":i}, the batch size it will use (see BATCHING).
  *
  * Active jobs are scanned and hello fails if any jobs have outstanding
  * start request (e.g. to existing exec service).
@@ -51,6 +52,16 @@
  * final=true.  This means all resources allocated to the job are no
  * longer in use by the exec system.
  *
+ * BATCHING:
+ *
+ * If the exec service offered a batch size > 0 in its hello request, jobs
+ * are started with <exec_service>.start-batch requests
+ * {"jobs":[{"id":I "userid":i}, ...]} holding up to 'batch' jobs (at most
+ * 1024), sent just before the reactor blocks or when a batch fills.  The exec
+ * service then responds with {"responses":[{"id":I "type":s "data":o}, ...]},
+ * where each element is one of the responses above, in order for each job.
+ * Responses may be sent on any start-batch request from the job-manager.
+ *
  * TEARDOWN:
  *
  * If an ENOSYS (or other "normal RPC error" response is returned to an
@@ -87,6 +98,7 @@
 
 #include "job.h"
 #include "event.h"
+#include "latency.h"
 
 #include "start.h"
 
@@ -94,8 +106,26 @@ struct start {
     struct job_manager *ctx;
     flux_msg_handler_t **handlers;
     char *topic;
+    char *batch_topic;  // <exec_service>.start-batch, if batching
+    int batch;          // max jobs per start-batch request, 0=no batching
+    json_t *start_batch; // jobs with start request not yet sent
+    flux_watcher_t *prep;
 };
 
+/* Upper bound on the batch size an exec service may negotiate in hello.
+ */
+static const int max_batch = 1024;
+
+static void start_topics_clear (struct start *start)
+{
+    free (start->topic);
+    start->topic = NULL;
+    free (start->batch_topic);
+    start->batch_topic = NULL;
+    start->batch = 0;
+    json_array_clear (start->start_batch);
+}
+
 static void hello_cb (flux_t *h, flux_msg_handler_t *mh,
                       const flux_msg_t *msg, void *arg)
 {
@@ -103,9 +133,16 @@ static void hello_cb (flux_t *h, flux_msg_handler_t *mh,
     struct start *start = ctx->start;
     struct job *job;
     const char *service_name;
+    int batch = 0;
 
-    if (flux_request_unpack (msg, NULL, "{s:s}", "service", &service_name) < 0)
+    if (flux_request_unpack (msg, NULL, "{s:s s?:i}",
+                                        "service", &service_name,
+                                        "batch", &batch) < 0)
         goto error;
+    if (batch < 0) {
+        errno = EPROTO;
+        goto error;
+    }
     /* If existing exec service is loaded, ensure it is idle before
      * allowing new exec service to override.
      */
@@ -118,13 +155,17 @@ static void hello_cb (flux_t *h, flux_msg_handler_t *mh,
             }
             job = zhashx_next (ctx->active_jobs);
         }
-        free (start->topic);
-        start->topic = NULL;
+        start_topics_clear (start);
     }
     if (asprintf (&start->topic, "%s.start", service_name) < 0)
         goto error;
-    if (flux_respond (h, msg, NULL) < 0)
-        flux_log_error (h, "%s: flux_respond", __FUNCTION__);
+    if (batch > 0) {
+        if (asprintf (&start->batch_topic, "%s.start-batch", service_name) < 0)
+            goto error;
+        start->batch = batch < max_batch ? batch : max_batch;
+    }
+    if (flux_respond_pack (h, msg, "{s:i}", "batch", start->batch) < 0)
+        flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
     /* Response has been sent, now take action on jobs in run state.
      */
     job = zhashx_first (ctx->active_jobs);
@@ -151,8 +192,7 @@ static void interface_teardown (struct start *start, char *s, int errnum)
         flux_log (ctx->h, LOG_DEBUG, "start: stop due to %s: %s",
                   s, flux_strerror (errnum));
 
-        free (start->topic);
-        start->topic = NULL;
+        start_topics_clear (start);
 
         job = zhashx_first (ctx->active_jobs);
         while (job) {
@@ -168,29 +208,17 @@ static void interface_teardown (struct start *start, char *s, int errnum)
     }
 }
 
-static void start_response_cb (flux_t *h, flux_msg_handler_t *mh,
-                               const flux_msg_t *msg, void *arg)
+/* Handle one start response of 'type' with 'data' for job 'id'.
+ * Errors are logged and affect only that job.
+ */
+static void start_response (struct job_manager *ctx,
+                            flux_jobid_t id,
+                            const char *type,
+                            json_t *data)
 {
-    struct job_manager *ctx = arg;
-    struct start *start = ctx->start;
-    const char *topic;
-    flux_jobid_t id;
-    const char *type;
-    json_t *data;
+    flux_t *h = ctx->h;
     struct job *job;
 
-    if (flux_response_decode (msg, &topic, NULL) < 0)
-        goto teardown; // e.g. ENOSYS
-    if (!start->topic || strcmp (start->topic, topic) != 0) {
-        flux_log_error (h, "start: topic=%s not registered", topic);
-        goto error;
-    }
-    if (flux_msg_unpack (msg, "{s:I s:s s:o}", "id", &id,
-                                               "type", &type,
-                                               "data", &data) < 0) {
-        flux_log_error (h, "start response payload");
-        goto error;
-    }
     if (!(job = zhashx_lookup (ctx->active_jobs, &id))) {
         flux_log (h, LOG_ERR, "start response: id=%ju not active",
                   (uintmax_t)id);
@@ -198,6 +226,7 @@ static void start_response_cb (flux_t *h, flux_msg_handler_t *mh,
         goto error;
     }
     if (!strcmp (type, "start")) {
+        latency_mark (ctx->latency, job, JOB_MARK_START);
         if (event_job_post_pack (ctx->event, job, "start", NULL) < 0)
             goto error_post;
     }
@@ -257,29 +286,151 @@ error_post:
     flux_log_error (h, "start: failed to post event type=%s", type);
 error:
     return;
+}
+
+static void start_response_cb (flux_t *h, flux_msg_handler_t *mh,
+                               const flux_msg_t *msg, void *arg)
+{
+    struct job_manager *ctx = arg;
+    struct start *start = ctx->start;
+    const char *topic;
+    flux_jobid_t id;
+    const char *type;
+    json_t *data;
+
+    if (flux_response_decode (msg, &topic, NULL) < 0)
+        goto teardown; // e.g. ENOSYS
+    if (!start->topic || strcmp (start->topic, topic) != 0) {
+        flux_log_error (h, "start: topic=%s not registered", topic);
+        return;
+    }
+    if (flux_msg_unpack (msg, "{s:I s:s s:o}", "id", &id,
+                                               "type", &type,
+                                               "data", &data) < 0) {
+        flux_log_error (h, "start response payload");
+        return;
+    }
+    start_response (ctx, id, type, data);
+    return;
 teardown:
     interface_teardown (start, "start response error", errno);
 }
 
-/* Send <exec_service>.start request for job.
+/* Handle a start-batch response, a list of start responses.
+ */
+static void start_batch_response_cb (flux_t *h, flux_msg_handler_t *mh,
+                                     const flux_msg_t *msg, void *arg)
+{
+    struct job_manager *ctx = arg;
+    struct start *start = ctx->start;
+    const char *topic;
+    json_t *responses;
+    json_t *entry;
+    size_t index;
+
+    if (flux_response_decode (msg, &topic, NULL) < 0)
+        goto teardown; // e.g. ENOSYS
+    if (!start->batch_topic || strcmp (start->batch_topic, topic) != 0) {
+        flux_log_error (h, "start: topic=%s not registered", topic);
+        return;
+    }
+    if (flux_msg_unpack (msg, "{s:o}", "responses", &responses) < 0
+        || !json_is_array (responses)) {
+        flux_log_error (h, "start-batch response payload");
+        return;
+    }
+    json_array_foreach (responses, index, entry) {
+        flux_jobid_t id;
+        const char *type;
+        json_t *data;
+
+        if (json_unpack (entry, "{s:I s:s s:o}", "id", &id,
+                                                 "type", &type,
+                                                 "data", &data) < 0) {
+            flux_log (h, LOG_ERR, "start-batch response: malformed entry");
+            continue;
+        }
+        start_response (ctx, id, type, data);
+    }
+    return;
+teardown:
+    interface_teardown (start, "start response error", errno);
+}
+
+/* Send one <exec_service>.start-batch request for the jobs in
+ * start->start_batch.
+ */
+static int start_request_flush (struct start *start)
+{
+    flux_msg_t *msg;
+
+    if (json_array_size (start->start_batch) == 0)
+        return 0;
+    if (!(msg = flux_request_encode (start->batch_topic, NULL)))
+        return -1;
+    if (flux_msg_pack (msg, "{s:O}", "jobs", start->start_batch) < 0)
+        goto error;
+    if (flux_send (start->ctx->h, msg, 0) < 0)
+        goto error;
+    json_array_clear (start->start_batch);
+    flux_msg_destroy (msg);
+    return 0;
+error:
+    flux_msg_destroy (msg);
+    return -1;
+}
+
+/* prep:
+ * Runs right before reactor calls poll(2).
+ * Send any batched start requests.
+ */
+static void prep_cb (flux_reactor_t *r, flux_watcher_t *w,
+                     int revents, void *arg)
+{
+    struct start *start = arg;
+
+    if (start_request_flush (start) < 0) {
+        flux_log_error (start->ctx->h, "start_request_flush fatal error");
+        flux_reactor_stop_error (r);
+    }
+}
+
+/* Send <exec_service>.start request for job, or if batching was
+ * negotiated, add it to the next start-batch request.
  * Idempotent.
  */
 int start_send_request (struct start *start, struct job *job)
 {
     struct job_manager *ctx = start->ctx;
-    flux_msg_t *msg;
+    flux_msg_t *msg = NULL;
 
     assert (job->state == FLUX_JOB_RUN);
     if (!job->start_pending && start->topic != NULL) {
-        if (!(msg = flux_request_encode (start->topic, NULL)))
-            return -1;
-        if (flux_msg_pack (msg, "{s:I s:i}",
-                                "id", job->id,
-                                "userid", job->userid) < 0)
-            goto error;
-        if (flux_send (ctx->h, msg, 0) < 0)
-            goto error;
-        flux_msg_destroy (msg);
+        if (start->batch > 0) {
+            json_t *entry;
+
+            if (!(entry = json_pack ("{s:I s:i}",
+                                     "id", job->id,
+                                     "userid", job->userid))
+                || json_array_append_new (start->start_batch, entry) < 0) {
+                errno = ENOMEM;
+                return -1;
+            }
+            if (json_array_size (start->start_batch) >= start->batch
+                && start_request_flush (start) < 0)
+                return -1;
+        }
+        else {
+            if (!(msg = flux_request_encode (start->topic, NULL)))
+                return -1;
+            if (flux_msg_pack (msg, "{s:I s:i}",
+                                    "id", job->id,
+                                    "userid", job->userid) < 0)
+                goto error;
+            if (flux_send (ctx->h, msg, 0) < 0)
+                goto error;
+            flux_msg_destroy (msg);
+        }
         job->start_pending = 1;
         if ((job->flags & FLUX_JOB_DEBUG))
             (void)event_job_post_pack (ctx->event, job,
@@ -296,7 +447,10 @@ void start_ctx_destroy (struct start *start)
     if (start) {
         int saved_errno = errno;;
         flux_msg_handler_delvec (start->handlers);
+        flux_watcher_destroy (start->prep);
         free (start->topic);
+        free (start->batch_topic);
+        json_decref (start->start_batch);
         free (start);
         errno = saved_errno;
     }
@@ -305,6 +459,7 @@ void start_ctx_destroy (struct start *start)
 static const struct flux_msg_handler_spec htab[] = {
     { FLUX_MSGTYPE_REQUEST, "job-manager.exec-hello", hello_cb, 0},
     { FLUX_MSGTYPE_RESPONSE, "*.start", start_response_cb, 0},
+    { FLUX_MSGTYPE_RESPONSE, "*.start-batch", start_batch_response_cb, 0},
     FLUX_MSGHANDLER_TABLE_END,
 };
 
@@ -315,8 +470,17 @@ struct start *start_ctx_create (struct job_manager *ctx)
     if (!(start = calloc (1, sizeof (*start))))
         return NULL;
     start->ctx = ctx;
+    if (!(start->start_batch = json_array ())) {
+        errno = ENOMEM;
+        goto error;
+    }
     if (flux_msg_handler_addvec (ctx->h, htab, ctx, &start->handlers) < 0)
         goto error;
+    if (!(start->prep = flux_prepare_watcher_create (flux_get_reactor (ctx->h),
+                                                     prep_cb,
+                                                     start)))
+        goto error;
+    flux_watcher_start (start->prep);
     return start;
 error:
     start_ctx_destroy (start);
@@ -21,6 +21,9 @@
 #include "alloc.h"
 #include "event.h"
 #include "wait.h"
+#include "jobindex.h"
+#include "latency.h"
+#include "admission.h"
 
 #include "submit.h"
 
@@ -34,24 +37,30 @@ struct submit {
 };
 
 /* Decode 'o' into a struct job, then add it to the active_job hash.
- * Also record the job in 'newjobs'.
+ * Also record the job in 'newjobs'.  An optional jobspec summary is held
+ * for job-manager.journal until the job's DEPEND transition is posted.
  */
 int submit_add_one_job (zhashx_t *active_jobs, zlist_t *newjobs, json_t *o)
 {
     struct job *job;
+    json_t *jobspec = NULL;
 
     if (!(job = job_create ()))
         return -1;
-    if (json_unpack (o, "{s:I s:i s:i s:f s:i}",
+    if (json_unpack (o, "{s:I s:i s:i s:f s:i s?f s?o}",
                         "id", &job->id,
                         "priority", &job->priority,
                         "userid", &job->userid,
                         "t_submit", &job->t_submit,
-                        "flags", &job->flags) < 0) {
+                        "flags", &job->flags,
+                        "t_ingest", &job->t_mark[JOB_MARK_INGEST],
+                        "jobspec", &jobspec) < 0) {
         errno = EPROTO;
         job_decref (job);
         return -1;
     }
+    job->jobspec = json_incref (jobspec);
+    job->t_mark[JOB_MARK_SUBMIT] = job->t_submit;
     if (zhashx_insert (active_jobs, &job->id, job) < 0) {
         job_decref (job);
         /* zhashx_insert() fails if hash item already exists.
@@ -116,11 +125,12 @@ error:
  * We instead re-create the event and run it directly through
  * event_job_update() and event_job_action().
  */
-int submit_post_event (struct event *event, struct job *job)
+int submit_post_event (struct job_manager *ctx, struct job *job)
 {
     json_t *entry = NULL;
     int rv = -1;
 
+    latency_mark (ctx->latency, job, JOB_MARK_ACCEPT);
     entry = eventlog_entry_pack (job->t_submit,
                                  "submit",
                                  "{ s:i s:i s:i }",
@@ -131,12 +141,17 @@ int submit_post_event (struct event *event, struct job *job)
         goto error;
     if (event_job_update (job, entry) < 0) /* NEW -> DEPEND */
         goto error;
-    if (event_batch_pub_state (event, job, job->t_submit) < 0)
+    admission_update (ctx->admission, job, FLUX_JOB_NEW);
+    if (jobindex_insert (ctx->index, job) < 0)
         goto error;
-    if (event_job_action (event, job) < 0)
+    if (event_batch_pub_state (ctx->event, job, job->t_submit) < 0)
+        goto error;
+    if (event_job_action (ctx->event, job) < 0)
         goto error;
     rv = 0;
  error:
+    json_decref (job->jobspec);
+    job->jobspec = NULL;
     json_decref (entry);
     return rv;
 }
@@ -145,12 +160,16 @@ int submit_post_event (struct event *event, struct job *job)
  * This is a batched request for one or more jobs already validated
  * by the ingest module, and already instantiated in the KVS.
  * The user isn't handed the jobid though until we accept the job here.
+ * Jobs refused by admission control are listed in the response,
+ * for job-ingest to fail and remove from the KVS - see admission.c.
  */
 static void submit_cb (flux_t *h, flux_msg_handler_t *mh,
                        const flux_msg_t *msg, void *arg)
 {
     struct job_manager *ctx = arg;
     json_t *jobs;
+    json_t *admitted = NULL;
+    json_t *rejected = NULL;
     zlist_t *newjobs;
     struct job *job;
     const char *errmsg = NULL;
@@ -164,21 +183,23 @@ static void submit_cb (flux_t *h, flux_msg_handler_t *mh,
         errmsg = ctx->submit->disable_errmsg;
         goto error;
     }
-    if (!(newjobs = submit_add_jobs (ctx->active_jobs, jobs))) {
+    if (admission_filter (ctx->admission, jobs, &admitted, &rejected) < 0) {
+        flux_log_error (h, "%s: admission control", __FUNCTION__);
+        goto error;
+    }
+    if (!(newjobs = submit_add_jobs (ctx->active_jobs, admitted))) {
         flux_log_error (h, "%s: error enqueuing batch", __FUNCTION__);
         goto error;
     }
-    if (flux_respond (h, msg, NULL) < 0)
-        flux_log_error (h, "%s: flux_respond", __FUNCTION__);
     flux_log (h, LOG_DEBUG, "%s: added %d jobs", __FUNCTION__,
                             (int)zlist_size (newjobs));
 
-    /* Submitting user is being responded to with jobid's.
-     * Now walk the list of new jobs and advance their state.
+    /* Walk the list of new jobs and advance their state, before the
+     * submitting user (job-ingest) is responded to below.
      * Side effect: update ctx->max_jobid.
      */
     while ((job = zlist_pop (newjobs))) {
-        if (submit_post_event (ctx->event, job) < 0)
+        if (submit_post_event (ctx, job) < 0)
             flux_log_error (h, "%s: submit_post_event id=%ju",
                             __FUNCTION__, (uintmax_t)job->id);
 
@@ -190,10 +211,19 @@ static void submit_cb (flux_t *h, flux_msg_handler_t *mh,
         job_decref (job);
     }
     zlist_destroy (&newjobs);
+    /* Respond after the new jobs are pending, so the credits in the
+     * response account for them.
+     */
+    if (admission_respond (ctx->admission, msg, rejected) < 0)
+        flux_log_error (h, "%s: flux_respond", __FUNCTION__);
+    json_decref (admitted);
+    json_decref (rejected);
     return;
 error:
     if (flux_respond_error (h, msg, errno, errmsg) < 0)
         flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+    json_decref (admitted);
+    json_decref (rejected);
 }
 
 static void submit_admin_cb (flux_t *h, flux_msg_handler_t *mh,
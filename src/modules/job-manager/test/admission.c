@@ -0,0 +1,212 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <string.h>
+#include <jansson.h>
+#include <flux/core.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/modules/job-manager/job.h"
+#include "src/modules/job-manager/admission.h"
+
+/* Build a job-manager.submit "jobs" array with one job per userid
+ * in 'userids', numbered from 'id'.
+ */
+static json_t *jobs_create (flux_jobid_t id, int *userids, int count)
+{
+    json_t *jobs;
+
+    if (!(jobs = json_array ()))
+        BAIL_OUT ("json_array failed");
+    for (int i = 0; i < count; i++) {
+        json_t *o = json_pack ("{s:I s:i s:i s:f s:i}",
+                               "id", id + i,
+                               "priority", 16,
+                               "userid", userids[i],
+                               "t_submit", 1.0,
+                               "flags", 0);
+        if (!o || json_array_append_new (jobs, o) < 0)
+            BAIL_OUT ("json_pack failed");
+    }
+    return jobs;
+}
+
+static struct job *pending_job (struct admission *admission,
+                                flux_jobid_t id,
+                                int userid)
+{
+    struct job *job;
+
+    if (!(job = job_create ()))
+        BAIL_OUT ("job_create failed");
+    job->id = id;
+    job->userid = userid;
+    job->state = FLUX_JOB_DEPEND;
+    admission_update (admission, job, FLUX_JOB_NEW);
+    return job;
+}
+
+static int stat_get (struct admission *admission, const char *name)
+{
+    json_t *o;
+    int val = -1;
+
+    if (!(o = admission_stats_encode (admission)))
+        BAIL_OUT ("admission_stats_encode failed");
+    (void)json_unpack (o, "{s:i}", name, &val);
+    json_decref (o);
+    return val;
+}
+
+void test_unlimited (struct admission *admission)
+{
+    int userids[] = { 42, 43 };
+    json_t *jobs = jobs_create (1, userids, 2);
+    json_t *admitted;
+    json_t *rejected;
+
+    ok (admission_credits (admission) == -1,
+        "admission_credits is -1 with no limits");
+    ok (admission_filter (admission, jobs, &admitted, &rejected) == 0
+        && json_equal (admitted, jobs)
+        && json_array_size (rejected) == 0,
+        "admission_filter admits all jobs with no limits");
+    json_decref (admitted);
+    json_decref (rejected);
+    json_decref (jobs);
+}
+
+void test_limits (struct admission *admission)
+{
+    struct job *job1, *job2;
+    int userids[] = { 42, 43, 42 };
+    json_t *jobs = jobs_create (10, userids, 3);
+    json_t *admitted;
+    json_t *rejected;
+    flux_jobid_t id;
+    const char *errmsg;
+
+    job1 = pending_job (admission, 1, 42);
+    job2 = pending_job (admission, 2, 43);
+    ok (stat_get (admission, "pending") == 2,
+        "admission_update counts pending jobs");
+
+    admission_set_limits (admission, 2, 0);
+    ok (admission_credits (admission) == 0,
+        "admission_credits is 0 at max-pending");
+    ok (admission_filter (admission, jobs, &admitted, &rejected) == 0
+        && json_array_size (admitted) == 0
+        && json_array_size (rejected) == 3,
+        "admission_filter refuses all jobs of a user over max-pending");
+    ok (json_unpack (json_array_get (rejected, 0), "[I,s]",
+                     &id, &errmsg) == 0
+        && id == 10
+        && strstr (errmsg, "job queue is full") != NULL,
+        "refused job has id and errmsg: %s", errmsg);
+    json_decref (admitted);
+    json_decref (rejected);
+
+    admission_set_limits (admission, 4, 0);
+    ok (admission_credits (admission) == 2,
+        "admission_credits is max-pending minus pending");
+    ok (admission_filter (admission, jobs, &admitted, &rejected) == 0
+        && json_array_size (admitted) == 2
+        && json_array_size (rejected) == 1,
+        "admission_filter admits one user and refuses the next");
+    ok (json_unpack (json_array_get (rejected, 0), "[I,s]",
+                     &id, &errmsg) == 0 && id == 11,
+        "refused job is the other user's");
+    json_decref (admitted);
+    json_decref (rejected);
+
+    admission_set_limits (admission, 0, 2);
+    ok (admission_filter (admission, jobs, &admitted, &rejected) == 0
+        && json_array_size (admitted) == 1
+        && json_array_size (rejected) == 2,
+        "admission_filter refuses a user over max-pending-user");
+    ok (json_unpack (json_array_get (rejected, 1), "[I,s]",
+                     &id, &errmsg) == 0
+        && id == 12
+        && strstr (errmsg, "max-pending-user=2") != NULL,
+        "refused job has errmsg: %s", errmsg);
+    json_decref (admitted);
+    json_decref (rejected);
+    ok (stat_get (admission, "rejected") == 6,
+        "stats count rejected jobs");
+
+    job1->state = FLUX_JOB_RUN;
+    admission_update (admission, job1, FLUX_JOB_SCHED);
+    ok (stat_get (admission, "pending") == 1,
+        "job leaving pending state is no longer counted");
+    ok (admission_filter (admission, jobs, &admitted, &rejected) == 0
+        && json_array_size (admitted) == 3
+        && json_array_size (rejected) == 0,
+        "admission_filter admits user after a job runs");
+    json_decref (admitted);
+    json_decref (rejected);
+
+    admission_stats_clear (admission);
+    ok (stat_get (admission, "rejected") == 0
+        && stat_get (admission, "paced") == 0
+        && stat_get (admission, "pending") == 1,
+        "admission_stats_clear clears counters only");
+
+    json_decref (jobs);
+    job_decref (job1);
+    job_decref (job2);
+}
+
+void test_inval (struct admission *admission)
+{
+    json_t *jobs = json_pack ("[{s:I}]", "id", (json_int_t)1);
+    json_t *admitted;
+    json_t *rejected;
+
+    if (!jobs)
+        BAIL_OUT ("json_pack failed");
+    admission_set_limits (admission, 10, 0);
+    errno = 0;
+    ok (admission_filter (admission, jobs, &admitted, &rejected) < 0
+        && errno == EPROTO,
+        "admission_filter fails with EPROTO on job without userid");
+    json_decref (jobs);
+    lives_ok ({admission_update (NULL, NULL, FLUX_JOB_NEW);},
+        "admission_update admission=NULL doesn't crash");
+    lives_ok ({admission_ctx_destroy (NULL);},
+        "admission_ctx_destroy admission=NULL doesn't crash");
+}
+
+int main (int argc, char *argv[])
+{
+    struct job_manager ctx;
+    struct admission *admission;
+
+    plan (NO_PLAN);
+
+    memset (&ctx, 0, sizeof (ctx));
+    if (!(admission = admission_ctx_create (&ctx)))
+        BAIL_OUT ("admission_ctx_create failed");
+
+    test_unlimited (admission);
+    test_limits (admission);
+    test_inval (admission);
+
+    admission_ctx_destroy (admission);
+
+    done_testing ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -238,6 +238,70 @@ void overwrite (void)
     json_decref (cmp);
 }
 
+void changed_keys (void)
+{
+    struct job j = {0};
+    json_t *new;
+    json_t *changed;
+    json_t *cmp;
+    int rc;
+
+    new = json_pack ("{s:{s:i} s:{s:s}}",
+                     "sched", "t_estimate", 10,
+                     "user", "str", "foo");
+    if (!new)
+        BAIL_OUT ("json_pack() failed");
+    changed = NULL;
+    rc = annotations_update (NULL, &j, new, &changed);
+    ok (rc == 0 && changed && json_array_size (changed) == 2,
+        "annotations_update reports both new keys as changed");
+    json_decref (changed);
+
+    changed = NULL;
+    rc = annotations_update (NULL, &j, new, &changed);
+    ok (rc == 0 && changed && json_array_size (changed) == 0,
+        "annotations_update reports no change for the same annotations");
+    json_decref (changed);
+    json_decref (new);
+
+    new = json_pack ("{s:{s:i} s:{s:s}}",
+                     "sched", "t_estimate", 20,
+                     "user", "str", "foo");
+    cmp = json_pack ("[s]", "sched");
+    if (!new || !cmp)
+        BAIL_OUT ("json_pack() failed");
+    changed = NULL;
+    rc = annotations_update (NULL, &j, new, &changed);
+    ok (rc == 0 && changed && json_equal (changed, cmp) > 0,
+        "annotations_update reports only the key that changed");
+    json_decref (changed);
+    json_decref (cmp);
+    json_decref (new);
+
+    new = json_pack ("{s:n s:{s:n}}", "user", "other", "foo");
+    cmp = json_pack ("[s]", "user");
+    if (!new || !cmp)
+        BAIL_OUT ("json_pack() failed");
+    changed = NULL;
+    rc = annotations_update (NULL, &j, new, &changed);
+    ok (rc == 0 && changed && json_equal (changed, cmp) > 0,
+        "annotations_update reports a removed key, not a missing one");
+    json_decref (changed);
+    json_decref (cmp);
+    json_decref (new);
+
+    new = json_pack ("{s:n}", "sched");
+    if (!new)
+        BAIL_OUT ("json_pack() failed");
+    changed = NULL;
+    rc = annotations_update (NULL, &j, new, &changed);
+    ok (rc == 0 && changed && json_array_size (changed) == 1
+        && j.annotations == NULL,
+        "annotations_update clears annotations when all keys are removed");
+    json_decref (changed);
+    json_decref (new);
+}
+
 int main (int argc, char *argv[])
 {
     plan (NO_PLAN);
@@ -245,6 +309,7 @@ int main (int argc, char *argv[])
     basic ();
     recursive ();
     overwrite ();
+    changed_keys ();
 
     done_testing ();
 }
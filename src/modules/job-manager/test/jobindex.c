@@ -0,0 +1,151 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <jansson.h>
+#include <flux/core.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/modules/job-manager/job.h"
+#include "src/modules/job-manager/jobindex.h"
+
+static struct job *create_job (flux_jobid_t id, uint32_t userid,
+                               int priority, flux_job_state_t state)
+{
+    struct job *job;
+
+    if (!(job = job_create ()))
+        BAIL_OUT ("job_create failed");
+    job->id = id;
+    job->userid = userid;
+    job->priority = priority;
+    job->t_submit = id;
+    job->state = state;
+    return job;
+}
+
+void test_basic (void)
+{
+    struct jobindex *ix;
+    struct job *job[4];
+    int i;
+
+    ok ((ix = jobindex_create ()) != NULL,
+        "jobindex_create works");
+    job[0] = create_job (1, 100, 16, FLUX_JOB_SCHED);
+    job[1] = create_job (2, 100, 20, FLUX_JOB_SCHED);
+    job[2] = create_job (3, 200, 16, FLUX_JOB_SCHED);
+    job[3] = create_job (4, 100, 16, FLUX_JOB_RUN);
+    for (i = 0; i < 4; i++) {
+        if (jobindex_insert (ix, job[i]) < 0)
+            BAIL_OUT ("jobindex_insert failed");
+    }
+    ok (jobindex_insert (ix, job[0]) < 0 && errno == EINVAL,
+        "jobindex_insert of indexed job fails with EINVAL");
+    ok (jobindex_state_count (ix, FLUX_JOB_SCHED) == 3
+        && jobindex_state_count (ix, FLUX_JOB_RUN) == 1
+        && jobindex_state_count (ix, FLUX_JOB_DEPEND) == 0,
+        "jobs are counted by state");
+    ok (jobindex_user_count (ix, 100) == 3
+        && jobindex_user_count (ix, 200) == 1
+        && jobindex_user_count (ix, 300) == 0,
+        "jobs are counted by userid");
+
+    ok (jobindex_state_first (ix, FLUX_JOB_SCHED) == job[1]
+        && jobindex_state_next (ix, FLUX_JOB_SCHED) == job[0]
+        && jobindex_state_next (ix, FLUX_JOB_SCHED) == job[2]
+        && jobindex_state_next (ix, FLUX_JOB_SCHED) == NULL,
+        "SCHED jobs iterate in priority, then t_submit order");
+    ok (jobindex_user_first (ix, 100) == job[1]
+        && jobindex_user_next (ix, 100) == job[0]
+        && jobindex_user_next (ix, 100) == job[3]
+        && jobindex_user_next (ix, 100) == NULL,
+        "user jobs iterate in priority, then t_submit order");
+    ok (jobindex_user_first (ix, 300) == NULL,
+        "unknown user has no jobs");
+
+    job[2]->priority = 31;
+    jobindex_reorder (ix, job[2]);
+    ok (jobindex_state_first (ix, FLUX_JOB_SCHED) == job[2],
+        "jobindex_reorder moves job after priority change");
+
+    job[0]->state = FLUX_JOB_RUN;
+    ok (jobindex_update_state (ix, job[0]) == 0,
+        "jobindex_update_state works");
+    ok (jobindex_state_count (ix, FLUX_JOB_SCHED) == 2
+        && jobindex_state_count (ix, FLUX_JOB_RUN) == 2,
+        "job moved from SCHED to RUN index");
+    ok (jobindex_update_state (ix, job[0]) == 0
+        && jobindex_state_count (ix, FLUX_JOB_RUN) == 2,
+        "jobindex_update_state without state change is a no-op");
+
+    jobindex_remove (ix, job[2]);
+    ok (jobindex_user_count (ix, 200) == 0
+        && jobindex_user_first (ix, 200) == NULL
+        && jobindex_state_count (ix, FLUX_JOB_SCHED) == 1,
+        "jobindex_remove removes job from all indices");
+    lives_ok ({jobindex_remove (ix, job[2]);},
+        "jobindex_remove of unindexed job is a no-op");
+    ok (jobindex_insert (ix, job[2]) == 0
+        && jobindex_user_count (ix, 200) == 1,
+        "removed job can be inserted again");
+
+    jobindex_destroy (ix);
+    for (i = 0; i < 4; i++)
+        job_decref (job[i]);
+}
+
+void test_badargs (void)
+{
+    struct job *job = create_job (1, 100, 16, FLUX_JOB_SCHED);
+    struct jobindex *ix;
+
+    ok (jobindex_insert (NULL, job) == 0
+        && jobindex_update_state (NULL, job) == 0
+        && jobindex_state_first (NULL, FLUX_JOB_SCHED) == NULL
+        && jobindex_user_first (NULL, 100) == NULL
+        && jobindex_state_count (NULL, FLUX_JOB_SCHED) == 0,
+        "NULL index is accepted and ignored");
+    lives_ok ({jobindex_remove (NULL, job);
+               jobindex_reorder (NULL, job);
+               jobindex_destroy (NULL);},
+        "jobindex_remove/reorder/destroy ix=NULL doesnt crash");
+
+    if (!(ix = jobindex_create ()))
+        BAIL_OUT ("jobindex_create failed");
+    job->state = 0;
+    errno = 0;
+    ok (jobindex_insert (ix, job) < 0 && errno == EINVAL,
+        "jobindex_insert of job with invalid state fails with EINVAL");
+    ok (jobindex_user_count (ix, 100) == 0,
+        "failed insert leaves no user entry");
+    ok (jobindex_state_count (ix, 3) == 0
+        && jobindex_state_first (ix, 3) == NULL,
+        "invalid state has no jobs");
+    jobindex_destroy (ix);
+    job_decref (job);
+}
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    test_basic ();
+    test_badargs ();
+
+    done_testing ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
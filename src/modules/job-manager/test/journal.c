@@ -0,0 +1,206 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <string.h>
+#include <jansson.h>
+#include <flux/core.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/modules/job-manager/job.h"
+#include "src/modules/job-manager/journal.h"
+
+const char *cancel_eventlog =
+    "{\"timestamp\":1.0,\"name\":\"submit\","
+     "\"context\":{\"userid\":42,\"priority\":16,\"flags\":0}}\n"
+    "{\"timestamp\":2.0,\"name\":\"depend\"}\n"
+    "{\"timestamp\":3.0,\"name\":\"alloc\"}\n"
+    "{\"timestamp\":4.0,\"name\":\"exception\","
+     "\"context\":{\"type\":\"test\",\"severity\":1,\"userid\":42}}\n"
+    "{\"timestamp\":5.0,\"name\":\"exception\","
+     "\"context\":{\"type\":\"cancel\",\"severity\":0,\"userid\":42}}\n"
+    "{\"timestamp\":6.0,\"name\":\"exception\","
+     "\"context\":{\"type\":\"late\",\"severity\":0,\"userid\":42}}\n"
+    "{\"timestamp\":7.0,\"name\":\"finish\",\"context\":{\"status\":9}}\n"
+    "{\"timestamp\":8.0,\"name\":\"free\"}\n"
+    "{\"timestamp\":9.0,\"name\":\"clean\"}\n";
+
+const char *success_eventlog =
+    "{\"timestamp\":1.0,\"name\":\"submit\","
+     "\"context\":{\"userid\":42,\"priority\":16,\"flags\":0}}\n"
+    "{\"timestamp\":2.0,\"name\":\"depend\"}\n"
+    "{\"timestamp\":3.0,\"name\":\"alloc\"}\n"
+    "{\"timestamp\":4.0,\"name\":\"finish\",\"context\":{\"status\":0}}\n"
+    "{\"timestamp\":5.0,\"name\":\"free\"}\n"
+    "{\"timestamp\":6.0,\"name\":\"clean\"}\n";
+
+/* Check that 'entry' is [id, state, timestamp], followed by data
+ * if 'datap' is non-NULL.
+ */
+static bool check_entry (json_t *entry,
+                         flux_jobid_t id,
+                         const char *state,
+                         double timestamp,
+                         json_t **datap)
+{
+    flux_jobid_t xid;
+    const char *xstate;
+    double xtimestamp;
+
+    if (!json_is_array (entry)
+        || json_array_size (entry) != (datap ? 4 : 3)
+        || json_unpack (entry, "[I,s,f]", &xid, &xstate, &xtimestamp) < 0
+        || xid != id
+        || strcmp (xstate, state) != 0
+        || xtimestamp != timestamp)
+        return false;
+    if (datap)
+        *datap = json_array_get (entry, 3);
+    return true;
+}
+
+void test_pending (void)
+{
+    struct job *job;
+    json_t *entry;
+    json_t *data;
+    int userid, priority, flags;
+    int ntasks = 0;
+
+    if (!(job = job_create ()))
+        BAIL_OUT ("job_create failed");
+    job->id = 1;
+    job->userid = 42;
+    job->priority = 16;
+    job->state = FLUX_JOB_DEPEND;
+
+    entry = journal_entry_create (job, 1.0);
+    ok (check_entry (entry, 1, "DEPEND", 1.0, &data)
+        && json_unpack (data, "{s:i s:i s:i !}",
+                        "userid", &userid,
+                        "priority", &priority,
+                        "flags", &flags) == 0
+        && userid == 42 && priority == 16 && flags == 0,
+        "DEPEND entry without jobspec has submit data");
+    json_decref (entry);
+
+    if (!(job->jobspec = json_pack ("{s:i s:[s]}",
+                                    "ntasks", 2,
+                                    "command", "hostname")))
+        BAIL_OUT ("json_pack failed");
+    entry = journal_entry_create (job, 1.0);
+    ok (check_entry (entry, 1, "DEPEND", 1.0, &data)
+        && json_unpack (data, "{s:{s:i}}", "jobspec", "ntasks", &ntasks) == 0
+        && ntasks == 2,
+        "DEPEND entry includes jobspec summary");
+    json_decref (entry);
+
+    job->state = FLUX_JOB_SCHED;
+    entry = journal_entry_create (job, 2.0);
+    ok (check_entry (entry, 1, "SCHED", 2.0, NULL),
+        "SCHED entry has no data");
+    json_decref (entry);
+
+    job_decref (job);
+}
+
+void test_run (void)
+{
+    struct job *job;
+    json_t *entry;
+    json_t *data;
+    const char *R;
+
+    if (!(job = job_create ()))
+        BAIL_OUT ("job_create failed");
+    job->id = 2;
+    job->state = FLUX_JOB_RUN;
+
+    entry = journal_entry_create (job, 3.0);
+    ok (check_entry (entry, 2, "RUN", 3.0, NULL),
+        "RUN entry without R has no data");
+    json_decref (entry);
+
+    if (!(job->R = json_string ("{\"version\":1}")))
+        BAIL_OUT ("json_string failed");
+    entry = journal_entry_create (job, 3.0);
+    ok (check_entry (entry, 2, "RUN", 3.0, &data)
+        && json_unpack (data, "{s:s}", "R", &R) == 0
+        && !strcmp (R, "{\"version\":1}"),
+        "RUN entry includes R");
+    json_decref (entry);
+
+    job_decref (job);
+}
+
+void test_inactive (void)
+{
+    struct job *job;
+    json_t *entry;
+    json_t *data;
+    int success;
+    const char *type;
+
+    if (!(job = job_create_from_eventlog (3, cancel_eventlog)))
+        BAIL_OUT ("job_create_from_eventlog failed");
+    ok (job->state == FLUX_JOB_INACTIVE,
+        "canceled job is INACTIVE");
+    entry = journal_entry_create (job, 9.0);
+    ok (check_entry (entry, 3, "INACTIVE", 9.0, &data)
+        && json_unpack (data, "{s:b s:{s:s}}",
+                        "success", &success,
+                        "exception", "type", &type) == 0
+        && !success
+        && !strcmp (type, "cancel"),
+        "INACTIVE entry has first most severe exception, no success");
+    json_decref (entry);
+    job_decref (job);
+
+    if (!(job = job_create_from_eventlog (4, success_eventlog)))
+        BAIL_OUT ("job_create_from_eventlog failed");
+    entry = journal_entry_create (job, 6.0);
+    ok (check_entry (entry, 4, "INACTIVE", 6.0, &data)
+        && json_unpack (data, "{s:b !}", "success", &success) == 0
+        && success,
+        "INACTIVE entry of successful job has success and no exception");
+    json_decref (entry);
+    job_decref (job);
+}
+
+void test_ctx (void)
+{
+    ok (journal_listening (NULL) == false,
+        "journal_listening journal=NULL returns false");
+    lives_ok ({journal_send (NULL, NULL);},
+        "journal_send journal=NULL doesn't crash");
+    lives_ok ({journal_disconnect (NULL, NULL);},
+        "journal_disconnect journal=NULL doesn't crash");
+    lives_ok ({journal_ctx_destroy (NULL);},
+        "journal_ctx_destroy journal=NULL doesn't crash");
+}
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    test_pending ();
+    test_run ();
+    test_inactive ();
+    test_ctx ();
+
+    done_testing ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -20,14 +20,16 @@
  * The event that transitions a waitable job to the CLEANUP state is
  * captured in job->end_event.  RFC 21 dictates it must be a finish event
  * containing a wait(2) style status byte, or a fatal exception.
- * The event is converted to the summary above when the wait response
- * is constructed.
+ * The event is converted to the summary above once, when the job
+ * becomes INACTIVE, and kept in job->wait_result.
  *
  * If the target job is active when the wait request is received,
  * the request is tacked onto the 'struct job' and processed upon
  * transtion to INACTIVE state.  If the target waitable job has already
  * transitioned to INACTIVE, it is found in the wait->zombies hash
- * and the request is processed immediately.
+ * and the request is processed immediately.  Zombies are also kept in
+ * wait->zombie_queue in the order they became INACTIVE, so that
+ * FLUX_JOBID_ANY is answered from the head of the queue in O(1).
  *
  * Only jobs submitted with the FLUX_JOB_WAITABLE can be waited on.
  *
@@ -38,11 +40,16 @@
  * to avoid possible unchecked zombie growth in a system instance.
  *
  * If the job id is FLUX_JOBID_ANY, then the response is:
- * (1) result of the first job found in the wait->zombies hash
+ * (1) result of the oldest zombie
  * (2) result of the next waitable job transitioning to INACTIVE,
  *     without a waiter on the specific ID
  * (3) ECHILD error if no waitable jobs are available, or there are
  *     more waiters than jobs
+ *
+ * A FLUX_JOBID_ANY request may set "max" to reap up to that many
+ * zombies at once.  The response is then {"jobs":[result, ...]}, with
+ * all zombies up to "max", or if there are none, the next waitable job
+ * to transition to INACTIVE.
  */
 
 #if HAVE_CONFIG_H
@@ -64,9 +71,11 @@ struct waitjob {
     struct job_manager *ctx;
     flux_msg_handler_t **handlers;
     zhashx_t *zombies;
+    zlistx_t *zombie_queue; // zombies in order of becoming INACTIVE
     int waiters; // count of waiters blocked on specific active jobs
     int waitables; // count of active waitable jobs
-    zlistx_t *requests; // requests to wait in FLUX_JOBID_ANY
+    struct flux_msglist *requests; // requests to wait in FLUX_JOBID_ANY
+    struct flux_msglist *jobs; // jobs with a waiter, by waiter's sender
 };
 
 static int decode_job_result (struct job *job,
@@ -137,32 +146,67 @@ static int decode_job_result (struct job *job,
     return 0;
 }
 
-/* Respond to wait request 'msg' with completion info from 'job'.
+/* Set job->wait_result to the completion info of INACTIVE 'job',
+ * so that it can be sent without decoding job->end_event again.
+ * The end event is not needed once the job is INACTIVE, so drop it.
  */
-static void wait_respond (struct waitjob *wait,
-                          const flux_msg_t *msg,
-                          struct job *job)
+static void wait_result_set (struct waitjob *wait, struct job *job)
 {
-    flux_t *h = wait->ctx->h;
     char errbuf[1024];
     bool success;
 
     if (decode_job_result (job, &success, errbuf, sizeof (errbuf)) < 0) {
-        flux_log (h,
+        flux_log (wait->ctx->h,
+                  LOG_ERR,
+                  "wait id=%ju: result decode failure",
+                  (uintmax_t)job->id);
+        return;
+    }
+    if (!(job->wait_result = json_pack ("{s:I s:b s:s}",
+                                        "id",
+                                        job->id,
+                                        "success",
+                                        success ? 1 : 0,
+                                        "errstr",
+                                        errbuf))) {
+        flux_log (wait->ctx->h,
                   LOG_ERR,
-                  "wait_respond id=%ju: result decode failure",
+                  "wait id=%ju: error encoding result",
                   (uintmax_t)job->id);
+        return;
+    }
+    json_decref (job->end_event);
+    job->end_event = NULL;
+}
+
+/* Return the "max" of a FLUX_JOBID_ANY wait request, or 0 if unset.
+ */
+static int wait_request_max (const flux_msg_t *msg)
+{
+    int max = 0;
+
+    (void)flux_request_unpack (msg, NULL, "{s?i}", "max", &max);
+    return max;
+}
+
+/* Respond to wait request 'msg' with completion info from 'job'.
+ */
+static void wait_respond (struct waitjob *wait,
+                          const flux_msg_t *msg,
+                          struct job *job)
+{
+    flux_t *h = wait->ctx->h;
+    int rc;
+
+    if (!job->wait_result) {
+        errno = EPROTO;
         goto error;
     }
-    if (flux_respond_pack (h,
-                           msg,
-                           "{s:I s:b s:s}",
-                           "id",
-                           job->id,
-                           "success",
-                           success ? 1 : 0,
-                           "errstr",
-                           errbuf) < 0)
+    if (wait_request_max (msg) > 0)
+        rc = flux_respond_pack (h, msg, "{s:[O]}", "jobs", job->wait_result);
+    else
+        rc = flux_respond_pack (h, msg, "O", job->wait_result);
+    if (rc < 0)
         flux_log_error (h, "wait_respond id=%ju", (uintmax_t)job->id);
     return;
 error:
@@ -170,6 +214,56 @@ error:
         flux_log_error (h, "wait_respond id=%ju", (uintmax_t)job->id);
 }
 
+static int zombie_add (struct waitjob *wait, struct job *job)
+{
+    if (zhashx_insert (wait->zombies, &job->id, job) < 0) // increfs job
+        return -1;
+    if (!(job->zombie_handle = zlistx_add_end (wait->zombie_queue, job))) {
+        zhashx_delete (wait->zombies, &job->id);
+        return -1;
+    }
+    return 0;
+}
+
+/* Remove 'job' from zombies.  This may drop the last reference to 'job'.
+ */
+static void zombie_remove (struct waitjob *wait, struct job *job)
+{
+    zlistx_delete (wait->zombie_queue, job->zombie_handle);
+    job->zombie_handle = NULL;
+    zhashx_delete (wait->zombies, &job->id); // decrefs job
+}
+
+/* Respond to FLUX_JOBID_ANY request 'msg' with "max" > 0, with the
+ * results of up to "max" zombies, which are then destroyed.
+ */
+static void wait_respond_batch (struct waitjob *wait,
+                                const flux_msg_t *msg,
+                                int max)
+{
+    flux_t *h = wait->ctx->h;
+    json_t *jobs;
+    struct job *job;
+
+    if (!(jobs = json_array ()))
+        goto nomem;
+    while (json_array_size (jobs) < max
+           && (job = zlistx_first (wait->zombie_queue))) {
+        if (job->wait_result
+            && json_array_append (jobs, job->wait_result) < 0)
+            goto nomem;
+        zombie_remove (wait, job);
+    }
+    if (flux_respond_pack (h, msg, "{s:O}", "jobs", jobs) < 0)
+        flux_log_error (h, "%s: flux_respond_pack", __func__);
+    json_decref (jobs);
+    return;
+nomem:
+    if (flux_respond_error (h, msg, ENOMEM, NULL) < 0)
+        flux_log_error (h, "%s: flux_respond_error", __func__);
+    json_decref (jobs);
+}
+
 /* Callback from event_job_action().  The 'job' has entered INACTIVE state.
  * Respond to a pending waiter, if any.  Otherwise insert into zombies
  * hash for a future wait request.
@@ -181,19 +275,21 @@ void wait_notify_inactive (struct waitjob *wait, struct job *job)
 
     assert ((job->flags & FLUX_JOB_WAITABLE));
 
+    wait_result_set (wait, job);
     if (job->waiter) {
         wait_respond (wait, job->waiter, job);
+        (void)flux_msglist_remove (wait->jobs, job);
         flux_msg_decref (job->waiter);
         job->waiter = NULL;
         wait->waiters--;
     }
-    else if ((req = zlistx_detach (wait->requests, NULL))) {
+    else if ((req = flux_msglist_pop (wait->requests))) {
         wait_respond (wait, req, job);
         flux_msg_decref (req);
     }
     else {
-        if (zhashx_insert (wait->zombies, &job->id, job) < 0) // increfs job
-            flux_log (h, LOG_ERR, "zhashx_insert into zombies hash failed");
+        if (zombie_add (wait, job) < 0)
+            flux_log (h, LOG_ERR, "error adding job to zombies");
     }
     wait->waitables--;
 }
@@ -215,27 +311,37 @@ static void wait_rpc (flux_t *h,
     struct job_manager *ctx = arg;
     struct waitjob *wait = ctx->wait;
     flux_jobid_t id;
+    int max = 0;
     struct job *job;
     const char *errstr = NULL;
 
-    if (flux_request_unpack (msg, NULL, "{s:I}", "id", &id) < 0) {
+    if (flux_request_unpack (msg, NULL, "{s:I s?i}",
+                             "id", &id,
+                             "max", &max) < 0) {
         errstr = "malformed wait request";
         goto error;
     }
+    if (max < 0 || (max > 0 && id != FLUX_JOBID_ANY)) {
+        errno = EPROTO;
+        errstr = "max must be positive and requires FLUX_JOBID_ANY";
+        goto error;
+    }
     if (id == FLUX_JOBID_ANY) {
-        /* If there's a zombie, respond and destroy it.
+        /* If there are zombies, respond and destroy them.
          */
-        if ((job = zhashx_first (wait->zombies))) {
+        if (max > 0 && zlistx_size (wait->zombie_queue) > 0)
+            wait_respond_batch (wait, msg, max);
+        else if ((job = zlistx_first (wait->zombie_queue))) {
             wait_respond (wait, msg, job);
-            zhashx_delete (wait->zombies, &job->id);
+            zombie_remove (wait, job);
         }
         /* Enqueue request until a waitable job transitions to inactive.
          */
         else {
-            if (zlistx_add_end (wait->requests,
-                                (void *)flux_msg_incref (msg)) < 0) {
+            if (flux_msglist_append (wait->requests,
+                                     msg,
+                                     (void *)flux_msg_incref (msg)) < 0) {
                 flux_msg_decref (msg);
-                errno = ENOMEM;
                 goto error;
             }
         }
@@ -245,7 +351,7 @@ static void wait_rpc (flux_t *h,
          */
         if ((job = zhashx_lookup (wait->zombies, &id))) {
             wait_respond (wait, msg, job);
-            zhashx_delete (wait->zombies, &id); // decrefs job
+            zombie_remove (wait, job);
         }
         /* If job is still active, enqueue the request.
          */
@@ -258,6 +364,8 @@ static void wait_rpc (flux_t *h,
                 errstr = "job was not submitted with FLUX_JOB_WAITABLE";
                 goto error_nojob;
             }
+            if (flux_msglist_append (wait->jobs, msg, job) < 0)
+                goto error;
             job->waiter = flux_msg_incref (msg);
             wait->waiters++;
             return;
@@ -275,8 +383,9 @@ static void wait_rpc (flux_t *h,
      * (1) wait on specific ID increased wait->waiters, or
      * (2) wait on FLUX_JOBID_ANY increased wait->requests.
      */
-    if (zlistx_size (wait->requests) + wait->waiters > wait->waitables) {
-        const flux_msg_t *req = zlistx_last (wait->requests);
+    if (flux_msglist_count (wait->requests) + wait->waiters
+        > wait->waitables) {
+        const flux_msg_t *req = flux_msglist_last (wait->requests);
 
         if (req) {
             if (flux_respond_error (h,
@@ -284,7 +393,7 @@ static void wait_rpc (flux_t *h,
                                     ECHILD,
                                     "there are no more waitable jobs") < 0)
                 flux_log_error (h, "%s: flux_respond_error", __func__);
-            zlistx_detach_cur (wait->requests);
+            (void)flux_msglist_remove (wait->requests, (void *)req);
             flux_msg_decref (req);
         }
     }
@@ -297,58 +406,32 @@ error:
         flux_log_error (h, "%s: flux_respond_error", __func__);
 }
 
-/* A client has disconnected.  Destroy any waiters registered by that client.
- */
-static void disconnect_rpc (flux_t *h,
-                            flux_msg_handler_t *mh,
-                            const flux_msg_t *msg,
-                            void *arg)
+void wait_disconnect (struct waitjob *wait, const flux_msg_t *msg)
 {
-    struct job_manager *ctx = arg;
-    struct waitjob *wait = ctx->wait;
-    char *sender;
-    char *w_sender;
     struct job *job;
     const flux_msg_t *req;
 
-    if (flux_msg_get_route_first (msg, &sender) < 0)
-        return;
-    job = zhashx_first (ctx->active_jobs);
-    while (job && wait->waiters > 0) {
-        if (job->waiter) {
-            if (flux_msg_get_route_first (job->waiter, &w_sender) == 0) {
-                if (!strcmp (sender, w_sender)) {
-                    flux_msg_decref (job->waiter);
-                    job->waiter = NULL;
-                    wait->waiters--;
-                }
-            }
-            free (w_sender);
-        }
-        job = zhashx_next (ctx->active_jobs);
-    }
-    req = zlistx_first (wait->requests);
-    while (req) {
-        if (flux_msg_get_route_first (req, &w_sender) == 0) {
-            if (!strcmp (sender, w_sender)) {
-                zlistx_detach_cur (wait->requests);
-                flux_msg_decref (req);
-            }
-            free (w_sender);
-        }
-        req = zlistx_next (wait->requests);
+    while ((job = flux_msglist_pop_sender (wait->jobs,
+                                           msg,
+                                           FLUX_MATCHTAG_NONE))) {
+        flux_msg_decref (job->waiter);
+        job->waiter = NULL;
+        wait->waiters--;
     }
-    free (sender);
+    while ((req = flux_msglist_pop_sender (wait->requests,
+                                           msg,
+                                           FLUX_MATCHTAG_NONE)))
+        flux_msg_decref (req);
 }
 
 struct job *wait_zombie_first (struct waitjob *wait)
 {
-    return zhashx_first (wait->zombies);
+    return zlistx_first (wait->zombie_queue);
 }
 
 struct job *wait_zombie_next (struct waitjob *wait)
 {
-    return zhashx_next (wait->zombies);
+    return zlistx_next (wait->zombie_queue);
 }
 
 static void respond_unloading (flux_t *h, const flux_msg_t *msg)
@@ -366,19 +449,17 @@ void wait_ctx_destroy (struct waitjob *wait)
         int saved_errno = errno;
         flux_msg_handler_delvec (wait->handlers);
 
-        /* Iterate through active jobs, sending ENOSYS response to
-         * any pending wait requests, indicating that the module is unloading.
-         * Use wait->waiters count to avoid unncessary scanning.
+        /* Send ENOSYS response to any pending wait requests on active
+         * jobs, indicating that the module is unloading.
          */
-        job = zhashx_first (wait->ctx->active_jobs);
-        while (job && wait->waiters > 0) {
-            if (job->waiter) {
+        if (wait->jobs) {
+            while ((job = flux_msglist_pop (wait->jobs))) {
                 respond_unloading (h, job->waiter);
                 flux_msg_decref (job->waiter);
                 job->waiter = NULL;
                 wait->waiters--;
             }
-            job = zhashx_next (wait->ctx->active_jobs);
+            flux_msglist_destroy (wait->jobs);
         }
 
         /* Send ENOSYS to any pending FLUX_JOBID_ANY wait requests,
@@ -387,13 +468,14 @@ void wait_ctx_destroy (struct waitjob *wait)
         if (wait->requests) {
             const flux_msg_t *msg;
 
-            while ((msg = zlistx_detach (wait->requests, NULL))) {
+            while ((msg = flux_msglist_pop (wait->requests))) {
                 respond_unloading (h, msg);
                 flux_msg_decref (msg);
             }
-            zlistx_destroy (&wait->requests);
+            flux_msglist_destroy (wait->requests);
         }
 
+        zlistx_destroy (&wait->zombie_queue);
         zhashx_destroy (&wait->zombies);
         free (wait);
         errno = saved_errno;
@@ -407,12 +489,6 @@ static const struct flux_msg_handler_spec htab[] = {
         .cb = wait_rpc,
         .rolemask = 0
     },
-    {
-        .typemask = FLUX_MSGTYPE_REQUEST,
-        .topic_glob = "job-manager.disconnect",
-        .cb = disconnect_rpc,
-        .rolemask = 0
-    },
     FLUX_MSGHANDLER_TABLE_END,
 };
 
@@ -428,8 +504,11 @@ struct waitjob *wait_ctx_create (struct job_manager *ctx)
         goto error;
     zhashx_set_destructor (wait->zombies, job_destructor);
     zhashx_set_duplicator (wait->zombies, job_duplicator);
+    if (!(wait->zombie_queue = zlistx_new ()))
+        goto error;
 
-    if (!(wait->requests = zlistx_new ()))
+    if (!(wait->requests = flux_msglist_create ())
+        || !(wait->jobs = flux_msglist_create ()))
         goto error;
 
     if (flux_msg_handler_addvec (ctx->h, htab, ctx, &wait->handlers) < 0)
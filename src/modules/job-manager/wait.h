@@ -19,6 +19,10 @@
 void wait_notify_inactive (struct waitjob *wait, struct job *job);
 void wait_notify_active (struct waitjob *wait, struct job *job);
 
+/* A client has disconnected.  Destroy any waiters registered by that client.
+ */
+void wait_disconnect (struct waitjob *wait, const flux_msg_t *msg);
+
 struct waitjob *wait_ctx_create (struct job_manager *ctx);
 void wait_ctx_destroy (struct waitjob *wait);
 
@@ -20,6 +20,7 @@
 #include "src/common/libkvs/treeobj.h"
 #include "src/common/libkvs/kvs_util_private.h"
 #include "src/common/libutil/blobref.h"
+#include "src/common/libutil/errno_safe.h"
 
 /* State for one watcher */
 struct watcher {
@@ -32,6 +33,7 @@ struct watcher {
     bool initial_rpc_sent;      // flag is initial watch rpc sent
     bool initial_rpc_received;  // flag is initial watch rpc received
     bool finished;              // flag indicates if watcher is finished
+    bool symlink;               // last lookup followed a symlink (or unknown)
     int initial_rootseq;        // initial rootseq returned by initial rpc
     char *key;                  // lookup key
     int flags;                  // kvs_lookup flags
@@ -39,7 +41,11 @@ struct watcher {
 
     struct ns_monitor *nsm;     // back pointer for removal
     json_t *prev;               // previous watch value for KVS_WATCH_FULL/UNIQ
-    int append_offset;          // offset for KVS_WATCH_APPEND
+    int append_index;           // KVS_WATCH_APPEND lookup position:
+    int append_offset;          //   blob index and offset within it,
+    int append_skip;            //   and bytes after it already returned
+    int append_end_index;       // KVS_WATCH_APPEND position at end of
+    int append_end_offset;      //   last response
 };
 
 /* Current KVS root.
@@ -50,6 +56,8 @@ struct commit {
     json_t *keys;               // keys changed by commit
                                 //  empty if data originates from getroot RPC
                                 //  or kvs.namespace-<NS>-created event
+    zhash_t *changed;           // keys changed by commit, NULL if unknown
+    zhash_t *parents;           // directories of the changed keys
 };
 
 
@@ -74,12 +82,19 @@ struct watch_ctx {
     flux_t *h;
     flux_msg_handler_t **handlers;
     zhash_t *namespaces;        // hash of monitored namespaces
+    zhash_t *shares;            // lookups sent for the current commit
+    struct flux_msglist *requests; // all watchers, indexed by sender
+    int lookups;                // for kvs-watch.stats.get
+    int lookups_shared;         // for kvs-watch.stats.get
+    int lookups_skipped;        // for kvs-watch.stats.get
 };
 
 static void watcher_destroy (struct watcher *w)
 {
     if (w) {
         int saved_errno = errno;
+        if (w->nsm)
+            (void)flux_msglist_remove (w->nsm->ctx->requests, w);
         flux_msg_decref (w->request);
         free (w->key);
         if (w->lookups) {
@@ -110,6 +125,7 @@ static struct watcher *watcher_create (const flux_msg_t *msg, const char *key,
         goto error_nomem;
     w->flags = flags;
     w->rootseq = -1;
+    w->symlink = true;
     return w;
 error_nomem:
     errno = ENOMEM;
@@ -125,11 +141,79 @@ static void commit_destroy (struct commit *commit)
         free (commit->rootref);
         if (commit->keys)
             json_decref (commit->keys);
+        zhash_destroy (&commit->changed);
+        zhash_destroy (&commit->parents);
         free (commit);
         errno = saved_errno;
     }
 }
 
+/* Index the keys changed by 'commit' in commit->changed, and each of
+ * their parent directories in commit->parents, so watchers can tell
+ * whether the commit may have affected them with a few lookups.
+ * Keys are normalized by the KVS.  The items are unused.
+ */
+static int commit_hash_keys (struct commit *commit)
+{
+    size_t index;
+    json_t *value;
+
+    if (!(commit->changed = zhash_new ())
+        || !(commit->parents = zhash_new ()))
+        goto nomem;
+    json_array_foreach (commit->keys, index, value) {
+        const char *key = json_string_value (value);
+        char *path;
+        char *cp;
+
+        if (!key)
+            continue;
+        if (zhash_insert (commit->changed, key, commit) < 0
+            && !zhash_lookup (commit->changed, key))
+            goto nomem;
+        if (!(path = strdup (key)))
+            goto nomem;
+        while ((cp = strrchr (path, '.'))) {
+            *cp = '\0';
+            if (zhash_insert (commit->parents, path, commit) < 0)
+                break; // path and its parents are already there
+        }
+        free (path);
+    }
+    return 0;
+nomem:
+    errno = ENOMEM;
+    return -1;
+}
+
+/* Return true if 'commit' may have changed the value of 'key', looked
+ * up without following symlinks: 'key' itself, a key under it, or one
+ * of its parent directories was changed.  If the changed keys are not
+ * known, return true.
+ */
+static bool commit_affects_key (struct commit *commit, const char *key)
+{
+    char *path;
+    char *cp;
+    bool match = false;
+
+    if (!commit->changed
+        || !strcmp (key, ".")
+        || zhash_lookup (commit->changed, ".")
+        || zhash_lookup (commit->changed, key)
+        || zhash_lookup (commit->parents, key))
+        return true;
+    if (!(path = strdup (key)))
+        return true;
+    while (!match && (cp = strrchr (path, '.'))) {
+        *cp = '\0';
+        if (zhash_lookup (commit->changed, path))
+            match = true;
+    }
+    free (path);
+    return match;
+}
+
 static struct commit *commit_create (const char *rootref, int rootseq,
                                      json_t *keys)
 {
@@ -143,6 +227,10 @@ static struct commit *commit_create (const char *rootref, int rootseq,
     /* keys can be NULL */
     commit->keys = json_incref (keys);
     commit->rootseq = rootseq;
+    if (keys && commit_hash_keys (commit) < 0) {
+        commit_destroy (commit);
+        return NULL;
+    }
     return commit;
 }
 
@@ -208,22 +296,6 @@ error:
     return NULL;
 }
 
-/* Helper for watcher_respond - is key a member of array?
- * N.B. array 'a' can be NULL
- */
-static bool array_match (json_t *a, const char *key)
-{
-    size_t index;
-    json_t *value;
-
-    json_array_foreach (a, index, value) {
-        const char *s = json_string_value (value);
-        if (s && !strcmp (s, key))
-            return true;
-    }
-    return false;
-}
-
 static void watcher_cleanup (struct ns_monitor *nsm, struct watcher *w)
 {
     /* wait for all in flight lookups to complete before destroying watcher */
@@ -237,10 +309,18 @@ static void watcher_cleanup (struct ns_monitor *nsm, struct watcher *w)
         zhash_delete (nsm->ctx->namespaces, nsm->ns_name);
 }
 
+static int handle_append_response (flux_t *h,
+                                   struct watcher *w,
+                                   json_t *val,
+                                   int index,
+                                   int offset);
+
 static int handle_initial_response (flux_t *h,
                                     struct watcher *w,
                                     json_t *val,
-                                    int root_seq)
+                                    int root_seq,
+                                    int index,
+                                    int offset)
 {
     /* this is the first response case, store the first response
      * val */
@@ -248,16 +328,12 @@ static int handle_initial_response (flux_t *h,
         || (w->flags & FLUX_KVS_WATCH_UNIQ))
         w->prev = json_incref (val);
 
+    /* the initial lookup starts at the beginning of the value */
     if ((w->flags & FLUX_KVS_WATCH_APPEND)) {
-        if (treeobj_decode_val (val,
-                                NULL,
-                                &w->append_offset) < 0) {
-            flux_log_error (h, "%s: treeobj_decode_val", __FUNCTION__);
+        if (handle_append_response (h, w, val, index, offset) < 0)
             return -1;
-        }
     }
-
-    if (flux_respond_pack (h, w->request, "{ s:O }", "val", val) < 0) {
+    else if (flux_respond_pack (h, w->request, "{ s:O }", "val", val) < 0) {
         flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
         return -1;
     }
@@ -302,69 +378,59 @@ static int handle_compare_response (flux_t *h,
     return 0;
 }
 
+/* Respond with the data of append lookup response 'val' that has not
+ * been returned yet.  Lookups in flight all start at the same position
+ * (see process_lookup_response()), so 'val' may begin with data already
+ * returned for an earlier commit.  'index' and 'offset' are the position
+ * at the end of the value.
+ */
 static int handle_append_response (flux_t *h,
-                                    struct watcher *w,
-                                    json_t *val)
+                                   struct watcher *w,
+                                   json_t *val,
+                                   int index,
+                                   int offset)
 {
-    if (!w->responded) {
-        /* this is the first response case, store the first response
-         * info.  This is here b/c initial response could have been
-         * ENOENT case */
-        if (treeobj_decode_val (val,
-                                NULL,
-                                &w->append_offset) < 0) {
-            flux_log_error (h, "%s: treeobj_decode_val", __FUNCTION__);
-            return -1;
-        }
-
-        if (flux_respond_pack (h, w->request, "{ s:O }", "val", val) < 0) {
-            flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
-            return -1;
-        }
+    json_t *new_val = NULL;
+    void *new_data = NULL;
+    int len;
 
-        w->responded = true;
+    if (treeobj_decode_val (val, &new_data, &len) < 0) {
+        flux_log_error (h, "%s: treeobj_decode_val", __FUNCTION__);
+        return -1;
     }
-    else {
-        json_t *new_val = NULL;
-        void *new_data = NULL;
-        int new_offset;
-
-        if (treeobj_decode_val (val,
-                                &new_data,
-                                &new_offset) < 0) {
-            flux_log_error (h, "%s: treeobj_decode_val", __FUNCTION__);
-            return -1;
-        }
 
-        /* check length to determine if append actually happened, note
-         * that zero length append is legal
-         *
-         * Note that this check does not ensure that the key was not
-         * "fake" appended to.  i.e. the key overwritten with data
-         * longer than the original.
-         */
-        if (new_offset < w->append_offset) {
-            free (new_data);
-            errno = EINVAL;
-            return -1;
-        }
-
-        if (!(new_val = treeobj_create_val (new_data + w->append_offset,
-                                            new_offset - w->append_offset))) {
-            free (new_data);
-            return -1;
-        }
+    /* The KVS fails the lookup if the value no longer extends to the
+     * lookup position.  Check that it still extends past the data
+     * already returned, note that a zero length append is legal.
+     *
+     * Note that this check does not ensure that the key was not
+     * "fake" appended to.  i.e. the key overwritten with data
+     * longer than the original.
+     */
+    if (index < 0 || len < w->append_skip) {
+        free (new_data);
+        errno = index < 0 ? EPROTO : EINVAL;
+        return -1;
+    }
 
+    if (!(new_val = treeobj_create_val ((char *)new_data + w->append_skip,
+                                        len - w->append_skip))) {
         free (new_data);
-        w->append_offset = new_offset;
+        return -1;
+    }
 
-        if (flux_respond_pack (h, w->request, "{ s:o }", "val", new_val) < 0) {
-            json_decref (new_val);
-            flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
-            return -1;
-        }
+    free (new_data);
+    w->append_skip = len;
+    w->append_end_index = index;
+    w->append_end_offset = offset;
+
+    if (flux_respond_pack (h, w->request, "{ s:o }", "val", new_val) < 0) {
+        json_decref (new_val);
+        flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
+        return -1;
     }
 
+    w->responded = true;
     return 0;
 }
 
@@ -394,8 +460,16 @@ static void handle_lookup_response (flux_future_t *f,
     flux_t *h = flux_future_get_flux (f);
     int errnum;
     int root_seq;
+    int index = -1;
+    int offset = -1;
+    int symlink = 1;
     json_t *val;
 
+    /* Older KVS modules do not report "symlink", assume one was followed.
+     */
+    (void)flux_rpc_get_unpack (f, "{ s?b }", "symlink", &symlink);
+    w->symlink = symlink ? true : false;
+
     if (flux_future_aux_get (f, "initial")) {
 
         w->initial_rpc_received = true;
@@ -414,9 +488,10 @@ static void handle_lookup_response (flux_future_t *f,
             goto error;
         }
 
-        if (flux_rpc_get_unpack (f, "{ s:o s:i }",
+        if (flux_rpc_get_unpack (f, "{ s:o s:i s?[ii] }",
                                  "val", &val,
-                                 "rootseq", &root_seq) < 0) {
+                                 "rootseq", &root_seq,
+                                 "append", &index, &offset) < 0) {
             /* It is worth mentioning ENOTSUP error conditions here.
              *
              * Recall that in namespace_monitor(), an initial getroot
@@ -437,7 +512,7 @@ static void handle_lookup_response (flux_future_t *f,
             goto error;
         }
 
-        if (handle_initial_response (h, w, val, root_seq) < 0)
+        if (handle_initial_response (h, w, val, root_seq, index, offset) < 0)
             goto error;
     }
     else {
@@ -450,9 +525,10 @@ static void handle_lookup_response (flux_future_t *f,
             goto error;
         }
 
-        if (flux_rpc_get_unpack (f, "{ s:o s:i }",
+        if (flux_rpc_get_unpack (f, "{ s:o s:i s?[ii] }",
                                  "val", &val,
-                                 "rootseq", &root_seq) < 0)
+                                 "rootseq", &root_seq,
+                                 "append", &index, &offset) < 0)
             goto error;
 
         /* if we got some setroots before the initial rpc returned,
@@ -467,7 +543,7 @@ static void handle_lookup_response (flux_future_t *f,
                     goto error;
             }
             else if (w->flags & FLUX_KVS_WATCH_APPEND) {
-                if (handle_append_response (h, w, val) < 0)
+                if (handle_append_response (h, w, val, index, offset) < 0)
                     goto error;
             }
             else {
@@ -489,10 +565,10 @@ error:
  * Pop ready futures off w->lookups and send responses, until
  * the list is empty, or a non-ready future is encountered.
  */
-static void lookup_continuation (flux_future_t *f, void *arg)
+static void lookup_continuation (struct watcher *w)
 {
-    struct watcher *w = arg;
     struct ns_monitor *nsm = w->nsm;
+    flux_future_t *f;
 
     while ((f = zlist_first (w->lookups)) && flux_future_is_ready (f)) {
         f = zlist_pop (w->lookups);
@@ -512,6 +588,31 @@ static void lookup_continuation (flux_future_t *f, void *arg)
         watcher_cleanup (nsm, w);
 }
 
+/* A lookup shared by the watchers in list 'l' has completed.
+ * Each watcher holds its own reference on 'f' in w->lookups.  Hold one
+ * more here, since the last watcher to drop its reference would
+ * otherwise destroy 'l' while it is being traversed.
+ */
+static void lookup_share_continuation (flux_future_t *f, void *arg)
+{
+    zlist_t *l = arg;
+    struct watcher *w;
+
+    flux_future_incref (f);
+    w = zlist_first (l);
+    while (w) {
+        lookup_continuation (w);
+        w = zlist_next (l);
+    }
+    flux_future_decref (f);
+}
+
+static void share_list_destroy (void *arg)
+{
+    zlist_t *l = arg;
+    zlist_destroy (&l);
+}
+
 /* Like flux_kvs_lookupat() except:
  * - targets kvs.lookup-plus, so root_ref & root_seq are available in
  *   response
@@ -528,29 +629,41 @@ static flux_future_t *lookupat (flux_t *h,
 {
     flux_msg_t *msg;
     json_t *o = NULL;
+    json_t *payload = NULL;
+    json_t *append;
     flux_future_t *f;
     int saved_errno;
 
     if (!(msg = flux_request_encode ("kvs.lookup-plus", NULL)))
         return NULL;
     if (!w->initial_rpc_sent) {
-        if (flux_msg_pack (msg, "{s:s s:s s:i}",
-                           "key", w->key,
-                           "namespace", ns,
-                           "flags", w->flags) < 0)
-            goto error;
+        if (!(payload = json_pack ("{s:s s:s s:i}",
+                                   "key", w->key,
+                                   "namespace", ns,
+                                   "flags", w->flags)))
+            goto nomem;
     }
     else {
         if (!(o = treeobj_create_dirref (blobref)))
             goto error;
-        if (flux_msg_pack (msg, "{s:s s:i s:i s:O}",
-                           "key", w->key,
-                           "flags", w->flags,
-                           "rootseq", root_seq,
-                           "rootdir", o) < 0)
-            goto error;
+        if (!(payload = json_pack ("{s:s s:i s:i s:O}",
+                                   "key", w->key,
+                                   "flags", w->flags,
+                                   "rootseq", root_seq,
+                                   "rootdir", o)))
+            goto nomem;
+    }
+    /* only the data after the append position is returned */
+    if ((w->flags & FLUX_KVS_WATCH_APPEND)) {
+        if (!(append = json_pack ("[ii]",
+                                  w->append_index,
+                                  w->append_offset))
+            || json_object_set_new (payload, "append", append) < 0)
+            goto nomem;
     }
-    /* N.B. Since this module is authenticated to the shmem:// connector
+    if (flux_msg_pack (msg, "O", payload) < 0)
+        goto error;
+    /* N.B. Since this module is authenticated to the broker connection
      * with FLUX_ROLE_OWNER, we are allowed to switch the message credentials
      * in this request message, and not be overridden at the connector,
      * as would be the case if we were not sufficiently privileged.
@@ -569,38 +682,127 @@ static flux_future_t *lookupat (flux_t *h,
     }
     w->initial_rpc_sent = true;
     flux_msg_destroy (msg);
+    json_decref (payload);
     json_decref (o);
     return f;
+nomem:
+    errno = ENOMEM;
 error:
     saved_errno = errno;
+    json_decref (payload);
     json_decref (o);
     flux_msg_destroy (msg);
     errno = saved_errno;
     return NULL;
 }
 
+/* Add an existing lookup 'f' to watcher 'w'.
+ */
+static int lookup_share (struct watcher *w, flux_future_t *f)
+{
+    zlist_t *l = flux_future_aux_get (f, "watchers");
+
+    if (zlist_append (l, w) < 0)
+        goto nomem;
+    if (zlist_append (w->lookups, f) < 0) {
+        zlist_remove (l, w);
+        goto nomem;
+    }
+    flux_future_incref (f);
+    return 0;
+nomem:
+    errno = ENOMEM;
+    return -1;
+}
+
+/* Send a lookup for watcher 'w' at the current commit.
+ *
+ * Watchers of the same key, with the same flags and credentials, would
+ * send identical lookups at each commit.  While the watchers of a
+ * namespace are processed for a commit, lookups are recorded in
+ * ctx->shares so that one lookup is sent and its response fans out to
+ * all of them.  The initial lookup of a watcher is not shared, as it
+ * is sent against the namespace rather than a particular root.
+ */
 static int process_lookup_response (struct ns_monitor *nsm, struct watcher *w)
 {
+    struct watch_ctx *ctx = nsm->ctx;
     flux_future_t *f;
-    if (!(f = lookupat (nsm->ctx->h,
+    zlist_t *l = NULL;
+    char *sharekey = NULL;
+
+    /* Lookups in flight for an append watcher all start at the same
+     * position, so that their responses may be returned in order
+     * without knowing how much data each of the earlier ones holds.
+     * Move the position to the end of the data returned so far once
+     * no lookups are in flight.
+     */
+    if ((w->flags & FLUX_KVS_WATCH_APPEND)
+        && zlist_size (w->lookups) == 0) {
+        w->append_index = w->append_end_index;
+        w->append_offset = w->append_end_offset;
+        w->append_skip = 0;
+    }
+    if (ctx->shares && w->initial_rpc_sent) {
+        if (asprintf (&sharekey, "%s %d %ju %ju %d %d %s",
+                      nsm->ns_name,
+                      w->flags,
+                      (uintmax_t)w->cred.userid,
+                      (uintmax_t)w->cred.rolemask,
+                      w->append_index,
+                      w->append_offset,
+                      w->key) < 0) {
+            errno = ENOMEM;
+            return -1;
+        }
+        if ((f = zhash_lookup (ctx->shares, sharekey))) {
+            if (lookup_share (w, f) < 0)
+                goto error;
+            ctx->lookups_shared++;
+            goto done;
+        }
+    }
+    if (!(f = lookupat (ctx->h,
                         w,
                         nsm->commit->rootref,
                         nsm->commit->rootseq,
                         nsm->ns_name))) {
-        flux_log_error (nsm->ctx->h, "%s: lookupat", __FUNCTION__);
-        return -1;
+        flux_log_error (ctx->h, "%s: lookupat", __FUNCTION__);
+        goto error;
     }
-    if (zlist_append (w->lookups, f) < 0) {
+    if (!(l = zlist_new ())
+        || flux_future_aux_set (f, "watchers", l, share_list_destroy) < 0) {
         flux_future_destroy (f);
+        if (l)
+            zlist_destroy (&l);
         errno = ENOMEM;
-        return -1;
+        goto error;
     }
-    if (flux_future_then (f, -1., lookup_continuation, w) < 0) {
+    if (zlist_append (l, w) < 0
+        || zlist_append (w->lookups, f) < 0) {
         flux_future_destroy (f);
-        return -1;
+        errno = ENOMEM;
+        goto error;
+    }
+    if (flux_future_then (f, -1., lookup_share_continuation, l) < 0) {
+        zlist_remove (w->lookups, f);
+        flux_future_destroy (f);
+        goto error;
     }
+    /* N.B. entries are only valid while ctx->shares exists, during
+     * which 'f' cannot be destroyed, since no watcher has handled its
+     * response yet.  On failure to insert, the lookup is not shared.
+     */
+    if (sharekey)
+        (void)zhash_insert (ctx->shares, sharekey, f);
+    ctx->lookups++;
+done:
     w->rootseq = nsm->commit->rootseq;
+    free (sharekey);
     return 0;
+error:
+    ERRNO_SAFE_WRAP (free, sharekey);
+    return -1;
 }
 
 /* Respond to watcher request, if appropriate.
@@ -661,14 +863,22 @@ static void watcher_respond (struct ns_monitor *nsm, struct watcher *w)
      * the requestor is permitted to access *that* namespace.
      *
      * Note on FLUX_KVS_WATCH_FULL: A lookup / comparison is done on every
-     * change.
+     * change that may have affected the value.  That is any change if the
+     * key was last reached through a symlink, or if a lookup is still in
+     * flight, since its response may show that the path now contains one.
      */
     if (w->rootseq == -1
-        || (w->flags & FLUX_KVS_WATCH_FULL)
-        || array_match (nsm->commit->keys, w->key)) {
+        || ((w->flags & FLUX_KVS_WATCH_FULL)
+            && (w->symlink
+                || zlist_size (w->lookups) > 0
+                || commit_affects_key (nsm->commit, w->key)))
+        || (nsm->commit->changed
+            && zhash_lookup (nsm->commit->changed, w->key))) {
         if (process_lookup_response (nsm, w) < 0)
             goto error_respond;
     }
+    else if ((w->flags & FLUX_KVS_WATCH_FULL))
+        nsm->ctx->lookups_skipped++;
     return;
 error_respond:
     if (!w->mute) {
@@ -687,9 +897,16 @@ finished:
  */
 static void watcher_respond_ns (struct ns_monitor *nsm)
 {
+    struct watch_ctx *ctx = nsm->ctx;
     zlist_t *l;
     struct watcher *w;
 
+    /* N.B. if ctx->shares cannot be created, lookups are simply not
+     * shared.  'nsm' may be destroyed by the last watcher_respond(),
+     * so only 'ctx' is accessed after the loop.
+     */
+    if (!ctx->shares)
+        ctx->shares = zhash_new ();
     if ((l = zlist_dup (nsm->watchers))) {
         w = zlist_first (l);
         while (w) {
@@ -699,77 +916,28 @@ static void watcher_respond_ns (struct ns_monitor *nsm)
         zlist_destroy (&l);
     }
     else
-        flux_log_error (nsm->ctx->h, "%s: zlist_dup", __FUNCTION__);
+        flux_log_error (ctx->h, "%s: zlist_dup", __FUNCTION__);
+    zhash_destroy (&ctx->shares);
 }
 
-/* Cancel watcher 'w' if it matches (sender, matchtag).
- * matchtag=FLUX_MATCHTAG_NONE matches any matchtag.
+/* Cancel all watchers whose request came from the sender of 'msg',
+ * and if matchtag is not FLUX_MATCHTAG_NONE, had that matchtag.
  * If 'mute' is true, suppress response (e.g. for disconnect handling).
- */
-static void watcher_cancel (struct ns_monitor *nsm, struct watcher *w,
-                            const char *sender, uint32_t matchtag,
-                            bool mute)
-{
-    uint32_t t;
-    char *s;
-
-    if (matchtag != FLUX_MATCHTAG_NONE
-            && (flux_msg_get_matchtag (w->request, &t) < 0 || matchtag != t))
-        return;
-    if (flux_msg_get_route_first (w->request, &s) < 0)
-        return;
-    if (!strcmp (sender, s)) {
-        w->cancelled = true;
-        w->mute = mute;
-        watcher_respond (nsm, w);
-    }
-    free (s);
-}
-
-/* Cancel all namespace watchers that match (sender, matchtag).
- * If 'mute' is true, suppress response.
- */
-static void watcher_cancel_ns (struct ns_monitor *nsm,
-                               const char *sender, uint32_t matchtag,
-                               bool mute)
-{
-    zlist_t *l;
-    struct watcher *w;
-
-    if ((l = zlist_dup (nsm->watchers))) {
-        w = zlist_first (l);
-        while (w) {
-            watcher_cancel (nsm, w, sender, matchtag, mute);
-            w = zlist_next (l);
-        }
-        zlist_destroy (&l);
-    }
-    else
-        flux_log_error (nsm->ctx->h, "%s: zlist_dup", __FUNCTION__);
-}
-
-/* Cancel all watchers that match (sender, matchtag).
- * If 'mute' is true, suppress response.
+ * N.B. a cancelled watcher is dropped from ctx->requests immediately,
+ * though it may linger on nsm->watchers until its lookups complete.
  */
 static void watcher_cancel_all (struct watch_ctx *ctx,
-                                const char *sender, uint32_t matchtag,
+                                const flux_msg_t *msg,
+                                uint32_t matchtag,
                                 bool mute)
 {
-    zlist_t *l;
-    char *name;
-    struct ns_monitor *nsm;
+    struct watcher *w;
 
-    if ((l = zhash_keys (ctx->namespaces))) {
-        name = zlist_first (l);
-        while (name) {
-            nsm = zhash_lookup (ctx->namespaces, name);
-            watcher_cancel_ns (nsm, sender, matchtag, mute);
-            name = zlist_next (l);
-        }
-        zlist_destroy (&l);
+    while ((w = flux_msglist_pop_sender (ctx->requests, msg, matchtag))) {
+        w->cancelled = true;
+        w->mute = mute;
+        watcher_respond (w->nsm, w);
     }
-    else
-        flux_log_error (ctx->h, "%s: zhash_keys", __FUNCTION__);
 }
 
 /* kvs.namespace-removed-* event
@@ -981,12 +1149,19 @@ static void lookup_cb (flux_t *h, flux_msg_handler_t *mh,
      */
     if (!(w = watcher_create (msg, key, flags)))
         goto error;
-    w->nsm = nsm;
     if (zlist_append (nsm->watchers, w) < 0) {
         watcher_destroy (w);
         errno = ENOMEM;
         goto error;
     }
+    w->nsm = nsm;
+    if (flux_msglist_append (ctx->requests, msg, w) < 0) {
+        int saved_errno = errno;
+        zlist_remove (nsm->watchers, w);
+        watcher_destroy (w);
+        errno = saved_errno;
+        goto error;
+    }
     if (nsm->commit)
         watcher_respond (nsm, w);
     return;
@@ -1006,18 +1181,12 @@ static void cancel_cb (flux_t *h, flux_msg_handler_t *mh,
 {
     struct watch_ctx *ctx = arg;
     uint32_t matchtag;
-    char *sender;
 
     if (flux_request_unpack (msg, NULL, "{s:i}", "matchtag", &matchtag) < 0) {
         flux_log_error (h, "%s: flux_request_unpack", __FUNCTION__);
         return;
     }
-    if (flux_msg_get_route_first (msg, &sender) < 0) {
-        flux_log_error (h, "%s: flux_msg_get_route_first", __FUNCTION__);
-        return;
-    }
-    watcher_cancel_all (ctx, sender, matchtag, false);
-    free (sender);
+    watcher_cancel_all (ctx, msg, matchtag, false);
 }
 
 /* kvs-watch.disconnect request
@@ -1028,18 +1197,12 @@ static void disconnect_cb (flux_t *h, flux_msg_handler_t *mh,
                            const flux_msg_t *msg, void *arg)
 {
     struct watch_ctx *ctx = arg;
-    char *sender;
 
     if (flux_request_decode (msg, NULL, NULL) < 0) {
         flux_log_error (h, "%s: flux_request_decode", __FUNCTION__);
         return;
     }
-    if (flux_msg_get_route_first (msg, &sender) < 0) {
-        flux_log_error (h, "%s: flux_msg_get_route_first", __FUNCTION__);
-        return;
-    }
-    watcher_cancel_all (ctx, sender, FLUX_MATCHTAG_NONE, true);
-    free (sender);
+    watcher_cancel_all (ctx, msg, FLUX_MATCHTAG_NONE, true);
 }
 
 /* kvs-watch.stats.get request
@@ -1072,9 +1235,16 @@ static void stats_cb (flux_t *h, flux_msg_handler_t *mh,
         watchers += zlist_size (nsm->watchers);
         nsm = zhash_next (ctx->namespaces);
     }
-    if (flux_respond_pack (h, msg, "{s:i s:i s:O}",
+    if (flux_respond_pack (h, msg, "{s:i s:i s:i s:i s:i s:f s:O}",
                            "watchers", watchers,
                            "namespace-count", (int)zhash_size (ctx->namespaces),
+                           "lookups", ctx->lookups,
+                           "lookups-shared", ctx->lookups_shared,
+                           "lookups-skipped", ctx->lookups_skipped,
+                           "lookup-dedup-ratio",
+                           ctx->lookups > 0 ?
+                               (double)(ctx->lookups + ctx->lookups_shared)
+                                   / ctx->lookups : 1.,
                            "namespaces", stats) < 0)
         flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
     json_decref (stats);
@@ -1131,6 +1301,7 @@ static void watch_ctx_destroy (struct watch_ctx *ctx)
     if (ctx) {
         int saved_errno = errno;
         zhash_destroy (&ctx->namespaces);
+        flux_msglist_destroy (ctx->requests);
         flux_msg_handler_delvec (ctx->handlers);
         free (ctx);
         errno = saved_errno;
@@ -1145,7 +1316,8 @@ static struct watch_ctx *watch_ctx_create (flux_t *h)
     ctx->h = h;
     if (flux_msg_handler_addvec (h, htab, ctx, &ctx->handlers) < 0)
         goto error;
-    if (!(ctx->namespaces = zhash_new ()))
+    if (!(ctx->namespaces = zhash_new ())
+        || !(ctx->requests = flux_msglist_create ()))
         goto error;
     return ctx;
 error:
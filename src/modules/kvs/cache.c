@@ -47,13 +47,26 @@ struct cache_entry {
                              * set, don't use data == NULL as test, as
                              * zero length data can be valid */
     bool dirty;
+    bool ephemeral;         /* not in the content store */
     int errnum;
     char *blobref;
     int refcount;
+    struct cache *cache;    /* cache containing entry, if inserted */
+    struct cache_entry *lru_prev;
+    struct cache_entry *lru_next;
 };
 
+/* Entries are kept on an LRU list, most recently used at the head,
+ * so cache_shrink() can evict from the tail in constant time per entry.
+ * 'size' is the sum of the data lengths of valid entries.
+ */
 struct cache {
     zhashx_t *zhx;
+    struct cache_entry *lru_head;
+    struct cache_entry *lru_tail;
+    size_t size;
+    size_t max_size;
+    struct cache_counters counters;
 };
 
 struct cache_entry *cache_entry_create (const char *ref)
@@ -123,6 +136,17 @@ int cache_entry_clear_dirty (struct cache_entry *entry)
     return -1;
 }
 
+bool cache_entry_get_ephemeral (struct cache_entry *entry)
+{
+    return (entry && entry->ephemeral);
+}
+
+void cache_entry_set_ephemeral (struct cache_entry *entry, bool val)
+{
+    if (entry)
+        entry->ephemeral = val;
+}
+
 int cache_entry_force_clear_dirty (struct cache_entry *entry)
 {
     if (entry && entry->valid) {
@@ -146,7 +170,7 @@ void cache_entry_incref (struct cache_entry *entry)
 
 void cache_entry_decref (struct cache_entry *entry)
 {
-    if (entry)
+    if (entry && entry->refcount > 0)
         entry->refcount--;
 }
 
@@ -188,12 +212,16 @@ int cache_entry_set_raw (struct cache_entry *entry, const void *data, int len)
     entry->data = cpy;
     entry->len = len;
     entry->valid = true;
+    if (entry->cache)
+        entry->cache->size += len;
     if (entry->waitlist_valid) {
         if (wait_runqueue (entry->waitlist_valid) < 0)
             goto reset_invalid;
     }
     return 0;
 reset_invalid:
+    if (entry->cache)
+        entry->cache->size -= len;
     free (entry->data);
     entry->data = NULL;
     entry->len = 0;
@@ -299,12 +327,77 @@ int cache_entry_wait_valid (struct cache_entry *entry, wait_t *wait)
     return 0;
 }
 
+static void lru_unlink (struct cache *cache, struct cache_entry *entry)
+{
+    if (entry->lru_prev)
+        entry->lru_prev->lru_next = entry->lru_next;
+    else
+        cache->lru_head = entry->lru_next;
+    if (entry->lru_next)
+        entry->lru_next->lru_prev = entry->lru_prev;
+    else
+        cache->lru_tail = entry->lru_prev;
+    entry->lru_prev = entry->lru_next = NULL;
+}
+
+static void lru_push (struct cache *cache, struct cache_entry *entry)
+{
+    entry->lru_prev = NULL;
+    entry->lru_next = cache->lru_head;
+    if (cache->lru_head)
+        cache->lru_head->lru_prev = entry;
+    else
+        cache->lru_tail = entry;
+    cache->lru_head = entry;
+}
+
+/* Unlink entry from the LRU list and size accounting, then
+ * delete it from the hash, which destroys it.
+ */
+static void cache_delete (struct cache *cache, struct cache_entry *entry)
+{
+    lru_unlink (cache, entry);
+    if (entry->valid)
+        cache->size -= entry->len;
+    entry->cache = NULL;
+    zhashx_delete (cache->zhx, entry->blobref);
+}
+
+static bool cache_entry_has_waiters (struct cache_entry *entry)
+{
+    return ((entry->waitlist_notdirty
+             && wait_queue_length (entry->waitlist_notdirty))
+            || (entry->waitlist_valid
+                && wait_queue_length (entry->waitlist_valid)));
+}
+
+/* An entry may be dropped from the cache only if it holds valid data
+ * that is safely in the content store and nobody is using or awaiting it.
+ */
+static bool cache_entry_evictable (struct cache_entry *entry)
+{
+    return (entry->valid
+            && !entry->dirty
+            && !entry->refcount
+            && !cache_entry_has_waiters (entry));
+}
+
 struct cache_entry *cache_lookup (struct cache *cache, const char *ref,
                                   int current_epoch)
 {
     struct cache_entry *entry = zhashx_lookup (cache->zhx, ref);
-    if (entry && current_epoch > entry->lastuse_epoch)
-        entry->lastuse_epoch = current_epoch;
+    if (entry) {
+        if (current_epoch > entry->lastuse_epoch)
+            entry->lastuse_epoch = current_epoch;
+        if (entry != cache->lru_head) {
+            lru_unlink (cache, entry);
+            lru_push (cache, entry);
+        }
+    }
+    if (entry && entry->valid)
+        cache->counters.hits++;
+    else
+        cache->counters.misses++;
     return entry;
 }
 
@@ -315,6 +408,10 @@ int cache_insert (struct cache *cache, struct cache_entry *entry)
     if (cache && entry) {
         rc = zhashx_insert (cache->zhx, entry->blobref, entry);
         assert (rc == 0);
+        entry->cache = cache;
+        if (entry->valid)
+            cache->size += entry->len;
+        lru_push (cache, entry);
     }
     return 0;
 }
@@ -325,11 +422,8 @@ int cache_remove_entry (struct cache *cache, const char *ref)
 
     if (entry
         && !entry->dirty
-        && (!entry->waitlist_notdirty
-            || !wait_queue_length (entry->waitlist_notdirty))
-        && (!entry->waitlist_valid
-            || !wait_queue_length (entry->waitlist_valid))) {
-        zhashx_delete (cache->zhx, ref);
+        && !cache_entry_has_waiters (entry)) {
+        cache_delete (cache, entry);
         return 1;
     }
     return 0;
@@ -370,15 +464,93 @@ int cache_expire_entries (struct cache *cache, int current_epoch, int thresh)
             && !entry->refcount
             && (thresh == 0
                 || cache_entry_age (entry, current_epoch) > thresh)) {
-                zhashx_delete (cache->zhx, ref);
+                cache_delete (cache, entry);
                 count++;
         }
         ref = zlistx_next (keys);
     }
     zlistx_destroy (&keys);
+    cache->counters.evictions += count;
     return count;
 }
 
+void cache_set_max_size (struct cache *cache, size_t max_size)
+{
+    if (cache)
+        cache->max_size = max_size;
+}
+
+size_t cache_get_size (struct cache *cache)
+{
+    return cache ? cache->size : 0;
+}
+
+int cache_shrink (struct cache *cache, int current_epoch)
+{
+    struct cache_entry *entry;
+    int count = 0;
+
+    if (!cache) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (cache->max_size == 0)
+        return 0;
+    entry = cache->lru_tail;
+    while (entry && cache->size > cache->max_size) {
+        struct cache_entry *prev = entry->lru_prev;
+        if (cache_entry_evictable (entry)
+            && cache_entry_age (entry, current_epoch) > 0) {
+            cache_delete (cache, entry);
+            count++;
+        }
+        entry = prev;
+    }
+    cache->counters.evictions += count;
+    return count;
+}
+
+json_t *cache_get_blobrefs (struct cache *cache)
+{
+    struct cache_entry *entry;
+    json_t *a;
+
+    if (!cache) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(a = json_array ()))
+        goto nomem;
+    entry = cache->lru_head;
+    while (entry) {
+        if (entry->valid && !entry->dirty && !entry->ephemeral) {
+            json_t *o = json_string (entry->blobref);
+            if (!o || json_array_append_new (a, o) < 0) {
+                json_decref (o);
+                json_decref (a);
+                goto nomem;
+            }
+        }
+        entry = entry->lru_next;
+    }
+    return a;
+nomem:
+    errno = ENOMEM;
+    return NULL;
+}
+
+void cache_get_counters (struct cache *cache, struct cache_counters *cp)
+{
+    if (cache && cp)
+        *cp = cache->counters;
+}
+
+void cache_clear_counters (struct cache *cache)
+{
+    if (cache)
+        memset (&cache->counters, 0, sizeof (cache->counters));
+}
+
 int cache_get_stats (struct cache *cache, tstat_t *ts, int *sizep,
                      int *incompletep, int *dirtyp)
 {
@@ -19,6 +19,12 @@
 struct cache_entry;
 struct cache;
 
+struct cache_counters {
+    unsigned long hits;     /* lookups that found valid data */
+    unsigned long misses;   /* lookups that found nothing or a pending load */
+    unsigned long evictions;
+};
+
 
 /* Create/destroy cache entry.
  *
@@ -59,6 +65,14 @@ int cache_entry_set_dirty (struct cache_entry *entry, bool val);
 int cache_entry_clear_dirty (struct cache_entry *entry);
 int cache_entry_force_clear_dirty (struct cache_entry *entry);
 
+/* Get/set cache entry's ephemeral bit.
+ * The ephemeral bit indicates that the entry's data was created for an
+ * ephemeral namespace and has not been written to the content store,
+ * so the entry holds the only copy of it.
+ */
+bool cache_entry_get_ephemeral (struct cache_entry *entry);
+void cache_entry_set_ephemeral (struct cache_entry *entry, bool val);
+
 /* take/remove reference on the cache entry.  Useful if you are using
  * data from cache_entry_get_raw() or cache_entry_get_treeobj() and do
  * not want the cache entry to accidentally expire.
@@ -116,7 +130,7 @@ void cache_destroy (struct cache *cache);
 
 /* Look up a cache entry.
  * Update the entry's "last used" time to 'current_epoch',
- * taking care not to not run backwards.
+ * taking care not to not run backwards, and mark it most recently used.
  */
 struct cache_entry *cache_lookup (struct cache *cache,
                                   const char *ref, int current_epoch);
@@ -143,6 +157,33 @@ int cache_count_entries (struct cache *cache);
  */
 int cache_expire_entries (struct cache *cache, int current_epoch, int thresh);
 
+/* Set a target for the total size in bytes of cached data (0 = unlimited).
+ * cache_shrink() evicts valid, clean, unreferenced entries with no waiters
+ * in least recently used order until the total is at or below the target.
+ * Entries used in 'current_epoch' are not evicted, so that a request
+ * restarted after a load can always make progress.  Entries that cannot
+ * be evicted are skipped, so the target may be exceeded.
+ * Returns -1 on error, evicted count on success.
+ */
+void cache_set_max_size (struct cache *cache, size_t max_size);
+int cache_shrink (struct cache *cache, int current_epoch);
+
+/* Return the total size in bytes of valid cached data.
+ */
+size_t cache_get_size (struct cache *cache);
+
+/* Return a JSON array of the blobrefs of entries holding valid data that
+ * is in the content store, that is, clean and not ephemeral, most recently
+ * used first.  A reloaded kvs module uses this to rebuild its cache.
+ * Returns NULL on error with errno set.
+ */
+json_t *cache_get_blobrefs (struct cache *cache);
+
+/* Get/clear lookup and eviction counters.
+ */
+void cache_get_counters (struct cache *cache, struct cache_counters *cp);
+void cache_clear_counters (struct cache *cache);
+
 /* Obtain statistics on the cache.
  * Returns -1 on error, 0 on success
  */
@@ -0,0 +1,206 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <czmq.h>
+#include <jansson.h>
+
+#include "src/common/libkvs/treeobj.h"
+
+#include "ephemeral.h"
+
+struct hold {
+    int count;
+    bool dir;                   /* blob is a treeobj dir (or dirshard) */
+    bool held;                  /* a cache entry reference was taken */
+};
+
+struct ephemeral {
+    struct cache *cache;
+    zhashx_t *holds;            /* blobref => struct hold */
+};
+
+static int hold_ref (struct ephemeral *eph, const char *ref, bool dir,
+                     int current_epoch);
+static void release_ref (struct ephemeral *eph, const char *ref,
+                         int current_epoch);
+
+static void hold_destroy (void **item)
+{
+    if (item && *item) {
+        free (*item);
+        *item = NULL;
+    }
+}
+
+/* Call hold_ref() (if 'hold' is true) or release_ref() on each blob
+ * that treeobj 'obj' refers to, including those of the dirs in it.
+ */
+static int visit_treeobj (struct ephemeral *eph, const json_t *obj,
+                          bool hold, int current_epoch)
+{
+    int count, i;
+
+    if (treeobj_is_dirref (obj) || treeobj_is_valref (obj)) {
+        bool dir = treeobj_is_dirref (obj);
+        if ((count = treeobj_get_count (obj)) < 0)
+            return -1;
+        for (i = 0; i < count; i++) {
+            const char *ref = treeobj_get_blobref (obj, i);
+            if (!ref)
+                return -1;
+            if (!hold)
+                release_ref (eph, ref, current_epoch);
+            else if (hold_ref (eph, ref, dir, current_epoch) < 0)
+                return -1;
+        }
+    }
+    else if (treeobj_is_dir (obj)) {
+        json_t *data = treeobj_get_data ((json_t *)obj);
+        const char *name;
+        json_t *entry;
+
+        json_object_foreach (data, name, entry) {
+            if (visit_treeobj (eph, entry, hold, current_epoch) < 0)
+                return -1;
+        }
+    }
+    else if (treeobj_is_dirshard (obj)) {
+        for (i = 0; i < TREEOBJ_DIRSHARD_WIDTH; i++) {
+            const json_t *shard = treeobj_peek_shard (obj, i);
+            if (shard && visit_treeobj (eph, shard, hold, current_epoch) < 0)
+                return -1;
+        }
+    }
+    return 0;
+}
+
+static int hold_ref (struct ephemeral *eph, const char *ref, bool dir,
+                     int current_epoch)
+{
+    struct hold *h;
+    struct cache_entry *entry;
+
+    if ((h = zhashx_lookup (eph->holds, ref))) {
+        h->count++;
+        return 0;
+    }
+    if (!(h = calloc (1, sizeof (*h))))
+        return -1;
+    h->count = 1;
+    h->dir = dir;
+    if (zhashx_insert (eph->holds, ref, h) < 0) {
+        free (h);
+        errno = ENOMEM;
+        return -1;
+    }
+    if ((entry = cache_lookup (eph->cache, ref, current_epoch))
+        && cache_entry_get_valid (entry)) {
+        cache_entry_incref (entry);
+        h->held = true;
+        if (dir) {
+            const json_t *o;
+            if (!(o = cache_entry_get_treeobj (entry)))
+                return -1;
+            if (visit_treeobj (eph, o, true, current_epoch) < 0)
+                return -1;
+        }
+    }
+    return 0;
+}
+
+static void release_ref (struct ephemeral *eph, const char *ref,
+                         int current_epoch)
+{
+    struct hold *h;
+    struct cache_entry *entry;
+
+    if (!(h = zhashx_lookup (eph->holds, ref)) || --h->count > 0)
+        return;
+    if (h->held && (entry = cache_lookup (eph->cache, ref, current_epoch))) {
+        const json_t *o;
+        if (h->dir && (o = cache_entry_get_treeobj (entry)))
+            (void)visit_treeobj (eph, o, false, current_epoch);
+        cache_entry_decref (entry);
+    }
+    zhashx_delete (eph->holds, ref);
+}
+
+int ephemeral_hold (struct ephemeral *eph, const char *ref, int current_epoch)
+{
+    if (!eph || !ref) {
+        errno = EINVAL;
+        return -1;
+    }
+    return hold_ref (eph, ref, true, current_epoch);
+}
+
+void ephemeral_release (struct ephemeral *eph, const char *ref,
+                        int current_epoch)
+{
+    if (eph && ref)
+        release_ref (eph, ref, current_epoch);
+}
+
+int ephemeral_count (struct ephemeral *eph)
+{
+    return eph ? zhashx_size (eph->holds) : 0;
+}
+
+void ephemeral_destroy (struct ephemeral *eph)
+{
+    if (eph) {
+        int saved_errno = errno;
+        struct hold *h;
+
+        h = eph->holds ? zhashx_first (eph->holds) : NULL;
+        while (h) {
+            struct cache_entry *entry;
+            if (h->held
+                && (entry = cache_lookup (eph->cache,
+                                          zhashx_cursor (eph->holds),
+                                          0)))
+                cache_entry_decref (entry);
+            h = zhashx_next (eph->holds);
+        }
+        zhashx_destroy (&eph->holds);
+        free (eph);
+        errno = saved_errno;
+    }
+}
+
+struct ephemeral *ephemeral_create (struct cache *cache)
+{
+    struct ephemeral *eph;
+
+    if (!cache) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(eph = calloc (1, sizeof (*eph))))
+        return NULL;
+    eph->cache = cache;
+    if (!(eph->holds = zhashx_new ())) {
+        ephemeral_destroy (eph);
+        errno = ENOMEM;
+        return NULL;
+    }
+    zhashx_set_destructor (eph->holds, hold_destroy);
+    return eph;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,52 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _FLUX_KVS_EPHEMERAL_H
+#define _FLUX_KVS_EPHEMERAL_H
+
+#include "cache.h"
+
+/* The data of an ephemeral namespace is not written to the content
+ * store, so the cache entries of its current tree must not expire.
+ * struct ephemeral holds a cache entry reference on each blob that is
+ * reachable from the roots it was given, counting how many times each
+ * blob is referenced from held roots and the dirs below them.  Holding
+ * a new root and then releasing the old one only visits the blobs that
+ * changed between them.
+ */
+struct ephemeral;
+
+struct ephemeral *ephemeral_create (struct cache *cache);
+
+/* Releases everything still held.  The cache must not be destroyed yet.
+ */
+void ephemeral_destroy (struct ephemeral *eph);
+
+/* Hold the tree of the root dir 'ref' in the cache.  Blobs that are not
+ * in the cache are counted, but not followed, as they would have come
+ * from the content store.  Returns 0 on success, -1 on error with errno
+ * set, in which case part of the tree may not be held.
+ */
+int ephemeral_hold (struct ephemeral *eph, const char *ref, int current_epoch);
+
+/* Release a root dir held by ephemeral_hold().
+ */
+void ephemeral_release (struct ephemeral *eph, const char *ref,
+                        int current_epoch);
+
+/* Return the number of distinct blobs held.
+ */
+int ephemeral_count (struct ephemeral *eph);
+
+#endif /* !_FLUX_KVS_EPHEMERAL_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
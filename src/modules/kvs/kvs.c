@@ -39,6 +39,7 @@
 #include "kvstxn.h"
 #include "kvsroot.h"
 #include "kvssync.h"
+#include "ephemeral.h"
 
 /* Expire cache_entry after 'max_lastuse_age' heartbeats.
  */
@@ -55,10 +56,36 @@ const int max_namespace_age = 1000;
  */
 const bool event_includes_rootdir = true;
 
+/* Store directories with more than 'default_dirshard_threshold' entries
+ * as dirshards, unless overridden with the dirshard-threshold option.
+ */
+const int default_dirshard_threshold = 4096;
+
+/* Merge appends into a key's last blob while it is smaller than
+ * 'default_append_blob_size' bytes, unless overridden with the
+ * append-blob-size option (0 disables).
+ */
+const int default_append_blob_size = 4096;
+
+/* Keep the results of up to 'default_lookup_cache_size' recent lookups,
+ * unless overridden with the lookup-cache-size option (0 disables).
+ */
+const int default_lookup_cache_size = 1024;
+
+/* Coalesce the setroot events of a namespace over 'setroot_window'
+ * seconds, unless overridden with the setroot-window option.  With 0,
+ * only transactions finished in the same reactor loop iteration share
+ * an event.
+ */
+const double default_setroot_window = 0.;
+
 typedef struct {
     struct cache *cache;    /* blobref => cache_entry */
     kvsroot_mgr_t *krm;
     int faults;                 /* for kvs.stats.get, etc. */
+    int handoff_loads;          /* objects prefetched after reload */
+    struct lookup_stats lookup_stats;
+    struct lookup_cache *lookup_cache;
     flux_t *h;
     uint32_t rank;
     int epoch;              /* tracks current heartbeat epoch */
@@ -66,7 +93,15 @@ typedef struct {
     flux_watcher_t *idle_w;
     flux_watcher_t *check_w;
     int transaction_merge;
+    int transaction_pipeline;
+    bool treeobj_binary;         /* store dirs in binary treeobj encoding */
+    int dirshard_threshold;      /* shard dirs with more entries, 0=never */
+    int append_blob_size;        /* merge appends into blobs, 0=never */
     bool events_init;            /* flag */
+    zlist_t *store_group;        /* dirty entries of all namespaces */
+    double setroot_window;       /* coalesce setroot events, seconds */
+    flux_watcher_t *setroot_w;   /* timer for setroot_window */
+    bool setroot_armed;          /* setroot_w is running */
     const char *hash_name;
     unsigned int seq;           /* for commit transactions */
 } kvs_ctx_t;
@@ -78,13 +113,19 @@ struct kvs_cb_data {
     int errnum;
     bool ready;
     char *sender;
+    zlist_t *refs;              /* missing refs to load in one batch */
+    zlist_t *entries;           /* dirty cache entries to store in one batch */
 };
 
 static void transaction_prep_cb (flux_reactor_t *r, flux_watcher_t *w,
                                  int revents, void *arg);
 static void transaction_check_cb (flux_reactor_t *r, flux_watcher_t *w,
                                   int revents, void *arg);
+static void setroot_timer_cb (flux_reactor_t *r, flux_watcher_t *w,
+                              int revents, void *arg);
 static void start_root_remove (kvs_ctx_t *ctx, const char *ns);
+static int error_event_send_to_name (kvs_ctx_t *ctx, const char *ns,
+                                     const char *name, int errnum);
 
 /*
  * kvs_ctx_t functions
@@ -93,11 +134,15 @@ static void freectx (void *arg)
 {
     kvs_ctx_t *ctx = arg;
     if (ctx) {
-        cache_destroy (ctx->cache);
+        /* roots of ephemeral namespaces hold cache entries */
         kvsroot_mgr_destroy (ctx->krm);
+        cache_destroy (ctx->cache);
+        lookup_cache_destroy (ctx->lookup_cache);
         flux_watcher_destroy (ctx->prep_w);
         flux_watcher_destroy (ctx->check_w);
         flux_watcher_destroy (ctx->idle_w);
+        flux_watcher_destroy (ctx->setroot_w);
+        zlist_destroy (&ctx->store_group);
         free (ctx);
     }
 }
@@ -127,35 +172,57 @@ static kvs_ctx_t *getctx (flux_t *h)
             saved_errno = ENOMEM;
             goto error;
         }
+        if (!(ctx->lookup_cache =
+                        lookup_cache_create (default_lookup_cache_size))) {
+            saved_errno = errno;
+            goto error;
+        }
         if (!(ctx->krm = kvsroot_mgr_create (ctx->h, ctx))) {
             saved_errno = ENOMEM;
             goto error;
         }
+        if (!(ctx->store_group = zlist_new ())) {
+            saved_errno = ENOMEM;
+            goto error;
+        }
         ctx->h = h;
         if (flux_get_rank (h, &ctx->rank) < 0) {
             saved_errno = errno;
             goto error;
         }
-        if (ctx->rank == 0) {
-            ctx->prep_w = flux_prepare_watcher_create (r, transaction_prep_cb, ctx);
-            if (!ctx->prep_w) {
-                saved_errno = errno;
-                goto error;
-            }
-            ctx->check_w = flux_check_watcher_create (r, transaction_check_cb, ctx);
-            if (!ctx->check_w) {
-                saved_errno = errno;
-                goto error;
-            }
-            ctx->idle_w = flux_idle_watcher_create (r, NULL, NULL);
-            if (!ctx->idle_w) {
-                saved_errno = errno;
-                goto error;
-            }
-            flux_watcher_start (ctx->prep_w);
-            flux_watcher_start (ctx->check_w);
+        /* Any rank may own a namespace and apply its transactions.
+         */
+        ctx->prep_w = flux_prepare_watcher_create (r, transaction_prep_cb, ctx);
+        if (!ctx->prep_w) {
+            saved_errno = errno;
+            goto error;
         }
+        ctx->check_w = flux_check_watcher_create (r, transaction_check_cb, ctx);
+        if (!ctx->check_w) {
+            saved_errno = errno;
+            goto error;
+        }
+        ctx->idle_w = flux_idle_watcher_create (r, NULL, NULL);
+        if (!ctx->idle_w) {
+            saved_errno = errno;
+            goto error;
+        }
+        ctx->setroot_w = flux_timer_watcher_create (r,
+                                                    0.,
+                                                    0.,
+                                                    setroot_timer_cb,
+                                                    ctx);
+        if (!ctx->setroot_w) {
+            saved_errno = errno;
+            goto error;
+        }
+        flux_watcher_start (ctx->prep_w);
+        flux_watcher_start (ctx->check_w);
         ctx->transaction_merge = 1;
+        ctx->transaction_pipeline = 1;
+        ctx->dirshard_threshold = default_dirshard_threshold;
+        ctx->append_blob_size = default_append_blob_size;
+        ctx->setroot_window = default_setroot_window;
         if (flux_aux_set (h, "kvssrv", ctx, freectx) < 0) {
             saved_errno = errno;
             goto error;
@@ -281,15 +348,77 @@ static int check_user (kvs_ctx_t *ctx, struct kvsroot *root,
     return kvsroot_check_user (ctx->krm, root, cred);
 }
 
+/* A namespace is owned by one rank (rank 0 unless placed elsewhere at
+ * creation), which applies all of its transactions and publishes its
+ * setroot events.  Other ranks relay commits and fences to the owner.
+ */
+static bool owns_root (kvs_ctx_t *ctx, struct kvsroot *root)
+{
+    return root->rank == ctx->rank;
+}
+
+/* The data of an ephemeral namespace is kept in the cache of its owner
+ * rank instead of in the content store.  Other ranks load it from the
+ * owner.
+ */
+static bool is_ephemeral (struct kvsroot *root)
+{
+    return (root->flags & FLUX_KVS_NAMESPACE_EPHEMERAL) ? true : false;
+}
+
+static bool load_from_owner (kvs_ctx_t *ctx, struct kvsroot *root)
+{
+    return root && is_ephemeral (root) && !owns_root (ctx, root);
+}
+
 /*
  * set/get root
  */
 
+/* Apply module options to the kvstxn manager of a new root.
+ */
+static void configure_kvstxn_mgr (kvs_ctx_t *ctx, struct kvsroot *root)
+{
+    kvstxn_mgr_t *ktm = root->ktm;
+
+    kvstxn_mgr_set_treeobj_binary (ktm, ctx->treeobj_binary);
+    kvstxn_mgr_set_dirshard_threshold (ktm, ctx->dirshard_threshold);
+    kvstxn_mgr_set_pipeline (ktm, ctx->transaction_pipeline ? true : false);
+    kvstxn_mgr_set_append_blob_size (ktm, ctx->append_blob_size);
+    kvstxn_mgr_set_ephemeral (ktm, is_ephemeral (root));
+}
+
+/* On the owner of an ephemeral namespace, hold the tree of the new root
+ * in the cache and release the old one.
+ */
+static void ephemeral_setroot (kvs_ctx_t *ctx, struct kvsroot *root,
+                               const char *rootref, int rootseq)
+{
+    char oldref[BLOBREF_MAX_STRING_SIZE];
+
+    if (!root->ephemeral && !(root->ephemeral = ephemeral_create (ctx->cache)))
+        goto error;
+    strcpy (oldref, root->ref);
+    if (ephemeral_hold (root->ephemeral, rootref, ctx->epoch) < 0)
+        goto error;
+    kvsroot_setroot (ctx->krm, root, rootref, rootseq);
+    if (strlen (oldref) > 0)
+        ephemeral_release (root->ephemeral, oldref, ctx->epoch);
+    return;
+error:
+    flux_log_error (ctx->h, "%s: namespace %s data may be evicted",
+                    __FUNCTION__, root->ns_name);
+    kvsroot_setroot (ctx->krm, root, rootref, rootseq);
+}
+
 static void setroot (kvs_ctx_t *ctx, struct kvsroot *root,
                      const char *rootref, int rootseq)
 {
     if (rootseq == 0 || rootseq > root->seq) {
-        kvsroot_setroot (ctx->krm, root, rootref, rootseq);
+        if (is_ephemeral (root) && owns_root (ctx, root))
+            ephemeral_setroot (ctx, root, rootref, rootseq);
+        else
+            kvsroot_setroot (ctx->krm, root, rootref, rootseq);
         kvssync_process (root, false);
         root->last_update_epoch = ctx->epoch;
     }
@@ -302,6 +431,7 @@ static void getroot_completion (flux_future_t *f, void *arg)
     const char *ns;
     int rootseq, flags;
     uint32_t owner;
+    uint32_t rank = 0;
     const char *ref;
     struct kvsroot *root;
     int save_errno;
@@ -315,12 +445,13 @@ static void getroot_completion (flux_future_t *f, void *arg)
         goto error;
     }
 
-    /* N.B. owner read into uint32_t */
-    if (flux_rpc_get_unpack (f, "{ s:i s:i s:s s:i }",
+    /* N.B. owner and rank read into uint32_t */
+    if (flux_rpc_get_unpack (f, "{ s:i s:i s:s s:i s?i }",
                              "owner", &owner,
                              "rootseq", &rootseq,
                              "rootref", &ref,
-                             "flags", &flags) < 0) {
+                             "flags", &flags,
+                             "rank", &rank) < 0) {
         if (errno != ENOTSUP)
             flux_log_error (ctx->h, "%s: flux_rpc_get_unpack", __FUNCTION__);
         goto error;
@@ -339,6 +470,8 @@ static void getroot_completion (flux_future_t *f, void *arg)
             flux_log_error (ctx->h, "%s: kvsroot_mgr_create_root", __FUNCTION__);
             goto error;
         }
+        configure_kvstxn_mgr (ctx, root);
+        root->rank = rank;
 
         if (event_subscribe (ctx, ns) < 0) {
             save_errno = errno;
@@ -365,7 +498,20 @@ static void getroot_completion (flux_future_t *f, void *arg)
     return;
 
 error:
-    if (flux_respond_error (ctx->h, msg, errno, NULL) < 0)
+    /* kvs.relaycommit and kvs.relayfence have no response, errors
+     * are returned to the original senders via an error event.
+     */
+    if (flux_msg_is_noresponse (msg)) {
+        const char *name;
+        int saved_errno = errno;
+        if (flux_request_unpack (msg, NULL, "{ s:s s:s }",
+                                 "namespace", &ns,
+                                 "name", &name) < 0
+            || error_event_send_to_name (ctx, ns, name, saved_errno) < 0)
+            flux_log_error (ctx->h, "%s: error_event_send_to_name",
+                            __FUNCTION__);
+    }
+    else if (flux_respond_error (ctx->h, msg, errno, NULL) < 0)
         flux_log_error (ctx->h, "%s: flux_respond_error", __FUNCTION__);
     flux_msg_destroy (msg);
     flux_future_destroy (f);
@@ -468,16 +614,17 @@ static void content_load_cache_entry_error (kvs_ctx_t *ctx,
         flux_log (ctx->h, LOG_ERR, "%s: cache_remove_entry", __FUNCTION__);
 }
 
-static void content_load_completion (flux_future_t *f, void *arg)
+/* Finish the load of 'blobref', which returned 'rc' (errno set on
+ * failure), and 'size' bytes of 'data' on success.
+ */
+static void content_load_finish (kvs_ctx_t *ctx,
+                                 const char *blobref,
+                                 int rc,
+                                 const void *data,
+                                 int size)
 {
-    kvs_ctx_t *ctx = arg;
-    const void *data;
-    int size;
-    const char *blobref;
     struct cache_entry *entry;
 
-    blobref = flux_future_aux_get (f, "ref");
-
     /* should be impossible for lookup to fail, cache entry created
      * earlier, and cache_expire_entries() could not have removed it
      * b/c it is not yet valid.  But check and log incase there is
@@ -485,13 +632,12 @@ static void content_load_completion (flux_future_t *f, void *arg)
      */
     if (!(entry = cache_lookup (ctx->cache, blobref, ctx->epoch))) {
         flux_log (ctx->h, LOG_ERR, "%s: cache_lookup", __FUNCTION__);
-        goto done;
+        return;
     }
 
-    if (flux_content_load_get (f, &data, &size) < 0) {
-        flux_log_error (ctx->h, "%s: flux_content_load_get", __FUNCTION__);
+    if (rc < 0) {
         content_load_cache_entry_error (ctx, entry, errno, blobref);
-        goto done;
+        return;
     }
 
     /* If cache_entry_set_raw() fails, it's a pretty terrible error
@@ -501,10 +647,46 @@ static void content_load_completion (flux_future_t *f, void *arg)
     if (cache_entry_set_raw (entry, data, size) < 0) {
         flux_log_error (ctx->h, "%s: cache_entry_set_raw", __FUNCTION__);
         content_load_cache_entry_error (ctx, entry, errno, blobref);
-        goto done;
+        return;
     }
 
-done:
+    if (cache_shrink (ctx->cache, ctx->epoch) < 0)
+        flux_log_error (ctx->h, "%s: cache_shrink", __FUNCTION__);
+}
+
+static void content_load_completion (flux_future_t *f, void *arg)
+{
+    kvs_ctx_t *ctx = arg;
+    const void *data = NULL;
+    int size = 0;
+    int rc;
+
+    if ((rc = flux_content_load_get (f, &data, &size)) < 0)
+        flux_log_error (ctx->h, "%s: flux_content_load_get", __FUNCTION__);
+    content_load_finish (ctx, flux_future_aux_get (f, "ref"), rc, data, size);
+    flux_future_destroy (f);
+}
+
+static void content_load_batch_completion (flux_future_t *f, void *arg)
+{
+    kvs_ctx_t *ctx = arg;
+    zlist_t *refs = flux_future_aux_get (f, "refs");
+    const char *ref;
+    const void *data;
+    int size;
+    int index = 0;
+    int rc;
+
+    ref = zlist_first (refs);
+    while (ref) {
+        data = NULL;
+        size = 0;
+        if ((rc = flux_content_load_batch_get (f, index++, &data, &size)) < 0)
+            flux_log_error (ctx->h, "%s: flux_content_load_batch_get",
+                            __FUNCTION__);
+        content_load_finish (ctx, ref, rc, data, size);
+        ref = zlist_next (refs);
+    }
     flux_future_destroy (f);
 }
 
@@ -541,40 +723,162 @@ error:
     return -1;
 }
 
-/* Return 0 on success, -1 on error.  Set stall variable appropriately
+static void ephemeral_load_completion (flux_future_t *f, void *arg)
+{
+    kvs_ctx_t *ctx = arg;
+    const char *ref = flux_future_aux_get (f, "ref");
+    struct cache_entry *entry;
+    const void *data = NULL;
+    int size = 0;
+    int rc;
+
+    if ((rc = flux_rpc_get_raw (f, &data, &size)) < 0) {
+        /* Not ephemeral data after all, e.g. a dirref copied in from
+         * another namespace, so it is in the content store.
+         */
+        if (errno == ENOENT && content_load_request_send (ctx, ref) == 0)
+            goto done;
+        flux_log_error (ctx->h, "%s: flux_rpc_get_raw", __FUNCTION__);
+    }
+    else if ((entry = cache_lookup (ctx->cache, ref, ctx->epoch)))
+        cache_entry_set_ephemeral (entry, true);
+    content_load_finish (ctx, ref, rc, data, size);
+done:
+    flux_future_destroy (f);
+}
+
+/* Send an ephemeral load request for 'ref' to the owner of 'root',
+ * falling back to the content store if the owner does not have it.
  */
-static int load (kvs_ctx_t *ctx, const char *ref, wait_t *wait, bool *stall)
+static int ephemeral_load_request_send (kvs_ctx_t *ctx,
+                                        struct kvsroot *root,
+                                        const char *ref)
 {
-    struct cache_entry *entry = cache_lookup (ctx->cache, ref, ctx->epoch);
+    flux_future_t *f = NULL;
+    char *refcpy;
+    int saved_errno;
+
+    if (!(f = flux_rpc_pack (ctx->h, "kvs.ephemeral-load", root->rank, 0,
+                             "{ s:s }",
+                             "blobref", ref))) {
+        flux_log_error (ctx->h, "%s: flux_rpc_pack", __FUNCTION__);
+        goto error;
+    }
+    if (!(refcpy = strdup (ref))) {
+        errno = ENOMEM;
+        goto error;
+    }
+    if (flux_future_aux_set (f, "ref", refcpy, free) < 0) {
+        flux_log_error (ctx->h, "%s: flux_future_aux_set", __FUNCTION__);
+        free (refcpy);
+        goto error;
+    }
+    if (flux_future_then (f, -1., ephemeral_load_completion, ctx) < 0) {
+        flux_log_error (ctx->h, "%s: flux_future_then", __FUNCTION__);
+        goto error;
+    }
+    return 0;
+error:
+    saved_errno = errno;
+    flux_future_destroy (f);
+    errno = saved_errno;
+    return -1;
+}
+
+static void zlist_destroy_wrapper (void *arg)
+{
+    zlist_t *l = arg;
+    zlist_destroy (&l);
+}
+
+/* Send one content.load-batch request for 'refs', taking ownership of
+ * 'refs' on success.
+ */
+static int content_load_batch_request_send (kvs_ctx_t *ctx, zlist_t *refs)
+{
+    flux_future_t *f = NULL;
+    const char **blobrefs;
+    const char *ref;
+    int count = 0;
+    int saved_errno;
+
+    if (!(blobrefs = calloc (zlist_size (refs), sizeof (blobrefs[0]))))
+        return -1;
+    ref = zlist_first (refs);
+    while (ref) {
+        blobrefs[count++] = ref;
+        ref = zlist_next (refs);
+    }
+    if (!(f = flux_content_load_batch (ctx->h, blobrefs, count, 0))) {
+        flux_log_error (ctx->h, "%s: flux_content_load_batch", __FUNCTION__);
+        goto error;
+    }
+    if (flux_future_then (f, -1., content_load_batch_completion, ctx) < 0) {
+        flux_log_error (ctx->h, "%s: flux_future_then", __FUNCTION__);
+        goto error;
+    }
+    if (flux_future_aux_set (f, "refs", refs, zlist_destroy_wrapper) < 0) {
+        flux_log_error (ctx->h, "%s: flux_future_aux_set", __FUNCTION__);
+        goto error;
+    }
+    free (blobrefs);
+    return 0;
+error:
+    saved_errno = errno;
+    flux_future_destroy (f);
+    free (blobrefs);
+    errno = saved_errno;
+    return -1;
+}
+
+/* Create an incomplete cache entry for 'ref' and start loading it.
+ * 'root' is the namespace 'ref' is loaded for, if known.
+ */
+static struct cache_entry *load_start (kvs_ctx_t *ctx,
+                                       struct kvsroot *root,
+                                       const char *ref)
+{
+    struct cache_entry *entry;
     int saved_errno, ret;
 
+    if (!(entry = cache_entry_create (ref))) {
+        flux_log_error (ctx->h, "%s: cache_entry_create",
+                        __FUNCTION__);
+        return NULL;
+    }
+    if (cache_insert (ctx->cache, entry) < 0) {
+        flux_log_error (ctx->h, "%s: cache_insert",
+                        __FUNCTION__);
+        cache_entry_destroy (entry);
+        return NULL;
+    }
+    if ((load_from_owner (ctx, root)
+            ? ephemeral_load_request_send (ctx, root, ref)
+            : content_load_request_send (ctx, ref)) < 0) {
+        saved_errno = errno;
+        flux_log_error (ctx->h, "%s: load request", __FUNCTION__);
+        /* cache entry just created, should always work */
+        ret = cache_remove_entry (ctx->cache, ref);
+        assert (ret == 1);
+        errno = saved_errno;
+        return NULL;
+    }
+    ctx->faults++;
+    return entry;
+}
+
+static int load (kvs_ctx_t *ctx, struct kvsroot *root, const char *ref,
+                 wait_t *wait, bool *stall)
+{
+    struct cache_entry *entry = cache_lookup (ctx->cache, ref, ctx->epoch);
+
     assert (wait != NULL);
 
     /* Create an incomplete hash entry if none found.
      */
     if (!entry) {
-        if (!(entry = cache_entry_create (ref))) {
-            flux_log_error (ctx->h, "%s: cache_entry_create",
-                            __FUNCTION__);
-            return -1;
-        }
-        if (cache_insert (ctx->cache, entry) < 0) {
-            flux_log_error (ctx->h, "%s: cache_insert",
-                            __FUNCTION__);
-            cache_entry_destroy (entry);
-            return -1;
-        }
-        if (content_load_request_send (ctx, ref) < 0) {
-            saved_errno = errno;
-            flux_log_error (ctx->h, "%s: content_load_request_send",
-                            __FUNCTION__);
-            /* cache entry just created, should always work */
-            ret = cache_remove_entry (ctx->cache, ref);
-            assert (ret == 1);
-            errno = saved_errno;
+        if (!(entry = load_start (ctx, root, ref)))
             return -1;
-        }
-        ctx->faults++;
     }
     /* If hash entry is incomplete (either created above or earlier),
      * arrange to stall caller.
@@ -605,24 +909,150 @@ static int load (kvs_ctx_t *ctx, const char *ref, wait_t *wait, bool *stall)
     return 0;
 }
 
+/* Add 'ref' to the refs that load_batch() will load for 'cbd'.
+ */
+static int load_collect (struct kvs_cb_data *cbd, const char *ref)
+{
+    if (!cbd->refs) {
+        if (!(cbd->refs = zlist_new ()))
+            goto nomem;
+        zlist_autofree (cbd->refs);
+    }
+    if (zlist_append (cbd->refs, (char *)ref) < 0)
+        goto nomem;
+    return 0;
+nomem:
+    cbd->errnum = ENOMEM;
+    errno = ENOMEM;
+    return -1;
+}
+
+/* Like load() for each ref collected with load_collect(), except that
+ * the refs not yet in the cache are requested with a single
+ * content.load-batch RPC.  The caller always stalls on cbd->wait.
+ * Return 0 on success, -1 on error with cbd->errnum set.
+ */
+static int load_batch (struct kvs_cb_data *cbd)
+{
+    kvs_ctx_t *ctx = cbd->ctx;
+    zlist_t *missing = NULL;
+    struct cache_entry *entry;
+    const char *ref;
+    int count;
+    int ret;
+
+    if (!cbd->refs)
+        return 0;
+    if (!(missing = zlist_new ())) {
+        errno = ENOMEM;
+        goto error;
+    }
+    zlist_autofree (missing);
+
+    /* Create an incomplete hash entry for each ref not found.
+     */
+    ref = zlist_first (cbd->refs);
+    while (ref) {
+        if (!cache_lookup (ctx->cache, ref, ctx->epoch)) {
+            if (!(entry = cache_entry_create (ref))) {
+                flux_log_error (ctx->h, "%s: cache_entry_create",
+                                __FUNCTION__);
+                goto error;
+            }
+            if (cache_insert (ctx->cache, entry) < 0) {
+                flux_log_error (ctx->h, "%s: cache_insert", __FUNCTION__);
+                cache_entry_destroy (entry);
+                goto error;
+            }
+            if (zlist_append (missing, (char *)ref) < 0) {
+                ret = cache_remove_entry (ctx->cache, ref);
+                assert (ret == 1);
+                errno = ENOMEM;
+                goto error;
+            }
+        }
+        ref = zlist_next (cbd->refs);
+    }
+    if (load_from_owner (ctx, cbd->root)) {
+        /* the owner serves ephemeral data from its cache, one at a time */
+        count = 0;
+        ref = zlist_first (missing);
+        while (ref) {
+            if (ephemeral_load_request_send (ctx, cbd->root, ref) < 0)
+                break;
+            (void)zlist_pop (missing);
+            free ((char *)ref);
+            count++;
+            ref = zlist_first (missing);
+        }
+        if (ref)
+            goto error;
+    }
+    else if ((count = zlist_size (missing)) == 1) {
+        if (content_load_request_send (ctx, zlist_first (missing)) < 0)
+            goto error;
+    }
+    else if (count > 1) {
+        if (content_load_batch_request_send (ctx, missing) < 0)
+            goto error;
+        missing = NULL; // owned by the future now
+    }
+    zlist_destroy (&missing);
+    ctx->faults += count;
+
+    /* Arrange to stall caller on each incomplete entry.
+     */
+    ref = zlist_first (cbd->refs);
+    while (ref) {
+        if ((entry = cache_lookup (ctx->cache, ref, ctx->epoch))
+            && !cache_entry_get_valid (entry)) {
+            /* no cleanup in this path, the rpc will complete, but not
+             * call a waiter on this load.
+             */
+            if (cache_entry_wait_valid (entry, cbd->wait) < 0) {
+                flux_log_error (ctx->h, "cache_entry_wait_valid");
+                cbd->errnum = errno;
+                return -1;
+            }
+        }
+        ref = zlist_next (cbd->refs);
+    }
+    return 0;
+error:
+    cbd->errnum = errno;
+    if (missing) {
+        /* cache entries just created, with no waiters, should always work */
+        ref = zlist_first (missing);
+        while (ref) {
+            ret = cache_remove_entry (ctx->cache, ref);
+            assert (ret == 1);
+            ref = zlist_next (missing);
+        }
+        zlist_destroy (&missing);
+    }
+    errno = cbd->errnum;
+    return -1;
+}
+
 /*
  * store/write
  */
 
-static void content_store_completion (flux_future_t *f, void *arg)
+/* Finish the store of the cache entry for 'cache_blobref', which
+ * returned 'rc' (errno set on failure), and 'blobref' on success.
+ */
+static void content_store_finish (kvs_ctx_t *ctx,
+                                  const char *cache_blobref,
+                                  int rc,
+                                  const char *blobref)
 {
-    kvs_ctx_t *ctx = arg;
     struct cache_entry *entry;
-    const char *cache_blobref, *blobref;
     int ret;
 
-    cache_blobref = flux_future_aux_get (f, "cache_blobref");
     assert (cache_blobref);
 
-    if (flux_content_store_get (f, &blobref) < 0) {
-        flux_log_error (ctx->h, "%s: flux_content_store_get", __FUNCTION__);
+    if (rc < 0)
         goto error;
-    }
 
     /* Double check that content store stored in the same blobref
      * location we calculated.
@@ -658,13 +1088,13 @@ static void content_store_completion (flux_future_t *f, void *arg)
                         __FUNCTION__);
         goto error;
     }
+    cache_entry_set_ephemeral (entry, false);
 
-    flux_future_destroy (f);
+    if (cache_shrink (ctx->cache, ctx->epoch) < 0)
+        flux_log_error (ctx->h, "%s: cache_shrink", __FUNCTION__);
     return;
 
 error:
-    flux_future_destroy (f);
-
     /* failure on store, inform all waiters, must destroy entry
      * afterwards, as future loads/stores may believe content is ok.
      * cache_remove_entry() will not work if a waiter is still there.
@@ -696,10 +1126,107 @@ error:
     ret = cache_entry_force_clear_dirty (entry);
     assert (ret == 0);
 
+    /* ephemeral data is still valid, and may be referenced by an
+     * ephemeral namespace
+     */
+    if (cache_entry_get_ephemeral (entry))
+        return;
+
     if (cache_remove_entry (ctx->cache, cache_blobref) < 0)
         flux_log (ctx->h, LOG_ERR, "%s: cache_remove_entry", __FUNCTION__);
 }
 
+static void content_store_completion (flux_future_t *f, void *arg)
+{
+    kvs_ctx_t *ctx = arg;
+    const char *blobref = NULL;
+    int rc;
+
+    if ((rc = flux_content_store_get (f, &blobref)) < 0)
+        flux_log_error (ctx->h, "%s: flux_content_store_get", __FUNCTION__);
+    content_store_finish (ctx,
+                          flux_future_aux_get (f, "cache_blobref"),
+                          rc,
+                          blobref);
+    flux_future_destroy (f);
+}
+
+static void content_store_batch_completion (flux_future_t *f, void *arg)
+{
+    kvs_ctx_t *ctx = arg;
+    zlist_t *cache_blobrefs = flux_future_aux_get (f, "cache_blobrefs");
+    const char *cache_blobref;
+    const char *blobref;
+    int index = 0;
+    int rc;
+
+    cache_blobref = zlist_first (cache_blobrefs);
+    while (cache_blobref) {
+        blobref = NULL;
+        if ((rc = flux_content_store_batch_get (f, index++, &blobref)) < 0)
+            flux_log_error (ctx->h, "%s: flux_content_store_batch_get",
+                            __FUNCTION__);
+        content_store_finish (ctx, cache_blobref, rc, blobref);
+        cache_blobref = zlist_next (cache_blobrefs);
+    }
+    flux_future_destroy (f);
+}
+
+/* Send one content.store-batch request for the dirty cache 'entries'.
+ * The blobrefs are owned by the entries, which cannot be expired while
+ * dirty.
+ */
+static int content_store_batch_request_send (kvs_ctx_t *ctx,
+                                             zlist_t *entries)
+{
+    flux_future_t *f = NULL;
+    zlist_t *cache_blobrefs = NULL;
+    struct cache_entry *entry;
+    const void **bufs;
+    int *lens;
+    int count = 0;
+    int saved_errno;
+
+    bufs = calloc (zlist_size (entries), sizeof (bufs[0]));
+    lens = calloc (zlist_size (entries), sizeof (lens[0]));
+    if (!bufs || !lens || !(cache_blobrefs = zlist_new ())) {
+        errno = ENOMEM;
+        goto error;
+    }
+    entry = zlist_first (entries);
+    while (entry) {
+        if (cache_entry_get_raw (entry, &bufs[count], &lens[count]) < 0)
+            goto error;
+        if (zlist_append (cache_blobrefs,
+                          (char *)cache_entry_get_blobref (entry)) < 0) {
+            errno = ENOMEM;
+            goto error;
+        }
+        count++;
+        entry = zlist_next (entries);
+    }
+    if (!(f = flux_content_store_batch (ctx->h, bufs, lens, count, 0)))
+        goto error;
+    if (flux_future_then (f, -1., content_store_batch_completion, ctx) < 0)
+        goto error;
+    if (flux_future_aux_set (f,
+                             "cache_blobrefs",
+                             cache_blobrefs,
+                             zlist_destroy_wrapper) < 0)
+        goto error;
+    free (bufs);
+    free (lens);
+    return 0;
+error:
+    saved_errno = errno;
+    flux_future_destroy (f);
+    zlist_destroy (&cache_blobrefs);
+    free (bufs);
+    free (lens);
+    errno = saved_errno;
+    return -1;
+}
+
 static int content_store_request_send (kvs_ctx_t *ctx, const char *blobref,
                                        const void *data, int len)
 {
@@ -729,58 +1256,137 @@ error:
 static int kvstxn_load_cb (kvstxn_t *kt, const char *ref, void *data)
 {
     struct kvs_cb_data *cbd = data;
-    bool stall;
 
-    if (load (cbd->ctx, ref, cbd->wait, &stall) < 0) {
-        cbd->errnum = errno;
-        flux_log_error (cbd->ctx->h, "%s: load", __FUNCTION__);
+    if (load_collect (cbd, ref) < 0) {
+        flux_log_error (cbd->ctx->h, "%s: load_collect", __FUNCTION__);
         return -1;
     }
-    /* if not stalling, logic issue within code */
-    assert (stall);
     return 0;
 }
 
-/* Flush to content cache asynchronously and push wait onto cache
- * object's wait queue.
+/* Collect dirty cache entries for store_batch().
  */
 static int kvstxn_cache_cb (kvstxn_t *kt, struct cache_entry *entry, void *data)
 {
     struct kvs_cb_data *cbd = data;
-    const char *blobref;
-    const void *storedata;
-    int storedatalen = 0;
 
     assert (cache_entry_get_dirty (entry));
 
-    if (cache_entry_get_raw (entry, &storedata, &storedatalen) < 0) {
-        flux_log_error (cbd->ctx->h, "%s: cache_entry_get_raw",
-                        __FUNCTION__);
+    /* must be true, otherwise we didn't insert entry in cache */
+    assert (cache_entry_get_blobref (entry));
+
+    if ((!cbd->entries && !(cbd->entries = zlist_new ()))
+        || zlist_append (cbd->entries, entry) < 0) {
+        cbd->errnum = ENOMEM;
+        flux_log (cbd->ctx->h, LOG_ERR, "%s: out of memory", __FUNCTION__);
         kvstxn_cleanup_dirty_cache_entry (kt, entry);
+        errno = ENOMEM;
         return -1;
     }
+    return 0;
+}
 
-    /* must be true, otherwise we didn't insert entry in cache */
-    blobref = cache_entry_get_blobref (entry);
-    assert (blobref);
-
-    if (content_store_request_send (cbd->ctx,
-                                    blobref,
-                                    storedata,
-                                    storedatalen) < 0) {
-        cbd->errnum = errno;
-        flux_log_error (cbd->ctx->h, "%s: content_store_request_send",
-                        __FUNCTION__);
-        kvstxn_cleanup_dirty_cache_entry (kt, entry);
+/* Keep a dirty cache entry of an ephemeral namespace in the cache
+ * instead of storing it.
+ */
+static int ephemeral_cache_cb (kvstxn_t *kt, struct cache_entry *entry,
+                               void *data)
+{
+    kvs_ctx_t *ctx = data;
+
+    cache_entry_set_ephemeral (entry, true);
+    if (cache_entry_set_dirty (entry, false) < 0) {
+        flux_log_error (ctx->h, "%s: cache_entry_set_dirty", __FUNCTION__);
         return -1;
     }
-    if (cache_entry_wait_notdirty (entry, cbd->wait) < 0) {
-        cbd->errnum = errno;
-        flux_log_error (cbd->ctx->h, "cache_entry_wait_notdirty");
+    return 0;
+}
+
+static void cleanup_dirty_cache_entries (kvstxn_t *kt, zlist_t *entries)
+{
+    struct cache_entry *entry;
+
+    while ((entry = zlist_pop (entries)))
         kvstxn_cleanup_dirty_cache_entry (kt, entry);
-        return -1;
+}
+
+/* Add the entries collected by kvstxn_cache_cb() to the store group,
+ * and push wait onto each cache object's wait queue.  The group is
+ * flushed by store_group_flush() once per reactor loop iteration, so
+ * transactions of all namespaces that are ready at the same time share
+ * one content store pass.  Return 0 on success, -1 on error with
+ * cbd->errnum set.
+ */
+static int store_batch (struct kvs_cb_data *cbd, kvstxn_t *kt)
+{
+    kvs_ctx_t *ctx = cbd->ctx;
+    struct cache_entry *entry;
+
+    while (cbd->entries && (entry = zlist_pop (cbd->entries))) {
+        if (zlist_append (ctx->store_group, entry) < 0) {
+            flux_log (ctx->h, LOG_ERR, "%s: out of memory", __FUNCTION__);
+            kvstxn_cleanup_dirty_cache_entry (kt, entry);
+            errno = ENOMEM;
+            goto error;
+        }
+        if (cache_entry_wait_notdirty (entry, cbd->wait) < 0) {
+            flux_log_error (ctx->h, "cache_entry_wait_notdirty");
+            zlist_remove (ctx->store_group, entry);
+            kvstxn_cleanup_dirty_cache_entry (kt, entry);
+            goto error;
+        }
     }
     return 0;
+error:
+    cbd->errnum = errno;
+    if (cbd->entries)
+        cleanup_dirty_cache_entries (kt, cbd->entries);
+    errno = cbd->errnum;
+    return -1;
+}
+
+/* Store the entries of the store group with one content.store or
+ * content.store-batch RPC.  If the request cannot be sent, the stores
+ * are failed as if the RPC had failed, so waiters see the error.
+ */
+static void store_group_flush (kvs_ctx_t *ctx)
+{
+    struct cache_entry *entry;
+    int count = zlist_size (ctx->store_group);
+    int rc = 0;
+    int saved_errno;
+
+    if (count == 1) {
+        const void *storedata;
+        int storedatalen = 0;
+
+        entry = zlist_first (ctx->store_group);
+        if (cache_entry_get_raw (entry, &storedata, &storedatalen) < 0
+            || content_store_request_send (ctx,
+                                           cache_entry_get_blobref (entry),
+                                           storedata,
+                                           storedatalen) < 0) {
+            flux_log_error (ctx->h, "%s: content_store_request_send",
+                            __FUNCTION__);
+            rc = -1;
+        }
+    }
+    else if (count > 1) {
+        if (content_store_batch_request_send (ctx, ctx->store_group) < 0) {
+            flux_log_error (ctx->h, "%s: content_store_batch_request_send",
+                            __FUNCTION__);
+            rc = -1;
+        }
+    }
+    if (rc < 0) {
+        saved_errno = errno;
+        while ((entry = zlist_pop (ctx->store_group))) {
+            errno = saved_errno;
+            content_store_finish (ctx, cache_entry_get_blobref (entry),
+                                  -1, NULL);
+        }
+    }
+    zlist_purge (ctx->store_group);
 }
 
 static void flux_msg_destroy_wrapper (void *arg)
@@ -798,14 +1404,14 @@ static int setroot_event_send (kvs_ctx_t *ctx, struct kvsroot *root,
     char *setroot_topic = NULL;
     int saved_errno, rc = -1;
 
-    assert (ctx->rank == 0);
+    assert (owns_root (ctx, root));
 
     if (event_includes_rootdir) {
         struct cache_entry *entry;
 
         if ((entry = cache_lookup (ctx->cache, root->ref, ctx->epoch)))
             root_dir = cache_entry_get_treeobj (entry);
-        assert (root_dir != NULL); // root entry is always in cache on rank 0
+        assert (root_dir != NULL); // root entry is always in cache on owner
     }
     else {
         if (!(nullobj = json_null ())) {
@@ -853,6 +1459,96 @@ done:
     return rc;
 }
 
+/* Send the setroot event for the transactions queued on 'root' by
+ * setroot_event_queue(), if any.  The event carries the current root,
+ * so followers skip the roots in between.
+ */
+static void setroot_event_flush (kvs_ctx_t *ctx, struct kvsroot *root)
+{
+    json_t *keys;
+    const char *key;
+    json_t *value;
+
+    if (!root->setroot_names)
+        return;
+    if (!(keys = json_array ())) {
+        flux_log (ctx->h, LOG_ERR, "%s: out of memory", __FUNCTION__);
+        goto done;
+    }
+    json_object_foreach (root->setroot_keys, key, value) {
+        if (json_array_append_new (keys, json_string (key)) < 0) {
+            flux_log (ctx->h, LOG_ERR, "%s: out of memory", __FUNCTION__);
+            goto done;
+        }
+    }
+    if (setroot_event_send (ctx, root, root->setroot_names, keys) < 0)
+        flux_log_error (ctx->h, "%s: setroot_event_send", __FUNCTION__);
+done:
+    json_decref (keys);
+    json_decref (root->setroot_names);
+    json_decref (root->setroot_keys);
+    root->setroot_names = NULL;
+    root->setroot_keys = NULL;
+}
+
+static int setroot_event_flush_cb (struct kvsroot *root, void *arg)
+{
+    setroot_event_flush (arg, root);
+    return 0;
+}
+
+static void setroot_event_flush_all (kvs_ctx_t *ctx)
+{
+    if (kvsroot_mgr_iter_roots (ctx->krm, setroot_event_flush_cb, ctx) < 0)
+        flux_log_error (ctx->h, "%s: kvsroot_mgr_iter_roots", __FUNCTION__);
+}
+
+static void setroot_timer_cb (flux_reactor_t *r, flux_watcher_t *w,
+                              int revents, void *arg)
+{
+    kvs_ctx_t *ctx = arg;
+
+    ctx->setroot_armed = false;
+    setroot_event_flush_all (ctx);
+}
+
+/* Queue the setroot event for the finished transactions 'names', which
+ * changed 'keys', to be sent with those of other transactions of
+ * 'root' that finish within the setroot window.  If the event cannot
+ * be queued, send what is queued and this one right away.
+ */
+static void setroot_event_queue (kvs_ctx_t *ctx, struct kvsroot *root,
+                                 json_t *names, json_t *keys)
+{
+    size_t index;
+    json_t *value;
+
+    if (!root->setroot_names) {
+        if (!(root->setroot_names = json_array ())
+            || !(root->setroot_keys = json_object ()))
+            goto nomem;
+    }
+    if (json_array_extend (root->setroot_names, names) < 0)
+        goto nomem;
+    json_array_foreach (keys, index, value) {
+        if (json_object_set (root->setroot_keys,
+                             json_string_value (value),
+                             json_true ()) < 0)
+            goto nomem;
+    }
+    if (ctx->setroot_window > 0. && !ctx->setroot_armed) {
+        flux_timer_watcher_reset (ctx->setroot_w, ctx->setroot_window, 0.);
+        flux_watcher_start (ctx->setroot_w);
+        ctx->setroot_armed = true;
+    }
+    return;
+nomem:
+    flux_log (ctx->h, LOG_ERR, "%s: out of memory", __FUNCTION__);
+    setroot_event_flush (ctx, root);
+    if (setroot_event_send (ctx, root, names, keys) < 0)
+        flux_log_error (ctx->h, "%s: setroot_event_send", __FUNCTION__);
+}
+
 static int error_event_send (kvs_ctx_t *ctx, const char *ns,
                              json_t *names, int errnum)
 {
@@ -954,6 +1650,7 @@ static void kvstxn_apply (kvstxn_t *kt)
     if ((errnum = kvstxn_get_aux_errnum (kt)))
         goto done;
 
+process:
     if ((ret = kvstxn_process (kt,
                                ctx->epoch,
                                root->ref)) == KVSTXN_PROCESS_ERROR) {
@@ -973,10 +1670,14 @@ static void kvstxn_apply (kvstxn_t *kt)
             goto done;
 
         cbd.ctx = ctx;
+        cbd.root = root;
         cbd.wait = wait;
         cbd.errnum = 0;
+        cbd.refs = NULL;
 
-        if (kvstxn_iter_missing_refs (kt, kvstxn_load_cb, &cbd) < 0) {
+        if (kvstxn_iter_missing_refs (kt, kvstxn_load_cb, &cbd) < 0
+            || load_batch (&cbd) < 0) {
+            zlist_destroy (&cbd.refs);
             errnum = cbd.errnum;
 
             /* rpcs already in flight, stall for them to complete */
@@ -987,10 +1688,19 @@ static void kvstxn_apply (kvstxn_t *kt)
 
             goto done;
         }
+        zlist_destroy (&cbd.refs);
 
         assert (wait_get_usecount (wait) > 0);
         goto stall;
     }
+    else if (ret == KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES && is_ephemeral (root)) {
+        /* nothing to wait for, the data stays in the cache */
+        if (kvstxn_iter_dirty_cache_entries (kt, ephemeral_cache_cb, ctx) < 0) {
+            errnum = errno;
+            goto done;
+        }
+        goto process;
+    }
     else if (ret == KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES) {
         struct kvs_cb_data cbd;
 
@@ -1005,8 +1715,18 @@ static void kvstxn_apply (kvstxn_t *kt)
         cbd.ctx = ctx;
         cbd.wait = wait;
         cbd.errnum = 0;
+        cbd.entries = NULL;
 
         if (kvstxn_iter_dirty_cache_entries (kt, kvstxn_cache_cb, &cbd) < 0) {
+            cbd.errnum = errno;
+            if (cbd.entries)
+                cleanup_dirty_cache_entries (kt, cbd.entries);
+        }
+        else
+            (void)store_batch (&cbd, kt);
+        zlist_destroy (&cbd.entries);
+
+        if (cbd.errnum) {
             errnum = cbd.errnum;
 
             /* rpcs already in flight, stall for them to complete */
@@ -1021,6 +1741,11 @@ static void kvstxn_apply (kvstxn_t *kt)
         assert (wait_get_usecount (wait) > 0);
         goto stall;
     }
+    else if (ret == KVSTXN_PROCESS_SETROOT_PENDING) {
+        /* an earlier transaction is still being stored, replayed
+         * from transaction_check_cb() once it has finished */
+        goto stall;
+    }
     /* else ret == KVSTXN_PROCESS_FINISHED */
 
     /* This finalizes the transaction by replacing root->ref with
@@ -1038,7 +1763,7 @@ done:
                       count, opcount);
         }
         setroot (ctx, root, kvstxn_get_newroot_ref (kt), root->seq + 1);
-        setroot_event_send (ctx, root, names, kvstxn_get_keys (kt));
+        setroot_event_queue (ctx, root, names, kvstxn_get_keys (kt));
     } else {
         fallback = kvstxn_fallback_mergeable (kt);
 
@@ -1086,6 +1811,8 @@ static void transaction_prep_cb (flux_reactor_t *r, flux_watcher_t *w,
     kvs_ctx_t *ctx = arg;
     struct kvs_cb_data cbd = { .ctx = ctx, .ready = false };
 
+    flux_module_memory_set (ctx->h, cache_get_size (ctx->cache));
+
     if (kvsroot_mgr_iter_roots (ctx->krm, kvstxn_prep_root_cb, &cbd) < 0) {
         flux_log_error (ctx->h, "%s: kvsroot_mgr_iter_roots", __FUNCTION__);
         return;
@@ -1133,10 +1860,16 @@ static void transaction_check_cb (flux_reactor_t *r, flux_watcher_t *w,
 
     flux_watcher_stop (ctx->idle_w);
 
-    if (kvsroot_mgr_iter_roots (ctx->krm, kvstxn_check_root_cb, &cbd) < 0) {
+    if (kvsroot_mgr_iter_roots (ctx->krm, kvstxn_check_root_cb, &cbd) < 0)
         flux_log_error (ctx->h, "%s: kvsroot_mgr_iter_roots", __FUNCTION__);
-        return;
-    }
+
+    /* Transactions replayed from message handlers earlier in this loop
+     * iteration have added to the store group as well.
+     */
+    store_group_flush (ctx);
+
+    if (ctx->setroot_window == 0.)
+        setroot_event_flush_all (ctx);
 }
 
 /*
@@ -1194,7 +1927,7 @@ static int heartbeat_root_cb (struct kvsroot *root, void *arg)
     kvs_ctx_t *ctx = arg;
 
     if (root->remove) {
-        if (!zlist_size (root->synclist)
+        if (!kvssync_count (root)
             && !treq_mgr_transactions_count (root->trm)
             && !kvstxn_mgr_ready_transaction_count (root->ktm)) {
 
@@ -1208,14 +1941,16 @@ static int heartbeat_root_cb (struct kvsroot *root, void *arg)
         }
     }
     else if (ctx->rank != 0
+             && !owns_root (ctx, root)
              && !root->remove
              && strcasecmp (root->ns_name, KVS_PRIMARY_NAMESPACE)
              && (ctx->epoch - root->last_update_epoch) > max_namespace_age
-             && !zlist_size (root->synclist)
+             && !kvssync_count (root)
              && !treq_mgr_transactions_count (root->trm)
              && !kvstxn_mgr_ready_transaction_count (root->ktm)) {
         /* remove a root if it not the primary one, has timed out
-         * on a follower node, and it does not have any watchers,
+         * on a follower node that does not own it, and it does not
+         * have any watchers,
          * and no one is trying to write/change something.
          */
         start_root_remove (ctx, root->ns_name);
@@ -1240,22 +1975,50 @@ static void heartbeat_cb (flux_t *h, flux_msg_handler_t *mh,
     if (kvsroot_mgr_iter_roots (ctx->krm, heartbeat_root_cb, ctx) < 0)
         flux_log_error (ctx->h, "%s: kvsroot_mgr_iter_roots", __FUNCTION__);
 
-    if (cache_expire_entries (ctx->cache, ctx->epoch, max_lastuse_age) < 0)
-        flux_log_error (ctx->h, "%s: cache_expire_entries", __FUNCTION__);
+    if (cache_expire_entries (ctx->cache, ctx->epoch, max_lastuse_age) < 0)
+        flux_log_error (ctx->h, "%s: cache_expire_entries", __FUNCTION__);
+    if (cache_shrink (ctx->cache, ctx->epoch) < 0)
+        flux_log_error (ctx->h, "%s: cache_shrink", __FUNCTION__);
+}
+
+/* Cache is over the module's soft memory limit.  Expire everything
+ * that can be, rather than waiting for entries to age out.
+ */
+static void memory_shed_cb (flux_t *h, size_t usage, size_t limit, void *arg)
+{
+    kvs_ctx_t *ctx = arg;
+    int count;
+
+    if ((count = cache_expire_entries (ctx->cache, ctx->epoch, 0)) < 0) {
+        flux_log_error (h, "%s: cache_expire_entries", __FUNCTION__);
+        return;
+    }
+    flux_module_memory_set (h, cache_get_size (ctx->cache));
+    flux_log (h, LOG_DEBUG, "memory limit: expired %d cache entries", count);
 }
 
 static int lookup_load_cb (lookup_t *lh, const char *ref, void *data)
 {
     struct kvs_cb_data *cbd = data;
-    bool stall;
 
-    if (load (cbd->ctx, ref, cbd->wait, &stall) < 0) {
-        cbd->errnum = errno;
-        flux_log_error (cbd->ctx->h, "%s: load", __FUNCTION__);
+    if (load_collect (cbd, ref) < 0) {
+        flux_log_error (cbd->ctx->h, "%s: load_collect", __FUNCTION__);
         return -1;
     }
-    /* if not stalling, logic issue within code */
-    assert (stall);
+    return 0;
+}
+
+/* Start loading 'ref' with nobody waiting on it, so that a later
+ * lookup finds it in the cache.
+ */
+static int lookup_prefetch_cb (lookup_t *lh, const char *ref, void *data)
+{
+    kvs_ctx_t *ctx = data;
+
+    if (!cache_lookup (ctx->cache, ref, ctx->epoch)) {
+        if (!load_start (ctx, NULL, ref))
+            return -1;
+    }
     return 0;
 }
 
@@ -1268,6 +2031,7 @@ static void lookup_wait_error_cb (wait_t *w, int errnum, void *arg)
 static lookup_t *lookup_common (flux_t *h, flux_msg_handler_t *mh,
                                 const flux_msg_t *msg, void *arg,
                                 flux_msg_handler_f replay_cb,
+                                bool return_dirent,
                                 bool *stall)
 {
     kvs_ctx_t *ctx = arg;
@@ -1288,6 +2052,8 @@ static lookup_t *lookup_common (flux_t *h, flux_msg_handler_t *mh,
     if (!lh) {
         struct flux_msg_cred cred;
         int root_seq = -1;
+        int append_index = -1;
+        int append_offset = -1;
 
         if (flux_request_unpack (msg, NULL, "{ s:s s:i }",
                                  "key", &key,
@@ -1308,6 +2074,10 @@ static lookup_t *lookup_common (flux_t *h, flux_msg_handler_t *mh,
         (void)flux_request_unpack (msg, NULL, "{ s:i }",
                                    "rootseq", &root_seq);
 
+        /* append position is optional */
+        (void)flux_request_unpack (msg, NULL, "{ s:[ii] }",
+                                   "append", &append_index, &append_offset);
+
         /* either namespace or rootdir must be specified */
         if (!ns && !root_dirent) {
             errno = EPROTO;
@@ -1342,6 +2112,11 @@ static lookup_t *lookup_common (flux_t *h, flux_msg_handler_t *mh,
                                   flags,
                                   h)))
             goto done;
+        lookup_set_stats (lh, &ctx->lookup_stats);
+        lookup_set_result_cache (lh, ctx->lookup_cache);
+        lookup_set_return_dirent (lh, return_dirent);
+        if (append_index >= 0)
+            lookup_set_append_position (lh, append_index, append_offset);
     }
     else {
         int err;
@@ -1392,10 +2167,16 @@ static lookup_t *lookup_common (flux_t *h, flux_msg_handler_t *mh,
             goto done;
 
         cbd.ctx = ctx;
+        cbd.root = NULL;
         cbd.wait = wait;
         cbd.errnum = 0;
+        cbd.refs = NULL;
+        if ((ns = lookup_get_namespace (lh)))
+            cbd.root = kvsroot_mgr_lookup_root (ctx->krm, ns);
 
-        if (lookup_iter_missing_refs (lh, lookup_load_cb, &cbd) < 0) {
+        if (lookup_iter_missing_refs (lh, lookup_load_cb, &cbd) < 0
+            || load_batch (&cbd) < 0) {
+            zlist_destroy (&cbd.refs);
             /* rpcs already in flight, stall for them to complete */
             if (wait_get_usecount (wait) > 0) {
                 lookup_set_aux_errnum (lh, cbd.errnum);
@@ -1405,12 +2186,20 @@ static lookup_t *lookup_common (flux_t *h, flux_msg_handler_t *mh,
             errno = cbd.errnum;
             goto done;
         }
+        zlist_destroy (&cbd.refs);
 
         assert (wait_get_usecount (wait) > 0);
         goto stall;
     }
     /* else lret == LOOKUP_PROCESS_FINISHED, fallthrough */
 
+    /* A directory listing is often followed by lookups of its
+     * subdirectories, so start loading them now.  Errors are not fatal
+     * to this lookup.
+     */
+    if (lookup_iter_prefetch_refs (lh, lookup_prefetch_cb, ctx) < 0)
+        flux_log_error (h, "%s: lookup_iter_prefetch_refs", __FUNCTION__);
+
     rc = 0;
 done:
     wait_destroy (wait);
@@ -1434,7 +2223,7 @@ static void lookup_request_cb (flux_t *h, flux_msg_handler_t *mh,
     bool stall = false;
 
     if (!(lh = lookup_common (h, mh, msg, arg, lookup_request_cb,
-                              &stall))) {
+                              false, &stall))) {
         if (stall)
             return;
         goto error;
@@ -1444,7 +2233,10 @@ static void lookup_request_cb (flux_t *h, flux_msg_handler_t *mh,
         errno = ENOENT;
         goto error;
     }
-    if (flux_respond_pack (h, msg, "{ s:O }", "val", val) < 0)
+    /* rootseq lets clients cache the value until the root changes */
+    if (flux_respond_pack (h, msg, "{ s:O s:i }",
+                           "val", val,
+                           "rootseq", lookup_get_root_seq (lh)) < 0)
         flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
     lookup_destroy (lh);
     json_decref (val);
@@ -1461,6 +2253,8 @@ error:
  * kvs-watch module.  The kvs-watch module requires root information
  * on lookups (including ENOENT failed lookups) to determine what
  * lookups can be considered to be read-your-writes consistency safe.
+ * If the request has an "append" position, only the data after it is
+ * returned, along with the new end position.
  */
 static void lookup_plus_request_cb (flux_t *h, flux_msg_handler_t *mh,
                                     const flux_msg_t *msg, void *arg)
@@ -1469,10 +2263,12 @@ static void lookup_plus_request_cb (flux_t *h, flux_msg_handler_t *mh,
     json_t *val = NULL;
     const char *root_ref;
     int root_seq;
+    int symlink;
+    int index, offset;
     bool stall = false;
 
     if (!(lh = lookup_common (h, mh, msg, arg, lookup_plus_request_cb,
-                              &stall))) {
+                              false, &stall))) {
         if (stall)
             return;
         goto error;
@@ -1482,19 +2278,31 @@ static void lookup_plus_request_cb (flux_t *h, flux_msg_handler_t *mh,
     assert (root_ref);
     root_seq = lookup_get_root_seq (lh);
     assert (root_seq >= 0);
+    symlink = lookup_get_symlink_followed (lh) ? 1 : 0;
 
     if (!(val = lookup_get_value (lh))) {
-        if (flux_respond_pack (h, msg, "{ s:i s:i s:s }",
+        if (flux_respond_pack (h, msg, "{ s:i s:i s:s s:b }",
                                "errno", ENOENT,
                                "rootseq", root_seq,
-                               "rootref", root_ref) < 0)
+                               "rootref", root_ref,
+                               "symlink", symlink) < 0)
+            flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
+    }
+    else if (lookup_get_append_position (lh, &index, &offset) == 0) {
+        if (flux_respond_pack (h, msg, "{ s:O s:i s:s s:[ii] s:b }",
+                               "val", val,
+                               "rootseq", root_seq,
+                               "rootref", root_ref,
+                               "append", index, offset,
+                               "symlink", symlink) < 0)
             flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
     }
     else {
-        if (flux_respond_pack (h, msg, "{ s:O s:i s:s }",
+        if (flux_respond_pack (h, msg, "{ s:O s:i s:s s:b }",
                                "val", val,
                                "rootseq", root_seq,
-                               "rootref", root_ref) < 0)
+                               "rootref", root_ref,
+                               "symlink", symlink) < 0)
             flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
     }
     lookup_destroy (lh);
@@ -1505,6 +2313,171 @@ error:
         flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
 }
 
+/* Stream the value of a key.  Each blob of a valref is sent in its own
+ * response, in order, with no more than one blob loaded on behalf of the
+ * request at a time.  A key with an inline value gets one response.
+ * The stream is terminated by an ENODATA error response.
+ */
+struct lookup_stream {
+    json_t *dirent;
+    char *ns;           /* namespace of the lookup, if known */
+    int index;
+    int errnum;
+};
+
+static void lookup_stream_request_cb (flux_t *h, flux_msg_handler_t *mh,
+                                      const flux_msg_t *msg, void *arg);
+
+static void lookup_stream_destroy (struct lookup_stream *ls)
+{
+    if (ls) {
+        int saved_errno = errno;
+        json_decref (ls->dirent);
+        free (ls->ns);
+        free (ls);
+        errno = saved_errno;
+    }
+}
+
+static void lookup_stream_wait_error_cb (wait_t *w, int errnum, void *arg)
+{
+    struct lookup_stream *ls = arg;
+    ls->errnum = errnum;
+}
+
+/* Respond with each blob in turn, until a blob is not in the cache.
+ * Then start loading it, and stall.
+ */
+static int lookup_stream_continue (kvs_ctx_t *ctx,
+                                   flux_msg_handler_t *mh,
+                                   const flux_msg_t *msg,
+                                   struct lookup_stream *ls,
+                                   bool *stall)
+{
+    int count = treeobj_get_count (ls->dirent);
+
+    while (ls->index < count) {
+        struct cache_entry *entry;
+        const char *ref;
+        const void *data;
+        int len;
+        json_t *val;
+
+        if (!(ref = treeobj_get_blobref (ls->dirent, ls->index)))
+            return -1;
+        if (!(entry = cache_lookup (ctx->cache, ref, ctx->epoch))
+            || !cache_entry_get_valid (entry)) {
+            wait_t *wait;
+
+            if (!(wait = wait_create_msg_handler (ctx->h, mh, msg, ctx,
+                                                  lookup_stream_request_cb)))
+                return -1;
+            if (wait_set_error_cb (wait,
+                                   lookup_stream_wait_error_cb,
+                                   ls) < 0
+                || load (ctx,
+                         ls->ns ? kvsroot_mgr_lookup_root (ctx->krm, ls->ns)
+                                : NULL,
+                         ref,
+                         wait,
+                         stall) < 0) {
+                if (wait_get_usecount (wait) == 0)
+                    wait_destroy (wait);
+                return -1;
+            }
+            assert (*stall);
+            return 0;
+        }
+        if (cache_entry_get_raw (entry, &data, &len) < 0) {
+            errno = ENOTRECOVERABLE;
+            return -1;
+        }
+        if (!(val = treeobj_create_val (data, len)))
+            return -1;
+        if (flux_respond_pack (ctx->h, msg, "{ s:o }", "val", val) < 0)
+            flux_log_error (ctx->h, "%s: flux_respond_pack", __FUNCTION__);
+        ls->index++;
+    }
+    *stall = false;
+    return 0;
+}
+
+static void lookup_stream_request_cb (flux_t *h, flux_msg_handler_t *mh,
+                                      const flux_msg_t *msg, void *arg)
+{
+    kvs_ctx_t *ctx = arg;
+    struct lookup_stream *ls;
+    lookup_t *lh = NULL;
+    json_t *val = NULL;
+    char *ns = NULL;
+    bool stall = false;
+
+    /* if lookup_stream exists in msg as aux data, is a replay */
+    if (!(ls = flux_msg_aux_get (msg, "lookup_stream"))) {
+        int flags;
+
+        if (flux_request_unpack (msg, NULL, "{ s:i }", "flags", &flags) < 0)
+            goto error;
+        if (!flux_msg_is_streaming (msg) || flags != 0) {
+            errno = EPROTO;
+            goto error;
+        }
+        if (!(lh = lookup_common (h, mh, msg, arg, lookup_stream_request_cb,
+                                  true, &stall))) {
+            if (stall)
+                return;
+            goto error;
+        }
+        if (!(val = lookup_get_value (lh))) {
+            errno = ENOENT;
+            goto error;
+        }
+        if (lookup_get_namespace (lh)
+            && !(ns = strdup (lookup_get_namespace (lh))))
+            goto error;
+        lookup_destroy (lh);
+        lh = NULL;
+        if (treeobj_is_val (val)) {
+            if (flux_respond_pack (h, msg, "{ s:O }", "val", val) < 0)
+                flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
+            errno = ENODATA;
+            goto error;
+        }
+        if (!treeobj_is_valref (val)) {
+            errno = treeobj_is_symlink (val) ? EPROTO : EISDIR;
+            goto error;
+        }
+        if (!(ls = calloc (1, sizeof (*ls))))
+            goto error;
+        ls->dirent = val;
+        ls->ns = ns;
+        val = NULL;
+        ns = NULL;
+        if (flux_msg_aux_set (msg,
+                              "lookup_stream",
+                              ls,
+                              (flux_free_f)lookup_stream_destroy) < 0) {
+            lookup_stream_destroy (ls);
+            goto error;
+        }
+    }
+    if (ls->errnum) {
+        errno = ls->errnum;
+        goto error;
+    }
+    if (lookup_stream_continue (ctx, mh, msg, ls, &stall) < 0)
+        goto error;
+    if (stall)
+        return;
+    errno = ENODATA;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+    lookup_destroy (lh);
+    json_decref (val);
+    free (ns);
+}
+
 
 static int finalize_transaction_req (treq_t *tr,
                                      const flux_msg_t *req,
@@ -1554,7 +2527,7 @@ static void finalize_transaction_bynames (kvs_ctx_t *ctx, struct kvsroot *root,
     }
 }
 
-/* kvs.relaycommit (rank 0 only, no response).
+/* kvs.relaycommit (namespace owner only, no response).
  */
 static void relaycommit_request_cb (flux_t *h, flux_msg_handler_t *mh,
                                     const flux_msg_t *msg, void *arg)
@@ -1564,6 +2537,7 @@ static void relaycommit_request_cb (flux_t *h, flux_msg_handler_t *mh,
     const char *ns;
     const char *name;
     int flags;
+    bool stall = false;
     json_t *ops = NULL;
 
     if (flux_request_unpack (msg, NULL, "{ s:o s:s s:s s:i }",
@@ -1575,11 +2549,27 @@ static void relaycommit_request_cb (flux_t *h, flux_msg_handler_t *mh,
         return;
     }
 
-    /* namespace must exist given we are on rank 0 */
-    if (!(root = kvsroot_mgr_lookup_root_safe (ctx->krm, ns))) {
+    /* On rank 0 the namespace must exist.  An owner on another rank
+     * initializes its root the first time a transaction is relayed to it.
+     */
+    if (!(root = getroot (ctx,
+                          ns,
+                          mh,
+                          msg,
+                          NULL,
+                          relaycommit_request_cb,
+                          &stall))) {
+        if (stall)
+            return;
         flux_log (h, LOG_ERR, "%s: namespace %s not available",
                   __FUNCTION__, ns);
-        errno = ENOTSUP;
+        goto error;
+    }
+
+    if (!owns_root (ctx, root)) {
+        flux_log (h, LOG_ERR, "%s: namespace %s owned by rank %u",
+                  __FUNCTION__, ns, root->rank);
+        errno = EPROTO;
         goto error;
     }
 
@@ -1653,7 +2643,7 @@ static void commit_request_cb (flux_t *h, flux_msg_handler_t *mh,
     if (treq_add_request_copy (tr, msg) < 0)
         goto error;
 
-    if (ctx->rank == 0) {
+    if (owns_root (ctx, root)) {
         /* we use this flag to indicate if a treq has been added to
          * the ready queue.  We don't need to call
          * treq_count_reached() b/c this is a commit and nprocs is 1
@@ -1672,8 +2662,9 @@ static void commit_request_cb (flux_t *h, flux_msg_handler_t *mh,
     else {
         flux_future_t *f;
 
-        /* route to rank 0 as instance owner */
-        if (!(f = flux_rpc_pack (h, "kvs.relaycommit", 0, FLUX_RPC_NORESPONSE,
+        /* route to the rank that owns the namespace */
+        if (!(f = flux_rpc_pack (h, "kvs.relaycommit", root->rank,
+                                 FLUX_RPC_NORESPONSE,
                                  "{ s:O s:s s:s s:i }",
                                  "ops", ops,
                                  "name", treq_get_name (tr),
@@ -1692,7 +2683,7 @@ error:
 }
 
 
-/* kvs.relayfence (rank 0 only, no response).
+/* kvs.relayfence (namespace owner only, no response).
  */
 static void relayfence_request_cb (flux_t *h, flux_msg_handler_t *mh,
                                    const flux_msg_t *msg, void *arg)
@@ -1702,6 +2693,7 @@ static void relayfence_request_cb (flux_t *h, flux_msg_handler_t *mh,
     const char *ns;
     const char *name;
     int saved_errno, nprocs, flags;
+    bool stall = false;
     json_t *ops = NULL;
     treq_t *tr;
 
@@ -1715,11 +2707,25 @@ static void relayfence_request_cb (flux_t *h, flux_msg_handler_t *mh,
         return;
     }
 
-    /* namespace must exist given we are on rank 0 */
-    if (!(root = kvsroot_mgr_lookup_root_safe (ctx->krm, ns))) {
+    /* see comment in relaycommit_request_cb() */
+    if (!(root = getroot (ctx,
+                          ns,
+                          mh,
+                          msg,
+                          NULL,
+                          relayfence_request_cb,
+                          &stall))) {
+        if (stall)
+            return;
         flux_log (h, LOG_ERR, "%s: namespace %s not available",
                   __FUNCTION__, ns);
-        errno = ENOTSUP;
+        goto error;
+    }
+
+    if (!owns_root (ctx, root)) {
+        flux_log (h, LOG_ERR, "%s: namespace %s owned by rank %u",
+                  __FUNCTION__, ns, root->rank);
+        errno = EPROTO;
         goto error;
     }
 
@@ -1843,10 +2849,10 @@ static void fence_request_cb (flux_t *h, flux_msg_handler_t *mh,
     if (treq_add_request_copy (tr, msg) < 0)
         goto error;
 
-    /* If we happen to be on rank 0, perform equivalent of
+    /* If we happen to own the namespace, perform equivalent of
      * relayfence_request_cb() here instead of sending an RPC
      */
-    if (ctx->rank == 0) {
+    if (owns_root (ctx, root)) {
 
         if (treq_add_request_ops (tr, ops) < 0) {
             flux_log_error (h, "%s: treq_add_request_ops", __FUNCTION__);
@@ -1876,8 +2882,9 @@ static void fence_request_cb (flux_t *h, flux_msg_handler_t *mh,
     else {
         flux_future_t *f;
 
-        /* route to rank 0 as instance owner */
-        if (!(f = flux_rpc_pack (h, "kvs.relayfence", 0, FLUX_RPC_NORESPONSE,
+        /* route to the rank that owns the namespace */
+        if (!(f = flux_rpc_pack (h, "kvs.relayfence", root->rank,
+                                 FLUX_RPC_NORESPONSE,
                                  "{ s:O s:s s:s s:i s:i }",
                                  "ops", ops,
                                  "name", name,
@@ -1943,6 +2950,33 @@ error:
         flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
 }
 
+/* Respond with the cached data of 'blobref', for another rank loading
+ * data of an ephemeral namespace owned by this one.
+ */
+static void ephemeral_load_request_cb (flux_t *h, flux_msg_handler_t *mh,
+                                       const flux_msg_t *msg, void *arg)
+{
+    kvs_ctx_t *ctx = arg;
+    const char *blobref;
+    struct cache_entry *entry;
+    const void *data;
+    int len;
+
+    if (flux_request_unpack (msg, NULL, "{ s:s }", "blobref", &blobref) < 0)
+        goto error;
+    if (!(entry = cache_lookup (ctx->cache, blobref, ctx->epoch))
+        || cache_entry_get_raw (entry, &data, &len) < 0) {
+        errno = ENOENT;
+        goto error;
+    }
+    if (flux_respond_raw (h, msg, data, len) < 0)
+        flux_log_error (h, "%s: flux_respond_raw", __FUNCTION__);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+}
+
 static void getroot_request_cb (flux_t *h, flux_msg_handler_t *mh,
                                 const flux_msg_t *msg, void *arg)
 {
@@ -1980,12 +3014,13 @@ static void getroot_request_cb (flux_t *h, flux_msg_handler_t *mh,
         }
     }
 
-    /* N.B. owner cast into int */
-    if (flux_respond_pack (h, msg, "{ s:i s:i s:s s:i }",
+    /* N.B. owner and rank cast into int */
+    if (flux_respond_pack (h, msg, "{ s:i s:i s:s s:i s:i }",
                            "owner", root->owner,
                            "rootseq", root->seq,
                            "rootref", root->ref,
-                           "flags", root->flags) < 0)
+                           "flags", root->flags,
+                           "rank", root->rank) < 0)
         flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
     return;
 error:
@@ -2023,26 +3058,48 @@ static void error_event_cb (flux_t *h, flux_msg_handler_t *mh,
     finalize_transaction_bynames (ctx, root, names, errnum);
 }
 
+/* Encode directory 'rootdir' for the content store, in the encoding
+ * selected by the treeobj-encoding module option.
+ */
+static char *encode_rootdir (kvs_ctx_t *ctx, json_t *rootdir, int *lenp)
+{
+    char *data;
+    size_t len;
+
+    if (ctx->treeobj_binary) {
+        if (!(data = treeobj_encode_binary (rootdir, &len)))
+            return NULL;
+    }
+    else {
+        if (!(data = treeobj_encode (rootdir)))
+            return NULL;
+        len = strlen (data);
+    }
+    *lenp = len;
+    return data;
+}
+
 /* Optimization: the current rootdir object is optionally included
  * in the kvs.namespace-<NS>-setroot event.  Prime the local cache with it.
  * If there are complications, just skip it.  Not critical.
  */
-static void prime_cache_with_rootdir (kvs_ctx_t *ctx, json_t *rootdir)
+static void prime_cache_with_rootdir (kvs_ctx_t *ctx, json_t *rootdir,
+                                      bool ephemeral)
 {
     struct cache_entry *entry;
     char ref[BLOBREF_MAX_STRING_SIZE];
     void *data = NULL;
     int len;
 
-    if (treeobj_validate (rootdir) < 0 || !treeobj_is_dir (rootdir)) {
+    if (treeobj_validate (rootdir) < 0
+        || (!treeobj_is_dir (rootdir) && !treeobj_is_dirshard (rootdir))) {
         flux_log (ctx->h, LOG_ERR, "%s: invalid rootdir", __FUNCTION__);
         goto done;
     }
-    if (!(data = treeobj_encode (rootdir))) {
-        flux_log_error (ctx->h, "%s: treeobj_encode", __FUNCTION__);
+    if (!(data = encode_rootdir (ctx, rootdir, &len))) {
+        flux_log_error (ctx->h, "%s: encode_rootdir", __FUNCTION__);
         goto done;
     }
-    len = strlen (data);
     if (blobref_hash (ctx->hash_name, data, len, ref, sizeof (ref)) < 0) {
         flux_log_error (ctx->h, "%s: blobref_hash", __FUNCTION__);
         goto done;
@@ -2058,6 +3115,7 @@ static void prime_cache_with_rootdir (kvs_ctx_t *ctx, json_t *rootdir)
         cache_entry_destroy (entry);
         goto done;
     }
+    cache_entry_set_ephemeral (entry, ephemeral);
     if (cache_insert (ctx->cache, entry) < 0) {
         flux_log_error (ctx->h, "%s: cache_insert", __FUNCTION__);
         cache_entry_destroy (entry);
@@ -2091,7 +3149,7 @@ static void setroot_event_process (kvs_ctx_t *ctx, struct kvsroot *root,
      * demand from content cache if not in local cache.
      */
     if (!json_is_null (rootdir))
-        prime_cache_with_rootdir (ctx, rootdir);
+        prime_cache_with_rootdir (ctx, rootdir, is_ephemeral (root));
 
     setroot (ctx, root, rootref, rootseq);
 }
@@ -2205,11 +3263,15 @@ static int stats_get_root_cb (struct kvsroot *root, void *arg)
     json_t *nsstats = arg;
     json_t *s;
 
-    if (!(s = json_pack ("{ s:i s:i s:i s:i s:i }",
+    if (!(s = json_pack ("{ s:i s:i s:i s:i s:i s:i s:i }",
                          "#syncers",
-                         zlist_size (root->synclist),
+                         kvssync_count (root),
+                         "#ephemeral objs",
+                         ephemeral_count (root->ephemeral),
                          "#no-op stores",
                          kvstxn_mgr_get_noop_stores (root->ktm),
+                         "#append merges",
+                         kvstxn_mgr_get_append_merges (root->ktm),
                          "#transactions",
                          treq_mgr_transactions_count (root->trm),
                          "#readytransactions",
@@ -2229,10 +3291,12 @@ static void stats_get_cb (flux_t *h, flux_msg_handler_t *mh,
     kvs_ctx_t *ctx = arg;
     json_t *tstats = NULL;
     json_t *cstats = NULL;
+    json_t *lstats = NULL;
     json_t *nsstats = NULL;
     tstat_t ts = { .min = 0.0, .max = 0.0, .M = 0.0, .S = 0.0, .newM = 0.0,
                    .newS = 0.0, .n = 0 };
     int size = 0, incomplete = 0, dirty = 0;
+    struct cache_counters cc;
     double scale = 1E-3;
 
     if (flux_request_decode (msg, NULL, NULL) < 0)
@@ -2243,6 +3307,7 @@ static void stats_get_cb (flux_t *h, flux_msg_handler_t *mh,
         if (cache_get_stats (ctx->cache, &ts, &size, &incomplete, &dirty) < 0)
             goto error;
     }
+    cache_get_counters (ctx->cache, &cc);
 
     if (!(tstats = json_pack ("{ s:i s:f s:f s:f s:f }",
                               "count", tstat_count (&ts),
@@ -2252,12 +3317,27 @@ static void stats_get_cb (flux_t *h, flux_msg_handler_t *mh,
                               "max", tstat_max (&ts)*scale)))
         goto nomem;
 
-    if (!(cstats = json_pack ("{ s:f s:O s:i s:i s:i }",
+    if (!(cstats = json_pack ("{ s:f s:O s:i s:i s:i s:i s:I s:I s:I }",
                               "obj size total (MiB)", (double)size/1048576,
                               "obj size (KiB)", tstats,
                               "#obj dirty", dirty,
                               "#obj incomplete", incomplete,
-                              "#faults", ctx->faults)))
+                              "#faults", ctx->faults,
+                              "#handoff loads", ctx->handoff_loads,
+                              "#hits", (json_int_t)cc.hits,
+                              "#misses", (json_int_t)cc.misses,
+                              "#evictions", (json_int_t)cc.evictions)))
+        goto nomem;
+
+    if (!(lstats = json_pack ("{ s:i s:i s:i s:i s:i }",
+                              "#stalls", ctx->lookup_stats.stalls,
+                              "#stalls avoided",
+                              ctx->lookup_stats.stalls_avoided,
+                              "#prefetches", ctx->lookup_stats.prefetches,
+                              "#result cache hits",
+                              ctx->lookup_stats.result_hits,
+                              "#result cache entries",
+                              lookup_cache_count (ctx->lookup_cache))))
         goto nomem;
 
     if (!(nsstats = json_object ()))
@@ -2287,12 +3367,14 @@ static void stats_get_cb (flux_t *h, flux_msg_handler_t *mh,
     }
 
     if (flux_respond_pack (h, msg,
-                           "{ s:O s:O }",
+                           "{ s:O s:O s:O }",
                            "cache", cstats,
+                           "lookup", lstats,
                            "namespace", nsstats) < 0)
         flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
     json_decref (tstats);
     json_decref (cstats);
+    json_decref (lstats);
     json_decref (nsstats);
     return;
 nomem:
@@ -2302,18 +3384,22 @@ error:
         flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
     json_decref (tstats);
     json_decref (cstats);
+    json_decref (lstats);
     json_decref (nsstats);
 }
 
 static int stats_clear_root_cb (struct kvsroot *root, void *arg)
 {
     kvstxn_mgr_clear_noop_stores (root->ktm);
+    kvstxn_mgr_clear_append_merges (root->ktm);
     return 0;
 }
 
 static void stats_clear (kvs_ctx_t *ctx)
 {
     ctx->faults = 0;
+    cache_clear_counters (ctx->cache);
+    memset (&ctx->lookup_stats, 0, sizeof (ctx->lookup_stats));
 
     if (kvsroot_mgr_iter_roots (ctx->krm, stats_clear_root_cb, NULL) < 0)
         flux_log_error (ctx->h, "%s: kvsroot_mgr_iter_roots", __FUNCTION__);
@@ -2338,8 +3424,13 @@ static void stats_clear_request_cb (flux_t *h, flux_msg_handler_t *mh,
         flux_log_error (h, "%s: flux_respond", __FUNCTION__);
 }
 
+/* Create namespace 'ns'.  If 'rootref' is non-NULL, the namespace starts
+ * out at that root, e.g. the root of another namespace being cloned,
+ * otherwise at an empty directory.
+ */
 static int namespace_create (kvs_ctx_t *ctx, const char *ns,
-                             uint32_t owner, int flags)
+                             uint32_t owner, uint32_t rank, int flags,
+                             const char *rootref)
 {
     struct kvsroot *root;
     json_t *rootdir = NULL;
@@ -2366,24 +3457,28 @@ static int namespace_create (kvs_ctx_t *ctx, const char *ns,
         flux_log_error (ctx->h, "%s: kvsroot_mgr_create_root", __FUNCTION__);
         return -1;
     }
+    configure_kvstxn_mgr (ctx, root);
+    root->rank = rank;
 
-    if (!(rootdir = treeobj_create_dir ())) {
-        flux_log_error (ctx->h, "%s: treeobj_create_dir", __FUNCTION__);
-        goto cleanup;
-    }
+    if (!rootref) {
+        if (!(rootdir = treeobj_create_dir ())) {
+            flux_log_error (ctx->h, "%s: treeobj_create_dir", __FUNCTION__);
+            goto cleanup;
+        }
 
-    if (!(data = treeobj_encode (rootdir))) {
-        flux_log_error (ctx->h, "%s: treeobj_encode", __FUNCTION__);
-        goto cleanup;
-    }
-    len = strlen (data);
+        if (!(data = encode_rootdir (ctx, rootdir, &len))) {
+            flux_log_error (ctx->h, "%s: encode_rootdir", __FUNCTION__);
+            goto cleanup;
+        }
 
-    if (blobref_hash (ctx->hash_name, data, len, ref, sizeof (ref)) < 0) {
-        flux_log_error (ctx->h, "%s: blobref_hash", __FUNCTION__);
-        goto cleanup;
+        if (blobref_hash (ctx->hash_name, data, len, ref, sizeof (ref)) < 0) {
+            flux_log_error (ctx->h, "%s: blobref_hash", __FUNCTION__);
+            goto cleanup;
+        }
+        rootref = ref;
     }
 
-    setroot (ctx, root, ref, 0);
+    setroot (ctx, root, rootref, 0);
 
     if (event_subscribe (ctx, ns) < 0) {
         flux_log_error (ctx->h, "%s: event_subscribe", __FUNCTION__);
@@ -2394,11 +3489,12 @@ static int namespace_create (kvs_ctx_t *ctx, const char *ns,
         goto cleanup;
 
     if (!(msg = flux_event_pack (topic,
-                                 "{ s:s s:i s:s s:i }",
+                                 "{ s:s s:i s:s s:i s:i }",
                                  "namespace", root->ns_name,
                                  "rootseq", root->seq,
                                  "rootref", root->ref,
-                                 "owner", root->owner))) {
+                                 "owner", root->owner,
+                                 "rank", root->rank))) {
         flux_log_error (ctx->h, "%s: flux_event_pack", __FUNCTION__);
         goto cleanup;
     }
@@ -2430,23 +3526,46 @@ static void namespace_create_request_cb (flux_t *h, flux_msg_handler_t *mh,
     kvs_ctx_t *ctx = arg;
     const char *ns;
     uint32_t owner;
+    uint32_t rank = 0;
+    uint32_t size;
     int flags;
+    const char *rootref = NULL;
 
     assert (ctx->rank == 0);
 
-    /* N.B. owner read into uint32_t */
-    if (flux_request_unpack (msg, NULL, "{ s:s s:i s:i }",
+    /* N.B. owner and rank read into uint32_t */
+    if (flux_request_unpack (msg, NULL, "{ s:s s:i s:i s?i s?s }",
                              "namespace", &ns,
                              "owner", &owner,
-                             "flags", &flags) < 0) {
+                             "flags", &flags,
+                             "rank", &rank,
+                             "rootref", &rootref) < 0) {
         flux_log_error (h, "%s: flux_request_unpack", __FUNCTION__);
         goto error;
     }
 
+    /* An initial root must be in the content store, which the data of
+     * an ephemeral namespace is not.
+     */
+    if (rootref && (blobref_validate (rootref) < 0
+                    || (flags & FLUX_KVS_NAMESPACE_EPHEMERAL))) {
+        errno = EINVAL;
+        goto error;
+    }
+
     if (owner == FLUX_USERID_UNKNOWN)
         owner = getuid ();
 
-    if (namespace_create (ctx, ns, owner, flags) < 0)
+    if (flux_get_size (h, &size) < 0) {
+        flux_log_error (h, "%s: flux_get_size", __FUNCTION__);
+        goto error;
+    }
+    if (rank >= size) {
+        errno = EINVAL;
+        goto error;
+    }
+
+    if (namespace_create (ctx, ns, owner, rank, flags, rootref) < 0)
         goto error;
 
     if (flux_respond (h, msg, NULL) < 0)
@@ -2488,6 +3607,11 @@ static void start_root_remove (kvs_ctx_t *ctx, const char *ns)
     if ((root = kvsroot_mgr_lookup_root_safe (ctx->krm, ns))) {
         struct kvs_cb_data cbd = { .ctx = ctx, .root = root };
 
+        /* Transactions that have finished get their setroot event,
+         * not ENOTSUP below.
+         */
+        setroot_event_flush (ctx, root);
+
         root->remove = true;
 
         /* Now that root has been marked for removal from roothash, run through
@@ -2615,10 +3739,11 @@ static int namespace_list_cb (struct kvsroot *root, void *arg)
     if (root->remove)
         return 0;
 
-    if (!(o = json_pack ("{ s:s s:i s:i }",
+    if (!(o = json_pack ("{ s:s s:i s:i s:i }",
                          "namespace", root->ns_name,
                          "owner", root->owner,
-                         "flags", root->flags))) {
+                         "flags", root->flags,
+                         "rank", root->rank))) {
         errno = ENOMEM;
         return -1;
     }
@@ -2788,12 +3913,16 @@ static const struct flux_msg_handler_spec htab[] = {
     { FLUX_MSGTYPE_EVENT,   "kvs.namespace-*-error",    error_event_cb, 0 },
     { FLUX_MSGTYPE_REQUEST, "kvs.getroot",
                             getroot_request_cb, FLUX_ROLE_USER },
+    { FLUX_MSGTYPE_REQUEST, "kvs.ephemeral-load",
+                            ephemeral_load_request_cb, 0 },
     { FLUX_MSGTYPE_REQUEST, "kvs.dropcache",  dropcache_request_cb, 0 },
     { FLUX_MSGTYPE_EVENT,   "kvs.dropcache",  dropcache_event_cb, 0 },
     { FLUX_MSGTYPE_EVENT,   "hb",             heartbeat_cb, 0 },
     { FLUX_MSGTYPE_REQUEST, "kvs.disconnect", disconnect_request_cb, 0 },
     { FLUX_MSGTYPE_REQUEST, "kvs.sync",
                             sync_request_cb, FLUX_ROLE_USER },
+    { FLUX_MSGTYPE_REQUEST, "kvs.lookup-stream",
+                            lookup_stream_request_cb, FLUX_ROLE_USER },
     { FLUX_MSGTYPE_REQUEST, "kvs.lookup",
                             lookup_request_cb, FLUX_ROLE_USER },
     { FLUX_MSGTYPE_REQUEST, "kvs.lookup-plus",
@@ -2826,6 +3955,27 @@ static void process_args (kvs_ctx_t *ctx, int ac, char **av)
     for (i = 0; i < ac; i++) {
         if (strncmp (av[i], "transaction-merge=", 13) == 0)
             ctx->transaction_merge = strtoul (av[i]+13, NULL, 10);
+        else if (strncmp (av[i], "transaction-pipeline=", 21) == 0)
+            ctx->transaction_pipeline = strtoul (av[i]+21, NULL, 10);
+        else if (strcmp (av[i], "treeobj-encoding=binary") == 0)
+            ctx->treeobj_binary = true;
+        else if (strcmp (av[i], "treeobj-encoding=json") == 0)
+            ctx->treeobj_binary = false;
+        else if (strncmp (av[i], "dirshard-threshold=", 19) == 0)
+            ctx->dirshard_threshold = strtoul (av[i]+19, NULL, 10);
+        else if (strncmp (av[i], "append-blob-size=", 17) == 0)
+            ctx->append_blob_size = strtoul (av[i]+17, NULL, 10);
+        else if (strncmp (av[i], "setroot-window=", 15) == 0)
+            ctx->setroot_window = strtod (av[i]+15, NULL);
+        else if (strncmp (av[i], "cache-max-size=", 15) == 0)
+            cache_set_max_size (ctx->cache, strtoull (av[i]+15, NULL, 10));
+        else if (strncmp (av[i], "lookup-cache-size=", 18) == 0) {
+            int size = strtoul (av[i]+18, NULL, 10);
+            lookup_cache_destroy (ctx->lookup_cache);
+            ctx->lookup_cache = NULL;
+            if (size > 0 && !(ctx->lookup_cache = lookup_cache_create (size)))
+                flux_log_error (ctx->h, "lookup_cache_create");
+        }
         else
             flux_log (ctx->h, LOG_ERR, "Unknown option `%s'", av[i]);
     }
@@ -2904,9 +4054,8 @@ static int store_initial_rootdir (kvs_ctx_t *ctx, char *ref, int ref_len)
         flux_log_error (ctx->h, "%s: treeobj_create_dir", __FUNCTION__);
         goto error;
     }
-    if (!(data = treeobj_encode (rootdir)))
+    if (!(data = encode_rootdir (ctx, rootdir, &len)))
         goto error;
-    len = strlen (data);
     if (blobref_hash (ctx->hash_name, data, len, ref, ref_len) < 0) {
         flux_log_error (ctx->h, "%s: blobref_hash", __FUNCTION__);
         goto error;
@@ -2959,6 +4108,168 @@ error:
     return -1;
 }
 
+/*
+ * handoff - keep the cache warm across module reload
+ */
+
+static const int handoff_version = 1;
+
+/* Refs per content.load-batch request, as limited by the content cache.
+ */
+static const int handoff_batch_max = 256;
+
+/* Export the blobrefs of cached objects that are in the content store,
+ * so the next kvs module loaded on this broker can prefetch them.
+ */
+static void handoff_export (kvs_ctx_t *ctx)
+{
+    json_t *blobrefs;
+    json_t *o = NULL;
+    char *s = NULL;
+
+    if (!(blobrefs = cache_get_blobrefs (ctx->cache)))
+        goto error;
+    if (!(o = json_pack ("{s:i s:O}",
+                         "version", handoff_version,
+                         "blobrefs", blobrefs))
+        || !(s = json_dumps (o, JSON_COMPACT))) {
+        errno = ENOMEM;
+        goto error;
+    }
+    if (flux_module_handoff_export (ctx->h, s) < 0)
+        goto error;
+    flux_log (ctx->h, LOG_DEBUG, "handoff: exported %zu cache entries",
+              json_array_size (blobrefs));
+    goto done;
+error:
+    flux_log_error (ctx->h, "error exporting cache for handoff");
+done:
+    free (s);
+    json_decref (o);
+    json_decref (blobrefs);
+}
+
+/* Remove the incomplete cache entries in 'refs' and destroy 'refs'.
+ */
+static void handoff_cancel (kvs_ctx_t *ctx, zlist_t *refs)
+{
+    const char *ref;
+
+    if (refs) {
+        int saved_errno = errno;
+        ref = zlist_first (refs);
+        while (ref) {
+            (void)cache_remove_entry (ctx->cache, ref);
+            ref = zlist_next (refs);
+        }
+        zlist_destroy (&refs);
+        errno = saved_errno;
+    }
+}
+
+/* Send loads for the incomplete cache entries in 'refs', taking
+ * ownership of 'refs'.  Returns the number of refs, or -1 on error.
+ */
+static int handoff_load (kvs_ctx_t *ctx, zlist_t *refs)
+{
+    int count = zlist_size (refs);
+
+    if (count == 1) {
+        if (content_load_request_send (ctx, zlist_first (refs)) < 0)
+            goto error;
+        zlist_destroy (&refs);
+    }
+    else if (content_load_batch_request_send (ctx, refs) < 0)
+        goto error;
+    return count;
+error:
+    handoff_cancel (ctx, refs);
+    return -1;
+}
+
+/* Prefetch the objects cached by the previous kvs module on this broker,
+ * if any, so that requests after a reload don't all fault.  Most are still
+ * in the broker content cache, which is not restarted with the module.
+ * Refs were exported most recently used first, so they are inserted in
+ * reverse to rebuild the LRU order.  An object that fails to load is
+ * dropped from the cache like any other failed load.
+ */
+static void handoff_import (kvs_ctx_t *ctx)
+{
+    const char *s;
+    json_t *o;
+    json_t *blobrefs;
+    int version;
+    zlist_t *refs = NULL;
+    size_t index;
+    int count;
+    int ret;
+
+    if (!(s = flux_module_handoff_import (ctx->h)))
+        return;
+    if (!(o = json_loads (s, 0, NULL))
+        || json_unpack (o,
+                        "{s:i s:o}",
+                        "version", &version,
+                        "blobrefs", &blobrefs) < 0
+        || version != handoff_version
+        || !json_is_array (blobrefs)) {
+        flux_log (ctx->h, LOG_ERR, "ignoring unknown handoff state");
+        json_decref (o);
+        return;
+    }
+    index = json_array_size (blobrefs);
+    while (index-- > 0) {
+        const char *ref = json_string_value (json_array_get (blobrefs, index));
+        struct cache_entry *entry;
+
+        if (!ref
+            || blobref_validate (ref) < 0
+            || cache_lookup (ctx->cache, ref, ctx->epoch))
+            continue;
+        if (!refs) {
+            if (!(refs = zlist_new ()))
+                goto nomem;
+            zlist_autofree (refs);
+        }
+        if (!(entry = cache_entry_create (ref)))
+            goto error;
+        if (cache_insert (ctx->cache, entry) < 0) {
+            cache_entry_destroy (entry);
+            goto error;
+        }
+        if (zlist_append (refs, (char *)ref) < 0) {
+            ret = cache_remove_entry (ctx->cache, ref);
+            assert (ret == 1);
+            goto nomem;
+        }
+        if (zlist_size (refs) == handoff_batch_max) {
+            count = handoff_load (ctx, refs);
+            refs = NULL;
+            if (count < 0)
+                goto error;
+            ctx->handoff_loads += count;
+        }
+    }
+    if (refs) {
+        count = handoff_load (ctx, refs);
+        refs = NULL;
+        if (count < 0)
+            goto error;
+        ctx->handoff_loads += count;
+    }
+    flux_log (ctx->h, LOG_DEBUG, "handoff: prefetching %d cache entries",
+              ctx->handoff_loads);
+    json_decref (o);
+    return;
+nomem:
+    errno = ENOMEM;
+error:
+    flux_log_error (ctx->h, "error prefetching handoff cache entries");
+    handoff_cancel (ctx, refs);
+    json_decref (o);
+}
+
 int mod_main (flux_t *h, int argc, char **argv)
 {
     kvs_ctx_t *ctx = getctx (h);
@@ -3002,6 +4313,7 @@ int mod_main (flux_t *h, int argc, char **argv)
                 flux_log_error (h, "kvsroot_mgr_create_root");
                 goto done;
             }
+            configure_kvstxn_mgr (ctx, root);
         }
 
         setroot (ctx, root, rootref, 0);
@@ -3011,14 +4323,20 @@ int mod_main (flux_t *h, int argc, char **argv)
             goto done;
         }
     }
+    handoff_import (ctx);
     if (flux_msg_handler_addvec (h, htab, ctx, &handlers) < 0) {
         flux_log_error (h, "flux_msg_handler_addvec");
         goto done;
     }
+    if (flux_module_set_shed (h, memory_shed_cb, ctx) < 0) {
+        flux_log_error (h, "flux_module_set_shed");
+        goto done;
+    }
     if (flux_reactor_run (flux_get_reactor (h), 0) < 0) {
         flux_log_error (h, "flux_reactor_run");
         goto done;
     }
+    setroot_event_flush_all (ctx);
     /* Checkpoint the KVS root to the content backing store.
      * If backing store is not loaded, silently proceed without checkpoint.
      */
@@ -3037,6 +4355,7 @@ int mod_main (flux_t *h, int argc, char **argv)
             }
         }
     }
+    handoff_export (ctx);
     rc = 0;
 done:
     flux_msg_handler_delvec (handlers);
@@ -22,7 +22,10 @@
 #include <flux/core.h>
 #include <jansson.h>
 
+#include "src/common/libutil/skiplist.h"
+
 #include "kvsroot.h"
+#include "ephemeral.h"
 
 struct kvsroot_mgr {
     zhash_t *roothash;
@@ -86,10 +89,12 @@ static void kvsroot_destroy (void *data)
             kvstxn_mgr_destroy (root->ktm);
         if (root->trm)
             treq_mgr_destroy (root->trm);
-        if (root->synclist)
-            zlist_destroy (&root->synclist);
+        skiplist_destroy (root->synclist);
+        ephemeral_destroy (root->ephemeral);
         if (root->setroot_queue)
             zlist_destroy (&root->setroot_queue);
+        json_decref (root->setroot_names);
+        json_decref (root->setroot_keys);
         free (data);
     }
 }
@@ -134,11 +139,6 @@ struct kvsroot *kvsroot_mgr_create_root (kvsroot_mgr_t *krm,
         goto error;
     }
 
-    if (!(root->synclist = zlist_new ())) {
-        flux_log_error (krm->h, "zlist_new");
-        goto error;
-    }
-
     root->owner = owner;
     root->flags = flags;
     root->remove = false;
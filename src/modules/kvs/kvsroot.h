@@ -12,6 +12,7 @@
 #define _FLUX_KVS_KVSROOT_H
 
 #include <stdbool.h>
+#include <jansson.h>
 #include <flux/core.h>
 
 #include "cache.h"
@@ -22,19 +23,26 @@
 
 typedef struct kvsroot_mgr kvsroot_mgr_t;
 
+struct skiplist;
+struct ephemeral;
+
 struct kvsroot {
     char *ns_name;
     uint32_t owner;
+    uint32_t rank;              /* broker rank that applies transactions */
     int seq;
     char ref[BLOBREF_MAX_STRING_SIZE];
     kvstxn_mgr_t *ktm;
     treq_mgr_t *trm;
-    zlist_t *synclist;
+    struct skiplist *synclist;  /* see kvssync.c, created on demand */
     int last_update_epoch;
     int flags;
     bool remove;
     bool setroot_pause;
     zlist_t *setroot_queue;
+    json_t *setroot_names;      /* transactions awaiting setroot event */
+    json_t *setroot_keys;       /* keys changed by them, key => true */
+    struct ephemeral *ephemeral; /* held tree, ephemeral owner only */
 };
 
 /* return -1 on error, 0 on success, 1 on success & to stop iterating */
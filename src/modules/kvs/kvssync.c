@@ -21,6 +21,8 @@
 #include <czmq.h>
 #include <flux/core.h>
 
+#include "src/common/libutil/skiplist.h"
+
 #include "kvssync.h"
 
 struct kvssync {
@@ -30,12 +32,13 @@ struct kvssync {
     const flux_msg_t *msg;
     void *arg;
     int seq;
+    void *handle;               /* in root->synclist */
 };
 
-static int kvssync_cmp (void *item1, void *item2)
+static int kvssync_cmp (const void *item1, const void *item2)
 {
-    struct kvssync *ks1 = item1;
-    struct kvssync *ks2 = item2;
+    const struct kvssync *ks1 = item1;
+    const struct kvssync *ks2 = item2;
 
     if (ks1->seq < ks2->seq)
         return -1;
@@ -53,6 +56,19 @@ static void kvssync_destroy (void *data)
     }
 }
 
+static void kvssync_destructor (void **item)
+{
+    if (item) {
+        kvssync_destroy (*item);
+        *item = NULL;
+    }
+}
+
+int kvssync_count (struct kvsroot *root)
+{
+    return root && root->synclist ? skiplist_size (root->synclist) : 0;
+}
+
 int kvssync_add (struct kvsroot *root, flux_msg_handler_f cb, flux_t *h,
                  flux_msg_handler_t *mh, const flux_msg_t *msg, void *arg,
                  int seq)
@@ -76,13 +92,15 @@ int kvssync_add (struct kvsroot *root, flux_msg_handler_f cb, flux_t *h,
     ks->arg = arg;
     ks->seq = seq;
 
-    if (zlist_push (root->synclist, ks) < 0) {
-        errno = ENOMEM;
-        goto error;
+    /* The synclist is kept sorted by seq, and created on first use.
+     */
+    if (!root->synclist) {
+        if (!(root->synclist = skiplist_create (kvssync_cmp)))
+            goto error;
+        skiplist_set_destructor (root->synclist, kvssync_destructor);
     }
-    zlist_freefn (root->synclist, ks, kvssync_destroy, false);
-
-    zlist_sort (root->synclist, kvssync_cmp);
+    if (!(ks->handle = skiplist_insert (root->synclist, ks)))
+        goto error;
 
     return 0;
 
@@ -95,17 +113,23 @@ void kvssync_process (struct kvsroot *root, bool all)
 {
     struct kvssync *ks;
 
-    if (!root)
+    if (!root || !root->synclist)
         return;
 
-    /* notify sync waiters that version has been reached */
+    /* notify sync waiters that version has been reached
+     * N.B. the entry is unlinked before its callback is run, and the
+     * callback may add new entries, so restart from the head each time.
+     */
 
-    ks = zlist_first (root->synclist);
+    ks = skiplist_first (root->synclist);
     while (ks && (all || root->seq >= ks->seq)) {
-        ks = zlist_pop (root->synclist);
-        ks->cb (ks->h, ks->mh, ks->msg, ks->arg);
-        kvssync_destroy (ks);
-        ks = zlist_first (root->synclist);
+        struct kvssync tmp = *ks;
+
+        tmp.msg = flux_msg_incref (ks->msg);
+        skiplist_delete (root->synclist, ks->handle);
+        tmp.cb (tmp.h, tmp.mh, tmp.msg, tmp.arg);
+        flux_msg_decref (tmp.msg);
+        ks = skiplist_first (root->synclist);
     }
 }
 
@@ -113,45 +137,24 @@ int kvssync_remove_msg (struct kvsroot *root,
                         kvssync_test_msg_f cmp,
                         void *arg)
 {
-    zlist_t *tmp = NULL;
     struct kvssync *ks;
-    int rc = -1;
-    int saved_errno;
 
     if (!root || !cmp) {
-        saved_errno = EINVAL;
-        goto error;
+        errno = EINVAL;
+        return -1;
     }
+    if (!root->synclist)
+        return 0;
 
-    ks = zlist_first (root->synclist);
+    /* N.B. it is safe to delete the current item while iterating
+     */
+    ks = skiplist_first (root->synclist);
     while (ks) {
-        if (cmp (ks->msg, arg)) {
-            if (!tmp && !(tmp = zlist_new ())) {
-                saved_errno = ENOMEM;
-                goto error;
-            }
-            if (zlist_append (tmp, ks) < 0) {
-                saved_errno = ENOMEM;
-                goto error;
-            }
-        }
-        ks = zlist_next (root->synclist);
-    }
-    if (tmp) {
-        while ((ks = zlist_pop (tmp)))
-            zlist_remove (root->synclist, ks);
+        if (cmp (ks->msg, arg))
+            skiplist_delete (root->synclist, ks->handle);
+        ks = skiplist_next (root->synclist);
     }
-    rc = 0;
-error:
-    /* if an error occurs above in zlist_new() or zlist_append(),
-     * simply destroy the tmp list.  Nothing has been removed off of
-     * the original queue yet.  Allow user to handle error as they see
-     * fit.
-     */
-    zlist_destroy (&tmp);
-    if (rc < 0)
-        errno = saved_errno;
-    return rc;
+    return 0;
 }
 
 /*
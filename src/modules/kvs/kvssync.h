@@ -18,7 +18,9 @@
 
 typedef bool (*kvssync_test_msg_f)(const flux_msg_t *msg, void *arg);
 
-/* add a kvssync structure to the kvsroot synclist */
+/* add a kvssync structure to the kvsroot synclist, which is kept
+ * sorted by sequence number (O(log n) insert).
+ */
 int kvssync_add (struct kvsroot *root, flux_msg_handler_f cb, flux_t *h,
                  flux_msg_handler_t *mh, const flux_msg_t *msg, void *arg,
                  int seq);
@@ -29,6 +31,9 @@ int kvssync_add (struct kvsroot *root, flux_msg_handler_f cb, flux_t *h,
  */
 void kvssync_process (struct kvsroot *root, bool all);
 
+/* return the number of entries on the kvsroot synclist */
+int kvssync_count (struct kvsroot *root);
+
 /* remove message on synclist that meet 'cmp' conditions */
 int kvssync_remove_msg (struct kvsroot *root,
                         kvssync_test_msg_f cmp,
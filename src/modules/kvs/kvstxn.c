@@ -25,6 +25,7 @@
 
 #include "src/common/libutil/macros.h"
 #include "src/common/libutil/blobref.h"
+#include "src/common/libutil/errno_safe.h"
 #include "src/common/libkvs/treeobj.h"
 #include "src/common/libkvs/kvs_txn_private.h"
 #include "src/common/libkvs/kvs_util_private.h"
@@ -34,13 +35,21 @@
 #define KVSTXN_PROCESSING      0x01
 #define KVSTXN_MERGED          0x02 /* kvstxn is a merger of transactions */
 #define KVSTXN_MERGE_COMPONENT 0x04 /* kvstxn is member of a merger */
+#define KVSTXN_PIPELINED       0x08 /* kvstxn is on the pending list */
 
 struct kvstxn_mgr {
     struct cache *cache;
     const char *ns_name;
     const char *hash_name;
     int noop_stores;            /* for kvs.stats.get, etc.*/
+    bool treeobj_binary;        /* store dirs with treeobj_encode_binary() */
+    int dirshard_threshold;     /* shard dirs with more entries, 0=never */
+    bool pipeline;              /* start next txn while stores in flight */
+    int append_blob_size;       /* merge appends into blobs up to size */
+    int append_merges;          /* for kvs.stats.get, etc. */
+    bool ephemeral;             /* namespace is not written to content */
     zlist_t *ready;
+    zlist_t *pending;           /* pipelined txns, in setroot order */
     flux_t *h;
     void *aux;
 };
@@ -147,7 +156,11 @@ int kvstxn_set_aux_errnum (kvstxn_t *kt, int errnum)
 
 bool kvstxn_fallback_mergeable (kvstxn_t *kt)
 {
-    if (kt->internal_flags & KVSTXN_MERGED)
+    /* A pipelined kvstxn has already applied all of its ops, and its
+     * components were dropped when it entered the pipeline.
+     */
+    if ((kt->internal_flags & KVSTXN_MERGED)
+        && !(kt->internal_flags & KVSTXN_PIPELINED))
         return true;
     return false;
 }
@@ -220,6 +233,12 @@ void kvstxn_cleanup_dirty_cache_entry (kvstxn_t *kt, struct cache_entry *entry)
         assert (ret == 0);
         assert (cache_entry_get_dirty (entry) == false);
 
+        /* ephemeral data was valid before this transaction and may
+         * still be referenced by an ephemeral namespace, keep it.
+         */
+        if (cache_entry_get_ephemeral (entry))
+            return;
+
         ret = cache_entry_get_raw (entry, &data, &len);
         assert (ret == 0);
 
@@ -246,56 +265,47 @@ static void cleanup_dirty_cache_list (kvstxn_t *kt)
  * Returns -1 on error, 0 on success entry already there, 1 on success
  * entry needs to be flushed to content store
  */
-static int store_cache (kvstxn_t *kt, int current_epoch, json_t *o,
-                        bool is_raw, char *ref, int ref_len,
-                        struct cache_entry **entryp)
+/* Put 'data' in the cache under its blobref, returned in 'ref', and
+ * mark it dirty if it was not already cached.
+ * Returns 1 if the entry was made dirty, 0 if already cached, -1 on error.
+ */
+static int store_cache_data (kvstxn_t *kt, int current_epoch,
+                             const void *data, size_t len,
+                             char *ref, int ref_len,
+                             struct cache_entry **entryp)
 {
     struct cache_entry *entry;
-    int saved_errno, rc;
-    const char *xdata;
-    char *data = NULL;
-    size_t xlen, len;
+    int rc;
 
-    if (is_raw) {
-        xdata = json_string_value (o);
-        xlen = strlen (xdata);
-        len = BASE64_DECODE_SIZE (xlen);
-        if (len > 0) {
-            if (!(data = malloc (len))) {
-                flux_log_error (kt->ktm->h, "malloc");
-                goto error;
-            }
-            if (sodium_base642bin ((unsigned char *)data, len, xdata, xlen,
-                                   NULL, &len, NULL,
-                                   sodium_base64_VARIANT_ORIGINAL) < 0) {
-                errno = EPROTO;
-                goto error;
-            }
-        }
-    }
-    else {
-        if (treeobj_validate (o) < 0 || !(data = treeobj_encode (o))) {
-            flux_log_error (kt->ktm->h, "%s: treeobj_encode", __FUNCTION__);
-            goto error;
-        }
-        len = strlen (data);
-    }
     if (blobref_hash (kt->ktm->hash_name, data, len, ref, ref_len) < 0) {
         flux_log_error (kt->ktm->h, "%s: blobref_hash", __FUNCTION__);
-        goto error;
+        return -1;
     }
     if (!(entry = cache_lookup (kt->ktm->cache, ref, current_epoch))) {
         if (!(entry = cache_entry_create (ref))) {
             flux_log_error (kt->ktm->h, "%s: cache_entry_create", __FUNCTION__);
-            goto error;
+            return -1;
         }
         if (cache_insert (kt->ktm->cache, entry) < 0) {
             cache_entry_destroy (entry);
             flux_log_error (kt->ktm->h, "%s: cache_insert", __FUNCTION__);
-            goto error;
+            return -1;
+        }
+    }
+    if (cache_entry_get_valid (entry)
+        && cache_entry_get_ephemeral (entry)
+        && !cache_entry_get_dirty (entry)
+        && !kt->ktm->ephemeral) {
+        /* data of an ephemeral namespace was never written to the
+         * content store, but is now referenced by this one.
+         */
+        if (cache_entry_set_dirty (entry, true) < 0) {
+            flux_log_error (kt->ktm->h, "%s: cache_entry_set_dirty",__FUNCTION__);
+            return -1;
         }
+        rc = 1;
     }
-    if (cache_entry_get_valid (entry)) {
+    else if (cache_entry_get_valid (entry)) {
         kt->ktm->noop_stores++;
         rc = 0;
     }
@@ -304,18 +314,71 @@ static int store_cache (kvstxn_t *kt, int current_epoch, json_t *o,
             int ret;
             ret = cache_remove_entry (kt->ktm->cache, ref);
             assert (ret == 1);
-            goto error;
+            return -1;
         }
         if (cache_entry_set_dirty (entry, true) < 0) {
             flux_log_error (kt->ktm->h, "%s: cache_entry_set_dirty",__FUNCTION__);
             int ret;
             ret = cache_remove_entry (kt->ktm->cache, ref);
             assert (ret == 1);
-            goto error;
+            return -1;
         }
         rc = 1;
     }
     *entryp = entry;
+    return rc;
+}
+
+static int store_cache (kvstxn_t *kt, int current_epoch, json_t *o,
+                        bool is_raw, char *ref, int ref_len,
+                        struct cache_entry **entryp)
+{
+    int saved_errno, rc;
+    const char *xdata;
+    char *data = NULL;
+    size_t xlen, len;
+
+    if (is_raw) {
+        xdata = json_string_value (o);
+        xlen = strlen (xdata);
+        len = BASE64_DECODE_SIZE (xlen);
+        if (len > 0) {
+            if (!(data = malloc (len))) {
+                flux_log_error (kt->ktm->h, "malloc");
+                goto error;
+            }
+            if (sodium_base642bin ((unsigned char *)data, len, xdata, xlen,
+                                   NULL, &len, NULL,
+                                   sodium_base64_VARIANT_ORIGINAL) < 0) {
+                errno = EPROTO;
+                goto error;
+            }
+        }
+    }
+    else {
+        if (treeobj_validate (o) < 0) {
+            flux_log_error (kt->ktm->h, "%s: treeobj_validate", __FUNCTION__);
+            goto error;
+        }
+        if (kt->ktm->treeobj_binary) {
+            if (!(data = treeobj_encode_binary (o, &len))) {
+                flux_log_error (kt->ktm->h, "%s: treeobj_encode_binary",
+                                __FUNCTION__);
+                goto error;
+            }
+        }
+        else {
+            if (!(data = treeobj_encode (o))) {
+                flux_log_error (kt->ktm->h, "%s: treeobj_encode",
+                                __FUNCTION__);
+                goto error;
+            }
+            len = strlen (data);
+        }
+    }
+    if ((rc = store_cache_data (kt, current_epoch, data, len,
+                                ref, ref_len, entryp)) < 0)
+        goto error;
     free (data);
     return rc;
 
@@ -326,6 +389,179 @@ static int store_cache (kvstxn_t *kt, int current_epoch, json_t *o,
     return -1;
 }
 
+/* The working copy of the root is built copy-on-write.  A dir or
+ * dirshard is copied with treeobj_copy() when it is first modified, so
+ * its entries stay shared with the cached original.  A dir or dirshard
+ * in the working copy with more than one reference is still shared,
+ * with a cached object or with the transaction ops, and must be copied
+ * before it is modified.
+ */
+static bool kvstxn_shared (const json_t *dir)
+{
+    return dir->refcount > 1;
+}
+
+/* Replace entry 'name' of 'dir' with a copy of 'subdir' that may be
+ * modified, and return it.
+ */
+static json_t *kvstxn_cow_entry (json_t *dir, const char *name,
+                                 const json_t *subdir)
+{
+    json_t *cpy;
+
+    if (!(cpy = treeobj_copy (subdir)))
+        return NULL;
+    if (treeobj_insert_entry (dir, name, cpy) < 0) {
+        ERRNO_SAFE_WRAP (json_decref, cpy);
+        return NULL;
+    }
+    json_decref (cpy);
+    return cpy;
+}
+
+/* Replace shard 'index' of 'dirshard' with a copy of 'shard' that may
+ * be modified, and return it.
+ */
+static json_t *kvstxn_cow_shard (json_t *dirshard, int index,
+                                 const json_t *shard)
+{
+    json_t *cpy;
+
+    if (!(cpy = treeobj_copy (shard)))
+        return NULL;
+    if (treeobj_insert_shard (dirshard, index, cpy) < 0) {
+        ERRNO_SAFE_WRAP (json_decref, cpy);
+        return NULL;
+    }
+    json_decref (cpy);
+    return cpy;
+}
+
+static int kvstxn_unroll (kvstxn_t *kt, int current_epoch, json_t *dir);
+
+static bool kvstxn_should_shard (kvstxn_t *kt, json_t *dir, int level)
+{
+    return (kt->ktm->dirshard_threshold > 0
+            && level < TREEOBJ_DIRSHARD_LEVELS
+            && treeobj_is_dir (dir)
+            && treeobj_get_count (dir) > kt->ktm->dirshard_threshold);
+}
+
+/* Split the entries of 'dir' into a new dirshard at 'level'.
+ * Shards that are still too large are split again when unrolled.
+ */
+static json_t *kvstxn_shard_dir (json_t *dir, int level)
+{
+    json_t *dirshard;
+    json_t *dir_data;
+    const char *name;
+    json_t *dir_entry;
+
+    if (!(dir_data = treeobj_get_data (dir))
+        || !(dirshard = treeobj_create_dirshard (level)))
+        return NULL;
+    json_object_foreach (dir_data, name, dir_entry) {
+        json_t *shard;
+        int index;
+
+        if ((index = treeobj_dirshard_index (level, name)) < 0)
+            goto error;
+        if (!(shard = treeobj_get_shard (dirshard, index))) {
+            if (!(shard = treeobj_create_dir ()))
+                goto error;
+            if (treeobj_insert_shard (dirshard, index, shard) < 0) {
+                json_decref (shard);
+                goto error;
+            }
+            json_decref (shard);
+        }
+        if (treeobj_insert_entry_novalidate (shard, name, dir_entry) < 0)
+            goto error;
+    }
+    return dirshard;
+error:
+    ERRNO_SAFE_WRAP (json_decref, dirshard);
+    return NULL;
+}
+
+/* Unroll and store 'dir', a dir or dirshard, and return its blobref in
+ * 'ref'.  If 'dir' has grown past the dirshard threshold, it is stored
+ * as a dirshard at 'level' instead.
+ */
+static int kvstxn_store_dir (kvstxn_t *kt, int current_epoch, json_t *dir,
+                             int level, char *ref, int ref_len)
+{
+    struct cache_entry *entry;
+    json_t *dirshard = NULL;
+    int ret;
+
+    if (kvstxn_should_shard (kt, dir, level)) {
+        if (!(dirshard = kvstxn_shard_dir (dir, level)))
+            return -1;
+        dir = dirshard;
+    }
+    if (kvstxn_unroll (kt, current_epoch, dir) < 0) /* depth first */
+        goto error;
+    if ((ret = store_cache (kt, current_epoch, dir,
+                            false, ref, ref_len, &entry)) < 0)
+        goto error;
+    if (ret) {
+        if (zlist_push (kt->dirty_cache_entries_list, entry) < 0) {
+            kvstxn_cleanup_dirty_cache_entry (kt, entry);
+            errno = ENOMEM;
+            goto error;
+        }
+    }
+    json_decref (dirshard);
+    return 0;
+error:
+    ERRNO_SAFE_WRAP (json_decref, dirshard);
+    return -1;
+}
+
+/* Store the dir and dirshard shards of 'dirshard', converting them to
+ * DIRREFs.  Empty dir shards are dropped.
+ */
+static int kvstxn_unroll_dirshard (kvstxn_t *kt, int current_epoch,
+                                   json_t *dirshard)
+{
+    char ref[BLOBREF_MAX_STRING_SIZE];
+    json_t *shard;
+    json_t *ktmp;
+    int level;
+    int i;
+
+    if ((level = treeobj_get_dirshard_level (dirshard)) < 0)
+        return -1;
+
+    for (i = 0; i < TREEOBJ_DIRSHARD_WIDTH; i++) {
+        if (!(shard = treeobj_get_shard (dirshard, i)))
+            continue;
+        if (treeobj_is_dir (shard) && treeobj_get_count (shard) == 0) {
+            if (treeobj_delete_shard (dirshard, i) < 0)
+                return -1;
+            continue;
+        }
+        if (treeobj_is_dir (shard) || treeobj_is_dirshard (shard)) {
+            if (kvstxn_shared (shard)) {
+                if (!(shard = kvstxn_cow_shard (dirshard, i, shard)))
+                    return -1;
+            }
+            if (kvstxn_store_dir (kt, current_epoch, shard,
+                                  level + 1, ref, sizeof (ref)) < 0)
+                return -1;
+            if (!(ktmp = treeobj_create_dirref (ref)))
+                return -1;
+            if (treeobj_insert_shard (dirshard, i, ktmp) < 0) {
+                json_decref (ktmp);
+                return -1;
+            }
+            json_decref (ktmp);
+        }
+    }
+    return 0;
+}
+
 /* Store DIRVAL objects, converting them to DIRREFs.
  * Store (large) FILEVAL objects, converting them to FILEREFs.
  * Return 0 on success, -1 on error
@@ -340,6 +576,9 @@ static int kvstxn_unroll (kvstxn_t *kt, int current_epoch, json_t *dir)
     struct cache_entry *entry;
     void *iter;
 
+    if (treeobj_is_dirshard (dir))
+        return kvstxn_unroll_dirshard (kt, current_epoch, dir);
+
     assert (treeobj_is_dir (dir));
 
     if (!(dir_data = treeobj_get_data (dir)))
@@ -352,19 +591,20 @@ static int kvstxn_unroll (kvstxn_t *kt, int current_epoch, json_t *dir)
      */
     while (iter) {
         dir_entry = json_object_iter_value (iter);
-        if (treeobj_is_dir (dir_entry)) {
-            if (kvstxn_unroll (kt, current_epoch, dir_entry) < 0) /* depth first */
-                return -1;
-            if ((ret = store_cache (kt, current_epoch, dir_entry,
-                                    false, ref, sizeof (ref), &entry)) < 0)
-                return -1;
-            if (ret) {
-                if (zlist_push (kt->dirty_cache_entries_list, entry) < 0) {
-                    kvstxn_cleanup_dirty_cache_entry (kt, entry);
+        if (treeobj_is_dir (dir_entry) || treeobj_is_dirshard (dir_entry)) {
+            if (kvstxn_shared (dir_entry)) {
+                if (!(ktmp = treeobj_copy (dir_entry)))
+                    return -1;
+                if (json_object_iter_set_new (dir, iter, ktmp) < 0) {
+                    json_decref (ktmp);
                     errno = ENOMEM;
                     return -1;
                 }
+                dir_entry = ktmp;
             }
+            if (kvstxn_store_dir (kt, current_epoch, dir_entry,
+                                  0, ref, sizeof (ref)) < 0)
+                return -1;
             if (!(ktmp = treeobj_create_dirref (ref)))
                 return -1;
             if (json_object_iter_set_new (dir, iter, ktmp) < 0) {
@@ -433,6 +673,102 @@ static int kvstxn_val_data_to_cache (kvstxn_t *kt, int current_epoch,
     return 0;
 }
 
+/* Store the concatenation of 'data1' and the value of 'val' as one blob,
+ * if its length does not exceed the append blob size target.
+ * Returns 1 with the blobref in 'ref' if stored, 0 if too large, -1 on error.
+ */
+static int kvstxn_append_concat (kvstxn_t *kt, int current_epoch,
+                                 const void *data1, int len1, json_t *val,
+                                 char *ref, int ref_len)
+{
+    struct cache_entry *entry;
+    void *data2 = NULL;
+    char *buf = NULL;
+    int len2;
+    int saved_errno;
+    int ret;
+    int rc = -1;
+
+    if (treeobj_decode_val (val, &data2, &len2) < 0)
+        return -1;
+    if (len1 + len2 == 0
+        || (size_t)len1 + len2 > (size_t)kt->ktm->append_blob_size) {
+        rc = 0;
+        goto done;
+    }
+    if (!(buf = malloc (len1 + len2)))
+        goto done;
+    if (len1 > 0)
+        memcpy (buf, data1, len1);
+    if (len2 > 0)
+        memcpy (buf + len1, data2, len2);
+    if ((ret = store_cache_data (kt, current_epoch, buf, len1 + len2,
+                                 ref, ref_len, &entry)) < 0)
+        goto done;
+    if (ret) {
+        if (zlist_push (kt->dirty_cache_entries_list, entry) < 0) {
+            kvstxn_cleanup_dirty_cache_entry (kt, entry);
+            errno = ENOMEM;
+            goto done;
+        }
+    }
+    rc = 1;
+done:
+    saved_errno = errno;
+    free (data2);
+    free (buf);
+    errno = saved_errno;
+    return rc;
+}
+
+/* Append the value of 'val' to valref 'valref' by merging it into the
+ * last blob, so eventlogs built from many small appends do not become
+ * valrefs of many tiny blobs.  This is only done if the last blob is
+ * in the cache and the merged blob fits the append blob size target.
+ * Returns the new valref, or NULL with errno == 0 if not merged.
+ */
+static json_t *kvstxn_append_merge (kvstxn_t *kt, int current_epoch,
+                                    json_t *valref, json_t *val)
+{
+    char ref[BLOBREF_MAX_STRING_SIZE];
+    struct cache_entry *entry;
+    const char *lastref;
+    const void *data;
+    int count;
+    int len;
+    json_t *cpy;
+    json_t *o;
+    int ret;
+
+    errno = 0;
+    if (kt->ktm->append_blob_size <= 0
+        || (count = treeobj_get_count (valref)) <= 0
+        || !(lastref = treeobj_get_blobref (valref, count - 1))
+        || !(entry = cache_lookup (kt->ktm->cache, lastref, current_epoch))
+        || cache_entry_get_raw (entry, &data, &len) < 0
+        || len >= kt->ktm->append_blob_size) {
+        errno = 0;
+        return NULL;
+    }
+    if ((ret = kvstxn_append_concat (kt, current_epoch, data, len, val,
+                                     ref, sizeof (ref))) < 0)
+        return NULL;
+    if (ret == 0) {
+        errno = 0;
+        return NULL;
+    }
+    if (!(cpy = treeobj_deep_copy (valref)))
+        return NULL;
+    if (!(o = json_string (ref))
+        || json_array_set_new (treeobj_get_data (cpy), count - 1, o) < 0) {
+        json_decref (cpy);
+        errno = ENOMEM;
+        return NULL;
+    }
+    kt->ktm->append_merges++;
+    return cpy;
+}
+
 static int kvstxn_append (kvstxn_t *kt, int current_epoch, json_t *dirent,
                           json_t *dir, const char *final_name, bool *append)
 {
@@ -454,6 +790,18 @@ static int kvstxn_append (kvstxn_t *kt, int current_epoch, json_t *dirent,
         char ref[BLOBREF_MAX_STRING_SIZE];
         json_t *cpy;
 
+        if ((cpy = kvstxn_append_merge (kt, current_epoch, entry, dirent))) {
+            if (treeobj_insert_entry_novalidate (dir, final_name, cpy) < 0) {
+                json_decref (cpy);
+                return -1;
+            }
+            json_decref (cpy);
+            (*append) = true;
+            return 0;
+        }
+        if (errno != 0)
+            return -1;
+
         /* treeobj is valref, so we need to append the new data's
          * blobref to this tree object.  Before doing so, we must save
          * off the new data to the cache and mark it dirty for
@@ -501,8 +849,28 @@ static int kvstxn_append (kvstxn_t *kt, int current_epoch, json_t *dirent,
 
         /* treeobj entry is val, so we need to convert the treeobj
          * into a valref first.  Then the procedure is basically the
-         * same as the treeobj valref case above.
+         * same as the treeobj valref case above.  If both values fit
+         * in one blob, the valref starts out with just that blob.
          */
+        if (kt->ktm->append_blob_size > 0) {
+            void *data;
+            int len;
+            int ret;
+
+            if (treeobj_decode_val (entry, &data, &len) < 0)
+                return -1;
+            ret = kvstxn_append_concat (kt, current_epoch, data, len, dirent,
+                                        ref1, sizeof (ref1));
+            ERRNO_SAFE_WRAP (free, data);
+            if (ret < 0)
+                return -1;
+            if (ret > 0) {
+                if (!(ktmp = treeobj_create_valref (ref1)))
+                    return -1;
+                kt->ktm->append_merges++;
+                goto insert;
+            }
+        }
 
         if (kvstxn_val_data_to_cache (kt, current_epoch, entry, ref1,
                                       sizeof (ref1)) < 0)
@@ -519,7 +887,7 @@ static int kvstxn_append (kvstxn_t *kt, int current_epoch, json_t *dirent,
             json_decref (ktmp);
             return -1;
         }
-
+insert:
         if (treeobj_insert_entry (dir, final_name, ktmp) < 0) {
             json_decref (ktmp);
             return -1;
@@ -536,7 +904,8 @@ static int kvstxn_append (kvstxn_t *kt, int current_epoch, json_t *dirent,
         return -1;
     }
     else if (treeobj_is_dir (entry)
-             || treeobj_is_dirref (entry)) {
+             || treeobj_is_dirref (entry)
+             || treeobj_is_dirshard (entry)) {
         errno = EISDIR;
         return -1;
     }
@@ -551,6 +920,99 @@ static int kvstxn_append (kvstxn_t *kt, int current_epoch, json_t *dirent,
     return 0;
 }
 
+/* If 'dir' is a dirshard, descend to the dir shard that holds 'name',
+ * copying shards from the cache into the working copy along the way.
+ * Missing shards are created if 'create' is true.  On return, *dirp is
+ * the dir shard, or NULL if the shard does not exist or must be loaded,
+ * in which case *missing_ref is set.
+ */
+static int kvstxn_resolve_shard (kvstxn_t *kt, int current_epoch,
+                                 json_t *dir, const char *name, bool create,
+                                 json_t **dirp, const char **missing_ref)
+{
+    while (treeobj_is_dirshard (dir)) {
+        json_t *shard;
+        int level, index;
+
+        if ((level = treeobj_get_dirshard_level (dir)) < 0
+            || (index = treeobj_dirshard_index (level, name)) < 0)
+            return -1;
+        if (!(shard = treeobj_get_shard (dir, index))) {
+            if (errno != ENOENT)
+                return -1;
+            if (!create) {
+                *dirp = NULL;
+                return 0;
+            }
+            if (!(shard = treeobj_create_dir ()))
+                return -1;
+            if (treeobj_insert_shard (dir, index, shard) < 0) {
+                json_decref (shard);
+                return -1;
+            }
+            json_decref (shard);
+        }
+        else if (treeobj_is_dirref (shard)) {
+            struct cache_entry *entry;
+            const json_t *shardtmp;
+            const char *ref;
+
+            if (treeobj_get_count (shard) != 1
+                || !(ref = treeobj_get_blobref (shard, 0))) {
+                errno = ENOTRECOVERABLE;
+                return -1;
+            }
+            if (!(entry = cache_lookup (kt->ktm->cache, ref, current_epoch))
+                || !cache_entry_get_valid (entry)) {
+                *missing_ref = ref;
+                *dirp = NULL;
+                return 0; /* stall */
+            }
+            if (!(shardtmp = cache_entry_get_treeobj (entry))
+                || (!treeobj_is_dir (shardtmp)
+                    && !treeobj_is_dirshard (shardtmp))) {
+                errno = ENOTRECOVERABLE;
+                return -1;
+            }
+            /* do not corrupt store by modifying orig. */
+            if (!(shard = kvstxn_cow_shard (dir, index, shardtmp)))
+                return -1;
+        }
+        else if (kvstxn_shared (shard)) {
+            if (!(shard = kvstxn_cow_shard (dir, index, shard)))
+                return -1;
+        }
+        dir = shard;
+    }
+    *dirp = dir;
+    return 0;
+}
+
+/* Return true if 'dirent' refers to cached data of an ephemeral
+ * namespace, which a namespace that is not ephemeral must not link to,
+ * as the data is not in the content store.
+ */
+static bool links_ephemeral (kvstxn_t *kt, int current_epoch,
+                             const json_t *dirent)
+{
+    int count, i;
+
+    if (kt->ktm->ephemeral
+        || !(treeobj_is_dirref (dirent) || treeobj_is_valref (dirent))
+        || (count = treeobj_get_count (dirent)) < 0)
+        return false;
+    for (i = 0; i < count; i++) {
+        const char *ref = treeobj_get_blobref (dirent, i);
+        struct cache_entry *entry;
+
+        if (ref
+            && (entry = cache_lookup (kt->ktm->cache, ref, current_epoch))
+            && cache_entry_get_ephemeral (entry))
+            return true;
+    }
+    return false;
+}
+
 /* link (key, dirent) into directory 'dir'.
  */
 static int kvstxn_link_dirent (kvstxn_t *kt, int current_epoch,
@@ -565,6 +1027,11 @@ static int kvstxn_link_dirent (kvstxn_t *kt, int current_epoch,
     json_t *subdir = NULL, *dir_entry;
     int saved_errno, rc = -1;
 
+    if (links_ephemeral (kt, current_epoch, dirent)) {
+        saved_errno = EXDEV;
+        goto done;
+    }
+
     if (!(cpy = kvs_util_normalize_key (key, NULL))) {
         saved_errno = errno;
         goto done;
@@ -586,6 +1053,15 @@ static int kvstxn_link_dirent (kvstxn_t *kt, int current_epoch,
     while ((next = strchr (name, '.'))) {
         *next++ = '\0';
 
+        if (kvstxn_resolve_shard (kt, current_epoch, dir, name,
+                                  !json_is_null (dirent),
+                                  &dir, missing_ref) < 0) {
+            saved_errno = errno;
+            goto done;
+        }
+        if (!dir) /* stall, or key deletion of nonexistent key */
+            goto success;
+
         if (!treeobj_is_dir (dir)) {
             saved_errno = ENOTRECOVERABLE;
             goto done;
@@ -604,8 +1080,16 @@ static int kvstxn_link_dirent (kvstxn_t *kt, int current_epoch,
                 goto done;
             }
             json_decref (subdir);
-        } else if (treeobj_is_dir (dir_entry)) {
-            subdir = dir_entry;
+        } else if (treeobj_is_dir (dir_entry)
+                   || treeobj_is_dirshard (dir_entry)) {
+            if (kvstxn_shared (dir_entry)) {
+                if (!(subdir = kvstxn_cow_entry (dir, name, dir_entry))) {
+                    saved_errno = errno;
+                    goto done;
+                }
+            }
+            else
+                subdir = dir_entry;
         } else if (treeobj_is_dirref (dir_entry)) {
             struct cache_entry *entry;
             const char *ref;
@@ -641,17 +1125,10 @@ static int kvstxn_link_dirent (kvstxn_t *kt, int current_epoch,
             }
 
             /* do not corrupt store by modifying orig. */
-            if (!(subdir = treeobj_deep_copy (subdirktmp))) {
-                saved_errno = errno;
-                goto done;
-            }
-
-            if (treeobj_insert_entry (dir, name, subdir) < 0) {
+            if (!(subdir = kvstxn_cow_entry (dir, name, subdirktmp))) {
                 saved_errno = errno;
-                json_decref (subdir);
                 goto done;
             }
-            json_decref (subdir);
         } else if (treeobj_is_symlink (dir_entry)) {
             const char *ns = NULL;
             const char *target = NULL;
@@ -707,6 +1184,14 @@ static int kvstxn_link_dirent (kvstxn_t *kt, int current_epoch,
     /* This is the final path component of the key.  Add/modify/delete
      * it in the directory.
      */
+    if (kvstxn_resolve_shard (kt, current_epoch, dir, name,
+                              !json_is_null (dirent),
+                              &dir, missing_ref) < 0) {
+        saved_errno = errno;
+        goto done;
+    }
+    if (!dir)
+        goto success;
     if (!json_is_null (dirent)) {
         if (flags & FLUX_KVS_APPEND) {
             if (kvstxn_append (kt,
@@ -828,6 +1313,60 @@ error:
     return NULL;
 }
 
+/* Return the root that the next transaction should be applied to,
+ * the new root of the last transaction on the pending list, or NULL
+ * if there is none and the published root should be used.
+ */
+static const char *pipeline_rootref (kvstxn_mgr_t *ktm)
+{
+    const char *ref = NULL;
+    kvstxn_t *kt;
+
+    kt = zlist_first (ktm->pending);
+    while (kt) {
+        if (!kt->errnum && !kt->aux_errnum)
+            ref = kt->newroot;
+        kt = zlist_next (ktm->pending);
+    }
+    return ref;
+}
+
+/* Move 'kt', the head of the ready list, to the tail of the pending
+ * list.  Its new root is in the cache, so the next transaction may be
+ * applied to it while its dirty cache entries are flushed.
+ *
+ * All ops have been applied, so there is nothing left to fall back to
+ * and any merge components following 'kt' are dropped.
+ */
+static int pipeline_transaction (kvstxn_t *kt)
+{
+    kvstxn_mgr_t *ktm = kt->ktm;
+    kvstxn_t *kt_tmp;
+
+    assert (zlist_first (ktm->ready) == kt);
+    if (zlist_append (ktm->pending, kt) < 0) {
+        errno = ENOMEM;
+        return -1;
+    }
+    zlist_freefn (ktm->pending, kt, (zlist_free_fn *)kvstxn_destroy, true);
+    (void)zlist_pop (ktm->ready);
+    kt->internal_flags |= KVSTXN_PIPELINED;
+
+    while ((kt_tmp = zlist_first (ktm->ready))
+           && (kt_tmp->internal_flags & KVSTXN_MERGE_COMPONENT))
+        zlist_remove (ktm->ready, kt_tmp);
+    return 0;
+}
+
+/* Return true if a transaction ahead of 'kt' on the pending list has
+ * yet to finish.
+ */
+static bool pipeline_predecessor (kvstxn_t *kt)
+{
+    return ((kt->internal_flags & KVSTXN_PIPELINED)
+            && zlist_first (kt->ktm->pending) != kt);
+}
+
 kvstxn_process_t kvstxn_process (kvstxn_t *kt,
                                  int current_epoch,
                                  const char *rootdir_ref)
@@ -845,9 +1384,12 @@ kvstxn_process_t kvstxn_process (kvstxn_t *kt,
     case KVSTXN_STATE_INIT:
     case KVSTXN_STATE_LOAD_ROOT:
     {
-        /* Make a copy of the root directory.
+        /* Make a copy of the root directory.  If earlier
+         * transactions are still being stored, apply to the newest
+         * root in the pipeline rather than the published one.
          */
         struct cache_entry *entry;
+        const char *pipeline_ref;
 
         /* Caller didn't call kvstxn_iter_missing_refs() */
         if (zlist_first (kt->missing_refs_list))
@@ -855,6 +1397,9 @@ kvstxn_process_t kvstxn_process (kvstxn_t *kt,
 
         kt->state = KVSTXN_STATE_LOAD_ROOT;
 
+        if ((pipeline_ref = pipeline_rootref (kt->ktm)))
+            rootdir_ref = pipeline_ref;
+
         if (!(entry = cache_lookup (kt->ktm->cache,
                                     rootdir_ref,
                                     current_epoch))
@@ -876,7 +1421,7 @@ kvstxn_process_t kvstxn_process (kvstxn_t *kt,
         cache_entry_incref (entry);
         kt->entry = entry;
 
-        if (!(kt->rootcpy = treeobj_deep_copy (kt->rootdir))) {
+        if (!(kt->rootcpy = treeobj_copy (kt->rootdir))) {
             kt->errnum = errno;
             return KVSTXN_PROCESS_ERROR;
         }
@@ -950,7 +1495,7 @@ kvstxn_process_t kvstxn_process (kvstxn_t *kt,
              * fresh rootcpy on the replay. */
             if (append) {
                 json_decref (kt->rootcpy);
-                if (!(kt->rootcpy = treeobj_deep_copy (kt->rootdir))) {
+                if (!(kt->rootcpy = treeobj_copy (kt->rootdir))) {
                     kt->errnum = errno;
                     return KVSTXN_PROCESS_ERROR;
                 }
@@ -970,24 +1515,13 @@ kvstxn_process_t kvstxn_process (kvstxn_t *kt,
          * Flushes to content cache are asynchronous but we don't
          * proceed until they are completed.
          */
-        struct cache_entry *entry;
-        int sret;
-
-        if (kvstxn_unroll (kt, current_epoch, kt->rootcpy) < 0)
-            kt->errnum = errno;
-        else if ((sret = store_cache (kt,
-                                      current_epoch,
-                                      kt->rootcpy,
-                                      false,
-                                      kt->newroot,
-                                      sizeof (kt->newroot),
-                                      &entry)) < 0)
+        if (kvstxn_store_dir (kt,
+                              current_epoch,
+                              kt->rootcpy,
+                              0,
+                              kt->newroot,
+                              sizeof (kt->newroot)) < 0)
             kt->errnum = errno;
-        else if (sret
-                 && zlist_push (kt->dirty_cache_entries_list, entry) < 0) {
-            kvstxn_cleanup_dirty_cache_entry (kt, entry);
-            kt->errnum = ENOMEM;
-        }
 
         if (kt->errnum) {
             cleanup_dirty_cache_list (kt);
@@ -1001,6 +1535,14 @@ kvstxn_process_t kvstxn_process (kvstxn_t *kt,
         json_decref (kt->rootcpy);
         kt->rootcpy = NULL;
 
+        if (kt->ktm->pipeline) {
+            if (pipeline_transaction (kt) < 0) {
+                kt->errnum = errno;
+                cleanup_dirty_cache_list (kt);
+                return KVSTXN_PROCESS_ERROR;
+            }
+        }
+
         /* fallthrough */
     }
     case KVSTXN_STATE_PRE_FINISHED:
@@ -1010,6 +1552,10 @@ kvstxn_process_t kvstxn_process (kvstxn_t *kt,
         if (zlist_first (kt->dirty_cache_entries_list))
             goto stall_store;
 
+        /* setroot must be published in transaction order */
+        if (pipeline_predecessor (kt))
+            goto stall_setroot;
+
         /* now generate keys for setroot */
         if (!(kt->keys = keys_from_ops (kt->ops))) {
             kt->errnum = ENOMEM;
@@ -1035,6 +1581,12 @@ kvstxn_process_t kvstxn_process (kvstxn_t *kt,
  stall_store:
     kt->blocked = 1;
     return KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES;
+
+ stall_setroot:
+    /* not blocked, kvstxn_mgr_get_ready_transaction() returns kt
+     * again once it reaches the head of the pending list */
+    kt->blocked = 0;
+    return KVSTXN_PROCESS_SETROOT_PENDING;
 }
 
 int kvstxn_iter_missing_refs (kvstxn_t *kt, kvstxn_ref_f cb, void *data)
@@ -1120,6 +1672,10 @@ kvstxn_mgr_t *kvstxn_mgr_create (struct cache *cache,
         saved_errno = ENOMEM;
         goto error;
     }
+    if (!(ktm->pending = zlist_new ())) {
+        saved_errno = ENOMEM;
+        goto error;
+    }
     ktm->h = h;
     ktm->aux = aux;
     return ktm;
@@ -1133,6 +1689,8 @@ kvstxn_mgr_t *kvstxn_mgr_create (struct cache *cache,
 void kvstxn_mgr_destroy (kvstxn_mgr_t *ktm)
 {
     if (ktm) {
+        if (ktm->pending)
+            zlist_destroy (&ktm->pending);
         if (ktm->ready)
             zlist_destroy (&ktm->ready);
         free (ktm);
@@ -1167,23 +1725,68 @@ int kvstxn_mgr_add_transaction (kvstxn_mgr_t *ktm,
     return 0;
 }
 
-bool kvstxn_mgr_transaction_ready (kvstxn_mgr_t *ktm)
+/* The head of the pending list may finish once its stores are done.
+ * The head of the ready list may start while the pending list is
+ * still being stored.
+ */
+static kvstxn_t *ready_transaction (kvstxn_mgr_t *ktm)
 {
     kvstxn_t *kt;
 
+    if ((kt = zlist_first (ktm->pending)) && !kt->blocked)
+        return kt;
     if ((kt = zlist_first (ktm->ready)) && !kt->blocked)
-        return true;
-    return false;
+        return kt;
+    return NULL;
+}
+
+bool kvstxn_mgr_transaction_ready (kvstxn_mgr_t *ktm)
+{
+    return ready_transaction (ktm) ? true : false;
 }
 
 kvstxn_t *kvstxn_mgr_get_ready_transaction (kvstxn_mgr_t *ktm)
 {
-    if (kvstxn_mgr_transaction_ready (ktm)) {
-        kvstxn_t *kt = zlist_first (ktm->ready);
+    kvstxn_t *kt;
+
+    if ((kt = ready_transaction (ktm)))
         kt->internal_flags |= KVSTXN_PROCESSING;
-        return kt;
+    return kt;
+}
+
+/* Return 'kt' to its initial state, so that it is applied again from
+ * the start.  Any stall in progress is unaffected, the replay simply
+ * begins at KVSTXN_STATE_INIT.
+ */
+static void kvstxn_restart (kvstxn_t *kt)
+{
+    json_decref (kt->rootcpy);
+    kt->rootcpy = NULL;
+    kt->rootdir = NULL;
+    cache_entry_decref (kt->entry);
+    kt->entry = NULL;
+    kt->state = KVSTXN_STATE_INIT;
+}
+
+/* Pipelined transaction 'kt' failed, so its new root will never be
+ * published.  Cancel the pending transactions that were applied on top
+ * of it, and restart the head of the ready list if it has begun.
+ */
+static void pipeline_cancel (kvstxn_mgr_t *ktm, kvstxn_t *kt)
+{
+    kvstxn_t *kt_tmp;
+
+    kt_tmp = zlist_first (ktm->pending);
+    while (kt_tmp && kt_tmp != kt)
+        kt_tmp = zlist_next (ktm->pending);
+    while ((kt_tmp = zlist_next (ktm->pending))) {
+        if (!kt_tmp->aux_errnum)
+            kt_tmp->aux_errnum = ECANCELED;
     }
-    return NULL;
+    if ((kt_tmp = zlist_first (ktm->ready))
+        && kt_tmp->state > KVSTXN_STATE_INIT
+        && kt_tmp->state <= KVSTXN_STATE_APPLY_OPS)
+        kvstxn_restart (kt_tmp);
 }
 
 void kvstxn_mgr_remove_transaction (kvstxn_mgr_t *ktm, kvstxn_t *kt,
@@ -1191,23 +1794,30 @@ void kvstxn_mgr_remove_transaction (kvstxn_mgr_t *ktm, kvstxn_t *kt,
 {
     if (kt->internal_flags & KVSTXN_PROCESSING) {
         bool kvstxn_is_merged = false;
+        zlist_t *list = ktm->ready;
 
         if (kt->internal_flags & KVSTXN_MERGED)
             kvstxn_is_merged = true;
 
-        zlist_remove (ktm->ready, kt);
+        if (kt->internal_flags & KVSTXN_PIPELINED) {
+            list = ktm->pending;
+            if (kt->state != KVSTXN_STATE_FINISHED)
+                pipeline_cancel (ktm, kt);
+        }
+
+        zlist_remove (list, kt);
 
         if (kvstxn_is_merged) {
-            kvstxn_t *kt_tmp = zlist_first (ktm->ready);
+            kvstxn_t *kt_tmp = zlist_first (list);
             while (kt_tmp && (kt_tmp->internal_flags & KVSTXN_MERGE_COMPONENT)) {
                 if (fallback) {
                     kt_tmp->internal_flags &= ~KVSTXN_MERGE_COMPONENT;
                     kt_tmp->flags |= FLUX_KVS_NO_MERGE;
                 }
                 else
-                    zlist_remove (ktm->ready, kt_tmp);
+                    zlist_remove (list, kt_tmp);
 
-                kt_tmp = zlist_next (ktm->ready);
+                kt_tmp = zlist_next (list);
             }
         }
     }
@@ -1223,9 +1833,44 @@ void kvstxn_mgr_clear_noop_stores (kvstxn_mgr_t *ktm)
     ktm->noop_stores = 0;
 }
 
+void kvstxn_mgr_set_treeobj_binary (kvstxn_mgr_t *ktm, bool enable)
+{
+    ktm->treeobj_binary = enable;
+}
+
+void kvstxn_mgr_set_dirshard_threshold (kvstxn_mgr_t *ktm, int count)
+{
+    ktm->dirshard_threshold = count;
+}
+
+void kvstxn_mgr_set_pipeline (kvstxn_mgr_t *ktm, bool enable)
+{
+    ktm->pipeline = enable;
+}
+
+void kvstxn_mgr_set_append_blob_size (kvstxn_mgr_t *ktm, int size)
+{
+    ktm->append_blob_size = size;
+}
+
+void kvstxn_mgr_set_ephemeral (kvstxn_mgr_t *ktm, bool enable)
+{
+    ktm->ephemeral = enable;
+}
+
+int kvstxn_mgr_get_append_merges (kvstxn_mgr_t *ktm)
+{
+    return ktm->append_merges;
+}
+
+void kvstxn_mgr_clear_append_merges (kvstxn_mgr_t *ktm)
+{
+    ktm->append_merges = 0;
+}
+
 int kvstxn_mgr_ready_transaction_count (kvstxn_mgr_t *ktm)
 {
-    return zlist_size (ktm->ready);
+    return zlist_size (ktm->ready) + zlist_size (ktm->pending);
 }
 
 static int kvstxn_merge (kvstxn_t *dest, kvstxn_t *src)
@@ -1302,6 +1947,7 @@ int kvstxn_mgr_merge_ready_transactions (kvstxn_mgr_t *ktm)
      * applied */
     first = zlist_first (ktm->ready);
     if (!first
+        || first->blocked
         || first->errnum != 0
         || first->aux_errnum != 0
         || first->state > KVSTXN_STATE_APPLY_OPS
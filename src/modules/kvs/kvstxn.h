@@ -24,6 +24,7 @@ typedef enum {
     KVSTXN_PROCESS_LOAD_MISSING_REFS = 2,
     KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES = 3,
     KVSTXN_PROCESS_FINISHED = 4,
+    KVSTXN_PROCESS_SETROOT_PENDING = 5,
 } kvstxn_process_t;
 
 /*
@@ -83,6 +84,8 @@ json_t *kvstxn_get_keys (kvstxn_t *kt);
  * KVSTXN_PROCESS_LOAD_MISSING_REFS stall & load,
  * KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES stall & process dirty cache
  * entries,
+ * KVSTXN_PROCESS_SETROOT_PENDING stall until earlier pipelined
+ * transactions finish,
  * KVSTXN_PROCESS_FINISHED all done
  *
  * on error, call kvstxn_get_errnum() to get error number
@@ -92,6 +95,9 @@ json_t *kvstxn_get_keys (kvstxn_t *kt);
  * on stall & process dirty cache entries, call
  * kvstxn_iter_dirty_cache_entries() to process entries.
  *
+ * on stall & setroot pending, there is nothing to do.  The transaction
+ * is returned by kvstxn_mgr_get_ready_transaction() once it may finish.
+ *
  * on completion, call kvstxn_get_newroot_ref() to get reference to
  * new root to be stored.
  */
@@ -178,7 +184,47 @@ void kvstxn_mgr_remove_transaction (kvstxn_mgr_t *ktm, kvstxn_t *kt,
 int kvstxn_mgr_get_noop_stores (kvstxn_mgr_t *ktm);
 void kvstxn_mgr_clear_noop_stores (kvstxn_mgr_t *ktm);
 
-/* return count of ready transactions */
+/* If enabled, directories are stored with treeobj_encode_binary()
+ * instead of treeobj_encode().  Disabled by default.
+ */
+void kvstxn_mgr_set_treeobj_binary (kvstxn_mgr_t *ktm, bool enable);
+
+/* Store directories with more than 'count' entries as dirshards, so
+ * that a change to one entry rewrites only the shards leading to it.
+ * If 'count' is 0 (the default), directories are never sharded.
+ */
+void kvstxn_mgr_set_dirshard_threshold (kvstxn_mgr_t *ktm, int count);
+
+/* If enabled, once a transaction's new root has been written to the
+ * cache, the next ready transaction may be applied to that root while
+ * the first transaction's dirty cache entries are still being flushed.
+ * Transactions still finish in order.  If a pipelined transaction fails,
+ * the pipelined transactions after it fail with ECANCELED.  Disabled
+ * by default.
+ */
+void kvstxn_mgr_set_pipeline (kvstxn_mgr_t *ktm, bool enable);
+
+/* If 'size' > 0, an append to a key whose last blob is cached and smaller
+ * than 'size' bytes is merged into that blob, as long as the result is
+ * at most 'size' bytes, instead of adding a blob to the key's valref.
+ * kvstxn_mgr_get_append_merges() returns the number of merged appends,
+ * kvstxn_mgr_clear_append_merges() resets it.
+ * Disabled (0) by default.
+ */
+void kvstxn_mgr_set_append_blob_size (kvstxn_mgr_t *ktm, int size);
+int kvstxn_mgr_get_append_merges (kvstxn_mgr_t *ktm);
+void kvstxn_mgr_clear_append_merges (kvstxn_mgr_t *ktm);
+
+/* Mark 'ktm' as belonging to an ephemeral namespace, whose dirty cache
+ * entries the caller keeps in the cache with the ephemeral bit set
+ * instead of writing them to the content store.  A transaction of a
+ * namespace that is not ephemeral returns cached ephemeral data that it
+ * references as a dirty cache entry, so that it is written after all.
+ * Disabled by default.
+ */
+void kvstxn_mgr_set_ephemeral (kvstxn_mgr_t *ktm, bool enable);
+
+/* return count of ready transactions, including pipelined ones */
 int kvstxn_mgr_ready_transaction_count (kvstxn_mgr_t *ktm);
 
 /* In internally stored ready transactions (moved to ready status via
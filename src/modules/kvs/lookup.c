@@ -23,6 +23,7 @@
 #include <jansson.h>
 
 #include "src/common/libutil/blobref.h"
+#include "src/common/libutil/lru_cache.h"
 #include "src/common/libkvs/treeobj.h"
 #include "src/common/libkvs/kvs_util_private.h"
 
@@ -35,6 +36,15 @@
  */
 #define SYMLINK_CYCLE_LIMIT 10
 
+/* Do not keep values larger than this (base64 encoded) in the
+ * lookup result cache.
+ */
+#define LOOKUP_CACHE_MAX_VALSIZE 65536
+
+struct lookup_cache {
+    lru_cache_t *lru;
+};
+
 typedef struct {
     int depth;
     char *path_copy;            /* for internal parsing, do not use */
@@ -80,6 +90,10 @@ struct lookup {
     const json_t *valref_missing_refs;
     const char *missing_ref;
 
+    /* dirref listing dirshard shards that must be loaded to read a
+     * sharded directory */
+    json_t *missing_shards;
+
     /* for namespace callback */
 
     char *missing_namespace;
@@ -87,6 +101,19 @@ struct lookup {
     int errnum;                 /* errnum if error */
     int aux_errnum;
 
+    struct lookup_stats *stats;
+    struct lookup_cache *result_cache;
+    bool result_cacheable;      /* false if walk left the namespace */
+    bool symlink_followed;      /* walk followed a symlink */
+    bool return_dirent;
+
+    /* append position, see lookup_set_append_position() */
+    bool append;
+    int append_index;
+    int append_offset;
+    int append_end_index;
+    int append_end_offset;
+
     /* API internal */
     zlist_t *levels;
     const json_t *wdirent;       /* result after walk() */
@@ -293,8 +320,15 @@ static lookup_process_t walk_symlink (lookup_t *lh,
             goto cleanup;
         }
 
+        /* The result depends on keys outside the path, so it is not
+         * cached, and lookup_get_symlink_followed() reports it.
+         */
+        lh->symlink_followed = true;
+        lh->result_cacheable = false;
+
         if (ns) {
             lookup_process_t nsret;
+            lh->result_cacheable = false;
             nsret = symlink_check_namespace (lh,
                                              ns,
                                              &root);
@@ -358,6 +392,186 @@ cleanup:
  * in load ref, which caller should then use to load missing reference
  * into KVS cache.
  */
+/* Get the treeobj that 'dirref' points to, which must be a dir or
+ * dirshard.  If it is not in the cache, set *stall and return NULL
+ * without error.  On error, set lh->errnum and return NULL.
+ */
+static const json_t *get_dirref_dir (lookup_t *lh,
+                                     const json_t *dirref,
+                                     struct cache_entry **entryp,
+                                     bool *stall)
+{
+    struct cache_entry *entry;
+    const json_t *dir;
+    const char *ref;
+    int refcount;
+
+    if ((refcount = treeobj_get_count (dirref)) < 0) {
+        lh->errnum = errno;
+        return NULL;
+    }
+    if (refcount != 1) {
+        flux_log (lh->h, LOG_ERR, "invalid dirref count: %d", refcount);
+        lh->errnum = ENOTRECOVERABLE;
+        return NULL;
+    }
+    if (!(ref = treeobj_get_blobref (dirref, 0))) {
+        lh->errnum = errno;
+        return NULL;
+    }
+    if (!(entry = cache_lookup (lh->cache, ref, lh->current_epoch))
+        || !cache_entry_get_valid (entry)) {
+        lh->missing_ref = ref;
+        (*stall) = true;
+        return NULL;
+    }
+    if (!(dir = cache_entry_get_treeobj (entry))
+        || (!treeobj_is_dir (dir) && !treeobj_is_dirshard (dir))) {
+        flux_log (lh->h, LOG_ERR, "dirref points to non-dir");
+        lh->errnum = ENOTRECOVERABLE;
+        return NULL;
+    }
+    if (entryp)
+        (*entryp) = entry;
+    (*stall) = false;
+    return dir;
+}
+
+/* Descend from dirshard 'dir' to the dir shard that holds 'name'.
+ * On success, *dirp and *entryp are updated to the shard and the cache
+ * entry holding it, or *dirp is set to NULL if the shard doesn't exist.
+ */
+static lookup_process_t walk_dirshard (lookup_t *lh,
+                                       const char *name,
+                                       const json_t **dirp,
+                                       struct cache_entry **entryp)
+{
+    const json_t *dir = *dirp;
+
+    while (treeobj_is_dirshard (dir)) {
+        const json_t *shard;
+        bool stall;
+        int level, index;
+
+        if ((level = treeobj_get_dirshard_level (dir)) < 0
+            || (index = treeobj_dirshard_index (level, name)) < 0) {
+            lh->errnum = errno;
+            return LOOKUP_PROCESS_ERROR;
+        }
+        if (!(shard = treeobj_peek_shard (dir, index))) {
+            if (errno != ENOENT) {
+                lh->errnum = errno;
+                return LOOKUP_PROCESS_ERROR;
+            }
+            (*dirp) = NULL;
+            return LOOKUP_PROCESS_FINISHED;
+        }
+        if (!treeobj_is_dirref (shard)) {
+            lh->errnum = ENOTRECOVERABLE;
+            return LOOKUP_PROCESS_ERROR;
+        }
+        if (!(dir = get_dirref_dir (lh, shard, entryp, &stall))) {
+            if (stall)
+                return LOOKUP_PROCESS_LOAD_MISSING_REFS;
+            return LOOKUP_PROCESS_ERROR;
+        }
+    }
+    (*dirp) = dir;
+    return LOOKUP_PROCESS_FINISHED;
+}
+
+/* Add all dir shard entries under 'dirshard' to 'dir'.  Shards that are
+ * not in the cache are appended to lh->missing_shards and skipped, so
+ * they can all be loaded at once.
+ */
+static int merge_dirshard (lookup_t *lh, json_t *dir, const json_t *dirshard)
+{
+    int i;
+
+    for (i = 0; i < TREEOBJ_DIRSHARD_WIDTH; i++) {
+        const json_t *shard, *sharddir;
+        const json_t *dir_data;
+        const char *name;
+        json_t *o;
+        bool stall;
+
+        if (!(shard = treeobj_peek_shard (dirshard, i)))
+            continue;
+        if (!treeobj_is_dirref (shard)) {
+            lh->errnum = ENOTRECOVERABLE;
+            return -1;
+        }
+        if (!(sharddir = get_dirref_dir (lh, shard, NULL, &stall))) {
+            if (!stall)
+                return -1;
+            if (!lh->missing_shards
+                && !(lh->missing_shards = treeobj_create_dirref (NULL))) {
+                lh->errnum = errno;
+                return -1;
+            }
+            if (treeobj_append_blobref (lh->missing_shards,
+                                        lh->missing_ref) < 0) {
+                lh->errnum = errno;
+                return -1;
+            }
+            continue;
+        }
+        if (treeobj_is_dirshard (sharddir)) {
+            if (merge_dirshard (lh, dir, sharddir) < 0)
+                return -1;
+            continue;
+        }
+        dir_data = treeobj_get_data ((json_t *)sharddir);
+        json_object_foreach ((json_t *)dir_data, name, o) {
+            json_t *cpy;
+            if (!(cpy = treeobj_deep_copy (o))
+                || treeobj_insert_entry_novalidate (dir, name, cpy) < 0) {
+                lh->errnum = errno;
+                json_decref (cpy);
+                return -1;
+            }
+            json_decref (cpy);
+        }
+    }
+    return 0;
+}
+
+/* Set lh->val to a copy of 'dir'.  If 'dir' is a dirshard, it is
+ * returned as the equivalent dir.  On success, 'stall' should be checked.
+ */
+static int get_dir_value (lookup_t *lh, const json_t *dir, bool *stall)
+{
+    json_t *val;
+
+    json_decref (lh->missing_shards);
+    lh->missing_shards = NULL;
+
+    if (!treeobj_is_dirshard (dir)) {
+        if (!(lh->val = treeobj_deep_copy (dir))) {
+            lh->errnum = errno;
+            return -1;
+        }
+        (*stall) = false;
+        return 0;
+    }
+    if (!(val = treeobj_create_dir ())) {
+        lh->errnum = errno;
+        return -1;
+    }
+    if (merge_dirshard (lh, val, dir) < 0) {
+        json_decref (val);
+        return -1;
+    }
+    if (lh->missing_shards) {
+        json_decref (val);
+        (*stall) = true;
+        return 0;
+    }
+    lh->val = val;
+    (*stall) = false;
+    return 0;
+}
+
 static lookup_process_t walk (lookup_t *lh)
 {
     const json_t *dir;
@@ -409,7 +623,7 @@ static lookup_process_t walk (lookup_t *lh)
                     lh->errnum = ENOTRECOVERABLE;
                 goto error;
             }
-            if (!treeobj_is_dir (dir)) {
+            if (!treeobj_is_dir (dir) && !treeobj_is_dirshard (dir)) {
                 /* dirref pointed to non-dir error, special case when
                  * root_dirent is bad, is EINVAL from user.
                  */
@@ -440,6 +654,21 @@ static lookup_process_t walk (lookup_t *lh)
             }
         }
 
+        /* If directory is sharded, find the shard holding path component */
+
+        if (treeobj_is_dirshard (dir)) {
+            lookup_process_t sret;
+
+            sret = walk_dirshard (lh, pathcomp, &dir, &entry);
+            if (sret != LOOKUP_PROCESS_FINISHED) {
+                if (sret == LOOKUP_PROCESS_ERROR)
+                    goto error;
+                return sret;
+            }
+            if (!dir)
+                goto done;
+        }
+
         /* Get directory reference of path component from directory */
 
         if (!(dirent_tmp = treeobj_peek_entry (dir, pathcomp))) {
@@ -582,6 +811,7 @@ lookup_t *lookup_create (struct cache *cache,
     }
 
     lh->wdirent = NULL;
+    lh->result_cacheable = true;
     lh->state = LOOKUP_STATE_INIT;
 
     return lh;
@@ -599,6 +829,7 @@ void lookup_destroy (lookup_t *lh)
         free (lh->root_ref);
         free (lh->path);
         json_decref (lh->val);
+        json_decref (lh->missing_shards);
         free (lh->missing_namespace);
         zlist_destroy (&lh->levels);
         free (lh);
@@ -650,22 +881,32 @@ int lookup_iter_missing_refs (lookup_t *lh, lookup_ref_f cb, void *data)
         && (lh->state == LOOKUP_STATE_CHECK_ROOT
             || lh->state == LOOKUP_STATE_WALK
             || lh->state == LOOKUP_STATE_VALUE)) {
-        if (lh->valref_missing_refs) {
+        int count = 0;
+
+        if (lh->missing_shards || lh->valref_missing_refs) {
+            const json_t *refs = lh->missing_shards ? lh->missing_shards
+                                                    : lh->valref_missing_refs;
             int refcount, i;
 
-            if (!treeobj_is_valref (lh->valref_missing_refs)) {
+            if (!lh->missing_shards
+                && !treeobj_is_valref (lh->valref_missing_refs)) {
                 errno = ENOTRECOVERABLE;
                 return -1;
             }
 
-            refcount = treeobj_get_count (lh->valref_missing_refs);
+            refcount = treeobj_get_count (refs);
             assert (refcount > 0);
 
-            for (i = 0; i < refcount; i++) {
+            /* data before the append position is not needed */
+            i = 0;
+            if (!lh->missing_shards && lh->append)
+                i = lh->append_index;
+
+            for (; i < refcount; i++) {
                 struct cache_entry *entry;
                 const char *ref;
 
-                if (!(ref = treeobj_get_blobref (lh->valref_missing_refs, i)))
+                if (!(ref = treeobj_get_blobref (refs, i)))
                     return -1;
 
                 if (!(entry = cache_lookup (lh->cache, ref, lh->current_epoch))
@@ -675,12 +916,19 @@ int lookup_iter_missing_refs (lookup_t *lh, lookup_ref_f cb, void *data)
                      * true */
                     if (cb (lh, ref, data) < 0)
                         return -1;
+                    count++;
                 }
             }
         }
         else {
             if (cb (lh, lh->missing_ref, data) < 0)
                 return -1;
+            count++;
+        }
+        if (lh->stats) {
+            lh->stats->stalls++;
+            if (count > 1)
+                lh->stats->stalls_avoided += count - 1;
         }
         return 0;
     }
@@ -688,6 +936,189 @@ int lookup_iter_missing_refs (lookup_t *lh, lookup_ref_f cb, void *data)
     return -1;
 }
 
+int lookup_iter_prefetch_refs (lookup_t *lh, lookup_ref_f cb, void *data)
+{
+    const char *name;
+    json_t *dir_data;
+    json_t *o;
+    int count = 0;
+
+    if (!lh || lh->state != LOOKUP_STATE_FINISHED) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (lh->errnum
+        || !(lh->flags & FLUX_KVS_READDIR)
+        || (lh->flags & FLUX_KVS_TREEOBJ)
+        || !treeobj_is_dir (lh->val))
+        return 0;
+    dir_data = treeobj_get_data (lh->val);
+    json_object_foreach (dir_data, name, o) {
+        const char *ref;
+
+        if (count == LOOKUP_PREFETCH_MAX)
+            break;
+        if (!treeobj_is_dirref (o)
+            || treeobj_get_count (o) != 1
+            || !(ref = treeobj_get_blobref (o, 0)))
+            continue;
+        if (!cache_lookup (lh->cache, ref, lh->current_epoch)) {
+            if (cb (lh, ref, data) < 0)
+                return -1;
+            count++;
+        }
+    }
+    if (lh->stats)
+        lh->stats->prefetches += count;
+    return 0;
+}
+
+void lookup_set_stats (lookup_t *lh, struct lookup_stats *stats)
+{
+    if (lh)
+        lh->stats = stats;
+}
+
+void lookup_set_return_dirent (lookup_t *lh, bool val)
+{
+    if (lh)
+        lh->return_dirent = val;
+}
+
+void lookup_set_append_position (lookup_t *lh, int index, int offset)
+{
+    if (lh) {
+        lh->append = true;
+        lh->append_index = index;
+        lh->append_offset = offset;
+        lh->append_end_index = -1;
+    }
+}
+
+int lookup_get_append_position (lookup_t *lh, int *index, int *offset)
+{
+    if (!lh
+        || !lh->append
+        || lh->state != LOOKUP_STATE_FINISHED
+        || lh->errnum
+        || lh->append_end_index < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (index)
+        (*index) = lh->append_end_index;
+    if (offset)
+        (*offset) = lh->append_end_offset;
+    return 0;
+}
+
+void lookup_set_result_cache (lookup_t *lh, struct lookup_cache *lc)
+{
+    if (lh)
+        lh->result_cache = lc;
+}
+
+static void lookup_cache_free (void *data)
+{
+    json_decref (data);
+}
+
+struct lookup_cache *lookup_cache_create (int maxsize)
+{
+    struct lookup_cache *lc;
+
+    if (maxsize <= 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(lc = calloc (1, sizeof (*lc))))
+        return NULL;
+    if (!(lc->lru = lru_cache_create (maxsize))) {
+        free (lc);
+        errno = ENOMEM;
+        return NULL;
+    }
+    lru_cache_set_free_f (lc->lru, lookup_cache_free);
+    return lc;
+}
+
+void lookup_cache_destroy (struct lookup_cache *lc)
+{
+    if (lc) {
+        int saved_errno = errno;
+        lru_cache_destroy (lc->lru);
+        free (lc);
+        errno = saved_errno;
+    }
+}
+
+int lookup_cache_count (struct lookup_cache *lc)
+{
+    return lc ? lru_cache_size (lc->lru) : 0;
+}
+
+static char *result_cache_key (lookup_t *lh)
+{
+    char *key;
+
+    if (asprintf (&key, "%s %d %s", lh->root_ref, lh->flags, lh->path) < 0)
+        return NULL;
+    return key;
+}
+
+/* On a hit, set lh->val and return true.  A cached JSON null records
+ * a lookup that found nothing.
+ */
+static bool result_cache_get (lookup_t *lh)
+{
+    json_t *val;
+    char *key;
+
+    if (!lh->result_cache
+        || lh->return_dirent
+        || lh->append
+        || !(key = result_cache_key (lh)))
+        return false;
+    val = lru_cache_get (lh->result_cache->lru, key);
+    free (key);
+    if (!val)
+        return false;
+    lh->val = json_is_null (val) ? NULL : json_incref (val);
+    if (lh->stats)
+        lh->stats->result_hits++;
+    return true;
+}
+
+static void result_cache_put (lookup_t *lh)
+{
+    json_t *val;
+    char *key;
+
+    if (!lh->result_cache
+        || !lh->result_cacheable
+        || lh->return_dirent
+        || lh->append)
+        return;
+    if (lh->val) {
+        if (treeobj_is_dir (lh->val))
+            return;
+        if (treeobj_is_val (lh->val)
+            && json_string_length (treeobj_get_data (lh->val))
+                                   > LOOKUP_CACHE_MAX_VALSIZE)
+            return;
+        val = json_incref (lh->val);
+    }
+    else
+        val = json_null ();
+    if (!(key = result_cache_key (lh))) {
+        json_decref (val);
+        return;
+    }
+    if (lru_cache_put (lh->result_cache->lru, key, val) < 0)
+        json_decref (val);
+    free (key);
+}
+
 const char *lookup_missing_namespace (lookup_t *lh)
 {
    if (lh
@@ -727,6 +1158,13 @@ int lookup_get_root_seq (lookup_t *lh)
     return -1;
 }
 
+bool lookup_get_symlink_followed (lookup_t *lh)
+{
+    if (lh && lh->state == LOOKUP_STATE_FINISHED)
+        return lh->symlink_followed;
+    return true;
+}
+
 int lookup_set_current_epoch (lookup_t *lh, int epoch)
 {
     if (lh) {
@@ -904,12 +1342,133 @@ done:
     return rc;
 }
 
+/* Get the data of valref blobs from the append position to the end.
+ * return 0 on success, -1 on failure.  On success, stall should be
+ * checked */
+static int get_append_valref_value (lookup_t *lh, int refcount, bool *stall)
+{
+    struct cache_entry *entry;
+    const char *reftmp;
+    const void *valdata;
+    char *valbuf = NULL;
+    int total = 0;
+    int pos = 0;
+    int len;
+    int i;
+    int rc = -1;
+
+    if (lh->append_index < 0
+        || lh->append_index >= refcount
+        || lh->append_offset < 0) {
+        lh->errnum = EINVAL;
+        return -1;
+    }
+    for (i = lh->append_index; i < refcount; i++) {
+        if (!(reftmp = treeobj_get_blobref (lh->wdirent, i))) {
+            lh->errnum = errno;
+            return -1;
+        }
+        if (!(entry = cache_lookup (lh->cache, reftmp, lh->current_epoch))
+            || !cache_entry_get_valid (entry)) {
+            lh->valref_missing_refs = lh->wdirent;
+            (*stall) = true;
+            return 0;
+        }
+        if (cache_entry_get_raw (entry, NULL, &len) < 0) {
+            flux_log (lh->h, LOG_ERR, "cache_entry_get_raw");
+            lh->errnum = ENOTRECOVERABLE;
+            return -1;
+        }
+        if (i == lh->append_index) {
+            /* value was overwritten or truncated */
+            if (lh->append_offset > len) {
+                lh->errnum = EINVAL;
+                return -1;
+            }
+            len -= lh->append_offset;
+        }
+        if (len > (INT_MAX - total)) {
+            lh->errnum = EOVERFLOW;
+            return -1;
+        }
+        total += len;
+    }
+
+    if (total > 0 && !(valbuf = malloc (total))) {
+        lh->errnum = errno;
+        return -1;
+    }
+    for (i = lh->append_index; i < refcount; i++) {
+        int ret;
+        int offset = i == lh->append_index ? lh->append_offset : 0;
+
+        reftmp = treeobj_get_blobref (lh->wdirent, i);
+        assert (reftmp);
+
+        entry = cache_lookup (lh->cache, reftmp, lh->current_epoch);
+        assert (entry);
+
+        ret = cache_entry_get_raw (entry, &valdata, &len);
+        assert (ret == 0);
+
+        if (len > offset) {
+            memcpy (valbuf + pos, (const char *)valdata + offset, len - offset);
+            pos += len - offset;
+        }
+    }
+    assert (pos == total);
+
+    if (!(lh->val = treeobj_create_val (valbuf, total))) {
+        lh->errnum = errno;
+        goto done;
+    }
+    lh->append_end_index = refcount - 1;
+    lh->append_end_offset = len;
+    (*stall) = false;
+    rc = 0;
+done:
+    free (valbuf);
+    return rc;
+}
+
+/* Get the data of an inline val from the append position, where the
+ * val is treated as blob 0.
+ */
+static int get_append_val_value (lookup_t *lh)
+{
+    void *data;
+    int len;
+    int rc = -1;
+
+    if (treeobj_decode_val (lh->wdirent, &data, &len) < 0) {
+        lh->errnum = errno;
+        return -1;
+    }
+    if (lh->append_index != 0
+        || lh->append_offset < 0
+        || lh->append_offset > len) {
+        lh->errnum = EINVAL;
+        goto done;
+    }
+    if (!(lh->val = treeobj_create_val ((char *)data + lh->append_offset,
+                                        len - lh->append_offset))) {
+        lh->errnum = errno;
+        goto done;
+    }
+    lh->append_end_index = 0;
+    lh->append_end_offset = len;
+    rc = 0;
+done:
+    free (data);
+    return rc;
+}
+
 lookup_process_t lookup (lookup_t *lh)
 {
     const json_t *valtmp = NULL;
-    const char *reftmp;
     struct cache_entry *entry;
     bool is_replay = false;
+    bool stall;
     int refcount;
 
     if (!lh) {
@@ -969,6 +1528,10 @@ lookup_process_t lookup (lookup_t *lh)
                 if (namespace_still_valid (lh) < 0)
                     goto error;
             }
+            else if (result_cache_get (lh)) {
+                lh->result_cacheable = false; /* already cached */
+                goto done;
+            }
 
             /* special case root */
             if (!strcmp (lh->path, ".")) {
@@ -995,15 +1558,16 @@ lookup_process_t lookup (lookup_t *lh)
                         lh->errnum = EINVAL;
                         goto error;
                     }
-                    if (!treeobj_is_dir (valtmp)) {
+                    if (!treeobj_is_dir (valtmp)
+                        && !treeobj_is_dirshard (valtmp)) {
                         /* root_ref points to not dir */
                         lh->errnum = ENOTRECOVERABLE;
                         goto error;
                     }
-                    if (!(lh->val = treeobj_deep_copy (valtmp))) {
-                        lh->errnum = errno;
+                    if (get_dir_value (lh, valtmp, &stall) < 0)
                         goto error;
-                    }
+                    if (stall)
+                        return LOOKUP_PROCESS_LOAD_MISSING_REFS;
                 }
                 goto done;
             }
@@ -1051,7 +1615,7 @@ lookup_process_t lookup (lookup_t *lh)
                     goto error;
             }
 
-            if ((lh->flags & FLUX_KVS_TREEOBJ)) {
+            if ((lh->flags & FLUX_KVS_TREEOBJ) || lh->return_dirent) {
                 if (!(lh->val = treeobj_deep_copy (lh->wdirent))) {
                     lh->errnum = errno;
                     goto error;
@@ -1068,43 +1632,17 @@ lookup_process_t lookup (lookup_t *lh)
                     lh->errnum = EISDIR;
                     goto error;
                 }
-                if ((refcount = treeobj_get_count (lh->wdirent)) < 0) {
-                    lh->errnum = errno;
-                    goto error;
-                }
-                if (refcount != 1) {
-                    flux_log (lh->h, LOG_ERR, "invalid dirref count: %d",
-                              refcount);
-                    lh->errnum = ENOTRECOVERABLE;
+                if (!(valtmp = get_dirref_dir (lh, lh->wdirent,
+                                               NULL, &stall))) {
+                    if (stall)
+                        return LOOKUP_PROCESS_LOAD_MISSING_REFS;
                     goto error;
                 }
-                if (!(reftmp = treeobj_get_blobref (lh->wdirent, 0))) {
-                    lh->errnum = errno;
+                if (get_dir_value (lh, valtmp, &stall) < 0)
                     goto error;
-                }
-                if (!(entry = cache_lookup (lh->cache, reftmp,
-                                            lh->current_epoch))
-                    || !cache_entry_get_valid (entry)) {
-                    lh->missing_ref = reftmp;
+                if (stall)
                     return LOOKUP_PROCESS_LOAD_MISSING_REFS;
-                }
-                if (!(valtmp = cache_entry_get_treeobj (entry))) {
-                    flux_log (lh->h, LOG_ERR, "dirref points to non-treeobj");
-                    lh->errnum = ENOTRECOVERABLE;
-                    goto error;
-                }
-                if (!treeobj_is_dir (valtmp)) {
-                    /* dirref points to not dir */
-                    lh->errnum = ENOTRECOVERABLE;
-                    goto error;
-                }
-                if (!(lh->val = treeobj_deep_copy (valtmp))) {
-                    lh->errnum = errno;
-                    goto error;
-                }
             } else if (treeobj_is_valref (lh->wdirent)) {
-                bool stall;
-
                 if ((lh->flags & FLUX_KVS_READLINK)) {
                     lh->errnum = EINVAL;
                     goto error;
@@ -1123,7 +1661,13 @@ lookup_process_t lookup (lookup_t *lh)
                     lh->errnum = ENOTRECOVERABLE;
                     goto error;
                 }
-                if (refcount == 1) {
+                if (lh->append) {
+                    if (get_append_valref_value (lh, refcount, &stall) < 0)
+                        goto error;
+                    if (stall)
+                        return LOOKUP_PROCESS_LOAD_MISSING_REFS;
+                }
+                else if (refcount == 1) {
                     if (get_single_blobref_valref_value (lh, &stall) < 0)
                         goto error;
                     if (stall)
@@ -1159,7 +1703,11 @@ lookup_process_t lookup (lookup_t *lh)
                     lh->errnum = ENOTDIR;
                     goto error;
                 }
-                if (!(lh->val = treeobj_deep_copy (lh->wdirent))) {
+                if (lh->append) {
+                    if (get_append_val_value (lh) < 0)
+                        goto error;
+                }
+                else if (!(lh->val = treeobj_deep_copy (lh->wdirent))) {
                     lh->errnum = errno;
                     goto error;
                 }
@@ -1188,7 +1736,7 @@ lookup_process_t lookup (lookup_t *lh)
             /* val now contains the requested object (copied) */
             break;
         case LOOKUP_STATE_FINISHED:
-            break;
+            goto finished;
         default:
             flux_log (lh->h, LOG_ERR, "%s: invalid state %d",
                       __FUNCTION__, lh->state);
@@ -1197,6 +1745,8 @@ lookup_process_t lookup (lookup_t *lh)
     }
 
 done:
+    result_cache_put (lh);
+finished:
     lh->state = LOOKUP_STATE_FINISHED;
     return LOOKUP_PROCESS_FINISHED;
 
@@ -17,6 +17,38 @@
 
 typedef struct lookup lookup_t;
 
+/* Lookup counters, which may be shared by many lookups.
+ * stalls - times a lookup stalled on missing references
+ * stalls_avoided - missing references loaded along with another one in
+ *   the same stall, each of which would otherwise have been a stall
+ * prefetches - references returned by lookup_iter_prefetch_refs()
+ * result_hits - lookups answered from a lookup_cache
+ */
+struct lookup_stats {
+    int stalls;
+    int stalls_avoided;
+    int prefetches;
+    int result_hits;
+};
+
+/* A lookup result cache holds the values of finished lookups, keyed by
+ * root blobref, flags, and normalized key.  Since a root blobref names
+ * an immutable tree, entries never need to be invalidated; entries for
+ * old roots simply age out of the LRU.  Results that followed a symlink
+ * into another namespace, directory listings, and large values are not
+ * cached.
+ */
+struct lookup_cache;
+
+struct lookup_cache *lookup_cache_create (int maxsize);
+void lookup_cache_destroy (struct lookup_cache *lc);
+int lookup_cache_count (struct lookup_cache *lc);
+
+/* Maximum number of references lookup_iter_prefetch_refs() returns
+ * for one lookup.
+ */
+#define LOOKUP_PREFETCH_MAX 32
+
 typedef enum {
     LOOKUP_PROCESS_ERROR = 1,
     LOOKUP_PROCESS_LOAD_MISSING_NAMESPACE = 2,
@@ -75,6 +107,46 @@ json_t *lookup_get_value (lookup_t *lh);
  */
 int lookup_iter_missing_refs (lookup_t *lh, lookup_ref_f cb, void *data);
 
+/* After a FLUX_KVS_READDIR lookup finishes, get up to LOOKUP_PREFETCH_MAX
+ * dirrefs in the directory that are not in the KVS cache, so they may be
+ * loaded before a recursive listing looks them up.  Unlike missing
+ * references, the caller need not wait for these to load.
+ *
+ * return -1 in callback to break iteration
+ */
+int lookup_iter_prefetch_refs (lookup_t *lh, lookup_ref_f cb, void *data);
+
+/* Count stalls in 'stats'.  'stats' must remain valid for the life of
+ * the lookup handle.
+ */
+void lookup_set_stats (lookup_t *lh, struct lookup_stats *stats);
+
+/* If 'val' is true, finish with the dirent that the key resolves to,
+ * following symlinks as usual, instead of its value.  This lets the
+ * caller fetch the blobs of a valref itself, e.g. one at a time.
+ * The result cache is not used in this mode.
+ */
+void lookup_set_return_dirent (lookup_t *lh, bool val);
+
+/* Return only the data of a value from byte 'offset' of blob 'index'
+ * of its valref, where an inline val is blob 0, e.g. the data appended
+ * since an earlier lookup.  Blobs before 'index' are not loaded.  The
+ * lookup fails with EINVAL if the value no longer extends to the
+ * position, e.g. it was overwritten.  The result cache is not used in
+ * this mode.
+ */
+void lookup_set_append_position (lookup_t *lh, int index, int offset);
+
+/* After a lookup with an append position finds a value, get the
+ * position at the end of the value, for use in the next lookup.
+ */
+int lookup_get_append_position (lookup_t *lh, int *index, int *offset);
+
+/* Consult and update result cache 'lc' during lookup().  'lc' must
+ * remain valid for the life of the lookup handle.
+ */
+void lookup_set_result_cache (lookup_t *lh, struct lookup_cache *lc);
+
 /* On lookup stall b/c of missing namespace, get missing namespace
  * returned by this function.
  *
@@ -102,6 +174,12 @@ const char *lookup_get_namespace (lookup_t *lh);
 const char *lookup_get_root_ref (lookup_t *lh);
 int lookup_get_root_seq (lookup_t *lh);
 
+/* Returns true if the lookup followed a symlink, i.e. its value may
+ * change with keys that are not along the looked up path.  Not valid
+ * (returns true) unless the lookup completes.
+ */
+bool lookup_get_symlink_followed (lookup_t *lh);
+
 /* Set a new current epoch.  Convenience on RPC replays and epoch may
  * be new */
 int lookup_set_current_epoch (lookup_t *lh, int epoch);
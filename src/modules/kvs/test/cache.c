@@ -12,6 +12,8 @@
 #include "config.h"
 #endif
 #include <stdbool.h>
+#include <string.h>
+#include <errno.h>
 #include <jansson.h>
 
 #include "src/common/libkvs/treeobj.h"
@@ -214,6 +216,17 @@ void cache_entry_raw_tests (void)
     ok (cache_entry_get_dirty (e) == false,
         "cache entry succcessfully now not dirty");
 
+    ok (cache_entry_get_ephemeral (e) == false,
+        "cache entry initially not ephemeral");
+    cache_entry_set_ephemeral (e, true);
+    ok (cache_entry_get_ephemeral (e) == true,
+        "cache_entry_set_ephemeral sets ephemeral");
+    cache_entry_set_ephemeral (e, false);
+    ok (cache_entry_get_ephemeral (e) == false,
+        "cache_entry_set_ephemeral clears ephemeral");
+    ok (cache_entry_get_ephemeral (NULL) == false,
+        "cache_entry_get_ephemeral returns false on bad input");
+
     cache_entry_destroy (e); /* destroys data */
     free (data);
     free (data2);
@@ -700,6 +713,159 @@ void cache_expiration_tests (void)
     cache_destroy (cache);
 }
 
+void cache_shrink_tests (void)
+{
+    struct cache *cache;
+    struct cache_entry *e1, *e2, *e3, *e4;
+    struct cache_counters cc;
+
+    ok ((cache = cache_create ()) != NULL,
+        "cache_create works");
+    ok (cache_shrink (cache, 1) == 0,
+        "cache_shrink on unbounded cache evicts nothing");
+
+    /* Four entries of 10 bytes, e1 least recently used.
+     */
+    e1 = cache_entry_create ("xxx1");
+    e2 = cache_entry_create ("xxx2");
+    e3 = cache_entry_create ("xxx3");
+    e4 = cache_entry_create ("xxx4");
+    if (!e1 || !e2 || !e3 || !e4)
+        BAIL_OUT ("cache_entry_create failed");
+    ok (cache_entry_set_raw (e1, "0123456789", 10) == 0
+        && cache_insert (cache, e1) == 0
+        && cache_insert (cache, e2) == 0,
+        "inserted entry with data and entry without data");
+    ok (cache_get_size (cache) == 10,
+        "cache_get_size counts only valid data");
+    ok (cache_entry_set_raw (e2, "0123456789", 10) == 0,
+        "cache_entry_set_raw on cached entry works");
+    ok (cache_get_size (cache) == 20,
+        "cache_get_size includes newly valid data");
+    ok (cache_entry_set_raw (e3, "0123456789", 10) == 0
+        && cache_insert (cache, e3) == 0
+        && cache_entry_set_raw (e4, "0123456789", 10) == 0
+        && cache_insert (cache, e4) == 0,
+        "inserted two more entries");
+    ok (cache_get_size (cache) == 40,
+        "cache_get_size is 40");
+
+    ok (cache_lookup (cache, "xxx1", 1) == e1
+        && cache_lookup (cache, "xxx2", 1) == e2
+        && cache_lookup (cache, "xxx3", 1) == e3
+        && cache_lookup (cache, "xxx4", 1) == e4
+        && cache_lookup (cache, "yyy1", 1) == NULL,
+        "cache_lookup of all entries works");
+    cache_get_counters (cache, &cc);
+    ok (cc.hits == 4 && cc.misses == 1 && cc.evictions == 0,
+        "counters show 4 hits, 1 miss");
+
+    cache_set_max_size (cache, 25);
+    ok (cache_shrink (cache, 1) == 0,
+        "cache_shrink does not evict entries used in the current epoch");
+
+    /* Make e1 most recently used and pin e2, so e3 then e4 are evicted.
+     */
+    ok (cache_lookup (cache, "xxx1", 1) == e1,
+        "cache_lookup moves entry to most recently used");
+    cache_entry_incref (e2);
+    ok (cache_shrink (cache, 2) == 2,
+        "cache_shrink evicted 2 entries");
+    ok (cache_lookup (cache, "xxx3", 2) == NULL
+        && cache_lookup (cache, "xxx4", 2) == NULL,
+        "least recently used unpinned entries were evicted");
+    ok (cache_count_entries (cache) == 2 && cache_get_size (cache) == 20,
+        "cache contains 2 entries, 20 bytes");
+
+    cache_set_max_size (cache, 5);
+    ok (cache_entry_set_dirty (e1, true) == 0,
+        "cache_entry_set_dirty success");
+    ok (cache_shrink (cache, 3) == 0,
+        "cache_shrink does not evict pinned or dirty entries");
+    cache_entry_decref (e2);
+    ok (cache_shrink (cache, 3) == 1
+        && cache_count_entries (cache) == 1 && cache_get_size (cache) == 10,
+        "cache_shrink evicts entry after decref");
+    cache_get_counters (cache, &cc);
+    ok (cc.evictions == 3,
+        "counters show 3 evictions");
+    cache_clear_counters (cache);
+    cache_get_counters (cache, &cc);
+    ok (cc.hits == 0 && cc.misses == 0 && cc.evictions == 0,
+        "cache_clear_counters works");
+
+    ok (cache_entry_set_dirty (e1, false) == 0
+        && cache_remove_entry (cache, "xxx1") == 1,
+        "cache_remove_entry works");
+    ok (cache_count_entries (cache) == 0 && cache_get_size (cache) == 0,
+        "cache is empty");
+
+    cache_destroy (cache);
+}
+
+void cache_get_blobrefs_tests (void)
+{
+    struct cache *cache;
+    struct cache_entry *e1, *e2, *e3, *e4, *e5;
+    json_t *a;
+
+    ok ((cache = cache_create ()) != NULL,
+        "cache_create works");
+    a = cache_get_blobrefs (cache);
+    ok (a != NULL && json_array_size (a) == 0,
+        "cache_get_blobrefs on empty cache returns empty array");
+    json_decref (a);
+
+    /* e1 is valid, e2 is incomplete, e3 is dirty, e4 is ephemeral,
+     * and e5 is valid.  Only e1 and e5 are in the content store.
+     */
+    e1 = cache_entry_create ("xxx1");
+    e2 = cache_entry_create ("xxx2");
+    e3 = cache_entry_create ("xxx3");
+    e4 = cache_entry_create ("xxx4");
+    e5 = cache_entry_create ("xxx5");
+    if (!e1 || !e2 || !e3 || !e4 || !e5)
+        BAIL_OUT ("cache_entry_create failed");
+    if (cache_entry_set_raw (e1, "data", 4) < 0
+        || cache_entry_set_raw (e3, "data", 4) < 0
+        || cache_entry_set_dirty (e3, true) < 0
+        || cache_entry_set_raw (e4, "data", 4) < 0
+        || cache_entry_set_raw (e5, "data", 4) < 0)
+        BAIL_OUT ("error setting up cache entries");
+    cache_entry_set_ephemeral (e4, true);
+    if (cache_insert (cache, e1) < 0
+        || cache_insert (cache, e2) < 0
+        || cache_insert (cache, e3) < 0
+        || cache_insert (cache, e4) < 0
+        || cache_insert (cache, e5) < 0)
+        BAIL_OUT ("cache_insert failed");
+
+    a = cache_get_blobrefs (cache);
+    ok (a != NULL
+        && json_array_size (a) == 2
+        && !strcmp (json_string_value (json_array_get (a, 0)), "xxx5")
+        && !strcmp (json_string_value (json_array_get (a, 1)), "xxx1"),
+        "cache_get_blobrefs returns clean entries most recently used first");
+    json_decref (a);
+
+    ok (cache_lookup (cache, "xxx1", 1) == e1,
+        "cache_lookup moves entry to most recently used");
+    a = cache_get_blobrefs (cache);
+    ok (a != NULL
+        && json_array_size (a) == 2
+        && !strcmp (json_string_value (json_array_get (a, 0)), "xxx1")
+        && !strcmp (json_string_value (json_array_get (a, 1)), "xxx5"),
+        "cache_get_blobrefs order follows use");
+    json_decref (a);
+
+    errno = 0;
+    ok (cache_get_blobrefs (NULL) == NULL && errno == EINVAL,
+        "cache_get_blobrefs cache=NULL fails with EINVAL");
+
+    (void)cache_entry_set_dirty (e3, false);
+    cache_destroy (cache);
+}
+
 int main (int argc, char *argv[])
 {
     plan (NO_PLAN);
@@ -712,6 +878,8 @@ int main (int argc, char *argv[])
     cache_expiration_tests ();
     cache_blobref_tests ();
     cache_remove_entry_tests ();
+    cache_shrink_tests ();
+    cache_get_blobrefs_tests ();
 
     done_testing ();
     return (0);
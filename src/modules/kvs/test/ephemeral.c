@@ -0,0 +1,199 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <jansson.h>
+
+#include "src/common/libkvs/treeobj.h"
+#include "src/common/libutil/blobref.h"
+#include "src/common/libtap/tap.h"
+#include "src/modules/kvs/cache.h"
+#include "src/modules/kvs/ephemeral.h"
+
+/* Insert raw 'data' in 'cache', returning its blobref in 'ref'.
+ */
+void insert_raw (struct cache *cache, const void *data, int len, char *ref)
+{
+    struct cache_entry *entry;
+
+    if (blobref_hash ("sha1", data, len, ref, BLOBREF_MAX_STRING_SIZE) < 0)
+        BAIL_OUT ("blobref_hash failed");
+    if (!(entry = cache_entry_create (ref))
+        || cache_entry_set_raw (entry, data, len) < 0
+        || cache_insert (cache, entry) < 0)
+        BAIL_OUT ("could not create cache entry");
+}
+
+/* Insert treeobj 'o' in 'cache', returning its blobref in 'ref', and
+ * consuming the reference on 'o'.
+ */
+void insert_treeobj (struct cache *cache, json_t *o, char *ref)
+{
+    char *s;
+
+    if (!o || !(s = treeobj_encode (o)))
+        BAIL_OUT ("treeobj_encode failed");
+    insert_raw (cache, s, strlen (s), ref);
+    free (s);
+    json_decref (o);
+}
+
+json_t *create_sub (const char *valref)
+{
+    json_t *dir = treeobj_create_dir ();
+    json_t *ref = treeobj_create_valref (valref);
+
+    if (!dir || !ref || treeobj_insert_entry (dir, "a", ref) < 0)
+        BAIL_OUT ("could not create sub dir");
+    json_decref (ref);
+    return dir;
+}
+
+json_t *create_root (const char *subref, const char *x)
+{
+    json_t *dir = treeobj_create_dir ();
+    json_t *dirref = treeobj_create_dirref (subref);
+    json_t *val = treeobj_create_val (x, strlen (x));
+
+    if (!dir || !dirref || !val
+        || treeobj_insert_entry (dir, "sub", dirref) < 0
+        || treeobj_insert_entry (dir, "x", val) < 0)
+        BAIL_OUT ("could not create root dir");
+    json_decref (dirref);
+    json_decref (val);
+    return dir;
+}
+
+void basic_api (void)
+{
+    struct cache *cache;
+    struct ephemeral *eph;
+
+    if (!(cache = cache_create ()))
+        BAIL_OUT ("cache_create failed");
+
+    errno = 0;
+    ok (ephemeral_create (NULL) == NULL && errno == EINVAL,
+        "ephemeral_create fails with EINVAL on bad input");
+    ok ((eph = ephemeral_create (cache)) != NULL,
+        "ephemeral_create works");
+    errno = 0;
+    ok (ephemeral_hold (NULL, "sha1-1234", 0) < 0 && errno == EINVAL,
+        "ephemeral_hold fails with EINVAL on bad eph");
+    errno = 0;
+    ok (ephemeral_hold (eph, NULL, 0) < 0 && errno == EINVAL,
+        "ephemeral_hold fails with EINVAL on bad ref");
+    ok (ephemeral_count (NULL) == 0,
+        "ephemeral_count returns 0 on bad input");
+    ok (ephemeral_count (eph) == 0,
+        "ephemeral_count is initially 0");
+
+    ok (ephemeral_hold (eph, "sha1-1234", 1) == 0,
+        "ephemeral_hold works on blob that is not cached");
+    ok (ephemeral_count (eph) == 1,
+        "ephemeral_count is 1");
+    ephemeral_release (eph, "sha1-1234", 1);
+    ok (ephemeral_count (eph) == 0,
+        "ephemeral_release works");
+    ephemeral_release (eph, "sha1-1234", 1);
+    ok (ephemeral_count (eph) == 0,
+        "ephemeral_release of blob not held is ignored");
+
+    lives_ok ({ephemeral_release (NULL, "sha1-1234", 1);},
+        "ephemeral_release doesn't crash on bad input");
+    lives_ok ({ephemeral_destroy (NULL);},
+        "ephemeral_destroy doesn't crash on NULL");
+
+    ephemeral_destroy (eph);
+    cache_destroy (cache);
+}
+
+void hold_release (void)
+{
+    struct cache *cache;
+    struct ephemeral *eph;
+    char valref[BLOBREF_MAX_STRING_SIZE];
+    char subref[BLOBREF_MAX_STRING_SIZE];
+    char root1[BLOBREF_MAX_STRING_SIZE];
+    char root2[BLOBREF_MAX_STRING_SIZE];
+
+    if (!(cache = cache_create ()))
+        BAIL_OUT ("cache_create failed");
+
+    /* root1 and root2 differ in "x", but share dir "sub", which holds
+     * a valref
+     */
+    insert_raw (cache, "abcd", 4, valref);
+    insert_treeobj (cache, create_sub (valref), subref);
+    insert_treeobj (cache, create_root (subref, "1"), root1);
+    insert_treeobj (cache, create_root (subref, "2"), root2);
+
+    ok ((eph = ephemeral_create (cache)) != NULL,
+        "ephemeral_create works");
+
+    ok (ephemeral_hold (eph, root1, 1) == 0,
+        "ephemeral_hold root1 works");
+    ok (ephemeral_count (eph) == 3,
+        "root1, sub dir and valref blob are held");
+    ok (cache_expire_entries (cache, 100, 0) == 1
+        && cache_count_entries (cache) == 3,
+        "cache_expire_entries expires only root2");
+
+    insert_treeobj (cache, create_root (subref, "2"), root2);
+    ok (ephemeral_hold (eph, root2, 2) == 0,
+        "ephemeral_hold root2 works");
+    ok (ephemeral_count (eph) == 4,
+        "root2 is held, shared blobs are counted once");
+    ephemeral_release (eph, root1, 2);
+    ok (ephemeral_count (eph) == 3,
+        "releasing root1 leaves shared blobs held");
+    ok (cache_expire_entries (cache, 200, 0) == 1
+        && cache_count_entries (cache) == 3,
+        "cache_expire_entries expires only root1");
+
+    ephemeral_release (eph, root2, 3);
+    ok (ephemeral_count (eph) == 0,
+        "releasing root2 releases everything");
+    ok (cache_expire_entries (cache, 300, 0) == 3
+        && cache_count_entries (cache) == 0,
+        "cache_expire_entries expires the rest");
+
+    insert_raw (cache, "abcd", 4, valref);
+    insert_treeobj (cache, create_sub (valref), subref);
+    insert_treeobj (cache, create_root (subref, "1"), root1);
+    ok (ephemeral_hold (eph, root1, 4) == 0
+        && ephemeral_count (eph) == 3,
+        "ephemeral_hold root1 works again");
+    ephemeral_destroy (eph);
+    ok (cache_expire_entries (cache, 400, 0) == 3,
+        "ephemeral_destroy releases everything");
+
+    cache_destroy (cache);
+}
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    basic_api ();
+    hold_release ();
+
+    done_testing ();
+    return (0);
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
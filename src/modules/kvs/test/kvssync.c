@@ -76,7 +76,7 @@ void basic_api_tests (void)
     ok (!kvssync_add (root, cb, NULL, NULL, msg, NULL, 4),
         "kvssync_add w/ seq = 4 works");
 
-    ok (zlist_size (root->synclist) == 3,
+    ok (kvssync_count (root) == 3,
         "synclist is length 3");
 
     kvsroot_setroot (krm, root, root_ref, 1);
@@ -88,7 +88,7 @@ void basic_api_tests (void)
     ok (count == 0,
         "kvssync_process did not call cb on seq = 1");
 
-    ok (zlist_size (root->synclist) == 3,
+    ok (kvssync_count (root) == 3,
         "synclist is length 3");
 
     kvsroot_setroot (krm, root, root_ref, 2);
@@ -100,7 +100,7 @@ void basic_api_tests (void)
     ok (count == 1,
         "kvssync_process called callback once on seq = 2");
 
-    ok (zlist_size (root->synclist) == 2,
+    ok (kvssync_count (root) == 2,
         "synclist is length 2");
 
     kvsroot_setroot (krm, root, root_ref, 4);
@@ -112,7 +112,7 @@ void basic_api_tests (void)
     ok (count == 2,
         "kvssync_process called callback twice on seq = 4");
 
-    ok (zlist_size (root->synclist) == 0,
+    ok (kvssync_count (root) == 0,
         "synclist is length 0");
 
     ok (!kvssync_add (root, cb, NULL, NULL, msg, NULL, 5),
@@ -122,7 +122,7 @@ void basic_api_tests (void)
     ok (!kvssync_add (root, cb, NULL, NULL, msg, NULL, 7),
         "kvssync_add w/ seq = 7 works");
 
-    ok (zlist_size (root->synclist) == 3,
+    ok (kvssync_count (root) == 3,
         "synclist is length 3");
 
     count = 0;
@@ -132,7 +132,7 @@ void basic_api_tests (void)
     ok (count == 3,
         "kvssync_process called callback thrice on all flag = true");
 
-    ok (zlist_size (root->synclist) == 0,
+    ok (kvssync_count (root) == 0,
         "synclist is length 0");
 
     /* cover some alternate insertion pattern, descending and
@@ -145,7 +145,7 @@ void basic_api_tests (void)
     ok (!kvssync_add (root, cb, NULL, NULL, msg, NULL, 8),
         "kvssync_add w/ seq = 8 works");
 
-    ok (zlist_size (root->synclist) == 3,
+    ok (kvssync_count (root) == 3,
         "synclist is length 3");
 
     count = 0;
@@ -221,7 +221,7 @@ void basic_remove_tests (void)
         flux_msg_destroy (msg);
     }
 
-    ok (zlist_size (root->synclist) == 10,
+    ok (kvssync_count (root) == 10,
         "synclist is length 10");
 
     count = 0;
@@ -229,19 +229,19 @@ void basic_remove_tests (void)
     ok (!kvssync_remove_msg (root, msgcmp, NULL),
         "kvssync_remove_msg works");
 
-    ok (zlist_size (root->synclist) == 5,
+    ok (kvssync_count (root) == 5,
         "synclist is length 5");
 
     ok (!kvssync_remove_msg (root, msgcmp, NULL),
         "kvssync_remove_msg works");
 
-    ok (zlist_size (root->synclist) == 5,
+    ok (kvssync_count (root) == 5,
         "synclist is still length 5");
 
     ok (!kvssync_remove_msg (root, msgcmp_true, NULL),
         "kvssync_remove_msg works");
 
-    ok (zlist_size (root->synclist) == 0,
+    ok (kvssync_count (root) == 0,
         "synclist is length 0");
 
     kvsroot_mgr_destroy (krm);
@@ -730,6 +730,138 @@ void kvstxn_basic_kvstxn_process_test (void)
     cache_destroy (cache);
 }
 
+int cache_set_ephemeral_cb (kvstxn_t *kt, struct cache_entry *entry,
+                            void *data)
+{
+    int *count = data;
+    cache_entry_set_ephemeral (entry, true);
+    if (cache_entry_set_dirty (entry, false) < 0)
+        return -1;
+    if (count)
+        (*count)++;
+    return 0;
+}
+
+void kvstxn_process_ephemeral (void)
+{
+    struct cache *cache;
+    kvsroot_mgr_t *krm;
+    int count = 0;
+    kvstxn_mgr_t *ktm_eph, *ktm;
+    kvstxn_t *kt;
+    char rootref[BLOBREF_MAX_STRING_SIZE];
+    char ephroot[BLOBREF_MAX_STRING_SIZE];
+    const char *newroot;
+    struct cache_entry *entry;
+    json_t *ops, *op, *dirref;
+
+    cache = create_cache_with_empty_rootdir (rootref, sizeof (rootref));
+
+    ok ((krm = kvsroot_mgr_create (NULL, NULL)) != NULL,
+        "kvsroot_mgr_create works");
+
+    setup_kvsroot (krm, KVS_PRIMARY_NAMESPACE, cache, ref_dummy);
+    setup_kvsroot (krm, "eph", cache, ref_dummy);
+
+    ok ((ktm_eph = kvstxn_mgr_create (cache,
+                                      "eph",
+                                      "sha1",
+                                      NULL,
+                                      &test_global)) != NULL,
+        "kvstxn_mgr_create works");
+    kvstxn_mgr_set_ephemeral (ktm_eph, true);
+
+    ok ((ktm = kvstxn_mgr_create (cache,
+                                  KVS_PRIMARY_NAMESPACE,
+                                  "sha1",
+                                  NULL,
+                                  &test_global)) != NULL,
+        "kvstxn_mgr_create works");
+
+    /* ephemeral namespace leaves its new root dir in the cache */
+
+    create_ready_kvstxn (ktm_eph, "transaction1", "key1", "1", 0, 0);
+
+    ok ((kt = kvstxn_mgr_get_ready_transaction (ktm_eph)) != NULL,
+        "kvstxn_mgr_get_ready_transaction returns ready kvstxn");
+
+    ok (kvstxn_process (kt, 1, rootref) == KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES,
+        "kvstxn_process returns KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES");
+
+    ok (kvstxn_iter_dirty_cache_entries (kt, cache_set_ephemeral_cb,
+                                          &count) == 0
+        && count == 1,
+        "ephemeral dirty cache entry marked ephemeral and not dirty");
+
+    ok (kvstxn_process (kt, 1, rootref) == KVSTXN_PROCESS_FINISHED,
+        "kvstxn_process returns KVSTXN_PROCESS_FINISHED");
+
+    ok ((newroot = kvstxn_get_newroot_ref (kt)) != NULL,
+        "kvstxn_get_newroot_ref returns != NULL when processing complete");
+    strcpy (ephroot, newroot);
+
+    kvstxn_mgr_remove_transaction (ktm_eph, kt, false);
+
+    /* the same change in another namespace yields the same root dir,
+     * which must be written out for it
+     */
+
+    create_ready_kvstxn (ktm, "transaction2", "key1", "1", 0, 0);
+
+    ok ((kt = kvstxn_mgr_get_ready_transaction (ktm)) != NULL,
+        "kvstxn_mgr_get_ready_transaction returns ready kvstxn");
+
+    ok (kvstxn_process (kt, 1, rootref) == KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES,
+        "kvstxn_process returns KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES "
+        "for cached ephemeral data");
+
+    count = 0;
+    ok (kvstxn_iter_dirty_cache_entries (kt, cache_count_dirty_cb, &count) == 0
+        && count == 1,
+        "ephemeral cache entry is returned dirty");
+
+    ok (kvstxn_process (kt, 1, rootref) == KVSTXN_PROCESS_FINISHED,
+        "kvstxn_process returns KVSTXN_PROCESS_FINISHED");
+
+    ok ((newroot = kvstxn_get_newroot_ref (kt)) != NULL
+        && !strcmp (newroot, ephroot),
+        "both namespaces have the same new root");
+
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "key1", "1");
+
+    kvstxn_mgr_remove_transaction (ktm, kt, false);
+
+    /* another namespace may not link to ephemeral data */
+
+    ok ((entry = cache_lookup (cache, ephroot, 1)) != NULL,
+        "cache_lookup of ephemeral root works");
+    cache_entry_set_ephemeral (entry, true);
+
+    ops = json_array ();
+    dirref = treeobj_create_dirref (ephroot);
+    txn_encode_op ("link", 0, dirref, &op);
+    json_array_append_new (ops, op);
+    json_decref (dirref);
+
+    ok (kvstxn_mgr_add_transaction (ktm, "transaction3", ops, 0) == 0,
+        "kvstxn_mgr_add_transaction works");
+    json_decref (ops);
+
+    ok ((kt = kvstxn_mgr_get_ready_transaction (ktm)) != NULL,
+        "kvstxn_mgr_get_ready_transaction returns ready kvstxn");
+
+    ok (kvstxn_process (kt, 1, rootref) == KVSTXN_PROCESS_ERROR
+        && kvstxn_get_errnum (kt) == EXDEV,
+        "kvstxn_process fails with EXDEV on link to ephemeral data");
+
+    kvstxn_mgr_remove_transaction (ktm, kt, false);
+
+    kvstxn_mgr_destroy (ktm);
+    kvstxn_mgr_destroy (ktm_eph);
+    kvsroot_mgr_destroy (krm);
+    cache_destroy (cache);
+}
+
 void kvstxn_basic_kvstxn_process_test_normalization (void)
 {
     struct cache *cache;
@@ -2980,6 +3112,195 @@ void kvstxn_process_append (void)
     json_decref (root);
 }
 
+int get_blob_count (struct cache *cache,
+                    kvsroot_mgr_t *krm,
+                    const char *root_ref,
+                    const char *key)
+{
+    lookup_t *lh;
+    json_t *o;
+    int count = -1;
+    struct flux_msg_cred cred = { .rolemask = FLUX_ROLE_OWNER, .userid = 0 };
+
+    if (!(lh = lookup_create (cache,
+                              krm,
+                              1,
+                              KVS_PRIMARY_NAMESPACE,
+                              root_ref,
+                              0,
+                              key,
+                              cred,
+                              FLUX_KVS_TREEOBJ,
+                              NULL)))
+        BAIL_OUT ("lookup_create failed");
+    if (lookup (lh) == LOOKUP_PROCESS_FINISHED
+        && (o = lookup_get_value (lh))) {
+        if (treeobj_is_valref (o))
+            count = treeobj_get_count (o);
+        json_decref (o);
+    }
+    lookup_destroy (lh);
+    return count;
+}
+
+void kvstxn_process_append_merge (void)
+{
+    struct cache *cache;
+    kvsroot_mgr_t *krm;
+    int count = 0;
+    kvstxn_mgr_t *ktm;
+    kvstxn_t *kt;
+    json_t *root;
+    char valref_ref[BLOBREF_MAX_STRING_SIZE];
+    char root_ref[BLOBREF_MAX_STRING_SIZE];
+    const char *newroot;
+
+    ok ((cache = cache_create ()) != NULL,
+        "cache_create works");
+    ok ((krm = kvsroot_mgr_create (NULL, NULL)) != NULL,
+        "kvsroot_mgr_create works");
+
+    /* This root is
+     *
+     * valref_ref
+     * "ABCD"
+     *
+     * root_ref
+     * "val" : val to "abcd"
+     * "valref" : valref to valref_ref
+     */
+
+    blobref_hash ("sha1", "ABCD", 4, valref_ref, sizeof (valref_ref));
+    (void)cache_insert (cache, create_cache_entry_raw (valref_ref, "ABCD", 4));
+
+    root = treeobj_create_dir ();
+    _treeobj_insert_entry_val (root, "val", "abcd", 4);
+    _treeobj_insert_entry_val (root, "valref", "ABCD", 4);
+
+    ok (treeobj_hash ("sha1", root, root_ref, sizeof (root_ref)) == 0,
+        "treeobj_hash worked");
+
+    (void)cache_insert (cache, create_cache_entry_treeobj (root_ref, root));
+
+    setup_kvsroot (krm, KVS_PRIMARY_NAMESPACE, cache, root_ref);
+
+    ok ((ktm = kvstxn_mgr_create (cache,
+                                  KVS_PRIMARY_NAMESPACE,
+                                  "sha1",
+                                  NULL,
+                                  &test_global)) != NULL,
+        "kvstxn_mgr_create works");
+
+    kvstxn_mgr_set_append_blob_size (ktm, 16);
+
+    /*
+     * first test, append to a treeobj valref is merged into last blob
+     */
+
+    create_ready_kvstxn (ktm, "transaction1", "valref", "EFGH", FLUX_KVS_APPEND, 0);
+
+    ok ((kt = kvstxn_mgr_get_ready_transaction (ktm)) != NULL,
+        "kvstxn_mgr_get_ready_transaction returns ready kvstxn");
+
+    ok (kvstxn_process (kt, 1, root_ref) == KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES,
+        "kvstxn_process returns KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES");
+
+    count = 0;
+    ok (kvstxn_iter_dirty_cache_entries (kt, cache_count_dirty_cb, &count) == 0,
+        "kvstxn_iter_dirty_cache_entries works for dirty cache entries");
+
+    /* 2 dirty entries, raw "ABCDEFGH", and a new root b/c valref
+     * blobref has changed */
+    ok (count == 2,
+        "correct number of cache entries were dirty");
+
+    ok (kvstxn_process (kt, 1, root_ref) == KVSTXN_PROCESS_FINISHED,
+        "kvstxn_process returns KVSTXN_PROCESS_FINISHED");
+
+    ok ((newroot = kvstxn_get_newroot_ref (kt)) != NULL,
+        "kvstxn_get_newroot_ref returns != NULL when processing complete");
+
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "valref", "ABCDEFGH");
+
+    ok (get_blob_count (cache, krm, newroot, "valref") == 1,
+        "valref still has one blobref");
+    ok (kvstxn_mgr_get_append_merges (ktm) == 1,
+        "kvstxn_mgr_get_append_merges returns 1");
+
+    kvstxn_mgr_remove_transaction (ktm, kt, false);
+
+    /*
+     * second test, append to a treeobj val produces single blob valref
+     */
+
+    create_ready_kvstxn (ktm, "transaction2", "val", "efgh", FLUX_KVS_APPEND, 0);
+
+    ok ((kt = kvstxn_mgr_get_ready_transaction (ktm)) != NULL,
+        "kvstxn_mgr_get_ready_transaction returns ready kvstxn");
+
+    ok (kvstxn_process (kt, 1, root_ref) == KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES,
+        "kvstxn_process returns KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES");
+
+    count = 0;
+    ok (kvstxn_iter_dirty_cache_entries (kt, cache_count_dirty_cb, &count) == 0,
+        "kvstxn_iter_dirty_cache_entries works for dirty cache entries");
+
+    /* 2 dirty entries, raw "abcdefgh", and a new root b/c val
+     * has been changed into a valref. */
+    ok (count == 2,
+        "correct number of cache entries were dirty");
+
+    ok (kvstxn_process (kt, 1, root_ref) == KVSTXN_PROCESS_FINISHED,
+        "kvstxn_process returns KVSTXN_PROCESS_FINISHED");
+
+    ok ((newroot = kvstxn_get_newroot_ref (kt)) != NULL,
+        "kvstxn_get_newroot_ref returns != NULL when processing complete");
+
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "val", "abcdefgh");
+
+    ok (get_blob_count (cache, krm, newroot, "val") == 1,
+        "val converted to valref with one blobref");
+    ok (kvstxn_mgr_get_append_merges (ktm) == 2,
+        "kvstxn_mgr_get_append_merges returns 2");
+
+    kvstxn_mgr_remove_transaction (ktm, kt, false);
+
+    /*
+     * third test, append exceeding target size is not merged
+     */
+
+    kvstxn_mgr_set_append_blob_size (ktm, 4);
+    kvstxn_mgr_clear_append_merges (ktm);
+
+    create_ready_kvstxn (ktm, "transaction3", "valref", "EFGH", FLUX_KVS_APPEND, 0);
+
+    ok ((kt = kvstxn_mgr_get_ready_transaction (ktm)) != NULL,
+        "kvstxn_mgr_get_ready_transaction returns ready kvstxn");
+
+    ok (kvstxn_process (kt, 1, root_ref) == KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES,
+        "kvstxn_process returns KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES");
+
+    ok (kvstxn_process (kt, 1, root_ref) == KVSTXN_PROCESS_FINISHED,
+        "kvstxn_process returns KVSTXN_PROCESS_FINISHED");
+
+    ok ((newroot = kvstxn_get_newroot_ref (kt)) != NULL,
+        "kvstxn_get_newroot_ref returns != NULL when processing complete");
+
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "valref", "ABCDEFGH");
+
+    ok (get_blob_count (cache, krm, newroot, "valref") == 2,
+        "valref has an additional blobref");
+    ok (kvstxn_mgr_get_append_merges (ktm) == 0,
+        "kvstxn_mgr_get_append_merges returns 0 after clear");
+
+    kvstxn_mgr_remove_transaction (ktm, kt, false);
+
+    kvstxn_mgr_destroy (ktm);
+    kvsroot_mgr_destroy (krm);
+    cache_destroy (cache);
+    json_decref (root);
+}
+
 void kvstxn_process_append_errors (void)
 {
     struct cache *cache;
@@ -3364,6 +3685,418 @@ void kvstxn_process_fallback_merge (void)
     cache_destroy (cache);
 }
 
+/* Look up 'key' with 'flags' and return its value.
+ */
+json_t *lookup_value (struct cache *cache,
+                      kvsroot_mgr_t *krm,
+                      const char *root_ref,
+                      const char *key,
+                      int flags)
+{
+    lookup_t *lh;
+    json_t *o = NULL;
+    struct flux_msg_cred cred = { .rolemask = FLUX_ROLE_OWNER, .userid = 0 };
+
+    if ((lh = lookup_create (cache,
+                             krm,
+                             1,
+                             KVS_PRIMARY_NAMESPACE,
+                             root_ref,
+                             0,
+                             key,
+                             cred,
+                             flags,
+                             NULL))
+        && lookup (lh) == LOOKUP_PROCESS_FINISHED)
+        o = lookup_get_value (lh);
+    lookup_destroy (lh);
+    return o;
+}
+
+void kvstxn_process_dirshard (void)
+{
+    struct cache *cache;
+    struct cache_entry *entry;
+    kvsroot_mgr_t *krm;
+    kvstxn_mgr_t *ktm;
+    kvstxn_t *kt;
+    json_t *ops;
+    json_t *o;
+    char rootref[BLOBREF_MAX_STRING_SIZE];
+    char key[64];
+    char newroot[BLOBREF_MAX_STRING_SIZE];
+    int count;
+    int i;
+
+    cache = create_cache_with_empty_rootdir (rootref, sizeof (rootref));
+
+    ok ((krm = kvsroot_mgr_create (NULL, NULL)) != NULL,
+        "kvsroot_mgr_create works");
+
+    setup_kvsroot (krm, KVS_PRIMARY_NAMESPACE, cache, rootref);
+
+    ok ((ktm = kvstxn_mgr_create (cache,
+                                  KVS_PRIMARY_NAMESPACE,
+                                  "sha1",
+                                  NULL,
+                                  &test_global)) != NULL,
+        "kvstxn_mgr_create works");
+    kvstxn_mgr_set_dirshard_threshold (ktm, 4);
+
+    /* Fill a directory well past the threshold in one transaction.
+     */
+    ops = json_array ();
+    for (i = 0; i < 100; i++) {
+        snprintf (key, sizeof (key), "dir.key%d", i);
+        ops_append (ops, key, "x", 0);
+    }
+    ok (kvstxn_mgr_add_transaction (ktm, "transaction1", ops, 0) == 0,
+        "kvstxn_mgr_add_transaction works");
+    json_decref (ops);
+
+    ok ((kt = kvstxn_mgr_get_ready_transaction (ktm)) != NULL,
+        "kvstxn_mgr_get_ready_transaction returns ready kvstxn");
+    ok (kvstxn_process (kt, 1, rootref) == KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES,
+        "kvstxn_process returns KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES");
+    count = 0;
+    ok (kvstxn_iter_dirty_cache_entries (kt, cache_count_dirty_cb, &count) == 0,
+        "kvstxn_iter_dirty_cache_entries works for dirty cache entries");
+    diag ("%d dirty cache entries", count);
+    ok (count > 2,
+        "large directory was stored as several shards");
+    ok (kvstxn_process (kt, 1, rootref) == KVSTXN_PROCESS_FINISHED,
+        "kvstxn_process returns KVSTXN_PROCESS_FINISHED");
+    strcpy (newroot, kvstxn_get_newroot_ref (kt));
+    kvstxn_mgr_remove_transaction (ktm, kt, false);
+
+    o = lookup_value (cache, krm, newroot, "dir", FLUX_KVS_TREEOBJ);
+    ok (o != NULL && treeobj_is_dirref (o),
+        "sharded directory is a dirref in its parent");
+    entry = o ? cache_lookup (cache, treeobj_get_blobref (o, 0), 1) : NULL;
+    ok (entry != NULL && treeobj_is_dirshard (cache_entry_get_treeobj (entry)),
+        "dirref points to a dirshard");
+    json_decref (o);
+
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "dir.key0", "x");
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "dir.key99", "x");
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "dir.nokey", NULL);
+
+    o = lookup_value (cache, krm, newroot, "dir", FLUX_KVS_READDIR);
+    ok (o != NULL && treeobj_is_dir (o) && treeobj_get_count (o) == 100,
+        "FLUX_KVS_READDIR returns all entries of sharded directory");
+    json_decref (o);
+
+    /* Changing one entry should rewrite only the shards leading to it.
+     */
+    create_ready_kvstxn (ktm, "transaction2", "dir.key42", "y", 0, 0);
+    ok ((kt = kvstxn_mgr_get_ready_transaction (ktm)) != NULL,
+        "kvstxn_mgr_get_ready_transaction returns ready kvstxn");
+    ok (kvstxn_process (kt, 1, newroot) == KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES,
+        "kvstxn_process returns KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES");
+    count = 0;
+    ok (kvstxn_iter_dirty_cache_entries (kt, cache_count_dirty_cb, &count) == 0,
+        "kvstxn_iter_dirty_cache_entries works for dirty cache entries");
+    diag ("%d dirty cache entries", count);
+    ok (count >= 3 && count <= 2 + TREEOBJ_DIRSHARD_LEVELS,
+        "update of one entry stored root and only the shards leading to it");
+    ok (kvstxn_process (kt, 1, newroot) == KVSTXN_PROCESS_FINISHED,
+        "kvstxn_process returns KVSTXN_PROCESS_FINISHED");
+    strcpy (newroot, kvstxn_get_newroot_ref (kt));
+    kvstxn_mgr_remove_transaction (ktm, kt, false);
+
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "dir.key42", "y");
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "dir.key41", "x");
+
+    /* Delete an entry and a nonexistent entry.
+     */
+    ops = json_array ();
+    ops_append (ops, "dir.key7", NULL, 0);
+    ops_append (ops, "dir.nokey", NULL, 0);
+    ok (kvstxn_mgr_add_transaction (ktm, "transaction3", ops, 0) == 0,
+        "kvstxn_mgr_add_transaction works");
+    json_decref (ops);
+    ok ((kt = kvstxn_mgr_get_ready_transaction (ktm)) != NULL,
+        "kvstxn_mgr_get_ready_transaction returns ready kvstxn");
+    ok (kvstxn_process (kt, 1, newroot) == KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES,
+        "kvstxn_process returns KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES");
+    ok (kvstxn_iter_dirty_cache_entries (kt, cache_noop_cb, NULL) == 0,
+        "kvstxn_iter_dirty_cache_entries works for dirty cache entries");
+    ok (kvstxn_process (kt, 1, newroot) == KVSTXN_PROCESS_FINISHED,
+        "kvstxn_process returns KVSTXN_PROCESS_FINISHED");
+    strcpy (newroot, kvstxn_get_newroot_ref (kt));
+    kvstxn_mgr_remove_transaction (ktm, kt, false);
+
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "dir.key7", NULL);
+    o = lookup_value (cache, krm, newroot, "dir", FLUX_KVS_READDIR);
+    ok (o != NULL && treeobj_get_count (o) == 99,
+        "FLUX_KVS_READDIR returns remaining entries after delete");
+    json_decref (o);
+
+    kvstxn_mgr_destroy (ktm);
+    kvsroot_mgr_destroy (krm);
+    cache_destroy (cache);
+}
+
+void kvstxn_process_pipeline (void)
+{
+    struct cache *cache;
+    kvsroot_mgr_t *krm;
+    kvstxn_mgr_t *ktm;
+    kvstxn_t *kt1, *kt2, *kt3;
+    char rootref[BLOBREF_MAX_STRING_SIZE];
+    const char *newroot;
+    int count;
+
+    cache = create_cache_with_empty_rootdir (rootref, sizeof (rootref));
+
+    ok ((krm = kvsroot_mgr_create (NULL, NULL)) != NULL,
+        "kvsroot_mgr_create works");
+
+    setup_kvsroot (krm, KVS_PRIMARY_NAMESPACE, cache, rootref);
+
+    ok ((ktm = kvstxn_mgr_create (cache,
+                                  KVS_PRIMARY_NAMESPACE,
+                                  "sha1",
+                                  NULL,
+                                  &test_global)) != NULL,
+        "kvstxn_mgr_create works");
+
+    kvstxn_mgr_set_pipeline (ktm, true);
+
+    create_ready_kvstxn (ktm, "transaction1", "key1", "1", 0, 0);
+    create_ready_kvstxn (ktm, "transaction2", "dir.key2", "2", 0, 0);
+
+    ok ((kt1 = kvstxn_mgr_get_ready_transaction (ktm)) != NULL,
+        "kvstxn_mgr_get_ready_transaction returns transaction1");
+
+    ok (kvstxn_process (kt1, 1, rootref) == KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES,
+        "kvstxn_process transaction1 returns KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES");
+
+    count = 0;
+    ok (kvstxn_iter_dirty_cache_entries (kt1, cache_count_dirty_cb, &count) == 0
+        && count == 1,
+        "kvstxn_iter_dirty_cache_entries returns 1 dirty entry");
+
+    /* transaction1 is waiting on stores, transaction2 may start */
+    ok ((kt2 = kvstxn_mgr_get_ready_transaction (ktm)) != NULL
+        && kt2 != kt1,
+        "kvstxn_mgr_get_ready_transaction returns transaction2");
+
+    ok (kvstxn_mgr_ready_transaction_count (ktm) == 2,
+        "kvstxn_mgr_ready_transaction_count counts pipelined transaction");
+
+    /* published root is passed in, transaction2 is applied on top
+     * of transaction1's root anyways */
+    ok (kvstxn_process (kt2, 1, rootref) == KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES,
+        "kvstxn_process transaction2 returns KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES");
+
+    count = 0;
+    ok (kvstxn_iter_dirty_cache_entries (kt2, cache_count_dirty_cb, &count) == 0
+        && count == 2,
+        "kvstxn_iter_dirty_cache_entries returns 2 dirty entries");
+
+    ok (kvstxn_process (kt2, 1, rootref) == KVSTXN_PROCESS_SETROOT_PENDING,
+        "kvstxn_process transaction2 returns KVSTXN_PROCESS_SETROOT_PENDING");
+
+    ok (kvstxn_mgr_get_ready_transaction (ktm) == NULL,
+        "kvstxn_mgr_get_ready_transaction returns NULL, all stalled");
+
+    ok (kvstxn_process (kt1, 1, rootref) == KVSTXN_PROCESS_FINISHED,
+        "kvstxn_process transaction1 returns KVSTXN_PROCESS_FINISHED");
+
+    ok ((newroot = kvstxn_get_newroot_ref (kt1)) != NULL,
+        "kvstxn_get_newroot_ref returns != NULL when processing complete");
+
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "key1", "1");
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "dir.key2", NULL);
+
+    kvstxn_mgr_remove_transaction (ktm, kt1, false);
+
+    ok (kvstxn_mgr_get_ready_transaction (ktm) == kt2,
+        "kvstxn_mgr_get_ready_transaction returns transaction2 again");
+
+    ok (kvstxn_process (kt2, 1, rootref) == KVSTXN_PROCESS_FINISHED,
+        "kvstxn_process transaction2 returns KVSTXN_PROCESS_FINISHED");
+
+    ok ((newroot = kvstxn_get_newroot_ref (kt2)) != NULL,
+        "kvstxn_get_newroot_ref returns != NULL when processing complete");
+
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "key1", "1");
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "dir.key2", "2");
+
+    kvstxn_mgr_remove_transaction (ktm, kt2, false);
+
+    ok (kvstxn_mgr_get_ready_transaction (ktm) == NULL,
+        "kvstxn_mgr_get_ready_transaction returns NULL, no more kvstxns");
+
+    /* a failed pipelined transaction cancels the ones after it and
+     * restarts the ready transaction */
+
+    create_ready_kvstxn (ktm, "transaction3", "key3", "3", 0, 0);
+    create_ready_kvstxn (ktm, "transaction4", "key4", "4", 0, 0);
+    create_ready_kvstxn (ktm, "transaction5", "key5", "5", 0, 0);
+
+    ok ((kt1 = kvstxn_mgr_get_ready_transaction (ktm)) != NULL
+        && kvstxn_process (kt1, 1, rootref) == KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES
+        && kvstxn_iter_dirty_cache_entries (kt1, cache_noop_cb, NULL) == 0,
+        "transaction3 is storing");
+    ok ((kt2 = kvstxn_mgr_get_ready_transaction (ktm)) != NULL
+        && kvstxn_process (kt2, 1, rootref) == KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES
+        && kvstxn_iter_dirty_cache_entries (kt2, cache_noop_cb, NULL) == 0,
+        "transaction4 is storing");
+    ok ((kt3 = kvstxn_mgr_get_ready_transaction (ktm)) != NULL,
+        "kvstxn_mgr_get_ready_transaction returns transaction5");
+
+    /* pretend store of transaction3 failed */
+    kvstxn_set_aux_errnum (kt1, EIO);
+    ok (kvstxn_fallback_mergeable (kt1) == false,
+        "kvstxn_fallback_mergeable returns false on pipelined transaction");
+    kvstxn_mgr_remove_transaction (ktm, kt1, false);
+
+    ok (kvstxn_get_aux_errnum (kt2) == ECANCELED,
+        "transaction4 was canceled");
+    kvstxn_mgr_remove_transaction (ktm, kt2, false);
+
+    ok (kvstxn_mgr_get_ready_transaction (ktm) == kt3,
+        "kvstxn_mgr_get_ready_transaction returns transaction5");
+    ok (kvstxn_get_aux_errnum (kt3) == 0,
+        "transaction5 was not canceled");
+
+    ok (kvstxn_process (kt3, 1, rootref) == KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES,
+        "kvstxn_process transaction5 returns KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES");
+
+    ok (kvstxn_iter_dirty_cache_entries (kt3, cache_noop_cb, NULL) == 0,
+        "kvstxn_iter_dirty_cache_entries works");
+
+    ok (kvstxn_process (kt3, 1, rootref) == KVSTXN_PROCESS_FINISHED,
+        "kvstxn_process transaction5 returns KVSTXN_PROCESS_FINISHED");
+
+    ok ((newroot = kvstxn_get_newroot_ref (kt3)) != NULL,
+        "kvstxn_get_newroot_ref returns != NULL when processing complete");
+
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "key3", NULL);
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "key4", NULL);
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "key5", "5");
+
+    kvstxn_mgr_remove_transaction (ktm, kt3, false);
+
+    kvstxn_mgr_destroy (ktm);
+    kvsroot_mgr_destroy (krm);
+    cache_destroy (cache);
+}
+
+/* Applying a transaction must not modify the cached directories that
+ * the working copy of the root shares entries with.
+ */
+void kvstxn_process_copy_on_write (void)
+{
+    struct cache *cache;
+    struct cache_entry *entry;
+    kvsroot_mgr_t *krm;
+    kvstxn_mgr_t *ktm;
+    kvstxn_t *kt;
+    json_t *root;
+    json_t *dir;
+    json_t *subdir;
+    json_t *ops;
+    char root_ref[BLOBREF_MAX_STRING_SIZE];
+    char subdir_ref[BLOBREF_MAX_STRING_SIZE];
+    const char *newroot;
+
+    ok ((cache = cache_create ()) != NULL,
+        "cache_create works");
+    ok ((krm = kvsroot_mgr_create (NULL, NULL)) != NULL,
+        "kvsroot_mgr_create works");
+
+    /* This root is
+     *
+     * subdir_ref
+     * "a" : val to "1"
+     *
+     * root_ref
+     * "dir" : dir with { "val" : val to 42 }
+     * "subdir" : dirref to subdir_ref
+     * "val" : val to "x"
+     *
+     */
+
+    subdir = treeobj_create_dir ();
+    _treeobj_insert_entry_val (subdir, "a", "1", 1);
+
+    ok (treeobj_hash ("sha1", subdir, subdir_ref, sizeof (subdir_ref)) == 0,
+        "treeobj_hash worked");
+
+    (void)cache_insert (cache, create_cache_entry_treeobj (subdir_ref, subdir));
+
+    dir = treeobj_create_dir ();
+    _treeobj_insert_entry_val (dir, "val", "42", 2);
+
+    root = treeobj_create_dir ();
+    treeobj_insert_entry (root, "dir", dir);
+    _treeobj_insert_entry_dirref (root, "subdir", subdir_ref);
+    _treeobj_insert_entry_val (root, "val", "x", 1);
+
+    ok (treeobj_hash ("sha1", root, root_ref, sizeof (root_ref)) == 0,
+        "treeobj_hash worked");
+
+    (void)cache_insert (cache, create_cache_entry_treeobj (root_ref, root));
+
+    setup_kvsroot (krm, KVS_PRIMARY_NAMESPACE, cache, root_ref);
+
+    ok ((ktm = kvstxn_mgr_create (cache,
+                                  KVS_PRIMARY_NAMESPACE,
+                                  "sha1",
+                                  NULL,
+                                  &test_global)) != NULL,
+        "kvstxn_mgr_create works");
+
+    ops = json_array ();
+    ops_append (ops, "dir.val", "52", 0);
+    ops_append (ops, "subdir.b", "2", 0);
+    ops_append (ops, "subdir.a", NULL, 0);
+
+    ok (kvstxn_mgr_add_transaction (ktm, "transaction1", ops, 0) == 0,
+        "kvstxn_mgr_add_transaction works");
+    json_decref (ops);
+
+    ok ((kt = kvstxn_mgr_get_ready_transaction (ktm)) != NULL,
+        "kvstxn_mgr_get_ready_transaction returns ready kvstxn");
+
+    ok (kvstxn_process (kt, 1, root_ref) == KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES,
+        "kvstxn_process returns KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES");
+
+    ok (kvstxn_iter_dirty_cache_entries (kt, cache_noop_cb, NULL) == 0,
+        "kvstxn_iter_dirty_cache_entries works for dirty cache entries");
+
+    ok (kvstxn_process (kt, 1, root_ref) == KVSTXN_PROCESS_FINISHED,
+        "kvstxn_process returns KVSTXN_PROCESS_FINISHED");
+
+    ok ((newroot = kvstxn_get_newroot_ref (kt)) != NULL,
+        "kvstxn_get_newroot_ref returns != NULL when processing complete");
+
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "dir.val", "52");
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "subdir.a", NULL);
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "subdir.b", "2");
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "val", "x");
+
+    ok ((entry = cache_lookup (cache, root_ref, 1)) != NULL
+        && json_equal (cache_entry_get_treeobj (entry), root),
+        "cached root was not modified");
+    ok ((entry = cache_lookup (cache, subdir_ref, 1)) != NULL
+        && json_equal (cache_entry_get_treeobj (entry), subdir),
+        "cached subdir was not modified");
+
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, root_ref, "dir.val", "42");
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, root_ref, "subdir.a", "1");
+
+    kvstxn_mgr_destroy (ktm);
+    kvsroot_mgr_destroy (krm);
+    cache_destroy (cache);
+    json_decref (subdir);
+    json_decref (dir);
+    json_decref (root);
+}
+
 int main (int argc, char *argv[])
 {
     plan (NO_PLAN);
@@ -3400,9 +4133,14 @@ int main (int argc, char *argv[])
     kvstxn_process_big_fileval ();
     kvstxn_process_giant_dir ();
     kvstxn_process_append ();
+    kvstxn_process_append_merge ();
     kvstxn_process_append_errors ();
     kvstxn_process_append_no_duplicate ();
     kvstxn_process_fallback_merge ();
+    kvstxn_process_dirshard ();
+    kvstxn_process_pipeline ();
+    kvstxn_process_copy_on_write ();
+    kvstxn_process_ephemeral ();
 
     done_testing ();
     return (0);
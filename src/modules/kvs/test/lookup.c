@@ -249,6 +249,8 @@ void basic_api (void)
         "lookup_get_root_ref fails on not-completed lookup");
     ok (lookup_get_root_seq (lh) < 0,
         "lookup_get_root_seq fails on not-completed lookup");
+    ok (lookup_get_symlink_followed (lh) == true,
+        "lookup_get_symlink_followed returns true on not-completed lookup");
 
     lookup_destroy (lh);
 
@@ -361,10 +363,12 @@ void basic_lookup (void) {
      *
      * root_ref
      * "val" : val to "foo"
+     * "link" : symlink to "val"
      */
 
     root = treeobj_create_dir ();
     _treeobj_insert_entry_val (root, "val", "foo", 3);
+    _treeobj_insert_entry_symlink (root, "link", NULL, "val");
 
     treeobj_hash ("sha1", root, root_ref, sizeof (root_ref));
 
@@ -391,6 +395,26 @@ void basic_lookup (void) {
         "lookup_get_root_ref returned correct root_ref");
     ok (lookup_get_root_seq (lh) >= 0,
         "lookup_get_root_seq returned valid root_seq");
+    ok (lookup_get_symlink_followed (lh) == false,
+        "lookup_get_symlink_followed returns false without symlink");
+
+    lookup_destroy (lh);
+
+    ok ((lh = lookup_create (cache,
+                             krm,
+                             1,
+                             KVS_PRIMARY_NAMESPACE,
+                             NULL,
+                             0,
+                             "link",
+                             owner_cred,
+                             0,
+                             NULL)) != NULL,
+        "lookup_create of symlink works");
+    ok (lookup (lh) == LOOKUP_PROCESS_FINISHED,
+        "lookup process finished");
+    ok (lookup_get_symlink_followed (lh) == true,
+        "lookup_get_symlink_followed returns true after following symlink");
 
     lookup_destroy (lh);
 
@@ -3499,6 +3523,529 @@ void lookup_stall_ref_expire_cache_entries (void) {
     json_decref (root);
 }
 
+/* lookup prefetch of subdirectories and lookup stats */
+void lookup_prefetch (void) {
+    json_t *root;
+    json_t *dirref1;
+    json_t *valref_multi;
+    struct cache *cache;
+    kvsroot_mgr_t *krm;
+    lookup_t *lh;
+    struct lookup_stats stats;
+    struct lookup_ref_data ld;
+    char valref1_ref[BLOBREF_MAX_STRING_SIZE];
+    char valref2_ref[BLOBREF_MAX_STRING_SIZE];
+    char dirref1_ref[BLOBREF_MAX_STRING_SIZE];
+    char dirref2_ref[BLOBREF_MAX_STRING_SIZE];
+    char root_ref[BLOBREF_MAX_STRING_SIZE];
+
+    ok ((cache = cache_create ()) != NULL,
+        "cache_create works");
+    ok ((krm = kvsroot_mgr_create (NULL, NULL)) != NULL,
+        "kvsroot_mgr_create works");
+
+    /* This cache is
+     *
+     * dirref1_ref
+     * "val" : val to "foo"
+     *
+     * root_ref
+     * "val" : val to "bar"
+     * "valref_multi" : valref to [ valref1_ref, valref2_ref ]
+     * "dirref1" : dirref to dirref1_ref
+     * "dirref2" : dirref to dirref2_ref
+     *
+     * valref1_ref, valref2_ref, and dirref2_ref are never in the cache.
+     */
+
+    blobref_hash ("sha1", "abcd", 4, valref1_ref, sizeof (valref1_ref));
+    blobref_hash ("sha1", "efgh", 4, valref2_ref, sizeof (valref2_ref));
+    blobref_hash ("sha1", "ijkl", 4, dirref2_ref, sizeof (dirref2_ref));
+
+    dirref1 = treeobj_create_dir ();
+    _treeobj_insert_entry_val (dirref1, "val", "foo", 3);
+    treeobj_hash ("sha1", dirref1, dirref1_ref, sizeof (dirref1_ref));
+
+    root = treeobj_create_dir ();
+    _treeobj_insert_entry_val (root, "val", "bar", 3);
+    valref_multi = treeobj_create_valref (valref1_ref);
+    treeobj_append_blobref (valref_multi, valref2_ref);
+    treeobj_insert_entry (root, "valref_multi", valref_multi);
+    _treeobj_insert_entry_dirref (root, "dirref1", dirref1_ref);
+    _treeobj_insert_entry_dirref (root, "dirref2", dirref2_ref);
+    treeobj_hash ("sha1", root, root_ref, sizeof (root_ref));
+
+    (void)cache_insert (cache, create_cache_entry_treeobj (root_ref, root));
+
+    setup_kvsroot (krm, KVS_PRIMARY_NAMESPACE, cache, root_ref, 0);
+
+    memset (&stats, 0, sizeof (stats));
+
+    /* lookup valref_multi, both blobrefs reported in one stall */
+    ok ((lh = lookup_create (cache,
+                             krm,
+                             1,
+                             KVS_PRIMARY_NAMESPACE,
+                             NULL,
+                             0,
+                             "valref_multi",
+                             owner_cred,
+                             0,
+                             NULL)) != NULL,
+        "lookup_create valref_multi");
+    lookup_set_stats (lh, &stats);
+    ok (lookup_iter_prefetch_refs (lh, lookup_ref, NULL) < 0
+        && errno == EINVAL,
+        "lookup_iter_prefetch_refs fails b/c lookup not finished");
+    check_stall (lh, EAGAIN, 2, NULL, "valref_multi stall");
+    ok (stats.stalls == 1 && stats.stalls_avoided == 1,
+        "valref_multi stall counted, one stall avoided");
+    lookup_destroy (lh);
+
+    /* readdir of root, subdirectories not in cache are prefetched */
+    ok ((lh = lookup_create (cache,
+                             krm,
+                             1,
+                             KVS_PRIMARY_NAMESPACE,
+                             NULL,
+                             0,
+                             ".",
+                             owner_cred,
+                             FLUX_KVS_READDIR,
+                             NULL)) != NULL,
+        "lookup_create . readdir");
+    lookup_set_stats (lh, &stats);
+    ok (lookup (lh) == LOOKUP_PROCESS_FINISHED,
+        ". readdir: lookup finished");
+    memset (&ld, 0, sizeof (ld));
+    ok (lookup_iter_prefetch_refs (lh, lookup_ref, &ld) == 0
+        && ld.count == 2,
+        ". readdir: lookup_iter_prefetch_refs reports both dirrefs");
+    ok (stats.prefetches == 2,
+        ". readdir: prefetches counted");
+    ok (lookup_iter_prefetch_refs (lh, lookup_ref_error, NULL) < 0
+        && errno == EMLINK,
+        ". readdir: error & errno properly returned from callback error");
+    lookup_destroy (lh);
+
+    (void)cache_insert (cache, create_cache_entry_treeobj (dirref1_ref,
+                                                          dirref1));
+
+    /* readdir again, cached subdirectory is skipped */
+    ok ((lh = lookup_create (cache,
+                             krm,
+                             1,
+                             KVS_PRIMARY_NAMESPACE,
+                             NULL,
+                             0,
+                             ".",
+                             owner_cred,
+                             FLUX_KVS_READDIR,
+                             NULL)) != NULL,
+        "lookup_create . readdir");
+    ok (lookup (lh) == LOOKUP_PROCESS_FINISHED,
+        ". readdir: lookup finished");
+    memset (&ld, 0, sizeof (ld));
+    ok (lookup_iter_prefetch_refs (lh, lookup_ref, &ld) == 0
+        && ld.count == 1
+        && strcmp (ld.ref, dirref2_ref) == 0,
+        ". readdir: lookup_iter_prefetch_refs skips cached dirref");
+    lookup_destroy (lh);
+
+    /* plain lookup of a value does not prefetch */
+    ok ((lh = lookup_create (cache,
+                             krm,
+                             1,
+                             KVS_PRIMARY_NAMESPACE,
+                             NULL,
+                             0,
+                             "val",
+                             owner_cred,
+                             0,
+                             NULL)) != NULL,
+        "lookup_create val");
+    ok (lookup (lh) == LOOKUP_PROCESS_FINISHED,
+        "val: lookup finished");
+    memset (&ld, 0, sizeof (ld));
+    ok (lookup_iter_prefetch_refs (lh, lookup_ref, &ld) == 0
+        && ld.count == 0,
+        "val: lookup_iter_prefetch_refs reports nothing");
+    lookup_destroy (lh);
+
+    cache_destroy (cache);
+    kvsroot_mgr_destroy (krm);
+    json_decref (dirref1);
+    json_decref (valref_multi);
+    json_decref (root);
+}
+
+void lookup_result_cache (void) {
+    json_t *root;
+    json_t *dirref1;
+    json_t *test;
+    struct cache *cache;
+    struct lookup_cache *lc;
+    kvsroot_mgr_t *krm;
+    lookup_t *lh;
+    struct lookup_stats stats;
+    char dirref1_ref[BLOBREF_MAX_STRING_SIZE];
+    char root_ref[BLOBREF_MAX_STRING_SIZE];
+
+    ok (lookup_cache_create (0) == NULL && errno == EINVAL,
+        "lookup_cache_create maxsize=0 fails with EINVAL");
+    ok ((lc = lookup_cache_create (16)) != NULL,
+        "lookup_cache_create works");
+    ok ((cache = cache_create ()) != NULL,
+        "cache_create works");
+    ok ((krm = kvsroot_mgr_create (NULL, NULL)) != NULL,
+        "kvsroot_mgr_create works");
+
+    /* This cache is
+     *
+     * dirref1_ref
+     * "val" : val to "foo"
+     *
+     * root_ref
+     * "val" : val to "bar"
+     * "dirref1" : dirref to dirref1_ref
+     * "symlinkNS" : symlink to "val" in primary namespace
+     */
+
+    dirref1 = treeobj_create_dir ();
+    _treeobj_insert_entry_val (dirref1, "val", "foo", 3);
+    treeobj_hash ("sha1", dirref1, dirref1_ref, sizeof (dirref1_ref));
+
+    root = treeobj_create_dir ();
+    _treeobj_insert_entry_val (root, "val", "bar", 3);
+    _treeobj_insert_entry_dirref (root, "dirref1", dirref1_ref);
+    _treeobj_insert_entry_symlink (root, "symlinkNS",
+                                   KVS_PRIMARY_NAMESPACE, "val");
+    treeobj_hash ("sha1", root, root_ref, sizeof (root_ref));
+
+    (void)cache_insert (cache, create_cache_entry_treeobj (dirref1_ref,
+                                                          dirref1));
+    (void)cache_insert (cache, create_cache_entry_treeobj (root_ref, root));
+
+    setup_kvsroot (krm, KVS_PRIMARY_NAMESPACE, cache, root_ref, 0);
+
+    memset (&stats, 0, sizeof (stats));
+
+    /* first lookup walks the tree and caches the result */
+    ok ((lh = lookup_create (cache,
+                             krm,
+                             1,
+                             KVS_PRIMARY_NAMESPACE,
+                             NULL,
+                             0,
+                             "dirref1.val",
+                             owner_cred,
+                             0,
+                             NULL)) != NULL,
+        "lookup_create dirref1.val");
+    lookup_set_stats (lh, &stats);
+    lookup_set_result_cache (lh, lc);
+    test = treeobj_create_val ("foo", 3);
+    check_value (lh, test, "dirref1.val");
+    ok (lookup_cache_count (lc) == 1 && stats.result_hits == 0,
+        "dirref1.val: result cached");
+
+    /* with dirref1 gone from the cache, the result is still found */
+    ok (cache_remove_entry (cache, dirref1_ref) == 1,
+        "cache_remove_entry dirref1_ref");
+    ok ((lh = lookup_create (cache,
+                             krm,
+                             1,
+                             KVS_PRIMARY_NAMESPACE,
+                             NULL,
+                             0,
+                             "dirref1.val",
+                             owner_cred,
+                             0,
+                             NULL)) != NULL,
+        "lookup_create dirref1.val");
+    lookup_set_stats (lh, &stats);
+    lookup_set_result_cache (lh, lc);
+    check_value (lh, test, "dirref1.val from result cache");
+    json_decref (test);
+    ok (stats.result_hits == 1,
+        "dirref1.val: result cache hit counted");
+
+    /* different flags are a different cache key, so this stalls */
+    ok ((lh = lookup_create (cache,
+                             krm,
+                             1,
+                             KVS_PRIMARY_NAMESPACE,
+                             NULL,
+                             0,
+                             "dirref1.val",
+                             owner_cred,
+                             FLUX_KVS_TREEOBJ,
+                             NULL)) != NULL,
+        "lookup_create dirref1.val treeobj");
+    lookup_set_result_cache (lh, lc);
+    check_stall (lh, EAGAIN, 1, dirref1_ref, "dirref1.val treeobj stall");
+    lookup_destroy (lh);
+
+    /* failed lookups are cached too */
+    ok ((lh = lookup_create (cache,
+                             krm,
+                             1,
+                             KVS_PRIMARY_NAMESPACE,
+                             NULL,
+                             0,
+                             "nokey",
+                             owner_cred,
+                             0,
+                             NULL)) != NULL,
+        "lookup_create nokey");
+    lookup_set_stats (lh, &stats);
+    lookup_set_result_cache (lh, lc);
+    check_value (lh, NULL, "nokey");
+    ok ((lh = lookup_create (cache,
+                             krm,
+                             1,
+                             KVS_PRIMARY_NAMESPACE,
+                             NULL,
+                             0,
+                             "nokey",
+                             owner_cred,
+                             0,
+                             NULL)) != NULL,
+        "lookup_create nokey");
+    lookup_set_stats (lh, &stats);
+    lookup_set_result_cache (lh, lc);
+    check_value (lh, NULL, "nokey from result cache");
+    ok (lookup_cache_count (lc) == 2 && stats.result_hits == 2,
+        "nokey: result cache hit counted");
+
+    /* results through a namespace symlink and directories are not cached */
+    ok ((lh = lookup_create (cache,
+                             krm,
+                             1,
+                             KVS_PRIMARY_NAMESPACE,
+                             NULL,
+                             0,
+                             "symlinkNS",
+                             owner_cred,
+                             0,
+                             NULL)) != NULL,
+        "lookup_create symlinkNS");
+    lookup_set_result_cache (lh, lc);
+    test = treeobj_create_val ("bar", 3);
+    check_value (lh, test, "symlinkNS");
+    json_decref (test);
+    ok ((lh = lookup_create (cache,
+                             krm,
+                             1,
+                             KVS_PRIMARY_NAMESPACE,
+                             NULL,
+                             0,
+                             ".",
+                             owner_cred,
+                             FLUX_KVS_READDIR,
+                             NULL)) != NULL,
+        "lookup_create . readdir");
+    lookup_set_result_cache (lh, lc);
+    check_value (lh, root, ". readdir");
+    ok (lookup_cache_count (lc) == 2,
+        "symlinkNS and . readdir results not cached");
+
+    lookup_cache_destroy (lc);
+    cache_destroy (cache);
+    kvsroot_mgr_destroy (krm);
+    json_decref (dirref1);
+    json_decref (root);
+}
+
+/* lookups that start at an append position */
+void lookup_append (void) {
+    json_t *root;
+    json_t *valref;
+    json_t *test;
+    struct cache *cache;
+    kvsroot_mgr_t *krm;
+    lookup_t *lh;
+    int index, offset;
+    char valref1_ref[BLOBREF_MAX_STRING_SIZE];
+    char valref2_ref[BLOBREF_MAX_STRING_SIZE];
+    char valref3_ref[BLOBREF_MAX_STRING_SIZE];
+    char root_ref[BLOBREF_MAX_STRING_SIZE];
+
+    ok ((cache = cache_create ()) != NULL,
+        "cache_create works");
+    ok ((krm = kvsroot_mgr_create (NULL, NULL)) != NULL,
+        "kvsroot_mgr_create works");
+
+    /* This cache is
+     *
+     * valref1_ref
+     * "abcd"
+     *
+     * valref2_ref
+     * "efgh"
+     *
+     * root_ref
+     * "val" : val to "foo"
+     * "valref" : valref to [ valref1_ref, valref2_ref, valref3_ref ]
+     *
+     * valref3_ref ("ij") is not in the cache at first.
+     */
+
+    blobref_hash ("sha1", "abcd", 4, valref1_ref, sizeof (valref1_ref));
+    blobref_hash ("sha1", "efgh", 4, valref2_ref, sizeof (valref2_ref));
+    blobref_hash ("sha1", "ij", 2, valref3_ref, sizeof (valref3_ref));
+
+    (void)cache_insert (cache, create_cache_entry_raw (valref1_ref,
+                                                      "abcd", 4));
+    (void)cache_insert (cache, create_cache_entry_raw (valref2_ref,
+                                                      "efgh", 4));
+
+    root = treeobj_create_dir ();
+    _treeobj_insert_entry_val (root, "val", "foo", 3);
+    valref = treeobj_create_valref (valref1_ref);
+    treeobj_append_blobref (valref, valref2_ref);
+    treeobj_append_blobref (valref, valref3_ref);
+    treeobj_insert_entry (root, "valref", valref);
+    treeobj_hash ("sha1", root, root_ref, sizeof (root_ref));
+
+    (void)cache_insert (cache, create_cache_entry_treeobj (root_ref, root));
+
+    setup_kvsroot (krm, KVS_PRIMARY_NAMESPACE, cache, root_ref, 0);
+
+    /* only blobs from the append position are loaded */
+    ok ((lh = lookup_create (cache,
+                             krm,
+                             1,
+                             KVS_PRIMARY_NAMESPACE,
+                             NULL,
+                             0,
+                             "valref",
+                             owner_cred,
+                             0,
+                             NULL)) != NULL,
+        "lookup_create valref");
+    lookup_set_append_position (lh, 1, 2);
+    check_stall (lh, EAGAIN, 1, valref3_ref, "valref append stall");
+
+    (void)cache_insert (cache, create_cache_entry_raw (valref3_ref,
+                                                      "ij", 2));
+
+    test = treeobj_create_val ("ghij", 4);
+    ok (lookup (lh) == LOOKUP_PROCESS_FINISHED,
+        "valref append: lookup finished");
+    ok (lookup_get_append_position (lh, &index, &offset) == 0
+        && index == 2 && offset == 2,
+        "valref append: lookup_get_append_position returns end of value");
+    check_value (lh, test, "valref append");
+    json_decref (test);
+
+    /* position at the end returns no data */
+    ok ((lh = lookup_create (cache,
+                             krm,
+                             1,
+                             KVS_PRIMARY_NAMESPACE,
+                             NULL,
+                             0,
+                             "valref",
+                             owner_cred,
+                             0,
+                             NULL)) != NULL,
+        "lookup_create valref");
+    lookup_set_append_position (lh, 2, 2);
+    test = treeobj_create_val (NULL, 0);
+    check_value (lh, test, "valref append at end");
+    json_decref (test);
+
+    /* position past the end of a blob or the value is an error */
+    ok ((lh = lookup_create (cache,
+                             krm,
+                             1,
+                             KVS_PRIMARY_NAMESPACE,
+                             NULL,
+                             0,
+                             "valref",
+                             owner_cred,
+                             0,
+                             NULL)) != NULL,
+        "lookup_create valref");
+    lookup_set_append_position (lh, 0, 5);
+    check_error (lh, EINVAL, "valref append offset past end of blob");
+
+    ok ((lh = lookup_create (cache,
+                             krm,
+                             1,
+                             KVS_PRIMARY_NAMESPACE,
+                             NULL,
+                             0,
+                             "valref",
+                             owner_cred,
+                             0,
+                             NULL)) != NULL,
+        "lookup_create valref");
+    lookup_set_append_position (lh, 3, 0);
+    check_error (lh, EINVAL, "valref append index past end of value");
+
+    /* an inline val is blob 0 */
+    ok ((lh = lookup_create (cache,
+                             krm,
+                             1,
+                             KVS_PRIMARY_NAMESPACE,
+                             NULL,
+                             0,
+                             "val",
+                             owner_cred,
+                             0,
+                             NULL)) != NULL,
+        "lookup_create val");
+    lookup_set_append_position (lh, 0, 1);
+    test = treeobj_create_val ("oo", 2);
+    ok (lookup (lh) == LOOKUP_PROCESS_FINISHED,
+        "val append: lookup finished");
+    ok (lookup_get_append_position (lh, &index, &offset) == 0
+        && index == 0 && offset == 3,
+        "val append: lookup_get_append_position returns end of value");
+    check_value (lh, test, "val append");
+    json_decref (test);
+
+    ok ((lh = lookup_create (cache,
+                             krm,
+                             1,
+                             KVS_PRIMARY_NAMESPACE,
+                             NULL,
+                             0,
+                             "val",
+                             owner_cred,
+                             0,
+                             NULL)) != NULL,
+        "lookup_create val");
+    lookup_set_append_position (lh, 1, 0);
+    check_error (lh, EINVAL, "val append index past end of value");
+
+    /* a lookup without an append position has no end position */
+    ok ((lh = lookup_create (cache,
+                             krm,
+                             1,
+                             KVS_PRIMARY_NAMESPACE,
+                             NULL,
+                             0,
+                             "val",
+                             owner_cred,
+                             0,
+                             NULL)) != NULL,
+        "lookup_create val");
+    ok (lookup (lh) == LOOKUP_PROCESS_FINISHED,
+        "val: lookup finished");
+    ok (lookup_get_append_position (lh, &index, &offset) < 0
+        && errno == EINVAL,
+        "val: lookup_get_append_position fails with EINVAL");
+    lookup_destroy (lh);
+
+    cache_destroy (cache);
+    kvsroot_mgr_destroy (krm);
+    json_decref (valref);
+    json_decref (root);
+}
+
 int main (int argc, char *argv[])
 {
     plan (NO_PLAN);
@@ -3521,6 +4068,9 @@ int main (int argc, char *argv[])
     lookup_stall_ref ();
     lookup_stall_namespace_removed ();
     lookup_stall_ref_expire_cache_entries ();
+    lookup_prefetch ();
+    lookup_result_cache ();
+    lookup_append ();
 
     done_testing ();
     return (0);
@@ -194,6 +194,42 @@ void treq_ops_tests (void)
     treq_destroy (tr);
 }
 
+void treq_ops_single_tests (void)
+{
+    treq_t *tr;
+    json_t *ops;
+
+    ok ((tr = treq_create ("foo", 1, 0)) != NULL,
+        "treq_create works");
+
+    ok ((ops = json_array ()) != NULL,
+        "json_array works");
+
+    json_array_append_new (ops, json_string ("A"));
+
+    ok (treq_add_request_ops (tr, ops) == 0,
+        "treq_add_request_ops add works");
+
+    ok (treq_get_ops (tr) == ops,
+        "treq_get_ops references ops of the only request");
+
+    json_decref (ops);
+
+    ok (json_array_size (treq_get_ops (tr)) == 1,
+        "treq_get_ops is still valid after caller drops its reference");
+
+    treq_destroy (tr);
+
+    ok ((tr = treq_create_rank (1, 2, 1, 0)) != NULL,
+        "treq_create_rank works");
+
+    ok (treq_get_ops (tr) != NULL
+        && json_array_size (treq_get_ops (tr)) == 0,
+        "treq_get_ops returns empty array before ops are added");
+
+    treq_destroy (tr);
+}
+
 void treq_request_tests (void)
 {
     treq_t *tr;
@@ -366,6 +402,7 @@ int main (int argc, char *argv[])
 
     treq_basic_tests ();
     treq_ops_tests ();
+    treq_ops_single_tests ();
     treq_request_tests ();
     treq_mgr_basic_tests ();
     treq_mgr_iter_tests ();
@@ -32,14 +32,19 @@ struct treq_mgr {
     zlist_t *removelist;
 };
 
+/* A commit is a treq with nprocs=1 and one request, so that case is
+ * handled without allocations beyond the treq itself: its ops array is
+ * referenced rather than copied, and the request is held directly.
+ */
 struct treq {
-    char *name;
     int nprocs;
     int count;
-    zlist_t *requests;
+    const flux_msg_t *request;  /* first request */
+    zlist_t *requests;          /* further requests, created on demand */
     json_t *ops;
     int flags;
     bool processed;
+    char name[];
 };
 
 /*
@@ -176,14 +181,14 @@ int treq_mgr_transactions_count (treq_mgr_t *trm)
 void treq_destroy (treq_t *tr)
 {
     if (tr) {
-        free (tr->name);
         json_decref (tr->ops);
+        flux_msg_decref (tr->request);
         zlist_destroy (&tr->requests);
         free (tr);
     }
 }
 
-static treq_t *treq_create_common (int nprocs, int flags)
+static treq_t *treq_create_common (size_t namesize, int nprocs, int flags)
 {
     treq_t *tr = NULL;
     int saved_errno;
@@ -192,9 +197,8 @@ static treq_t *treq_create_common (int nprocs, int flags)
         saved_errno = EINVAL;
         goto error;
     }
-    if (!(tr = calloc (1, sizeof (*tr)))
-        || !(tr->ops = json_array ())
-        || !(tr->requests = zlist_new ())) {
+    if (!(tr = calloc (1, sizeof (*tr) + namesize))
+        || (nprocs > 1 && !(tr->ops = json_array ()))) {
         saved_errno = ENOMEM;
         goto error;
     }
@@ -212,50 +216,29 @@ error:
 treq_t *treq_create (const char *name, int nprocs, int flags)
 {
     treq_t *tr = NULL;
-    int saved_errno;
+    size_t namesize;
 
     if (!name) {
-        saved_errno = EINVAL;
-        goto error;
+        errno = EINVAL;
+        return NULL;
     }
-
-    if (!(tr = treq_create_common (nprocs, flags))) {
-        saved_errno = EINVAL;
-        goto error;
-    }
-
-    if (!(tr->name = strdup (name))) {
-        saved_errno = ENOMEM;
-        goto error;
-    }
-
+    namesize = strlen (name) + 1;
+    if (!(tr = treq_create_common (namesize, nprocs, flags)))
+        return NULL;
+    memcpy (tr->name, name, namesize);
     return tr;
-error:
-    treq_destroy (tr);
-    errno = saved_errno;
-    return NULL;
 }
 
 treq_t *treq_create_rank (uint32_t rank, unsigned int seq, int nprocs, int flags)
 {
     treq_t *tr = NULL;
-    int saved_errno;
-
-    if (!(tr = treq_create_common (nprocs, flags))) {
-        saved_errno = EINVAL;
-        goto error;
-    }
-
-    if (asprintf (&(tr->name), "treq.%u.%u", rank, seq) < 0) {
-        saved_errno = ENOMEM;
-        goto error;
-    }
+    int namesize;
 
+    namesize = snprintf (NULL, 0, "treq.%u.%u", rank, seq) + 1;
+    if (!(tr = treq_create_common (namesize, nprocs, flags)))
+        return NULL;
+    (void)snprintf (tr->name, namesize, "treq.%u.%u", rank, seq);
     return tr;
-error:
-    treq_destroy (tr);
-    errno = saved_errno;
-    return NULL;
 }
 
 bool treq_count_reached (treq_t *tr)
@@ -281,6 +264,8 @@ int treq_get_flags (treq_t *tr)
 
 json_t *treq_get_ops (treq_t *tr)
 {
+    if (!tr->ops)
+        tr->ops = json_array ();
     return tr->ops;
 }
 
@@ -294,6 +279,16 @@ int treq_add_request_ops (treq_t *tr, json_t *ops)
         return -1;
     }
 
+    if (tr->nprocs == 1 && json_is_array (ops)) {
+        json_decref (tr->ops);
+        tr->ops = json_incref (ops);
+        tr->count++;
+        return 0;
+    }
+    if (!tr->ops && !(tr->ops = json_array ())) {
+        errno = ENOMEM;
+        return -1;
+    }
     if (ops) {
         for (i = 0; i < json_array_size (ops); i++) {
             if ((op = json_array_get (ops, i)))
@@ -309,6 +304,14 @@ int treq_add_request_ops (treq_t *tr, json_t *ops)
 
 int treq_add_request_copy (treq_t *tr, const flux_msg_t *request)
 {
+    if (!tr->request) {
+        tr->request = flux_msg_incref (request);
+        return 0;
+    }
+    if (!tr->requests && !(tr->requests = zlist_new ())) {
+        errno = ENOMEM;
+        return -1;
+    }
     if (zlist_push (tr->requests, (void *)flux_msg_incref (request)) < 0) {
         flux_msg_decref (request);
         return -1;
@@ -324,12 +327,19 @@ int treq_iter_request_copies (treq_t *tr, treq_msg_cb cb, void *data)
 {
     const flux_msg_t *msg;
 
-    msg = zlist_first (tr->requests);
+    /* N.B. later requests are pushed onto tr->requests, so they are
+     * visited newest first, followed by the first request.
+     */
+    msg = tr->requests ? zlist_first (tr->requests) : NULL;
     while (msg) {
         if (cb (tr, msg, data) < 0)
             return -1;
         msg = zlist_next (tr->requests);
     }
+    if (tr->request) {
+        if (cb (tr, tr->request, data) < 0)
+            return -1;
+    }
 
     return 0;
 }
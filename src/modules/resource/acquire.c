@@ -36,6 +36,13 @@
  * targets from the resource_object are marked "down".  On the next
  * scheduler reload, the resource set will omit those targets.
  *
+ * Subsequent responses are computed from the idset carried by the
+ * resource.eventlog event that triggered them, so their cost scales with
+ * the number of targets that changed state, not with the size of the
+ * resource set.  If the event has no idset, availability is recomputed
+ * from scratch.  The resource.stats.get RPC reports the number and total
+ * size of update responses and the thread CPU time spent preparing them.
+ *
  * RESOURCE OBJECT
  *
  * The hwloc.by_rank object format is used as a placeholder until
@@ -61,6 +68,7 @@
 #if HAVE_CONFIG_H
 #include "config.h"
 #endif
+#include <time.h>
 #include <jansson.h>
 #include <flux/core.h>
 
@@ -87,12 +95,29 @@ struct acquire_request {
     struct idset *up;                   // available targets
 };
 
+struct acquire_stats {
+    int updates;                        // update responses sent
+    int resyncs;                        // updates that recomputed all targets
+    size_t bytes;                       // total update response payload size
+    double cpu;                         // thread CPU seconds in updates
+};
+
 struct acquire {
     struct resource_ctx *ctx;
     flux_msg_handler_t **handlers;
     struct acquire_request *request;    // N.B. there can be only one currently
+    struct acquire_stats stats;
 };
 
+static double thread_cputime (void)
+{
+    struct timespec ts;
+
+    if (clock_gettime (CLOCK_THREAD_CPUTIME_ID, &ts) < 0)
+        return 0.;
+    return ts.tv_sec + ts.tv_nsec * 1E-9;
+}
+
 
 static void acquire_request_destroy (struct acquire_request *ar)
 {
@@ -143,13 +168,12 @@ static int acquire_request_init (struct acquire_request *ar,
     return 0;
 }
 
-/* reslog_cb() says 'name' event occurred.
+/* Recompute the set of available targets from scratch.
  * If anything changed with respect to target availability, populate
  * up and/or down idsets with the changes.
  * Replace ar->up with new set of available targets.
  */
-static int acquire_request_update (struct acquire_request *ar,
-                                   const char *name,
+static int acquire_request_resync (struct acquire_request *ar,
                                    struct idset **up,
                                    struct idset **dn)
 {
@@ -168,12 +192,78 @@ static int acquire_request_update (struct acquire_request *ar,
         goto error;
     idset_destroy (ar->up);
     ar->up = new_up;
+    ar->acquire->stats.resyncs++;
     return 0;
 error:
     idset_destroy (new_up);
     return -1;
 }
 
+static bool target_is_up (struct resource_ctx *ctx, unsigned int id)
+{
+    return (idset_test (monitor_get_up (ctx->monitor), id)
+            && !idset_test (drain_get (ctx->drain), id)
+            && !idset_test (exclude_get (ctx->exclude), id));
+}
+
+/* Add 'id' to '*ids', creating it if necessary.
+ */
+static int idset_set_lazy (struct idset **ids, unsigned int id)
+{
+    if (!*ids && !(*ids = idset_create (0, IDSET_FLAG_AUTOGROW)))
+        return -1;
+    return idset_set (*ids, id);
+}
+
+/* reslog_cb() says an event occurred that may have changed the availability
+ * of the targets in 'context.idset'.  Re-evaluate only those targets.
+ * If anything changed, populate up and/or down idsets with the changes,
+ * and update ar->up in place.  Fall back to acquire_request_resync() if
+ * the event does not list the affected targets.
+ */
+static int acquire_request_update (struct acquire_request *ar,
+                                   json_t *context,
+                                   struct idset **up,
+                                   struct idset **dn)
+{
+    struct resource_ctx *ctx = ar->acquire->ctx;
+    const char *s;
+    struct idset *ids;
+    unsigned int id;
+
+    *up = *dn = NULL;
+    if (!context
+        || json_unpack (context, "{s:s}", "idset", &s) < 0
+        || !(ids = idset_decode (s)))
+        return acquire_request_resync (ar, up, dn);
+
+    id = idset_first (ids);
+    while (id != IDSET_INVALID_ID) {
+        if (idset_test (ar->valid, id)) {
+            bool is_up = target_is_up (ctx, id);
+
+            if (is_up && !idset_test (ar->up, id)) {
+                if (idset_set_lazy (up, id) < 0 || idset_set (ar->up, id) < 0)
+                    goto error;
+            }
+            else if (!is_up && idset_test (ar->up, id)) {
+                if (idset_set_lazy (dn, id) < 0
+                    || idset_clear (ar->up, id) < 0)
+                    goto error;
+            }
+        }
+        id = idset_next (ids, id);
+    }
+    idset_destroy (ids);
+    return 0;
+error:
+    ERRNO_SAFE_WRAP (idset_destroy, ids);
+    ERRNO_SAFE_WRAP (idset_destroy, *up);
+    ERRNO_SAFE_WRAP (idset_destroy, *dn);
+    *up = *dn = NULL;
+    return -1;
+}
+
 /* Send the first response to resource.acquire request.  This presumes
  * that acquire_request_init() has already prepared ar->resources and ar->up.
  */
@@ -207,6 +297,7 @@ static int acquire_respond_next (struct acquire_request *ar,
                                  struct idset *down)
 {
     json_t *o;
+    char *s = NULL;
 
     if (!(o = json_object()))
         goto nomem;
@@ -214,14 +305,20 @@ static int acquire_respond_next (struct acquire_request *ar,
         goto error;
     if (down && rutil_set_json_idset (o, "down", down) < 0)
         goto error;
-    if (flux_respond_pack (ar->acquire->ctx->h, ar->msg, "O", o) < 0)
+    if (!(s = json_dumps (o, JSON_COMPACT)))
+        goto nomem;
+    if (flux_respond (ar->acquire->ctx->h, ar->msg, s) < 0)
         goto error;
+    ar->acquire->stats.updates++;
+    ar->acquire->stats.bytes += strlen (s);
+    free (s);
     json_decref (o);
     ar->response_count++;
     return 0;
 nomem:
     errno = ENOMEM;
 error:
+    ERRNO_SAFE_WRAP (free, s);
     ERRNO_SAFE_WRAP (json_decref, o);
     return -1;
 }
@@ -309,7 +406,10 @@ void acquire_disconnect (struct acquire *acquire, const flux_msg_t *msg)
  * FWIW, this function is not called until after the eventlog KVS
  * commit completes.
  */
-static void reslog_cb (struct reslog *reslog, const char *name, void *arg)
+static void reslog_cb (struct reslog *reslog,
+                       const char *name,
+                       json_t *context,
+                       void *arg)
 {
     struct acquire *acquire = arg;
     struct resource_ctx *ctx = acquire->ctx;
@@ -340,7 +440,12 @@ static void reslog_cb (struct reslog *reslog, const char *name, void *arg)
             || !strcmp (name, "drain") || !strcmp (name, "undrain")) {
         if (acquire->request->response_count > 0) {
             struct idset *up, *dn;
-            if (acquire_request_update (acquire->request, name, &up, &dn) < 0) {
+            double t0 = thread_cputime ();
+
+            if (acquire_request_update (acquire->request,
+                                        context,
+                                        &up,
+                                        &dn) < 0) {
                 errmsg = "error preparing resource.acquire update response";
                 goto error;
             }
@@ -353,6 +458,7 @@ static void reslog_cb (struct reslog *reslog, const char *name, void *arg)
                 idset_destroy (up);
                 idset_destroy (dn);
             }
+            acquire->stats.cpu += thread_cputime () - t0;
         }
     }
     return;
@@ -369,6 +475,22 @@ static const struct flux_msg_handler_spec htab[] = {
     FLUX_MSGHANDLER_TABLE_END,
 };
 
+json_t *acquire_stats_get (struct acquire *acquire)
+{
+    json_t *o;
+
+    if (!(o = json_pack ("{s:b s:i s:i s:I s:f}",
+                         "active", acquire->request ? 1 : 0,
+                         "updates", acquire->stats.updates,
+                         "resyncs", acquire->stats.resyncs,
+                         "bytes", (json_int_t)acquire->stats.bytes,
+                         "cpu", acquire->stats.cpu))) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    return o;
+}
+
 void acquire_destroy (struct acquire *acquire)
 {
     if (acquire) {
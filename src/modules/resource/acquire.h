@@ -16,6 +16,11 @@ void acquire_destroy (struct acquire *acquire);
 
 void acquire_disconnect (struct acquire *acquire, const flux_msg_t *msg);
 
+/* Return counters for resource.acquire update responses:
+ * {active:b updates:i resyncs:i bytes:I cpu:f}
+ */
+json_t *acquire_stats_get (struct acquire *acquire);
+
 #endif /* !_FLUX_RESOURCE_ACQUIRE_H */
 
 
@@ -15,6 +15,7 @@ struct reslog;
 
 typedef void (*reslog_cb_f)(struct reslog *reslog,
                             const char *name,
+                            json_t *context,
                             void *arg);
 
 struct reslog *reslog_create (flux_t *h);
@@ -35,7 +36,7 @@ int reslog_post_pack (struct reslog *reslog,
  */
 int reslog_sync (struct reslog *reslog);
 
-/* Get a callback for each event.
+/* Get a callback for each event, with the event context, if any.
  */
 void reslog_set_callback (struct reslog *reslog, reslog_cb_f cb, void *arg);
 
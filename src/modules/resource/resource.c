@@ -118,6 +118,28 @@ static void disconnect_cb (flux_t *h,
     acquire_disconnect (ctx->acquire, msg);
 }
 
+/* Report counters for resource.acquire update responses.
+ */
+static void stats_cb (flux_t *h,
+                      flux_msg_handler_t *mh,
+                      const flux_msg_t *msg,
+                      void *arg)
+{
+    struct resource_ctx *ctx = arg;
+    json_t *acquire;
+
+    if (flux_request_decode (msg, NULL, NULL) < 0)
+        goto error;
+    if (!(acquire = acquire_stats_get (ctx->acquire)))
+        goto error;
+    if (flux_respond_pack (h, msg, "{s:o}", "acquire", acquire) < 0)
+        flux_log_error (h, "error responding to stats-get request");
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "error responding to stats-get request");
+}
+
 static void resource_ctx_destroy (struct resource_ctx *ctx)
 {
     if (ctx) {
@@ -157,6 +179,12 @@ static const struct flux_msg_handler_spec htab[] = {
         .cb = disconnect_cb,
         .rolemask = 0
     },
+    {
+        .typemask = FLUX_MSGTYPE_REQUEST,
+        .topic_glob = MODULE_NAME ".stats.get",
+        .cb = stats_cb,
+        .rolemask = 0
+    },
     FLUX_MSGHANDLER_TABLE_END,
 };
 
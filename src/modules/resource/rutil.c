@@ -23,37 +23,31 @@
 
 int rutil_idset_sub (struct idset *ids1, const struct idset *ids2)
 {
-    if (!ids1) {
-        errno = EINVAL;
-        return -1;
-    }
-    if (ids2) {
-        unsigned int id;
-        id = idset_first (ids2);
-        while (id != IDSET_INVALID_ID) {
-            if (idset_clear (ids1, id) < 0)
-                return -1;
-            id = idset_next (ids2, id);
-        }
-    }
-    return 0;
+    return idset_subtract (ids1, ids2);
 }
 
 int rutil_idset_add (struct idset *ids1, const struct idset *ids2)
 {
-    if (!ids1) {
-        errno = EINVAL;
-        return -1;
-    }
-    if (ids2) {
-        unsigned int id;
-        id = idset_first (ids2);
-        while (id != IDSET_INVALID_ID) {
-            if (idset_set (ids1, id) < 0)
-                return -1;
-            id = idset_next (ids2, id);
+    return idset_add (ids1, ids2);
+}
+
+/* Set *result to ids1 - ids2, or NULL if that is empty.
+ */
+static int idset_diff_nonempty (const struct idset *ids1,
+                                const struct idset *ids2,
+                                struct idset **result)
+{
+    struct idset *ids = NULL;
+
+    if (ids1 && idset_count (ids1) > 0) {
+        if (!(ids = idset_difference (ids1, ids2)))
+            return -1;
+        if (idset_count (ids) == 0) {
+            idset_destroy (ids);
+            ids = NULL;
         }
     }
+    *result = ids;
     return 0;
 }
 
@@ -64,36 +58,14 @@ int rutil_idset_diff (const struct idset *ids1,
 {
     struct idset *add = NULL;
     struct idset *sub = NULL;
-    unsigned int id;
 
     if (!addp || !subp) {
         errno = EINVAL;
         return -1;
     }
-    if (ids1) { // find ids in ids1 but not in ids2, and add to 'sub'
-        id = idset_first (ids1);
-        while (id != IDSET_INVALID_ID) {
-            if (!ids2 || !idset_test (ids2, id)) {
-                if (!sub && !(sub = idset_create (0, IDSET_FLAG_AUTOGROW)))
-                    goto error;
-                if (idset_set (sub, id) < 0)
-                    goto error;
-            }
-            id = idset_next (ids1, id);
-        }
-    }
-    if (ids2) { // find ids in ids2 but not in ids1, and add to 'add'
-        id = idset_first (ids2);
-        while (id != IDSET_INVALID_ID) {
-            if (!ids1 || !idset_test (ids1, id)) {
-                if (!add && !(add = idset_create (0, IDSET_FLAG_AUTOGROW)))
-                    goto error;
-                if (idset_set (add, id) < 0)
-                    goto error;
-            }
-            id = idset_next (ids2, id);
-        }
-    }
+    if (idset_diff_nonempty (ids1, ids2, &sub) < 0
+        || idset_diff_nonempty (ids2, ids1, &add) < 0)
+        goto error;
     *addp = add;
     *subp = sub;
     return 0;
@@ -138,17 +110,12 @@ struct idset *rutil_idset_from_resobj (const json_t *resobj)
     if (resobj) {
         json_object_foreach ((json_t *)resobj, key, val) {
             struct idset *valset;
-            unsigned long id;
 
             if (!(valset = idset_decode (key)))
                 goto error;
-            id = idset_first (valset);
-            while (id != IDSET_INVALID_ID) {
-                if (idset_set (ids, id) < 0) {
-                    idset_destroy (valset);
-                    goto error;
-                }
-                id = idset_next (valset, id);
+            if (idset_add (ids, valset) < 0) {
+                idset_destroy (valset);
+                goto error;
             }
             idset_destroy (valset);
         }
@@ -14,10 +14,433 @@
 
 #include <errno.h>
 #include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <limits.h>
+#include <math.h>
 #include <jansson.h>
 
 #include "libjj.h"
 
+/* Fast path:  scan the jobspec text in place, without decoding it.
+ *
+ * The scanner checks the JSON syntax of the whole document, but it only
+ * handles the well formed jobspecs that make up nearly all requests.
+ * Anything unusual, such as an escaped key, a non-ASCII string, a null
+ * where an object is expected, a duplicate key, or a value that would be
+ * an error, makes it give up, and the jansson parser below runs instead.
+ * That parser is the reference:  the scanner must never succeed where it
+ * fails, or return different counts, and it alone reports errors.
+ */
+#define JJ_SCAN_MAX_DEPTH 64
+
+struct jj_token {
+    const char *s;
+    size_t len;
+};
+
+static void scan_ws (const char **pp)
+{
+    const char *p = *pp;
+    while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')
+        p++;
+    *pp = p;
+}
+
+static bool scan_char (const char **pp, char c)
+{
+    scan_ws (pp);
+    if (**pp != c)
+        return false;
+    (*pp)++;
+    return true;
+}
+
+static bool is_hex (char c)
+{
+    return (c >= '0' && c <= '9')
+        || (c >= 'a' && c <= 'f')
+        || (c >= 'A' && c <= 'F');
+}
+
+/* Scan a string, setting 'tok' to its contents, unless 'tok' is NULL.
+ * An escaped string may only be skipped, since its contents differ from
+ * its text.  \u0000 and surrogates are left to jansson, which rejects
+ * \u0000 by default and checks surrogate pairs.
+ */
+static bool scan_string (const char **pp, struct jj_token *tok)
+{
+    const char *p;
+
+    if (!scan_char (pp, '"'))
+        return false;
+    p = *pp;
+    while (*p != '"') {
+        unsigned char c = *p;
+        if (c < 0x20 || c >= 0x80)
+            return false;
+        if (c == '\\') {
+            if (tok)
+                return false;
+            p++;
+            if (*p == 'u') {
+                if (!is_hex (p[1]) || !is_hex (p[2])
+                    || !is_hex (p[3]) || !is_hex (p[4])
+                    || !strncmp (p + 1, "0000", 4)
+                    || p[1] == 'd' || p[1] == 'D')
+                    return false;
+                p += 4;
+            }
+            else if (!strchr ("\"\\/bfnrt", *p) || *p == '\0')
+                return false;
+        }
+        p++;
+    }
+    if (tok) {
+        tok->s = *pp;
+        tok->len = p - *pp;
+    }
+    *pp = p + 1;
+    return true;
+}
+
+static bool token_is (struct jj_token *tok, const char *s)
+{
+    return tok->len == strlen (s) && !strncmp (tok->s, s, tok->len);
+}
+
+static bool scan_digits (const char **pp)
+{
+    const char *p = *pp;
+    while (*p >= '0' && *p <= '9')
+        p++;
+    if (p == *pp)
+        return false;
+    *pp = p;
+    return true;
+}
+
+/* Scan a number, setting 'tok' to its text and 'is_int' to true
+ * if it has neither fraction nor exponent.
+ */
+static bool scan_number (const char **pp, struct jj_token *tok, bool *is_int)
+{
+    const char *p;
+
+    scan_ws (pp);
+    p = *pp;
+    *is_int = true;
+    if (*p == '-')
+        p++;
+    if (*p == '0')
+        p++;
+    else if (!scan_digits (&p))
+        return false;
+    if (*p == '.') {
+        p++;
+        if (!scan_digits (&p))
+            return false;
+        *is_int = false;
+    }
+    if (*p == 'e' || *p == 'E') {
+        p++;
+        if (*p == '+' || *p == '-')
+            p++;
+        if (!scan_digits (&p))
+            return false;
+        *is_int = false;
+    }
+    tok->s = *pp;
+    tok->len = p - *pp;
+    *pp = p;
+    return true;
+}
+
+/* Scan an integer that fits in an int.
+ */
+static bool scan_int (const char **pp, int *valp)
+{
+    struct jj_token tok;
+    bool is_int;
+    const char *p;
+    long long val = 0;
+
+    if (!scan_number (pp, &tok, &is_int) || !is_int)
+        return false;
+    p = tok.s;
+    if (*p == '-')
+        p++;
+    for (; p < tok.s + tok.len; p++) {
+        val = val * 10 + (*p - '0');
+        if (val > INT_MAX)
+            return false;
+    }
+    *valp = *tok.s == '-' ? -val : val;
+    return true;
+}
+
+static bool scan_real (const char **pp, double *valp)
+{
+    struct jj_token tok;
+    bool is_int;
+    char *end;
+    double val;
+
+    if (!scan_number (pp, &tok, &is_int))
+        return false;
+    if (is_int && tok.len > 15)
+        return false;
+    errno = 0;
+    val = strtod (tok.s, &end);
+    if (end != tok.s + tok.len || errno != 0 || !isfinite (val))
+        return false;
+    *valp = val;
+    return true;
+}
+
+static bool scan_literal (const char **pp, const char *s)
+{
+    size_t len = strlen (s);
+    if (strncmp (*pp, s, len) != 0)
+        return false;
+    *pp += len;
+    return true;
+}
+
+static bool scan_value (const char **pp, int depth);
+
+/* Scan the opening brace of an object, then each key up to the closing
+ * brace.  Call with 'first' true, then after scanning each member value.
+ * Return 1 with 'key' set, 0 at the end of the object, or -1 on error.
+ */
+static int scan_member (const char **pp, struct jj_token *key, bool first)
+{
+    if (first) {
+        if (!scan_char (pp, '{'))
+            return -1;
+        if (scan_char (pp, '}'))
+            return 0;
+    }
+    else {
+        if (scan_char (pp, '}'))
+            return 0;
+        if (!scan_char (pp, ','))
+            return -1;
+    }
+    if (!scan_string (pp, key) || !scan_char (pp, ':'))
+        return -1;
+    return 1;
+}
+
+static bool scan_object (const char **pp, int depth)
+{
+    struct jj_token key;
+    bool first = true;
+    int rc;
+
+    while ((rc = scan_member (pp, &key, first)) == 1) {
+        if (!scan_value (pp, depth))
+            return false;
+        first = false;
+    }
+    return rc == 0;
+}
+
+static bool scan_array (const char **pp, int depth)
+{
+    if (!scan_char (pp, '['))
+        return false;
+    if (scan_char (pp, ']'))
+        return true;
+    do {
+        if (!scan_value (pp, depth))
+            return false;
+    } while (scan_char (pp, ','));
+    return scan_char (pp, ']');
+}
+
+/* Scan any value, checking its syntax.
+ */
+static bool scan_value (const char **pp, int depth)
+{
+    double val;
+
+    if (++depth > JJ_SCAN_MAX_DEPTH)
+        return false;
+    scan_ws (pp);
+    switch (**pp) {
+        case '{':
+            return scan_object (pp, depth);
+        case '[':
+            return scan_array (pp, depth);
+        case '"':
+            return scan_string (pp, NULL);
+        case 't':
+            return scan_literal (pp, "true");
+        case 'f':
+            return scan_literal (pp, "false");
+        case 'n':
+            return scan_literal (pp, "null");
+        default:
+            /* jansson rejects numbers that overflow */
+            return scan_real (pp, &val);
+    }
+}
+
+static bool scan_level (const char *p, struct jj_counts *jj);
+
+/* Scan one resource vertex.  Its "with" array is scanned after the
+ * vertex itself, wherever it appears among the keys, to match the
+ * order in which jj_read_vertex() assigns counts.
+ */
+static bool scan_vertex (const char **pp, struct jj_counts *jj)
+{
+    struct jj_token key;
+    struct jj_token type = { NULL, 0 };
+    const char *with = NULL;
+    int count = 0;
+    bool have_count = false;
+    bool first = true;
+    int rc;
+
+    while ((rc = scan_member (pp, &key, first)) == 1) {
+        if (token_is (&key, "type")) {
+            if (type.s || !scan_string (pp, &type))
+                return false;
+        }
+        else if (token_is (&key, "count")) {
+            if (have_count || !scan_int (pp, &count))
+                return false;
+            have_count = true;
+        }
+        else if (token_is (&key, "with")) {
+            scan_ws (pp);
+            if (with || **pp != '[')
+                return false;
+            with = *pp;
+            if (!scan_array (pp, 0))
+                return false;
+        }
+        else if (!scan_value (pp, 0))
+            return false;
+        first = false;
+    }
+    if (rc < 0 || !type.s || !have_count || count <= 0)
+        return false;
+    if (token_is (&type, "node"))
+        jj->nnodes = count;
+    else if (token_is (&type, "slot"))
+        jj->nslots = count;
+    else if (token_is (&type, "core"))
+        jj->slot_size = count;
+    else
+        return false;
+    if (with)
+        return scan_level (with, jj);
+    return true;
+}
+
+static bool scan_level (const char *p, struct jj_counts *jj)
+{
+    if (!scan_char (&p, '['))
+        return false;
+    if (scan_char (&p, ']'))
+        return true;
+    do {
+        if (!scan_vertex (&p, jj))
+            return false;
+    } while (scan_char (&p, ','));
+    return scan_char (&p, ']');
+}
+
+/* Scan attributes.system.duration.
+ */
+static bool scan_attributes (const char **pp, struct jj_counts *jj)
+{
+    struct jj_token key;
+    bool have_system = false;
+    bool have_duration = false;
+    bool first = true;
+    int rc;
+
+    while ((rc = scan_member (pp, &key, first)) == 1) {
+        if (token_is (&key, "system")) {
+            bool sfirst = true;
+            int src;
+
+            if (have_system)
+                return false;
+            have_system = true;
+            while ((src = scan_member (pp, &key, sfirst)) == 1) {
+                if (token_is (&key, "duration")) {
+                    if (have_duration || !scan_real (pp, &jj->duration))
+                        return false;
+                    have_duration = true;
+                }
+                else if (!scan_value (pp, 2))
+                    return false;
+                sfirst = false;
+            }
+            if (src < 0)
+                return false;
+        }
+        else if (!scan_value (pp, 1))
+            return false;
+        first = false;
+    }
+    return rc == 0;
+}
+
+static bool scan_counts (const char *spec, struct jj_counts *jj)
+{
+    const char *p = spec;
+    struct jj_token key;
+    const char *resources = NULL;
+    bool have_version = false;
+    bool have_attributes = false;
+    bool first = true;
+    int version = 0;
+    int rc;
+
+    if (!p)
+        return false;
+    while ((rc = scan_member (&p, &key, first)) == 1) {
+        if (token_is (&key, "version")) {
+            if (have_version || !scan_int (&p, &version))
+                return false;
+            have_version = true;
+        }
+        else if (token_is (&key, "resources")) {
+            scan_ws (&p);
+            if (resources || *p != '[')
+                return false;
+            resources = p;
+            if (!scan_array (&p, 0))
+                return false;
+        }
+        else if (token_is (&key, "attributes")) {
+            if (have_attributes || !scan_attributes (&p, jj))
+                return false;
+            have_attributes = true;
+        }
+        else if (!scan_value (&p, 0))
+            return false;
+        first = false;
+    }
+    scan_ws (&p);
+    if (rc < 0 || *p != '\0')
+        return false;
+    if (!have_version || version != 1 || !resources || !have_attributes)
+        return false;
+    if (!scan_level (resources, jj))
+        return false;
+    if (jj->nslots <= 0 || jj->slot_size <= 0)
+        return false;
+    if (jj->nnodes)
+        jj->nslots *= jj->nnodes;
+    return true;
+}
+
 static int jj_read_level (json_t *o, int level, struct jj_counts *jj);
 
 static int jj_read_vertex (json_t *o, int level, struct jj_counts *jj)
@@ -91,6 +514,9 @@ int libjj_get_counts (const char *spec, struct jj_counts *jj)
         return -1;
     }
     memset (jj, 0, sizeof (*jj));
+    if (scan_counts (spec, jj))
+        return 0;
+    memset (jj, 0, sizeof (*jj));
 
     if ((o = json_loads (spec, 0, &error)) == NULL) {
         snprintf (jj->error, sizeof (jj->error) - 1,
@@ -145,6 +571,35 @@ err:
     errno = saved_errno;
     return rc;
 }
+
+int libjj_get_counts_json (json_t *o, struct jj_counts *jj)
+{
+    json_error_t error;
+
+    if (!o || !jj) {
+        errno = EINVAL;
+        return -1;
+    }
+    memset (jj, 0, sizeof (*jj));
+    if (json_unpack_ex (o, &error, 0, "{s:i s:i s:i s:F}",
+                        "nnodes", &jj->nnodes,
+                        "nslots", &jj->nslots,
+                        "slot_size", &jj->slot_size,
+                        "duration", &jj->duration) < 0) {
+        snprintf (jj->error, sizeof (jj->error) - 1,
+                  "counts: %s", error.text);
+        errno = EINVAL;
+        return -1;
+    }
+    if (jj->nnodes < 0 || jj->nslots <= 0 || jj->slot_size <= 0) {
+        snprintf (jj->error, sizeof (jj->error) - 1,
+                  "counts: invalid nnodes=%d nslots=%d slot_size=%d",
+                  jj->nnodes, jj->nslots, jj->slot_size);
+        errno = EINVAL;
+        return -1;
+    }
+    return 0;
+}
                        
 
 /* vi: ts=4 sw=4 expandtab
@@ -14,6 +14,7 @@
 #if HAVE_CONFIG_H
 #include "config.h"
 #endif
+#include <jansson.h>
 
 #define JJ_ERROR_TEXT_LENGTH 256
 
@@ -34,4 +35,12 @@ struct jj_counts {
  */
 int libjj_get_counts (const char *spec, struct jj_counts *counts);
 
+/*  Get the resource request summary precomputed by job-ingest, from the
+ *   "counts" object of a sched.alloc request:
+ *   {"nnodes":i, "nslots":i, "slot_size":i, "duration":f}
+ *  Returns 0 on success and -1 on failure with errno set and jj->error[]
+ *   with an error message string.
+ */
+int libjj_get_counts_json (json_t *o, struct jj_counts *counts);
+
 #endif /* !HAVE_SCHED_LIBJJ_H */
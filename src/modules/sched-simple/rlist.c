@@ -20,13 +20,108 @@
 #include <jansson.h>
 
 #include "src/common/libidset/idset.h"
+#include "src/common/libutil/skiplist.h"
 #include "rnode.h"
 #include "rlist.h"
 #include "libjj.h"
 
+/*  Availability index:
+ *
+ *  Once the first allocation is attempted, each node is kept in
+ *   rl->by_avail[i], where i is its number of available cores (0 if
+ *   the node is down).  Each entry is a skiplist sorted by rank.  The
+ *   index is updated whenever a node's availability changes, so the
+ *   fit algorithms below can choose a node by looking at the head of
+ *   at most one list per possible core count instead of sorting or
+ *   scanning the whole node list.
+ *
+ *  If the index cannot be updated (e.g. out of memory), it is dropped,
+ *   and rebuilt on the next allocation.
+ */
+static int rnode_rank_cmp (const void *item1, const void *item2)
+{
+    const struct rnode *x = item1;
+    const struct rnode *y = item2;
+    if (x->rank == y->rank)
+        return 0;
+    return x->rank < y->rank ? -1 : 1;
+}
+
+static void rlist_index_destroy (struct rlist *rl)
+{
+    int i;
+    for (i = 0; i < rl->index_size; i++)
+        skiplist_destroy (rl->by_avail[i]);
+    free (rl->by_avail);
+    rl->by_avail = NULL;
+    rl->index_size = 0;
+}
+
+static int rlist_index_grow (struct rlist *rl, int size)
+{
+    if (size > rl->index_size) {
+        struct skiplist **a = realloc (rl->by_avail, size * sizeof (*a));
+        if (!a)
+            return -1;
+        rl->by_avail = a;
+        while (rl->index_size < size) {
+            if (!(a[rl->index_size] = skiplist_create (rnode_rank_cmp)))
+                return -1;
+            rl->index_size++;
+        }
+    }
+    return 0;
+}
+
+/*  Move node `n` to the index entry for its current availability.
+ *  No-op if the index has not been built.
+ */
+static void rlist_index_update (struct rlist *rl, struct rnode *n)
+{
+    int avail;
+
+    if (!rl->by_avail)
+        return;
+    avail = rnode_avail (n);
+    if (n->index_handle && n->index_avail == avail)
+        return;
+    if (rlist_index_grow (rl, avail + 1) < 0)
+        goto error;
+    if (n->index_handle)
+        skiplist_delete (rl->by_avail[n->index_avail], n->index_handle);
+    if (!(n->index_handle = skiplist_insert (rl->by_avail[avail], n)))
+        goto error;
+    n->index_avail = avail;
+    return;
+error:
+    rlist_index_destroy (rl);
+}
+
+static int rlist_index_build (struct rlist *rl)
+{
+    struct rnode *n;
+
+    if (rl->by_avail)
+        return 0;
+    if (rlist_index_grow (rl, 1) < 0) {
+        rlist_index_destroy (rl);
+        return -1;
+    }
+    n = zlistx_first (rl->nodes);
+    while (n) {
+        n->index_handle = NULL;
+        rlist_index_update (rl, n);
+        if (!rl->by_avail)
+            return -1;
+        n = zlistx_next (rl->nodes);
+    }
+    return 0;
+}
+
 void rlist_destroy (struct rlist *rl)
 {
     if (rl) {
+        rlist_index_destroy (rl);
         zlistx_destroy (&rl->nodes);
         free (rl);
     }
@@ -58,7 +153,7 @@ struct rlist *rlist_copy_empty (const struct rlist *orig)
         return NULL;
     n = zlistx_first (orig->nodes);
     while (n) {
-        n = rnode_create_idset (n->rank, n->ids);
+        n = rnode_copy_empty (n);
         if (!n || !zlistx_add_end (rl->nodes, n))
             goto fail;
         rl->total += rnode_count (n);
@@ -71,6 +166,29 @@ fail:
     return NULL;
 }
 
+struct rlist *rlist_copy (const struct rlist *orig)
+{
+    struct rnode *n;
+    struct rlist *rl = rlist_create ();
+    if (!rl)
+        return NULL;
+    n = zlistx_first (orig->nodes);
+    while (n) {
+        struct rnode *copy = rnode_copy (n);
+        if (!copy || !zlistx_add_end (rl->nodes, copy)) {
+            rnode_destroy (copy);
+            goto fail;
+        }
+        n = zlistx_next (orig->nodes);
+    }
+    rl->total = orig->total;
+    rl->avail = orig->avail;
+    return rl;
+fail:
+    rlist_destroy (rl);
+    return NULL;
+}
+
 struct rlist *rlist_copy_down (const struct rlist *orig)
 {
     struct rnode *n;
@@ -80,7 +198,7 @@ struct rlist *rlist_copy_down (const struct rlist *orig)
     n = zlistx_first (orig->nodes);
     while (n) {
         if (!n->up) {
-            n = rnode_create_idset (n->rank, n->ids);
+            n = rnode_copy_empty (n);
             if (!n || !zlistx_add_end (rl->nodes, n))
                 goto fail;
             rl->total += rnode_count (n);
@@ -94,26 +212,10 @@ fail:
     return NULL;
 }
 
-static struct idset *idset_subtract (const struct idset *orig, struct idset *x)
-{
-    struct idset *ids = idset_copy (orig);
-    unsigned int i;
-
-    if (!ids)
-        return NULL;
-
-    i = idset_first (x);
-    while (i != IDSET_INVALID_ID) {
-        idset_clear (ids, i);
-        i = idset_next (x, i);
-    }
-    return ids;
-}
-
 static struct rnode *rnode_create_alloc (const struct rnode *n)
 {
     struct rnode *result;
-    struct idset *ids = idset_subtract (n->ids, n->avail);
+    struct idset *ids = idset_difference (n->ids, n->avail);
     if (!ids)
         return NULL;
     result = rnode_create_idset (n->rank, ids);
@@ -156,55 +258,13 @@ static struct rnode *rlist_find_rank (struct rlist *rl, uint32_t rank)
     return NULL;
 }
 
-/*  Compare two values from idset_first()/idset_next():
- *  Returns:
- *    0   : if x == y
- *    > 0 : if x > y
- *    < 0 : if x < y
- *
- *  Where IDSET_INVALID_ID is considered to come before all numbers.
- */
-static int idset_val_cmp (unsigned int x, unsigned int y)
-{
-    if (x == y)
-        return 0;
-    else if (x == IDSET_INVALID_ID)
-        return -1;
-    else if (y == IDSET_INVALID_ID)
-        return  1;
-    else
-        return (x - y);
-}
-
-static int idset_cmp (struct idset *set1, struct idset *set2)
-{
-    int rv = 0;
-    if (!idset_equal (set1, set2)) {
-        /*  Sort on the first non-equal integer (see idset_val_cmp())
-         */
-        unsigned int a = idset_first (set1);
-        unsigned int b = idset_first (set2);
-        while ((rv = idset_val_cmp (a, b)) == 0) {
-            a = idset_next (set1, a);
-            b = idset_next (set2, b);
-        }
-    }
-    return rv;
-}
-
 static int idset_add_set (struct idset *set, struct idset *new)
 {
-    unsigned int i = idset_first (new);
-    while (i != IDSET_INVALID_ID) {
-        if (idset_test (set, i)) {
-            errno = EEXIST;
-            return -1;
-        }
-        if (idset_set (set, i) < 0)
-            return -1;
-        i = idset_next (new, i);
+    if (idset_has_intersection (set, new)) {
+        errno = EEXIST;
+        return -1;
     }
-    return 0;
+    return idset_add (set, new);
 }
 
 static int idset_remove_set (struct idset *set, struct idset *remove)
@@ -215,35 +275,53 @@ static int idset_remove_set (struct idset *set, struct idset *remove)
             errno = ENOENT;
             return -1;
         }
-        if (idset_clear (set, i) < 0)
-            return -1;
         i = idset_next (remove, i);
     }
+    return idset_subtract (set, remove);
+}
+
+/*  Add `n`, whose rank is known not to be in `rl` yet.
+ */
+static int rlist_push_rnode (struct rlist *rl, struct rnode *n)
+{
+    if (!zlistx_add_end (rl->nodes, n))
+        return -1;
+    rl->total += rnode_count (n);
+    if (n->up)
+        rl->avail += rnode_avail (n);
+    rlist_index_update (rl, n);
     return 0;
 }
 
 static int rlist_add_rnode (struct rlist *rl, struct rnode *n)
 {
     struct rnode *found = rlist_find_rank (rl, n->rank);
-    if (found) {
-        if (idset_add_set (found->ids, n->ids) < 0)
-            return (-1);
-        if (idset_add_set (found->avail, n->avail) < 0) {
-            idset_remove_set (found->ids, n->ids);
-            return (-1);
-        }
+    if (!found)
+        return rlist_push_rnode (rl, n);
+    if (rnode_unshare (found) < 0
+        || idset_add_set (found->ids, n->ids) < 0)
+        return (-1);
+    if (idset_add_set (found->avail, n->avail) < 0) {
+        idset_remove_set (found->ids, n->ids);
+        rnode_avail_changed (found);
+        return (-1);
     }
-    else if (!zlistx_add_end (rl->nodes, n))
-        return -1;
+    rnode_avail_changed (found);
     rl->total += rnode_count (n);
     if (n->up)
         rl->avail += rnode_avail (n);
-    if (found)
-        rnode_destroy (n);
+    rlist_index_update (rl, found);
+    rnode_destroy (n);
     return 0;
 }
 
+/*  Append one by_rank entry:  the ranks in idset `ranks` all have the
+ *   shape described by `e`, so its ids are decoded once and shared by
+ *   their rnodes.  Ranks not in `seen` are new to `rl` and skip the
+ *   search for an existing rnode to merge with.
+ */
 static int rlist_append (struct rlist *rl,
+                         struct idset *seen,
                          const char *ranks,
                          json_t *e,
                          const char *name)
@@ -253,6 +331,7 @@ static int rlist_append (struct rlist *rl,
     unsigned int i;
     const char *corelist = NULL;
     struct rnode *node;
+    struct rnode_shape *shape = NULL;
     struct idset *ids = idset_decode (ranks);
     json_error_t err;
 
@@ -260,20 +339,31 @@ static int rlist_append (struct rlist *rl,
                                 "Core", &n,
                                 name, &corelist) < 0)
         goto out;
+    if (corelist)
+        shape = rnode_shape_create (corelist);
+    else
+        shape = rnode_shape_create_count (n);
+    if (!shape)
+        goto out;
     i = idset_first (ids);
     while (i != IDSET_INVALID_ID) {
-        if (corelist)
-            node = rnode_create (i, corelist);
+        int added;
+        if (!(node = rnode_create_shape (i, shape)))
+            goto out;
+        if (!idset_test (seen, i))
+            added = rlist_push_rnode (rl, node);
         else
-            node = rnode_create_count (i, n);
-        if (!node || rlist_add_rnode (rl, node) < 0) {
-            rnode_destroy (node);
+            added = rlist_add_rnode (rl, node);
+        if (added < 0 || idset_set (seen, i) < 0) {
+            if (added < 0)
+                rnode_destroy (node);
             goto out;
         }
         i = idset_next (ids, i);
     }
     rc = 0;
 out:
+    rnode_shape_decref (shape);
     idset_destroy (ids);
     return rc;
 }
@@ -281,23 +371,31 @@ out:
 struct rlist *rlist_from_hwloc_by_rank (const char *by_rank, bool sched_pus)
 {
     struct rlist *rl = NULL;
+    struct idset *seen = NULL;
     const char *key = NULL;
     json_t *entry = NULL;
 
     json_t *o = json_loads (by_rank, 0, NULL);
     if (o == NULL)
         return NULL;
-    if (!(rl = rlist_create ()))
+    if (!(rl = rlist_create ())
+        || !(seen = idset_create (0, IDSET_FLAG_AUTOGROW)))
         goto err;
 
     json_object_foreach (o, key, entry) {
-        if (rlist_append (rl, key, entry, sched_pus ? "cpuset" : "coreids") < 0)
+        if (rlist_append (rl,
+                          seen,
+                          key,
+                          entry,
+                          sched_pus ? "cpuset" : "coreids") < 0)
             goto err;
     }
+    idset_destroy (seen);
     json_decref (o);
 
     return (rl);
 err:
+    idset_destroy (seen);
     json_decref (o);
     rlist_destroy (rl);
     return NULL;
@@ -392,21 +490,9 @@ err:
 /* Helper for rlist_compressed */
 struct multi_rnode {
     struct idset *ids;
-    const struct rnode *rnode;
+    struct rnode *rnode;
 };
 
-static int multi_rnode_cmp (struct multi_rnode *x, const struct rnode *n)
-{
-    int rv = idset_cmp (x->rnode->avail, n->avail);
-
-    /* Only collapse nodes with same avail idset + same up/down status */
-    if (rv == 0 && n->up == x->rnode->up)
-        return 0;
-
-    /* O/w, order doesn't matter too much, but put up nodes first */
-    return n->up ? -1 : 1;
-}
-
 static void multi_rnode_destroy (struct multi_rnode **mrn)
 {
     if (mrn && *mrn) {
@@ -435,15 +521,13 @@ fail:
 json_t *multi_rnode_tojson (struct multi_rnode *mrn)
 {
     json_t *o = NULL;
-    char *ids = NULL;
+    const char *ids = rnode_avail_str (mrn->rnode);
     char *ranks = idset_encode (mrn->ids, IDSET_FLAG_RANGE);
 
-    ids = idset_encode (mrn->rnode->avail, IDSET_FLAG_RANGE);
     if (!ids || !ranks)
         goto done;
     o = json_pack ("{s:s,s:{s:s}}", "rank", ranks, "children", "core", ids);
 done:
-    free (ids);
     free (ranks);
     return (o);
 }
@@ -460,33 +544,51 @@ static int multi_rnode_by_rank (const void *item1, const void *item2)
     return (x - y);
 }
 
+/*  Group nodes with the same available ids and up/down status.
+ *  Groups are found by hashing the cached encoding of each node's
+ *   available ids, so the cost is proportional to the number of nodes,
+ *   not nodes times groups.
+ */
 static zlistx_t * rlist_mrlist (struct rlist *rl)
 {
     struct rnode *n = NULL;
     struct multi_rnode *mrn = NULL;
+    zhashx_t *up = zhashx_new ();
+    zhashx_t *down = zhashx_new ();
     zlistx_t *l = zlistx_new ();
 
-    zlistx_set_comparator (l, (czmq_comparator *) multi_rnode_cmp);
+    if (!up || !down || !l)
+        goto fail;
     zlistx_set_destructor (l, (czmq_destructor *) multi_rnode_destroy);
 
     n = zlistx_first (rl->nodes);
     while (n) {
-        if (zlistx_find (l, n)) {
-            if (!(mrn = zlistx_handle_item (zlistx_cursor (l)))
-                    || idset_set (mrn->ids, n->rank) < 0) {
+        zhashx_t *groups = n->up ? up : down;
+        const char *key = rnode_avail_str (n);
+
+        if (!key)
+            goto fail;
+        if ((mrn = zhashx_lookup (groups, key))) {
+            if (idset_set (mrn->ids, n->rank) < 0)
                 goto fail;
-            }
         }
         else {
             if (!(mrn = multi_rnode_create (n))
                     || !zlistx_add_end (l, mrn)) {
+                multi_rnode_destroy (&mrn);
                 goto fail;
             }
+            if (zhashx_insert (groups, key, mrn) < 0)
+                goto fail;
         }
         n = zlistx_next (rl->nodes);
     }
+    zhashx_destroy (&up);
+    zhashx_destroy (&down);
     return (l);
 fail:
+    zhashx_destroy (&up);
+    zhashx_destroy (&down);
     zlistx_destroy (&l);
     return NULL;
 }
@@ -565,17 +667,27 @@ char * rlist_dumps (struct rlist *rl)
 
     mrn = zlistx_first (l);
     while (mrn) {
-        char *ranks = idset_encode (mrn->ids, flags);
-        char *cores = idset_encode (mrn->rnode->avail, flags);
+        char *ranks;
+        const char *cores;
+        bool brackets = idset_count (mrn->rnode->avail) > 1;
 
+        if (!(ranks = idset_encode (mrn->ids, flags))
+            || !(cores = rnode_avail_str (mrn->rnode))) {
+            free (ranks);
+            goto fail;
+        }
         /* Be sure to skip empty corelists */
         if (strlen (cores) > 0
-            && sprintfcat (&result, &size, &len , "%srank%s/core%s",
+            && sprintfcat (&result, &size, &len , "%srank%s/core%s%s%s",
                          result[0] != '\0' ? " ": "",
-                         ranks, cores) < 0)
+                         ranks,
+                         brackets ? "[" : "",
+                         cores,
+                         brackets ? "]" : "") < 0) {
+            free (ranks);
             goto fail;
+        }
         free (ranks);
-        free (cores);
         mrn = zlistx_next (l);
     }
     zlistx_destroy (&l);
@@ -607,16 +719,6 @@ static int by_rank (const void *item1, const void *item2)
     return (x->rank - y->rank);
 }
 
-static int by_avail (const void *item1, const void *item2)
-{
-    int n;
-    const struct rnode *x = item1;
-    const struct rnode *y = item2;
-    if ((n = rnode_avail (x) - rnode_avail (y)) == 0)
-        n = by_rank (x, y);
-    return n;
-}
-
 static int by_used (const void *item1, const void *item2)
 {
     int n;
@@ -633,6 +735,7 @@ static int rlist_rnode_alloc (struct rlist *rl, struct rnode *n,
     if (!n || rnode_alloc (n, count, idsetp) < 0)
         return -1;
     rl->avail -= idset_count (*idsetp);
+    rlist_index_update (rl, n);
     return 0;
 }
 
@@ -647,92 +750,129 @@ static uint32_t rlist_rnode_rank (struct rlist *rl)
 }
 #endif
 
-static struct rnode *rlist_first (struct rlist *rl)
+/*  Return the node with at least `count` cores available that a fit
+ *   algorithm should allocate from next, or NULL if there is none.
+ */
+typedef struct rnode * (*rnode_pick_f) (struct rlist *rl, int count);
+
+/*  Lowest ranked node with `count` cores available.
+ */
+static struct rnode *pick_first_fit (struct rlist *rl, int count)
+{
+    struct rnode *result = NULL;
+    int i;
+    for (i = count; i < rl->index_size; i++) {
+        struct rnode *n = skiplist_first (rl->by_avail[i]);
+        if (n && (!result || n->rank < result->rank))
+            result = n;
+    }
+    return result;
+}
+
+/*  Lowest ranked node among those with the fewest available cores
+ *   that still have `count` cores available.
+ */
+static struct rnode *pick_best_fit (struct rlist *rl, int count)
 {
-    return zlistx_first (rl->nodes);
+    int i;
+    for (i = count; i < rl->index_size; i++) {
+        struct rnode *n = skiplist_first (rl->by_avail[i]);
+        if (n)
+            return n;
+    }
+    return NULL;
 }
 
-static struct rnode *rlist_next (struct rlist *rl)
+/*  Lowest ranked node among those with the most available cores.
+ */
+static struct rnode *pick_worst_fit (struct rlist *rl, int count)
 {
-    return zlistx_next (rl->nodes);
+    int i;
+    for (i = rl->index_size - 1; i >= count && i > 0; i--) {
+        struct rnode *n = skiplist_first (rl->by_avail[i]);
+        if (n)
+            return n;
+    }
+    return NULL;
 }
 
 /*
- *  Allocate the first available N slots of size cores_per_slot from
- *   resource list rl after sorting the nodes with the current sort strategy.
+ *  Allocate `slots` of size cores_per_slot from rlist `rl`, filling
+ *   the node chosen by `pick` before choosing the next one.
  */
-static struct rlist * rlist_alloc_first_fit (struct rlist *rl,
-                                             int cores_per_slot,
-                                             int slots)
+static struct rlist * rlist_alloc_fit (struct rlist *rl,
+                                       rnode_pick_f pick,
+                                       int cores_per_slot,
+                                       int slots)
 {
     int rc;
     struct idset *ids = NULL;
     struct rnode *n = NULL;
     struct rlist *result = NULL;
 
-    zlistx_sort (rl->nodes);
-
-    if (!(n = rlist_first (rl)))
+    if (rlist_index_build (rl) < 0)
         return NULL;
 
     if (!(result = rlist_create ()))
         return NULL;
 
-    /* 2. assign slots to first nodes where they fit
-     */
-    while (n && slots) {
-        /*  Try to allocate a slot on this node. If we fail with ENOSPC,
-         *   then advance to the next node and try again.
+    while (slots > 0) {
+        if (!(n = pick (rl, cores_per_slot)))
+            goto unwind;
+        /*  Assign slots to this node while they fit. Its position in
+         *   the availability index is updated on each allocation.
          */
-        if ((rc = rlist_rnode_alloc (rl, n, cores_per_slot, &ids)) < 0) {
-            if (errno != ENOSPC)
+        while (slots > 0 && rnode_avail (n) >= cores_per_slot) {
+            if (rlist_rnode_alloc (rl, n, cores_per_slot, &ids) < 0)
+                goto unwind;
+            rc = rlist_append_idset (result, n->rank, ids);
+            idset_destroy (ids);
+            if (rc < 0)
                 goto unwind;
-            n = rlist_next (rl);
-            continue;
+            slots--;
         }
-        /*  Append the allocated cores to the result set and continue
-         *   if needed
-         */
-        rc = rlist_append_idset (result, n->rank, ids);
-        idset_destroy (ids);
-        if (rc < 0)
-            goto unwind;
-        slots--;
-    }
-    if (slots != 0) {
-unwind:
-        rlist_free (rl, result);
-        rlist_destroy (result);
-        errno = ENOSPC;
-        return NULL;
     }
     return result;
+unwind:
+    rlist_free (rl, result);
+    rlist_destroy (result);
+    errno = ENOSPC;
+    return NULL;
+}
+
+/*
+ *  Allocate the first available N slots of size cores_per_slot from
+ *   resource list rl in rank order.
+ */
+static struct rlist * rlist_alloc_first_fit (struct rlist *rl,
+                                             int cores_per_slot,
+                                             int slots)
+{
+    return rlist_alloc_fit (rl, pick_first_fit, cores_per_slot, slots);
 }
 
 /*
  *  Allocate `slots` of size cores_per_slot from rlist `rl` and return
- *   the result. Sorts the node list by smallest available first, so that
+ *   the result. Uses nodes with smallest available first, so that
  *   we get something like "best fit". (minimize nodes used)
  */
 static struct rlist * rlist_alloc_best_fit (struct rlist *rl,
                                             int cores_per_slot,
                                             int slots)
 {
-    zlistx_set_comparator (rl->nodes, by_avail);
-    return rlist_alloc_first_fit (rl, cores_per_slot, slots);
+    return rlist_alloc_fit (rl, pick_best_fit, cores_per_slot, slots);
 }
 
 /*
  *  Allocate `slots` of size cores_per_slot from rlist `rl` and return
- *   the result. Sorts the node list by least utilized first, so that
+ *   the result. Uses least utilized nodes first, so that
  *   we get something like "worst fit". (Spread jobs across nodes)
  */
 static struct rlist * rlist_alloc_worst_fit (struct rlist *rl,
                                              int cores_per_slot,
                                              int slots)
 {
-    zlistx_set_comparator (rl->nodes, by_used);
-    return rlist_alloc_first_fit (rl, cores_per_slot, slots);
+    return rlist_alloc_fit (rl, pick_worst_fit, cores_per_slot, slots);
 }
 
 
@@ -928,6 +1068,7 @@ static int rlist_free_rnode (struct rlist *rl, struct rnode *n)
         return -1;
     if (rnode->up)
         rl->avail += idset_count (n->ids);
+    rlist_index_update (rl, rnode);
     return 0;
 }
 
@@ -941,6 +1082,7 @@ static int rlist_alloc_rnode (struct rlist *rl, struct rnode *n)
     if (rnode_alloc_idset (rnode, n->avail) < 0)
         return -1;
     rl->avail -= idset_count (n->avail);
+    rlist_index_update (rl, rnode);
     return 0;
 }
 
@@ -1002,6 +1144,98 @@ size_t rlist_nnodes (struct rlist *rl)
     return zlistx_size (rl->nodes);
 }
 
+enum {
+    SUMMARY_ALL,
+    SUMMARY_UP,
+    SUMMARY_DOWN,
+    SUMMARY_ALLOCATED,
+    SUMMARY_FREE,
+    SUMMARY_COUNT,
+};
+
+static const char *summary_names[] = {
+    "all", "up", "down", "allocated", "free",
+};
+
+struct summary_entry {
+    int nnodes;
+    int ncores;
+    struct idset *ranks;
+};
+
+static int summary_add (struct summary_entry *e, uint32_t rank, int ncores)
+{
+    e->nnodes++;
+    e->ncores += ncores;
+    return idset_set (e->ranks, rank);
+}
+
+json_t *rlist_summary (struct rlist *rl)
+{
+    int flags = IDSET_FLAG_RANGE | IDSET_FLAG_BRACKETS;
+    struct summary_entry e[SUMMARY_COUNT];
+    json_t *o = NULL;
+    struct rnode *n;
+    int i;
+
+    if (!rl) {
+        errno = EINVAL;
+        return NULL;
+    }
+    memset (e, 0, sizeof (e));
+    for (i = 0; i < SUMMARY_COUNT; i++) {
+        if (!(e[i].ranks = idset_create (0, IDSET_FLAG_AUTOGROW)))
+            goto out;
+    }
+    n = zlistx_first (rl->nodes);
+    while (n) {
+        int count = rnode_count (n);
+        int avail = rnode_avail (n);
+
+        if (summary_add (&e[SUMMARY_ALL], n->rank, count) < 0
+            || summary_add (&e[n->up ? SUMMARY_UP : SUMMARY_DOWN],
+                            n->rank,
+                            count) < 0
+            || (count > avail
+                && summary_add (&e[SUMMARY_ALLOCATED],
+                                n->rank,
+                                count - avail) < 0)
+            || (n->up && avail > 0
+                && summary_add (&e[SUMMARY_FREE], n->rank, avail) < 0))
+            goto out;
+        n = zlistx_next (rl->nodes);
+    }
+    if (!(o = json_object ()))
+        goto nomem;
+    for (i = 0; i < SUMMARY_COUNT; i++) {
+        json_t *entry;
+        char *ranks;
+
+        if (!(ranks = idset_encode (e[i].ranks, flags)))
+            goto error;
+        entry = json_pack ("{s:i s:i s:i s:s}",
+                           "nnodes", e[i].nnodes,
+                           "ncores", e[i].ncores,
+                           "ngpus", 0,
+                           "ranks", ranks);
+        free (ranks);
+        if (!entry || json_object_set_new (o, summary_names[i], entry) < 0) {
+            json_decref (entry);
+            goto nomem;
+        }
+    }
+    goto out;
+nomem:
+    errno = ENOMEM;
+error:
+    json_decref (o);
+    o = NULL;
+out:
+    for (i = 0; i < SUMMARY_COUNT; i++)
+        idset_destroy (e[i].ranks);
+    return o;
+}
+
 /* Mark all nodes in state 'up'. Count number of cores that changed
  *  availability state.
  */
@@ -1013,6 +1247,7 @@ static int rlist_mark_all (struct rlist *rl, bool up)
         if (n->up != up)
             count += idset_count (n->avail);
         n->up = up;
+        rlist_index_update (rl, n);
         n = zlistx_next (rl->nodes);
     }
     return count;
@@ -1031,6 +1266,7 @@ static int rlist_mark_state (struct rlist *rl, bool up, const char *ids)
         if (n->up != up)
             count += idset_count (n->avail);
         n->up = up;
+        rlist_index_update (rl, n);
         i = idset_next (idset, i);
     }
     idset_destroy (idset);
@@ -24,6 +24,10 @@ struct rlist {
     int total;
     int avail;
     zlistx_t *nodes;
+
+    /* nodes indexed by available core count, built on first alloc */
+    struct skiplist **by_avail;
+    int index_size;
 };
 
 /*  Create an empty rlist object */
@@ -40,6 +44,9 @@ int rlist_mark_up (struct rlist *rl, const char *ids);
 /*  Create a copy of rlist rl with all cores available */
 struct rlist *rlist_copy_empty (const struct rlist *rl);
 
+/*  Create a copy of rlist rl, including allocated and down state */
+struct rlist *rlist_copy (const struct rlist *rl);
+
 /*  Create a copy of rl including only down resources */
 struct rlist *rlist_copy_down (const struct rlist *orig);
 
@@ -72,6 +79,20 @@ size_t rlist_nnodes (struct rlist *rl);
  */
 json_t * rlist_to_R (struct rlist *rl);
 
+/*
+ *  Summarize resource list `rl` by state without encoding any per-rank
+ *   detail.  Returns an object with an entry for each of "all", "up",
+ *   "down", "allocated" and "free":
+ *
+ *   {"nnodes":i, "ncores":i, "ngpus":i, "ranks":s}
+ *
+ *   where "ranks" is a ranged idset of the ranks with resources in that
+ *   state.  As in the sets returned by sched.resource-status, "free"
+ *   is the unallocated cores of up nodes, and "allocated" includes
+ *   allocated cores of down nodes.
+ */
+json_t *rlist_summary (struct rlist *rl);
+
 /*
  *  Dump short form description of rlist `rl` as a single line string.
  *    Caller must free returned string.
@@ -20,15 +20,151 @@
 
 #include "rnode.h"
 
+static struct rnode_shape *rnode_shape_alloc (struct idset *ids)
+{
+    struct rnode_shape *shape;
+
+    if (!ids || !(shape = calloc (1, sizeof (*shape)))) {
+        idset_destroy (ids);
+        return NULL;
+    }
+    shape->refcount = 1;
+    shape->ids = ids;
+    return shape;
+}
+
+struct rnode_shape *rnode_shape_create (const char *ids)
+{
+    return rnode_shape_alloc (idset_decode (ids));
+}
+
+struct rnode_shape *rnode_shape_create_count (int count)
+{
+    struct idset *ids;
+
+    if (!(ids = idset_create (0, IDSET_FLAG_AUTOGROW))
+        || (count > 0 && idset_range_set (ids, 0, count-1) < 0)) {
+        idset_destroy (ids);
+        return NULL;
+    }
+    return rnode_shape_alloc (ids);
+}
+
+static struct rnode_shape *rnode_shape_incref (struct rnode_shape *shape)
+{
+    shape->refcount++;
+    return shape;
+}
+
+void rnode_shape_decref (struct rnode_shape *shape)
+{
+    if (shape && --shape->refcount == 0) {
+        idset_destroy (shape->ids);
+        free (shape->ids_str);
+        free (shape);
+    }
+}
+
+static bool avail_shared (const struct rnode *n)
+{
+    return n->shape && n->avail == n->shape->ids;
+}
+
 void rnode_destroy (struct rnode *n)
 {
     if (n) {
-        idset_destroy (n->avail);
-        idset_destroy (n->ids);
+        if (!avail_shared (n))
+            idset_destroy (n->avail);
+        if (!n->shape)
+            idset_destroy (n->ids);
+        rnode_shape_decref (n->shape);
+        free (n->avail_str);
         free (n);
     }
 }
 
+/*  Copy on allocate:  give `n` its own avail before it is modified.
+ */
+static int rnode_avail_own (struct rnode *n)
+{
+    struct idset *avail;
+
+    if (!avail_shared (n))
+        return 0;
+    if (!(avail = idset_copy (n->avail)))
+        return -1;
+    n->avail = avail;
+    return 0;
+}
+
+/*  Share the shape's avail again once all ids are free.
+ */
+static void rnode_avail_reshare (struct rnode *n)
+{
+    if (n->shape
+        && !avail_shared (n)
+        && idset_count (n->avail) == idset_count (n->ids)) {
+        idset_destroy (n->avail);
+        n->avail = n->shape->ids;
+    }
+}
+
+int rnode_unshare (struct rnode *n)
+{
+    struct idset *ids;
+
+    if (!n->shape)
+        return 0;
+    if (rnode_avail_own (n) < 0)
+        return -1;
+    if (!(ids = idset_copy (n->ids)))
+        return -1;
+    n->ids = ids;
+    rnode_shape_decref (n->shape);
+    n->shape = NULL;
+    return 0;
+}
+
+struct rnode *rnode_create_shape (uint32_t rank, struct rnode_shape *shape)
+{
+    struct rnode *n = calloc (1, sizeof (*n));
+    if (n == NULL)
+        return NULL;
+    n->rank = rank;
+    n->shape = rnode_shape_incref (shape);
+    n->ids = shape->ids;
+    n->avail = shape->ids;
+    n->up = true;
+    return (n);
+}
+
+struct rnode *rnode_copy_empty (const struct rnode *n)
+{
+    if (n->shape)
+        return rnode_create_shape (n->rank, n->shape);
+    return rnode_create_idset (n->rank, n->ids);
+}
+
+struct rnode *rnode_copy (const struct rnode *n)
+{
+    struct rnode *copy;
+
+    if (!(copy = rnode_copy_empty (n)))
+        return NULL;
+    if (!avail_shared (n)) {
+        struct idset *avail;
+        if (!(avail = idset_copy (n->avail))) {
+            rnode_destroy (copy);
+            return NULL;
+        }
+        if (!avail_shared (copy))
+            idset_destroy (copy->avail);
+        copy->avail = avail;
+    }
+    copy->up = n->up;
+    return copy;
+}
+
 struct rnode *rnode_create (uint32_t rank, const char *ids)
 {
     struct rnode *n = calloc (1, sizeof (*n));
@@ -90,7 +226,8 @@ int rnode_alloc (struct rnode *n, int count, struct idset **setp)
         errno = ENOSPC;
         return -1;
     }
-    if (!(ids = idset_create (0, IDSET_FLAG_AUTOGROW)))
+    if (rnode_avail_own (n) < 0
+        || !(ids = idset_create (0, IDSET_FLAG_AUTOGROW)))
         return -1;
     i = idset_first (n->avail);
     while (count--) {
@@ -98,6 +235,7 @@ int rnode_alloc (struct rnode *n, int count, struct idset **setp)
         idset_clear (n->avail, i);
         i = idset_next (n->avail, i);
     }
+    rnode_avail_changed (n);
     if (setp != NULL)
         *setp = ids;
     return (0);
@@ -126,18 +264,16 @@ static bool alloc_ids_valid (struct rnode *n, struct idset *ids)
 
 int rnode_alloc_idset (struct rnode *n, struct idset *ids)
 {
-    unsigned int i;
     if (!ids) {
         errno = EINVAL;
         return -1;
     }
     if (!alloc_ids_valid (n, ids))
         return -1;
-    i = idset_first (ids);
-    while (i != IDSET_INVALID_ID) {
-        idset_clear (n->avail, i);
-        i = idset_next (ids, i);
-    }
+    if (rnode_avail_own (n) < 0
+        || idset_subtract (n->avail, ids) < 0)
+        return -1;
+    rnode_avail_changed (n);
     return 0;
 }
 
@@ -164,18 +300,17 @@ static bool free_ids_valid (struct rnode *n, struct idset *ids)
 
 int rnode_free_idset (struct rnode *n, struct idset *ids)
 {
-    unsigned int i;
     if (!ids) {
         errno = EINVAL;
         return -1;
     }
     if (!free_ids_valid (n, ids))
         return -1;
-    i = idset_first (ids);
-    while (i != IDSET_INVALID_ID) {
-        idset_set (n->avail, i);
-        i = idset_next (ids, i);
-    }
+    if (rnode_avail_own (n) < 0
+        || idset_add (n->avail, ids) < 0)
+        return -1;
+    rnode_avail_reshare (n);
+    rnode_avail_changed (n);
     return 0;
 }
 
@@ -202,6 +337,25 @@ size_t rnode_count (const struct rnode *n)
     return (idset_count (n->ids));
 }
 
+const char *rnode_avail_str (struct rnode *n)
+{
+    if (avail_shared (n)) {
+        if (!n->shape->ids_str)
+            n->shape->ids_str = idset_encode (n->shape->ids,
+                                              IDSET_FLAG_RANGE);
+        return n->shape->ids_str;
+    }
+    if (!n->avail_str)
+        n->avail_str = idset_encode (n->avail, IDSET_FLAG_RANGE);
+    return n->avail_str;
+}
+
+void rnode_avail_changed (struct rnode *n)
+{
+    free (n->avail_str);
+    n->avail_str = NULL;
+}
+
 
 /* vi: ts=4 sw=4 expandtab
  */
@@ -19,12 +19,33 @@
 #include <jansson.h>
 #include <flux/idset.h>
 
-/* Simple resource node object */
+/* A set of ids shared by the rnodes of many ranks with the same shape,
+ *  so that each rank does not parse and store its own copy.
+ */
+struct rnode_shape {
+    int refcount;
+    struct idset * ids;
+    char * ids_str;     /* cached encoding of ids */
+};
+
+/* Simple resource node object
+ *
+ *  If `shape` is set, `ids` is the shape's idset, which must not be
+ *   modified, and so is `avail` until ids are allocated from the node.
+ *   The first allocation gives the node its own copy of `avail`, which
+ *   is dropped again once all ids are free.
+ */
 struct rnode {
     bool up;
     uint32_t rank;
     struct idset * ids;
     struct idset * avail;
+    char * avail_str;   /* cached encoding of avail, see rnode_avail_str() */
+    struct rnode_shape * shape;
+
+    /* availability index entry, private to rlist.c */
+    int index_avail;
+    void *index_handle;
 };
 
 /*  Create a resource node object from an existing idset `set`
@@ -40,6 +61,30 @@ struct rnode *rnode_create (uint32_t rank, const char *ids);
  */
 struct rnode *rnode_create_count (uint32_t rank, int count);
 
+/*  Create a shape from a string representation of an idset, or with
+ *   `count` ids starting at 0.  The caller holds one reference.
+ */
+struct rnode_shape *rnode_shape_create (const char *ids);
+struct rnode_shape *rnode_shape_create_count (int count);
+
+void rnode_shape_decref (struct rnode_shape *shape);
+
+/*  Create a resource node with the ids of `shape`, taking a reference
+ *   on it.
+ */
+struct rnode *rnode_create_shape (uint32_t rank, struct rnode_shape *shape);
+
+/*  Create a copy of `n`, or a copy with all ids available, sharing the
+ *   shape of `n`, if any.
+ */
+struct rnode *rnode_copy (const struct rnode *n);
+struct rnode *rnode_copy_empty (const struct rnode *n);
+
+/*  Give `n` its own copies of ids and avail, so they may be modified
+ *   directly.  Returns 0 on success, -1 on failure with errno set.
+ */
+int rnode_unshare (struct rnode *n);
+
 /*  Destroy rnode object
  */
 void rnode_destroy (struct rnode *n);
@@ -73,4 +118,14 @@ size_t rnode_avail (const struct rnode *n);
  */
 size_t rnode_count (const struct rnode *n);
 
+/*  Return the ids available in resource node `n` as a ranged idset
+ *   string, e.g. "0-3".  The encoding is cached until the available ids
+ *   change.  Returns NULL on failure with errno set.
+ */
+const char *rnode_avail_str (struct rnode *n);
+
+/*  Invalidate the cached encoding after modifying n->avail directly.
+ */
+void rnode_avail_changed (struct rnode *n);
+
 #endif /* !HAVE_SCHED_RNODE_H */
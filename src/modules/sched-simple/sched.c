@@ -18,6 +18,7 @@
 
 #include "src/common/libutil/errno_safe.h"
 #include "src/common/libjob/job.h"
+#include "src/common/libjob/job_hash.h"
 #include "libjj.h"
 #include "rlist.h"
 
@@ -32,22 +33,39 @@ struct jobreq {
     int errnum;
 };
 
+/* Allocation of a running job, tracked for backfill.
+ */
+struct runjob {
+    flux_jobid_t id;
+    struct rlist *alloc;
+    double expiration;      /* 0. if unknown */
+};
+
 struct simple_sched {
     flux_t *h;
     flux_future_t *acquire_f; /* resource.acquire future */
 
     char *mode;             /* allocation mode */
     bool single;
+    int batch;              /* max jobs per batched alloc/free request */
+    int queue_depth;        /* jobs behind blocked head to try backfilling */
     bool sched_pus;         /* schedule PUs as cores */
     struct rlist *rlist;    /* list of resources */
     zlistx_t *queue;        /* job queue */
+    zhashx_t *running;      /* running jobs by id, if queue_depth > 0 */
     schedutil_t *util_ctx;
 
     flux_watcher_t *prep;
     flux_watcher_t *check;
     flux_watcher_t *idle;
+
+    struct flux_msglist *watchers; /* streaming resource-summary requests */
+    json_t *summary;        /* summary last sent to watchers */
+    flux_watcher_t *summary_timer;
 };
 
+static void summary_notify (struct simple_sched *ss);
+
 static void jobreq_destroy (struct jobreq *job)
 {
     if (job) {
@@ -75,6 +93,117 @@ static int jobreq_cmp (const void *x, const void *y)
     return rc;
 }
 
+static void runjob_destroy (struct runjob *rj)
+{
+    if (rj) {
+        int saved_errno = errno;
+        rlist_destroy (rj->alloc);
+        free (rj);
+        errno = saved_errno;
+    }
+}
+
+static void runjob_destructor (void **x)
+{
+    if (x) {
+        runjob_destroy (*x);
+        *x = NULL;
+    }
+}
+
+/*  Track allocation `alloc` of running job `id`, if backfill is enabled.
+ *  Takes ownership of `alloc`.
+ */
+static void runjob_add (struct simple_sched *ss,
+                        flux_jobid_t id,
+                        struct rlist *alloc,
+                        double expiration)
+{
+    struct runjob *rj;
+
+    if (!ss->running || !(rj = calloc (1, sizeof (*rj)))) {
+        rlist_destroy (alloc);
+        return;
+    }
+    rj->id = id;
+    rj->alloc = alloc;
+    rj->expiration = expiration;
+    zhashx_delete (ss->running, &id);
+    if (zhashx_insert (ss->running, &rj->id, rj) < 0)
+        runjob_destroy (rj);
+}
+
+static int runjob_cmp (const void *a, const void *b)
+{
+    const struct runjob *r1 = *(const struct runjob **)a;
+    const struct runjob *r2 = *(const struct runjob **)b;
+
+    return NUMCMP (r1->expiration, r2->expiration);
+}
+
+/*  Estimate the earliest time that a job with resource request `jj`
+ *   could start, by releasing running job allocations in order of
+ *   expiration from a copy of the current resource list.  If `extra`
+ *   is non-NULL, it is treated as an additional running job.
+ *  Returns the estimated start time, or -1. if the job cannot be
+ *   started before some job with unknown expiration completes.
+ */
+static double estimate_start (struct simple_sched *ss,
+                              struct jj_counts *jj,
+                              struct runjob *extra)
+{
+    struct runjob **rjv;
+    struct runjob *rj;
+    struct rlist *rl;
+    struct rlist *alloc;
+    double start = -1.;
+    int count = 0;
+    int i;
+
+    if (!(rjv = calloc (zhashx_size (ss->running) + 1, sizeof (*rjv))))
+        return -1.;
+    rj = zhashx_first (ss->running);
+    while (rj) {
+        if (rj->expiration > 0.)
+            rjv[count++] = rj;
+        rj = zhashx_next (ss->running);
+    }
+    if (extra && extra->expiration > 0.)
+        rjv[count++] = extra;
+    qsort (rjv, count, sizeof (*rjv), runjob_cmp);
+
+    if (!(rl = rlist_copy (ss->rlist)))
+        goto out;
+    for (i = 0; i < count; i++) {
+        if (rlist_free (rl, rjv[i]->alloc) < 0)
+            continue;
+        if ((alloc = rlist_alloc (rl, ss->mode,
+                                  jj->nnodes, jj->nslots, jj->slot_size))) {
+            rlist_destroy (alloc);
+            start = rjv[i]->expiration;
+            break;
+        }
+    }
+    rlist_destroy (rl);
+out:
+    free (rjv);
+    return start;
+}
+
+static double R_expiration (const char *R)
+{
+    json_t *o;
+    double expiration = 0.;
+
+    if ((o = json_loads (R, 0, NULL))) {
+        (void)json_unpack (o, "{s:{s:F}}",
+                           "execution",
+                             "expiration", &expiration);
+        json_decref (o);
+    }
+    return expiration;
+}
+
 static struct jobreq *
 jobreq_find (struct simple_sched *ss, flux_jobid_t id)
 {
@@ -92,6 +221,7 @@ static struct jobreq *
 jobreq_create (const flux_msg_t *msg, const char *jobspec)
 {
     struct jobreq *job = calloc (1, sizeof (*job));
+    json_t *counts = NULL;
 
     if (job == NULL)
         return NULL;
@@ -102,6 +232,13 @@ jobreq_create (const flux_msg_t *msg, const char *jobspec)
                                         &job->t_submit) < 0)
         goto err;
     job->msg = flux_msg_incref (msg);
+    /* Prefer the counts precomputed by job-ingest.  They are missing from
+     * requests sent by an older job-manager, and for jobs reloaded from
+     * the KVS, so parse the jobspec then.  Errors come from the parser.
+     */
+    (void)flux_request_unpack (msg, NULL, "{s?o}", "counts", &counts);
+    if (counts && libjj_get_counts_json (counts, &job->jj) == 0)
+        return job;
     if (libjj_get_counts (jobspec, &job->jj) < 0)
         job->errnum = errno;
     return job;
@@ -112,13 +249,25 @@ err:
 
 static void simple_sched_destroy (flux_t *h, struct simple_sched *ss)
 {
+    const flux_msg_t *msg;
     struct jobreq *job = zlistx_first (ss->queue);
     while (job) {
         flux_respond_error (h, job->msg, ENOSYS, "simple sched exiting");
         job = zlistx_next (ss->queue);
     }
+    if (ss->watchers) {
+        while ((msg = flux_msglist_pop (ss->watchers))) {
+            if (flux_respond_error (h, msg, ENODATA, NULL) < 0)
+                flux_log_error (h, "error ending resource-summary");
+            flux_msg_decref (msg);
+        }
+        flux_msglist_destroy (ss->watchers);
+    }
+    flux_watcher_destroy (ss->summary_timer);
+    json_decref (ss->summary);
     flux_future_destroy (ss->acquire_f);
     zlistx_destroy (&ss->queue);
+    zhashx_destroy (&ss->running);
     flux_watcher_destroy (ss->prep);
     flux_watcher_destroy (ss->check);
     flux_watcher_destroy (ss->idle);
@@ -136,6 +285,7 @@ static struct simple_sched * simple_sched_create (void)
 
     /* Single alloc request mode is default */
     ss->single = true;
+    ss->batch = 256;
     return ss;
 }
 
@@ -177,21 +327,21 @@ out:
     return (s);
 }
 
-static int try_alloc (flux_t *h, struct simple_sched *ss)
+/*  Respond to alloc request for `job` with allocation `alloc`, or deny
+ *   the request if `alloc` is NULL, then remove `job` from the queue.
+ *  Takes ownership of `alloc`.
+ */
+static int alloc_respond (flux_t *h,
+                          struct simple_sched *ss,
+                          struct jobreq *job,
+                          struct rlist *alloc)
 {
     int rc = -1;
     char *s = NULL;
-    struct rlist *alloc = NULL;
-    struct jj_counts *jj = NULL;
+    struct jj_counts *jj = &job->jj;
     char *R = NULL;
-    struct jobreq *job = zlistx_first (ss->queue);
     double now = flux_reactor_now (flux_get_reactor (h));
 
-    if (!job)
-        return -1;
-    jj = &job->jj;
-    alloc = rlist_alloc (ss->rlist, ss->mode,
-                         jj->nnodes, jj->nslots, jj->slot_size);
     if (!alloc || !(R = Rstring_create (alloc, now, jj->duration))) {
         const char *note = "unable to allocate provided jobspec";
         if (alloc != NULL) {
@@ -202,9 +352,7 @@ static int try_alloc (flux_t *h, struct simple_sched *ss)
                 flux_log_error (h, "try_alloc: rlist_free");
             rlist_destroy (alloc);
             alloc = NULL;
-        } else if (errno == ENOSPC)
-            return rc;
-        else if (errno == EOVERFLOW)
+        } else if (errno == EOVERFLOW)
             note = "unsatisfiable request";
         if (schedutil_alloc_respond_deny (ss->util_ctx,
                                           job->msg,
@@ -222,6 +370,12 @@ static int try_alloc (flux_t *h, struct simple_sched *ss)
         flux_log_error (h, "schedutil_alloc_respond_success_pack");
 
     flux_log (h, LOG_DEBUG, "alloc: %ju: %s", (uintmax_t) job->id, s);
+    runjob_add (ss,
+                job->id,
+                alloc,
+                jj->duration > 0. ? now + jj->duration : 0.);
+    alloc = NULL;
+    summary_notify (ss);
     rc = 0;
 
 out:
@@ -232,6 +386,70 @@ out:
     return rc;
 }
 
+static int try_alloc (flux_t *h, struct simple_sched *ss)
+{
+    struct jj_counts *jj = NULL;
+    struct rlist *alloc;
+    struct jobreq *job = zlistx_first (ss->queue);
+
+    if (!job)
+        return -1;
+    jj = &job->jj;
+    alloc = rlist_alloc (ss->rlist, ss->mode,
+                         jj->nnodes, jj->nslots, jj->slot_size);
+    if (!alloc && errno == ENOSPC)
+        return -1;
+    return alloc_respond (h, ss, job, alloc);
+}
+
+/*  The job at the head of the queue cannot be allocated resources.
+ *   Try to allocate resources to up to queue_depth jobs behind it, as
+ *   long as this does not delay the estimated start time of the head job.
+ *  Jobs that will complete before the head job can start, or that do not
+ *   use resources it needs, may be allocated.  If the start time of the
+ *   head job cannot be estimated, any job that fits is allocated.
+ */
+static void try_backfill (flux_t *h, struct simple_sched *ss)
+{
+    struct jobreq *head;
+    struct jobreq *job;
+    double now = flux_reactor_now (flux_get_reactor (h));
+    double start;
+    int count = 0;
+
+    if (ss->queue_depth == 0 || !(head = zlistx_first (ss->queue)))
+        return;
+    start = estimate_start (ss, &head->jj, NULL);
+
+    job = zlistx_next (ss->queue);
+    while (job && count++ < ss->queue_depth) {
+        struct jj_counts *jj = &job->jj;
+        struct runjob rj = {
+            .id = job->id,
+            .expiration = jj->duration > 0. ? now + jj->duration : 0.,
+        };
+
+        if ((rj.alloc = rlist_alloc (ss->rlist, ss->mode,
+                                     jj->nnodes, jj->nslots, jj->slot_size))) {
+            double new_start;
+
+            if (start < 0.
+                || (rj.expiration > 0. && rj.expiration <= start)
+                || ((new_start = estimate_start (ss, &head->jj, &rj)) >= 0.
+                    && new_start <= start)) {
+                flux_log (h, LOG_DEBUG, "backfill: %ju", (uintmax_t)job->id);
+                (void)alloc_respond (h, ss, job, rj.alloc);
+            }
+            else {
+                if (rlist_free (ss->rlist, rj.alloc) < 0)
+                    flux_log_error (h, "backfill: rlist_free");
+                rlist_destroy (rj.alloc);
+            }
+        }
+        job = zlistx_next (ss->queue);
+    }
+}
+
 static void prep_cb (flux_reactor_t *r, flux_watcher_t *w,
                      int revents, void *arg)
 {
@@ -255,6 +473,7 @@ static void check_cb (flux_reactor_t *r, flux_watcher_t *w,
      *  watcher, i.e. block. O/w, retry on next loop.
      */
     if (try_alloc (ss->h, ss) < 0 && errno == ENOSPC) {
+        try_backfill (ss->h, ss);
         flux_watcher_stop (ss->prep);
         flux_watcher_stop (ss->check);
     }
@@ -272,8 +491,10 @@ static int try_free (flux_t *h, struct simple_sched *ss, const char *R)
     r = rlist_dumps (alloc);
     if ((rc = rlist_free (ss->rlist, alloc)) < 0)
         flux_log_error (h, "free: %s", r);
-    else
+    else {
         flux_log (h, LOG_DEBUG, "free: %s", r);
+        summary_notify (ss);
+    }
     free (r);
     rlist_destroy (alloc);
     return rc;
@@ -282,7 +503,10 @@ static int try_free (flux_t *h, struct simple_sched *ss, const char *R)
 void free_cb (flux_t *h, const flux_msg_t *msg, const char *R, void *arg)
 {
     struct simple_sched *ss = arg;
+    flux_jobid_t id;
 
+    if (ss->running && schedutil_free_request_decode (msg, &id) == 0)
+        zhashx_delete (ss->running, &id);
     if (try_free (h, ss, R) < 0) {
         if (flux_respond_error (h, msg, errno, NULL) < 0)
             flux_log_error (h, "free_cb: flux_respond_error");
@@ -372,8 +596,11 @@ static int hello_cb (flux_t *h,
     s = rlist_dumps (alloc);
     if ((rc = rlist_set_allocated (ss->rlist, alloc)) < 0)
         flux_log_error (h, "hello: rlist_remove (%s)", s);
-    else
+    else {
         flux_log (h, LOG_DEBUG, "hello: alloc %s", s);
+        runjob_add (ss, id, alloc, R_expiration (R));
+        alloc = NULL;
+    }
     free (s);
     rlist_destroy (alloc);
     return 0;
@@ -438,6 +665,101 @@ err:
         flux_log_error (h, "flux_respond_error");
 }
 
+/*  Send the resource summary to streaming resource-summary requests
+ *   when it has changed.  Changes are coalesced by a zero timeout timer,
+ *   so that a burst of allocations results in one response.
+ */
+static void summary_timer_cb (flux_reactor_t *r, flux_watcher_t *w,
+                              int revents, void *arg)
+{
+    struct simple_sched *ss = arg;
+    const flux_msg_t *msg;
+    json_t *o;
+
+    if (!(o = rlist_summary (ss->rlist))) {
+        flux_log_error (ss->h, "failed to summarize resources");
+        return;
+    }
+    if (ss->summary && json_equal (o, ss->summary)) {
+        json_decref (o);
+        return;
+    }
+    json_decref (ss->summary);
+    ss->summary = o;
+    msg = flux_msglist_first (ss->watchers);
+    while (msg) {
+        if (flux_respond_pack (ss->h, msg, "O", o) < 0) {
+            flux_log_error (ss->h, "error responding to resource-summary");
+            (void)flux_msglist_remove (ss->watchers, (void *)msg);
+            flux_msg_decref (msg);
+        }
+        msg = flux_msglist_next (ss->watchers);
+    }
+}
+
+static void summary_notify (struct simple_sched *ss)
+{
+    if (flux_msglist_count (ss->watchers) > 0)
+        flux_watcher_start (ss->summary_timer);
+}
+
+/*  Respond with a summary of resources by state, computed here so that
+ *   clients need not expand the per-rank R of sched.resource-status.
+ *   If the request is streaming, also respond whenever it changes.
+ */
+static void summary_cb (flux_t *h, flux_msg_handler_t *mh,
+                        const flux_msg_t *msg, void *arg)
+{
+    struct simple_sched *ss = arg;
+    const char *errstr = NULL;
+    json_t *o = NULL;
+
+    if (flux_request_decode (msg, NULL, NULL) < 0)
+        goto error;
+    if (ss->rlist == NULL) {
+        errno = EAGAIN;
+        errstr = "sched-simple not initialized";
+        goto error;
+    }
+    if (!(o = rlist_summary (ss->rlist)))
+        goto error;
+    if (flux_msg_is_streaming (msg)) {
+        /*  With no other watchers, changes have not been tracked, so
+         *   start from the summary sent here.
+         */
+        if (flux_msglist_count (ss->watchers) == 0) {
+            json_decref (ss->summary);
+            ss->summary = json_incref (o);
+        }
+        if (flux_msglist_append (ss->watchers,
+                                 msg,
+                                 (void *)flux_msg_incref (msg)) < 0) {
+            flux_msg_decref (msg);
+            goto error;
+        }
+    }
+    if (flux_respond_pack (h, msg, "O", o) < 0)
+        flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
+    json_decref (o);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, errstr) < 0)
+        flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+    json_decref (o);
+}
+
+static void disconnect_cb (flux_t *h, flux_msg_handler_t *mh,
+                           const flux_msg_t *msg, void *arg)
+{
+    struct simple_sched *ss = arg;
+    const flux_msg_t *req;
+
+    while ((req = flux_msglist_pop_sender (ss->watchers,
+                                           msg,
+                                           FLUX_MATCHTAG_NONE)))
+        flux_msg_decref (req);
+}
+
 static int ss_resource_update (struct simple_sched *ss, flux_future_t *f)
 {
     const char *up = NULL;
@@ -462,6 +784,7 @@ static int ss_resource_update (struct simple_sched *ss, flux_future_t *f)
         flux_log_error (ss->h, "failed to update resource state");
         goto err;
     }
+    summary_notify (ss);
     rc = 0;
 err:
     flux_future_reset (f);
@@ -555,9 +878,10 @@ static int simple_sched_init (flux_t *h, struct simple_sched *ss)
         flux_log_error (h, "schedutil_hello");
         goto out;
     }
-    if (schedutil_ready (ss->util_ctx,
-                         ss->single ? "single": "unlimited",
-                         NULL) < 0) {
+    if (schedutil_ready_batch (ss->util_ctx,
+                               ss->single ? "single": "unlimited",
+                               ss->batch,
+                               NULL) < 0) {
         flux_log_error (h, "schedutil_ready");
         goto out;
     }
@@ -592,6 +916,27 @@ static int process_args (flux_t *h, struct simple_sched *ss,
         else if (strcmp ("unlimited", argv[i]) == 0) {
             ss->single = false;
         }
+        else if (strncmp ("batch=", argv[i], 6) == 0) {
+            char *endptr;
+            errno = 0;
+            ss->batch = strtol (argv[i]+6, &endptr, 10);
+            if (errno != 0 || *endptr != '\0' || ss->batch < 0) {
+                flux_log (h, LOG_ERR, "invalid batch value: %s", argv[i]+6);
+                errno = EINVAL;
+                return -1;
+            }
+        }
+        else if (strncmp ("queue-depth=", argv[i], 12) == 0) {
+            char *endptr;
+            errno = 0;
+            ss->queue_depth = strtol (argv[i]+12, &endptr, 10);
+            if (errno != 0 || *endptr != '\0' || ss->queue_depth < 0) {
+                flux_log (h, LOG_ERR, "invalid queue-depth value: %s",
+                          argv[i]+12);
+                errno = EINVAL;
+                return -1;
+            }
+        }
         else if (strcmp ("sched-PUs", argv[i]) == 0) {
             ss->sched_pus = true;
         }
@@ -605,6 +950,8 @@ static int process_args (flux_t *h, struct simple_sched *ss,
 
 static const struct flux_msg_handler_spec htab[] = {
     { FLUX_MSGTYPE_REQUEST, "*.resource-status", status_cb, FLUX_ROLE_USER },
+    { FLUX_MSGTYPE_REQUEST, "*.resource-summary", summary_cb, FLUX_ROLE_USER },
+    { FLUX_MSGTYPE_REQUEST, "*.disconnect", disconnect_cb, FLUX_ROLE_USER },
     FLUX_MSGHANDLER_TABLE_END,
 };
 
@@ -632,7 +979,14 @@ int mod_main (flux_t *h, int argc, char **argv)
     ss->prep = flux_prepare_watcher_create (r, prep_cb, ss);
     ss->check = flux_check_watcher_create (r, check_cb, ss);
     ss->idle = flux_idle_watcher_create (r, NULL, NULL);
-    if (!ss->prep || !ss->check || !ss->idle) {
+    ss->summary_timer = flux_timer_watcher_create (r,
+                                                   0.,
+                                                   0.,
+                                                   summary_timer_cb,
+                                                   ss);
+    ss->watchers = flux_msglist_create ();
+    if (!ss->prep || !ss->check || !ss->idle
+        || !ss->summary_timer || !ss->watchers) {
         errno = ENOMEM;
         goto done;
     }
@@ -643,6 +997,12 @@ int mod_main (flux_t *h, int argc, char **argv)
     zlistx_set_comparator (ss->queue, jobreq_cmp);
     zlistx_set_destructor (ss->queue, jobreq_destructor);
 
+    if (ss->queue_depth > 0) {
+        if (!(ss->running = job_hash_create ()))
+            goto done;
+        zhashx_set_destructor (ss->running, runjob_destructor);
+    }
+
     /* Let `flux module load simple-sched` return before synchronous
      * initialization with resource and job-manager modules.
      */
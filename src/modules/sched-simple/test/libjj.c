@@ -0,0 +1,208 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#include <errno.h>
+#include <string.h>
+#include <jansson.h>
+
+#include "src/common/libtap/tap.h"
+#include "libjj.h"
+
+struct counts_test {
+    const char *spec;
+    int nnodes;
+    int nslots;
+    int slot_size;
+    double duration;
+};
+
+/* Jobspecs that the in-place scanner should handle, and some that it
+ * leaves to jansson, which must give the same counts.
+ */
+static struct counts_test valid[] = {
+    { "{\"version\":1,"
+       "\"resources\":[{\"type\":\"slot\",\"count\":1,"
+         "\"with\":[{\"type\":\"core\",\"count\":1}]}],"
+       "\"tasks\":[{\"command\":[\"hostname\"],\"slot\":\"task\","
+         "\"count\":{\"per_slot\":1}}],"
+       "\"attributes\":{\"system\":{\"cwd\":\"/tmp\"}}}",
+      0, 1, 1, 0. },
+    { " {\n \"attributes\" : {\"system\" : {\"duration\" : 60}} ,\n"
+       " \"resources\" : [ {\"with\" : [ {\"count\":4,"
+         "\"with\":[{\"type\":\"core\",\"count\":2}],\"type\":\"slot\"} ],"
+         "\"type\":\"node\",\"count\":3} ],\n"
+       " \"version\" : 1 }\n",
+      3, 12, 2, 60. },
+    { "{\"version\":1,"
+       "\"resources\":[{\"type\":\"slot\",\"count\":2,"
+         "\"with\":[{\"type\":\"core\",\"count\":4}]}],"
+       "\"attributes\":{\"system\":{\"duration\":1.5e1,"
+         "\"environment\":{\"A\":\"x\\\"y\\u00e9\",\"B\":[1,-2.5,true,"
+           "false,null,{}]}}}}",
+      0, 2, 4, 15. },
+    /* escaped key and duplicate key are left to jansson */
+    { "{\"version\":1,"
+       "\"resources\":[{\"type\":\"slot\",\"count\":2,"
+         "\"with\":[{\"type\":\"core\",\"count\":1}]}],"
+       "\"attributes\":{\"system\":{\"dur\\u0061tion\":5.0}}}",
+      0, 2, 1, 5. },
+    { "{\"version\":1,"
+       "\"resources\":[{\"type\":\"slot\",\"count\":2,"
+         "\"with\":[{\"type\":\"core\",\"count\":1}]}],"
+       "\"attributes\":{\"system\":{\"duration\":5.0,\"duration\":6}}}",
+      0, 2, 1, 6. },
+    { NULL, 0, 0, 0, 0. },
+};
+
+/* Invalid jobspecs, which the scanner leaves to jansson for the error.
+ */
+static struct counts_test invalid[] = {
+    { "{\"version\":2,"
+       "\"resources\":[{\"type\":\"slot\",\"count\":1,"
+         "\"with\":[{\"type\":\"core\",\"count\":1}]}],"
+       "\"attributes\":{}}",
+      0, 0, 0, 0. },
+    { "{\"version\":1,"
+       "\"resources\":[{\"type\":\"slot\",\"count\":1,"
+         "\"with\":[{\"type\":\"core\",\"count\":-1}]}],"
+       "\"attributes\":{}}",
+      0, 0, 0, 0. },
+    { "{\"version\":1,"
+       "\"resources\":[{\"type\":\"slot\",\"count\":1,"
+         "\"with\":[{\"type\":\"gpu\",\"count\":1}]}],"
+       "\"attributes\":{}}",
+      0, 0, 0, 0. },
+    { "{\"version\":1,"
+       "\"resources\":[{\"type\":\"slot\",\"count\":1}],"
+       "\"attributes\":{}}",
+      0, 0, 0, 0. },
+    { "{\"version\":1,"
+       "\"resources\":[{\"type\":\"slot\",\"count\":1,"
+         "\"with\":[{\"type\":\"core\",\"count\":1}]}]}",
+      0, 0, 0, 0. },
+    { "{\"version\":1,"
+       "\"resources\":[{\"type\":\"slot\",\"count\":1,"
+         "\"with\":[{\"type\":\"core\",\"count\":1}]}],"
+       "\"attributes\":{}} trailing",
+      0, 0, 0, 0. },
+    { "{\"version\":1,"
+       "\"resources\":[{\"type\":\"slot\",\"count\":1,"
+         "\"with\":[{\"type\":\"core\",\"count\":1}]}],"
+       "\"attributes\":{\"x\":1e999}}",
+      0, 0, 0, 0. },
+    { "{\"version\":1,"
+       "\"resources\":[{\"type\":\"slot\",\"count\":1,"
+         "\"with\":[{\"type\":\"core\",\"count\":1}]}],"
+       "\"attributes\":{\"x\":\"\\ud800\"}}",
+      0, 0, 0, 0. },
+    { NULL, 0, 0, 0, 0. },
+};
+
+static void test_counts (void)
+{
+    struct jj_counts jj;
+    int i;
+
+    for (i = 0; valid[i].spec != NULL; i++) {
+        ok (libjj_get_counts (valid[i].spec, &jj) == 0
+            && jj.nnodes == valid[i].nnodes
+            && jj.nslots == valid[i].nslots
+            && jj.slot_size == valid[i].slot_size
+            && jj.duration == valid[i].duration,
+            "libjj_get_counts valid[%d] works: "
+            "nnodes=%d nslots=%d slot_size=%d duration=%.1f",
+            i, jj.nnodes, jj.nslots, jj.slot_size, jj.duration);
+    }
+    for (i = 0; invalid[i].spec != NULL; i++) {
+        errno = 0;
+        ok (libjj_get_counts (invalid[i].spec, &jj) < 0
+            && errno == EINVAL
+            && strlen (jj.error) > 0,
+            "libjj_get_counts invalid[%d] fails: %s", i, jj.error);
+    }
+    ok (libjj_get_counts (invalid[1].spec, &jj) < 0
+        && !strcmp (jj.error, "Invalid count -1 for type 'core'"),
+        "libjj_get_counts reports the parser's error");
+    errno = 0;
+    ok (libjj_get_counts (invalid[0].spec, NULL) < 0 && errno == EINVAL,
+        "libjj_get_counts counts=NULL fails with EINVAL");
+}
+
+static void test_counts_json (void)
+{
+    struct jj_counts jj;
+    json_t *o;
+
+    if (!(o = json_pack ("{s:i s:i s:i s:f}",
+                         "nnodes", 2,
+                         "nslots", 8,
+                         "slot_size", 4,
+                         "duration", 30.)))
+        BAIL_OUT ("json_pack failed");
+    ok (libjj_get_counts_json (o, &jj) == 0
+        && jj.nnodes == 2
+        && jj.nslots == 8
+        && jj.slot_size == 4
+        && jj.duration == 30.,
+        "libjj_get_counts_json works");
+    json_decref (o);
+
+    if (!(o = json_pack ("{s:i s:i s:i s:i}",
+                         "nnodes", 0,
+                         "nslots", 1,
+                         "slot_size", 1,
+                         "duration", 0)))
+        BAIL_OUT ("json_pack failed");
+    ok (libjj_get_counts_json (o, &jj) == 0
+        && jj.nnodes == 0
+        && jj.duration == 0.,
+        "libjj_get_counts_json accepts integer duration and nnodes=0");
+    json_decref (o);
+
+    if (!(o = json_pack ("{s:i s:i s:i}",
+                         "nnodes", 0,
+                         "nslots", 1,
+                         "slot_size", 1)))
+        BAIL_OUT ("json_pack failed");
+    errno = 0;
+    ok (libjj_get_counts_json (o, &jj) < 0 && errno == EINVAL,
+        "libjj_get_counts_json fails with EINVAL on missing duration: %s",
+        jj.error);
+    json_decref (o);
+
+    if (!(o = json_pack ("{s:i s:i s:i s:f}",
+                         "nnodes", 0,
+                         "nslots", 1,
+                         "slot_size", 0,
+                         "duration", 0.)))
+        BAIL_OUT ("json_pack failed");
+    errno = 0;
+    ok (libjj_get_counts_json (o, &jj) < 0 && errno == EINVAL,
+        "libjj_get_counts_json fails with EINVAL on slot_size=0: %s",
+        jj.error);
+    json_decref (o);
+
+    errno = 0;
+    ok (libjj_get_counts_json (NULL, &jj) < 0 && errno == EINVAL,
+        "libjj_get_counts_json o=NULL fails with EINVAL");
+}
+
+int main (int ac, char *av[])
+{
+    plan (NO_PLAN);
+
+    test_counts ();
+    test_counts_json ();
+
+    done_testing ();
+}
+
+/* vi: ts=4 sw=4 expandtab
+ */
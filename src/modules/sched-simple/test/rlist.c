@@ -10,6 +10,7 @@
 
 #include <unistd.h>
 #include <errno.h>
+#include <string.h>
 #include <jansson.h>
 
 #include "src/common/libtap/tap.h"
@@ -720,6 +721,132 @@ static void test_updown ()
     rlist_destroy (rl2);
 }
 
+static void check_alloc (struct rlist *rl, const char *mode,
+                         int nslots, int slot_size,
+                         const char *expected, struct rlist **allocp)
+{
+    char *s = NULL;
+    struct rlist *alloc = rlist_alloc (rl, mode, 0, nslots, slot_size);
+    if (alloc)
+        s = rlist_dumps (alloc);
+    is (s, expected,
+        "%s: %d slots of %d cores: %s", mode, nslots, slot_size, s);
+    free (s);
+    if (allocp)
+        *allocp = alloc;
+    else
+        rlist_destroy (alloc);
+}
+
+static void test_fit_index ()
+{
+    struct rlist *rl = NULL;
+    struct rlist *a = NULL;
+    struct rlist *b = NULL;
+    char *R = R_create (4, 4);
+    if (!(rl = rlist_from_R (R)))
+        BAIL_OUT ("rlist_from_R failed");
+    free (R);
+
+    ok (rlist_mark_down (rl, "0") == 0,
+        "fit: rlist_mark_down 0 works");
+    check_alloc (rl, "first-fit", 1, 1, "rank1/core0", &a);
+    check_alloc (rl, "best-fit", 1, 2, "rank1/core[1-2]", &b);
+    check_alloc (rl, "worst-fit", 1, 4, "rank2/core[0-3]", NULL);
+    check_alloc (rl, "best-fit", 1, 1, "rank1/core3", NULL);
+
+    ok (rlist_free (rl, a) == 0 && rlist_free (rl, b) == 0,
+        "fit: rlist_free works");
+    rlist_destroy (a);
+    rlist_destroy (b);
+    check_alloc (rl, "best-fit", 1, 3, "rank1/core[0-2]", NULL);
+    check_alloc (rl, "worst-fit", 1, 4, "rank3/core[0-3]", NULL);
+
+    ok (rlist_mark_up (rl, "0") == 0,
+        "fit: rlist_mark_up 0 works");
+    if (!(a = rlist_copy (rl)))
+        BAIL_OUT ("rlist_copy failed");
+    ok (a->avail == rl->avail && a->total == rl->total,
+        "fit: rlist_copy preserves avail and total");
+    check_alloc (a, "worst-fit", 1, 4, "rank0/core[0-3]", NULL);
+    ok (a->avail == 0 && rl->avail == 4,
+        "fit: allocation from copy does not affect original");
+    rlist_destroy (a);
+    check_alloc (rl, "first-fit", 2, 2, "rank0/core[0-3]", NULL);
+    ok (rlist_alloc (rl, "first-fit", 0, 1, 1) == NULL && errno == ENOSPC,
+        "fit: allocation fails with ENOSPC when all cores are allocated");
+
+    rlist_destroy (rl);
+}
+
+static bool check_summary (json_t *o,
+                           const char *state,
+                           int nnodes,
+                           int ncores,
+                           const char *ranks)
+{
+    int xnnodes, xncores, xngpus;
+    const char *xranks;
+
+    if (json_unpack (o, "{s:{s:i s:i s:i s:s}}",
+                     state,
+                       "nnodes", &xnnodes,
+                       "ncores", &xncores,
+                       "ngpus", &xngpus,
+                       "ranks", &xranks) < 0) {
+        diag ("summary: %s: missing or malformed entry", state);
+        return false;
+    }
+    diag ("summary: %s: nnodes=%d ncores=%d ranks=%s",
+          state, xnnodes, xncores, xranks);
+    return xnnodes == nnodes
+        && xncores == ncores
+        && xngpus == 0
+        && !strcmp (xranks, ranks);
+}
+
+static void test_summary ()
+{
+    struct rlist *rl = NULL;
+    struct rlist *alloc = NULL;
+    json_t *o;
+    char *R = R_create (4, 4);
+    if (!(rl = rlist_from_R (R)))
+        BAIL_OUT ("rlist_from_R failed");
+    free (R);
+
+    ok ((o = rlist_summary (rl)) != NULL
+        && check_summary (o, "all", 4, 16, "[0-3]")
+        && check_summary (o, "up", 4, 16, "[0-3]")
+        && check_summary (o, "down", 0, 0, "")
+        && check_summary (o, "allocated", 0, 0, "")
+        && check_summary (o, "free", 4, 16, "[0-3]"),
+        "rlist_summary of idle resources works");
+    json_decref (o);
+
+    if (rlist_mark_down (rl, "3") < 0)
+        BAIL_OUT ("rlist_mark_down failed");
+    if (!(alloc = rlist_alloc (rl, "first-fit", 0, 6, 1)))
+        BAIL_OUT ("rlist_alloc failed");
+    if (rlist_mark_down (rl, "1") < 0)
+        BAIL_OUT ("rlist_mark_down failed");
+    ok ((o = rlist_summary (rl)) != NULL
+        && check_summary (o, "all", 4, 16, "[0-3]")
+        && check_summary (o, "up", 2, 8, "[0,2]")
+        && check_summary (o, "down", 2, 8, "[1,3]")
+        && check_summary (o, "allocated", 2, 6, "[0-1]")
+        && check_summary (o, "free", 1, 4, "2"),
+        "rlist_summary with allocated and down resources works");
+    json_decref (o);
+
+    errno = 0;
+    ok (rlist_summary (NULL) == NULL && errno == EINVAL,
+        "rlist_summary rl=NULL fails with EINVAL");
+
+    rlist_destroy (alloc);
+    rlist_destroy (rl);
+}
+
 int main (int ac, char *av[])
 {
     plan (NO_PLAN);
@@ -733,6 +860,8 @@ int main (int ac, char *av[])
     test_issue2473 ();
     test_by_rank_coreids ();
     test_updown ();
+    test_fit_index ();
+    test_summary ();
 
     done_testing ();
 }
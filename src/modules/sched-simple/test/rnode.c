@@ -43,9 +43,79 @@ static void rnode_avail_check (struct rnode *n, const char *expected)
         BAIL_OUT ("failed to encode n->avail");
     is (avail, expected,
         "rnode->avail is expected: %s", avail);
+    is (rnode_avail_str (n), expected,
+        "rnode_avail_str is expected: %s", rnode_avail_str (n));
     free (avail);
 }
 
+static void test_shape (void)
+{
+    struct rnode_shape *shape;
+    struct rnode *n1, *n2, *copy;
+    struct idset *ids = NULL;
+
+    if (!(shape = rnode_shape_create ("0-3")))
+        BAIL_OUT ("rnode_shape_create failed");
+    if (!(n1 = rnode_create_shape (1, shape))
+        || !(n2 = rnode_create_shape (2, shape)))
+        BAIL_OUT ("rnode_create_shape failed");
+    rnode_shape_decref (shape);
+    ok (n1->ids == n2->ids && n1->avail == n1->ids,
+        "rnodes of one shape share ids and avail");
+    rnode_avail_check (n1, "0-3");
+    ok (rnode_count (n1) == 4 && rnode_avail (n2) == 4,
+        "rnode_count and rnode_avail work on shaped rnodes");
+
+    rnode_alloc_and_check (n1, 2, "0-1");
+    ok (n1->avail != n1->ids,
+        "rnode_alloc gives the rnode its own avail");
+    rnode_avail_check (n1, "2-3");
+    rnode_avail_check (n2, "0-3");
+
+    if (!(copy = rnode_copy (n1)))
+        BAIL_OUT ("rnode_copy failed");
+    ok (copy->ids == n1->ids && copy->avail != n1->avail,
+        "rnode_copy shares ids and copies avail");
+    rnode_avail_check (copy, "2-3");
+    rnode_destroy (copy);
+
+    ok (rnode_free (n1, "0-1") == 0,
+        "rnode_free (0-1) works");
+    ok (n1->avail == n1->ids,
+        "rnode shares avail again once all ids are free");
+    rnode_avail_check (n1, "0-3");
+
+    ids = idset_decode ("3");
+    ok (rnode_alloc_idset (n2, ids) == 0,
+        "rnode_alloc_idset (3) works on shaped rnode");
+    rnode_avail_check (n2, "0-2");
+    rnode_avail_check (n1, "0-3");
+    idset_destroy (ids);
+
+    ok (rnode_unshare (n2) == 0 && n2->ids != n1->ids,
+        "rnode_unshare gives the rnode its own ids");
+    rnode_avail_check (n2, "0-2");
+    ok (rnode_count (n2) == 4,
+        "rnode_count is unchanged after rnode_unshare");
+
+    rnode_destroy (n1);
+    rnode_destroy (n2);
+
+    if (!(shape = rnode_shape_create_count (8)))
+        BAIL_OUT ("rnode_shape_create_count failed");
+    if (!(n1 = rnode_create_shape (5, shape)))
+        BAIL_OUT ("rnode_create_shape failed");
+    rnode_shape_decref (shape);
+    if (!(copy = rnode_copy_empty (n1)))
+        BAIL_OUT ("rnode_copy_empty failed");
+    ok (copy->rank == 5 && copy->ids == n1->ids,
+        "rnode_copy_empty shares the shape");
+    rnode_avail_check (copy, "0-7");
+    rnode_destroy (n1);
+    rnode_avail_check (copy, "0-7");
+    rnode_destroy (copy);
+}
+
 int main (int ac, char *av[])
 {
     struct idset *ids = NULL;
@@ -152,6 +222,9 @@ int main (int ac, char *av[])
 
     idset_destroy (alloc);
     rnode_destroy (n);
+
+    test_shape ();
+
     done_testing ();
 }
 
@@ -14,6 +14,11 @@
 #include "config.h"
 #endif
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 #include <hwloc.h>
 #include <flux/core.h>
 #include <flux/shell.h>
@@ -154,14 +159,91 @@ static void shell_affinity_destroy (void *arg)
     free (sa);
 }
 
+/*  Return the path of the topology cache shared by job shells running
+ *   under the local broker, or NULL if the cache should not be used.
+ *   The cache lives in broker.rundir, and is only used if rundir is
+ *   owned by the shell user (the instance owner), so that a guest's
+ *   shell neither trusts nor writes a file other users can replace.
+ */
+static char *topology_cache_path (flux_shell_t *shell)
+{
+    flux_t *h = flux_shell_get_flux (shell);
+    const char *rundir;
+    struct stat sb;
+    char *path;
+
+    if (!h || !(rundir = flux_attr_get (h, "broker.rundir")))
+        return NULL;
+    if (stat (rundir, &sb) < 0 || sb.st_uid != getuid ())
+        return NULL;
+    if (asprintf (&path, "%s/shell-topology.xml", rundir) < 0)
+        return NULL;
+    return path;
+}
+
+/*  Load topology from XML cache 'path', previously exported from full
+ *   discovery on this system.
+ */
+static int topology_load_cached (hwloc_topology_t *tp, const char *path)
+{
+    if (access (path, R_OK) < 0)
+        return -1;
+    if (hwloc_topology_init (tp) < 0)
+        return -1;
+    if (hwloc_topology_set_xml (*tp, path) < 0
+        || hwloc_topology_set_flags (*tp, HWLOC_TOPOLOGY_FLAG_IS_THISSYSTEM) < 0
+        || hwloc_topology_load (*tp) < 0) {
+        hwloc_topology_destroy (*tp);
+        *tp = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+/*  Export discovered topology to XML cache 'path'.  Write a temporary
+ *   file and rename it, so concurrent shells never read a partial file.
+ */
+static void topology_save_cached (hwloc_topology_t topo, const char *path)
+{
+    char *tmp;
+
+    if (asprintf (&tmp, "%s.%d", path, (int)getpid ()) < 0)
+        return;
+#if HWLOC_API_VERSION >= 0x20000
+    if (hwloc_topology_export_xml (topo, tmp, 0) < 0
+#else
+    if (hwloc_topology_export_xml (topo, tmp) < 0
+#endif
+        || rename (tmp, path) < 0) {
+        shell_debug ("failed to write topology cache %s", path);
+        (void)unlink (tmp);
+    }
+    free (tmp);
+}
+
 /*  Initialize topology object for affinity processing.
+ *  Full topology discovery is slow on many-core nodes, so the first shell
+ *   under a broker caches the discovered (unrestricted) topology as XML,
+ *   and later shells load that instead.
  */
-static int shell_affinity_topology_init (struct shell_affinity *sa)
+static int shell_affinity_topology_init (struct shell_affinity *sa,
+                                         flux_shell_t *shell)
 {
-    if (hwloc_topology_init (&sa->topo) < 0)
-        return shell_log_errno ("hwloc_topology_init");
-    if (hwloc_topology_load (sa->topo) < 0)
-        return shell_log_errno ("hwloc_topology_load");
+    char *cache = topology_cache_path (shell);
+
+    if (!cache || topology_load_cached (&sa->topo, cache) < 0) {
+        if (hwloc_topology_init (&sa->topo) < 0) {
+            free (cache);
+            return shell_log_errno ("hwloc_topology_init");
+        }
+        if (hwloc_topology_load (sa->topo) < 0) {
+            free (cache);
+            return shell_log_errno ("hwloc_topology_load");
+        }
+        if (cache)
+            topology_save_cached (sa->topo, cache);
+    }
+    free (cache);
     if (topology_restrict_current (sa->topo) < 0)
         return shell_log_errno ("topology_restrict_current");
     return 0;
@@ -176,7 +258,7 @@ static struct shell_affinity * shell_affinity_create (flux_shell_t *shell)
     struct shell_affinity *sa = calloc (1, sizeof (*sa));
     if (!sa)
         return NULL;
-    if (shell_affinity_topology_init (sa) < 0)
+    if (shell_affinity_topology_init (sa, shell) < 0)
         goto err;
     if (flux_shell_rank_info_unpack (shell,
                                      -1,
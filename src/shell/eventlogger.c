@@ -103,22 +103,28 @@ static void commit_cb (flux_future_t *f, void *arg)
     flux_future_destroy (f);
 }
 
-static void
-timer_cb (flux_reactor_t *r, flux_watcher_t *w, int revents, void *arg)
+static int eventlog_batch_commit (struct eventlog_batch *batch)
 {
-    struct eventlog_batch *batch = arg;
     struct eventlogger *ev = batch->ev;
-    flux_t *h = ev->h;
     double timeout = ev->commit_timeout;
     flux_future_t *f = NULL;
     int flags = FLUX_KVS_TXN_COMPACT;
 
-    if (!(f = flux_kvs_commit (h, NULL, flags, batch->txn))
+    flux_watcher_stop (batch->timer);
+    if (!(f = flux_kvs_commit (ev->h, NULL, flags, batch->txn))
         || flux_future_then (f, timeout, commit_cb, batch) < 0) {
         eventlog_batch_error (batch, errno);
-        return;
+        flux_future_destroy (f);
+        return -1;
     }
-    batch->ev->current = NULL;
+    ev->current = NULL;
+    return 0;
+}
+
+static void
+timer_cb (flux_reactor_t *r, flux_watcher_t *w, int revents, void *arg)
+{
+    (void) eventlog_batch_commit (arg);
 }
 
 static struct eventlog_batch * eventlog_batch_create (struct eventlogger *ev)
@@ -263,6 +269,17 @@ out:
     return rc;
 }
 
+int eventlogger_commit (struct eventlogger *ev)
+{
+    if (!ev) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!ev->current)
+        return 0;
+    return eventlog_batch_commit (ev->current);
+}
+
 int eventlogger_flush (struct eventlogger *ev)
 {
     int rc = -1;
@@ -60,6 +60,11 @@ int eventlogger_append_entry (struct eventlogger *ev,
 
 int eventlogger_set_commit_timeout (struct eventlogger *ev, double timeout);
 
+/*  Start an asynchronous commit of the current batch now, without
+ *   waiting for the batch timeout.  No-op if there is no current batch.
+ */
+int eventlogger_commit (struct eventlogger *ev);
+
 int eventlogger_flush (struct eventlogger *ev);
 
 #ifdef __cplusplus
@@ -16,6 +16,9 @@
 #include "config.h"
 #endif
 
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
 #include <czmq.h>
 #include <jansson.h>
 
@@ -50,6 +53,28 @@ static void shell_eventlogger_unref (struct eventlogger *ev, void *arg)
     flux_shell_remove_completion_ref (shev->shell, "shell_eventlogger");
 }
 
+static void shell_eventlogger_error (struct eventlogger *ev,
+                                     int errnum,
+                                     json_t *entry)
+{
+    const char *name = NULL;
+    const char *msg = NULL;
+
+    if (json_unpack (entry, "{s:s s?{s?s}}",
+                            "name", &name,
+                            "context",
+                              "message", &msg) < 0) {
+        fprintf (stderr, "shell_eventlogger_error: failed to unpack entry\n");
+        return;
+    }
+    if (msg)
+        fprintf (stderr, "flux-shell: eventlog failure: %s: %s: msg=%s\n",
+                         strerror (errnum), name, msg);
+    else
+        fprintf (stderr, "flux-shell: eventlog failure: %s: %s\n",
+                         strerror (errnum), name);
+}
+
 void shell_eventlogger_destroy (struct shell_eventlogger *shev)
 {
     if (shev) {
@@ -64,10 +89,14 @@ struct shell_eventlogger *shell_eventlogger_create (flux_shell_t *shell)
     flux_t *h;
     struct eventlogger_ops ops = {
         .busy = shell_eventlogger_ref,
-        .idle = shell_eventlogger_unref
+        .idle = shell_eventlogger_unref,
+        .err = shell_eventlogger_error,
     };
     struct shell_eventlogger *shev = calloc (1, sizeof (*shev));
 
+    if (!shev)
+        return NULL;
+    shev->shell = shell;
     if (!(h = flux_shell_get_flux (shell))
         || !(shev->ev = eventlogger_create (h, 0.01, &ops, shev))
         || !(shev->contexts = zhashx_new ())) {
@@ -78,6 +107,15 @@ struct shell_eventlogger *shell_eventlogger_create (flux_shell_t *shell)
     return shev;
 }
 
+struct eventlogger *shell_eventlogger_get (struct shell_eventlogger *shev)
+{
+    if (!shev) {
+        errno = EINVAL;
+        return NULL;
+    }
+    return shev->ev;
+}
+
 int shell_eventlogger_emit_event (struct shell_eventlogger *shev,
                                   int flags,
                                   const char *event)
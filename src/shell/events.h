@@ -12,10 +12,19 @@
 #define _SHELL_EVENTS_H
 
 struct shell_eventlogger;
+struct eventlogger;
 
 void shell_eventlogger_destroy (struct shell_eventlogger *shev);
 struct shell_eventlogger *shell_eventlogger_create (flux_shell_t *shell);
 
+/*  Return the eventlogger shared by all shell components on this shell.
+ *  Appends from shell events, log messages, and KVS output are batched
+ *   into a single KVS transaction per batch window. A synchronous append
+ *   (EVENTLOGGER_FLAG_WAIT) or eventlogger_flush() commits everything
+ *   pending, so shell.init and shell.start act as durable flush points.
+ */
+struct eventlogger *shell_eventlogger_get (struct shell_eventlogger *shev);
+
 int shell_eventlogger_emit_event (struct shell_eventlogger *shev,
                                   int flags,
                                   const char *event);
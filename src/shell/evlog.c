@@ -78,52 +78,22 @@ static int log_eventlog (flux_plugin_t *p,
 
 static void evlog_destroy (struct evlog *evlog)
 {
-    eventlogger_destroy (evlog->ev);
     free (evlog);
 }
 
-static void evlog_ref (struct eventlogger *ev, void *arg)
-{
-    struct evlog *evlog = arg;
-    flux_shell_add_completion_ref (evlog->shell, "eventlogger.txn");
-}
-
-static void evlog_unref (struct eventlogger *ev, void *arg)
-{
-    struct evlog *evlog = arg;
-    flux_shell_remove_completion_ref (evlog->shell, "eventlogger.txn");
-}
-
-static void evlog_error (struct eventlogger *ev, int errnum, json_t *entry)
-{
-    const char *msg;
-    if (json_unpack (entry, "{s:{s:s}}",
-                            "context",
-                            "message", &msg) < 0) {
-        fprintf (stderr, "evlog_error: failed to unpack message\n");
-        return;
-    }
-    fprintf (stderr, "flux-shell: evlog failure: %s: msg=%s\n",
-                     strerror (errnum), msg);
-}
-
+/*  Log messages share the shell's eventlogger, so they are committed
+ *   in the same KVS transaction as shell events and output.
+ */
 static struct evlog *evlog_create (flux_shell_t *shell)
 {
-    flux_t *h = flux_shell_get_flux (shell);
-    struct eventlogger_ops ops = {
-        .busy = evlog_ref,
-        .idle = evlog_unref,
-        .err =  evlog_error
-    };
     struct evlog *evlog = calloc (1, sizeof (*evlog));
 
-    if (h == NULL) {
-        fprintf (stderr, "evlog_create failure due to no handle\n");
+    if (!evlog)
         return NULL;
-    }
-    if (!evlog || !(evlog->ev = eventlogger_create (h, 0.01, &ops, evlog)))
+    if (!(evlog->ev = shell_eventlogger_get (shell->ev))) {
+        fprintf (stderr, "evlog_create failure due to no eventlogger\n");
         goto err;
-    eventlogger_set_commit_timeout (evlog->ev, 5.);
+    }
     evlog->level = FLUX_SHELL_NOTICE + shell->verbose;
     evlog->shell = shell;
     return evlog;
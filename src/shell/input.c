@@ -13,6 +13,11 @@
  * Depending on inputs from user, a service is started to receive
  * stdin from front-end command or file is read for redirected
  * standard input.
+ *
+ * The leader shell appends stdin once to the guest.input eventlog.
+ * Each shell then watches that eventlog with a single stream, started
+ * at shell.start once all local tasks are running, and writes each
+ * data event to the local tasks it is addressed to.
  */
 
 #if HAVE_CONFIG_H
@@ -44,16 +49,19 @@ enum {
     FLUX_TASK_INPUT_KVS = 1,
 };
 
-struct shell_task_input_kvs {
-    flux_future_t *input_f;
-    bool input_header_parsed;
-};
-
 struct shell_task_input {
     struct shell_input *in;
     struct shell_task *task;
     int type;
-    struct shell_task_input_kvs input_kvs;
+    bool closed;
+};
+
+/* One guest.input watch per shell, shared by all local tasks */
+struct shell_input_kvs {
+    flux_future_t *input_f;
+    bool input_header_parsed;
+    bool canceled;
+    int nopen;              /* local tasks still reading input */
 };
 
 struct shell_input_type_file {
@@ -68,20 +76,16 @@ struct shell_input {
     int stdin_type;
     struct shell_task_input *task_inputs;
     int ntasks;
+    struct shell_input_kvs input_kvs;
     struct shell_input_type_file stdin_file;
 };
 
-static void shell_task_input_kvs_cleanup (struct shell_task_input_kvs *kp)
+static void shell_input_kvs_cleanup (struct shell_input_kvs *kp)
 {
     flux_future_destroy (kp->input_f);
     kp->input_f = NULL;
 }
 
-static void shell_task_input_cleanup (struct shell_task_input *tp)
-{
-    shell_task_input_kvs_cleanup (&(tp->input_kvs));
-}
-
 static void shell_input_type_file_cleanup (struct shell_input_type_file *fp)
 {
     close (fp->fd);
@@ -93,10 +97,8 @@ void shell_input_destroy (struct shell_input *in)
 {
     if (in) {
         int saved_errno = errno;
-        int i;
         shell_input_type_file_cleanup (&(in->stdin_file));
-        for (i = 0; i < in->ntasks; i++)
-            shell_task_input_cleanup (&(in->task_inputs[i]));
+        shell_input_kvs_cleanup (&(in->input_kvs));
         free (in->task_inputs);
         free (in);
         errno = saved_errno;
@@ -418,43 +420,52 @@ error:
     return NULL;
 }
 
-static int shell_input_init (flux_plugin_t *p,
-                             const char *topic,
-                             flux_plugin_arg_t *args,
-                             void *data)
+/*  Stop the input watch once no local task is reading input.
+ */
+static void shell_input_kvs_cancel (struct shell_input_kvs *kp)
 {
-    flux_shell_t *shell = flux_plugin_get_shell (p);
-    struct shell_input *in = shell_input_create (shell);
-    if (!in)
-        return -1;
-    if (flux_plugin_aux_set (p, "builtin.input", in,
-                            (flux_free_f) shell_input_destroy) < 0) {
-        shell_input_destroy (in);
-        return -1;
+    if (kp->input_f && !kp->canceled) {
+        if (flux_job_event_watch_cancel (kp->input_f) < 0)
+            shell_log_errno ("flux_job_event_watch_cancel");
+        kp->canceled = true;
     }
-    return 0;
 }
 
-/*  Return 1 if idset string 'set' contains the integer id.
- *  O/w, return 0, or -1 on failure to decode 'set'.
+/*  Write one data event to a local task, closing its stdin on eof.
  */
-static int idset_string_contains (const char *set, uint32_t id)
+static void shell_task_input_write (struct shell_task_input *ti,
+                                    json_t *context)
 {
-    int rc;
-    struct idset *idset;
-    if (strcmp (set, "all") == 0)
-        return 1;
-    if (!(idset = idset_decode (set)))
-        return shell_log_errno ("idset_decode (%s)", set);
-    rc = idset_test (idset, id);
-    idset_destroy (idset);
-    return rc;
+    struct shell_input_kvs *kp = &(ti->in->input_kvs);
+    flux_shell_task_t *task = ti->task;
+    const char *stream;
+    char *data = NULL;
+    int len;
+    bool eof;
+
+    if (iodecode (context, &stream, NULL, &data, &len, &eof) < 0)
+        shell_die (1, "malformed event context");
+    if (len > 0) {
+        if (flux_subprocess_write (task->proc, stream, data, len) < 0) {
+            if (errno != EPIPE)
+                shell_die_errno (1, "flux_subprocess_write");
+            else
+                eof = true; /* Pretend that we got eof */
+        }
+    }
+    if (eof) {
+        if (flux_subprocess_close (task->proc, stream) < 0)
+            shell_die_errno (1, "flux_subprocess_close");
+        ti->closed = true;
+        kp->nopen--;
+    }
+    free (data);
 }
 
-static void shell_task_input_kvs_input_cb (flux_future_t *f, void *arg)
+static void shell_input_kvs_input_cb (flux_future_t *f, void *arg)
 {
-    struct shell_task_input *task_input = arg;
-    struct shell_task_input_kvs *kp = &(task_input->input_kvs);
+    struct shell_input *in = arg;
+    struct shell_input_kvs *kp = &(in->input_kvs);
     const char *entry;
     json_t *o;
     const char *name;
@@ -476,65 +487,53 @@ static void shell_task_input_kvs_input_cb (flux_future_t *f, void *arg)
         kp->input_header_parsed = true;
     }
     else if (!strcmp (name, "data")) {
-        flux_shell_task_t *task = task_input->task;
         const char *rank = NULL;
+        struct idset *ranks = NULL;
+        int i;
+
         if (!kp->input_header_parsed)
             shell_die (1, "stream data read before header");
         if (iodecode (context, NULL, &rank, NULL, NULL, NULL) < 0)
             shell_die (1, "malformed event context");
-        if (idset_string_contains (rank, task->rank) == 1) {
-            const char *stream;
-            char *data = NULL;
-            int len;
-            bool eof;
-            if (iodecode (context, &stream, NULL, &data, &len, &eof) < 0)
-                shell_die (1, "malformed event context");
-            if (len > 0) {
-                if (flux_subprocess_write (task->proc,
-                                           stream,
-                                           data,
-                                           len) < 0) {
-                    if (errno != EPIPE)
-                        shell_die_errno (1, "flux_subprocess_write");
-                    else
-                        eof = true; /* Pretend that we got eof */
-                }
-            }
-            if (eof) {
-                if (flux_subprocess_close (task->proc, stream) < 0)
-                    shell_die_errno (1, "flux_subprocess_close");
-                if (flux_job_event_watch_cancel (f) < 0)
-                    shell_die_errno (1, "flux_job_event_watch_cancel");
-            }
-            free (data);
+        /*  Decode the target idset once for all local tasks */
+        if (strcmp (rank, "all") != 0 && !(ranks = idset_decode (rank)))
+            shell_die_errno (1, "idset_decode (%s)", rank);
+        for (i = 0; i < in->ntasks; i++) {
+            struct shell_task_input *ti = &in->task_inputs[i];
+            if (ti->task
+                && !ti->closed
+                && (!ranks || idset_test (ranks, ti->task->rank)))
+                shell_task_input_write (ti, context);
         }
+        idset_destroy (ranks);
     }
     json_decref (o);
+    if (kp->nopen == 0)
+        shell_input_kvs_cancel (kp);
     flux_future_reset (f);
     return;
 done:
-    shell_task_input_kvs_cleanup (kp);
+    shell_input_kvs_cleanup (kp);
 }
 
-static int shell_task_input_kvs_start (struct shell_task_input *ti)
+static int shell_input_kvs_start (struct shell_input *in)
 {
-    struct shell_task_input_kvs *kp = &(ti->input_kvs);
     flux_future_t *f = NULL;
     /*  Start watching kvs guest.input eventlog.
      *  Since this function is called after shell initialization
      *   barrier, we are guaranteed that input eventlog exists.
      */
-    if (!(f = flux_job_event_watch (ti->in->shell->h,
-                                    ti->in->shell->info->jobid,
+    if (!(f = flux_job_event_watch (in->shell->h,
+                                    in->shell->info->jobid,
                                     "guest.input",
                                     0)))
             shell_die_errno (1, "flux_job_event_watch");
 
-    if (flux_future_then (f, -1., shell_task_input_kvs_input_cb, ti) < 0) {
+    if (flux_future_then (f, -1., shell_input_kvs_input_cb, in) < 0) {
         flux_future_destroy (f);
         shell_die_errno (1, "flux_future_then");
     }
-    kp->input_f = f;
+    in->input_kvs.input_f = f;
     return 0;
 }
 
@@ -560,13 +559,46 @@ static int shell_input_task_init (flux_plugin_t *p,
     task_input = get_task_input (in, task);
     task_input->in = in;
     task_input->task = task;
+    if (task_input->type == FLUX_TASK_INPUT_KVS)
+        in->input_kvs.nopen++;
+    return 0;
+}
+
+/*  Start the shared input watch once all local tasks have been started.
+ */
+static int shell_input_start (flux_plugin_t *p,
+                              const char *topic,
+                              flux_plugin_arg_t *args,
+                              void *data)
+{
+    struct shell_input *in = flux_plugin_aux_get (p, "builtin.input");
+
+    if (!in)
+        return -1;
+    /* can't read stdin in standalone mode, no KVS to read from */
+    if (in->shell->standalone || in->input_kvs.nopen == 0)
+        return 0;
+    if (shell_input_kvs_start (in) < 0)
+        shell_die_errno (1, "shell_input_kvs_start");
+    return 0;
+}
 
-    if (task_input->type == FLUX_TASK_INPUT_KVS) {
-        /* can't read stdin in standalone mode, no KVS to read from */
-        if (!task_input->in->shell->standalone
-            && shell_task_input_kvs_start (task_input) < 0)
-            shell_die_errno (1, "shell_input_start_task_watch");
+static int shell_input_init (flux_plugin_t *p,
+                             const char *topic,
+                             flux_plugin_arg_t *args,
+                             void *data)
+{
+    flux_shell_t *shell = flux_plugin_get_shell (p);
+    struct shell_input *in = shell_input_create (shell);
+    if (!in)
+        return -1;
+    if (flux_plugin_aux_set (p, "builtin.input", in,
+                            (flux_free_f) shell_input_destroy) < 0) {
+        shell_input_destroy (in);
+        return -1;
     }
+    if (flux_plugin_add_handler (p, "shell.start", shell_input_start, NULL) < 0)
+        return -1;
     return 0;
 }
 
@@ -584,10 +616,10 @@ static int shell_input_task_exit (flux_plugin_t *p,
         return -1;
 
     task_input = get_task_input (in, task);
-    if (task_input->type == FLUX_TASK_INPUT_KVS
-        && task_input->input_kvs.input_f) {
-        if (flux_job_event_watch_cancel (task_input->input_kvs.input_f) < 0)
-            shell_log_errno ("flux_job_event_watch_cancel");
+    if (task_input->type == FLUX_TASK_INPUT_KVS && !task_input->closed) {
+        task_input->closed = true;
+        if (--in->input_kvs.nopen == 0)
+            shell_input_kvs_cancel (&in->input_kvs);
     }
     return 0;
 }
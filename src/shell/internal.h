@@ -43,6 +43,9 @@ struct flux_shell {
     int verbose;
     bool standalone;
 
+    json_t *timing;             /* seconds spent in each startup phase */
+    struct timespec t_phase;    /* start of the current startup phase */
+
     struct aux_item *aux;
 };
 
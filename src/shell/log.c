@@ -127,7 +127,9 @@ static int log_event (int level,
      *   another log message then format log message args and call all
      *   "shell.log" callbacks.
      */
-    if (logger.shell->plugstack && !logger.active) {
+    if (logger.shell->plugstack
+        && !logger.active
+        && plugstack_has_handler (logger.shell->plugstack, "shell.log") != 0) {
         logger.active = 1;
         if (!(args = log_msg_args (level, rank, component, file, line, msg)))
             return -1;
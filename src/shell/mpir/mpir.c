@@ -10,6 +10,14 @@
 
 /* MPIR_proctable service for job shell
  *
+ * The leader shell answers proctable requests with the proctable of
+ * the whole job. Shells are organized as a K-ary tree rooted at the
+ * leader (mpir.tree-fanout, default 32), and each shell with children
+ * answers a "subtree" request from its parent with the merged,
+ * range-encoded proctable of its subtree. The leader therefore only
+ * handles K responses, and each reply is merged once per level rather
+ * than all at the leader. With mpir.tree-fanout=0 the leader requests
+ * proctables from every shell directly.
  */
 
 #if HAVE_CONFIG_H
@@ -26,16 +34,25 @@
 #include <flux/core.h>
 #include <flux/shell.h>
 
+#include "src/common/libutil/kary.h"
+
 #include "builtins.h"
 #include "mpir/proctable.h"
 
+static const int mpir_tree_fanout_default = 32;
+
+/*  The time each shell waits for its children to respond, per level of
+ *   the tree below it.
+ */
+static const double mpir_level_timeout = 5.;
+
 
 /*  Structure for use during proctable gather from shell rank 0.
  */
 struct proctable_gather {
     flux_t *h;
     flux_shell_t *shell;
-    int shell_size;
+    int count;          /* number of proctables expected */
     const flux_msg_t *req;
     zlistx_t *proctables;
     zlistx_t *futures;
@@ -69,6 +86,22 @@ static int shell_rank (flux_shell_t *shell)
     return rank;
 }
 
+/*  Fanout of the proctable tree, or 0 if shells are not organized in
+ *   a tree.
+ */
+static int mpir_tree_fanout (flux_shell_t *shell)
+{
+    int k = mpir_tree_fanout_default;
+    if (flux_shell_getopt_unpack (shell, "mpir", "{s?i}",
+                                  "tree-fanout", &k) < 0
+        || k < 0) {
+        shell_log_error ("invalid mpir.tree-fanout, using %d",
+                         mpir_tree_fanout_default);
+        k = mpir_tree_fanout_default;
+    }
+    return k;
+}
+
 static int proctable_add_task (struct proctable *p,
                                flux_shell_task_t *task)
 {
@@ -184,7 +217,7 @@ static void proctable_gather_destroy (struct proctable_gather *pg)
 }
 
 static struct proctable_gather *proctable_gather_create (flux_shell_t *shell,
-                                                         int shell_size,
+                                                         int count,
                                                          const flux_msg_t *msg)
 {
     struct proctable_gather *pg = calloc (1, sizeof (*pg));
@@ -197,7 +230,7 @@ static struct proctable_gather *proctable_gather_create (flux_shell_t *shell,
      */
     flux_shell_add_completion_ref (pg->shell, "proctable.get");
 
-    pg->shell_size = shell_size;
+    pg->count = count;
     pg->h = flux_shell_get_flux (shell);
     pg->req = flux_msg_incref (msg);
     if (!(pg->proctables = zlistx_new ())
@@ -218,7 +251,7 @@ static int proctable_gather_complete (struct proctable_gather *pg)
     /*  Once we've stored all local/remote proctables, reduce the
      *   list and respond to original request.
      */
-    if (zlistx_size (pg->proctables) == pg->shell_size) {
+    if (zlistx_size (pg->proctables) == pg->count) {
         struct proctable *p = zlistx_detach (pg->proctables, NULL);
         struct proctable *next = zlistx_detach (pg->proctables, NULL);
 
@@ -291,34 +324,76 @@ err:
     proctable_gather_cancel (pg);
 }
 
+/*  Fill 'children' with the shell ranks this shell gathers proctables
+ *   from, and return the number of children.
+ */
+static int proctable_children (int k,
+                               int size,
+                               int rank,
+                               int *children)
+{
+    int n = 0;
+    if (k == 0) {
+        if (rank == 0) {
+            for (int i = 1; i < size; i++)
+                children[n++] = i;
+        }
+        return n;
+    }
+    for (int j = 0; j < k; j++) {
+        uint32_t child = kary_childof (k, size, rank, j);
+        if (child == KARY_NONE)
+            break;
+        children[n++] = child;
+    }
+    return n;
+}
+
 static int request_all_proctables (flux_shell_t *shell,
-                                   int shell_size,
+                                   int k,
+                                   int size,
+                                   int *children,
+                                   int nchildren,
                                    const flux_msg_t *msg,
                                    struct proctable *p)
 {
     struct proctable_gather *pg;
+    double timeout = mpir_level_timeout;
 
-    if (!(pg = proctable_gather_create (shell, shell_size, msg))
+    if (!(pg = proctable_gather_create (shell, nchildren + 1, msg))
         || !zlistx_insert (pg->proctables, p, false)) {
         shell_log_errno ("failed to create proctable gather struct");
         goto err;
     }
 
-    shell_debug ("requesting proctables from %d ranks", pg->shell_size - 1);
-    for (int i = 1; i < pg->shell_size; i++) {
+    /*  Allow each level of the subtree below this shell to time out
+     *   before giving up on it.
+     */
+    if (k > 0)
+        timeout *= kary_levelof (k, size - 1)
+                   - kary_levelof (k, shell_rank (shell));
+
+    shell_debug ("requesting proctables from %d ranks", nchildren);
+    for (int i = 0; i < nchildren; i++) {
         flux_future_t *f;
-        /*  Request proctable from remote shell:
+        /*  Request proctable from remote shell, including its subtree
+         *   if shells are organized in a tree:
          */
-        if (!(f = flux_shell_rpc_pack (shell, "proctable", i, 0, "{}"))) {
+        if (!(f = flux_shell_rpc_pack (shell,
+                                       "proctable",
+                                       children[i],
+                                       0,
+                                       "{s:b}",
+                                       "subtree", k > 0))) {
             shell_log_errno ("flux_shell_rpc_pack");
             goto err;
         }
-        /*  Give 5.0s for shells to respond. This timeout is required
+        /*  Give shells time to respond. This timeout is required
          *   in case remote shells have already exited or are exiting
          *   at the time the leader shell requests proctables. In that
          *   case the request RPC is dropped without any ENOSYS response.
          */
-        if (flux_future_then (f, 5., proctable_get_cb, pg) < 0) {
+        if (flux_future_then (f, timeout, proctable_get_cb, pg) < 0) {
             shell_log_errno ("flux_future_then");
             goto err;
         }
@@ -337,28 +412,51 @@ static void mpir_proctable_get (flux_t *h,
 {
     flux_shell_t *shell = arg;
     int size = shell_size (shell);
-    struct proctable *p = local_proctable_create (shell);
-
-    if (p == NULL)
+    int rank = shell_rank (shell);
+    int k = mpir_tree_fanout (shell);
+    int subtree = 0;
+    int nchildren = 0;
+    int *children = NULL;
+    struct proctable *p = NULL;
+
+    if (flux_request_unpack (msg, NULL, "{s?b}", "subtree", &subtree) < 0
+        || !(p = local_proctable_create (shell)))
         goto error;
 
-    /*  For non-leader shells, or a job size of 1, immediately respond
-     *   to the request with the local proctable.
+    /*  The leader gathers the proctable of the whole job. Other shells
+     *   gather their subtree only when asked by their parent.
      */
-    if (shell_rank (shell) != 0 || size == 1) {
+    if (rank == 0 || subtree) {
+        if (!(children = calloc (size, sizeof (int))))
+            goto error;
+        nchildren = proctable_children (k, size, rank, children);
+    }
+
+    /*  With no children to wait for, immediately respond to the
+     *   request with the local proctable.
+     */
+    if (nchildren == 0) {
         if (respond_proctable (h, msg, p) < 0)
             shell_log_errno ("unable to send proctable");
         proctable_destroy (p);
+        free (children);
         return;
     }
 
-    /*  On a leader shell in a job with size > 1, initiate requests to
-     *   all other shells for their local proctables.
+    /*  Otherwise, initiate requests to children for their proctables.
      */
-    if (request_all_proctables (shell, size, msg, p) < 0)
+    if (request_all_proctables (shell,
+                                k,
+                                size,
+                                children,
+                                nchildren,
+                                msg,
+                                p) < 0)
         shell_log_errno ("request_all_proctables");
+    free (children);
     return;
 error:
+    proctable_destroy (p);
     if (flux_respond_error (h, msg, errno, NULL) < 0)
         shell_log_errno ("flux_response");
 }
@@ -38,6 +38,30 @@
  * - In standalone mode, output is written to the shell's stdout/stderr not KVS
  * - The number of in-flight write requests on each shell is limited to
  *   shell_output_hwm, to avoid matchtag exhaustion, etc. for chatty tasks.
+ * - Output bound for the KVS is staged on the leader and handed to the
+ *   shell's shared eventlogger in batches.  A batch is flushed when it
+ *   holds output.batch-bytes of data or output.batch-lines lines, or
+ *   output.batch-timeout seconds after its first entry, whichever comes
+ *   first.  The eventlogger commits flushed output in the same KVS
+ *   transaction as any pending shell events and log messages.
+ * - While staged, consecutive chunks from the same rank and stream are
+ *   concatenated, and identical chunks from different ranks on the same
+ *   stream are merged into one entry with an idset "rank" (RFC 24).
+ * - If output.tree-fanout=K is set, shells are organized as a K-ary tree
+ *   rooted at the leader.  Shells with children register their own
+ *   "write" service, which also receives output of their own tasks,
+ *   and forward what they receive to their parent as one batch of
+ *   entries per reactor loop iteration.  Requests are not answered until
+ *   the parent has accepted the batch, so backpressure from the leader
+ *   reaches the shells at the leaves.  With output.tree-dedup=1,
+ *   identical output from different ranks is collapsed into one entry
+ *   with an idset "rank" along the way.
+ * - If output.<stream>.direct is set for file output, the leader only
+ *   writes a redirect event to the KVS, and each shell writes the output
+ *   of its own tasks directly to the file.  The path may contain
+ *   {{node}} and {{taskid}} templates to get per-shell or per-task files.
+ *   A path shared between shells is opened with O_APPEND and is not
+ *   truncated.
  */
 
 #if HAVE_CONFIG_H
@@ -49,6 +73,7 @@
 #include <flux/core.h>
 
 #include "src/common/libidset/idset.h"
+#include "src/common/libutil/kary.h"
 #include "src/common/libeventlog/eventlog.h"
 #include "src/common/libioencode/ioencode.h"
 
@@ -62,6 +87,7 @@ enum {
     FLUX_OUTPUT_TYPE_TERM = 1,
     FLUX_OUTPUT_TYPE_KVS = 2,
     FLUX_OUTPUT_TYPE_FILE = 3,
+    FLUX_OUTPUT_TYPE_DIRECT = 4, // file written by each shell, not leader
 };
 
 struct shell_output_fd {
@@ -72,12 +98,35 @@ struct shell_output_type_file {
     struct shell_output_fd *fdp;
     char *path;
     int label;
+    int direct;
+    int append;
+};
+
+/* Subscriber argument for a task stream written directly to a file.
+ */
+struct direct_task {
+    struct shell_output_fd *fdp;
+    int label;
 };
 
 struct shell_output {
     flux_shell_t *shell;
     struct eventlogger *ev;
     double batch_timeout;
+    int batch_bytes;
+    int batch_lines;
+    json_t *batch;
+    int batch_nbytes;
+    int batch_nlines;
+    flux_watcher_t *batch_timer;
+    int tree_k;
+    int tree_dedup;
+    int write_rank;         // shell rank that services our "write" RPCs
+    int parent;             // shell rank output is forwarded to
+    zlistx_t *fwd_entries;  // staged forward_entry's (tree interior only)
+    zlist_t *fwd_requests;  // requests answered once the batch is accepted
+    flux_watcher_t *fwd_prep;
+    bool fwd_ref;
     int refcount;
     int eof_pending;
     zlist_t *pending_writes;
@@ -88,11 +137,24 @@ struct shell_output {
     struct shell_output_type_file stdout_file;
     struct shell_output_type_file stderr_file;
     zhash_t *fds;
+    zlist_t *direct_tasks;
 };
 
 static const int shell_output_lwm = 100;
 static const int shell_output_hwm = 1000;
 
+static const double batch_timeout_default = 0.5;
+static const int batch_bytes_default = 65536;
+static const int batch_lines_default = 1024;
+
+struct forward_entry {
+    char *stream;
+    struct idset *ranks;
+    char *data;
+    int len;
+    bool eof;
+};
+
 /* Pause/resume output on 'stream' of 'task'.
  */
 static void shell_output_control_task (struct shell_task *task,
@@ -176,14 +238,14 @@ static int shell_output_term (struct shell_output *out)
 static int shell_output_redirect_stream (struct shell_output *out,
                                          flux_kvs_txn_t *txn,
                                          const char *stream,
-                                         const char *path)
+                                         const char *path,
+                                         int ntasks)
 {
-    struct idset *idset;
+    struct idset *idset = NULL;
     json_t *entry = NULL;
     char *entrystr = NULL;
     int saved_errno, rc = -1;
     char *rankptr = NULL;
-    int ntasks = out->shell->info->rankinfo.ntasks;
 
     if (ntasks > 1) {
         int flags = IDSET_FLAG_BRACKETS | IDSET_FLAG_RANGE;
@@ -227,6 +289,7 @@ static int shell_output_redirect_stream (struct shell_output *out,
 error:
     /* on error, future destroyed via shell_output destroy */
     saved_errno = errno;
+    idset_destroy (idset);
     json_decref (entry);
     free (entrystr);
     free (rankptr);
@@ -234,21 +297,37 @@ error:
     return rc;
 }
 
+static int redirect_ntasks (struct shell_output *out, int type)
+{
+    /* Direct output redirect events are the only record of the output
+     * in the KVS, so they cover all tasks of the job.
+     */
+    if (type == FLUX_OUTPUT_TYPE_DIRECT)
+        return out->shell->info->total_ntasks;
+    return out->shell->info->rankinfo.ntasks;
+}
+
 static int shell_output_redirect (struct shell_output *out, flux_kvs_txn_t *txn)
 {
     /* if file redirected, output redirect event */
-    if (out->stdout_type == FLUX_OUTPUT_TYPE_FILE) {
+    if (out->stdout_type == FLUX_OUTPUT_TYPE_FILE
+        || out->stdout_type == FLUX_OUTPUT_TYPE_DIRECT) {
         if (shell_output_redirect_stream (out,
                                           txn,
                                           "stdout",
-                                          out->stdout_file.path) < 0)
+                                          out->stdout_file.path,
+                                          redirect_ntasks (out,
+                                                           out->stdout_type)) < 0)
             return -1;
     }
-    if (out->stderr_type == FLUX_OUTPUT_TYPE_FILE) {
+    if (out->stderr_type == FLUX_OUTPUT_TYPE_FILE
+        || out->stderr_type == FLUX_OUTPUT_TYPE_DIRECT) {
         if (shell_output_redirect_stream (out,
                                           txn,
                                           "stderr",
-                                          out->stderr_file.path) < 0)
+                                          out->stderr_file.path,
+                                          redirect_ntasks (out,
+                                                           out->stderr_type)) < 0)
             return -1;
     }
     return 0;
@@ -310,15 +389,188 @@ static int entry_output_is_kvs (struct shell_output *out, json_t *entry)
     return 0;
 }
 
+static int count_lines (const char *data, int len)
+{
+    int count = 0;
+    int i;
+    for (i = 0; i < len; i++) {
+        if (data[i] == '\n')
+            count++;
+    }
+    return count;
+}
+
+/* Merge 'rank' into the idset string 'ranks'.
+ * Returns a new idset string on success (caller must free).
+ */
+static char *merge_ranks (const char *ranks, const char *rank)
+{
+    struct idset *ids;
+    struct idset *add = NULL;
+    unsigned int id;
+    char *s = NULL;
+
+    if (!(ids = idset_decode (ranks)) || !(add = idset_decode (rank)))
+        goto out;
+    id = idset_first (add);
+    while (id != IDSET_INVALID_ID) {
+        if (idset_set (ids, id) < 0)
+            goto out;
+        id = idset_next (add, id);
+    }
+    s = idset_encode (ids, IDSET_FLAG_RANGE);
+out:
+    idset_destroy (ids);
+    idset_destroy (add);
+    return s;
+}
+
+/* Try to merge a data event into the last staged entry.
+ * Returns 1 if merged, 0 if entries are not compatible, -1 on error.
+ */
+static int batch_merge (struct shell_output *out,
+                        const char *stream,
+                        const char *rank,
+                        const char *data,
+                        int len)
+{
+    size_t last = json_array_size (out->batch);
+    json_t *prev;
+    json_t *context;
+    json_t *o = NULL;
+    json_t *nentry = NULL;
+    double timestamp;
+    const char *pstream;
+    const char *prank;
+    char *pdata = NULL;
+    char *buf = NULL;
+    char *ranks = NULL;
+    int plen;
+    bool peof;
+    int rc = -1;
+
+    if (last == 0 || len == 0)
+        return 0;
+    prev = json_array_get (out->batch, last - 1);
+    if (eventlog_entry_parse (prev, &timestamp, NULL, &context) < 0
+        || iodecode (context, &pstream, &prank, &pdata, &plen, &peof) < 0)
+        return -1;
+    if (peof || plen == 0 || strcmp (stream, pstream) != 0) {
+        rc = 0;
+        goto out;
+    }
+    if (!strcmp (rank, prank)) {
+        if (!(buf = malloc (plen + len)))
+            goto out;
+        memcpy (buf, pdata, plen);
+        memcpy (buf + plen, data, len);
+        o = ioencode (stream, rank, buf, plen + len, false);
+    }
+    else if (plen == len && !memcmp (pdata, data, len)) {
+        if (!(ranks = merge_ranks (prank, rank)))
+            goto out;
+        o = ioencode (stream, ranks, pdata, plen, false);
+    }
+    else {
+        rc = 0;
+        goto out;
+    }
+    if (!o || !(nentry = eventlog_entry_pack (timestamp, "data", "O", o)))
+        goto out;
+    if (json_array_set_new (out->batch, last - 1, nentry) < 0) {
+        json_decref (nentry);
+        errno = ENOMEM;
+        goto out;
+    }
+    rc = 1;
+out:
+    json_decref (o);
+    free (pdata);
+    free (buf);
+    free (ranks);
+    return rc;
+}
+
+/* Hand all staged entries to the eventlogger, which commits them along
+ * with other pending appends at the end of its batch window.
+ * If 'wait' is true, commit now and wait for the commit to complete.
+ */
+static int batch_flush (struct shell_output *out, bool wait)
+{
+    json_t *entry;
+    size_t index;
+
+    flux_watcher_stop (out->batch_timer);
+    if (json_array_size (out->batch) == 0 && !wait)
+        return 0;
+    json_array_foreach (out->batch, index, entry) {
+        if (eventlogger_append_entry (out->ev, 0, "output", entry) < 0)
+            return shell_log_errno ("eventlogger_append");
+    }
+    if (json_array_clear (out->batch) < 0) {
+        errno = ENOMEM;
+        return -1;
+    }
+    out->batch_nbytes = 0;
+    out->batch_nlines = 0;
+    if (wait) {
+        if (eventlogger_flush (out->ev) < 0)
+            return shell_log_errno ("eventlogger_flush");
+    }
+    return 0;
+}
+
+static void batch_timer_cb (flux_reactor_t *r,
+                            flux_watcher_t *w,
+                            int revents,
+                            void *arg)
+{
+    struct shell_output *out = arg;
+    if (batch_flush (out, false) < 0)
+        shell_die_errno (1, "batch_flush");
+}
+
+static int batch_append (struct shell_output *out, json_t *entry)
+{
+    json_t *context;
+    const char *stream;
+    const char *rank;
+    char *data = NULL;
+    int len = 0;
+    int rc = -1;
+    int merged;
+
+    if (eventlog_entry_parse (entry, NULL, NULL, &context) < 0
+        || iodecode (context, &stream, &rank, &data, &len, NULL) < 0)
+        return -1;
+    if ((merged = batch_merge (out, stream, rank, data, len)) < 0)
+        goto out;
+    if (!merged && json_array_append (out->batch, entry) < 0) {
+        errno = ENOMEM;
+        goto out;
+    }
+    if (json_array_size (out->batch) == 1)
+        flux_watcher_start (out->batch_timer);
+    out->batch_nbytes += len;
+    out->batch_nlines += count_lines (data, len);
+    if (out->batch_nbytes >= out->batch_bytes
+        || out->batch_nlines >= out->batch_lines) {
+        if (batch_flush (out, false) < 0)
+            goto out;
+    }
+    rc = 0;
+out:
+    free (data);
+    return rc;
+}
+
 static int shell_output_kvs (struct shell_output *out)
 {
     json_t *entry;
     size_t index;
     json_array_foreach (out->output, index, entry) {
-        if (entry_output_is_kvs (out, entry) &&
-            eventlogger_append_entry (out->ev, 0, "output", entry) < 0) {
-            return shell_log_errno ("eventlogger_append");
-        }
+        if (entry_output_is_kvs (out, entry) && batch_append (out, entry) < 0)
+            return shell_log_errno ("batch_append");
     }
     return 0;
 }
@@ -338,6 +590,38 @@ static int shell_output_write_fd (int fd, const void *buf, size_t len)
     return n;
 }
 
+/* Write 'data' to 'ofp' once for each task in 'rank', which is an idset
+ * if identical output from several tasks was merged on the way here.
+ */
+static int shell_output_write_type_file (struct shell_output_type_file *ofp,
+                                         const char *rank,
+                                         const char *data,
+                                         int len)
+{
+    struct idset *ranks;
+    unsigned int id;
+    int rc = -1;
+
+    if (!(ranks = idset_decode (rank)))
+        return -1;
+    id = idset_first (ranks);
+    while (id != IDSET_INVALID_ID) {
+        if (ofp->label) {
+            char buf[32];
+            int buflen = snprintf (buf, sizeof (buf), "%u: ", id);
+            if (shell_output_write_fd (ofp->fdp->fd, buf, buflen) < 0)
+                goto out;
+        }
+        if (shell_output_write_fd (ofp->fdp->fd, data, len) < 0)
+            goto out;
+        id = idset_next (ranks, id);
+    }
+    rc = 0;
+out:
+    idset_destroy (ranks);
+    return rc;
+}
+
 static int shell_output_file (struct shell_output *out)
 {
     json_t *entry;
@@ -370,19 +654,10 @@ static int shell_output_file (struct shell_output *out)
                 ofp = &out->stderr_file;
             }
             if ((output_type == FLUX_OUTPUT_TYPE_FILE) && len > 0) {
-                if (ofp->label) {
-                    char *buf = NULL;
-                    int buflen;
-                    if ((buflen = asprintf (&buf, "%s: ", rank)) < 0)
-                        return -1;
-                    if (shell_output_write_fd (ofp->fdp->fd, buf, buflen) < 0) {
-                        free (buf);
-                        return -1;
-                    }
-                    free (buf);
-                }
-                if (shell_output_write_fd (ofp->fdp->fd, data, len) < 0)
+                if (shell_output_write_type_file (ofp, rank, data, len) < 0) {
+                    free (data);
                     return -1;
+                }
             }
             free (data);
         }
@@ -393,27 +668,53 @@ static int shell_output_file (struct shell_output *out)
 /* Convert 'iodecode' object to an valid RFC 24 data event.
  * N.B. the iodecode object is a valid "context" for the event.
  */
+static int shell_output_append (struct shell_output *out, json_t *o, int *neof)
+{
+    json_t *entry;
+    bool eof;
+
+    if (iodecode (o, NULL, NULL, NULL, NULL, &eof) < 0)
+        return -1;
+    if (!(entry = eventlog_entry_pack (0., "data", "O", o))) // increfs 'o'
+        return -1;
+    if (json_array_append_new (out->output, entry) < 0) {
+        json_decref (entry);
+        errno = ENOMEM;
+        return -1;
+    }
+    if (eof)
+        (*neof)++;
+    return 0;
+}
+
 static void shell_output_write_cb (flux_t *h,
                                    flux_msg_handler_t *mh,
                                    const flux_msg_t *msg,
                                    void *arg)
 {
     struct shell_output *out = arg;
-    bool eof = false;
+    int neof = 0;
     json_t *o;
-    json_t *entry;
+    json_t *batch = NULL;
 
     if (flux_request_unpack (msg, NULL, "o", &o) < 0)
         goto error;
-    if (iodecode (o, NULL, NULL, NULL, NULL, &eof) < 0)
-        goto error;
-    if (!(entry = eventlog_entry_pack (0., "data", "O", o))) // increfs 'o'
-        goto error;
-    if (json_array_append_new (out->output, entry) < 0) {
-        json_decref (entry);
-        errno = ENOMEM;
-        goto error;
+    /* Shells in an output tree forward {"batch":[io, ...]}
+     */
+    if (json_unpack (o, "{s:o}", "batch", &batch) == 0) {
+        size_t index;
+        json_t *io;
+        if (!json_is_array (batch)) {
+            errno = EPROTO;
+            goto error;
+        }
+        json_array_foreach (batch, index, io) {
+            if (shell_output_append (out, io, &neof) < 0)
+                goto error;
+        }
     }
+    else if (shell_output_append (out, o, &neof) < 0)
+        goto error;
     /* Error failing to commit is a fatal error.  Should be cleaner in
      * future. Issue #2378 */
     if ((out->stdout_type == FLUX_OUTPUT_TYPE_TERM
@@ -435,8 +736,9 @@ static void shell_output_write_cb (flux_t *h,
         shell_log_error ("json_array_clear failed");
         goto error;
     }
-    if (eof) {
-        if (--out->eof_pending == 0) {
+    if (neof > 0) {
+        out->eof_pending -= neof;
+        if (out->eof_pending == 0) {
             flux_msg_handler_stop (mh);
             if (flux_shell_remove_completion_ref (out->shell, "output.write") < 0)
                 shell_log_errno ("flux_shell_remove_completion_ref");
@@ -444,8 +746,8 @@ static void shell_output_write_cb (flux_t *h,
              * output */
             if ((out->stdout_type == FLUX_OUTPUT_TYPE_KVS
                  || (out->stderr_type == FLUX_OUTPUT_TYPE_KVS))) {
-                if (eventlogger_flush (out->ev) < 0)
-                    shell_log_errno ("eventlogger_flush");
+                if (batch_flush (out, true) < 0)
+                    shell_log_errno ("batch_flush");
             }
         }
     }
@@ -487,7 +789,12 @@ static int shell_output_write (struct shell_output *out,
         return -1;
     }
 
-    if (!(f = flux_shell_rpc_pack (out->shell, "write", 0, 0, "O", o)))
+    if (!(f = flux_shell_rpc_pack (out->shell,
+                                   "write",
+                                   out->write_rank,
+                                   0,
+                                   "O",
+                                   o)))
         goto error;
     if (flux_future_then (f, -1, shell_output_write_completion, out) < 0)
         goto error;
@@ -505,6 +812,387 @@ error:
     return -1;
 }
 
+static bool output_type_requires_service (int type)
+{
+    if ((type == FLUX_OUTPUT_TYPE_TERM)
+        || (type == FLUX_OUTPUT_TYPE_KVS)
+        || (type == FLUX_OUTPUT_TYPE_FILE))
+        return true;
+    return false;
+}
+
+static void forward_entry_destroy (struct forward_entry *fe)
+{
+    if (fe) {
+        int saved_errno = errno;
+        free (fe->stream);
+        idset_destroy (fe->ranks);
+        free (fe->data);
+        free (fe);
+        errno = saved_errno;
+    }
+}
+
+static void forward_entry_destructor (void **item)
+{
+    if (item) {
+        forward_entry_destroy (*item);
+        *item = NULL;
+    }
+}
+
+static struct forward_entry *forward_entry_create (json_t *io)
+{
+    struct forward_entry *fe;
+    const char *stream;
+    const char *rank;
+
+    if (!(fe = calloc (1, sizeof (*fe))))
+        return NULL;
+    if (iodecode (io, &stream, &rank, &fe->data, &fe->len, &fe->eof) < 0)
+        goto error;
+    if (!(fe->stream = strdup (stream)))
+        goto error;
+    if (!(fe->ranks = idset_decode (rank)))
+        goto error;
+    return fe;
+error:
+    forward_entry_destroy (fe);
+    return NULL;
+}
+
+static bool ranks_overlap (const struct idset *a, const struct idset *b)
+{
+    unsigned int id = idset_first (b);
+    while (id != IDSET_INVALID_ID) {
+        if (idset_test (a, id))
+            return true;
+        id = idset_next (b, id);
+    }
+    return false;
+}
+
+static int ranks_add (struct idset *dst, const struct idset *src)
+{
+    unsigned int id = idset_first (src);
+    while (id != IDSET_INVALID_ID) {
+        if (idset_set (dst, id) < 0)
+            return -1;
+        id = idset_next (src, id);
+    }
+    return 0;
+}
+
+/* Find a staged entry with the same stream and data as 'fe'.  The search
+ * stops at the first entry from any of the ranks of 'fe', so per-rank
+ * ordering of output is preserved.
+ */
+static struct forward_entry *forward_find_dup (struct shell_output *out,
+                                               struct forward_entry *fe)
+{
+    struct forward_entry *prev = zlistx_last (out->fwd_entries);
+
+    while (prev) {
+        if (ranks_overlap (prev->ranks, fe->ranks))
+            return NULL;
+        if (!prev->eof
+            && prev->len == fe->len
+            && !strcmp (prev->stream, fe->stream)
+            && !memcmp (prev->data, fe->data, fe->len))
+            return prev;
+        prev = zlistx_prev (out->fwd_entries);
+    }
+    return NULL;
+}
+
+static int forward_stage (struct shell_output *out, json_t *io)
+{
+    struct forward_entry *fe;
+    struct forward_entry *dup;
+
+    if (!(fe = forward_entry_create (io)))
+        return -1;
+    if (out->tree_dedup
+        && !fe->eof
+        && fe->len > 0
+        && (dup = forward_find_dup (out, fe))) {
+        int rc = ranks_add (dup->ranks, fe->ranks);
+        forward_entry_destroy (fe);
+        return rc;
+    }
+    if (fe->eof)
+        out->eof_pending--;
+    if (!zlistx_add_end (out->fwd_entries, fe)) {
+        forward_entry_destroy (fe);
+        errno = ENOMEM;
+        return -1;
+    }
+    return 0;
+}
+
+static void requests_destroy (zlist_t *requests)
+{
+    zlist_destroy (&requests);
+}
+
+static json_t *forward_encode (struct shell_output *out)
+{
+    struct forward_entry *fe;
+    json_t *batch;
+
+    if (!(batch = json_array ()))
+        goto nomem;
+    fe = zlistx_first (out->fwd_entries);
+    while (fe) {
+        char *ranks;
+        json_t *o;
+        if (!(ranks = idset_encode (fe->ranks, IDSET_FLAG_RANGE)))
+            goto error;
+        o = ioencode (fe->stream, ranks, fe->data, fe->len, fe->eof);
+        free (ranks);
+        if (!o)
+            goto error;
+        if (json_array_append_new (batch, o) < 0) {
+            json_decref (o);
+            goto nomem;
+        }
+        fe = zlistx_next (out->fwd_entries);
+    }
+    return batch;
+nomem:
+    errno = ENOMEM;
+error:
+    json_decref (batch);
+    return NULL;
+}
+
+/* Drop the "output.forward" completion reference once all EOFs from
+ * the subtree have been forwarded and accepted.
+ */
+static void forward_check_done (struct shell_output *out)
+{
+    if (out->fwd_ref
+        && out->eof_pending == 0
+        && zlistx_size (out->fwd_entries) == 0
+        && zlist_size (out->pending_writes) == 0) {
+        if (flux_shell_remove_completion_ref (out->shell, "output.forward") < 0)
+            shell_log_errno ("flux_shell_remove_completion_ref");
+        out->fwd_ref = false;
+    }
+}
+
+static void forward_completion (flux_future_t *f, void *arg)
+{
+    struct shell_output *out = arg;
+    zlist_t *requests = flux_future_aux_get (f, "output::requests");
+    const flux_msg_t *msg;
+    int rc;
+    int errnum;
+
+    if ((rc = flux_future_get (f, NULL)) < 0)
+        shell_log_errno ("forward output to shell rank %d", out->parent);
+    errnum = errno;
+    msg = zlist_first (requests);
+    while (msg) {
+        if (rc < 0) {
+            if (flux_respond_error (out->shell->h, msg, errnum, NULL) < 0)
+                shell_log_errno ("flux_respond_error");
+        }
+        else if (flux_respond (out->shell->h, msg, NULL) < 0)
+            shell_log_errno ("flux_respond");
+        msg = zlist_next (requests);
+    }
+    zlist_remove (out->pending_writes, f);
+    flux_future_destroy (f);
+
+    if (zlist_size (out->pending_writes) <= shell_output_lwm)
+        shell_output_control (out, false);
+    forward_check_done (out);
+}
+
+/* Forward all staged output to the parent in one request.
+ */
+static int forward_flush (struct shell_output *out)
+{
+    json_t *batch;
+    flux_future_t *f = NULL;
+    zlist_t *requests;
+
+    if (zlistx_size (out->fwd_entries) == 0)
+        return 0;
+    if (!(batch = forward_encode (out)))
+        return -1;
+    if (!(f = flux_shell_rpc_pack (out->shell,
+                                   "write",
+                                   out->parent,
+                                   0,
+                                   "{s:O}",
+                                   "batch", batch)))
+        goto error;
+    if (!(requests = zlist_new ()))
+        goto error;
+    if (flux_future_aux_set (f,
+                             "output::requests",
+                             out->fwd_requests,
+                             (flux_free_f) requests_destroy) < 0) {
+        zlist_destroy (&requests);
+        goto error;
+    }
+    out->fwd_requests = requests;
+    if (flux_future_then (f, -1, forward_completion, out) < 0)
+        goto error;
+    if (zlist_append (out->pending_writes, f) < 0)
+        shell_log_error ("zlist_append failed");
+    zlistx_purge (out->fwd_entries);
+    json_decref (batch);
+
+    if (zlist_size (out->pending_writes) >= shell_output_hwm)
+        shell_output_control (out, true);
+    return 0;
+error:
+    flux_future_destroy (f);
+    json_decref (batch);
+    return -1;
+}
+
+static void forward_prep_cb (flux_reactor_t *r,
+                             flux_watcher_t *w,
+                             int revents,
+                             void *arg)
+{
+    struct shell_output *out = arg;
+
+    flux_watcher_stop (w);
+    if (forward_flush (out) < 0)
+        shell_die_errno (1, "forward output to shell rank %d", out->parent);
+}
+
+/* "write" service of a shell in the interior of the output tree.
+ */
+static void shell_output_forward_cb (flux_t *h,
+                                     flux_msg_handler_t *mh,
+                                     const flux_msg_t *msg,
+                                     void *arg)
+{
+    struct shell_output *out = arg;
+    json_t *o;
+    json_t *batch = NULL;
+
+    if (flux_request_unpack (msg, NULL, "o", &o) < 0)
+        goto error;
+    if (json_unpack (o, "{s:o}", "batch", &batch) == 0) {
+        size_t index;
+        json_t *io;
+        if (!json_is_array (batch)) {
+            errno = EPROTO;
+            goto error;
+        }
+        json_array_foreach (batch, index, io) {
+            if (forward_stage (out, io) < 0)
+                goto error;
+        }
+    }
+    else if (forward_stage (out, o) < 0)
+        goto error;
+    if (zlist_append (out->fwd_requests, (void *)flux_msg_incref (msg)) < 0) {
+        flux_msg_decref (msg);
+        errno = ENOMEM;
+        goto error;
+    }
+    zlist_freefn (out->fwd_requests,
+                  (void *)msg,
+                  (zlist_free_fn *) flux_msg_decref,
+                  true);
+    flux_watcher_start (out->fwd_prep);
+    return;
+error:
+    if (flux_respond_error (out->shell->h, msg, errno, NULL) < 0)
+        shell_log_errno ("flux_respond");
+}
+
+/* Count tasks on shell 'rank' and all of its descendants.
+ */
+static int subtree_ntasks (struct shell_output *out, uint32_t rank)
+{
+    struct rcalc_rankinfo ri;
+    uint32_t size = out->shell->info->shell_size;
+    uint32_t child;
+    int count;
+    int j;
+
+    if (rcalc_get_nth (out->shell->info->rcalc, rank, &ri) < 0)
+        return -1;
+    count = ri.ntasks;
+    for (j = 0; j < out->tree_k; j++) {
+        int n;
+        if ((child = kary_childof (out->tree_k, size, rank, j)) == KARY_NONE)
+            break;
+        if ((n = subtree_ntasks (out, child)) < 0)
+            return -1;
+        count += n;
+    }
+    return count;
+}
+
+/* Place this shell in the output tree.  Shells with children aggregate
+ * output from their subtree, including their own tasks.
+ */
+static int output_tree_init (struct shell_output *out)
+{
+    flux_shell_t *shell = out->shell;
+    uint32_t rank = shell->info->shell_rank;
+    uint32_t size = shell->info->shell_size;
+    int ntasks;
+
+    out->write_rank = 0;
+    if (flux_shell_getopt_unpack (shell,
+                                  "output",
+                                  "{s?i s?i}",
+                                  "tree-fanout", &out->tree_k,
+                                  "tree-dedup", &out->tree_dedup) < 0)
+        return shell_log_errno ("invalid output.tree-* option");
+    if (out->tree_k < 0) {
+        errno = EINVAL;
+        return shell_log_errno ("output.tree-fanout must be >= 0");
+    }
+    if (out->tree_k == 0 || rank == 0)
+        return 0;
+    if (kary_childof (out->tree_k, size, rank, 0) == KARY_NONE) {
+        out->write_rank = kary_parentof (out->tree_k, rank);
+        return 0;
+    }
+    out->write_rank = rank;
+    out->parent = kary_parentof (out->tree_k, rank);
+    if ((ntasks = subtree_ntasks (out, rank)) < 0)
+        return shell_log_errno ("unable to count tasks in output subtree");
+    if (output_type_requires_service (out->stdout_type))
+        out->eof_pending += ntasks;
+    if (output_type_requires_service (out->stderr_type))
+        out->eof_pending += ntasks;
+    if (!(out->fwd_entries = zlistx_new ())
+        || !(out->fwd_requests = zlist_new ())) {
+        errno = ENOMEM;
+        return -1;
+    }
+    zlistx_set_destructor (out->fwd_entries, forward_entry_destructor);
+    if (!(out->fwd_prep = flux_prepare_watcher_create (flux_get_reactor (shell->h),
+                                                       forward_prep_cb,
+                                                       out)))
+        return -1;
+    if (flux_shell_service_register (shell,
+                                     "write",
+                                     shell_output_forward_cb,
+                                     out) < 0)
+        return -1;
+    if (flux_shell_add_completion_ref (shell, "output.forward") < 0)
+        return -1;
+    out->fwd_ref = true;
+    shell_debug ("output tree: forwarding %d tasks to shell rank %d",
+                 ntasks,
+                 out->parent);
+    return 0;
+}
+
 static void shell_output_type_file_cleanup (struct shell_output_type_file *ofp)
 {
     if (ofp->path)
@@ -542,10 +1230,22 @@ void shell_output_destroy (struct shell_output *out)
                     shell_log_errno ("shell_output_file");
             }
         }
+        if (out->batch && json_array_size (out->batch) > 0) { // leader only
+            if (batch_flush (out, true) < 0)
+                shell_log_errno ("batch_flush");
+        }
+        json_decref (out->batch);
+        flux_watcher_destroy (out->batch_timer);
+        zlistx_destroy (&out->fwd_entries);
+        if (out->fwd_requests)
+            zlist_destroy (&out->fwd_requests);
+        flux_watcher_destroy (out->fwd_prep);
         json_decref (out->output);
         shell_output_type_file_cleanup (&out->stdout_file);
         shell_output_type_file_cleanup (&out->stderr_file);
-        if (out->fds) { // leader only
+        if (out->direct_tasks)
+            zlist_destroy (&out->direct_tasks);
+        if (out->fds) {
             struct shell_output_fd *fdp = zhash_first (out->fds);
             while (fdp) {
                 close (fdp->fd);
@@ -553,22 +1253,12 @@ void shell_output_destroy (struct shell_output *out)
             }
             zhash_destroy (&out->fds);
         }
-        eventlogger_destroy (out->ev);
         free (out);
         errno = saved_errno;
     }
 }
 
 /* check if this output type requires the service to be started */
-static bool output_type_requires_service (int type)
-{
-    if ((type == FLUX_OUTPUT_TYPE_TERM)
-        || (type == FLUX_OUTPUT_TYPE_KVS)
-        || (type == FLUX_OUTPUT_TYPE_FILE))
-        return true;
-    return false;
-}
-
 static int shell_output_parse_type (struct shell_output *out,
                                     const char *typestr,
                                     int *typep)
@@ -586,36 +1276,64 @@ static int shell_output_parse_type (struct shell_output *out,
     return 0;
 }
 
+/* Return a copy of 'path' with all occurrences of 'tmpl' replaced by
+ * 'value'.
+ */
+static char *path_subst (const char *path, const char *tmpl, const char *value)
+{
+    size_t tlen = strlen (tmpl);
+    size_t vlen = strlen (value);
+    size_t len = strlen (path) + 1;
+    const char *p;
+    char *rv;
+    char *q;
+
+    for (p = strstr (path, tmpl); p; p = strstr (p + tlen, tmpl))
+        len += vlen - tlen;
+    if (len > PATH_MAX + 1) {
+        errno = EOVERFLOW;
+        return NULL;
+    }
+    if (!(rv = calloc (1, len)))
+        return NULL;
+    q = rv;
+    while ((p = strstr (path, tmpl))) {
+        memcpy (q, path, p - path);
+        q += p - path;
+        memcpy (q, value, vlen);
+        q += vlen;
+        path = p + tlen;
+    }
+    strcpy (q, path);
+    return rv;
+}
+
 /* handle mustache templates and the similar special cases */
 static char *shell_output_get_path (struct shell_output *out, const char *path)
 {
-    char *rv = NULL;
-    char *ptr;
+    char buf[32];
 
     /* replace {{id}} with jobid */
-    if ((ptr = strstr (path, "{{id}}"))) {
-        char buf[32];
-        int len, buflen, total_len;
-
-        len = strlen (path);
-        buflen = snprintf (buf, sizeof (buf), "%ju",
-                           (uintmax_t)out->shell->info->jobid);
-        /* -6 for {{id}}, +1 for NUL */
-        total_len = len - 6 + buflen + 1;
-        if (total_len > (PATH_MAX + 1)) {
-            errno = EOVERFLOW;
-            return NULL;
-        }
-        if (!(rv = calloc (1, total_len)))
-            return NULL;
-        memcpy (rv, path, ptr - path);
-        memcpy (rv + (ptr - path), buf, buflen);
-        memcpy (rv + (ptr - path) + buflen, ptr + 6, len - (ptr - path) - 6);
-    }
-    else {
-        if (!(rv = strdup (path)))
-            return NULL;
-    }
+    snprintf (buf, sizeof (buf), "%ju", (uintmax_t)out->shell->info->jobid);
+    return path_subst (path, "{{id}}", buf);
+}
+
+/* Expand the per-shell and per-task templates of a direct output path.
+ */
+static char *shell_output_get_direct_path (struct shell_output *out,
+                                           const char *path,
+                                           int taskid)
+{
+    char buf[32];
+    char *tmp;
+    char *rv;
+
+    snprintf (buf, sizeof (buf), "%d", out->shell->info->shell_rank);
+    if (!(tmp = path_subst (path, "{{node}}", buf)))
+        return NULL;
+    snprintf (buf, sizeof (buf), "%d", taskid);
+    rv = path_subst (tmp, "{{taskid}}", buf);
+    free (tmp);
     return rv;
 }
 
@@ -641,14 +1359,19 @@ shell_output_setup_type_file (struct shell_output *out,
         return -1;
 
     if (flux_shell_getopt_unpack (out->shell, "output",
-                                  "{s:{s?:b}}",
-                                  stream, "label", &(ofp->label)) < 0)
+                                  "{s:{s?:b s?:b s?:b}}",
+                                  stream,
+                                  "label", &(ofp->label),
+                                  "direct", &(ofp->direct),
+                                  "append", &(ofp->append)) < 0)
         return -1;
 
     if (ofp_copy) {
         if (!(ofp_copy->path = strdup (ofp->path)))
             return -1;
         ofp_copy->label = ofp->label;
+        ofp_copy->direct = ofp->direct;
+        ofp_copy->append = ofp->append;
     }
 
     return 0;
@@ -677,6 +1400,16 @@ static int shell_output_setup_type (struct shell_output *out,
     return 0;
 }
 
+/* File output with the "direct" option is written by each shell.
+ */
+static void shell_output_check_direct (struct shell_output *out)
+{
+    if (out->stdout_type == FLUX_OUTPUT_TYPE_FILE && out->stdout_file.direct)
+        out->stdout_type = FLUX_OUTPUT_TYPE_DIRECT;
+    if (out->stderr_type == FLUX_OUTPUT_TYPE_FILE && out->stderr_file.direct)
+        out->stderr_type = FLUX_OUTPUT_TYPE_DIRECT;
+}
+
 static int shell_output_check_alternate_output (struct shell_output *out)
 {
     const char *stdout_typestr = NULL;
@@ -735,6 +1468,7 @@ static int shell_output_check_alternate_output (struct shell_output *out)
                 return -1;
         }
     }
+    shell_output_check_direct (out);
     return 0;
 }
 
@@ -793,6 +1527,59 @@ error:
     return -1;
 }
 
+/* Open the file for direct output of task 'taskid' to 'ofp', or return
+ * the already open file if the expanded path was seen before.
+ */
+static struct shell_output_fd *
+shell_output_direct_open (struct shell_output *out,
+                          struct shell_output_type_file *ofp,
+                          int taskid)
+{
+    mode_t mode = S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH;
+    int open_flags = O_CREAT | O_WRONLY;
+    struct shell_output_fd *fdp = NULL;
+    char *path;
+    bool shared;
+    int saved_errno, fd = -1;
+
+    if (!(path = shell_output_get_direct_path (out, ofp->path, taskid)))
+        return NULL;
+    if ((fdp = zhash_lookup (out->fds, path))) {
+        free (path);
+        return fdp;
+    }
+    /* A file shared with other shells must not be truncated, since
+     * another shell may already have written to it.
+     */
+    shared = !strcmp (path, ofp->path) && out->shell->info->shell_size > 1;
+    if (ofp->append || shared)
+        open_flags |= O_APPEND;
+    else
+        open_flags |= O_TRUNC;
+    if ((fd = open (path, open_flags, mode)) < 0) {
+        shell_log_errno ("error opening output file '%s'", path);
+        goto error;
+    }
+    if (!(fdp = shell_output_fd_create (fd)))
+        goto error;
+    fd = -1;
+    if (zhash_insert (out->fds, path, fdp) < 0) {
+        errno = ENOMEM;
+        goto error;
+    }
+    zhash_freefn (out->fds, path, shell_output_fd_destroy);
+    free (path);
+    return fdp;
+error:
+    saved_errno = errno;
+    if (fd >= 0)
+        close (fd);
+    shell_output_fd_destroy (fdp);
+    free (path);
+    errno = saved_errno;
+    return NULL;
+}
+
 /* Write RFC 24 header event to KVS.  Assume:
  * - fixed utf-8 encoding for stdout, stderr
  * - no options
@@ -837,40 +1624,47 @@ error:
     return rc;
 }
 
-static void output_ref (struct eventlogger *ev, void *arg)
-{
-    struct shell_output *out = arg;
-    flux_shell_add_completion_ref (out->shell, "output.txn");
-}
-
-
-static void output_unref (struct eventlogger *ev, void *arg)
-{
-    struct shell_output *out = arg;
-    flux_shell_remove_completion_ref (out->shell, "output.txn");
-}
-
 static int output_eventlogger_start (struct shell_output *out)
 {
     flux_t *h = flux_shell_get_flux (out->shell);
-    struct eventlogger_ops ops = {
-        .busy = output_ref,
-        .idle = output_unref
-    };
 
-    out->batch_timeout = 0.5;
+    out->batch_timeout = batch_timeout_default;
+    out->batch_bytes = batch_bytes_default;
+    out->batch_lines = batch_lines_default;
 
     if (flux_shell_getopt_unpack (out->shell,
                                   "output",
-                                  "{s?F}",
-                                  "batch-timeout", &out->batch_timeout) < 0)
-        return shell_log_errno ("invalid output.batch-timeout option");
+                                  "{s?F s?i s?i}",
+                                  "batch-timeout", &out->batch_timeout,
+                                  "batch-bytes", &out->batch_bytes,
+                                  "batch-lines", &out->batch_lines) < 0)
+        return shell_log_errno ("invalid output.batch-* option");
+    if (out->batch_timeout < 0.
+        || out->batch_bytes < 0
+        || out->batch_lines < 0) {
+        errno = EINVAL;
+        return shell_log_errno ("output.batch-* options must be >= 0");
+    }
 
-    shell_debug ("batch timeout = %.3fs", out->batch_timeout);
+    shell_debug ("batch timeout = %.3fs bytes = %d lines = %d",
+                 out->batch_timeout,
+                 out->batch_bytes,
+                 out->batch_lines);
 
-    out->ev = eventlogger_create (h, out->batch_timeout, &ops, out);
-    if (!out->ev)
-        return shell_log_errno ("eventlogger_create");
+    if (!(out->batch = json_array ())) {
+        errno = ENOMEM;
+        return shell_log_errno ("json_array");
+    }
+    out->batch_timer = flux_timer_watcher_create (flux_get_reactor (h),
+                                                  out->batch_timeout,
+                                                  0.,
+                                                  batch_timer_cb,
+                                                  out);
+    if (!out->batch_timer)
+        return shell_log_errno ("flux_timer_watcher_create");
+
+    if (!(out->ev = shell_eventlogger_get (out->shell->ev)))
+        return shell_log_errno ("shell_eventlogger_get");
     return 0;
 }
 
@@ -895,6 +1689,19 @@ struct shell_output *shell_output_create (flux_shell_t *shell)
 
     if (!(out->pending_writes = zlist_new ()))
         goto error;
+    if (out->stdout_type == FLUX_OUTPUT_TYPE_DIRECT
+        || out->stderr_type == FLUX_OUTPUT_TYPE_DIRECT) {
+        if (!(out->fds = zhash_new ())
+            || !(out->direct_tasks = zlist_new ())) {
+            errno = ENOMEM;
+            goto error;
+        }
+    }
+    if (output_type_requires_service (out->stdout_type)
+        || output_type_requires_service (out->stderr_type)) {
+        if (output_tree_init (out) < 0)
+            goto error;
+    }
     if (shell->info->shell_rank == 0) {
         if (output_type_requires_service (out->stdout_type)
             || output_type_requires_service (out->stderr_type)) {
@@ -916,7 +1723,7 @@ struct shell_output *shell_output_create (flux_shell_t *shell)
         }
         if (out->stdout_type == FLUX_OUTPUT_TYPE_FILE
             || out->stderr_type == FLUX_OUTPUT_TYPE_FILE) {
-            if (!(out->fds = zhash_new ())) {
+            if (!out->fds && !(out->fds = zhash_new ())) {
                 errno = ENOMEM;
                 goto error;
             }
@@ -962,6 +1769,71 @@ static void task_output_cb (struct shell_task *task,
     }
 }
 
+/* Write one line of task output directly to its file.  A labeled line
+ * is written with a single write(2) so that O_APPEND writes from several
+ * shells are not interleaved.
+ */
+static int shell_output_direct_write (struct direct_task *dt,
+                                      int rank,
+                                      const char *data,
+                                      int len)
+{
+    char *buf;
+    int n;
+    int rc;
+
+    if (!dt->label)
+        return shell_output_write_fd (dt->fdp->fd, data, len);
+    if (!(buf = malloc (len + 32)))
+        return -1;
+    n = snprintf (buf, 32, "%d: ", rank);
+    memcpy (buf + n, data, len);
+    rc = shell_output_write_fd (dt->fdp->fd, buf, n + len);
+    free (buf);
+    return rc;
+}
+
+static void task_direct_cb (struct shell_task *task,
+                            const char *stream,
+                            void *arg)
+{
+    struct direct_task *dt = arg;
+    const char *data;
+    int len;
+
+    data = flux_subprocess_getline (task->proc, stream, &len);
+    if (len < 0)
+        shell_log_errno ("read %s task %d", stream, task->rank);
+    else if (len > 0) {
+        if (shell_output_direct_write (dt, task->rank, data, len) < 0)
+            shell_log_errno ("write %s task %d", stream, task->rank);
+    }
+}
+
+static int shell_output_direct_subscribe (struct shell_output *out,
+                                          flux_shell_task_t *task,
+                                          const char *stream,
+                                          struct shell_output_type_file *ofp)
+{
+    struct direct_task *dt;
+
+    if (!(dt = calloc (1, sizeof (*dt))))
+        return -1;
+    if (zlist_append (out->direct_tasks, dt) < 0) {
+        free (dt);
+        errno = ENOMEM;
+        return -1;
+    }
+    zlist_freefn (out->direct_tasks, dt, free, true);
+    if (!(dt->fdp = shell_output_direct_open (out, ofp, task->rank)))
+        return -1;
+    dt->label = ofp->label;
+    return flux_shell_task_channel_subscribe (task,
+                                              stream,
+                                              task_direct_cb,
+                                              dt);
+}
+
 static int shell_output_task_init (flux_plugin_t *p,
                                    const char *topic,
                                    flux_plugin_arg_t *args,
@@ -984,6 +1856,20 @@ static int shell_output_task_init (flux_plugin_t *p,
                                                task_output_cb, out) < 0)
             return -1;
     }
+    if (out->stdout_type == FLUX_OUTPUT_TYPE_DIRECT) {
+        if (shell_output_direct_subscribe (out,
+                                           task,
+                                           "stdout",
+                                           &out->stdout_file) < 0)
+            return -1;
+    }
+    if (out->stderr_type == FLUX_OUTPUT_TYPE_DIRECT) {
+        if (shell_output_direct_subscribe (out,
+                                           task,
+                                           "stderr",
+                                           &out->stderr_file) < 0)
+            return -1;
+    }
 
     return 0;
 }
@@ -22,6 +22,7 @@
 #include <flux/shell.h>
 
 #include "src/common/libutil/iterators.h"
+#include "src/common/libutil/monotime.h"
 
 #include "plugstack.h"
 
@@ -38,14 +39,67 @@ struct plugstack {
     zlistx_t *plugins;  /* Ordered list of loaded plugins                  */
     zhashx_t *names;    /* Hash for lookup of plugins by name              */
     zlistx_t *current;  /* stack holding current plugin in plugstack_call  */
+    zhashx_t *tables;   /* Per-topic dispatch tables, built on first call  */
+    zhashx_t *timing;   /* If set, per plugin/topic callback timing        */
+    int generation;     /* Incremented when the plugin list changes        */
 };
 
+/*  A dispatch table holds the plugins, in stack order, with a handler
+ *   matching one topic. Tables are built on the first plugstack_call()
+ *   of a topic and reused until a plugin is pushed or unloaded, or a
+ *   plugin adds or removes a handler. Tables are reference counted so
+ *   one may be replaced by a reentrant plugstack_call() while in use.
+ */
+struct plugstack_table {
+    int refcount;
+    int generation;     /* plugstack generation at build time              */
+    int handler_gen;    /* sum of plugin handler generations at build time */
+    int count;
+    flux_plugin_t *plugins[];
+};
+
+struct plugstack_timing {
+    char *name;
+    char *topic;
+    int count;
+    double total;       /* milliseconds */
+};
+
+static void table_decref (struct plugstack_table *t)
+{
+    if (t && --t->refcount == 0) {
+        int saved_errno = errno;
+        free (t);
+        errno = saved_errno;
+    }
+}
+
+static void table_destructor (void **item)
+{
+    if (item) {
+        table_decref (*item);
+        *item = NULL;
+    }
+}
+
+static void timing_destructor (void **item)
+{
+    if (item && *item) {
+        struct plugstack_timing *t = *item;
+        free (t->name);
+        free (t->topic);
+        free (t);
+        *item = NULL;
+    }
+}
+
 void plugstack_unload_name (struct plugstack *st, const char *name)
 {
     void *item;
     if ((item = zhashx_lookup (st->names, name))) {
         zlistx_delete (st->plugins, item);
         zhashx_delete (st->names, name);
+        st->generation++;
     }
 }
 
@@ -94,6 +148,7 @@ int plugstack_push (struct plugstack *st, flux_plugin_t *p)
     }
     if (!(item = zlistx_add_end (st->plugins, p)))
         return -1;
+    st->generation++;
 
     /* Override any existing plugin with the same name */
     plugstack_unload_name (st, name);
@@ -109,6 +164,8 @@ void plugstack_destroy (struct plugstack *st)
         int saved_errno = errno;
         zlistx_destroy (&st->plugins);
         zlistx_destroy (&st->current);
+        zhashx_destroy (&st->tables);
+        zhashx_destroy (&st->timing);
         zhashx_destroy (&st->names);
         zhashx_destroy (&st->aux);
         free (st->searchpath);
@@ -130,11 +187,13 @@ struct plugstack * plugstack_create (void)
         || !(st->plugins = zlistx_new ())
         || !(st->current = zlistx_new ())
         || !(st->names = zhashx_new ())
+        || !(st->tables = zhashx_new ())
         || !(st->aux = zhashx_new ())) {
         plugstack_destroy (st);
         return NULL;
     }
     zlistx_set_destructor (st->plugins, (czmq_destructor *) plugin_destroy);
+    zhashx_set_destructor (st->tables, table_destructor);
     return (st);
 }
 
@@ -149,15 +208,87 @@ const char *plugstack_current_name (struct plugstack *st)
     return flux_plugin_get_name (zlistx_first (st->current));
 }
 
-/*  Copy the plugin list, unsetting the destructor so plugins aren't
- *   destroyed on destruction of the list copy.
+/*  Sum of handler generations across all plugins. Since generations
+ *   only increase, a change in the sum for an unchanged plugin list
+ *   means some plugin added or removed a handler.
  */
-static zlistx_t *plugstack_list_dup (struct plugstack *st)
+static int plugstack_handler_gen (struct plugstack *st)
 {
-    zlistx_t *l = zlistx_dup (st->plugins);
-    if (l)
-        zlistx_set_destructor (l, NULL);
-    return l;
+    int gen = 0;
+    flux_plugin_t *p = zlistx_first (st->plugins);
+    while (p) {
+        gen += flux_plugin_get_handler_generation (p);
+        p = zlistx_next (st->plugins);
+    }
+    return gen;
+}
+
+static struct plugstack_table *table_create (struct plugstack *st,
+                                             const char *topic,
+                                             int handler_gen)
+{
+    struct plugstack_table *t;
+    size_t size = zlistx_size (st->plugins) * sizeof (flux_plugin_t *);
+    flux_plugin_t *p;
+
+    if (!(t = calloc (1, sizeof (*t) + size)))
+        return NULL;
+    t->refcount = 1;
+    t->generation = st->generation;
+    t->handler_gen = handler_gen;
+    p = zlistx_first (st->plugins);
+    while (p) {
+        if (flux_plugin_match_handler (p, topic))
+            t->plugins[t->count++] = p;
+        p = zlistx_next (st->plugins);
+    }
+    return t;
+}
+
+/*  Return the dispatch table for 'topic' with a reference held for the
+ *   caller, rebuilding it if the plugin stack has changed.
+ */
+static struct plugstack_table *table_get (struct plugstack *st,
+                                          const char *topic)
+{
+    int handler_gen = plugstack_handler_gen (st);
+    struct plugstack_table *t = zhashx_lookup (st->tables, topic);
+
+    if (!t
+        || t->generation != st->generation
+        || t->handler_gen != handler_gen) {
+        if (!(t = table_create (st, topic, handler_gen)))
+            return NULL;
+        zhashx_update (st->tables, topic, t);
+    }
+    t->refcount++;
+    return t;
+}
+
+static void timing_update (struct plugstack *st,
+                           flux_plugin_t *p,
+                           const char *topic,
+                           double ms)
+{
+    struct plugstack_timing *t;
+    const char *name = flux_plugin_get_name (p);
+    char *key;
+
+    if (!name || asprintf (&key, "%s/%s", name, topic) < 0)
+        return;
+    if (!(t = zhashx_lookup (st->timing, key))) {
+        if (!(t = calloc (1, sizeof (*t)))
+            || !(t->name = strdup (name))
+            || !(t->topic = strdup (topic))
+            || zhashx_insert (st->timing, key, t) < 0) {
+            timing_destructor ((void **) &t);
+            goto out;
+        }
+    }
+    t->count++;
+    t->total += ms;
+out:
+    free (key);
 }
 
 int plugstack_call (struct plugstack *st,
@@ -165,16 +296,20 @@ int plugstack_call (struct plugstack *st,
                     flux_plugin_arg_t *args)
 {
     int rc = 0;
-    flux_plugin_t *p = NULL;
+    int i;
+    struct plugstack_table *t;
 
-    /* Duplicate list to make plugstack_call() reentrant.
-     */
-    zlistx_t *l = plugstack_list_dup (st);
-    if (!l)
+    if (!(t = table_get (st, name)))
         return -1;
 
-    p = zlistx_first (l);
-    while (p) {
+    for (i = 0; i < t->count; i++) {
+        flux_plugin_t *p = t->plugins[i];
+        bool timing = (st->timing != NULL);
+        struct timespec t0;
+
+        if (timing)
+            monotime (&t0);
+
         /*  Push plugin onto the current plugin stack */
         void * item = zlistx_add_start (st->current, p);
         if (flux_plugin_call (p, name, args) < 0) {
@@ -185,12 +320,64 @@ int plugstack_call (struct plugstack *st,
         }
         /* Pop plugin from the current plugin stack */
         zlistx_detach (st->current, item);
-        p = zlistx_next (l);
+
+        if (timing)
+            timing_update (st, p, name, monotime_since (t0));
     }
-    zlistx_destroy (&l);
+    table_decref (t);
     return rc;
 }
 
+int plugstack_has_handler (struct plugstack *st, const char *name)
+{
+    struct plugstack_table *t;
+    int count;
+
+    if (!st || !name) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!(t = table_get (st, name)))
+        return -1;
+    count = t->count;
+    table_decref (t);
+    return count > 0;
+}
+
+int plugstack_timing_enable (struct plugstack *st)
+{
+    if (!st) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!st->timing) {
+        if (!(st->timing = zhashx_new ()))
+            return -1;
+        zhashx_set_destructor (st->timing, timing_destructor);
+    }
+    return 0;
+}
+
+int plugstack_timing_foreach (struct plugstack *st,
+                              plugstack_timing_f fn,
+                              void *arg)
+{
+    struct plugstack_timing *t;
+
+    if (!st || !fn) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!st->timing)
+        return 0;
+    t = zhashx_first (st->timing);
+    while (t) {
+        (*fn) (t->name, t->topic, t->count, t->total, arg);
+        t = zhashx_next (st->timing);
+    }
+    return 0;
+}
+
 static int plugin_aux_from_zhashx (flux_plugin_t *p, zhashx_t *aux)
 {
     const char *key;
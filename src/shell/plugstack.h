@@ -61,6 +61,29 @@ int plugstack_call (struct plugstack *st,
                     const char *name,
                     flux_plugin_arg_t *args);
 
+/*  Return 1 if any plugin in the stack has a handler matching topic
+ *   'name', 0 if none do, or -1 on error. Callers may use this to skip
+ *   building plugin args for a topic nobody is listening on.
+ */
+int plugstack_has_handler (struct plugstack *st, const char *name);
+
+/*  Start collecting per-plugin callback time in plugstack_call().
+ */
+int plugstack_timing_enable (struct plugstack *st);
+
+typedef void (*plugstack_timing_f) (const char *name,
+                                    const char *topic,
+                                    int count,
+                                    double total_ms,
+                                    void *arg);
+
+/*  Call 'fn' once per plugin name and topic pair with the number of
+ *   callbacks made and total time spent in them since timing was enabled.
+ */
+int plugstack_timing_foreach (struct plugstack *st,
+                              plugstack_timing_f fn,
+                              void *arg);
+
 /*  Return currently active plugin name, or NULL if not in plugstack
  */
 const char * plugstack_current_name (struct plugstack *st);
@@ -42,10 +42,27 @@
  * distributes KVS data that was "put" so that it is available to "get".
  * A local hash captures key-value pairs as they are put.  If the entire
  * job runs under one shell, the barrier is a no-op, and the gets are
- * serviced only from the cache.  Otherwise, the barrier dumps the hash
+ * serviced only from the cache.  Otherwise, by default, the barrier is
+ * an allgather of the keys put since the last barrier over a k-ary tree
+ * of shells (see pmi_exchange.c), after which every shell holds all keys
+ * in its cache and gets are answered without any messages.
+ *
+ * With the pmi.kvs=native shell option, the barrier instead dumps the hash
  * into a Flux KVS txn and commits it with a flux_kvs_fence(), using
  * the number of shells as "nprocs".  Gets are serviced from the cache,
- * with fall-through to a flux_kvs_lookup().
+ * with fall-through to a flux_kvs_lookup().  Fetched values are added to
+ * the cache, concurrent gets of one key from several local tasks share a
+ * single lookup, and keys found missing are remembered until the next
+ * barrier, so each shell looks up each key at most once per cycle.
+ * The pmi.exchange.k option
+ * sets the fanout of the exchange tree (default 2).
+ *
+ * After each barrier, the local hash is also written to a file named by
+ * FLUX_PMI_KVSSEG in the task environment (see libpmi/kvsseg.h).  The
+ * flux PMI client library maps it and answers gets from it directly, so
+ * local tasks need not send a get request per key.  Keys not found there
+ * fall back to the protocol as usual.  The pmi.kvsseg=0 shell option
+ * disables the segment.
  *
  * If shell->verbose is true (shell --verbose flag was provided), the
  * protocol engine emits client and server telemetry to stderr, and
@@ -57,7 +74,7 @@
  * - 64-bit Flux job id's are assigned to integer-typed PMI appnum
  * - PMI publish, unpublish, lookup, spawn are not implemented
  * - Although multiple cycles of put / barrier / get are supported, the
- *   the barrier rewrites data from previous cycles to the Flux KVS.
+ *   the native barrier rewrites data from previous cycles to the Flux KVS.
  * - PMI_Abort() is implemented as log message + exit in the client code.
  *   It does not reach this module.
  * - Teardown of the subprocess channel is deferred until task completion,
@@ -75,19 +92,30 @@
 
 #include "src/common/libpmi/simple_server.h"
 #include "src/common/libpmi/clique.h"
+#include "src/common/libpmi/kvsseg.h"
 
 #include "builtins.h"
 #include "internal.h"
 #include "task.h"
+#include "pmi_exchange.h"
 
 #define FQ_KVS_KEY_MAX (SIMPLE_KVS_KEY_MAX + 128)
 
+static const int default_exchange_k = 2;
+
 struct shell_pmi {
     flux_shell_t *shell;
     struct pmi_simple_server *server;
     zhashx_t *kvs;
     zhashx_t *locals;
+    zhashx_t *fetched;  // keys cached from KVS lookups (native KVS)
+    zhashx_t *missing;  // keys not found in the KVS this cycle
+    zhashx_t *lookups;  // key => zlist of clients awaiting a lookup
+    struct pmi_exchange *exchange;
+    json_t *puts;   // keys put since the last exchange
     int cycle;      // count cycles of put / barrier / get
+    char *kvsseg;   // path of KVS segment file, if enabled
+    unsigned int barriers;
 };
 
 static void shell_pmi_abort (void *arg,
@@ -110,6 +138,17 @@ static int shell_pmi_kvs_put (void *arg,
     struct shell_pmi *pmi = arg;
 
     zhashx_update (pmi->kvs, key, (char *)val);
+    zhashx_delete (pmi->fetched, key);
+    zhashx_delete (pmi->missing, key);
+    if (pmi->puts) {
+        json_t *o;
+        if (!(o = json_string (val))
+            || json_object_set_new (pmi->puts, key, o) < 0) {
+            json_decref (o);
+            shell_log_error ("error saving PMI key %s for exchange", key);
+            return -1;
+        }
+    }
     return 0;
 }
 
@@ -121,19 +160,43 @@ static void pmi_kvs_put_local (struct shell_pmi *pmi,
     zhashx_update (pmi->locals, key, (void *) 0x1);
 }
 
-/* Handle kvs lookup response.
+/* Handle kvs lookup response: cache the result, then answer every
+ * local client that asked for the key while the lookup was in flight.
  */
 static void kvs_lookup_continuation (flux_future_t *f, void *arg)
 {
     struct shell_pmi *pmi = arg;
-    void *cli = flux_future_aux_get (f, "flux::shell_pmi");
+    const char *key = flux_future_aux_get (f, "flux::shell_pmi");
+    zlist_t *clients;
     const char *val = NULL;
+    void *cli;
 
-    flux_kvs_lookup_get (f, &val); // val remains NULL on failure
-    pmi_simple_server_kvs_get_complete (pmi->server, cli, val);
+    if (flux_kvs_lookup_get (f, &val) < 0) { // val remains NULL on failure
+        if (errno == ENOENT)
+            zhashx_update (pmi->missing, key, (void *) 0x1);
+    }
+    else {
+        zhashx_update (pmi->kvs, key, (char *)val);
+        zhashx_update (pmi->fetched, key, (void *) 0x1);
+    }
+    if ((clients = zhashx_lookup (pmi->lookups, key))) {
+        while ((cli = zlist_pop (clients)))
+            pmi_simple_server_kvs_get_complete (pmi->server, cli, val);
+        zhashx_delete (pmi->lookups, key);
+    }
     flux_future_destroy (f);
 }
 
+// zhashx_destructor_fn footprint
+static void lookup_clients_destructor (void **item)
+{
+    if (item) {
+        zlist_t *clients = *item;
+        zlist_destroy (&clients);
+        *item = NULL;
+    }
+}
+
 /* Construct a PMI key in job's guest namespace.
  * Put it in a subdir named "pmi".
  */
@@ -152,6 +215,8 @@ static int shell_pmi_kvs_key (char *buf,
 /* Lookup a key: first try the local hash.   If that fails and the
  * job spans multiple shells, do a KVS lookup in the job's private
  * KVS namespace and handle the response in kvs_lookup_continuation().
+ * After an exchange, the local hash holds all keys, so there is no
+ * fall-through.
  */
 static int shell_pmi_kvs_get (void *arg,
                               void *cli,
@@ -166,9 +231,20 @@ static int shell_pmi_kvs_get (void *arg,
         pmi_simple_server_kvs_get_complete (pmi->server, cli, val);
         return 0;
     }
-    if (pmi->shell->info->shell_size > 1) {
+    if (pmi->shell->info->shell_size > 1 && !pmi->exchange) {
         char nkey[FQ_KVS_KEY_MAX];
         flux_future_t *f = NULL;
+        zlist_t *clients;
+
+        if (zhashx_lookup (pmi->missing, key))
+            goto out;
+        if ((clients = zhashx_lookup (pmi->lookups, key))) {
+            if (zlist_append (clients, cli) < 0) {
+                shell_log_error ("out of memory queuing PMI get");
+                goto out;
+            }
+            return 0; // response deferred until lookup completes
+        }
 
         if (shell_pmi_kvs_key (nkey,
                                sizeof (nkey),
@@ -181,13 +257,22 @@ static int shell_pmi_kvs_get (void *arg,
             shell_log_errno ("flux_kvs_lookup");
             goto out;
         }
-        if (flux_future_aux_set (f, "flux::shell_pmi", cli, NULL) < 0) {
+        if (flux_future_aux_set (f, "flux::shell_pmi", strdup (key), free) < 0
+            || !flux_future_aux_get (f, "flux::shell_pmi")) {
             shell_log_errno ("flux_future_aux_set");
             flux_future_destroy (f);
             goto out;
         }
+        if (!(clients = zlist_new ()) || zlist_append (clients, cli) < 0) {
+            shell_log_error ("out of memory queuing PMI get");
+            zlist_destroy (&clients);
+            flux_future_destroy (f);
+            goto out;
+        }
+        zhashx_update (pmi->lookups, key, clients);
         if (flux_future_then (f, -1., kvs_lookup_continuation, pmi) < 0) {
             shell_log_errno ("flux_future_then");
+            zhashx_delete (pmi->lookups, key);
             flux_future_destroy (f);
             goto out;
         }
@@ -197,16 +282,98 @@ out:
     return -1; // cause PMI_KVS_Get() to fail with INVALID_KEY
 }
 
+/* Write the local hash to the KVS segment, tagged with the number of
+ * barriers completed so far.  A failure only disables the fast path, since
+ * clients fall back to get requests if the segment is stale.
+ */
+static void kvsseg_update (struct shell_pmi *pmi)
+{
+    const char **keys = NULL;
+    const char **vals = NULL;
+    size_t count = zhashx_size (pmi->kvs);
+    const char *val;
+    int i = 0;
+
+    if (!(keys = calloc (count + 1, sizeof (*keys)))
+        || !(vals = calloc (count + 1, sizeof (*vals))))
+        goto error;
+    val = zhashx_first (pmi->kvs);
+    while (val) {
+        keys[i] = zhashx_cursor (pmi->kvs);
+        vals[i++] = val;
+        val = zhashx_next (pmi->kvs);
+    }
+    if (pmi_kvsseg_write (pmi->kvsseg, pmi->barriers, i, keys, vals) < 0)
+        goto error;
+    free (keys);
+    free (vals);
+    return;
+error:
+    shell_log_errno ("error writing PMI KVS segment %s", pmi->kvsseg);
+    free (keys);
+    free (vals);
+}
+
+static void shell_pmi_barrier_complete (struct shell_pmi *pmi, int rc)
+{
+    if (rc == 0) {
+        pmi->barriers++;
+        if (pmi->kvsseg)
+            kvsseg_update (pmi);
+    }
+    pmi_simple_server_barrier_complete (pmi->server, rc);
+}
+
 static void kvs_fence_continuation (flux_future_t *f, void *arg)
 {
     struct shell_pmi *pmi = arg;
     int rc;
 
     rc = flux_future_get (f, NULL);
-    pmi_simple_server_barrier_complete (pmi->server, rc);
+    shell_pmi_barrier_complete (pmi, rc);
     flux_future_destroy (f);
 }
 
+static void exchange_cb (struct pmi_exchange *pex, void *arg)
+{
+    struct shell_pmi *pmi = arg;
+    const char *key;
+    json_t *val;
+    int rc = -1;
+
+    if (pmi_exchange_has_error (pex))
+        goto out;
+    json_object_foreach (pmi_exchange_get_dict (pex), key, val) {
+        const char *s = json_string_value (val);
+        if (!s) {
+            shell_log_error ("pmi-exchange: %s has non-string value", key);
+            goto out;
+        }
+        zhashx_update (pmi->kvs, key, (char *)s);
+    }
+    rc = 0;
+out:
+    shell_pmi_barrier_complete (pmi, rc);
+}
+
+static int shell_pmi_barrier_exchange (struct shell_pmi *pmi)
+{
+    json_t *puts = pmi->puts;
+
+    if (!(pmi->puts = json_object ())) {
+        pmi->puts = puts;
+        shell_log_error ("error creating PMI exchange dictionary");
+        return -1;
+    }
+    if (pmi_exchange (pmi->exchange, puts, exchange_cb, pmi) < 0) {
+        shell_log_errno ("pmi_exchange");
+        json_decref (puts);
+        return -1;
+    }
+    json_decref (puts);
+    return 0;
+}
+
 static int shell_pmi_barrier_enter (void *arg)
 {
     struct shell_pmi *pmi = arg;
@@ -219,9 +386,14 @@ static int shell_pmi_barrier_enter (void *arg)
     char nkey[FQ_KVS_KEY_MAX];
 
     if (nprocs == 1) { // all local: no further sync needed
-        pmi_simple_server_barrier_complete (pmi->server, 0);
+        shell_pmi_barrier_complete (pmi, 0);
         return 0;
     }
+    if (pmi->exchange)
+        return shell_pmi_barrier_exchange (pmi);
+    /* Keys may be put by other shells in this cycle.
+     */
+    zhashx_purge (pmi->missing);
     snprintf (name, sizeof (name), "pmi.%ju.%d",
              (uintmax_t)pmi->shell->jobid,
              pmi->cycle++);
@@ -235,9 +407,11 @@ static int shell_pmi_barrier_enter (void *arg)
         /* Special case:
          * Keys in pmi->locals are not added to the KVS transaction
          * because they were locally generated and need not be
-         * shared with the other shells.
+         * shared with the other shells.  Keys in pmi->fetched came
+         * from the KVS in the first place.
          */
-        if (zhashx_lookup (pmi->locals, key)) {
+        if (zhashx_lookup (pmi->locals, key)
+            || zhashx_lookup (pmi->fetched, key)) {
             val = zhashx_next (pmi->kvs);
             continue;
         }
@@ -398,8 +572,17 @@ static void pmi_destroy (struct shell_pmi *pmi)
     if (pmi) {
         int saved_errno = errno;
         pmi_simple_server_destroy (pmi->server);
+        pmi_exchange_destroy (pmi->exchange);
+        json_decref (pmi->puts);
         zhashx_destroy (&pmi->kvs);
         zhashx_destroy (&pmi->locals);
+        zhashx_destroy (&pmi->fetched);
+        zhashx_destroy (&pmi->missing);
+        zhashx_destroy (&pmi->lookups);
+        if (pmi->kvsseg) {
+            (void)unlink (pmi->kvsseg);
+            free (pmi->kvsseg);
+        }
         free (pmi);
         errno = saved_errno;
     }
@@ -433,6 +616,85 @@ static struct pmi_simple_ops shell_pmi_ops = {
 };
 
 
+/* Set up the tree exchange unless pmi.kvs=native is requested, or the
+ * job runs under one shell and the barrier is a no-op anyway.
+ */
+static int shell_pmi_init_exchange (struct shell_pmi *pmi)
+{
+    const char *kvs = "exchange";
+    int k = default_exchange_k;
+
+    if (flux_shell_getopt_unpack (pmi->shell,
+                                  "pmi",
+                                  "{s?s s?{s?i}}",
+                                  "kvs", &kvs,
+                                  "exchange",
+                                    "k", &k) < 0) {
+        shell_log_error ("error parsing pmi shell option");
+        return -1;
+    }
+    if (!strcmp (kvs, "native"))
+        return 0;
+    if (strcmp (kvs, "exchange") != 0) {
+        shell_log_error ("pmi.kvs must be exchange or native");
+        errno = EINVAL;
+        return -1;
+    }
+    if (k < 1) {
+        shell_log_error ("pmi.exchange.k must be >= 1");
+        errno = EINVAL;
+        return -1;
+    }
+    if (pmi->shell->info->shell_size == 1)
+        return 0;
+    if (!(pmi->puts = json_object ())) {
+        errno = ENOMEM;
+        return -1;
+    }
+    if (!(pmi->exchange = pmi_exchange_create (pmi->shell, k))) {
+        shell_log_errno ("pmi_exchange_create");
+        return -1;
+    }
+    shell_debug ("pmi: using tree exchange with k=%d", k);
+    return 0;
+}
+
+/* Create the KVS segment file unless pmi.kvsseg=0 is requested.
+ * The file is replaced, not rewritten, on each update, so clients never
+ * see a partially written segment.
+ */
+static int shell_pmi_init_kvsseg (struct shell_pmi *pmi)
+{
+    const char *tmpdir = getenv ("TMPDIR");
+    int kvsseg = 1;
+    int fd;
+
+    if (flux_shell_getopt_unpack (pmi->shell,
+                                  "pmi",
+                                  "{s?i}",
+                                  "kvsseg", &kvsseg) < 0) {
+        shell_log_error ("error parsing pmi.kvsseg shell option");
+        return -1;
+    }
+    if (!kvsseg)
+        return 0;
+    if (asprintf (&pmi->kvsseg, "%s/flux-pmi-%ju-%d-XXXXXX",
+                  tmpdir ? tmpdir : "/tmp",
+                  (uintmax_t)pmi->shell->jobid,
+                  pmi->shell->info->shell_rank) < 0) {
+        pmi->kvsseg = NULL;
+        return -1;
+    }
+    if ((fd = mkstemp (pmi->kvsseg)) < 0) {
+        shell_log_errno ("mkstemp %s", pmi->kvsseg);
+        free (pmi->kvsseg);
+        pmi->kvsseg = NULL;
+        return -1;
+    }
+    close (fd);
+    return 0;
+}
+
 static struct shell_pmi *pmi_create (flux_shell_t *shell)
 {
     struct shell_pmi *pmi;
@@ -463,14 +725,22 @@ static struct shell_pmi *pmi_create (flux_shell_t *shell)
                                                   pmi)))
         goto error;
     if (!(pmi->kvs = zhashx_new ())
-        || !(pmi->locals = zhashx_new ())) {
+        || !(pmi->locals = zhashx_new ())
+        || !(pmi->fetched = zhashx_new ())
+        || !(pmi->missing = zhashx_new ())
+        || !(pmi->lookups = zhashx_new ())) {
         errno = ENOMEM;
         goto error;
     }
+    zhashx_set_destructor (pmi->lookups, lookup_clients_destructor);
     zhashx_set_destructor (pmi->kvs, kvs_value_destructor);
     zhashx_set_duplicator (pmi->kvs, kvs_value_duplicator);
     if (init_clique (pmi) < 0)
         goto error;
+    if (shell_pmi_init_exchange (pmi) < 0)
+        goto error;
+    if (shell_pmi_init_kvsseg (pmi) < 0)
+        goto error;
     if (!shell->standalone) {
         if (set_flux_instance_level (pmi) < 0)
             goto error;
@@ -519,6 +789,12 @@ static int shell_pmi_task_init (flux_plugin_t *p,
         return -1;
     if (flux_cmd_setenvf (cmd, 1, "PMI_SIZE", "%d", task->size) < 0)
         return -1;
+    if (pmi->kvsseg) {
+        if (flux_cmd_setenvf (cmd, 1, "FLUX_PMI_KVSSEG", "%s", pmi->kvsseg) < 0)
+            return -1;
+    }
+    else
+        flux_cmd_unsetenv (cmd, "FLUX_PMI_KVSSEG");
     if (flux_shell_task_channel_subscribe (task, "PMI_FD", pmi_fd_cb, pmi) < 0)
         return -1;
     return 0;
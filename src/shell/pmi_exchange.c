@@ -0,0 +1,255 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* pmi_exchange.c - allgather of PMI KVS dictionaries over a tree of shells
+ *
+ * Shells are organized as a k-ary tree rooted at shell rank 0.  Each shell
+ * waits for its own contribution and a "pmi-exchange" request from each
+ * of its children, merges them, and sends the result to its parent in
+ * one request.  The root then holds the complete dictionary, and sends it
+ * back down the tree in the responses to the held requests.
+ *
+ * A child cannot enter the next exchange before it receives a response to
+ * its request for the current one, so requests never get ahead of the
+ * exchange the parent is working on.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <errno.h>
+#include <czmq.h>
+#include <jansson.h>
+#include <flux/core.h>
+#include <flux/shell.h>
+
+#include "src/common/libutil/kary.h"
+
+#include "internal.h"
+#include "info.h"
+#include "pmi_exchange.h"
+
+struct pmi_exchange {
+    flux_shell_t *shell;
+    int k;
+    int rank;
+    int child_count;
+    zlist_t *requests;      // held requests from children
+    json_t *dict;           // merged dictionary for the current exchange
+    bool local_in;          // this shell has contributed
+    flux_future_t *f;       // request to the parent
+    int errnum;
+    pmi_exchange_f cb;
+    void *cb_arg;
+};
+
+bool pmi_exchange_has_error (struct pmi_exchange *pex)
+{
+    return pex->errnum != 0;
+}
+
+json_t *pmi_exchange_get_dict (struct pmi_exchange *pex)
+{
+    return pex->dict;
+}
+
+static void exchange_reset (struct pmi_exchange *pex)
+{
+    json_decref (pex->dict);
+    pex->dict = NULL;
+    flux_future_destroy (pex->f);
+    pex->f = NULL;
+    pex->local_in = false;
+    pex->errnum = 0;
+    pex->cb = NULL;
+    pex->cb_arg = NULL;
+}
+
+/* Answer the children, notify the caller, and get ready for the next
+ * exchange.
+ */
+static void exchange_complete (struct pmi_exchange *pex, int errnum)
+{
+    flux_t *h = flux_shell_get_flux (pex->shell);
+    const flux_msg_t *msg;
+
+    while ((msg = zlist_pop (pex->requests))) {
+        int rc;
+        if (errnum)
+            rc = flux_respond_error (h, msg, errnum, NULL);
+        else
+            rc = flux_respond_pack (h, msg, "{s:O}", "dict", pex->dict);
+        if (rc < 0)
+            shell_log_errno ("error responding to pmi-exchange request");
+        flux_msg_decref (msg);
+    }
+    pex->errnum = errnum;
+    if (pex->cb)
+        pex->cb (pex, pex->cb_arg);
+    exchange_reset (pex);
+}
+
+static void parent_continuation (flux_future_t *f, void *arg)
+{
+    struct pmi_exchange *pex = arg;
+    json_t *dict;
+
+    if (flux_rpc_get_unpack (f, "{s:o}", "dict", &dict) < 0) {
+        shell_log_errno ("pmi-exchange");
+        exchange_complete (pex, errno);
+        return;
+    }
+    json_decref (pex->dict);
+    pex->dict = json_incref (dict);
+    exchange_complete (pex, 0);
+}
+
+/* Once this shell and all of its children have contributed, either
+ * complete the exchange (root) or pass the merged dictionary up.
+ */
+static void exchange_progress (struct pmi_exchange *pex)
+{
+    if (!pex->local_in || zlist_size (pex->requests) < pex->child_count)
+        return;
+    if (pex->rank == 0) {
+        exchange_complete (pex, 0);
+        return;
+    }
+    if (!(pex->f = flux_shell_rpc_pack (pex->shell,
+                                        "pmi-exchange",
+                                        kary_parentof (pex->k, pex->rank),
+                                        0,
+                                        "{s:O}",
+                                        "dict", pex->dict))
+        || flux_future_then (pex->f, -1., parent_continuation, pex) < 0) {
+        shell_log_errno ("error sending pmi-exchange request");
+        exchange_complete (pex, errno);
+    }
+}
+
+static int exchange_merge (struct pmi_exchange *pex, json_t *dict)
+{
+    if (!json_is_object (dict)) {
+        errno = EPROTO;
+        return -1;
+    }
+    if (!pex->dict && !(pex->dict = json_object ()))
+        goto nomem;
+    if (json_object_update (pex->dict, dict) < 0)
+        goto nomem;
+    return 0;
+nomem:
+    errno = ENOMEM;
+    return -1;
+}
+
+static void exchange_request_cb (flux_t *h,
+                                 flux_msg_handler_t *mh,
+                                 const flux_msg_t *msg,
+                                 void *arg)
+{
+    struct pmi_exchange *pex = arg;
+    json_t *dict;
+
+    if (flux_request_unpack (msg, NULL, "{s:o}", "dict", &dict) < 0)
+        goto error;
+    if (zlist_size (pex->requests) >= pex->child_count) {
+        errno = EPROTO;
+        goto error;
+    }
+    if (exchange_merge (pex, dict) < 0)
+        goto error;
+    if (zlist_append (pex->requests, (void *)flux_msg_incref (msg)) < 0) {
+        flux_msg_decref (msg);
+        errno = ENOMEM;
+        goto error;
+    }
+    exchange_progress (pex);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        shell_log_errno ("error responding to pmi-exchange request");
+}
+
+int pmi_exchange (struct pmi_exchange *pex,
+                  json_t *dict,
+                  pmi_exchange_f cb,
+                  void *arg)
+{
+    if (!pex || !cb) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (pex->local_in) {
+        errno = EBUSY;
+        return -1;
+    }
+    if (exchange_merge (pex, dict) < 0)
+        return -1;
+    pex->local_in = true;
+    pex->cb = cb;
+    pex->cb_arg = arg;
+    exchange_progress (pex);
+    return 0;
+}
+
+void pmi_exchange_destroy (struct pmi_exchange *pex)
+{
+    if (pex) {
+        int saved_errno = errno;
+        const flux_msg_t *msg;
+        if (pex->requests) {
+            while ((msg = zlist_pop (pex->requests)))
+                flux_msg_decref (msg);
+            zlist_destroy (&pex->requests);
+        }
+        json_decref (pex->dict);
+        flux_future_destroy (pex->f);
+        free (pex);
+        errno = saved_errno;
+    }
+}
+
+struct pmi_exchange *pmi_exchange_create (flux_shell_t *shell, int k)
+{
+    struct pmi_exchange *pex;
+    int size = shell->info->shell_size;
+
+    if (k < 1) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(pex = calloc (1, sizeof (*pex))))
+        return NULL;
+    pex->shell = shell;
+    pex->k = k;
+    pex->rank = shell->info->shell_rank;
+    while (pex->child_count < k
+           && kary_childof (k, size, pex->rank, pex->child_count) != KARY_NONE)
+        pex->child_count++;
+    if (!(pex->requests = zlist_new ())) {
+        errno = ENOMEM;
+        goto error;
+    }
+    if (flux_shell_service_register (shell,
+                                     "pmi-exchange",
+                                     exchange_request_cb,
+                                     pex) < 0)
+        goto error;
+    return pex;
+error:
+    pmi_exchange_destroy (pex);
+    return NULL;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,47 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _SHELL_PMI_EXCHANGE_H
+#define _SHELL_PMI_EXCHANGE_H
+
+#include <stdbool.h>
+#include <jansson.h>
+#include <flux/shell.h>
+
+/* Allgather of PMI key-value dictionaries over a k-ary tree of shells.
+ * Each shell contributes a JSON object of string values.  Once every
+ * shell has contributed, all shells hold the union of the objects.
+ */
+
+struct pmi_exchange;
+
+typedef void (*pmi_exchange_f)(struct pmi_exchange *pex, void *arg);
+
+struct pmi_exchange *pmi_exchange_create (flux_shell_t *shell, int k);
+void pmi_exchange_destroy (struct pmi_exchange *pex);
+
+/* Contribute 'dict' to an exchange.  'cb' is called once the exchange
+ * has completed or failed.  Only one exchange may be in progress at a time.
+ */
+int pmi_exchange (struct pmi_exchange *pex,
+                  json_t *dict,
+                  pmi_exchange_f cb,
+                  void *arg);
+
+/* Accessors valid only during the pmi_exchange_f callback.
+ */
+bool pmi_exchange_has_error (struct pmi_exchange *pex);
+json_t *pmi_exchange_get_dict (struct pmi_exchange *pex);
+
+#endif /* !_SHELL_PMI_EXCHANGE_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -10,6 +10,11 @@
 
 /* Load and run shell rc script
  *
+ * If the initrc-cache shell option is set, compiled rc chunks are cached
+ * in a private directory under TMPDIR, so that other shells and later
+ * jobs on the node can skip parsing the Lua source.  Each cache entry
+ * starts with a header recording the source path, mtime and size, and is
+ * only used if they still match the source file.
  */
 
 #if HAVE_CONFIG_H
@@ -17,6 +22,12 @@
 #endif
 #include <libgen.h>
 #include <glob.h>
+#include <stdint.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 #include <czmq.h>
 #include <lua.h>
 #include <lauxlib.h>
@@ -26,6 +37,7 @@
 
 #include "src/bindings/lua/jansson-lua.h"
 #include "src/bindings/lua/lutil.h"
+#include "src/common/libutil/read_all.h"
 #include "internal.h"
 #include "info.h"
 
@@ -55,6 +67,9 @@ static flux_shell_t *rc_shell = NULL;
  */
 static zlistx_t *file_stack = NULL;
 
+/*  Directory for compiled rc chunks, NULL if caching is disabled
+ */
+static char *cache_dir = NULL;
 
 
 /* Push a filename onto the current stack of Lua files
@@ -315,6 +330,145 @@ static int l_plugin_load (lua_State *L)
     return 0;
 }
 
+/*  Use the cache directory only if it is a directory owned by us
+ *   and inaccessible to others, since its contents are executed.
+ */
+static int cache_init (void)
+{
+    const char *tmpdir = getenv ("TMPDIR");
+    struct stat sb;
+
+    if (asprintf (&cache_dir, "%s/flux-shell-rc-%ju",
+                  tmpdir ? tmpdir : "/tmp",
+                  (uintmax_t) getuid ()) < 0) {
+        cache_dir = NULL;
+        return -1;
+    }
+    if ((mkdir (cache_dir, 0700) < 0 && errno != EEXIST)
+        || lstat (cache_dir, &sb) < 0
+        || !S_ISDIR (sb.st_mode)
+        || sb.st_uid != getuid ()
+        || (sb.st_mode & 077) != 0) {
+        shell_debug ("rc cache %s is unusable, disabling", cache_dir);
+        free (cache_dir);
+        cache_dir = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+/*  Cache entries are named by a hash of the source path.  A collision
+ *   only costs a recompile, since the header is checked on load.
+ */
+static char *cache_path (const char *rcfile)
+{
+    uint64_t hash = 14695981039346656037ULL; // FNV-1a
+    const char *p;
+    char *path;
+
+    for (p = rcfile; *p != '\0'; p++) {
+        hash ^= (unsigned char)*p;
+        hash *= 1099511628211ULL;
+    }
+    if (asprintf (&path, "%s/%016jx.luac", cache_dir, (uintmax_t) hash) < 0)
+        return NULL;
+    return path;
+}
+
+static char *cache_header (const char *rcfile, struct stat *sb)
+{
+    char *hdr;
+    if (asprintf (&hdr, "%s\n%ju %ju\n",
+                  rcfile,
+                  (uintmax_t) sb->st_mtime,
+                  (uintmax_t) sb->st_size) < 0)
+        return NULL;
+    return hdr;
+}
+
+/*  Load a cached chunk for rcfile onto the stack.
+ *   Returns 0 on success, -1 if there is no usable cache entry.
+ */
+static int cache_load (lua_State *L, const char *rcfile, struct stat *sb)
+{
+    char *path = NULL;
+    char *hdr = NULL;
+    void *buf = NULL;
+    ssize_t len;
+    size_t hdrlen;
+    char name[PATH_MAX + 2];
+    int fd = -1;
+    int rc = -1;
+
+    if (!(path = cache_path (rcfile))
+        || !(hdr = cache_header (rcfile, sb))
+        || (fd = open (path, O_RDONLY)) < 0
+        || (len = read_all (fd, &buf)) < 0)
+        goto out;
+    hdrlen = strlen (hdr);
+    if (len <= hdrlen || memcmp (buf, hdr, hdrlen) != 0)
+        goto out;
+    (void)snprintf (name, sizeof (name), "@%s", rcfile);
+    if (luaL_loadbuffer (L, (char *)buf + hdrlen, len - hdrlen, name) != 0) {
+        lua_pop (L, 1);
+        goto out;
+    }
+    rc = 0;
+out:
+    if (fd >= 0)
+        close (fd);
+    free (buf);
+    free (hdr);
+    free (path);
+    return rc;
+}
+
+static int cache_writer (lua_State *L, const void *p, size_t sz, void *ud)
+{
+    int *fdp = ud;
+    return write_all (*fdp, p, sz) < 0 ? 1 : 0;
+}
+
+/*  Save the compiled chunk on top of the stack for rcfile.
+ *   Errors are not fatal, they just mean no cache entry next time.
+ */
+static void cache_store (lua_State *L, const char *rcfile, struct stat *sb)
+{
+    char *path = NULL;
+    char *hdr = NULL;
+    char *tmp = NULL;
+    int fd;
+    int rc;
+
+    if (!(path = cache_path (rcfile))
+        || !(hdr = cache_header (rcfile, sb))
+        || asprintf (&tmp, "%s.XXXXXX", path) < 0) {
+        tmp = NULL;
+        goto out;
+    }
+    if ((fd = mkstemp (tmp)) < 0)
+        goto out;
+    rc = write_all (fd, hdr, strlen (hdr));
+#if LUA_VERSION_NUM >= 503
+    if (rc >= 0 && lua_dump (L, cache_writer, &fd, 0) != 0)
+#else
+    if (rc >= 0 && lua_dump (L, cache_writer, &fd) != 0)
+#endif
+        rc = -1;
+    if (close (fd) < 0)
+        rc = -1;
+    if (rc < 0 || rename (tmp, path) < 0) {
+        shell_debug ("failed to write rc cache for %s", rcfile);
+        (void)unlink (tmp);
+        goto out;
+    }
+    shell_trace ("cached %s in %s", rcfile, path);
+out:
+    free (tmp);
+    free (hdr);
+    free (path);
+}
+
 /*  Run a Lua file as a shell initrc script
  */
 static int shell_run_rcfile (flux_shell_t *shell,
@@ -328,11 +482,15 @@ static int shell_run_rcfile (flux_shell_t *shell,
         return -1;
     file_stack_push (rcfile);
 
-    /*  Compile rcfile onto stack
+    /*  Compile rcfile onto stack, or fetch it from the cache
      */
-    if (luaL_loadfile (L, rcfile) != 0) {
-        shell_log_error ("%s: %s", rcfile, lua_tostring (L, -1));
-        return -1;
+    if (!cache_dir || cache_load (L, rcfile, &sb) < 0) {
+        if (luaL_loadfile (L, rcfile) != 0) {
+            shell_log_error ("%s: %s", rcfile, lua_tostring (L, -1));
+            return -1;
+        }
+        if (cache_dir)
+            cache_store (L, rcfile, &sb);
     }
     if (lua_pcall (L, 0, 0, 0) != 0) {
         shell_log_error ("%s", lua_tostring (L, -1));
@@ -825,9 +983,16 @@ int shell_rc (flux_shell_t *shell, const char *rcfile)
 {
     lua_State *L = NULL;
     char *copy = NULL;
+    int cache = 0;
 
     if (!shell || !rcfile)
         return -1;
+    if (flux_shell_getopt_unpack (shell, "initrc-cache", "i", &cache) < 0) {
+        shell_log_error ("initrc-cache option must be an integer");
+        return -1;
+    }
+    if (cache)
+        (void)cache_init ();
     if (!(copy = strdup (rcfile)))
         return -1;
     if (!(global_L = luaL_newstate ()))
@@ -892,6 +1057,8 @@ int shell_rc_close (void)
     /*  Destroy file stack
      */
     zlistx_destroy (&file_stack);
+    free (cache_dir);
+    cache_dir = NULL;
     return 0;
 }
 
@@ -27,6 +27,7 @@
 #include "src/common/liboptparse/optparse.h"
 #include "src/common/libeventlog/eventlog.h"
 #include "src/common/libutil/log.h"
+#include "src/common/libutil/monotime.h"
 
 #include "internal.h"
 #include "builtins.h"
@@ -234,6 +235,13 @@ static void shell_connect_flux (flux_shell_t *shell)
             shell_log_errno ("error fetching broker rank");
         shell->broker_rank = rank;
     }
+
+    /*  Create the shared eventlogger before shell.connect so that
+     *   plugins may append to it from their connect callbacks.
+     */
+    if (!(shell->ev = shell_eventlogger_create (shell)))
+        shell_die_errno (1, "shell_eventlogger_create");
+
     if (plugstack_call (shell->plugstack, "shell.connect", NULL) < 0)
         shell_log_errno ("shell.connect");
 }
@@ -711,6 +719,7 @@ static void shell_finalize (flux_shell_t *shell)
     optparse_destroy (shell->p);
 
     zhashx_destroy (&shell->completion_refs);
+    json_decref (shell->timing);
 }
 
 static void item_free (void **item)
@@ -897,17 +906,41 @@ static void barrier_cb (flux_future_t *f, void *arg)
     }
 }
 
-static int shell_barrier (flux_shell_t *shell, const char *name)
+struct shell_barrier {
+    flux_t *h;
+    flux_future_t *f;
+    flux_future_t *log_f;
+};
+
+static void shell_barrier_destroy (struct shell_barrier *b)
 {
-    flux_future_t *log_f = NULL;
-    flux_future_t *f = NULL;
-    flux_t *h = NULL;
+    if (b) {
+        int saved_errno = errno;
+        flux_job_event_watch_cancel (b->log_f);
+        flux_future_destroy (b->log_f);
+        flux_future_destroy (b->f);
+
+        /*  Close the cloned handle */
+        flux_close (b->h);
+        free (b);
+        errno = saved_errno;
+    }
+}
+
+/*  Enter barrier 'name' without waiting for it to complete, so that
+ *   local work may proceed while other shells catch up.
+ */
+static struct shell_barrier *shell_barrier_begin (flux_shell_t *shell,
+                                                  const char *name)
+{
+    struct shell_barrier *b;
     flux_jobid_t id;
     char fqname[128];
-    int rc = -1;
 
+    if (!(b = calloc (1, sizeof (*b))))
+        return NULL;
     if (shell->standalone || shell->info->shell_size == 1)
-        return 0; // NO-OP
+        return b; // NO-OP
     id = shell->info->jobid;
     if (snprintf (fqname,
                   sizeof (fqname),
@@ -915,46 +948,102 @@ static int shell_barrier (flux_shell_t *shell, const char *name)
                   (uintmax_t) id,
                    name) >= sizeof (fqname)) {
         errno = EINVAL;
-        return -1;
+        goto error;
     }
     /*  Clone shell flux handle so that only barrier and eventlog watch
-     *   messages are dispatched in the temporary reactor call here.
-     *   This allows messages from other shell services to be requeued
-     *   for the real reactor in main().
+     *   messages are dispatched in the temporary reactor call in
+     *   shell_barrier_wait().  This allows messages from other shell
+     *   services to be requeued for the real reactor in main().
      */
-    if (!(h = flux_clone (shell->h)))
+    if (!(b->h = flux_clone (shell->h)))
         shell_die_errno (1, "flux_handle_clone");
 
-    if (!(f = flux_barrier (h, fqname, shell->info->shell_size))) {
+    if (!(b->f = flux_barrier (b->h, fqname, shell->info->shell_size))) {
         shell_log_errno ("flux_barrier");
-        goto out;
+        goto error;
     }
-    if (!(log_f = flux_job_event_watch (h, id, "eventlog", 0))) {
+    if (!(b->log_f = flux_job_event_watch (b->h, id, "eventlog", 0))) {
         shell_log_errno ("flux_job_event_watch");
-        goto out;
-    }
-    if (flux_future_then (log_f, -1., eventlog_cb, NULL) < 0
-        ||  flux_future_then (f, -1., barrier_cb, NULL) < 0) {
-        shell_log_errno ("flux_future_then");
-        goto out;
+        goto error;
     }
-    if (flux_future_then (f, -1., barrier_cb, shell) < 0) {
+    if (flux_future_then (b->log_f, -1., eventlog_cb, NULL) < 0
+        ||  flux_future_then (b->f, -1., barrier_cb, shell) < 0) {
         shell_log_errno ("flux_future_then");
-        goto out;
+        goto error;
     }
-    if (flux_reactor_run (flux_get_reactor (h), 0) >= 0)
+    return b;
+error:
+    shell_barrier_destroy (b);
+    return NULL;
+}
+
+static int shell_barrier_wait (struct shell_barrier *b)
+{
+    int rc = -1;
+
+    if (!b->h)
+        return 0;
+    if (flux_reactor_run (flux_get_reactor (b->h), 0) >= 0)
         rc = 0;
     shell_trace ("exited barrier with rc = %d", rc);
-out:
-    flux_job_event_watch_cancel (log_f);
-    flux_future_destroy (log_f);
-    flux_future_destroy (f);
+    return rc;
+}
+
+static int shell_barrier (flux_shell_t *shell, const char *name)
+{
+    struct shell_barrier *b;
+    int rc;
 
-    /*  Close the cloned handle */
-    flux_close (h);
+    if (!(b = shell_barrier_begin (shell, name)))
+        return -1;
+    rc = shell_barrier_wait (b);
+    shell_barrier_destroy (b);
     return rc;
 }
 
+/*  Charge the time since the last mark to startup 'phase'.
+ *   Repeated phases (e.g. once per task) accumulate.
+ */
+static void shell_timing_mark (flux_shell_t *shell, const char *phase)
+{
+    double t = monotime_since (shell->t_phase) / 1000.;
+    json_t *o;
+
+    if (shell->timing) {
+        if ((o = json_object_get (shell->timing, phase)))
+            t += json_real_value (o);
+        if (!(o = json_real (t))
+            || json_object_set_new (shell->timing, phase, o) < 0)
+            json_decref (o);
+    }
+    monotime (&shell->t_phase);
+}
+
+/*  Log this shell's startup timing, and add it to the shell.start
+ *   event context on the leader.
+ */
+static void shell_timing_report (flux_shell_t *shell, struct timespec t0)
+{
+    char *s;
+    json_t *o;
+
+    if (!shell->timing)
+        return;
+    if ((o = json_real (monotime_since (t0) / 1000.))
+        && json_object_set_new (shell->timing, "total", o) < 0)
+        json_decref (o);
+    if ((s = json_dumps (shell->timing, JSON_COMPACT | JSON_SORT_KEYS))) {
+        shell_debug ("startup timing: %s", s);
+        free (s);
+    }
+    if (!shell->standalone
+        && shell->info->shell_rank == 0
+        && flux_shell_add_event_context (shell, "shell.start", 0,
+                                         "{s:O}",
+                                         "timing", shell->timing) < 0)
+        shell_log_errno ("failed to add startup timing to shell.start");
+}
+
 static int load_initrc (flux_shell_t *shell)
 {
     bool required = false;
@@ -984,6 +1073,7 @@ static int load_initrc (flux_shell_t *shell)
                    errno ? strerror (errno) : "");
         return -1;
     }
+    shell_timing_mark (shell, "initrc");
 
     return 0;
 }
@@ -1010,7 +1100,10 @@ static int shell_init (flux_shell_t *shell)
         }
     }
 
-    return plugstack_call (shell->plugstack, "shell.init", NULL);
+    if (plugstack_call (shell->plugstack, "shell.init", NULL) < 0)
+        return -1;
+    shell_timing_mark (shell, "shell.init");
+    return 0;
 }
 
 static int shell_task_init (flux_shell_t *shell)
@@ -1047,6 +1140,64 @@ static int shell_exit (flux_shell_t *shell)
     return plugstack_call (shell->plugstack, "shell.exit", NULL);
 }
 
+/*  Create task 'index' of this shell and call plugin task_init callbacks.
+ */
+static struct shell_task *shell_task_setup (flux_shell_t *shell, int index)
+{
+    struct shell_task *task;
+
+    if (!(task = shell_task_create (shell->info, index)))
+        shell_die (1, "shell_task_create index=%d", index);
+
+    task->pre_exec_cb = shell_task_exec;
+    task->pre_exec_arg = shell;
+    shell->current_task = task;
+
+    /*  Call all plugin task_init callbacks:
+     */
+    if (shell_task_init (shell) < 0)
+        shell_die (1, "failed to initialize taskid=%d", index);
+
+    shell_timing_mark (shell, "task.init");
+    return task;
+}
+
+/*  Launch a task prepared by shell_task_setup() and call plugin
+ *   task_fork callbacks.
+ */
+static void shell_task_launch (flux_shell_t *shell, struct shell_task *task)
+{
+    shell->current_task = task;
+
+    if (shell_task_start (task, shell->r, task_completion_cb, shell) < 0) {
+        int ec = 1;
+        /* bash standard, 126 for permission/access denied, 127
+         * for command not found.  Note that shell only launches
+         * local tasks, therefore no need to check for
+         * EHOSTUNREACH.
+         */
+        if (errno == EPERM || errno == EACCES)
+            ec = 126;
+        else if (errno == ENOENT)
+            ec = 127;
+        shell_die (ec, "task %d: start failed: %s: %s",
+                   task->index, flux_cmd_arg (task->cmd, 0), strerror (errno));
+    }
+
+    if (zlist_append (shell->tasks, task) < 0)
+        shell_die (1, "zlist_append failed");
+
+    if (flux_shell_add_completion_ref (shell, "task%d", task->rank) < 0)
+        shell_die (1, "flux_shell_add_completion_ref");
+
+    /*  Call all plugin task_fork callbacks:
+     */
+    if (shell_task_forked (shell) < 0)
+        shell_die (1, "shell_task_forked");
+
+    shell_timing_mark (shell, "task.start");
+}
+
 /*  Log basic shell info at startup.
  */
 static void shell_log_info (flux_shell_t *shell)
@@ -1074,6 +1225,21 @@ static void shell_log_info (flux_shell_t *shell)
     }
 }
 
+/*  Log time spent in plugin callbacks at exit when verbose.
+ */
+static void log_plugin_timing (const char *name,
+                               const char *topic,
+                               int count,
+                               double total_ms,
+                               void *arg)
+{
+    shell_debug ("plugin timing: %s: %s: calls=%d total=%.3fms",
+                 name,
+                 topic,
+                 count,
+                 total_ms);
+}
+
 /*  Add default event context for standard shell emitted events -
  *   shell.init and shell.start.
  */
@@ -1099,8 +1265,14 @@ static int shell_register_event_context (flux_shell_t *shell)
 int main (int argc, char *argv[])
 {
     flux_shell_t shell;
+    struct shell_barrier *barrier;
+    struct shell_task *task;
+    struct timespec t0;
+    int early_task_init = 0;
     int i;
 
+    monotime (&t0);
+
     /* Initialize locale from environment
      */
     setlocale (LC_ALL, "");
@@ -1111,6 +1283,11 @@ int main (int argc, char *argv[])
 
     shell_parse_cmdline (&shell, argc, argv);
 
+    /* Time startup phases (failure to allocate just disables timing)
+     */
+    shell.timing = json_object ();
+    shell.t_phase = t0;
+
     /* Get reactor capable of monitoring subprocesses.
      */
     if (!(shell.r = flux_reactor_create (FLUX_REACTOR_SIGCHLD)))
@@ -1120,13 +1297,12 @@ int main (int argc, char *argv[])
      */
     shell_connect_flux (&shell);
 
-    if (!(shell.ev = shell_eventlogger_create (&shell)))
-        shell_die_errno (1, "shell_eventlogger_create");
-
     /* Subscribe to shell-<id>.* events. (no-op on loopback connector)
      */
     shell_events_subscribe (&shell);
 
+    shell_timing_mark (&shell, "connect");
+
     /* Populate 'struct shell_info' for general use by shell components.
      * Fetches missing info from shell handle if set.
      */
@@ -1147,74 +1323,82 @@ int main (int argc, char *argv[])
     /* Now that verbosity may have changed, log shell startup info */
     shell_log_info (&shell);
 
+    /* Collect per-plugin callback timing for debug output at exit */
+    if (shell.verbose && plugstack_timing_enable (shell.plugstack) < 0)
+        shell_log_errno ("plugstack_timing_enable");
+
     /* Register service on the leader shell.
      */
     if (!(shell.svc = shell_svc_create (&shell)))
         shell_die (1, "shell_svc_create");
 
+    if (flux_shell_getopt_unpack (&shell,
+                                  "early-task-init",
+                                  "i",
+                                  &early_task_init) < 0)
+        shell_die (1, "failed to parse early-task-init shell option");
+
+    shell_timing_mark (&shell, "info");
+
     /* Call shell initialization routines and "shell_init" plugins.
      */
     if (shell_init (&shell) < 0)
         shell_die_errno (1, "shell_init");
 
-    /* Barrier to ensure initialization has completed across all shells.
-     */
-    if (shell_barrier (&shell, "init") < 0)
-        shell_die_errno (1, "shell_barrier");
-
-    /*  Emit an event after barrier completion from rank 0 if not in
-     *   standalone mode.
-     */
-    if (shell.info->shell_rank == 0
-        && !shell.standalone
-        && shell_eventlogger_emit_event (shell.ev, 0, "shell.init") < 0)
-            shell_die_errno (1, "failed to emit event shell.init");
-
-    /* Create tasks
-     */
     if (!(shell.tasks = zlist_new ()))
         shell_die (1, "zlist_new failed");
-    for (i = 0; i < shell.info->rankinfo.ntasks; i++) {
-        struct shell_task *task;
-
-        if (!(task = shell_task_create (shell.info, i)))
-            shell_die (1, "shell_task_create index=%d", i);
 
-        task->pre_exec_cb = shell_task_exec;
-        task->pre_exec_arg = &shell;
-        shell.current_task = task;
-
-        /*  Call all plugin task_init callbacks:
-         */
-        if (shell_task_init (&shell) < 0)
-            shell_die (1, "failed to initialize taskid=%d", i);
-
-        if (shell_task_start (task, shell.r, task_completion_cb, &shell) < 0) {
-            int ec = 1;
-            /* bash standard, 126 for permission/access denied, 127
-             * for command not found.  Note that shell only launches
-             * local tasks, therefore no need to check for
-             * EHOSTUNREACH.
-             */
-            if (errno == EPERM || errno == EACCES)
-                ec = 126;
-            else if (errno == ENOENT)
-                ec = 127;
-            shell_die (ec, "task %d: start failed: %s: %s",
-                       i, flux_cmd_arg (task->cmd, 0), strerror (errno));
+    /* Barrier to ensure initialization has completed across all shells.
+     * With early-task-init, tasks are created and their task_init
+     * callbacks called while the barrier is in progress, instead of
+     * after it completes.  Tasks are not started until after the barrier.
+     */
+    if (!(barrier = shell_barrier_begin (&shell, "init")))
+        shell_die_errno (1, "shell_barrier");
+    if (early_task_init) {
+        zlist_t *pending;
+
+        if (!(pending = zlist_new ()))
+            shell_die (1, "zlist_new failed");
+        for (i = 0; i < shell.info->rankinfo.ntasks; i++) {
+            task = shell_task_setup (&shell, i);
+            if (zlist_append (pending, task) < 0)
+                shell_die (1, "zlist_append failed");
         }
+        shell.current_task = NULL;
+        if (shell_barrier_wait (barrier) < 0)
+            shell_die_errno (1, "shell_barrier");
+        shell_timing_mark (&shell, "barrier.init");
+        if (shell.info->shell_rank == 0
+            && !shell.standalone
+            && shell_eventlogger_emit_event (shell.ev, 0, "shell.init") < 0)
+                shell_die_errno (1, "failed to emit event shell.init");
+        while ((task = zlist_pop (pending)))
+            shell_task_launch (&shell, task);
+        zlist_destroy (&pending);
+    }
+    else {
+        if (shell_barrier_wait (barrier) < 0)
+            shell_die_errno (1, "shell_barrier");
+        shell_timing_mark (&shell, "barrier.init");
 
-        if (zlist_append (shell.tasks, task) < 0)
-            shell_die (1, "zlist_append failed");
-
-        if (flux_shell_add_completion_ref (&shell, "task%d", task->rank) < 0)
-            shell_die (1, "flux_shell_add_completion_ref");
+        /*  Emit an event after barrier completion from rank 0 if not in
+         *   standalone mode.
+         */
+        if (shell.info->shell_rank == 0
+            && !shell.standalone
+            && shell_eventlogger_emit_event (shell.ev, 0, "shell.init") < 0)
+                shell_die_errno (1, "failed to emit event shell.init");
 
-        /*  Call all plugin task_fork callbacks:
+        /* Create tasks
          */
-        if (shell_task_forked (&shell) < 0)
-            shell_die (1, "shell_task_forked");
+        for (i = 0; i < shell.info->rankinfo.ntasks; i++) {
+            task = shell_task_setup (&shell, i);
+            shell_task_launch (&shell, task);
+        }
     }
+    shell_barrier_destroy (barrier);
+
     /*  Reset current task since we've left task-specific context:
      */
     shell.current_task = NULL;
@@ -1222,9 +1406,14 @@ int main (int argc, char *argv[])
     if (shell_start (&shell) < 0)
         shell_die_errno (1, "shell.start callback(s) failed");
 
+    shell_timing_mark (&shell, "shell.start");
+
     if (shell_barrier (&shell, "start") < 0)
         shell_die_errno (1, "shell_barrier");
 
+    shell_timing_mark (&shell, "barrier.start");
+    shell_timing_report (&shell, t0);
+
     /*  Emit an event after barrier completion from rank 0 if not in
      *   standalone mode.
      */
@@ -1250,6 +1439,8 @@ int main (int argc, char *argv[])
     }
 
     shell.rc = shell_max_task_exit (&shell);
+    if (shell.verbose)
+        plugstack_timing_foreach (shell.plugstack, log_plugin_timing, NULL);
     shell_debug ("exit %d", shell.rc);
 
     if (shell_rc_close ())
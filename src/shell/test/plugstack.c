@@ -64,6 +64,17 @@ static int check_name (flux_plugin_t *p, const char *s,
     return plugstack_call (st, "next.level", args);
 }
 
+static void count_timing (const char *name,
+                          const char *topic,
+                          int count,
+                          double total_ms,
+                          void *arg)
+{
+    int *total = arg;
+    if (strcmp (topic, "callback") == 0)
+        *total += count;
+}
+
 void test_invalid_args (struct plugstack *st, flux_plugin_t *p)
 {
     ok (plugstack_push (NULL, p) < 0 && errno == EINVAL,
@@ -87,6 +98,14 @@ void test_invalid_args (struct plugstack *st, flux_plugin_t *p)
         "plugstack_plugin_aux_set (NULL, ...) returns EINVAL");
     ok (plugstack_current_name (NULL) == NULL && errno == EINVAL,
         "plugstack_current_name (NULL) returns EINVAL");
+    ok (plugstack_has_handler (NULL, "foo") < 0 && errno == EINVAL,
+        "plugstack_has_handler (NULL, ...) returns EINVAL");
+    ok (plugstack_has_handler (st, NULL) < 0 && errno == EINVAL,
+        "plugstack_has_handler (st, NULL) returns EINVAL");
+    ok (plugstack_timing_enable (NULL) < 0 && errno == EINVAL,
+        "plugstack_timing_enable (NULL) returns EINVAL");
+    ok (plugstack_timing_foreach (st, NULL, NULL) < 0 && errno == EINVAL,
+        "plugstack_timing_foreach (st, NULL, NULL) returns EINVAL");
 }
 
 void test_load (void)
@@ -251,6 +270,39 @@ int main (int argc, char **argv)
     ok (called_bar == 2 && called_foo == 0,
         "plugstack_call didn't call foo() only bar()");
 
+    ok (plugstack_has_handler (st, "callback") == 1,
+        "plugstack_has_handler (st, 'callback') returns 1");
+    ok (plugstack_has_handler (st, "late") == 0,
+        "plugstack_has_handler (st, 'late') returns 0");
+
+    /*  Handlers added after a topic has been called must be picked up
+     */
+    called_foo = 0;
+    ok (plugstack_call (st, "late", args) == 0 && called_foo == 0,
+        "plugstack_call (st, 'late') with no handlers does nothing");
+    ok (flux_plugin_add_handler (p3, "late", foo, NULL) == 0,
+        "flux_plugin_add_handler (p3, 'late', &foo)");
+    ok (plugstack_has_handler (st, "late") == 1,
+        "plugstack_has_handler (st, 'late') now returns 1");
+    ok (plugstack_call (st, "late", args) == 0 && called_foo == 1,
+        "plugstack_call (st, 'late') calls newly added handler");
+    ok (flux_plugin_remove_handler (p3, "late") == 0,
+        "flux_plugin_remove_handler (p3, 'late')");
+    ok (plugstack_call (st, "late", args) == 0 && called_foo == 1,
+        "plugstack_call (st, 'late') no longer calls removed handler");
+
+    int total = 0;
+    ok (plugstack_timing_foreach (st, count_timing, &total) == 0
+        && total == 0,
+        "plugstack_timing_foreach reports nothing before enable");
+    ok (plugstack_timing_enable (st) == 0,
+        "plugstack_timing_enable works");
+    ok (plugstack_call (st, "callback", args) == 0,
+        "plugstack_call (st, 'callback')");
+    ok (plugstack_timing_foreach (st, count_timing, &total) == 0
+        && total == 2,
+        "plugstack_timing_foreach reports 2 callbacks for topic");
+
     plugstack_destroy (st);
     flux_plugin_arg_destroy (args);
 
@@ -33,8 +33,12 @@ static void commit_continuation (flux_future_t *f, void *arg)
             flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
     }
     else {
-        if (flux_respond (h, msg, NULL) < 0)
-            flux_log_error (h, "%s: flux_respond", __FUNCTION__);
+        if (flux_respond_pack (h,
+                               msg,
+                               "{s:i s:[]}",
+                               "credits", -1,
+                               "rejected") < 0)
+            flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
     }
     flux_msg_destroy (msg);
     flux_future_destroy (f);
@@ -0,0 +1,106 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* submit-bulk - submit N copies of jobspec with one job-ingest.submit-bulk
+ *
+ * Usage: submit-bulk [--count=N] [--bad=INDEX] jobspec
+ *
+ * Jobids are printed one per line, in order.  If --bad=INDEX is given,
+ * the job at INDEX is replaced with an invalid jobspec.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <flux/core.h>
+#include <flux/optparse.h>
+
+#include "src/common/libutil/log.h"
+#include "src/common/libutil/xzmalloc.h"
+#include "src/common/libutil/read_all.h"
+#include "src/common/libjob/job.h"
+
+static struct optparse_option opts[] =  {
+    { .name = "count", .key = 'n', .has_arg = 1, .arginfo = "N",
+      .usage = "Submit N instances of jobspec (default 1)",
+    },
+    { .name = "bad", .key = 'b', .has_arg = 1, .arginfo = "INDEX",
+      .usage = "Replace the job at INDEX with an invalid jobspec",
+    },
+    OPTPARSE_TABLE_END
+};
+
+int main (int argc, char *argv[])
+{
+    optparse_t *p;
+    int optindex;
+    int count;
+    int bad;
+    int fd;
+    void *buf;
+    const char **jobspecs;
+    flux_jobid_t *ids;
+    flux_t *h;
+    flux_future_t *f;
+    int i;
+
+    log_init ("submit-bulk");
+
+    if (!(p = optparse_create ("submit-bulk"))
+        || optparse_add_option_table (p, opts) != OPTPARSE_SUCCESS
+        || optparse_set (p, OPTPARSE_USAGE, "[OPTIONS] jobspec")
+            != OPTPARSE_SUCCESS)
+        log_msg_exit ("error setting up option parsing");
+    if ((optindex = optparse_parse_args (p, argc, argv)) < 0)
+        exit (1);
+    if (optindex != argc - 1) {
+        optparse_print_usage (p);
+        exit (1);
+    }
+    count = optparse_get_int (p, "count", 1);
+    bad = optparse_get_int (p, "bad", -1);
+
+    if ((fd = open (argv[optindex], O_RDONLY)) < 0)
+        log_err_exit ("%s", argv[optindex]);
+    if (read_all (fd, &buf) < 0)
+        log_err_exit ("%s", argv[optindex]);
+    close (fd);
+
+    jobspecs = xzmalloc (sizeof (jobspecs[0]) * count);
+    ids = xzmalloc (sizeof (ids[0]) * count);
+    for (i = 0; i < count; i++)
+        jobspecs[i] = i == bad ? "{}" : buf;
+
+    if (!(h = flux_open (NULL, 0)))
+        log_err_exit ("flux_open");
+    if (!(f = flux_job_submit_bulk (h, count, jobspecs, 16, 0)))
+        log_err_exit ("flux_job_submit_bulk");
+    if (flux_job_submit_bulk_get_ids (f, count, ids) < 0)
+        log_msg_exit ("submit-bulk: %s", future_strerror (f, errno));
+    for (i = 0; i < count; i++)
+        printf ("%ju\n", (uintmax_t)ids[i]);
+
+    flux_future_destroy (f);
+    flux_close (h);
+    free (ids);
+    free (jobspecs);
+    free (buf);
+    optparse_destroy (p);
+    log_fini ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -28,6 +28,12 @@ static struct optparse_option list_opts[] =  {
     { .name = "count", .key = 'c', .has_arg = 1, .arginfo = "N",
       .usage = "Limit output to N jobs",
     },
+    { .name = "user", .key = 'u', .has_arg = 1, .arginfo = "UID",
+      .usage = "List only jobs owned by UID",
+    },
+    { .name = "states", .key = 's', .has_arg = 1, .arginfo = "STATE,...",
+      .usage = "List only jobs in the given states",
+    },
     OPTPARSE_TABLE_END
 };
 
@@ -46,11 +52,38 @@ static int iso_timestr (double timestamp, char *buf, size_t size)
     return 0;
 }
 
+/* Convert comma-separated list of state names to a state bitmask.
+ */
+static int parse_states (const char *arg)
+{
+    char *cpy;
+    char *tok;
+    char *saveptr = NULL;
+    char *s;
+    int states = 0;
+
+    if (!(cpy = strdup (arg)))
+        log_msg_exit ("out of memory");
+    s = cpy;
+    while ((tok = strtok_r (s, ",", &saveptr))) {
+        flux_job_state_t state;
+        if (flux_job_strtostate (tok, &state) < 0)
+            log_msg_exit ("invalid state: %s", tok);
+        states |= state;
+        s = NULL;
+    }
+    free (cpy);
+    return states;
+}
+
 int main (int argc, char *argv[])
 {
     flux_t *h;
     optparse_t *opts;
     int max_entries;
+    int userid;
+    int states = 0;
+    const char *arg;
     int optindex;
     flux_future_t *f;
     json_t *jobs;
@@ -66,6 +99,9 @@ int main (int argc, char *argv[])
         exit (1);
 
     max_entries = optparse_get_int (opts, "count", 0);
+    userid = optparse_get_int (opts, "user", FLUX_USERID_UNKNOWN);
+    if ((arg = optparse_get_str (opts, "states", NULL)))
+        states = parse_states (arg);
 
     if (optindex != argc) {
         optparse_print_usage (opts);
@@ -79,9 +115,13 @@ int main (int argc, char *argv[])
                              "job-manager.list",
                              FLUX_NODEID_ANY,
                              0,
-                             "{s:i}",
+                             "{s:i s:i s:i}",
                              "max_entries",
-                             max_entries)))
+                             max_entries,
+                             "userid",
+                             userid,
+                             "states",
+                             states)))
         log_err_exit ("flux_rpc_pack");
 
     if (flux_rpc_get_unpack (f, "{s:o}", "jobs", &jobs) < 0)
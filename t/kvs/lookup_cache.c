@@ -0,0 +1,122 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* lookup_cache.c - check that the client side lookup cache answers
+ * repeated lookups locally, and sees a root change by another handle.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <libgen.h>
+#include <unistd.h>
+#include <flux/core.h>
+
+#include "src/common/libutil/log.h"
+
+static void usage (void)
+{
+    fprintf (stderr, "Usage: lookup_cache key\n");
+    exit (1);
+}
+
+static void put (flux_t *h, const char *key, const char *value)
+{
+    flux_kvs_txn_t *txn;
+    flux_future_t *f;
+
+    if (!(txn = flux_kvs_txn_create ())
+        || flux_kvs_txn_put (txn, 0, key, value) < 0)
+        log_err_exit ("flux_kvs_txn_put");
+    if (!(f = flux_kvs_commit (h, NULL, 0, txn))
+        || flux_future_get (f, NULL) < 0)
+        log_err_exit ("flux_kvs_commit");
+    flux_future_destroy (f);
+    flux_kvs_txn_destroy (txn);
+}
+
+/* Look up 'key', returning true if the value is 'value'.
+ */
+static bool check (flux_t *h, const char *key, const char *value)
+{
+    flux_future_t *f;
+    const char *s;
+    bool match;
+
+    if (!(f = flux_kvs_lookup (h, NULL, 0, key))
+        || flux_kvs_lookup_get (f, &s) < 0)
+        log_err_exit ("flux_kvs_lookup %s", key);
+    match = !strcmp (s, value);
+    flux_future_destroy (f);
+    return match;
+}
+
+static int request_count (flux_t *h)
+{
+    flux_msgcounters_t mcs;
+
+    flux_get_msgcounters (h, &mcs);
+    return mcs.request_tx;
+}
+
+int main (int argc, char *argv[])
+{
+    flux_t *h, *h2;
+    const char *key;
+    int count;
+    int i;
+
+    log_init (basename (argv[0]));
+
+    if (argc != 2)
+        usage ();
+    key = argv[1];
+
+    if (!(h = flux_open (NULL, 0)) || !(h2 = flux_open (NULL, 0)))
+        log_err_exit ("flux_open");
+    if (flux_kvs_lookup_cache_enable (h) < 0)
+        log_err_exit ("flux_kvs_lookup_cache_enable");
+
+    /* A commit on the caching handle is seen right away.
+     */
+    put (h, key, "1");
+    if (!check (h, key, "1"))
+        log_msg_exit ("lookup after commit did not return new value");
+    count = request_count (h);
+    if (!check (h, key, "1"))
+        log_msg_exit ("repeated lookup returned different value");
+    if (request_count (h) != count)
+        log_msg_exit ("repeated lookup was not answered from cache");
+    put (h, key, "2");
+    if (!check (h, key, "2"))
+        log_msg_exit ("lookup after second commit did not return new value");
+
+    /* A commit on another handle is seen when its setroot event arrives.
+     */
+    put (h2, key, "3");
+    for (i = 0; i < 100; i++) {
+        if (check (h, key, "3"))
+            break;
+        usleep (100000);
+    }
+    if (i == 100)
+        log_msg_exit ("commit on another handle was not seen");
+
+    printf ("lookup cache ok\n");
+
+    flux_close (h2);
+    flux_close (h);
+    log_fini ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
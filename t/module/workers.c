@@ -0,0 +1,169 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* workers.c - test module for flux_module_set_workers()
+ *
+ * workers.info request {"key"?:s} responds with {"worker":i}
+ * workers.rank request {"key"?:s} makes an attr.get RPC from the worker
+ * and responds with {"worker":i, "rank":s}.
+ * workers.block request responds, then makes a synchronous workers.noreply
+ * RPC, which is never answered, so the worker is blocked at module unload.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <flux/core.h>
+
+#define WORKER_COUNT 4
+
+struct worker_ctx {
+    int index;
+};
+
+static const char *get_key (const flux_msg_t *msg, void *arg)
+{
+    const char *key = NULL;
+
+    if (flux_request_unpack (msg, NULL, "{s?:s}", "key", &key) < 0)
+        return NULL;
+    return key;
+}
+
+static void info_cb (flux_t *h,
+                     flux_msg_handler_t *mh,
+                     const flux_msg_t *msg,
+                     void *arg)
+{
+    struct worker_ctx *ctx = arg;
+
+    if (flux_respond_pack (h, msg, "{s:i}", "worker", ctx->index) < 0)
+        flux_log_error (h, "error responding to info request");
+}
+
+static void rank_continuation (flux_future_t *f, void *arg)
+{
+    struct worker_ctx *ctx = arg;
+    flux_t *h = flux_future_get_flux (f);
+    const flux_msg_t *msg = flux_future_aux_get (f, "request");
+    const char *value;
+
+    if (flux_rpc_get_unpack (f, "{s:s}", "value", &value) < 0) {
+        if (flux_respond_error (h, msg, errno, NULL) < 0)
+            flux_log_error (h, "error responding to rank request");
+        goto done;
+    }
+    if (flux_respond_pack (h,
+                           msg,
+                           "{s:i s:s}",
+                           "worker", ctx->index,
+                           "rank", value) < 0)
+        flux_log_error (h, "error responding to rank request");
+done:
+    flux_future_destroy (f);
+}
+
+static void rank_cb (flux_t *h,
+                     flux_msg_handler_t *mh,
+                     const flux_msg_t *msg,
+                     void *arg)
+{
+    flux_future_t *f;
+
+    if (!(f = flux_rpc_pack (h,
+                             "attr.get",
+                             FLUX_NODEID_ANY,
+                             0,
+                             "{s:s}",
+                             "name", "rank"))
+        || flux_future_aux_set (f,
+                                "request",
+                                (void *)flux_msg_incref (msg),
+                                (flux_free_f)flux_msg_decref) < 0
+        || flux_future_then (f, -1., rank_continuation, arg) < 0) {
+        if (flux_respond_error (h, msg, errno, NULL) < 0)
+            flux_log_error (h, "error responding to rank request");
+        flux_future_destroy (f);
+    }
+}
+
+static void noreply_cb (flux_t *h,
+                        flux_msg_handler_t *mh,
+                        const flux_msg_t *msg,
+                        void *arg)
+{
+}
+
+static void block_cb (flux_t *h,
+                      flux_msg_handler_t *mh,
+                      const flux_msg_t *msg,
+                      void *arg)
+{
+    flux_future_t *f;
+
+    if (flux_respond (h, msg, NULL) < 0)
+        flux_log_error (h, "error responding to block request");
+    if (!(f = flux_rpc (h, "workers.noreply", NULL, FLUX_NODEID_ANY, 0))
+        || flux_rpc_get (f, NULL) < 0)
+        flux_log_error (h, "workers.noreply");
+    flux_future_destroy (f);
+}
+
+static const struct flux_msg_handler_spec htab[] = {
+    { FLUX_MSGTYPE_REQUEST, "workers.info", info_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST, "workers.rank", rank_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST, "workers.noreply", noreply_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST, "workers.block", block_cb, 0 },
+    FLUX_MSGHANDLER_TABLE_END,
+};
+
+static int worker_main (flux_t *h, int index, void *arg)
+{
+    struct worker_ctx ctx = { .index = index };
+    flux_msg_handler_t **handlers = NULL;
+    int rc = -1;
+
+    if (flux_msg_handler_addvec (h, htab, &ctx, &handlers) < 0) {
+        flux_log_error (h, "flux_msg_handler_addvec");
+        return -1;
+    }
+    if (flux_reactor_run (flux_get_reactor (h), 0) < 0) {
+        flux_log_error (h, "flux_reactor_run");
+        goto done;
+    }
+    rc = 0;
+done:
+    flux_msg_handler_delvec (handlers);
+    return rc;
+}
+
+int mod_main (flux_t *h, int argc, char *argv[])
+{
+    if (flux_module_set_workers (h,
+                                 WORKER_COUNT,
+                                 "workers.*",
+                                 get_key,
+                                 worker_main,
+                                 NULL) < 0) {
+        flux_log_error (h, "flux_module_set_workers");
+        return -1;
+    }
+    if (flux_reactor_run (flux_get_reactor (h), 0) < 0) {
+        flux_log_error (h, "flux_reactor_run");
+        return -1;
+    }
+    return 0;
+}
+
+MOD_NAME ("workers");
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
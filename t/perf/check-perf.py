@@ -0,0 +1,212 @@
+##############################################################
+# Copyright 2021 Lawrence Livermore National Security, LLC
+# (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+#
+# This file is part of the Flux resource manager framework.
+# For details, see https://github.com/flux-framework.
+#
+# SPDX-License-Identifier: LGPL-3.0
+##############################################################
+
+# Usage: check-perf.py [OPTIONS] [SCENARIO...]
+#
+# Run flux-bench(1) scenarios in a test instance started with
+# 'flux start --test-size=N', compare the results with a baseline,
+# and write a JSON report.  Exit with 1 if any scenario regressed.
+#
+# The baseline is a JSON object:
+#   {"size":i, "count":i, "tolerance":f,
+#    "scenarios":{name:{"rate"?:f, "p99"?:f}, ...}}
+# A scenario regresses if its rate falls below (1 - tolerance) * rate,
+# or its p99 latency (usec) rises above (1 + tolerance) * p99.
+# Scenarios without a baseline are reported as "new" and do not fail.
+#
+# Baselines depend on the machine.  Use --update to record the results
+# of a run as the new baseline.
+#
+
+import os
+import sys
+import json
+import argparse
+import subprocess
+
+
+def load_json(path):
+    with open(path) as fp:
+        return json.load(fp)
+
+
+def save_json(path, obj):
+    with open(path, "w") as fp:
+        json.dump(obj, fp, indent=2, sort_keys=True)
+        fp.write("\n")
+
+
+def run_bench(args, scenarios):
+    cmd = [
+        args.flux,
+        "start",
+        "--test-size={}".format(args.size),
+        args.flux,
+        "bench",
+        "--count={}".format(args.count),
+    ]
+    cmd.extend(scenarios)
+    print("check-perf: " + " ".join(cmd), file=sys.stderr)
+    out = subprocess.check_output(cmd)
+    return json.loads(out.decode("utf-8"))
+
+
+def check_scenario(name, result, baseline, tolerance):
+    """Return the verdict on 'result' of scenario 'name' against
+    'baseline', a dict of baseline scenarios
+    """
+    verdict = {"status": "new", "checks": []}
+    if name not in baseline:
+        return verdict
+    verdict["status"] = "pass"
+    base = baseline[name]
+    if "rate" in base:
+        limit = base["rate"] * (1.0 - tolerance)
+        check = {
+            "metric": "rate",
+            "value": result["rate"],
+            "baseline": base["rate"],
+            "limit": limit,
+            "pass": result["rate"] >= limit,
+        }
+        verdict["checks"].append(check)
+    if "p99" in base:
+        limit = base["p99"] * (1.0 + tolerance)
+        check = {
+            "metric": "p99",
+            "value": result["latency"]["p99"],
+            "baseline": base["p99"],
+            "limit": limit,
+            "pass": result["latency"]["p99"] <= limit,
+        }
+        verdict["checks"].append(check)
+    if not all(check["pass"] for check in verdict["checks"]):
+        verdict["status"] = "fail"
+    return verdict
+
+
+def make_baseline(results, tolerance):
+    scenarios = {}
+    for name, result in results["scenarios"].items():
+        scenarios[name] = {
+            "rate": round(result["rate"], 1),
+            "p99": round(result["latency"]["p99"], 1),
+        }
+    return {
+        "size": results["size"],
+        "count": results["count"],
+        "tolerance": tolerance,
+        "scenarios": scenarios,
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(prog="check-perf")
+    parser.add_argument(
+        "-b",
+        "--baseline",
+        metavar="FILE",
+        default=os.path.join(os.path.dirname(__file__), "baseline.json"),
+        help="Baseline to compare with (default: %(default)s)",
+    )
+    parser.add_argument(
+        "-o",
+        "--output",
+        metavar="FILE",
+        default="perf-report.json",
+        help="Write JSON report to FILE (default: %(default)s)",
+    )
+    parser.add_argument(
+        "-r",
+        "--results",
+        metavar="FILE",
+        help="Compare flux-bench output in FILE instead of running it",
+    )
+    parser.add_argument(
+        "-N", "--size", type=int, help="Instance size (default: baseline)",
+    )
+    parser.add_argument(
+        "-n", "--count", type=int, help="Operations per scenario",
+    )
+    parser.add_argument(
+        "-t", "--tolerance", type=float, help="Allowed fractional regression",
+    )
+    parser.add_argument(
+        "-u",
+        "--update",
+        action="store_true",
+        help="Write the results to the baseline instead of comparing",
+    )
+    parser.add_argument(
+        "--flux",
+        metavar="PATH",
+        default=os.environ.get("FLUX", "flux"),
+        help="Path to flux command (default: $FLUX or flux)",
+    )
+    parser.add_argument("scenario", nargs="*", help="Scenarios to run")
+    args = parser.parse_args()
+
+    baseline = {}
+    if os.path.exists(args.baseline):
+        baseline = load_json(args.baseline)
+    elif not args.update:
+        sys.exit("check-perf: {}: no such baseline".format(args.baseline))
+    if args.size is None:
+        args.size = baseline.get("size", 2)
+    if args.count is None:
+        args.count = baseline.get("count", 1000)
+    if args.tolerance is None:
+        args.tolerance = baseline.get("tolerance", 0.5)
+    scenarios = args.scenario or sorted(baseline.get("scenarios", {}))
+
+    if args.results:
+        results = load_json(args.results)
+    else:
+        results = run_bench(args, scenarios)
+
+    if args.update:
+        save_json(args.baseline, make_baseline(results, args.tolerance))
+        print("check-perf: updated {}".format(args.baseline))
+        return
+
+    report = {
+        "baseline": args.baseline,
+        "tolerance": args.tolerance,
+        "results": results,
+        "verdict": {},
+    }
+    failed = []
+    base_scenarios = baseline.get("scenarios", {})
+    for name in sorted(results["scenarios"]):
+        verdict = check_scenario(
+            name, results["scenarios"][name], base_scenarios, args.tolerance
+        )
+        report["verdict"][name] = verdict
+        print("{:<16} {}".format(name, verdict["status"]))
+        for check in verdict["checks"]:
+            if not check["pass"]:
+                how = "below" if check["metric"] == "rate" else "above"
+                print(
+                    "  {metric}: {value:.1f} {how} limit {limit:.1f}"
+                    " (baseline {baseline:.1f})".format(how=how, **check)
+                )
+        if verdict["status"] == "fail":
+            failed.append(name)
+    report["pass"] = not failed
+    save_json(args.output, report)
+    print("check-perf: wrote {}".format(args.output))
+    if failed:
+        sys.exit("check-perf: regressed: {}".format(" ".join(failed)))
+
+
+if __name__ == "__main__":
+    main()
+
+# vi: ts=4 sw=4 expandtab
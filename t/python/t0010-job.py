@@ -429,6 +429,24 @@ class TestJob(unittest.TestCase):
                     # Ensure encode back to same type works
                     self.assertEqual(getattr(jobid, key), test[key])
 
+    def test_25_wait_batch(self):
+        """Test that wait_batch reaps several waitable jobs at once"""
+        jobids = [
+            job.submit(self.fh, self.basic_jobspec, waitable=True) for i in range(3)
+        ]
+        for jobid in jobids:
+            job.event_wait(self.fh, jobid, "clean")
+        results = job.wait_batch(self.fh, 2)
+        results += job.wait_batch(self.fh, 2)
+        self.assertEqual(sorted(r.jobid for r in results), sorted(jobids))
+        for result in results:
+            self.assertTrue(result.success)
+        with self.assertRaises(OSError) as error:
+            job.wait_batch(self.fh, 2)
+        self.assertEqual(error.exception.errno, errno.ECHILD)
+        with self.assertRaises(OSError):
+            job.wait_batch(self.fh, 0)
+
 
 if __name__ == "__main__":
     from subflux import rerun_under_flux
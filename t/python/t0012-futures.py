@@ -14,10 +14,13 @@ from __future__ import print_function
 
 import gc
 import errno
+import json
+import asyncio
 import unittest
 
 import six.moves
 import flux
+import flux.aio
 import flux.constants
 from flux.core.inner import ffi
 from flux.future import Future
@@ -146,6 +149,53 @@ class TestHandle(unittest.TestCase):
         fut = self.f.service_unregister("rpctest")
         self.assertEqual(self.f.future_get(fut, ffi.NULL), 0)
 
+    def test_08_rpc_batch(self):
+        payloads = [{"seq": i, "pad": "stuff"} for i in range(64)]
+        rpcs = self.f.rpc_batch([("cmb.ping", p) for p in payloads])
+        self.assertEqual(len(rpcs), len(payloads))
+        for rpc, payload in zip(rpcs, payloads):
+            self.assertDictContainsSubset(payload, rpc.get())
+
+    def test_09_rpc_batch_nodeid(self):
+        rank = {"name": "rank"}
+        rpcs = self.f.rpc_batch([("attr.get", rank, 1), ("attr.get", rank)], nodeid=0)
+        self.assertEqual(rpcs[0].get()["value"], "1")
+        self.assertEqual(rpcs[1].get()["value"], "0")
+
+    def test_10_rpc_get_raw(self):
+        rpc = self.f.rpc("cmb.ping", {"seq": 1, "pad": "stuff"})
+        raw = rpc.get_raw()
+        self.assertNotEqual(raw[-1:], b"\0")
+        self.assertEqual(json.loads(raw.decode("utf-8"))["seq"], 1)
+
+    def test_11_await_rpc(self):
+        async def ping(seq):
+            return await self.f.rpc("cmb.ping", {"seq": seq, "pad": "stuff"})
+
+        async def main():
+            return await asyncio.gather(*[ping(i) for i in range(16)])
+
+        loop = asyncio.new_event_loop()
+        try:
+            resps = loop.run_until_complete(main())
+        finally:
+            flux.aio.detach(self.f)
+            loop.close()
+        self.assertEqual([r["seq"] for r in resps], list(range(16)))
+
+    def test_12_await_error(self):
+        async def main():
+            return await self.f.rpc("nonexistent.topic")
+
+        loop = asyncio.new_event_loop()
+        try:
+            with self.assertRaises(EnvironmentError) as cm:
+                loop.run_until_complete(main())
+        finally:
+            flux.aio.detach(self.f)
+            loop.close()
+        self.assertEqual(cm.exception.errno, errno.ENOSYS)
+
 
 if __name__ == "__main__":
     if rerun_under_flux(__flux_size()):
@@ -35,6 +35,8 @@ static struct optparse_option cmdopts[] = {
       .usage = "Output state changes as they occur" },
     { .name = "stdin2stream", .key = 'i', .has_arg = 1, .arginfo = "CHANNEL",
       .usage = "Read in stdin and forward to subprocess channel" },
+    { .name = "bufsize", .key = 'b', .has_arg = 1, .arginfo = "SIZE",
+      .usage = "Set stdout and stderr buffer size" },
     OPTPARSE_TABLE_END
 };
 
@@ -165,6 +167,12 @@ int main (int argc, char *argv[])
 
     free (cwd);
 
+    if (optparse_getopt (opts, "bufsize", &optargp) > 0) {
+        if (flux_cmd_setopt (cmd, "stdout_BUFSIZE", optargp) < 0
+            || flux_cmd_setopt (cmd, "stderr_BUFSIZE", optargp) < 0)
+            log_err_exit ("flux_cmd_setopt");
+    }
+
     if (optparse_getopt (opts, "stdin2stream", &optargp) > 0) {
         if (strcmp (optargp, "stdin")
             && strcmp (optargp, "stdout")
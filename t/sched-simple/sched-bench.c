@@ -0,0 +1,400 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* sched-bench - drive the sched-simple allocator with a synthetic workload
+ *
+ * A stream of jobs with random size, duration, and arrival time is run
+ * through a simulated clock against an rlist.  Jobs are considered in
+ * submission order (FCFS, like sched-simple without backfill), so a job
+ * that does not fit blocks the queue until resources are freed.
+ *
+ * Wall clock time is measured only around rlist_alloc() and rlist_free(),
+ * so allocations per second reflects the cost of the allocator itself.
+ * Queue latency and utilization are in simulated time.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <unistd.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <flux/optparse.h>
+
+#include "src/common/libutil/log.h"
+#include "src/common/libutil/read_all.h"
+#include "src/common/libutil/monotime.h"
+#include "src/common/libutil/skiplist.h"
+#include "src/modules/sched-simple/rlist.h"
+
+struct range {
+    int min;
+    int max;
+};
+
+struct job {
+    int id;
+    int size;           // cores
+    double duration;
+    double t_submit;
+    double t_start;
+    double t_end;
+    struct rlist *alloc;
+    void *handle;       // in bench->running
+};
+
+struct bench {
+    struct rlist *rl;
+    const char *mode;
+    struct job *jobs;
+    int njobs;
+    struct skiplist *running;   // ordered by t_end
+
+    int allocs;
+    int attempts;
+    int unsatisfiable;
+    double alloc_ms;
+    double free_ms;
+    double busy;                // core-seconds allocated
+    double makespan;
+};
+
+static struct optparse_option opts[] = {
+    { .name = "nodes", .key = 'N', .has_arg = 1, .arginfo = "N",
+      .usage = "Generate N nodes (default 16)",
+    },
+    { .name = "cores", .key = 'c', .has_arg = 1, .arginfo = "N",
+      .usage = "Generate N cores per node (default 16)",
+    },
+    { .name = "R", .key = 'R', .has_arg = 1, .arginfo = "FILE",
+      .usage = "Read resource set from R FILE instead of generating it",
+    },
+    { .name = "by-rank", .key = 'H', .has_arg = 1, .arginfo = "FILE",
+      .usage = "Read resource set from resource.hwloc.by_rank FILE",
+    },
+    { .name = "jobs", .key = 'j', .has_arg = 1, .arginfo = "N",
+      .usage = "Submit N jobs (default 1000)",
+    },
+    { .name = "size", .key = 's', .has_arg = 1, .arginfo = "MIN[-MAX]",
+      .usage = "Job size in cores, uniformly distributed (default 1-16)",
+    },
+    { .name = "duration", .key = 'd', .has_arg = 1, .arginfo = "MIN[-MAX]",
+      .usage = "Job duration in seconds, uniformly distributed (default 1-60)",
+    },
+    { .name = "interval", .key = 'i', .has_arg = 1, .arginfo = "SECONDS",
+      .usage = "Mean time between submissions (default 0, all at once)",
+    },
+    { .name = "mode", .key = 'm', .has_arg = 1, .arginfo = "MODE",
+      .usage = "Allocation mode: worst-fit, best-fit, first-fit",
+    },
+    { .name = "seed", .key = 'S', .has_arg = 1, .arginfo = "N",
+      .usage = "Seed for random number generator (default 1)",
+    },
+    OPTPARSE_TABLE_END
+};
+
+static int parse_range (const char *s, struct range *r)
+{
+    char *endptr;
+
+    errno = 0;
+    r->min = r->max = strtol (s, &endptr, 10);
+    if (errno != 0 || endptr == s || r->min < 1)
+        return -1;
+    if (*endptr == '-') {
+        s = endptr + 1;
+        r->max = strtol (s, &endptr, 10);
+        if (errno != 0 || endptr == s || r->max < r->min)
+            return -1;
+    }
+    if (*endptr != '\0')
+        return -1;
+    return 0;
+}
+
+static int uniform (struct range *r)
+{
+    return r->min + (int)(drand48 () * (r->max - r->min + 1));
+}
+
+static char *read_file (const char *path)
+{
+    int fd;
+    char *s;
+
+    if ((fd = open (path, O_RDONLY)) < 0)
+        log_err_exit ("%s", path);
+    if (read_all (fd, (void **)&s) < 0)
+        log_err_exit ("%s", path);
+    close (fd);
+    return s;
+}
+
+static struct rlist *resources_create (optparse_t *p)
+{
+    struct rlist *rl;
+    const char *path;
+    char *s;
+
+    if ((path = optparse_get_str (p, "R", NULL))) {
+        s = read_file (path);
+        if (!(rl = rlist_from_R (s)))
+            log_msg_exit ("%s: failed to parse R", path);
+        free (s);
+    }
+    else if ((path = optparse_get_str (p, "by-rank", NULL))) {
+        s = read_file (path);
+        if (!(rl = rlist_from_hwloc_by_rank (s, false)))
+            log_msg_exit ("%s: failed to parse by_rank", path);
+        free (s);
+    }
+    else {
+        int nodes = optparse_get_int (p, "nodes", 16);
+        int cores = optparse_get_int (p, "cores", 16);
+        char ids[64];
+        int i;
+
+        if (nodes < 1 || cores < 1)
+            log_msg_exit ("--nodes and --cores must be at least 1");
+        snprintf (ids, sizeof (ids), "0-%d", cores - 1);
+        if (!(rl = rlist_create ()))
+            log_err_exit ("rlist_create");
+        for (i = 0; i < nodes; i++) {
+            if (rlist_append_rank (rl, i, ids) < 0)
+                log_err_exit ("rlist_append_rank");
+        }
+    }
+    if (rl->total == 0)
+        log_msg_exit ("resource set is empty");
+    return rl;
+}
+
+static struct job *jobs_create (optparse_t *p, int njobs)
+{
+    struct job *jobs;
+    struct range size = { 1, 16 };
+    struct range duration = { 1, 60 };
+    double interval = optparse_get_double (p, "interval", 0.);
+    const char *s;
+    double t = 0.;
+    int i;
+
+    if ((s = optparse_get_str (p, "size", NULL)) && parse_range (s, &size) < 0)
+        log_msg_exit ("invalid --size value: %s", s);
+    if ((s = optparse_get_str (p, "duration", NULL))
+        && parse_range (s, &duration) < 0)
+        log_msg_exit ("invalid --duration value: %s", s);
+    if (interval < 0.)
+        log_msg_exit ("invalid --interval value: %f", interval);
+    if (!(jobs = calloc (njobs, sizeof (jobs[0]))))
+        log_err_exit ("calloc");
+    for (i = 0; i < njobs; i++) {
+        jobs[i].id = i;
+        jobs[i].size = uniform (&size);
+        jobs[i].duration = uniform (&duration);
+        jobs[i].t_submit = t;
+        t += drand48 () * 2. * interval;
+    }
+    return jobs;
+}
+
+static int job_end_cmp (const void *a, const void *b)
+{
+    const struct job *j1 = a;
+    const struct job *j2 = b;
+
+    if (j1->t_end < j2->t_end)
+        return -1;
+    if (j1->t_end > j2->t_end)
+        return 1;
+    return j1->id - j2->id;
+}
+
+static int try_alloc (struct bench *b, struct job *job, double now)
+{
+    struct timespec t0;
+
+    b->attempts++;
+    monotime (&t0);
+    job->alloc = rlist_alloc (b->rl, b->mode, 0, job->size, 1);
+    b->alloc_ms += monotime_since (t0);
+    if (!job->alloc) {
+        if (errno != ENOSPC)
+            log_err_exit ("rlist_alloc");
+        return -1;
+    }
+    b->allocs++;
+    job->t_start = now;
+    job->t_end = now + job->duration;
+    b->busy += job->size * job->duration;
+    if (!(job->handle = skiplist_insert (b->running, job)))
+        log_err_exit ("skiplist_insert");
+    return 0;
+}
+
+static void free_job (struct bench *b, struct job *job)
+{
+    struct timespec t0;
+
+    monotime (&t0);
+    if (rlist_free (b->rl, job->alloc) < 0)
+        log_err_exit ("rlist_free");
+    b->free_ms += monotime_since (t0);
+    rlist_destroy (job->alloc);
+    job->alloc = NULL;
+    skiplist_delete (b->running, job->handle);
+    job->handle = NULL;
+}
+
+static void run (struct bench *b)
+{
+    int submitted = 0;
+    int head = 0;
+    double now = 0.;
+    struct job *job;
+
+    while (head < b->njobs) {
+        /* Advance the clock to the next submission or completion.
+         */
+        job = skiplist_first (b->running);
+        if (submitted < b->njobs
+            && (!job || b->jobs[submitted].t_submit <= job->t_end))
+            now = b->jobs[submitted].t_submit;
+        else if (job)
+            now = job->t_end;
+
+        while ((job = skiplist_first (b->running)) && job->t_end <= now) {
+            free_job (b, job);
+        }
+        while (submitted < b->njobs && b->jobs[submitted].t_submit <= now)
+            submitted++;
+
+        /* Allocate in submission order until a job does not fit.
+         */
+        while (head < submitted) {
+            job = &b->jobs[head];
+            if (job->size > b->rl->total) {
+                b->unsatisfiable++;
+                job->t_start = -1.;
+            }
+            else if (try_alloc (b, job, now) < 0)
+                break;
+            head++;
+        }
+    }
+    while ((job = skiplist_first (b->running))) {
+        now = job->t_end;
+        free_job (b, job);
+    }
+    b->makespan = now;
+}
+
+static int double_cmp (const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+
+    return x < y ? -1 : x > y ? 1 : 0;
+}
+
+static double percentile (double *v, int n, int pct)
+{
+    int i = (n * pct) / 100;
+
+    if (n == 0)
+        return 0.;
+    return v[i < n ? i : n - 1];
+}
+
+static void report (struct bench *b)
+{
+    double *wait;
+    int n = 0;
+    int i;
+    char *s;
+
+    if (!(wait = calloc (b->njobs, sizeof (wait[0]))))
+        log_err_exit ("calloc");
+    for (i = 0; i < b->njobs; i++) {
+        if (b->jobs[i].t_start >= 0.)
+            wait[n++] = b->jobs[i].t_start - b->jobs[i].t_submit;
+    }
+    qsort (wait, n, sizeof (wait[0]), double_cmp);
+
+    if (!(s = rlist_dumps (b->rl)))
+        log_err_exit ("rlist_dumps");
+    printf ("resources: %s\n", s);
+    printf ("mode: %s\n", b->mode ? b->mode : "worst-fit");
+    printf ("jobs: %d\n", b->njobs);
+    printf ("allocated: %d\n", b->allocs);
+    printf ("unsatisfiable: %d\n", b->unsatisfiable);
+    printf ("attempts: %d\n", b->attempts);
+    printf ("alloc time: %.3fms\n", b->alloc_ms);
+    printf ("free time: %.3fms\n", b->free_ms);
+    printf ("allocs/s: %.1f\n",
+            b->alloc_ms > 0. ? b->allocs / (b->alloc_ms / 1000.) : 0.);
+    printf ("makespan: %.1fs\n", b->makespan);
+    printf ("latency p50: %.1fs\n", percentile (wait, n, 50));
+    printf ("latency p90: %.1fs\n", percentile (wait, n, 90));
+    printf ("latency p99: %.1fs\n", percentile (wait, n, 99));
+    printf ("latency max: %.1fs\n", percentile (wait, n, 100));
+    printf ("utilization: %.1f%%\n",
+            b->makespan > 0. ?
+            100. * b->busy / (b->rl->total * b->makespan) : 0.);
+    free (s);
+    free (wait);
+}
+
+int main (int argc, char *argv[])
+{
+    optparse_t *p;
+    struct bench b;
+
+    log_init ("sched-bench");
+
+    if (!(p = optparse_create ("sched-bench")))
+        log_msg_exit ("optparse_create");
+    if (optparse_add_option_table (p, opts) != OPTPARSE_SUCCESS)
+        log_msg_exit ("optparse_add_option_table");
+    if (optparse_parse_args (p, argc, argv) < 0)
+        exit (1);
+
+    memset (&b, 0, sizeof (b));
+    b.mode = optparse_get_str (p, "mode", NULL);
+    if (b.mode && strcmp (b.mode, "worst-fit")
+               && strcmp (b.mode, "best-fit")
+               && strcmp (b.mode, "first-fit"))
+        log_msg_exit ("invalid --mode value: %s", b.mode);
+    if ((b.njobs = optparse_get_int (p, "jobs", 1000)) < 1)
+        log_msg_exit ("--jobs must be at least 1");
+    srand48 (optparse_get_int (p, "seed", 1));
+
+    b.rl = resources_create (p);
+    b.jobs = jobs_create (p, b.njobs);
+    if (!(b.running = skiplist_create (job_end_cmp)))
+        log_err_exit ("skiplist_create");
+
+    run (&b);
+    report (&b);
+
+    skiplist_destroy (b.running);
+    rlist_destroy (b.rl);
+    free (b.jobs);
+    optparse_destroy (p);
+    log_fini ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
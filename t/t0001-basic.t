@@ -61,9 +61,94 @@ test_expect_success 'flux-start with size 2 has a peer' "
 	flux start ${ARGS} --size=2 'flux comms lspeer' > idle.out &&
         grep 'idle' idle.out
 "
+test_expect_success 'overlay works with message batching enabled' "
+	flux start ${ARGS},-Stbon.batch-count=16 --size=4 \
+		'flux exec flux getattr rank && flux ping --count=64 --batch 3' \
+		>batch.out &&
+	test \$(grep -c '^[0-3]\$' batch.out) -eq 4
+"
+test_expect_success 'tbon.event-replay-size can be set on the command line' "
+	flux start ${ARGS},-Stbon.event-replay-size=4 --size=4 \
+		'flux exec flux getattr tbon.event-replay-size' >replay.out &&
+	test \$(grep -c '^4\$' replay.out) -eq 4
+"
+test_expect_success 'overlay works with compression enabled' "
+	flux start ${ARGS},-Stbon.compress-threshold=256 --size=4 \
+		'flux exec flux getattr rank && \
+		flux ping --count=8 --pad=4096 3 && \
+		flux exec -r 1 flux comms stats' >compress.out &&
+	test \$(grep -c '^[0-3]\$' compress.out) -eq 4 &&
+	grep '\"compress\": *{\"count\": *[1-9]' compress.out
+"
+test_expect_success 'flux comms traffic counts requests by topic' "
+	flux start ${ARGS} --size=2 \
+		'flux ping --count=3 0 && flux comms traffic' >traffic.out &&
+	grep '^cmb.ping  *3 ' traffic.out &&
+	grep '^broker.stats  *1 ' traffic.out &&
+	grep '^1 ' traffic.out
+"
+test_expect_success 'flux comms traffic --clear resets counters' "
+	flux start ${ARGS} --size=1 \
+		'flux comms traffic --clear >/dev/null && \
+		flux comms traffic --json' >traffic.json &&
+	grep '\"broker.stats\": *{\"count\": *1,' traffic.json
+"
+test_expect_success 'FLUX_HANDLE_RPCTRACE traces an RPC across brokers' "
+	flux start ${ARGS} --size=2 \
+		'FLUX_HANDLE_RPCTRACE=1 flux ping --count=1 1 && \
+		flux comms trace -r 1' >rpctrace.out &&
+	grep ' overlay.rx  *request  *cmb.ping\$' rpctrace.out &&
+	grep ' dispatch  *request  *cmb.ping\$' rpctrace.out &&
+	grep ' overlay.tx  *response  *cmb.ping\$' rpctrace.out
+"
+test_expect_success 'flux comms trace does not record untraced RPCs' "
+	flux start ${ARGS} --size=1 \
+		'flux ping --count=1 0 >/dev/null && flux comms trace' >notrace.out &&
+	test_must_be_empty notrace.out
+"
+test_expect_success 'hello.mode defaults to children, logs level wireup' "
+	flux start ${ARGS} --size=4 \
+		'flux getattr hello.mode && flux dmesg' >hello.out &&
+	grep '^children\$' hello.out &&
+	grep 'wireup: level 2 complete' hello.out
+"
+test_expect_success 'hello.mode=subtree works' "
+	flux start ${ARGS},-Shello.mode=subtree --size=4 \
+		'flux getattr hello.mode' >hello_subtree.out &&
+	grep '^subtree\$' hello_subtree.out
+"
+test_expect_success 'hello.mode rejects an unknown mode' "
+	test_must_fail flux start ${ARGS},-Shello.mode=bogus /bin/true
+"
+test_expect_success 'tbon.compress-codec rejects an unknown codec' "
+	test_must_fail flux start ${ARGS},-Stbon.compress-codec=gzip \
+		/bin/true
+"
 test_expect_success 'flux-start --size=1 --bootstrap=selfpmi works' "
 	flux start ${ARGS} --size=1 --bootstrap=selfpmi /bin/true
 "
+test_expect_success 'flux-start -v reports time to each PMI barrier' "
+	flux start ${ARGS} --size=2 -v /bin/true 2>barrier.err &&
+	grep 'PMI barrier 1: 2 brokers after' barrier.err &&
+	grep 'PMI barrier 2: 2 brokers after' barrier.err
+"
+test_expect_success 'flux-start --lightweight sets init.lightweight' "
+	flux start ${ARGS} --size=2 --lightweight \
+		flux exec -r 1 flux getattr init.lightweight >lightweight.out &&
+	test \$(cat lightweight.out) = 1
+"
+test_expect_success 'flux-start --lightweight skips heavy modules on rank 1' "
+	flux start --size=2 --lightweight \
+		flux exec -r 1 flux module list >lightweight_lsmod.out &&
+	grep '^kvs ' lightweight_lsmod.out &&
+	grep '^barrier ' lightweight_lsmod.out &&
+	test_must_fail grep -w kvs-watch lightweight_lsmod.out &&
+	test_must_fail grep -w job-ingest lightweight_lsmod.out
+"
+test_expect_success 'flux-start --lightweight instance can run a job on rank 1' "
+	flux start --size=2 --lightweight \
+		flux exec -r 1 flux mini run -N1 hostname
+"
 test_expect_success 'flux-start --bootstrap=selfpmi fails (no size specified)' "
 	test_must_fail flux start ${ARGS} --bootstrap=selfpmi /bin/true
 "
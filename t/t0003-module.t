@@ -8,6 +8,8 @@ Verify module load/unload/list
 
 . `dirname $0`/sharness.sh
 SIZE=4
+RPC=${FLUX_BUILD_DIR}/t/request/rpc
+
 test_under_flux ${SIZE} minimal
 
 invalid_rank() {
@@ -27,6 +29,12 @@ test_expect_success 'module: lsmod shows test module' '
 	flux module list | grep parent
 '
 
+test_expect_success 'module: lsmod shows init time of test module' '
+	flux module list >init.out &&
+	grep "^Module .* Init  S" init.out &&
+	grep "^parent .* [0-9]*\.[0-9][0-9][0-9]  [RS] " init.out
+'
+
 test_expect_success 'module: cannot load the same module twice' '
 	test_must_fail flux module load \
 		${FLUX_BUILD_DIR}/t/module/.libs/parent.so
@@ -124,6 +132,33 @@ test_expect_success 'module: unload test module (all ranks)' '
 	flux exec -r all flux module remove parent
 '
 
+test_expect_success 'module: remove -r all removes module from all ranks' '
+	flux exec -r all flux module load \
+		${FLUX_BUILD_DIR}/t/module/.libs/parent.so &&
+	flux module remove -r all parent &&
+	flux exec -r all flux module list >rmall.out &&
+	test_must_fail grep parent rmall.out
+'
+
+test_expect_success 'module: remove -r all -x 0 spares rank 0' '
+	flux exec -r all flux module load \
+		${FLUX_BUILD_DIR}/t/module/.libs/parent.so &&
+	flux module remove -r all -x 0 parent &&
+	flux module list | grep parent &&
+	flux exec -r all -x 0 flux module list >rmx.out &&
+	test_must_fail grep parent rmx.out &&
+	flux module remove parent
+'
+
+test_expect_success 'module: remove -r all fails if module is not loaded' '
+	test_must_fail flux module remove -r all parent 2>rmall.err &&
+	grep "rank 0" rmall.err
+'
+
+test_expect_success 'module: remove -f -r all ignores missing module' '
+	flux module remove -f -r all parent
+'
+
 test_expect_success 'module: insmod returns initialization error' '
 	test_must_fail flux module load \
 		${FLUX_BUILD_DIR}/t/module/.libs/parent.so --init-failure
@@ -244,6 +279,103 @@ test_expect_success 'flux module stats --rusage --parse maxrss works' '
 	test "$RSS" -gt 0
 '
 
+test_expect_success 'flux module stats --rusage reports message cache stats' '
+	ALLOC=$(flux module stats --rusage --parse msgcache.msg-alloc $TESTMOD) &&
+	REUSE=$(flux module stats --rusage --parse msgcache.msg-reuse $TESTMOD) &&
+	test $(($ALLOC+$REUSE)) -gt 0
+'
+
+test_expect_success 'flux module stats --rusage reports reactor stats' '
+	flux module stats --rusage --parse reactor.timers $TESTMOD &&
+	flux module stats --rusage --parse reactor.coarse-timers $TESTMOD
+'
+
+test_expect_success 'flux module stats --profile reports watcher stats' '
+	test $(flux module stats --profile --parse enabled $TESTMOD) = "true" &&
+	COUNT=$(flux module stats --profile --parse watchers.handle.count $TESTMOD) &&
+	test $COUNT -gt 0
+'
+
+test_expect_success HAVE_JQ 'flux module stats --profile reports request stats' '
+	flux module stats --profile $TESTMOD >profile.json &&
+	jq -e ".request[\"${TESTMOD}.profile\"].count > 0" <profile.json
+'
+
+test_expect_success 'flux module stats --clear clears profile stats' '
+	flux module stats --rusage $TESTMOD &&
+	flux module stats --profile --parse request $TESTMOD >before.out &&
+	grep -q ${TESTMOD}.rusage before.out &&
+	flux module stats --clear $TESTMOD &&
+	flux module stats --profile --parse request $TESTMOD >after.out &&
+	test_must_fail grep -q ${TESTMOD}.rusage after.out
+'
+
+# test memory accounting
+
+test_expect_success 'flux module list shows Memory column' '
+	flux module list >list.out &&
+	grep -q "Memory" list.out
+'
+test_expect_success 'flux module memory reports usage' '
+	flux module memory $TESTMOD >memory.out &&
+	grep -q "^usage: " memory.out &&
+	grep -q "^peak: " memory.out &&
+	grep -q "^limit: 0$" memory.out &&
+	grep -q "^sheds: " memory.out
+'
+test_expect_success 'flux module memory --limit sets soft limit' '
+	flux module memory --limit=1.5K $TESTMOD >limit.out &&
+	grep -q "^limit: 1536$" limit.out &&
+	flux module memory --limit=0 $TESTMOD >limit0.out &&
+	grep -q "^limit: 0$" limit0.out
+'
+test_expect_success 'flux module memory --limit fails on invalid size' '
+	test_must_fail flux module memory --limit=1X $TESTMOD &&
+	test_must_fail flux module memory --limit=-1 $TESTMOD
+'
+test_expect_success 'flux module memory fails on unknown module' '
+	test_must_fail flux module memory nosuchmodule
+'
+
+# test placement
+
+first_cpu() {
+	awk '/^Cpus_allowed_list/ {split($2,a,/[-,]/); print a[1]}' \
+		/proc/self/status
+}
+test -d /sys/devices/system/node/node0 && test_set_prereq NUMA
+
+test_expect_success 'flux module list --placement shows Cpus and Numa' '
+	flux module list --placement >placement.out &&
+	grep "^Module .* Cpus .* Numa  S" placement.out &&
+	grep "^connector-local " placement.out
+'
+test_expect_success 'flux module load --cpus places module thread' '
+	CPU=$(first_cpu) &&
+	flux module load --cpus=$CPU \
+		${FLUX_BUILD_DIR}/t/module/.libs/parent.so &&
+	flux module list --placement >cpus.out &&
+	grep "^parent  *$CPU " cpus.out &&
+	flux module remove parent
+'
+test_expect_success NUMA 'flux module load --numa places module thread' '
+	flux module load --numa=0 \
+		${FLUX_BUILD_DIR}/t/module/.libs/parent.so &&
+	flux module list --placement >numa.out &&
+	grep "^parent  *[0-9,-]*  *0  " numa.out &&
+	flux module remove parent
+'
+test_expect_success 'flux module load --cpus fails on invalid idset' '
+	test_must_fail flux module load --cpus=foo \
+		${FLUX_BUILD_DIR}/t/module/.libs/parent.so &&
+	! flux module list | grep parent
+'
+test_expect_success 'flux module load --numa fails on unknown node' '
+	test_must_fail flux module load --numa=100000 \
+		${FLUX_BUILD_DIR}/t/module/.libs/parent.so &&
+	! flux module list | grep parent
+'
+
 # try to hit some error cases
 
 test_expect_success 'flux module with no arguments prints usage and fails' '
@@ -278,4 +410,40 @@ test_expect_success 'flux_module_set_running - remove test module' '
 	flux module remove running
 '
 
+test_expect_success 'flux_module_set_workers - load test module' '
+	flux module load ${FLUX_BUILD_DIR}/t/module/.libs/workers.so
+'
+test_expect_success 'flux_module_set_workers - requests reach a worker' '
+	echo "{}" | ${RPC} workers.info >info.out &&
+	jq -e ".worker >= 0 and .worker < 4" <info.out
+'
+test_expect_success 'flux_module_set_workers - same key goes to same worker' '
+	echo "{\"key\":\"ns0\"}" | ${RPC} workers.info >key1.out &&
+	echo "{\"key\":\"ns0\"}" | ${RPC} workers.info >key2.out &&
+	test_cmp key1.out key2.out
+'
+test_expect_success 'flux_module_set_workers - keys are spread across workers' '
+	for i in 0 1 2 3 4 5 6 7; do \
+		echo "{\"key\":\"ns$i\"}" | ${RPC} workers.info \
+			| jq .worker || return 1; \
+	done | sort -u >workers.out &&
+	test $(wc -l <workers.out) -gt 1
+'
+test_expect_success 'flux_module_set_workers - worker can make RPCs' '
+	echo "{\"key\":\"ns1\"}" | ${RPC} workers.rank >rank.out &&
+	jq -e ".rank == \"0\"" <rank.out
+'
+test_expect_success 'flux_module_set_workers - remove test module' '
+	flux module remove workers
+'
+test_expect_success 'flux_module_set_workers - reload test module' '
+	flux module load ${FLUX_BUILD_DIR}/t/module/.libs/workers.so
+'
+test_expect_success 'flux_module_set_workers - block a worker in an RPC' '
+	echo "{}" | ${RPC} workers.block
+'
+test_expect_success 'flux_module_set_workers - remove does not hang' '
+	run_timeout 30 flux module remove workers
+'
+
 test_done
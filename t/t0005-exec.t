@@ -240,4 +240,48 @@ test_expect_success 'stdin broadcast -- long lines' '
 	done
 '
 
+test_expect_success 'exec --tree merges identical output lines' '
+	flux exec -t -r0-3 echo hello >tree.out &&
+	echo "0-3: hello" >tree.exp &&
+	test_cmp tree.exp tree.out
+'
+
+test_expect_success 'exec --tree labels distinct output with its rank' '
+	flux exec -t flux getattr rank | sort -n >tree_ranks.out &&
+	cat >tree_ranks.exp <<-EOT &&
+	0: 0
+	1: 1
+	2: 2
+	3: 3
+	EOT
+	test_cmp tree_ranks.exp tree_ranks.out
+'
+
+test_expect_success 'exec --tree preserves the order of output lines' '
+	flux exec -t -r1-3 sh -c "echo a; echo b; echo c" >tree_order.out &&
+	cat >tree_order.exp <<-EOT &&
+	1-3: a
+	1-3: b
+	1-3: c
+	EOT
+	test_cmp tree_order.exp tree_order.out
+'
+
+test_expect_success 'exec --tree merges exit status' '
+	test_expect_code 3 flux exec -t -r1-3 sh -c "exit 3" 2>tree_exit.err &&
+	grep "^\[1-3\]: Exit 3" tree_exit.err
+'
+
+test_expect_success 'exec --tree reports command not found' '
+	test_expect_code 127 flux exec -t ./nosuchprocess 2>tree_noent.err &&
+	grep "No such file or directory" tree_noent.err
+'
+
+test_expect_success 'exec --tree to valid and invalid ranks works' '
+	test_expect_code 68 flux exec -t -r 0,$(invalid_rank) echo working \
+		>tree_inval.out 2>tree_inval.err &&
+	grep "^0: working" tree_inval.out &&
+	grep "No route to host" tree_inval.err
+'
+
 test_done
@@ -115,6 +115,23 @@ test_expect_success 'basic rexec stdin / stdout long lines' '
         test_cmp expected output
 '
 
+test_expect_success 'rexec large output is delivered intact' '
+        dd if=/dev/urandom bs=65536 count=16 | base64 >expected.large &&
+        ${FLUX_BUILD_DIR}/t/rexec/rexec -r 1 cat expected.large > output.large &&
+        test_cmp expected.large output.large
+'
+
+test_expect_success 'rexec output larger than the buffer is flow controlled' '
+        ${FLUX_BUILD_DIR}/t/rexec/rexec -r 1 -b 8192 cat expected.large > output.small &&
+        test_cmp expected.large output.small
+'
+
+test_expect_success 'rexec binary output is delivered intact' '
+        dd if=/dev/urandom of=expected.bin bs=65536 count=4 &&
+        ${FLUX_BUILD_DIR}/t/rexec/rexec -r 1 cat expected.bin > output.bin &&
+        cmp expected.bin output.bin
+'
+
 # pipe in /dev/null, we don't care about stdin for this test
 test_expect_success 'rexec check channel FD created' '
 	${FLUX_BUILD_DIR}/t/rexec/rexec -i TEST_CHANNEL /usr/bin/env < /dev/null > output 2>&1 &&
@@ -231,4 +248,11 @@ test_expect_success 'rexec read_getline call works on remote streams' '
         test_cmp expected output
 '
 
+test_expect_success HAVE_JQ 'rexec.stats reports spawn count and latency' '
+	echo "{}" | ${FLUX_BUILD_DIR}/t/request/rpc cmb.rexec.stats > stats.out &&
+	count=$($jq ".spawn.count" < stats.out) &&
+	test "$count" -gt 0 &&
+	$jq -e ".spawn.\"time-max\" >= 0" < stats.out
+'
+
 test_done
@@ -59,6 +59,51 @@ test_expect_success 'ring buffer wraps over old entries' '
 	! flux dmesg | grep -q hello_wrap1 &&
 	flux setattr log-ring-size $OLD_RINGSIZE
 '
+test_expect_success 'flux setattr log-ring-size keeps newest entries' '
+	OLD_RINGSIZE=`flux getattr log-ring-size` &&
+	seq 1 8 | flux logger --appname=resizetest &&
+	flux setattr log-ring-size 3 &&
+	flux setattr log-ring-size $OLD_RINGSIZE &&
+	flux dmesg | grep resizetest | sed -e "s/.*: //" >resize.out &&
+	test $(wc -l <resize.out) -le 3 &&
+	test "$(tail -1 resize.out)" = "8"
+'
+test_expect_success 'flux dmesg returns more entries than fit in one response' '
+	seq 1 200 | flux logger --appname=chunktest &&
+	flux dmesg | grep chunktest | sed -e "s/.*: //" >chunktest.out &&
+	seq 1 200 >chunktest.exp &&
+	test_cmp chunktest.exp chunktest.out
+'
+test_expect_success 'flux dmesg -f prints new entries' '
+	flux dmesg -f >follow.out &
+	pid=$! &&
+	flux logger hello_follow &&
+	i=0 &&
+	while ! grep -q hello_follow follow.out && test $i -lt 100; do
+		sleep 0.1
+		i=$((i+1))
+	done &&
+	kill $pid &&
+	grep -q hello_follow follow.out
+'
+test_expect_success 'flux getattr log-forward-window, log-forward-rate work' '
+	test "$(flux getattr log-forward-window)" = "1" &&
+	test "$(flux getattr log-forward-rate)" = "1000"
+'
+test_expect_success 'flux setattr log-forward-window rejects negative value' '
+	test_must_fail flux setattr log-forward-window -1
+'
+test_expect_success 'identical messages from downstream ranks are collapsed' '
+	flux setattr log-filename agg.log &&
+	flux exec -r 1-3 sh -c "flux logger hello_agg; flux logger hello_agg" &&
+	i=0 &&
+	while ! grep -q "hello_agg (.* occurrences)" agg.log \
+		&& test $i -lt 100; do
+		sleep 0.1
+		i=$((i+1))
+	done &&
+	grep "hello_agg (.* occurrences)" agg.log
+'
 
 test_expect_success 'multi-line log messages are split' '
 	seq 1 8 | flux logger --appname=linesplit1 &&
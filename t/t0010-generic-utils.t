@@ -79,4 +79,31 @@ test_expect_success 'heaptrace.dump request with empty payload fails with EPROTO
 	${RPC} heaptrace.dump 71 </dev/null
 '
 
+stackprof_error_check()
+{
+	output=$(flux stackprof "$@" 2>&1) \
+		|| echo $output | grep -q "Function not implemented"
+}
+
+# stackprof requires backtrace(3), so ENOSYS is a valid response.
+test_expect_success 'stackprof start, stop, and dump work' '
+	stackprof_error_check start --frequency=997 &&
+	for i in $(seq 1 50); do flux getattr rank >/dev/null; done &&
+	stackprof_error_check stop &&
+	stackprof_error_check dump
+'
+test_expect_success 'stackprof start works with the lowest frequency' '
+	stackprof_error_check start --frequency=1 &&
+	stackprof_error_check stop
+'
+test_expect_success 'stackprof stop fails when not running' '
+	test_must_fail flux stackprof stop
+'
+test_expect_success 'stackprof.start request with empty payload fails with EPROTO(71)' '
+	${RPC} stackprof.start 71 </dev/null
+'
+test_expect_success 'stackprof.start with bad frequency fails with EINVAL(22)' '
+	echo "{\"frequency\":0}" | ${RPC} stackprof.start 22
+'
+
 test_done
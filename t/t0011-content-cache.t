@@ -181,6 +181,99 @@ test_expect_success 'store 1K blobs from all ranks using async RPC' '
 	flux exec -n flux content spam 1024 256 >/dev/null
 '
 
+test_expect_success 'rank 1 cache counts a miss, then a hit' '
+	ARCREF=`echo arctest | flux content store` &&
+	MISSES=`flux exec -r 1 flux module stats --type int --parse misses content` &&
+	HITS=`flux exec -r 1 flux module stats --type int --parse hits content` &&
+	flux exec -r 1 flux content load $ARCREF >/dev/null &&
+	flux exec -r 1 flux content load $ARCREF >/dev/null &&
+	MISSES2=`flux exec -r 1 flux module stats --type int --parse misses content` &&
+	HITS2=`flux exec -r 1 flux module stats --type int --parse hits content` &&
+	test $MISSES2 -eq $(($MISSES+1)) &&
+	test $HITS2 -eq $(($HITS+1))
+'
+test_expect_success 'content stats include ghost-hits' '
+	flux module stats --type int --parse ghost-hits content
+'
+
+test_expect_success 'loading a dir on rank 1 reads its entries ahead' '
+	REF1=$(echo readahead1 | flux content store) &&
+	REF2=$(echo readahead2 | flux content store) &&
+	REF3=$(echo readahead3 | flux content store) &&
+	DIRREF=$(printf "{\"ver\":1,\"type\":\"dir\",\"data\":{\"a\":{\"ver\":1,\"type\":\"valref\",\"data\":[\"$REF1\",\"$REF2\"]},\"b\":{\"ver\":1,\"type\":\"dirref\",\"data\":[\"$REF3\"]}}}" \
+		| flux content store) &&
+	ISSUED=$(flux exec -r 1 flux module stats --type int \
+		--parse prefetch-issued content) &&
+	flux exec -r 1 flux content load $DIRREF >/dev/null &&
+	ISSUED2=$(flux exec -r 1 flux module stats --type int \
+		--parse prefetch-issued content) &&
+	test $ISSUED2 -eq $(($ISSUED+3))
+'
+test_expect_success 'loading a dir entry counts a prefetch hit' '
+	HITS=$(flux exec -r 1 flux module stats --type int \
+		--parse prefetch-hits content) &&
+	flux exec -r 1 flux content load $REF1 >readahead1.out &&
+	echo readahead1 >readahead1.exp &&
+	test_cmp readahead1.exp readahead1.out &&
+	HITS2=$(flux exec -r 1 flux module stats --type int \
+		--parse prefetch-hits content) &&
+	test $HITS2 -eq $(($HITS+1))
+'
+test_expect_success 'readahead can be disabled' '
+	flux exec -r 1 flux setattr content.prefetch-limit 0 &&
+	REF4=$(echo readahead4 | flux content store) &&
+	DIRREF2=$(printf "{\"ver\":1,\"type\":\"dir\",\"data\":{\"a\":{\"ver\":1,\"type\":\"valref\",\"data\":[\"$REF4\"]}}}" \
+		| flux content store) &&
+	ISSUED=$(flux exec -r 1 flux module stats --type int \
+		--parse prefetch-issued content) &&
+	flux exec -r 1 flux content load $DIRREF2 >/dev/null &&
+	ISSUED2=$(flux exec -r 1 flux module stats --type int \
+		--parse prefetch-issued content) &&
+	test $ISSUED2 -eq $ISSUED
+'
+
+test_expect_success 'rank 1 write-back coalesces stores into batches' '
+	flux exec -r 1 flux setattr content.writeback-window 1000 &&
+	BATCHES=$(flux exec -r 1 flux module stats --type int \
+		--parse writeback-batches content) &&
+	flux exec -r 1 sh -c "for i in 1 2 3 4; do \
+		echo writeback\$i | flux content store >writeback\$i.ref & \
+		done; wait" &&
+	BATCHES2=$(flux exec -r 1 flux module stats --type int \
+		--parse writeback-batches content) &&
+	test $BATCHES2 -gt $BATCHES &&
+	test $BATCHES2 -lt $(($BATCHES+4))
+'
+test_expect_success 'write-back blobs are on rank 0' '
+	for i in 1 2 3 4; do \
+		echo writeback$i >writeback.exp &&
+		flux content load $(cat writeback$i.ref) >writeback.out &&
+		test_cmp writeback.exp writeback.out || return 1; \
+	done
+'
+test_expect_success 'rank 1 flush does not wait out the write-back window' '
+	flux exec -r 1 flux setattr content.writeback-window 60000 &&
+	run_timeout 30 flux exec -r 1 sh -c "echo writeback5 | flux content store & \
+		sleep 0.5; flux content flush; wait" &&
+	flux exec -r 1 flux setattr content.writeback-window 0
+'
+test_expect_success 'content.purge-period cannot be changed at runtime' '
+	test_must_fail flux setattr content.purge-period 100
+'
+test_expect_success 'rank 1 cache is purged by timer with content.purge-period' '
+	cat >purge.sh <<-EOT &&
+	#!/bin/sh
+	flux exec -r 1 sh -c "echo purge1 | flux content store" >/dev/null &&
+	sleep 1 &&
+	flux exec -r 1 flux getattr content.acct-entries
+	EOT
+	chmod +x purge.sh &&
+	flux start -s2 -o,-Scontent.purge-period=100 \
+		-o,-Scontent.purge-target-entries=0 \
+		-o,-Scontent.purge-old-entry=1 \
+		./purge.sh >purge.out &&
+	test "$(cat purge.out)" = "0"
+'
 test_expect_success 'load request with empty payload fails with EPROTO(71)' '
 	${RPC} content.load 71 </dev/null
 '
@@ -161,5 +161,156 @@ test_expect_success 'remove content-sqlite module on rank 0' '
 	flux module remove content-sqlite
 '
 
+test_expect_success 'content-sqlite fails to load with bad journal-mode' '
+	test_must_fail flux module load content-sqlite journal-mode=badmode
+'
+
+test_expect_success 'content-sqlite fails to load with bad transaction-max' '
+	test_must_fail flux module load content-sqlite transaction-max=0
+'
+
+test_expect_success 'load content-sqlite with tuning options' '
+	flux module load content-sqlite journal-mode=delete synchronous=normal \
+		mmap-size=1048576 cache-size=-4096 transaction-max=4
+'
+
+test_expect_success 'store 100 blobs with small transactions' '
+	store_junk txn 100 &&
+	flux content flush
+'
+
+test_expect_success 'blobs can be loaded after reload' '
+	flux module remove content-sqlite &&
+	flux module load content-sqlite transaction-max=4 &&
+	echo txn:99 | $BLOBREF $HASHFUN >txn99.hash &&
+	flux content load --bypass-cache $(cat txn99.hash) >txn99.out &&
+	echo txn:99 >txn99.exp &&
+	test_cmp txn99.exp txn99.out
+'
+
+test_expect_success 'remove content-sqlite module on rank 0' '
+	flux module remove content-sqlite
+'
+
+test_expect_success 'content-sqlite fails to load with unknown codec' '
+	test_must_fail flux module load content-sqlite codec=badcodec
+'
+
+test_expect_success 'load content-sqlite with codec=none' '
+	flux module load content-sqlite codec=none
+'
+
+test_expect_success 'store a large blob with codec=none' '
+	dd if=/dev/zero count=64 bs=4096 >zero.store 2>/dev/null &&
+	flux content store --bypass-cache <zero.store >zero.hash
+'
+
+test_expect_success HAVE_JQ 'content stats report codec and ratio' '
+	flux module stats content >stats.json &&
+	jq -e ".backing.codec == \"none\"" <stats.json &&
+	jq -e ".backing.codecs.none.count >= 1" <stats.json &&
+	jq -e ".backing.ratio == 1" <stats.json
+'
+
+test_expect_success 'reload content-sqlite with default codec' '
+	flux module remove content-sqlite &&
+	flux module load content-sqlite
+'
+
+test_expect_success 'blob stored with codec=none can be loaded' '
+	flux content load --bypass-cache $(cat zero.hash) >zero.load &&
+	test_cmp zero.store zero.load
+'
+
+test_expect_success 'blob stored before the codec change can be loaded' '
+	flux content load --bypass-cache $(cat 1m.0.hash) >1m.0.load2 &&
+	test_cmp 1m.0.store 1m.0.load2
+'
+
+test_expect_success HAVE_JQ 'compressible blob is compressed with lz4' '
+	dd if=/dev/zero count=64 bs=4097 >zero2.store 2>/dev/null &&
+	flux content store --bypass-cache <zero2.store >zero2.hash &&
+	flux module stats content >stats2.json &&
+	jq -e ".backing.codec == \"lz4\"" <stats2.json &&
+	jq -e ".backing.codecs.lz4.count >= 1" <stats2.json &&
+	jq -e ".backing.ratio > 1" <stats2.json
+'
+
+test_expect_success 'store of a blob already in backing store is deduplicated' '
+	echo dedup-test | flux content store >dedup.hash &&
+	flux content flush &&
+	flux content dropcache &&
+	DEDUP=`flux module stats --type int --parse dedup-hits content` &&
+	echo dedup-test | flux content store >dedup2.hash &&
+	flux content flush &&
+	DEDUP2=`flux module stats --type int --parse dedup-hits content` &&
+	test_cmp dedup.hash dedup2.hash &&
+	test $DEDUP2 -eq $(($DEDUP+1))
+'
+
+test_expect_success 'deduplicated blob can be loaded' '
+	flux content dropcache &&
+	flux content load $(cat dedup.hash) >dedup.load &&
+	echo dedup-test >dedup.store &&
+	test_cmp dedup.store dedup.load
+'
+
+test_expect_success 'content-sqlite fails to load with bad gc-batch' '
+	flux module remove content-sqlite &&
+	test_must_fail flux module load content-sqlite gc-batch=0 &&
+	flux module load content-sqlite gc-batch=2
+'
+
+test_expect_success HAVE_JQ 'store a tree referenced by a checkpoint' '
+	echo gc-val | flux content store >gcval.hash &&
+	jq -j -c -n "{data:{a:{data:[\"$(cat gcval.hash)\"],type:\"valref\",\
+ver:1}},type:\"dir\",ver:1}" | flux content store >gcdir.hash &&
+	echo gc-junk | flux content store >gcjunk.hash &&
+	flux content flush &&
+	kvs_checkpoint_put gc-test $(cat gcdir.hash)
+'
+
+test_expect_success HAVE_JQ 'flux content gc deletes unreachable blobs' '
+	flux content gc -v 2>gc.err &&
+	cat gc.err &&
+	grep "^deleted [1-9]" gc.err &&
+	test_must_fail flux content load --bypass-cache $(cat gcjunk.hash)
+'
+
+test_expect_success HAVE_JQ 'blobs reachable from the checkpoint remain' '
+	echo gc-val >gcval.exp &&
+	flux content load --bypass-cache $(cat gcval.hash) >gcval.out &&
+	test_cmp gcval.exp gcval.out &&
+	flux content load --bypass-cache $(cat gcdir.hash) >/dev/null
+'
+
+test_expect_success HAVE_JQ 'content stats report the gc run' '
+	flux module stats content >gcstats.json &&
+	jq -e ".backing.gc.state == \"idle\"" <gcstats.json &&
+	jq -e ".backing.gc.runs == 1" <gcstats.json &&
+	jq -e ".backing.gc.roots == 1" <gcstats.json &&
+	jq -e ".backing.gc.deleted >= 1" <gcstats.json &&
+	jq -e ".backing.gc.cursor == .backing.gc.horizon" <gcstats.json
+'
+
+test_expect_success HAVE_JQ 'second gc run deletes nothing' '
+	flux content gc -v 2>gc2.err &&
+	grep "^deleted 0 of 2 blobs" gc2.err
+'
+
+test_expect_success HAVE_JQ 'a blob stored again after gc can be loaded' '
+	echo gc-junk | flux content store >gcjunk2.hash &&
+	test_cmp gcjunk.hash gcjunk2.hash &&
+	flux content flush &&
+	flux content dropcache &&
+	flux content load --bypass-cache $(cat gcjunk.hash) >gcjunk.out &&
+	echo gc-junk >gcjunk.exp &&
+	test_cmp gcjunk.exp gcjunk.out
+'
+
+test_expect_success 'remove content-sqlite module on rank 0' '
+	flux module remove content-sqlite
+'
+
 
 test_done
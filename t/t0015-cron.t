@@ -305,6 +305,26 @@ test_expect_success 'flux cron sync can set epsilon' '
     flux cron sync | grep 42.000s
 '
 
+##  Reload cron module with a limit on running tasks
+test_expect_success 'module reload with max_tasks=1' '
+    flux module reload cron max_tasks=1
+'
+test_expect_success 'tasks beyond max_tasks wait for a running task' '
+    id1=$(flux_cron event t.throttle sleep 1) &&
+    id2=$(flux_cron event t.throttle sleep 1) &&
+    test_when_finished "flux cron delete ${id1}; flux cron delete ${id2}" &&
+    flux event pub t.throttle &&
+    sleep 0.5 &&
+    flux cron dump --key=task.1.state ${id1} >throttle.out &&
+    flux cron dump --key=task.1.state ${id2} >>throttle.out &&
+    printf "Deferred\nRunning\n" >throttle.exp &&
+    sort throttle.out >throttle.sorted &&
+    test_cmp throttle.exp throttle.sorted &&
+    sleep 2.5 &&
+    cron_entry_check ${id1} task.1.state Exited &&
+    cron_entry_check ${id2} task.1.state Exited
+'
+
 test_expect_success 'create request with empty payload fails with EPROTO(71)' '
 	${RPC} cron.create 71 </dev/null
 '
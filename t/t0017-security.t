@@ -75,6 +75,50 @@ test_expect_success 'reconfig with bad TOML fails' '
 	test_must_fail flux config reload
 '
 
+test_expect_success 'connector-local sets send-hwm on reconfig' '
+	flux dmesg --clear &&
+	cat >connector.toml <<-EOT &&
+	[connector-local]
+	send-hwm = 4096
+	EOT
+	flux config reload &&
+	flux dmesg | grep connector-local >dmesg-hwm.out &&
+	grep send-hwm=4096 dmesg-hwm.out
+'
+
+test_expect_success 'connector-local reconfig fails on negative send-hwm' '
+	cat >connector.toml <<-EOT &&
+	[connector-local]
+	send-hwm = -1
+	EOT
+	test_must_fail flux config reload 2>reload-hwm.err &&
+	grep send-hwm reload-hwm.err &&
+	rm connector.toml &&
+	flux config reload
+'
+
+test_expect_success 'local connector works over shared memory rings' '
+	FLUX_LOCAL_CONNECTOR_SHMEM_SIZE=65536 \
+		flux ping --count=4 --pad=262144 broker &&
+	FLUX_LOCAL_CONNECTOR_SHMEM_SIZE=65536 flux getattr rank
+'
+
+test_expect_success 'local connector falls back to socket if shmem is refused' '
+	cat >connector.toml <<-EOT &&
+	[connector-local]
+	shmem = false
+	EOT
+	flux config reload &&
+	FLUX_LOCAL_CONNECTOR_SHMEM_SIZE=65536 \
+		flux ping --count=2 --pad=4096 broker &&
+	rm connector.toml &&
+	flux config reload
+'
+
+test_expect_success 'local connector rejects bad FLUX_LOCAL_CONNECTOR_SHMEM_SIZE' '
+	test_must_fail env FLUX_LOCAL_CONNECTOR_SHMEM_SIZE=bad flux getattr rank
+'
+
 test_expect_success 'connector-local restored private access policy' '
 	flux dmesg --clear &&
 	cat >access.toml <<-EOT &&
@@ -334,4 +378,38 @@ test_expect_success 'flux content load/store allowed for guest user' '
 	test_cmp content.store.value content.load.value
 '
 
+test_expect_success 'connector-local rejects negative io-threads' '
+	mkdir -p iothreads-bad &&
+	cat >iothreads-bad/connector.toml <<-EOT &&
+	[connector-local]
+	io-threads = -1
+	EOT
+	test_must_fail env FLUX_CONF_DIR=$(pwd)/iothreads-bad \
+		flux start -o,-Sbroker.rc1_path=,-Sbroker.rc3_path= /bin/true
+'
+
+test_expect_success 'connector-local serves clients from io-threads' '
+	mkdir -p iothreads &&
+	cat >iothreads/connector.toml <<-EOT &&
+	[connector-local]
+	io-threads = 2
+	EOT
+	FLUX_CONF_DIR=$(pwd)/iothreads \
+		flux start -o,-Sbroker.rc1_path=,-Sbroker.rc3_path= \
+		"flux getattr rank \
+		&& flux ping --count=4 --pad=4096 broker \
+		&& FLUX_LOCAL_CONNECTOR_SHMEM_SIZE=65536 \
+			flux ping --count=4 --pad=262144 broker \
+		&& flux event pub test.iothreads \
+		&& flux module stats connector-local >iothreads.json" &&
+	jq -e ".\"io-threads\" | length == 2" <iothreads.json &&
+	jq -e "[.\"io-threads\"[].connects] | add >= 5" <iothreads.json &&
+	jq -e "[.\"io-threads\"[].rx] | add > 0" <iothreads.json
+'
+
+test_expect_success 'connector-local stats show no io-threads by default' '
+	flux module stats connector-local >stats-noiothreads.json &&
+	jq -e ".\"io-threads\" | length == 0" <stats-noiothreads.json
+'
+
 test_done
@@ -148,6 +148,37 @@ test_expect_success HAVE_JQ 'kvs-checkpoint.get foo returns same value' '
         test_cmp value2.exp value2.out
 '
 
+test_expect_success 'stored files are in fan-out subdirectories' '
+	test $(find ${FILEDB} -maxdepth 1 -type f | wc -l) -eq 0 &&
+	test $(find ${FILEDB} -mindepth 3 -type f | wc -l) -gt 0
+'
+
+test_expect_success 'blob in the old flat layout can be loaded' '
+	ref=$(cat blobref.1024) &&
+	mv $(find ${FILEDB} -type f -name $ref) ${FILEDB}/$ref &&
+	recheck_blob 1024
+'
+
+test_expect_success 'reload content-files module with workers=0' '
+	flux module reload content-files testing workers=0
+'
+
+test_expect_success 'store/load/verify blobs with no worker threads' '
+	err=0 &&
+	for size in 0 1 1025 65536; do \
+		if ! check_blob $size; then err=$(($err+1)); fi; \
+	done &&
+	test $err -eq 0
+'
+
+test_expect_success 'content-files module rejects bad workers option' '
+	test_must_fail flux module reload content-files testing workers=foo
+'
+
+test_expect_success 'load content-files module again' '
+	flux module load content-files testing
+'
+
 test_expect_success 'load with invalid blobref fails' '
 	test_must_fail backing_load notblobref 2>notblobref.err &&
 	grep "invalid blobref" notblobref.err
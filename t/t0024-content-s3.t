@@ -248,6 +248,60 @@ test_expect_success LONGTEST 'reload/verify various size large blobs through cac
 	test $err -eq 0
 '
 
+test_expect_success 'configure pack-threshold and workers' '
+	cat >>content-s3.toml <<-TOML
+	workers = 2
+	pack-threshold = 4096
+	TOML
+	flux config reload &&
+	flux module reload content-s3
+'
+
+test_expect_success 'store small blobs through cache and flush' '
+	for i in $(seq 1 64); do \
+		echo "packed blob $i $(date +%N)" >packblob.$i &&
+		flux content store <packblob.$i >packref.$i || return 1; \
+	done &&
+	flux content flush
+'
+
+test_expect_success 'small blobs can be loaded after dropcache' '
+	flux content dropcache &&
+	err=0 &&
+	for i in $(seq 1 64); do \
+		flux content load $(cat packref.$i) >packblob.$i.out &&
+		test_cmp packblob.$i packblob.$i.out || err=$(($err+1)); \
+	done &&
+	test $err -eq 0
+'
+
+test_expect_success 'packed blobs can be loaded after module reload' '
+	flux module reload content-s3 &&
+	err=0 &&
+	for i in $(seq 1 64); do \
+		backing_load $(cat packref.$i) >packblob.$i.reload &&
+		test_cmp packblob.$i packblob.$i.reload || err=$(($err+1)); \
+	done &&
+	test $err -eq 0
+'
+
+test_expect_success 'module with workers = 0 works' '
+	cp content-s3.toml content-s3.pack &&
+	sed -i -e "s/^workers = 2/workers = 0/" content-s3.toml &&
+	flux config reload &&
+	flux module reload content-s3 &&
+	recheck_blob 1024 &&
+	recheck_blob 65536
+'
+
+test_expect_success 'config: negative pack-threshold is rejected' '
+	sed -i -e "s/^pack-threshold = 4096/pack-threshold = -1/" \
+		content-s3.toml &&
+	test_must_fail flux config reload &&
+	mv -f content-s3.pack content-s3.toml &&
+	flux config reload
+'
+
 test_expect_success 'remove content-s3 module' '
 	flux module remove content-s3
 '
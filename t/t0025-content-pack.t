@@ -0,0 +1,289 @@
+#!/bin/sh
+
+test_description='Test content-pack backing store service'
+
+. `dirname $0`/sharness.sh
+
+if test "$TEST_LONG" = "t"; then
+    test_set_prereq LONGTEST
+fi
+
+test_under_flux 1 minimal
+
+RPC=${FLUX_BUILD_DIR}/t/request/rpc
+
+SIZES="0 1 64 100 1000 1024 1025 8192 65536 262144 1048576 4194304"
+LARGE_SIZES="8388608 10000000 16777216 33554432 67108864"
+
+##
+# Functions used by tests
+##
+
+# Usage: backing_load blobref
+backing_load() {
+        echo -n $1 | $RPC content-backing.load
+}
+# Usage: backing_store <blob >blobref
+backing_store() {
+        $RPC -r content-backing.store
+}
+# Usage: make_blob size >blob
+make_blob() {
+	if test $1 -eq 0; then
+		dd if=/dev/null 2>/dev/null
+	else
+		dd if=/dev/urandom count=1 bs=$1 2>/dev/null
+	fi
+}
+# Usage: check_blob size
+# Leaves behind blob.<size> and blobref.<size>
+check_blob() {
+	make_blob $1 >blob.$1 &&
+	backing_store <blob.$1 >blobref.$1 &&
+	backing_load $(cat blobref.$1) >blob.$1.check &&
+	test_cmp blob.$1 blob.$1.check
+}
+# Usage: recheck_blob size
+# Relies on existence of blob.<size> and blobref.<size>
+recheck_blob() {
+	backing_load $(cat blobref.$1) >blob.$1.recheck &&
+	test_cmp blob.$1 blob.$1.recheck
+}
+# Usage: recheck_cache_blob size
+# Relies on existence of blob.<size> and blobref.<size>
+recheck_cache_blob() {
+	flux content load $(cat blobref.$1) >blob.$1.cachecheck &&
+	test_cmp blob.$1 blob.$1.cachecheck
+}
+# Usage: kvs_checkpoint_put key value
+kvs_checkpoint_put() {
+        jq -j -c -n  "{key:\"$1\",value:\"$2\"}" | $RPC kvs-checkpoint.put
+}
+# Usage: kvs_checkpoint_get key >value
+kvs_checkpoint_get() {
+        jq -j -c -n  "{key:\"$1\"}" | $RPC kvs-checkpoint.get
+}
+
+##
+# Tests of the module by itself (no content cache)
+##
+
+test_expect_success 'load content-pack module' '
+	flux module load content-pack testing
+'
+
+test_expect_success 'content.backing-path attribute is set' '
+	PACKDB=$(flux getattr content.backing-path) &&
+	test -d ${PACKDB}
+'
+
+test_expect_success 'store/load/verify various size small blobs' '
+	err=0 &&
+	for size in $SIZES; do \
+		if ! check_blob $size; then err=$(($err+1)); fi; \
+	done &&
+	test $err -eq 0
+'
+
+test_expect_success LONGTEST 'store/load/verify various size large blobs' '
+	err=0 &&
+	for size in $LARGE_SIZES; do \
+		if ! check_blob $size; then err=$(($err+1)); fi; \
+	done &&
+	test $err -eq 0
+'
+
+test_expect_success 'blobs were appended to one segment file' '
+	test $(ls ${PACKDB}/seg-* | wc -l) -eq 1
+'
+
+test_expect_success 'storing a blob again does not append it' '
+	size=$(stat -c %s ${PACKDB}/seg-00000000) &&
+	backing_store <blob.1024 >blobref.1024.again &&
+	test_cmp blobref.1024 blobref.1024.again &&
+	test $(stat -c %s ${PACKDB}/seg-00000000) -eq $size
+'
+
+test_expect_success HAVE_JQ 'content-pack.compact with no KVS roots fails' '
+	echo {} | test_must_fail $RPC content-pack.compact 2>noroots.err &&
+	grep "no KVS roots" noroots.err
+'
+
+test_expect_success HAVE_JQ 'kvs-checkpoint.put foo=bar' '
+        kvs_checkpoint_put foo bar
+'
+
+test_expect_success HAVE_JQ 'kvs-checkpoint.get foo returned bar' '
+        echo bar >value.exp &&
+        kvs_checkpoint_get foo | jq -r .value >value.out &&
+        test_cmp value.exp value.out
+'
+
+test_expect_success HAVE_JQ 'kvs-checkpoint.put updates foo=baz' '
+        kvs_checkpoint_put foo baz
+'
+
+test_expect_success HAVE_JQ 'kvs-checkpoint.get foo returned baz' '
+        echo baz >value2.exp &&
+        kvs_checkpoint_get foo | jq -r .value >value2.out &&
+        test_cmp value2.exp value2.out
+'
+
+test_expect_success 'reload content-pack module' '
+	flux module reload content-pack testing
+'
+
+test_expect_success 'reload/verify various size small blobs' '
+	err=0 &&
+	for size in $SIZES; do \
+		if ! recheck_blob $size; then err=$(($err+1)); fi; \
+	done &&
+	test $err -eq 0
+'
+
+test_expect_success LONGTEST 'reload/verify various size large blobs' '
+	err=0 &&
+	for size in $LARGE_SIZES; do \
+		if ! recheck_blob $size; then err=$(($err+1)); fi; \
+	done &&
+	test $err -eq 0
+'
+
+test_expect_success HAVE_JQ 'kvs-checkpoint.get foo returns same value' '
+        kvs_checkpoint_get foo | jq -r .value >value2.out &&
+        test_cmp value2.exp value2.out
+'
+
+test_expect_success 'remove content-pack module' '
+	flux module remove content-pack
+'
+
+test_expect_success 'torn record at end of active segment is truncated' '
+	size=$(stat -c %s ${PACKDB}/seg-00000000) &&
+	printf "PKRB\0\0\0" >>${PACKDB}/seg-00000000 &&
+	flux module load content-pack testing &&
+	test $(stat -c %s ${PACKDB}/seg-00000000) -eq $size &&
+	recheck_blob 1024
+'
+
+test_expect_success 'reload content-pack module with small segments' '
+	flux module reload content-pack testing segment-size=64K
+'
+
+test_expect_success 'store/load/verify blobs across several segments' '
+	err=0 &&
+	for size in 1000 30000 40000 50000 65536 262144; do \
+		if ! check_blob $size; then err=$(($err+1)); fi; \
+	done &&
+	test $err -eq 0 &&
+	test $(ls ${PACKDB}/seg-*[0-9] | wc -l) -gt 1 &&
+	test $(ls ${PACKDB}/seg-*.idx | wc -l) -gt 0
+'
+
+test_expect_success 'reload/verify blobs from sealed segments' '
+	flux module reload content-pack testing segment-size=64K &&
+	err=0 &&
+	for size in 0 1 1024 30000 65536 262144 4194304; do \
+		if ! recheck_blob $size; then err=$(($err+1)); fi; \
+	done &&
+	test $err -eq 0
+'
+
+test_expect_success HAVE_JQ 'content-pack.stats-get reports segments' '
+	$RPC content-pack.stats-get </dev/null >stats.json &&
+	jq -e ".segments > 1 and .blobs > 0" <stats.json
+'
+
+test_expect_success 'content-pack module rejects bad segment-size option' '
+	test_must_fail flux module reload content-pack testing segment-size=1
+'
+
+test_expect_success 'load content-pack module again' '
+	flux module load content-pack testing
+'
+
+test_expect_success 'load with invalid blobref fails' '
+	test_must_fail backing_load notblobref 2>notblobref.err &&
+	grep "invalid blobref" notblobref.err
+'
+test_expect_success 'kvs-checkpoint.get bad request fails with EPROTO' '
+	test_must_fail $RPC kvs-checkpoint.get </dev/null 2>badget.err &&
+	grep "Protocol error" badget.err
+'
+test_expect_success 'kvs-checkpoint.put bad request fails with EPROTO' '
+	test_must_fail $RPC kvs-checkpoint.put </dev/null 2>badput.err &&
+	grep "Protocol error" badput.err
+'
+
+##
+# Tests of the module acting as backing store for content cache
+##
+
+test_expect_success 'reload content-pack module without testing option' '
+	flux module reload content-pack segment-size=16K
+'
+
+test_expect_success 'verify content.backing-module=content-pack' '
+        test "$(flux getattr content.backing-module)" = "content-pack"
+'
+
+test_expect_success 'reload/verify various size small blobs through cache' '
+	err=0 &&
+	for size in $SIZES; do \
+		if ! recheck_cache_blob $size; then err=$(($err+1)); fi; \
+	done &&
+	test $err -eq 0
+'
+
+test_expect_success 'load kvs module and store some keys' '
+	flux module load kvs &&
+	for i in $(seq 1 16); do \
+		make_blob 4096 | base64 -w0 >val.$i && echo >>val.$i && \
+		flux kvs put test.a.$i=$(cat val.$i) || return 1; \
+	done
+'
+
+test_expect_success 'store unreferenced blobs, then more keys' '
+	for i in $(seq 1 16); do \
+		make_blob 4096 | backing_store >junk.$i || return 1; \
+	done &&
+	for i in $(seq 1 16); do \
+		make_blob 4096 | base64 -w0 >val2.$i && echo >>val2.$i && \
+		flux kvs put test.b.$i=$(cat val2.$i) || return 1; \
+	done &&
+	flux content flush
+'
+
+test_expect_success HAVE_JQ 'content-pack.compact drops unreferenced blobs' '
+	root=$(flux kvs getroot | jq -r ".data[0]") &&
+	jq -j -c -n "{roots:[\"$root\"],threshold:1.0}" \
+		| $RPC content-pack.compact >compact.json &&
+	jq -e ".segments > 0 and .blobs > 0" <compact.json &&
+	err=0 &&
+	for i in $(seq 1 16); do \
+		if backing_load $(cat junk.$i) >/dev/null; then \
+			err=$(($err+1)); \
+		fi; \
+	done &&
+	test $err -lt 16
+'
+
+test_expect_success 'KVS content survives compaction' '
+	flux content dropcache &&
+	for i in $(seq 1 16); do \
+		flux kvs get test.a.$i >val.$i.out && \
+		test_cmp val.$i val.$i.out && \
+		flux kvs get test.b.$i >val2.$i.out && \
+		test_cmp val2.$i val2.$i.out || return 1; \
+	done
+'
+
+test_expect_success 'remove kvs module' '
+	flux module remove kvs
+'
+
+test_expect_success 'remove content-pack module' '
+	flux module remove content-pack
+'
+
+test_done
@@ -0,0 +1,98 @@
+#!/bin/sh
+#
+
+test_description='Test flux bench'
+
+. `dirname $0`/sharness.sh
+
+skip_all_unless_have jq
+
+test_under_flux 2 job
+
+SCENARIOS="rpc stream event kvs-commit kvs-lookup kvs-watch content \
+	job-latency job-throughput"
+
+test_expect_success 'flux bench --list lists all scenarios' '
+	flux bench --list >list.out &&
+	for s in ${SCENARIOS}; do grep "^$s " list.out || return 1; done
+'
+test_expect_success 'flux bench runs all non-job scenarios by default' '
+	flux bench --count=10 >default.json &&
+	jq -e ".count == 10 and .size == 2" default.json &&
+	jq -e ".scenarios | keys | length == 7" default.json &&
+	jq -e ".scenarios | has(\"job-latency\") | not" default.json
+'
+test_expect_success 'flux bench reports latency percentiles' '
+	jq -e "[.scenarios[] | .count == 10 and .rate > 0 \
+		and .latency.min <= .latency.p50 \
+		and .latency.p50 <= .latency.p90 \
+		and .latency.p90 <= .latency.p99 \
+		and .latency.p99 <= .latency.max] | all" default.json
+'
+test_expect_success 'flux bench --size pads payloads' '
+	flux bench --count=5 --warmup=0 --size=65536 rpc content kvs-commit \
+		>size.json &&
+	jq -e ".\"payload-size\" == 65536 and .warmup == 0" size.json &&
+	jq -e ".scenarios | keys == [\"content\",\"kvs-commit\",\"rpc\"]" \
+		size.json
+'
+test_expect_success 'flux bench runs job scenarios' '
+	flux bench --count=4 job-latency job-throughput >job.json &&
+	jq -e ".scenarios[\"job-latency\"].count == 4" job.json &&
+	jq -e ".scenarios[\"job-throughput\"].count == 4" job.json
+'
+test_expect_success 'flux bench leaves no active jobs behind' '
+	test $(flux jobs -n -o "{id}" | wc -l) -eq 0
+'
+test_expect_success 'flux bench fails on unknown scenario' '
+	test_must_fail flux bench nosuch 2>unknown.err &&
+	grep "unknown scenario: nosuch" unknown.err
+'
+test_expect_success 'flux bench fails on invalid count' '
+	test_must_fail flux bench --count=0 rpc
+'
+
+CHECK_PERF="${PYTHON:-python3} ${SHARNESS_TEST_SRCDIR}/perf/check-perf.py"
+
+test_expect_success 'check-perf --update records a baseline' '
+	$CHECK_PERF --baseline=baseline.json --tolerance=0.1 \
+		--results=default.json --update &&
+	jq -e ".tolerance == 0.1 and .size == 2 and .count == 10" \
+		baseline.json &&
+	jq -e ".scenarios | keys | length == 7" baseline.json
+'
+test_expect_success 'check-perf passes against its own baseline' '
+	$CHECK_PERF --baseline=baseline.json --results=default.json \
+		--output=pass.json &&
+	jq -e ".pass and .tolerance == 0.1" pass.json &&
+	jq -e "[.verdict[] | .status == \"pass\"] | all" pass.json
+'
+test_expect_success 'check-perf fails on a slower rpc rate' '
+	jq ".scenarios.rpc.rate /= 2" default.json >slow.json &&
+	test_must_fail $CHECK_PERF --baseline=baseline.json \
+		--results=slow.json --output=fail.json >fail.out 2>&1 &&
+	grep "regressed: rpc" fail.out &&
+	jq -e ".pass | not" fail.json &&
+	jq -e ".verdict.rpc.status == \"fail\"" fail.json &&
+	jq -e ".verdict.event.status == \"pass\"" fail.json
+'
+test_expect_success 'check-perf fails on a higher p99 latency' '
+	jq ".scenarios.event.latency.p99 *= 2" default.json >p99.json &&
+	test_must_fail $CHECK_PERF --baseline=baseline.json \
+		--results=p99.json --output=p99-report.json &&
+	jq -e "[.verdict.event.checks[] | select(.metric == \"p99\")] \
+		| .[0].pass | not" p99-report.json
+'
+test_expect_success 'check-perf reports scenarios missing from baseline' '
+	jq "del(.scenarios.rpc)" baseline.json >partial.json &&
+	$CHECK_PERF --baseline=partial.json --results=default.json \
+		--output=new.json &&
+	jq -e ".verdict.rpc.status == \"new\"" new.json
+'
+test_expect_success 'check-perf runs flux bench in a test instance' '
+	$CHECK_PERF --flux=$(which flux) --baseline=baseline.json \
+		--size=1 --count=5 --update rpc &&
+	jq -e ".size == 1 and .count == 5" baseline.json &&
+	jq -e ".scenarios | keys == [\"rpc\"]" baseline.json
+'
+test_done
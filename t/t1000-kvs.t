@@ -567,6 +567,21 @@ test_expect_success 'kvs: basic append works with newlines' '
 	flux kvs get --raw $DIR.a >output &&
 	test_cmp output expected
 '
+test_expect_success 'kvs: get --stream of appended value works' '
+	flux kvs get --stream $DIR.a >output &&
+	test_cmp output expected
+'
+test_expect_success 'kvs: get --stream of small value works' '
+	flux kvs unlink -Rf $DIR &&
+	flux kvs put --raw $DIR.a=abc &&
+	printf "%s" "abc" >expected &&
+	flux kvs get --stream $DIR.a >output &&
+	test_cmp output expected
+'
+test_expect_success 'kvs: get --stream fails on missing key and directory' '
+	test_must_fail flux kvs get --stream $DIR.nokey &&
+	test_must_fail flux kvs get --stream $DIR
+'
 
 #
 # put --no-merge tests
@@ -720,6 +735,21 @@ test_expect_success 'kvs: ls -R lists deep directory hierarchy' '
 	EOF
 	test_cmp expected output
 '
+test_expect_success 'kvs: dir -R lists wide directory hierarchy' '
+	flux kvs unlink -Rf $DIR &&
+	${FLUX_BUILD_DIR}/t/kvs/dtree -p$DIR -h3 -w10 &&
+	flux kvs dir -R $DIR >output &&
+	test $(wc -l <output) -eq 1000 &&
+	test $(grep -c " = 1\$" output) -eq 1000
+'
+test_expect_success 'kvs: dir -R output is depth first' '
+	sed -e "s/ = 1\$//" -e "s/\.[^.]*\$//" output >parents &&
+	test $(uniq parents | wc -l) -eq $(sort -u parents | wc -l)
+'
+test_expect_success 'kvs: ls -R lists wide directory hierarchy' '
+	flux kvs ls -R $DIR >output &&
+	test $(grep -c ":\$" output) -eq 111
+'
 test_expect_success 'kvs: ls key. works' '
 	flux kvs unlink -Rf $DIR &&
 	flux kvs mkdir $DIR.a &&
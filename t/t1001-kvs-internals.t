@@ -517,4 +517,153 @@ test_expect_success 'kvs: test invalid lookup rpc' '
         grep "flux_future_get: Protocol error" lookup_invalid_output
 '
 
+#
+# test client side lookup cache
+#
+
+test_expect_success 'kvs: lookup cache answers repeated lookups and sees updates' '
+        ${FLUX_BUILD_DIR}/t/kvs/lookup_cache lookupcache.key > lookup_cache_output &&
+        grep "lookup cache ok" lookup_cache_output
+'
+
+#
+# test binary treeobj encoding of directories in the content store
+#
+
+test_expect_success 'kvs: treeobj-encoding=binary stores binary dirs' '
+        flux module reload kvs treeobj-encoding=binary &&
+        flux kvs put $DIR.binary.a=1 $DIR.binary.b=2 &&
+        ref=$(flux kvs getroot | sed -e "s/.*\(sha1-[0-9a-f]*\).*/\1/") &&
+        flux content load $ref | head -c 4 | tr -d "\000\001" > magic.out &&
+        test "$(cat magic.out)" = "TO"
+'
+
+test_expect_success 'kvs: binary dirs can be read back' '
+        test "$(flux kvs get $DIR.binary.a)" = "1" &&
+        test "$(flux kvs get $DIR.binary.b)" = "2" &&
+        flux kvs ls $DIR.binary
+'
+
+test_expect_success 'kvs: json dirs can be read after switching back' '
+        flux module reload kvs &&
+        flux kvs put $DIR.binary.c=3 &&
+        test "$(flux kvs get $DIR.binary.a)" = "1" &&
+        test "$(flux kvs get $DIR.binary.c)" = "3"
+'
+
+#
+# test sharded directories
+#
+
+test_expect_success 'kvs: large directory is sharded past dirshard-threshold' '
+        flux module reload kvs dirshard-threshold=8 &&
+        for i in $(seq 1 100); do echo "$DIR.shard.key$i=$i"; done \
+            | xargs flux kvs put &&
+        ref=$(flux kvs get --treeobj $DIR.shard \
+            | sed -e "s/.*\(sha1-[0-9a-f]*\).*/\1/") &&
+        flux content load $ref | grep dirshard
+'
+
+test_expect_success 'kvs: entries of sharded directory can be read' '
+        test "$(flux kvs get $DIR.shard.key1)" = "1" &&
+        test "$(flux kvs get $DIR.shard.key100)" = "100" &&
+        test_must_fail flux kvs get $DIR.shard.nokey
+'
+
+test_expect_success 'kvs: sharded directory can be listed' '
+        flux kvs ls -1 $DIR.shard > shard_ls.out &&
+        test $(wc -l < shard_ls.out) -eq 100
+'
+
+test_expect_success 'kvs: sharded directory entries can be updated and removed' '
+        flux kvs put $DIR.shard.key50=fifty &&
+        flux kvs unlink $DIR.shard.key51 &&
+        test "$(flux kvs get $DIR.shard.key50)" = "fifty" &&
+        test_must_fail flux kvs get $DIR.shard.key51 &&
+        flux kvs ls -1 $DIR.shard > shard_ls2.out &&
+        test $(wc -l < shard_ls2.out) -eq 99 &&
+        flux module reload kvs
+'
+
+#
+# test lookup result cache
+#
+
+test_expect_success 'kvs: repeated lookup is answered from result cache' '
+        flux kvs put $DIR.rcache.a=1 &&
+        flux module stats -c kvs &&
+        test "$(flux kvs get $DIR.rcache.a)" = "1" &&
+        test "$(flux kvs get $DIR.rcache.a)" = "1" &&
+        test $(flux module stats --parse "lookup.#result cache hits" kvs) -gt 0
+'
+
+test_expect_success 'kvs: result cache does not return stale values' '
+        flux kvs put $DIR.rcache.a=2 &&
+        test "$(flux kvs get $DIR.rcache.a)" = "2"
+'
+
+test_expect_success 'kvs: lookup-cache-size=0 disables result cache' '
+        flux module reload kvs lookup-cache-size=0 &&
+        test "$(flux kvs get $DIR.rcache.a)" = "2" &&
+        test "$(flux kvs get $DIR.rcache.a)" = "2" &&
+        test $(flux module stats --parse "lookup.#result cache hits" kvs) -eq 0 &&
+        flux module reload kvs
+'
+
+#
+# test setroot event coalescing
+#
+
+test_expect_success 'kvs: commits complete with setroot-window set' '
+        flux module reload kvs setroot-window=0.1 &&
+        for i in $(seq 1 8); do \
+            flux kvs put $DIR.window.key$i=$i & \
+        done &&
+        wait &&
+        for i in $(seq 1 8); do \
+            test "$(flux kvs get $DIR.window.key$i)" = "$i" || return 1; \
+        done
+'
+
+test_expect_success 'kvs: followers see the coalesced root' '
+        VERS=$(flux kvs version) &&
+        flux exec -n -r 1 flux kvs wait $VERS &&
+        test "$(flux exec -n -r 1 flux kvs get $DIR.window.key8)" = "8" &&
+        flux module reload kvs
+'
+
+#
+# test size-bounded cache
+#
+
+test_expect_success 'kvs: values can be read with a tiny cache-max-size' '
+        flux module reload kvs cache-max-size=1 &&
+        for i in $(seq 1 20); do echo "$DIR.bounded.key$i=$largeval"; done \
+            | xargs flux kvs put &&
+        for i in $(seq 1 20); do \
+            test "$(flux kvs get $DIR.bounded.key$i)" = "$largeval" || return 1; \
+        done
+'
+
+test_expect_success 'kvs: cache hit/miss/eviction counters are reported' '
+        flux module stats --parse "cache.#hits" kvs &&
+        flux module stats --parse "cache.#misses" kvs &&
+        flux module stats --parse "cache.#evictions" kvs &&
+        flux module stats -c kvs &&
+        test $(flux module stats --parse "cache.#hits" kvs) -eq 0 &&
+        flux module reload kvs
+'
+
+#
+# test cache handoff across reload
+#
+
+test_expect_success 'kvs: reload prefetches the previous cache' '
+        flux kvs put $DIR.handoff.a=1 &&
+        test "$(flux kvs get $DIR.handoff.a)" = "1" &&
+        flux module reload kvs &&
+        test $(flux module stats --parse "cache.#handoff loads" kvs) -gt 0 &&
+        test "$(flux kvs get $DIR.handoff.a)" = "1"
+'
+
 test_done
@@ -131,4 +131,12 @@ test_expect_success 'kvs: transaction-merge disabling works' '
 	test "$OUTPUT" = "${THREADS}"
 '
 
+# transaction-pipeline option test
+test_expect_success 'kvs: transaction-pipeline disabling works' '
+	THREADS=8 &&
+	flux module reload kvs transaction-pipeline=0 &&
+	flux exec -n ${FLUX_BUILD_DIR}/t/kvs/commit ${THREADS} 100 \
+		$(basename ${SHARNESS_TEST_FILE})
+'
+
 test_done
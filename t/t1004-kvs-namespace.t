@@ -439,6 +439,22 @@ test_expect_success 'kvs: put/get in different namespaces works' '
         test_kvs_key_namespace $NAMESPACETEST $DIR.test 2
 '
 
+test_expect_success 'kvs: concurrent commits in several namespaces work' '
+	for i in 1 2 3 4; do \
+		flux kvs namespace create $NAMESPACETMP-GROUP$i || return 1; \
+	done &&
+	for i in 1 2 3 4; do \
+		flux kvs put --namespace=$NAMESPACETMP-GROUP$i \
+			$DIR.a=$i $DIR.b.c=$i & \
+	done &&
+	wait &&
+	for i in 1 2 3 4; do \
+		test_kvs_key_namespace $NAMESPACETMP-GROUP$i $DIR.a $i && \
+		test_kvs_key_namespace $NAMESPACETMP-GROUP$i $DIR.b.c $i && \
+		flux kvs namespace remove $NAMESPACETMP-GROUP$i || return 1; \
+	done
+'
+
 test_expect_success 'kvs: unlink in different namespaces works' '
         flux kvs put --namespace=$PRIMARYNAMESPACE $DIR.testA=1 &&
         flux kvs put --namespace=$PRIMARYNAMESPACE $DIR.testB=1 &&
@@ -512,4 +528,167 @@ test_expect_success NO_CHAIN_LINT 'kvs: wait in different namespaces works' '
         test_expect_code 0 wait $testkvswaitpid
 '
 
+#
+# Namespace placed on another rank
+#
+
+NAMESPACEPLACED=namespaceplaced
+
+test_expect_success 'kvs: namespace create with invalid rank fails' '
+        test_must_fail flux kvs namespace create --rank=$SIZE $NAMESPACEPLACED
+'
+
+test_expect_success 'kvs: namespace create on rank 1 works' '
+        flux kvs namespace create --rank=1 $NAMESPACEPLACED &&
+        flux kvs namespace list | grep $NAMESPACEPLACED
+'
+
+test_expect_success 'kvs: put/get in namespace owned by rank 1 works on rank 0' '
+        flux kvs put --namespace=$NAMESPACEPLACED $DIR.test=1 &&
+        test_kvs_key_namespace $NAMESPACEPLACED $DIR.test 1
+'
+
+test_expect_success 'kvs: put/get in namespace owned by rank 1 works on rank 1' '
+        flux exec -n -r 1 sh -c "flux kvs put --namespace=$NAMESPACEPLACED $DIR.test=2" &&
+        flux exec -n -r 1 sh -c "flux kvs get --namespace=$NAMESPACEPLACED $DIR.test" > placed1.out &&
+        echo 2 > placed1.exp &&
+        test_cmp placed1.exp placed1.out
+'
+
+test_expect_success 'kvs: put/get in namespace owned by rank 1 works on other ranks' '
+        flux exec -n -r 2 sh -c "flux kvs put --namespace=$NAMESPACEPLACED $DIR.test=3" &&
+        flux exec -n -r 2 sh -c "flux kvs get --namespace=$NAMESPACEPLACED $DIR.test" > placed2.out &&
+        echo 3 > placed2.exp &&
+        test_cmp placed2.exp placed2.out
+'
+
+test_expect_success 'kvs: rank 0 sees writes to namespace owned by rank 1' '
+        VERS=$(flux exec -n -r 2 sh -c "flux kvs version --namespace=$NAMESPACEPLACED") &&
+        flux kvs wait --namespace=$NAMESPACEPLACED $VERS &&
+        test_kvs_key_namespace $NAMESPACEPLACED $DIR.test 3
+'
+
+test_expect_success 'kvs: fence in namespace owned by rank 1 works' '
+        FLUX_KVS_NAMESPACE=$NAMESPACEPLACED ${FLUX_BUILD_DIR}/t/kvs/fence_api 8 placedtest
+'
+
+test_expect_success 'kvs: namespace owned by rank 1 can be removed' '
+        flux kvs namespace remove $NAMESPACEPLACED &&
+        ! flux kvs get --namespace=$NAMESPACEPLACED $DIR.test
+'
+
+#
+# Ephemeral namespace
+#
+
+test_expect_success 'kvs: namespace clone works' '
+        flux kvs namespace create clonesrc &&
+        flux kvs put --namespace=clonesrc $DIR.a=1 $DIR.b.c=2 &&
+        flux kvs namespace create --clone=clonesrc clonedst &&
+        test_kvs_key_namespace clonedst $DIR.a 1 &&
+        test_kvs_key_namespace clonedst $DIR.b.c 2
+'
+
+test_expect_success 'kvs: namespace clone starts at source root' '
+        test "$(flux kvs getroot --namespace=clonesrc)" = \
+             "$(flux kvs getroot --namespace=clonedst)"
+'
+
+test_expect_success 'kvs: namespace clone is independent of source' '
+        flux kvs put --namespace=clonedst $DIR.a=3 &&
+        test_kvs_key_namespace clonesrc $DIR.a 1 &&
+        test_kvs_key_namespace clonedst $DIR.a 3
+'
+
+test_expect_success 'kvs: namespace clone can be read on other ranks' '
+        VERS=$(flux kvs version --namespace=clonedst) &&
+        flux exec -n -r 1 sh -c "flux kvs wait --namespace=clonedst $VERS" &&
+        flux exec -n -r 1 sh -c "flux kvs get --namespace=clonedst $DIR.b.c" > clone1.out &&
+        echo 2 > clone1.exp &&
+        test_cmp clone1.exp clone1.out
+'
+
+test_expect_success 'kvs: namespace clone of unknown namespace fails' '
+        test_must_fail flux kvs namespace create --clone=noclonesrc clonedst2
+'
+
+test_expect_success 'kvs: namespace clone with --ephemeral fails' '
+        test_must_fail flux kvs namespace create --clone=clonesrc -e clonedst2
+'
+
+test_expect_success 'kvs: cloned namespaces can be removed' '
+        flux kvs namespace remove clonesrc clonedst
+'
+
+NAMESPACEEPH=namespaceeph
+
+test_expect_success 'kvs: ephemeral namespace create works' '
+        flux kvs namespace create --ephemeral $NAMESPACEEPH &&
+        flux kvs namespace list | grep $NAMESPACEEPH
+'
+
+test_expect_success 'kvs: put/get in ephemeral namespace works' '
+        flux kvs put --namespace=$NAMESPACEEPH $DIR.status=1 &&
+        test_kvs_key_namespace $NAMESPACEEPH $DIR.status 1
+'
+
+test_expect_success 'kvs: ephemeral namespace is not written to content store' '
+        before=$(flux module stats --parse count content) &&
+        for i in $(seq 1 8); do
+                flux kvs put --namespace=$NAMESPACEEPH $DIR.status=ephemeral$i
+        done &&
+        after=$(flux module stats --parse count content) &&
+        test $after -le $before &&
+        test_kvs_key_namespace $NAMESPACEEPH $DIR.status ephemeral8
+'
+
+test_expect_success 'kvs: ephemeral namespace holds its objects' '
+        test $(flux module stats --parse namespace.$NAMESPACEEPH.#ephemeral\ objs kvs) -gt 0
+'
+
+test_expect_success 'kvs: ephemeral namespace survives dropcache' '
+        flux kvs dropcache &&
+        test_kvs_key_namespace $NAMESPACEEPH $DIR.status ephemeral8
+'
+
+test_expect_success 'kvs: ephemeral namespace can be read on other ranks' '
+        VERS=$(flux kvs version --namespace=$NAMESPACEEPH) &&
+        flux exec -n -r 1 sh -c "flux kvs wait --namespace=$NAMESPACEEPH $VERS" &&
+        flux exec -n -r 1 sh -c "flux kvs get --namespace=$NAMESPACEEPH $DIR.status" > eph1.out &&
+        echo ephemeral8 > eph1.exp &&
+        test_cmp eph1.exp eph1.out
+'
+
+test_expect_success 'kvs: ephemeral namespace can be written on other ranks' '
+        flux exec -n -r 1 sh -c "flux kvs put --namespace=$NAMESPACEEPH $DIR.other=2" &&
+        VERS=$(flux exec -n -r 1 sh -c "flux kvs version --namespace=$NAMESPACEEPH") &&
+        flux kvs wait --namespace=$NAMESPACEEPH $VERS &&
+        test_kvs_key_namespace $NAMESPACEEPH $DIR.other 2
+'
+
+test_expect_success 'kvs: ephemeral namespace can be watched on other ranks' '
+        flux exec -n -r 1 sh -c "flux kvs get --namespace=$NAMESPACEEPH --watch --count=2 $DIR.status" > eph2.out &
+        pid=$! &&
+        $waitfile --count=1 --timeout=10 --pattern="ephemeral8" eph2.out &&
+        flux kvs put --namespace=$NAMESPACEEPH $DIR.status=ephemeral9 &&
+        wait $pid &&
+        printf "ephemeral8\nephemeral9\n" > eph2.exp &&
+        test_cmp eph2.exp eph2.out
+'
+
+test_expect_success 'kvs: ephemeral dir cannot be copied to primary namespace' '
+        test_must_fail flux kvs copy --src-namespace=$NAMESPACEEPH $DIR test.ephcopy 2> ephcopy.err &&
+        ! flux kvs get test.ephcopy
+'
+
+test_expect_success 'kvs: ephemeral namespace cannot be cloned' '
+        test_must_fail flux kvs namespace create --clone=$NAMESPACEEPH ephclone &&
+        ! flux kvs namespace list | grep ephclone
+'
+
+test_expect_success 'kvs: ephemeral namespace can be removed' '
+        flux kvs namespace remove $NAMESPACEEPH &&
+        ! flux kvs get --namespace=$NAMESPACEEPH $DIR.status
+'
+
 test_done
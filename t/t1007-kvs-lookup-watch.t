@@ -46,6 +46,28 @@ test_expect_success NO_CHAIN_LINT 'kvs-watch stats reports active watcher' '
        wait $pid
 '
 
+test_expect_success NO_CHAIN_LINT 'kvs-watch shares lookups of identical watchers' '
+       flux kvs put test.share=0 &&
+       shared=$(flux module stats --parse=lookups-shared kvs-watch) &&
+       flux kvs get --watch --count=2 test.share >share1.out &
+       pid1=$! &&
+       flux kvs get --watch --count=2 test.share >share2.out &
+       pid2=$! &&
+       flux kvs get --watch --count=2 test.share >share3.out &
+       pid3=$! &&
+       $waitfile --count=1 --timeout=10 --pattern="[0-9]+" share1.out &&
+       $waitfile --count=1 --timeout=10 --pattern="[0-9]+" share2.out &&
+       $waitfile --count=1 --timeout=10 --pattern="[0-9]+" share3.out &&
+       flux kvs put --no-merge test.share=1 &&
+       wait $pid1 && wait $pid2 && wait $pid3 &&
+       printf "0\n1\n" >share.exp &&
+       test_cmp share.exp share1.out &&
+       test_cmp share.exp share2.out &&
+       test_cmp share.exp share3.out &&
+       shared2=$(flux module stats --parse=lookups-shared kvs-watch) &&
+       test $shared2 -eq $((shared + 2))
+'
+
 # Check that stdin contains an integer on each line that
 # is one more than the integer on the previous line.
 test_monotonicity() {
@@ -609,6 +631,44 @@ xyz
 	test_cmp expected full7.out
 '
 
+test_expect_success NO_CHAIN_LINT 'flux kvs get --watch w/ --full skips lookups for unrelated keys' '
+        flux kvs unlink -Rf test &&
+        flux kvs put test.dir.a="abc" &&
+        skipped=$(flux module stats --parse=lookups-skipped kvs-watch) &&
+        flux kvs get --watch --full --count=2 test.dir.a > full8.out 2>&1 &
+        pid=$! &&
+        wait_watcherscount_nonzero primary &&
+        $waitfile --count=1 --timeout=10 \
+                  --pattern="abc" full8.out >/dev/null &&
+        flux kvs put test.other.a="1" &&
+        flux kvs put test.other.a="2" &&
+        flux kvs put test.dir.a="def" &&
+        wait $pid &&
+	cat >expected <<-EOF &&
+abc
+def
+	EOF
+	test_cmp expected full8.out &&
+        skipped2=$(flux module stats --parse=lookups-skipped kvs-watch) &&
+        test $skipped2 -gt $skipped
+'
+
+test_expect_success NO_CHAIN_LINT 'flux kvs get --watch w/ --full detects change through symlink' '
+        flux kvs unlink -Rf test &&
+        flux kvs put test.target.a="abc" &&
+        flux kvs link test.target test.link &&
+        flux kvs get --watch --full --count=2 test.link.a > full9.out 2>&1 &
+        pid=$! &&
+        wait_watcherscount_nonzero primary &&
+        flux kvs put test.target.a="xyz" &&
+        wait $pid &&
+	cat >expected <<-EOF &&
+abc
+xyz
+	EOF
+	test_cmp expected full9.out
+'
+
 # make sure keys are normalized
 
 test_expect_success NO_CHAIN_LINT 'flux kvs get --watch, normalized key matching works ' '
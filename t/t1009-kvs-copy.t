@@ -158,6 +158,28 @@ test_expect_success 'remove test namespace' '
 	flux kvs namespace remove tons
 '
 
+test_expect_success 'kvs-copy of several keys works' '
+	flux kvs unlink -Rf test &&
+	flux kvs put test.src.a=1 test.src.b=2 test.src.c.d=3 &&
+	flux kvs copy test.src.a test.dst.a test.src.b test.dst.b \
+		test.src.c test.dst.c
+'
+test_expect_success 'kvs-copy of several keys is one commit' '
+	vers=$(flux kvs version) &&
+	flux kvs copy test.src.a test.dst2.a test.src.b test.dst2.b &&
+	test $(flux kvs version) -eq $((vers+1))
+'
+test_expect_success 'kvs-copy of several keys dst contains expected values' '
+	test "$(flux kvs get test.dst.a)" = "1" &&
+	test "$(flux kvs get test.dst.b)" = "2" &&
+	test "$(flux kvs get test.dst.c.d)" = "3"
+'
+test_expect_success 'kvs-copy of several keys fails if any src is missing' '
+	test_must_fail flux kvs copy test.src.a test.dst3.a \
+		test.notakey test.dst3.b &&
+	test_must_fail flux kvs get test.dst3.a
+'
+
 # expected failures
 
 test_expect_success 'kvs-copy missing argument fails' '
@@ -166,6 +188,9 @@ test_expect_success 'kvs-copy missing argument fails' '
 test_expect_success 'kvs-move missing argument fails' '
 	test_must_fail flux kvs move foo
 '
+test_expect_success 'kvs-copy odd number of arguments fails' '
+	test_must_fail flux kvs copy foo bar baz
+'
 test_expect_success 'kvs-copy nonexistent src fails' '
 	flux kvs unlink -Rf test.notakey &&
 	test_must_fail flux kvs copy test.notakey foo
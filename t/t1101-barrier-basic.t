@@ -86,5 +86,38 @@ test_expect_success 'barrier: remove barrier module' '
 	flux exec -r all flux module remove barrier
 '
 
+test_expect_success 'barrier: load barrier module with unknown option fails' '
+	test_must_fail flux module load barrier badopt
+'
+
+test_expect_success 'barrier: load barrier module with tree option' '
+	flux exec -r all flux module load barrier tree
+'
+
+test_expect_success 'barrier: tree completion works (all ranks)' '
+	run_timeout 5 flux exec -n ${tbarrier} --nprocs ${SIZE} tree-abc
+'
+
+test_expect_success 'barrier: tree completion works (subset of ranks)' '
+	run_timeout 5 flux exec -n -r 1,3 ${tbarrier} --nprocs 2 tree-xyz
+'
+
+test_expect_success 'barrier: tree completion works with several clients per rank' '
+	run_timeout 5 flux exec -n -r all \
+		sh -c "${tbarrier} --nprocs 8 tree-n & ${tbarrier} --nprocs 8 tree-n && wait \$!"
+'
+
+test_expect_success 'barrier: disconnect aborts tree barrier' '
+	run_timeout 5 \
+	    $SHARNESS_TEST_SRCDIR/scripts/event-trace.lua \
+		barrier barrier.exit \
+                "${tbarrier} --nprocs 2 --early-exit tree-discon" >tdiscon.out &&
+	grep barrier.exit tdiscon.out
+'
+
+test_expect_success 'barrier: remove barrier module' '
+	flux exec -r all flux module remove barrier
+'
+
 
 test_done
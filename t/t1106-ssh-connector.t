@@ -101,4 +101,65 @@ test_expect_success 'ssh:// with missing path component fails in flux_open()' '
 	grep -q "flux_open:" nopath.out
 '
 
+persist_sockets() {
+	ls $1/flux-ssh-$(id -u) | grep -v "\.lock$"
+}
+
+test_expect_success 'ssh:// with FLUX_SSH_PERSIST starts a shared proxy' '
+	mkdir persist &&
+	FLUX_URI=ssh://localhost$TEST_SOCKDIR FLUX_SSH=$TEST_SSH \
+	  FLUX_SSH_PERSIST=60s TMPDIR=$(pwd)/persist \
+	  flux getattr size 2>persist.err &&
+	test_must_fail grep cmd= persist.err &&
+	persist_sockets persist >persist.ls &&
+	test_line_count = 1 persist.ls
+'
+
+test_expect_success 'ssh:// with FLUX_SSH_PERSIST reuses the shared proxy' '
+	for i in 1 2 3; do \
+	  FLUX_URI=ssh://localhost$TEST_SOCKDIR FLUX_SSH=$TEST_SSH \
+	    FLUX_SSH_PERSIST=60s TMPDIR=$(pwd)/persist \
+	    flux getattr size || return 1; \
+	done &&
+	persist_sockets persist >persist2.ls &&
+	test_cmp persist.ls persist2.ls
+'
+
+test_expect_success 'ssh:// shared proxy can work with events' '
+	FLUX_URI=ssh://localhost$TEST_SOCKDIR FLUX_SSH=$TEST_SSH \
+	  FLUX_SSH_PERSIST=60s TMPDIR=$(pwd)/persist \
+	  flux event sub --count=1 hb
+'
+
+test_expect_success 'ssh:// shared proxy for another URI gets its own socket' '
+	FLUX_URI=ssh://fred@localhost$TEST_SOCKDIR FLUX_SSH=$TEST_SSH \
+	  FLUX_SSH_PERSIST=60s TMPDIR=$(pwd)/persist \
+	  flux getattr size &&
+	persist_sockets persist >persist3.ls &&
+	test_line_count = 2 persist3.ls
+'
+
+test_expect_success 'ssh:// shared proxy exits after idle timeout' '
+	mkdir persist-idle &&
+	FLUX_URI=ssh://localhost$TEST_SOCKDIR FLUX_SSH=$TEST_SSH \
+	  FLUX_SSH_PERSIST=0.5s TMPDIR=$(pwd)/persist-idle \
+	  flux getattr size &&
+	count=0 &&
+	while test -n "$(persist_sockets persist-idle)"; do \
+	  sleep 0.5; \
+	  count=$((count+1)); \
+	  test $count -lt 60 || return 1; \
+	done
+'
+
+test_expect_success 'ssh:// with bad FLUX_SSH_PERSIST value fails in flux_open()' '
+	! FLUX_URI=ssh://localhost$TEST_SOCKDIR FLUX_SSH=$TEST_SSH \
+	  FLUX_SSH_PERSIST=bad flux getattr size 2>badpersist.out &&
+	grep -q "flux_open:" badpersist.out
+'
+
+test_expect_success 'flux proxy --idle-timeout requires --listen' '
+	test_must_fail flux proxy --idle-timeout=1s $FLUX_URI /bin/true
+'
+
 test_done
@@ -95,6 +95,13 @@ test_expect_success 'hwloc: every rank reloads the same xml of a node' '
     test_cmp hwloc-info.expected2 hwloc-info.out2
 '
 
+test_expect_success 'hwloc: ranks with the same xml share one valref' '
+    flux kvs get --treeobj resource.hwloc.xml.0 >treeobj0.out &&
+    flux kvs get --treeobj resource.hwloc.xml.1 >treeobj1.out &&
+    grep valref treeobj0.out &&
+    test_cmp treeobj0.out treeobj1.out
+'
+
 test_expect_success HAVE_JQ 'hwloc: only one rank reloads an xml file' '
     flux hwloc reload --rank="[0]" $exclu2 &&
     flux kvs get resource.hwloc.by_rank | $jq -S . > mixed.out &&
@@ -59,4 +59,32 @@ test_expect_success 'content from previous instance survived' '
 	test_cmp get.exp get.out
 '
 
+test_expect_success 'snapshot the checkpointed KVS root' '
+	flux start -o,--setattr=content.backing-path=$(pwd)/content.sqlite \
+	           flux content snapshot -v $(pwd)/content.snap 2>snap.err &&
+	test -f content.snap &&
+	grep "blobs from" snap.err
+'
+
+test_expect_success 're-run instance serving content from the snapshot' '
+	flux start -o,--setattr=content.backing-path=$(pwd)/content.sqlite \
+	           -o,--setattr=content.snapshot=$(pwd)/content.snap \
+	           sh -c "flux kvs get testkey && \
+	                  flux module stats --type int \
+	                      --parse snapshot-hits content" >snaprun.out &&
+	test "$(head -1 snaprun.out)" = "42" &&
+	test $(tail -1 snaprun.out) -gt 0
+'
+
+test_expect_success 'instance fails to start with a missing snapshot' '
+	test_must_fail flux start \
+	    -o,--setattr=content.snapshot=$(pwd)/nosuch.snap /bin/true
+'
+
+test_expect_success 'snapshot of an invalid root fails' '
+	test_must_fail flux start \
+	    flux content snapshot --root=sha1-1234 $(pwd)/bad.snap &&
+	! test -f bad.snap
+'
+
 test_done
@@ -75,6 +75,39 @@ test_expect_success 'flux-aggregate: --fwd-count works' '
         ".count == 8 and .total == 8 and .min == 1 and .max == 1"
 '
 
+test_expect_success 'flux-aggregate: --reduce=sum works' '
+    run_timeout 5 flux exec -n -r 0-7 bash -c \
+     "flux aggregate --reduce=sum test \$(flux getattr rank)" &&
+    kvs_json_check test ".count == 8 and (.entries | length) == 1" &&
+    kvs_json_check test ".entries.\"[0-7]\" == 28"
+'
+
+test_expect_success 'flux-aggregate: --reduce=min and max work' '
+    run_timeout 5 flux exec -n -r 0-7 bash -c \
+     "flux aggregate --reduce=min test 1.\$(flux getattr rank)" &&
+    kvs_json_check test ".entries.\"[0-7]\" == 1" &&
+    run_timeout 5 flux exec -n -r 0-7 bash -c \
+     "flux aggregate --reduce=max test \$(flux getattr rank)" &&
+    kvs_json_check test ".entries.\"[0-7]\" == 7 and .max == 7"
+'
+
+test_expect_success 'flux-aggregate: --reduce=idset works' '
+    run_timeout 5 flux exec -n -r 0-7 bash -c \
+     "flux aggregate --reduce=idset test \\\"\$(flux getattr rank)\\\"" &&
+    kvs_json_check test ".count == 8" &&
+    kvs_json_check test ".entries.\"[0-7]\" == \"0-7\""
+'
+
+test_expect_success 'push request with unknown reduce op fails with EINVAL(22)' '
+	echo "{\"key\":\"x\",\"total\":1,\"entries\":{\"0\":1},\"reduce\":\"foo\"}" \
+		| ${RPC} aggregator.push 22
+'
+
+test_expect_success 'push request with reduce op on wrong type fails with EINVAL(22)' '
+	echo "{\"key\":\"x\",\"total\":2,\"entries\":{\"0\":\"a\"},\"reduce\":\"sum\"}" \
+		| ${RPC} aggregator.push 22
+'
+
 test_expect_success 'push request with empty payload fails with EPROTO(71)' '
 	${RPC} aggregator.push 71 </dev/null
 '
@@ -19,6 +19,7 @@ flux setattr log-stderr-level 1
 JOBSPEC=${SHARNESS_TEST_SRCDIR}/jobspec
 Y2J="flux python ${JOBSPEC}/y2j.py"
 SUBMITBENCH="${FLUX_BUILD_DIR}/t/ingest/submitbench"
+SUBMITBULK="${FLUX_BUILD_DIR}/t/ingest/submit-bulk"
 RPC=${FLUX_BUILD_DIR}/t/request/rpc
 SCHEMA=${FLUX_SOURCE_DIR}/src/modules/job-ingest/schemas/jobspec.jsonschema
 BINDINGS_VALIDATOR=${FLUX_SOURCE_DIR}/src/modules/job-ingest/validators/validate-jobspec.py
@@ -158,6 +159,39 @@ test_expect_success 'job-ingest: submit job 100 times, reuse signature' '
 	${SUBMITBENCH} ${SUBMITBENCH_OPT_R} -r 100 use_case_2.6.json
 '
 
+test_expect_success 'job-ingest: bulk submit of 100 jobs works' '
+	${SUBMITBULK} --count=100 use_case_2.6.json >bulk.ids &&
+	test $(wc -l <bulk.ids) -eq 100 &&
+	test $(sort -u bulk.ids | wc -l) -eq 100 &&
+	sort -n -c bulk.ids
+'
+
+test_expect_success 'job-ingest: bulk submitted jobs are stored in KVS' '
+	for id in $(head -1 bulk.ids) $(tail -1 bulk.ids); do
+		kvsdir=$(flux job id --to=kvs $id) &&
+		flux kvs get --raw ${kvsdir}.jobspec >bulkjobspec.out &&
+		test_cmp use_case_2.6.json bulkjobspec.out || return 1
+	done
+'
+
+test_expect_success 'job-ingest: bulk submitted jobs announced to job manager' '
+	flux kvs eventlog get ${DUMMY_EVENTLOG} >bulkjobman.out &&
+	for id in $(head -1 bulk.ids) $(tail -1 bulk.ids); do
+		grep -q "\"id\":${id}" bulkjobman.out || return 1
+	done
+'
+
+test_expect_success 'job-ingest: bulk submit fails if any job is invalid' '
+	test_must_fail ${SUBMITBULK} --count=10 --bad=3 \
+		use_case_2.6.json 2>bulkbad.err &&
+	grep "job 3:" bulkbad.err
+'
+
+test_expect_success 'job-ingest: bulk submit with no jobs fails with EPROTO(71)' '
+	echo "{\"jobs\":[], \"priority\":16, \"flags\":0}" \
+		| ${RPC} job-ingest.submit-bulk 71
+'
+
 test_expect_success HAVE_FLUX_SECURITY 'job-ingest: submit user != signed user fails' '
 	! FLUX_HANDLE_USERID=9999 flux job submit basic.json 2>baduser.out &&
 	grep -q "signer=$(id -u) != requestor=9999" baduser.out
@@ -182,6 +216,77 @@ test_expect_success 'job-ingest: v1 jobspecs accepted with v1 requirement' '
 	test_valid ${JOBSPEC}/valid_v1/*
 '
 
+test_expect_success HAVE_JQ 'job-ingest: getinfo reports validator workers' '
+	${RPC} job-ingest.getinfo >getinfo.json &&
+	jq -e ".validator.builtin == false" getinfo.json &&
+	jq -e ".validator.\"max-workers\" == 4" getinfo.json &&
+	jq -e "[.validator.workers[].requests] | add > 0" getinfo.json &&
+	jq -e ".validator.workers[0].latency.p99 > 0" getinfo.json
+'
+
+test_expect_success 'job-ingest: validator-workers=0 is rejected' '
+	test_must_fail flux module reload job-ingest \
+		validator=${BINDINGS_VALIDATOR} validator-workers=0 &&
+	flux module load job-ingest validator=${BINDINGS_VALIDATOR}
+'
+
+test_expect_success 'job-ingest: validator pool size can be set' '
+	ingest_module reload \
+		validator=${BINDINGS_VALIDATOR} validator-workers=8 &&
+	${SUBMITBENCH} -r 100 use_case_2.6.json
+'
+
+test_expect_success HAVE_JQ 'job-ingest: getinfo reports validator pool size' '
+	${RPC} job-ingest.getinfo >getinfo8.json &&
+	jq -e ".validator.\"max-workers\" == 8" getinfo8.json &&
+	jq -e ".validator.workers | length == 8" getinfo8.json
+'
+
+test_expect_success 'job-ingest: load builtin validator' '
+	ingest_module reload validator=builtin
+'
+
+test_expect_success 'job-ingest: bulk submit works with builtin validator' '
+	${SUBMITBULK} --count=100 use_case_2.6.json >bulk-builtin.ids &&
+	test $(wc -l <bulk-builtin.ids) -eq 100 &&
+	test_must_fail ${SUBMITBULK} --count=10 --bad=9 use_case_2.6.json
+'
+
+test_expect_success HAVE_JQ 'job-ingest: getinfo reports builtin validator' '
+	${RPC} job-ingest.getinfo >getinfo-builtin.json &&
+	jq -e ".validator.builtin == true" getinfo-builtin.json &&
+	jq -e ".validator.workers | length == 0" getinfo-builtin.json
+'
+
+test_expect_success 'job-ingest: valid jobspecs accepted by builtin validator' '
+	test_valid ${JOBSPEC}/valid/*
+'
+
+test_expect_success 'job-ingest: invalid jobs rejected by builtin validator' '
+	test_invalid ${JOBSPEC}/invalid/*
+'
+
+test_expect_success HAVE_JQ 'job-ingest: builtin validator reports reason' '
+	jq ".version = 0" basic.json >badversion.json &&
+	test_must_fail flux job submit badversion.json 2>badversion.out &&
+	grep "version must be >= 1" badversion.out
+'
+
+test_expect_success 'job-ingest: builtin validator with version 1 enforced' '
+	ingest_module reload \
+		validator=builtin validator-args="--require-version,1"
+'
+
+test_expect_success 'job-ingest: v1 jobspecs accepted by builtin v1 validator' '
+	test_valid ${JOBSPEC}/valid_v1/*
+'
+
+test_expect_success 'job-ingest: builtin validator rejects unknown args' '
+	test_must_fail flux module reload job-ingest \
+		validator=builtin validator-args=--schema,${SCHEMA} &&
+	flux module load job-ingest validator=builtin
+'
+
 test_expect_success 'job-ingest: test non-python validator' '
 	ingest_module reload \
 		validator=${FAKE_VALIDATOR}
@@ -208,6 +313,39 @@ test_expect_success 'job-ingest: invalid jobs rejected by jsonschema validator'
 	test_invalid ${JOBSPEC}/invalid/*
 '
 
+test_expect_success HAVE_JQ 'job-ingest: getinfo reports batch statistics' '
+	${RPC} job-ingest.getinfo >batch.json &&
+	jq -e ".batch.timeout == 0.01" batch.json &&
+	jq -e ".batch.max == 0" batch.json &&
+	jq -e ".batch.count > 0" batch.json &&
+	jq -e ".batch.size.max >= 1" batch.json &&
+	jq -e "(.batch.size.hist | add) == .batch.count" batch.json &&
+	jq -e "(.batch.latency.hist | add) == .batch.count" batch.json
+'
+
+test_expect_success 'job-ingest: invalid batch options are rejected' '
+	test_must_fail flux module reload job-ingest batch-timeout=xyz &&
+	test_must_fail flux module load job-ingest batch-max=-1 &&
+	flux module load job-ingest
+'
+
+test_expect_success 'job-ingest: batch-max limits batch size' '
+	ingest_module reload batch-timeout=1s batch-max=8 &&
+	${SUBMITBENCH} -r 100 use_case_2.6.json
+'
+
+test_expect_success HAVE_JQ 'job-ingest: batches were no larger than batch-max' '
+	${RPC} job-ingest.getinfo >batchmax.json &&
+	jq -e ".batch.timeout == 1" batchmax.json &&
+	jq -e ".batch.max == 8" batchmax.json &&
+	jq -e ".batch.size.max <= 8" batchmax.json
+'
+
+test_expect_success 'job-ingest: a lone job is not held for batch-timeout' '
+	ingest_module reload batch-timeout=60s &&
+	run_timeout 30 flux job submit basic.json
+'
+
 test_expect_success 'job-ingest: validator unexpected exit is handled' '
 	ingest_module reload \
 		validator=${BAD_VALIDATOR} &&
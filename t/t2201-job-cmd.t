@@ -340,6 +340,11 @@ test_expect_success 'flux job: killall with no args works' '
 	test_cmp killall_0.exp killall_0.err
 '
 
+test_expect_success 'flux job: kill of several jobs that are not running fails' '
+	test_must_fail flux job kill 1 2 2>kill_list.err &&
+	grep "2 of 2 jobs not found or not eligible" kill_list.err
+'
+
 test_expect_success 'flux-job: killall with bad broker connection fails' '
 	! FLUX_URI=/wrong flux job killall
 '
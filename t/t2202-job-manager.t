@@ -126,6 +126,18 @@ test_expect_success 'job-manager: list-jobs --count shows highest priority jobs'
 	test_cmp list3_lim2.exp list3_lim2.out
 '
 
+test_expect_success 'job-manager: list-jobs --states=sched uses state index' '
+	${LIST_JOBS} --states=sched -c 2 | cut -f4 >list3_sched.out &&
+	test_cmp list3_lim2.exp list3_sched.out &&
+	test $(${LIST_JOBS} --states=run | wc -l) -eq 0
+'
+
+test_expect_success 'job-manager: list-jobs --user lists only that user' '
+	${LIST_JOBS} --user=$(id -u) >list3_user.out &&
+	test_cmp list3.out list3_user.out &&
+	test $(${LIST_JOBS} --user=$(($(id -u)+1)) | wc -l) -eq 0
+'
+
 test_expect_success 'job-manager: cancel jobs' '
 	for jobid in $(cut -f1 <list3.out); do \
 		flux job cancel ${jobid}; \
@@ -187,6 +199,28 @@ test_expect_success HAVE_JQ 'job-manager: max_jobid has not changed' '
 	test_cmp max2.exp max2.out
 '
 
+test_expect_success 'job-manager: jobs were restored from checkpoint' '
+	flux dmesg | grep "restart: 10 jobs from checkpoint"
+'
+
+test_expect_success 'job-manager: reload after changing job directory' '
+	flux module remove job-manager &&
+	flux kvs put job.snapshot-test=1 &&
+	flux dmesg -C &&
+	flux module load job-manager &&
+	flux kvs unlink job.snapshot-test
+'
+
+test_expect_success 'job-manager: eventlogs were replayed' '
+	flux dmesg | grep "restart: job directory changed since checkpoint" &&
+	flux dmesg | grep "restart: 10 jobs"
+'
+
+test_expect_success 'job-manager: queue was reconstructed from eventlogs' '
+	${LIST_JOBS} >list_replay.out &&
+	test_cmp list10_reordered.out list_replay.out
+'
+
 test_expect_success 'job-manager: cancel jobs' '
 	for jobid in $(cut -f1 <list_reload.out); do \
 		flux job cancel ${jobid}; \
@@ -202,6 +236,25 @@ test_expect_success 'job-manager: flux job priority fails on invalid priority' '
 	flux job cancel ${jobid}
 '
 
+test_expect_success 'job-manager: flux job priority sets priority of several jobs' '
+	id1=$(flux job submit basic.json) &&
+	id2=$(flux job submit basic.json) &&
+	flux job priority ${id1} ${id2} 3 &&
+	flux job wait-event --timeout=5.0 ${id1} priority &&
+	flux job wait-event --timeout=5.0 ${id2} priority &&
+	flux job eventlog ${id1} | grep priority=3 &&
+	flux job eventlog ${id2} | grep priority=3 &&
+	flux job cancel ${id1} &&
+	flux job cancel ${id2}
+'
+
+test_expect_success 'job-manager: flux job priority fails on unknown job in list' '
+	id1=$(flux job submit basic.json) &&
+	test_must_fail flux job priority ${id1} 7654321 3 2>pri_list.err &&
+	grep "1 of 2 jobs" pri_list.err &&
+	flux job cancel ${id1}
+'
+
 test_expect_success 'job-manager: guest can reduce priority from default' '
 	jobid=$(flux job submit  basic.json) &&
 	FLUX_HANDLE_ROLEMASK=0x2 flux job priority ${jobid} 5 &&
@@ -295,6 +348,9 @@ test_expect_success 'raise request with empty payload fails with EPROTO(71)' '
 test_expect_success 'priority request with empty payload fails with EPROTO(71)' '
 	${RPC} job-manager.priority 71 </dev/null
 '
+test_expect_success 'priorityall request with empty payload fails with EPROTO(71)' '
+	${RPC} job-manager.priorityall 71 </dev/null
+'
 test_expect_success 'sched-ready request with empty payload fails with EPROTO(71)' '
 	${RPC} job-manager.sched-ready 71 </dev/null
 '
@@ -304,6 +360,50 @@ test_expect_success 'exec-hello request with empty payload fails with EPROTO(71)
 test_expect_success 'submit request with empty payload fails with EPROTO(71)' '
 	${RPC} job-manager.submit 71 </dev/null
 '
+test_expect_success 'non-streaming journal request fails with EPROTO(71)' '
+	${RPC} job-manager.journal 71 </dev/null
+'
+
+test_expect_success HAVE_JQ 'job-manager: stats count pending jobs' '
+	${RPC} job-manager.stats.get </dev/null >admit0.json &&
+	jq -e ".admission.pending > 0" admit0.json &&
+	jq -e ".admission.\"max-pending\" == 0" admit0.json &&
+	jq -e ".admission.rejected == 0" admit0.json
+'
+test_expect_success 'job-manager: invalid admission options are rejected' '
+	test_must_fail flux module reload job-manager max-pending=xyz &&
+	test_must_fail flux module load job-manager max-pending-user=-1 &&
+	flux module load job-manager
+'
+test_expect_success HAVE_JQ 'job-manager: reload with max-pending' '
+	pending=$(jq .admission.pending admit0.json) &&
+	flux module reload job-manager max-pending=$((${pending}+1)) &&
+	${RPC} job-manager.stats.get </dev/null >admit1.json &&
+	jq -e ".admission.pending == ${pending}" admit1.json
+'
+test_expect_success 'job-manager: job is admitted up to max-pending' '
+	flux job submit basic.json
+'
+test_expect_success 'job-manager: job over max-pending fails' '
+	test_must_fail flux job submit basic.json 2>full.err &&
+	grep "job queue is full" full.err
+'
+test_expect_success HAVE_JQ 'job-manager: stats count rejected and paced' '
+	${RPC} job-manager.stats.get </dev/null >admit2.json &&
+	jq -e ".admission.rejected == 1" admit2.json &&
+	jq -e ".admission.paced >= 1" admit2.json &&
+	${RPC} job-ingest.getinfo </dev/null >ingest-admit.json &&
+	jq -e ".batch.rejected == 1 and .batch.credits == 0" ingest-admit.json
+'
+test_expect_success 'job-manager: job over max-pending-user fails' '
+	flux module reload job-manager max-pending-user=1 &&
+	test_must_fail flux job submit basic.json 2>user.err &&
+	grep "max-pending-user=1" user.err
+'
+test_expect_success 'job-manager: reload without limits' '
+	flux module reload job-manager &&
+	flux job submit basic.json
+'
 
 test_expect_success 'job-manager: remove job-manager, job-info, job-ingest' '
 	flux module remove job-manager &&
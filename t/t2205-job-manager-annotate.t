@@ -316,6 +316,20 @@ test_expect_success 'job-manager: remove sched-dummy' '
         flux module remove sched-dummy
 '
 
+test_expect_success HAVE_JQ 'job-manager: job-info applies successive annotation updates' '
+        jobid=$(flux job submit basic.json) &&
+        flux job annotate $jobid mykey foo &&
+        flux job annotate $jobid otherkey bar &&
+        jinfo_check_annotation $jobid "user.mykey" "\"foo\"" &&
+        jinfo_check_annotation $jobid "user.otherkey" "\"bar\"" &&
+        flux job annotate $jobid mykey baz &&
+        flux job annotate $jobid mykey baz &&
+        jmgr_check_annotation $jobid "user.mykey" "\"baz\"" &&
+        jinfo_check_annotation $jobid "user.mykey" "\"baz\"" &&
+        jinfo_check_annotation $jobid "user.otherkey" "\"bar\"" &&
+        flux job cancel $jobid
+'
+
 test_expect_success 'job-manager: remove job-manager, job-ingest' '
         flux module remove job-manager &&
         flux exec -r all flux module remove job-info &&
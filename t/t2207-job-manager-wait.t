@@ -71,6 +71,19 @@ test_expect_success "wait FLUX_JOBID_ANY works on three waitable jobs" '
 	test_cmp jobs_s.out wait_s.out
 '
 
+test_expect_success "wait FLUX_JOBID_ANY returns zombies in completion order" '
+	rm -f order.out &&
+	for i in 1 2 3; do
+		JOBID=$(flux mini submit --flags waitable /bin/true) &&
+		flux job wait-event ${JOBID} clean &&
+		echo ${JOBID} >>order.out || return 1
+	done &&
+	flux job wait >order_wait.out &&
+	flux job wait >>order_wait.out &&
+	flux job wait >>order_wait.out &&
+	test_cmp order.out order_wait.out
+'
+
 test_expect_success 'python submit-wait example works' '
         ${SUBMIT_WAIT} >submit_wait.out &&
         test $(grep Success submit_wait.out | wc -l) -eq 5
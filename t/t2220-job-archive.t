@@ -270,4 +270,76 @@ test_expect_success 'job-archive: both db exists after module unloaded' '
         test $count -eq 8
 '
 
+test_expect_success 'job-archive: load module with long period' '
+        flux module load job-archive dbpath=${ARCHIVEDB}-NEW period=1h
+'
+
+test_expect_success 'job-archive: inactive job stored before period expires' '
+        jobid=`flux mini submit hostname` &&
+        fj_wait_event $jobid clean &&
+        wait_db $jobid ${ARCHIVEDB}-NEW &&
+        db_check_entries $jobid ${ARCHIVEDB}-NEW &&
+        db_check_values_run $jobid ${ARCHIVEDB}-NEW
+'
+
+test_expect_success 'job-archive: jobs submitted together are all stored' '
+        for i in 1 2 3 4; do flux mini submit hostname; done >batch.ids &&
+        for id in $(cat batch.ids); do fj_wait_event $id clean; done &&
+        for id in $(cat batch.ids); do wait_db $id ${ARCHIVEDB}-NEW; done &&
+        count=`db_count_entries ${ARCHIVEDB}-NEW` &&
+        test $count -eq 13
+'
+
+test_expect_success 'job-archive: scalar columns are stored' '
+        id=$(flux job id $(tail -1 batch.ids)) &&
+        ${QUERYCMD} ${ARCHIVEDB}-NEW \
+            "select name,nnodes,ntasks,result from jobs where id=$id;" \
+            >scalar.out &&
+	cat <<-EOF >scalar.exp &&
+	name = hostname
+	nnodes = 1
+	ntasks = 1
+	result = COMPLETED
+	EOF
+        test_cmp scalar.exp scalar.out
+'
+
+test_expect_success 'job-archive: jobs_summary view lists jobs by day' '
+        ${QUERYCMD} ${ARCHIVEDB}-NEW \
+            "select sum(c) as n from (select day, count(*) as c \
+             from jobs_summary where day is not null group by day);" \
+            >summary.out &&
+        test "$(cat summary.out)" = "n = 13"
+'
+
+test_expect_success 'job-archive: unload module' '
+        flux module unload job-archive
+'
+
+test_expect_success 'job-archive: create db with old schema' '
+	cat <<-EOF >oldschema.py &&
+	import sys, sqlite3
+	con = sqlite3.connect(sys.argv[1])
+	con.execute("CREATE TABLE jobs(id CHAR(16) PRIMARY KEY, userid INT,"
+	            " ranks TEXT, t_submit REAL, t_sched REAL, t_run REAL,"
+	            " t_cleanup REAL, t_inactive REAL, eventlog TEXT,"
+	            " jobspec TEXT, R TEXT)")
+	con.commit()
+	EOF
+        flux python oldschema.py ${ARCHIVEDB}-OLD
+'
+
+test_expect_success 'job-archive: old schema gains scalar columns' '
+        flux module load job-archive dbpath=${ARCHIVEDB}-OLD &&
+        jobid=`flux mini submit hostname` &&
+        fj_wait_event $jobid clean &&
+        wait_db $jobid ${ARCHIVEDB}-OLD &&
+        id=$(flux job id $jobid) &&
+        ${QUERYCMD} ${ARCHIVEDB}-OLD \
+            "select nnodes,result from jobs where id=$id;" >old.out &&
+        grep "nnodes = 1" old.out &&
+        grep "result = COMPLETED" old.out &&
+        flux module unload job-archive
+'
+
 test_done
@@ -34,6 +34,18 @@ wait_jobid_state() {
         return 0
 }
 
+# job-info reads jobs from the KVS after it is loaded
+wait_loaded() {
+        local i=0
+        while [ "$(flux module stats --parse loading job-info)" != "0" ] \
+              && [ $i -lt 50 ]
+        do
+                sleep 0.1
+                i=$((i + 1))
+        done
+        test "$i" -lt 50
+}
+
 #
 # job list tests
 #
@@ -346,6 +358,56 @@ test_expect_success HAVE_JQ 'flux job list all jobs works' '
         test_cmp all.ids list_all_jobids.out
 '
 
+test_expect_success HAVE_JQ 'job-info.list cursor pages through all jobs' '
+        id=$(id -u) &&
+        req="{max_entries:5, userid:${id}, states:0, results:0, attrs:[]}" &&
+        $jq -j -c -n "$req" | $RPC job-info.list > page.json &&
+        $jq ".jobs[].id" page.json > list_paged.out &&
+        while $jq -e .cursor page.json >/dev/null; do
+            $jq -j -c -n --argjson c "$($jq -c .cursor page.json)" \
+                "$req + {cursor:\$c}" \
+              | $RPC job-info.list > page.json &&
+            $jq ".jobs[].id" page.json >> list_paged.out || return 1
+        done &&
+        test_cmp all.ids list_paged.out
+'
+
+test_expect_success HAVE_JQ 'job-info.list cursor for any user works' '
+        $jq -j -c -n "{max_entries:3, userid:4294967295, states:0, results:0, attrs:[]}" \
+          | $RPC job-info.list > page_all.json &&
+        $jq -j -c -n --argjson c "$($jq -c .cursor page_all.json)" \
+            "{max_entries:3, userid:4294967295, states:0, results:0, attrs:[], cursor:\$c}" \
+          | $RPC job-info.list | $jq ".jobs[].id" > list_page2.out &&
+        sed -n 4,6p all.ids > list_page2.exp &&
+        test_cmp list_page2.exp list_page2.out
+'
+
+test_expect_success HAVE_JQ 'job-info.list with malformed cursor fails with EPROTO' '
+        $jq -j -c -n "{max_entries:3, userid:0, states:0, results:0, attrs:[], cursor:{list:\"foo\"}}" \
+          | $RPC job-info.list 71
+'
+
+test_expect_success 'streaming job-info.list returns all jobs in chunks' '
+	cat <<-EOF >list-stream.py &&
+	import flux, flux.job
+	for job in flux.job.job_list_stream(flux.Flux(), 0, states=0, chunk_size=5):
+	    print(job["id"])
+	EOF
+        flux python list-stream.py > list_stream.out &&
+        test_cmp all.ids list_stream.out
+'
+
+test_expect_success 'streaming job-info.list respects max_entries' '
+	cat <<-EOF >list-stream-max.py &&
+	import flux, flux.job
+	for job in flux.job.job_list_stream(flux.Flux(), 7, states=0, chunk_size=3):
+	    print(job["id"])
+	EOF
+        flux python list-stream-max.py > list_stream_max.out &&
+        head -n 7 all.ids > list_stream_max.exp &&
+        test_cmp list_stream_max.exp list_stream_max.out
+'
+
 test_expect_success HAVE_JQ 'job stats lists jobs in correct state (mix)' '
         flux job stats | jq -e ".job_states.depend == 0" &&
         flux job stats | jq -e ".job_states.sched == $(state_count pending)" &&
@@ -380,6 +442,7 @@ wait_inactive() {
 test_expect_success 'reload the job-info module' '
         flux job list -a > before_reload.out &&
         flux module reload job-info &&
+        wait_loaded &&
         wait_inactive
 '
 
@@ -637,7 +700,8 @@ test_expect_success HAVE_JQ 'flux job lists full path for job name if basename f
 '
 
 test_expect_success 'reload the job-info module' '
-        flux module reload job-info
+        flux module reload job-info &&
+        wait_loaded
 '
 
 test_expect_success HAVE_JQ 'verify job names preserved across restart' '
@@ -674,7 +738,8 @@ test_expect_success HAVE_JQ 'flux job list outputs ntasks correctly (4 tasks)' '
 '
 
 test_expect_success 'reload the job-info module' '
-        flux module reload job-info
+        flux module reload job-info &&
+        wait_loaded
 '
 
 test_expect_success HAVE_JQ 'verify task count preserved across restart' '
@@ -786,7 +851,8 @@ test_expect_success HAVE_JQ 'flux job list outputs expiration time when set' '
 '
 
 test_expect_success 'reload the job-info module' '
-        flux module reload job-info
+        flux module reload job-info &&
+        wait_loaded
 '
 
 test_expect_success HAVE_JQ 'verify nnodes preserved across restart' '
@@ -979,6 +1045,125 @@ test_expect_success HAVE_JQ 'list-inactive request with invalid input fails with
 	test_cmp ${name}.expected ${name}.out
 '
 
+#
+# inactive job retention
+#
+
+wait_evicted() {
+        local i=0
+        while [ "$(flux module stats --parse jobs.inactive job-info)" != "$1" ] \
+              && [ $i -lt 50 ]
+        do
+                sleep 0.1
+                i=$((i + 1))
+        done
+        test "$i" -lt 50
+}
+
+test_expect_success 'job-info fails to load with invalid inactive-limit' '
+        flux module remove job-info &&
+        test_must_fail flux module load job-info inactive-limit=-1 &&
+        test_must_fail flux module load job-info inactive-age-limit=foo
+'
+test_expect_success 'reload job-info with inactive-limit=2' '
+        flux job list -s inactive -c 0 | jq .id > retention_all.ids &&
+        test $(wc -l < retention_all.ids) -gt 2 &&
+        flux module load job-info inactive-limit=2 &&
+        wait_loaded &&
+        wait_evicted 2
+'
+test_expect_success 'only the 2 newest inactive jobs are listed' '
+        flux job list -s inactive -c 0 | jq .id > retention_kept.ids &&
+        head -2 retention_all.ids > retention_kept.expected &&
+        test_cmp retention_kept.expected retention_kept.ids
+'
+test_expect_success 'evicted jobs are counted in module stats' '
+        evicted=$(flux module stats --parse jobs.evicted job-info) &&
+        test $evicted -eq $(($(wc -l < retention_all.ids) - 2))
+'
+test_expect_success 'job-info.list-id of an evicted job fails with ENOENT' '
+        id=$(tail -1 retention_all.ids) &&
+        test_must_fail flux job list-ids $id 2>list_id_evicted.err &&
+        grep "evicted" list_id_evicted.err
+'
+test_expect_success 'newly inactive jobs evict the oldest kept job' '
+        jobid=$(flux mini submit hostname | flux job id) &&
+        fj_wait_event $jobid clean &&
+        wait_evicted 2 &&
+        flux job list -s inactive -c 0 | jq .id > retention_new.ids &&
+        test $(head -1 retention_new.ids) -eq $jobid &&
+        test $(tail -1 retention_new.ids) -eq $(head -1 retention_all.ids)
+'
+test_expect_success 'reload job-info without retention limits' '
+        flux module reload job-info &&
+        wait_loaded &&
+        test $(flux job list -s inactive -c 0 | wc -l) -gt 3
+'
+
+#
+# startup
+#
+
+test_expect_success 'job-info fails to load with invalid load-concurrency' '
+        flux module remove job-info &&
+        test_must_fail flux module load job-info load-concurrency=0 &&
+        test_must_fail flux module load job-info load-concurrency=foo
+'
+test_expect_success 'job-info reads the same jobs with load-concurrency=1' '
+        flux module load job-info &&
+        wait_loaded &&
+        flux job list -a -c 0 | jq .id > load_all.ids &&
+        flux module reload job-info load-concurrency=1 &&
+        wait_loaded &&
+        flux job list -a -c 0 | jq .id > load_one.ids &&
+        test_cmp load_all.ids load_one.ids
+'
+test_expect_success 'jobs submitted while loading are listed' '
+        flux module reload job-info load-concurrency=1 &&
+        jobid=$(flux mini submit hostname | flux job id) &&
+        fj_wait_event $jobid clean &&
+        wait_loaded &&
+        wait_jobid_state $jobid inactive
+'
+
+#
+# job-manager journal
+#
+
+test_expect_success 'job-info follows the job-manager journal' '
+        flux module reload job-info &&
+        wait_loaded &&
+        jobid=$(flux mini submit hostname | flux job id) &&
+        fj_wait_event $jobid clean &&
+        wait_jobid_state $jobid inactive &&
+        test "$(flux module stats --parse journal.running job-info)" = "true"
+'
+test_expect_success HAVE_JQ 'journal transitions need no KVS lookups' '
+        before=$(flux module stats --parse journal.state_lookups job-info) &&
+        jobid=$(flux mini submit -n2 -N2 hostname | flux job id) &&
+        fj_wait_event $jobid clean &&
+        wait_jobid_state $jobid inactive &&
+        after=$(flux module stats --parse journal.state_lookups job-info) &&
+        test $after -eq $before &&
+        flux job list-ids $jobid > journal.out &&
+        jq -e ".name == \"hostname\"" < journal.out &&
+        jq -e ".ntasks == 2 and .nnodes == 2" < journal.out &&
+        jq -e ".success == true and .result == 1" < journal.out
+'
+test_expect_success HAVE_JQ 'journal reports exceptions' '
+        before=$(flux module stats --parse journal.state_lookups job-info) &&
+        jobid=$(flux mini submit sleep 300 | flux job id) &&
+        fj_wait_event $jobid start &&
+        flux job cancel $jobid &&
+        fj_wait_event $jobid clean &&
+        wait_jobid_state $jobid inactive &&
+        after=$(flux module stats --parse journal.state_lookups job-info) &&
+        test $after -eq $before &&
+        flux job list-ids $jobid > journal_cancel.out &&
+        jq -e ".success == false and .exception_type == \"cancel\"" \
+            < journal_cancel.out
+'
+
 #
 # stress test
 #
@@ -169,6 +169,47 @@ test_expect_success 'flux job eventlog -p fails on invalid path' '
         test_must_fail flux job eventlog -p "foobar" $jobid
 '
 
+#
+# lookup cache tests
+#
+
+lookup_cache_stat() {
+        flux module stats --parse lookup_cache.$1 job-info
+}
+
+test_expect_success 'flux job info of inactive job is served from cache' '
+        jobid=$(submit_job) &&
+        hits=$(lookup_cache_stat hits) &&
+        flux job info $jobid jobspec R eventlog >cache_a1.out &&
+        i=0 &&
+        while test $(lookup_cache_stat hits) -le $hits && test $i -lt 50
+        do
+                flux job info $jobid jobspec R eventlog >cache_a2.out
+                i=$((i+1))
+        done &&
+        test $(lookup_cache_stat hits) -gt $hits &&
+        test_cmp cache_a1.out cache_a2.out
+'
+
+test_expect_success 'lookup cache accounts for cached bytes' '
+        test $(lookup_cache_stat count) -ge 3 &&
+        test $(lookup_cache_stat bytes) -gt 0
+'
+
+test_expect_success 'lookup cache can be disabled' '
+        flux module reload job-info lookup-cache-size=0 &&
+        jobid=$(submit_job) &&
+        flux job info $jobid jobspec >/dev/null &&
+        flux job info $jobid jobspec >/dev/null &&
+        test $(lookup_cache_stat count) -eq 0 &&
+        test $(lookup_cache_stat hits) -eq 0
+'
+
+test_expect_success 'job-info fails to load with invalid lookup-cache-size' '
+        test_must_fail flux module reload job-info lookup-cache-size=-1 &&
+        flux module load job-info
+'
+
 #
 # stats & corner cases
 #
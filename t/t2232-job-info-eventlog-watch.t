@@ -200,6 +200,38 @@ test_expect_success 'flux job wait-event w/ bad match-context fails (invalid inp
         test_must_fail fj_wait_event --match-context=foo $jobid exception
 '
 
+test_expect_success 'flux job wait-event --start skips events' '
+        jobid=$(submit_job) &&
+        fj_wait_event --verbose $jobid clean > wait_event_start.all &&
+        fj_wait_event --verbose --start=2 $jobid clean > wait_event_start1.out &&
+        tail -n +3 wait_event_start.all > wait_event_start1.exp &&
+        test_cmp wait_event_start1.exp wait_event_start1.out
+'
+
+test_expect_success 'flux job wait-event --start < 0 starts with last events' '
+        fj_wait_event --verbose --start=-2 $jobid clean > wait_event_start2.out &&
+        tail -n 2 wait_event_start.all > wait_event_start2.exp &&
+        test_cmp wait_event_start2.exp wait_event_start2.out &&
+        fj_wait_event --verbose --start=-1000 $jobid clean > wait_event_start3.out &&
+        test_cmp wait_event_start.all wait_event_start3.out
+'
+
+test_expect_success 'flux job wait-event --start past clean gets no event' '
+        test_must_fail fj_wait_event --start=1000 $jobid clean
+'
+
+test_expect_success 'flux job wait-event --start works (guest.exec.eventlog)' '
+        fj_wait_event -v -p guest.exec.eventlog $jobid done > wait_event_start4.all &&
+        fj_wait_event -v -p guest.exec.eventlog --start=1 $jobid done \
+                > wait_event_start4.out &&
+        tail -n +2 wait_event_start4.all > wait_event_start4.exp &&
+        test_cmp wait_event_start4.exp wait_event_start4.out
+'
+
+test_expect_success 'flux job wait-event --start < 0 fails on guest eventlog' '
+        test_must_fail fj_wait_event -p guest.exec.eventlog --start=-1 $jobid done
+'
+
 test_expect_success 'flux job wait-event -p works (eventlog)' '
         jobid=$(submit_job) &&
         fj_wait_event -p "eventlog" $jobid submit > wait_event_path1.out &&
@@ -306,13 +338,73 @@ test_expect_success NO_CHAIN_LINT 'flux job wait-event -p guest.exec.eventlog wo
         flux job cancel ${jobidall}
 '
 
+#
+# state-watch
+#
+
+test_expect_success 'create state-watch script' '
+	cat <<-EOF >state-watch.py
+	import sys, errno, flux
+	from flux.constants import FLUX_RPC_STREAMING
+	h = flux.Flux()
+	ids = [int(x) for x in sys.argv[1:]]
+	rpc = h.rpc("job-info.state-watch", {"ids": ids}, flags=FLUX_RPC_STREAMING)
+	while True:
+	    try:
+	        trans = rpc.get()["transitions"]
+	    except OSError as exc:
+	        if exc.errno == errno.ENODATA:
+	            break
+	        raise
+	    for (id, state, timestamp) in trans:
+	        print(f"{id} {state}")
+	    sys.stdout.flush()
+	    rpc.reset()
+	EOF
+'
+test_expect_success 'state-watch of inactive jobs returns their state' '
+        jobid1=$(submit_job | flux job id) &&
+        jobid2=$(submit_job | flux job id) &&
+        flux python state-watch.py $jobid1 $jobid2 >state_watch1.out &&
+	cat <<-EOF >state_watch1.exp &&
+	$jobid1 INACTIVE
+	$jobid2 INACTIVE
+	EOF
+        test_cmp state_watch1.exp state_watch1.out
+'
+test_expect_success NO_CHAIN_LINT 'state-watch follows a job until inactive' '
+        jobid=$(submit_job_live sleeplong.json | flux job id)
+        flux python state-watch.py $jobid >state_watch2.out &
+        pid=$! &&
+        wait_watchers_nonzero "state_watchers" &&
+        flux job cancel $jobid &&
+        wait $pid &&
+	cat <<-EOF >state_watch2.exp &&
+	$jobid RUN
+	$jobid CLEANUP
+	$jobid INACTIVE
+	EOF
+        tail -3 state_watch2.out >state_watch2.tail &&
+        test_cmp state_watch2.exp state_watch2.tail
+'
+test_expect_success 'state-watch ends when watchers are gone' '
+        test "$(flux module stats --parse state_watchers job-info)" = "0"
+'
+test_expect_success 'state-watch request without streaming flag fails with EPROTO(71)' '
+        echo "{\"ids\":[]}" | ${RPC} job-info.state-watch 71
+'
+test_expect_success 'state-watch request with ids and userid fails with EPROTO(71)' '
+        echo "{\"ids\":[], \"userid\":0}" | ${RPC} job-info.state-watch 71
+'
+
 #
 # stats & corner cases
 #
 
 test_expect_success 'job-info stats works' '
         flux module stats --parse watchers job-info &&
-        flux module stats --parse guest_watchers job-info
+        flux module stats --parse guest_watchers job-info &&
+        flux module stats --parse state_watchers job-info
 '
 
 test_expect_success 'eventlog-watch request with empty payload fails with EPROTO(71)' '
@@ -178,6 +178,12 @@ test_expect_success 'sched-simple: check allocations for running jobs' '
 	EOF
 	test_cmp first-fit-allocs.expected first-fit-allocs.out
 '
+test_expect_success HAVE_JQ 'sched-simple: sched-hello response includes R' '
+	${FLUX_BUILD_DIR}/t/request/rpc job-manager.sched-hello \
+		</dev/null >hello.out &&
+	test $(jq ".alloc | length" hello.out) -eq 3 &&
+	test $(jq "[.alloc[] | select(.R)] | length" hello.out) -eq 3
+'
 test_expect_success 'sched-simple: reload with outstanding allocations' '
 	flux module reload sched-simple &&
 	flux dmesg | grep "hello: alloc rank0/core0" &&
@@ -227,6 +233,71 @@ test_expect_success 'sched-simple: there are no outstanding sched requests' '
 	grep "0 free requests pending to scheduler" queue_status.out
 '
 
+test_expect_success 'sched-simple: reload in unlimited mode with batch=2' '
+	flux dmesg -C &&
+	flux module load sched-simple unlimited batch=2 &&
+	flux dmesg | grep "scheduler: ready unlimited batch=2"
+'
+test_expect_success 'sched-simple: submit 4 jobs with batched alloc' '
+	for i in $(seq 1 4); do \
+		flux job submit basic.json >>batch.ids || return 1; \
+	done &&
+	for id in $(head -3 batch.ids); do \
+		flux job wait-event --timeout=5.0 ${id} alloc || return 1; \
+	done &&
+	test "$($query)" = ""
+'
+test_expect_success 'sched-simple: batched free unblocks remaining job' '
+	flux job cancel $(head -1 batch.ids) &&
+	flux job wait-event --timeout=5.0 $(head -1 batch.ids) clean &&
+	flux job wait-event --timeout=5.0 $(tail -1 batch.ids) alloc
+'
+test_expect_success 'sched-simple: remove sched-simple and cancel jobs' '
+	flux module remove sched-simple &&
+	flux job cancelall -f
+'
+test_expect_success 'sched-simple: there are no outstanding sched requests' '
+	flux queue status -v 2>queue_status.out &&
+	grep "0 alloc requests pending to scheduler" queue_status.out &&
+	grep "0 free requests pending to scheduler" queue_status.out
+'
+test_expect_success 'sched-simple: batch=0 disables batching' '
+	flux dmesg -C &&
+	flux module load sched-simple unlimited batch=0 &&
+	flux dmesg | grep "scheduler: ready unlimited" >ready.out &&
+	test_must_fail grep batch= ready.out &&
+	flux module remove sched-simple
+'
+test_expect_success 'sched-simple: invalid batch value fails' '
+	test_must_fail flux module load sched-simple batch=foo
+'
+
+test_expect_success 'sched-simple: invalid queue-depth value fails' '
+	test_must_fail flux module load sched-simple queue-depth=-1
+'
+test_expect_success 'sched-simple: reload in unlimited mode with queue-depth=4' '
+	flux module load sched-simple unlimited queue-depth=4
+'
+test_expect_success 'sched-simple: submit job using 2 cores for 10m' '
+	flux jobspec srun -n2 -t 10 hostname | flux job submit >bf1.id &&
+	flux job wait-event --timeout=5.0 $(cat bf1.id) alloc
+'
+test_expect_success 'sched-simple: submit job using all cores, which blocks' '
+	flux jobspec srun -n3 hostname | flux job submit >bf2.id
+'
+test_expect_success 'sched-simple: job without time limit is not backfilled' '
+	flux job submit basic.json >bf3.id &&
+	test_must_fail flux job wait-event --timeout=1.0 $(cat bf3.id) alloc
+'
+test_expect_success 'sched-simple: short job is backfilled' '
+	flux jobspec srun -n1 -t 1 hostname | flux job submit >bf4.id &&
+	flux job wait-event --timeout=5.0 $(cat bf4.id) alloc &&
+	test_must_fail flux job wait-event --timeout=0.1 $(cat bf2.id) alloc
+'
+test_expect_success 'sched-simple: remove sched-simple and cancel jobs' '
+	flux module remove sched-simple &&
+	flux job cancelall -f
+'
 test_expect_success 'sched-simple: load sched-simple and wait for queue drain' '
 	flux module load sched-simple &&
 	run_timeout 30 flux queue drain
@@ -9,6 +9,7 @@ test -n "$FLUX_TESTS_LOGFILE" && set -- "$@" --logfile
 test_under_flux 4 job
 
 query="flux resource list --state=free -no {rlist}"
+waitfile=${SHARNESS_TEST_SRCDIR}/scripts/waitfile.lua
 
 
 hwloc_by_rank='{"0-1": {"Core": 4, "cpuset": "0-3", "coreids": "0-3"}}'
@@ -97,4 +98,29 @@ test_expect_success 'sched-simple: job is scheduled when resource undrained' '
 	check_nnodes "allocated" 2 &&
 	check_ncores "allocated" 2
 '
+test_expect_success 'sched-simple: resource-summary matches resource-status' '
+	fmt="{state} {nnodes} {ncores} {ngpus} {ranks}" &&
+	states=all,up,down,allocated,free &&
+	flux resource list -n -s $states -o "$fmt" >summary.out &&
+	flux python -c "import flux,json; \
+		print(json.dumps(flux.Flux().rpc(\"sched.resource-status\").get()))" \
+		| flux resource list --from-stdin -n -s $states -o "$fmt" \
+		>status.out &&
+	test_debug "cat summary.out" &&
+	test_cmp status.out summary.out
+'
+test_expect_success 'sched-simple: flux resource list --watch works' '
+	flux resource list -w -n -s free -o "{ncores}" >watch.out &
+	pid=$! &&
+	$waitfile -t 10 -c 1 -p "^3$" watch.out &&
+	id=$(flux mini submit -n1 hostname) &&
+	flux job wait-event -t 10 $id alloc &&
+	$waitfile -t 10 -c 1 -p "^2$" watch.out &&
+	kill $pid &&
+	test_debug "cat watch.out" &&
+	test $(wc -l <watch.out) -eq 2
+'
+test_expect_success 'sched-simple: flux resource list --watch fails with {rlist}' '
+	test_must_fail flux resource list -w -o "{rlist}"
+'
 test_done
@@ -0,0 +1,63 @@
+#!/bin/sh
+
+test_description='Test sched-simple allocator benchmark'
+
+. `dirname $0`/sharness.sh
+
+bench=${FLUX_BUILD_DIR}/t/sched-simple/sched-bench
+
+summary() {
+	grep -E "^(resources|allocated|unsatisfiable|attempts|makespan|latency|utilization)" "$@"
+}
+
+test_expect_success 'sched-bench: runs with default workload' '
+	$bench >default.out &&
+	grep "^jobs: 1000" default.out &&
+	grep "^allocated: 1000" default.out &&
+	grep "^allocs/s:" default.out
+'
+test_expect_success 'sched-bench: simulates FCFS queue' '
+	$bench --nodes=2 --cores=2 --jobs=3 --size=2 --duration=10 \
+		>fcfs.out &&
+	cat >fcfs.expected <<-EOF &&
+	resources: rank[0-1]/core[0-1]
+	allocated: 3
+	unsatisfiable: 0
+	attempts: 4
+	makespan: 20.0s
+	latency p50: 0.0s
+	latency p90: 10.0s
+	latency p99: 10.0s
+	latency max: 10.0s
+	utilization: 75.0%
+	EOF
+	summary fcfs.out >fcfs.summary &&
+	test_cmp fcfs.expected fcfs.summary
+'
+test_expect_success 'sched-bench: jobs larger than resources are skipped' '
+	$bench --nodes=1 --cores=4 --jobs=10 --size=3-5 >skip.out &&
+	grep "^unsatisfiable: [1-9]" skip.out
+'
+test_expect_success 'sched-bench: all modes give the same schedule for cores' '
+	for mode in worst-fit best-fit first-fit; do
+		$bench --mode=$mode --jobs=200 --interval=0.5 >$mode.out &&
+		summary $mode.out >$mode.summary || return 1
+	done &&
+	test_cmp worst-fit.summary best-fit.summary &&
+	test_cmp worst-fit.summary first-fit.summary
+'
+test_expect_success 'sched-bench: reads resource.hwloc.by_rank file' '
+	cat >by_rank.json <<-EOF &&
+	{"0-3": {"Core": 4, "cpuset": "0-3", "coreids": "0-3"}}
+	EOF
+	$bench --by-rank=by_rank.json --size=1-4 >by_rank.out &&
+	grep "^resources: rank\[0-3\]/core\[0-3\]" by_rank.out
+'
+test_expect_success 'sched-bench: invalid arguments fail' '
+	test_must_fail $bench --mode=foo &&
+	test_must_fail $bench --size=4-2 &&
+	test_must_fail $bench --duration=x &&
+	test_must_fail $bench --jobs=0 &&
+	test_must_fail $bench --R=/nonexistent
+'
+test_done
@@ -252,6 +252,13 @@ test_expect_success HAVE_JQ,NO_CHAIN_LINT 'add/remove new exclusion causes down/
 	kill -15 $pid && wait $pid || true
 '
 
+test_expect_success HAVE_JQ 'stats.get reports acquire update responses' '
+	$RPC $RESNAME.stats.get </dev/null >stats.out &&
+	jq -e ".acquire.updates > 0" stats.out &&
+	jq -e ".acquire.bytes > 0" stats.out &&
+	jq -e ".acquire.cpu >= 0" stats.out
+'
+
 test_expect_success 'unload resource module' '
 	flux module remove $RESNAME
 '
@@ -116,4 +116,34 @@ test_expect_success FLAKY_TESTS 'job-exec: exception during cleanup' '
 test_expect_success 'start request with empty payload fails with EPROTO(71)' '
 	${RPC} job-exec.start 71 </dev/null
 '
+test_expect_success HAVE_JQ 'job-manager.stats.get reports stage latency' '
+	flux module stats --clear job-manager &&
+	flux module stats --clear job-exec &&
+	jobid=$(flux mini submit hostname) &&
+	flux job wait-event -t 10 ${jobid} clean &&
+	flux module stats job-manager >jm-stats.json &&
+	for stage in validate ingest depend queue sched exec total; do
+		jq -e ".latency.${stage}.count == 1" jm-stats.json || return 1
+	done &&
+	jq -e ".latency.total.total >= .latency.exec.total" jm-stats.json
+'
+test_expect_success HAVE_JQ 'job-exec.stats.get reports stage latency' '
+	flux module stats job-exec >exec-stats.json &&
+	jq -e ".latency.init.count == 1" exec-stats.json &&
+	jq -e ".latency.launch.count == 1" exec-stats.json
+'
+test_expect_success 'flux job stats --latency shows pipeline stages' '
+	flux job stats --latency >latency.out &&
+	test_debug "cat latency.out" &&
+	head -1 latency.out | grep "^STAGE" &&
+	for stage in validate ingest depend queue sched exec \
+		exec.init exec.launch total; do
+		grep "^${stage} *1 " latency.out || return 1
+	done
+'
+test_expect_success 'flux module stats --clear clears stage latency' '
+	flux module stats --clear job-manager &&
+	flux job stats --latency >latency-clear.out &&
+	grep "^total *0 " latency-clear.out
+'
 test_done
@@ -99,4 +99,29 @@ test_expect_success 'job-exec: exception while starting terminates job' '
 	     | flux job submit) &&
 	flux job wait-event -vt 5 $id clean
 '
+test_expect_success 'job-exec: output from relayed job shell sent to flux log' '
+	id=$(flux jobspec srun -N4 \
+	     "test \$JOB_SHELL_RANK = 3 && echo relayed hello || true" \
+	     | flux job submit) &&
+	flux job wait-event $id clean &&
+	flux dmesg | grep "$(flux job id $id): 3: stdout: relayed hello"
+'
+test_expect_success 'job-exec: launch falls back to direct without relay' '
+	flux exec -r 1 flux module remove job-exec &&
+	id=$(flux jobspec srun -N4 \
+	    "flux kvs put test2.\$BROKER_RANK=\$JOB_SHELL_RANK" \
+	    | flux job submit) &&
+	flux job wait-event $id clean &&
+	kvsdir=$(flux job id --to=kvs $id).guest &&
+	test $(flux kvs get ${kvsdir}.test2.1) = 1 &&
+	test $(flux kvs get ${kvsdir}.test2.3) = 3 &&
+	flux dmesg | grep "job-exec not loaded on rank 1" &&
+	flux exec -r 1 flux module load job-exec
+'
+test_expect_success 'job-exec: tree-launch=0 launches shells directly' '
+	flux module reload job-exec tree-launch=0 &&
+	id=$(flux jobspec srun -N4 "exit \$JOB_SHELL_RANK" | flux job submit) &&
+	flux job wait-event -vt 10 $id finish | grep status=768 &&
+	flux module reload job-exec
+'
 test_done
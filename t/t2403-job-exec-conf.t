@@ -40,6 +40,26 @@ test_expect_success 'job-exec: bad kill-timeout config causes module failure' '
 	) &&
 	grep "invalid kill-timeout: foo" ${name}.log
 '
+test_expect_success 'job-exec: start requests are batched by default' '
+	test $(flux module stats --parse batch job-exec) -gt 0 &&
+	flux mini run -n1 hostname
+'
+test_expect_success 'job-exec: batch-size=0 disables batching' '
+	flux module reload job-exec batch-size=0 &&
+	test $(flux module stats --parse batch job-exec) -eq 0 &&
+	flux mini run -n1 hostname
+'
+test_expect_success 'job-exec: batch-size is capped by the job-manager' '
+	flux module reload job-exec batch-size=100000 &&
+	test $(flux module stats --parse batch job-exec) -eq 1024 &&
+	flux mini run -n1 hostname
+'
+test_expect_success 'job-exec: bad batch-size value causes module failure' '
+	flux dmesg -C &&
+	test_expect_code 1 flux module reload job-exec batch-size=-1 &&
+	flux dmesg | grep "invalid batch-size: -1" &&
+	flux module load job-exec
+'
 test_expect_success 'job-exec: can specify default-shell on cmdline' '
 	flux dmesg -C &&
 	flux module reload -f job-exec job-shell=/path/to/shell &&
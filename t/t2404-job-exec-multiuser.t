@@ -63,4 +63,18 @@ test_expect_success HAVE_JQ 'job-exec: kill multiuser job uses the IMP' '
 	test_expect_code 143 run_timeout 30 flux job status -v ${id} &&
 	flux dmesg | grep "test-imp: Kill .*signal 15"
 '
+test_expect_success 'job-exec: multiuser kill reports ranks signaled' '
+	flux dmesg | grep "exec_kill: $(flux job id ${id}): signaled ranks 0-1"
+'
+test_expect_success HAVE_JQ 'job-exec: multiuser kill falls back without relay' '
+	flux exec -r 1 flux module remove job-exec &&
+	id=$(FLUX_HANDLE_USERID=42 \
+	    flux job submit --flags=signed sleep-job.signed) &&
+	flux job wait-event -p guest.exec.eventlog -vt 30 ${id} shell.start &&
+	flux job cancel ${id} &&
+	test_expect_code 143 run_timeout 30 flux job status -v ${id} &&
+	flux dmesg | grep "job-exec not loaded on rank 1, killing directly" &&
+	flux dmesg | grep "exec_kill: $(flux job id ${id}): signaled ranks 0-1" &&
+	flux exec -r 1 flux module load job-exec
+'
 test_done
@@ -104,6 +104,74 @@ test_expect_success 'attach: output events processed after shell.init failure' '
 	grep "FATAL:.*noinitrc: No such file or directory" init-failure.output
 '
 
+count_data_events() {
+	flux job eventlog --format=json -p guest.output $1 \
+	    | jq -c ". | select(.name == \"data\") | select(.context.data)" \
+	    | wc -l
+}
+
+test_expect_success HAVE_JQ 'attach: output lines from one task are batched' '
+	jobid=$(flux mini submit -o output.batch-timeout=60 seq 1 100) &&
+	flux job attach $jobid >batch1.out &&
+	seq 1 100 >batch1.expected &&
+	test_cmp batch1.expected batch1.out &&
+	count=$(count_data_events $jobid) &&
+	test_debug "echo $count data events" &&
+	test $count -eq 1
+'
+test_expect_success HAVE_JQ 'attach: output.batch-lines limits batch size' '
+	jobid=$(flux mini submit -o output.batch-timeout=60 \
+		-o output.batch-lines=10 seq 1 100) &&
+	flux job attach $jobid >batch2.out &&
+	test_cmp batch1.expected batch2.out &&
+	count=$(count_data_events $jobid) &&
+	test_debug "echo $count data events" &&
+	test $count -eq 10
+'
+test_expect_success 'attach: merged output is written once per task' '
+	flux mini run -n4 -o output.batch-timeout=60 --label-io echo foo \
+		| sort >batch3.out &&
+	cat >batch3.expected <<-EOT &&
+	0: foo
+	1: foo
+	2: foo
+	3: foo
+	EOT
+	test_cmp batch3.expected batch3.out
+'
+test_expect_success HAVE_JQ 'attach: output and log messages share eventlog batches' '
+	jobid=$(flux mini submit -o verbose -o output.batch-timeout=60 \
+		seq 1 100) &&
+	flux job attach $jobid >batch4.out 2>batch4.err &&
+	test_cmp batch1.expected batch4.out &&
+	count=$(count_data_events $jobid) &&
+	test $count -eq 1 &&
+	flux job eventlog -p guest.output $jobid >batch4.eventlog &&
+	grep "log.*batch timeout = 60.000s" batch4.eventlog
+'
+test_expect_success 'attach: invalid output.batch-lines fails job' '
+	test_must_fail flux mini run -o output.batch-lines=-1 hostname
+'
+test_expect_success 'attach: output is forwarded through an output tree' '
+	flux mini run -N4 -n8 -o output.tree-fanout=2 --label-io \
+		seq 1 3 | sort -n >tree1.out &&
+	for i in 0 1 2 3 4 5 6 7; do seq 1 3 | sed "s/^/$i: /"; done \
+		| sort -n >tree1.expected &&
+	test_cmp tree1.expected tree1.out
+'
+test_expect_success 'attach: output tree with dedup writes output once per task' '
+	flux mini run -N4 -n8 -o output.tree-fanout=2 -o output.tree-dedup=1 \
+		--label-io seq 1 3 | sort -n >tree2.out &&
+	test_cmp tree1.expected tree2.out
+'
+test_expect_success 'attach: output tree with fanout of 1 works' '
+	flux mini run -N4 -n4 -o output.tree-fanout=1 echo foo >tree3.out &&
+	test $(grep -c foo tree3.out) -eq 4
+'
+test_expect_success 'attach: invalid output.tree-fanout fails job' '
+	test_must_fail flux mini run -o output.tree-fanout=-1 hostname
+'
+
 # use a shell function to make sane quoting possible
 filter_log_context() {
     jq -c '. | select(.name == "log") | .context'
@@ -103,6 +103,54 @@ test_expect_success 'job-shell: PMI KVS works' '
 	flux job attach $id >kvstest.out &&
 	grep "t phase" kvstest.out
 '
+test_expect_success 'job-shell: PMI KVS works with native KVS' '
+	flux mini run -N4 -o pmi.kvs=native ${KVSTEST} >kvstest.native.out &&
+	grep "t phase" kvstest.native.out
+'
+test_expect_success 'job-shell: PMI KVS works with native KVS, 4 tasks per shell' '
+	flux mini run -N4 -n16 -o pmi.kvs=native ${KVSTEST} \
+		>kvstest.native16.out &&
+	grep "t phase" kvstest.native16.out
+'
+test_expect_success 'job-shell: PMI KVS works with 2 tasks per shell' '
+	flux mini run -N4 -n8 ${KVSTEST} >kvstest.n8.out &&
+	grep "t phase" kvstest.n8.out
+'
+for k in 1 3 4; do
+    test_expect_success "job-shell: PMI KVS works with pmi.exchange.k=$k" "
+	flux mini run -N4 -o pmi.exchange.k=$k ${KVSTEST} >kvstest.k$k.out &&
+	grep \"t phase\" kvstest.k$k.out
+    "
+done
+test_expect_success 'job-shell: PMI exchange does not write to the KVS' '
+	id=$(flux mini submit -N4 ${KVSTEST}) &&
+	flux job attach $id &&
+	kvsdir=$(flux job id --to=kvs $id) &&
+	test_must_fail flux kvs dir ${kvsdir}.guest.pmi
+'
+test_expect_success 'job-shell: invalid pmi.kvs fails job' '
+	test_must_fail flux mini run -N4 -o pmi.kvs=foo ${KVSTEST}
+'
+test_expect_success 'job-shell: invalid pmi.exchange.k fails job' '
+	test_must_fail flux mini run -N4 -o pmi.exchange.k=0 ${KVSTEST}
+'
+test_expect_success 'job-shell: FLUX_PMI_KVSSEG is set by default' '
+	flux mini run -N2 printenv FLUX_PMI_KVSSEG >kvsseg.env.out &&
+	test $(wc -l <kvsseg.env.out) -eq 2
+'
+test_expect_success 'job-shell: FLUX_PMI_KVSSEG is unset with pmi.kvsseg=0' '
+	test_must_fail flux mini run -o pmi.kvsseg=0 printenv FLUX_PMI_KVSSEG
+'
+test_expect_success 'job-shell: PMI KVS works with pmi.kvsseg=0' '
+	flux mini run -N4 -n8 -o pmi.kvsseg=0 ${KVSTEST} \
+		>kvstest.noseg.out &&
+	grep "t phase" kvstest.noseg.out
+'
+test_expect_success 'job-shell: PMI KVS works with segment and native KVS' '
+	flux mini run -N4 -n8 -o pmi.kvs=native ${KVSTEST} \
+		>kvstest.segnative.out &&
+	grep "t phase" kvstest.segnative.out
+'
 test_expect_success 'job-exec: decrease kill timeout for tests' '
 	flux module reload job-exec kill-timeout=0.1
 '
@@ -49,6 +49,34 @@ test_expect_success HAVE_JQ 'flux-shell: initrc: in jobspec works' '
 	test_debug "cat ${name}.log" &&
 	grep "jobspec initrc OK" ${name}.log
 '
+test_expect_success HAVE_JQ 'flux-shell: initrc: initrc-cache caches chunks' '
+	name=cached &&
+	mkdir -p rctmp &&
+	cat >${name}.lua <<-EOT &&
+	    print ("cached initrc OK")
+	EOT
+	flux jobspec srun -N1 -n1 echo Hi \
+	    | jq ".attributes.system.shell.options[\"initrc-cache\"] = 1" \
+	    > j4 &&
+	TMPDIR=$(pwd)/rctmp ${FLUX_SHELL} -v -s -r 0 -j j4 -R R1 \
+		--initrc=$(pwd)/${name}.lua 0 > ${name}.log 2>&1 &&
+	test_debug "cat ${name}.log" &&
+	grep "cached initrc OK" ${name}.log &&
+	ls rctmp/flux-shell-rc-$(id -u)/*.luac &&
+	TMPDIR=$(pwd)/rctmp ${FLUX_SHELL} -v -s -r 0 -j j4 -R R1 \
+		--initrc=$(pwd)/${name}.lua 0 > ${name}2.log 2>&1 &&
+	grep "cached initrc OK" ${name}2.log
+'
+test_expect_success HAVE_JQ 'flux-shell: initrc: changed initrc bypasses cache' '
+	name=cached &&
+	cat >${name}.lua <<-EOT &&
+	    print ("changed cached initrc OK")
+	EOT
+	TMPDIR=$(pwd)/rctmp ${FLUX_SHELL} -v -s -r 0 -j j4 -R R1 \
+		--initrc=$(pwd)/${name}.lua 0 > ${name}3.log 2>&1 &&
+	test_debug "cat ${name}3.log" &&
+	grep "changed cached initrc OK" ${name}3.log
+'
 test_expect_success 'flux-shell: initrc: failed initrc causes termination' '
 	name=failed &&
 	cat >${name}.lua <<-EOT &&
@@ -51,6 +51,23 @@ test_expect_success 'flux-shell: per-task affinity sanity check' '
     flux mini run --label-io -ocpu-affinity=per-task -n1 -c1 \
 		hwloc-bind --get
 '
+test_expect_success 'flux-shell: topology cache is written to broker.rundir' '
+    flux exec -n sh -c \
+        "test -f \$(flux getattr broker.rundir)/shell-topology.xml \
+            && echo found; true" > cache.out &&
+    grep found cache.out
+'
+test_expect_success 'flux-shell: default affinity works with cached topology' '
+    flux mini run -n1 -c1 $CPUS_ALLOWED_COUNT > result.cached &&
+    test_debug "cat result.cached" &&
+    test "$(cat result.cached)" = "1"
+'
+test_expect_success 'flux-shell: invalid topology cache is ignored' '
+    flux exec -n sh -c \
+        "echo garbage > \$(flux getattr broker.rundir)/shell-topology.xml" &&
+    flux mini run -n1 -c1 $CPUS_ALLOWED_COUNT > result.garbage &&
+    test "$(cat result.garbage)" = "1"
+'
 test_expect_success 'flux-shell: affinity can be disabled' '
     hwloc-bind --get > affinity-off.expected &&
     flux mini run -ocpu-affinity=off -n1 hwloc-bind --get >affinity-off.out &&
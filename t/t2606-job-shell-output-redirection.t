@@ -318,4 +318,72 @@ test_expect_success NO_CHAIN_LINT 'job-shell: job attach waits if no kvs output
         flux job cancel $id &&
         ! wait $pid
 '
+#
+# direct output: each shell writes its own tasks' output
+#
+
+test_expect_success 'job-shell: direct output to per-task files' '
+        flux mini run -N2 -n4 \
+             --output="direct30.{{taskid}}" -o output.stdout.direct=true \
+             ${TEST_SUBPROCESS_DIR}/test_echo -P -O foo &&
+        for i in 0 1 2 3; do grep "stdout:foo" direct30.$i || return 1; done
+'
+
+test_expect_success 'job-shell: direct output to per-node files with labels' '
+        flux mini run -N2 -n4 --label-io \
+             --output="direct31.{{node}}" -o output.stdout.direct=true \
+             ${TEST_SUBPROCESS_DIR}/test_echo -P -O foo &&
+        test $(wc -l <direct31.0) -eq 2 &&
+        test $(wc -l <direct31.1) -eq 2 &&
+        cat direct31.0 direct31.1 | sort >direct31.out &&
+        cat >direct31.expected <<-EOT &&
+	0: stdout:foo
+	1: stdout:foo
+	2: stdout:foo
+	3: stdout:foo
+	EOT
+        test_cmp direct31.expected direct31.out
+'
+
+test_expect_success 'job-shell: direct output to a shared file appends' '
+        rm -f direct32 &&
+        flux mini run -N2 -n4 \
+             --output=direct32 -o output.stdout.direct=true \
+             ${TEST_SUBPROCESS_DIR}/test_echo -P -O foo &&
+        test $(grep -c "stdout:foo" direct32) -eq 4 &&
+        flux mini run -N2 -n4 \
+             --output=direct32 -o output.stdout.direct=true \
+             ${TEST_SUBPROCESS_DIR}/test_echo -P -O foo &&
+        test $(grep -c "stdout:foo" direct32) -eq 8
+'
+
+test_expect_success 'job-shell: direct output per-task file is truncated' '
+        echo stale >direct33.0 &&
+        flux mini run -n1 \
+             --output="direct33.{{taskid}}" -o output.stdout.direct=true \
+             ${TEST_SUBPROCESS_DIR}/test_echo -P -O foo &&
+        ! grep stale direct33.0
+'
+
+test_expect_success 'job-shell: direct output append option keeps contents' '
+        echo old >direct34.0 &&
+        flux mini run -n1 \
+             --output="direct34.{{taskid}}" -o output.stdout.direct=true \
+             -o output.stdout.append=true \
+             ${TEST_SUBPROCESS_DIR}/test_echo -P -O foo &&
+        grep old direct34.0 &&
+        grep stdout:foo direct34.0
+'
+
+test_expect_success 'job-shell: direct output records only a redirect event' '
+        id=$(flux mini submit -N2 -n4 \
+             --output="direct35.{{taskid}}" -o output.stdout.direct=true \
+             ${TEST_SUBPROCESS_DIR}/test_echo -P -O -E baz) &&
+        flux job wait-event $id clean &&
+        flux job eventlog -p guest.output $id > eventlog35.out &&
+        grep "stdout" eventlog35.out | grep redirect | grep "0-3" \
+            | grep "direct35.{{taskid}}" &&
+        ! grep "data" eventlog35.out &&
+        grep stderr:baz direct35.3
+'
 test_done
@@ -44,6 +44,14 @@ test_expect_success 'flux-shell: run 2-task input file as stdin job' '
         grep "1: doh" pipe2.out
 '
 
+test_expect_success 'flux-shell: input reaches all tasks on multiple shells' '
+        id=$(flux mini submit -N2 -n8 \
+             ${TEST_SUBPROCESS_DIR}/test_echo -O -n) &&
+        flux job attach -l $id < input_stdin_file > pipe3.out &&
+        test $(grep -c ": foo" pipe3.out) -eq 8 &&
+        test $(grep -c ": doh" pipe3.out) -eq 8
+'
+
 test_expect_success LONGTEST 'flux-shell: 10K line lptest piped input works' '
         id=$(flux mini submit -n1 \
              ${TEST_SUBPROCESS_DIR}/test_echo -O -n) &&
@@ -39,4 +39,19 @@ test_expect_success 'flux-shell: plugin can add event context' '
 		-m event-test=foo ${id} shell.init
 
 '
+test_expect_success 'flux-shell: shell.start event includes startup timing' '
+	id=$(flux mini submit -n4 -N2 /bin/true)  &&
+	flux job wait-event -vt 5 -p guest.exec.eventlog \
+		${id} shell.start >start.out &&
+	test_debug "cat start.out" &&
+	grep "\"timing\":{" start.out &&
+	grep "barrier.init" start.out
+'
+test_expect_success 'flux-shell: early-task-init works' '
+	flux mini run -n4 -N2 -o early-task-init=1 -o verbose \
+		hostname >early.out 2>early.err &&
+	test_debug "cat early.err" &&
+	test $(wc -l <early.out) -eq 4 &&
+	grep "startup timing" early.err
+'
 test_done
@@ -36,6 +36,17 @@ for test in 1:1 2:2 2:4 4:4 4:8 4:7; do
         flux job attach ${id}
     '
 done
+for k in 0 1 2; do
+    test_expect_success "flux-shell: 4N/8P: mpir with tree-fanout=${k} works" '
+	id=$(flux mini submit -o stop-tasks-in-exec -o mpir.tree-fanout=${k} \
+             -n8 -N4 /bin/true)  &&
+        flux job wait-event -vt 5 -p guest.exec.eventlog \
+                -m sync=true ${id} shell.start &&
+        ${mpir} $(shell_leader_rank $id) $(shell_service $id) &&
+        flux job kill -s CONT ${id} &&
+        flux job attach ${id}
+    '
+done
 
 
 test_expect_success 'flux-shell: test security of proctable method' '
@@ -182,6 +182,46 @@ test_expect_success HAVE_JQ 'flux mini --job-name works' '
 	flux mini submit --dry-run --job-name=foobar hostname >name.out &&
 	test $(jq ".attributes.system.job.name" name.out) = "\"foobar\""
 '
+test_expect_success 'flux mini submit --cc works' '
+	flux mini submit --cc=1-4 --output=cc.{cc}.out \
+		sh -c "echo {cc} \$FLUX_JOB_CC" >cc.ids &&
+	test $(wc -l <cc.ids) -eq 4 &&
+	for id in $(cat cc.ids); do flux job wait-event $id clean; done &&
+	for i in 1 2 3 4; do echo "$i $i" | test_cmp - cc.$i.out; done
+'
+test_expect_success 'flux mini submit --bcc submits identical jobs' '
+	flux mini submit --bcc=0-2 echo {cc} >bcc.ids &&
+	test $(wc -l <bcc.ids) -eq 3 &&
+	for id in $(cat bcc.ids); do
+		flux job attach $id >bcc.out &&
+		echo "{cc}" | test_cmp - bcc.out || return 1
+	done
+'
+test_expect_success HAVE_JQ 'flux mini submit --cc substitutes in jobspec' '
+	flux mini submit --dry-run --cc=3,5 --job-name=j{cc} x{cc} >ccdry.out &&
+	test $(wc -l <ccdry.out) -eq 2 &&
+	jq -e -s ".[0].tasks[0].command[0] == \"x3\"
+		and .[1].tasks[0].command[0] == \"x5\"
+		and .[1].attributes.system.job.name == \"j5\"
+		and .[1].attributes.system.environment.FLUX_JOB_CC == \"5\"" \
+		<ccdry.out
+'
+test_expect_success 'flux mini submit --cc -v reports submission rate' '
+	flux mini submit --cc=0-9 -v hostname >ccv.ids 2>ccv.err &&
+	test $(wc -l <ccv.ids) -eq 10 &&
+	grep "submitted 10 jobs in" ccv.err
+'
+test_expect_success 'flux mini submit --cc with --bcc fails' '
+	test_must_fail flux mini submit --cc=0 --bcc=0 hostname 2>ccbcc.err &&
+	grep "mutually exclusive" ccbcc.err
+'
+test_expect_success 'flux mini submit --cc with a bad idset fails' '
+	test_must_fail flux mini submit --cc=3-1 hostname 2>ccbad.err &&
+	grep "invalid idset" ccbad.err
+'
+test_expect_success 'flux mini run does not accept --cc' '
+	test_must_fail flux mini run --cc=0-1 hostname
+'
 
 
 test_done
@@ -281,6 +281,30 @@ test_expect_success 'flux-jobs --count works' '
 	test $count -eq 8
 '
 
+test_expect_success 'flux-jobs --name works' '
+	count=`flux jobs --suppress-header -a --name=hostname | wc -l` &&
+	test $count -eq 4 &&
+	count=`flux jobs --suppress-header -a --name="host*" | wc -l` &&
+	test $count -eq 4 &&
+	count=`flux jobs --suppress-header --name=sleep | wc -l` &&
+	test $count -eq $(state_count active) &&
+	count=`flux jobs --suppress-header -a --name=nomatch | wc -l` &&
+	test $count -eq 0
+'
+
+test_expect_success 'flux-jobs --since lists recently inactive jobs' '
+	count=`flux jobs --suppress-header --since=1d | wc -l` &&
+	test $count -eq $(state_count all) &&
+	count=`flux jobs --suppress-header --since=0 | wc -l` &&
+	test $count -eq $(state_count active) &&
+	count=`flux jobs --suppress-header --since=1d -f inactive | wc -l` &&
+	test $count -eq $(state_count inactive)
+'
+
+test_expect_success 'flux-jobs --since with invalid duration fails' '
+	test_must_fail flux jobs --since=foo
+'
+
 #
 # test specific IDs
 #